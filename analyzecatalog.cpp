@@ -0,0 +1,432 @@
+/** Calculates statistics of every light curve in a catalog
+ * @file lightcurveMC/analyzecatalog.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * Usage: analyzecatalog [-j THREADS] CATALOG STAT [STAT ...]
+ *
+ * CATALOG is any catalog accepted by the --add argument of
+ * lightcurveMC, including a bundle. Each STAT is a statistic accepted
+ * by lightcurveMC; only statistics with one value per light curve are
+ * printed. The program prints a tab-separated table to standard output,
+ * with one row per light curve in catalog order. Light curves that
+ * cannot be analyzed are reported on standard error, and printed as
+ * NaN.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ *
+ * LightcurveMC is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors
+ *	  may be used to endorse or promote products derived from this software
+ *	  without specific prior written permission.
+ *
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <boost/shared_ptr.hpp>
+#include "binstats.h"
+#include "paramlist.h"
+#include "statparser.h"
+#include "trialpool.h"
+#include "samples/catalog.h"
+#include "samples/observations.h"
+
+namespace lcmc { namespace inject {
+
+using boost::shared_ptr;
+using std::string;
+using std::vector;
+using stats::LcBinStats;
+using stats::StatType;
+
+/** Describes one column of the output table
+ */
+struct Column {
+	/** The statistic that produces the column */
+	StatType stat;
+	/** The tag of the column's values in LcBinStats::getScalars() */
+	const char* tag;
+	/** The column's name in the header */
+	const char* name;
+};
+
+/** The columns that may be printed, in the same order as in
+ *	LcBinStats::printBinHeader()
+ */
+const Column COLUMNS[] = {
+	{stats::C1,      "c1",        "C1"          },
+	{stats::PERIOD,  "peri",      "Period"      },
+	{stats::DMDTCUT, "cut50_3",   "50%@1/3"     },
+	{stats::DMDTCUT, "cut50_2",   "50%@1/2"     },
+	{stats::DMDTCUT, "cut90_3",   "90%@1/3"     },
+	{stats::DMDTCUT, "cut90_2",   "90%@1/2"     },
+	{stats::IACFCUT, "acf9",      "ACF@1/9"     },
+	{stats::IACFCUT, "acf4",      "ACF@1/4"     },
+	{stats::IACFCUT, "acf2",      "ACF@1/2"     },
+	{stats::SACFCUT, "sacf9",     "SACF@1/9"    },
+	{stats::SACFCUT, "sacf4",     "SACF@1/4"    },
+	{stats::SACFCUT, "sacf2",     "SACF@1/2"    },
+	{stats::PEAKCUT, "cutpeak3",  "PeakFind@1/3"},
+	{stats::PEAKCUT, "cutpeak2",  "PeakFind@1/2"},
+	{stats::PEAKCUT, "cutpeak45", "PeakFind@80%"},
+	{stats::GPTAU,   "gpt",       "GP Time"     },
+	{stats::GPTAU,   "gperr",     "GP Error"    },
+	{stats::GPTAU,   "gpchi",     "GP Chi^2"    },
+	{stats::DRWTAU,  "drwt",      "DRW Time"    },
+	{stats::DRWTAU,  "drwerr",    "DRW Error"   },
+	{stats::DRWTAU,  "drwchi",    "DRW Chi^2"   }
+};
+
+/** The number of elements in @ref COLUMNS */
+const size_t N_COLUMNS = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+
+/** Light curves analyzed at once for each thread. Large enough that
+ *	the threads rarely wait for the slowest light curve in a batch,
+ *	small enough that a batch takes little memory.
+ */
+const size_t BATCH_FACTOR = 16;
+
+/** SourceAnalyzer calculates the statistics of a batch of light curves,
+ * one row per light curve.
+ *
+ * Each light curve is analyzed separately, so a light curve that cannot
+ * be analyzed does not affect the others in the batch. Light curves
+ * with the same cadence share the cadence-keyed caches of the
+ * statistics, so a catalog from a single survey pays for each
+ * periodogram grid and lag table only once.
+ */
+class SourceAnalyzer {
+public:
+	/** Prepares to analyze a batch of light curves
+	 *
+	 * @param[in] sources The light curves to analyze. Null pointers
+	 *	represent light curves that could not be read, and are skipped.
+	 * @param[in] statList The statistics to calculate.
+	 * @param[in] columns The columns to fill.
+	 * @param[out] rows The location where the values of @p columns
+	 *	are stored, one row per element of @p sources. Each row
+	 *	must already have one element per column.
+	 * @param[out] errors The location where the reason each light
+	 *	curve could not be analyzed is stored, one element per element
+	 *	of @p sources. Each element must already exist.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	SourceAnalyzer(const vector<shared_ptr<const Observations> >& sources,
+			const vector<StatType>& statList,
+			const vector<const Column*>& columns,
+			vector<vector<double> >& rows, vector<string>& errors)
+			: sources(sources), statList(statList), columns(columns),
+			rows(rows), errors(errors) {
+	}
+
+	/** Analyzes a range of light curves
+	 *
+	 * @param[in] chunk Not used.
+	 * @param[in] first, last The range of light curves to analyze.
+	 *
+	 * @post rows[i] holds the statistics of light curve i, for
+	 *	@p first &le; i &lt; @p last. If a light curve could not be
+	 *	analyzed, its row is unchanged and errors[i] says why.
+	 *
+	 * @exception std::logic_error Thrown if a bug was encountered.
+	 *
+	 * @exceptsafe Each row is either complete or unchanged in the
+	 *	event of an exception.
+	 */
+	void operator()(size_t /*chunk*/, size_t first, size_t last) const {
+		for(size_t i = first; i < last; i++) {
+			if (sources[i].get() != NULL) {
+				analyze(i);
+			}
+		}
+	}
+
+private:
+	/** Analyzes one light curve
+	 *
+	 * @param[in] i The index of the light curve in the batch.
+	 *
+	 * @post rows[i] holds the statistics of the light curve, or
+	 *	errors[i] says why it could not be analyzed.
+	 *
+	 * @exception std::logic_error Thrown if a bug was encountered.
+	 *
+	 * @exceptsafe rows[i] is unchanged in the event of an exception.
+	 */
+	void analyze(size_t i) const {
+		try {
+			// Distributions are kept so that the value can be read
+			//	back, but there is only one value per collection
+			LcBinStats bin("catalog", models::RangeList(), "none",
+				statList, true, stats::LS_DIRECT, false);
+			bin.analyzeLightCurve(sources[i]->cadence(),
+				sources[i]->fluxView(), models::ParamList());
+
+			vector<double> row(columns.size());
+			for(size_t j = 0; j < columns.size(); j++) {
+				const stats::CollectedScalars& values
+					= bin.getScalars(columns[j]->tag);
+				row[j] = (values.size() > 0 ? values.data()[0]
+					: std::numeric_limits<double>::quiet_NaN());
+			}
+
+			// IMPORTANT: no exceptions beyond this point
+
+			rows[i].swap(row);
+		} catch (const std::logic_error& e) {
+			throw;
+		} catch (const std::exception& e) {
+			try {
+				errors[i] = e.what();
+			} catch (const std::bad_alloc& e) {
+				// Nothing to report, but the row stays NaN
+			}
+		}
+	}
+
+	const vector<shared_ptr<const Observations> >& sources;
+	const vector<StatType>& statList;
+	const vector<const Column*>& columns;
+	vector<vector<double> >& rows;
+	vector<string>& errors;
+};
+
+/** Reads a range of light curves from a catalog
+ *
+ * @param[in] catalog The catalog to read.
+ * @param[in] first, last The range of light curves to read.
+ * @param[out] sources The light curves, in order. Light curves that
+ *	could not be read are null.
+ * @param[out] errors The reason each light curve could not be read,
+ *	or an empty string if it was read.
+ *
+ * @pre @p first &le; @p last &le; @p catalog.size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	store the light curves.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void readBatch(const Catalog& catalog, size_t first, size_t last,
+		vector<shared_ptr<const Observations> >& sources,
+		vector<string>& errors) {
+	vector<shared_ptr<const Observations> > newSources(last - first);
+	vector<string> newErrors(last - first);
+	for(size_t i = first; i < last; i++) {
+		try {
+			newSources[i - first] = catalog.readSource(i);
+		} catch (const std::bad_alloc& e) {
+			throw;
+		} catch (const std::runtime_error& e) {
+			newErrors[i - first] = e.what();
+		}
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	sources.swap(newSources);
+	errors.swap(newErrors);
+}
+
+/** Tells the catalog to start reading a range of light curves
+ *
+ * @param[in] catalog The catalog to read.
+ * @param[in] first, last The range of light curves that will be
+ *	needed next. Positions past the end of the catalog are ignored.
+ *
+ * @exceptsafe Does not throw exceptions. A light curve that cannot be
+ *	prefetched is read when it is needed.
+ */
+void prefetchBatch(const Catalog& catalog, size_t first, size_t last) {
+	try {
+		vector<size_t> indices;
+		for(size_t i = first; i < std::min(last, catalog.size()); i++) {
+			indices.push_back(i);
+		}
+		catalog.prefetch(indices);
+	} catch (const std::bad_alloc& e) {
+		// Not an error, since readBatch() will read the light curves
+	}
+}
+
+/** Prints a header row for the table printed by analyzeCatalog()
+ *
+ * @param[in] file The file to print to.
+ * @param[in] columns The statistics to include.
+ *
+ * @exception std::runtime_error Thrown if the header could not be printed.
+ *
+ * @exceptsafe The program is in a consistent state in the event
+ *	of an exception.
+ */
+void printHeader(FILE* const file, const vector<const Column*>& columns) {
+	int status = fprintf(file, "Index\tSource\tEpochs");
+	for(size_t j = 0; status >= 0 && j < columns.size(); j++) {
+		status = fprintf(file, "\t%s", columns[j]->name);
+	}
+	if (status < 0 || fprintf(file, "\n") < 0) {
+		throw std::runtime_error("Could not print table header.");
+	}
+}
+
+/** Calculates statistics of every light curve in a catalog, and prints
+ *	one row per light curve
+ *
+ * The catalog is analyzed in batches. The next batch is read in the
+ * background while the current one is analyzed, and the light curves of
+ * a batch are analyzed in parallel. Each batch is printed and discarded
+ * before the next one is read, so the memory used does not depend on
+ * the size of the catalog.
+ *
+ * @param[in] catalogName The catalog to analyze.
+ * @param[in] statList The statistics to calculate.
+ * @param[in] nThreads The number of light curves to analyze at once.
+ * @param[in] file The file to print to.
+ *
+ * @pre @p nThreads &ge; 1
+ *
+ * @exception kpfutils::except::FileIo Thrown if the catalog could not
+ *	be read.
+ * @exception std::invalid_argument Thrown if @p statList contains no
+ *	statistics with one value per light curve.
+ * @exception std::runtime_error Thrown if the table could not be printed.
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	analyze a batch.
+ * @exception std::logic_error Thrown if a bug was encountered.
+ *
+ * @exceptsafe The rows already printed are complete in the event of
+ *	an exception.
+ */
+void analyzeCatalog(const string& catalogName, const vector<StatType>& statList,
+		size_t nThreads, FILE* const file) {
+	const stats::StatSet wanted(statList);
+	vector<const Column*> columns;
+	for(size_t j = 0; j < N_COLUMNS; j++) {
+		if (wanted.contains(COLUMNS[j].stat)) {
+			columns.push_back(&COLUMNS[j]);
+		}
+	}
+	if (columns.empty()) {
+		throw std::invalid_argument("None of the requested statistics has one value per light curve.");
+	}
+
+	const Catalog catalog(catalogName);
+	const size_t batchSize = BATCH_FACTOR * nThreads;
+
+	printHeader(file, columns);
+	prefetchBatch(catalog, 0, batchSize);
+	for(size_t first = 0; first < catalog.size(); first += batchSize) {
+		const size_t last = std::min(first + batchSize, catalog.size());
+
+		vector<shared_ptr<const Observations> > sources;
+		vector<string> errors;
+		readBatch(catalog, first, last, sources, errors);
+		// Read the next batch while this one is analyzed
+		prefetchBatch(catalog, last, last + batchSize);
+
+		vector<vector<double> > rows(last - first, vector<double>(columns.size(),
+			std::numeric_limits<double>::quiet_NaN()));
+		runChunks(last - first, 1, nThreads,
+			SourceAnalyzer(sources, statList, columns, rows, errors));
+
+		for(size_t i = 0; i < rows.size(); i++) {
+			if (!errors[i].empty()) {
+				fprintf(stderr, "WARNING: could not analyze light curve %lu: %s\n",
+					static_cast<unsigned long>(first + i), errors[i].c_str());
+			}
+
+			const string name = catalog.sourceName(first + i);
+			int status = fprintf(file, "%lu\t%s\t%lu",
+				static_cast<unsigned long>(first + i),
+				(name.empty() ? "-" : name.c_str()),
+				static_cast<unsigned long>(sources[i].get() != NULL
+					? sources[i]->timeView().size() : 0));
+			for(size_t j = 0; status >= 0 && j < rows[i].size(); j++) {
+				status = fprintf(file, "\t%.5g", rows[i][j]);
+			}
+			if (status < 0 || fprintf(file, "\n") < 0) {
+				throw std::runtime_error("Could not print table row.");
+			}
+		}
+		fflush(file);
+	}
+}
+
+}}		// end lcmc::inject
+
+/** Analyzes a catalog
+ *
+ * @param[in] argc The number of arguments given to the program.
+ * @param[in] argv An optional thread count, the name of the catalog,
+ *	and the statistics to calculate.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+int main(int argc, char* argv[]) {
+	int arg = 1;
+	long nThreads = 1;
+	if (argc > 2 && std::string(argv[1]) == "-j") {
+		char* end = NULL;
+		nThreads = strtol(argv[2], &end, 10);
+		if (*end != '\0' || nThreads < 1) {
+			fprintf(stderr, "ERROR: THREADS must be a positive integer, not %s\n",
+				argv[2]);
+			return 1;
+		}
+		arg = 3;
+	}
+	if (argc - arg < 2) {
+		fprintf(stderr, "Usage: %s [-j THREADS] CATALOG STAT [STAT ...]\n", argv[0]);
+		return 1;
+	}
+
+	try {
+		std::vector<lcmc::stats::StatType> statList;
+		for(int i = arg + 1; i < argc; i++) {
+			statList.push_back(lcmc::parse::parseStat(argv[i]));
+		}
+
+		lcmc::inject::analyzeCatalog(argv[arg], statList,
+			static_cast<size_t>(nThreads), stdout);
+	} catch (const std::domain_error &e) {
+		// Unknown statistic
+		fprintf(stderr, "ERROR: %s\n", e.what());
+		return 1;
+	} catch (const std::invalid_argument &e) {
+		fprintf(stderr, "ERROR: %s\n", e.what());
+		return 1;
+	} catch(std::logic_error &e) {
+		fprintf(stderr, "BUG: %s\nPlease report this to the developer at krzys@astro.caltech.edu.\n", e.what());
+		return 1;
+	} catch (const std::exception &e) {
+		fprintf(stderr, "ERROR: %s\n", e.what());
+		return 1;
+	} catch (...) {
+		fprintf(stderr, "BUG: Unknown exception.\nPlease report this to the developer at krzys@astro.caltech.edu.\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -2,7 +2,7 @@
  * @file lightcurveMC/binstats.cpp
  * @author Krzysztof Findeisen
  * @date Created June 6, 2011
- * @date Last modified August 5, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -29,24 +29,34 @@
 
 #include <algorithm>
 #include <limits>
+#include <climits>
 #include <stdexcept>
 #include <string>
 #include <vector>
 #include <cstdio>
 #include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
 #include <timescales/timescales.h>
 #include "stats/acfinterp.h"
+#include "stats/analysiscontext.h"
+#include "stats/deadline.h"
+#include "stats/gpfit.h"
 #include "binstats.h"
+#include "cachestats.h"
 #include "../common/cerror.h"
-#include "fluxmag.h"
+#include "../common/fileio.h"
 #include "stats/magdist.h"
 #include "stats/output.h"
-#include "nan.h"
+#include "stats/profile.h"
+#include "stats/trace.h"
 #include "../common/nan.h"
 #include "paramlist.h"
+#include "progress.h"
 #include "except/paramlist.h"
 #include "stats/statcollect.h"
+#include "stats/scargleacf.h"
 #include "stats/statfamilies.h"
+#include "trialpool.h"
 #include "except/undefined.h"
 
 #include "../common/warnflags.h"
@@ -64,12 +74,272 @@
 namespace lcmc { namespace stats {
 
 using boost::lexical_cast;
+using boost::shared_ptr;
 using std::string;
+using std::vector;
 using kpfutils::cError;
 using kpfutils::fileError;
 using lcmc::models::RangeList;
 using lcmc::models::ParamList;
 
+/** The most light curves whose periodograms or Gaussian process fits 
+ *	are computed together by LcBinStats::analyzeLightCurves()
+ */
+const size_t ANALYSIS_BATCH = 16;
+
+/** Returns the number of threads used to analyze each light curve
+ *
+ * @return A modifiable reference to the thread count.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& statThreads() {
+	static long nThreads = 1;
+	return nThreads;
+}
+
+/** Sets the number of threads used to calculate the statistics of 
+ *	each light curve
+ *
+ * @param[in] nThreads The most statistic families to calculate at once 
+ *	for a single light curve.
+ *
+ * @post If @p nThreads > 1, LcBinStats::analyzeLightCurve() calculates 
+ *	independent groups of statistics (C1, periodogram, 
+ *	&Delta;m&Delta;t, each ACF, peak-finding, Gaussian process, and 
+ *	damped random walk) on separate threads, so each light curve takes 
+ *	about as long as its slowest group. The results do not depend on 
+ *	@p nThreads.
+ *
+ * @exception std::invalid_argument Thrown if @p nThreads < 1.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe. Call before any light curves are analyzed.
+ * @note Each group runs on a new thread for every light curve, so the 
+ *	@ref GPSTART_PREVIOUS "GPSTART_PREVIOUS" policy of setGpStart() 
+ *	has no earlier solution to start from.
+ */
+void setStatThreads(long nThreads) {
+	if (nThreads < 1) {
+		throw std::invalid_argument("Need at least one thread per light curve (gave "
+			+ lexical_cast<string>(nThreads) + ").");
+	}
+	statThreads() = nThreads;
+}
+
+/** Returns the number of threads chosen with setStatThreads()
+ *
+ * @return The most statistic families calculated at once for a single 
+ *	light curve.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long getStatThreads() {
+	return statThreads();
+}
+
+/** Returns the relative standard error at which a bin has enough 
+ *	light curves
+ *
+ * @return A modifiable reference to the target.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& targetError() {
+	static double error = 0.0;
+	return error;
+}
+
+/** Sets the relative standard error at which a bin has enough 
+ *	light curves
+ *
+ * @param[in] error The largest acceptable standard error of each 
+ *	summary statistic, as a fraction of its mean, or 0 to analyze a 
+ *	fixed number of light curves.
+ *
+ * @post If @p error > 0, the driver stops simulating a bin once 
+ *	LcBinStats::relativeError() is at most @p error, and 
+ *	LcBinStats::printBinStats() reports the number of light curves 
+ *	analyzed.
+ *
+ * @exception std::invalid_argument Thrown if @p error is negative.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe. Call before any bins are simulated.
+ */
+void setTargetError(double error) {
+	if (!(error >= 0.0)) {
+		throw std::invalid_argument("Target error must be nonnegative (gave "
+			+ lexical_cast<string>(error) + ").");
+	}
+	targetError() = error;
+}
+
+/** Returns the target chosen with setTargetError()
+ *
+ * @return The target relative error, or 0 if bins analyze a fixed 
+ *	number of light curves.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double getTargetError() {
+	return targetError();
+}
+
+/** Creates an empty set
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+StatSet::StatSet() : bits(0) {
+}
+
+/** Creates a set containing the elements of a list
+ *
+ * @param[in] stats The statistics to include. Duplicates are ignored.
+ *
+ * @exception std::logic_error Thrown if a statistic does not fit in 
+ *	the set's bitmask.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+StatSet::StatSet(const std::vector<StatType>& stats) : bits(0) {
+	for(vector<StatType>::const_iterator it = stats.begin(); 
+			it != stats.end(); it++) {
+		insert(*it);
+	}
+}
+
+/** Adds a statistic to the set
+ *
+ * @param[in] x The statistic to add.
+ *
+ * @post contains(@p x)
+ *
+ * @exception std::logic_error Thrown if @p x does not fit in the 
+ *	set's bitmask.
+ *
+ * @exceptsafe The set is unchanged in the event of an exception.
+ */
+void StatSet::insert(StatType x) {
+	const size_t bit = static_cast<size_t>(x);
+	// unsigned long has at least 32 bits
+	if (bit >= sizeof(bits) * CHAR_BIT) {
+		throw std::logic_error("Statistic does not fit in StatSet: " 
+			+ lexical_cast<string>(x));
+	}
+	bits |= (1UL << bit);
+}
+
+/** Tests whether a statistic is in the set
+ *
+ * @param[in] x The statistic to look up.
+ *
+ * @return True if @p x was added to the set, false otherwise.
+ *
+ * @perform O(1) time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool StatSet::contains(StatType x) const {
+	const size_t bit = static_cast<size_t>(x);
+	return (bit < sizeof(bits) * CHAR_BIT) && ((bits >> bit) & 1UL);
+}
+
+/** Tests whether the set has no elements
+ *
+ * @return True if no statistic has been added to the set.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool StatSet::empty() const {
+	return (bits == 0);
+}
+
+/** Tests whether two sets have the same elements
+ *
+ * @param[in] other The set to compare to.
+ *
+ * @return True if every statistic in either set is also in the other.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool StatSet::operator==(const StatSet& other) const {
+	return (bits == other.bits);
+}
+
+/** Tests whether two sets have different elements
+ *
+ * @param[in] other The set to compare to.
+ *
+ * @return True if some statistic is in one set but not the other.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool StatSet::operator!=(const StatSet& other) const {
+	return !(*this == other);
+}
+
+// Families don't depend on which thread calculates them, so 
+//	FamilyAnalyzer::operator() does not use its worker index
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+/** Function object that calculates blocks of statistic families for 
+ *	a single light curve.
+ */
+class FamilyAnalyzer {
+public:
+	/** Prepares to analyze a light curve.
+	 *
+	 * @param[in,out] bin The object in which to record the statistics.
+	 * @param[in] families The groups of statistics to calculate.
+	 * @param[in] lc The light curve to analyze.
+	 * @param[in] trueTime The timescale used to simulate the light 
+	 *	curve, or NaN if not available.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	FamilyAnalyzer(LcBinStats& bin, const vector<LcBinStats::StatFamily>& families, 
+			const AnalysisContext& lc, double trueTime)
+			: bin(bin), families(families), lc(lc), trueTime(trueTime) {
+	}
+
+	/** Calculates each family in a block.
+	 *
+	 * @param[in] worker The index of the worker analyzing the block.
+	 * @param[in] first, last The range of indices in @p families to 
+	 *	calculate.
+	 *
+	 * @post @p bin contains the statistics for 
+	 *	<tt>families[first, last)</tt>.
+	 *
+	 * @exception std::exception Thrown if a family could not be 
+	 *	calculated.
+	 *
+	 * @exceptsafe @p bin is in a valid state in the event of an exception.
+	 */
+	void operator()(size_t worker, size_t first, size_t last) const {
+		for(size_t i = first; i < last; i++) {
+			bin.analyzeFamily(families[i], lc, trueTime);
+		}
+	}
+
+private:
+	LcBinStats& bin;
+	const vector<LcBinStats::StatFamily>& families;
+	const AnalysisContext& lc;
+	double trueTime;
+};
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
 /** Creates a new stat counter.
  *
  * @param[in] modelName The name of the model being tested. Used to name the 
@@ -82,6 +352,17 @@ using lcmc::models::ParamList;
  *	this string is the name of the light curve library to which signals 
  *	are added.
  * @param[in] toCalc A list of statistics whose values will be calculated.
+ * @param[in] storeDistribs If true, the value of each scalar statistic 
+ *	for each light curve is kept so that its distribution can be 
+ *	printed. If false, only summaries of the scalar statistics are kept, 
+ *	and memory usage does not grow with the number of light curves.
+ * @param[in] pgramMethod The algorithm to use for calculating 
+ *	periodograms.
+ * @param[in] storeCurves If true, every periodogram, &Delta;m-&Delta;t 
+ *	median curve, ACF, peak plot, and RMS curve is kept so that it can 
+ *	be printed. If false, only the mean, scatter, and percentiles of 
+ *	each function at each grid point are kept, and memory usage does 
+ *	not grow with the number of light curves.
  *
  * @pre @p toCalc is not empty
  *
@@ -92,39 +373,139 @@ using lcmc::models::ParamList;
  * @exceptsafe Object creation is atomic.
  */
 LcBinStats::LcBinStats(const string& modelName, const RangeList& binSpecs, const string& noise, 
-		const std::vector<StatType>& toCalc) 
+		const std::vector<StatType>& toCalc, bool storeDistribs, 
+		PeriodogramMethod pgramMethod, bool storeCurves) 
 		: binName(makeBinName(modelName, binSpecs, noise)), 
 		fileName(makeFileName(modelName, binSpecs, noise)), 
-		stats(toCalc), 
-		c1vals("C1", "run_c1_" + fileName + ".dat"), 
-		periods("Period", "run_peri_" + fileName + ".dat"), 
-		periodograms("Periodograms", "run_pgram_" + fileName + ".dat"), 
-		cutDmdt50Amp3s("50th percentile crossing 1/3 amp", "run_cut50_3_" + fileName + ".dat"), 
-		cutDmdt50Amp2s("50th percentile crossing 1/2 amp", "run_cut50_2_" + fileName + ".dat"), 
-		cutDmdt90Amp3s("90th percentile crossing 1/3 amp", "run_cut90_3_" + fileName + ".dat"), 
-		cutDmdt90Amp2s("90th percentile crossing 1/2 amp", "run_cut90_2_" + fileName + ".dat"), 
-		dmdtMedians("DMDT Medians", "run_dmdtmed_" + fileName + ".dat"), 
-		cutIAcf9s("ACF crossing 1/9", "run_acf9_" + fileName + ".dat"), 
-		cutIAcf4s("ACF crossing 1/4", "run_acf4_" + fileName + ".dat"), 
-		cutIAcf2s("ACF crossing 1/2", "run_acf2_" + fileName + ".dat"), 
-		iAcfs("ACFs", "run_acf_" + fileName + ".dat"), 
-		cutSAcf9s("ACF crossing 1/9", "run_sacf9_" + fileName + ".dat"), 
-		cutSAcf4s("ACF crossing 1/4", "run_sacf4_" + fileName + ".dat"), 
-		cutSAcf2s("ACF crossing 1/2", "run_sacf2_" + fileName + ".dat"), 
-		sAcfs("ACFs", "run_sacf_" + fileName + ".dat"), 
-		cutPeakAmp3s("Timescales for peaks > 1/3 amp", "run_cutpeak3_" + fileName + ".dat"), 
-		cutPeakAmp2s("Timescales for peaks > 1/3 amp", "run_cutpeak2_" + fileName + ".dat"), 
-		cutPeakMax08s("Timescales for peaks > 80% max", "run_cutpeak45_" + fileName + ".dat"), 
-		peaks("Peaks", "run_peaks_" + fileName + ".dat"), 
-		gpTaus("GP", "run_gpt_" + fileName + ".dat"), 
-		gpErrors("GP_err", "run_gperr_" + fileName + ".dat"), 
-		gpChi("GP_chiSq", "run_gpchi_" + fileName + ".dat") {
+		stats(toCalc), families(neededFamilies(StatSet(toCalc))), pgramMethod(pgramMethod), 
+		c1vals("C1", "run_c1_" + fileName + ".dat", storeDistribs), 
+		periods("Period", "run_peri_" + fileName + ".dat", storeDistribs), 
+		periodograms("Periodograms", "run_pgram_" + fileName + ".dat", storeCurves), 
+		cutDmdt50Amp3s("50th percentile crossing 1/3 amp", "run_cut50_3_" + fileName + ".dat", storeDistribs), 
+		cutDmdt50Amp2s("50th percentile crossing 1/2 amp", "run_cut50_2_" + fileName + ".dat", storeDistribs), 
+		cutDmdt90Amp3s("90th percentile crossing 1/3 amp", "run_cut90_3_" + fileName + ".dat", storeDistribs), 
+		cutDmdt90Amp2s("90th percentile crossing 1/2 amp", "run_cut90_2_" + fileName + ".dat", storeDistribs), 
+		dmdtMedians("DMDT Medians", "run_dmdtmed_" + fileName + ".dat", storeCurves), 
+		cutIAcf9s("ACF crossing 1/9", "run_acf9_" + fileName + ".dat", storeDistribs), 
+		cutIAcf4s("ACF crossing 1/4", "run_acf4_" + fileName + ".dat", storeDistribs), 
+		cutIAcf2s("ACF crossing 1/2", "run_acf2_" + fileName + ".dat", storeDistribs), 
+		iAcfs("ACFs", "run_acf_" + fileName + ".dat", storeCurves), 
+		cutSAcf9s("ACF crossing 1/9", "run_sacf9_" + fileName + ".dat", storeDistribs), 
+		cutSAcf4s("ACF crossing 1/4", "run_sacf4_" + fileName + ".dat", storeDistribs), 
+		cutSAcf2s("ACF crossing 1/2", "run_sacf2_" + fileName + ".dat", storeDistribs), 
+		sAcfs("ACFs", "run_sacf_" + fileName + ".dat", storeCurves), 
+		cutPeakAmp3s("Timescales for peaks > 1/3 amp", "run_cutpeak3_" + fileName + ".dat", storeDistribs), 
+		cutPeakAmp2s("Timescales for peaks > 1/3 amp", "run_cutpeak2_" + fileName + ".dat", storeDistribs), 
+		cutPeakMax08s("Timescales for peaks > 80% max", "run_cutpeak45_" + fileName + ".dat", storeDistribs), 
+		peaks("Peaks", "run_peaks_" + fileName + ".dat", storeCurves), 
+		gpTaus("GP", "run_gpt_" + fileName + ".dat", storeDistribs), 
+		gpErrors("GP_err", "run_gperr_" + fileName + ".dat", storeDistribs), 
+		gpChi("GP_chiSq", "run_gpchi_" + fileName + ".dat", storeDistribs), 
+		drwTaus("DRW", "run_drwt_" + fileName + ".dat", storeDistribs), 
+		drwErrors("DRW_err", "run_drwerr_" + fileName + ".dat", storeDistribs), 
+		drwChi("DRW_chiSq", "run_drwchi_" + fileName + ".dat", storeDistribs), 
+		rmsRooted("RMS Curves", "run_rms_" + fileName + ".dat", storeCurves), 
+		rmsPairs("RMS Medians", "run_rmsmed_" + fileName + ".dat", storeCurves), 
+		periodTimeouts(0), gpTimeouts(0), drwTimeouts(0), analyzedCurves(0), 
+		profiledCurves(0), simSeconds(0.0), analysisSeconds(0.0), 
+		familySeconds(N_FAMILIES, 0.0), simCounts(), analysisCounts(), 
+		familyCounts(N_FAMILIES), 
+		familyFailures(N_FAMILIES, vector<long>(N_STAT_STATUS, 0)) {
 	if (toCalc.size() == 0) {
 		throw std::invalid_argument("LcBinStats won't calculate any statistics");
 	}
 }
 
+/** Every family, indexed by StatFamily.
+ *
+ * To add a family, append it to the StatFamily enumeration, give it 
+ * an analyze*() function, and list it here. Families share no results 
+ * except through the AnalysisContext, so no family depends on another.
+ */
+const LcBinStats::FamilySpec LcBinStats::FAMILIES[] = {
+	{FAMILY_C1,          "C1",          1, {C1                  }, &LcBinStats::analyzeC1         }, 
+	{FAMILY_PERIODOGRAM, "Periodogram", 2, {PERIOD, PERIODOGRAM }, &LcBinStats::analyzePeriodogram}, 
+	{FAMILY_DMDT,        "DMDT",        2, {DMDTCUT, DMDT       }, &LcBinStats::analyzeDmdt       }, 
+	{FAMILY_IACF,        "ACF",         2, {IACFCUT, IACF       }, &LcBinStats::analyzeIAcf       }, 
+	{FAMILY_SACF,        "SACF",        2, {SACFCUT, SACF       }, &LcBinStats::analyzeSAcf       }, 
+	{FAMILY_PEAK,        "Peaks",       2, {PEAKCUT, PEAKFIND   }, &LcBinStats::analyzePeak       }, 
+	{FAMILY_GP,          "GP",          1, {GPTAU               }, &LcBinStats::analyzeGp         }, 
+	{FAMILY_DRW,         "DRW",         1, {DRWTAU              }, &LcBinStats::analyzeDrw        }, 
+	{FAMILY_RMS,         "RMS",         2, {RMSPLOT, RMSPAIRPLOT}, &LcBinStats::analyzeRms        }
+};
+
+const size_t LcBinStats::N_FAMILIES = sizeof(FAMILIES)/sizeof(FAMILIES[0]);
+
+/** Returns the description of a family
+ *
+ * @param[in] family The family to look up.
+ *
+ * @return The element of @ref FAMILIES describing @p family.
+ *
+ * @exception std::logic_error Thrown if @p family is not a valid 
+ *	family, or if @ref FAMILIES is out of order.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+const LcBinStats::FamilySpec& LcBinStats::familySpec(StatFamily family) {
+	const size_t i = static_cast<size_t>(family);
+	if (i >= N_FAMILIES || FAMILIES[i].family != family) {
+		throw std::logic_error("Unknown statistic family in familySpec(): " 
+			+ lexical_cast<string>(family));
+	}
+	return FAMILIES[i];
+}
+
+/** Returns the families needed to produce a set of statistics
+ *
+ * Within a family, each do*() function computes only the intermediate 
+ * results needed by the outputs it is asked for.
+ *
+ * @param[in] toCalc The statistics to calculate.
+ *
+ * @return The families that produce at least one element of @p toCalc, 
+ *	each listed once, in the order of the StatFamily enumeration.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the list.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+std::vector<LcBinStats::StatFamily> LcBinStats::neededFamilies(
+		const StatSet& toCalc) {
+	vector<StatFamily> needed;
+	for (size_t i = 0; i < N_FAMILIES; i++) {
+		for (size_t j = 0; j < FAMILIES[i].nOutputs; j++) {
+			if (toCalc.contains(FAMILIES[i].outputs[j])) {
+				needed.push_back(FAMILIES[i].family);
+				break;
+			}
+		}
+	}
+	return needed;
+}
+
+/** Returns the name of a family for column headers
+ *
+ * @param[in] family The family to name.
+ *
+ * @return A short name for the statistics in @p family. The name is a 
+ *	string literal, so it may also be used to label a TraceSpan.
+ *
+ * @exception std::logic_error Thrown if @p family is not a valid family.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+const char* LcBinStats::familyName(StatFamily family) {
+	return familySpec(family).name;
+}
+
 /** Wrapper for calculating the Scargle ACF.
+ * 
+ * The ACF is calculated with the algorithm chosen by 
+ * setScargleAcfMethod(). With @ref SACF_PERIODOGRAM "SACF_PERIODOGRAM", 
+ * the periodogram and transform depend only on the cadence and lag 
+ * grid, so they are shared by all light curves with the same times.
  * 
  * @param[in] times	Times at which data were taken
  * @param[in] data	The data (typically fluxes or magnitudes) measured 
@@ -140,12 +521,43 @@ LcBinStats::LcBinStats(const string& modelName, const RangeList& binSpecs, const
  */
 void scargleAdapter(const DoubleVec& times, const DoubleVec& data, 
 		double offStep, size_t nOffsets, DoubleVec& acfs) {
-	DoubleVec offsets;
-	for (size_t i = 0; i < nOffsets; i++) {
-		offsets.push_back(i*offStep);
+	if (getScargleAcfMethod() == SACF_PERIODOGRAM) {
+		ScargleAcfPlan::forCadence(times, offStep, nOffsets)->autoCorr(data, acfs);
+	} else {
+		DoubleVec offsets;
+		for (size_t i = 0; i < nOffsets; i++) {
+			offsets.push_back(i*offStep);
+		}
+		
+		kpftimes::autoCorr(times, data, offsets, acfs/*, 100000.0*/);
 	}
-	
-	kpftimes::autoCorr(times, data, offsets, acfs/*, 100000.0*/);
+}
+
+/** Wrapper for calculating the Scargle ACF at only the lags that 
+ *	doAcf() uses.
+ * 
+ * Only used with @ref SACF_PERIODOGRAM "SACF_PERIODOGRAM".
+ * 
+ * @param[in] times	Times at which data were taken
+ * @param[in] data	The data (typically fluxes or magnitudes) measured 
+ *			at each time
+ * @param[in] offStep, nOffsets The spacing and number of grid points over which 
+ *			the ACF should be calculated. The grid will run from 
+ *			lags of 0 to (<tt>nOffsets</tt>-1)*<tt>offStep</tt>.
+ * @param[in] lags	The grid points at which the ACF is needed.
+ * @param[in] level	The ACF is also needed at every grid point up to 
+ *			the first one where it is below @p level.
+ * @param[out] acfs	The value of the autocorrelation function at each 
+ *			offset, or NaN where it was not needed.
+ *
+ * @exceptsafe The program is in a consistent state in the event of 
+ *	an exception.
+ */
+void scargleLagAdapter(const DoubleVec& times, const DoubleVec& data, 
+		double offStep, size_t nOffsets, const vector<size_t>& lags, 
+		double level, DoubleVec& acfs) {
+	ScargleAcfPlan::forCadence(times, offStep, nOffsets)->autoCorr(data, 
+		lags, level, acfs);
 }
 
 // Current implementation of analyzeLightCurve does not use  
@@ -160,8 +572,10 @@ void scargleAdapter(const DoubleVec& times, const DoubleVec& data,
  * @param[in] times The time stamps of the observations.
  * @param[in] fluxes A Monte Carlo realization of a light curve sampled over times.
  * @param[in] trueParams The parameters used to calculate fluxes.
+ * @param[in] units Whether @p fluxes holds fluxes or magnitudes.
  *
  * @pre @p times.size() = @p fluxes.size()
+ * @pre @p fluxes is in the same order as <tt>times.timeView()</tt>
  * @pre No element of @p times is NaN
  * @pre @p fluxes may contain NaNs
  *
@@ -171,80 +585,806 @@ void scargleAdapter(const DoubleVec& times, const DoubleVec& data,
  *	have matching lengths.
  * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
  *	and @p fluxes are too short to calculate the desired statistics.
+ *	If setStatThreads() was given more than one thread, it is reported 
+ *	as a std::runtime_error instead.
+ * @exception std::runtime_error Thrown if the threads for the 
+ *	statistic families could not be started.
  *
  * @exceptsafe The object is in a valid state in the event of an exception.
  *
  * @internal @note The implementation *should not* assume that any particular parameter 
  * is defined in trueParams.
  */
-void LcBinStats::analyzeLightCurve(const DoubleVec& times, const DoubleVec& fluxes, 
-		const ParamList& trueParams) {
+void LcBinStats::analyzeLightCurve(const models::Cadence& times, const DoubleVec& fluxes, 
+		const ParamList& trueParams, utils::PhotUnits units) {
+	const ProfileScope timer(analysisSeconds, analysisCounts);
+	const TraceSpan span("analyze");
+	
+	// Cleaned light curve, plus intermediate results shared by the families
+	const AnalysisContext lc(times, fluxes, units);
+
+	analyzeContext(lc, trueParams);
+}
+
+/** Returns the timescale used to simulate a light curve
+ *
+ * @param[in] trueParams The parameters used to simulate the light curve.
+ *
+ * @return The period or coherence time in @p trueParams, or NaN if it 
+ *	has none.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double trueTimescale(const ParamList& trueParams) {
+	try {
+		return trueParams.get(models::PARAM_PERIOD);
+	} catch (const models::except::MissingParam& e) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+}
+
+/** Calculates statistics from a range of light curves and records 
+ *	them in order.
+ * 
+ * @param[in] trials The light curves to analyze.
+ * @param[in] first, last The range of indices in @p trials to analyze.
+ *
+ * @pre <tt>first &le; last &le; trials.size()</tt>
+ * @pre Each element of @p trials satisfies the preconditions of 
+ *	analyzeLightCurve().
+ *
+ * @post The object contains the same statistics as if 
+ *	analyzeLightCurve() had been called on <tt>trials[first, last)</tt>, 
+ *	in order.
+ *
+ * @perform If periods or periodograms are requested, the periodograms 
+ *	of up to ANALYSIS_BATCH consecutive light curves on the same 
+ *	cadence are computed together, so that the trigonometric terms 
+ *	are loaded once per batch rather than once per light curve. The 
+ *	batches are skipped if setStatBudget() was given a budget, so 
+ *	that each periodogram still gets its own deadline.
+ * @perfmore Likewise, if Gaussian process timescales are requested and 
+ *	gpBatchable() is true, the fits of light curves on the same 
+ *	cadence are done together, sharing their time lags and any 
+ *	covariance matrices factored at the same hyperparameters.
+ * @perfmore Likewise, if interpolated ACFs or their cuts are requested, 
+ *	the ACFs of light curves on the same cadence are interpolated and 
+ *	transformed together.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception std::invalid_argument Thrown if a light curve's times and 
+ *	fluxes do not have matching lengths.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if a light 
+ *	curve is too short to calculate the desired statistics.
+ * @exception std::runtime_error Thrown if the threads for the 
+ *	statistic families could not be started.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeLightCurves(const vector<SimTrial>& trials, 
+		size_t first, size_t last) {
+	const bool pgramBatch = batchesPeriodograms();
+	const bool gpBatch    = batchesGpFits();
+	const bool acfBatch   = batchesAcfs();
+	if (!pgramBatch && !gpBatch && !acfBatch) {
+		for(size_t i = first; i < last; i++) {
+			analyzeLightCurve(trials[i].times, trials[i].fluxes, 
+				trials[i].params, trials[i].units);
+		}
+		return;
+	}
 	
-	if (times.size() != fluxes.size()) {
-		throw std::invalid_argument("Times and fluxes must have the same length in analyzeLightCurve() (gave " 
-			+ lexical_cast<string>(times.size()) + " for times and " 
-			+ lexical_cast<string>(fluxes.size()) + " for fluxes).");
+	const ProfileScope timer(analysisSeconds, analysisCounts);
+	for(size_t start = first; start < last; start += ANALYSIS_BATCH) {
+		const size_t end = std::min(last, start + ANALYSIS_BATCH);
+		
+		vector<shared_ptr<AnalysisContext> > contexts;
+		vector<double> trueTimes;
+		contexts.reserve(end - start);
+		trueTimes.reserve(end - start);
+		for(size_t i = start; i < end; i++) {
+			contexts.push_back(shared_ptr<AnalysisContext>(new AnalysisContext(
+				trials[i].times, trials[i].fluxes, trials[i].units)));
+			trueTimes.push_back(trueTimescale(trials[i].params));
+		}
+		
+		if (pgramBatch) {
+			batchPeriodograms(contexts);
+		}
+		if (gpBatch) {
+			batchGpFits(contexts, trueTimes);
+		}
+		if (acfBatch) {
+			batchAcfs(contexts);
+		}
+		
+		for(size_t i = start; i < end; i++) {
+			const TraceSpan span("analyze");
+			analyzeContext(*contexts[i - start], trials[i].params);
+		}
 	}
+}
 
-	DoubleVec mags;
-	utils::fluxToMag(fluxes, mags);
+/** Tests whether analyzeLightCurves() should compute periodograms 
+ *	for several light curves at once.
+ *
+ * @return True if periods or periodograms are requested with a method 
+ *	that can share work between light curves, and no statistic has 
+ *	a time budget.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool LcBinStats::batchesPeriodograms() const {
+	return (stats.contains(PERIOD) || stats.contains(PERIODOGRAM)) 
+		&& pgramMethod != LS_FAST && !(getStatBudget() > 0.0);
+}
 
-	DoubleVec cleanTimes, cleanMags;
-	utils::removeNans(mags, cleanMags, times, cleanTimes);
+/** Computes the periodograms of the light curves that share a cadence, 
+ *	and records them in each light curve.
+ *
+ * @param[in,out] contexts The light curves to analyze. Those with the 
+ *	same valid times as the first have their periodograms recorded.
+ *
+ * @pre No element of @p contexts is shared with another thread.
+ *
+ * @post If two or more elements of @p contexts share a cadence, 
+ *	AnalysisContext::findPeriodogram() returns their periodograms. 
+ *	Any other light curve is left for analyzePeriodogram() to handle 
+ *	on its own.
+ * @post If getProfiling() is true, the time spent is added to the 
+ *	periodogram family's total.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the periodograms.
+ *
+ * @exceptsafe Each element of @p contexts is unchanged in the event 
+ *	of an exception.
+ */
+void LcBinStats::batchPeriodograms(const vector<shared_ptr<AnalysisContext> >& 
+		contexts) {
+	if (contexts.empty()) {
+		return;
+	}
+	
+	const ProfileScope timer(familySeconds[FAMILY_PERIODOGRAM], 
+		familyCounts[FAMILY_PERIODOGRAM]);
+	const TraceSpan span("periodogram batch");
+	
+	// Light curves with missing points have their own cadences
+	const models::Cadence& shared = contexts.front()->getCadence();
+	vector<AnalysisContext*> members;
+	vector<const DoubleVec*> data;
+	for(vector<shared_ptr<AnalysisContext> >::const_iterator it = contexts.begin(); 
+			it != contexts.end(); it++) {
+		if ((*it)->getCadence().sameAs(shared)) {
+			members.push_back(it->get());
+			data.push_back(&(*it)->getMags());
+		}
+	}
+	if (members.size() < 2) {
+		return;
+	}
+	
+	shared_ptr<const PeriodogramPlan> plan;
+	try {
+		plan = PeriodogramPlan::forCadence(shared.timeView(), pgramMethod);
+	} catch (const std::invalid_argument& e) {
+		// Reported as NotEnoughData when each light curve is analyzed
+		return;
+	}
+	
+	vector<DoubleVec> powers;
+	plan->lombScargleBatch(data, powers);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	for(size_t k = 0; k < members.size(); k++) {
+		members[k]->setPeriodogram(plan, powers[k]);
+	}
+}
+
+/** Tests whether analyzeLightCurves() should fit Gaussian processes 
+ *	to several light curves at once.
+ *
+ * @return True if Gaussian process timescales are requested, 
+ *	gpBatchable() is true, and no statistic has a time budget.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool LcBinStats::batchesGpFits() const {
+	return stats.contains(GPTAU) && gpBatchable() && !(getStatBudget() > 0.0);
+}
+
+/** Fits Gaussian processes to the light curves that share a cadence, 
+ *	and records the fits in each light curve.
+ *
+ * @param[in,out] contexts The light curves to analyze. Those with the 
+ *	same valid times as the first have their fits recorded.
+ * @param[in] trueTimes The timescale used to simulate each element 
+ *	of @p contexts, or NaN if not available.
+ *
+ * @pre No element of @p contexts is shared with another thread.
+ * @pre @p trueTimes.size() = @p contexts.size()
+ *
+ * @post If two or more elements of @p contexts share a cadence with 
+ *	at least two times, AnalysisContext::findGpFit() returns their 
+ *	fits. Any other light curve is left for analyzeGp() to handle 
+ *	on its own.
+ * @post If getProfiling() is true, the time spent is added to the 
+ *	Gaussian process family's total.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	fit the models.
+ *
+ * @exceptsafe Each element of @p contexts is unchanged in the event 
+ *	of an exception.
+ */
+void LcBinStats::batchGpFits(const vector<shared_ptr<AnalysisContext> >& 
+		contexts, const vector<double>& trueTimes) {
+	if (contexts.empty()) {
+		return;
+	}
+	
+	const ProfileScope timer(familySeconds[FAMILY_GP], familyCounts[FAMILY_GP]);
+	const TraceSpan span("gp batch");
+	
+	// Light curves with missing points have their own cadences
+	const models::Cadence& shared = contexts.front()->getCadence();
+	vector<AnalysisContext*> members;
+	vector<const DoubleVec*> data;
+	vector<double> memberTimes;
+	for(size_t k = 0; k < contexts.size(); k++) {
+		if (contexts[k]->getCadence().sameAs(shared)) {
+			members.push_back(contexts[k].get());
+			data.push_back(&contexts[k]->getMags());
+			memberTimes.push_back(trueTimes[k]);
+		}
+	}
+	// Too-short light curves are reported as NotEnoughData when each 
+	//	light curve is analyzed
+	if (members.size() < 2 || members.front()->getTimes().size() < 2) {
+		return;
+	}
+	
+	vector<double> timescales, timeErrors;
+	fitGaussGpBatch(members.front()->getTimes(), data, memberTimes, 
+		timescales, timeErrors);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	for(size_t k = 0; k < members.size(); k++) {
+		members[k]->setGpFit(timescales[k], timeErrors[k]);
+	}
+}
+
+/** Tests whether analyzeLightCurves() should compute interpolated 
+ *	ACFs for several light curves at once.
+ *
+ * @return True if interpolated ACFs or their cuts are requested, and 
+ *	no statistic has a time budget.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool LcBinStats::batchesAcfs() const {
+	return (stats.contains(IACFCUT) || stats.contains(IACF)) 
+		&& !(getStatBudget() > 0.0);
+}
+
+/** Computes the interpolated ACFs of the light curves that share a 
+ *	cadence, and records them in each light curve.
+ *
+ * @param[in,out] contexts The light curves to analyze. Those with the 
+ *	same valid times as the first have their ACFs recorded.
+ *
+ * @pre No element of @p contexts is shared with another thread.
+ *
+ * @post If two or more elements of @p contexts share a cadence, 
+ *	AnalysisContext::findAcf() returns their ACFs. Any other light 
+ *	curve is left for analyzeIAcf() to handle on its own.
+ * @post If getProfiling() is true, the time spent is added to the 
+ *	interpolated ACF family's total.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the ACFs.
+ * @exception std::runtime_error Thrown if the ACF calculations produce 
+ *	an error.
+ *
+ * @exceptsafe Each element of @p contexts is unchanged in the event 
+ *	of an exception.
+ */
+void LcBinStats::batchAcfs(const vector<shared_ptr<AnalysisContext> >& 
+		contexts) {
+	if (contexts.empty()) {
+		return;
+	}
+	
+	const ProfileScope timer(familySeconds[FAMILY_IACF], familyCounts[FAMILY_IACF]);
+	const TraceSpan span("acf batch");
+	
+	// Light curves with missing points have their own cadences
+	const models::Cadence& shared = contexts.front()->getCadence();
+	vector<AnalysisContext*> members;
+	for(vector<shared_ptr<AnalysisContext> >::const_iterator it = contexts.begin(); 
+			it != contexts.end(); it++) {
+		if ((*it)->getCadence().sameAs(shared)) {
+			members.push_back(it->get());
+		}
+	}
+	if (members.size() < 2) {
+		return;
+	}
+	
+	batchInterpAcfs(members);
+}
+
+/** Calculates statistics from a prepared light curve and records them.
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueParams The parameters used to simulate @p lc.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc is 
+ *	too short to calculate the desired statistics. If setStatThreads() 
+ *	was given more than one thread, it is reported as a 
+ *	std::runtime_error instead.
+ * @exception std::runtime_error Thrown if the threads for the 
+ *	statistic families could not be started.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeContext(const AnalysisContext& lc, 
+		const ParamList& trueParams) {
+	analyzedCurves++;
+	if (getProfiling()) {
+		profiledCurves++;
+	}
 
 	////////////////////////////////////////
 	// Light curve properties
-	double trueTime;
+	const double trueTime = trueTimescale(trueParams);
+	
+	////////////////////////////////////////
+	// The statistics
+	
+	// Families were chosen once, in the constructor
+	const size_t nWorkers = std::min(static_cast<size_t>(getStatThreads()), 
+		families.size());
+	if (nWorkers <= 1) {
+		for(vector<StatFamily>::const_iterator it = families.begin(); 
+				it != families.end(); it++) {
+			analyzeFamily(*it, lc, trueTime);
+		}
+	} else {
+		// Each family writes only to its own collections
+		runBlocks(families.size(), nWorkers, 
+			FamilyAnalyzer(*this, families, lc, trueTime));
+	}
+}
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+/** Calculates one group of statistics from a light curve and records them.
+ * 
+ * @param[in] family The group of statistics to calculate.
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime The timescale used to simulate the light curve, 
+ *	or NaN if not available.
+ *
+ * @post The collections belonging to @p family have a new element. No 
+ *	other collection is read or changed, so different families may be 
+ *	calculated on different threads at once.
+ * @post If getProfiling() is true, the time spent is added to the 
+ *	family's total.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate the desired statistics.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeFamily(StatFamily family, const AnalysisContext& lc, 
+		double trueTime) {
+	const FamilySpec& spec = familySpec(family);
+	
+	// Each family has its own total, so threads never share one
+	const ProfileScope timer(familySeconds[family], familyCounts[family]);
+	const TraceSpan span(spec.name);
+	
+	(this->*spec.analyze)(lc, trueTime);
+}
+
+/** Records why a family could not analyze a light curve
+ * 
+ * @param[in] family The family that analyzed the light curve.
+ * @param[in] status The outcome of the analysis.
+ *
+ * @post If @p status is not STAT_OK, it is counted for @p family. 
+ *	Each family has its own counts, so different families may 
+ *	call countFailure() on different threads at once.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void LcBinStats::countFailure(StatFamily family, StatStatus status) {
+	if (status != STAT_OK) {
+		familyFailures[family][status]++;
+	}
+}
+
+// Only the fits use the true timescale, but every family has the 
+//	same signature so that it can be called through FAMILIES
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+/** Calculates the C1 statistic of a light curve and records it.
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime Not used.
+ *
+ * @post @ref c1vals has a new element.
+ * @post If C1 is undefined for @p lc, the failure is counted.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate C1.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeC1(const AnalysisContext& lc, double trueTime) {
+	double C1 = 0.0;
+	// Shares the ranked magnitudes with the amplitude
+	const StatStatus status = tryC1Sorted(lc.getRankedMags(), C1);
+	if (status == STAT_NOT_ENOUGH_DATA) {
+		// The one failure we don't want to ignore
+		throw except::NotEnoughData("Need at least 3 values to compute C1.");
+	} else if (status == STAT_OK) {
+		c1vals.addStat(C1);
+	} else {
+		c1vals.addNull();
+		countFailure(FAMILY_C1, status);
+	}
+}
+
+/** Calculates the period and periodogram of a light curve and 
+ *	records them.
+ * 
+ * Expensive statistics are abandoned if they exceed getStatBudget().
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime Not used.
+ *
+ * @post @ref periods and @ref periodograms have new elements, if 
+ *	requested.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate a periodogram.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzePeriodogram(const AnalysisContext& lc, double trueTime) {
+	const StatDeadline budget(getStatBudget());
 	try {
-		trueTime = trueParams.get("p");
-	} catch (const models::except::MissingParam& e) {
-		trueTime = std::numeric_limits<double>::quiet_NaN();
+		doPeriodogram(lc, stats.contains(PERIOD), 
+			stats.contains(PERIODOGRAM), pgramMethod, 
+			this->periods, this->periodograms);
+	} catch (const except::TimedOut &e) {
+		// No periodogram to plot, but the period is undefined
+		if (stats.contains(PERIOD)) {
+			periods.addNull();
+		}
+		periodTimeouts++;
+	}
+}
+
+/** Calculates the &Delta;m&Delta;t statistics of a light curve and 
+ *	records them.
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime Not used.
+ *
+ * @post The &Delta;m&Delta;t collections have new elements, if 
+ *	requested.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate a &Delta;m&Delta;t plot.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeDmdt(const AnalysisContext& lc, double trueTime) {
+	doDmdt(lc, stats.contains(DMDTCUT), stats.contains(DMDT), 
+		this->cutDmdt50Amp3s, this->cutDmdt50Amp2s, 
+		this->cutDmdt90Amp3s, this->cutDmdt90Amp2s, 
+		this->dmdtMedians);
+}
+
+/** Calculates the interpolated ACF statistics of a light curve and 
+ *	records them.
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime Not used.
+ *
+ * @post The interpolated ACF collections have new elements, if 
+ *	requested.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate an ACF.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeIAcf(const AnalysisContext& lc, double trueTime) {
+	doAcf(lc, interp::autoCorr, 
+		stats.contains(IACFCUT), stats.contains(IACF), 
+		this->cutIAcf9s, this->cutIAcf4s, this->cutIAcf2s, this->iAcfs);
+}
+
+/** Calculates the Scargle ACF statistics of a light curve and 
+ *	records them.
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime Not used.
+ *
+ * @post The Scargle ACF collections have new elements, if requested.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate an ACF.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeSAcf(const AnalysisContext& lc, double trueTime) {
+	doAcf(lc, scargleAdapter, 
+		stats.contains(SACFCUT), stats.contains(SACF), 
+		this->cutSAcf9s, this->cutSAcf4s, this->cutSAcf2s, this->sAcfs, 
+		(getScargleAcfMethod() == SACF_PERIODOGRAM ? scargleLagAdapter : NULL));
+}
+
+/** Calculates the peak-finding statistics of a light curve and 
+ *	records them.
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime Not used.
+ *
+ * @post The peak-finding collections have new elements, if requested.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to find peaks.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzePeak(const AnalysisContext& lc, double trueTime) {
+	doPeak(lc, stats.contains(PEAKCUT), stats.contains(PEAKFIND), 
+		this->cutPeakAmp3s, this->cutPeakAmp2s, this->cutPeakMax08s, this->peaks);
+}
+
+/** Fits a Gaussian process model to a light curve and records the 
+ *	results.
+ * 
+ * Expensive statistics are abandoned if they exceed getStatBudget().
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime The timescale used to simulate the light curve, 
+ *	or NaN if not available.
+ *
+ * @post The Gaussian process collections have new elements.
+ * @post If no timescale was found, the reason is counted.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to fit.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeGp(const AnalysisContext& lc, double trueTime) {
+	const StatDeadline budget(getStatBudget());
+	try {
+		countFailure(FAMILY_GP, doGaussFit(lc, stats.contains(GPTAU), 
+			trueTime, this->gpTaus, this->gpErrors, this->gpChi));
+	} catch (const except::TimedOut &e) {
+		gpTaus  .addNull();
+		gpErrors.addNull();
+		gpChi   .addNull();
+		gpTimeouts++;
+	}
+}
+
+/** Fits a damped random walk model to a light curve and records the 
+ *	results.
+ * 
+ * Expensive statistics are abandoned if they exceed getStatBudget().
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime The timescale used to simulate the light curve, 
+ *	or NaN if not available.
+ *
+ * @post The damped random walk collections have new elements.
+ * @post If no timescale was found, the reason is counted.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to fit.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeDrw(const AnalysisContext& lc, double trueTime) {
+	const StatDeadline budget(getStatBudget());
+	try {
+		countFailure(FAMILY_DRW, doDrwFit(lc, stats.contains(DRWTAU), 
+			trueTime, this->drwTaus, this->drwErrors, this->drwChi));
+	} catch (const except::TimedOut &e) {
+		drwTaus  .addNull();
+		drwErrors.addNull();
+		drwChi   .addNull();
+		drwTimeouts++;
+	}
+}
+
+/** Calculates the RMS-timescale curves of a light curve and records 
+ *	them.
+ * 
+ * @param[in] lc The light curve to analyze.
+ * @param[in] trueTime Not used.
+ *
+ * @post @ref rmsRooted and @ref rmsPairs have new elements, if 
+ *	requested.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate an RMS.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::analyzeRms(const AnalysisContext& lc, double trueTime) {
+	doRms(lc, stats.contains(RMSPLOT), stats.contains(RMSPAIRPLOT), 
+		this->rmsRooted, this->rmsPairs);
+}
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+/** Records the time spent simulating light curves for this object
+ *
+ * Light curves are simulated outside LcBinStats, so the caller times 
+ * them, typically with monotonicSeconds().
+ *
+ * @param[in] seconds The time spent simulating.
+ *
+ * @post If getProfiling() is true, @p seconds is included in the 
+ *	simulation time printed by printBinStats().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void LcBinStats::addSimulationTime(double seconds) {
+	simSeconds += seconds;
+}
+
+/** Records the hardware events counted while simulating light curves 
+ *	for this object
+ *
+ * Light curves are simulated outside LcBinStats, so the caller counts 
+ * the events, typically as the difference of two calls to threadCounts().
+ *
+ * @param[in] counts The events counted while simulating.
+ *
+ * @post If getProfileCounters() is true, @p counts is included in the 
+ *	simulation counts printed by printBinStats().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void LcBinStats::addSimulationCounts(const HardwareCounts& counts) {
+	simCounts += counts;
+}
+
+/** Appends the statistics collected by another LcBinStats to this one.
+ * 
+ * The results in @p other are treated as if they came from 
+ * light curves analyzed after all the light curves already recorded 
+ * in this object. Merging the results of several LcBinStats in the 
+ * order in which their light curves were generated gives the same 
+ * output as analyzing all the light curves with a single object.
+ * 
+ * @param[in] other The statistics to add to this object.
+ *
+ * @pre @p other calculates the same statistics as this object
+ * @pre If this object stores distributions, so does @p other
+ *
+ * @post The object contains all the statistics previously stored, 
+ *	followed by the statistics stored in @p other.
+ * @post The bin and file names of the object are unchanged.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception std::invalid_argument Thrown if @p other does not calculate 
+ *	the same statistics as this object, or if this object stores 
+ *	distributions and @p other does not.
+ *
+ * @exceptsafe The object is in a valid state in the event of an exception.
+ */
+void LcBinStats::merge(const LcBinStats& other) {
+	if (other.stats != this->stats) {
+		throw std::invalid_argument("Cannot merge LcBinStats that calculate different statistics.");
 	}
 	
-	////////////////////////////////////////
-	// The statistics
-	
-	if (hasStat(stats, C1)) {
-		try {
-			double C1 = getC1(cleanMags);
-			c1vals.addStat(C1);
-		} catch (const except::NotEnoughData &e) {
-			// The one kind of Undefined we don't want to ignore
-			throw;
-		} catch (const except::Undefined &e) {
-			// Undefined must have been thrown by getC1(), 
-			//	so addStat() has not yet been called
-			c1vals.addNull();
-		}
-	}
+	c1vals.append(other.c1vals);
 
-	doPeriodogram(cleanTimes, cleanMags, hasStat(stats, PERIOD), 
-		hasStat(stats, PERIODOGRAM), this->periods, this->periodograms);
-	
-	doDmdt(cleanTimes, cleanMags, hasStat(stats, DMDTCUT), hasStat(stats, DMDT), 
-		this->cutDmdt50Amp3s, this->cutDmdt50Amp2s, 
-		this->cutDmdt90Amp3s, this->cutDmdt90Amp2s, 
-		this->dmdtMedians);
+	periods.append(other.periods);
+	periodograms.append(other.periodograms);
 
-	doAcf(cleanTimes, cleanMags, interp::autoCorr, 
-		hasStat(stats, IACFCUT), hasStat(stats, IACF), 
-		this->cutIAcf9s, this->cutIAcf4s, this->cutIAcf2s, this->iAcfs);
+	cutDmdt50Amp3s.append(other.cutDmdt50Amp3s);
+	cutDmdt50Amp2s.append(other.cutDmdt50Amp2s);
+	cutDmdt90Amp3s.append(other.cutDmdt90Amp3s);
+	cutDmdt90Amp2s.append(other.cutDmdt90Amp2s);
+	dmdtMedians.append(other.dmdtMedians);
 
-	doAcf(cleanTimes, cleanMags, scargleAdapter, 
-		hasStat(stats, SACFCUT), hasStat(stats, SACF), 
-		this->cutSAcf9s, this->cutSAcf4s, this->cutSAcf2s, this->sAcfs);
+	cutIAcf9s.append(other.cutIAcf9s);
+	cutIAcf4s.append(other.cutIAcf4s);
+	cutIAcf2s.append(other.cutIAcf2s);
+	iAcfs.append(other.iAcfs);
 
-	doPeak(cleanTimes, cleanMags, hasStat(stats, PEAKCUT), hasStat(stats, PEAKFIND), 
-		this->cutPeakAmp3s, this->cutPeakAmp2s, this->cutPeakMax08s, this->peaks);
+	cutSAcf9s.append(other.cutSAcf9s);
+	cutSAcf4s.append(other.cutSAcf4s);
+	cutSAcf2s.append(other.cutSAcf2s);
+	sAcfs.append(other.sAcfs);
+	
+	cutPeakAmp3s.append(other.cutPeakAmp3s);
+	cutPeakAmp2s.append(other.cutPeakAmp2s);
+	cutPeakMax08s.append(other.cutPeakMax08s);
+	peaks.append(other.peaks);
+	
+	gpTaus  .append(other.gpTaus);
+	gpErrors.append(other.gpErrors);
+	gpChi.append(other.gpChi);
+	
+	drwTaus  .append(other.drwTaus);
+	drwErrors.append(other.drwErrors);
+	drwChi.append(other.drwChi);
+	
+	rmsRooted.append(other.rmsRooted);
+	rmsPairs .append(other.rmsPairs);
 
-	doGaussFit(cleanTimes, cleanMags, hasStat(stats, GPTAU), trueTime, 
-		this->gpTaus, this->gpErrors, this->gpChi);
-}
+	periodTimeouts += other.periodTimeouts;
+	gpTimeouts     += other.gpTimeouts;
+	drwTimeouts    += other.drwTimeouts;
+	analyzedCurves += other.analyzedCurves;
 
-// Re-enable all compiler warnings
-#ifdef GNUC_FINEWARN
-#pragma GCC diagnostic pop
-#endif
+	profiledCurves  += other.profiledCurves;
+	simSeconds      += other.simSeconds;
+	analysisSeconds += other.analysisSeconds;
+	for(size_t i = 0; i < familySeconds.size(); i++) {
+		familySeconds[i] += other.familySeconds[i];
+	}
+	simCounts      += other.simCounts;
+	analysisCounts += other.analysisCounts;
+	for(size_t i = 0; i < familyCounts.size(); i++) {
+		familyCounts[i] += other.familyCounts[i];
+	}
+	for(size_t i = 0; i < familyFailures.size(); i++) {
+		for(size_t j = 0; j < familyFailures[i].size(); j++) {
+			familyFailures[i][j] += other.familyFailures[i][j];
+		}
+	}
+}
 
 /** Deletes all the simulation results from the object. 
  * 
@@ -283,6 +1423,612 @@ void LcBinStats::clear() {
 	gpTaus  .clear();
 	gpErrors.clear();
 	gpChi.clear();
+	
+	drwTaus  .clear();
+	drwErrors.clear();
+	drwChi.clear();
+	
+	rmsRooted.clear();
+	rmsPairs .clear();
+
+	periodTimeouts = 0;
+	gpTimeouts     = 0;
+	drwTimeouts    = 0;
+	analyzedCurves = 0;
+
+	profiledCurves  = 0;
+	simSeconds      = 0.0;
+	analysisSeconds = 0.0;
+	std::fill(familySeconds.begin(), familySeconds.end(), 0.0);
+	simCounts      = HardwareCounts();
+	analysisCounts = HardwareCounts();
+	std::fill(familyCounts.begin(), familyCounts.end(), HardwareCounts());
+	for(size_t i = 0; i < familyFailures.size(); i++) {
+		std::fill(familyFailures[i].begin(), familyFailures[i].end(), 0);
+	}
+}
+
+/** Returns every collection of statistics in the object
+ *
+ * @return Pointers to the collections, in the order they are printed 
+ *	by printBinStats().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the list.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+vector<const NamedCollection*> LcBinStats::collections() const {
+	const NamedCollection* const all[] = {&c1vals, &periods, &periodograms, 
+		&cutDmdt50Amp3s, &cutDmdt50Amp2s, &cutDmdt90Amp3s, &cutDmdt90Amp2s, 
+		&dmdtMedians, &cutIAcf9s, &cutIAcf4s, &cutIAcf2s, &iAcfs, 
+		&cutSAcf9s, &cutSAcf4s, &cutSAcf2s, &sAcfs, 
+		&cutPeakAmp3s, &cutPeakAmp2s, &cutPeakMax08s, &peaks, 
+		&gpTaus, &gpErrors, &gpChi, &drwTaus, &drwErrors, &drwChi, 
+		&rmsRooted, &rmsPairs};
+	return vector<const NamedCollection*>(all, all + sizeof(all)/sizeof(all[0]));
+}
+
+/** Returns the heap memory held by the statistics collected so far
+ *
+ * @return The total of NamedCollection::memoryBytes() over all the 
+ *	collections in the object.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	list the collections.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+size_t LcBinStats::memoryBytes() const {
+	const vector<const NamedCollection*> all = collections();
+	
+	size_t total = 0;
+	for(vector<const NamedCollection*>::const_iterator it = all.begin(); 
+			it != all.end(); it++) {
+		total += (*it)->memoryBytes();
+	}
+	return total;
+}
+
+/** Returns the number of light curves analyzed so far
+ *
+ * @return The number of calls to analyzeLightCurve(), including the 
+ *	light curves of any merged or restored bins.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long LcBinStats::trials() const {
+	return analyzedCurves;
+}
+
+/** Includes one collection in a search for the largest relative error
+ *
+ * @param[in] stats The collection to examine.
+ * @param[in,out] worst The largest relative error found so far, or 
+ *	NaN if none has been found.
+ *
+ * @post If the relative error of @p stats is defined and larger than 
+ *	@p worst, or @p worst is NaN, then @p worst is the relative error 
+ *	of @p stats.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void updateWorstError(const CollectedScalars& stats, double& worst) {
+	const double error = stats.relativeError();
+	if (!kpfutils::isNan(error) && (kpfutils::isNan(worst) || error > worst)) {
+		worst = error;
+	}
+}
+
+/** Returns the largest relative standard error of the summary 
+ *	statistics collected so far
+ *
+ * Only the scalar statistics whose means are printed by printBinStats() 
+ * are considered. Statistics with fewer than two finite values so far 
+ * have no error estimate and are ignored.
+ *
+ * @return The largest value of CollectedScalars::relativeError() over 
+ *	the statistics requested from the object, or NaN if none of them 
+ *	has an error estimate.
+ *
+ * @perform O(1) time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double LcBinStats::relativeError() const {
+	double worst = std::numeric_limits<double>::quiet_NaN();
+
+	if (stats.contains(C1)) {
+		updateWorstError(c1vals, worst);
+	}
+	if (stats.contains(PERIOD)) {
+		updateWorstError(periods, worst);
+	}
+	if (stats.contains(DMDTCUT)) {
+		updateWorstError(cutDmdt50Amp3s, worst);
+		updateWorstError(cutDmdt50Amp2s, worst);
+		updateWorstError(cutDmdt90Amp3s, worst);
+		updateWorstError(cutDmdt90Amp2s, worst);
+	}
+	if (stats.contains(IACFCUT)) {
+		updateWorstError(cutIAcf9s, worst);
+		updateWorstError(cutIAcf4s, worst);
+		updateWorstError(cutIAcf2s, worst);
+	}
+	if (stats.contains(SACFCUT)) {
+		updateWorstError(cutSAcf9s, worst);
+		updateWorstError(cutSAcf4s, worst);
+		updateWorstError(cutSAcf2s, worst);
+	}
+	if (stats.contains(PEAKCUT)) {
+		updateWorstError(cutPeakAmp3s,  worst);
+		updateWorstError(cutPeakAmp2s,  worst);
+		updateWorstError(cutPeakMax08s, worst);
+	}
+	if (stats.contains(GPTAU)) {
+		updateWorstError(gpTaus,   worst);
+		updateWorstError(gpErrors, worst);
+	}
+	if (stats.contains(DRWTAU)) {
+		updateWorstError(drwTaus,   worst);
+		updateWorstError(drwErrors, worst);
+	}
+	
+	return worst;
+}
+
+/** Returns one collection of scalar statistics
+ *
+ * Together with CollectedScalars::data(), this lets programs that 
+ * embed the simulator read the statistics without going through the 
+ * distribution files.
+ *
+ * @param[in] tag The name of the statistic, as used in its 
+ *	distribution file: @c c1, @c peri, @c cut50_3, @c cut50_2, 
+ *	@c cut90_3, @c cut90_2, @c acf9, @c acf4, @c acf2, @c sacf9, 
+ *	@c sacf4, @c sacf2, @c cutpeak3, @c cutpeak2, @c cutpeak45, 
+ *	@c gpt, @c gperr, @c gpchi, @c drwt, @c drwerr, or @c drwchi.
+ *
+ * @return A reference to the collection, valid for the lifetime of 
+ *	the object. The collection is empty unless its statistic was 
+ *	requested in the constructor.
+ *
+ * @exception std::invalid_argument Thrown if @p tag does not name a 
+ *	scalar statistic.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const CollectedScalars& LcBinStats::getScalars(const string& tag) const {
+	if      (tag == "c1"       ) { return c1vals;         }
+	else if (tag == "peri"     ) { return periods;        }
+	else if (tag == "cut50_3"  ) { return cutDmdt50Amp3s; }
+	else if (tag == "cut50_2"  ) { return cutDmdt50Amp2s; }
+	else if (tag == "cut90_3"  ) { return cutDmdt90Amp3s; }
+	else if (tag == "cut90_2"  ) { return cutDmdt90Amp2s; }
+	else if (tag == "acf9"     ) { return cutIAcf9s;      }
+	else if (tag == "acf4"     ) { return cutIAcf4s;      }
+	else if (tag == "acf2"     ) { return cutIAcf2s;      }
+	else if (tag == "sacf9"    ) { return cutSAcf9s;      }
+	else if (tag == "sacf4"    ) { return cutSAcf4s;      }
+	else if (tag == "sacf2"    ) { return cutSAcf2s;      }
+	else if (tag == "cutpeak3" ) { return cutPeakAmp3s;   }
+	else if (tag == "cutpeak2" ) { return cutPeakAmp2s;   }
+	else if (tag == "cutpeak45") { return cutPeakMax08s;  }
+	else if (tag == "gpt"      ) { return gpTaus;         }
+	else if (tag == "gperr"    ) { return gpErrors;       }
+	else if (tag == "gpchi"    ) { return gpChi;          }
+	else if (tag == "drwt"     ) { return drwTaus;        }
+	else if (tag == "drwerr"   ) { return drwErrors;      }
+	else if (tag == "drwchi"   ) { return drwChi;         }
+	throw std::invalid_argument("No scalar statistic named " + tag + ".");
+}
+
+/** Returns one collection of function statistics
+ *
+ * @param[in] tag The name of the statistic, as used in its 
+ *	distribution file: @c pgram, @c dmdtmed, @c acf, @c sacf, 
+ *	@c peaks, @c rms, or @c rmsmed.
+ *
+ * @return A reference to the collection, valid for the lifetime of 
+ *	the object. The collection is empty unless its statistic was 
+ *	requested in the constructor.
+ *
+ * @exception std::invalid_argument Thrown if @p tag does not name a 
+ *	function statistic.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const CollectedPairs& LcBinStats::getPairs(const string& tag) const {
+	if      (tag == "pgram"  ) { return periodograms; }
+	else if (tag == "dmdtmed") { return dmdtMedians;  }
+	else if (tag == "acf"    ) { return iAcfs;        }
+	else if (tag == "sacf"   ) { return sAcfs;        }
+	else if (tag == "peaks"  ) { return peaks;        }
+	else if (tag == "rms"    ) { return rmsRooted;    }
+	else if (tag == "rmsmed" ) { return rmsPairs;     }
+	throw std::invalid_argument("No function statistic named " + tag + ".");
+}
+
+/** Writes the statistics collected so far to their distribution 
+ *	files, and frees their memory
+ *
+ * Long runs can call spill() whenever memoryBytes() exceeds a limit, 
+ * or after every fixed number of light curves, so that the bin runs in 
+ * bounded memory and an interrupted run leaves its results so far on 
+ * disk. Only the running summaries of scalar statistics are kept.
+ *
+ * @post Each statistic that held any values has written them to the 
+ *	next part of its distribution file, as described by 
+ *	CollectedScalars::spill() and CollectedPairs::spill(), and holds 
+ *	no values.
+ *
+ * @exception kpfutils::except::FileIo Thrown if a distribution file 
+ *	could not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	write the distribution files.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception. Every statistic is either written and freed, or unchanged.
+ */
+void LcBinStats::spill() {
+	c1vals        .spill();
+	periods       .spill();
+	periodograms  .spill();
+	
+	cutDmdt50Amp3s.spill();
+	cutDmdt50Amp2s.spill();
+	cutDmdt90Amp3s.spill();
+	cutDmdt90Amp2s.spill();
+	dmdtMedians   .spill();
+	
+	cutIAcf9s     .spill();
+	cutIAcf4s     .spill();
+	cutIAcf2s     .spill();
+	iAcfs         .spill();
+	
+	cutSAcf9s     .spill();
+	cutSAcf4s     .spill();
+	cutSAcf2s     .spill();
+	sAcfs         .spill();
+	
+	cutPeakAmp3s  .spill();
+	cutPeakAmp2s  .spill();
+	cutPeakMax08s .spill();
+	peaks         .spill();
+	
+	gpTaus        .spill();
+	gpErrors      .spill();
+	gpChi         .spill();
+	drwTaus       .spill();
+	drwErrors     .spill();
+	drwChi        .spill();
+	
+	rmsRooted     .spill();
+	rmsPairs      .spill();
+}
+
+/** Renames the parts written under a label so that they follow the 
+ *	parts of another bin
+ *
+ * A merged run reads the statistics of each shard, renames their 
+ * parts, and merges them in order, so that its distribution files 
+ * can be joined as if a single process had written them.
+ *
+ * @param[in] label The label the parts were written with, as chosen 
+ *	with setPartPrefix().
+ * @param[in] previous The bin that the statistics will be merged into.
+ *
+ * @pre The label chosen with setPartPrefix() is empty
+ *
+ * @post Each statistic's parts are renamed as described by 
+ *	CollectedScalars::renumberParts() and CollectedPairs::renumberParts().
+ *
+ * @exception kpfutils::except::FileIo Thrown if a part could not be 
+ *	renamed.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	rename the parts.
+ *
+ * @exceptsafe The parts renamed before an exception keep their new 
+ *	names.
+ */
+void LcBinStats::renumberParts(const string& label, const LcBinStats& previous) const {
+	c1vals        .renumberParts(label, previous.c1vals);
+	periods       .renumberParts(label, previous.periods);
+	periodograms  .renumberParts(label, previous.periodograms);
+	
+	cutDmdt50Amp3s.renumberParts(label, previous.cutDmdt50Amp3s);
+	cutDmdt50Amp2s.renumberParts(label, previous.cutDmdt50Amp2s);
+	cutDmdt90Amp3s.renumberParts(label, previous.cutDmdt90Amp3s);
+	cutDmdt90Amp2s.renumberParts(label, previous.cutDmdt90Amp2s);
+	dmdtMedians   .renumberParts(label, previous.dmdtMedians);
+	
+	cutIAcf9s     .renumberParts(label, previous.cutIAcf9s);
+	cutIAcf4s     .renumberParts(label, previous.cutIAcf4s);
+	cutIAcf2s     .renumberParts(label, previous.cutIAcf2s);
+	iAcfs         .renumberParts(label, previous.iAcfs);
+	
+	cutSAcf9s     .renumberParts(label, previous.cutSAcf9s);
+	cutSAcf4s     .renumberParts(label, previous.cutSAcf4s);
+	cutSAcf2s     .renumberParts(label, previous.cutSAcf2s);
+	sAcfs         .renumberParts(label, previous.sAcfs);
+	
+	cutPeakAmp3s  .renumberParts(label, previous.cutPeakAmp3s);
+	cutPeakAmp2s  .renumberParts(label, previous.cutPeakAmp2s);
+	cutPeakMax08s .renumberParts(label, previous.cutPeakMax08s);
+	peaks         .renumberParts(label, previous.peaks);
+	
+	gpTaus        .renumberParts(label, previous.gpTaus);
+	gpErrors      .renumberParts(label, previous.gpErrors);
+	gpChi         .renumberParts(label, previous.gpChi);
+	drwTaus       .renumberParts(label, previous.drwTaus);
+	drwErrors     .renumberParts(label, previous.drwErrors);
+	drwChi        .renumberParts(label, previous.drwChi);
+	
+	rmsRooted     .renumberParts(label, previous.rmsRooted);
+	rmsPairs      .renumberParts(label, previous.rmsPairs);
+}
+
+/** Saves the state of a spilled bin to a text file
+ *
+ * Together with the distribution files already written by spill(), 
+ * the state is enough to continue the bin in a later run.
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ *
+ * @pre spill() has been called since the last light curve was analyzed.
+ *
+ * @post The timeout counts, the number of light curves analyzed, 
+ *	the profiling times, the failure counts, the hardware counts, 
+ *	and the state of each collection of statistics are written to 
+ *	@p file, one line each.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the state could not 
+ *	be written.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void LcBinStats::writeState(FILE* const file) const {
+	// %.17g preserves every bit of a double
+	if (fprintf(file, "%ld %ld %ld %ld %ld %.17g %.17g", periodTimeouts, 
+			gpTimeouts, drwTimeouts, analyzedCurves, profiledCurves, 
+			simSeconds, analysisSeconds) < 0) {
+		fileError(file, "Could not save statistics in writeState(): ");
+	}
+	for(vector<double>::const_iterator it = familySeconds.begin(); 
+			it != familySeconds.end(); it++) {
+		if (fprintf(file, " %.17g", *it) < 0) {
+			fileError(file, "Could not save statistics in writeState(): ");
+		}
+	}
+	for(size_t i = 0; i < familyFailures.size(); i++) {
+		for(size_t j = 0; j < familyFailures[i].size(); j++) {
+			if (fprintf(file, " %ld", familyFailures[i][j]) < 0) {
+				fileError(file, "Could not save statistics in writeState(): ");
+			}
+		}
+	}
+	vector<HardwareCounts> stageCounts(1, simCounts);
+	stageCounts.push_back(analysisCounts);
+	stageCounts.insert(stageCounts.end(), familyCounts.begin(), familyCounts.end());
+	for(vector<HardwareCounts>::const_iterator it = stageCounts.begin(); 
+			it != stageCounts.end(); it++) {
+		if (fprintf(file, " %.17g %.17g %.17g", it->cycles, 
+				it->instructions, it->cacheMisses) < 0) {
+			fileError(file, "Could not save statistics in writeState(): ");
+		}
+	}
+	if (fprintf(file, "\n") < 0) {
+		fileError(file, "Could not save statistics in writeState(): ");
+	}
+	
+	c1vals        .writeState(file);
+	periods       .writeState(file);
+	periodograms  .writeState(file);
+	
+	cutDmdt50Amp3s.writeState(file);
+	cutDmdt50Amp2s.writeState(file);
+	cutDmdt90Amp3s.writeState(file);
+	cutDmdt90Amp2s.writeState(file);
+	dmdtMedians   .writeState(file);
+	
+	cutIAcf9s     .writeState(file);
+	cutIAcf4s     .writeState(file);
+	cutIAcf2s     .writeState(file);
+	iAcfs         .writeState(file);
+	
+	cutSAcf9s     .writeState(file);
+	cutSAcf4s     .writeState(file);
+	cutSAcf2s     .writeState(file);
+	sAcfs         .writeState(file);
+	
+	cutPeakAmp3s  .writeState(file);
+	cutPeakAmp2s  .writeState(file);
+	cutPeakMax08s .writeState(file);
+	peaks         .writeState(file);
+	
+	gpTaus        .writeState(file);
+	gpErrors      .writeState(file);
+	gpChi         .writeState(file);
+	drwTaus       .writeState(file);
+	drwErrors     .writeState(file);
+	drwChi        .writeState(file);
+	
+	rmsRooted     .writeState(file);
+	rmsPairs      .writeState(file);
+}
+
+/** Restores a state saved by writeState()
+ *
+ * @param[in] file An open file handle positioned at the text written 
+ *	by writeState().
+ *
+ * @pre The object was constructed with the same arguments as the 
+ *	object that wrote the text.
+ *
+ * @post The object has the same timeout counts, light curve count, 
+ *	profiling times, failure counts, hardware counts, and collections 
+ *	of statistics as the object that wrote the text, and 
+ *	holds no statistics in memory beyond their running summaries.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p file does not 
+ *	contain a saved state.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception.
+ */
+void LcBinStats::readState(FILE* const file) {
+	long newPeriodTimeouts, newGpTimeouts, newDrwTimeouts, newAnalyzed, 
+		newProfiled;
+	double newSim, newAnalysis;
+	if (fscanf(file, "%ld %ld %ld %ld %ld %lf %lf", &newPeriodTimeouts, 
+			&newGpTimeouts, &newDrwTimeouts, &newAnalyzed, &newProfiled, 
+			&newSim, &newAnalysis) != 7) {
+		throw kpfutils::except::FileIo("Misformatted saved state for " 
+			+ binName + ".");
+	}
+	vector<double> newFamilies(familySeconds.size());
+	for(vector<double>::iterator it = newFamilies.begin(); 
+			it != newFamilies.end(); it++) {
+		if (fscanf(file, "%lf", &(*it)) != 1) {
+			throw kpfutils::except::FileIo("Misformatted saved state for " 
+				+ binName + ".");
+		}
+	}
+	vector<vector<long> > newFailures(familyFailures);
+	for(size_t i = 0; i < newFailures.size(); i++) {
+		for(size_t j = 0; j < newFailures[i].size(); j++) {
+			if (fscanf(file, "%ld", &newFailures[i][j]) != 1) {
+				throw kpfutils::except::FileIo("Misformatted saved state for " 
+					+ binName + ".");
+			}
+		}
+	}
+	// Simulation, analysis, then each family
+	vector<HardwareCounts> newCounts(2 + familyCounts.size());
+	for(vector<HardwareCounts>::iterator it = newCounts.begin(); 
+			it != newCounts.end(); it++) {
+		if (fscanf(file, "%lf %lf %lf", &it->cycles, &it->instructions, 
+				&it->cacheMisses) != 3) {
+			throw kpfutils::except::FileIo("Misformatted saved state for " 
+				+ binName + ".");
+		}
+	}
+	
+	c1vals        .readState(file);
+	periods       .readState(file);
+	periodograms  .readState(file);
+	
+	cutDmdt50Amp3s.readState(file);
+	cutDmdt50Amp2s.readState(file);
+	cutDmdt90Amp3s.readState(file);
+	cutDmdt90Amp2s.readState(file);
+	dmdtMedians   .readState(file);
+	
+	cutIAcf9s     .readState(file);
+	cutIAcf4s     .readState(file);
+	cutIAcf2s     .readState(file);
+	iAcfs         .readState(file);
+	
+	cutSAcf9s     .readState(file);
+	cutSAcf4s     .readState(file);
+	cutSAcf2s     .readState(file);
+	sAcfs         .readState(file);
+	
+	cutPeakAmp3s  .readState(file);
+	cutPeakAmp2s  .readState(file);
+	cutPeakMax08s .readState(file);
+	peaks         .readState(file);
+	
+	gpTaus        .readState(file);
+	gpErrors      .readState(file);
+	gpChi         .readState(file);
+	drwTaus       .readState(file);
+	drwErrors     .readState(file);
+	drwChi        .readState(file);
+	
+	rmsRooted     .readState(file);
+	rmsPairs      .readState(file);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	periodTimeouts  = newPeriodTimeouts;
+	gpTimeouts      = newGpTimeouts;
+	drwTimeouts     = newDrwTimeouts;
+	analyzedCurves  = newAnalyzed;
+	profiledCurves  = newProfiled;
+	simSeconds      = newSim;
+	analysisSeconds = newAnalysis;
+	familySeconds.swap(newFamilies);
+	simCounts      = newCounts[0];
+	analysisCounts = newCounts[1];
+	std::copy(newCounts.begin() + 2, newCounts.end(), familyCounts.begin());
+	familyFailures.swap(newFailures);
+}
+
+/** Prints the memory held by each collection of statistics, by 
+ *	the caches, and by the program as a whole
+ *
+ * The report has one summary line naming the bin, followed by one 
+ * indented line for each collection that holds any memory.
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ *
+ * @exception std::runtime_error Thrown if the report could not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	list the collections.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void LcBinStats::printMemoryReport(FILE* const file) const {
+	const double MB = 1024.0*1024.0;
+	
+	if (fprintf(file, "Memory for %s: statistics %.3g MB, caches %.3g MB, "
+			"RSS %.0f MB, peak RSS %.0f MB\n", binName.c_str(), 
+			memoryBytes() / MB, utils::cacheBytes() / MB, 
+			currentMemoryMb(), peakMemoryMb()) < 0) {
+		cError("Could not print output in printMemoryReport(): ");
+	}
+	
+	const vector<const NamedCollection*> all = collections();
+	for(vector<const NamedCollection*>::const_iterator it = all.begin(); 
+			it != all.end(); it++) {
+		const size_t bytes = (*it)->memoryBytes();
+		if (bytes > 0 && fprintf(file, "\t%-40s %10.3g MB\n", 
+				(*it)->getStatName().c_str(), bytes / MB) < 0) {
+			cError("Could not print output in printMemoryReport(): ");
+		}
+	}
+}
+
+/** Prints how many light curves each family could not analyze, 
+ *	and why
+ *
+ * The report has one line for each family that failed on at least 
+ * one light curve. Timeouts are reported by printBinStats() instead.
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ *
+ * @exception std::runtime_error Thrown if the report could not be written.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void LcBinStats::printFailureReport(FILE* const file) const {
+	for(size_t i = 0; i < N_FAMILIES; i++) {
+		const vector<long>& counts = familyFailures[i];
+		const long undefined = counts[STAT_UNDEFINED];
+		const long tooShort  = counts[STAT_NOT_ENOUGH_DATA];
+		const long noFit     = counts[STAT_NO_FIT];
+		const long total = undefined + tooShort + noFit;
+		if (total > 0 && fprintf(file, "%s: %s not found for %ld of %ld "
+				"light curves (%ld undefined, %ld too short, %ld did not "
+				"converge)\n", binName.c_str(), FAMILIES[i].name, total, 
+				analyzedCurves, undefined, tooShort, noFit) < 0) {
+			cError("Could not print output in printFailureReport(): ");
+		}
+	}
 }
 
 /** Prints a row representing the accumulated statistics to the specified file.
@@ -291,6 +2037,18 @@ void LcBinStats::clear() {
  * the statistics. The row is in tab-delimited format, with statistics 
  * separated from their errors by the  sign. When feeding the log file into 
  * a csv reader, you should give both characters as delimiters.
+ * If setStatBudget() was given a time limit, the periodogram, GP, and DRW 
+ * statistics are each followed by the number of light curves for which 
+ * they timed out.
+ * If setTargetError() was given a target, the statistics are followed 
+ * by the number of light curves analyzed.
+ * If setProfiling() turned profiling on, the row ends with the mean 
+ * time per light curve, in milliseconds, spent simulating, analyzing, 
+ * and calculating each family of statistics. If setProfileCounters() 
+ * also turned on hardware counters, these are followed by the mean 
+ * millions of cycles, the instructions per cycle, and the mean 
+ * thousands of last-level cache misses per light curve for the same 
+ * stages.
  * 
  * @param[in] file An open file handle representing the text file to write to.
  *
@@ -303,72 +2061,132 @@ void LcBinStats::clear() {
  *	of an exception.
  */
 void LcBinStats::printBinStats(FILE* const file) const {
+	const TraceSpan span("output");
+	
 	// Start with the bin ID
 	if (fprintf(file, "%s", binName.c_str()) < 0) {
 		cError("Could not print output in printBinStats(): ");
 	}
 
-	if (hasStat(stats, C1)) {
+	if (stats.contains(C1)) {
 		c1vals.printStats(file);
 	}
-	if (hasStat(stats, PERIOD)) {
+	if (stats.contains(PERIOD)) {
 		periods.printStats(file);
 	}
-	if (hasStat(stats, PERIODOGRAM)) {
+	if (stats.contains(PERIODOGRAM)) {
 		periodograms.printStats(file);
 	}
-	if (hasStat(stats, DMDTCUT)) {
+	if (getStatBudget() > 0.0 
+			&& (stats.contains(PERIOD) || stats.contains(PERIODOGRAM))) {
+		if (fprintf(file, "\t%ld", periodTimeouts) < 0) {
+			cError("Could not print output in printBinStats(): ");
+		}
+	}
+	if (stats.contains(DMDTCUT)) {
 		cutDmdt50Amp3s.printStats(file);
 		cutDmdt50Amp2s.printStats(file);
 		cutDmdt90Amp3s.printStats(file);
 		cutDmdt90Amp2s.printStats(file);
 	}
-	if (hasStat(stats, DMDT)) {
+	if (stats.contains(DMDT)) {
 		dmdtMedians.printStats(file);
 	}
 
-	if (hasStat(stats, IACFCUT)) {
+	if (stats.contains(IACFCUT)) {
 		cutIAcf9s.printStats(file);
 		cutIAcf4s.printStats(file);
 		cutIAcf2s.printStats(file);
 	}
-	if (hasStat(stats, IACF)) {
+	if (stats.contains(IACF)) {
 		iAcfs.printStats(file);
 	}
 
-	if (hasStat(stats, SACFCUT)) {
+	if (stats.contains(SACFCUT)) {
 		cutSAcf9s.printStats(file);
 		cutSAcf4s.printStats(file);
 		cutSAcf2s.printStats(file);
 	}
-	if (hasStat(stats, SACF)) {
+	if (stats.contains(SACF)) {
 		sAcfs.printStats(file);
 	}
 
-	if (hasStat(stats, PEAKCUT)) {
+	if (stats.contains(PEAKCUT)) {
 		cutPeakAmp3s .printStats(file);
 		cutPeakAmp2s .printStats(file);
 		cutPeakMax08s.printStats(file);
 	}
-	if (hasStat(stats, PEAKFIND)) {
+	if (stats.contains(PEAKFIND)) {
 		peaks.printStats(file);
 	}
-	if (hasStat(stats, GPTAU)) {
+	if (stats.contains(GPTAU)) {
 		gpTaus  .printStats(file);
 		gpErrors.printStats(file);
 		
-		vector<double> normDevs;
-		gpChi.toVector(normDevs);
-		double chi = 0.0;
-		for(vector<double>::const_iterator it = normDevs.begin(); 
-				it != normDevs.end(); it++) {
-			if (!kpfutils::isNan(*it)) {
-				chi += (*it) * (*it);
-			}
+		double chi = gpChi.sumSquares();
+		if (fprintf(file, "\t%6.3g", chi) < 0) {
+			cError("Could not print output in printBinStats(): ");
+		}
+		if (getStatBudget() > 0.0 && fprintf(file, "\t%ld", gpTimeouts) < 0) {
+			cError("Could not print output in printBinStats(): ");
 		}
+	}
+	if (stats.contains(DRWTAU)) {
+		drwTaus  .printStats(file);
+		drwErrors.printStats(file);
+		
+		double chi = drwChi.sumSquares();
 		if (fprintf(file, "\t%6.3g", chi) < 0) {
 			cError("Could not print output in printBinStats(): ");
 		}
+		if (getStatBudget() > 0.0 && fprintf(file, "\t%ld", drwTimeouts) < 0) {
+			cError("Could not print output in printBinStats(): ");
+		}
+	}
+	if (stats.contains(RMSPLOT)) {
+		rmsRooted.printStats(file);
+	}
+	if (stats.contains(RMSPAIRPLOT)) {
+		rmsPairs.printStats(file);
+	}
+	if (getTargetError() > 0.0 && fprintf(file, "\t%ld", analyzedCurves) < 0) {
+		cError("Could not print output in printBinStats(): ");
+	}
+	
+	if (getProfiling()) {
+		// Mean time per light curve, in ms
+		const double scale = (profiledCurves > 0 ? 1000.0 / profiledCurves 
+			: std::numeric_limits<double>::quiet_NaN());
+		if (fprintf(file, "\t%.3g\t%.3g", scale*simSeconds, 
+				scale*analysisSeconds) < 0) {
+			cError("Could not print output in printBinStats(): ");
+		}
+		for(vector<StatFamily>::const_iterator it = families.begin(); 
+				it != families.end(); it++) {
+			if (fprintf(file, "\t%.3g", scale*familySeconds[*it]) < 0) {
+				cError("Could not print output in printBinStats(): ");
+			}
+		}
+	}
+	if (getProfileCounters()) {
+		vector<HardwareCounts> stageCounts(1, simCounts);
+		stageCounts.push_back(analysisCounts);
+		for(vector<StatFamily>::const_iterator it = families.begin(); 
+				it != families.end(); it++) {
+			stageCounts.push_back(familyCounts[*it]);
+		}
+		
+		const double perCurve = (profiledCurves > 0 ? 1.0 / profiledCurves 
+			: std::numeric_limits<double>::quiet_NaN());
+		for(vector<HardwareCounts>::const_iterator it = stageCounts.begin(); 
+				it != stageCounts.end(); it++) {
+			const double ipc = (it->cycles > 0.0 ? it->instructions / it->cycles 
+				: std::numeric_limits<double>::quiet_NaN());
+			if (fprintf(file, "\t%.3g\t%.3g\t%.3g", 1e-6*perCurve*it->cycles, 
+					ipc, 1e-3*perCurve*it->cacheMisses) < 0) {
+				cError("Could not print output in printBinStats(): ");
+			}
+		}
 	}
 
 	if (fprintf(file, "\n") < 0) {
@@ -395,6 +2213,7 @@ void LcBinStats::printBinStats(FILE* const file) const {
  */
 void LcBinStats::printBinHeader(FILE* const file, const RangeList& binSpecs, 
 		const std::vector<StatType>& outputStats) {
+	const StatSet wanted(outputStats);
 
 	int status = fprintf(file, "LCType\t");
 	if (status < 0) {
@@ -412,54 +2231,112 @@ void LcBinStats::printBinHeader(FILE* const file, const RangeList& binSpecs,
 		fileError(file, "Header output failed in printBinHeader(): ");
 	}
 
-	if (hasStat(outputStats, C1)) {
+	if (wanted.contains(C1)) {
 		CollectedScalars::printHeader(file, "C1");
 	}
-	if (hasStat(outputStats, PERIOD)) {
+	if (wanted.contains(PERIOD)) {
 		CollectedScalars::printHeader(file, "Period");
 	}
-	if (hasStat(outputStats, PERIODOGRAM)) {
+	if (wanted.contains(PERIODOGRAM)) {
 		CollectedPairs::printHeader(file, "Periodograms");
 	}
-	if (hasStat(outputStats, DMDTCUT)) {
+	if (getStatBudget() > 0.0 
+			&& (wanted.contains(PERIOD) || wanted.contains(PERIODOGRAM))) {
+		if (fprintf(file, "\tPeriod Timeouts") < 0) {
+			fileError(file, "Header output failed in printBinHeader(): ");
+		}
+	}
+	if (wanted.contains(DMDTCUT)) {
 		CollectedScalars::printHeader(file, "50%@1/3");
 		CollectedScalars::printHeader(file, "50%@1/2");
 		CollectedScalars::printHeader(file, "90%@1/3");
 		CollectedScalars::printHeader(file, "90%@1/2");
 	}
-	if (hasStat(outputStats, DMDT)) {
+	if (wanted.contains(DMDT)) {
 		CollectedPairs::printHeader(file, "DMDT Medians");
 	}
-	if (hasStat(outputStats, IACFCUT)) {
+	if (wanted.contains(IACFCUT)) {
 		CollectedScalars::printHeader(file, "ACF@1/9");
 		CollectedScalars::printHeader(file, "ACF@1/4");
 		CollectedScalars::printHeader(file, "ACF@1/2");
 	}
-	if (hasStat(outputStats, IACF)) {
+	if (wanted.contains(IACF)) {
 		CollectedPairs::printHeader(file, "ACFs");
 	}
-	if (hasStat(outputStats, SACFCUT)) {
+	if (wanted.contains(SACFCUT)) {
 		CollectedScalars::printHeader(file, "ACF@1/9");
 		CollectedScalars::printHeader(file, "ACF@1/4");
 		CollectedScalars::printHeader(file, "ACF@1/2");
 	}
-	if (hasStat(outputStats, SACF)) {
+	if (wanted.contains(SACF)) {
 		CollectedPairs::printHeader(file, "ACFs");
 	}
-	if (hasStat(outputStats, PEAKCUT)) {
+	if (wanted.contains(PEAKCUT)) {
 		CollectedScalars::printHeader(file, "PeakFind@1/3");
 		CollectedScalars::printHeader(file, "PeakFind@1/2");
 		CollectedScalars::printHeader(file, "PeakFind@80%");
 	}
-	if (hasStat(outputStats, PEAKFIND)) {
+	if (wanted.contains(PEAKFIND)) {
 		CollectedPairs::printHeader(file, "Peaks");
 	}
-	if (hasStat(outputStats, GPTAU)) {
+	if (wanted.contains(GPTAU)) {
 		CollectedScalars::printHeader(file, "GP Time");
 		CollectedScalars::printHeader(file, "GP Error");
 		if (fprintf(file, "\tGP Chi^2") < 0) {
 			fileError(file, "Header output failed in printBinHeader(): ");
 		}
+		if (getStatBudget() > 0.0 && fprintf(file, "\tGP Timeouts") < 0) {
+			fileError(file, "Header output failed in printBinHeader(): ");
+		}
+	}
+	if (wanted.contains(DRWTAU)) {
+		CollectedScalars::printHeader(file, "DRW Time");
+		CollectedScalars::printHeader(file, "DRW Error");
+		if (fprintf(file, "\tDRW Chi^2") < 0) {
+			fileError(file, "Header output failed in printBinHeader(): ");
+		}
+		if (getStatBudget() > 0.0 && fprintf(file, "\tDRW Timeouts") < 0) {
+			fileError(file, "Header output failed in printBinHeader(): ");
+		}
+	}
+	if (wanted.contains(RMSPLOT)) {
+		CollectedPairs::printHeader(file, "RMS Curves");
+	}
+	if (wanted.contains(RMSPAIRPLOT)) {
+		CollectedPairs::printHeader(file, "RMS Medians");
+	}
+	if (getTargetError() > 0.0 && fprintf(file, "\tTrials") < 0) {
+		fileError(file, "Header output failed in printBinHeader(): ");
+	}
+	
+	if (getProfiling()) {
+		if (fprintf(file, "\tSim ms\tAnalysis ms") < 0) {
+			fileError(file, "Header output failed in printBinHeader(): ");
+		}
+		const vector<StatFamily> families = neededFamilies(wanted);
+		for(vector<StatFamily>::const_iterator it = families.begin(); 
+				it != families.end(); it++) {
+			if (fprintf(file, "\t%s ms", familyName(*it)) < 0) {
+				fileError(file, "Header output failed in printBinHeader(): ");
+			}
+		}
+		
+		if (getProfileCounters()) {
+			vector<string> stages;
+			stages.push_back("Sim");
+			stages.push_back("Analysis");
+			for(vector<StatFamily>::const_iterator it = families.begin(); 
+					it != families.end(); it++) {
+				stages.push_back(familyName(*it));
+			}
+			for(vector<string>::const_iterator it = stages.begin(); 
+					it != stages.end(); it++) {
+				if (fprintf(file, "\t%s Mcycles\t%s IPC\t%s kLLC misses", 
+						it->c_str(), it->c_str(), it->c_str()) < 0) {
+					fileError(file, "Header output failed in printBinHeader(): ");
+				}
+			}
+		}
 	}
 
 	if (fprintf(file, "\n") < 0) {
@@ -467,20 +2344,6 @@ void LcBinStats::printBinHeader(FILE* const file, const RangeList& binSpecs,
 	}
 }
 
-/** Tests whether this object needs to calculate a particular statistic
- *
- * @param[in] orders A list of statistics to calculate.
- * @param[in] x The statistic to look up
- *
- * @return True if this object needs to calculate @p x, false otherwise.
- *
- * @exceptsafe Does not throw exceptions.
- */
-bool LcBinStats::hasStat(const std::vector<StatType>& orders, StatType x) {
-	return (std::find(orders.begin(), orders.end(), x) != orders.end());
-}
-
-
 /** Creates a unique name for the simulation run, formatted to go in a table.
  * 
  * The name is the light curve type, followed by the parameters, in tab-
@@ -2,7 +2,7 @@
  * @file lightcurveMC/binstats.h
  * @author Krzysztof Findeisen
  * @date Reconstructed June 23, 2011
- * @date Last modified August 5, 2013
+ * @date Last modified October 14, 2026
  *
  * @todo Break up this file
  */
@@ -35,11 +35,20 @@
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <boost/shared_ptr.hpp>
+#include "cadence.h"
+#include "fluxmag.h"
 #include "paramlist.h"
+#include "stats/analysiscontext.h"
+#include "stats/lsplan.h"
+#include "stats/profile.h"
 #include "stats/statcollect.h"
+#include "stats/statstatus.h"
 
 namespace lcmc { 
 
+struct SimTrial;
+
 /** This namespace identifies data types and functions that handle 
  * data analysis on simulated light curves.
  */
@@ -90,9 +99,77 @@ enum StatType {
 	PEAKFIND, 
 	/** Represents the best-fit Gaussian process model
 	 */
-	GPTAU
+	GPTAU, 
+	/** Represents the best-fit damped random walk model
+	 */
+	DRWTAU, 
+	/** Represents dumps of the RMS from the first observation to 
+	 *	each later one
+	 */
+	RMSPLOT, 
+	/** Represents dumps of the median RMS over all subintervals, 
+	 *	binned by length
+	 */
+	RMSPAIRPLOT
 };
 
+/** StatSet represents a set of statistics to calculate, with one bit 
+ * per @ref StatType "StatType".
+ *
+ * Membership tests take constant time, and do not depend on the 
+ * order in which the statistics were requested.
+ */
+class StatSet {
+public:
+	/** Creates an empty set
+	 */
+	StatSet();
+
+	/** Creates a set containing the elements of a list
+	 */
+	explicit StatSet(const std::vector<StatType>& stats);
+
+	/** Adds a statistic to the set
+	 */
+	void insert(StatType x);
+
+	/** Tests whether a statistic is in the set
+	 */
+	bool contains(StatType x) const;
+
+	/** Tests whether the set has no elements
+	 */
+	bool empty() const;
+
+	/** Tests whether two sets have the same elements
+	 */
+	bool operator==(const StatSet& other) const;
+
+	/** Tests whether two sets have different elements
+	 */
+	bool operator!=(const StatSet& other) const;
+
+private:
+	unsigned long bits;
+};
+
+/** Sets the number of threads used to calculate the statistics of 
+ *	each light curve
+ */
+void setStatThreads(long nThreads);
+
+/** Returns the number of threads chosen with setStatThreads()
+ */
+long getStatThreads();
+
+/** Sets the relative standard error at which a bin has enough light curves
+ */
+void setTargetError(double error);
+
+/** Returns the target chosen with setTargetError()
+ */
+double getTargetError();
+
 /** Organizes test statistics on artificial light curves. LcBinStats can 
  * collate the results from multiple runs and print summary statistics to log 
  * files.
@@ -112,17 +189,88 @@ public:
 	/** Creates a new stat counter
 	 */
 	explicit LcBinStats(const std::string& modelName, const RangeList& binSpecs, 
-			const std::string& noise, const std::vector<StatType>& toCalc);
+			const std::string& noise, const std::vector<StatType>& toCalc, 
+			bool storeDistribs, PeriodogramMethod pgramMethod = LS_DIRECT, 
+			bool storeCurves = true);
 
 	/** Calculates statistics from the light curve and records them in lcBinStats.
 	 */
-	void analyzeLightCurve(const DoubleVec& times, const DoubleVec& fluxes, 
-		const ParamList& trueParams);
+	void analyzeLightCurve(const models::Cadence& times, const DoubleVec& fluxes, 
+		const ParamList& trueParams, 
+		utils::PhotUnits units = utils::FLUX_UNITS);
+
+	/** Calculates statistics from a range of light curves and records 
+	 *	them in order.
+	 */
+	void analyzeLightCurves(const std::vector<SimTrial>& trials, 
+		size_t first, size_t last);
+
+	/** Records the time spent simulating light curves for this object
+	 */
+	void addSimulationTime(double seconds);
+
+	/** Records the hardware events counted while simulating light 
+	 *	curves for this object
+	 */
+	void addSimulationCounts(const HardwareCounts& counts);
+
+	/** Appends the statistics collected by another LcBinStats to this one.
+	 */
+	void merge(const LcBinStats& other);
 
 	/** Deletes all the simulation results from the object.
 	 */
 	void clear();
 
+	/** Returns the heap memory held by the statistics collected so far
+	 */
+	size_t memoryBytes() const;
+
+	/** Returns the number of light curves analyzed so far
+	 */
+	long trials() const;
+
+	/** Returns the largest relative standard error of the summary 
+	 *	statistics collected so far
+	 */
+	double relativeError() const;
+
+	/** Returns one collection of scalar statistics
+	 */
+	const CollectedScalars& getScalars(const std::string& tag) const;
+
+	/** Returns one collection of function statistics
+	 */
+	const CollectedPairs& getPairs(const std::string& tag) const;
+
+	/** Writes the statistics collected so far to their distribution 
+	 *	files, and frees their memory
+	 */
+	void spill();
+
+	/** Renames the parts written under a label so that they follow 
+	 *	the parts of another bin
+	 */
+	void renumberParts(const std::string& label, const LcBinStats& previous) const;
+
+	/** Saves the state of a spilled bin to a text file
+	 */
+	void writeState(FILE* const file) const;
+
+	/** Restores a state saved by writeState()
+	 */
+	void readState(FILE* const file);
+
+	/** Prints the memory held by each collection of statistics, by 
+	 *	the caches, and by the program as a whole
+	 */
+	void printMemoryReport(FILE* const file) const;
+
+	/** Prints how many light curves each family could not analyze, 
+	 *	and why
+	 */
+	void printFailureReport(FILE* const file) const;
+
 	/** Prints a row representing the accumulated statistics to the specified file
 	 */
 	void printBinStats(FILE* const file) const;
@@ -144,14 +292,128 @@ public:
 		const std::vector<StatType>& outputStats);
 
 private: 
-	/** Tests whether the object needs to calculate a particular statistic
+	/** Calculates statistics from a prepared light curve and records 
+	 *	them.
+	 */
+	void analyzeContext(const AnalysisContext& lc, const ParamList& trueParams);
+
+	/** Tests whether analyzeLightCurves() should compute periodograms 
+	 *	for several light curves at once.
+	 */
+	bool batchesPeriodograms() const;
+
+	/** Computes the periodograms of the light curves that share a cadence, 
+	 *	and records them in each light curve.
+	 */
+	void batchPeriodograms(const std::vector<boost::shared_ptr<AnalysisContext> >& 
+		contexts);
+
+	/** Tests whether analyzeLightCurves() should fit Gaussian processes 
+	 *	to several light curves at once.
+	 */
+	bool batchesGpFits() const;
+
+	/** Fits Gaussian processes to the light curves that share a cadence, 
+	 *	and records the fits in each light curve.
+	 */
+	void batchGpFits(const std::vector<boost::shared_ptr<AnalysisContext> >& 
+		contexts, const std::vector<double>& trueTimes);
+
+	/** Tests whether analyzeLightCurves() should compute interpolated 
+	 *	ACFs for several light curves at once.
+	 */
+	bool batchesAcfs() const;
+
+	/** Computes the interpolated ACFs of the light curves that share a 
+	 *	cadence, and records them in each light curve.
+	 */
+	void batchAcfs(const std::vector<boost::shared_ptr<AnalysisContext> >& 
+		contexts);
+
+	/** Groups of statistics that are calculated from the same 
+	 *	intermediate results, and do not share data with other groups
 	 */
-	static bool hasStat(const std::vector<StatType>& orders, StatType x);
+	enum StatFamily {
+		FAMILY_C1, 
+		FAMILY_PERIODOGRAM, 
+		FAMILY_DMDT, 
+		FAMILY_IACF, 
+		FAMILY_SACF, 
+		FAMILY_PEAK, 
+		FAMILY_GP, 
+		FAMILY_DRW, 
+		FAMILY_RMS
+	};
+
+	/** Describes how to calculate one family of statistics
+	 */
+	struct FamilySpec {
+		/** The family described */
+		StatFamily family;
+		/** A short name for column headers and traces */
+		const char* name;
+		/** The number of elements of @ref outputs in use */
+		size_t nOutputs;
+		/** The statistics the family can produce */
+		StatType outputs[2];
+		/** Calculates the family from a light curve and records 
+		 *	the results in the family's own collections */
+		void (LcBinStats::*analyze)(const AnalysisContext& lc, double trueTime);
+	};
+
+	/** Every family, indexed by StatFamily */
+	static const FamilySpec FAMILIES[];
+
+	/** The number of elements of @ref FAMILIES */
+	static const size_t N_FAMILIES;
+
+	/** Returns the description of a family
+	 */
+	static const FamilySpec& familySpec(StatFamily family);
+
+	/** Calculates one group of statistics from a light curve and 
+	 *	records them
+	 */
+	void analyzeFamily(StatFamily family, const AnalysisContext& lc, 
+		double trueTime);
+
+	// One function per family, called through FAMILIES
+	void analyzeC1         (const AnalysisContext& lc, double trueTime);
+	void analyzePeriodogram(const AnalysisContext& lc, double trueTime);
+	void analyzeDmdt       (const AnalysisContext& lc, double trueTime);
+	void analyzeIAcf       (const AnalysisContext& lc, double trueTime);
+	void analyzeSAcf       (const AnalysisContext& lc, double trueTime);
+	void analyzePeak       (const AnalysisContext& lc, double trueTime);
+	void analyzeGp         (const AnalysisContext& lc, double trueTime);
+	void analyzeDrw        (const AnalysisContext& lc, double trueTime);
+	void analyzeRms        (const AnalysisContext& lc, double trueTime);
+
+	/** Records why a family could not analyze a light curve
+	 */
+	void countFailure(StatFamily family, StatStatus status);
+
+	// Calls analyzeFamily() from worker threads
+	friend class FamilyAnalyzer;
+
+	/** Returns the families needed to produce a set of statistics
+	 */
+	static std::vector<StatFamily> neededFamilies(const StatSet& toCalc);
+
+	/** Returns the name of a family for column headers
+	 */
+	static const char* familyName(StatFamily family);
+
+	/** Returns every collection of statistics in the object
+	 */
+	std::vector<const NamedCollection*> collections() const;
 	
 	std::string binName;
 	std::string fileName;
 	
-	std::vector<StatType> stats;
+	StatSet stats;
+	/** The families that produce @ref stats, in calculation order */
+	std::vector<StatFamily> families;
+	PeriodogramMethod pgramMethod;
 	
 	//----------------------------------------
 
@@ -187,6 +449,43 @@ private:
 	CollectedScalars gpTaus;
 	CollectedScalars gpErrors;
 	CollectedScalars gpChi;
+
+	CollectedScalars drwTaus;
+	CollectedScalars drwErrors;
+	CollectedScalars drwChi;
+
+	// RMS-timescale statistics
+	CollectedPairs rmsRooted;
+	CollectedPairs rmsPairs;
+
+	// Light curves abandoned for exceeding the time limit on statistics
+	long periodTimeouts;
+	long gpTimeouts;
+	long drwTimeouts;
+
+	/** The light curves analyzed */
+	long analyzedCurves;
+
+	// Time spent on each stage, if getProfiling() is true
+	/** The light curves analyzed while profiling */
+	long profiledCurves;
+	/** Seconds spent simulating light curves */
+	double simSeconds;
+	/** Seconds spent in analyzeLightCurve() and analyzeLightCurves() */
+	double analysisSeconds;
+	/** Seconds spent on each family, indexed by StatFamily */
+	std::vector<double> familySeconds;
+	/** Hardware events while simulating, if getProfileCounters() 
+	 *	is true */
+	HardwareCounts simCounts;
+	/** Hardware events in analyzeLightCurve() and analyzeLightCurves() */
+	HardwareCounts analysisCounts;
+	/** Hardware events for each family, indexed by StatFamily */
+	std::vector<HardwareCounts> familyCounts;
+
+	/** Light curves each family could not analyze, indexed by 
+	 *	StatFamily and then by StatStatus */
+	std::vector<std::vector<long> > familyFailures;
 };
 
 }}		// end lcmc::stats
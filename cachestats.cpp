@@ -0,0 +1,237 @@
+/** Hit and miss counters for the program's internal caches
+ * @file lightcurveMC/cachestats.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/thread/mutex.hpp>
+#include "cachestats.h"
+#include "../common/cerror.h"
+#include "stats/profile.h"
+
+namespace lcmc { namespace utils {
+
+using std::string;
+using std::vector;
+
+/** Protects cacheCounters()
+ *
+ * @return The lock that must be held while reading or changing the 
+ *	list of counters.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::mutex& registryLock() {
+	static boost::mutex lock;
+	return lock;
+}
+
+/** Returns every counter created so far
+ *
+ * @return A modifiable list of counters, in order of creation.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+vector<const CacheCounter*>& cacheCounters() {
+	static vector<const CacheCounter*> counters;
+	return counters;
+}
+
+/** Creates a counter and adds it to the report
+ *
+ * @param[in] name A description of the cache, for printCacheReport().
+ *
+ * @post The counter has no hits or misses, and is listed by 
+ *	printCacheReport() until it is destroyed.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	register the counter.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+CacheCounter::CacheCounter(const string& name) : name(name), hits(0), misses(0), 
+		timeLock(), missSeconds(0.0), bytes(0) {
+	boost::mutex::scoped_lock guard(registryLock());
+	cacheCounters().push_back(this);
+}
+
+/** Removes a counter from the report
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+CacheCounter::~CacheCounter() {
+	boost::mutex::scoped_lock guard(registryLock());
+	vector<const CacheCounter*>& counters = cacheCounters();
+	counters.erase(std::remove(counters.begin(), counters.end(), this), 
+		counters.end());
+}
+
+/** Records a lookup that found its result in the cache
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void CacheCounter::hit() {
+	++hits;
+}
+
+/** Records a lookup that had to compute its result
+ *
+ * @param[in] seconds The time spent computing the result.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void CacheCounter::miss(double seconds) {
+	++misses;
+	boost::mutex::scoped_lock guard(timeLock);
+	missSeconds += seconds;
+}
+
+/** Returns the number of lookups that found their result
+ *
+ * @return The number of calls to hit().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long CacheCounter::getHits() const {
+	return hits;
+}
+
+/** Returns the number of lookups that computed their result
+ *
+ * @return The number of calls to miss(), including those made by 
+ *	CacheMiss.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long CacheCounter::getMisses() const {
+	return misses;
+}
+
+/** Records the memory currently held by the cache
+ *
+ * @param[in] bytes The number of bytes held by the cached results.
+ *
+ * @post getBytes() = @p bytes
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void CacheCounter::setBytes(size_t bytes) {
+	boost::mutex::scoped_lock guard(timeLock);
+	this->bytes = bytes;
+}
+
+/** Returns the memory last recorded by setBytes()
+ *
+ * @return The number of bytes held by the cache, or 0 if the cache 
+ *	does not record its memory.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t CacheCounter::getBytes() const {
+	boost::mutex::scoped_lock guard(timeLock);
+	return bytes;
+}
+
+/** Starts timing a cache miss
+ *
+ * @param[in,out] counter The counter in which to record the miss.
+ *
+ * @post When this object is destroyed, @p counter records a miss 
+ *	that took as long as the object's lifetime. The miss is recorded 
+ *	even if the scope is left by an exception.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+CacheMiss::CacheMiss(CacheCounter& counter) : counter(counter), 
+		start(stats::monotonicSeconds()) {
+}
+
+/** Records the cache miss
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+CacheMiss::~CacheMiss() {
+	counter.miss(stats::monotonicSeconds() - start);
+}
+
+/** Prints the hits, misses, and miss times of every cache used so far
+ *
+ * Caches that were never used are not listed.
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the report could not 
+ *	be written.
+ *
+ * @exceptsafe The counters are unchanged in the event of an exception.
+ */
+void printCacheReport(FILE* file) {
+	boost::mutex::scoped_lock guard(registryLock());
+	
+	if (fprintf(file, "%-36s %10s %10s %14s %10s\n", 
+			"Cache", "Hits", "Misses", "Miss time (s)", "MB held") < 0) {
+		kpfutils::fileError(file, "Could not print cache report: ");
+	}
+	for(vector<const CacheCounter*>::const_iterator it = cacheCounters().begin(); 
+			it != cacheCounters().end(); it++) {
+		const CacheCounter& counter = **it;
+		double seconds;
+		{
+			boost::mutex::scoped_lock timeGuard(counter.timeLock);
+			seconds = counter.missSeconds;
+		}
+		if (fprintf(file, "%-36s %10ld %10ld %14.3g %10.3g\n", counter.name.c_str(), 
+				counter.getHits(), counter.getMisses(), seconds, 
+				counter.getBytes() / (1024.0*1024.0)) < 0) {
+			kpfutils::fileError(file, "Could not print cache report: ");
+		}
+	}
+}
+
+/** Returns the memory held by every cache that records it
+ *
+ * @return The total of getBytes() over all counters.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t cacheBytes() {
+	boost::mutex::scoped_lock guard(registryLock());
+	
+	size_t total = 0;
+	for(vector<const CacheCounter*>::const_iterator it = cacheCounters().begin(); 
+			it != cacheCounters().end(); it++) {
+		total += (*it)->getBytes();
+	}
+	return total;
+}
+
+}}		// end lcmc::utils
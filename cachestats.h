@@ -0,0 +1,133 @@
+/** Hit and miss counters for the program's internal caches
+ * @file lightcurveMC/cachestats.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCCACHESTATSH
+#define LCMCCACHESTATSH
+
+#include <string>
+#include <cstdio>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace lcmc { namespace utils {
+
+/** CacheCounter records how often one of the program's caches could 
+ * reuse an earlier result, and how long it spent when it could not.
+ *
+ * Each counter adds itself to the report printed by printCacheReport() 
+ * when it is created, so a counter is usually a function-local static 
+ * next to the cache it describes. Counters may be updated by several 
+ * threads at once.
+ */
+class CacheCounter {
+public:
+	/** Creates a counter and adds it to the report
+	 */
+	explicit CacheCounter(const std::string& name);
+
+	/** Removes a counter from the report
+	 */
+	~CacheCounter();
+
+	/** Records a lookup that found its result in the cache
+	 */
+	void hit();
+
+	/** Records a lookup that had to compute its result
+	 */
+	void miss(double seconds);
+
+	/** Returns the number of lookups that found their result
+	 */
+	long getHits() const;
+
+	/** Returns the number of lookups that computed their result
+	 */
+	long getMisses() const;
+
+	/** Records the memory currently held by the cache
+	 */
+	void setBytes(size_t bytes);
+
+	/** Returns the memory last recorded by setBytes()
+	 */
+	size_t getBytes() const;
+
+private:
+	// Counters are registered by address, and cannot be copied
+	CacheCounter(const CacheCounter&);
+	CacheCounter& operator=(const CacheCounter&);
+
+	// Reads the counts
+	friend void printCacheReport(FILE* file);
+
+	std::string name;
+	boost::detail::atomic_count hits;
+	boost::detail::atomic_count misses;
+	/** Protects missSeconds and bytes */
+	mutable boost::mutex timeLock;
+	double missSeconds;
+	size_t bytes;
+};
+
+/** CacheMiss records a miss in a CacheCounter, along with the time 
+ * spent in its scope.
+ */
+class CacheMiss {
+public:
+	/** Starts timing a cache miss
+	 */
+	explicit CacheMiss(CacheCounter& counter);
+
+	/** Records the cache miss
+	 */
+	~CacheMiss();
+
+private:
+	// Misses are tied to a scope, and cannot be copied
+	CacheMiss(const CacheMiss&);
+	CacheMiss& operator=(const CacheMiss&);
+
+	CacheCounter& counter;
+	/** The time at which the miss started */
+	double start;
+};
+
+/** Prints the hits, misses, and miss times of every cache used so far
+ */
+void printCacheReport(FILE* file);
+
+/** Returns the memory held by every cache that records it
+ */
+size_t cacheBytes();
+
+}}		// end lcmc::utils
+
+#endif		// end LCMCCACHESTATSH
@@ -0,0 +1,426 @@
+/** Implementation of Cadence
+ * @file lightcurveMC/cadence.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include "cadence.h"
+#include "hash.h"
+
+namespace lcmc { namespace models {
+
+using boost::shared_ptr;
+using boost::uint64_t;
+using std::vector;
+
+/** Returns the times shared by every empty cadence
+ *
+ * @return An empty vector.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the vector.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+shared_ptr<const vector<double> > noTimes() {
+	static shared_ptr<const vector<double> > theTimes(new vector<double>());
+	return theTimes;
+}
+
+/** Computes the properties a cadence records about its times
+ *
+ * @param[in] times The times of the cadence, in ascending order.
+ * @param[out] hash A hash of @p times.
+ * @param[out] minStep The smallest interval between consecutive 
+ *	elements of @p times, or 0 if there are fewer than two.
+ *
+ * @perform O(N) time, where N = @p times.size()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void describeTimes(const vector<double>& times, uint64_t& hash, double& minStep) {
+	hash = utils::fnvBasis();
+	if (!times.empty()) {
+		hash = utils::fnvHash(hash, &times[0], times.size()*sizeof(double));
+	}
+	
+	// Same conventions as readTimeStamps()
+	minStep = 0.0;
+	for(size_t i = 1; i < times.size(); i++) {
+		const double step = times[i] - times[i-1];
+		if (i == 1 || step < minStep) {
+			minStep = step;
+		}
+	}
+}
+
+/** Creates a cadence with no times
+ *
+ * @post size() = 0
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+Cadence::Cadence() : times(noTimes()), hash(utils::fnvBasis()), 
+		baseline(0.0), minStep(0.0) {
+}
+
+/** Creates a cadence from a list of times
+ *
+ * @param[in] times The times at which a light curve is sampled, in 
+ *	any order.
+ *
+ * @post timeView() contains the same elements as @p times, in 
+ *	ascending order.
+ *
+ * @perform O(N) time if @p times is already sorted, O(N log N) 
+ *	otherwise, where N = @p times.size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+Cadence::Cadence(const vector<double>& times) : times(), hash(), 
+		baseline(0.0), minStep(0.0) {
+	shared_ptr<vector<double> > temp(new vector<double>(times));
+	// Simulated cadences are already sorted, so check before paying 
+	//	for a sort
+	if (std::adjacent_find(temp->begin(), temp->end(), 
+			std::greater<double>()) != temp->end()) {
+		std::sort(temp->begin(), temp->end());
+	}
+	
+	uint64_t tempHash;
+	double tempStep;
+	describeTimes(*temp, tempHash, tempStep);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	this->times    = temp;
+	this->hash     = tempHash;
+	this->baseline = (temp->empty() ? 0.0 : temp->back() - temp->front());
+	this->minStep  = tempStep;
+}
+
+/** Creates a cadence from a list of times known to be in ascending 
+ *	order
+ *
+ * Loaders and functions that derive one cadence from another already 
+ * produce sorted times, so they can skip the check made by 
+ * Cadence(const std::vector<double>&). The order is only verified in 
+ * debug builds.
+ *
+ * @param[in] times The times at which a light curve is sampled.
+ *
+ * @pre @p times is sorted in ascending order
+ *
+ * @post timeView() contains the same elements as @p times, in the 
+ *	same order.
+ *
+ * @perform O(N) time, where N = @p times.size(), without comparing 
+ *	the times to each other.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+Cadence::Cadence(const vector<double>& times, SortedTimes) : times(), 
+		hash(), baseline(0.0), minStep(0.0) {
+	assert(std::adjacent_find(times.begin(), times.end(), 
+		std::greater<double>()) == times.end());
+	
+	shared_ptr<vector<double> > temp(new vector<double>(times));
+	
+	uint64_t tempHash;
+	double tempStep;
+	describeTimes(*temp, tempHash, tempStep);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	this->times    = temp;
+	this->hash     = tempHash;
+	this->baseline = (temp->empty() ? 0.0 : temp->back() - temp->front());
+	this->minStep  = tempStep;
+}
+
+/** Returns the times, in ascending order
+ *
+ * @return A reference to the times, valid for the lifetime of any 
+ *	copy of the object.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const vector<double>& Cadence::timeView() const {
+	return *times;
+}
+
+/** Returns the number of times
+ *
+ * @return The number of elements in timeView().
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t Cadence::size() const {
+	return times->size();
+}
+
+/** Tests whether the cadence has no times
+ *
+ * @return True if size() = 0, false otherwise.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool Cadence::empty() const {
+	return times->empty();
+}
+
+/** Returns a hash of the times
+ *
+ * @return An FNV-1a hash of timeView(). Equal cadences always have 
+ *	equal hashes.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint64_t Cadence::getHash() const {
+	return hash;
+}
+
+/** Returns the time between the first and last observations
+ *
+ * @return The difference between the last and first elements of 
+ *	timeView(), or 0 if there are fewer than two times.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double Cadence::getBaseline() const {
+	return baseline;
+}
+
+/** Returns the smallest interval between consecutive observations
+ *
+ * @return The smallest difference between adjacent elements of 
+ *	timeView(), or 0 if there are fewer than two times.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double Cadence::getMinStep() const {
+	return minStep;
+}
+
+/** Tests whether two cadences share the same times
+ *
+ * @param[in] other The cadence to compare to.
+ *
+ * @return True if @p other is a copy of this object, or of a cadence 
+ *	this object was copied from. Cadences created separately from equal 
+ *	times are equal, but do not share their times.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool Cadence::sameAs(const Cadence& other) const {
+	return times == other.times;
+}
+
+/** Tests whether two cadences have the same times
+ *
+ * @param[in] other The cadence to compare to.
+ *
+ * @return True if timeView() = @p other.timeView(), false otherwise.
+ *
+ * @perform Constant time if the cadences share their times or have 
+ *	different hashes, O(N) time otherwise, where N = size().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool Cadence::operator==(const Cadence& other) const {
+	return sameAs(other) 
+		|| (hash == other.hash && *times == *(other.times));
+}
+
+/** Tests whether two cadences have different times
+ *
+ * @param[in] other The cadence to compare to.
+ *
+ * @return The negation of <tt>*this == other</tt>.
+ *
+ * @perform Same as operator==()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool Cadence::operator!=(const Cadence& other) const {
+	return !(*this == other);
+}
+
+/** Non-throwing swap
+ *
+ * @param[in,out] other The cadence with which to exchange contents.
+ *
+ * @post The times previously in @p other are now in @p *this, and 
+ *	vice versa.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void Cadence::swap(Cadence& other) {
+	using std::swap;
+	
+	swap(this->times   , other.times   );
+	swap(this->hash    , other.hash    );
+	swap(this->baseline, other.baseline);
+	swap(this->minStep , other.minStep );
+}
+
+/** Non-throwing swap
+ *
+ * @param[in,out] a,b The cadences to exchange contents.
+ *
+ * @post The times previously in @p a are now in @p b, and vice versa.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void swap(Cadence& a, Cadence& b) {
+	a.swap(b);
+}
+
+/** Selects the times of a cadence that fall within some baseline of 
+ *	its first time
+ *
+ * A survey that has run for @p baseline days would have observed 
+ * @p prefix, so the analysis of a light curve on increasing baselines 
+ * shows how the statistics depend on the length of the survey.
+ *
+ * @param[in] full The cadence to truncate.
+ * @param[in] baseline The longest time, after the first time of 
+ *	@p full, to keep.
+ * @param[out] prefix The times of @p full no more than @p baseline 
+ *	after its first time. Empty if @p full is empty.
+ *
+ * @perform O(log N) time to find the prefix, plus O(N) time to copy 
+ *	it, where N = @p prefix.size().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store @p prefix.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of 
+ *	an exception.
+ */
+void truncateCadence(const Cadence& full, double baseline, Cadence& prefix) {
+	const vector<double>& times = full.timeView();
+	vector<double>::const_iterator end = times.begin();
+	if (!times.empty()) {
+		end = std::upper_bound(times.begin(), times.end(), 
+			times.front() + baseline);
+	}
+	// A prefix of sorted times is sorted
+	Cadence newPrefix(vector<double>(times.begin(), end), SortedTimes());
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(prefix, newPrefix);
+}
+
+/** Combines several cadences into one containing every time in any 
+ *	of them
+ *
+ * A light curve sampled once on @p whole can then be analyzed on each 
+ * part by selecting the values at @p positions, without simulating it 
+ * again for each part.
+ *
+ * @param[in] parts The cadences to combine.
+ * @param[out] whole The times in any element of @p parts, in ascending 
+ *	order. A time in several parts appears once.
+ * @param[out] positions For each element of @p parts, the index in 
+ *	@p whole of each of its times.
+ *
+ * @post <tt>whole.timeView()[positions[i][j]] == parts[i].timeView()[j]</tt> 
+ *	for all i and j.
+ *
+ * @perform O(N log N) time, where N is the total number of times in 
+ *	@p parts.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	combine the cadences.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of 
+ *	an exception.
+ */
+void mergeCadences(const vector<Cadence>& parts, Cadence& whole, 
+		vector<vector<size_t> >& positions) {
+	vector<double> times;
+	for(vector<Cadence>::const_iterator it = parts.begin(); 
+			it != parts.end(); it++) {
+		times.insert(times.end(), it->timeView().begin(), it->timeView().end());
+	}
+	std::sort(times.begin(), times.end());
+	times.erase(std::unique(times.begin(), times.end()), times.end());
+	
+	vector<vector<size_t> > newPositions(parts.size());
+	for(size_t i = 0; i < parts.size(); i++) {
+		const vector<double>& part = parts[i].timeView();
+		newPositions[i].reserve(part.size());
+		for(vector<double>::const_iterator it = part.begin(); 
+				it != part.end(); it++) {
+			newPositions[i].push_back(static_cast<size_t>(
+				std::lower_bound(times.begin(), times.end(), *it) 
+				- times.begin()));
+		}
+	}
+	Cadence newWhole(times, SortedTimes());
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(whole, newWhole);
+	positions.swap(newPositions);
+}
+
+}}		// end lcmc::models
@@ -0,0 +1,134 @@
+/** Type definitions for observing cadences
+ * @file lightcurveMC/cadence.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCCADENCEH
+#define LCMCCADENCEH
+
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace lcmc { namespace models {
+
+/** Tag marking a list of times that is already in ascending order
+ */
+struct SortedTimes {
+};
+
+/** Cadence represents the times at which a light curve is sampled.
+ *
+ * The times are stored once and shared by every copy of the object, 
+ * so a cadence can be passed to every trial, light curve, and 
+ * statistic that uses it without copying the times. Properties that 
+ * many clients need are computed once, when the cadence is created.
+ *
+ * @invariant Cadence is immutable.
+ * @invariant The times are in ascending order.
+ */
+class Cadence {
+public:
+	/** Creates a cadence with no times
+	 */
+	Cadence();
+	
+	/** Creates a cadence from a list of times
+	 */
+	// Not explicit, so that any vector of times may be passed to a light curve
+	Cadence(const std::vector<double>& times);
+	
+	/** Creates a cadence from a list of times known to be in 
+	 *	ascending order
+	 */
+	Cadence(const std::vector<double>& times, SortedTimes);
+	
+	/** Returns the times, in ascending order
+	 */
+	const std::vector<double>& timeView() const;
+	
+	/** Returns the number of times
+	 */
+	size_t size() const;
+	
+	/** Tests whether the cadence has no times
+	 */
+	bool empty() const;
+	
+	/** Returns a hash of the times
+	 */
+	boost::uint64_t getHash() const;
+	
+	/** Returns the time between the first and last observations
+	 */
+	double getBaseline() const;
+	
+	/** Returns the smallest interval between consecutive observations
+	 */
+	double getMinStep() const;
+	
+	/** Tests whether two cadences share the same times
+	 */
+	bool sameAs(const Cadence& other) const;
+	
+	/** Tests whether two cadences have the same times
+	 */
+	bool operator==(const Cadence& other) const;
+	
+	/** Tests whether two cadences have different times
+	 */
+	bool operator!=(const Cadence& other) const;
+	
+	/** Non-throwing swap
+	 */
+	void swap(Cadence& other);
+
+private:
+	boost::shared_ptr<const std::vector<double> > times;
+	boost::uint64_t hash;
+	double baseline;
+	double minStep;
+};
+
+/** Non-throwing swap
+ */
+void swap(Cadence& a, Cadence& b);
+
+/** Selects the times of a cadence that fall within some baseline of 
+ *	its first time
+ */
+void truncateCadence(const Cadence& full, double baseline, Cadence& prefix);
+
+/** Combines several cadences into one containing every time in any 
+ *	of them
+ */
+void mergeCadences(const std::vector<Cadence>& parts, Cadence& whole, 
+		std::vector<std::vector<size_t> >& positions);
+
+}}		// end lcmc::models
+
+#endif		// end LCMCCADENCEH
@@ -31,6 +31,7 @@
 #include <string>
 #include <cerrno>
 #include <cstring>
+#include <boost/lexical_cast.hpp>
 #include <gsl/gsl_errno.h>
 //#include "cerror.h"
 
@@ -48,3 +49,22 @@ void gslCheck(int status, std::string msg) {
 		throw std::runtime_error(msg + gsl_strerror(status));
 	}
 }
+
+/** Wrapper that throws @c std::runtime_error in response to a LAPACK error
+ *
+ * @param[in] info The @c info argument returned by a LAPACK routine.
+ * @param[in] msg A string prepended to the exception's error message.
+ *
+ * @exception std::runtime_error Thrown if @p info &ne; 0
+ * 
+ * @exceptsafe The function arguments are unchanged in the event of an exception.
+ */
+void lapackCheck(int info, std::string msg) {
+	if (info < 0) {
+		throw std::runtime_error(msg + "LAPACK argument " 
+			+ boost::lexical_cast<std::string>(-info) + " was invalid.");
+	} else if (info > 0) {
+		throw std::runtime_error(msg + "LAPACK routine failed with code " 
+			+ boost::lexical_cast<std::string>(info) + ".");
+	}
+}
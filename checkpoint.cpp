@@ -0,0 +1,545 @@
+/** Checkpoints and partial results for interrupted and sharded runs
+ * @file lightcurveMC/checkpoint.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/shared_ptr.hpp>
+#include "binstats.h"
+#include "checkpoint.h"
+#include "../common/cerror.h"
+#include "../common/fileio.h"
+
+namespace lcmc {
+
+using std::string;
+using boost::shared_ptr;
+
+/** The first line of every checkpoint file, identifying its format */
+const char* const CHECKPOINT_MAGIC = "lcmc-checkpoint 8";
+
+/** The first line of every shard file, identifying its format */
+const char* const SHARD_MAGIC = "lcmc-shard 7";
+
+/** Describes a run that has not started
+ *
+ * @param[in] seed The seed of the per-trial random number streams.
+ * @param[in] nTrials The number of trials in each bin.
+ * @param[in] nBins The number of light curve types in the run.
+ * @param[in] streamOffset The stream key of the first trial in each bin.
+ * @param[in] flushEvery The number of light curves after which the 
+ *	distributions are written out, or 0 for none.
+ * @param[in] memoryLimit The megabytes of statistics after which the 
+ *	distributions are written out, or 0 for no limit.
+ *
+ * @post No bins are finished, and the first bin starts at trial 0.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+RunProgress::RunProgress(long seed, long nTrials, long nBins, long streamOffset, 
+		long flushEvery, double memoryLimit) 
+		: seed(seed), streamOffset(streamOffset), nTrials(nTrials), 
+		nBins(nBins), flushEvery(flushEvery), memoryLimit(memoryLimit), 
+		rows(), trial(0) {
+}
+
+/** Reads one line of a text file
+ *
+ * @param[in] file The file to read.
+ * @param[out] line The text of the line, without its newline.
+ *
+ * @return True if a line was read, false if @p file was already at 
+ *	its end.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the line.
+ *
+ * @exceptsafe @p line is in a valid state in the event of an exception.
+ */
+bool readLine(FILE* const file, string& line) {
+	line.clear();
+	
+	int c;
+	while ((c = getc(file)) != EOF && c != '\n') {
+		line += static_cast<char>(c);
+	}
+	return c != EOF || !line.empty();
+}
+
+/** Reads the line identifying the run that wrote a checkpoint or shard
+ *
+ * @param[in] file The file to read, positioned at the line.
+ * @param[out] seed, nTrials, nBins, streamOffset The properties of 
+ *	the run.
+ *
+ * @return True if the line was read, false if it is misformatted.
+ *
+ * @post Files written before --stream-offset existed are read as 
+ *	having an offset of 0.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the line.
+ *
+ * @exceptsafe The arguments are in a valid state in the event of an 
+ *	exception.
+ */
+bool readRunLine(FILE* const file, long& seed, long& nTrials, long& nBins, 
+		long& streamOffset) {
+	string line;
+	if (!readLine(file, line)) {
+		return false;
+	}
+	streamOffset = 0;
+	const int nRead = sscanf(line.c_str(), "run %ld %ld %ld %ld", 
+		&seed, &nTrials, &nBins, &streamOffset);
+	return nRead == 3 || nRead == 4;
+}
+
+/** Reads the part of a checkpoint that describes the finished bins
+ *
+ * @param[in] file A checkpoint file, positioned at its start.
+ * @param[in] fileName The name of @p file, for error messages.
+ * @param[out] progress The progress of the run.
+ *
+ * @post @p file is positioned at the saved state of the bin in 
+ *	progress, if any.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p file is not a 
+ *	checkpoint, or was written by a run with a different seed, stream 
+ *	offset, number of trials, number of light curve types, 
+ *	--flush-every, or --memory-limit than @p progress.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the checkpoint.
+ *
+ * @exceptsafe @p progress is unchanged in the event of an exception.
+ */
+void readProgress(FILE* const file, const string& fileName, 
+		RunProgress& progress) {
+	const string misformatted = "Misformatted checkpoint file " + fileName + ".";
+	
+	string line;
+	if (!readLine(file, line) || line != CHECKPOINT_MAGIC) {
+		throw kpfutils::except::FileIo(fileName + " is not a checkpoint file.");
+	}
+	
+	long seed, nTrials, nBins, streamOffset;
+	if (!readRunLine(file, seed, nTrials, nBins, streamOffset)) {
+		throw kpfutils::except::FileIo(misformatted);
+	}
+	if (seed != progress.seed || streamOffset != progress.streamOffset 
+			|| nTrials != progress.nTrials || nBins != progress.nBins) {
+		throw kpfutils::except::FileIo("Checkpoint file " + fileName 
+			+ " was written by a run with a different --seed, "
+			"--stream-offset, --ntrials, or list of light curve types.");
+	}
+	
+	// The saved parts end where the interrupted run flushed, so the 
+	//	resumed run must flush in the same places
+	long flushEvery;
+	double memoryLimit;
+	if (!readLine(file, line) || sscanf(line.c_str(), "flush %ld %lg", 
+			&flushEvery, &memoryLimit) != 2) {
+		throw kpfutils::except::FileIo(misformatted);
+	}
+	if (flushEvery != progress.flushEvery || memoryLimit != progress.memoryLimit) {
+		throw kpfutils::except::FileIo("Checkpoint file " + fileName 
+			+ " was written by a run with a different --flush-every "
+			"or --memory-limit.");
+	}
+	
+	long nDone;
+	if (!readLine(file, line) || sscanf(line.c_str(), "done %ld", &nDone) != 1 
+			|| nDone < 0 || nDone > nBins) {
+		throw kpfutils::except::FileIo(misformatted);
+	}
+	std::vector<string> rows;
+	for(long i = 0; i < nDone; i++) {
+		if (!readLine(file, line)) {
+			throw kpfutils::except::FileIo(misformatted);
+		}
+		rows.push_back(line);
+	}
+	
+	long trial;
+	if (!readLine(file, line) || sscanf(line.c_str(), "trial %ld", &trial) != 1 
+			|| trial < 0 || trial > nTrials) {
+		throw kpfutils::except::FileIo(misformatted);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	progress.rows.swap(rows);
+	progress.trial = trial;
+}
+
+/** Saves the progress of a run
+ *
+ * The checkpoint is first written to a temporary file, then moved 
+ * into place, so that an interrupted run never leaves a partial 
+ * checkpoint behind.
+ *
+ * @param[in] fileName The checkpoint file to write.
+ * @param[in] progress The progress of the run.
+ * @param[in] curBin The bin in progress.
+ *
+ * @pre If @p progress.trial &gt; 0, @p curBin has been spilled since 
+ *	its last light curve was analyzed.
+ *
+ * @post @p fileName contains @p progress, and the state of @p curBin 
+ *	if @p progress.trial &gt; 0.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the checkpoint could 
+ *	not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	write the checkpoint.
+ *
+ * @exceptsafe Any previous checkpoint in @p fileName is unchanged in 
+ *	the event of an exception.
+ */
+void writeCheckpoint(const string& fileName, const RunProgress& progress, 
+		const stats::LcBinStats& curBin) {
+	const string tempName = fileName + ".tmp";
+	{
+		shared_ptr<FILE> file = kpfutils::fileCheckOpen(tempName, "w");
+		
+		// %.17g preserves every bit of a double
+		if (fprintf(file.get(), "%s\nrun %ld %ld %ld %ld\nflush %ld %.17g\ndone %lu\n", 
+				CHECKPOINT_MAGIC, progress.seed, progress.nTrials, 
+				progress.nBins, progress.streamOffset, 
+				progress.flushEvery, progress.memoryLimit, 
+				static_cast<unsigned long>(progress.rows.size())) < 0) {
+			kpfutils::fileError(file.get(), "Could not write checkpoint " + tempName + ": ");
+		}
+		for(std::vector<string>::const_iterator it = progress.rows.begin(); 
+				it != progress.rows.end(); it++) {
+			if (fprintf(file.get(), "%s\n", it->c_str()) < 0) {
+				kpfutils::fileError(file.get(), "Could not write checkpoint " + tempName + ": ");
+			}
+		}
+		if (fprintf(file.get(), "trial %ld\n", progress.trial) < 0) {
+			kpfutils::fileError(file.get(), "Could not write checkpoint " + tempName + ": ");
+		}
+		if (progress.trial > 0) {
+			curBin.writeState(file.get());
+		}
+		
+		if (fflush(file.get()) != 0) {
+			kpfutils::fileError(file.get(), "Could not write checkpoint " + tempName + ": ");
+		}
+	}
+	
+	if (rename(tempName.c_str(), fileName.c_str()) != 0) {
+		throw kpfutils::except::FileIo("Could not replace checkpoint " + fileName + ".");
+	}
+}
+
+/** Reads the progress of a run saved by writeCheckpoint()
+ *
+ * @param[in] fileName The checkpoint file to read.
+ * @param[in,out] progress The run being resumed. The seed, number of 
+ *	trials, and number of bins must be set before the call.
+ *
+ * @return True if @p fileName exists, false if it does not, in which 
+ *	case the run should start from the beginning.
+ *
+ * @post If the return value is true, @p progress.rows and 
+ *	@p progress.trial match the checkpoint. Otherwise, @p progress 
+ *	is unchanged.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName is not a 
+ *	checkpoint, or was written by a different run.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the checkpoint.
+ *
+ * @exceptsafe @p progress is unchanged in the event of an exception.
+ */
+bool readCheckpoint(const string& fileName, RunProgress& progress) {
+	FILE* const rawFile = fopen(fileName.c_str(), "r");
+	if (rawFile == NULL) {
+		return false;
+	}
+	shared_ptr<FILE> file(rawFile, &fclose);
+	
+	readProgress(file.get(), fileName, progress);
+	return true;
+}
+
+/** Restores the bin in progress saved by writeCheckpoint()
+ *
+ * @param[in] fileName The checkpoint file to read.
+ * @param[in] progress The run being resumed, as returned by 
+ *	readCheckpoint().
+ * @param[in,out] curBin The bin to restore. Must have been constructed 
+ *	with the same arguments as the bin that was saved.
+ *
+ * @pre readCheckpoint(@p fileName, @p progress) returned true, with 
+ *	@p progress.trial &gt; 0.
+ *
+ * @post @p curBin has the state it had when the checkpoint was written.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could 
+ *	not be read, or does not contain the state of a bin.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the checkpoint.
+ *
+ * @exceptsafe @p curBin is in a valid state in the event of an exception.
+ */
+void readCheckpointBin(const string& fileName, const RunProgress& progress, 
+		stats::LcBinStats& curBin) {
+	shared_ptr<FILE> file = kpfutils::fileCheckOpen(fileName, "r");
+	
+	// Skip to the state of the bin
+	RunProgress saved = progress;
+	readProgress(file.get(), fileName, saved);
+	
+	curBin.readState(file.get());
+}
+
+/** Prints a row representing a finished bin, and returns a copy
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ * @param[in] bin The bin to print.
+ *
+ * @return The row printed by @ref stats::LcBinStats::printBinStats() 
+ *	"bin.printBinStats()", without its newline.
+ *
+ * @post The row has been printed to @p file, and any distribution 
+ *	files have been written, exactly once.
+ *
+ * @exception std::runtime_error Thrown if the row could not be printed.
+ * @exception kpfutils::except::FileIo Thrown if there are difficulties 
+ *	writing the distribution files.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	copy the row.
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+string printBinRow(FILE* const file, const stats::LcBinStats& bin) {
+	FILE* const rawTemp = tmpfile();
+	if (rawTemp == NULL) {
+		kpfutils::cError("Could not buffer output in printBinRow(): ");
+	}
+	shared_ptr<FILE> temp(rawTemp, &fclose);
+	
+	bin.printBinStats(temp.get());
+	rewind(temp.get());
+	string row;
+	readLine(temp.get(), row);
+	
+	if (fprintf(file, "%s\n", row.c_str()) < 0) {
+		kpfutils::cError("Could not print output in printBinRow(): ");
+	}
+	return row;
+}
+
+/** Returns the trials run by one shard of a run
+ *
+ * Each shard runs a contiguous block of trials, so that merging the 
+ * shards in order reproduces the order of a single-process run, in the 
+ * same way that analyzeTrials() divides a batch among threads.
+ *
+ * @param[in] nTrials The number of trials in each bin of the run.
+ * @param[in] shard The shard to run, counting from 0.
+ * @param[in] nShards The number of shards in the run.
+ * @param[out] first, last The trials run by the shard are 
+ *	[@p first, @p last).
+ *
+ * @pre 0 &le; @p shard &lt; @p nShards
+ *
+ * @post The blocks of all shards cover [0, @p nTrials) without 
+ *	overlapping, in order, and differ in length by at most one trial.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void shardTrials(long nTrials, long shard, long nShards, 
+		long& first, long& last) {
+	// Written to avoid overflow for large nTrials
+	const long size = nTrials / nShards;
+	const long extra = nTrials % nShards;
+	first = shard * size + std::min(shard, extra);
+	last  = first + size + (shard < extra ? 1 : 0);
+}
+
+/** Returns the name of the file holding the results of one shard
+ *
+ * @param[in] shard The shard, counting from 0.
+ * @param[in] nShards The number of shards in the run.
+ *
+ * @return A file name in the working directory, unique to @p shard.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string shardFileName(long shard, long nShards) {
+	char name[64];
+	sprintf(name, "shard_%ld_of_%ld.txt", shard, nShards);
+	return name;
+}
+
+/** Starts the file holding the results of one shard
+ *
+ * @param[in] run The run the shard belongs to. Only its seed, stream 
+ *	offset, number of trials, and number of bins are used.
+ * @param[in] shard The shard, counting from 0.
+ * @param[in] nShards The number of shards in the run.
+ *
+ * @return A handle to shardFileName(@p shard, @p nShards), to be 
+ *	passed to writeShardBin() after each bin.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the file could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	open the file.
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+shared_ptr<FILE> createShard(const RunProgress& run, long shard, long nShards) {
+	const string fileName = shardFileName(shard, nShards);
+	shared_ptr<FILE> file = kpfutils::fileCheckOpen(fileName, "w");
+	
+	if (fprintf(file.get(), "%s\nshard %ld %ld\nrun %ld %ld %ld %ld\n", 
+			SHARD_MAGIC, shard, nShards, 
+			run.seed, run.nTrials, run.nBins, run.streamOffset) < 0) {
+		kpfutils::fileError(file.get(), "Could not write shard " + fileName + ": ");
+	}
+	return file;
+}
+
+/** Opens the file holding the results of one shard, for merging
+ *
+ * @param[in] run The run being merged. Only its seed, stream offset, 
+ *	number of trials, and number of bins are used.
+ * @param[in] shard The shard, counting from 0.
+ * @param[in] nShards The number of shards in the run.
+ *
+ * @return A handle to shardFileName(@p shard, @p nShards), positioned 
+ *	at the first bin.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the file could not be 
+ *	read, is not a shard file, or was written by a run with a different 
+ *	seed, stream offset, number of trials, number of light curve types, 
+ *	or number of shards.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	open the file.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+shared_ptr<FILE> openShard(const RunProgress& run, long shard, long nShards) {
+	const string fileName = shardFileName(shard, nShards);
+	shared_ptr<FILE> file = kpfutils::fileCheckOpen(fileName, "r");
+	
+	string line;
+	if (!readLine(file.get(), line) || line != SHARD_MAGIC) {
+		throw kpfutils::except::FileIo(fileName + " is not a shard file.");
+	}
+	long savedShard, savedShards, seed, nTrials, nBins, streamOffset;
+	if (!readLine(file.get(), line) || sscanf(line.c_str(), "shard %ld %ld", 
+			&savedShard, &savedShards) != 2 
+			|| !readRunLine(file.get(), seed, nTrials, nBins, streamOffset)) {
+		throw kpfutils::except::FileIo("Misformatted shard file " + fileName + ".");
+	}
+	if (savedShard != shard || savedShards != nShards || seed != run.seed 
+			|| streamOffset != run.streamOffset 
+			|| nTrials != run.nTrials || nBins != run.nBins) {
+		throw kpfutils::except::FileIo("Shard file " + fileName 
+			+ " was written by a run with a different --seed, "
+			"--stream-offset, --ntrials, --shard, or list of light curve types.");
+	}
+	return file;
+}
+
+/** Adds the statistics of a finished bin to the results of a shard
+ *
+ * @param[in] file A handle returned by createShard().
+ * @param[in] bin The bin to save.
+ *
+ * @pre @p bin has been spilled since its last light curve was analyzed.
+ *
+ * @post The state of @p bin is appended to @p file, and @p file is 
+ *	flushed so that the bin is saved even if the shard is interrupted 
+ *	later.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the bin could not 
+ *	be written.
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void writeShardBin(FILE* const file, const stats::LcBinStats& bin) {
+	if (fprintf(file, "bin\n") < 0) {
+		kpfutils::fileError(file, "Could not write shard: ");
+	}
+	bin.writeState(file);
+	if (fflush(file) != 0) {
+		kpfutils::fileError(file, "Could not write shard: ");
+	}
+}
+
+/** Reads the statistics of the next bin from the results of a shard
+ *
+ * @param[in] file A handle returned by openShard(), or positioned 
+ *	after the previous bin read by readShardBin().
+ * @param[in] fileName The name of @p file, for error messages.
+ * @param[in,out] bin The bin to restore. Must have been constructed 
+ *	with the same arguments as the bin that was saved.
+ *
+ * @post @p bin has the state it had when it was saved by writeShardBin().
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p file has no more 
+ *	bins, or the next bin is misformatted.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the bin.
+ *
+ * @exceptsafe @p bin is in a valid state in the event of an exception.
+ */
+void readShardBin(FILE* const file, const string& fileName, 
+		stats::LcBinStats& bin) {
+	// The previous bin ends partway through its last line
+	string line;
+	bool found;
+	while ((found = readLine(file, line)) && line.empty()) {
+	}
+	if (!found) {
+		throw kpfutils::except::FileIo("Shard file " + fileName 
+			+ " is incomplete; was the shard interrupted?");
+	}
+	if (line != "bin") {
+		throw kpfutils::except::FileIo("Misformatted shard file " + fileName + ".");
+	}
+	
+	bin.readState(file);
+}
+
+}		// end lcmc
@@ -0,0 +1,125 @@
+/** Checkpoints and partial results for interrupted and sharded runs
+ * @file lightcurveMC/checkpoint.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCCHECKPOINTH
+#define LCMCCHECKPOINTH
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/shared_ptr.hpp>
+#include "binstats.h"
+
+namespace lcmc {
+
+/** RunProgress records how far a run has gone, in enough detail to 
+ *	continue it from a checkpoint.
+ *
+ * The run is identified by its seed, its stream offset, its number of 
+ * trials, and its number of light curve types, so that a checkpoint is 
+ * not accidentally resumed by a different run. The settings that 
+ * decide when the distributions are written out are recorded too, 
+ * since they decide how the saved parts are numbered.
+ */
+struct RunProgress {
+	/** Describes a run that has not started
+	 */
+	RunProgress(long seed, long nTrials, long nBins, long streamOffset, 
+		long flushEvery, double memoryLimit);
+	
+	/** The seed of the per-trial random number streams */
+	long seed;
+	/** The stream key of the first trial in each bin */
+	long streamOffset;
+	/** The number of trials in each bin */
+	long nTrials;
+	/** The number of light curve types in the run */
+	long nBins;
+	/** The value of --flush-every */
+	long flushEvery;
+	/** The value of --memory-limit */
+	double memoryLimit;
+	/** The rows printed for each finished bin, without newlines. The 
+	 *	bin in progress is therefore number <tt>rows.size()</tt> */
+	std::vector<std::string> rows;
+	/** The first trial in the bin in progress whose statistics have 
+	 *	not been saved */
+	long trial;
+};
+
+/** Saves the progress of a run
+ */
+void writeCheckpoint(const std::string& fileName, const RunProgress& progress, 
+	const stats::LcBinStats& curBin);
+
+/** Reads the progress of a run saved by writeCheckpoint()
+ */
+bool readCheckpoint(const std::string& fileName, RunProgress& progress);
+
+/** Restores the bin in progress saved by writeCheckpoint()
+ */
+void readCheckpointBin(const std::string& fileName, const RunProgress& progress, 
+	stats::LcBinStats& curBin);
+
+/** Prints a row representing a finished bin, and returns a copy
+ */
+std::string printBinRow(FILE* const file, const stats::LcBinStats& bin);
+
+/** Returns the trials run by one shard of a run
+ */
+void shardTrials(long nTrials, long shard, long nShards, 
+	long& first, long& last);
+
+/** Returns the name of the file holding the results of one shard
+ */
+std::string shardFileName(long shard, long nShards);
+
+/** Starts the file holding the results of one shard
+ */
+boost::shared_ptr<FILE> createShard(const RunProgress& run, 
+	long shard, long nShards);
+
+/** Opens the file holding the results of one shard, for merging
+ */
+boost::shared_ptr<FILE> openShard(const RunProgress& run, 
+	long shard, long nShards);
+
+/** Adds the statistics of a finished bin to the results of a shard
+ */
+void writeShardBin(FILE* const file, const stats::LcBinStats& bin);
+
+/** Reads the statistics of the next bin from the results of a shard
+ */
+void readShardBin(FILE* const file, const std::string& fileName, 
+	stats::LcBinStats& bin);
+
+}		// end lcmc
+
+#endif		// end LCMCCHECKPOINTH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/cmd/cmd.cpp
  * @author Krzysztof Findeisen
  * @date Created April 12, 2013
- * @date Last modified August 19, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -59,8 +59,142 @@ using models::RangeList;
  * @param[out] toPrint if > 0, the program will print the first few 
  *	light curves generated. This setting is intended primarily for 
  *	debugging.
+ * @param[out] nThreads the number of threads to use when analyzing 
+ *	light curves
+ * @param[out] seed the seed for per-trial random number streams, or -1 
+ *	if all light curves should share a single sequence of random numbers
+ * @param[out] storeDistribs if true, the program will record the 
+ *	distribution of each scalar statistic as well as its summary
+ * @param[out] storeCurves if true, the program will record every 
+ *	function statistic rather than only its per-point summary
+ * @param[out] sketchSize the number of values each level of a quantile 
+ *	sketch holds before it is compacted
+ * @param[out] printQuantiles if true, the program will print the 
+ *	median and percentiles of each scalar statistic
+ * @param[out] floatCurves if true, the program will store the values 
+ *	of function statistics in single precision
+ * @param[out] distribFormat the file format in which to record the 
+ *	distributions of statistics
+ * @param[out] compressDistribs if true, distributions written as text 
+ *	will be compressed
+ * @param[out] archiveFile the zip file in which to collect the 
+ *	distributions of statistics, or an empty string to write each 
+ *	to its own file
+ * @param[out] archiveCompress if true, the distributions in 
+ *	@p archiveFile will be compressed
+ * @param[out] pgramMethod the algorithm to use for calculating 
+ *	periodograms
+ * @param[out] floatPgram if true, periodogram tables will be stored 
+ *	in single precision
+ * @param[out] sacfMethod the algorithm to use for calculating 
+ *	Scargle ACFs
+ * @param[out] peakMethod the search to use for peak-finding timescales
+ * @param[out] cacheDir the directory in which to save periodogram 
+ *	thresholds and covariance factorizations between runs, or an 
+ *	empty string to not save them
+ * @param[out] cacheLimit the most megabytes that the files in 
+ *	cacheDir may take up
+ * @param[out] gpFactor the algorithm to use for factoring Gaussian 
+ *	process covariance matrices
+ * @param[out] tauGrid the number of grid points per decade to which 
+ *	Gaussian process coherence times are rounded, or 0 for no rounding
+ * @param[out] gpOrder the order of the state-space approximation to 
+ *	Gaussian process kernels, or 0 to use the exact kernels
+ * @param[out] gpRank the number of inducing points of the low-rank 
+ *	approximation to Gaussian process kernels, or 0 to use the exact 
+ *	kernels
+ * @param[out] gpSeasons the largest covariance between observing 
+ *	seasons, as a fraction of the variance, below which seasons are 
+ *	generated independently, or 0 to use the exact kernels
+ * @param[out] gpSparse the largest covariance, as a fraction of the 
+ *	variance, that may be treated as zero in a sparse covariance 
+ *	matrix, or 0 to use the exact kernels
+ * @param[out] gpFit the backend to use for fitting Gaussian process 
+ *	models to light curves
+ * @param[out] gpPlugin the statistics plugin to use for fitting 
+ *	Gaussian process models if @p gpFit is GPFIT_PLUGIN
+ * @param[out] rWorkers the number of separate R processes to use for 
+ *	fitting Gaussian process models, or 0 to use the embedded R 
+ *	interpreter
+ * @param[out] gpStart the policy for choosing where Gaussian process 
+ *	fits start
+ * @param[out] statBudget the most time, in seconds, that an expensive 
+ *	statistic may spend on one light curve, or 0 for no limit
+ * @param[out] statThreads the number of threads to use for calculating 
+ *	the statistics of each light curve
+ * @param[out] profile if true, the time spent on each stage of the 
+ *	simulation is reported
+ * @param[out] profileCounters if true, the hardware events counted in 
+ *	each stage are also reported
+ * @param[out] cacheReport if true, the use of each internal cache is 
+ *	reported at the end of the run
+ * @param[out] progressInterval the least time, in seconds, between 
+ *	progress reports, or 0 for no reports
+ * @param[out] traceFile the file in which to record trace events, or 
+ *	an empty string for no tracing
+ * @param[out] traceEvents the most trace events to keep
+ * @param[out] memoryReport if true, the memory used by each bin is 
+ *	reported
+ * @param[out] memoryLimit the most memory, in megabytes, that the 
+ *	statistics of a bin may hold before being written out, or 0 for 
+ *	no limit
+ * @param[out] flushEvery the number of light curves after which the 
+ *	statistics of a bin should be written out, or 0 for only at the 
+ *	end of the bin
+ * @param[out] checkpointFile the file in which to save the progress of 
+ *	the run, or an empty string for no checkpoints
+ * @param[out] resume if true, the run should continue from 
+ *	@p checkpointFile
+ * @param[out] shard, nShards the part of the run to carry out is 
+ *	shard @p shard of @p nShards, counting from 0, or 0 of 0 for 
+ *	the whole run
+ * @param[out] merge the number of shards whose results should be 
+ *	merged, or 0 to simulate
+ * @param[out] pipelineDepth the most simulated batches that may wait 
+ *	for analysis, or 0 to simulate and analyze in turn
+ * @param[out] numa if true, analysis threads are bound to NUMA nodes
+ * @param[out] hugePages if true, large buffers are placed on huge pages
+ * @param[out] gpuStats if true, batches of periodograms may be computed 
+ *	on a CUDA device
+ * @param[out] printPolicy, printStat how to choose the light curves 
+ *	to print, and the statistic by which to choose them (if any)
+ * @param[out] shapeTolerance the largest error allowed in tabulated 
+ *	outburst and fade waveforms, as a fraction of the amplitude, or 
+ *	0 to evaluate them exactly
+ * @param[out] noisePool if true, the noise of each trial is drawn once 
+ *	and reused by every bin
+ * @param[out] streamOffset the number added to each trial's index to 
+ *	key its random number streams
+ * @param[out] packBins the most bins to simulate and analyze together, 
+ *	or 0 to run one bin at a time
+ * @param[out] gpBin the width of the bins in which light curves are 
+ *	averaged before Gaussian process fitting, or 0 to fit every 
+ *	observation
+ * @param[out] costsFile the file of measured costs to use and update, 
+ *	or an empty string to ignore costs
+ * @param[out] tune if true, time the candidate batch sizes and 
+ *	statistic thread counts before the first bin
+ * @param[out] targetError the relative standard error at which a bin 
+ *	has enough light curves, or 0 to run @p nTrials in every bin
+ * @param[out] sampling the way trial parameters are drawn
+ * @param[out] commonRandom if true, every light curve type uses the 
+ *	same random numbers for each trial
+ * @param[out] saveTrialsFile the file in which to save the simulated 
+ *	light curves, or an empty string to not save them
+ * @param[out] replayFile the file from which to read light curves 
+ *	instead of simulating them, or an empty string to simulate
+ * @param[out] resultCache the directory in which to keep the results 
+ *	of finished bins, or an empty string to run every bin
+ * @param[out] cadenceFiles the files of Julian dates of other cadences 
+ *	on which to analyze each simulated light curve, in addition to 
+ *	@p jdList
+ * @param[out] baselines the lengths of the prefixes of @p jdList on 
+ *	which to analyze each simulated light curve, in addition to 
+ *	@p jdList
  * @param[out] paramRanges the minimum and maximum values of light curve 
  *	parameters allowed by the user
+ * @param[out] paramGrid the parameter ranges of each bin to simulate, 
+ *	in order; contains only @p paramRanges unless --grid was given
  * @param[out] jdList the name of a file containing the Julian dates of the 
  *	simulated observations
  * @param[out] lcNameList the list of light curve types to simulate, one 
@@ -72,6 +206,8 @@ using models::RangeList;
  *	which to inject simulated light curves
  * @param[out] injectMode if true, the program will carry out an injection 
  *	analysis rather than merely generating theoretical light curves.
+ * @param[out] magMode if true, light curves are simulated and analyzed 
+ *	in magnitudes, and @p sigma is in magnitudes.
  * 
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	represent the command line arguments.
@@ -86,12 +222,32 @@ using models::RangeList;
  *	argument is being referred to. Rewrite!
  */
 void parseArguments(int argc, char* argv[], 
-		double& sigma, long& nTrials, long& toPrint, 
+		double& sigma, long& nTrials, long& toPrint, long& nThreads, long& seed, 
+		bool& storeDistribs, bool& storeCurves, long& sketchSize, bool& printQuantiles, bool& floatCurves, 
+		stats::DistribFormat& distribFormat, 
+		bool& compressDistribs, string& archiveFile, bool& archiveCompress, 
+		stats::PeriodogramMethod& pgramMethod, bool& floatPgram, 
+		stats::ScargleAcfMethod& sacfMethod, stats::PeakMethod& peakMethod, 
+		string& cacheDir, double& cacheLimit, utils::CovarFactor& gpFactor, long& tauGrid, long& gpOrder, long& gpRank, 
+		double& gpSeasons, double& gpSparse, stats::GpFitMethod& gpFit, string& gpPlugin, long& rWorkers, stats::GpStart& gpStart, 
+		double& statBudget, long& statThreads, bool& profile, bool& profileCounters, 
+		bool& cacheReport, double& progressInterval, 
+		string& traceFile, long& traceEvents, bool& memoryReport, 
+		double& memoryLimit, long& flushEvery, string& checkpointFile, 
+		bool& resume, long& shard, long& nShards, long& merge, 
+		long& pipelineDepth, bool& numa, bool& hugePages, bool& gpuStats, 
+		DumpPolicy& printPolicy, string& printStat, 
+		double& shapeTolerance, bool& noisePool, long& streamOffset, 
+		long& packBins, double& gpBin, string& costsFile, bool& tune, 
+		double& targetError, ParamSampling& sampling, bool& commonRandom, 
+		string& saveTrialsFile, string& replayFile, string& resultCache, 
+		vector<string>& cadenceFiles, vector<double>& baselines, 
 		RangeList& paramRanges, 
+		vector<RangeList>& paramGrid, 
 		string& jdList, vector<string>& lcNameList, 
 		vector<LightCurveType>&  lcList, 
 		vector<      StatType>& statList, 
-		string& dataSet, bool& injectMode) {
+		string& dataSet, bool& injectMode, bool& magMode) {
 	using namespace TCLAP;
 	
   	// Start by defining the command line
@@ -114,15 +270,173 @@ void parseArguments(int argc, char* argv[],
 			throw CmdLineParseException("Mutually exclusive argument already set!", 
 				"(--noise)");
 		}
+		// constraint: --magnitudes only valid if jdList defined
+		if (getParam<SwitchArg>(cmd, "magnitudes").isSet() 
+				&& !getParam<UnlabeledValueArg<string> >(cmd, "jdlist")
+				.isSet()) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--magnitudes)");
+		}
+		// constraint: --resume only valid if --checkpoint defined
+		if (getParam<SwitchArg>(cmd, "resume").isSet() 
+				&& !getParam<ValueArg<string> >(cmd, "checkpoint").isSet()) {
+			throw CmdLineParseException("Requires --checkpoint!", 
+				"(--resume)");
+		}
+		// constraint: --checkpoint only valid if --seed defined, since 
+		//	otherwise the random numbers cannot be restored
+		if (getParam<ValueArg<string> >(cmd, "checkpoint").isSet() 
+				&& !getParam<ValueArg<long> >(cmd, "seed").isSet()) {
+			throw CmdLineParseException("Requires --seed!", 
+				"(--checkpoint)");
+		}
+		// constraint: --checkpoint not valid with --archive, since the 
+		//	archive is unreadable until it is closed
+		if (getParam<ValueArg<string> >(cmd, "checkpoint").isSet() 
+				&& getParam<ValueArg<string> >(cmd, "archive").isSet()) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--checkpoint)");
+		}
+		// constraint: --shard only valid if --seed defined, since 
+		//	otherwise the shards would share random numbers
+		if (getParam<ValueArg<string> >(cmd, "shard").isSet() 
+				&& !getParam<ValueArg<long> >(cmd, "seed").isSet()) {
+			throw CmdLineParseException("Requires --seed!", 
+				"(--shard)");
+		}
+		// constraint: --shard not valid with --checkpoint, --archive, 
+		//	or --merge
+		if (getParam<ValueArg<string> >(cmd, "shard").isSet() 
+				&& (getParam<ValueArg<string> >(cmd, "checkpoint").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "archive").isSet() 
+				|| getParam<ValueArg<long> >(cmd, "merge").isSet())) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--shard)");
+		}
+		// constraint: --sampling sobol only valid if --seed defined, 
+		//	since the Sobol points are indexed by trial
+		if (getParam<ValueArg<string> >(cmd, "sampling").getValue() == "sobol" 
+				&& !getParam<ValueArg<long> >(cmd, "seed").isSet()) {
+			throw CmdLineParseException("Requires --seed!", 
+				"(--sampling)");
+		}
+		// constraint: --common-random only valid if --seed defined, 
+		//	since only keyed streams can be replayed for each type
+		if (getParam<SwitchArg>(cmd, "common-random").isSet() 
+				&& !getParam<ValueArg<long> >(cmd, "seed").isSet()) {
+			throw CmdLineParseException("Requires --seed!", 
+				"(--common-random)");
+		}
+		// constraint: --noise-pool only valid if --seed defined, 
+		//	since only keyed streams give the same noise in every bin
+		if (getParam<SwitchArg>(cmd, "noise-pool").isSet() 
+				&& !getParam<ValueArg<long> >(cmd, "seed").isSet()) {
+			throw CmdLineParseException("Requires --seed!", 
+				"(--noise-pool)");
+		}
+		// constraint: --stream-offset only valid if --seed defined, 
+		//	since only keyed streams can be positioned
+		if (getParam<ValueArg<long> >(cmd, "stream-offset").isSet() 
+				&& !getParam<ValueArg<long> >(cmd, "seed").isSet()) {
+			throw CmdLineParseException("Requires --seed!", 
+				"(--stream-offset)");
+		}
+		// constraint: --pack-bins not valid with --pipeline, 
+		//	--target-error, --replay, or --result-cache, since each 
+		//	of them handles one bin at a time
+		if (getParam<ValueArg<long> >(cmd, "pack-bins").isSet() 
+				&& (getParam<ValueArg<long> >(cmd, "pipeline").isSet() 
+				|| getParam<ValueArg<double> >(cmd, "target-error").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "replay").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "result-cache").isSet())) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--pack-bins)");
+		}
+		// constraint: --save-trials not valid with --replay, 
+		//	--checkpoint, --shard, or --merge, since the archive 
+		//	holds one complete run
+		if (getParam<ValueArg<string> >(cmd, "save-trials").isSet() 
+				&& (getParam<ValueArg<string> >(cmd, "replay").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "checkpoint").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "shard").isSet() 
+				|| getParam<ValueArg<long> >(cmd, "merge").isSet())) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--save-trials)");
+		}
+		// constraint: --replay not valid with --shard or --merge, 
+		//	since the archive is read in order
+		if (getParam<ValueArg<string> >(cmd, "replay").isSet() 
+				&& (getParam<ValueArg<string> >(cmd, "shard").isSet() 
+				|| getParam<ValueArg<long> >(cmd, "merge").isSet())) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--replay)");
+		}
+		// constraint: --target-error not valid with --shard, --merge, 
+		//	or --pipeline, since none of them can tell when the 
+		//	whole bin has enough light curves
+		if (getParam<ValueArg<double> >(cmd, "target-error").isSet() 
+				&& (getParam<ValueArg<string> >(cmd, "shard").isSet() 
+				|| getParam<ValueArg<long> >(cmd, "merge").isSet() 
+				|| getParam<ValueArg<long> >(cmd, "pipeline").isSet())) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--target-error)");
+		}
+		// constraint: --result-cache only valid if --seed defined, 
+		//	since otherwise no two runs have the same results
+		if (getParam<ValueArg<string> >(cmd, "result-cache").isSet() 
+				&& !getParam<ValueArg<long> >(cmd, "seed").isSet()) {
+			throw CmdLineParseException("Requires --seed!", 
+				"(--result-cache)");
+		}
+		// constraint: --result-cache not valid with --checkpoint, 
+		//	--archive, --shard, --merge, --save-trials, or --replay, 
+		//	since a cached bin is not simulated and its 
+		//	distribution files must be on disk
+		if (getParam<ValueArg<string> >(cmd, "result-cache").isSet() 
+				&& (getParam<ValueArg<string> >(cmd, "checkpoint").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "archive").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "shard").isSet() 
+				|| getParam<ValueArg<long> >(cmd, "merge").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "save-trials").isSet() 
+				|| getParam<ValueArg<string> >(cmd, "replay").isSet())) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--result-cache)");
+		}
+		// constraint: --print-select other than first not valid with 
+		//	--checkpoint, since the light curves chosen so far 
+		//	are not saved
+		const string printSpec = getParam<ValueArg<string> >(cmd, "print-select").getValue();
+		if (printSpec != "first" 
+				&& getParam<ValueArg<string> >(cmd, "checkpoint").isSet()) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--print-select)");
+		}
+		// constraint: --print-select outlier not valid with 
+		//	--no-distributions, since it reads the stored values
+		if (printSpec.compare(0, 8, "outlier:") == 0 
+				&& getParam<SwitchArg>(cmd, "no-distributions").isSet()) {
+			throw CmdLineParseException("Mutually exclusive argument already set!", 
+				"(--print-select)");
+		}
 		
 		//--------------------------------------------------
 		// Export values
 	
 		// Mandatory simulation settings
-		parseSimType(cmd, jdList, dataSet, injectMode, sigma);
+		parseSimType(cmd, jdList, dataSet, injectMode, sigma, magMode);
 	
 		// Optional simulation settings
-		parseSimOptions(cmd, nTrials, toPrint);
+		parseSimOptions(cmd, nTrials, toPrint, nThreads, seed, storeDistribs, storeCurves, sketchSize, printQuantiles, floatCurves, 
+			distribFormat, compressDistribs, archiveFile, archiveCompress, 
+			pgramMethod, floatPgram, sacfMethod, peakMethod, cacheDir, cacheLimit, gpFactor, tauGrid, gpOrder, gpRank, gpSeasons, gpSparse, gpFit, gpPlugin, rWorkers, 
+			gpStart, statBudget, statThreads, profile, profileCounters, cacheReport, 
+			progressInterval, traceFile, traceEvents, memoryReport, 
+			memoryLimit, flushEvery, checkpointFile, resume, shard, 
+			nShards, merge, pipelineDepth, numa, hugePages, gpuStats, printPolicy, printStat, 
+			shapeTolerance, noisePool, streamOffset, packBins, gpBin, costsFile, 
+			tune, targetError, sampling, 
+			commonRandom, saveTrialsFile, replayFile, resultCache, cadenceFiles, 
+			baselines);
 	
 		// Light curve list
 		try {
@@ -147,6 +461,7 @@ void parseArguments(int argc, char* argv[],
 		// Model parameters
 		try {
 			parseModelParams(cmd, paramRanges);
+			parseModelGrid(cmd, paramRanges, paramGrid);
 		} catch (const utils::except::UnexpectedNan& e) {
 			throw std::logic_error("Parameter validation doesn't work!\nOriginal error: " + string(e.what()));
 		} catch (const models::except::ExtraParam& e) {
@@ -2,7 +2,7 @@
  * @file lightcurveMC/cmd/cmd.tmp.h
  * @author Krzysztof Findeisen
  * @date Created May 11, 2013
- * @date Last modified August 19, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <stdexcept>
@@ -10,8 +10,15 @@
 #include <typeinfo>
 #include <vector>
 #include "../binstats.h"
+#include "../lcdump.h"
 #include "../lightcurvetypes.h"
 #include "../paramlist.h"
+#include "../sims.h"
+#include "../stats/columns.h"
+#include "../stats/gpfit.h"
+#include "../stats/scargleacf.h"
+#include "../stats/statfamilies.h"
+#include "../waves/generators.h"
 
 #include "../../common/warnflags.h"
 
@@ -49,7 +56,7 @@ void logSimType(CmdLineInterface& cmd);
 /** Parses the command line parameters that define the simulation
  */
 void parseSimType(CmdLineInterface& cmd, string& cadenceFile, string& catalogFile, 
-		bool& isInject, double& noise);
+		bool& isInject, double& noise, bool& magMode);
 
 /** Specifies the command line parameters that change optional settings
  */
@@ -57,7 +64,27 @@ void logSimOptions(CmdLineInterface& cmd);
 
 /** Parses the command line parameters that change optional settings
  */
-void parseSimOptions(CmdLineInterface& cmd, long& nTrials, long& nPrint);
+void parseSimOptions(CmdLineInterface& cmd, long& nTrials, long& nPrint, 
+		long& nThreads, long& seed, bool& storeDistribs, bool& storeCurves, long& sketchSize, bool& printQuantiles, bool& floatCurves, 
+		stats::DistribFormat& distribFormat, bool& compressDistribs, 
+		string& archiveFile, bool& archiveCompress, 
+		stats::PeriodogramMethod& pgramMethod, bool& floatPgram, 
+		stats::ScargleAcfMethod& sacfMethod, stats::PeakMethod& peakMethod, 
+		string& cacheDir, 
+		double& cacheLimit, utils::CovarFactor& gpFactor, long& tauGrid, long& gpOrder, long& gpRank, 
+		double& gpSeasons, double& gpSparse, stats::GpFitMethod& gpFit, string& gpPlugin, long& rWorkers, stats::GpStart& gpStart, 
+		double& statBudget, long& statThreads, bool& profile, bool& profileCounters, 
+		bool& cacheReport, double& progressInterval, 
+		string& traceFile, long& traceEvents, bool& memoryReport, 
+		double& memoryLimit, long& flushEvery, string& checkpointFile, 
+		bool& resume, long& shard, long& nShards, long& merge, 
+		long& pipelineDepth, bool& numa, bool& hugePages, bool& gpuStats, 
+		DumpPolicy& printPolicy, string& printStat, 
+		double& shapeTolerance, bool& noisePool, long& streamOffset, 
+		long& packBins, double& gpBin, string& costsFile, bool& tune, 
+		double& targetError, ParamSampling& sampling, bool& commonRandom, 
+		string& saveTrialsFile, string& replayFile, string& resultCache, 
+		vector<string>& cadenceFiles, vector<double>& baselines);
 
 /** Specifies the command line parameters that list light curves and statistics
  */
@@ -84,6 +111,12 @@ void logModelParams(CmdLineInterface& cmd);
  */
 void parseModelParams(CmdLineInterface& cmd, RangeList& range);
 
+/** Parses the command line parameter that lists bins of model parameter 
+ * ranges
+ */
+void parseModelGrid(CmdLineInterface& cmd, const RangeList& defaults, 
+		std::vector<RangeList>& bins);
+
 
 /** Adds a parameter to a light curve specification if the appropriate 
  * command line argument was used
@@ -2,10 +2,16 @@
  * @file lightcurveMC/cmd/modelparams.cpp
  * @author Krzysztof Findeisen
  * @date Created August 19, 2013
- * @date Last modified August 19, 2013
+ * @date Last modified October 14, 2026
  */
 
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
 #include <string>
+#include <vector>
 #include "cmd.tmp.h"
 #include "cmd_constraints.tmp.h"
 #include "cmd_ranges.tmp.h"
@@ -94,6 +100,10 @@ void logModelParams(CmdLineInterface& cmd) {
 		false, 
 		Range(), &posRange);
 	cmd.add(argAmp2);
+	ValueArg<string>* argGrid = new ValueArg<string>("", "grid", 
+		"a file listing several bins of parameter ranges to simulate in turn. The output is the same as one run per bin, except that the header is printed once, and the bins share cached cadences, thresholds, and covariance factorizations. Each line of the file is one bin: a list of parameter names as printed in the header (a, p, ph, width, width2, d, amp2, period2), each followed by its smallest and largest values. Parameters missing from a line keep the ranges given on the command line. Every bin must end up with the same parameters. Blank lines and lines starting with # are ignored.", 
+		false, "", "file");
+	cmd.add(argGrid);
 }
 
 /** Parses the command line parameters that describe model parameter ranges
@@ -129,4 +139,181 @@ void parseModelParams(CmdLineInterface& cmd, RangeList& range) {
 		RangeList::LOGUNIFORM);
 }
 
+/** Returns the parameters of the built-in light curves, in the order 
+ *	used by parseModelParams()
+ *
+ * @return A list of parameter names and their distributions.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const std::vector<std::pair<ParamType, RangeList::RangeType> >& modelParamTable() {
+	typedef std::pair<ParamType, RangeList::RangeType> Entry;
+	static const Entry builtIn[] = {
+		Entry("a",       RangeList::LOGUNIFORM), 
+		Entry("p",       RangeList::LOGUNIFORM), 
+		Entry("ph",      RangeList::UNIFORM), 
+		Entry("width",   RangeList::LOGUNIFORM), 
+		Entry("width2",  RangeList::LOGUNIFORM), 
+		Entry("d",       RangeList::LOGUNIFORM), 
+		Entry("amp2",    RangeList::LOGUNIFORM), 
+		Entry("period2", RangeList::LOGUNIFORM)};
+	static const std::vector<Entry> table(builtIn, 
+		builtIn + sizeof(builtIn)/sizeof(builtIn[0]));
+	return table;
+}
+
+/** Tests whether a range list has a parameter
+ *
+ * @param[in] range The list to search.
+ * @param[in] param The parameter to find.
+ *
+ * @return True if @p param is one of the parameters of @p range.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool hasParam(const RangeList& range, const ParamType& param) {
+	for(RangeList::const_iterator it = range.begin(); it != range.end(); it++) {
+		if (*it == param) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Parses one line of a --grid file
+ *
+ * @param[in] line The text of the line.
+ * @param[in] where A description of the line, for error messages.
+ * @param[in] defaults The ranges of any parameters missing from @p line.
+ * @param[out] bin The parameter ranges of the bin.
+ *
+ * @post @p bin contains every parameter of @p line and of @p defaults, 
+ *	in the order used by parseModelParams().
+ *
+ * @exception TCLAP::CmdLineParseException Thrown if @p line names an 
+ *	unknown or repeated parameter, or gives an invalid range.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void parseGridBin(const string& line, const string& where, 
+		const RangeList& defaults, RangeList& bin) {
+	static PositiveNumber<Range> posRange;
+	static UnitSubrange         unitRange;
+	typedef std::vector<std::pair<ParamType, RangeList::RangeType> > Table;
+	const Table& table = modelParamTable();
+	
+	std::map<ParamType, Range> given;
+	std::istringstream tokens(line);
+	string name;
+	while (tokens >> name) {
+		Table::const_iterator entry = table.begin();
+		while (entry != table.end() && entry->first != name) {
+			entry++;
+		}
+		if (entry == table.end()) {
+			throw CmdLineParseException(where + ": unknown parameter \"" 
+				+ name + "\"", "(--grid)");
+		}
+		Range value;
+		if (!(tokens >> value)) {
+			throw CmdLineParseException(where + ": expected two numbers after \"" 
+				+ name + "\"", "(--grid)");
+		}
+		const Constraint<Range>& allowed = (entry->second == RangeList::UNIFORM 
+			? static_cast<const Constraint<Range>&>(unitRange) 
+			: static_cast<const Constraint<Range>&>(posRange));
+		if (!allowed.check(value)) {
+			throw CmdLineParseException(where + ": for \"" + name + "\", " 
+				+ allowed.description(), "(--grid)");
+		}
+		if (!given.insert(std::make_pair(name, value)).second) {
+			throw CmdLineParseException(where + ": \"" + name 
+				+ "\" given more than once", "(--grid)");
+		}
+	}
+	
+	RangeList temp;
+	for(Table::const_iterator it = table.begin(); it != table.end(); it++) {
+		std::map<ParamType, Range>::const_iterator value = given.find(it->first);
+		if (value != given.end()) {
+			temp.add(it->first, value->second, it->second);
+		} else if (hasParam(defaults, it->first)) {
+			temp.add(it->first, defaults.getMin(it->first), 
+				defaults.getMax(it->first), defaults.getType(it->first));
+		}
+	}
+	
+	bin = temp;
+}
+
+/** Parses the --grid command line parameter into a list of bins
+ *
+ * @param[in] cmd The command-line parser used by the program
+ * @param[in] defaults The ranges given by the other model parameters.
+ * @param[out] bins The parameter ranges of each bin to simulate, in order.
+ *
+ * @post If --grid was not given, @p bins contains only @p defaults.
+ * @post Every element of @p bins has the same parameters.
+ * 
+ * @exception std::logic_error Thrown if the expected parameters are 
+ *	missing from @p cmd.
+ * @exception TCLAP::CmdLineParseException Thrown if the grid file 
+ *	cannot be read, is empty, or has an invalid line, or if its 
+ *	bins do not all have the same parameters.
+ *
+ * @exceptsafe All arguments are left in valid states in the event 
+ *	of an exception.
+ */
+void parseModelGrid(CmdLineInterface& cmd, const RangeList& defaults, 
+		std::vector<RangeList>& bins) {
+	ValueArg<string>& argGrid = getParam<ValueArg<string> >(cmd, "grid");
+	std::vector<RangeList> temp;
+	
+	if (!argGrid.isSet()) {
+		temp.push_back(defaults);
+	} else {
+		const string fileName = argGrid.getValue();
+		std::ifstream file(fileName.c_str());
+		if (!file) {
+			throw CmdLineParseException("Could not open " + fileName, 
+				"(--grid)");
+		}
+		
+		string line;
+		for(long lineNum = 1; std::getline(file, line); lineNum++) {
+			std::istringstream tokens(line);
+			string first;
+			if (!(tokens >> first) || first[0] == '#') {
+				continue;
+			}
+			std::ostringstream where;
+			where << fileName << ", line " << lineNum;
+			
+			RangeList bin;
+			parseGridBin(line, where.str(), defaults, bin);
+			
+			// Bins with different parameters would need different headers
+			if (!temp.empty() && (std::distance(bin.begin(), bin.end()) 
+					!= std::distance(temp.front().begin(), temp.front().end()) 
+					|| !std::equal(bin.begin(), bin.end(), temp.front().begin()))) {
+				throw CmdLineParseException(where.str() 
+					+ ": every bin must have the same parameters", "(--grid)");
+			}
+			temp.push_back(bin);
+		}
+		if (file.bad()) {
+			throw CmdLineParseException("Could not read " + fileName, 
+				"(--grid)");
+		}
+		if (temp.empty()) {
+			throw CmdLineParseException(fileName + " contains no bins", 
+				"(--grid)");
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	bins.swap(temp);
+}
+
 }}	// end lcmc::parse
@@ -2,10 +2,12 @@
  * @file lightcurveMC/cmd/simoptions.cpp
  * @author Krzysztof Findeisen
  * @date Created August 19, 2013
- * @date Last modified August 19, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <string>
+#include <vector>
+#include <cstdio>
 #include "cmd.tmp.h"
 #include "cmd_constraints.tmp.h"
 
@@ -46,13 +48,251 @@ using namespace TCLAP;
 void logSimOptions(CmdLineInterface& cmd) {
 	static    PositiveNumber<long>    posInt;
 	static NonNegativeNumber<long> nonNegInt;
+	static NonNegativeNumber<double> nonNegReal;
+	static    PositiveNumber<double>    posReal;
 
-	ValueArg<long>* argRepeat = new ValueArg<long>("", "ntrials", "Number of light curves generated per bin. 1000 if omitted.", 
+	ValueArg<long>* argRepeat = new ValueArg<long>("", "ntrials", "Number of light curves generated per bin, or the most generated per bin with --target-error. 1000 if omitted.", 
 		false, 1000, &posInt);
 	cmd.add(argRepeat);
 	ValueArg<long>* argPrint = new ValueArg<long>("", "print", "Number of light curves to print. 0 if omitted.", 
 		false, 0, &nonNegInt);
 	cmd.add(argPrint);
+	ValueArg<long>* argThreads = new ValueArg<long>("", "threads", "Number of threads used to analyze light curves. 1 if omitted.", 
+		false, 1, &posInt);
+	cmd.add(argThreads);
+	ValueArg<long>* argStatThreads = new ValueArg<long>("", "stat-threads", "Number of threads used to calculate the statistics of each light curve. Independent groups of statistics (C1, periodogram, dmdt, each ACF, peak-finding, gp, drw) run at the same time, so each light curve takes about as long as its slowest group; useful for runs with few light curves. Multiplies the thread count from --threads. '--gp-start previous' has no effect with more than one thread. 1 if omitted.", 
+		false, 1, &posInt);
+	cmd.add(argStatThreads);
+	SwitchArg* argProfile = new SwitchArg("", "profile", "Time the simulation, the analysis, and each group of statistics, and print the mean milliseconds per light curve as extra columns at the end of each row. With --stat-threads, groups running at the same time are each charged their own wall time.");
+	cmd.add(argProfile);
+	SwitchArg* argProfileCounters = new SwitchArg("", "profile-counters", "With --profile, also count processor cycles, instructions, and last-level cache misses in the same stages, and print the mean millions of cycles, the instructions per cycle, and the mean thousands of cache misses per light curve after the timing columns. Only the thread running each stage is counted. Ignored without --profile, or unless the program was built with PERF = perf_event and the system lets unprivileged programs count hardware events.");
+	cmd.add(argProfileCounters);
+	SwitchArg* argCacheReport = new SwitchArg("", "cache-report", "At the end of the run, print to standard error how often each internal cache (cadences, covariance matrices and factorizations, periodogram thresholds and plans, ACF and dmdt plans) reused an earlier result, and how long it spent when it could not. Useful for finding parameter ranges that defeat a cache.");
+	cmd.add(argCacheReport);
+	ValueArg<double>* argProgress = new ValueArg<double>("", "progress", "Print a progress report to standard error at most every this many seconds: the trials completed in the current light curve type, trials per second, the shares of time spent simulating and analyzing, the estimated time left for the light curve type and for the whole run, and the peak memory use. Reports are printed between batches of light curves, so a batch that takes longer than the interval delays the next report. 0 (no reports) if omitted.", 
+		false, 0.0, &nonNegReal);
+	cmd.add(argProgress);
+	ValueArg<string>* argTrace = new ValueArg<string>("", "trace", "File in which to save a timeline of the simulation and analysis of each light curve, with one track per thread, in the Chrome trace event format. The file can be opened with chrome://tracing or Perfetto to find unusually slow light curves. If omitted, no timeline is recorded.", 
+		false, "", "file");
+	cmd.add(argTrace);
+	ValueArg<long>* argTraceEvents = new ValueArg<long>("", "trace-events", "Most events to keep for --trace. Once this many have been recorded, each new event replaces the oldest one, so the timeline covers only the end of the run. Each event takes about 32 bytes. 1000000 if omitted.", 
+		false, 1000000, &posInt);
+	cmd.add(argTraceEvents);
+	SwitchArg* argMemoryReport = new SwitchArg("", "memory-report", "After each light curve type, print to standard error the memory held by each collection of statistics and by the internal caches, and the program's current and peak memory use.");
+	cmd.add(argMemoryReport);
+	ValueArg<double>* argMemoryLimit = new ValueArg<double>("", "memory-limit", "Most megabytes that the statistics of one light curve type may hold before the distributions collected so far are written out, to the archive if --archive is given, as numbered parts of their distribution files. The summary table then gives a pattern matching all the parts. This limit does not cover the internal caches. 0 (no limit) if omitted.", 
+		false, 0.0, &nonNegReal);
+	cmd.add(argMemoryLimit);
+	ValueArg<long>* argFlushEvery = new ValueArg<long>("", "flush-every", "Write the distributions collected so far as numbered parts of their distribution files after at least this many light curves of each type, as for --memory-limit. Only the running summaries stay in memory, and an interrupted run leaves its results so far on disk unless --archive is given. Rounded up to a whole batch of light curves. 0 (only at the end of each light curve type) if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argFlushEvery);
+	ValueArg<string>* argCheckpoint = new ValueArg<string>("", "checkpoint", "File in which to save the progress of the run whenever the distributions are written out (see --flush-every and --memory-limit) and after each light curve type, so that an interrupted run can be continued with --resume. Requires --seed, and cannot be combined with --archive. If omitted, no checkpoints are saved.", 
+		false, "", "file");
+	cmd.add(argCheckpoint);
+	SwitchArg* argResume = new SwitchArg("", "resume", "Continue the run from the file given by --checkpoint: reprint the rows of the light curve types already finished, restore the statistics of the one in progress, and continue from the first light curve not yet saved. The final output is the same as for an uninterrupted run with the same --checkpoint and --threads. The other options must match the interrupted run; a different --seed, --stream-offset, --ntrials, list of light curve types, --flush-every, or --memory-limit is an error. If the checkpoint file does not exist, the run starts from the beginning.");
+	cmd.add(argResume);
+	ValueArg<string>* argShard = new ValueArg<string>("", "shard", "Run only shard K of N of every light curve type, counting from 0, so that one run can be spread over N processes or nodes. Each shard runs a contiguous block of the trials, and saves the statistics of each light curve type to shard_K_of_N.txt instead of printing them; its distribution files are numbered parts labeled K. Requires --seed, and cannot be combined with --checkpoint or --archive. All shards must be given the same other options, and be run in the same directory. If omitted, every trial is run.", 
+		false, "", "K/N");
+	cmd.add(argShard);
+	ValueArg<long>* argMerge = new ValueArg<long>("", "merge", "Instead of simulating, combine the results of a run split into this many shards with --shard, and print the table the run would have printed as a single process. Must be given the same other options as the shards, in the directory where they ran. The shards' parts of each text distribution file are joined into the file a single process would have written; with --distrib-format binary or --archive, they stay in the shards' parts, and the table gives a pattern matching all of them. 0 (no merge) if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argMerge);
+	ValueArg<long>* argPipeline = new ValueArg<long>("", "pipeline", "Simulate the following batches of light curves while earlier batches are analyzed by the --threads analysis threads, with at most this many simulated batches waiting for analysis. The output is the same as without --pipeline, but up to this many more batches are held in memory. After each light curve type, the fraction of time each stage was busy and the average number of waiting batches are printed to standard error. 0 (simulate and analyze in turn) if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argPipeline);
+	ValueArg<long>* argPackBins = new ValueArg<long>("", "pack-bins", "Simulate up to this many consecutive bins together, if each bin's light curves fit in one batch, and analyze all their light curves with one pool of --threads threads. Bins with fewer light curves than threads then keep every thread busy. Each bin keeps its own statistics, and the output is the same, in the same order, as without --pack-bins. Only bins with the same range of periods are packed together. Cannot be combined with --pipeline, --target-error, --replay, --result-cache, --cadence, --baseline, or several MPI processes. 0 (one bin at a time) if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argPackBins);
+	SwitchArg* argNuma = new SwitchArg("", "numa", "Bind each analysis thread to one NUMA node, and keep a separate copy of the covariance factorizations, dmdt pair indices, and periodogram tables on each node the threads use. Trades more memory for less traffic between processor sockets. Ignored unless the program was built with NUMA support and the system has more than one node.");
+	cmd.add(argNuma);
+	SwitchArg* argNoHuge = new SwitchArg("", "no-huge-pages", "Do not ask for huge pages for covariance matrices and their factorizations, dmdt pair indices, periodogram tables, and other large buffers kept for each cadence. By default each buffer of at least 2 MB is aligned to a 2 MB boundary and marked for transparent huge pages, which reduces TLB misses when the buffer is read in full. Has no effect on systems without transparent huge pages.");
+	cmd.add(argNoHuge);
+	SwitchArg* argGpuStats = new SwitchArg("", "gpu-stats", "Compute the periodograms of light curves that share a cadence in batches on a CUDA device, with the cadence's trigonometric tables kept on the device. The periods and periodograms differ from those computed on the CPU only by rounding. Ignored for --periodogram fast, with --stat-budget, or unless the program was built with GPU = cuda and a device is present.");
+	cmd.add(argGpuStats);
+	ValueArg<string>* argPrintSelect = new ValueArg<string>("", "print-select", "Which light curves of each bin to print with --print. 'first' prints the first ones simulated. 'random' prints a random sample of the bin, chosen by the seed and the trial number, so that the same light curves are chosen for any --threads or --pipeline. 'outlier:STAT' prints the light curves with the highest and lowest values of the statistic STAT, named as in its distribution file (e.g., 'outlier:c1' or 'outlier:gpt'); STAT must be one of the statistics calculated, and cannot be used with --no-distributions. The light curves are written by a separate thread while the simulation continues; those chosen by 'random' or 'outlier' are written at the end of each bin. With --shard, each shard chooses its own light curves. 'random' and 'outlier' cannot be combined with --checkpoint or several MPI processes. 'first' if omitted.", 
+		false, "first", "first|random|outlier:STAT");
+	cmd.add(argPrintSelect);
+	ValueArg<double>* argShapeTolerance = new ValueArg<double>("", "shape-tolerance", "Interpolate the waveforms of slow_peak, flare_peak, slow_dip, and flare_dip light curves from a table of each light curve's cycle, instead of evaluating exponentials at every epoch, changing the fluxes by up to this fraction of the amplitude. A light curve is evaluated exactly if its table would need more than 65536 points or more points than it has epochs. Must be less than 1. 0 (exact waveforms) if omitted.", 
+		false, 0.0, &nonNegReal);
+	cmd.add(argShapeTolerance);
+	SwitchArg* argNoisePool = new SwitchArg("", "noise-pool", "Keep the measurement noise of each trial the first time it is drawn, and copy it into the same trial of every other bin of --grid (and, with --common-random, of every other light curve type) instead of drawing it again. The results are unchanged. The pool holds one noise value per epoch per trial per light curve type, and is kept in a temporary file under $TMPDIR (or /tmp) if it is larger than 256 MB. Requires --seed. Ignored with --add.");
+	cmd.add(argNoisePool);
+	ValueArg<string>* argCosts = new ValueArg<string>("", "costs", "File of measured costs per light curve, for each light curve type, list of statistics, and number of epochs. The costs are used to estimate the run time, printed to standard error at the start of the run, and to size the chunks of trials handed out to MPI workers. The time taken by each bin of this run is added to the file, so the first run with --costs calibrates it. If omitted, costs are neither used nor recorded.", 
+		false, "", "file");
+	cmd.add(argCosts);
+	SwitchArg* argTune = new SwitchArg("", "tune", "Before the first bin, time a few batches of its light curves with several batch sizes and numbers of statistic threads (up to the --stat-threads value), and run the whole job with the fastest. Only settings that leave the results unchanged are compared, so nothing is tuned with '--gp-start previous'. With --cache-dir, the choice is saved for each host, cadence, list of statistics, and --threads, and later runs reuse it without timing anything. The choice is printed to standard error. Ignored in injection mode and with --merge; cannot be combined with several MPI processes.");
+	cmd.add(argTune);
+	ValueArg<double>* argTargetError = new ValueArg<double>("", "target-error", "Stop simulating each bin once the standard error of every summary statistic is at most this fraction of its mean, or after --ntrials light curves, whichever comes first. The errors are checked every 100 light curves, so the result does not depend on --threads. The number of light curves used is printed in a Trials column after the statistics. Statistics that are rarely defined, and dumps such as periodograms, do not delay stopping. Cannot be combined with --shard, --merge, --pipeline, or several MPI processes. 0 (always run --ntrials light curves) if omitted.", 
+		false, 0.0, &nonNegReal);
+	cmd.add(argTargetError);
+	static KeywordConstraint* samplingAllowed = NULL;
+	if (samplingAllowed == NULL) {
+		std::vector<string> samplingNames;
+		samplingNames.push_back("random");
+		samplingNames.push_back("sobol");
+		samplingAllowed = new KeywordConstraint(samplingNames);
+	}
+	ValueArg<string>* argSampling = new ValueArg<string>("", "sampling", "How the light curve parameters of each trial are chosen from their ranges. 'random' draws each parameter independently. 'sobol' takes them from a randomly shifted Sobol sequence, so that the trials of each bin cover the ranges evenly and summary statistics that vary smoothly with the parameters converge in fewer trials; it works best with --ntrials a power of 2, and supports up to 10 parameters whose ranges are not a single value. Requires --seed. 'random' if omitted.", 
+		false, "random", samplingAllowed);
+	cmd.add(argSampling);
+	SwitchArg* argCommonRandom = new SwitchArg("", "common-random", "Give trial K of every light curve type the same random numbers: the same parameters, measurement noise, injected light curves, and random draws of the models. Differences between light curve types are then not blurred by differences in their random draws, so comparisons between types need fewer trials. Requires --seed. The results for each type no longer match a run of that type alone.");
+	cmd.add(argCommonRandom);
+	ValueArg<string>* argSaveTrials = new ValueArg<string>("", "save-trials", "Binary file in which to save every simulated light curve, with the parameters used to generate it, so that later runs can calculate other statistics with --replay instead of simulating again. Each distinct cadence is saved once. Takes 8 bytes per epoch per light curve. Cannot be combined with --replay, --checkpoint, --shard, --merge, or several MPI processes. If omitted, light curves are not saved.", 
+		false, "", "file");
+	cmd.add(argSaveTrials);
+	ValueArg<string>* argReplay = new ValueArg<string>("", "replay", "Instead of simulating light curves, analyze the ones saved by an earlier run with --save-trials. The other options must be those of the earlier run, except for --stat and the options that only affect the analysis or the output; --ntrials may be smaller. Cannot be combined with --shard, --merge, or several MPI processes. If omitted, light curves are simulated.", 
+		false, "", "file");
+	cmd.add(argReplay);
+	ValueArg<string>* argResultCache = new ValueArg<string>("", "result-cache", "Directory in which to keep the table row, distribution files, and printed light curves of every finished light curve type. A later run of the same type, with the same parameter ranges, cadence or injection catalog, noise, statistics, seed, number of trials, program build, and other options that affect the results, reprints them instead of simulating again. Changes to the light curves listed in an injection catalog are not detected. Requires --seed. Cannot be combined with --checkpoint, --archive, --shard, --merge, --save-trials, --replay, or several MPI processes. If omitted, every light curve type is simulated.", 
+		false, "", "dir");
+	cmd.add(argResultCache);
+	MultiArg<string>* argCadence = new MultiArg<string>("", "cadence", "File of Julian dates of another cadence on which to analyze every light curve, in the same format as the main date list. May be given more than once. Each light curve is generated once, at every time in the main date list or any of these files, and then analyzed separately at the times of each cadence. Each extra cadence gets its own table rows and run_*.dat files, labeled by appending @ and the file's name without directory or extension to the light curve type. Cannot be combined with injection mode, several MPI processes, --checkpoint, --shard, --merge, --pipeline, --target-error, --costs, --save-trials, --replay, or --result-cache.", 
+		false, "file");
+	cmd.add(argCadence);
+	MultiArg<double>* argBaseline = new MultiArg<double>("", "baseline", "Length, in days, of a prefix of the main date list on which to also analyze every light curve, as if the survey had stopped after that long. May be given more than once. Each light curve is generated once, on the full date list, and its first observations are analyzed for each baseline. The dmdt bins of each baseline are taken from those of the full date list rather than binned again; the other statistics are calculated afresh for each baseline. Each baseline gets its own table rows and run_*.dat files, labeled by appending @ and the baseline in days to the light curve type. Has the same restrictions as --cadence, with which it may be combined.", 
+		false, &posReal);
+	cmd.add(argBaseline);
+	ValueArg<long>* argSeed = new ValueArg<long>("", "seed", "Seed for per-trial random number streams, so that each light curve can be regenerated independently of the others. If omitted, the light curves are generated from a single sequence of random numbers.", 
+		false, -1, &nonNegInt);
+	cmd.add(argSeed);
+	ValueArg<long>* argStreamOffset = new ValueArg<long>("", "stream-offset", "Give trial K of each bin the random numbers of trial K + this number of a run with the same --seed. The streams of any trial are reached directly, without generating those of earlier trials, so runs with offsets of 0, N, 2N, ... and --ntrials N are independent replicas that together match a single run with more trials. --stream-offset plus --ntrials may be at most 2^32. Requires --seed. 0 if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argStreamOffset);
+	SwitchArg* argNoDistrib = new SwitchArg("", "no-distributions", "Do not record the distributions of scalar statistics in run_*.dat files. Only their summaries are kept, so memory use does not grow with --ntrials.");
+	cmd.add(argNoDistrib);
+	SwitchArg* argCurveSummaries = new SwitchArg("", "curve-summaries", "Do not record every periodogram, dmdt median curve, ACF, peak plot, and RMS curve. Their run_*.dat files instead hold, for each grid on which they were sampled, six rows giving the number of light curves defined at each grid point and the mean, standard deviation, and approximate 5th, 50th, and 95th percentiles across light curves, so memory use does not grow with --ntrials.");
+	cmd.add(argCurveSummaries);
+	ValueArg<long>* argSketchSize = new ValueArg<long>("", "sketch-size", "Number of values each level of the quantile sketches holds before it is compacted. The sketches give the median and 5th and 95th percentiles printed after each scalar statistic by --quantiles, and the percentiles written by --curve-summaries. Larger values give more accurate percentiles, with rank errors of about 1% at 64 and 10^5 light curves, but use more memory. Must be even. 64 if omitted.", 
+		false, 64, &posInt);
+	cmd.add(argSketchSize);
+	SwitchArg* argQuantiles = new SwitchArg("", "quantiles", "Print the median and the 5th and 95th percentiles of each scalar statistic in an extra column after the name of its distribution file. The percentiles are estimated with the precision set by --sketch-size, and are available even with --no-distributions.");
+	cmd.add(argQuantiles);
+	SwitchArg* argFloatCurves = new SwitchArg("", "float-curves", "Store the values of every periodogram, dmdt median curve, ACF, peak plot, and RMS curve in single precision. This halves the memory they use and the size of their binary run_*.dat files; text run_*.dat files, which have three decimal places, change only where rounding crosses the last place. Their sampling grids, and the summaries written by --curve-summaries, keep full precision.");
+	cmd.add(argFloatCurves);
+	
+	static KeywordConstraint* formatAllowed = NULL;
+	if (formatAllowed == NULL) {
+		std::vector<string> formatNames;
+		formatNames.push_back("text");
+		formatNames.push_back("binary");
+		formatAllowed = new KeywordConstraint(formatNames);
+	}
+	ValueArg<string>* argDistribFormat = new ValueArg<string>("", "distrib-format", "Format of the run_*.dat distribution files. 'text' writes each value with three decimal places. 'binary' writes full-precision little-endian columns to run_*.bin instead, described by a JSON schema in run_*.json, so that they can be loaded without parsing. 'text' if omitted.", 
+		false, "text", formatAllowed);
+	cmd.add(argDistribFormat);
+	SwitchArg* argCompressDistribs = new SwitchArg("", "compress-distributions", "Write text distribution files in gzip format, as run_*.dat.gz. The compression runs on a background thread, and typically shrinks the periodogram, dmdt, ACF, and peak-finding distributions severalfold. Has no effect on binary distribution files, on files in --archive (see --archive-compress), or unless the program was built with zlib support.");
+	cmd.add(argCompressDistribs);
+	ValueArg<string>* argArchive = new ValueArg<string>("", "archive", "Zip file in which to collect the distribution files of every light curve type, instead of writing each to its own file. The files keep their usual names inside the archive, and the archive's index lets any one of them be read without unpacking the rest. If omitted, the distribution files are written separately.", 
+		false, "", "file name");
+	cmd.add(argArchive);
+	SwitchArg* argArchiveCompress = new SwitchArg("", "archive-compress", "Compress the distribution files in --archive. Has no effect unless the program was built with zlib support.");
+	cmd.add(argArchiveCompress);
+	
+	static KeywordConstraint* pgramAllowed = NULL;
+	if (pgramAllowed == NULL) {
+		// Because KeywordConstraint takes a mutable reference, need a 
+		//	local variable to store the allowed values
+		std::vector<string> pgramNames;
+		pgramNames.push_back("direct");
+		pgramNames.push_back("fast");
+		pgramAllowed = new KeywordConstraint(pgramNames);
+	}
+	ValueArg<string>* argPgram = new ValueArg<string>("", "periodogram", "Algorithm for calculating periodograms. 'direct' evaluates the Lomb-Scargle periodogram at each frequency. 'fast' uses the O(N log N) method of Press & Rybicki (1989), which agrees with 'direct' to about 1e-5 of the peak power. 'direct' if omitted.", 
+		false, "direct", pgramAllowed);
+	cmd.add(argPgram);
+	SwitchArg* argFloatPgram = new SwitchArg("", "float-periodograms", "Store the trigonometric tables of 'direct' periodograms in single precision. This halves their memory, so tables are kept for cadences twice as long, and doubles the width of the SIMD sums when built with SIMD=avx2 or SIMD=avx512. Phases are still computed in double precision; powers change in about the fifth significant figure.");
+	cmd.add(argFloatPgram);
+	
+	static KeywordConstraint* sacfAllowed = NULL;
+	if (sacfAllowed == NULL) {
+		std::vector<string> sacfNames;
+		sacfNames.push_back("direct");
+		sacfNames.push_back("periodogram");
+		sacfAllowed = new KeywordConstraint(sacfNames);
+	}
+	ValueArg<string>* argSacf = new ValueArg<string>("", "sacf-method", "Algorithm for calculating the Scargle ACFs of '--stat sacf' and '--stat sacfcut'. 'direct' calls the timescales library, as earlier versions did. 'periodogram' transforms a Lomb-Scargle periodogram whose frequency grid and trigonometric terms are computed once per cadence, which is much faster on long baselines but uses a different frequency grid, so the ACFs differ slightly. 'direct' if omitted.", 
+		false, "direct", sacfAllowed);
+	cmd.add(argSacf);
+	
+	static KeywordConstraint* peakAllowed = NULL;
+	if (peakAllowed == NULL) {
+		std::vector<string> peakNames;
+		peakNames.push_back("direct");
+		peakNames.push_back("ladder");
+		peakAllowed = new KeywordConstraint(peakNames);
+	}
+	ValueArg<string>* argPeak = new ValueArg<string>("", "peak-method", "How '--stat peakcut' and '--stat peakplot' search for peak-finding timescales. 'direct' searches separately for the 1/3 and 1/2 amplitude cuts, the peak-finding curve, and the 80% cut, as earlier versions did. 'ladder' searches each light curve once for every threshold and interpolates the 80% cut from the peak-finding curve, so that cut can differ from 'direct' by less than 0.01 mag of threshold. 'direct' if omitted.", 
+		false, "direct", peakAllowed);
+	cmd.add(argPeak);
+	
+	static KeywordConstraint* gpAllowed = NULL;
+	if (gpAllowed == NULL) {
+		std::vector<string> gpNames;
+		gpNames.push_back("eigen");
+		gpNames.push_back("cholesky");
+		gpNames.push_back("fft");
+		gpAllowed = new KeywordConstraint(gpNames);
+	}
+	ValueArg<string>* argGpSampler = new ValueArg<string>("", "gp-sampler", "Algorithm for factoring the covariance matrices of Gaussian process light curves. 'eigen' uses an eigendecomposition. 'cholesky' uses a Cholesky decomposition, which is several times faster but generates different (statistically equivalent) light curves. 'fft' generates simple_gp and two_gp light curves on regular cadences by circulant embedding, in O(N log N) time, and is otherwise the same as 'eigen'. 'eigen' if omitted.", 
+		false, "eigen", gpAllowed);
+	cmd.add(argGpSampler);
+	ValueArg<long>* argTauGrid = new ValueArg<long>("", "tau-grid", "Round the coherence times of simple_gp and two_gp light curves to this many logarithmically spaced values per decade, so that trials with similar coherence times share one covariance factorization. The largest resulting error in the covariance is printed at startup. 0 (exact coherence times) if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argTauGrid);
+	ValueArg<long>* argGpOrder = new ValueArg<long>("", "gp-order", "Generate simple_gp and two_gp light curves from a state-space approximation of this order (1-8) to the squared exponential kernel, in O(N) time. Higher orders are slower but more accurate; the largest error in the covariance is printed at startup. Takes precedence over --gp-sampler for these light curves. 0 (exact covariance) if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argGpOrder);
+	ValueArg<long>* argGpRank = new ValueArg<long>("", "gp-rank", "Generate simple_gp and two_gp light curves having more than this many observations from a Nystrom approximation with this many inducing points, in O(rank^2 N) time and without storing an N x N covariance matrix. The variance missed by the approximation is added back as independent noise; the largest resulting error in the covariance is printed at the end of the run. Takes precedence over --gp-sampler, but not --gp-order, for these light curves. 0 (exact covariance) if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argGpRank);
+	ValueArg<double>* argGpSeasons = new ValueArg<double>("", "gp-seasons", "Generate simple_gp and two_gp light curves one observing season at a time, treating observations separated by a gap across which the kernel has fallen below this fraction of the variance as independent. Each season's covariance matrix is factored separately, so cadences made of several seasons much longer apart than the coherence time are generated far faster. Seasons separated by shorter gaps are generated together. The largest covariance dropped between seasons is printed at the end of the run. Takes precedence over --gp-sampler, but not --gp-order or --gp-rank, for these light curves. 0 (exact covariance) if omitted.", 
+		false, 0.0, &nonNegReal);
+	cmd.add(argGpSeasons);
+	ValueArg<double>* argGpSparse = new ValueArg<double>("", "gp-sparse", "Generate simple_gp and two_gp light curves from a sparse covariance matrix, treating covariances below this fraction of the variance as zero. When the coherence time is short compared to the spacing between observations, the time and memory needed to generate each light curve become proportional to the number of correlated pairs of observations. Light curves whose covariance matrices are not sparse are generated from the full matrix. Takes precedence over --gp-sampler except on regular grids, but --gp-order, --gp-rank, and --gp-seasons take precedence over it. 0 (exact covariance) if omitted.", 
+		false, 0.0, &nonNegReal);
+	cmd.add(argGpSparse);
+	
+	static KeywordConstraint* gpFitAllowed = NULL;
+	if (gpFitAllowed == NULL) {
+		std::vector<string> gpFitNames;
+		gpFitNames.push_back("r");
+		gpFitNames.push_back("native");
+		gpFitNames.push_back("plugin");
+		gpFitAllowed = new KeywordConstraint(gpFitNames);
+	}
+	ValueArg<string>* argGpFit = new ValueArg<string>("", "gp-fit", "Backend for fitting Gaussian process models with '--stat gp'. 'r' uses the gptk package in an embedded R interpreter. 'native' maximizes the same likelihood from the same starting point in compiled code, with analytic gradients and Hessian; it is much faster and can run on several threads, but may converge to slightly different solutions. 'plugin' uses the statistics plugin named by --gp-plugin. 'r' if omitted.", 
+		false, "r", gpFitAllowed);
+	cmd.add(argGpFit);
+	ValueArg<string>* argGpPlugin = new ValueArg<string>("", "gp-plugin", "Statistics plugin to use for '--gp-fit plugin'. The plugin is loaded from lcmc_NAME.so in the directories listed in the environment variable LCMC_PLUGIN_DIR, or in plugins/ next to the program, and only if a Gaussian process statistic is requested. 'rgp' (the plugin used by '--gp-fit r') if omitted.", 
+		false, "rgp", "name");
+	cmd.add(argGpPlugin);
+	ValueArg<long>* argRWorkers = new ValueArg<long>("", "r-workers", "Number of separate R processes to use for '--gp-fit r'. Each process loads gptk once and fits one light curve at a time, so with --threads up to this many fits run in parallel. Requires Rscript on the PATH. 0 (fit in a single embedded R interpreter) if omitted.", 
+		false, 0, &nonNegInt);
+	cmd.add(argRWorkers);
+	static KeywordConstraint* gpStartAllowed = NULL;
+	if (gpStartAllowed == NULL) {
+		std::vector<string> gpStartNames;
+		gpStartNames.push_back("default");
+		gpStartNames.push_back("previous");
+		gpStartNames.push_back("true");
+		gpStartNames.push_back("midpoint");
+		gpStartAllowed = new KeywordConstraint(gpStartNames);
+	}
+	ValueArg<string>* argGpStart = new ValueArg<string>("", "gp-start", "Starting point for fitting Gaussian process models with '--stat gp'. 'default' uses the gptk defaults for every light curve. 'previous' starts from the last solution found by the same thread, so results may depend on --threads. 'true' starts from the timescale used to simulate the light curve. 'midpoint' starts from the geometric middle of the period range. Starting close to the answer makes fits converge faster, but may bias them toward the starting point. 'default' if omitted.", 
+		false, "default", gpStartAllowed);
+	cmd.add(argGpStart);
+	ValueArg<double>* argGpBin = new ValueArg<double>("", "gp-bin", "Average the observations in bins of this width, in days, before fitting Gaussian process models with '--stat gp'. Each bin counts as one point whose noise is reduced by the number of observations in it ('--gp-fit native' only). Dense light curves then fit in a fraction of the time, but the smoothing makes timescales come out slightly too long; the estimated average bias is printed at the end of the run. 0 (fit every observation) if omitted.", 
+		false, 0.0, &nonNegReal);
+	cmd.add(argGpBin);
+	ValueArg<double>* argStatBudget = new ValueArg<double>("", "stat-budget", "Most seconds of wall time that the periodogram, GP, or DRW statistics may spend on one light curve. Light curves that take longer are recorded as undefined, and the number of them is printed after each of these statistics. Fits with '--gp-fit r' can only be cut short if --r-workers is also given. 0 (no limit) if omitted.", 
+		false, 0.0, &nonNegReal);
+	cmd.add(argStatBudget);
+	ValueArg<string>* argCacheDir = new ValueArg<string>("", "cache-dir", "Directory in which to save periodogram false alarm thresholds, Gaussian process covariance factorizations, and parsed cadence files, so that later runs with the same cadence and light curve parameters can reuse them. Created if it does not exist. If omitted, all are recalculated by each run.", 
+		false, "", "directory");
+	cmd.add(argCacheDir);
+	ValueArg<double>* argCacheLimit = new ValueArg<double>("", "cache-limit", "Most megabytes that the files saved in --cache-dir may take up. Whenever a file is saved, the least recently used files are deleted until the cache fits. Files in the directory that the program did not save are never deleted. 4096 if omitted.", 
+		false, 4096.0, &nonNegReal);
+	cmd.add(argCacheLimit);
 }
 
 /** Parses the command line parameters that change optional settings
@@ -61,15 +301,290 @@ void logSimOptions(CmdLineInterface& cmd) {
  * @param[out] nTrials The number of times to run the simulations.
  * @param[out] nPrint The number of simulations whose light curves should 
  *	be dumped to file.
+ * @param[out] nThreads The number of threads to use for analyzing 
+ *	light curves.
+ * @param[out] seed The seed for per-trial random number streams, or -1 
+ *	if the light curves should be generated from a single sequence of 
+ *	random numbers.
+ * @param[out] storeDistribs If true, the distribution of each scalar 
+ *	statistic should be recorded.
+ * @param[out] storeCurves If true, every function statistic should be 
+ *	recorded, rather than its per-point summary.
+ * @param[out] sketchSize The number of values each level of a 
+ *	quantile sketch should hold before it is compacted.
+ * @param[out] printQuantiles If true, the median and percentiles 
+ *	of each scalar statistic should be printed.
+ * @param[out] floatCurves If true, the values of function statistics 
+ *	should be stored in single precision.
+ * @param[out] distribFormat The file format in which to record the 
+ *	distributions of statistics.
+ * @param[out] compressDistribs If true, distributions written as 
+ *	text should be compressed.
+ * @param[out] archiveFile The zip file in which to collect the 
+ *	distributions of statistics, or an empty string if each 
+ *	distribution should have its own file.
+ * @param[out] archiveCompress If true, the distributions in 
+ *	@p archiveFile should be compressed.
+ * @param[out] pgramMethod The algorithm to use for calculating 
+ *	periodograms.
+ * @param[out] floatPgram If true, periodogram tables should be stored 
+ *	in single precision.
+ * @param[out] sacfMethod The algorithm to use for calculating 
+ *	Scargle ACFs.
+ * @param[out] peakMethod The search to use for peak-finding timescales.
+ * @param[out] cacheDir The directory in which to save periodogram 
+ *	thresholds and covariance factorizations, or an empty string if 
+ *	they should not be saved.
+ * @param[out] cacheLimit The most megabytes that the files in 
+ *	@p cacheDir may take up.
+ * @param[out] gpFactor The algorithm to use for factoring Gaussian 
+ *	process covariance matrices.
+ * @param[out] tauGrid The number of grid points per decade to which 
+ *	Gaussian process coherence times are rounded, or 0 for no rounding.
+ * @param[out] gpOrder The order of the state-space approximation to 
+ *	Gaussian process kernels, or 0 to use the exact kernels.
+ * @param[out] gpRank The number of inducing points of the low-rank 
+ *	approximation to Gaussian process kernels, or 0 to use the exact 
+ *	kernels.
+ * @param[out] gpSeasons The largest covariance between observing 
+ *	seasons, as a fraction of the variance, below which seasons are 
+ *	generated independently, or 0 to use the exact kernels.
+ * @param[out] gpSparse The largest covariance, as a fraction of the 
+ *	variance, that may be treated as zero in a sparse covariance 
+ *	matrix, or 0 to use the exact kernels.
+ * @param[out] gpFit The backend to use for fitting Gaussian process 
+ *	models to light curves.
+ * @param[out] gpPlugin The statistics plugin to use for fitting 
+ *	Gaussian process models if @p gpFit is GPFIT_PLUGIN.
+ * @param[out] rWorkers The number of separate R processes to use for 
+ *	fitting Gaussian process models, or 0 to use the embedded R 
+ *	interpreter.
+ * @param[out] gpStart The policy for choosing where Gaussian process 
+ *	fits start.
+ * @param[out] statBudget The most time, in seconds, that an expensive 
+ *	statistic may spend on one light curve, or 0 for no limit.
+ * @param[out] statThreads The number of threads to use for calculating 
+ *	the statistics of each light curve.
+ * @param[out] profile If true, the time spent on each stage of the 
+ *	simulation should be reported.
+ * @param[out] profileCounters If true, the hardware events counted in 
+ *	each stage should also be reported.
+ * @param[out] cacheReport If true, the use of each internal cache 
+ *	should be reported at the end of the run.
+ * @param[out] progressInterval The least time, in seconds, between 
+ *	progress reports, or 0 for no reports.
+ * @param[out] traceFile The file in which to record trace events, or 
+ *	an empty string for no tracing.
+ * @param[out] traceEvents The most trace events to keep.
+ * @param[out] memoryReport If true, the memory used by each bin should 
+ *	be reported.
+ * @param[out] memoryLimit The most memory, in megabytes, that the 
+ *	statistics of a bin may hold before being written out, or 0 for 
+ *	no limit.
+ * @param[out] flushEvery The number of light curves after which the 
+ *	statistics of a bin should be written out, or 0 to write them 
+ *	only at the end of the bin.
+ * @param[out] checkpointFile The file in which to save the progress of 
+ *	the run, or an empty string for no checkpoints.
+ * @param[out] resume If true, the run should continue from 
+ *	@p checkpointFile.
+ * @param[out] shard, nShards The part of the run to carry out is 
+ *	shard @p shard of @p nShards. If there is no sharding, 
+ *	@p shard = 0 and @p nShards = 0.
+ * @param[out] merge The number of shards whose results should be 
+ *	merged, or 0 to simulate.
+ * @param[out] pipelineDepth The most simulated batches that may wait 
+ *	for analysis, or 0 to simulate and analyze in turn.
+ * @param[out] numa If true, analysis threads are bound to NUMA nodes.
+ * @param[out] hugePages If true, large buffers are placed on huge pages.
+ * @param[out] gpuStats If true, batches of periodograms may be computed 
+ *	on a CUDA device.
+ * @param[out] printPolicy, printStat How to choose the light curves 
+ *	to print, and the statistic by which to choose them (if any).
+ * @param[out] shapeTolerance The largest error allowed in tabulated 
+ *	outburst and fade waveforms, as a fraction of the amplitude, or 
+ *	0 to evaluate them exactly.
+ * @param[out] noisePool If true, the noise of each trial is drawn once 
+ *	and reused by every bin.
+ * @param[out] streamOffset The number added to each trial's index to 
+ *	key its random number streams.
+ * @param[out] packBins The most bins to simulate and analyze together, 
+ *	or 0 to run one bin at a time.
+ * @param[out] gpBin The width of the bins in which light curves are 
+ *	averaged before Gaussian process fitting, or 0 to fit every 
+ *	observation.
+ * @param[out] costsFile The file of measured costs to use and update, 
+ *	or an empty string to ignore costs.
+ * @param[out] tune If true, time the candidate batch sizes and 
+ *	statistic thread counts before the first bin.
+ * @param[out] targetError The relative standard error at which a bin 
+ *	has enough light curves, or 0 to run @p nTrials in every bin.
+ * @param[out] sampling The way trial parameters are drawn.
+ * @param[out] commonRandom If true, every light curve type uses the 
+ *	same random numbers for each trial.
+ * @param[out] saveTrialsFile The file in which to save the simulated 
+ *	light curves, or an empty string to not save them.
+ * @param[out] replayFile The file from which to read light curves 
+ *	instead of simulating them, or an empty string to simulate.
+ * @param[out] resultCache The directory in which to keep the results 
+ *	of finished bins, or an empty string to run every bin.
+ * @param[out] cadenceFiles The files of Julian dates of any other 
+ *	cadences on which to analyze each light curve.
+ * @param[out] baselines The lengths of the prefixes of the main 
+ *	cadence on which to analyze each light curve.
  * 
  * @exception std::logic_error Thrown if the expected parameters are missing from @p cmd.
  *
  * @exceptsafe All arguments are left in valid states in the event 
  *	of an exception.
  */
-void parseSimOptions(CmdLineInterface& cmd, long& nTrials, long& nPrint) {
-	nTrials = getParam<ValueArg<long> >(cmd, "ntrials").getValue();
-	nPrint  = getParam<ValueArg<long> >(cmd, "print").getValue();
+void parseSimOptions(CmdLineInterface& cmd, long& nTrials, long& nPrint, 
+		long& nThreads, long& seed, bool& storeDistribs, bool& storeCurves, long& sketchSize, bool& printQuantiles, bool& floatCurves, 
+		stats::DistribFormat& distribFormat, bool& compressDistribs, 
+		string& archiveFile, bool& archiveCompress, 
+		stats::PeriodogramMethod& pgramMethod, bool& floatPgram, 
+		stats::ScargleAcfMethod& sacfMethod, stats::PeakMethod& peakMethod, 
+		string& cacheDir, 
+		double& cacheLimit, utils::CovarFactor& gpFactor, long& tauGrid, long& gpOrder, long& gpRank, 
+		double& gpSeasons, double& gpSparse, stats::GpFitMethod& gpFit, string& gpPlugin, long& rWorkers, stats::GpStart& gpStart, 
+		double& statBudget, long& statThreads, bool& profile, bool& profileCounters, 
+		bool& cacheReport, double& progressInterval, 
+		string& traceFile, long& traceEvents, bool& memoryReport, 
+		double& memoryLimit, long& flushEvery, string& checkpointFile, 
+		bool& resume, long& shard, long& nShards, long& merge, 
+		long& pipelineDepth, bool& numa, bool& hugePages, bool& gpuStats, 
+		DumpPolicy& printPolicy, string& printStat, 
+		double& shapeTolerance, bool& noisePool, long& streamOffset, 
+		long& packBins, double& gpBin, string& costsFile, bool& tune, 
+		double& targetError, ParamSampling& sampling, bool& commonRandom, 
+		string& saveTrialsFile, string& replayFile, string& resultCache, 
+		vector<string>& cadenceFiles, vector<double>& baselines) {
+	nTrials  = getParam<ValueArg<long> >(cmd, "ntrials").getValue();
+	nPrint   = getParam<ValueArg<long> >(cmd, "print").getValue();
+	nThreads = getParam<ValueArg<long> >(cmd, "threads").getValue();
+	seed     = getParam<ValueArg<long> >(cmd, "seed"   ).getValue();
+	storeDistribs = !getParam<SwitchArg>(cmd, "no-distributions").getValue();
+	storeCurves   = !getParam<SwitchArg>(cmd, "curve-summaries").getValue();
+	sketchSize    = getParam<ValueArg<long> >(cmd, "sketch-size").getValue();
+	printQuantiles = getParam<SwitchArg>(cmd, "quantiles").getValue();
+	floatCurves   = getParam<SwitchArg>(cmd, "float-curves").getValue();
+	distribFormat = (getParam<ValueArg<string> >(cmd, "distrib-format").getValue() == "binary" 
+		? stats::DISTRIB_BINARY : stats::DISTRIB_TEXT);
+	compressDistribs = getParam<SwitchArg>(cmd, "compress-distributions").getValue();
+	archiveFile   = getParam<ValueArg<string> >(cmd, "archive").getValue();
+	archiveCompress = getParam<SwitchArg>(cmd, "archive-compress").getValue();
+	pgramMethod   = (getParam<ValueArg<string> >(cmd, "periodogram").getValue() == "fast" 
+		? stats::LS_FAST : stats::LS_DIRECT);
+	floatPgram    = getParam<SwitchArg>(cmd, "float-periodograms").getValue();
+	sacfMethod    = (getParam<ValueArg<string> >(cmd, "sacf-method").getValue() == "periodogram" 
+		? stats::SACF_PERIODOGRAM : stats::SACF_DIRECT);
+	peakMethod    = (getParam<ValueArg<string> >(cmd, "peak-method").getValue() == "ladder" 
+		? stats::PEAK_LADDER : stats::PEAK_DIRECT);
+	cacheDir      = getParam<ValueArg<string> >(cmd, "cache-dir").getValue();
+	cacheLimit    = getParam<ValueArg<double> >(cmd, "cache-limit").getValue();
+	const string gpSampler = getParam<ValueArg<string> >(cmd, "gp-sampler").getValue();
+	gpFactor      = (gpSampler == "cholesky" ? utils::FACTOR_CHOLESKY 
+		: (gpSampler == "fft" ? utils::FACTOR_CIRCULANT : utils::FACTOR_EIGEN));
+	tauGrid       = getParam<ValueArg<long> >(cmd, "tau-grid").getValue();
+	gpOrder       = getParam<ValueArg<long> >(cmd, "gp-order").getValue();
+	if (gpOrder > 8) {
+		throw TCLAP::CmdLineParseException("Expected an order of at most 8", 
+			"(--gp-order)");
+	}
+	gpRank        = getParam<ValueArg<long> >(cmd, "gp-rank").getValue();
+	gpSeasons     = getParam<ValueArg<double> >(cmd, "gp-seasons").getValue();
+	if (gpSeasons >= 1.0) {
+		throw TCLAP::CmdLineParseException("Expected a tolerance less than 1", 
+			"(--gp-seasons)");
+	}
+	gpSparse      = getParam<ValueArg<double> >(cmd, "gp-sparse").getValue();
+	if (gpSparse >= 1.0) {
+		throw TCLAP::CmdLineParseException("Expected a tolerance less than 1", 
+			"(--gp-sparse)");
+	}
+	const string gpFitName = getParam<ValueArg<string> >(cmd, "gp-fit").getValue();
+	gpFit         = (gpFitName == "native" ? stats::GPFIT_NATIVE 
+		: (gpFitName == "plugin" ? stats::GPFIT_PLUGIN 
+		: stats::GPFIT_R));
+	gpPlugin      = getParam<ValueArg<string> >(cmd, "gp-plugin").getValue();
+	if (gpPlugin.empty() || gpPlugin.find('/') != string::npos) {
+		throw TCLAP::CmdLineParseException("Expected a plugin name without a directory", 
+			"(--gp-plugin)");
+	}
+	rWorkers      = getParam<ValueArg<long> >(cmd, "r-workers").getValue();
+	const string gpStartName = getParam<ValueArg<string> >(cmd, "gp-start").getValue();
+	gpStart       = (gpStartName == "previous" ? stats::GPSTART_PREVIOUS 
+		: (gpStartName == "true" ? stats::GPSTART_TRUE 
+		: (gpStartName == "midpoint" ? stats::GPSTART_MIDPOINT 
+		: stats::GPSTART_DEFAULT)));
+	statBudget    = getParam<ValueArg<double> >(cmd, "stat-budget").getValue();
+	statThreads   = getParam<ValueArg<long> >(cmd, "stat-threads").getValue();
+	profile       = getParam<SwitchArg>(cmd, "profile").getValue();
+	profileCounters = getParam<SwitchArg>(cmd, "profile-counters").getValue();
+	cacheReport   = getParam<SwitchArg>(cmd, "cache-report").getValue();
+	progressInterval = getParam<ValueArg<double> >(cmd, "progress").getValue();
+	traceFile     = getParam<ValueArg<string> >(cmd, "trace").getValue();
+	traceEvents   = getParam<ValueArg<long> >(cmd, "trace-events").getValue();
+	memoryReport  = getParam<SwitchArg>(cmd, "memory-report").getValue();
+	memoryLimit   = getParam<ValueArg<double> >(cmd, "memory-limit").getValue();
+	flushEvery    = getParam<ValueArg<long> >(cmd, "flush-every").getValue();
+	checkpointFile = getParam<ValueArg<string> >(cmd, "checkpoint").getValue();
+	resume        = getParam<SwitchArg>(cmd, "resume").getValue();
+	const string shardSpec = getParam<ValueArg<string> >(cmd, "shard").getValue();
+	shard   = 0;
+	nShards = 0;
+	if (!shardSpec.empty()) {
+		char extra;
+		if (sscanf(shardSpec.c_str(), "%ld/%ld%c", &shard, &nShards, &extra) != 2 
+				|| nShards < 1 || shard < 0 || shard >= nShards) {
+			throw TCLAP::CmdLineParseException("Expected K/N with 0 <= K < N, found " 
+				+ shardSpec, "(--shard)");
+		}
+	}
+	merge         = getParam<ValueArg<long> >(cmd, "merge").getValue();
+	pipelineDepth = getParam<ValueArg<long> >(cmd, "pipeline").getValue();
+	numa          = getParam<SwitchArg>(cmd, "numa").getValue();
+	hugePages     = !getParam<SwitchArg>(cmd, "no-huge-pages").getValue();
+	gpuStats      = getParam<SwitchArg>(cmd, "gpu-stats").getValue();
+	const string printSpec = getParam<ValueArg<string> >(cmd, "print-select").getValue();
+	printStat = "";
+	if (printSpec == "first") {
+		printPolicy = DUMP_FIRST;
+	} else if (printSpec == "random") {
+		printPolicy = DUMP_RANDOM;
+	} else if (printSpec.compare(0, 8, "outlier:") == 0 && printSpec.size() > 8) {
+		printPolicy = DUMP_OUTLIER;
+		printStat = printSpec.substr(8);
+	} else {
+		throw TCLAP::CmdLineParseException("Expected first, random, or "
+			"outlier:STAT, found " + printSpec, "(--print-select)");
+	}
+	shapeTolerance = getParam<ValueArg<double> >(cmd, "shape-tolerance").getValue();
+	if (shapeTolerance >= 1.0) {
+		throw TCLAP::CmdLineParseException("Expected a tolerance less than 1", 
+			"(--shape-tolerance)");
+	}
+	noisePool     = getParam<SwitchArg>(cmd, "noise-pool").getValue();
+	streamOffset  = getParam<ValueArg<long> >(cmd, "stream-offset").getValue();
+	packBins      = getParam<ValueArg<long> >(cmd, "pack-bins").getValue();
+	gpBin         = getParam<ValueArg<double> >(cmd, "gp-bin").getValue();
+	// Trial keys are 32-bit counters
+	if (static_cast<double>(streamOffset) + static_cast<double>(nTrials) 
+			> 4294967296.0) {
+		throw TCLAP::CmdLineParseException("Expected an offset of at most "
+			"2^32 minus --ntrials", "(--stream-offset)");
+	}
+	costsFile     = getParam<ValueArg<string> >(cmd, "costs").getValue();
+	tune          = getParam<SwitchArg>(cmd, "tune").getValue();
+	targetError   = getParam<ValueArg<double> >(cmd, "target-error").getValue();
+	sampling      = (getParam<ValueArg<string> >(cmd, "sampling").getValue() == "sobol" 
+		? SAMPLE_SOBOL : SAMPLE_RANDOM);
+	commonRandom  = getParam<SwitchArg>(cmd, "common-random").getValue();
+	saveTrialsFile = getParam<ValueArg<string> >(cmd, "save-trials").getValue();
+	replayFile    = getParam<ValueArg<string> >(cmd, "replay").getValue();
+	resultCache   = getParam<ValueArg<string> >(cmd, "result-cache").getValue();
+	cadenceFiles  = getParam<MultiArg<string> >(cmd, "cadence").getValue();
+	baselines     = getParam<MultiArg<double> >(cmd, "baseline").getValue();
 }
 
 }}	// end lcmc::parse
@@ -2,7 +2,7 @@
  * @file lightcurveMC/cmd/simtype.cpp
  * @author Krzysztof Findeisen
  * @date Created May 29, 2013
- * @date Last modified August 19, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <string>
@@ -49,6 +49,8 @@ void logSimType(CmdLineInterface& cmd) {
 	ValueArg<double>* argNoise = new ValueArg<double>("", "noise", "Gaussian error added to each photometric measurement, in units of the typical source flux. REQUIRES that <date file> is provided.", 
 		false, 0.0, &nonNegReal);
 
+	SwitchArg* argMagnitudes = new SwitchArg("", "magnitudes", "Simulate and analyze light curves in magnitudes. --noise is then Gaussian error in magnitudes, and light curves are never converted to fluxes. REQUIRES that <date file> is provided.");
+
 	ValueArg<string>* argInject = new ValueArg<string>("", "add", 
 		"Name of a text file containing the names of light curves to sample.", 
 		false, "", "file list");
@@ -61,6 +63,7 @@ void logSimType(CmdLineInterface& cmd) {
 	//	argDateFile is already in a xor relationship we'll have to 
 	//	enforce this constraint manually after parsing
 	cmd.add(argNoise);
+	cmd.add(argMagnitudes);
 }
 
 /** Parses the command line parameters that define the simulation
@@ -73,6 +76,8 @@ void logSimType(CmdLineInterface& cmd) {
  * @param[out] isInject True if the program will do an injection analysis, 
  *	and false if it will do a standalone simulation.
  * @param[out] noise The amount of white noise to add to the program.
+ * @param[out] magMode True if the simulation and analysis are to be 
+ *	done in magnitudes, false if in fluxes.
  * 
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	represent the arguments.
@@ -82,11 +87,12 @@ void logSimType(CmdLineInterface& cmd) {
  *	of an exception.
  */
 void parseSimType(CmdLineInterface& cmd, string& cadenceFile, string& catalogFile, 
-		bool& isInject, double& noise) {
+		bool& isInject, double& noise, bool& magMode) {
 	cadenceFile = getParam<UnlabeledValueArg<string> >(cmd, "jdlist").getValue();
 	catalogFile = getParam<ValueArg<string> >(cmd, "add").getValue();
 	isInject    = (catalogFile.size() > 0);
 	noise       = getParam<ValueArg<double> >(cmd, "noise").getValue();
+	magMode     = getParam<SwitchArg>(cmd, "magnitudes").getValue();
 }
 
 }}	// end lcmc::parse
@@ -0,0 +1,507 @@
+/** Measured costs of simulating and analyzing light curves
+ * @file lightcurveMC/costmodel.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include "costmodel.h"
+#include "statparser.h"
+#include "../common/cerror.h"
+#include "../common/fileio.h"
+
+namespace lcmc {
+
+using boost::shared_ptr;
+using std::string;
+using std::vector;
+
+/** Identifies a cost table file, and the version of its format */
+const char* const COST_MAGIC = "lcmc-costs 1";
+
+/** Identifies a tuning table file, and the version of its format */
+const char* const TUNING_MAGIC = "lcmc-tuning 1";
+
+/** Creates an empty table
+ *
+ * @post estimate() returns 0 for every bin.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+CostTable::CostTable() : costs() {
+}
+
+/** Replaces the table with one written by write()
+ *
+ * @param[in] fileName The file to read.
+ *
+ * @return True if @p fileName exists, false if it does not, in which 
+ *	case the table is unchanged.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be read, or is not a cost table.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the table.
+ *
+ * @exceptsafe The table is unchanged in the event of an exception.
+ */
+bool CostTable::read(const string& fileName) {
+	FILE* const rawFile = fopen(fileName.c_str(), "r");
+	if (rawFile == NULL) {
+		return false;
+	}
+	shared_ptr<FILE> file(rawFile, &fclose);
+	
+	char magic[32];
+	if (fgets(magic, sizeof(magic), file.get()) == NULL 
+			|| string(magic) != string(COST_MAGIC) + "\n") {
+		throw kpfutils::except::FileIo(fileName + " is not a cost table.");
+	}
+	
+	std::map<Key, Cost> temp;
+	char bin[256], stats[256];
+	long nEpochs, nTrials;
+	double seconds;
+	int status;
+	// Bin labels may contain spaces, so fields are separated by tabs
+	while ((status = fscanf(file.get(), "%255[^\t\n]\t%255[^\t\n]\t%ld\t%ld\t%lg\n", 
+			bin, stats, &nEpochs, &nTrials, &seconds)) == 5) {
+		if (nEpochs < 0 || nTrials <= 0 || !(seconds >= 0.0)) {
+			break;
+		}
+		temp[Key(std::make_pair(string(bin), string(stats)), nEpochs)] 
+			= Cost(nTrials, seconds);
+	}
+	if (status != EOF || ferror(file.get())) {
+		throw kpfutils::except::FileIo("Misformatted cost table " 
+			+ fileName + ".");
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	costs.swap(temp);
+	return true;
+}
+
+/** Saves the table to a file
+ *
+ * @param[in] fileName The file to write. It is replaced only once 
+ *	the new table has been written in full.
+ *
+ * @post read(@p fileName) restores the table.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be written.
+ *
+ * @exceptsafe The table is unchanged in the event of an exception. 
+ *	@p fileName is unchanged unless the new table was written.
+ */
+void CostTable::write(const string& fileName) const {
+	const string tempName = fileName + ".tmp";
+	{
+		shared_ptr<FILE> file = kpfutils::fileCheckOpen(tempName, "w");
+		
+		if (fprintf(file.get(), "%s\n", COST_MAGIC) < 0) {
+			kpfutils::fileError(file.get(), "Could not write cost table " + tempName + ": ");
+		}
+		for(std::map<Key, Cost>::const_iterator it = costs.begin(); 
+				it != costs.end(); it++) {
+			if (fprintf(file.get(), "%s\t%s\t%ld\t%ld\t%.6g\n", 
+					it->first.first.first.c_str(), 
+					it->first.first.second.c_str(), it->first.second, 
+					it->second.first, it->second.second) < 0) {
+				kpfutils::fileError(file.get(), "Could not write cost table " + tempName + ": ");
+			}
+		}
+		
+		if (fflush(file.get()) != 0) {
+			kpfutils::fileError(file.get(), "Could not write cost table " + tempName + ": ");
+		}
+	}
+	
+	if (rename(tempName.c_str(), fileName.c_str()) != 0) {
+		throw kpfutils::except::FileIo("Could not replace cost table " + fileName + ".");
+	}
+}
+
+/** Records the measured cost of a bin
+ *
+ * @param[in] bin The label of the bin, as given by 
+ *	stats::LcBinStats::makeFileName().
+ * @param[in] stats The statistics calculated, as given by statKey().
+ * @param[in] nEpochs The number of epochs in each light curve.
+ * @param[in] nTrials The number of light curves measured.
+ * @param[in] seconds The wall time one process took for all 
+ *	@p nTrials light curves.
+ *
+ * @post estimate(@p bin, @p stats, @p nEpochs) returns 
+ *	@p seconds / @p nTrials. Earlier measurements of the same bin 
+ *	are forgotten, so that the table follows changes in hardware 
+ *	and settings.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the cost.
+ *
+ * @exceptsafe The table is unchanged in the event of an exception.
+ *
+ * @note Does nothing if @p nTrials &le; 0.
+ */
+void CostTable::record(const string& bin, const string& stats, 
+		long nEpochs, long nTrials, double seconds) {
+	if (nTrials > 0) {
+		costs[Key(std::make_pair(bin, stats), nEpochs)] 
+			= Cost(nTrials, seconds);
+	}
+}
+
+/** Predicts the cost of one light curve in a bin
+ *
+ * If the table has no entry for @p nEpochs, the entry for the same 
+ * bin and statistics with the nearest number of epochs 
+ * is scaled by the square of the ratio of epochs, since the 
+ * slowest statistics compare every pair of epochs.
+ *
+ * @param[in] bin The label of the bin, as given by 
+ *	stats::LcBinStats::makeFileName().
+ * @param[in] stats The statistics calculated, as given by statKey().
+ * @param[in] nEpochs The number of epochs in each light curve.
+ *
+ * @return The expected wall time, in seconds, that one process will 
+ *	take per light curve, or 0 if nothing similar has been recorded.
+ *
+ * @perform O(M) time, where M is the number of entries in the table.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double CostTable::estimate(const string& bin, const string& stats, 
+		long nEpochs) const {
+	const std::pair<string, string> kind(bin, stats);
+	
+	const Cost* nearest = NULL;
+	long nearestEpochs = 0;
+	for(std::map<Key, Cost>::const_iterator it = costs.begin(); 
+			it != costs.end(); it++) {
+		if (it->first.first == kind && (nearest == NULL 
+				|| labs(it->first.second - nEpochs) < labs(nearestEpochs - nEpochs))) {
+			nearest = &(it->second);
+			nearestEpochs = it->first.second;
+		}
+	}
+	if (nearest == NULL) {
+		return 0.0;
+	}
+	
+	const double perTrial = nearest->second / static_cast<double>(nearest->first);
+	if (nearestEpochs == nEpochs || nearestEpochs <= 0) {
+		return perTrial;
+	} else {
+		const double ratio = static_cast<double>(nEpochs) 
+			/ static_cast<double>(nearestEpochs);
+		return perTrial * ratio * ratio;
+	}
+}
+
+/** Names a list of statistics for use as a CostTable key
+ *
+ * @param[in] stats The statistics calculated by a run.
+ *
+ * @return The command-line names of @p stats, in order, joined by 
+ *	"+", or "none" if @p stats is empty.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	build the name.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of 
+ *	an exception.
+ */
+string statKey(const vector<stats::StatType>& stats) {
+	const vector<string> names = parse::statTypes();
+	
+	string key;
+	for(vector<stats::StatType>::const_iterator it = stats.begin(); 
+			it != stats.end(); it++) {
+		for(vector<string>::const_iterator name = names.begin(); 
+				name != names.end(); name++) {
+			if (parse::parseStat(*name) == *it) {
+				if (!key.empty()) {
+					key += "+";
+				}
+				key += *name;
+				break;
+			}
+		}
+	}
+	return (key.empty() ? "none" : key);
+}
+
+/** Chooses the settings used without --tune
+ *
+ * @post batchFactor = 16, which amortizes the cost of starting the 
+ *	threads without using much memory, and statThreads = 1.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+Tuning::Tuning() : batchFactor(16), statThreads(1) {
+}
+
+/** Chooses specific settings
+ *
+ * @param[in] batchFactor The light curves in each batch, per analysis 
+ *	thread.
+ * @param[in] statThreads The threads calculating the statistics of 
+ *	each light curve.
+ *
+ * @pre @p batchFactor &gt; 0
+ * @pre @p statThreads &gt; 0
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+Tuning::Tuning(long batchFactor, long statThreads) 
+		: batchFactor(batchFactor), statThreads(statThreads) {
+}
+
+/** Creates an empty table
+ *
+ * @post find() fails for every run.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+TuningTable::TuningTable() : choices() {
+}
+
+/** Replaces the table with one written by write()
+ *
+ * @param[in] fileName The file to read.
+ *
+ * @return True if @p fileName exists, false if it does not, in which 
+ *	case the table is unchanged.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be read, or is not a tuning table.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the table.
+ *
+ * @exceptsafe The table is unchanged in the event of an exception.
+ */
+bool TuningTable::read(const string& fileName) {
+	FILE* const rawFile = fopen(fileName.c_str(), "r");
+	if (rawFile == NULL) {
+		return false;
+	}
+	shared_ptr<FILE> file(rawFile, &fclose);
+	
+	char magic[32];
+	if (fgets(magic, sizeof(magic), file.get()) == NULL 
+			|| string(magic) != string(TUNING_MAGIC) + "\n") {
+		throw kpfutils::except::FileIo(fileName + " is not a tuning table.");
+	}
+	
+	std::map<string, Tuning> temp;
+	char key[512];
+	long batchFactor, statThreads;
+	int status;
+	while ((status = fscanf(file.get(), "%511[^\t\n]\t%ld\t%ld\n", 
+			key, &batchFactor, &statThreads)) == 3) {
+		if (batchFactor <= 0 || statThreads <= 0) {
+			break;
+		}
+		temp[string(key)] = Tuning(batchFactor, statThreads);
+	}
+	if (status != EOF || ferror(file.get())) {
+		throw kpfutils::except::FileIo("Misformatted tuning table " 
+			+ fileName + ".");
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	choices.swap(temp);
+	return true;
+}
+
+/** Saves the table to a file
+ *
+ * @param[in] fileName The file to write. It is replaced only once 
+ *	the new table has been written in full.
+ *
+ * @post read(@p fileName) restores the table.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be written.
+ *
+ * @exceptsafe The table is unchanged in the event of an exception. 
+ *	@p fileName is unchanged unless the new table was written.
+ */
+void TuningTable::write(const string& fileName) const {
+	const string tempName = fileName + ".tmp";
+	{
+		shared_ptr<FILE> file = kpfutils::fileCheckOpen(tempName, "w");
+		
+		if (fprintf(file.get(), "%s\n", TUNING_MAGIC) < 0) {
+			kpfutils::fileError(file.get(), "Could not write tuning table " + tempName + ": ");
+		}
+		for(std::map<string, Tuning>::const_iterator it = choices.begin(); 
+				it != choices.end(); it++) {
+			if (fprintf(file.get(), "%s\t%ld\t%ld\n", it->first.c_str(), 
+					it->second.batchFactor, it->second.statThreads) < 0) {
+				kpfutils::fileError(file.get(), "Could not write tuning table " + tempName + ": ");
+			}
+		}
+		
+		if (fflush(file.get()) != 0) {
+			kpfutils::fileError(file.get(), "Could not write tuning table " + tempName + ": ");
+		}
+	}
+	
+	if (rename(tempName.c_str(), fileName.c_str()) != 0) {
+		throw kpfutils::except::FileIo("Could not replace tuning table " + fileName + ".");
+	}
+}
+
+/** Records the fastest settings for a run
+ *
+ * @param[in] key The run, as given by tuningKey().
+ * @param[in] best The settings found fastest for @p key.
+ *
+ * @post find(@p key) returns @p best. Earlier settings for @p key are 
+ *	forgotten.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the settings.
+ *
+ * @exceptsafe The table is unchanged in the event of an exception.
+ */
+void TuningTable::record(const string& key, const Tuning& best) {
+	choices[key] = best;
+}
+
+/** Looks up the fastest settings for a run
+ *
+ * @param[in] key The run, as given by tuningKey().
+ * @param[out] best The settings last recorded for @p key.
+ *
+ * @return True if settings were recorded for @p key, false otherwise, 
+ *	in which case @p best is unchanged.
+ *
+ * @perform O(log M) time, where M is the number of entries in the table.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool TuningTable::find(const string& key, Tuning& best) const {
+	const std::map<string, Tuning>::const_iterator it = choices.find(key);
+	if (it == choices.end()) {
+		return false;
+	}
+	best = it->second;
+	return true;
+}
+
+/** Names a run for use as a TuningTable key
+ *
+ * The fastest settings depend on the hardware as well as on the work, 
+ * so the key includes the name of the host.
+ *
+ * @param[in] times The cadence of the run.
+ * @param[in] stats The statistics calculated, as given by statKey().
+ * @param[in] nThreads The number of analysis threads.
+ *
+ * @return A name, without tabs or line breaks, that is the same for 
+ *	runs on the same host with equal cadences, statistics, and threads.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	build the name.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of 
+ *	an exception.
+ */
+string tuningKey(const models::Cadence& times, const string& stats, 
+		long nThreads) {
+	char host[256];
+	if (gethostname(host, sizeof(host)) != 0) {
+		strcpy(host, "unknown");
+	}
+	host[sizeof(host) - 1] = '\0';
+	
+	const boost::uint64_t hash = times.getHash();
+	char cadence[32];
+	sprintf(cadence, "%08lx%08lx", 
+		static_cast<unsigned long>((hash >> 32) & 0xffffffffUL), 
+		static_cast<unsigned long>( hash        & 0xffffffffUL));
+	
+	return string(host) + " " + cadence + " " + stats + " " 
+		+ boost::lexical_cast<string>(nThreads);
+}
+
+/** Lists the settings that --tune compares
+ *
+ * @param[in] maxStatThreads The most threads to try for the statistics 
+ *	of each light curve.
+ *
+ * @return Every combination of 8, 16, or 32 light curves per analysis 
+ *	thread in a batch with 1, 2, 4, ... or @p maxStatThreads statistic 
+ *	threads. The settings used without --tune, with @p maxStatThreads 
+ *	statistic threads, come first.
+ *
+ * @pre @p maxStatThreads &gt; 0
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	build the list.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of 
+ *	an exception.
+ */
+vector<Tuning> tuningCandidates(long maxStatThreads) {
+	const Tuning defaults(Tuning().batchFactor, maxStatThreads);
+	
+	vector<long> statThreads;
+	for(long n = 1; n < maxStatThreads; n *= 2) {
+		statThreads.push_back(n);
+	}
+	statThreads.push_back(maxStatThreads);
+	
+	vector<Tuning> candidates(1, defaults);
+	for(long batchFactor = 8; batchFactor <= 32; batchFactor *= 2) {
+		for(vector<long>::const_iterator it = statThreads.begin(); 
+				it != statThreads.end(); it++) {
+			if (batchFactor != defaults.batchFactor 
+					|| *it != defaults.statThreads) {
+				candidates.push_back(Tuning(batchFactor, *it));
+			}
+		}
+	}
+	return candidates;
+}
+
+}		// end lcmc
@@ -0,0 +1,147 @@
+/** Measured costs of simulating and analyzing light curves
+ * @file lightcurveMC/costmodel.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCCOSTMODELH
+#define LCMCCOSTMODELH
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "binstats.h"
+#include "cadence.h"
+
+namespace lcmc {
+
+/** CostTable remembers how long one process took per light curve for 
+ * each kind of bin, so that later runs can plan their work before 
+ * measuring it.
+ *
+ * Costs are keyed by the bin (its light curve type, parameter ranges, 
+ * and noise), the statistics calculated, and the number of epochs per 
+ * light curve. A table is calibrated by 
+ * any run that records its bins, and kept up to date by later runs.
+ */
+class CostTable {
+public:
+	/** Creates an empty table
+	 */
+	CostTable();
+	
+	/** Replaces the table with one written by write()
+	 */
+	bool read(const std::string& fileName);
+	
+	/** Saves the table to a file
+	 */
+	void write(const std::string& fileName) const;
+	
+	/** Records the measured cost of a bin
+	 */
+	void record(const std::string& bin, const std::string& stats, 
+		long nEpochs, long nTrials, double seconds);
+	
+	/** Predicts the cost of one light curve in a bin
+	 */
+	double estimate(const std::string& bin, const std::string& stats, 
+		long nEpochs) const;
+	
+private:
+	/** Bin, statistics, and number of epochs */
+	typedef std::pair<std::pair<std::string, std::string>, long> Key;
+	/** Number of light curves and the seconds they took */
+	typedef std::pair<long, double> Cost;
+	
+	std::map<Key, Cost> costs;
+};
+
+/** Names a list of statistics for use as a CostTable key
+ */
+std::string statKey(const std::vector<stats::StatType>& stats);
+
+/** Tuning holds the settings of a run that may be changed without 
+ * changing its results.
+ */
+struct Tuning {
+	/** Chooses the settings used without --tune
+	 */
+	Tuning();
+	
+	/** Chooses specific settings
+	 */
+	Tuning(long batchFactor, long statThreads);
+	
+	/** The light curves in each batch, per analysis thread */
+	long batchFactor;
+	/** The threads calculating the statistics of each light curve */
+	long statThreads;
+};
+
+/** TuningTable remembers the fastest Tuning found for each cadence and 
+ * host, so that later runs need not measure it again.
+ */
+class TuningTable {
+public:
+	/** Creates an empty table
+	 */
+	TuningTable();
+	
+	/** Replaces the table with one written by write()
+	 */
+	bool read(const std::string& fileName);
+	
+	/** Saves the table to a file
+	 */
+	void write(const std::string& fileName) const;
+	
+	/** Records the fastest settings for a run
+	 */
+	void record(const std::string& key, const Tuning& best);
+	
+	/** Looks up the fastest settings for a run
+	 */
+	bool find(const std::string& key, Tuning& best) const;
+	
+private:
+	std::map<std::string, Tuning> choices;
+};
+
+/** Names a run for use as a TuningTable key
+ */
+std::string tuningKey(const models::Cadence& times, const std::string& stats, 
+	long nThreads);
+
+/** Lists the settings that --tune compares
+ */
+std::vector<Tuning> tuningCandidates(long maxStatThreads);
+
+}		// end lcmc
+
+#endif		// end LCMCCOSTMODELH
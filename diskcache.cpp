@@ -0,0 +1,302 @@
+/** Size-limited cache directory shared by runs
+ * @file lightcurveMC/diskcache.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "diskcache.h"
+
+namespace lcmc { namespace utils {
+
+using boost::shared_ptr;
+using boost::uint64_t;
+using std::string;
+using std::vector;
+
+/** The prefixes of the files that the program saves in a cache 
+ *	directory. Other files in the directory are never evicted.
+ */
+const char* const CACHE_PREFIXES[] = {"covfactor_", "lsthresh_", "cadence_"};
+
+/** Returns the size limit of the cache directory
+ *
+ * @return A modifiable limit, in bytes.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint64_t& diskCacheLimit() {
+	// 4 GiB by default
+	static uint64_t limit = static_cast<uint64_t>(4096) << 20;
+	return limit;
+}
+
+/** Serializes evictions by the threads of this process
+ *
+ * @return The lock to hold while scanning the cache directory.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::mutex& evictionLock() {
+	static boost::mutex lock;
+	return lock;
+}
+
+/** Sets the largest total size of the files in a cache directory
+ *
+ * @param[in] bytes The most space, in bytes, that the files saved 
+ *	by the program may take up in the cache directory.
+ *
+ * @post Subsequent calls to commitCacheFile() delete the least 
+ *	recently used files until the cache fits in @p bytes.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any files are cached.
+ */
+void setDiskCacheLimit(uint64_t bytes) {
+	diskCacheLimit() = bytes;
+}
+
+/** Returns the limit chosen with setDiskCacheLimit()
+ *
+ * @return The most space, in bytes, that the cache may take up. 
+ *	4 GiB if setDiskCacheLimit() was never called.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint64_t getDiskCacheLimit() {
+	return diskCacheLimit();
+}
+
+/** Creates a uniquely named temporary file next to a cache file
+ *
+ * The name is chosen by mkstemp(), so that threads and processes 
+ * saving the same file at once never write to the same temporary file.
+ *
+ * @param[in] dir The cache directory. Created if it does not exist.
+ * @param[in] fileName The name the file will have once it is complete.
+ * @param[out] tempName The name of the temporary file.
+ *
+ * @return A handle to the new file, open for binary writing, or a 
+ *	null handle if the file could not be created.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the names.
+ *
+ * @exceptsafe @p tempName is unchanged in the event of an exception 
+ *	or if the file could not be created.
+ */
+shared_ptr<FILE> openCacheTemp(const string& dir, const string& fileName, 
+		string& tempName) {
+	// Fails harmlessly if the directory already exists
+	mkdir(dir.c_str(), 0777);
+	
+	// mkstemp() needs a writable copy of the name
+	string name = fileName + ".tmpXXXXXX";
+	const int fd = mkstemp(&name[0]);
+	if (fd < 0) {
+		return shared_ptr<FILE>();
+	}
+	// mkstemp() leaves the file readable only by its owner
+	fchmod(fd, 0644);
+	
+	FILE* const rawFile = fdopen(fd, "wb");
+	if (rawFile == NULL) {
+		close(fd);
+		remove(name.c_str());
+		return shared_ptr<FILE>();
+	}
+	shared_ptr<FILE> file;
+	try {
+		file = shared_ptr<FILE>(rawFile, &fclose);
+	} catch (const std::bad_alloc& e) {
+		// shared_ptr has already closed the file
+		remove(name.c_str());
+		throw;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	tempName.swap(name);
+	return file;
+}
+
+/** Describes a file in the cache directory
+ */
+struct CachedFile {
+	/** Describes a file
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	to store the name.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	CachedFile(const string& name, time_t lastUse, uint64_t size) 
+			: name(name), lastUse(lastUse), size(size) {
+	}
+	
+	/** Orders files from least to most recently used
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool operator<(const CachedFile& other) const {
+		return lastUse < other.lastUse;
+	}
+	
+	string name;
+	time_t lastUse;
+	uint64_t size;
+};
+
+/** Tests whether a file in the cache directory was saved by the program
+ *
+ * @param[in] name The name of the file, without the directory.
+ *
+ * @return True if the file is a completed cache file, false if it is 
+ *	unrelated or still being written.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool isCacheFile(const char* name) {
+	if (strstr(name, ".tmp") != NULL) {
+		return false;
+	}
+	const size_t nPrefixes = sizeof(CACHE_PREFIXES)/sizeof(CACHE_PREFIXES[0]);
+	for(size_t i = 0; i < nPrefixes; i++) {
+		if (strncmp(name, CACHE_PREFIXES[i], strlen(CACHE_PREFIXES[i])) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Deletes the least recently used files until a cache directory is 
+ *	within its limit
+ *
+ * @param[in] dir The cache directory.
+ *
+ * @post The files saved by the program in @p dir take up at most 
+ *	getDiskCacheLimit() bytes, unless another process added files 
+ *	in the meantime.
+ *
+ * @perform O(F log F) time, where F is the number of files in @p dir.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	list the directory.
+ *
+ * @exceptsafe Files may have been deleted in the event of an exception.
+ */
+void evictCacheFiles(const string& dir) {
+	boost::mutex::scoped_lock guard(evictionLock());
+	
+	DIR* const rawDir = opendir(dir.c_str());
+	if (rawDir == NULL) {
+		return;
+	}
+	shared_ptr<DIR> listing(rawDir, &closedir);
+	
+	vector<CachedFile> files;
+	uint64_t total = 0;
+	while (const struct dirent* entry = readdir(listing.get())) {
+		if (!isCacheFile(entry->d_name)) {
+			continue;
+		}
+		const string name = dir + "/" + entry->d_name;
+		struct stat info;
+		if (stat(name.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+			files.push_back(CachedFile(name, info.st_mtime, 
+				static_cast<uint64_t>(info.st_size)));
+			total += static_cast<uint64_t>(info.st_size);
+		}
+	}
+	
+	std::sort(files.begin(), files.end());
+	for(vector<CachedFile>::const_iterator it = files.begin(); 
+			it != files.end() && total > getDiskCacheLimit(); it++) {
+		// Memory-mapped copies stay valid after the file is deleted
+		if (remove(it->name.c_str()) == 0) {
+			total -= it->size;
+		}
+	}
+}
+
+/** Moves a finished temporary file into place, evicting old files if 
+ *	the cache is over its limit
+ *
+ * Failure to save the file is not an error, since cached files can 
+ * always be recalculated.
+ *
+ * @param[in] dir The cache directory.
+ * @param[in] tempName The file created by openCacheTemp(), which must 
+ *	be closed.
+ * @param[in] fileName The name the file should have.
+ *
+ * @post @p fileName holds the contents of @p tempName, unless it was 
+ *	larger than the cache limit. @p tempName no longer exists.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void commitCacheFile(const string& dir, const string& tempName, 
+		const string& fileName) {
+	if (rename(tempName.c_str(), fileName.c_str()) != 0) {
+		remove(tempName.c_str());
+		return;
+	}
+	try {
+		evictCacheFiles(dir);
+	} catch (const std::exception& e) {
+		// Eviction is retried by the next save
+	}
+}
+
+/** Records that a cache file was used, so that it is evicted last
+ *
+ * @param[in] fileName The file that was read.
+ *
+ * @post The modification time of @p fileName is the current time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void touchCacheFile(const string& fileName) {
+	// Access times are unreliable on many file systems
+	utime(fileName.c_str(), NULL);
+}
+
+}}		// end lcmc::utils
@@ -0,0 +1,65 @@
+/** Size-limited cache directory shared by runs
+ * @file lightcurveMC/diskcache.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCDISKCACHEH
+#define LCMCDISKCACHEH
+
+#include <string>
+#include <cstdio>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace lcmc { namespace utils {
+
+/** Sets the largest total size of the files in a cache directory
+ */
+void setDiskCacheLimit(boost::uint64_t bytes);
+
+/** Returns the limit chosen with setDiskCacheLimit()
+ */
+boost::uint64_t getDiskCacheLimit();
+
+/** Creates a uniquely named temporary file next to a cache file
+ */
+boost::shared_ptr<FILE> openCacheTemp(const std::string& dir, 
+		const std::string& fileName, std::string& tempName);
+
+/** Moves a finished temporary file into place, evicting old files if 
+ *	the cache is over its limit
+ */
+void commitCacheFile(const std::string& dir, const std::string& tempName, 
+		const std::string& fileName);
+
+/** Records that a cache file was used, so that it is evicted last
+ */
+void touchCacheFile(const std::string& fileName);
+
+}}		// end lcmc::utils
+
+#endif		// end LCMCDISKCACHEH
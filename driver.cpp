@@ -2,7 +2,7 @@
  * @file lightcurveMC/driver.cpp
  * @author Krzysztof Findeisen
  * @date Created January 22, 2010
- * @date Last modified May 26, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,18 +27,60 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include <cmath>
 #include <cstdio>
-#include <boost/lexical_cast.hpp>	// dump only
+#include <ctime>
+#include <sys/stat.h>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <tclap/ArgException.h>
 #include "binstats.h"
+#include "cachestats.h"
+#include "checkpoint.h"
+#include "costmodel.h"
+#include "diskcache.h"
+#include "../common/cerror.h"
+#include "../common/nan.h"
+#include "largealloc.tmp.h"
 #include "lightcurvetypes.h"
 #include "mcio.h"			// dump only
+#include "mpidriver.h"
+#include "noisepool.h"
+#include "numa.h"
 #include "paramlist.h"
+#include "progress.h"
+#include "resultcache.h"
+#include "rngstream.h"
 #include "except/parse.h"
+#include "fluxmag.h"
+#include "jobserver.h"
+#include "lcdump.h"
 #include "sims.h"
+#include "stats/columns.h"
+#include "stats/deadline.h"
+#include "stats/devicestats.h"
+#include "stats/gpfit.h"
+#include "stats/lsthreshold.h"
+#include "stats/output.h"
+#include "stats/profile.h"
+#include "stats/quantilesketch.h"
+#include "stats/scargleacf.h"
+#include "stats/statcollect.h"
+#include "stats/statfamilies.h"
+#include "stats/trace.h"
+#include "waves/generators.h"
+#include "waves/lightcurves_gp.h"
+#include "waves/lightcurves_periodic.h"
+#include "ziparchive.h"
+#include "trialarchive.h"
+#include "trialpool.h"
 
 using namespace lcmc;
 using std::string;
@@ -56,12 +98,31 @@ namespace parse {
 /** Converts the input arguments to a set of variables.
  */
 void parseArguments(int argc, char* argv[], 
-	double& sigma, long& nTrials, long& toPrint, 
+	double& sigma, long& nTrials, long& toPrint, long& nThreads, long& seed, 
+	bool& storeDistribs, bool& storeCurves, long& sketchSize, bool& printQuantiles, bool& floatCurves, 
+	stats::DistribFormat& distribFormat, 
+	bool& compressDistribs, string& archiveFile, bool& archiveCompress, 
+	stats::PeriodogramMethod& pgramMethod, bool& floatPgram, 
+	stats::ScargleAcfMethod& sacfMethod, stats::PeakMethod& peakMethod, 
+	string& cacheDir, double& cacheLimit, utils::CovarFactor& gpFactor, long& tauGrid, long& gpOrder, long& gpRank, 
+	double& gpSeasons, double& gpSparse, stats::GpFitMethod& gpFit, string& gpPlugin, long& rWorkers, stats::GpStart& gpStart, 
+	double& statBudget, long& statThreads, bool& profile, bool& profileCounters, 
+	bool& cacheReport, double& progressInterval, 
+	string& traceFile, long& traceEvents, bool& memoryReport, 
+	double& memoryLimit, long& flushEvery, string& checkpointFile, 
+	bool& resume, long& shard, long& nShards, long& merge, 
+	long& pipelineDepth, bool& numa, bool& hugePages, bool& gpuStats, DumpPolicy& printPolicy, string& printStat, 
+	double& shapeTolerance, bool& noisePool, long& streamOffset, 
+	long& packBins, double& gpBin, string& costsFile, bool& tune, double& targetError, 
+	ParamSampling& sampling, bool& commonRandom, 
+	string& saveTrialsFile, string& replayFile, string& resultCache, 
+	vector<string>& cadenceFiles, vector<double>& baselines, 
 	models::RangeList& paramRanges, 
+	vector<models::RangeList>& paramGrid, 
 	string& jdList, vector<string>& lcNameList, 
 	vector<models::LightCurveType>& lcList, 
 	vector< stats::      StatType>& statList, 
-	string& dataSet, bool& injectMode);
+	string& dataSet, bool& injectMode, bool& magMode);
 
 }}	// end lcmc::parse
 
@@ -69,10 +130,14 @@ void parseArguments(int argc, char* argv[],
  * 
  * @param[in] injectMode If true, program is being run in injection mode. 
  *	If false, program is being run in noisy simulation mode.
+ * @param[in] magMode If true, @p noiseAmp is in magnitudes rather 
+ *	than flux units.
  * @param[in] The name of the catalog file, if any.
  * @param[in] The amplitude of the noise, if any.
  *
- * @return A string representation of (injectMode ? catName : noiseAmp)
+ * @return A string representation of (injectMode ? catName : noiseAmp). 
+ *	Noise in magnitudes is followed by <tt>mag</tt>, so that runs in 
+ *	the two units never write to the same files.
  *
  * @exception std::runtime_error Thrown if a string representation could not 
  *	be constructed.
@@ -82,7 +147,7 @@ void parseArguments(int argc, char* argv[],
  * @exceptsafe The function arguments are unchanged in the event 
  *	of an exception.
  */
-string noiseDesc(bool injectMode, string catName, double noiseAmp) {
+string noiseDesc(bool injectMode, bool magMode, string catName, double noiseAmp) {
 	string noiseStr;
 	
 	if (injectMode) {
@@ -93,83 +158,1692 @@ string noiseDesc(bool injectMode, string catName, double noiseAmp) {
 			throw std::runtime_error("Could not format bin name.");
 		}
 		noiseStr = noiseBuf;
+		if (magMode) {
+			noiseStr += "mag";
+		}
 	}
 	
 	return noiseStr;
 }
 
+/** Generates a simulated light curve, incorporating all the simulation settings
+ * 
+ * @param[in] curve The type of light curve to simulate.
+ * @param[in] limits The ranges from which to draw the light curve parameters.
+ * @param[in] injectMode If true, the light curve is injected into an observed 
+ *	light curve from @p injectCat. If false, it is sampled at the times 
+ *	in @p simTimes and white noise of amplitude @p sigma is added.
+ * @param[in] injectCat The catalog of light curves to use in injection mode.
+ * @param[in] simTimes The time stamps to use in simulation mode.
+ * @param[in] sigma The amplitude of the white noise to use in simulation mode.
+ * @param[in] magMode If true and not in injection mode, @p sigma is in 
+ *	magnitudes and @p trial is simulated and analyzed in magnitudes.
+ * @param[out] trial The simulated light curve and the parameters used to 
+ *	generate it.
+ *
+ * @post All random numbers needed by @p trial have been drawn, but its 
+ *	fluxes are not computed until finishTrials() is called.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	simulate the light curve.
+ * @exception std::runtime_error Thrown if the light curve could not be 
+ *	generated.
+ *
+ * @exceptsafe The function arguments are in a valid state in the event 
+ *	of an exception.
+ */
+void simTrial(const models::LightCurveType& curve, const models::RangeList& limits, 
+		bool injectMode, const string& injectCat, const models::Cadence& simTimes, 
+		double sigma, bool magMode, SimTrial& trial) {
+	// Set up noise or injection tests
+	// Injections add the catalog's copy of the observed light curve, 
+	//	rather than copying it into each trial
+	vector<double> noise;
+	boost::shared_ptr<const vector<double> > base;
+	{
+		const stats::TraceSpan span("make noise");
+		if (injectMode) {
+			makeInjectBase(injectCat, trial.times, base);
+		} else {
+			trial.times = simTimes;
+			makeWhiteNoise(trial.times.timeView(), sigma, noise);
+		}
+	}
+	
+	{
+		const stats::TraceSpan span("draw params");
+		trial.params = drawParams(limits);
+	}
+
+	// Generate the light curve, but leave the fluxes for finishTrials()
+	const stats::TraceSpan span("make model");
+	std::auto_ptr<models::ILightCurve> model = makeLightCurve(curve, 
+		trial.params, trial.times);
+	trial.model.reset(model.release());
+	trial.noise.swap(noise);
+	trial.base.swap(base);
+	trial.units = (magMode && !injectMode ? utils::MAG_UNITS : utils::FLUX_UNITS);
+}
+
+/** Computes the fluxes of a batch of light curves created by simTrial()
+ * 
+ * Gaussian processes with the same covariance matrix are computed 
+ * together with models::GaussianProcess::solveBatch(), which needs 
+ * one matrix-matrix product per run of consecutive trials rather 
+ * than one matrix-vector product per trial.
+ * 
+ * @param[in,out] trials The light curves to compute.
+ *
+ * @post For each element of @p trials, @p fluxes contains the simulated 
+ *	light curve in the trial's units, and @p model, @p noise, and 
+ *	@p base are empty.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the light curves.
+ * @exception std::logic_error Thrown if a bug is found in the flux 
+ *	calculations.
+ *
+ * @exceptsafe The function arguments are in a valid state in the event 
+ *	of an exception.
+ */
+void finishTrials(vector<SimTrial>& trials) {
+	vector<const models::GaussianProcess*> gps;
+	for(vector<SimTrial>::const_iterator it = trials.begin(); 
+			it != trials.end(); it++) {
+		const models::GaussianProcess* const gp = 
+			dynamic_cast<const models::GaussianProcess*>(it->model.get());
+		if (gp != NULL) {
+			gps.push_back(gp);
+		}
+	}
+	{
+		const stats::TraceSpan span("sample batch");
+		models::GaussianProcess::solveBatch(gps);
+	}
+	
+	for(vector<SimTrial>::iterator it = trials.begin(); 
+			it != trials.end(); it++) {
+		if (it->model.get() != NULL) {
+			const stats::TraceSpan span("sample");
+			const vector<double>& noise = (it->base ? *(it->base) : it->noise);
+			if (it->units == utils::MAG_UNITS) {
+				finishLightCurveMags(*(it->model), noise, it->fluxes);
+			} else {
+				finishLightCurve(*(it->model), noise, it->fluxes);
+			}
+			it->model.reset();
+			vector<double>().swap(it->noise);
+			it->base.reset();
+		}
+	}
+}
+
+/** Generates a block of consecutive trials of one light curve type
+ * 
+ * @param[in] curve The type of light curve to simulate.
+ * @param[in] streamIndex The key for the random numbers of each trial; 
+ *	usually the position of @p curve in the run.
+ * @param[in] limits, injectMode, injectCat, simTimes, sigma, magMode 
+ *	The simulation settings, as for simTrial().
+ * @param[in] seed The seed of the run, or a negative number if the 
+ *	trials don't use utils::TrialStreams.
+ * @param[in] streamOffset The number added to each trial's index to 
+ *	key its streams.
+ * @param[in] first The index of the first trial to generate.
+ * @param[in,out] batch The trials to generate. Element @p i is 
+ *	replaced by trial @p first + @p i.
+ *
+ * @post Every element of @p batch is ready for finishTrials(). If 
+ *	@p seed &ge; 0, each trial's random numbers depend only on @p seed, 
+ *	@p streamIndex, and the trial's index plus @p streamOffset.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	simulate the light curves.
+ * @exception std::runtime_error Thrown if a light curve could not be 
+ *	generated.
+ *
+ * @exceptsafe The function arguments are in a valid state in the event 
+ *	of an exception.
+ */
+void simTrials(const models::LightCurveType& curve, long streamIndex, 
+		const models::RangeList& limits, bool injectMode, 
+		const string& injectCat, const models::Cadence& simTimes, double sigma, 
+		bool magMode, long seed, long streamOffset, long first, 
+		vector<SimTrial>& batch) {
+	for(size_t i = 0; i < batch.size(); i++) {
+		// Keyed streams make each trial's random 
+		//	numbers independent of all other trials
+		boost::scoped_ptr<utils::TrialStreams> streams;
+		if (seed >= 0) {
+			streams.reset(new utils::TrialStreams(seed, streamIndex, 
+				streamOffset + first + static_cast<long>(i)));
+		}
+		simTrial(curve, limits, injectMode, injectCat, simTimes, sigma, 
+			magMode, batch[i]);
+	}
+}
+
+/** BatchFinisher does the bookkeeping for each batch of analyzed light 
+ * curves: it updates the progress meter, writes out the statistics 
+ * when they grow too large, and offers the light curves for printing.
+ *
+ * A BatchFinisher only refers to its state, so copies of it (such as 
+ * those made by TrialPipeline) all update the same bin.
+ */
+class BatchFinisher {
+public:
+	/** Defines the bookkeeping for one bin
+	 *
+	 * @param[in,out] curBin The statistics of the bin.
+	 * @param[in,out] progress The progress meter for the run.
+	 * @param[in,out] saved The progress to record in @p checkpointFile.
+	 * @param[in,out] unflushed The number of light curves analyzed 
+	 *	since @p curBin was last written out.
+	 * @param[in] memoryLimit, flushEvery, checkpointFile The 
+	 *	settings of --memory-limit, --flush-every, and --checkpoint.
+	 * @param[in,out] dumper The light curves of the bin to print.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	BatchFinisher(LcBinStats& curBin, ProgressMeter& progress, 
+			RunProgress& saved, long& unflushed, double memoryLimit, 
+			long flushEvery, const string& checkpointFile, 
+			TrialDumper& dumper) 
+			: curBin(curBin), progress(progress), saved(saved), 
+			unflushed(unflushed), memoryLimit(memoryLimit), 
+			flushEvery(flushEvery), checkpointFile(checkpointFile), 
+			dumper(dumper) {
+	}
+	
+	/** Records a batch whose statistics have been added to the bin
+	 *
+	 * @param[in] first The index of the first trial in @p batch.
+	 * @param[in] batch The analyzed light curves.
+	 * @param[in] simSeconds, analysisSeconds The time spent 
+	 *	simulating and analyzing @p batch.
+	 *
+	 * @post The time and light curves are counted by the bin and the 
+	 *	progress meter.
+	 * @post If the bin is over its memory or batch limit, it has been 
+	 *	written out, and the checkpoint (if any) updated.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	to finish the batch.
+	 * @exception kpfutils::except::FileIo Thrown if the statistics 
+	 *	or the light curves could not be written.
+	 * @exception std::invalid_argument Thrown if the light curves 
+	 *	are chosen by a statistic the bin does not store.
+	 *
+	 * @exceptsafe The program is in a consistent state in the event 
+	 *	of an exception.
+	 */
+	void operator()(long first, const vector<SimTrial>& batch, 
+			double simSeconds, double analysisSeconds) const {
+		const long last = first + static_cast<long>(batch.size());
+		
+		curBin.addSimulationTime(simSeconds);
+		progress.addBatch(last - first, simSeconds, analysisSeconds);
+		
+		// Must see the batch's statistics before they are written out
+		dumper.offer(first, batch, curBin);
+		
+		// Write out the statistics rather than 
+		//	let them grow without bound
+		unflushed += last - first;
+		if ((memoryLimit > 0.0 
+				&& curBin.memoryBytes() > memoryLimit*1024.0*1024.0) 
+				|| (flushEvery > 0 && unflushed >= flushEvery)) {
+			curBin.spill();
+			unflushed = 0;
+			if (!checkpointFile.empty()) {
+				saved.trial = last;
+				writeCheckpoint(checkpointFile, saved, curBin);
+			}
+		}
+	}
+	
+private:
+	LcBinStats& curBin;
+	ProgressMeter& progress;
+	RunProgress& saved;
+	long& unflushed;
+	const double memoryLimit;
+	const long flushEvery;
+	const string& checkpointFile;
+	TrialDumper& dumper;
+};
+
+/** The number of light curves between checks of --target-error
+ */
+const long TARGET_STEP = 100;
+
+/** Chooses where a batch of trials ends
+ *
+ * @param[in] first The first trial of the batch.
+ * @param[in] end One past the last trial of the bin.
+ * @param[in] batchSize The most trials in a batch.
+ *
+ * @return One past the last trial of the batch. If 
+ *	stats::getTargetError() is positive, batches do not cross 
+ *	multiples of @ref TARGET_STEP "TARGET_STEP", so that the 
+ *	trials at which a bin is checked do not depend on @p batchSize.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long batchEnd(long first, long end, long batchSize) {
+	long last = std::min(end, first + batchSize);
+	if (stats::getTargetError() > 0.0) {
+		last = std::min(last, (first / TARGET_STEP + 1) * TARGET_STEP);
+	}
+	return last;
+}
+
+/** The light curves that --tune times with each candidate setting, per 
+ *	analysis thread
+ */
+const long TUNE_FACTOR = 32;
+
+/** The fraction by which a setting must beat the fastest one so far 
+ *	before --tune prefers it
+ */
+const double TUNE_MARGIN = 0.05;
+
+/** Finds the fastest settings for a run that do not change its results
+ *
+ * Each candidate from tuningCandidates() simulates and analyzes the 
+ * same light curves, in batches of its own size, after one untimed 
+ * batch has filled the caches for the cadence. The light curves and 
+ * their statistics are then discarded.
+ *
+ * @param[in] curve, streamIndex, limits, simTimes, sigma, magMode, 
+ *	seed, streamOffset The light curves to time, as for simTrials().
+ * @param[in] first The index of the first light curve to time.
+ * @param[in] nTrials The most light curves to time with each setting.
+ * @param[in] nThreads The number of analysis threads.
+ * @param[in] maxStatThreads The most threads to try for the statistics 
+ *	of each light curve.
+ * @param[in] emptyBin A collection with no statistics, used as the 
+ *	template for the discarded results.
+ *
+ * @return The fastest candidate. A later candidate is chosen over an 
+ *	earlier one only if it is at least @ref TUNE_MARGIN "TUNE_MARGIN" 
+ *	faster, so that noise in the timing does not move the run away 
+ *	from the settings used without --tune.
+ *
+ * @post stats::getStatThreads() is unspecified.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	simulate the light curves.
+ * @exception std::runtime_error Thrown if the light curves could not 
+ *	be simulated.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of 
+ *	an exception.
+ */
+Tuning measureTuning(const models::LightCurveType& curve, long streamIndex, 
+		const models::RangeList& limits, const models::Cadence& simTimes, 
+		double sigma, bool magMode, long seed, long streamOffset, long first, 
+		long nTrials, long nThreads, long maxStatThreads, 
+		const LcBinStats& emptyBin) {
+	const vector<Tuning> candidates = tuningCandidates(maxStatThreads);
+	const long unit = std::max(nThreads, 4L);
+	const long nTune = std::min(nTrials, TUNE_FACTOR * unit);
+	if (nTune <= 0) {
+		return candidates.front();
+	}
+	
+	{
+		const stats::TraceSpan span("tune");
+		vector<SimTrial> batch(std::min(nTune, unit));
+		simTrials(curve, streamIndex, limits, false, "", simTimes, sigma, 
+			magMode, seed, streamOffset, first, batch);
+		finishTrials(batch);
+		LcBinStats discard(emptyBin);
+		analyzeTrials(batch, nThreads, emptyBin, discard);
+	}
+	
+	Tuning best = candidates.front();
+	double bestTime = std::numeric_limits<double>::infinity();
+	for(vector<Tuning>::const_iterator it = candidates.begin(); 
+			it != candidates.end(); it++) {
+		const stats::TraceSpan span("tune");
+		stats::setStatThreads(it->statThreads);
+		const long batchSize = it->batchFactor * unit;
+		
+		LcBinStats discard(emptyBin);
+		const double start = stats::monotonicSeconds();
+		for(long i = 0, j = 0; i < nTune; i = j) {
+			j = std::min(nTune, i + batchSize);
+			vector<SimTrial> batch(j - i);
+			simTrials(curve, streamIndex, limits, false, "", simTimes, sigma, 
+				magMode, seed, streamOffset, first + i, batch);
+			finishTrials(batch);
+			analyzeTrials(batch, nThreads, emptyBin, discard);
+		}
+		const double seconds = stats::monotonicSeconds() - start;
+		
+		if (seconds < (1.0 - TUNE_MARGIN) * bestTime) {
+			best = *it;
+			bestTime = seconds;
+		}
+	}
+	return best;
+}
+
+/** Returns the label of the bins of an extra cadence
+ *
+ * @param[in] dateList The file containing the cadence's time stamps.
+ *
+ * @return The name of @p dateList, without its directory or extension.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	construct the label.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string cadenceLabel(const string& dateList) {
+	const size_t slash = dateList.find_last_of("/\\");
+	string label = (slash == string::npos ? dateList : dateList.substr(slash + 1));
+	const size_t dot = label.rfind('.');
+	if (dot != string::npos && dot > 0) {
+		label.erase(dot);
+	}
+	return label;
+}
+
+/** Returns the label of the bins of a prefix of the main cadence
+ *
+ * @param[in] baseline The length of the prefix, in days.
+ *
+ * @return @p baseline, followed by <tt>d</tt>.
+ *
+ * @exception std::runtime_error Thrown if the label could not be 
+ *	formatted.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	construct the label.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string baselineLabel(double baseline) {
+	char label[32];
+	if (sprintf(label, "%gd", baseline) < 0) {
+		throw std::runtime_error("Could not format baseline label.");
+	}
+	return label;
+}
+
+/** Prints how long a run is expected to take, based on earlier runs
+ * 
+ * @param[in] costs The measured costs of earlier runs.
+ * @param[in] binLabels The label of each bin in the run, as given by 
+ *	LcBinStats::makeFileName().
+ * @param[in] costStats, nEpochs The rest of the key for @p costs.
+ * @param[in] nTrials The number of trials each process runs per bin.
+ * @param[in] nWorkers The number of processes sharing the trials.
+ *
+ * @post A one-line estimate has been printed to standard error.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the estimate could 
+ *	not be printed.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void printRunEstimate(const CostTable& costs, const vector<string>& binLabels, 
+		const string& costStats, long nEpochs, long nTrials, long nWorkers) {
+	double seconds = 0.0;
+	long nKnown = 0;
+	for(vector<string>::const_iterator it = binLabels.begin(); 
+			it != binLabels.end(); it++) {
+		const double perTrial = costs.estimate(*it, costStats, nEpochs);
+		if (perTrial > 0.0) {
+			seconds += perTrial * static_cast<double>(nTrials) 
+				/ static_cast<double>(nWorkers);
+			nKnown++;
+		}
+	}
+	
+	if (fprintf(stderr, "Estimated run time: %.0f s for the %ld of %lu bins with known costs\n", 
+			seconds, nKnown, static_cast<unsigned long>(binLabels.size())) < 0) {
+		kpfutils::cError("Could not print output: ");
+	}
+}
+
+/** Rounds Gaussian process coherence times to a grid, if requested, 
+ *	and reports the resulting error
+ * 
+ * @param[in] tauGrid The number of grid points per decade, or 0 to use 
+ *	exact coherence times.
+ * @param[in] bins The ranges from which light curve parameters are 
+ *	drawn, one element per bin.
+ *
+ * @post If @p tauGrid > 0, coherence times are rounded to the grid, 
+ *	and multiNormal() can cache a factorization for every combination 
+ *	of grid values allowed by any element of @p bins.
+ *
+ * @exception std::invalid_argument Thrown if @p tauGrid < 0.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void configureTauGrid(long tauGrid, const vector<models::RangeList>& bins) {
+	models::setTauGrid(tauGrid);
+	if (tauGrid <= 0) {
+		return;
+	}
+	
+	// Two-timescale processes need a matrix for each pair of grid values
+	// The bins are run one at a time, so only the largest needs to fit
+	size_t nMatrices = 1;
+	for(vector<models::RangeList>::const_iterator bin = bins.begin(); 
+			bin != bins.end(); bin++) {
+		size_t binMatrices = 1;
+		for(models::RangeList::const_iterator it = bin->begin(); 
+				it != bin->end(); it++) {
+			if ((*it == "p" || *it == "period2") && bin->getMin(*it) > 0.0) {
+				binMatrices *= models::tauGridSize(bin->getMin(*it), 
+					bin->getMax(*it));
+			}
+		}
+		nMatrices = std::max(nMatrices, binMatrices);
+	}
+	utils::reserveFactorCache(nMatrices);
+	
+	fprintf(stderr, "WARNING: Gaussian process coherence times rounded to %ld values per decade, changing them by up to %.2g%% and their covariances by up to %.2g of the variance. Up to %lu covariance factorizations will be cached.\n", 
+		tauGrid, 100.0 * models::tauGridError(), models::tauGridCovarError(), 
+		static_cast<unsigned long>(nMatrices));
+}
+
+/** Approximates Gaussian process kernels by state-space models, if 
+ *	requested, and reports the resulting error
+ * 
+ * @param[in] gpOrder The order of the state-space models, or 0 to use 
+ *	the exact kernels.
+ *
+ * @post If @p gpOrder > 0, simple_gp and two_gp light curves are 
+ *	generated in linear time from the approximate kernel.
+ *
+ * @exception std::invalid_argument Thrown if @p gpOrder is negative 
+ *	or too large.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void configureStateSpace(long gpOrder) {
+	models::setStateSpaceOrder(gpOrder);
+	if (gpOrder <= 0) {
+		return;
+	}
+	
+	fprintf(stderr, "WARNING: Gaussian process light curves generated from a state-space approximation of order %ld, changing their covariances by up to %.2g of the variance.\n", 
+		gpOrder, models::stateSpaceError());
+}
+
+/** Interpolates outburst and fade waveforms from tables, if requested, 
+ *	and reports the resulting error
+ * 
+ * @param[in] tolerance The largest error allowed, as a fraction of 
+ *	the amplitude, or 0 to evaluate the waveforms exactly.
+ *
+ * @post If @p tolerance > 0, slow_peak, flare_peak, slow_dip, and 
+ *	flare_dip light curves are interpolated wherever a table can 
+ *	meet the tolerance.
+ *
+ * @exception std::invalid_argument Thrown if @p tolerance is negative 
+ *	or at least 1.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void configureShapeTables(double tolerance) {
+	models::setShapeTolerance(tolerance);
+	if (tolerance <= 0.0) {
+		return;
+	}
+	
+	fprintf(stderr, "WARNING: outburst and fade waveforms interpolated from tables, changing their fluxes by up to %.2g of the amplitude.\n", 
+		tolerance);
+}
+
+/** Reuses the white noise of each trial in every bin, if requested
+ * 
+ * @param[in] enabled If true, use a noise pool.
+ * @param[in] injectMode If true, the run adds no white noise, and 
+ *	no pool is used.
+ * @param[in] seed The seed of the run.
+ * @param[in] nStreams The number of stream indices used by the run.
+ * @param[in] firstTrial, lastTrial The trials simulated in each bin.
+ * @param[in] times The cadence on which the noise is drawn.
+ * @param[in] sigma The amplitude of the noise.
+ *
+ * @post If @p enabled is true and @p injectMode is false, makeWhiteNoise() 
+ *	copies the noise of trials [@p firstTrial, @p lastTrial) from a pool 
+ *	after the first bin that draws it. Otherwise, noise is always drawn, 
+ *	and any pool left by an earlier run is released.
+ *
+ * @exception std::runtime_error Thrown if a large pool could not be 
+ *	mapped to a file.
+ * @exception std::length_error Thrown if the pool is too large to 
+ *	address.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the pool.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void configureNoisePool(bool enabled, bool injectMode, long seed, 
+		long nStreams, long firstTrial, long lastTrial, 
+		const models::Cadence& times, double sigma) {
+	setNoisePool(boost::shared_ptr<NoisePool>());
+	if (!enabled) {
+		return;
+	}
+	if (injectMode) {
+		fprintf(stderr, "WARNING: --noise-pool ignored, since injected light curves have no simulated noise.\n");
+		return;
+	}
+	
+	const boost::shared_ptr<NoisePool> pool(new NoisePool(
+		static_cast<unsigned long>(seed), static_cast<unsigned long>(nStreams), 
+		static_cast<unsigned long>(firstTrial), 
+		static_cast<unsigned long>(lastTrial), 
+		times.size(), sigma));
+	if (pool->isMapped()) {
+		fprintf(stderr, "WARNING: noise pool of %.0f MB kept in a temporary file.\n", 
+			static_cast<double>(pool->bytes()) / (1024.0*1024.0));
+	}
+	setNoisePool(pool);
+}
+
+/** Computes batches of periodograms on a CUDA device, if requested
+ * 
+ * @param[in] gpuStats If true, use a device when one is available.
+ *
+ * @post If @p gpuStats is true and the program was built with CUDA 
+ *	support, large batches of periodograms are computed on the device.
+ *	If no device is available, a warning is printed and the CPU is used.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void configureDeviceStats(bool gpuStats) {
+	stats::setDeviceStats(gpuStats);
+	if (gpuStats && !stats::deviceStatsAvailable()) {
+		fprintf(stderr, "WARNING: --gpu-stats given, but no CUDA device is available. Periodograms will be computed on the CPU.\n");
+	}
+}
+
+/** Counts hardware events in each profiled stage, if requested and 
+ *	possible
+ *
+ * @param[in] profileCounters If true, the user has asked for the 
+ *	hardware events of each stage to be reported.
+ *
+ * @post If @p profileCounters is true and hardware events can be 
+ *	counted, profiled stages also count their events. If they cannot, 
+ *	a warning has been printed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void configureProfileCounters(bool profileCounters) {
+	const bool available = profileCounters && stats::profileCountersAvailable();
+	stats::setProfileCounters(available);
+	if (profileCounters && !available) {
+		fprintf(stderr, "WARNING: --profile-counters given, but hardware events cannot be counted on this system. Only times will be reported.\n");
+	}
+}
+
+/** Approximates stationary Gaussian processes by low-rank models, if 
+ *	requested
+ * 
+ * @param[in] gpRank The number of inducing points of the low-rank 
+ *	models, or 0 to use the exact kernels.
+ *
+ * @post If @p gpRank > 0, simple_gp and two_gp light curves with more 
+ *	than @p gpRank observations are generated from a Nystr&ouml;m 
+ *	approximation to their kernels.
+ *
+ * @exception std::invalid_argument Thrown if @p gpRank is negative.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void configureNystrom(long gpRank) {
+	models::setNystromRank(gpRank);
+	if (gpRank <= 0) {
+		return;
+	}
+	
+	fprintf(stderr, "WARNING: Gaussian process light curves with more than %ld observations generated from a rank-%ld Nystrom approximation. The resulting error in their covariances will be printed at the end of the run.\n", 
+		gpRank, gpRank);
+}
+
+/** Prints the largest covariance error of the low-rank Gaussian process 
+ *	models used in the run
+ *
+ * @post If setNystromRank() was given a nonzero rank, the largest 
+ *	error is printed to standard error.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void reportNystromError() {
+	if (models::getNystromRank() <= 0) {
+		return;
+	}
+	
+	fprintf(stderr, "WARNING: Nystrom approximation changed Gaussian process covariances by up to %.2g of the variance.\n", 
+		models::nystromError());
+}
+
+/** Generates Gaussian processes one observing season at a time, if 
+ *	requested
+ * 
+ * @param[in] gpSeasons The largest covariance between seasons, as a 
+ *	fraction of the variance, that may be ignored, or 0 to use the 
+ *	exact kernels.
+ *
+ * @post If @p gpSeasons > 0, simple_gp and two_gp light curves whose 
+ *	kernels fall below @p gpSeasons across gaps in the cadence are 
+ *	generated one season at a time.
+ *
+ * @exception std::invalid_argument Thrown if @p gpSeasons is negative 
+ *	or not less than 1.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void configureSeasons(double gpSeasons) {
+	models::setSeasonTolerance(gpSeasons);
+	if (gpSeasons <= 0.0) {
+		return;
+	}
+	
+	fprintf(stderr, "WARNING: Gaussian process light curves generated one season at a time, ignoring covariances below %.2g of the variance between seasons. The largest covariance ignored will be printed at the end of the run.\n", 
+		gpSeasons);
+}
+
+/** Generates Gaussian processes from sparse covariance matrices, if 
+ *	requested
+ * 
+ * @param[in] gpSparse The largest covariance, as a fraction of the 
+ *	variance, that may be treated as zero, or 0 to use the exact 
+ *	kernels.
+ *
+ * @post If @p gpSparse > 0, simple_gp and two_gp light curves whose 
+ *	covariance matrices are mostly below @p gpSparse are generated 
+ *	from sparse matrices.
+ *
+ * @exception std::invalid_argument Thrown if @p gpSparse is negative 
+ *	or not less than 1.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void configureSparse(double gpSparse) {
+	models::setSparseTolerance(gpSparse);
+	if (gpSparse <= 0.0) {
+		return;
+	}
+	
+	fprintf(stderr, "WARNING: Gaussian process covariances below %.2g of the variance treated as zero.\n", 
+		gpSparse);
+}
+
+/** Prints the largest covariance ignored between the seasons of the 
+ *	Gaussian process light curves generated in the run
+ *
+ * @post If setSeasonTolerance() was given a nonzero tolerance, the 
+ *	largest covariance ignored is printed to standard error.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void reportSeasonError() {
+	if (models::getSeasonTolerance() <= 0.0) {
+		return;
+	}
+	
+	fprintf(stderr, "WARNING: generating seasons separately ignored Gaussian process covariances of up to %.2g of the variance.\n", 
+		models::seasonError());
+}
+
+/** Finds the midpoint of the range of simulated periods
+ * 
+ * @param[in] limits The ranges from which light curve parameters are drawn.
+ *
+ * @return The geometric mean of the range of periods, since timescales 
+ *	are usually sampled over several decades, or NaN if @p limits has 
+ *	no positive range of periods.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double gpMidpoint(const models::RangeList& limits) {
+	double midpoint = std::numeric_limits<double>::quiet_NaN();
+	for(models::RangeList::const_iterator it = limits.begin(); 
+			it != limits.end(); it++) {
+		if (*it == "p" && limits.getMin(*it) > 0.0) {
+			midpoint = sqrt(limits.getMin(*it) * limits.getMax(*it));
+		}
+	}
+	return midpoint;
+}
+
+/** Chooses where Gaussian process fits start their optimization
+ * 
+ * @param[in] gpStart The policy for choosing the starting timescale.
+ * @param[in] limits The ranges from which light curve parameters are drawn.
+ *
+ * @post fitGaussGp() starts from the point chosen by @p gpStart. For 
+ *	@ref stats::GPSTART_MIDPOINT "GPSTART_MIDPOINT", the midpoint is 
+ *	gpMidpoint(@p limits).
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void configureGpStart(stats::GpStart gpStart, const models::RangeList& limits) {
+	stats::setGpStart(gpStart, gpMidpoint(limits));
+}
+
+/** Selects how Gaussian process models are fit
+ * 
+ * @param[in] gpFit The backend to use for the fits.
+ * @param[in] gpPlugin The statistics plugin to use if @p gpFit is 
+ *	GPFIT_PLUGIN.
+ * @param[in] rWorkers The number of separate R processes to use if 
+ *	@p gpFit is GPFIT_R, or 0 to use the embedded R interpreter.
+ * @param[in] statList The statistics to calculate.
+ *
+ * @post fitGaussGp() fits models as chosen by @p gpFit, @p gpPlugin, 
+ *	and @p rWorkers.
+ * @post If @p statList contains a Gaussian process statistic, any 
+ *	plugin needed for the fits is loaded. Otherwise, no plugin (and 
+ *	in particular, no R interpreter) is loaded.
+ *
+ * @exception std::invalid_argument Thrown if @p rWorkers < 0 or 
+ *	@p gpPlugin is not a valid plugin name.
+ * @exception std::runtime_error Thrown if a needed plugin could not 
+ *	be loaded.
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void configureGpFit(stats::GpFitMethod gpFit, const string& gpPlugin, 
+		long rWorkers, const vector<stats::StatType>& statList) {
+	stats::setGpFitMethod(gpFit);
+	stats::setGpPlugin(gpPlugin);
+	stats::setRWorkers(rWorkers);
+	
+	// Load the plugin now, so that a missing plugin stops the run 
+	//	instead of failing every fit
+	if (std::find(statList.begin(), statList.end(), stats::GPTAU) != statList.end()) {
+		stats::loadGpPlugin();
+	}
+}
+
+/** Bins light curves before Gaussian process fits, if requested
+ * 
+ * @param[in] gpBin The width of the bins, or 0 to fit every observation.
+ * @param[in] gpFit The backend used for the fits.
+ *
+ * @post If @p gpBin > 0, fitGaussGp() fits light curves averaged in 
+ *	bins of width @p gpBin.
+ *
+ * @exception std::invalid_argument Thrown if @p gpBin is negative.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void configureGpBinning(double gpBin, stats::GpFitMethod gpFit) {
+	stats::setGpBinning(gpBin);
+	if (gpBin <= 0.0) {
+		return;
+	}
+	
+	fprintf(stderr, "WARNING: light curves averaged in bins of %g days before Gaussian process fits. The estimated bias in the fitted timescales will be printed at the end of the run.\n", 
+		gpBin);
+	if (gpFit != stats::GPFIT_NATIVE) {
+		fprintf(stderr, "WARNING: --gp-fit r cannot weight bins by their number of observations; all bins are fit with the same noise.\n");
+	}
+}
+
+/** Tests whether two bins may be analyzed together
+ * 
+ * @param[in] first, second The ranges from which the bins' light 
+ *	curve parameters are drawn.
+ *
+ * @return True if the settings made by configureGpStart() are the 
+ *	same for both bins.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool sameGpStart(const models::RangeList& first, const models::RangeList& second) {
+	const double a = gpMidpoint(first);
+	const double b = gpMidpoint(second);
+	// Exact comparison is intended: the setting is global
+	return (a == b) || (kpfutils::isNan(a) && kpfutils::isNan(b));
+}
+
+/** PackedBins holds the bins simulated and analyzed together by 
+ *	--pack-bins, until the loop over bins reaches each of them.
+ */
+struct PackedBins {
+	/** Creates an object holding no bins
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	PackedBins() : first(0), bins(), trials(), simSeconds(), 
+			analysisSeconds(0.0) {
+	}
+	
+	/** Tests whether a bin is held
+	 *
+	 * @param[in] binIndex The index of the bin in the run.
+	 *
+	 * @return True if the statistics of bin @p binIndex are held.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool has(long binIndex) const {
+		return binIndex >= first 
+			&& static_cast<size_t>(binIndex - first) < bins.size();
+	}
+	
+	/** The index of the first bin held */
+	long first;
+	/** The statistics of each bin held, starting with bin @p first */
+	vector<LcBinStats> bins;
+	/** The light curves of each bin held */
+	vector<vector<SimTrial> > trials;
+	/** The time spent simulating each bin held */
+	vector<double> simSeconds;
+	/** The share of the analysis time charged to each bin held */
+	double analysisSeconds;
+};
+
+/** Reports how much binning biased Gaussian process fits, if any 
+ *	light curves were binned
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void reportGpBinning() {
+	long nFits, nUnresolved;
+	double meanBias;
+	stats::getGpBinningBias(nFits, meanBias, nUnresolved);
+	if (nFits > 0) {
+		fprintf(stderr, "Binning lengthened Gaussian process timescales by an estimated %.2g%% on average (%ld fits).\n", 
+			100.0 * meanBias, nFits - nUnresolved);
+	}
+	if (nUnresolved > 0) {
+		fprintf(stderr, "WARNING: %ld Gaussian process fits found timescales too short compared to --gp-bin to estimate their bias.\n", 
+			nUnresolved);
+	}
+}
+
+/** Reports how quickly Gaussian process fits converged, if any 
+ *	iteration counts are available
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void reportGpIterations() {
+	long nFits, nIterations;
+	stats::getGpIterations(nFits, nIterations);
+	if (nFits > 0) {
+		fprintf(stderr, "Gaussian process fits took %.1f optimizer iterations on average (%ld fits).\n", 
+			static_cast<double>(nIterations) / static_cast<double>(nFits), 
+			nFits);
+	}
+}
+
 ////////////////////////////////////////
 // Main Program
 
-/** The driver for Lightcurve MC.
+/** Runs one simulation, as specified on the command line
  *
  * @param[in] argc, argv: an array of C-strings denoting the arguments, using the C 
  *	convention
  *
  * @return 0 if successful, 1 if an error occurred
+ *
+ * @exceptsafe Does not throw exceptions.
  */
-int main(int argc, char* argv[]) {
+int runJob(int argc, char* argv[]) {
 	using namespace lcmc::models;
 	
 	try {
 		////////////////////
 		// Parse the input
-		long nTrials, numToPrint;
-		double sigma;
+		long nTrials, numToPrint, nThreads, seed, streamOffset, packBins;
+		double sigma, statBudget, progressInterval, memoryLimit, cacheLimit, targetError, shapeTolerance, gpBin, gpSeasons, gpSparse;
 		RangeList limits;
-		vector<string> lcNameList;
+		vector<RangeList> grid;
+		vector<string> lcNameList, cadenceFiles;
+		vector<double> baselines;
 		vector<models::LightCurveType>   lcList;
 		vector< stats::      StatType> statList;
-		string dateList, injectCat;
-		bool injectMode;
+		string dateList, injectCat, cacheDir, archiveFile, traceFile, checkpointFile, 
+			costsFile, saveTrialsFile, replayFile, resultCacheDir, gpPlugin;
+		bool injectMode, magMode, storeDistribs, storeCurves, printQuantiles, floatCurves, floatPgram, compressDistribs, archiveCompress, 
+			profile, profileCounters, cacheReport, memoryReport, resume, numa, hugePages, gpuStats, commonRandom, noisePool, tune;
+		DumpPolicy printPolicy;
+		string printStat;
+		stats::DistribFormat distribFormat;
+		stats::PeriodogramMethod pgramMethod;
+		stats::ScargleAcfMethod sacfMethod;
+		stats::PeakMethod peakMethod;
+		utils::CovarFactor gpFactor;
+		long tauGrid, gpOrder, gpRank, rWorkers, statThreads, sketchSize, traceEvents, flushEvery, 
+			shard, nShards, merge, pipelineDepth;
+		stats::GpFitMethod gpFit;
+		stats::GpStart gpStart;
+		ParamSampling sampling;
 	
-		parse::parseArguments(argc, argv, sigma, nTrials, numToPrint, 
-			limits, dateList, lcNameList, lcList, statList, injectCat, injectMode);
+		parse::parseArguments(argc, argv, sigma, nTrials, numToPrint, nThreads, seed, storeDistribs, storeCurves, sketchSize, printQuantiles, floatCurves, 
+			distribFormat, compressDistribs, archiveFile, archiveCompress, pgramMethod, floatPgram, sacfMethod, peakMethod, cacheDir, cacheLimit, gpFactor, tauGrid, gpOrder, gpRank, gpSeasons, gpSparse, gpFit, gpPlugin, rWorkers, gpStart, statBudget, statThreads, profile, profileCounters, cacheReport, progressInterval, traceFile, traceEvents, memoryReport, memoryLimit, flushEvery, checkpointFile, resume, shard, nShards, merge, pipelineDepth, numa, hugePages, gpuStats, printPolicy, printStat, shapeTolerance, noisePool, streamOffset, packBins, gpBin, costsFile, tune, targetError, sampling, commonRandom, saveTrialsFile, replayFile, resultCacheDir, cadenceFiles, baselines, limits, grid, dateList, lcNameList, lcList, statList, injectCat, injectMode, magMode);
+		stats::setThresholdCacheDir(cacheDir);
+		utils::setFactorCacheDir(cacheDir);
+		utils::setDiskCacheLimit(static_cast<boost::uint64_t>(cacheLimit*1024.0*1024.0));
+		utils::setNumaPinning(numa);
+		utils::setHugePages(hugePages);
+		configureDeviceStats(gpuStats);
+		setCadenceCacheDir(cacheDir);
+		stats::setThresholdThreads(nThreads);
+		utils::setCovarFactor(gpFactor);
+		configureTauGrid(tauGrid, grid);
+		configureStateSpace(gpOrder);
+		configureShapeTables(shapeTolerance);
+		configureNystrom(gpRank);
+		configureSeasons(gpSeasons);
+		configureSparse(gpSparse);
+		configureGpFit(gpFit, gpPlugin, rWorkers, statList);
+		configureGpBinning(gpBin, gpFit);
+		stats::setStatBudget(statBudget);
+		stats::setStatThreads(statThreads);
+		stats::setProfiling(profile);
+		configureProfileCounters(profile && profileCounters);
+		stats::setTargetError(targetError);
+		stats::setSketchSize(sketchSize);
+		stats::setPrintQuantiles(printQuantiles);
+		stats::setCurvePrecision(floatCurves ? stats::SINGLE_PRECISION 
+			: stats::DOUBLE_PRECISION);
+		stats::setPeriodogramPrecision(floatPgram ? stats::SINGLE_PRECISION 
+			: stats::DOUBLE_PRECISION);
+		stats::setScargleAcfMethod(sacfMethod);
+		stats::setPeakMethod(peakMethod);
+		setParamSampling(sampling);
+		
+		// With several processes, process 0 hands out chunks of trials 
+		//	to the others and prints the results
+		const bool distributed = mpiSize() > 1;
+		const bool coordinator = mpiRank() == 0;
+		if (distributed && (seed < 0 || nShards > 0 || merge > 0 
+				|| !checkpointFile.empty() || !archiveFile.empty() 
+				|| targetError > 0.0 || !saveTrialsFile.empty() 
+				|| !replayFile.empty() || !resultCacheDir.empty() 
+				|| packBins > 0 || tune)) {
+			throw parse::except::ParseError("A run with several MPI processes "
+				"needs --seed, and cannot use --shard, --merge, "
+				"--checkpoint, --archive, --target-error, "
+				"--save-trials, --replay, --result-cache, --pack-bins, "
+				"or --tune.");
+		}
+		if (distributed && printPolicy != DUMP_FIRST) {
+			// Each worker sees only its own chunks of each bin
+			throw parse::except::ParseError("A run with several MPI processes "
+				"can only use '--print-select first'.");
+		}
+		if ((!cadenceFiles.empty() || !baselines.empty()) && (injectMode || distributed 
+				|| !checkpointFile.empty() || nShards > 0 || merge > 0 
+				|| pipelineDepth > 0 || targetError > 0.0 
+				|| !costsFile.empty() || !saveTrialsFile.empty() 
+				|| !replayFile.empty() || !resultCacheDir.empty() 
+				|| packBins > 0)) {
+			throw parse::except::ParseError("--cadence and --baseline cannot "
+				"be used in injection mode, with several MPI processes, or with "
+				"--checkpoint, --shard, --merge, --pipeline, "
+				"--target-error, --costs, --save-trials, --replay, "
+				"--result-cache, or --pack-bins.");
+		}
+		if (!traceFile.empty() && coordinator) {
+			stats::startTrace(traceFile, traceEvents);
+		}
+		stats::setDistribFormat(distribFormat);
+		if (compressDistribs && !utils::canCompressZip()) {
+			fprintf(stderr, "WARNING: built without zlib; distribution files will not be compressed\n");
+		}
+		stats::setDistribCompression(compressDistribs);
+		if (!archiveFile.empty()) {
+			if (archiveCompress && !utils::canCompressZip()) {
+				fprintf(stderr, "WARNING: built without zlib; %s will not be compressed\n", 
+					archiveFile.c_str());
+			}
+			stats::openDistribArchive(archiveFile, archiveCompress);
+		}
 	
 		// For file name formatting
-		string noiseStr = noiseDesc(injectMode, injectCat, sigma);
+		string noiseStr = noiseDesc(injectMode, magMode, injectCat, sigma);
+		
+		// Bins already run with the same inputs are reprinted from 
+		//	the cache; runKey holds the inputs shared by all bins
+		boost::scoped_ptr<ResultCache> resultCache;
+		ResultKey runKey;
+		if (!resultCacheDir.empty()) {
+			resultCache.reset(new ResultCache(resultCacheDir));
+			runKey.addProgram();
+			runKey.add(noiseStr);
+			runKey.add(sigma);
+			runKey.add(static_cast<long>(injectMode));
+			runKey.add(static_cast<long>(magMode));
+			runKey.addFile(injectMode ? injectCat : dateList);
+			runKey.add(static_cast<long>(statList.size()));
+			for(vector<stats::StatType>::const_iterator it = statList.begin(); 
+					it != statList.end(); it++) {
+				runKey.add(static_cast<long>(*it));
+			}
+			runKey.add(seed);
+			runKey.add(streamOffset);
+			runKey.add(nTrials);
+			runKey.add(numToPrint);
+			runKey.add(static_cast<long>(printPolicy));
+			runKey.add(printStat);
+			runKey.add(static_cast<long>(storeDistribs));
+			runKey.add(static_cast<long>(storeCurves));
+			runKey.add(sketchSize);
+			runKey.add(static_cast<long>(floatCurves));
+			runKey.add(static_cast<long>(distribFormat));
+			runKey.add(static_cast<long>(compressDistribs));
+			runKey.add(static_cast<long>(pgramMethod));
+			runKey.add(static_cast<long>(floatPgram));
+			runKey.add(static_cast<long>(sacfMethod));
+			runKey.add(static_cast<long>(peakMethod));
+			runKey.add(static_cast<long>(gpFactor));
+			runKey.add(tauGrid);
+			runKey.add(gpOrder);
+			runKey.add(gpRank);
+			runKey.add(gpSeasons);
+			runKey.add(gpSparse);
+			runKey.add(shapeTolerance);
+			runKey.add(static_cast<long>(gpFit));
+			runKey.add(gpPlugin);
+			runKey.add(gpBin);
+			runKey.add(static_cast<long>(gpStart));
+			if (gpStart == stats::GPSTART_PREVIOUS) {
+				// Only case where the results depend on the threads
+				runKey.add(nThreads);
+				runKey.add(statThreads);
+			}
+			runKey.add(statBudget);
+			runKey.add(static_cast<long>(profile));
+			runKey.add(static_cast<long>(stats::getProfileCounters()));
+			runKey.add(targetError);
+			runKey.add(static_cast<long>(sampling));
+			runKey.add(static_cast<long>(commonRandom));
+		}
+		
+		// A shard runs only its own block of each bin's trials, and 
+		//	labels its distribution files so that they can share a 
+		//	directory with the other shards
+		long shardFirst = 0, shardLast = nTrials;
+		if (nShards > 0) {
+			shardTrials(nTrials, shard, nShards, shardFirst, shardLast);
+			stats::setPartPrefix(boost::lexical_cast<string>(shard) + ".");
+		} else {
+			// An earlier job of --serve may have been a shard
+			stats::setPartPrefix("");
+		}
+		// A merge joins the shards' parts into the files of a 
+		//	single-process run
+		stats::setJoinParts(merge > 0);
+		
+		// Rows are printed for every light curve type in each bin
+		const long nCurves = static_cast<long>(lcList.size());
+		const long nBins = nCurves * static_cast<long>(grid.size());
+		
+		// Measured costs let the run be planned before it starts
+		CostTable costs;
+		const string costStats = statKey(statList);
+		long nEpochs = 0;
+		if (!costsFile.empty() && merge == 0) {
+			costs.read(costsFile);
+			// Injected light curves vary in length, and share one entry
+			if (!injectMode) {
+				models::Cadence cadence;
+				makeTimes(dateList, cadence);
+				nEpochs = static_cast<long>(cadence.size());
+			}
+			if (coordinator) {
+				vector<string> binLabels;
+				for(long i = 0; i < nBins; i++) {
+					binLabels.push_back(LcBinStats::makeFileName(
+						lcNameList[i % nCurves], grid[i / nCurves], noiseStr));
+				}
+				printRunEstimate(costs, binLabels, costStats, nEpochs, 
+					shardLast - shardFirst, (distributed ? mpiSize() - 1 : 1));
+			}
+		}
 		
 		////////////////////
 		// And start simulating
-		LcBinStats::printBinHeader(stdout, limits, statList);
+		if (nShards == 0 && coordinator) {
+			LcBinStats::printBinHeader(stdout, grid.front(), statList);
+		}
+		ProgressMeter progress(coordinator ? progressInterval : 0.0, 
+			nBins, shardLast - shardFirst);
+		// Light curves are written while the next ones are simulated
+		DumpQueue dumpQueue(64);
+		
+		// The light curve types already finished by an interrupted run 
+		//	are reprinted rather than simulated again
+		RunProgress saved(seed, nTrials, nBins, streamOffset, flushEvery, 
+			memoryLimit);
+		const bool resumed = resume && readCheckpoint(checkpointFile, saved);
+		for(vector<string>::const_iterator it = saved.rows.begin(); 
+				it != saved.rows.end(); it++) {
+			if (fprintf(stdout, "%s\n", it->c_str()) < 0) {
+				kpfutils::cError("Could not print output: ");
+			}
+		}
+		
+		// Light curves may be saved for, or replayed from, another run
+		boost::scoped_ptr<TrialWriter> trialWriter;
+		if (!saveTrialsFile.empty()) {
+			trialWriter.reset(new TrialWriter(saveTrialsFile));
+		}
+		boost::scoped_ptr<TrialReader> trialReader;
+		if (!replayFile.empty()) {
+			trialReader.reset(new TrialReader(replayFile));
+		}
+		
+		boost::shared_ptr<FILE> shardFile;
+		if (nShards > 0) {
+			shardFile = createShard(saved, shard, nShards);
+		}
+		// A merge reads the bins of every shard in order instead 
+		//	of simulating them
+		vector<boost::shared_ptr<FILE> > mergeFiles;
+		for(long k = 0; k < merge; k++) {
+			mergeFiles.push_back(openShard(saved, k, merge));
+		}
 		
-		for(vector<LightCurveType>::const_iterator curve = lcList.begin(); 
-				curve != lcList.end(); curve++) {
-			const string curName = *(lcNameList.begin() + (curve - lcList.begin()));
-			LcBinStats curBin(curName, limits, noiseStr, statList);
+		// Light curves analyzed on several cadences are generated once, 
+		//	on every time of any cadence, and subsampled for each
+		// The first cadence is the main one, and has no label
+		models::Cadence simTimes;
+		vector<models::Cadence> cadences;
+		vector<string> cadenceLabels;
+		vector<vector<size_t> > cadencePositions;
+		if (!injectMode) {
+			makeTimes(dateList, simTimes);
+		}
+		if (!cadenceFiles.empty() || !baselines.empty()) {
+			cadences.push_back(simTimes);
+			cadenceLabels.push_back("");
+			for(vector<string>::const_iterator it = cadenceFiles.begin(); 
+					it != cadenceFiles.end(); it++) {
+				models::Cadence extra;
+				makeTimes(*it, extra);
+				cadences.push_back(extra);
+				cadenceLabels.push_back(cadenceLabel(*it));
+			}
+			// Of the statistics, only the dmdt pair bins are carried 
+			//	over from the full date list (see DmdtPairIndex)
+			// The periodogram's frequency grid depends on the baseline, 
+			//	and the moments cost only O(N) per prefix, so both 
+			//	are calculated afresh on each prefix
+			for(vector<double>::const_iterator it = baselines.begin(); 
+					it != baselines.end(); it++) {
+				models::Cadence prefix;
+				models::truncateCadence(cadences.front(), *it, prefix);
+				cadences.push_back(prefix);
+				cadenceLabels.push_back(baselineLabel(*it));
+			}
+			models::mergeCadences(cadences, simTimes, cadencePositions);
+		}
+		// The noise of each trial is the same in every bin, and with 
+		//	--common-random in every light curve type
+		configureNoisePool(noisePool && merge == 0 && !trialReader, 
+			injectMode, seed, (commonRandom ? 1 : nCurves), 
+			streamOffset + shardFirst, streamOffset + shardLast, 
+			simTimes, sigma);
+		
+		// --tune times its candidates on light curves of the first bin, 
+		//	and remembers the fastest in --cache-dir
+		Tuning tuning(Tuning().batchFactor, statThreads);
+		if (tune && merge == 0 && !injectMode) {
+			if (gpStart == stats::GPSTART_PREVIOUS) {
+				fprintf(stderr, "WARNING: the results of '--gp-start previous' "
+					"depend on the threads, so --tune has no effect\n");
+			} else {
+				const string key = tuningKey(simTimes, costStats, nThreads);
+				const string tuningFile = (cacheDir.empty() ? string() 
+					: cacheDir + "/tuning.txt");
+				TuningTable table;
+				bool known = false;
+				if (!tuningFile.empty()) {
+					try {
+						known = table.read(tuningFile) && table.find(key, tuning);
+					} catch (const kpfutils::except::FileIo& e) {
+						fprintf(stderr, "WARNING: %s\n", e.what());
+					}
+				}
+				if (!known) {
+					configureGpStart(gpStart, grid.front());
+					const LcBinStats tuneBin(lcNameList.front(), grid.front(), 
+						noiseStr, statList, false, pgramMethod, false);
+					tuning = measureTuning(lcList.front(), 0, grid.front(), 
+						simTimes, sigma, magMode, seed, streamOffset, 
+						shardFirst, shardLast - shardFirst, nThreads, 
+						statThreads, tuneBin);
+					if (!tuningFile.empty()) {
+						table.record(key, tuning);
+						try {
+							// Fails harmlessly if the directory already exists
+							mkdir(cacheDir.c_str(), 0777);
+							table.write(tuningFile);
+						} catch (const kpfutils::except::FileIo& e) {
+							fprintf(stderr, "WARNING: %s\n", e.what());
+						}
+					}
+				}
+				fprintf(stderr, "Tuned: batches of %ld light curves per "
+					"thread, %ld statistic thread(s)%s\n", tuning.batchFactor, 
+					tuning.statThreads, (known ? ", as saved in --cache-dir" : ""));
+			}
+		}
+		stats::setStatThreads(tuning.statThreads);
+		
+		// Bins simulated ahead of the loop by --pack-bins
+		PackedBins packed;
+		
+		// Each bin of --grid runs every light curve type in turn, 
+		//	as a separate run with those ranges would
+		for(long binIndex = static_cast<long>(saved.rows.size()); 
+				binIndex < nBins; binIndex++) {
+			// Random numbers depend only on the light curve type, 
+			//	so that --seed reproduces the individual runs
+			// With --common-random, all types share one set of streams
+			const long curveIndex = binIndex % nCurves;
+			const long streamIndex = (commonRandom ? 0 : curveIndex);
+			const vector<LightCurveType>::const_iterator curve = 
+				lcList.begin() + curveIndex;
+			const string curName = *(lcNameList.begin() + curveIndex);
+			const RangeList& binLimits = grid[binIndex / nCurves];
+			configureGpStart(gpStart, binLimits);
+			LcBinStats curBin(curName, binLimits, noiseStr, statList, storeDistribs, 
+				pgramMethod, storeCurves);
+			const LcBinStats emptyBin(curName, binLimits, noiseStr, statList, 
+				storeDistribs, pgramMethod, storeCurves);
+			
+			if (merge > 0) {
+				// Shards cover consecutive blocks of trials, so 
+				//	merging them in order gives the order of a 
+				//	single-process run
+				for(long k = 0; k < merge; k++) {
+					LcBinStats part(emptyBin);
+					readShardBin(mergeFiles[k].get(), 
+						shardFileName(k, merge), part);
+					part.renumberParts(boost::lexical_cast<string>(k) + ".", 
+						curBin);
+					curBin.merge(part);
+				}
+				curBin.printBinStats(stdout);
+				curBin.printFailureReport(stderr);
+				continue;
+			}
+			
+			ResultKey binKey(runKey);
+			const std::time_t binWall = std::time(NULL);
+			if (resultCache) {
+				binKey.add(curName);
+				binKey.add(binLimits);
+				binKey.add(streamIndex);
+				if (resultCache->replay(binKey, stdout)) {
+					continue;
+				}
+			}
+			
+			progress.startBin(curName);
+			const string binLabel = LcBinStats::makeFileName(curName, 
+				binLimits, noiseStr);
+			TrialDumper dumper(dumpQueue, "lightcurve_" + binLabel + "_", 
+				numToPrint, printPolicy, printStat, seed);
+			if (trialWriter) {
+				trialWriter->startBin(binLabel, binLimits);
+			}
+			if (trialReader) {
+				trialReader->startBin(binLabel, binLimits);
+			}
+			const double binStart = stats::monotonicSeconds();
 			
-			for(long i = 0; i < nTrials; i++) {
-				// Set up noise or injection tests
-				vector<double> times, noise;
-				if (injectMode) {
-					makeInjectNoise(injectCat, times, noise);
+			// Light curves are always generated in order on this thread, 
+			//	so the random numbers used in each trial don't 
+			//	depend on nThreads
+			// Only the analysis is distributed, a batch at a time
+			// 16 light curves per thread per batch amortizes the cost 
+			//	of starting the threads without using much memory, 
+			//	unless --tune finds something faster
+			// Even a single thread uses batches, so that Gaussian 
+			//	processes can be computed together
+			const long batchSize = tuning.batchFactor*std::max(nThreads, 4L);
+			
+			if (distributed && !coordinator) {
+				// Each chunk is one batch, handed out to whichever 
+				//	worker is free, so that slow trials don't 
+				//	hold up the other workers
+				string result;
+				long first, last;
+				while (nextChunk(static_cast<int>(binIndex), result, 
+						first, last)) {
+					vector<SimTrial> batch(last - first);
+					double simTime = stats::monotonicSeconds();
+					stats::HardwareCounts simCounts = stats::threadCounts();
+					simTrials(*curve, streamIndex, binLimits, injectMode, 
+						injectCat, simTimes, sigma, magMode, seed, 
+						streamOffset, first, batch);
+					finishTrials(batch);
+					simTime = stats::monotonicSeconds() - simTime;
+					simCounts = stats::threadCounts() - simCounts;
+					
+					LcBinStats part(emptyBin);
+					part.addSimulationTime(simTime);
+					part.addSimulationCounts(simCounts);
+					const double analysisStart = stats::monotonicSeconds();
+					analyzeTrials(batch, nThreads, emptyBin, part);
+					const double analysisTime = stats::monotonicSeconds() 
+						- analysisStart;
+					dumper.offer(first, batch, part);
+					
+					// Only the summaries are sent back; distributions 
+					//	are written here, labeled by chunk
+					stats::setPartPrefix(boost::lexical_cast<string>(first) 
+						+ ".");
+					part.spill();
+					result = chunkResult(first, last, simTime, analysisTime, 
+						part);
+				}
+				dumpQueue.flush();
+				continue;
+			} else if (distributed) {
+				const long nWorkers = mpiSize() - 1;
+				coordinateBin(static_cast<int>(binIndex), nTrials, 
+					batchSize, costs.estimate(binLabel, costStats, nEpochs), 
+					emptyBin, curBin, progress);
+				curBin.printBinStats(stdout);
+				curBin.printFailureReport(stderr);
+				if (memoryReport) {
+					curBin.printMemoryReport(stderr);
+				}
+				if (!costsFile.empty()) {
+					// Charge each worker's share of the bin's time
+					costs.record(binLabel, costStats, nEpochs, nTrials, 
+						(stats::monotonicSeconds() - binStart) * nWorkers);
+					costs.write(costsFile);
+				}
+				continue;
+			}
+			
+			if (!cadences.empty()) {
+				// The main cadence keeps the usual bin; each extra 
+				//	cadence gets its own, named after its label
+				vector<string> cadenceNames(1, curName);
+				vector<LcBinStats> cadenceBins(1, emptyBin);
+				vector<boost::shared_ptr<TrialDumper> > cadenceDumpers;
+				for(vector<string>::const_iterator it = cadenceLabels.begin() + 1; 
+						it != cadenceLabels.end(); it++) {
+					cadenceNames.push_back(curName + "@" + *it);
+					cadenceBins.push_back(LcBinStats(cadenceNames.back(), 
+						binLimits, noiseStr, statList, storeDistribs, 
+						pgramMethod, storeCurves));
+				}
+				const vector<LcBinStats> cadenceEmpty(cadenceBins);
+				for(vector<string>::const_iterator it = cadenceNames.begin(); 
+						it != cadenceNames.end(); it++) {
+					cadenceDumpers.push_back(boost::shared_ptr<TrialDumper>(
+						new TrialDumper(dumpQueue, "lightcurve_" 
+						+ LcBinStats::makeFileName(*it, binLimits, noiseStr) 
+						+ "_", numToPrint, printPolicy, printStat, seed)));
+				}
+				
+				long unflushed = 0;
+				for(long first = 0, last = 0; first < nTrials; first = last) {
+					last = batchEnd(first, nTrials, batchSize);
+					
+					vector<SimTrial> batch(last - first);
+					double simTime = stats::monotonicSeconds();
+					stats::HardwareCounts simCounts = stats::threadCounts();
+					simTrials(*curve, streamIndex, binLimits, injectMode, 
+						injectCat, simTimes, sigma, magMode, seed, 
+						streamOffset, first, batch);
+					finishTrials(batch);
+					simTime = stats::monotonicSeconds() - simTime;
+					simCounts = stats::threadCounts() - simCounts;
+					
+					const double analysisStart = stats::monotonicSeconds();
+					unflushed += last - first;
+					const bool flush = (flushEvery > 0 && unflushed >= flushEvery);
+					for(size_t i = 0; i < cadenceBins.size(); i++) {
+						vector<SimTrial> part;
+						subsampleTrials(batch, cadences[i], cadencePositions[i], part);
+						analyzeTrials(part, nThreads, cadenceEmpty[i], cadenceBins[i]);
+						// Every cadence shares the cost of the simulation
+						cadenceBins[i].addSimulationTime(simTime 
+							/ static_cast<double>(cadenceBins.size()));
+						cadenceBins[i].addSimulationCounts(simCounts 
+							* (1.0 / static_cast<double>(cadenceBins.size())));
+						cadenceDumpers[i]->offer(first, part, cadenceBins[i]);
+						if (flush || (memoryLimit > 0.0 && cadenceBins[i].memoryBytes() 
+								> memoryLimit*1024.0*1024.0)) {
+							cadenceBins[i].spill();
+						}
+					}
+					if (flush) {
+						unflushed = 0;
+					}
+					progress.addBatch(last - first, simTime, 
+						stats::monotonicSeconds() - analysisStart);
+				}
+				
+				for(size_t i = 0; i < cadenceBins.size(); i++) {
+					cadenceDumpers[i]->finish();
+				}
+				dumpQueue.flush();
+				for(size_t i = 0; i < cadenceBins.size(); i++) {
+					cadenceBins[i].printBinStats(stdout);
+					cadenceBins[i].printFailureReport(stderr);
+					if (memoryReport) {
+						cadenceBins[i].printMemoryReport(stderr);
+					}
+				}
+				continue;
+			}
+			
+			// Light curves analyzed since the bin was last written out
+			long unflushed = 0;
+			long firstTrial = shardFirst;
+			if (resumed && saved.trial > 0) {
+				readCheckpointBin(checkpointFile, saved, curBin);
+				firstTrial = saved.trial;
+			}
+			const BatchFinisher finishBatch(curBin, progress, saved, 
+				unflushed, memoryLimit, flushEvery, checkpointFile, dumper);
+			
+			// While the pipeline runs, curBin and progress belong to 
+			//	its analysis thread
+			boost::scoped_ptr<TrialPipeline> pipeline;
+			if (pipelineDepth > 0) {
+				pipeline.reset(new TrialPipeline(pipelineDepth, nThreads, 
+					emptyBin, curBin, finishBatch));
+			}
+			
+			// Bins with few light curves are simulated together with 
+			//	the bins after them, and their light curves analyzed 
+			//	by one pool of threads
+			const long binTrials = shardLast - shardFirst;
+			if (packBins > 1 && !packed.has(binIndex) && firstTrial == shardFirst 
+					&& binTrials > 0 && binTrials <= batchSize) {
+				const long maxPacked = std::min(packBins, batchSize / binTrials);
+				long nPacked = 1;
+				while (nPacked < maxPacked && binIndex + nPacked < nBins 
+						&& sameGpStart(binLimits, 
+						grid[(binIndex + nPacked) / nCurves])) {
+					nPacked++;
+				}
+				
+				packed.first = binIndex;
+				packed.bins.clear();
+				packed.trials.clear();
+				packed.simSeconds.clear();
+				// Same order of simulation as running the bins in turn
+				for(long k = binIndex; k < binIndex + nPacked; k++) {
+					const long packCurve = k % nCurves;
+					const RangeList& packLimits = grid[k / nCurves];
+					packed.bins.push_back(LcBinStats(lcNameList[packCurve], 
+						packLimits, noiseStr, statList, storeDistribs, 
+						pgramMethod, storeCurves));
+					packed.trials.push_back(vector<SimTrial>(binTrials));
+					
+					const double simStart = stats::monotonicSeconds();
+					const stats::HardwareCounts simCounts = stats::threadCounts();
+					simTrials(lcList[packCurve], (commonRandom ? 0 : packCurve), 
+						packLimits, injectMode, injectCat, simTimes, sigma, 
+						magMode, seed, streamOffset, shardFirst, 
+						packed.trials.back());
+					finishTrials(packed.trials.back());
+					packed.simSeconds.push_back(stats::monotonicSeconds() - simStart);
+					// Not yet shared with any analysis thread
+					packed.bins.back().addSimulationCounts(
+						stats::threadCounts() - simCounts);
+				}
+				
+				const vector<LcBinStats> packedEmpty(packed.bins);
+				vector<BinJob> jobs;
+				for(size_t k = 0; k < packed.bins.size(); k++) {
+					jobs.push_back(BinJob(packed.trials[k], packedEmpty[k], 
+						packed.bins[k]));
+				}
+				const double analysisStart = stats::monotonicSeconds();
+				analyzeBins(jobs, nThreads);
+				packed.analysisSeconds = (stats::monotonicSeconds() - analysisStart) 
+					/ static_cast<double>(nPacked);
+			}
+			const bool packedBin = packed.has(binIndex);
+			if (packedBin) {
+				const size_t k = static_cast<size_t>(binIndex - packed.first);
+				curBin.merge(packed.bins[k]);
+				if (trialWriter) {
+					const stats::TraceSpan span("save trials");
+					for(size_t i = 0; i < packed.trials[k].size(); i++) {
+						trialWriter->write(shardFirst + static_cast<long>(i), 
+							packed.trials[k][i]);
+					}
+				}
+				finishBatch(shardFirst, packed.trials[k], packed.simSeconds[k], 
+					packed.analysisSeconds);
+				vector<SimTrial>().swap(packed.trials[k]);
+			}
+			
+			// With --target-error, the bin may stop before shardLast
+			long endTrial = shardLast;
+			// Packed bins have already been simulated and analyzed
+			const long loopFirst = (packedBin ? shardLast : firstTrial);
+			stats::HardwareCounts simCounts;
+			for(long first = loopFirst, last = loopFirst; first < shardLast; 
+					first = last) {
+				last = batchEnd(first, shardLast, batchSize);
+				
+				vector<SimTrial> batch(last - first);
+				// Timing is needed by both --profile and --progress, 
+				//	and costs only a few clock reads per batch
+				double simTime = stats::monotonicSeconds();
+				const stats::HardwareCounts simStart = stats::threadCounts();
+				if (trialReader) {
+					const stats::TraceSpan span("replay");
+					for(size_t i = 0; i < batch.size(); i++) {
+						trialReader->read(first + static_cast<long>(i), batch[i]);
+					}
 				} else {
-					makeTimes(dateList, times);
-					makeWhiteNoise(times, sigma, noise);
+					simTrials(*curve, streamIndex, binLimits, injectMode, 
+						injectCat, simTimes, sigma, magMode, seed, 
+						streamOffset, first, batch);
 				}
+				simTime = stats::monotonicSeconds() - simTime;
+				simCounts += stats::threadCounts() - simStart;
 				
-				models::ParamList params = drawParams(limits);
-	
-				// Generate the light curve
-				vector<double> lc;
-				simLightCurve(*curve, params, times, noise, lc);
+				// Read the next batch's observed light curves 
+				//	while this batch is analyzed
+				// At most one batch is read ahead, to bound memory use
+				if (injectMode && !trialReader && last < shardLast) {
+					prefetchInjectNoise(injectCat, seed, 
+						streamIndex, streamOffset + last, 
+						streamOffset + batchEnd(last, shardLast, batchSize));
+				}
+				const double finishStart = stats::monotonicSeconds();
+				const stats::HardwareCounts finishCounts = stats::threadCounts();
+				finishTrials(batch);
+				if (trialWriter) {
+					const stats::TraceSpan span("save trials");
+					for(size_t i = 0; i < batch.size(); i++) {
+						trialWriter->write(first + static_cast<long>(i), batch[i]);
+					}
+				}
+				simTime += stats::monotonicSeconds() - finishStart;
+				simCounts += stats::threadCounts() - finishCounts;
 	
 				// Collect the statistics
-				curBin.analyzeLightCurve(times, lc, params);
-	
-				// Print a few
-				if(i < numToPrint) {
-					string dumpFile = "lightcurve_" 
-						+ LcBinStats::makeFileName(curName, limits, 
-							noiseStr) 
-						+ "_" + boost::lexical_cast<string>(i) + ".dat";
-					printLightCurve(dumpFile, times, lc);
+				// The progress meter is updated only after all 
+				//	analysis threads have finished with the batch
+				if (pipeline) {
+					pipeline->push(first, batch, simTime);
+				} else {
+					const double analysisStart = stats::monotonicSeconds();
+					analyzeTrials(batch, nThreads, emptyBin, curBin);
+					finishBatch(first, batch, simTime, 
+						stats::monotonicSeconds() - analysisStart);
+				}
+				
+				if (targetError > 0.0 && last % TARGET_STEP == 0 
+						&& curBin.relativeError() <= targetError) {
+					endTrial = last;
+					break;
 				}
 			}	// end loop over simulations
+			if (pipeline) {
+				pipeline->finish();
+				pipeline->printReport(stderr, curName);
+			}
+			// Added only once the analysis thread is done with the bin
+			curBin.addSimulationCounts(simCounts);
+			// The result cache keeps copies of the printed light curves
+			dumper.finish();
+			dumpQueue.flush();
 	
-			curBin.printBinStats(stdout);
+			if (nShards > 0) {
+				// Everything must be on disk before the shard is merged
+				curBin.spill();
+				writeShardBin(shardFile.get(), curBin);
+			} else if (resultCache) {
+				resultCache->save(binKey, binLabel, 
+					printBinRow(stdout, curBin), binWall);
+			} else if (checkpointFile.empty()) {
+				curBin.printBinStats(stdout);
+			} else {
+				saved.rows.push_back(printBinRow(stdout, curBin));
+				saved.trial = 0;
+				writeCheckpoint(checkpointFile, saved, curBin);
+			}
+			curBin.printFailureReport(stderr);
+			if (memoryReport) {
+				curBin.printMemoryReport(stderr);
+			}
+			if (!costsFile.empty()) {
+				costs.record(binLabel, costStats, nEpochs, 
+					endTrial - firstTrial, 
+					stats::monotonicSeconds() - binStart);
+				costs.write(costsFile);
+			}
 	
 		}	// end loop over light curve types
+		
+		// Write the archive index before reporting success
+		stats::closeDistribArchive();
+		if (trialWriter) {
+			trialWriter->close();
+		}
+		stats::writeTrace();
+		reportGpIterations();
+		reportGpBinning();
+		reportNystromError();
+		reportSeasonError();
+		if (cacheReport) {
+			utils::printCacheReport(stderr);
+		}
 	
 	// End of program; use Pokemon exception handling to 
 	//	handle error messages gracefully
@@ -179,15 +1853,90 @@ int main(int argc, char* argv[]) {
 	} catch(parse::except::ParseError &e) {
 		// For consistency with default TCLAP output
 		fprintf(stderr, "PARSE ERROR: %s\n", e.what());
+		abortMpi(1);
 		return 1;
 	} catch(std::logic_error &e) {
 		fprintf(stderr, "BUG: %s\nPlease report this to the developer at krzys@astro.caltech.edu.\n", e.what());
+		abortMpi(1);
 		return 1;
 	} catch (const std::exception &e) {
 		fprintf(stderr, "ERROR: %s\n", e.what());
+		abortMpi(1);
 		return 1;
 	} catch (...) {
 		fprintf(stderr, "BUG: Unknown exception.\nPlease report this to the developer at krzys@astro.caltech.edu.\n");
+		abortMpi(1);
+		return 1;
+	}
+	
+	return 0;
+}
+
+/** Runs one job of --serve
+ *
+ * @param[in] argc, argv As for runJob().
+ *
+ * @return The exit status of runJob().
+ *
+ * @post Outputs left open by a failed job are closed, so that they 
+ *	cannot affect the next job.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+int serveJob(int argc, char* argv[]) {
+	const int status = runJob(argc, argv);
+	if (status != 0) {
+		try {
+			stats::closeDistribArchive();
+			stats::writeTrace();
+		} catch (const std::exception &e) {
+			fprintf(stderr, "WARNING: %s\n", e.what());
+		}
+	}
+	return status;
+}
+
+/** The driver for Lightcurve MC.
+ *
+ * With @c --serve as the only argument, the program reads one job per 
+ * line from standard input, each holding the arguments of a normal 
+ * run. With @c --serve @em socket, it reads jobs from clients of a 
+ * Unix domain socket instead. Either way, the R instance and every 
+ * in-memory cache stay warm from one job to the next.
+ *
+ * @param[in] argc, argv: an array of C-strings denoting the arguments, using the C 
+ *	convention
+ *
+ * @return 0 if successful, 1 if an error occurred
+ */
+int main(int argc, char* argv[]) {
+	// Does nothing unless built with MPI
+	MpiSession mpi(&argc, &argv);
+	
+	if (argc < 2 || string(argv[1]) != "--serve") {
+		return runJob(argc, argv);
+	}
+	
+	try {
+		if (mpiSize() > 1) {
+			throw parse::except::ParseError(
+				"--serve cannot run with several MPI processes.");
+		} else if (argc > 3) {
+			throw parse::except::ParseError(
+				"Usage: " + string(argv[0]) + " --serve [socket]");
+		}
+		
+		if (argc == 3) {
+			serveSocket(argv[2], argv[0], &serveJob);
+		} else {
+			serveJobs(stdin, stdout, argv[0], &serveJob);
+		}
+	} catch(parse::except::ParseError &e) {
+		fprintf(stderr, "PARSE ERROR: %s\n", e.what());
+		abortMpi(1);
+		return 1;
+	} catch (const std::exception &e) {
+		fprintf(stderr, "ERROR: %s\n", e.what());
 		return 1;
 	}
 	
@@ -2,7 +2,7 @@
  * @file lightcurveMC/except/undefined.cpp
  * @author Krzysztof Findeisen
  * @date Created May 5, 2013
- * @date Last modified June 18, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -120,4 +120,19 @@ double UpperBound::getBound() const {
 NotEnoughData::NotEnoughData(const string& what_arg) : Undefined(what_arg) {
 }
 
+/** Constructs a TimedOut object.
+ *
+ * @param[in] what_arg A string with the same content as the value 
+ *	returned by what().
+ *
+ * @post this->what() = @p what_arg.c_str()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	construct the exception.
+ * 
+ * @exceptsafe Object construction is atomic.
+ */
+TimedOut::TimedOut(const string& what_arg) : Undefined(what_arg) {
+}
+
 }}}		// end lcmc::stats::except
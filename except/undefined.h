@@ -2,7 +2,7 @@
  * @file lightcurveMC/except/undefined.h
  * @author Krzysztof Findeisen
  * @date Created May 5, 2013
- * @date Last modified June 18, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -90,6 +90,16 @@ public:
 	explicit NotEnoughData(const string& what_arg);
 };
 
+/** This exception is thrown if a statistic could not be calculated within 
+ *	its time limit
+ */
+class TimedOut : public Undefined {
+public:
+	/** Constructs a TimedOut object.
+	 */
+	explicit TimedOut(const string& what_arg);
+};
+
 }}}		// end lcmc::stats::except
 
 #endif		// end ifndef LCMCUNDEFEXCEPTH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/fluxmag.cpp
  * @author Krzysztof Findeisen
  * @date Created April 4, 2013
- * @date Last modified May 13, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,11 +31,20 @@
 #include <vector>
 #include <cmath>
 #include "fluxmag.h"
+#include "nan.h"
 
 namespace lcmc { namespace utils {
 
 using std::vector;
 
+// Both conversions are written in terms of natural logarithms and 
+//	exponentials, which vector math libraries provide for loops 
+//	over arrays; log10() and pow() usually have no vector form
+/** Magnitudes per e-folding of flux, -2.5/ln(10) */
+const double MAG_PER_LN = -1.0857362047581295691;
+/** e-foldings of flux per magnitude, -0.4 ln(10) */
+const double LN_PER_MAG = -0.92103403719761827361;
+
 /** Function for converting fluxes to magnitudes
  * 
  * @param[in] flux The flux to convert.
@@ -46,7 +55,7 @@ using std::vector;
  * @exceptsafe Does not throw exceptions.
  */
 double fluxToMag(double flux) {
-	return -2.5*log10(flux);
+	return MAG_PER_LN*log(flux);
 }
 
 /** Function for converting magnitudes to fluxes
@@ -58,7 +67,7 @@ double fluxToMag(double flux) {
  * @exceptsafe Does not throw exceptions.
  */
 double magToFlux(double mag) {
-	return pow(10.0, -0.4*mag);
+	return exp(LN_PER_MAG*mag);
 }
 
 /** Converts fluxes to magnitudes.
@@ -80,11 +89,11 @@ double magToFlux(double mag) {
 void fluxToMag(const vector<double>& fluxes, vector<double>& mags) {
 	using std::swap;
 	
-	// Explicit declaration to disambiguate which fluxToMag is being called
-	static double (* fp)(double) = fluxToMag;
-
 	vector<double> temp(fluxes.size());
-	std::transform(fluxes.begin(), fluxes.end(), temp.begin(), fp);
+	// &temp[0] is not defined for an empty vector
+	if (!temp.empty()) {
+		fluxToMag(&fluxes[0], &temp[0], temp.size());
+	}
 	
 	swap(mags, temp);
 }
@@ -108,13 +117,110 @@ void fluxToMag(const vector<double>& fluxes, vector<double>& mags) {
 void magToFlux(const vector<double>& mags, vector<double>& fluxes) {
 	using std::swap;
 
-	// Explicit declaration to disambiguate which magToFlux is being called
-	static double (* fp)(double) = magToFlux;
-
 	vector<double> temp(mags.size());
-	std::transform(mags.begin(), mags.end(), temp.begin(), fp);
+	// &temp[0] is not defined for an empty vector
+	if (!temp.empty()) {
+		magToFlux(&mags[0], &temp[0], temp.size());
+	}
 	
 	swap(fluxes, temp);
 }
 
+/** Converts an array of fluxes to magnitudes.
+ * 
+ * @param[in] fluxes An array of fluxes to convert.
+ * @param[out] mags An array in which to store the corresponding magnitudes.
+ * @param[in] n The number of elements in @p fluxes and @p mags.
+ *
+ * @pre @p mags may be the same array as @p fluxes
+ *
+ * @post for all i < @p n, @p mags[i] = @p fluxToMag(fluxes[i])
+ *
+ * @perform O(@p n) time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void fluxToMag(const double fluxes[], double mags[], size_t n) {
+	for(size_t i = 0; i < n; i++) {
+		mags[i] = MAG_PER_LN*log(fluxes[i]);
+	}
+}
+
+/** Converts an array of magnitudes to fluxes.
+ * 
+ * @param[in] mags An array of magnitudes to convert.
+ * @param[out] fluxes An array in which to store the corresponding fluxes.
+ * @param[in] n The number of elements in @p mags and @p fluxes.
+ *
+ * @pre @p fluxes may be the same array as @p mags
+ *
+ * @post for all i < @p n, @p fluxes[i] = @p magToFlux(mags[i])
+ *
+ * @perform O(@p n) time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void magToFlux(const double mags[], double fluxes[], size_t n) {
+	for(size_t i = 0; i < n; i++) {
+		fluxes[i] = exp(LN_PER_MAG*mags[i]);
+	}
+}
+
+/** Converts fluxes to magnitudes, keeping only the observations with 
+ *	a valid magnitude.
+ *
+ * This function does the work of fluxToMag() followed by removeNans() 
+ * in a single pass, one cache-sized block at a time, without storing 
+ * the magnitudes of the whole light curve.
+ * 
+ * @param[in] times The times at which the fluxes were measured.
+ * @param[in] fluxes The fluxes to convert. May contain NaNs.
+ * @param[out] validTimes The elements of @p times whose magnitudes 
+ *	are not NaN.
+ * @param[out] mags The magnitudes that are not NaN.
+ *
+ * @pre @p times.size() = @p fluxes.size()
+ * @pre @p validTimes and @p mags are distinct from each other and 
+ *	from @p times and @p fluxes
+ *
+ * @post @p validTimes.size() = @p mags.size() &le; @p fluxes.size()
+ * @post @p mags contains fluxToMag(@p fluxes[i]) for each i for which 
+ *	it is not NaN, in the same order as in @p fluxes, and 
+ *	@p validTimes contains the corresponding @p times[i].
+ *
+ * @perform O(N) time, where N = @p fluxes.size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to store the output.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void fluxToValidMags(const vector<double>& times, const vector<double>& fluxes, 
+		vector<double>& validTimes, vector<double>& mags) {
+	using std::swap;
+	
+	const size_t BLOCK = 256;
+	double blockMags[BLOCK];
+	
+	const size_t n = fluxes.size();
+	vector<double> tempTimes(n), tempMags(n);
+	
+	size_t nGood = 0;
+	for(size_t start = 0; start < n; start += BLOCK) {
+		const size_t nBlock = std::min(n - start, BLOCK);
+		fluxToMag(&fluxes[start], blockMags, nBlock);
+		
+		nGood += compactNotNan(blockMags, &times[start], nBlock, 
+				&tempMags[nGood], &tempTimes[nGood]);
+	}
+	// Shrinking a vector does not throw
+	tempTimes.resize(nGood);
+	tempMags .resize(nGood);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(validTimes, tempTimes);
+	swap(mags      , tempMags );
+}
+
 }}	// end lcmc::utils
@@ -2,7 +2,7 @@
  * @file lightcurveMC/fluxmag.h
  * @author Krzysztof Findeisen
  * @date Created April 4, 2013
- * @date Last modified April 11, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -34,6 +34,15 @@
 
 namespace lcmc { namespace utils {
 
+/** Identifies how the brightness of a light curve is represented
+ */
+enum PhotUnits {
+	/** Values are linear fluxes */
+	FLUX_UNITS, 
+	/** Values are magnitudes */
+	MAG_UNITS
+};
+
 /** Function for converting fluxes to magnitudes
  */
 double fluxToMag(double flux);
@@ -50,6 +59,21 @@ void fluxToMag(const std::vector<double>& fluxes, std::vector<double>& mags);
  */
 void magToFlux(const std::vector<double>& mags, std::vector<double>& fluxes);
 
+/** Converts an array of fluxes to magnitudes.
+ */
+void fluxToMag(const double fluxes[], double mags[], size_t n);
+
+/** Converts an array of magnitudes to fluxes.
+ */
+void magToFlux(const double mags[], double fluxes[], size_t n);
+
+/** Converts fluxes to magnitudes, keeping only the observations with 
+ *	a valid magnitude.
+ */
+void fluxToValidMags(const std::vector<double>& times, 
+		const std::vector<double>& fluxes, 
+		std::vector<double>& validTimes, std::vector<double>& mags);
+
 }}		// end lcmc::utils
 
 #endif 		// end LCMCFLUXMAGH
@@ -0,0 +1,185 @@
+/** Per-thread pools of reusable GSL workspaces
+ * @file lightcurveMC/gslpool.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gslpool.tmp.h"
+#include "largealloc.tmp.h"
+#include "../common/alloc.tmp.h"
+
+namespace lcmc { namespace utils {
+
+using kpfutils::checkAlloc;
+
+/** Allocates a workspace for an @p n &times; @p n matrix
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ */
+gsl_eigen_symmv_workspace* EigenSymmvTraits::alloc(size_t n) {
+	return checkAlloc(gsl_eigen_symmv_alloc(n));
+}
+
+/** Frees a workspace made by alloc()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void EigenSymmvTraits::destroy(gsl_eigen_symmv_workspace* x) {
+	gsl_eigen_symmv_free(x);
+}
+
+/** Names the pool in the cache report
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const char* EigenSymmvTraits::name() {
+	return "GSL eigen workspaces";
+}
+
+/** Allocates a vector with @p n elements
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ */
+gsl_vector* VectorTraits::alloc(size_t n) {
+	return checkAlloc(gsl_vector_alloc(n));
+}
+
+/** Frees a vector made by alloc()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void VectorTraits::destroy(gsl_vector* x) {
+	gsl_vector_free(x);
+}
+
+/** Names the pool in the cache report
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const char* VectorTraits::name() {
+	return "GSL vectors";
+}
+
+/** Allocates an @p n &times; @p n matrix
+ *
+ * The elements are allocated by largeAlloc(), since pooled matrices 
+ * are as large as the covariance matrices they copy.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ */
+gsl_matrix* SquareMatrixTraits::alloc(size_t n) {
+	return checkAlloc(largeMatrixAlloc(n, n));
+}
+
+/** Frees a matrix made by alloc()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void SquareMatrixTraits::destroy(gsl_matrix* x) {
+	gsl_matrix_free(x);
+}
+
+/** Names the pool in the cache report
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const char* SquareMatrixTraits::name() {
+	return "GSL matrices";
+}
+
+/** Allocates a workspace for transforms of length @p n
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ */
+gsl_fft_real_workspace* FftWorkspaceTraits::alloc(size_t n) {
+	return checkAlloc(gsl_fft_real_workspace_alloc(n));
+}
+
+/** Frees a workspace made by alloc()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void FftWorkspaceTraits::destroy(gsl_fft_real_workspace* x) {
+	gsl_fft_real_workspace_free(x);
+}
+
+/** Names the pool in the cache report
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const char* FftWorkspaceTraits::name() {
+	return "GSL FFT workspaces";
+}
+
+/** Allocates a wavetable for transforms of length @p n
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ */
+gsl_fft_real_wavetable* FftRealTableTraits::alloc(size_t n) {
+	return checkAlloc(gsl_fft_real_wavetable_alloc(n));
+}
+
+/** Frees a wavetable made by alloc()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void FftRealTableTraits::destroy(gsl_fft_real_wavetable* x) {
+	gsl_fft_real_wavetable_free(x);
+}
+
+/** Names the pool in the cache report
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const char* FftRealTableTraits::name() {
+	return "GSL FFT wavetables";
+}
+
+/** Allocates a wavetable for transforms of length @p n
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ */
+gsl_fft_halfcomplex_wavetable* FftHalfcomplexTableTraits::alloc(size_t n) {
+	return checkAlloc(gsl_fft_halfcomplex_wavetable_alloc(n));
+}
+
+/** Frees a wavetable made by alloc()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void FftHalfcomplexTableTraits::destroy(gsl_fft_halfcomplex_wavetable* x) {
+	gsl_fft_halfcomplex_wavetable_free(x);
+}
+
+/** Names the pool in the cache report
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const char* FftHalfcomplexTableTraits::name() {
+	return "GSL inverse FFT wavetables";
+}
+
+}}		// end lcmc::utils
@@ -0,0 +1,313 @@
+/** Per-thread pools of reusable GSL workspaces
+ * @file lightcurveMC/gslpool.tmp.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCGSLPOOLH
+#define LCMCGSLPOOLH
+
+#include <cstddef>
+#include <boost/thread/tss.hpp>
+#include <gsl/gsl_eigen.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+#include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include "cachestats.h"
+
+namespace lcmc { namespace utils {
+
+/** Describes how to allocate and free an eigenvector workspace for 
+ *	gsl_eigen_symmv()
+ */
+struct EigenSymmvTraits {
+	/** The type of object pooled */
+	typedef gsl_eigen_symmv_workspace Object;
+	/** Allocates a workspace for an @p n &times; @p n matrix */
+	static Object* alloc(size_t n);
+	/** Frees a workspace made by alloc() */
+	static void destroy(Object* x);
+	/** Names the pool in the cache report */
+	static const char* name();
+};
+
+/** Describes how to allocate and free a GSL vector
+ */
+struct VectorTraits {
+	/** The type of object pooled */
+	typedef gsl_vector Object;
+	/** Allocates a vector with @p n elements */
+	static Object* alloc(size_t n);
+	/** Frees a vector made by alloc() */
+	static void destroy(Object* x);
+	/** Names the pool in the cache report */
+	static const char* name();
+};
+
+/** Describes how to allocate and free a square GSL matrix
+ */
+struct SquareMatrixTraits {
+	/** The type of object pooled */
+	typedef gsl_matrix Object;
+	/** Allocates an @p n &times; @p n matrix */
+	static Object* alloc(size_t n);
+	/** Frees a matrix made by alloc() */
+	static void destroy(Object* x);
+	/** Names the pool in the cache report */
+	static const char* name();
+};
+
+/** Describes how to allocate and free a real FFT workspace
+ */
+struct FftWorkspaceTraits {
+	/** The type of object pooled */
+	typedef gsl_fft_real_workspace Object;
+	/** Allocates a workspace for transforms of length @p n */
+	static Object* alloc(size_t n);
+	/** Frees a workspace made by alloc() */
+	static void destroy(Object* x);
+	/** Names the pool in the cache report */
+	static const char* name();
+};
+
+/** Describes how to allocate and free the wavetable of a forward 
+ *	real FFT
+ */
+struct FftRealTableTraits {
+	/** The type of object pooled */
+	typedef gsl_fft_real_wavetable Object;
+	/** Allocates a wavetable for transforms of length @p n */
+	static Object* alloc(size_t n);
+	/** Frees a wavetable made by alloc() */
+	static void destroy(Object* x);
+	/** Names the pool in the cache report */
+	static const char* name();
+};
+
+/** Describes how to allocate and free the wavetable of an inverse 
+ *	half-complex FFT
+ */
+struct FftHalfcomplexTableTraits {
+	/** The type of object pooled */
+	typedef gsl_fft_halfcomplex_wavetable Object;
+	/** Allocates a wavetable for transforms of length @p n */
+	static Object* alloc(size_t n);
+	/** Frees a wavetable made by alloc() */
+	static void destroy(Object* x);
+	/** Names the pool in the cache report */
+	static const char* name();
+};
+
+/** GslPool holds the GSL objects of one type that a thread is not 
+ * currently using, keyed by size.
+ *
+ * A pool keeps at most @ref SLOTS idle objects, and frees the least 
+ * recently returned one to make room for another. Simulations 
+ * typically use one or two sizes per type, so the objects for those 
+ * sizes stay in the pool.
+ *
+ * @tparam Traits A class like EigenSymmvTraits, declaring the pooled 
+ *	type @c Object and the static functions @c alloc(size_t), 
+ *	@c destroy(Object*), and @c name().
+ */
+template <class Traits>
+class GslPool {
+public:
+	/** The type of object pooled */
+	typedef typename Traits::Object Object;
+
+	/** Returns the calling thread's pool
+	 *
+	 * @return A pool private to the calling thread, created on first 
+	 *	use and freed when the thread exits.
+	 *
+	 * @exception std::bad_alloc Thrown if the pool could not be created.
+	 *
+	 * @exceptsafe The program state is unchanged in the event of an 
+	 *	exception.
+	 */
+	static GslPool& forThread() {
+		static boost::thread_specific_ptr<GslPool> pools;
+		if (pools.get() == NULL) {
+			pools.reset(new GslPool());
+		}
+		return *pools;
+	}
+
+	/** Frees every idle object
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	~GslPool() {
+		for(size_t i = 0; i < nIdle; i++) {
+			Traits::destroy(objects[i]);
+		}
+	}
+
+	/** Removes an idle object of a given size from the pool
+	 *
+	 * @param[in] n The size of the object wanted.
+	 *
+	 * @return An object made by <tt>Traits::alloc(n)</tt>, or NULL if 
+	 *	the pool has none idle.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	Object* take(size_t n) {
+		// Search from the most recently returned object
+		for(size_t i = nIdle; i > 0; i--) {
+			if (sizes[i-1] == n) {
+				Object* const found = objects[i-1];
+				for(size_t j = i; j < nIdle; j++) {
+					sizes  [j-1] = sizes  [j];
+					objects[j-1] = objects[j];
+				}
+				nIdle--;
+				return found;
+			}
+		}
+		return NULL;
+	}
+
+	/** Adds an object to the pool
+	 *
+	 * @param[in] n The size of @p x.
+	 * @param[in] x An object made by <tt>Traits::alloc(n)</tt>. The 
+	 *	pool takes ownership of it.
+	 *
+	 * @post If the pool was full, its least recently returned object 
+	 *	has been freed.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void put(size_t n, Object* x) {
+		if (nIdle == SLOTS) {
+			Traits::destroy(objects[0]);
+			for(size_t j = 1; j < nIdle; j++) {
+				sizes  [j-1] = sizes  [j];
+				objects[j-1] = objects[j];
+			}
+			nIdle--;
+		}
+		sizes  [nIdle] = n;
+		objects[nIdle] = x;
+		nIdle++;
+	}
+
+private:
+	/** Creates an empty pool
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	GslPool() : nIdle(0) {
+	}
+
+	// Pools own their objects, and are only accessed through forThread()
+	GslPool(const GslPool&);
+	GslPool& operator=(const GslPool&);
+
+	/** The most idle objects kept */
+	static const size_t SLOTS = 4;
+
+	/** The number of elements of @ref objects in use */
+	size_t nIdle;
+	/** The size of each idle object */
+	size_t sizes[SLOTS];
+	/** The idle objects, from least to most recently returned */
+	Object* objects[SLOTS];
+};
+
+/** GslLease borrows a GSL object from the calling thread's GslPool for 
+ * the lifetime of one scope.
+ *
+ * The object's contents are left over from its previous user, so it 
+ * must be completely overwritten before being read.
+ *
+ * @tparam Traits A class like EigenSymmvTraits describing the type 
+ *	of object to borrow.
+ */
+template <class Traits>
+class GslLease {
+public:
+	/** The type of object borrowed */
+	typedef typename Traits::Object Object;
+
+	/** Borrows an object of a given size
+	 *
+	 * @param[in] n The size of the object to borrow, as passed to 
+	 *	<tt>Traits::alloc()</tt>.
+	 *
+	 * @exception std::bad_alloc Thrown if a new object is needed and 
+	 *	there is not enough memory for it.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	explicit GslLease(size_t n) : n(n), object(NULL) {
+		static CacheCounter counter(Traits::name());
+		
+		object = GslPool<Traits>::forThread().take(n);
+		if (object != NULL) {
+			counter.hit();
+		} else {
+			const CacheMiss miss(counter);
+			object = Traits::alloc(n);
+		}
+	}
+
+	/** Returns the object to the pool
+	 *
+	 * @pre The object is destroyed on the thread that created it
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	~GslLease() {
+		GslPool<Traits>::forThread().put(n, object);
+	}
+
+	/** Returns the borrowed object
+	 *
+	 * @return An object that the caller may use freely until the 
+	 *	lease is destroyed.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	Object* get() const {
+		return object;
+	}
+
+private:
+	// Each lease returns its object exactly once
+	GslLease(const GslLease&);
+	GslLease& operator=(const GslLease&);
+
+	size_t n;
+	Object* object;
+};
+
+}}		// end lcmc::utils
+
+#endif		// end LCMCGSLPOOLH
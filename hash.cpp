@@ -0,0 +1,68 @@
+/** Functions for identifying data by hashing
+ * @file lightcurveMC/hash.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/cstdint.hpp>
+#include "hash.h"
+
+namespace lcmc { namespace utils {
+
+using boost::uint64_t;
+
+/** Returns the starting value of an FNV-1a hash
+ *
+ * @return The FNV-1a 64-bit offset basis, 0xcbf29ce484222325.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint64_t fnvBasis() {
+	return (static_cast<uint64_t>(0xcbf29ce4UL) << 32) + 0x84222325UL;
+}
+
+/** Updates an FNV-1a hash with a block of memory
+ *
+ * @param[in] hash The hash of all previous data.
+ * @param[in] data, n The bytes to add to the hash.
+ *
+ * @return The hash of the previous data followed by @p data.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint64_t fnvHash(uint64_t hash, const void* data, size_t n) {
+	// FNV-1a 64-bit prime, 2^40 + 2^8 + 0xb3
+	const uint64_t prime = (static_cast<uint64_t>(1) << 40) + 0x1b3;
+
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for(size_t i = 0; i < n; i++) {
+		hash ^= bytes[i];
+		hash *= prime;
+	}
+	return hash;
+}
+
+}}		// end lcmc::utils
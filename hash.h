@@ -0,0 +1,48 @@
+/** Functions for identifying data by hashing
+ * @file lightcurveMC/hash.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCHASHH
+#define LCMCHASHH
+
+#include <cstddef>
+#include <boost/cstdint.hpp>
+
+namespace lcmc { namespace utils {
+
+/** Returns the starting value of an FNV-1a hash
+ */
+boost::uint64_t fnvBasis();
+
+/** Updates an FNV-1a hash with a block of memory
+ */
+boost::uint64_t fnvHash(boost::uint64_t hash, const void* data, size_t n);
+
+}}		// end lcmc::utils
+
+#endif		// end LCMCHASHH
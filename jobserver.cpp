@@ -0,0 +1,382 @@
+/** Runs many jobs in one long-lived process
+ * @file lightcurveMC/jobserver.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "jobserver.h"
+#include "../common/cerror.h"
+
+namespace lcmc {
+
+using std::string;
+using std::vector;
+
+/** Printed after the output of each job, followed by its exit status */
+const char END_MARKER[] = "# done ";
+
+namespace {
+
+/** Closes a file descriptor when it goes out of scope
+ */
+class Descriptor {
+public:
+	explicit Descriptor(int fd) : fd(fd) {}
+	~Descriptor() {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+	int get() const {
+		return fd;
+	}
+	
+private:
+	// Descriptors have a single owner
+	Descriptor(const Descriptor&);
+	Descriptor& operator=(const Descriptor&);
+	
+	int fd;
+};
+
+/** Reads one line of text, of any length
+ *
+ * @param[in] input The stream to read.
+ * @param[out] line The line, without its end-of-line characters.
+ *
+ * @return False if the stream ended before any characters were read.
+ *
+ * @exception std::runtime_error Thrown if @p input could not be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the line.
+ *
+ * @exceptsafe @p line is unchanged in the event of an exception.
+ */
+bool readLine(FILE* input, string& line) {
+	string temp;
+	char buffer[4096];
+	bool any = false;
+	while (fgets(buffer, sizeof(buffer), input) != NULL) {
+		any = true;
+		temp += buffer;
+		if (!temp.empty() && temp[temp.size()-1] == '\n') {
+			break;
+		}
+	}
+	if (ferror(input)) {
+		kpfutils::cError("Could not read job: ");
+	}
+	
+	while (!temp.empty() && (temp[temp.size()-1] == '\n' 
+			|| temp[temp.size()-1] == '\r')) {
+		temp.erase(temp.size()-1);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	line.swap(temp);
+	return any;
+}
+
+/** Redirects standard output and error to a client connection, and 
+ *	restores them when it goes out of scope
+ */
+class Redirect {
+public:
+	explicit Redirect(int fd) : savedOut(dup(STDOUT_FILENO)), 
+			savedErr(dup(STDERR_FILENO)) {
+		if (savedOut.get() < 0 || savedErr.get() < 0) {
+			kpfutils::cError("Could not redirect output: ");
+		}
+		fflush(stdout);
+		fflush(stderr);
+		if (dup2(fd, STDOUT_FILENO) < 0 || dup2(fd, STDERR_FILENO) < 0) {
+			restore();
+			kpfutils::cError("Could not redirect output: ");
+		}
+	}
+	~Redirect() {
+		restore();
+	}
+	
+private:
+	// Redirects have a single owner
+	Redirect(const Redirect&);
+	Redirect& operator=(const Redirect&);
+	
+	void restore() {
+		fflush(stdout);
+		fflush(stderr);
+		dup2(savedOut.get(), STDOUT_FILENO);
+		dup2(savedErr.get(), STDERR_FILENO);
+		// A client that hung up leaves the error flags set
+		clearerr(stdout);
+		clearerr(stderr);
+	}
+	
+	Descriptor savedOut;
+	Descriptor savedErr;
+};
+
+}	// end unnamed namespace
+
+/** Splits one job specification into command-line arguments
+ *
+ * The specification uses a small subset of shell syntax: arguments are 
+ * separated by whitespace, may be quoted with single or double quotes, 
+ * and may contain a backslash-escaped character outside single quotes.
+ *
+ * @param[in] line The job specification, without the program name.
+ * @param[out] words The arguments, in order, with quotes and escapes 
+ *	removed.
+ *
+ * @exception std::invalid_argument Thrown if @p line ends inside a 
+ *	quote or after a backslash.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the arguments.
+ *
+ * @exceptsafe @p words is unchanged in the event of an exception.
+ */
+void splitJobLine(const string& line, vector<string>& words) {
+	vector<string> temp;
+	string word;
+	// Distinguishes '' from no argument at all
+	bool inWord = false;
+	char quote = '\0';
+	
+	for(size_t i = 0; i < line.size(); i++) {
+		const char c = line[i];
+		if (quote == '\'') {
+			if (c == '\'') {
+				quote = '\0';
+			} else {
+				word += c;
+			}
+		} else if (c == '\\') {
+			if (i+1 >= line.size()) {
+				throw std::invalid_argument("Job ends with a backslash: " + line);
+			}
+			word += line[++i];
+			inWord = true;
+		} else if (quote == '"') {
+			if (c == '"') {
+				quote = '\0';
+			} else {
+				word += c;
+			}
+		} else if (c == '\'' || c == '"') {
+			quote = c;
+			inWord = true;
+		} else if (c == ' ' || c == '\t') {
+			if (inWord) {
+				temp.push_back(word);
+				word.clear();
+				inWord = false;
+			}
+		} else {
+			word += c;
+			inWord = true;
+		}
+	}
+	if (quote != '\0') {
+		throw std::invalid_argument("Job has an unmatched quote: " + line);
+	}
+	if (inWord) {
+		temp.push_back(word);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	words.swap(temp);
+}
+
+/** Runs jobs read from a stream until the stream ends
+ *
+ * Each line of @p input holds the arguments of one job, exactly as 
+ * they would follow the program name on the command line. Blank lines 
+ * and lines starting with @c # are ignored, and a line holding only 
+ * @c quit stops the server.
+ *
+ * Each job prints its results to standard output as a separate run 
+ * would, followed by a line with @ref END_MARKER and the job's exit 
+ * status, so that a client knows when the job is finished.
+ *
+ * @param[in] input The stream of job specifications.
+ * @param[in] output The stream on which to mark the end of each job. 
+ *	Should be the standard output written by @p runJob.
+ * @param[in] progName The program name to pass to @p runJob.
+ * @param[in] runJob The function that runs each job.
+ *
+ * @return True if the input asked the server to stop, false if the 
+ *	input ended.
+ *
+ * @perform Everything calculated or read in memory by one job, such 
+ *	as the R instance, cadences, periodogram thresholds, and 
+ *	covariance factorizations, is reused by later jobs.
+ *
+ * @exception std::runtime_error Thrown if @p input or @p output could 
+ *	not be used.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read a job.
+ *
+ * @exceptsafe The jobs already finished are unaffected by an exception.
+ */
+bool serveJobs(FILE* input, FILE* output, const string& progName, 
+		JobRunner runJob) {
+	string line;
+	while (readLine(input, line)) {
+		int status = 1;
+		vector<string> words;
+		bool parsed = true;
+		try {
+			splitJobLine(line, words);
+		} catch (const std::invalid_argument& e) {
+			// For consistency with the command-line errors
+			fprintf(stderr, "PARSE ERROR: %s\n", e.what());
+			parsed = false;
+		}
+		
+		if (parsed) {
+			if (words.empty() || words.front().compare(0, 1, "#") == 0) {
+				continue;
+			} else if (words.size() == 1 && words.front() == "quit") {
+				return true;
+			}
+			
+			// argv must be modifiable, so copy each argument
+			words.insert(words.begin(), progName);
+			vector<vector<char> > buffers;
+			for(vector<string>::const_iterator it = words.begin(); 
+					it != words.end(); it++) {
+				buffers.push_back(vector<char>(it->begin(), it->end()));
+				buffers.back().push_back('\0');
+			}
+			vector<char*> argv;
+			for(size_t i = 0; i < buffers.size(); i++) {
+				argv.push_back(&buffers[i][0]);
+			}
+			argv.push_back(NULL);
+			
+			status = runJob(static_cast<int>(words.size()), &argv[0]);
+		}
+		
+		fflush(stderr);
+		if (fprintf(output, "%s%d\n", END_MARKER, status) < 0 
+				|| fflush(output) != 0) {
+			kpfutils::cError("Could not finish job: ");
+		}
+	}
+	return false;
+}
+
+/** Runs jobs sent by clients of a local socket
+ *
+ * Clients are served one at a time, in the order they connect. Each 
+ * client sends jobs as for serveJobs(), and receives the standard 
+ * output and standard error of its jobs on the same connection. The 
+ * server stops when a client sends @c quit.
+ *
+ * @param[in] path The file name of the Unix domain socket. A socket 
+ *	left by an earlier server is replaced.
+ * @param[in] progName, runJob As for serveJobs().
+ *
+ * @post The socket file is removed when the server stops.
+ *
+ * @exception std::invalid_argument Thrown if @p path is too long for 
+ *	a socket name.
+ * @exception std::runtime_error Thrown if the socket could not be 
+ *	created or used.
+ *
+ * @exceptsafe The jobs already finished are unaffected by an exception.
+ */
+void serveSocket(const string& path, const string& progName, JobRunner runJob) {
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	if (path.size() >= sizeof(address.sun_path)) {
+		throw std::invalid_argument("Socket name is too long: " + path);
+	}
+	address.sun_family = AF_UNIX;
+	std::strcpy(address.sun_path, path.c_str());
+	
+	// Write errors from clients that hung up are reported by the jobs
+	signal(SIGPIPE, SIG_IGN);
+	
+	// Never replace anything but a stale socket
+	struct stat info;
+	if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+		unlink(path.c_str());
+	}
+	
+	const Descriptor server(socket(AF_UNIX, SOCK_STREAM, 0));
+	if (server.get() < 0 
+			|| bind(server.get(), reinterpret_cast<sockaddr*>(&address), 
+				sizeof(address)) != 0 
+			|| listen(server.get(), 8) != 0) {
+		kpfutils::cError("Could not open socket " + path + ": ");
+	}
+	
+	bool quit = false;
+	while (!quit) {
+		const int client = accept(server.get(), NULL, NULL);
+		if (client < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			unlink(path.c_str());
+			kpfutils::cError("Could not accept connection on " + path + ": ");
+		}
+		FILE* const input = fdopen(client, "r");
+		if (input == NULL) {
+			close(client);
+			continue;
+		}
+		
+		try {
+			const Redirect redirect(client);
+			quit = serveJobs(input, stdout, progName, runJob);
+		} catch (const std::runtime_error& e) {
+			// The client went away; wait for the next one
+			fprintf(stderr, "WARNING: %s\n", e.what());
+		}
+		fclose(input);
+	}
+	
+	unlink(path.c_str());
+}
+
+}		// end lcmc
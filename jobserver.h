@@ -0,0 +1,61 @@
+/** Runs many jobs in one long-lived process
+ * @file lightcurveMC/jobserver.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCJOBSERVERH
+#define LCMCJOBSERVERH
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+namespace lcmc {
+
+/** Type of a function that runs one job from its command line, using 
+ * the conventions of main(), and returns its exit status
+ */
+typedef int (*JobRunner)(int argc, char* argv[]);
+
+/** Splits one job specification into command-line arguments
+ */
+void splitJobLine(const std::string& line, std::vector<std::string>& words);
+
+/** Runs jobs read from a stream until the stream ends
+ */
+bool serveJobs(FILE* input, FILE* output, const std::string& progName, 
+	JobRunner runJob);
+
+/** Runs jobs sent by clients of a local socket
+ */
+void serveSocket(const std::string& path, const std::string& progName, 
+	JobRunner runJob);
+
+}		// end lcmc
+
+#endif		// end LCMCJOBSERVERH
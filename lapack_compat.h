@@ -0,0 +1,46 @@
+/** Compatibility definitions to allow the program to interface
+ *	with LAPACK
+ * @file lightcurveMC/lapack_compat.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCLAPACKH
+#define LCMCLAPACKH
+
+#include <string>
+
+//----------------------------------------------------------
+// Fortran interface
+// Only defined if the program is built with LINALG = lapack (see makefile.inc)
+
+#ifdef LCMC_USE_LAPACK
+
+extern "C" {
+
+/** Computes selected eigenvalues and eigenvectors of a real symmetric
+ *	matrix using the Relatively Robust Representations algorithm
+ */
+void dsyevr_(const char* jobz, const char* range, const char* uplo,
+		const int* n, double* a, const int* lda,
+		const double* vl, const double* vu, const int* il, const int* iu,
+		const double* abstol, int* m, double* w, double* z, const int* ldz,
+		int* isuppz, double* work, const int* lwork,
+		int* iwork, const int* liwork, int* info);
+
+/** Computes the Cholesky factorization of a real symmetric positive
+ *	definite matrix
+ */
+void dpotrf_(const char* uplo, const int* n, double* a, const int* lda,
+		int* info);
+
+}
+
+#endif		// end ifdef LCMC_USE_LAPACK
+
+/** Wrapper that throws @c std::runtime_error in response to a LAPACK error
+ */
+void lapackCheck(int info, std::string msg);
+
+#endif		// end LCMCLAPACKH
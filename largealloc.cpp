@@ -0,0 +1,203 @@
+/** Aligned, huge-page-backed allocation of large buffers
+ * @file lightcurveMC/largealloc.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <gsl/gsl_block.h>
+#include <gsl/gsl_matrix.h>
+#include "largealloc.tmp.h"
+
+namespace lcmc { namespace utils {
+
+/** The size of a transparent huge page on x86-64 and most ARM systems
+ */
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/** The alignment of every block from largeAlloc(), enough for one 
+ *	cache line or one AVX-512 register
+ */
+const size_t LARGE_ALIGNMENT = 64;
+
+/** Returns the flag set by setHugePages()
+ *
+ * @return A modifiable flag, initially true.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& hugePageFlag() {
+	static bool use = true;
+	return use;
+}
+
+/** Sets whether large buffers are placed on huge pages
+ *
+ * Covariance matrices, their factorizations, and the tables cached for 
+ * each cadence span many megabytes, and are read in full by every 
+ * matrix-vector product or pass over the pairs. On normal pages, each 
+ * pass misses the TLB once every 4 KB; a 2 MB huge page covers 512 
+ * times as much memory per TLB entry.
+ *
+ * @param[in] use If true, blocks of at least 2 MB from largeAlloc() 
+ *	are aligned to huge page boundaries, and the kernel is asked to 
+ *	back them with transparent huge pages.
+ *
+ * @post hugePages() returns @p use.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Has no effect on blocks already allocated. The request is 
+ *	advisory: the operating system may still use normal pages, for 
+ *	example if transparent huge pages are disabled or memory is 
+ *	fragmented.
+ */
+void setHugePages(bool use) {
+	hugePageFlag() = use;
+}
+
+/** Returns the choice made with setHugePages()
+ *
+ * @return The value passed to setHugePages(), or true if it has not 
+ *	been called.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool hugePages() {
+	return hugePageFlag();
+}
+
+/** Allocates a block of memory aligned for vector instructions, on 
+ *	huge pages if it is large enough
+ *
+ * @param[in] bytes The size of the block.
+ *
+ * @return A pointer to at least @p bytes bytes of uninitialized memory, 
+ *	or NULL if there is not enough memory. The block is aligned to 
+ *	64 bytes, and to 2 MB if hugePages() is true and @p bytes is at 
+ *	least 2 MB.
+ *
+ * @perform Constant time. Huge pages are requested with madvise(), 
+ *	which does not touch the block.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void* largeAlloc(size_t bytes) {
+	const bool huge = hugePages() && bytes >= HUGE_PAGE_SIZE;
+	void* block = NULL;
+	if (posix_memalign(&block, (huge ? HUGE_PAGE_SIZE : LARGE_ALIGNMENT), 
+			std::max<size_t>(bytes, 1)) != 0) {
+		return NULL;
+	}
+#ifdef MADV_HUGEPAGE
+	if (huge) {
+		// A refusal only means the block stays on normal pages
+		madvise(block, bytes, MADV_HUGEPAGE);
+	}
+#endif
+	return block;
+}
+
+/** Frees a block allocated by largeAlloc()
+ *
+ * @param[in] block A pointer returned by largeAlloc(), or NULL.
+ *
+ * @post The memory pointed to by @p block may be reused.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void largeFree(void* block) {
+	free(block);
+}
+
+/** Allocates a matrix whose elements are allocated by largeAlloc()
+ *
+ * The matrix is laid out exactly as by gsl_matrix_alloc(), and may be 
+ * freed with gsl_matrix_free(). GSL frees the matrix, its block, and 
+ * the block's elements with free(), which also frees memory from 
+ * posix_memalign().
+ *
+ * @param[in] n1, n2 The dimensions of the matrix.
+ *
+ * @return A pointer to a new @p n1 &times; @p n2 matrix with 
+ *	uninitialized elements, or NULL if there is not enough memory.
+ *
+ * @perform Constant time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+gsl_matrix* largeMatrixAlloc(size_t n1, size_t n2) {
+	if (n2 > 0 && n1 > std::numeric_limits<size_t>::max() / sizeof(double) / n2) {
+		return NULL;
+	}
+	
+	gsl_matrix* const m     = static_cast<gsl_matrix*>(malloc(sizeof(gsl_matrix)));
+	gsl_block*  const block = static_cast<gsl_block* >(malloc(sizeof(gsl_block )));
+	double*     const data  = static_cast<double*>(largeAlloc(n1 * n2 * sizeof(double)));
+	if (m == NULL || block == NULL || data == NULL) {
+		free(m);
+		free(block);
+		largeFree(data);
+		return NULL;
+	}
+	
+	block->size = n1 * n2;
+	block->data = data;
+	m->size1 = n1;
+	m->size2 = n2;
+	m->tda   = n2;
+	m->data  = data;
+	m->block = block;
+	m->owner = 1;
+	return m;
+}
+
+/** Allocates a matrix whose elements are allocated by largeAlloc(), 
+ *	and sets every element to zero
+ *
+ * @param[in] n1, n2 The dimensions of the matrix.
+ *
+ * @return A pointer to a new @p n1 &times; @p n2 matrix of zeros, 
+ *	which may be freed with gsl_matrix_free(), or NULL if there is 
+ *	not enough memory.
+ *
+ * @perform O(@p n1 &times; @p n2) time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+gsl_matrix* largeMatrixCalloc(size_t n1, size_t n2) {
+	gsl_matrix* const m = largeMatrixAlloc(n1, n2);
+	if (m != NULL) {
+		std::fill(m->data, m->data + n1 * n2, 0.0);
+	}
+	return m;
+}
+
+}}		// end lcmc::utils
@@ -0,0 +1,221 @@
+/** Aligned, huge-page-backed allocation of large buffers
+ * @file lightcurveMC/largealloc.tmp.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCLARGEALLOCH
+#define LCMCLARGEALLOCH
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+#include <gsl/gsl_matrix.h>
+
+namespace lcmc { namespace utils {
+
+/** Sets whether large buffers are placed on huge pages
+ */
+void setHugePages(bool use);
+
+/** Returns the choice made with setHugePages()
+ */
+bool hugePages();
+
+/** Allocates a block of memory aligned for vector instructions, on 
+ *	huge pages if it is large enough
+ */
+void* largeAlloc(size_t bytes);
+
+/** Frees a block allocated by largeAlloc()
+ */
+void largeFree(void* block);
+
+/** Allocates a matrix whose elements are allocated by largeAlloc()
+ */
+gsl_matrix* largeMatrixAlloc(size_t n1, size_t n2);
+
+/** Allocates a matrix whose elements are allocated by largeAlloc(), 
+ *	and sets every element to zero
+ */
+gsl_matrix* largeMatrixCalloc(size_t n1, size_t n2);
+
+/** Standard allocator that obtains its memory from largeAlloc()
+ *
+ * The allocator is stateless, so containers using it may be swapped 
+ * and copied like containers using std::allocator.
+ *
+ * @tparam T The type of object allocated.
+ */
+template <class T>
+class LargeAllocator {
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+
+	/** The equivalent allocator for another type */
+	template <class U> struct rebind {
+		typedef LargeAllocator<U> other;
+	};
+
+	/** Creates an allocator
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	LargeAllocator() {
+	}
+
+	/** Creates an allocator equivalent to another
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	LargeAllocator(const LargeAllocator&) {
+	}
+
+	/** Creates an allocator equivalent to one for another type
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	template <class U> 
+	LargeAllocator(const LargeAllocator<U>&) {
+	}
+
+	/** Returns the address of an object
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	pointer address(reference x) const {
+		return &x;
+	}
+
+	/** Returns the address of an object
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	const_pointer address(const_reference x) const {
+		return &x;
+	}
+
+	/** Allocates uninitialized storage
+	 *
+	 * @param[in] n The number of objects to make room for.
+	 *
+	 * @return A pointer to storage for @p n objects, aligned as 
+	 *	described by largeAlloc().
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory.
+	 *
+	 * @exceptsafe The program state is unchanged in the event of an 
+	 *	exception.
+	 */
+	pointer allocate(size_type n, const void* = 0) {
+		if (n > max_size()) {
+			throw std::bad_alloc();
+		}
+		void* const block = largeAlloc(n * sizeof(T));
+		if (block == NULL) {
+			throw std::bad_alloc();
+		}
+		return static_cast<pointer>(block);
+	}
+
+	/** Frees storage made by allocate()
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void deallocate(pointer p, size_type) {
+		largeFree(p);
+	}
+
+	/** Returns the largest number of objects allocate() can make 
+	 *	room for
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	size_type max_size() const {
+		return std::numeric_limits<size_type>::max() / sizeof(T);
+	}
+
+	/** Copies an object into uninitialized storage
+	 *
+	 * @exceptsafe Provides the exception guarantee of T's copy 
+	 *	constructor.
+	 */
+	void construct(pointer p, const T& value) {
+		new(static_cast<void*>(p)) T(value);
+	}
+
+	/** Destroys an object without freeing its storage
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void destroy(pointer p) {
+		p->~T();
+	}
+};
+
+/** Tests whether memory from one allocator may be freed by another
+ *
+ * @return true, since all LargeAllocators share largeAlloc().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+template <class T, class U>
+bool operator==(const LargeAllocator<T>&, const LargeAllocator<U>&) {
+	return true;
+}
+
+/** Tests whether memory from one allocator may not be freed by another
+ *
+ * @return false, since all LargeAllocators share largeAlloc().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+template <class T, class U>
+bool operator!=(const LargeAllocator<T>&, const LargeAllocator<U>&) {
+	return false;
+}
+
+/** Names the type of a vector allocated by LargeAllocator
+ *
+ * @tparam T The type of element stored.
+ */
+template <class T>
+struct LargeVector {
+	/** A std::vector of @p T whose elements are allocated by 
+	 *	largeAlloc() */
+	typedef std::vector<T, LargeAllocator<T> > type;
+};
+
+}}		// end lcmc::utils
+
+#endif		// end LCMCLARGEALLOCH
@@ -0,0 +1,447 @@
+/** Functions for writing simulated light curves to disk
+ * @file lightcurveMC/lcdump.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "binstats.h"
+#include "fluxmag.h"
+#include "hash.h"
+#include "lcdump.h"
+#include "mcio.h"
+#include "../common/nan.h"
+#include "stats/statcollect.h"
+#include "stats/trace.h"
+
+namespace lcmc {
+
+using std::string;
+using std::vector;
+
+/** Prepares to write light curves
+ *
+ * @param[in] depth The most light curves that may wait to be written 
+ *	at once.
+ *
+ * @pre @p depth &ge; 1
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+DumpQueue::DumpQueue(size_t depth) : depth(depth), lock(), changed(), 
+		queue(), writing(false), closed(false), failed(false), message(), 
+		thread() {
+}
+
+/** Stops the writing thread, abandoning any files not yet written
+ *
+ * @post The writing thread has finished. If flush() was not called, 
+ *	the file being written is completed, but later files are not.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+DumpQueue::~DumpQueue() {
+	if (thread.get() != NULL) {
+		{
+			boost::mutex::scoped_lock guard(lock);
+			closed = true;
+			queue.clear();
+		}
+		changed.notify_all();
+		thread->join();
+	}
+}
+
+/** Writes light curves until the queue is closed
+ *
+ * @post Every light curve in the queue has been written, or a file 
+ *	could not be written and @ref message describes the error.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void DumpQueue::run() {
+	try {
+		for(;;) {
+			PendingDump job;
+			{
+				boost::mutex::scoped_lock guard(lock);
+				while (queue.empty() && !closed) {
+					changed.wait(guard);
+				}
+				if (queue.empty()) {
+					return;
+				}
+				job = queue.front();
+				queue.pop_front();
+				writing = true;
+			}
+			// The simulations may continue
+			changed.notify_all();
+			
+			{
+				const stats::TraceSpan span("print light curve");
+				if (job.units == utils::MAG_UNITS) {
+					// Light curve files always hold fluxes
+					vector<double> fluxes;
+					utils::magToFlux(job.fluxes, fluxes);
+					printLightCurve(job.fileName, job.times.timeView(), fluxes);
+				} else {
+					printLightCurve(job.fileName, job.times.timeView(), job.fluxes);
+				}
+			}
+			
+			{
+				boost::mutex::scoped_lock guard(lock);
+				writing = false;
+			}
+			changed.notify_all();
+		}
+	} catch (const std::exception& e) {
+		boost::mutex::scoped_lock guard(lock);
+		failed  = true;
+		writing = false;
+		try {
+			message = e.what();
+		} catch (...) {
+			// Report the error without the description
+			message.clear();
+		}
+	} catch (...) {
+		boost::mutex::scoped_lock guard(lock);
+		failed  = true;
+		writing = false;
+		message.clear();
+	}
+	// Don't leave the simulations waiting for space in the queue
+	changed.notify_all();
+}
+
+/** Adds a light curve to the files to write
+ *
+ * If the queue is full, waits until the writing thread takes the 
+ * oldest light curve.
+ *
+ * @param[in] fileName The file to write.
+ * @param[in] trial The light curve to write, ready for analysis. It is 
+ *	copied, so it may be discarded once the function returns.
+ *
+ * @post The light curve will be written to @p fileName, in flux units, 
+ *	after every light curve already added.
+ *
+ * @exception std::runtime_error Thrown if an earlier file could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	add the light curve.
+ * @exception boost::thread_resource_error Thrown if the writing 
+ *	thread could not be started.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void DumpQueue::push(const string& fileName, const SimTrial& trial) {
+	PendingDump job;
+	job.fileName = fileName;
+	job.times    = trial.times;
+	job.fluxes   = trial.fluxes;
+	job.units    = trial.units;
+	
+	{
+		const stats::TraceSpan span("dump wait");
+		boost::mutex::scoped_lock guard(lock);
+		while (queue.size() >= depth && !failed) {
+			changed.wait(guard);
+		}
+		if (failed) {
+			throw std::runtime_error(message);
+		}
+		if (thread.get() == NULL) {
+			thread.reset(new boost::thread(&DumpQueue::run, this));
+		}
+		
+		// Last operation in this block that is allowed to throw
+		queue.push_back(job);
+	}
+	changed.notify_all();
+}
+
+/** Waits for every light curve added so far to be written
+ *
+ * @post Every light curve passed to push() is on disk.
+ *
+ * @exception std::runtime_error Thrown if any file could not be written.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void DumpQueue::flush() {
+	if (thread.get() == NULL) {
+		return;
+	}
+	
+	const stats::TraceSpan span("dump wait");
+	boost::mutex::scoped_lock guard(lock);
+	while ((!queue.empty() || writing) && !failed) {
+		changed.wait(guard);
+	}
+	if (failed) {
+		throw std::runtime_error(message);
+	}
+}
+
+/** Defines the light curves to print from one bin
+ *
+ * @param[in] queue The queue that writes the chosen light curves. Must 
+ *	outlive the object.
+ * @param[in] filePrefix The start of the file names. Each file is 
+ *	named by appending the trial index and <tt>.dat</tt>.
+ * @param[in] numToPrint The number of light curves to print.
+ * @param[in] policy How to choose the light curves.
+ * @param[in] statTag With @ref DUMP_OUTLIER "DUMP_OUTLIER", the name of 
+ *	the statistic by which to choose the light curves, as accepted by 
+ *	@ref stats::LcBinStats::getScalars() "LcBinStats::getScalars()". 
+ *	Ignored otherwise.
+ * @param[in] seed With @ref DUMP_RANDOM "DUMP_RANDOM", the seed whose 
+ *	hash with each trial index chooses the light curves. Ignored 
+ *	otherwise.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the settings.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+TrialDumper::TrialDumper(DumpQueue& queue, const string& filePrefix, 
+		long numToPrint, DumpPolicy policy, const string& statTag, long seed) 
+		: queue(queue), filePrefix(filePrefix), numToPrint(numToPrint), 
+		policy(policy), statTag(statTag), seed(seed), lows(), highs() {
+}
+
+/** Orders candidates by key, then by trial index
+ *
+ * @param[in] x, y The candidates to compare.
+ *
+ * @return True if @p x should be printed in preference to @p y.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool TrialDumper::lessKey(const Candidate& x, const Candidate& y) {
+	return x.key < y.key || (x.key == y.key && x.index < y.index);
+}
+
+/** Orders candidates by trial index
+ *
+ * @param[in] x, y The candidates to compare, with their light curves.
+ *
+ * @return True if @p x comes from an earlier trial than @p y.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool TrialDumper::lessIndex(const std::pair<Candidate, const SimTrial*>& x, 
+		const std::pair<Candidate, const SimTrial*>& y) {
+	return x.first.index < y.first.index;
+}
+
+/** Adds a candidate to a selection of bounded size
+ *
+ * @param[in,out] chosen The candidates chosen so far.
+ * @param[in] limit The most candidates to keep.
+ * @param[in] key, index, trial The new candidate.
+ *
+ * @post @p chosen holds the @p limit candidates with the smallest keys 
+ *	among those it held before and the new one.
+ *
+ * @perform O(N + log @p limit) time, where N = 
+ *	<tt>trial.fluxes.size()</tt>.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	copy @p trial.
+ *
+ * @exceptsafe @p chosen is unchanged in the event of an exception.
+ */
+void TrialDumper::consider(Selection& chosen, size_t limit, 
+		double key, long index, const SimTrial& trial) {
+	vector<Candidate>& heap = chosen.heap;
+	Candidate next = {key, index, chosen.trials.size()};
+	if (heap.size() < limit) {
+		heap.reserve(heap.size() + 1);
+		chosen.trials.push_back(trial);
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		heap.push_back(next);
+		std::push_heap(heap.begin(), heap.end(), &lessKey);
+	} else if (limit > 0 && lessKey(next, heap.front())) {
+		SimTrial copy(trial);
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		std::pop_heap(heap.begin(), heap.end(), &lessKey);
+		next.slot = heap.back().slot;
+		heap.back() = next;
+		std::push_heap(heap.begin(), heap.end(), &lessKey);
+		
+		SimTrial& old = chosen.trials[next.slot];
+		old.times.swap(copy.times);
+		old.fluxes.swap(copy.fluxes);
+		old.units = copy.units;
+	}
+}
+
+/** Returns the name of the file for one trial
+ *
+ * @param[in] index The index of the trial in its bin.
+ *
+ * @return The name of the file to which the light curve is printed.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	build the name.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+string TrialDumper::fileName(long index) const {
+	return filePrefix + boost::lexical_cast<string>(index) + ".dat";
+}
+
+/** Considers a batch of analyzed light curves for printing
+ *
+ * @param[in] first The index of the first trial in @p batch.
+ * @param[in] batch The light curves, ready for analysis.
+ * @param[in] bin The statistics of the bin, whose last 
+ *	<tt>batch.size()</tt> values are those of @p batch.
+ *
+ * @pre With @ref DUMP_OUTLIER "DUMP_OUTLIER", @p bin stores the 
+ *	distribution of the chosen statistic, and has not been spilled 
+ *	since @p batch was analyzed.
+ *
+ * @post With @ref DUMP_FIRST "DUMP_FIRST", each trial in @p batch 
+ *	whose index is less than the number to print has been passed to 
+ *	the queue. Otherwise, the light curves of @p batch that are 
+ *	better choices than those already held replace them.
+ *
+ * @exception std::invalid_argument Thrown if the statistic chosen with 
+ *	@ref DUMP_OUTLIER "DUMP_OUTLIER" is not stored by @p bin.
+ * @exception std::runtime_error Thrown if an earlier light curve could 
+ *	not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	hold the chosen light curves.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception.
+ */
+void TrialDumper::offer(long first, const vector<SimTrial>& batch, 
+		const stats::LcBinStats& bin) {
+	if (numToPrint <= 0 || batch.empty()) {
+		return;
+	}
+	const long last = first + static_cast<long>(batch.size());
+	const size_t limit = static_cast<size_t>(numToPrint);
+	
+	switch (policy) {
+	case DUMP_RANDOM:
+		for(long i = first; i < last; i++) {
+			boost::uint64_t hash = utils::fnvHash(utils::fnvBasis(), 
+				&seed, sizeof(seed));
+			hash = utils::fnvHash(hash, &i, sizeof(i));
+			// Top 53 bits, as a fraction in [0, 1)
+			const double key = static_cast<double>(hash >> 11) 
+				/ 9007199254740992.0;
+			consider(lows, limit, key, i, batch[i - first]);
+		}
+		break;
+	case DUMP_OUTLIER: {
+		const stats::CollectedScalars& scores = bin.getScalars(statTag);
+		if (scores.size() < batch.size()) {
+			throw std::invalid_argument("Cannot choose light curves to print by " 
+				+ statTag + ", since its values are not being stored.");
+		}
+		const double* values = scores.data() + (scores.size() - batch.size());
+		for(long i = first; i < last; i++) {
+			const double value = values[i - first];
+			if (!kpfutils::isNan(value)) {
+				consider(highs, (limit+1)/2, -value, i, batch[i - first]);
+				consider(lows ,  limit   /2,  value, i, batch[i - first]);
+			}
+		}
+		break;
+	}
+	default:
+		for(long i = first; i < last && i < numToPrint; i++) {
+			queue.push(fileName(i), batch[i - first]);
+		}
+		break;
+	}
+}
+
+/** Prints the light curves chosen from every batch offered
+ *
+ * @post Every light curve chosen under @ref DUMP_RANDOM "DUMP_RANDOM" 
+ *	or @ref DUMP_OUTLIER "DUMP_OUTLIER" has been passed to the queue, in 
+ *	trial order, and the object holds no more light curves. Call 
+ *	DumpQueue::flush() to wait for the files to be written.
+ *
+ * @exception std::runtime_error Thrown if an earlier light curve could 
+ *	not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	queue the light curves.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception. Some of the light curves may have been queued.
+ */
+void TrialDumper::finish() {
+	// A light curve may be among both the highest and the lowest 
+	//	values if the bin is small
+	vector<std::pair<Candidate, const SimTrial*> > chosen;
+	for(vector<Candidate>::const_iterator it = lows.heap.begin(); 
+			it != lows.heap.end(); it++) {
+		chosen.push_back(std::make_pair(*it, &lows.trials[it->slot]));
+	}
+	for(vector<Candidate>::const_iterator it = highs.heap.begin(); 
+			it != highs.heap.end(); it++) {
+		chosen.push_back(std::make_pair(*it, &highs.trials[it->slot]));
+	}
+	std::sort(chosen.begin(), chosen.end(), &lessIndex);
+	
+	long previous = -1;
+	for(size_t i = 0; i < chosen.size(); i++) {
+		if (chosen[i].first.index != previous) {
+			queue.push(fileName(chosen[i].first.index), *chosen[i].second);
+			previous = chosen[i].first.index;
+		}
+	}
+	
+	lows  = Selection();
+	highs = Selection();
+}
+
+}	// end lcmc
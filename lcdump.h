@@ -0,0 +1,209 @@
+/** Functions for writing simulated light curves to disk
+ * @file lightcurveMC/lcdump.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCLCDUMPH
+#define LCMCLCDUMPH
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "binstats.h"
+#include "cadence.h"
+#include "fluxmag.h"
+#include "trialpool.h"
+
+namespace lcmc {
+
+/** Type used to tell the program which light curves of each bin to print
+ */
+enum DumpPolicy {
+	/** Prints the first light curves simulated
+	 */
+	DUMP_FIRST, 
+	/** Prints a random sample of the light curves, chosen by a hash 
+	 *	of the seed and the trial index
+	 */
+	DUMP_RANDOM, 
+	/** Prints the light curves with the highest and lowest values 
+	 *	of one statistic
+	 */
+	DUMP_OUTLIER
+};
+
+/** DumpQueue writes light curve files on a background thread, so that 
+ *	the simulations do not wait for the file system.
+ *
+ * Files are written in the order they are added. The thread is started 
+ * by the first light curve added.
+ */
+class DumpQueue {
+public:
+	/** Prepares to write light curves
+	 */
+	explicit DumpQueue(size_t depth);
+	
+	/** Stops the writing thread, abandoning any files not yet written
+	 */
+	~DumpQueue();
+	
+	/** Adds a light curve to the files to write
+	 */
+	void push(const std::string& fileName, const SimTrial& trial);
+	
+	/** Waits for every light curve added so far to be written
+	 */
+	void flush();
+
+private:
+	// The writing thread refers to the queue
+	DumpQueue(const DumpQueue&);
+	DumpQueue& operator=(const DumpQueue&);
+	
+	/** Writes light curves until the queue is closed
+	 */
+	void run();
+	
+	/** A light curve waiting to be written */
+	struct PendingDump {
+		PendingDump() : fileName(), times(), fluxes(), 
+				units(utils::FLUX_UNITS) {
+		}
+		
+		std::string fileName;
+		models::Cadence times;
+		std::vector<double> fluxes;
+		utils::PhotUnits units;
+	};
+	
+	const size_t depth;
+	
+	/** Protects every member below it, except where noted */
+	boost::mutex lock;
+	boost::condition_variable changed;
+	std::deque<PendingDump> queue;
+	/** True while the writing thread holds a light curve taken from 
+	 *	@ref queue */
+	bool writing;
+	/** True once no more light curves will be added */
+	bool closed;
+	/** True if a file could not be written */
+	bool failed;
+	/** The reason a file could not be written */
+	std::string message;
+	
+	/** Used only by the callers' threads */
+	boost::scoped_ptr<boost::thread> thread;
+};
+
+/** TrialDumper chooses which light curves of a bin to print, and hands 
+ *	them to a DumpQueue.
+ *
+ * Light curves are offered after they have been analyzed, so that the 
+ * choice may depend on their statistics. Light curves printed under 
+ * @ref DUMP_FIRST "DUMP_FIRST" are passed on at once; the others are 
+ * held until finish(), when the choice is final.
+ */
+class TrialDumper {
+public:
+	/** Defines the light curves to print from one bin
+	 */
+	TrialDumper(DumpQueue& queue, const std::string& filePrefix, 
+		long numToPrint, DumpPolicy policy, const std::string& statTag, 
+		long seed);
+	
+	/** Considers a batch of analyzed light curves for printing
+	 */
+	void offer(long first, const std::vector<SimTrial>& batch, 
+		const stats::LcBinStats& bin);
+	
+	/** Prints the light curves chosen from every batch offered
+	 */
+	void finish();
+
+private:
+	/** A light curve that may be printed */
+	struct Candidate {
+		/** The candidates with the smallest keys are printed */
+		double key;
+		/** The index of the trial in its bin */
+		long index;
+		/** The position of the light curve in its Selection */
+		size_t slot;
+	};
+	
+	/** A bounded set of candidates */
+	struct Selection {
+		Selection() : heap(), trials() {
+		}
+		
+		/** The candidates, as a max-heap ordered by lessKey() */
+		std::vector<Candidate> heap;
+		/** The light curves of the candidates, in no particular order */
+		std::vector<SimTrial> trials;
+	};
+	
+	/** Orders candidates by key, then by trial index */
+	static bool lessKey(const Candidate& x, const Candidate& y);
+	
+	/** Orders candidates by trial index */
+	static bool lessIndex(const std::pair<Candidate, const SimTrial*>& x, 
+		const std::pair<Candidate, const SimTrial*>& y);
+	
+	/** Adds a candidate to a selection of bounded size
+	 */
+	static void consider(Selection& chosen, size_t limit, 
+		double key, long index, const SimTrial& trial);
+	
+	/** Returns the name of the file for one trial
+	 */
+	std::string fileName(long index) const;
+	
+	DumpQueue& queue;
+	const std::string filePrefix;
+	const long numToPrint;
+	const DumpPolicy policy;
+	const std::string statTag;
+	const long seed;
+	
+	/** The light curves chosen so far. With @ref DUMP_OUTLIER 
+	 *	"DUMP_OUTLIER", @ref lows holds the lowest values of the 
+	 *	statistic and @ref highs the highest; otherwise only 
+	 *	@ref lows is used. */
+	Selection lows, highs;
+};
+
+}	// end lcmc
+
+#endif	// LCMCLCDUMPH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/lcregistry.cpp
  * @author Krzysztof Findeisen
  * @date Created April 25, 2012
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  * 
  * The functions defined here handle the details of the ILightCurve subclasses.
  */
@@ -34,9 +34,15 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
+#include <cstddef>
+#include <boost/thread/mutex.hpp>
+#include "cadence.h"
 #include "lightcurvetypes.h"
 #include "paramlist.h"
 
+#include "../common/warnflags.h"
+
 using std::map;
 using std::pair;
 using std::string;
@@ -82,130 +88,314 @@ const LightCurveType         TWOGP() {return LightCurveType(24);}
 typedef  map<string, const LightCurveType> LightCurveRegistry;
 typedef pair<string, const LightCurveType> LightCurveEntry;
 
-/** Implements a global registry of light curves. This registry is used to 
- * implement the functions lightCurveTypes() and parseLightCurve(). While 
- * constructing a map is somewhat less efficient than hardcoding the light 
- * curve information into the two functions, it is much easier to update 
- * because all the information for each light curve is declared in one place.
+/** Type of a function that allocates and initializes one kind of 
+ *	ILightCurve. The arguments are the times at which the light curve 
+ *	is sampled and the parameters of the light curve.
+ */
+typedef std::auto_ptr<ILightCurve> (*LightCurveMaker)(
+		const Cadence& times, const ParamList& lcParams);
+
+/** Table of LightCurveMakers, indexed by LightCurveType::getId(). 
+ *	Unused identifiers have null entries.
+ */
+typedef std::vector<LightCurveMaker> LightCurveFactories;
+
+// Light curves without parameters don't use lcParams, but their 
+//	constructors must still match LightCurveMaker
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+/** Allocates a light curve that takes no parameters
  *
- * @return The registry.
+ * @param[in] times The times at which the light curve is sampled.
+ * @param[in] lcParams The parameters of the light curve (ignored).
+ *
+ * @return A newly allocated light curve.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the light curve.
+ * @exception lcmc::models::except::BadParam Thrown if any of the 
+ *	parameters are outside their allowed ranges.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+template <class Wave>
+std::auto_ptr<ILightCurve> makeUnparameterized(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new Wave(times));
+}
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+/** Allocates a periodic light curve described by an amplitude, period, and phase
+ *
+ * @param[in] times The times at which the light curve is sampled.
+ * @param[in] lcParams The parameters of the light curve.
+ *
+ * @return A newly allocated light curve.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the light curve.
+ * @exception lcmc::models::except::MissingParam Thrown if a parameter 
+ *	needed by the light curve is not in @p lcParams.
+ * @exception lcmc::models::except::BadParam Thrown if any of the 
+ *	parameters are outside their allowed ranges.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+template <class Wave>
+std::auto_ptr<ILightCurve> makePeriodic(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new Wave(times, lcParams.get(PARAM_AMP), 
+		lcParams.get(PARAM_PERIOD), lcParams.get(PARAM_PHASE)));
+}
+
+/** Allocates a periodic light curve that also has a characteristic width
+ *
+ * @param[in] times The times at which the light curve is sampled.
+ * @param[in] lcParams The parameters of the light curve.
+ *
+ * @return A newly allocated light curve.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the light curve.
+ * @exception lcmc::models::except::MissingParam Thrown if a parameter 
+ *	needed by the light curve is not in @p lcParams.
+ * @exception lcmc::models::except::BadParam Thrown if any of the 
+ *	parameters are outside their allowed ranges.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+template <class Wave>
+std::auto_ptr<ILightCurve> makeWidth(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new Wave(times, lcParams.get(PARAM_AMP), 
+		lcParams.get(PARAM_PERIOD), lcParams.get(PARAM_PHASE), 
+		lcParams.get(PARAM_WIDTH)));
+}
+
+/** Allocates a periodic light curve that has separate rise and 
+ *	fall widths
+ *
+ * @param[in] times The times at which the light curve is sampled.
+ * @param[in] lcParams The parameters of the light curve.
+ *
+ * @return A newly allocated light curve.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the light curve.
+ * @exception lcmc::models::except::MissingParam Thrown if a parameter 
+ *	needed by the light curve is not in @p lcParams.
+ * @exception lcmc::models::except::BadParam Thrown if any of the 
+ *	parameters are outside their allowed ranges.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+template <class Wave>
+std::auto_ptr<ILightCurve> makeTwoWidths(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new Wave(times, lcParams.get(PARAM_AMP), 
+		lcParams.get(PARAM_PERIOD), lcParams.get(PARAM_PHASE), 
+		lcParams.get(PARAM_WIDTH2), lcParams.get(PARAM_WIDTH)));
+}
+
+/** Allocates a white noise light curve
+ *
+ * @copydetails makePeriodic()
+ */
+std::auto_ptr<ILightCurve> makeWhiteNoise(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new WhiteNoise(times, 
+		lcParams.get(PARAM_AMP)));
+}
+
+/** Allocates a random walk light curve
+ *
+ * @copydetails makePeriodic()
+ */
+std::auto_ptr<ILightCurve> makeRandomWalk(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new RandomWalk(times, 
+		lcParams.get(PARAM_DIFFUS)));
+}
+
+/** Allocates a damped random walk light curve
+ *
+ * @copydetails makePeriodic()
+ */
+std::auto_ptr<ILightCurve> makeDampedWalk(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new DampedRandomWalk(times, 
+		lcParams.get(PARAM_DIFFUS), lcParams.get(PARAM_PERIOD)));
+}
+
+/** Allocates a squared exponential Gaussian process light curve
+ *
+ * @copydetails makePeriodic()
+ */
+std::auto_ptr<ILightCurve> makeSimpleGp(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new SimpleGp(times, 
+		lcParams.get(PARAM_AMP), lcParams.get(PARAM_PERIOD)));
+}
+
+/** Allocates a two-component Gaussian process light curve
+ *
+ * @copydetails makePeriodic()
+ */
+std::auto_ptr<ILightCurve> makeTwoScaleGp(const Cadence& times, 
+		const ParamList& lcParams) {
+	return std::auto_ptr<ILightCurve>(new TwoScaleGp(times, 
+		lcParams.get(PARAM_AMP), lcParams.get(PARAM_PERIOD), 
+		lcParams.get(PARAM_AMP2), lcParams.get(PARAM_PERIOD2)));
+}
+
+/** Stores the name and constructor of every supported light curve.
+ */
+struct LightCurveTables {
+	/** Creates empty tables.
+	 */
+	LightCurveTables() : registry(), factories() {
+	}
+	
+	/** Maps the command-line name of each light curve to its type.
+	 */
+	LightCurveRegistry registry;
+	/** Maps the type of each light curve to its constructor.
+	 */
+	LightCurveFactories factories;
+};
+
+/** Adds a light curve to the registry and the constructor table
+ *
+ * @param[in,out] tables The tables to update.
+ * @param[in] name The name of the light curve on the command line.
+ * @param[in] type The type of the light curve.
+ * @param[in] maker The function that constructs the light curve.
+ *
+ * @pre Neither @p name nor @p type is already in @p tables.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	extend the tables.
+ *
+ * @exceptsafe @p tables is in a valid state in the event of an exception.
+ */
+void addLightCurve(LightCurveTables& tables, const string& name, 
+		LightCurveType type, LightCurveMaker maker) {
+	tables.registry.insert(LightCurveEntry(name, type));
+	if (tables.factories.size() <= type.getId()) {
+		tables.factories.resize(type.getId() + 1, NULL);
+	}
+	tables.factories[type.getId()] = maker;
+}
+
+/** Implements a global registry of light curves, along with a table of 
+ * their constructors. The registry is used to implement the functions 
+ * lightCurveTypes() and parseLightCurve(), and the constructor table 
+ * to implement lcFactory(). While constructing a map is somewhat less 
+ * efficient than hardcoding the light curve information into the 
+ * functions, it is much easier to update because all the information 
+ * for each light curve is declared in one place.
+ *
+ * @return The tables.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to create 
- *	the registry.
+ *	the tables.
  *
  * @exceptsafe The program state is unchanged in the event of an exception.
  */
-const LightCurveRegistry & getLightCurveRegistry() {
-	// invariant: registry contains the names of all valid light curves, 
+const LightCurveTables& getLightCurveTables() {
+	using std::swap;
+	
+	// invariant: tables contains all valid light curves, 
 	//	or called == false
-	static LightCurveRegistry registry;
+	static boost::mutex tablesLock;
+	static LightCurveTables tables;
 	static bool called = false;
+	
+	// The tables never change once built, so references to them stay 
+	//	valid after the lock is released
+	boost::mutex::scoped_lock guard(tablesLock);
 	if (called == false) {
-		registry.clear();
+		LightCurveTables temp;
 
 		// Original waveforms
-		registry.insert(LightCurveEntry(       "flat",      FLATWAVE() ));
-		registry.insert(LightCurveEntry(       "sine",      SINEWAVE() ));
-		registry.insert(LightCurveEntry(   "triangle",  TRIANGLEWAVE() ));
-		registry.insert(LightCurveEntry(    "ellipse",   ELLIPSEWAVE() ));
-		registry.insert(LightCurveEntry( "broad_peak", BROADPEAKWAVE() ));
-		registry.insert(LightCurveEntry( "sharp_peak", SHARPPEAKWAVE() ));
-		registry.insert(LightCurveEntry(    "eclipse",   ECLIPSEWAVE() ));
-		registry.insert(LightCurveEntry(    "magsine",   MAGSINEWAVE() ));
-		registry.insert(LightCurveEntry(      "aatau",     AATAUWAVE() ));
+		addLightCurve(temp,        "flat",      FLATWAVE(), &makeUnparameterized<FlatWave>);
+		addLightCurve(temp,        "sine",      SINEWAVE(), &makePeriodic<SineWave>     );
+		addLightCurve(temp,    "triangle",  TRIANGLEWAVE(), &makePeriodic<TriangleWave> );
+		addLightCurve(temp,     "ellipse",   ELLIPSEWAVE(), &makePeriodic<EllipseWave>  );
+		addLightCurve(temp,  "broad_peak", BROADPEAKWAVE(), &makePeriodic<BroadPeakWave>);
+		addLightCurve(temp,  "sharp_peak", SHARPPEAKWAVE(), &makePeriodic<SharpPeakWave>);
+		addLightCurve(temp,     "eclipse",   ECLIPSEWAVE(), &makePeriodic<EclipseWave>  );
+		addLightCurve(temp,     "magsine",   MAGSINEWAVE(), &makePeriodic<MagSineWave>  );
+		addLightCurve(temp,       "aatau",     AATAUWAVE(), &makeWidth<AaTauWave>       );
 		
 		// Outburst waveforms
-		registry.insert(LightCurveEntry(  "slow_peak",      SLOWPEAK() ));
-		registry.insert(LightCurveEntry( "flare_peak",     FLAREPEAK() ));
-		registry.insert(LightCurveEntry(  "flat_peak",    SQUAREPEAK() ));
-		registry.insert(LightCurveEntry(   "slow_dip",       SLOWDIP() ));
-		registry.insert(LightCurveEntry(  "flare_dip",      FLAREDIP() ));
-		registry.insert(LightCurveEntry(   "flat_dip",     SQUAREDIP() ));
+		addLightCurve(temp,   "slow_peak",      SLOWPEAK(), &makeWidth<SlowPeak>        );
+		addLightCurve(temp,  "flare_peak",     FLAREPEAK(), &makeTwoWidths<FlarePeak>   );
+		addLightCurve(temp,   "flat_peak",    SQUAREPEAK(), &makeWidth<SquarePeak>      );
+		addLightCurve(temp,    "slow_dip",       SLOWDIP(), &makeWidth<SlowDip>         );
+		addLightCurve(temp,   "flare_dip",      FLAREDIP(), &makeTwoWidths<FlareDip>    );
+		addLightCurve(temp,    "flat_dip",     SQUAREDIP(), &makeWidth<SquareDip>       );
 
 		// Gaussian process waveforms
-		registry.insert(LightCurveEntry("white_noise",    WHITENOISE() ));
-		registry.insert(LightCurveEntry(       "walk",    RANDOMWALK() ));
-		registry.insert(LightCurveEntry(        "drw",  DAMPRANDWALK() ));
-		registry.insert(LightCurveEntry(  "simple_gp",         ONEGP() ));
-		registry.insert(LightCurveEntry(     "two_gp",         TWOGP() ));
+		addLightCurve(temp, "white_noise",    WHITENOISE(), &makeWhiteNoise             );
+		addLightCurve(temp,        "walk",    RANDOMWALK(), &makeRandomWalk             );
+		addLightCurve(temp,         "drw",  DAMPRANDWALK(), &makeDampedWalk             );
+		addLightCurve(temp,   "simple_gp",         ONEGP(), &makeSimpleGp               );
+		addLightCurve(temp,      "two_gp",         TWOGP(), &makeTwoScaleGp             );
 
 		// No exceptions past this point
 		// To preserve the invariant in the face of exceptions, 
-		//	only set called flag when we know the registry 
-		//	is ready
+		//	only set called flag when we know the tables 
+		//	are ready
+		swap(tables.registry , temp.registry );
+		swap(tables.factories, temp.factories);
 		called = true;
 	}
 
-	// assert: registry is fully defined
+	// assert: tables are fully defined
 	
-	return registry;
+	return tables;
+}
+
+/** Implements a global registry of light curves. This registry is used to 
+ * implement the functions lightCurveTypes() and parseLightCurve().
+ *
+ * @return The registry.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to create 
+ *	the registry.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+const LightCurveRegistry & getLightCurveRegistry() {
+	return getLightCurveTables().registry;
 }
 
 /** lcFactory is a factory method that allocates and initializes a ILightCurve 
  *	object given its specification.
+ *
+ * The light curve is found by indexing a table of constructors, so the 
+ * cost of lcFactory() does not depend on how many kinds of light curve 
+ * are supported.
  */
-std::auto_ptr<ILightCurve> lcFactory(LightCurveType whichLc, const std::vector<double> &times, const ParamList &lcParams) {
-	using std::auto_ptr;
-
-	/** @todo Look into using argument forwarding to make calls like 
-	 *	<tt>lcFactory(Sine, amp, per, phase)</tt>
-	 */
+std::auto_ptr<ILightCurve> lcFactory(LightCurveType whichLc, const Cadence &times, const ParamList &lcParams) {
+	const LightCurveFactories& factories = getLightCurveTables().factories;
+	
+	if (whichLc.getId() >= factories.size() || factories[whichLc.getId()] == NULL) {
+		throw std::invalid_argument("Unsupported light curve.");
+	}
 
 	// once the LightCurve is constructed, constructing auto_ptr 
 	//	does not throw an exception.
 	// Therefore, no memory is leaked if an exception is thrown
-
-	// Basic periodic light curves	
-	if (whichLc == FLATWAVE()) {
-		return auto_ptr<ILightCurve>(new FlatWave     (times));
-	} else if (whichLc == SINEWAVE()) {
-		return auto_ptr<ILightCurve>(new SineWave     (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph")));
-	} else if (whichLc == TRIANGLEWAVE()) {
-		return auto_ptr<ILightCurve>(new TriangleWave (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph")));
-	} else if (whichLc == ELLIPSEWAVE()) {
-		return auto_ptr<ILightCurve>(new EllipseWave  (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph")));
-	} else if (whichLc == BROADPEAKWAVE()) {
-		return auto_ptr<ILightCurve>(new BroadPeakWave(times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph")));
-	} else if (whichLc == SHARPPEAKWAVE()) {
-		return auto_ptr<ILightCurve>(new SharpPeakWave(times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph")));
-	} else if (whichLc == ECLIPSEWAVE()) {
-		return auto_ptr<ILightCurve>(new EclipseWave  (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph")));
-	} else if (whichLc == MAGSINEWAVE()) {
-		return auto_ptr<ILightCurve>(new MagSineWave  (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph")));
-	} else if (whichLc == AATAUWAVE()) {
-		return auto_ptr<ILightCurve>(new AaTauWave    (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph"), lcParams.get("width")));
-
-	// Bursty light curves	
-	} else if (whichLc ==   SLOWPEAK()) {
-		return auto_ptr<ILightCurve>(new SlowPeak     (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph"), lcParams.get("width")));
-	} else if (whichLc ==  FLAREPEAK()) {
-		return auto_ptr<ILightCurve>(new FlarePeak    (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph"), lcParams.get("width2"), lcParams.get("width")));
-	} else if (whichLc == SQUAREPEAK()) {
-		return auto_ptr<ILightCurve>(new SquarePeak   (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph"), lcParams.get("width")));
-
-	// Fadey light curves	
-	} else if (whichLc ==   SLOWDIP()) {
-		return auto_ptr<ILightCurve>(new SlowDip     (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph"), lcParams.get("width")));
-	} else if (whichLc ==  FLAREDIP()) {
-		return auto_ptr<ILightCurve>(new FlareDip    (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph"), lcParams.get("width2"), lcParams.get("width")));
-	} else if (whichLc == SQUAREDIP()) {
-		return auto_ptr<ILightCurve>(new SquareDip   (times, lcParams.get("a"), lcParams.get("p"), lcParams.get("ph"), lcParams.get("width")));
-
-	// Gaussian process light curves	
-	} else if (whichLc ==   WHITENOISE()) {
-		return auto_ptr<ILightCurve>(new WhiteNoise  (times, lcParams.get("a")));
-	} else if (whichLc == RANDOMWALK()) {
-		return auto_ptr<ILightCurve>(new RandomWalk(times, lcParams.get("d")));
-	} else if (whichLc == DAMPRANDWALK()) {
-		return auto_ptr<ILightCurve>(new DampedRandomWalk(times, lcParams.get("d"), lcParams.get("p")));
-	} else if (whichLc == ONEGP()) {
-		return auto_ptr<ILightCurve>(new SimpleGp(times, lcParams.get("a"), lcParams.get("p")));
-	} else if (whichLc == TWOGP()) {
-		return auto_ptr<ILightCurve>(new TwoScaleGp(times, lcParams.get("a"), lcParams.get("p"), lcParams.get("amp2"), lcParams.get("period2") ));
-
-	} else {
-		throw std::invalid_argument("Unsupported light curve.");
-	}
+	return factories[whichLc.getId()](times, lcParams);
 }
 
 }}		// end lcmc::models
@@ -0,0 +1,256 @@
+/** Interface for programs that embed Lightcurve MC
+ * @file lightcurveMC/lightcurvemc.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include "binstats.h"
+#include "cadence.h"
+#include "fluxmag.h"
+#include "lightcurvemc.h"
+#include "lightcurveparser.h"
+#include "lightcurvetypes.h"
+#include "paramlist.h"
+#include "rngstream.h"
+#include "sims.h"
+#include "statparser.h"
+
+namespace lcmc { namespace api {
+
+using std::string;
+using std::vector;
+
+/** Returns the names of the light curve models that simulate() accepts
+ *
+ * @return The same names accepted on the command line.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	list the names.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<string> modelNames() {
+	return parse::lightCurveTypes();
+}
+
+/** Simulates a light curve into a caller-owned buffer
+ *
+ * @param[in] model The name of the light curve model, as given on 
+ *	the command line.
+ * @param[in] params The parameters of the light curve.
+ * @param[in] times The times at which to simulate the light curve.
+ * @param[in] nTimes The number of elements in @p times.
+ * @param[in] seed If non-negative, the random numbers of a stochastic 
+ *	model depend only on @p seed and @p trial, as for the command line 
+ *	option --seed. If negative, they are drawn from the program's 
+ *	single sequence of random numbers.
+ * @param[in] trial The index of the light curve, if @p seed is used.
+ * @param[out] fluxes An array of at least @p nTimes elements in 
+ *	which to store the noiseless fluxes.
+ *
+ * @pre @p nTimes > 0
+ * @pre @p params contains a valid entry for each parameter required 
+ *	by @p model
+ *
+ * @post @p fluxes[i] is the flux at @p times[i], for all i &lt; 
+ *	@p nTimes.
+ *
+ * @perform The times are copied once, to build the cadence shared 
+ *	with the model; the fluxes are written in place.
+ *
+ * @exception std::domain_error Thrown if @p model is not a light 
+ *	curve model.
+ * @exception lcmc::models::except::MissingParam Thrown if a required 
+ *	parameter is missing from @p params.
+ * @exception lcmc::models::except::BadParam Thrown if @p params 
+ *	contains an illegal parameter value.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	simulate the light curve.
+ *
+ * @exceptsafe The program is in a consistent state in the event of 
+ *	an exception. The contents of @p fluxes are unspecified.
+ */
+void simulate(const string& model, const models::ParamList& params, 
+		const double* times, size_t nTimes, long seed, long trial, 
+		double* fluxes) {
+	const models::LightCurveType curve = parse::parseLightCurve(model);
+	const models::Cadence cadence(vector<double>(times, times + nTimes));
+	
+	boost::scoped_ptr<utils::TrialStreams> streams;
+	if (seed >= 0) {
+		streams.reset(new utils::TrialStreams(seed, 0, trial));
+	}
+	const std::auto_ptr<models::ILightCurve> lc = 
+		makeLightCurve(curve, params, cadence);
+	lc->fillFluxes(fluxes);
+}
+
+/** Converts statistic names to their identifiers
+ *
+ * @param[in] statNames The names of the statistics, as given on the 
+ *	command line.
+ *
+ * @return The corresponding @ref stats::StatType "StatTypes".
+ *
+ * @exception std::domain_error Thrown if an element of @p statNames 
+ *	is not a statistic.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the list.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<stats::StatType> parseStats(const vector<string>& statNames) {
+	vector<stats::StatType> statList;
+	for(vector<string>::const_iterator it = statNames.begin(); 
+			it != statNames.end(); it++) {
+		statList.push_back(parse::parseStat(*it));
+	}
+	return statList;
+}
+
+/** Prepares to calculate statistics
+ *
+ * @param[in] statNames The statistics to calculate, named as on the 
+ *	command line.
+ * @param[in] pgramMethod The algorithm used to compute periodograms.
+ *
+ * @post The object has analyzed no light curves. Its statistics are 
+ *	kept in memory, and are not written to any files.
+ *
+ * @exception std::domain_error Thrown if an element of @p statNames 
+ *	is not a statistic.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+Analysis::Analysis(const vector<string>& statNames, 
+		stats::PeriodogramMethod pgramMethod) 
+		: bin("api", models::RangeList(), "none", parseStats(statNames), 
+			true, pgramMethod) {
+}
+
+/** Calculates the statistics of one light curve
+ *
+ * @param[in] times The times of the observations.
+ * @param[in] fluxes The flux or magnitude of each observation.
+ * @param[in] nTimes The number of elements in @p times and @p fluxes.
+ * @param[in] units Whether @p fluxes holds fluxes or magnitudes.
+ *
+ * @post Every statistic requested in the constructor has one more 
+ *	value, which is NaN if it is undefined for this light curve.
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if the light 
+ *	curve is too short to calculate the requested statistics.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	analyze the light curve.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void Analysis::add(const double* times, const double* fluxes, size_t nTimes, 
+		utils::PhotUnits units) {
+	const models::Cadence cadence(vector<double>(times, times + nTimes));
+	bin.analyzeLightCurve(cadence, vector<double>(fluxes, fluxes + nTimes), 
+		models::ParamList(), units);
+}
+
+/** Returns the number of light curves analyzed
+ *
+ * @return The number of successful calls to add().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long Analysis::size() const {
+	return bin.trials();
+}
+
+/** Returns the values of one statistic, without copying them
+ *
+ * @param[in] tag The name of the statistic, as accepted by 
+ *	@ref stats::LcBinStats::getScalars() "LcBinStats::getScalars()".
+ * @param[out] nValues The number of values.
+ *
+ * @return A pointer to @p nValues contiguous values, one per light 
+ *	curve, in the order they were added. The pointer is valid until 
+ *	the object is next changed. May be null if @p nValues is zero.
+ *
+ * @exception std::invalid_argument Thrown if @p tag does not name a 
+ *	scalar statistic.
+ *
+ * @exceptsafe The object and @p nValues are unchanged in the event 
+ *	of an exception.
+ */
+const double* Analysis::values(const string& tag, size_t& nValues) const {
+	const stats::CollectedScalars& collection = bin.getScalars(tag);
+	nValues = collection.size();
+	return collection.data();
+}
+
+/** Returns the number of functions recorded for one statistic
+ *
+ * @param[in] tag The name of the statistic, as accepted by 
+ *	@ref stats::LcBinStats::getPairs() "LcBinStats::getPairs()".
+ *
+ * @return The number of light curves for which the function, such as 
+ *	a periodogram or an ACF, was recorded.
+ *
+ * @exception std::invalid_argument Thrown if @p tag does not name a 
+ *	function statistic.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+size_t Analysis::curves(const string& tag) const {
+	return bin.getPairs(tag).size();
+}
+
+/** Returns one function recorded for a statistic, without copying it
+ *
+ * @param[in] tag The name of the statistic, as accepted by 
+ *	@ref stats::LcBinStats::getPairs() "LcBinStats::getPairs()".
+ * @param[in] i The index of the function, counting from 0 in the 
+ *	order the light curves were added.
+ * @param[out] x, y Pointers to @p n contiguous coordinates of the 
+ *	function. The pointers are valid until the object is next changed.
+ * @param[out] n The number of points in the function.
+ *
+ * @exception std::invalid_argument Thrown if @p tag does not name a 
+ *	function statistic.
+ * @exception std::out_of_range Thrown if @p i &ge; curves(@p tag).
+ *
+ * @exceptsafe The object and the arguments are unchanged in the event 
+ *	of an exception.
+ */
+void Analysis::curve(const string& tag, size_t i, const double*& x, 
+		const double*& y, size_t& n) const {
+	bin.getPairs(tag).getStat(i, x, y, n);
+}
+
+}}		// end lcmc::api
@@ -0,0 +1,105 @@
+/** Interface for programs that embed Lightcurve MC
+ * @file lightcurveMC/lightcurvemc.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCLIGHTCURVEMCH
+#define LCMCLIGHTCURVEMCH
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "binstats.h"
+#include "fluxmag.h"
+#include "paramlist.h"
+
+namespace lcmc { 
+
+/** This namespace identifies the functions that let other programs 
+ * simulate and analyze light curves in-process, without the command 
+ * line or any text files.
+ *
+ * Everything is linked from @c liblightcurvemc.a. Times, fluxes, and 
+ * statistics are passed as arrays owned by the caller, or as views 
+ * into arrays owned by the library.
+ */
+namespace api {
+
+/** Returns the names of the light curve models that simulate() accepts
+ */
+std::vector<std::string> modelNames();
+
+/** Simulates a light curve into a caller-owned buffer
+ */
+void simulate(const std::string& model, const models::ParamList& params, 
+	const double* times, size_t nTimes, long seed, long trial, 
+	double* fluxes);
+
+/** Analysis calculates statistics of light curves that are already 
+ * in memory, and keeps them until the caller reads them.
+ *
+ * Each Analysis is an independent bin of statistics, and may be used 
+ * by one thread at a time.
+ */
+class Analysis {
+public:
+	/** Prepares to calculate statistics
+	 */
+	explicit Analysis(const std::vector<std::string>& statNames, 
+		stats::PeriodogramMethod pgramMethod = stats::LS_DIRECT);
+	
+	/** Calculates the statistics of one light curve
+	 */
+	void add(const double* times, const double* fluxes, size_t nTimes, 
+		utils::PhotUnits units = utils::FLUX_UNITS);
+	
+	/** Returns the number of light curves analyzed
+	 */
+	long size() const;
+	
+	/** Returns the values of one statistic, without copying them
+	 */
+	const double* values(const std::string& tag, size_t& nValues) const;
+	
+	/** Returns the number of functions recorded for one statistic
+	 */
+	size_t curves(const std::string& tag) const;
+	
+	/** Returns one function recorded for a statistic, without 
+	 *	copying it
+	 */
+	void curve(const std::string& tag, size_t i, const double*& x, 
+		const double*& y, size_t& n) const;
+	
+private:
+	stats::LcBinStats bin;
+};
+
+}}		// end lcmc::api
+
+#endif		// end LCMCLIGHTCURVEMCH
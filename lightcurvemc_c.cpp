@@ -0,0 +1,220 @@
+/** C interface for programs that embed Lightcurve MC
+ * @file lightcurveMC/lightcurvemc_c.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <exception>
+#include <new>
+#include <string>
+#include <vector>
+#include <boost/thread/tss.hpp>
+#include "lightcurvemc.h"
+#include "lightcurvemc_c.h"
+#include "paramlist.h"
+
+/** The C handle is the C++ object itself */
+struct lcmc_analysis {
+	/** Prepares to calculate statistics
+	 *
+	 * @param[in] statNames The statistics to calculate.
+	 *
+	 * @exception std::domain_error Thrown if an element of 
+	 *	@p statNames is not a statistic.
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	to create the object.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	explicit lcmc_analysis(const std::vector<std::string>& statNames) 
+			: analysis(statNames) {
+	}
+	
+	lcmc::api::Analysis analysis;
+};
+
+namespace {
+
+/** Returns the description of the last failure on this thread
+ *
+ * @return A modifiable message, created on first use by each thread.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the message.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+std::string& lastError() {
+	static boost::thread_specific_ptr<std::string> message;
+	if (message.get() == NULL) {
+		message.reset(new std::string());
+	}
+	return *message;
+}
+
+/** Records a failure for lcmc_last_error()
+ *
+ * @param[in] what The description of the failure.
+ *
+ * @exceptsafe Does not throw exceptions. If the message cannot be 
+ *	stored, the previous message is kept.
+ */
+void setError(const char* what) {
+	try {
+		lastError() = what;
+	} catch (const std::bad_alloc& e) {
+		// Keep the old message; the return code still reports failure
+	}
+}
+
+}	// end unnamed namespace
+
+/** Simulates a light curve into a caller-owned buffer
+ *
+ * @param[in] model The name of the light curve model.
+ * @param[in] paramNames, paramValues The names and values of the 
+ *	light curve parameters.
+ * @param[in] nParams The number of elements in @p paramNames and 
+ *	@p paramValues.
+ * @param[in] times, nTimes, seed, trial As for 
+ *	@ref lcmc::api::simulate() "lcmc::api::simulate()".
+ * @param[out] fluxes An array of at least @p nTimes elements in 
+ *	which to store the fluxes.
+ *
+ * @return 0 if the light curve was simulated, nonzero otherwise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+int lcmc_simulate(const char* model, const char* const* paramNames, 
+		const double* paramValues, size_t nParams, 
+		const double* times, size_t nTimes, long seed, long trial, 
+		double* fluxes) {
+	try {
+		lcmc::models::ParamList params;
+		for(size_t i = 0; i < nParams; i++) {
+			params.add(paramNames[i], paramValues[i]);
+		}
+		lcmc::api::simulate(model, params, times, nTimes, seed, trial, fluxes);
+		return 0;
+	} catch (const std::exception& e) {
+		setError(e.what());
+		return 1;
+	}
+}
+
+/** Prepares to calculate statistics
+ *
+ * @param[in] statNames The statistics to calculate, named as on the 
+ *	command line.
+ * @param[in] nStats The number of elements in @p statNames.
+ *
+ * @return A new object, to be freed with lcmc_analysis_free(), or 
+ *	null if it could not be created.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+lcmc_analysis* lcmc_analysis_create(const char* const* statNames, size_t nStats) {
+	try {
+		return new lcmc_analysis(std::vector<std::string>(statNames, 
+			statNames + nStats));
+	} catch (const std::exception& e) {
+		setError(e.what());
+		return NULL;
+	}
+}
+
+/** Calculates the statistics of one light curve
+ *
+ * @param[in] analysis The object collecting the statistics.
+ * @param[in] times, fluxes The times and fluxes of the observations.
+ * @param[in] nTimes The number of elements in @p times and @p fluxes.
+ *
+ * @return 0 if the light curve was analyzed, nonzero otherwise.
+ *
+ * @exceptsafe Does not throw exceptions. @p analysis is unchanged 
+ *	if the return value is nonzero.
+ */
+int lcmc_analysis_add(lcmc_analysis* analysis, const double* times, 
+		const double* fluxes, size_t nTimes) {
+	try {
+		analysis->analysis.add(times, fluxes, nTimes);
+		return 0;
+	} catch (const std::exception& e) {
+		setError(e.what());
+		return 1;
+	}
+}
+
+/** Returns the values of one statistic, without copying them
+ *
+ * @param[in] analysis The object collecting the statistics.
+ * @param[in] tag The name of the statistic, as accepted by 
+ *	@ref lcmc::api::Analysis::values() "Analysis::values()".
+ * @param[out] values A pointer to the values, valid until 
+ *	@p analysis is next changed.
+ * @param[out] nValues The number of values.
+ *
+ * @return 0 if @p tag names a statistic, nonzero otherwise.
+ *
+ * @exceptsafe Does not throw exceptions. @p values and @p nValues are 
+ *	unchanged if the return value is nonzero.
+ */
+int lcmc_analysis_values(const lcmc_analysis* analysis, const char* tag, 
+		const double** values, size_t* nValues) {
+	try {
+		*values = analysis->analysis.values(tag, *nValues);
+		return 0;
+	} catch (const std::exception& e) {
+		setError(e.what());
+		return 1;
+	}
+}
+
+/** Frees an object created by lcmc_analysis_create()
+ *
+ * @param[in] analysis The object to free. May be null.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void lcmc_analysis_free(lcmc_analysis* analysis) {
+	delete analysis;
+}
+
+/** Describes the last failure on the calling thread
+ *
+ * @return A message valid until the next failure on the same thread, 
+ *	or an empty string if nothing has failed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const char* lcmc_last_error(void) {
+	try {
+		return lastError().c_str();
+	} catch (const std::bad_alloc& e) {
+		return "Out of memory";
+	}
+}
@@ -0,0 +1,83 @@
+/** C interface for programs that embed Lightcurve MC
+ * @file lightcurveMC/lightcurvemc_c.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * This header may be included from C or C++. It wraps the functions 
+ * in lightcurvemc.h for callers that cannot use C++ types, such as 
+ * other languages' foreign function interfaces.
+ *
+ * Functions that can fail return 0 on success and a nonzero value on 
+ * failure, in which case lcmc_last_error() describes the problem.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCLIGHTCURVEMCCH
+#define LCMCLIGHTCURVEMCCH
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Opaque handle to a lcmc::api::Analysis */
+typedef struct lcmc_analysis lcmc_analysis;
+
+/** Simulates a light curve into a caller-owned buffer
+ */
+int lcmc_simulate(const char* model, const char* const* paramNames, 
+	const double* paramValues, size_t nParams, 
+	const double* times, size_t nTimes, long seed, long trial, 
+	double* fluxes);
+
+/** Prepares to calculate statistics
+ */
+lcmc_analysis* lcmc_analysis_create(const char* const* statNames, size_t nStats);
+
+/** Calculates the statistics of one light curve
+ */
+int lcmc_analysis_add(lcmc_analysis* analysis, const double* times, 
+	const double* fluxes, size_t nTimes);
+
+/** Returns the values of one statistic, without copying them
+ */
+int lcmc_analysis_values(const lcmc_analysis* analysis, const char* tag, 
+	const double** values, size_t* nValues);
+
+/** Frees an object created by lcmc_analysis_create()
+ */
+void lcmc_analysis_free(lcmc_analysis* analysis);
+
+/** Describes the last failure on the calling thread
+ */
+const char* lcmc_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif		/* end LCMCLIGHTCURVEMCCH */
@@ -2,7 +2,7 @@
  * @file lightcurveMC/lightcurvetypes.h
  * @author Krzysztof Findeisen
  * @date Created February 9, 2012
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  * 
  * These types represent the interface Lightcurve MC uses to handle light 
  * curves in an abstract fashion. Do not add anything to this header unless 
@@ -93,6 +93,17 @@ public:
 	bool operator!= (const LightCurveType& other) const {
 		return (this->id != other.id);
 	}
+
+	/** Returns the constant identifying the light curve, for use as 
+	 *	an index into tables of light curve properties.
+	 *
+	 * @return The value passed to the constructor.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	unsigned int getId() const {
+		return id;
+	}
 private: 
 	unsigned int id;
 };
@@ -157,6 +168,64 @@ public:
 	 */
 	virtual void getFluxes(std::vector<double>& fluxArray) const = 0;
 
+	/** Returns a read-only view of the times at which the simulated 
+	 *	data were taken
+	 *
+	 * Unlike getTimes(), timeView() does not copy the times.
+	 *
+	 * @return A reference to the times with which the light curve was 
+	 *	initialized. The reference is valid for the lifetime of the 
+	 *	object.
+	 *
+	 * @post return value.size() = size()
+	 * @post return value equals the value of getTimes()
+	 *
+	 * @perform Constant time
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	virtual const std::vector<double>& timeView() const = 0;
+
+	/** Writes the simulated fluxes into a caller-provided buffer
+	 *
+	 * Unlike getFluxes(), fillFluxes() does not allocate a temporary 
+	 * copy of the light curve.
+	 *
+	 * @param[out] fluxArray An array of at least size() elements in 
+	 *	which to store the fluxes.
+	 *
+	 * @post @p fluxArray[i] = getFluxes()[i] for all i < size()
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to compute 
+	 *	the light curve.
+	 * @exception std::logic_error Thrown if a bug was found in the flux calculations.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception. 
+	 *	The contents of @p fluxArray are unspecified.
+	 */
+	virtual void fillFluxes(double fluxArray[]) const = 0;
+
+	/** Writes the simulated light curve, in magnitudes, into a 
+	 *	caller-provided buffer
+	 *
+	 * Light curves defined in magnitudes can provide them without 
+	 * converting to fluxes and back.
+	 *
+	 * @param[out] magArray An array of at least size() elements in 
+	 *	which to store the magnitudes.
+	 *
+	 * @post @p magArray[i] = utils::fluxToMag(getFluxes()[i]) for all 
+	 *	i < size(), up to rounding error
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to compute 
+	 *	the light curve.
+	 * @exception std::logic_error Thrown if a bug was found in the flux calculations.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception. 
+	 *	The contents of @p magArray are unspecified.
+	 */
+	virtual void fillMags(double magArray[]) const = 0;
+
 
 	/** Returns the number of times and fluxes
 	 *
@@ -0,0 +1,67 @@
+/** Packs a light curve catalog into a bundle for faster injection runs
+ * @file lightcurveMC/makebundle.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * Usage: makebundle CATALOG BUNDLE
+ *
+ * CATALOG is any catalog accepted by the --add argument of 
+ * lightcurveMC. BUNDLE may be passed to --add in its place, and gives 
+ * the same results without reading or parsing any text files.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+#include <cstdio>
+#include "samples/bundle.h"
+
+/** Converts a catalog to a bundle
+ *
+ * @param[in] argc The number of arguments given to the program.
+ * @param[in] argv The names of the catalog and the bundle.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s CATALOG BUNDLE\n", argv[0]);
+		return 1;
+	}
+	
+	try {
+		lcmc::inject::writeBundle(argv[1], argv[2]);
+	} catch(std::logic_error &e) {
+		fprintf(stderr, "BUG: %s\nPlease report this to the developer at krzys@astro.caltech.edu.\n", e.what());
+		return 1;
+	} catch (const std::exception &e) {
+		fprintf(stderr, "ERROR: %s\n", e.what());
+		return 1;
+	} catch (...) {
+		fprintf(stderr, "BUG: Unknown exception.\nPlease report this to the developer at krzys@astro.caltech.edu.\n");
+		return 1;
+	}
+	
+	return 0;
+}
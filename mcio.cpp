@@ -2,7 +2,7 @@
  * @file lightcurveMC/mcio.cpp
  * @author Krzysztof Findeisen
  * @date Created February 4, 2011
- * @date Last modified June 18, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -28,16 +28,60 @@
  */
 
 #include <algorithm>
+#include <functional>
+#include <new>
 #include <string>
 #include <vector>
+#include <cstring>
 #include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <boost/cstdint.hpp>
 #include <boost/smart_ptr.hpp>
 #include "../common/cerror.h"
+#include "../common/fileio.h"
 #include "../common/alloc.tmp.h"
+#include "cachestats.h"
+#include "diskcache.h"
+#include "hash.h"
 #include "mcio.h"
+#include "textwriter.h"
+#include "stats/profile.h"
 
 using std::sort;
 using boost::shared_ptr;
+using boost::uint64_t;
+
+/** Reads the rest of a file into memory
+ *
+ * @param[in] hInput an open file handle to be read.
+ * @param[out] text the contents of the file from the current position 
+ *	to the end, followed by a null character.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to store the 
+ *	file contents.
+ * @exception kpfutils::except::FileIo Thrown if the file could not be read.
+ *
+ * @exceptsafe @p text is in a valid state in the event of an exception. 
+ */
+void slurp(FILE* hInput, std::vector<char>& text) {
+	text.clear();
+	
+	// One large read is much faster than one read per line
+	const size_t BLOCK = 1 << 20;
+	size_t nRead = 0;
+	do {
+		text.resize(text.size() + BLOCK);
+		nRead = fread(&text[text.size() - BLOCK], 1, BLOCK, hInput);
+		text.resize(text.size() - BLOCK + nRead);
+	} while (nRead == BLOCK);
+	if (ferror(hInput)) {
+		kpfutils::fileError(hInput, "Could not read time stamp file: ");
+	}
+	
+	// strtod() needs a terminated string
+	text.push_back('\0');
+}
 
 /** Reads a file containing timestamps into a vector of dates
  *
@@ -63,17 +107,38 @@ using boost::shared_ptr;
 void readTimeStamps(FILE* hInput, DoubleVec& dates, double& minDelT, double& maxDelT) {
 	dates.clear();
 
+	std::vector<char> text;
+	slurp(hInput, text);
+	
 	// Read into dates
-	double buffer;
-	int nRead;
-	while(!feof(hInput)) {
-		nRead = fscanf(  hInput, "%lf\n", &buffer);
-		if(nRead < 1/* || ferror(hInput) || nRead == EOF*/) {
-			kpfutils::fileError(hInput, "Misformatted time stamp file: ");
+	// strtod() parses exactly the same values as fscanf("%lf")
+	const char* pos = &text[0];
+	while (true) {
+		char* end = NULL;
+		const double buffer = strtod(pos, &end);
+		if (end == pos) {
+			// Only whitespace may follow the last time stamp
+			while (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n') {
+				pos++;
+			}
+			if (*pos == '\0' && dates.empty()) {
+				throw kpfutils::except::FileIo("Misformatted time stamp file: no time stamps found.");
+			} else if (*pos != '\0') {
+				const size_t tokenLength = std::min<size_t>(strcspn(pos, " \t\r\n"), 20);
+				throw kpfutils::except::FileIo("Misformatted time stamp file: expected a number, found \"" 
+					+ std::string(pos, tokenLength) + "\"");
+			}
+			break;
 		}
 		dates.push_back(buffer);
+		pos = end;
+	}
+	
+	// Most cadence files are already in order
+	if (std::adjacent_find(dates.begin(), dates.end(), std::greater<double>()) 
+			!= dates.end()) {
+		sort(dates.begin(), dates.end());
 	}
-	sort(dates.begin(), dates.end());
 
 	// Clean up the dates to make them easier to work with
 	// While we're at it, find the minimum and maximum intervals
@@ -121,6 +186,235 @@ void readTimeStamps(FILE* hInput, DoubleVec& dates) {
 	readTimeStamps(hInput, dates, minTemp, maxTemp);
 }
 
+/** Returns the directory in which parsed time stamp files are saved
+ *
+ * @return A modifiable directory name, empty if time stamps are not
+ *	saved between runs.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+std::string& cadenceCacheDir() {
+	static std::string theDir;
+	return theDir;
+}
+
+/** Sets the directory in which parsed time stamp files are saved 
+ *	between runs
+ *
+ * @param[in] dir The directory to use. If empty, time stamp files are 
+ *	parsed by every run.
+ *
+ * @post Subsequent calls to readTimeStampFile() will look for the 
+ *	parsed times in @p dir before reading the original file, and save 
+ *	any newly parsed times to @p dir. The directory is created if 
+ *	necessary.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the directory name.
+ *
+ * @exceptsafe The cache directory is unchanged in the event of an exception.
+ */
+void setCadenceCacheDir(const std::string& dir) {
+	cadenceCacheDir() = dir;
+}
+
+/** The layout of the start of a saved cadence
+ *
+ * The header is followed by @p count time stamps, in ascending order.
+ */
+struct CadenceFileHeader {
+	/** Identifies the file format */
+	char magic[8];
+	/** The size of the original file, in bytes */
+	uint64_t size;
+	/** The modification time of the original file */
+	uint64_t mtime;
+	/** The number of time stamps */
+	uint64_t count;
+};
+
+/** The value of CadenceFileHeader::magic for the current file format
+ */
+const char CADENCE_MAGIC[8] = {'L', 'C', 'M', 'C', 'J', 'D', 'S', '1'};
+
+/** Returns the name of the file in which a parsed cadence is saved
+ *
+ * @param[in] dir The cache directory.
+ * @param[in] fileName The original time stamp file.
+ *
+ * @return The path to the file.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	for the file name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+std::string cadenceFile(const std::string& dir, const std::string& fileName) {
+	const uint64_t key = lcmc::utils::fnvHash(lcmc::utils::fnvBasis(), 
+		fileName.data(), fileName.size());
+	
+	char name[64];
+	sprintf(name, "cadence_%08lx%08lx.bin",
+		static_cast<unsigned long>((key >> 32) & 0xffffffffUL),
+		static_cast<unsigned long>( key        & 0xffffffffUL));
+	return dir + "/" + name;
+}
+
+/** Loads a cadence saved by a previous run
+ *
+ * @param[in] cacheName The file to read.
+ * @param[in] info The properties of the original time stamp file, 
+ *	used to check that the saved cadence is up to date.
+ * @param[out] dates The saved time stamps.
+ *
+ * @return True if the file exists and matches the original file, 
+ *	false otherwise.
+ *
+ * @post @p dates is unchanged if the return value is false.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool readCadence(const std::string& cacheName, const struct stat& info, 
+		DoubleVec& dates) {
+	try {
+		FILE* const rawFile = fopen(cacheName.c_str(), "rb");
+		if (rawFile == NULL) {
+			return false;
+		}
+		shared_ptr<FILE> file(rawFile, &fclose);
+		
+		CadenceFileHeader header;
+		if (fread(&header, sizeof(header), 1, file.get()) != 1
+				|| !std::equal(CADENCE_MAGIC, CADENCE_MAGIC + sizeof(CADENCE_MAGIC), header.magic)
+				|| header.size  != static_cast<uint64_t>(info.st_size)
+				|| header.mtime != static_cast<uint64_t>(info.st_mtime)
+				|| header.count == 0) {
+			return false;
+		}
+		
+		DoubleVec temp(static_cast<size_t>(header.count));
+		if (fread(&temp[0], sizeof(double), temp.size(), file.get()) != temp.size()) {
+			return false;
+		}
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		dates.swap(temp);
+		return true;
+	} catch (const std::bad_alloc& e) {
+		return false;
+	}
+}
+
+/** Saves a cadence for future runs
+ *
+ * The cadence is first written to a uniquely named temporary file, 
+ * then moved into place, so that other processes never read a partial 
+ * file. Failure to save the cadence is not an error, since it can 
+ * always be parsed again.
+ *
+ * @param[in] dir The cache directory.
+ * @param[in] cacheName The file to write.
+ * @param[in] info The properties of the original time stamp file.
+ * @param[in] dates The parsed time stamps.
+ *
+ * @pre @p dates is not empty
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void writeCadence(const std::string& dir, const std::string& cacheName, 
+		const struct stat& info, const DoubleVec& dates) {
+	try {
+		CadenceFileHeader header;
+		std::copy(CADENCE_MAGIC, CADENCE_MAGIC + sizeof(CADENCE_MAGIC), header.magic);
+		header.size  = static_cast<uint64_t>(info.st_size);
+		header.mtime = static_cast<uint64_t>(info.st_mtime);
+		header.count = dates.size();
+		
+		std::string tempName;
+		bool written;
+		{
+			shared_ptr<FILE> file = lcmc::utils::openCacheTemp(dir, cacheName, tempName);
+			if (file.get() == NULL) {
+				fprintf(stderr, "WARNING: could not save cadence to %s\n",
+					cacheName.c_str());
+				return;
+			}
+			
+			written = fwrite(&header, sizeof(header), 1, file.get()) == 1
+				&& fwrite(&dates[0], sizeof(double), dates.size(), file.get()) 
+					== dates.size()
+				&& fflush(file.get()) == 0;
+		}
+		
+		if (written) {
+			lcmc::utils::commitCacheFile(dir, tempName, cacheName);
+		} else {
+			remove(tempName.c_str());
+		}
+	} catch (const std::bad_alloc& e) {
+		// Saving is optional
+	}
+}
+
+/** Reads a file containing timestamps into a vector of dates, reusing 
+ *	the results of earlier runs when possible
+ *
+ * If setCadenceCacheDir() has been called, the parsed time stamps are 
+ * saved in binary form, and later runs read the binary copy as long as 
+ * the original file keeps the same size and modification time.
+ *
+ * @param[in] fileName The file to read. The file is assumed to be 
+ *	formatted as a list of floating-point values, one per line. 
+ * @param[out] dates a vector of doubles that stores the timestamps in 
+ *	@p fileName. The dates will be sorted in ascending order.
+ *
+ * @post @p dates does not contain any NaNs
+ *
+ * @perform O(N) time if the cadence is cached or the file is already 
+ *	in order, where N is the number of time stamps. O(N log N) time 
+ *	otherwise.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to store the 
+ *	file contents.
+ * @exception kpfutils::except::FileIo Thrown if the file could not be 
+ *	read or has the wrong format.
+ *
+ * @exceptsafe @p dates is unchanged in the event of an exception. 
+ */
+void readTimeStampFile(const std::string& fileName, DoubleVec& dates) {
+	const std::string dir = cadenceCacheDir();
+	
+	struct stat info;
+	const bool cacheable = !dir.empty() && stat(fileName.c_str(), &info) == 0;
+	const std::string cacheName = (cacheable ? cadenceFile(dir, fileName) : "");
+	
+	static lcmc::utils::CacheCounter counter("Parsed cadences on disk");
+	if (cacheable && readCadence(cacheName, info, dates)) {
+		counter.hit();
+		lcmc::utils::touchCacheFile(cacheName);
+		return;
+	}
+	
+	const double start = lcmc::stats::monotonicSeconds();
+	
+	// readTimeStamps() is not atomic
+	DoubleVec temp;
+	{
+		shared_ptr<FILE> hJulDates = kpfutils::fileCheckOpen(fileName, "r");
+		readTimeStamps(hJulDates.get(), temp);
+	}
+	
+	if (cacheable) {
+		writeCadence(dir, cacheName, info, temp);
+		counter.miss(lcmc::stats::monotonicSeconds() - start);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	dates.swap(temp);
+}
+
 /** Dumps the contents of a lightcurve to a file
  *
  * @param[in] fileName The name of the file to which to log the light curve
@@ -135,23 +429,22 @@ void readTimeStamps(FILE* hInput, DoubleVec& dates) {
  *
  * @exceptsafe Program is in a consistent state in the event of an exception. 
  *
+ * @perform O(N) time, where N = @p timeGrid.size(). The table is 
+ *	written in large blocks rather than one line at a time.
+ *
  * @bug Write more (flux) digits!
  */
 void printLightCurve(const std::string& fileName, 
 		const DoubleVec& timeGrid, const DoubleVec& fluxGrid) {
-	shared_ptr<FILE> hOutput = kpfutils::fileCheckOpen(fileName, "w");
+	lcmc::utils::TextWriter hOutput(fileName);
 
-	// Print the table
-	int status = fprintf(hOutput.get(), "#Time\tFlux\n");
-	if (status < 0) {
-		kpfutils::fileError(hOutput.get(), "Could not write to file '" 
-			+ fileName + "' in printLightCurve(): ");
-	}
+	// Print the table, formatted as "%0.5f\t%7.4f\n"
+	hOutput.write("#Time\tFlux\n");
 	for(size_t i = 0; i < timeGrid.size(); i++) {
-		status = fprintf(hOutput.get(), "%0.5f\t%7.4f\n", timeGrid[i], fluxGrid[i]);
-		if (status < 0) {
-			kpfutils::fileError(hOutput.get(), "Could not write to file '" 
-				+ fileName + "' in printLightCurve(): ");
-		}
+		hOutput.writeFixed(timeGrid[i], 5);
+		hOutput.write('\t');
+		hOutput.writeFixed(fluxGrid[i], 4, 7);
+		hOutput.write('\n');
 	}
+	hOutput.close();
 }
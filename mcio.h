@@ -2,7 +2,7 @@
  * @file lightcurveMC/mcio.h
  * @author Krzysztof Findeisen
  * @date Created February 4, 2011
- * @date Last modified June 18, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -47,6 +47,16 @@ void readTimeStamps(FILE* hInput, DoubleVec &dates, double &minDelT, double &max
  */	
 void readTimeStamps(FILE* hInput, DoubleVec &dates);
 
+/** Reads a file containing timestamps into a vector of dates, reusing 
+ *	the results of earlier runs when possible
+ */
+void readTimeStampFile(const std::string& fileName, DoubleVec &dates);
+
+/** Sets the directory in which parsed time stamp files are saved 
+ *	between runs
+ */
+void setCadenceCacheDir(const std::string& dir);
+
 /** Dumps the contents of a lightcurve to a file
  */
 void printLightCurve(const std::string& fileName, 
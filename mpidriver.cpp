@@ -0,0 +1,420 @@
+/** Distributes a run over the processes of an MPI job
+ * @file lightcurveMC/mpidriver.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <boost/shared_ptr.hpp>
+#ifdef LCMC_USE_MPI
+#include <mpi.h>
+#endif
+#include "binstats.h"
+#include "mpidriver.h"
+#include "progress.h"
+#include "../common/cerror.h"
+
+#include "../common/warnflags.h"
+
+// MPI handles are C macros that expand to C-style casts, and builds 
+//	without MPI ignore the arguments of most functions
+#if defined(GNUC_COARSEWARN) || defined(GNUC_FINEWARN)
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+namespace lcmc {
+
+using std::string;
+using std::vector;
+using boost::shared_ptr;
+
+/** Starts MPI
+ *
+ * @param[in,out] argc, argv The arguments to main(). MPI may remove 
+ *	arguments meant for itself.
+ *
+ * @post If the program was built with MPI, MPI is running and every 
+ *	process knows its rank.
+ *
+ * @exceptsafe Does not throw exceptions. If MPI cannot start, the 
+ *	program is stopped by MPI.
+ */
+MpiSession::MpiSession(int* argc, char*** argv) {
+#ifdef LCMC_USE_MPI
+	MPI_Init(argc, argv);
+#endif
+}
+
+/** Stops MPI
+ *
+ * @post If the program was built with MPI, MPI has been shut down.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+MpiSession::~MpiSession() {
+#ifdef LCMC_USE_MPI
+	MPI_Finalize();
+#endif
+}
+
+/** Returns the number of processes in the job
+ *
+ * @return The number of processes started by @c mpirun, or 1 if the 
+ *	program was built without MPI.
+ *
+ * @pre An MpiSession exists.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+int mpiSize() {
+#ifdef LCMC_USE_MPI
+	int size = 1;
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	return size;
+#else
+	return 1;
+#endif
+}
+
+/** Returns the rank of this process in the job
+ *
+ * @return The rank of this process, counting from 0. Process 0 
+ *	coordinates the job and prints its results.
+ *
+ * @pre An MpiSession exists.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+int mpiRank() {
+#ifdef LCMC_USE_MPI
+	int rank = 0;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	return rank;
+#else
+	return 0;
+#endif
+}
+
+/** Stops every process in the job after an error
+ *
+ * Without this, the other processes would wait forever for a process 
+ * that has stopped.
+ *
+ * @param[in] errorCode The exit status to report.
+ *
+ * @post If this is one of several processes, the job has been stopped. 
+ *	Otherwise, does nothing.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void abortMpi(int errorCode) {
+#ifdef LCMC_USE_MPI
+	if (mpiSize() > 1) {
+		MPI_Abort(MPI_COMM_WORLD, errorCode);
+	}
+#endif
+}
+
+/** Reads a whole temporary file into a string
+ *
+ * @param[in] file An open file handle.
+ * @param[out] contents The contents of the file, from the beginning.
+ *
+ * @exception std::runtime_error Thrown if the file could not be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the contents.
+ *
+ * @exceptsafe @p contents is unchanged in the event of an exception.
+ */
+void readAll(FILE* const file, string& contents) {
+	rewind(file);
+	string temp;
+	char buffer[4096];
+	size_t count;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		temp.append(buffer, count);
+	}
+	if (ferror(file)) {
+		kpfutils::cError("Could not buffer chunk results: ");
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	contents.swap(temp);
+}
+
+/** Packs the results of a chunk of trials for the coordinator
+ *
+ * @param[in] first, last The chunk of trials analyzed, as returned by 
+ *	nextChunk().
+ * @param[in] simSeconds The time spent simulating the chunk.
+ * @param[in] analysisSeconds The time spent analyzing the chunk.
+ * @param[in] part The statistics of the chunk alone.
+ *
+ * @return A message to pass to nextChunk().
+ *
+ * @pre @p part has been spilled since its last light curve was analyzed.
+ *
+ * @exception std::runtime_error Thrown if the results could not be 
+ *	buffered.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the results.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string chunkResult(long first, long last, double simSeconds, 
+		double analysisSeconds, const stats::LcBinStats& part) {
+	FILE* const rawTemp = tmpfile();
+	if (rawTemp == NULL) {
+		kpfutils::cError("Could not buffer chunk results: ");
+	}
+	shared_ptr<FILE> temp(rawTemp, &fclose);
+	
+	if (fprintf(temp.get(), "%ld %ld %.17g %.17g\n", first, last, 
+			simSeconds, analysisSeconds) < 0) {
+		kpfutils::cError("Could not buffer chunk results: ");
+	}
+	part.writeState(temp.get());
+	
+	string result;
+	readAll(temp.get(), result);
+	return result;
+}
+
+/** Unpacks the results of a chunk of trials
+ *
+ * @param[in] message A message created by chunkResult().
+ * @param[in,out] part The bin to restore. Must have been constructed 
+ *	with the same arguments as the bin that was packed.
+ *
+ * @return The trial after the last one in the chunk.
+ *
+ * @exception std::logic_error Thrown if @p message is misformatted.
+ * @exception std::runtime_error Thrown if @p message could not be 
+ *	buffered.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the bin.
+ *
+ * @exceptsafe @p part is in a valid state in the event of an exception.
+ */
+long readChunk(const string& message, stats::LcBinStats& part) {
+	FILE* const rawTemp = tmpfile();
+	if (rawTemp == NULL) {
+		kpfutils::cError("Could not buffer chunk results: ");
+	}
+	shared_ptr<FILE> temp(rawTemp, &fclose);
+	
+	if (fputs(message.c_str(), temp.get()) == EOF) {
+		kpfutils::cError("Could not buffer chunk results: ");
+	}
+	rewind(temp.get());
+	
+	long first, last;
+	double simSeconds, analysisSeconds;
+	if (fscanf(temp.get(), "%ld %ld %lg %lg", &first, &last, 
+			&simSeconds, &analysisSeconds) != 4) {
+		throw std::logic_error("Misformatted chunk results.");
+	}
+	part.readState(temp.get());
+	return last;
+}
+
+/** Hands out the trials of a bin to the workers, and merges their 
+ *	results
+ *
+ * Trials are handed out a chunk at a time to whichever worker asks 
+ * first, so that fast workers are not left waiting for slow ones. The 
+ * chunks are merged in trial order whatever order they finish in, so 
+ * @p results does not depend on the number of workers or their speed.
+ *
+ * Once the cost of a trial is known, chunks shrink as the bin nears 
+ * its end, so that the last chunks to finish are short and no worker 
+ * is left idle for long while the bin's stragglers run. The cost is 
+ * taken from @p trialSeconds until the first chunks have been measured.
+ *
+ * @param[in] bin The index of the bin, used to keep the messages of 
+ *	different bins apart.
+ * @param[in] nTrials The number of trials in the bin.
+ * @param[in] chunkSize The largest number of trials to hand out at a time.
+ * @param[in] trialSeconds The expected wall time of one trial on one 
+ *	worker, or 0 if unknown.
+ * @param[in] emptyBin A collection with no statistics, used as the 
+ *	template for each chunk's results.
+ * @param[in,out] results The collection to which the statistics of 
+ *	every trial are added.
+ * @param[in,out] progress The meter to update as chunks finish.
+ *
+ * @pre This is process 0 of a job with at least two processes, and 
+ *	every other process calls nextChunk() with the same @p bin until 
+ *	it returns false.
+ * @pre @p chunkSize &ge; 1
+ *
+ * @post @p results contains the statistics previously stored, followed 
+ *	by the statistics of trials 0 through @p nTrials - 1, in order.
+ *
+ * @exception std::logic_error Thrown if the program was built without 
+ *	MPI, or a worker sent a misformatted result.
+ * @exception std::runtime_error Thrown if a result could not be 
+ *	buffered.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the results.
+ *
+ * @exceptsafe @p results is in a valid state in the event of an exception.
+ */
+void coordinateBin(int bin, long nTrials, long chunkSize, 
+		double trialSeconds, const stats::LcBinStats& emptyBin, 
+		stats::LcBinStats& results, ProgressMeter& progress) {
+#ifdef LCMC_USE_MPI
+	// Chunks shorter than this cost more in messages than they save
+	const static double MIN_CHUNK_SECONDS = 0.5;
+	const int nWorkers = mpiSize() - 1;
+	
+	// Chunks that finished before an earlier chunk, keyed by first trial
+	std::map<long, string> pending;
+	long toSend = 0, toMerge = 0;
+	int idle = 0;
+	// Measured cost of the chunks returned so far
+	long measuredTrials = 0;
+	double measuredSeconds = 0.0;
+	while (idle < nWorkers) {
+		MPI_Status status;
+		MPI_Probe(MPI_ANY_SOURCE, bin, MPI_COMM_WORLD, &status);
+		int length = 0;
+		MPI_Get_count(&status, MPI_CHAR, &length);
+		// One extra element so that the buffer is never empty
+		vector<char> buffer(length + 1);
+		MPI_Recv(&buffer[0], length, MPI_CHAR, status.MPI_SOURCE, bin, 
+			MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		
+		// An empty message is a worker starting the bin
+		if (length > 0) {
+			const string message(&buffer[0], length);
+			long first, last;
+			double simSeconds, analysisSeconds;
+			if (sscanf(message.c_str(), "%ld %ld %lg %lg", &first, &last, 
+					&simSeconds, &analysisSeconds) != 4) {
+				throw std::logic_error("Misformatted chunk results.");
+			}
+			pending[first] = message;
+			measuredTrials  += last - first;
+			measuredSeconds += simSeconds + analysisSeconds;
+			// Report the time of an average worker, so that the 
+			//	fractions still add up to one
+			progress.addBatch(last - first, simSeconds / nWorkers, 
+				analysisSeconds / nWorkers);
+		}
+		
+		for(std::map<long, string>::iterator it = pending.find(toMerge); 
+				it != pending.end(); it = pending.find(toMerge)) {
+			stats::LcBinStats part(emptyBin);
+			toMerge = readChunk(it->second, part);
+			results.merge(part);
+			pending.erase(it);
+		}
+		
+		long chunk[2] = {-1, -1};
+		if (toSend < nTrials) {
+			const double cost = (measuredTrials > 0 
+				? measuredSeconds / static_cast<double>(measuredTrials) 
+				: trialSeconds);
+			long size = chunkSize;
+			if (cost > 0.0) {
+				// Guided self-scheduling: each chunk is a fraction 
+				//	of the work left for each worker
+				const long minSize = static_cast<long>(
+					std::ceil(MIN_CHUNK_SECONDS / cost));
+				size = std::min(chunkSize, std::max(minSize, 
+					(nTrials - toSend) / (2L * nWorkers)));
+				size = std::max(size, 1L);
+			}
+			chunk[0] = toSend;
+			chunk[1] = std::min(nTrials, toSend + size);
+			toSend = chunk[1];
+		} else {
+			idle++;
+		}
+		MPI_Send(chunk, 2, MPI_LONG, status.MPI_SOURCE, bin, MPI_COMM_WORLD);
+	}
+	
+	if (toMerge != nTrials) {
+		throw std::logic_error("Not all chunks were returned by the workers.");
+	}
+#else
+	throw std::logic_error("Program was built without MPI; cannot coordinate workers.");
+#endif
+}
+
+/** Returns the results of the last chunk of trials to the coordinator, 
+ *	and asks for another
+ *
+ * @param[in] bin The index of the bin being worked on.
+ * @param[in] result The value of chunkResult() for the last chunk, or 
+ *	an empty string if this is the first request for @p bin.
+ * @param[out] first, last The next chunk of trials to run is 
+ *	[@p first, @p last).
+ *
+ * @return True if there is another chunk to run, false if the bin 
+ *	is finished.
+ *
+ * @pre This is not process 0, and process 0 calls coordinateBin() 
+ *	with the same @p bin.
+ *
+ * @exception std::logic_error Thrown if the program was built without MPI.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	send the result.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+bool nextChunk(int bin, const string& result, long& first, long& last) {
+#ifdef LCMC_USE_MPI
+	// Older versions of MPI_Send take a non-const buffer
+	vector<char> buffer(result.begin(), result.end());
+	buffer.push_back('\0');
+	MPI_Send(&buffer[0], static_cast<int>(result.size()), MPI_CHAR, 0, bin, 
+		MPI_COMM_WORLD);
+	
+	long chunk[2];
+	MPI_Recv(chunk, 2, MPI_LONG, 0, bin, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	first = chunk[0];
+	last  = chunk[1];
+	return first >= 0;
+#else
+	throw std::logic_error("Program was built without MPI; cannot contact the coordinator.");
+#endif
+}
+
+}		// end lcmc
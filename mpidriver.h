@@ -0,0 +1,92 @@
+/** Distributes a run over the processes of an MPI job
+ * @file lightcurveMC/mpidriver.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCMPIDRIVERH
+#define LCMCMPIDRIVERH
+
+#include <string>
+#include "binstats.h"
+#include "progress.h"
+
+namespace lcmc {
+
+/** MpiSession starts and stops MPI for the lifetime of the program.
+ *
+ * In builds without MPI, an MpiSession does nothing, and the program 
+ * behaves as a job with a single process.
+ */
+class MpiSession {
+public:
+	/** Starts MPI
+	 */
+	MpiSession(int* argc, char*** argv);
+	
+	/** Stops MPI
+	 */
+	~MpiSession();
+
+private:
+	// There is only one MPI environment per program
+	MpiSession(const MpiSession&);
+	MpiSession& operator=(const MpiSession&);
+};
+
+/** Returns the number of processes in the job
+ */
+int mpiSize();
+
+/** Returns the rank of this process in the job
+ */
+int mpiRank();
+
+/** Stops every process in the job after an error
+ */
+void abortMpi(int errorCode);
+
+/** Hands out the trials of a bin to the workers, and merges their 
+ *	results
+ */
+void coordinateBin(int bin, long nTrials, long chunkSize, 
+	double trialSeconds, const stats::LcBinStats& emptyBin, 
+	stats::LcBinStats& results, ProgressMeter& progress);
+
+/** Returns the results of the last chunk of trials to the coordinator, 
+ *	and asks for another
+ */
+bool nextChunk(int bin, const std::string& result, long& first, long& last);
+
+/** Packs the results of a chunk of trials for the coordinator
+ */
+std::string chunkResult(long first, long last, double simSeconds, 
+	double analysisSeconds, const stats::LcBinStats& part);
+
+}		// end lcmc
+
+#endif		// end LCMCMPIDRIVERH
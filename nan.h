@@ -2,7 +2,7 @@
  * @file lightcurveMC/nan.h
  * @author Krzysztof Findeisen
  * @date Created April 11, 2013
- * @date Last modified April 21, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,6 +31,7 @@
 #define LCMCNANH
 
 #include <vector>
+#include <cstddef>
 
 namespace lcmc { 
 
@@ -51,6 +52,18 @@ bool lessFinite(double x, double y);
 void removeNans(const vector<double>& badVals, vector<double>& goodVals, 
 		const vector<double>& sideVals, vector<double>& matchVals);
 
+/** Copies the non-NaN elements of an array, and their counterparts in a 
+ *	second array, without branching on each element.
+ */
+size_t compactNotNan(const double badVals[], const double sideVals[], size_t n, 
+		double goodVals[], double matchVals[]);
+
+/** Calculates the number, mean, and variance of the non-NaN elements 
+ *	of a vector in a single pass.
+ */
+void summarizeNoNan(const vector<double>& vals, size_t& count, double& mean, 
+		double& variance);
+
 /** Calculates the mean, ignoring NaNs
  */
 double meanNoNan(const vector<double>& vals);
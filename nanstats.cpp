@@ -2,7 +2,7 @@
  * @file lightcurveMC/nanstats.cpp
  * @author Krzysztof Findeisen
  * @date Created April 11, 2013
- * @date Last modified May 25, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -29,12 +29,10 @@
 
 #include <limits>
 #include <vector>
-#include <boost/iterator/filter_iterator.hpp>
 #include <boost/lexical_cast.hpp>
 #include "nan.h"
 #include "except/undefined.h"
 #include "../common/nan.h"
-#include "../common/stats.tmp.h"
 
 namespace lcmc { namespace utils {
 
@@ -66,6 +64,49 @@ bool lessFinite(double x, double y) {
 	}
 }
 
+/** Copies the non-NaN elements of an array, and their counterparts in a 
+ *	second array, without branching on each element.
+ *
+ * Every element is written to the next free output position, but the 
+ * position only advances past elements that are not NaN, so the loop 
+ * has no data-dependent branches for NaN-rich data to mispredict.
+ *
+ * @param[in] badVals An array of @p n values that may contain NaNs.
+ * @param[in] sideVals An array of @p n values that correspond to the 
+ *	values in @p badVals.
+ * @param[in] n The number of elements in @p badVals and @p sideVals.
+ * @param[out] goodVals An array of at least @p n elements in which to 
+ *	store the elements in @p badVals that are not NaNs.
+ * @param[out] matchVals An array of at least @p n elements in which to 
+ *	store the elements in @p sideVals whose counterparts in @p badVals 
+ *	are not NaNs.
+ *
+ * @return The number of elements that are not NaNs.
+ *
+ * @pre @p goodVals and @p matchVals do not overlap each other or 
+ *	either input array
+ *
+ * @post The first (return value) elements of @p goodVals and 
+ *	@p matchVals contain the kept values, in their original order. 
+ *	The remaining elements have unspecified values.
+ *
+ * @perform O(N) time, where N = @p n
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t compactNotNan(const double badVals[], const double sideVals[], size_t n, 
+		double goodVals[], double matchVals[]) {
+	size_t nGood = 0;
+	for(size_t i = 0; i < n; i++) {
+		const double x = badVals[i];
+		 goodVals[nGood] = x;
+		matchVals[nGood] = sideVals[i];
+		// Only NaN compares unequal to itself
+		nGood += (x == x);
+	}
+	return nGood;
+}
+
 /** Removes NaNs from a pair of vectors.
  *
  * @param[in] badVals A vector of values that may contain NaNs.
@@ -113,16 +154,14 @@ void removeNans(const vector<double>& badVals, vector<double>& goodVals,
 
 	// copy-and-swap to ensure that throwing std::bad_alloc doesn't 
 	//	corrupt goodVals and matchVals
-	vector<double> goodOut, matchOut;
-	 goodOut.reserve(n);
-	matchOut.reserve(n);
+	vector<double> goodOut(n), matchOut(n);
 	
-	for(vector<double>::const_iterator badIt = badVals.begin(), sideIt = sideVals.begin();
-			badIt != badVals.end(); badIt++, sideIt++) {
-		if (!kpfutils::isNan(*badIt)) {
-			goodOut. push_back( *badIt);
-			matchOut.push_back(*sideIt);
-		}
+	if (n > 0) {
+		const size_t nGood = compactNotNan(&badVals[0], &sideVals[0], n, 
+				&goodOut[0], &matchOut[0]);
+		// Shrinking a vector does not throw
+		 goodOut.resize(nGood);
+		matchOut.resize(nGood);
 	}
 	
 	// IMPORTANT: No exceptions thrown past this point
@@ -133,6 +172,94 @@ void removeNans(const vector<double>& badVals, vector<double>& goodVals,
 	swap(matchOut, matchVals);
 }
 
+/** Calculates the number, mean, and variance of the non-NaN elements 
+ *	of a vector in a single pass.
+ *
+ * The sums are taken relative to the first finite value, which keeps 
+ * the one-pass variance from cancelling catastrophically when the mean 
+ * is large compared to the scatter (e.g., magnitudes). NaNs are masked 
+ * out rather than branched around, and the sums are split over 
+ * independent accumulators so that the compiler may keep them in 
+ * vector registers without reordering any single sum.
+ *
+ * @param[in] vals The values to summarize. May include NaNs.
+ * @param[out] count The number of non-NaN elements of @p vals.
+ * @param[out] mean The mean of the non-NaN elements of @p vals, or NaN 
+ *	if @p count = 0.
+ * @param[out] variance The (unbiased) variance of the non-NaN elements 
+ *	of @p vals, or NaN if @p count &lt; 2.
+ *
+ * @post @p variance &ge; 0 if @p count &ge; 2
+ *
+ * @perform O(N) time, where N = @p vals.size()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void summarizeNoNan(const vector<double>& vals, size_t& count, double& mean, 
+		double& variance) {
+	const size_t n = vals.size();
+	
+	// Subtracting a typical value first makes the sums well-conditioned
+	size_t first = 0;
+	while (first < n && kpfutils::isNan(vals[first])) {
+		first++;
+	}
+	if (first == n) {
+		count    = 0;
+		mean     = numeric_limits<double>::quiet_NaN();
+		variance = numeric_limits<double>::quiet_NaN();
+		return;
+	}
+	// An infinite shift would turn every difference into NaN
+	double shift = 0.0;
+	for(size_t j = first; j < n; j++) {
+		if (!kpfutils::isNanOrInf(vals[j])) {
+			shift = vals[j];
+			break;
+		}
+	}
+	
+	const size_t LANES = 4;
+	double nLane[LANES] = {0.0, 0.0, 0.0, 0.0};
+	double sLane[LANES] = {0.0, 0.0, 0.0, 0.0};
+	double qLane[LANES] = {0.0, 0.0, 0.0, 0.0};
+	
+	size_t i = first;
+	for(; i + LANES <= n; i += LANES) {
+		for(size_t j = 0; j < LANES; j++) {
+			const double x = vals[i+j];
+			// Only NaN compares unequal to itself
+			const bool good = (x == x);
+			const double d = good ? x - shift : 0.0;
+			nLane[j] += good ? 1.0 : 0.0;
+			sLane[j] += d;
+			qLane[j] += d*d;
+		}
+	}
+	for(; i < n; i++) {
+		const double x = vals[i];
+		const bool good = (x == x);
+		const double d = good ? x - shift : 0.0;
+		nLane[0] += good ? 1.0 : 0.0;
+		sLane[0] += d;
+		qLane[0] += d*d;
+	}
+	
+	const double num = (nLane[0] + nLane[1]) + (nLane[2] + nLane[3]);
+	const double sum = (sLane[0] + sLane[1]) + (sLane[2] + sLane[3]);
+	const double sq  = (qLane[0] + qLane[1]) + (qLane[2] + qLane[3]);
+	
+	count = static_cast<size_t>(num);
+	mean  = shift + sum/num;
+	if (count >= 2) {
+		const double raw = (sq - sum*sum/num) / (num - 1.0);
+		// Floor at 0 to prevent rounding errors from causing a negative variance
+		variance = (raw > 0.0 ? raw : 0.0);
+	} else {
+		variance = numeric_limits<double>::quiet_NaN();
+	}
+}
+
 /** Calculates the mean, ignoring NaNs
  *
  * @param[in] vals The values whose mean to take. May include NaNs.
@@ -143,23 +270,18 @@ void removeNans(const vector<double>& badVals, vector<double>& goodVals,
  *	@p vals are NaNs.
  *
  * @exceptsafe @p vals is unchanged in the event of an exception.
+ *
+ * @see summarizeNoNan()
  */
 double meanNoNan(const vector<double>& vals) {
-	using namespace boost;
+	size_t count;
+	double mean, variance;
+	summarizeNoNan(vals, count, mean, variance);
 	
-	// Ignore all NaN values
-	// Predicate argument needs to be default-constructible
-	// 	Can't use either std::unary_negate or boost:unary_negate
-	typedef filter_iterator<kpfutils::NotNan, vector<double>::const_iterator> NotNanFilter;
-	NotNanFilter firstClean(vals.begin(), vals.end());
-	NotNanFilter  lastClean(vals.end()  , vals.end());
-	
-	try {
-		return kpfutils::mean(firstClean, lastClean);
-	} catch (const kpfutils::except::NotEnoughData &e) {
-		throw stats::except::NotEnoughData(e.what());
-//		return numeric_limits<double>::quiet_NaN();
+	if (count < 1) {
+		throw stats::except::NotEnoughData("Cannot take the mean of a data set containing only NaNs.");
 	}
+	return mean;
 }
 
 /** Calculates the variance, ignoring NaNs
@@ -172,30 +294,18 @@ double meanNoNan(const vector<double>& vals) {
  *	the elements of @p vals are NaNs.
  *
  * @exceptsafe @p vals is unchanged in the event of an exception.
+ *
+ * @see summarizeNoNan()
  */
 double varianceNoNan(const vector<double>& vals) {
-	using namespace boost;
+	size_t count;
+	double mean, variance;
+	summarizeNoNan(vals, count, mean, variance);
 	
-	// Ignore all NaN values
-	// Predicate argument needs to be default-constructible
-	// 	Can't use either std::unary_negate or boost:unary_negate
-	typedef filter_iterator<kpfutils::NotNan, vector<double>::const_iterator> NotNanFilter;
-	NotNanFilter firstClean(vals.begin(), vals.end());
-	NotNanFilter  lastClean(vals.end()  , vals.end());
-
-	try {	
-		double rawVariance = kpfutils::variance(firstClean, lastClean);
-		// Floor at 0 to prevent rounding errors from causing a negative variance
-		if (rawVariance < 0.0 && rawVariance > -1e-12) {
-			return 0.0;
-		} else {
-			return rawVariance;
-		}
-	} catch (const kpfutils::except::NotEnoughData &e) {
-		// Translate to lcmc exception to avoid exposing implementation
-		throw stats::except::NotEnoughData(e.what());
-//		return numeric_limits<double>::quiet_NaN();
+	if (count < 2) {
+		throw stats::except::NotEnoughData("Cannot take the variance of fewer than two non-NaN values.");
 	}
+	return variance;
 }
 
 }}	// end lcmc::utils
@@ -0,0 +1,339 @@
+/** Functions for reusing the measurement noise of each trial
+ * @file lightcurveMC/noisepool.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include "noisepool.h"
+#include "rngstream.h"
+
+namespace lcmc {
+
+using boost::shared_ptr;
+using std::vector;
+
+/** Pools larger than this many bytes are kept in a temporary file 
+ *	rather than in memory.
+ */
+const size_t POOL_MAP_BYTES = 256*1024*1024;
+
+/** Deallocator for a pool kept in a temporary file
+ */
+class UnmapPool {
+public:
+	/** Prepares to unmap a file
+	 *
+	 * @param[in] length The length of the mapping, in bytes.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	explicit UnmapPool(size_t length) : length(length) {
+	}
+	
+	/** Unmaps the file
+	 *
+	 * @param[in] start The address returned by mmap().
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void operator()(double* start) const {
+		munmap(start, length);
+	}
+
+private:
+	size_t length;
+};
+
+/** Deallocator for a pool kept in memory
+ */
+class DeletePool {
+public:
+	/** Deletes the pool
+	 *
+	 * @param[in] start The array allocated for the pool.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void operator()(double* start) const {
+		delete[] start;
+	}
+};
+
+/** Creates an anonymous temporary file and maps it into memory
+ *
+ * The file is deleted as soon as it is mapped, so it does not outlive 
+ * the program. It is created in the directory named by the TMPDIR 
+ * environment variable, or in /tmp.
+ *
+ * @param[in] length The size of the file, in bytes.
+ *
+ * @return A writable mapping of @p length zero bytes.
+ *
+ * @exception std::runtime_error Thrown if the file could not be 
+ *	created or mapped.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	keep track of the mapping.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+shared_ptr<double> mapTempFile(size_t length) {
+	const char* const tmpDir = getenv("TMPDIR");
+	const std::string pattern = std::string(tmpDir != NULL && *tmpDir != '\0' 
+		? tmpDir : "/tmp") + "/lcmc_noise_XXXXXX";
+	
+	// mkstemp() needs a writable copy of the name
+	vector<char> fileName(pattern.begin(), pattern.end());
+	fileName.push_back('\0');
+	const int fd = mkstemp(&fileName[0]);
+	if (fd < 0) {
+		throw std::runtime_error("Could not create noise pool file " + pattern);
+	}
+	// The file remains until it is closed and unmapped
+	unlink(&fileName[0]);
+	if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+		close(fd);
+		throw std::runtime_error("Could not allocate noise pool file " + pattern);
+	}
+	void* const start = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	// The mapping remains valid after the file is closed
+	close(fd);
+	if (start == MAP_FAILED) {
+		throw std::runtime_error("Could not map noise pool file " + pattern);
+	}
+	
+	// shared_ptr calls the deallocator if it throws
+	return shared_ptr<double>(static_cast<double*>(start), UnmapPool(length));
+}
+
+/** Prepares to store the noise of a range of trials
+ *
+ * @param[in] seed The seed of the run.
+ * @param[in] nStreams The number of stream indices used by the run.
+ * @param[in] firstTrial, lastTrial The trials to store, as a 
+ *	half-open range.
+ * @param[in] nTimes The number of epochs in each light curve.
+ * @param[in] sigma The amplitude of the noise.
+ *
+ * @post The pool can hold the noise of trials [@p firstTrial, 
+ *	@p lastTrial) of every stream index less than @p nStreams, but 
+ *	holds none yet.
+ * @post If the pool needs more than 256 MB, it is kept in a temporary 
+ *	file.
+ *
+ * @perform Constant time. Memory or disk space is used only as trials 
+ *	are stored.
+ *
+ * @exception std::invalid_argument Thrown if @p lastTrial < @p firstTrial.
+ * @exception std::length_error Thrown if the pool is too large to 
+ *	address.
+ * @exception std::runtime_error Thrown if a large pool could not be 
+ *	mapped to a file.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+NoisePool::NoisePool(unsigned long seed, unsigned long nStreams, 
+		unsigned long firstTrial, unsigned long lastTrial, 
+		size_t nTimes, double sigma) 
+		: seed(seed), nStreams(nStreams), firstTrial(firstTrial), 
+		lastTrial(lastTrial), nTimes(nTimes), sigma(sigma), mapped(false), 
+		values(), lock(), filled() {
+	if (lastTrial < firstTrial) {
+		throw std::invalid_argument("Noise pool must cover at least zero trials.");
+	}
+	
+	const size_t nSlots = static_cast<size_t>(lastTrial - firstTrial);
+	// Divide rather than multiply, to avoid overflow
+	const size_t maxValues = std::numeric_limits<size_t>::max() / sizeof(double);
+	if (nStreams > 0 && nSlots > 0 && nTimes > 0 
+			&& (nSlots > maxValues / nStreams 
+			|| nTimes > maxValues / (nStreams * nSlots))) {
+		throw std::length_error("Noise pool is too large.");
+	}
+	const size_t nValues = static_cast<size_t>(nStreams) * nSlots * nTimes;
+	
+	vector<bool> tempFilled(static_cast<size_t>(nStreams) * nSlots, false);
+	shared_ptr<double> tempValues;
+	bool tempMapped = false;
+	if (nValues * sizeof(double) > POOL_MAP_BYTES) {
+		tempValues = mapTempFile(nValues * sizeof(double));
+		tempMapped = true;
+	} else if (nValues > 0) {
+		// shared_ptr calls the deallocator if it throws
+		tempValues = shared_ptr<double>(new double[nValues], DeletePool());
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	this->values.swap(tempValues);
+	this->mapped = tempMapped;
+	this->filled.swap(tempFilled);
+}
+
+/** Returns the noise of the trial running on this thread, if the 
+ *	pool covers it
+ *
+ * The first request for a trial draws its noise from the trial's 
+ * utils::NOISE_STREAM, exactly as makeWhiteNoise() does, and stores 
+ * it. Later requests for the same trial, including those from other 
+ * bins and, with a shared stream index, other light curve types, copy 
+ * the stored noise.
+ *
+ * @param[in] nTimes The number of epochs needing noise.
+ * @param[in] sigma The amplitude of the noise.
+ * @param[out] noise Stores the noise offsets.
+ *
+ * @return True if the pool covers the trial. If false, @p noise is 
+ *	unchanged and the caller must draw the noise itself.
+ *
+ * @post If the return value is true, @p noise.size() = @p nTimes and 
+ *	@p noise is the same as would be drawn without the pool.
+ *
+ * @perform O(@p nTimes) time. Only the first request for each trial 
+ *	generates random numbers.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the output.
+ *
+ * @exceptsafe The program is in a valid state in the event of an exception.
+ * 
+ * @internal @note No atomic guarantee because the trial's noise 
+ *	stream may be updated.
+ */
+bool NoisePool::draw(size_t nTimes, double sigma, vector<double>& noise) {
+	using std::swap;
+	
+	unsigned long trialSeed, stream, trial;
+	if (!utils::trialKey(trialSeed, stream, trial)) {
+		return false;
+	}
+	// Exact comparison is intended: any other amplitude gives other noise
+	if (trialSeed != this->seed || stream >= this->nStreams 
+			|| trial < this->firstTrial || trial >= this->lastTrial 
+			|| nTimes != this->nTimes || sigma != this->sigma) {
+		return false;
+	}
+	if (nTimes == 0) {
+		vector<double>().swap(noise);
+		return true;
+	}
+	
+	// copy-and-swap
+	vector<double> tempNoise(nTimes);
+	
+	const size_t slot = static_cast<size_t>(stream) 
+		* static_cast<size_t>(this->lastTrial - this->firstTrial) 
+		+ static_cast<size_t>(trial - this->firstTrial);
+	double* const stored = values.get() + slot * nTimes;
+	{
+		boost::lock_guard<boost::mutex> guard(lock);
+		if (!filled[slot]) {
+			utils::fillNormal(utils::trialStream(utils::NOISE_STREAM), 
+				stored, nTimes, sigma);
+			filled[slot] = true;
+		}
+	}
+	// A filled slot is never written again
+	std::copy(stored, stored + nTimes, tempNoise.begin());
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(noise, tempNoise);
+	return true;
+}
+
+/** Returns the size of the pool
+ *
+ * @return The number of bytes reserved for the noise, whether in 
+ *	memory or in a file.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t NoisePool::bytes() const {
+	return filled.size() * nTimes * sizeof(double);
+}
+
+/** Tests whether the pool is kept in a temporary file
+ *
+ * @return True if the noise is stored in a memory-mapped file, false 
+ *	if it is stored in memory.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool NoisePool::isMapped() const {
+	return mapped;
+}
+
+/** Stores the pool used by makeWhiteNoise()
+ *
+ * @return A reference to the pool, which is empty unless set.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+shared_ptr<NoisePool>& noisePool() {
+	static shared_ptr<NoisePool> pool;
+	
+	return pool;
+}
+
+/** Sets the pool used by makeWhiteNoise()
+ *
+ * @param[in] pool The pool from which to take the noise of each trial, 
+ *	or an empty pointer to always draw new noise.
+ *
+ * @post getNoisePool() returns @p pool.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void setNoisePool(const shared_ptr<NoisePool>& pool) {
+	noisePool() = pool;
+}
+
+/** Returns the pool set by setNoisePool()
+ *
+ * @return The pool used by makeWhiteNoise(), or an empty pointer if 
+ *	there is none.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+shared_ptr<NoisePool> getNoisePool() {
+	return noisePool();
+}
+
+}	// end lcmc
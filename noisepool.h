@@ -0,0 +1,102 @@
+/** Functions for reusing the measurement noise of each trial
+ * @file lightcurveMC/noisepool.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCNOISEPOOLH
+#define LCMCNOISEPOOLH
+
+#include <vector>
+#include <cstddef>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace lcmc {
+
+/** NoisePool remembers the white noise drawn for each trial, so that 
+ *	the bins of a grid run draw the noise of trial K only once.
+ *
+ * The noise of a trial depends only on the seed, the stream index of 
+ * its light curve type, and the trial index, so without the pool every 
+ * bin regenerates the same vectors. The pool stores each vector the 
+ * first time it is drawn, and later bins copy it. Large pools are kept 
+ * in a memory-mapped temporary file, so that the operating system may 
+ * page them out.
+ */
+class NoisePool {
+public:
+	/** Prepares to store the noise of a range of trials
+	 */
+	NoisePool(unsigned long seed, unsigned long nStreams, 
+			unsigned long firstTrial, unsigned long lastTrial, 
+			size_t nTimes, double sigma);
+	
+	/** Returns the noise of the trial running on this thread, if the 
+	 *	pool covers it
+	 */
+	bool draw(size_t nTimes, double sigma, std::vector<double>& noise);
+	
+	/** Returns the size of the pool
+	 */
+	size_t bytes() const;
+	
+	/** Tests whether the pool is kept in a temporary file
+	 */
+	bool isMapped() const;
+
+private:
+	// The storage may be a mapping, which cannot be copied
+	NoisePool(const NoisePool&);
+	NoisePool& operator=(const NoisePool&);
+	
+	/** The trials covered by the pool */
+	unsigned long seed, nStreams, firstTrial, lastTrial;
+	/** The noise in each trial */
+	size_t nTimes;
+	double sigma;
+	
+	/** True if @ref values is a file mapping */
+	bool mapped;
+	boost::shared_ptr<double> values;
+	
+	/** Protects @ref values and @ref filled */
+	boost::mutex lock;
+	/** True for each trial whose noise is in @ref values */
+	std::vector<bool> filled;
+};
+
+/** Sets the pool used by makeWhiteNoise()
+ */
+void setNoisePool(const boost::shared_ptr<NoisePool>& pool);
+
+/** Returns the pool set by setNoisePool()
+ */
+boost::shared_ptr<NoisePool> getNoisePool();
+
+}	// end lcmc
+
+#endif	// LCMCNOISEPOOLH
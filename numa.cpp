@@ -0,0 +1,157 @@
+/** Placement of analysis threads and cached data on NUMA nodes
+ * @file lightcurveMC/numa.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#ifdef LCMC_USE_NUMA
+#include <sched.h>
+#include <numa.h>
+#endif
+#include "numa.h"
+
+namespace lcmc { namespace utils {
+
+/** Returns the flag set by setNumaPinning()
+ *
+ * @return A modifiable flag, initially false.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& pinningFlag() {
+	static bool pin = false;
+	return pin;
+}
+
+/** Sets whether analysis threads are pinned to NUMA nodes
+ *
+ * @param[in] pin If true, pinWorker() binds each thread to a node, and 
+ *	caches of large read-only tables keep one copy per node.
+ *
+ * @post numaPinning() returns @p pin.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Has no effect on threads already started. Ignored if the 
+ *	program was built without NUMA support or the system does not 
+ *	provide it.
+ */
+void setNumaPinning(bool pin) {
+	pinningFlag() = pin;
+}
+
+/** Returns whether analysis threads are pinned to NUMA nodes
+ *
+ * @return The value passed to setNumaPinning(), or false if NUMA 
+ *	is not available.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool numaPinning() {
+	return pinningFlag() && numaNodeCount() > 1;
+}
+
+/** Returns the number of NUMA nodes caches may keep copies for
+ *
+ * @return The number of memory nodes on the system, or 1 if the 
+ *	program was built without NUMA support or the system does not 
+ *	provide it.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t numaNodeCount() {
+#ifdef LCMC_USE_NUMA
+	// The node count does not change while the program runs
+	static const size_t nNodes = (numa_available() < 0 ? 1 
+		: static_cast<size_t>(std::max(1, numa_num_configured_nodes())));
+	return nNodes;
+#else
+	return 1;
+#endif
+}
+
+/** Returns the NUMA node whose cached copies the calling thread 
+ *	should use
+ *
+ * @return The node of the processor running the calling thread, 
+ *	in the range [0, numaNodeCount()), or 0 if numaPinning() is false.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Threads not bound by pinWorker() may move to another node at 
+ *	any time, after which the copies they use are no longer local. 
+ *	The copies are still correct.
+ */
+size_t currentNumaNode() {
+#ifdef LCMC_USE_NUMA
+	if (numaPinning()) {
+		const int cpu = sched_getcpu();
+		const int node = (cpu < 0 ? 0 : numa_node_of_cpu(cpu));
+		if (node >= 0 && static_cast<size_t>(node) < numaNodeCount()) {
+			return static_cast<size_t>(node);
+		}
+	}
+#endif
+	return 0;
+}
+
+/** Binds the calling thread to the NUMA node for one of several 
+ *	workers
+ *
+ * Workers are assigned to nodes in contiguous groups, so that workers 
+ * handling neighboring blocks of data share a node.
+ *
+ * @param[in] worker The index of the calling thread's worker.
+ * @param[in] nWorkers The number of workers.
+ *
+ * @pre @p worker &lt; @p nWorkers
+ *
+ * @post If numaPinning() is true, the calling thread runs only on the 
+ *	processors of node (@p worker &times; numaNodeCount()) / 
+ *	@p nWorkers, and allocates new memory on that node. Otherwise, 
+ *	the thread is unchanged.
+ *
+ * @exceptsafe Does not throw exceptions. If the thread cannot be 
+ *	bound, it is left unchanged.
+ */
+void pinWorker(size_t worker, size_t nWorkers) {
+#ifdef LCMC_USE_NUMA
+	if (numaPinning() && nWorkers > 0) {
+		const int node = static_cast<int>((worker * numaNodeCount()) / nWorkers);
+		if (numa_run_on_node(node) == 0) {
+			numa_set_localalloc();
+		}
+	}
+#else
+	// Keep the signature the same for non-NUMA builds
+	static_cast<void>(worker);
+	static_cast<void>(nWorkers);
+#endif
+}
+
+}}		// end lcmc::utils
@@ -0,0 +1,62 @@
+/** Placement of analysis threads and cached data on NUMA nodes
+ * @file lightcurveMC/numa.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCNUMAH
+#define LCMCNUMAH
+
+#include <cstddef>
+
+namespace lcmc { namespace utils {
+
+/** Sets whether analysis threads are pinned to NUMA nodes
+ */
+void setNumaPinning(bool pin);
+
+/** Returns whether analysis threads are pinned to NUMA nodes
+ */
+bool numaPinning();
+
+/** Returns the number of NUMA nodes caches may keep copies for
+ */
+size_t numaNodeCount();
+
+/** Returns the NUMA node whose cached copies the calling thread 
+ *	should use
+ */
+size_t currentNumaNode();
+
+/** Binds the calling thread to the NUMA node for one of several 
+ *	workers
+ */
+void pinWorker(size_t worker, size_t nWorkers);
+
+}}		// end lcmc::utils
+
+#endif		// end LCMCNUMAH
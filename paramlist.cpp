@@ -2,7 +2,7 @@
  * @file lightcurveMC/paramlist.cpp
  * @author Krzysztof Findeisen
  * @date Created March 19, 2012
- * @date Last modified May 24, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,13 +27,18 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <limits>
 #include <map>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 #include <cstdio>
 #include <boost/concept/assert.hpp>
 #include <boost/iterator/iterator_concepts.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
 #include "../common/nan.h"
 #include "paramlist.h"
 #include "except/iterator.h"
@@ -44,62 +49,208 @@ namespace lcmc { namespace models {
 
 using boost::lexical_cast;
 
-/** Initializes an empty parameter list
+namespace {
+
+/** Stores every parameter name assigned an identifier, and the lock 
+ *	that protects it
+ */
+struct ParamTable {
+	ParamTable();
+
+	/** The names, indexed by ParamId
+	 */
+	std::vector<ParamType> names;
+
+	/** Must be held while reading or changing @p names
+	 */
+	boost::mutex lock;
+};
+
+/** Creates a table holding the parameters of the built-in light curves
+ *
+ * @post names has capacity for MAX_PARAMS names, so references 
+ *	returned by paramName() are never invalidated.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
- *	construct the list.
- * 
+ *	create the table.
+ *
  * @exceptsafe Object construction is atomic.
  */
-ParamList::ParamList() : lookup(new MapType()) {
+ParamTable::ParamTable() : names(), lock() {
+	// Must be in the same order as PARAM_AMP, PARAM_PERIOD, ...
+	static const char* const builtIn[] = {"a", "p", "ph", "width", 
+		"width2", "d", "amp2", "period2"};
+	names.reserve(MAX_PARAMS);
+	names.assign(builtIn, builtIn + sizeof(builtIn)/sizeof(builtIn[0]));
 }
 
-/** Initializes a parameter list with the same parameters and values as @p other
- * 
- * @param[in] other The parameter list to copy
+/** Returns the only ParamTable, creating it on the first call
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
- *	construct the list.
- * 
- * @exceptsafe Object construction is atomic.
+ *	create the table.
+ *
+ * @exceptsafe Does not throw after the first call.
  */
-ParamList::ParamList(const ParamList& other) : lookup(new MapType(*(other.lookup))) {
+ParamTable& tableInstance() {
+	static ParamTable table;
+	return table;
 }
 
-/** Cleans up the parameter list
+/** Creates the ParamTable, for use with boost::call_once()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the table.
+ */
+void initParamTable() {
+	tableInstance();
+}
+
+/** Guards the creation of the ParamTable
+ *
+ * Statically initialized, so it is ready before any thread can start.
+ */
+boost::once_flag paramTableFlag = BOOST_ONCE_INIT;
+
+/** Returns the table of parameter names, indexed by ParamId
+ *
+ * The table is created exactly once, even if the first calls come 
+ * from several threads at once.
+ *
+ * @return The table of every name assigned an identifier so far, 
+ *	starting with the parameters of the built-in light curves. Its 
+ *	lock must be held while using the names.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the table on the first call.
+ *
+ * @exceptsafe Does not throw after the first call.
+ */
+ParamTable& paramTable() {
+	boost::call_once(&initParamTable, paramTableFlag);
+	return tableInstance();
+}
+
+/** Looks up a name in a table whose lock is already held
+ *
+ * @param[in] names The table to search.
+ * @param[in] name The name of the parameter.
+ * @param[out] id The identifier of @p name, if it has one.
+ *
+ * @return True if @p name has an identifier, false otherwise.
  *
  * @exceptsafe Does not throw exceptions.
  */
-ParamList::~ParamList() {
-	delete lookup;
+bool findLocked(const std::vector<ParamType>& names, const ParamType& name, 
+		ParamId& id) {
+	const std::vector<ParamType>::const_iterator it = 
+		std::find(names.begin(), names.end(), name);
+	if (it == names.end()) {
+		return false;
+	}
+	id = static_cast<ParamId>(it - names.begin());
+	return true;
 }
 
-/** Sets a parameter list to a specific value
- * 
- * @param[in] other The parameter list to copy
+}	// end unnamed namespace
+
+/** Returns the identifier of a parameter, assigning a new one if the 
+ *	name has not been seen before
  *
- * @return An assignable lvalue
+ * Identifiers are assigned when parameters are first named, normally 
+ * while reading the command line. This function may be called from 
+ * several threads at once.
+ *
+ * @param[in] name The name of the parameter.
+ *
+ * @return The identifier of @p name.
  *
+ * @post paramName(@p return) = @p name
+ * @post @p return &lt; MAX_PARAMS
+ *
+ * @perform O(K) time, where K is the number of names seen so far.
+ *
+ * @exception std::length_error Thrown if more than MAX_PARAMS distinct 
+ *	names are needed.
  * @exception std::bad_alloc Thrown if there is not enough memory to 
- *	construct the list.
+ *	store a new name.
  * 
- * @exceptsafe Neither list is changed in the event of an exception.
+ * @exceptsafe Previously assigned identifiers are unchanged in the 
+ *	event of an exception.
  */
-ParamList& ParamList::operator=(const ParamList& other) {
-	// swap() lookup only works properly with unqualified names. See 
-	//	Item 25, Effective C++ 3E
-	using std::swap;
+ParamId paramId(const ParamType& name) {
+	ParamTable& table = paramTable();
+	boost::mutex::scoped_lock guard(table.lock);
 	
-	// map::operator= can throw exceptions, but only offers the basic guarantee
-	// Use copy-and-swap, so that exceptions (Map() can throw 
-	//	them too) don't cascade to this->lookup
-	MapType temp = *(other.lookup);
+	std::vector<ParamType>& names = table.names;
+	ParamId id;
+	if (findLocked(names, name, id)) {
+		return id;
+	}
 	
-	// IMPORTANT: No exceptions thrown past this point
+	if (names.size() >= MAX_PARAMS) {
+		throw std::length_error("Too many distinct parameters (at most " 
+			+ lexical_cast<std::string>(MAX_PARAMS) + " allowed).");
+	}
+	// vector::push_back() has an atomic guarantee
+	names.push_back(name);
+	return names.size() - 1;
+}
 
-	swap(*(this->lookup), temp);
+/** Looks up the identifier of a parameter without assigning a new one
+ *
+ * @param[in] name The name of the parameter.
+ * @param[out] id The identifier of @p name, if it has one.
+ *
+ * @return True if @p name has an identifier, false otherwise.
+ *
+ * @perform O(K) time, where K is the number of names seen so far.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the table of names.
+ * 
+ * @exceptsafe @p id is unchanged in the event of an exception or if 
+ *	@p name has no identifier.
+ */
+bool findParamId(const ParamType& name, ParamId& id) {
+	ParamTable& table = paramTable();
+	boost::mutex::scoped_lock guard(table.lock);
+	return findLocked(table.names, name, id);
+}
+
+/** Returns the name of a parameter identifier
+ *
+ * @param[in] id The identifier of the parameter.
+ *
+ * @return The name passed to the paramId() call that returned @p id.
+ *
+ * @exception std::invalid_argument Thrown if @p id was never assigned.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the table of names.
+ * 
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+const ParamType& paramName(ParamId id) {
+	ParamTable& table = paramTable();
+	boost::mutex::scoped_lock guard(table.lock);
 	
-	return *this;
+	// Safe to return after unlocking: names are never moved or changed
+	const std::vector<ParamType>& names = table.names;
+	if (id >= names.size()) {
+		throw std::invalid_argument("Unknown parameter identifier: " 
+			+ lexical_cast<std::string>(id));
+	}
+	return names[id];
+}
+
+//----------------------------------------------------------
+
+/** Initializes an empty parameter list
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ParamList::ParamList() : values() {
+	std::fill(values, values + MAX_PARAMS, 
+		std::numeric_limits<double>::quiet_NaN());
 }
 
 /** Adds a new parameter.
@@ -115,6 +266,8 @@ ParamList& ParamList::operator=(const ParamList& other) {
  * @exception lcmc::utils::except::UnexpectedNan Thrown if @p value is NaN
  * @exception lcmc::models::except::ExtraParam Thrown if a value for the 
  *	parameter is already in the list
+ * @exception std::length_error Thrown if @p name would be a new 
+ *	parameter, but MAX_PARAMS parameters are already in use.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	add an element to the list.
@@ -123,6 +276,34 @@ ParamList& ParamList::operator=(const ParamList& other) {
  *	in the event of an exception.
  */
 void ParamList::add(ParamType name, double value) {
+	add(paramId(name), value);
+}
+
+/** Adds a new parameter.
+ * 
+ * @param[in] id The identifier of the parameter to add.
+ * @param[in] value The value of the parameter.
+ *
+ * @pre @p id was returned by paramId()
+ * @pre @p id is not already represented in the ParamList
+ * @pre @p value is not NaN
+ *
+ * @post @ref get() "get"(@p id) returns value
+ *
+ * @perform Constant time. Does not allocate memory unless an 
+ *	exception is thrown.
+ *
+ * @exception lcmc::utils::except::UnexpectedNan Thrown if @p value is NaN
+ * @exception lcmc::models::except::ExtraParam Thrown if a value for the 
+ *	parameter is already in the list
+ * @exception std::invalid_argument Thrown if @p id is not a valid 
+ *	parameter identifier.
+ * 
+ * @exceptsafe Neither the ParamList nor the arguments to add() are changed 
+ *	in the event of an exception.
+ */
+void ParamList::add(ParamId id, double value) {
+	const ParamType& name = paramName(id);
 	if (kpfutils::isNan(value)) {
 		try {
 			throw utils::except::UnexpectedNan("NaN value for parameter: " 
@@ -131,11 +312,7 @@ void ParamList::add(ParamType name, double value) {
 			throw utils::except::UnexpectedNan("NaN value for parameter");
 		}
 	}
-	// Check for duplicate elements directly, since duplicates cause 
-	//	map::insert() to fail quietly
-	// map::count() has an atomic guarantee... but doesn't specify what 
-	//	exceptions it throws???
-	if (lookup->count(name) > 0) {
+	if (!kpfutils::isNan(values[id])) {
 		try {
 			throw except::ExtraParam("Duplicate parameter to ParamList: " 
 				+ lexical_cast<std::string>(name), 
@@ -145,11 +322,7 @@ void ParamList::add(ParamType name, double value) {
 		}
 	}
 	
-	// assert: lookup has not changed since the beginning of the 
-	//	function call
-
-	// map::insert() has an atomic guarantee
-	lookup->insert(MapType::value_type(name, value));
+	values[id] = value;
 }
 
 /** Returns the value of a specific parameter in the list
@@ -166,8 +339,8 @@ void ParamList::add(ParamType name, double value) {
  * @exceptsafe The parameter list is unchanged in the event of an exception.
  */
 double ParamList::get(ParamType param) const {
-	MapType::const_iterator it = lookup->find(param);
-	if (it == lookup->end()) {
+	ParamId id;
+	if (!findParamId(param, id)) {
 		try {
 			throw except::MissingParam("Required parameter not found: " 
 				+ lexical_cast<std::string>(param), 
@@ -177,7 +350,42 @@ double ParamList::get(ParamType param) const {
 		}
 	}
 	
-	return it->second;
+	return get(id);
+}
+
+/** Returns the value of a specific parameter in the list
+ *
+ * @param[in] param The identifier of the parameter whose value is needed
+ *
+ * @return The value of the desired parameter.
+ *
+ * @pre @p param was returned by paramId()
+ *
+ * @post return value is not NaN
+ *
+ * @perform Constant time. Does not allocate memory unless an 
+ *	exception is thrown.
+ *
+ * @exception lcmc::models::except::MissingParam Thrown if the desired 
+ *	parameter is not in the ParamList.
+ * @exception std::invalid_argument Thrown if @p param is not a valid 
+ *	parameter identifier.
+ * 
+ * @exceptsafe The parameter list is unchanged in the event of an exception.
+ */
+double ParamList::get(ParamId param) const {
+	if (param >= MAX_PARAMS || kpfutils::isNan(values[param])) {
+		const ParamType& name = paramName(param);
+		try {
+			throw except::MissingParam("Required parameter not found: " 
+				+ lexical_cast<std::string>(name), 
+				name);
+		} catch (const boost::bad_lexical_cast &e) {
+			throw except::MissingParam("Required parameter not found.", name);
+		}
+	}
+	
+	return values[param];
 }
 
 //----------------------------------------------------------
@@ -260,6 +468,8 @@ RangeList& RangeList::operator=(const RangeList& other) {
  *	parameter is already in the list
  * @exception lcmc::models::except::NegativeRange Thrown if @p max > @p min
  * @exception std::invalid_argument Thrown if @p distrib is not a valid value.
+ * @exception std::length_error Thrown if @p name would be a new 
+ *	parameter, but MAX_PARAMS parameters are already in use.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	add an element to the list.
@@ -288,7 +498,8 @@ void RangeList::add(ParamType name, double min, double max, RangeType distrib) {
 	// RangeInfo() has an atomic guarantee
 	// value_type() does not throw
 	// map::insert() has an atomic guarantee
-	lookup->insert(MapType::value_type(name, RangeInfo(min, max, distrib)));
+	lookup->insert(MapType::value_type(name, 
+		RangeInfo(paramId(name), min, max, distrib)));
 }
 
 /** Adds a new allowed range for a parameter
@@ -460,6 +671,7 @@ bool RangeList::checkRangeType(RangeList::RangeType x) {
 
 /** Initializes a range for a particular parameter.
  *
+ * @param[in] id The identifier of the parameter.
  * @param[in] min The smallest value the parameter can take.
  * @param[in] max The largest value the parameter can take.
  * @param[in] distrib The distribution over [@p min, @p max] from which the 
@@ -479,8 +691,8 @@ bool RangeList::checkRangeType(RangeList::RangeType x) {
  * 
  * @exceptsafe Object creation is atomic.
  */
-RangeList::RangeInfo::RangeInfo(double min, double max, RangeType distrib) 
-	: min(min), max(max), distrib(distrib) {
+RangeList::RangeInfo::RangeInfo(ParamId id, double min, double max, RangeType distrib) 
+	: id(id), min(min), max(max), distrib(distrib) {
 	if (kpfutils::isNan(min) || kpfutils::isNan(max)) {
 		throw utils::except::UnexpectedNan("NaN value for range limits.");
 	}
@@ -492,6 +704,16 @@ RangeList::RangeInfo::RangeInfo(double min, double max, RangeType distrib)
 	}
 }
 
+/** Returns the identifier of the parameter.
+ *
+ * @return The value passed to the constructor.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ParamId RangeList::RangeInfo::getId() const {
+	return id;
+}
+
 /** Returns the smallest value the parameter can take.
  *
  * @return The value.
@@ -749,6 +971,93 @@ RangeList::const_iterator RangeList::const_iterator::operator--(int) {
 	return temp;
 }
 
+/** Returns the range of the parameter to which the iterator is pointing
+ *
+ * @return The range information stored in the RangeList.
+ *
+ * @exception lcmc::utils::except::BadIterator Thrown if the iterator does 
+ *	not point to a valid element of a RangeList.
+ *
+ * @exceptsafe Neither the iterator nor any RangeList it points to are 
+ *	changed in the event of an exception.
+ */
+const RangeList::RangeInfo& RangeList::const_iterator::info() const {
+	// Class invariant guarantees that this is the only way to 
+	//	not point to a valid element
+	if (it == this->end()) {
+		throw utils::except::BadIterator("Cannot dereference RangeList::end().");
+	}
+	
+	return it->second;
+}
+
+/** Returns the identifier of the parameter to which the iterator 
+ *	is pointing
+ *
+ * Unlike RangeList::getMin() and related methods, this method does not 
+ * need to search the RangeList.
+ *
+ * @return The identifier of @p *it, as given by paramId().
+ *
+ * @exception lcmc::utils::except::BadIterator Thrown if the iterator does 
+ *	not point to a valid element of a RangeList.
+ *
+ * @exceptsafe Neither the iterator nor any RangeList it points to are 
+ *	changed in the event of an exception.
+ */
+ParamId RangeList::const_iterator::getId() const {
+	return info().getId();
+}
+
+/** Returns the minimum value of the parameter to which the iterator 
+ *	is pointing
+ *
+ * @return The minimum value of @p *it.
+ *
+ * @post return value is not NaN
+ *
+ * @exception lcmc::utils::except::BadIterator Thrown if the iterator does 
+ *	not point to a valid element of a RangeList.
+ *
+ * @exceptsafe Neither the iterator nor any RangeList it points to are 
+ *	changed in the event of an exception.
+ */
+double RangeList::const_iterator::getMin() const {
+	return info().getMin();
+}
+
+/** Returns the maximum value of the parameter to which the iterator 
+ *	is pointing
+ *
+ * @return The maximum value of @p *it.
+ *
+ * @post return value is not NaN
+ *
+ * @exception lcmc::utils::except::BadIterator Thrown if the iterator does 
+ *	not point to a valid element of a RangeList.
+ *
+ * @exceptsafe Neither the iterator nor any RangeList it points to are 
+ *	changed in the event of an exception.
+ */
+double RangeList::const_iterator::getMax() const {
+	return info().getMax();
+}
+
+/** Returns the distribution of the parameter to which the iterator 
+ *	is pointing
+ *
+ * @return The distribution type of @p *it.
+ *
+ * @exception lcmc::utils::except::BadIterator Thrown if the iterator does 
+ *	not point to a valid element of a RangeList.
+ *
+ * @exceptsafe Neither the iterator nor any RangeList it points to are 
+ *	changed in the event of an exception.
+ */
+RangeList::RangeType RangeList::const_iterator::getType() const {
+	return info().getType();
+}
+
 /** Returns the earliest allowed value of the iterator.
  *
  * @return The first element of the RangeList.
@@ -2,7 +2,7 @@
  * @file lightcurveMC/paramlist.h
  * @author Krzysztof Findeisen
  * @date Created April 3, 2012
- * @date Last modified July 23, 2013
+ * @date Last modified October 14, 2026
  * 
  * These types handle information needed to set up simulation runs.
  */
@@ -55,6 +55,7 @@
 #include <map>
 #include <string>
 #include <utility>
+#include <cstddef>
 
 namespace lcmc { namespace models {
 
@@ -63,9 +64,57 @@ namespace lcmc { namespace models {
  */
 typedef std::string ParamType;
 
+/** Type identifying a parameter by a small integer, in place of its name
+ */
+typedef size_t ParamId;
+
+/** The largest number of distinct parameter names the program may use
+ */
+const size_t MAX_PARAMS = 32;
+
+/** Identifiers of the parameters used by the built-in light curves. 
+ *	paramId() returns these values for the corresponding names.
+ */
+enum {
+	/** The amplitude, named "a" */
+	PARAM_AMP = 0, 
+	/** The period or coherence time, named "p" */
+	PARAM_PERIOD, 
+	/** The phase, named "ph" */
+	PARAM_PHASE, 
+	/** The width of a feature, named "width" */
+	PARAM_WIDTH, 
+	/** The width of a secondary feature, named "width2" */
+	PARAM_WIDTH2, 
+	/** The diffusion constant, named "d" */
+	PARAM_DIFFUS, 
+	/** The secondary amplitude, named "amp2" */
+	PARAM_AMP2, 
+	/** The secondary period or coherence time, named "period2" */
+	PARAM_PERIOD2
+};
+
+/** Returns the identifier of a parameter, assigning a new one if the 
+ *	name has not been seen before
+ */
+ParamId paramId(const ParamType& name);
+
+/** Looks up the identifier of a parameter without assigning a new one
+ */
+bool findParamId(const ParamType& name, ParamId& id);
+
+/** Returns the name of a parameter identifier
+ */
+const ParamType& paramName(ParamId id);
+
 /** A ParamList contains the arguments needed by the light curve.
  * Providing the arguments in this form allows the client code to not 
  * care what kind of light curve it is generating parameters for.
+ *
+ * Parameters are stored in a fixed-size array indexed by ParamId, so 
+ * ParamLists never allocate memory and look up parameters in constant 
+ * time. The overloads taking a ParamType are for use at the command-line 
+ * boundary.
  */
 class ParamList {
 public: 
@@ -73,30 +122,19 @@ public:
 	 */
 	ParamList();
 	
-	/** Initializes a parameter list with the same parameters and values as @p other
-	 */
-	ParamList(const ParamList& other);
-	
-	/** Cleans up the parameter list
-	 */
-	~ParamList();
-	
-	/** Sets a parameter list to a specific value
-	 */
-	ParamList& operator=(const ParamList& other);
-	
 	/** Adds a new parameter
 	 */
 	void add(ParamType name, double value);
+	void add(ParamId id, double value);
 	
 	/** Returns the value of a specific parameter in the list
 	 */
 	double get(ParamType param) const;
+	double get(ParamId param) const;
 private: 
-	typedef std::map<ParamType, double> MapType;
-	/** @todo replace lookup with a smart pointer
-	 */
-	MapType* const lookup;
+	// invariant: values[i] is NaN if and only if parameter i is not 
+	//	in the list
+	double values[MAX_PARAMS];
 };
 
 /** A RangeList contains the minimum and maximum arguments to consider 
@@ -196,7 +234,10 @@ class RangeList::RangeInfo {
 public: 
 	/** Initializes a range for a particular parameter.
 	 */
-	RangeInfo(double min, double max, RangeType distrib);
+	RangeInfo(ParamId id, double min, double max, RangeType distrib);
+	/** Returns the identifier of the parameter.
+	 */
+	ParamId getId() const;
 	/** Returns the smallest value the parameter can take.
 	 */
 	double getMin() const;
@@ -207,6 +248,7 @@ public:
 	 */
 	RangeType getType() const;
 private:
+	ParamId id;
 	double min;
 	double max;
 	RangeType distrib;
@@ -276,7 +318,29 @@ public:
 	/** Implements <tt>std::BidirectionalIterator::-\-</tt> (postfix)
 	 */
 	const_iterator operator--(int);
+	
+	/** Returns the identifier of the parameter to which the iterator 
+	 *	is pointing
+	 */
+	ParamId getId() const;
+	/** Returns the minimum value of the parameter to which the 
+	 *	iterator is pointing
+	 */
+	double getMin() const;
+	/** Returns the maximum value of the parameter to which the 
+	 *	iterator is pointing
+	 */
+	double getMax() const;
+	/** Returns the distribution of the parameter to which the 
+	 *	iterator is pointing
+	 */
+	RangeType getType() const;
 private:
+	/** Returns the range of the parameter to which the iterator 
+	 *	is pointing
+	 */
+	const RangeInfo& info() const;
+
 	/** Standard constructor for const_iterator.
 	 */
 	const_iterator(MapType::const_iterator where, const RangeList::MapType* parent);
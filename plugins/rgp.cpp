@@ -0,0 +1,192 @@
+/** Statistics plugin that fits Gaussian process models with R
+ * @file lightcurveMC/plugins/rgp.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * Built as <tt>plugins/lcmc_rgp.so</tt>, together with rinstance.cpp 
+ * and except/r.cpp, so that only runs that fit Gaussian processes with 
+ * '--gp-fit r' load R.
+ */
+
+#include <algorithm>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <boost/smart_ptr.hpp>
+#include "../r_compat.h"
+#include "../stats/pluginapi.h"
+
+namespace lcmc { namespace plugins {
+
+using boost::shared_ptr;
+using std::vector;
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model using the gptk package
+ * 
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve.
+ * @param[in] start The timescale, kernel variance, and noise variance 
+ *	from which to start the optimization. NaN elements start from the 
+ *	gptk defaults.
+ * @param[out] best The best-fit timescale, kernel variance, and noise 
+ *	variance.
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ * 
+ * @pre @p times.size() = @p data.size() &ge; 2
+ * @pre @p start has 3 elements
+ * 
+ * @perform O(N<sup>3</sup>) time, where N = @p times.size()
+ * @perfmore O(N<sup>2</sup>) memory
+ * @perfmore Not thread-safe, as the embedded R interpreter is not.
+ * 
+ * @exception lcmc::except::BadRSession Thrown if R could not be started.
+ * @exception std::runtime_error Thrown if the fit failed.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit 
+ *	the model.
+ * 
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void fitGpR(const vector<double>& times, const vector<double>& data, 
+		const double* start, vector<double>& best, double& timeError) {
+	shared_ptr<RInside> r = getRInstance();
+	
+	Rcpp::NumericVector rTimes(times.begin(), times.end(), static_cast<int>(times.size()));
+	Rcpp::NumericVector rData (data .begin(), data .end(), static_cast<int>(data .size()));
+	
+	(*r)["times"] = rTimes;
+	(*r)["data" ] = rData;
+	
+	// Unfortunately, there seems to be no way to source() files relative 
+	// to the directory containing the lightcurveMC program... it must 
+	// be relative to a hardcoded path or to the lightcurveMC *working* 
+	// directory
+	r->parseEvalQ("suppressMessages(library(gptk))");
+	r->parseEvalQ("suppressMessages(library(numDeriv))");
+	r->parseEvalQ("gpSettings <- gpOptions('ftc')");	// Exact solution; approximations are no faster
+	r->parseEvalQ("gpSettings$optimiser <- 'CG'");		// SCG gives low quality solutions
+	r->parseEvalQ("gpSettings$kern$type <- 'cmpnd'");	// GP + noise
+	r->parseEvalQ("gpSettings$kern$comp <- list('rbf', 'white')");
+	r->parseEvalQ("gpSettings$scaleVal <- sd(data)");	// Equivalent to $scale2var1, but doesn't produce errors
+	
+	// Solve for the best fit
+	r->parseEvalQ("model <- gpCreate(1, 1, as.matrix(times), as.matrix(data), gpSettings)");
+	// Parameters are ln(1/tau^2), ln(amp^2), ln(noise^2), in that order
+	// NaN parameters propagate through log(), and is.na() is true for NaN
+	vector<double> startParams(3);
+	startParams[0] = -2.0*log(start[0]);
+	startParams[1] = log(start[1]);
+	startParams[2] = log(start[2]);
+	Rcpp::NumericVector rStart(startParams.begin(), startParams.end(), 3);
+	(*r)["start0"] = rStart;
+	r->parseEvalQ("start <- gpExtractParam(model)");
+	r->parseEvalQ("start[!is.na(start0)] <- start0[!is.na(start0)]");
+	r->parseEvalQ("model <- gpExpandParam(model, start)");
+	// Conjugate gradient optimization is supposed to converge within N iterations, 
+	//	where N is the size of the kernel matrix
+	// 10% margin for normal truncation errors
+	r->parseEvalQ("model <- gpOptimise(model, 0, 1.1*length(times))");
+	r->parseEvalQ("tau <- 1.0/sqrt(model$kern$comp[[1]]$inverseWidth)");
+	r->parseEvalQ("params <- c(tau, model$kern$comp[[1]]$variance, model$kern$comp[[2]]$variance)");
+
+	// Estimate the errors
+	r->parseEvalQ("hess <- jacobian(function(p) {gpGradient(p, model)}, gpExtractParam(model))");
+	// If likelihood maximized poorly, Hessian matrix will be asymmetric
+	r->parseEvalQ("isSym <- isSymmetric(hess, tol=1e-4)");
+	if ( !Rcpp::as<bool>((*r)["isSym"]) ) {
+		throw std::runtime_error("Hessian matrix is asymmetric. This probably means the fit is not a local likelihood maximum.");
+	}
+
+	r->parseEvalQ("covar <- solve(hess)");
+	// Covariance matrix is for ln(1/tau^2), ln(amp^2), ln(noise^2), in that order
+	r->parseEvalQ("err <- 0.5 * sqrt(covar[1,1]) * tau");
+
+	// copy-and-swap
+	// Rcpp will convert NAs to NaNs without error; the program 
+	//	rejects those solutions
+	vector<double> params = Rcpp::as<vector<double> >((*r)["params"]);
+	if (params.size() != 3) {
+		throw std::runtime_error("gptk returned the wrong number of hyperparameters.");
+	}
+	double tempErr = Rcpp::as<double>((*r)["err"]);
+
+	// IMPORTANT: no exceptions beyond this point
+
+	best.swap(params);
+	timeError = tempErr;
+}
+
+/** Copies an error message into a buffer provided by the program
+ *
+ * @param[in] what The message to copy.
+ * @param[out] message A buffer of @p messageSize characters, or null.
+ *
+ * @post @p message contains as much of @p what as fits, followed by 
+ *	a null character.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void copyMessage(const char* what, char* message, size_t messageSize) {
+	if (message != NULL && messageSize > 0) {
+		std::strncpy(message, what, messageSize - 1);
+		message[messageSize - 1] = '\0';
+	}
+}
+
+}}		// end lcmc::plugins
+
+extern "C" {
+
+/** Fits a squared exponential Gaussian process model using R
+ *
+ * Implements LcmcGpFitFunction; see pluginapi.h for the parameters.
+ *
+ * @exceptsafe Does not throw exceptions. The outputs other than 
+ *	@p message are unchanged if the fit fails.
+ */
+int lcmcRgpFit(const double* times, const double* data, size_t n, 
+		const double* start, double* best, double* timeError, 
+		long* iterations, char* message, size_t messageSize) {
+	try {
+		const std::vector<double> timeVec(times, times + n);
+		const std::vector<double> dataVec(data,  data  + n);
+		std::vector<double> params;
+		double err = 0.0;
+		lcmc::plugins::fitGpR(timeVec, dataVec, start, params, err);
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		std::copy(params.begin(), params.end(), best);
+		*timeError  = err;
+		*iterations = -1;	// gptk does not report its iterations
+		return LCMC_PLUGIN_OK;
+	} catch (const std::bad_alloc& e) {
+		lcmc::plugins::copyMessage(e.what(), message, messageSize);
+		return LCMC_PLUGIN_NO_MEMORY;
+	} catch (const std::exception& e) {
+		// Only std::exception can catch all possible Rcpp errors
+		lcmc::plugins::copyMessage(e.what(), message, messageSize);
+		return LCMC_PLUGIN_ERROR;
+	} catch (...) {
+		lcmc::plugins::copyMessage("Unknown error in R.", message, messageSize);
+		return LCMC_PLUGIN_ERROR;
+	}
+}
+
+/** Describes the rgp plugin
+ *
+ * @return A description that remains valid until the program exits.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const struct LcmcStatPlugin* lcmcStatPlugin(void) {
+	static const LcmcStatPlugin plugin = {LCMC_PLUGIN_API_VERSION, "rgp", 0, &lcmcRgpFit};
+	return &plugin;
+}
+
+}		// end extern "C"
@@ -0,0 +1,221 @@
+/** Progress reports for long simulation runs
+ * @file lightcurveMC/progress.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string>
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "progress.h"
+#include "stats/profile.h"
+
+namespace lcmc {
+
+using std::string;
+
+/** Returns the largest amount of memory the program has used so far
+ *
+ * @return The peak resident set size, in megabytes, or 0 if it is 
+ *	not available.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double peakMemoryMb() {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0.0;
+	}
+#ifdef __APPLE__
+	// Reported in bytes
+	return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+	// Reported in kilobytes
+	return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+}
+
+/** Returns the amount of memory the program is using now
+ *
+ * @return The resident set size, in megabytes, or 0 if it is not 
+ *	available on this platform.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double currentMemoryMb() {
+#ifdef __linux__
+	FILE* const statm = fopen("/proc/self/statm", "r");
+	if (statm == NULL) {
+		return 0.0;
+	}
+	long pages = 0, resident = 0;
+	const int nRead = fscanf(statm, "%ld %ld", &pages, &resident);
+	fclose(statm);
+	if (nRead != 2) {
+		return 0.0;
+	}
+	return static_cast<double>(resident) * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+#else
+	return 0.0;
+#endif
+}
+
+/** Formats a duration for a progress report
+ *
+ * @param[in] seconds The duration to format.
+ *
+ * @return The duration in hours, minutes, and seconds, or "?" if 
+ *	@p seconds is not a finite, nonnegative number.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the string.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string formatDuration(double seconds) {
+	if (!(seconds >= 0.0 && seconds < 1e9)) {
+		return "?";
+	}
+	const long total = static_cast<long>(seconds + 0.5);
+	char buffer[32];
+	if (total >= 3600) {
+		sprintf(buffer, "%ldh%02ldm%02lds", total / 3600, (total / 60) % 60, total % 60);
+	} else if (total >= 60) {
+		sprintf(buffer, "%ldm%02lds", total / 60, total % 60);
+	} else {
+		sprintf(buffer, "%lds", total);
+	}
+	return buffer;
+}
+
+/** Prepares to report on a run
+ *
+ * @param[in] interval The least time, in seconds, between two reports, 
+ *	or 0 if no reports should be printed.
+ * @param[in] nBins The number of bins in the run.
+ * @param[in] nTrials The number of trials in each bin.
+ * @param[in] file An open file handle representing the text file to 
+ *	write reports to.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	construct the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+ProgressMeter::ProgressMeter(double interval, long nBins, long nTrials, FILE* file) 
+		: interval(interval), nBins(nBins), nTrials(nTrials), file(file), 
+		runStart(stats::monotonicSeconds()), lastReport(runStart), 
+		binName(), binsStarted(0), binStart(runStart), binTrials(0), 
+		pastTrials(0), simSeconds(0.0), analysisSeconds(0.0) {
+}
+
+/** Starts reporting on a new bin
+ *
+ * @param[in] binName The name of the bin, as printed in the reports.
+ *
+ * @post Subsequent calls to addBatch() are counted towards @p binName.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the name.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void ProgressMeter::startBin(const string& binName) {
+	this->binName = binName;
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	binsStarted++;
+	pastTrials += binTrials;
+	binTrials = 0;
+	binStart = stats::monotonicSeconds();
+	simSeconds = analysisSeconds = 0.0;
+}
+
+/** Records the completion of a batch of trials
+ *
+ * @param[in] nTrials The number of trials in the batch.
+ * @param[in] simSeconds The time spent simulating the batch.
+ * @param[in] analysisSeconds The time spent analyzing the batch.
+ *
+ * @post If reports are enabled and at least the report interval has 
+ *	passed since the last report, a new report is printed.
+ *
+ * @exceptsafe Does not throw exceptions. Failure to print a report 
+ *	is ignored, since it does not affect the results of the run.
+ */
+void ProgressMeter::addBatch(long nTrials, double simSeconds, double analysisSeconds) {
+	binTrials             += nTrials;
+	this->simSeconds      += simSeconds;
+	this->analysisSeconds += analysisSeconds;
+	
+	if (interval > 0.0) {
+		const double now = stats::monotonicSeconds();
+		if (now - lastReport >= interval || binTrials >= this->nTrials) {
+			report(now);
+			lastReport = now;
+		}
+	}
+}
+
+/** Prints one progress report
+ *
+ * The report gives the trials completed in the current bin, the rate 
+ * at which they were completed, the fraction of the time spent 
+ * simulating and analyzing them, the estimated time left in the bin and 
+ * in the run, and the program's peak memory use.
+ *
+ * @param[in] now The current time, from stats::monotonicSeconds().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void ProgressMeter::report(double now) {
+	const double binTime = now - binStart;
+	const double runTime = now - runStart;
+	const double binRate = binTrials / binTime;
+	const double runRate = (pastTrials + binTrials) / runTime;
+	const long binLeft = nTrials - binTrials;
+	const long runLeft = binLeft + (nBins - binsStarted) * nTrials;
+	
+	try {
+		fprintf(file, "[%s %ld/%ld] %ld/%ld trials (%.0f%%), %.3g trials/s, "
+			"%.0f%% simulating, %.0f%% analyzing, "
+			"ETA %s (run %s), peak RSS %.0f MB\n", 
+			binName.c_str(), binsStarted, nBins, binTrials, nTrials, 
+			100.0 * binTrials / nTrials, binRate, 
+			100.0 * simSeconds / binTime, 100.0 * analysisSeconds / binTime, 
+			formatDuration(binLeft / binRate).c_str(), 
+			formatDuration(runLeft / runRate).c_str(), 
+			peakMemoryMb());
+		fflush(file);
+	} catch (const std::bad_alloc& e) {
+		// Skip this report
+	}
+}
+
+}	// end lcmc
@@ -0,0 +1,102 @@
+/** Progress reports for long simulation runs
+ * @file lightcurveMC/progress.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCPROGRESSH
+#define LCMCPROGRESSH
+
+#include <string>
+#include <cstdio>
+
+namespace lcmc {
+
+/** Returns the largest amount of memory the program has used so far
+ */
+double peakMemoryMb();
+
+/** Returns the amount of memory the program is using now
+ */
+double currentMemoryMb();
+
+/** ProgressMeter periodically reports how far a run has progressed.
+ *
+ * The meter is updated from the thread that runs the trial loop, 
+ * between batches, so it never needs to synchronize with the analysis 
+ * threads.
+ */
+class ProgressMeter {
+public:
+	/** Prepares to report on a run
+	 */
+	ProgressMeter(double interval, long nBins, long nTrials, FILE* file = stderr);
+
+	/** Starts reporting on a new bin
+	 */
+	void startBin(const std::string& binName);
+
+	/** Records the completion of a batch of trials
+	 */
+	void addBatch(long nTrials, double simSeconds, double analysisSeconds);
+
+private:
+	// Meters report on a single run, and are not copied
+	ProgressMeter(const ProgressMeter&);
+	ProgressMeter& operator=(const ProgressMeter&);
+
+	/** Prints one progress report
+	 */
+	void report(double now);
+
+	/** The least time between reports, or 0 for no reports */
+	double interval;
+	long nBins;
+	long nTrials;
+	FILE* file;
+	
+	/** The time at which the run started */
+	double runStart;
+	/** The time of the last report */
+	double lastReport;
+	
+	std::string binName;
+	/** The number of bins started, including the current one */
+	long binsStarted;
+	/** The time at which the current bin started */
+	double binStart;
+	/** The trials completed in the current bin */
+	long binTrials;
+	/** The trials completed in previous bins */
+	long pastTrials;
+	/** Time spent simulating and analyzing in the current bin */
+	double simSeconds, analysisSeconds;
+};
+
+}	// end lcmc
+
+#endif		// end LCMCPROGRESSH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/projectinfo.h
  * @author Krzysztof Findeisen
  * @date Created April 19, 2013
- * @date Last modified August 31, 2013
+ * @date Last modified October 14, 2026
  *
  * @todo Consider adding an algorithms overview for interested researchers.
  * @todo Rely less on integration tests
@@ -132,6 +132,11 @@
  * - <a href="http://cran.r-project.org/web/packages/gptk/">Gaussian Process Tool Kit (gptk)</a> 1.03 or later
  * - <a href="http://cran.r-project.org/web/packages/numDeriv/">numDeriv</a> 2006.4-1 or later
  * 
+ * R, Rcpp, and RInside are only needed by the rgp plugin 
+ * (plugins/lcmc_rgp.so), which is loaded when Gaussian process 
+ * statistics are fit with '--gp-fit r'; gptk and numDeriv are only 
+ * needed for those fits.
+ * 
  * These libraries are not provided with the installation package, as most 
  * systems will have Boost, GSL, and R installed already. Please contact your 
  * system administrator if these libraries are not installed.
@@ -233,6 +238,18 @@
  *	curve and returns the best-fit time scale parameters. Be aware that 
  *	this statistic is several orders of magnitude slower than the other 
  *	options.</dd>
+ *	<dt><tt>drwtau</tt></dt><dd>Fits a damped random walk model to each 
+ *	light curve and returns the best-fit damping timescale. The 
+ *	likelihood is computed in linear time, so this statistic is much 
+ *	faster than @c gptau.</dd>
+ *	<dt><tt>rmsplot</tt></dt><dd>Creates a file containing, for each 
+ *	light curve, the RMS from the first observation to each later 
+ *	observation, as a function of elapsed time.</dd>
+ *	<dt><tt>rmspairplot</tt></dt><dd>Creates a file containing, for each 
+ *	light curve, the median RMS over all stretches of the light curve 
+ *	as a function of their length, on the same grid as @c dmdtplot. 
+ *	This statistic takes time proportional to the square of the number 
+ *	of observations.</dd>
  *	</dl>
  * If no @c -\-stat arguments are given, the default behavior is to run all tests.
  * </dd>
@@ -646,7 +663,18 @@
  * time scale. Finally, the program prints the &chi;<sup>2</sup> statistic 
  * describing whether the inferred time scales are consistent with the true 
  * light curve time scale, given their formal errors.</dd>
+ * <dt><tt>drwtau</tt></dt><dd>The same as for @c gptau, but for the 
+ * damping timescale of the damped random walk model.</dd>
+ * <dt><tt>rmsplot</tt>, <tt>rmspairplot</tt></dt><dd>The program prints 
+ * the name of a file containing pairs of rows representing the 
+ * individual RMS functions from each run. The first row in each pair 
+ * contains the timescales in space-delimited format, while the second 
+ * row contains the RMS at each timescale in space-delimited format.</dd>
  * </dl>
+ * If a time limit was given with @c -\-stat-budget, the periodogram 
+ * statistics, @c gptau, and @c drwtau are each followed by the number of 
+ * light curves for which the calculation ran out of time. These light 
+ * curves count as simulations in which no value could be found.
  * 
  * @section examples Examples
  *
@@ -0,0 +1,741 @@
+/** Python bindings for the embedding interface
+ * @file lightcurveMC/python/lightcurvemc.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * The module exchanges arrays through the buffer protocol, so NumPy 
+ * arrays are read and written in place, and statistics are returned 
+ * as read-only views that numpy.asarray() wraps without copying. The 
+ * module does not need the NumPy headers.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Python.h must come before any standard header
+#include <Python.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../lightcurvemc.h"
+#include "../paramlist.h"
+
+namespace {
+
+using std::string;
+using std::vector;
+using lcmc::api::Analysis;
+
+/** Describes a C++ exception so that it can be reported to Python 
+ * after the interpreter lock has been reacquired
+ */
+struct Failure {
+	Failure() : type(NULL), message() {}
+	
+	/** The Python exception to raise, or null if nothing failed */
+	PyObject* type;
+	/** The message of the C++ exception */
+	string message;
+
+private:
+	// Failures are never passed around
+	Failure(const Failure&);
+	Failure& operator=(const Failure&);
+};
+
+/** Converts the exception currently being handled to a Failure
+ *
+ * @param[out] failure The description of the exception.
+ *
+ * @pre Must be called from inside a catch block.
+ *
+ * @post @p failure maps std::bad_alloc to MemoryError, 
+ *	std::out_of_range to IndexError, std::invalid_argument and 
+ *	std::domain_error to ValueError, and anything else to RuntimeError.
+ *
+ * @exceptsafe Does not throw exceptions. Does not need the interpreter 
+ *	lock.
+ */
+void classify(Failure& failure) {
+	try {
+		try {
+			throw;
+		} catch (const std::bad_alloc& e) {
+			failure.type = PyExc_MemoryError;
+		} catch (const std::out_of_range& e) {
+			failure.type = PyExc_IndexError;
+			failure.message = e.what();
+		} catch (const std::invalid_argument& e) {
+			failure.type = PyExc_ValueError;
+			failure.message = e.what();
+		} catch (const std::domain_error& e) {
+			failure.type = PyExc_ValueError;
+			failure.message = e.what();
+		} catch (const std::exception& e) {
+			failure.type = PyExc_RuntimeError;
+			failure.message = e.what();
+		} catch (...) {
+			failure.type = PyExc_RuntimeError;
+		}
+	} catch (const std::bad_alloc& e) {
+		// Message could not be copied
+		failure.type = PyExc_MemoryError;
+		failure.message.clear();
+	}
+}
+
+/** Raises a Python exception describing a C++ failure
+ *
+ * @param[in] failure The description of the exception.
+ *
+ * @return Null, for use as the return value of a Python function.
+ *
+ * @pre The caller holds the interpreter lock.
+ */
+PyObject* raise(const Failure& failure) {
+	if (failure.type == PyExc_MemoryError) {
+		return PyErr_NoMemory();
+	}
+	PyErr_SetString(failure.type, failure.message.c_str());
+	return NULL;
+}
+
+/** Requests a one-dimensional, contiguous array of doubles
+ *
+ * @param[in] obj Any object supporting the buffer protocol, such as a 
+ *	NumPy array, array.array('d'), or a memoryview.
+ * @param[out] view The buffer to fill. Must be released with 
+ *	PyBuffer_Release() if the function succeeds.
+ * @param[in] writable If set, the buffer must be writable.
+ * @param[in] name The name of the argument, for error messages.
+ *
+ * @return 0 on success, -1 with a Python exception set on failure.
+ *
+ * @post No data is copied; @p view points into the memory of @p obj.
+ */
+int getDoubles(PyObject* obj, Py_buffer& view, bool writable, const char* name) {
+	int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;
+	if (writable) {
+		flags |= PyBUF_WRITABLE;
+	}
+	if (PyObject_GetBuffer(obj, &view, flags) != 0) {
+		return -1;
+	}
+	const string format = (view.format != NULL ? view.format : "B");
+	if (view.ndim != 1 || view.itemsize != sizeof(double) 
+			|| (format != "d" && format != "=d" && format != "@d")) {
+		PyBuffer_Release(&view);
+		PyErr_Format(PyExc_TypeError, 
+			"%s must be a one-dimensional array of float64", name);
+		return -1;
+	}
+	return 0;
+}
+
+/** Returns the number of doubles in a buffer from getDoubles()
+ */
+size_t length(const Py_buffer& view) {
+	return static_cast<size_t>(view.len) / sizeof(double);
+}
+
+//----------------------------------------------------------------------
+// Views of library-owned arrays
+
+/** Exports a read-only array owned by an Analysis
+ *
+ * A view keeps its Analysis alive, and the Analysis refuses to change 
+ * while any of its views exist.
+ */
+struct ViewObject {
+	PyObject_HEAD
+	/** The Analysis holding the data */
+	PyObject* owner;
+	const double* data;
+	Py_ssize_t size;
+	Py_ssize_t stride;
+};
+
+/** Python type of ViewObject, created at import */
+PyTypeObject* viewType = NULL;
+
+/** An empty array, for statistics with no values */
+const double noData = 0.0;
+
+/** Python wrapper for lcmc::api::Analysis
+ */
+struct AnalysisObject {
+	PyObject_HEAD
+	Analysis* analysis;
+	lcmc::utils::PhotUnits units;
+	/** The number of ViewObjects pointing into @p analysis */
+	Py_ssize_t exports;
+	/** Set while another thread is adding a light curve */
+	bool busy;
+};
+
+/** Python type of AnalysisObject, created at import */
+PyTypeObject* analysisType = NULL;
+
+/** Wraps an array owned by an Analysis in a memoryview
+ *
+ * @param[in] owner The AnalysisObject holding the data.
+ * @param[in] data, n The array to wrap.
+ *
+ * @return A new reference to a read-only memoryview of format 'd', or 
+ *	null with a Python exception set.
+ */
+PyObject* makeView(AnalysisObject* owner, const double* data, size_t n) {
+	ViewObject* view = PyObject_New(ViewObject, viewType);
+	if (view == NULL) {
+		return NULL;
+	}
+	Py_INCREF(owner);
+	view->owner  = reinterpret_cast<PyObject*>(owner);
+	view->data   = (data != NULL ? data : &noData);
+	view->size   = static_cast<Py_ssize_t>(n);
+	view->stride = sizeof(double);
+	owner->exports++;
+	
+	PyObject* result = PyMemoryView_FromObject(reinterpret_cast<PyObject*>(view));
+	// The memoryview, if any, holds its own reference to the view
+	Py_DECREF(view);
+	return result;
+}
+
+void viewDealloc(PyObject* self) {
+	ViewObject* view = reinterpret_cast<ViewObject*>(self);
+	reinterpret_cast<AnalysisObject*>(view->owner)->exports--;
+	Py_DECREF(view->owner);
+	PyTypeObject* type = Py_TYPE(self);
+	PyObject_Free(self);
+	Py_DECREF(type);
+}
+
+int viewGetBuffer(PyObject* self, Py_buffer* buffer, int flags) {
+	if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+		PyErr_SetString(PyExc_BufferError, "Statistics are read-only");
+		buffer->obj = NULL;
+		return -1;
+	}
+	ViewObject* view = reinterpret_cast<ViewObject*>(self);
+	Py_INCREF(self);
+	buffer->obj        = self;
+	buffer->buf        = const_cast<double*>(view->data);
+	buffer->len        = view->size * view->stride;
+	buffer->readonly   = 1;
+	buffer->itemsize   = sizeof(double);
+	buffer->format     = ((flags & PyBUF_FORMAT) == PyBUF_FORMAT 
+		? const_cast<char*>("d") : NULL);
+	buffer->ndim       = 1;
+	buffer->shape      = ((flags & PyBUF_ND) == PyBUF_ND ? &view->size : NULL);
+	buffer->strides    = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES 
+		? &view->stride : NULL);
+	buffer->suboffsets = NULL;
+	buffer->internal   = NULL;
+	return 0;
+}
+
+//----------------------------------------------------------------------
+// Analysis
+
+int analysisInit(PyObject* self, PyObject* args, PyObject* kwds) {
+	static char* keywords[] = {const_cast<char*>("stats"), 
+		const_cast<char*>("fast_periodogram"), 
+		const_cast<char*>("units"), NULL};
+	PyObject* statSeq = NULL;
+	int fast = 0;
+	const char* units = "flux";
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|ps", keywords, 
+			&statSeq, &fast, &units)) {
+		return -1;
+	}
+	AnalysisObject* me = reinterpret_cast<AnalysisObject*>(self);
+	if (me->analysis != NULL) {
+		PyErr_SetString(PyExc_RuntimeError, "Analysis is already initialized");
+		return -1;
+	}
+	
+	const string unitName(units);
+	if (unitName != "flux" && unitName != "mag") {
+		PyErr_SetString(PyExc_ValueError, "units must be 'flux' or 'mag'");
+		return -1;
+	}
+	
+	PyObject* statList = PySequence_Fast(statSeq, "stats must be a sequence of str");
+	if (statList == NULL) {
+		return -1;
+	}
+	Failure failure;
+	try {
+		vector<string> names;
+		for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(statList); i++) {
+			const char* name = PyUnicode_AsUTF8(
+				PySequence_Fast_GET_ITEM(statList, i));
+			if (name == NULL) {
+				Py_DECREF(statList);
+				return -1;
+			}
+			names.push_back(name);
+		}
+		me->analysis = new Analysis(names, 
+			fast ? lcmc::stats::LS_FAST : lcmc::stats::LS_DIRECT);
+	} catch (...) {
+		classify(failure);
+	}
+	Py_DECREF(statList);
+	if (failure.type != NULL) {
+		raise(failure);
+		return -1;
+	}
+	
+	me->units   = (unitName == "mag" ? lcmc::utils::MAG_UNITS 
+		: lcmc::utils::FLUX_UNITS);
+	me->exports = 0;
+	me->busy    = false;
+	return 0;
+}
+
+void analysisDealloc(PyObject* self) {
+	delete reinterpret_cast<AnalysisObject*>(self)->analysis;
+	PyTypeObject* type = Py_TYPE(self);
+	type->tp_free(self);
+	Py_DECREF(type);
+}
+
+/** Checks that an Analysis may be used, and not just created
+ */
+bool ready(const AnalysisObject* me) {
+	if (me->analysis == NULL) {
+		PyErr_SetString(PyExc_RuntimeError, "Analysis was not initialized");
+		return false;
+	}
+	if (me->busy) {
+		PyErr_SetString(PyExc_RuntimeError, 
+			"Analysis is being used by another thread");
+		return false;
+	}
+	return true;
+}
+
+PyObject* analysisAdd(PyObject* self, PyObject* args) {
+	PyObject* timeObj = NULL;
+	PyObject* fluxObj = NULL;
+	if (!PyArg_ParseTuple(args, "OO", &timeObj, &fluxObj)) {
+		return NULL;
+	}
+	AnalysisObject* me = reinterpret_cast<AnalysisObject*>(self);
+	if (!ready(me)) {
+		return NULL;
+	}
+	if (me->exports > 0) {
+		PyErr_SetString(PyExc_BufferError, 
+			"Cannot add light curves while views of the statistics exist");
+		return NULL;
+	}
+	
+	Py_buffer times, fluxes;
+	if (getDoubles(timeObj, times, false, "times") != 0) {
+		return NULL;
+	}
+	if (getDoubles(fluxObj, fluxes, false, "fluxes") != 0) {
+		PyBuffer_Release(&times);
+		return NULL;
+	}
+	if (length(times) != length(fluxes)) {
+		PyBuffer_Release(&times);
+		PyBuffer_Release(&fluxes);
+		PyErr_SetString(PyExc_ValueError, 
+			"times and fluxes must have the same length");
+		return NULL;
+	}
+	
+	// The object is protected by the busy flag, and the inputs by 
+	//	their buffer exports, while other Python threads run
+	Failure failure;
+	me->busy = true;
+	Py_BEGIN_ALLOW_THREADS
+	try {
+		me->analysis->add(static_cast<const double*>(times.buf), 
+			static_cast<const double*>(fluxes.buf), length(times), me->units);
+	} catch (...) {
+		classify(failure);
+	}
+	Py_END_ALLOW_THREADS
+	me->busy = false;
+	
+	PyBuffer_Release(&times);
+	PyBuffer_Release(&fluxes);
+	if (failure.type != NULL) {
+		return raise(failure);
+	}
+	Py_RETURN_NONE;
+}
+
+PyObject* analysisValues(PyObject* self, PyObject* args) {
+	const char* tag = NULL;
+	if (!PyArg_ParseTuple(args, "s", &tag)) {
+		return NULL;
+	}
+	AnalysisObject* me = reinterpret_cast<AnalysisObject*>(self);
+	if (!ready(me)) {
+		return NULL;
+	}
+	try {
+		size_t n = 0;
+		const double* data = me->analysis->values(tag, n);
+		return makeView(me, data, n);
+	} catch (...) {
+		Failure failure;
+		classify(failure);
+		return raise(failure);
+	}
+}
+
+PyObject* analysisCurves(PyObject* self, PyObject* args) {
+	const char* tag = NULL;
+	if (!PyArg_ParseTuple(args, "s", &tag)) {
+		return NULL;
+	}
+	AnalysisObject* me = reinterpret_cast<AnalysisObject*>(self);
+	if (!ready(me)) {
+		return NULL;
+	}
+	try {
+		return PyLong_FromSize_t(me->analysis->curves(tag));
+	} catch (...) {
+		Failure failure;
+		classify(failure);
+		return raise(failure);
+	}
+}
+
+PyObject* analysisCurve(PyObject* self, PyObject* args) {
+	const char* tag = NULL;
+	Py_ssize_t i = 0;
+	if (!PyArg_ParseTuple(args, "sn", &tag, &i)) {
+		return NULL;
+	}
+	AnalysisObject* me = reinterpret_cast<AnalysisObject*>(self);
+	if (!ready(me)) {
+		return NULL;
+	}
+	if (i < 0) {
+		PyErr_SetString(PyExc_IndexError, "Curve index must not be negative");
+		return NULL;
+	}
+	const double* x = NULL;
+	const double* y = NULL;
+	size_t n = 0;
+	try {
+		me->analysis->curve(tag, static_cast<size_t>(i), x, y, n);
+	} catch (...) {
+		Failure failure;
+		classify(failure);
+		return raise(failure);
+	}
+	
+	PyObject* xView = makeView(me, x, n);
+	if (xView == NULL) {
+		return NULL;
+	}
+	PyObject* yView = makeView(me, y, n);
+	if (yView == NULL) {
+		Py_DECREF(xView);
+		return NULL;
+	}
+	// PyTuple_Pack does not steal references
+	PyObject* result = PyTuple_Pack(2, xView, yView);
+	Py_DECREF(xView);
+	Py_DECREF(yView);
+	return result;
+}
+
+Py_ssize_t analysisLength(PyObject* self) {
+	AnalysisObject* me = reinterpret_cast<AnalysisObject*>(self);
+	if (me->analysis == NULL) {
+		return 0;
+	}
+	return static_cast<Py_ssize_t>(me->analysis->size());
+}
+
+PyMethodDef analysisMethods[] = {
+	{"add", analysisAdd, METH_VARARGS, 
+		"add(times, fluxes)\n\n"
+		"Calculates the statistics of one light curve. Both arguments are\n"
+		"one-dimensional float64 buffers of the same length.\n"
+		"Other Python threads run during the calculation."}, 
+	{"values", analysisValues, METH_VARARGS, 
+		"values(tag) -> memoryview\n\n"
+		"Returns one scalar statistic for every light curve added, e.g.\n"
+		"values('c1') or values('cut50_3'), as a read-only view of the\n"
+		"library's storage. No light curves may be added while the view\n"
+		"exists."}, 
+	{"curves", analysisCurves, METH_VARARGS, 
+		"curves(tag) -> int\n\n"
+		"Returns the number of functions stored for one function statistic:\n"
+		"'pgram', 'dmdtmed', 'acf', 'sacf', 'peaks', 'rms', or 'rmsmed'."}, 
+	{"curve", analysisCurve, METH_VARARGS, 
+		"curve(tag, i) -> (memoryview, memoryview)\n\n"
+		"Returns the coordinates of the function stored for the i-th light\n"
+		"curve, as read-only views like those of values()."}, 
+	{NULL, NULL, 0, NULL}
+};
+
+PyType_Slot analysisSlots[] = {
+	{Py_tp_doc, const_cast<char*>(
+		"Analysis(stats, fast_periodogram=False, units='flux')\n\n"
+		"Calculates statistics of light curves held in memory. The\n"
+		"statistics are named as on the lightcurveMC command line.")}, 
+	{Py_tp_new, reinterpret_cast<void*>(PyType_GenericNew)}, 
+	{Py_tp_init, reinterpret_cast<void*>(analysisInit)}, 
+	{Py_tp_dealloc, reinterpret_cast<void*>(analysisDealloc)}, 
+	{Py_tp_methods, analysisMethods}, 
+	{Py_sq_length, reinterpret_cast<void*>(analysisLength)}, 
+	{0, NULL}
+};
+
+PyType_Spec analysisSpec = {
+	"lightcurvemc.Analysis", sizeof(AnalysisObject), 0, 
+	Py_TPFLAGS_DEFAULT, analysisSlots
+};
+
+PyType_Slot viewSlots[] = {
+	{Py_tp_dealloc, reinterpret_cast<void*>(viewDealloc)}, 
+	{Py_bf_getbuffer, reinterpret_cast<void*>(viewGetBuffer)}, 
+	{0, NULL}
+};
+
+PyType_Spec viewSpec = {
+	"lightcurvemc._View", sizeof(ViewObject), 0, 
+	Py_TPFLAGS_DEFAULT, viewSlots
+};
+
+//----------------------------------------------------------------------
+// Module functions
+
+PyObject* models(PyObject*, PyObject*) {
+	try {
+		const vector<string> names = lcmc::api::modelNames();
+		PyObject* result = PyList_New(static_cast<Py_ssize_t>(names.size()));
+		if (result == NULL) {
+			return NULL;
+		}
+		for (size_t i = 0; i < names.size(); i++) {
+			PyObject* name = PyUnicode_FromString(names[i].c_str());
+			if (name == NULL) {
+				Py_DECREF(result);
+				return NULL;
+			}
+			PyList_SET_ITEM(result, static_cast<Py_ssize_t>(i), name);
+		}
+		return result;
+	} catch (...) {
+		Failure failure;
+		classify(failure);
+		return raise(failure);
+	}
+}
+
+/** Converts a dict of parameter values to a ParamList
+ *
+ * @return 0 on success, -1 with a Python exception set on failure.
+ */
+int toParams(PyObject* dict, lcmc::models::ParamList& params) {
+	if (dict == NULL || dict == Py_None) {
+		return 0;
+	}
+	if (!PyDict_Check(dict)) {
+		PyErr_SetString(PyExc_TypeError, "params must be a dict");
+		return -1;
+	}
+	Py_ssize_t pos = 0;
+	PyObject* key = NULL;
+	PyObject* value = NULL;
+	while (PyDict_Next(dict, &pos, &key, &value)) {
+		const char* name = PyUnicode_AsUTF8(key);
+		if (name == NULL) {
+			return -1;
+		}
+		const double x = PyFloat_AsDouble(value);
+		if (x == -1.0 && PyErr_Occurred()) {
+			return -1;
+		}
+		try {
+			params.add(name, x);
+		} catch (...) {
+			Failure failure;
+			classify(failure);
+			raise(failure);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+PyObject* simulate(PyObject*, PyObject* args, PyObject* kwds) {
+	static char* keywords[] = {const_cast<char*>("model"), 
+		const_cast<char*>("times"), const_cast<char*>("params"), 
+		const_cast<char*>("seed"), const_cast<char*>("trial"), 
+		const_cast<char*>("out"), NULL};
+	const char* model = NULL;
+	PyObject* timeObj = NULL;
+	PyObject* paramObj = NULL;
+	long seed = -1;
+	long trial = 0;
+	PyObject* outObj = NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "sO|OllO", keywords, 
+			&model, &timeObj, &paramObj, &seed, &trial, &outObj)) {
+		return NULL;
+	}
+	
+	lcmc::models::ParamList params;
+	if (toParams(paramObj, params) != 0) {
+		return NULL;
+	}
+	Py_buffer times;
+	if (getDoubles(timeObj, times, false, "times") != 0) {
+		return NULL;
+	}
+	
+	// Without an output array, write into a new bytearray
+	PyObject* result = NULL;
+	if (outObj == NULL || outObj == Py_None) {
+		PyObject* bytes = PyByteArray_FromStringAndSize(NULL, times.len);
+		if (bytes == NULL) {
+			PyBuffer_Release(&times);
+			return NULL;
+		}
+		PyObject* raw = PyMemoryView_FromObject(bytes);
+		Py_DECREF(bytes);
+		if (raw == NULL) {
+			PyBuffer_Release(&times);
+			return NULL;
+		}
+		result = PyObject_CallMethod(raw, "cast", "s", "d");
+		Py_DECREF(raw);
+	} else {
+		Py_INCREF(outObj);
+		result = outObj;
+	}
+	if (result == NULL) {
+		PyBuffer_Release(&times);
+		return NULL;
+	}
+	Py_buffer fluxes;
+	if (getDoubles(result, fluxes, true, "out") != 0) {
+		PyBuffer_Release(&times);
+		Py_DECREF(result);
+		return NULL;
+	}
+	if (length(fluxes) != length(times)) {
+		PyBuffer_Release(&times);
+		PyBuffer_Release(&fluxes);
+		Py_DECREF(result);
+		PyErr_SetString(PyExc_ValueError, "out must have the same length as times");
+		return NULL;
+	}
+	
+	Failure failure;
+	const double* t = static_cast<const double*>(times.buf);
+	double* f = static_cast<double*>(fluxes.buf);
+	if (seed >= 0) {
+		// Seeded simulations draw only from per-thread streams
+		Py_BEGIN_ALLOW_THREADS
+		try {
+			lcmc::api::simulate(model, params, t, length(times), seed, trial, f);
+		} catch (...) {
+			classify(failure);
+		}
+		Py_END_ALLOW_THREADS
+	} else {
+		// Unseeded simulations share one generator, which the 
+		//	interpreter lock protects
+		try {
+			lcmc::api::simulate(model, params, t, length(times), seed, trial, f);
+		} catch (...) {
+			classify(failure);
+		}
+	}
+	
+	PyBuffer_Release(&times);
+	PyBuffer_Release(&fluxes);
+	if (failure.type != NULL) {
+		Py_DECREF(result);
+		return raise(failure);
+	}
+	return result;
+}
+
+PyMethodDef moduleMethods[] = {
+	{"models", models, METH_NOARGS, 
+		"models() -> list of str\n\n"
+		"Returns the names of the light curve models simulate() accepts."}, 
+	{"simulate", reinterpret_cast<PyCFunction>(reinterpret_cast<void(*)()>(simulate)), 
+		METH_VARARGS | METH_KEYWORDS, 
+		"simulate(model, times, params=None, seed=-1, trial=0, out=None)\n\n"
+		"Simulates a light curve at the given times. params maps parameter\n"
+		"names ('a', 'p', 'ph', 'width', 'd', ...) to\n"
+		"values. A nonnegative seed makes the result depend only on seed and\n"
+		"trial, and lets other Python threads run during the simulation.\n"
+		"The fluxes are written into out if given, otherwise into a new\n"
+		"array, which is returned as a float64 memoryview."}, 
+	{NULL, NULL, 0, NULL}
+};
+
+PyModuleDef moduleDef = {
+	PyModuleDef_HEAD_INIT, "lightcurvemc", 
+	"Simulates and analyzes light curves with Lightcurve MC.\n\n"
+	"Arrays are exchanged through the buffer protocol: NumPy arrays are\n"
+	"read and written in place, and results are memoryviews that\n"
+	"numpy.asarray() wraps without copying.", 
+	-1, moduleMethods, NULL, NULL, NULL, NULL
+};
+
+}	// end unnamed namespace
+
+PyMODINIT_FUNC PyInit_lightcurvemc() {
+	PyObject* module = PyModule_Create(&moduleDef);
+	if (module == NULL) {
+		return NULL;
+	}
+	
+	viewType = reinterpret_cast<PyTypeObject*>(PyType_FromSpec(&viewSpec));
+	analysisType = reinterpret_cast<PyTypeObject*>(PyType_FromSpec(&analysisSpec));
+	if (viewType == NULL || analysisType == NULL) {
+		Py_XDECREF(viewType);
+		Py_XDECREF(analysisType);
+		Py_DECREF(module);
+		return NULL;
+	}
+	// PyModule_AddObject steals the reference on success only
+	Py_INCREF(analysisType);
+	if (PyModule_AddObject(module, "Analysis", 
+			reinterpret_cast<PyObject*>(analysisType)) != 0) {
+		Py_DECREF(analysisType);
+		Py_DECREF(module);
+		return NULL;
+	}
+	
+	return module;
+}
@@ -0,0 +1,521 @@
+/** Cache of the results of finished bins
+ * @file lightcurveMC/resultcache.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <ctime>
+#include <new>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include "hash.h"
+#include "paramlist.h"
+#include "projectinfo.h"
+#include "resultcache.h"
+#include "../common/cerror.h"
+#include "../common/fileio.h"
+
+namespace lcmc {
+
+using boost::shared_ptr;
+using boost::uint64_t;
+using std::string;
+using std::vector;
+
+/** The file in each cache entry holding the printed row */
+const char ROW_FILE[]  = "row.txt";
+/** The file in each cache entry listing the distribution files */
+const char LIST_FILE[] = "files.txt";
+
+/** Opens a file, returning a null pointer instead of throwing if it 
+ *	cannot be opened
+ *
+ * @param[in] fileName, mode The arguments to fopen().
+ *
+ * @return A handle that closes the file when it is destroyed, or a 
+ *	null handle if the file could not be opened.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	for the handle.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+shared_ptr<FILE> tryOpenFile(const string& fileName, const char* mode) {
+	FILE* file = fopen(fileName.c_str(), mode);
+	if (file == NULL) {
+		return shared_ptr<FILE>();
+	}
+	return shared_ptr<FILE>(file, &fclose);
+}
+
+/** Reads a whole file into memory
+ *
+ * @param[in] fileName The file to read.
+ * @param[out] contents The bytes of the file.
+ *
+ * @return True if the file was read, false if it could not be.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the file.
+ *
+ * @exceptsafe @p contents is unchanged if the return value is false 
+ *	or in the event of an exception.
+ */
+bool readContents(const string& fileName, vector<char>& contents) {
+	shared_ptr<FILE> file = tryOpenFile(fileName, "rb");
+	if (file.get() == NULL) {
+		return false;
+	}
+	
+	vector<char> temp;
+	char buffer[65536];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file.get())) > 0) {
+		temp.insert(temp.end(), buffer, buffer + n);
+	}
+	if (ferror(file.get())) {
+		return false;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	contents.swap(temp);
+	return true;
+}
+
+/** Writes a whole file from memory
+ *
+ * @param[in] fileName The file to write. Any existing file is replaced.
+ * @param[in] contents The bytes to write.
+ *
+ * @return True if the file was written, false if it could not be.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	open the file.
+ *
+ * @exceptsafe The program state is unchanged in the event of an 
+ *	exception, but @p fileName may be incomplete if the return value 
+ *	is false.
+ */
+bool writeContents(const string& fileName, const vector<char>& contents) {
+	shared_ptr<FILE> file = tryOpenFile(fileName, "wb");
+	if (file.get() == NULL) {
+		return false;
+	}
+	if (!contents.empty() 
+			&& fwrite(&contents[0], contents.size(), 1, file.get()) != 1) {
+		return false;
+	}
+	return fflush(file.get()) == 0;
+}
+
+/** Tests whether a file holds results of a bin
+ *
+ * @param[in] fileName The name of the file, without a directory.
+ * @param[in] binLabel The label of the bin, as given by 
+ *	stats::LcBinStats::makeFileName().
+ *
+ * @return True if @p fileName is a distribution file (<tt>run_*</tt>) 
+ *	or a printed light curve (<tt>lightcurve_*</tt>) of the bin.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compare the names.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+bool isBinFile(const string& fileName, const string& binLabel) {
+	if (fileName.compare(0, 4, "run_") != 0 
+			&& fileName.compare(0, 11, "lightcurve_") != 0) {
+		return false;
+	}
+	
+	// The label is followed by an extension, a part number, or a 
+	//	light curve number, so that bins whose labels start the 
+	//	same way don't match
+	const string tag = "_" + binLabel;
+	for(size_t pos = fileName.find(tag); pos != string::npos; 
+			pos = fileName.find(tag, pos + 1)) {
+		const size_t end = pos + tag.size();
+		if (end < fileName.size() 
+				&& (fileName[end] == '.' || fileName[end] == '_')) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Lists the results of a bin in the working directory
+ *
+ * @param[in] binLabel The label of the bin, as given by 
+ *	stats::LcBinStats::makeFileName().
+ * @param[in] since The time at which the bin started.
+ *
+ * @return The names of the files of the bin, as tested by isBinFile(), 
+ *	that were modified no earlier than @p since. Files left by earlier 
+ *	runs are therefore excluded.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	list the files.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<string> findBinFiles(const string& binLabel, std::time_t since) {
+	vector<string> files;
+	
+	DIR* rawDir = opendir(".");
+	if (rawDir == NULL) {
+		return files;
+	}
+	shared_ptr<DIR> cwd(rawDir, &closedir);
+	
+	struct dirent* entry;
+	while ((entry = readdir(cwd.get())) != NULL) {
+		const string name = entry->d_name;
+		struct stat info;
+		if (isBinFile(name, binLabel) && stat(name.c_str(), &info) == 0 
+				&& S_ISREG(info.st_mode) && info.st_mtime >= since) {
+			files.push_back(name);
+		}
+	}
+	return files;
+}
+
+/** Deletes a partly written cache entry
+ *
+ * @param[in] entry The directory of the entry.
+ * @param[in] files The names of the distribution files that might 
+ *	have been copied to it.
+ *
+ * @post @p entry no longer exists, if it could be removed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void removeEntry(const string& entry, const vector<string>& files) {
+	try {
+		for(vector<string>::const_iterator it = files.begin(); 
+				it != files.end(); it++) {
+			remove((entry + "/" + *it).c_str());
+		}
+		remove((entry + "/" + ROW_FILE).c_str());
+		remove((entry + "/" + LIST_FILE).c_str());
+		rmdir(entry.c_str());
+	} catch (const std::bad_alloc& e) {
+		// Leaves some litter, but never a complete entry
+	}
+}
+
+/** Creates a key that identifies nothing
+ *
+ * @post value() is the same for every key created this way.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ResultKey::ResultKey() : hash(utils::fnvBasis()) {
+}
+
+/** Adds a name or other text to the key
+ *
+ * @param[in] text The text to add.
+ *
+ * @post The key depends on @p text. The length of @p text is included, 
+ *	so that adding "ab" then "c" differs from adding "a" then "bc".
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void ResultKey::add(const string& text) {
+	const size_t length = text.size();
+	hash = utils::fnvHash(hash, &length, sizeof(length));
+	hash = utils::fnvHash(hash, text.data(), length);
+}
+
+/** Adds an integer to the key
+ *
+ * @param[in] value The integer to add. Flags and enumerations may be 
+ *	added by converting them to long.
+ *
+ * @post The key depends on @p value.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void ResultKey::add(long value) {
+	hash = utils::fnvHash(hash, &value, sizeof(value));
+}
+
+/** Adds a number to the key
+ *
+ * @param[in] value The number to add.
+ *
+ * @post The key depends on every bit of @p value.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void ResultKey::add(double value) {
+	hash = utils::fnvHash(hash, &value, sizeof(value));
+}
+
+/** Adds parameter ranges to the key
+ *
+ * @param[in] limits The ranges to add.
+ *
+ * @post The key depends on the name, the limits, and the distribution 
+ *	of every parameter in @p limits.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void ResultKey::add(const models::RangeList& limits) {
+	for(models::RangeList::const_iterator it = limits.begin(); 
+			it != limits.end(); it++) {
+		add(models::paramName(it.getId()));
+		add(limits.getMin(*it));
+		add(limits.getMax(*it));
+		add(static_cast<long>(limits.getType(*it)));
+	}
+}
+
+/** Adds the contents of a file to the key
+ *
+ * @param[in] fileName The file to add.
+ *
+ * @post The key depends on the bytes in @p fileName, but not on its 
+ *	name, so that renaming a file does not invalidate the cache.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be read.
+ *
+ * @exceptsafe The key is unchanged in the event of an exception.
+ */
+void ResultKey::addFile(const string& fileName) {
+	shared_ptr<FILE> file = kpfutils::fileCheckOpen(fileName, "rb");
+	
+	uint64_t temp = hash;
+	char buffer[65536];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file.get())) > 0) {
+		temp = utils::fnvHash(temp, buffer, n);
+	}
+	if (ferror(file.get())) {
+		kpfutils::fileError(file.get(), "Could not read " + fileName + ": ");
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	hash = temp;
+}
+
+/** Adds the version of the running program to the key
+ *
+ * Development builds rarely change their version number, so the 
+ * program file itself is added where the system allows it to be read.
+ *
+ * @post The key depends on the program version, and on the bytes of 
+ *	the executable if it could be found through 
+ *	<tt>/proc/self/exe</tt>.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the program.
+ *
+ * @exceptsafe The key is unchanged in the event of an exception.
+ */
+void ResultKey::addProgram() {
+	ResultKey temp(*this);
+	temp.add(string(VERSION_STRING));
+	try {
+		temp.addFile("/proc/self/exe");
+	} catch (const kpfutils::except::FileIo& e) {
+		// Not Linux; fall back to the version alone
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	hash = temp.hash;
+}
+
+/** Returns the hash of everything added to the key
+ *
+ * @return A value that identifies the sequence of calls made to the 
+ *	key.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint64_t ResultKey::value() const {
+	return hash;
+}
+
+/** Uses a directory as a cache
+ *
+ * @param[in] dir The directory in which to store the results. It is 
+ *	created the first time a bin is saved.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+ResultCache::ResultCache(const string& dir) : dir(dir) {
+}
+
+/** Returns the directory holding one bin
+ *
+ * @param[in] key The identifier of the bin.
+ *
+ * @return The path to the directory, whether or not it exists.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	for the name.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+string ResultCache::entryDir(const ResultKey& key) const {
+	char name[64];
+	sprintf(name, "bin_%08lx%08lx", 
+		static_cast<unsigned long>((key.value() >> 32) & 0xffffffffUL),
+		static_cast<unsigned long>( key.value()        & 0xffffffffUL));
+	return dir + "/" + name;
+}
+
+/** Reprints a bin saved by save(), if there is one
+ *
+ * @param[in] key The identifier of the bin.
+ * @param[in] file An open file handle representing the text file to 
+ *	print the row to.
+ *
+ * @return True if the bin was found and reprinted, false if it must 
+ *	be run.
+ *
+ * @post If the return value is true, the saved row has been printed to 
+ *	@p file, and the saved distribution files and light curves have 
+ *	been restored to the working directory, replacing any files with 
+ *	the same names.
+ *
+ * @exception std::runtime_error Thrown if the row could not be printed.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the bin.
+ *
+ * @exceptsafe Nothing is printed in the event of an exception, but 
+ *	some distribution files may have been restored.
+ */
+bool ResultCache::replay(const ResultKey& key, FILE* const file) const {
+	const string entry = entryDir(key);
+	
+	vector<char> row, list;
+	if (!readContents(entry + "/" + ROW_FILE, row) 
+			|| !readContents(entry + "/" + LIST_FILE, list)) {
+		return false;
+	}
+	
+	// One name per line
+	string name;
+	for(vector<char>::const_iterator it = list.begin(); it != list.end(); it++) {
+		if (*it != '\n') {
+			name += *it;
+			continue;
+		}
+		vector<char> contents;
+		if (!readContents(entry + "/" + name, contents) 
+				|| !writeContents(name, contents)) {
+			fprintf(stderr, "WARNING: could not restore %s from %s; running the bin again\n", 
+				name.c_str(), entry.c_str());
+			return false;
+		}
+		name.clear();
+	}
+	
+	if (fprintf(file, "%s\n", string(row.begin(), row.end()).c_str()) < 0) {
+		kpfutils::cError("Could not print output: ");
+	}
+	return true;
+}
+
+/** Saves the results of a finished bin
+ *
+ * The entry is first written to a temporary directory, then moved into 
+ * place, so that other runs never read a partial entry. Failure to 
+ * save the bin is not an error, since it can always be run again.
+ *
+ * @param[in] key The identifier of the bin.
+ * @param[in] binLabel The label of the bin, as given by 
+ *	stats::LcBinStats::makeFileName().
+ * @param[in] row The row printed for the bin, without its newline.
+ * @param[in] binStart The time at which the bin started. Distribution 
+ *	files and light curves of the bin written since then are saved 
+ *	with the row.
+ *
+ * @post replay(@p key) reprints the bin, unless it could not be saved.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void ResultCache::save(const ResultKey& key, const string& binLabel, 
+		const string& row, std::time_t binStart) const {
+	try {
+		// Fails harmlessly if the directory already exists
+		mkdir(dir.c_str(), 0777);
+		
+		const string entry = entryDir(key);
+		char suffix[32];
+		sprintf(suffix, ".tmp%ld", static_cast<long>(getpid()));
+		const string tempDir = entry + suffix;
+		if (mkdir(tempDir.c_str(), 0777) != 0) {
+			fprintf(stderr, "WARNING: could not save results of %s to %s\n", 
+				binLabel.c_str(), dir.c_str());
+			return;
+		}
+		
+		const vector<string> files = findBinFiles(binLabel, binStart);
+		bool written = writeContents(tempDir + "/" + ROW_FILE, 
+			vector<char>(row.begin(), row.end()));
+		string list;
+		for(vector<string>::const_iterator it = files.begin(); 
+				written && it != files.end(); it++) {
+			vector<char> contents;
+			written = readContents(*it, contents) 
+				&& writeContents(tempDir + "/" + *it, contents);
+			list += *it + "\n";
+		}
+		written = written && writeContents(tempDir + "/" + LIST_FILE, 
+			vector<char>(list.begin(), list.end()));
+		
+		if (!written) {
+			fprintf(stderr, "WARNING: could not save results of %s to %s\n", 
+				binLabel.c_str(), dir.c_str());
+			removeEntry(tempDir, files);
+		} else if (rename(tempDir.c_str(), entry.c_str()) != 0) {
+			// Another run saved the same bin first
+			removeEntry(tempDir, files);
+		}
+	} catch (const std::bad_alloc& e) {
+		// Saving is optional
+	}
+}
+
+}		// end lcmc
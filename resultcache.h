@@ -0,0 +1,120 @@
+/** Defines a cache of the results of finished bins
+ * @file lightcurveMC/resultcache.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCRESULTCACHEH
+#define LCMCRESULTCACHEH
+
+#include <string>
+#include <cstdio>
+#include <ctime>
+#include <boost/cstdint.hpp>
+#include "paramlist.h"
+
+namespace lcmc {
+
+/** ResultKey identifies everything that determines the results of a 
+ * bin, so that a ResultCache can tell whether the bin has been run 
+ * before.
+ *
+ * The key is a hash of the values added to it, in the order they were 
+ * added. Values that are not part of the key, such as the contents of 
+ * files named by an input file, are not detected when they change.
+ */
+class ResultKey {
+public:
+	/** Creates a key that identifies nothing
+	 */
+	ResultKey();
+	
+	/** Adds a name or other text to the key
+	 */
+	void add(const std::string& text);
+	
+	/** Adds an integer to the key
+	 */
+	void add(long value);
+	
+	/** Adds a number to the key
+	 */
+	void add(double value);
+	
+	/** Adds parameter ranges to the key
+	 */
+	void add(const models::RangeList& limits);
+	
+	/** Adds the contents of a file to the key
+	 */
+	void addFile(const std::string& fileName);
+	
+	/** Adds the version of the running program to the key
+	 */
+	void addProgram();
+	
+	/** Returns the hash of everything added to the key
+	 */
+	boost::uint64_t value() const;
+	
+private:
+	boost::uint64_t hash;
+};
+
+/** ResultCache keeps the printed row and the distribution files of 
+ * each finished bin, so that a later run of the same bin can reprint 
+ * them instead of simulating it again.
+ *
+ * Each bin is stored in its own subdirectory of the cache, named for 
+ * its ResultKey. Several runs may share a cache.
+ */
+class ResultCache {
+public:
+	/** Uses a directory as a cache
+	 */
+	explicit ResultCache(const std::string& dir);
+	
+	/** Reprints a bin saved by save(), if there is one
+	 */
+	bool replay(const ResultKey& key, FILE* const file) const;
+	
+	/** Saves the results of a finished bin
+	 */
+	void save(const ResultKey& key, const std::string& binLabel, 
+		const std::string& row, std::time_t binStart) const;
+	
+private:
+	/** Returns the directory holding one bin
+	 */
+	std::string entryDir(const ResultKey& key) const;
+	
+	std::string dir;
+};
+
+}		// end lcmc
+
+#endif		// end LCMCRESULTCACHEH
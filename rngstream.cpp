@@ -0,0 +1,606 @@
+/** Functions for generating reproducible random number streams
+ * @file lightcurveMC/rngstream.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/thread/tss.hpp>
+#include <gsl/gsl_rng.h>
+#include "rngstream.h"
+#include "waves/lcstochastic.h"
+#include "../common/alloc.tmp.h"
+
+namespace lcmc { namespace utils {
+
+using boost::uint32_t;
+using boost::uint64_t;
+
+/** Applies the Philox4x32-10 bijection to a counter
+ *
+ * This is the counter-based generator described by Salmon et al. (2011),
+ * "Parallel random numbers: as easy as 1, 2, 3". Distinct
+ * (counter, key) pairs give statistically independent output.
+ *
+ * @param[in] counter The value to encrypt.
+ * @param[in] key The key with which to encrypt @p counter.
+ * @param[out] result The encrypted value of @p counter.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4]) {
+	const uint32_t M0 = 0xD2511F53UL, M1 = 0xCD9E8D57UL;
+	const uint32_t W0 = 0x9E3779B9UL, W1 = 0xBB67AE85UL;
+
+	uint32_t c[4] = {counter[0], counter[1], counter[2], counter[3]};
+	uint32_t k[2] = {key[0], key[1]};
+
+	for(int round = 0; round < 10; round++) {
+		if (round > 0) {
+			k[0] += W0;
+			k[1] += W1;
+		}
+
+		const uint64_t prod0 = static_cast<uint64_t>(M0) * c[0];
+		const uint64_t prod1 = static_cast<uint64_t>(M1) * c[2];
+		const uint32_t hi0 = static_cast<uint32_t>(prod0 >> 32);
+		const uint32_t lo0 = static_cast<uint32_t>(prod0);
+		const uint32_t hi1 = static_cast<uint32_t>(prod1 >> 32);
+		const uint32_t lo1 = static_cast<uint32_t>(prod1);
+
+		c[0] = hi1 ^ c[1] ^ k[0];
+		c[1] = lo1;
+		c[2] = hi0 ^ c[3] ^ k[1];
+		c[3] = lo0;
+	}
+
+	for(int i = 0; i < 4; i++) {
+		result[i] = c[i];
+	}
+}
+
+extern "C" {
+
+/** Initializes a Philox generator using the GSL seeding interface.
+ *
+ * @param[out] vstate The generator state to initialize.
+ * @param[in] seed The key of the new stream.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+static void philoxSet(void* vstate, unsigned long int seed) {
+	PhiloxState* state = static_cast<PhiloxState*>(vstate);
+
+	for(int i = 0; i < 4; i++) {
+		state->counter[i] = 0;
+		state->block[i]   = 0;
+	}
+	state->key[0] = static_cast<uint32_t>(seed);
+	state->key[1] = 0;
+	// Force a new block on the first draw
+	state->next   = 4;
+}
+
+/** Draws a random integer from a Philox generator.
+ *
+ * @param[in,out] vstate The generator state.
+ *
+ * @return A number distributed uniformly over [0, 2^32).
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+static unsigned long int philoxGet(void* vstate) {
+	PhiloxState* state = static_cast<PhiloxState*>(vstate);
+
+	if (state->next >= 4) {
+		philox4x32(state->counter, state->key, state->block);
+		state->next = 0;
+		// The low half of the counter is the block number
+		if (++(state->counter[0]) == 0) {
+			++(state->counter[1]);
+		}
+	}
+
+	return state->block[state->next++];
+}
+
+/** Draws a random floating-point number from a Philox generator.
+ *
+ * @param[in,out] vstate The generator state.
+ *
+ * @return A number distributed uniformly over [0, 1).
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+static double philoxGetDouble(void* vstate) {
+	return philoxGet(vstate) / 4294967296.0;
+}
+
+/** GSL description of the Philox generator
+ */
+static const gsl_rng_type philoxInfo = {
+	"philox4x32-10",
+	0xFFFFFFFFUL,
+	0,
+	sizeof(PhiloxState),
+	&philoxSet,
+	&philoxGet,
+	&philoxGetDouble
+};
+
+}	// end extern "C"
+
+/** Returns the GSL description of the counter-based generator used
+ *	for trial streams
+ *
+ * @return A generator type that can be passed to gsl_rng_alloc().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const gsl_rng_type* philoxType() {
+	return &philoxInfo;
+}
+
+/** Sets a Philox generator to the start of one stream of one trial
+ *
+ * @param[out] state The generator state to initialize.
+ * @param[in] seed The seed for the entire simulation run.
+ * @param[in] bin The index of the light curve or parameter bin being
+ *	simulated.
+ * @param[in] trial The index of the trial within @p bin.
+ * @param[in] stream The purpose of the stream within the trial.
+ *
+ * @post The sequence of numbers produced by @p state depends
+ *	only on @p seed, @p bin, @p trial, and @p stream.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void initStream(PhiloxState& state, unsigned long seed, unsigned long bin,
+		unsigned long trial, StreamType stream) {
+	philoxSet(&state, seed);
+	state.key[1]     = static_cast<uint32_t>(bin);
+	state.counter[2] = static_cast<uint32_t>(trial);
+	state.counter[3] = static_cast<uint32_t>(stream);
+}
+
+/** Fills an array with independent normal random variates
+ *
+ * The variates are generated with the Box-Muller transform, a block 
+ * at a time: the uniform deviates for a block are drawn first, then 
+ * transformed in loops free of calls to the generator, which the 
+ * compiler may vectorize.
+ *
+ * @param[in] rng The generator from which to draw uniform deviates.
+ * @param[out] out An array of at least @p n elements in which to 
+ *	store the variates.
+ * @param[in] n The number of variates to generate.
+ * @param[in] sigma The standard deviation of the variates.
+ *
+ * @post @p out[i] is normally distributed with mean 0 and standard 
+ *	deviation @p sigma, for all i < @p n.
+ * @post 2&lceil;@p n/2&rceil; uniform deviates have been drawn from @p rng.
+ *
+ * @perform O(@p n) time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void fillNormal(const gsl_rng* rng, double out[], size_t n, double sigma) {
+	const double TWO_PI = 6.283185307179586476925;
+	// Number of pairs of variates per block
+	const size_t BLOCK = 64;
+	double radius[BLOCK];
+	double angle [BLOCK];
+	
+	for(size_t start = 0; start < n; start += 2*BLOCK) {
+		const size_t nValues = std::min(n - start, 2*BLOCK);
+		const size_t nPairs  = (nValues + 1) / 2;
+		
+		for(size_t i = 0; i < nPairs; i++) {
+			// gsl_rng_uniform() may return 0 but not 1
+			radius[i] = 1.0 - gsl_rng_uniform(rng);
+			angle [i] = gsl_rng_uniform(rng);
+		}
+		for(size_t i = 0; i < nPairs; i++) {
+			radius[i] = sigma * sqrt(-2.0 * log(radius[i]));
+			angle [i] *= TWO_PI;
+		}
+		
+		double* const block = out + start;
+		for(size_t i = 0; i < nValues/2; i++) {
+			block[2*i  ] = radius[i] * cos(angle[i]);
+			block[2*i+1] = radius[i] * sin(angle[i]);
+		}
+		if (nValues % 2 != 0) {
+			block[nValues-1] = radius[nPairs-1] * cos(angle[nPairs-1]);
+		}
+	}
+}
+
+/** Allocates a random number generator for one stream of one trial
+ *
+ * @param[in] seed The seed for the entire simulation run.
+ * @param[in] bin The index of the light curve or parameter bin being
+ *	simulated.
+ * @param[in] trial The index of the trial within @p bin.
+ * @param[in] stream The purpose of the stream within the trial.
+ *
+ * @return A newly allocated generator. The caller is responsible for
+ *	freeing it with gsl_rng_free().
+ *
+ * @post The sequence of numbers produced by the return value depends
+ *	only on @p seed, @p bin, @p trial, and @p stream.
+ *
+ * @exception std::bad_alloc Thrown if there was not enough memory
+ *	to construct the generator.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+gsl_rng* allocStream(unsigned long seed, unsigned long bin,
+		unsigned long trial, StreamType stream) {
+	gsl_rng* rng = kpfutils::checkAlloc(gsl_rng_alloc(philoxType()));
+
+	initStream(*static_cast<PhiloxState*>(rng->state), seed, bin, trial, stream);
+
+	return rng;
+}
+
+/** Primitive polynomial and initial direction numbers for one 
+ *	dimension of a Sobol sequence
+ */
+struct SobolPoly {
+	/** The degree of the polynomial. */
+	unsigned int degree;
+	/** The inner coefficients, highest power first. */
+	unsigned int coeffs;
+	/** The first @p degree direction numbers. */
+	unsigned int m[5];
+};
+
+/** Direction numbers for dimensions 1 and up, from Joe & Kuo (2008), 
+ * "Constructing Sobol sequences with better two-dimensional 
+ * projections". Dimension 0 is the van der Corput sequence.
+ */
+const SobolPoly SOBOL_POLYS[] = {
+	{1, 0, {1, 0,  0,  0,  0}}, 
+	{2, 1, {1, 3,  0,  0,  0}}, 
+	{3, 1, {1, 3,  1,  0,  0}}, 
+	{3, 2, {1, 1,  1,  0,  0}}, 
+	{4, 1, {1, 1,  3,  3,  0}}, 
+	{4, 4, {1, 3,  5, 13,  0}}, 
+	{5, 2, {1, 1,  5,  5, 17}}, 
+	{5, 4, {1, 1,  5,  5,  5}}, 
+	{5, 7, {1, 1,  7, 11, 19}}
+};
+
+/** Returns the number of dimensions supported by sobolPoint()
+ *
+ * @return The number of coordinates each Sobol point has.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t sobolDimensions() {
+	return 1 + sizeof(SOBOL_POLYS)/sizeof(SOBOL_POLYS[0]);
+}
+
+/** Returns one coordinate of a point of an unscrambled Sobol sequence
+ *
+ * @param[in] index The position of the point in the sequence.
+ * @param[in] dim The coordinate to return.
+ *
+ * @return The coordinate, as a binary fraction of 2<sup>32</sup>.
+ *
+ * @pre @p dim &lt; sobolDimensions()
+ *
+ * @perform O(1) time. The direction numbers are recomputed on each 
+ *	call, so that points can be generated on any thread without 
+ *	shared state.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint32_t sobolInteger(unsigned long index, size_t dim) {
+	uint32_t direction[32];
+	if (dim == 0) {
+		for(unsigned int j = 0; j < 32; j++) {
+			direction[j] = static_cast<uint32_t>(1) << (31 - j);
+		}
+	} else {
+		const SobolPoly& poly = SOBOL_POLYS[dim - 1];
+		const unsigned int s = poly.degree;
+		for(unsigned int j = 0; j < 32; j++) {
+			if (j < s) {
+				direction[j] = static_cast<uint32_t>(poly.m[j]) << (31 - j);
+			} else {
+				direction[j] = direction[j-s] ^ (direction[j-s] >> s);
+				for(unsigned int k = 1; k < s; k++) {
+					if ((poly.coeffs >> (s - 1 - k)) & 1) {
+						direction[j] ^= direction[j-k];
+					}
+				}
+			}
+		}
+	}
+	
+	uint32_t point = 0;
+	for(unsigned int j = 0; j < 32 && index > 0; j++, index >>= 1) {
+		if (index & 1) {
+			point ^= direction[j];
+		}
+	}
+	return point;
+}
+
+/** Returns one coordinate of a point of a scrambled Sobol sequence
+ *
+ * The sequence is scrambled with a random digital shift, which keeps 
+ * the equidistribution of the Sobol sequence while making each 
+ * coordinate uniformly distributed, so that averages over the points 
+ * are unbiased.
+ *
+ * @param[in] seed The seed for the entire simulation run.
+ * @param[in] bin The index of the light curve or parameter bin being
+ *	simulated.
+ * @param[in] index The position of the point in the sequence, 
+ *	usually the trial index.
+ * @param[in] dim The coordinate to return.
+ *
+ * @return The coordinate, between 0 and 1 exclusive.
+ *
+ * @pre @p index &lt; 2<sup>32</sup>
+ *
+ * @post The return value depends only on @p seed, @p bin, @p index, 
+ *	and @p dim. The first 2<sup>m</sup> points of a bin fill 
+ *	[0, 1)<sup>d</sup> far more evenly than independent random points.
+ *
+ * @perform O(1) time
+ *
+ * @exception std::invalid_argument Thrown if @p dim &ge; sobolDimensions().
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+double sobolPoint(unsigned long seed, unsigned long bin, 
+		unsigned long index, size_t dim) {
+	if (dim >= sobolDimensions()) {
+		throw std::invalid_argument("Quasi-random sequences support at most " 
+			+ boost::lexical_cast<std::string>(sobolDimensions()) 
+			+ " dimensions.");
+	}
+	
+	// One shift per dimension, shared by every trial of the bin
+	PhiloxState state;
+	initStream(state, seed, bin, 0, QMC_STREAM);
+	state.counter[0] = static_cast<uint32_t>(dim);
+	philox4x32(state.counter, state.key, state.block);
+	
+	const uint32_t point = sobolInteger(index, dim) ^ state.block[0];
+	return (static_cast<double>(point) + 0.5) / 4294967296.0;
+}
+
+/** Does nothing.
+ *
+ * TrialStreams objects manage their own lifetime, so the thread-specific
+ * pointer to the current object must not delete it.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+static void noCleanup(TrialStreams*) {
+}
+
+/** Returns the TrialStreams object active on the calling thread
+ *
+ * @return A pointer that is NULL if no trial is active.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+static boost::thread_specific_ptr<TrialStreams>& currentStreams() {
+	static boost::thread_specific_ptr<TrialStreams> current(&noCleanup);
+
+	return current;
+}
+
+/** Makes a trial's streams the current streams for this thread
+ *
+ * @param[in] seed The seed for the entire simulation run.
+ * @param[in] bin The index of the light curve or parameter bin being
+ *	simulated.
+ * @param[in] trial The index of the trial within @p bin.
+ *
+ * @post trialStream() and trialModelRng() return streams keyed by
+ *	(@p seed, @p bin, @p trial) until the object is destroyed.
+ *
+ * @exception std::bad_alloc Thrown if there was not enough memory
+ *	to construct the generators.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+TrialStreams::TrialStreams(unsigned long seed, unsigned long bin, unsigned long trial)
+		: paramRng (allocStream(seed, bin, trial, PARAM_STREAM ), &gsl_rng_free),
+		  noiseRng (allocStream(seed, bin, trial, NOISE_STREAM ), &gsl_rng_free),
+		  injectRng(allocStream(seed, bin, trial, INJECT_STREAM), &gsl_rng_free),
+		  stochasticRng(new models::StochasticRng(seed, bin, trial, MODEL_STREAM)),
+		  seed(seed), bin(bin), trial(trial), 
+		  previous(currentStreams().get()) {
+	// IMPORTANT: no exceptions beyond this point
+
+	currentStreams().reset(this);
+}
+
+/** Restores the streams that were current before this object
+ *	was created
+ *
+ * @pre No TrialStreams object created on this thread after this one
+ *	still exists.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+TrialStreams::~TrialStreams() {
+	currentStreams().reset(previous);
+}
+
+/** Returns the generator for one stream of this trial
+ *
+ * @param[in] stream The stream to return.
+ *
+ * @return The generator for @p stream.
+ *
+ * @exception std::invalid_argument Thrown if @p stream is not a stream
+ *	represented by a gsl_rng.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+gsl_rng* TrialStreams::stream(StreamType stream) const {
+	switch(stream) {
+	case PARAM_STREAM:
+		return paramRng.get();
+	case NOISE_STREAM:
+		return noiseRng.get();
+	case INJECT_STREAM:
+		return injectRng.get();
+	default:
+		throw std::invalid_argument("Stream has no gsl_rng representation.");
+	}
+}
+
+/** Returns the generator used by stochastic light curves in this trial
+ *
+ * @return The stochastic light curve stream.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+models::StochasticRng& TrialStreams::modelRng() const {
+	return *stochasticRng;
+}
+
+/** Returns one coordinate of this trial's point in the bin's 
+ *	Sobol sequence
+ *
+ * @param[in] dim The coordinate to return.
+ *
+ * @return sobolPoint() for this trial's seed, bin, and index.
+ *
+ * @exception std::invalid_argument Thrown if @p dim &ge; sobolDimensions().
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+double TrialStreams::sobol(size_t dim) const {
+	return sobolPoint(seed, bin, trial, dim);
+}
+
+/** Returns the key of this trial's streams
+ *
+ * @param[out] seed, bin, trial The arguments with which the object 
+ *	was constructed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void TrialStreams::key(unsigned long& seed, unsigned long& bin, 
+		unsigned long& trial) const {
+	seed  = this->seed;
+	bin   = this->bin;
+	trial = this->trial;
+}
+
+/** Returns the generator for one stream of the trial running on this thread
+ *
+ * @param[in] stream The stream to return.
+ *
+ * @return The generator for @p stream, or NULL if no TrialStreams object
+ *	is active on this thread.
+ *
+ * @exception std::invalid_argument Thrown if @p stream is not a stream
+ *	represented by a gsl_rng.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+gsl_rng* trialStream(StreamType stream) {
+	const TrialStreams* current = currentStreams().get();
+
+	return (current != NULL ? current->stream(stream) : NULL);
+}
+
+/** Returns the generator used by stochastic light curves in the trial
+ *	running on this thread
+ *
+ * @return The stochastic light curve stream, or NULL if no TrialStreams
+ *	object is active on this thread.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+models::StochasticRng* trialModelRng() {
+	const TrialStreams* current = currentStreams().get();
+
+	return (current != NULL ? &(current->modelRng()) : NULL);
+}
+
+/** Returns one coordinate of the Sobol point of the trial running on 
+ *	this thread
+ *
+ * @param[in] dim The coordinate to return.
+ *
+ * @return TrialStreams::sobol() for the active trial.
+ *
+ * @exception std::logic_error Thrown if no TrialStreams object is 
+ *	active on this thread.
+ * @exception std::invalid_argument Thrown if @p dim &ge; sobolDimensions().
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+double trialSobol(size_t dim) {
+	const TrialStreams* current = currentStreams().get();
+	if (current == NULL) {
+		throw std::logic_error("Quasi-random parameters need a trial index.");
+	}
+
+	return current->sobol(dim);
+}
+
+/** Returns the key of the streams of the trial running on this thread, 
+ *	if there is one
+ *
+ * @param[out] seed, bin, trial The key of the active TrialStreams 
+ *	object.
+ *
+ * @return True if a TrialStreams object is active on this thread. If 
+ *	false, the arguments are unchanged.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool trialKey(unsigned long& seed, unsigned long& bin, unsigned long& trial) {
+	const TrialStreams* current = currentStreams().get();
+	if (current == NULL) {
+		return false;
+	}
+
+	current->key(seed, bin, trial);
+	return true;
+}
+
+}}		// end lcmc::utils
@@ -0,0 +1,193 @@
+/** Functions for generating reproducible random number streams
+ * @file lightcurveMC/rngstream.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCRNGSTREAMH
+#define LCMCRNGSTREAMH
+
+#include <cstddef>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <gsl/gsl_rng.h>
+
+namespace lcmc {
+
+namespace models {
+class StochasticRng;
+}
+
+namespace utils {
+
+/** Identifies the purpose of a random number stream within a trial.
+ */
+enum StreamType {
+	/** Stream used to draw light curve parameters */
+	PARAM_STREAM,
+	/** Stream used to generate measurement noise */
+	NOISE_STREAM,
+	/** Stream used to pick light curves for injection */
+	INJECT_STREAM,
+	/** Stream used by stochastic light curve models */
+	MODEL_STREAM, 
+	/** Stream used to simulate noise for periodogram false alarm 
+	 *	thresholds */
+	THRESHOLD_STREAM, 
+	/** Stream used to scramble quasi-random parameters, shared by 
+	 *	all trials of a bin */
+	QMC_STREAM
+};
+
+/** Internal state of a Philox4x32-10 generator.
+ *
+ * The generator returns the four words of philox4x32(counter, key) in
+ * turn, then increments the low half of the counter. The high half of
+ * the counter and the key identify the stream.
+ *
+ * The state is small enough to be copied by value, so a generator can 
+ * be saved and restored without allocating memory.
+ */
+struct PhiloxState {
+	/** The input to the next block of random numbers. */
+	boost::uint32_t counter[4];
+	/** Identifies the run and the bin. */
+	boost::uint32_t key[2];
+	/** The current block of random numbers. */
+	boost::uint32_t block[4];
+	/** The index of the next unused word in @p block. */
+	unsigned int next;
+};
+
+/** Applies the Philox4x32-10 bijection to a counter
+ */
+void philox4x32(const boost::uint32_t counter[4], const boost::uint32_t key[2],
+		boost::uint32_t result[4]);
+
+/** Returns the GSL description of the counter-based generator used
+ *	for trial streams
+ */
+const gsl_rng_type* philoxType();
+
+/** Sets a Philox generator to the start of one stream of one trial
+ */
+void initStream(PhiloxState& state, unsigned long seed, unsigned long bin,
+		unsigned long trial, StreamType stream);
+
+/** Fills an array with independent normal random variates
+ */
+void fillNormal(const gsl_rng* rng, double out[], size_t n, double sigma);
+
+/** Allocates a random number generator for one stream of one trial
+ */
+gsl_rng* allocStream(unsigned long seed, unsigned long bin,
+		unsigned long trial, StreamType stream);
+
+/** Returns the number of dimensions supported by sobolPoint()
+ */
+size_t sobolDimensions();
+
+/** Returns one coordinate of a point of a scrambled Sobol sequence
+ */
+double sobolPoint(unsigned long seed, unsigned long bin, 
+		unsigned long index, size_t dim);
+
+/** Assigns a private set of random number streams to one trial.
+ *
+ * While a TrialStreams object exists, trialStream() and trialModelRng()
+ * return generators whose state depends only on the run seed, the bin,
+ * the trial index, and the stream, so that any trial can be regenerated
+ * on its own, in any order and on any thread.
+ *
+ * Each TrialStreams object affects only the thread that created it.
+ */
+class TrialStreams {
+public:
+	/** Makes a trial's streams the current streams for this thread
+	 */
+	TrialStreams(unsigned long seed, unsigned long bin, unsigned long trial);
+
+	/** Restores the streams that were current before this object
+	 *	was created
+	 */
+	~TrialStreams();
+
+	/** Returns the generator for one stream of this trial
+	 */
+	gsl_rng* stream(StreamType stream) const;
+
+	/** Returns the generator used by stochastic light curves in this trial
+	 */
+	models::StochasticRng& modelRng() const;
+
+	/** Returns one coordinate of this trial's point in the bin's 
+	 *	Sobol sequence
+	 */
+	double sobol(size_t dim) const;
+
+	/** Returns the key of this trial's streams
+	 */
+	void key(unsigned long& seed, unsigned long& bin, unsigned long& trial) const;
+
+private:
+	// Copying would let two objects restore the same previous streams
+	TrialStreams(const TrialStreams&);
+	TrialStreams& operator=(const TrialStreams&);
+
+	boost::shared_ptr<gsl_rng> paramRng;
+	boost::shared_ptr<gsl_rng> noiseRng;
+	boost::shared_ptr<gsl_rng> injectRng;
+	boost::scoped_ptr<models::StochasticRng> stochasticRng;
+
+	/** The trial identified by the streams */
+	unsigned long seed, bin, trial;
+
+	TrialStreams* previous;
+};
+
+/** Returns the generator for one stream of the trial running on this thread
+ */
+gsl_rng* trialStream(StreamType stream);
+
+/** Returns the generator used by stochastic light curves in the trial
+ *	running on this thread
+ */
+models::StochasticRng* trialModelRng();
+
+/** Returns one coordinate of the Sobol point of the trial running on 
+ *	this thread
+ */
+double trialSobol(size_t dim);
+
+/** Returns the key of the streams of the trial running on this thread, 
+ *	if there is one
+ */
+bool trialKey(unsigned long& seed, unsigned long& bin, unsigned long& trial);
+
+}}		// end lcmc::utils
+
+#endif		// LCMCRNGSTREAMH
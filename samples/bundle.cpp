@@ -0,0 +1,397 @@
+/** Implementation of Bundle
+ * @file lightcurveMC/samples/bundle.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#include "bundle.h"
+#include "catalog.h"
+#include "observations.h"
+#include "../except/inject.h"
+#include "../../common/cerror.h"
+#include "../../common/fileio.h"
+
+namespace lcmc { namespace inject {
+
+using boost::lexical_cast;
+using boost::shared_ptr;
+using boost::uint64_t;
+
+/** The layout of the start of a bundle
+ *
+ * The header is followed by @p count BundleEntry objects, one per 
+ * light curve, and then by the light curves themselves.
+ */
+struct BundleHeader {
+	/** Identifies the file format */
+	char magic[8];
+	/** The number of light curves in the bundle */
+	uint64_t count;
+};
+
+/** The index entry for a single light curve
+ *
+ * The light curve is stored as @p length timestamps, followed 
+ * immediately by @p length fluxes.
+ */
+struct BundleEntry {
+	/** The position of the first timestamp, in bytes from the start 
+	 * of the file */
+	uint64_t offset;
+	/** The number of observations in the light curve */
+	uint64_t length;
+};
+
+/** The value of BundleHeader::magic for the current file format
+ */
+const char BUNDLE_MAGIC[8] = {'L', 'C', 'M', 'C', 'B', 'N', 'D', '1'};
+
+/** Deallocator for a memory-mapped bundle
+ */
+class UnmapBundle {
+public:
+	/** Prepares to unmap a file
+	 *
+	 * @param[in] length The length of the mapping, in bytes.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	explicit UnmapBundle(size_t length) : length(length) {
+	}
+	
+	/** Unmaps the file
+	 *
+	 * @param[in] start The address returned by mmap().
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void operator()(void* start) const {
+		munmap(start, length);
+	}
+
+private:
+	size_t length;
+};
+
+/** Maps a bundle file into memory
+ *
+ * @param[in] fileName The bundle to open.
+ *
+ * @post The object represents the light curves in @p fileName.
+ *
+ * @perform Constant time. Light curves are read from disk only when 
+ *	they are accessed.
+ *
+ * @exception lcmc::inject::except::BadFile Thrown if the file could not 
+ *	be opened or mapped.
+ * @exception lcmc::inject::except::BadFormat Thrown if the file is not 
+ *	a bundle, or is too short to hold its own index.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+Bundle::Bundle(const std::string& fileName) : fileName(fileName), mapping(), 
+		length(0), count(0) {
+	const int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw except::BadFile("Could not open bundle " + fileName, fileName);
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw except::BadFile("Could not read bundle " + fileName, fileName);
+	}
+	const size_t tempLength = static_cast<size_t>(info.st_size);
+	if (tempLength < sizeof(BundleHeader)) {
+		close(fd);
+		throw except::BadFormat("File " + fileName + " is not a light curve bundle.", fileName);
+	}
+	void* const start = mmap(NULL, tempLength, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping remains valid after the file is closed
+	close(fd);
+	if (start == MAP_FAILED) {
+		throw except::BadFile("Could not map bundle " + fileName, fileName);
+	}
+	// shared_ptr calls the deallocator if it throws
+	shared_ptr<void> tempMapping(start, UnmapBundle(tempLength));
+	
+	const BundleHeader* const header = static_cast<const BundleHeader*>(start);
+	if (!std::equal(BUNDLE_MAGIC, BUNDLE_MAGIC + sizeof(BUNDLE_MAGIC), header->magic)) {
+		throw except::BadFormat("File " + fileName + " is not a light curve bundle.", fileName);
+	}
+	// Divide rather than multiply, to avoid overflow
+	if (header->count > (tempLength - sizeof(BundleHeader)) / sizeof(BundleEntry)) {
+		throw except::BadFormat("Bundle " + fileName + " is truncated.", fileName);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	this->mapping.swap(tempMapping);
+	this->length = tempLength;
+	this->count  = static_cast<size_t>(header->count);
+}
+
+/** Returns the number of light curves in the bundle
+ *
+ * @return The number of light curves that may be accessed.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t Bundle::size() const {
+	return count;
+}
+
+/** Returns the offset of a light curve in the file
+ *
+ * @param[in] index The light curve to find.
+ *
+ * @return The position of the light curve's first timestamp, in bytes 
+ *	from the start of the file.
+ *
+ * @perform Constant time
+ *
+ * @exception std::out_of_range Thrown if @p index &ge; size()
+ * @exception lcmc::inject::except::BadFormat Thrown if the light curve 
+ *	does not lie within the file.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+size_t Bundle::offset(size_t index) const {
+	if (index >= count) {
+		throw std::out_of_range("Bundle " + fileName + " contains only " 
+			+ lexical_cast<std::string>(count) + " light curves.");
+	}
+	const BundleEntry& entry = static_cast<const BundleEntry*>(static_cast<const void*>(
+		static_cast<const char*>(mapping.get()) + sizeof(BundleHeader)))[index];
+	
+	// Divide rather than multiply, to avoid overflow
+	if (entry.offset % sizeof(double) != 0 || entry.offset > length 
+			|| entry.length > (length - entry.offset) / (2*sizeof(double))) {
+		throw except::BadFormat("Light curve " + lexical_cast<std::string>(index) 
+			+ " in bundle " + fileName + " is corrupted.", fileName);
+	}
+	return static_cast<size_t>(entry.offset);
+}
+
+/** Returns the number of observations in a light curve
+ *
+ * @param[in] index The light curve to examine.
+ *
+ * @return The number of elements in times(@p index) and 
+ *	fluxes(@p index).
+ *
+ * @perform Constant time
+ *
+ * @exception std::out_of_range Thrown if @p index &ge; size()
+ * @exception lcmc::inject::except::BadFormat Thrown if the light curve 
+ *	does not lie within the file.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+size_t Bundle::sourceSize(size_t index) const {
+	offset(index);
+	
+	const BundleEntry& entry = static_cast<const BundleEntry*>(static_cast<const void*>(
+		static_cast<const char*>(mapping.get()) + sizeof(BundleHeader)))[index];
+	return static_cast<size_t>(entry.length);
+}
+
+/** Returns the timestamps of a light curve
+ *
+ * @param[in] index The light curve to examine.
+ *
+ * @return A pointer to the first of sourceSize(@p index) timestamps, 
+ *	valid for the lifetime of the object.
+ *
+ * @post The timestamps do not contain NaNs
+ *
+ * @perform Constant time
+ *
+ * @exception std::out_of_range Thrown if @p index &ge; size()
+ * @exception lcmc::inject::except::BadFormat Thrown if the light curve 
+ *	does not lie within the file.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const double* Bundle::times(size_t index) const {
+	return static_cast<const double*>(static_cast<const void*>(
+		static_cast<const char*>(mapping.get()) + offset(index)));
+}
+
+/** Returns the normalized fluxes of a light curve
+ *
+ * @param[in] index The light curve to examine.
+ *
+ * @return A pointer to the first of sourceSize(@p index) fluxes, 
+ *	valid for the lifetime of the object. The fluxes have a median of 1.
+ *
+ * @post The fluxes do not contain NaNs
+ *
+ * @perform Constant time
+ *
+ * @exception std::out_of_range Thrown if @p index &ge; size()
+ * @exception lcmc::inject::except::BadFormat Thrown if the light curve 
+ *	does not lie within the file.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const double* Bundle::fluxes(size_t index) const {
+	return times(index) + sourceSize(index);
+}
+
+/** Tests whether a file is a bundle
+ *
+ * @param[in] fileName The file to examine.
+ *
+ * @return True if @p fileName exists and starts with the bundle 
+ *	format identifier, false otherwise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool isBundle(const std::string& fileName) {
+	FILE* const rawFile = fopen(fileName.c_str(), "rb");
+	if (rawFile == NULL) {
+		return false;
+	}
+	char magic[sizeof(BUNDLE_MAGIC)];
+	const bool match = fread(magic, sizeof(magic), 1, rawFile) == 1 
+		&& std::equal(BUNDLE_MAGIC, BUNDLE_MAGIC + sizeof(BUNDLE_MAGIC), magic);
+	fclose(rawFile);
+	return match;
+}
+
+/** Writes raw data to a bundle
+ *
+ * @param[in] hFile The file to write to.
+ * @param[in] data The start of the data to write.
+ * @param[in] size The size of each element.
+ * @param[in] n The number of elements to write.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the data could not 
+ *	be written.
+ *
+ * @exceptsafe The program is in a consistent state in the event of 
+ *	an exception.
+ */
+void writeRaw(FILE* const hFile, const void* data, size_t size, size_t n) {
+	if (n > 0 && fwrite(data, size, n, hFile) != n) {
+		kpfutils::fileError(hFile, "Could not write bundle: ");
+	}
+}
+
+/** Packs the light curves in a catalog into a bundle
+ *
+ * The bundle is first written to a temporary file, then moved into 
+ * place, so that other processes never read a partial bundle.
+ *
+ * @param[in] catalogName A text file where each line is a path 
+ *	to a text file containing the light curve of a source in 
+ *	the sample, or an existing bundle.
+ * @param[in] bundleName The file to which the bundle is written.
+ *
+ * @post @p bundleName is a bundle containing the light curves in 
+ *	@p catalogName, in the same order and with the same normalization 
+ *	used by Catalog.
+ *
+ * @exception lcmc::inject::except::NoCatalog Thrown if the catalog file 
+ *	does not exist.
+ * @exception kpfutils::except::FileIo Thrown if the catalog or a light 
+ *	curve could not be read, or if the bundle could not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the catalog.
+ *
+ * @exceptsafe @p bundleName is unchanged in the event of an exception.
+ */
+void writeBundle(const std::string& catalogName, const std::string& bundleName) {
+	const Catalog catalog(catalogName);
+	
+	BundleHeader header;
+	std::copy(BUNDLE_MAGIC, BUNDLE_MAGIC + sizeof(BUNDLE_MAGIC), header.magic);
+	header.count = catalog.size();
+	
+	std::vector<BundleEntry> index(catalog.size());
+	
+	const std::string tempName = bundleName + ".tmp";
+	try {
+		{
+			shared_ptr<FILE> hBundle = kpfutils::fileCheckOpen(tempName, "wb");
+			
+			// Reserve space for the index, which is filled in at the end
+			writeRaw(hBundle.get(), &header, sizeof(header), 1);
+			writeRaw(hBundle.get(), &index[0], sizeof(BundleEntry), index.size());
+			
+			uint64_t position = sizeof(BundleHeader) + index.size()*sizeof(BundleEntry);
+			for(size_t i = 0; i < catalog.size(); i++) {
+				const shared_ptr<const Observations> source = catalog.getSource(i);
+				const std::vector<double>& times  = source->timeView();
+				const std::vector<double>& fluxes = source->fluxView();
+				
+				index[i].offset = position;
+				index[i].length = times.size();
+				if (!times.empty()) {
+					writeRaw(hBundle.get(), &times [0], sizeof(double), times .size());
+					writeRaw(hBundle.get(), &fluxes[0], sizeof(double), fluxes.size());
+				}
+				position += 2*times.size()*sizeof(double);
+			}
+			
+			if (fseek(hBundle.get(), sizeof(BundleHeader), SEEK_SET) != 0) {
+				kpfutils::fileError(hBundle.get(), "Could not write bundle: ");
+			}
+			writeRaw(hBundle.get(), &index[0], sizeof(BundleEntry), index.size());
+			
+			// hBundle closes the file, but any write errors must be caught first
+			if (fflush(hBundle.get()) != 0) {
+				kpfutils::fileError(hBundle.get(), "Could not write bundle: ");
+			}
+		}
+	} catch (...) {
+		remove(tempName.c_str());
+		throw;
+	}
+	
+	if (rename(tempName.c_str(), bundleName.c_str()) != 0) {
+		remove(tempName.c_str());
+		throw kpfutils::except::FileIo("Could not write bundle " + bundleName);
+	}
+}
+
+}}		// end lcmc::inject
@@ -0,0 +1,97 @@
+/** Type definitions for packed catalogs of observed light curves
+ * @file lightcurveMC/samples/bundle.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCBUNDLEH
+#define LCMCBUNDLEH
+
+#include <string>
+#include <boost/smart_ptr.hpp>
+
+namespace lcmc { namespace inject {
+
+/** Bundle represents a light curve catalog packed into a single binary 
+ * file.
+ *
+ * The file holds an index of the light curves, followed by the times 
+ * and normalized fluxes of each one. The file is memory-mapped rather 
+ * than read, so opening a bundle takes constant time regardless of the 
+ * number of light curves, and each light curve is paged in only when 
+ * it is used.
+ *
+ * Bundles are written by writeBundle(). They use the native byte order, 
+ * and cannot be shared between machines of different architectures.
+ *
+ * @invariant Bundle is immutable.
+ */
+class Bundle {
+public:
+	/** Maps a bundle file into memory
+	 */
+	explicit Bundle(const std::string& fileName);
+	
+	/** Returns the number of light curves in the bundle
+	 */
+	size_t size() const;
+	
+	/** Returns the number of observations in a light curve
+	 */
+	size_t sourceSize(size_t index) const;
+	
+	/** Returns the timestamps of a light curve
+	 */
+	const double* times(size_t index) const;
+	
+	/** Returns the normalized fluxes of a light curve
+	 */
+	const double* fluxes(size_t index) const;
+
+private:
+	/** Returns the offset of a light curve in the file
+	 */
+	size_t offset(size_t index) const;
+	
+	std::string fileName;
+	
+	// Unmaps the file when the last copy is destroyed
+	boost::shared_ptr<void> mapping;
+	size_t length;
+	size_t count;
+};
+
+/** Tests whether a file is a bundle
+ */
+bool isBundle(const std::string& fileName);
+
+/** Packs the light curves in a catalog into a bundle
+ */
+void writeBundle(const std::string& catalogName, const std::string& bundleName);
+
+}}		// end lcmc::inject
+
+#endif		// end ifndef LCMCBUNDLEH
@@ -0,0 +1,620 @@
+/** Implementation of Catalog
+ * @file lightcurveMC/samples/catalog.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/smart_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <gsl/gsl_rng.h>
+#include "bundle.h"
+#include "catalog.h"
+#include "observations.h"
+#include "../../common/fileio.h"
+#include "../cachestats.h"
+#include "../gsl_compat.h"
+#include "../except/inject.h"
+#include "../rngstream.h"
+#include "../../common/cerror.h"
+#include "../../common/alloc.tmp.h"
+
+namespace lcmc { namespace inject {
+
+/** Function object that reads prefetched light curves on a 
+ *	background thread.
+ */
+class CatalogLoader {
+public:
+	/** Prepares to read light curves
+	 *
+	 * @param[in] catalog The catalog whose queue is to be read. The 
+	 *	catalog must not be destroyed until the thread finishes.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	explicit CatalogLoader(const Catalog& catalog) : catalog(catalog) {
+	}
+	
+	/** Reads light curves until the catalog's queue is empty
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void operator()() const {
+		catalog.loadQueued();
+	}
+
+private:
+	const Catalog& catalog;
+};
+
+/** Returns the generator used to pick light curves when no trial 
+ *	streams are active
+ *
+ * @return A generator shared by all catalogs.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+gsl_rng* defaultPicker() {
+	// Note: because sourcePicker is static, no memory management is needed
+	static gsl_rng * sourcePicker = NULL;
+	if (sourcePicker == NULL) {
+		sourcePicker = gsl_rng_alloc(gsl_rng_mt19937);
+		gsl_rng_set(sourcePicker, 5489);
+	}
+	return sourcePicker;
+}
+
+/** Reads the list of light curves in a catalog
+ *
+ * @param[in] catalogName Either a text file where each line is a path 
+ *	to a text file containing the light curve of a source in 
+ *	the sample, or a bundle created by writeBundle().
+ *
+ * @post The object represents the light curves listed in 
+ *	@p catalogName. No light curves have been read yet.
+ *
+ * @perform O(N) time for a text catalog of N light curves, constant 
+ *	time for a bundle.
+ * 
+ * @exception lcmc::inject::except::NoCatalog Thrown if the catalog file does not exist.
+ * @exception kpfutils::except::FileIo Thrown if the catalog could not be 
+ *	read or does not contain any light curves.
+ * @exception std::bad_alloc Thrown if there is not enough memory to create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+Catalog::Catalog(const std::string& catalogName) 
+		: bundle(openBundle(catalogName)), 
+		library(bundle.get() == NULL ? getLcLibrary(catalogName) 
+			: std::vector<std::string>()), 
+		sources(bundle.get() == NULL ? library.size() : bundle->size()), 
+		prefetchLock(), prefetchDone(), queue(), pending(), prefetched(), 
+		loading(false), loader() {
+	if (sources.size() == 0) {
+		throw kpfutils::except::FileIo("Catalog " + catalogName + " does not contain any light curves.");
+	}
+}
+
+/** Waits for any light curves being prefetched
+ *
+ * @post The background thread, if any, has finished.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+Catalog::~Catalog() {
+	try {
+		{
+			boost::lock_guard<boost::mutex> guard(prefetchLock);
+			// Don't read light curves that will never be used
+			queue.clear();
+		}
+		if (loader) {
+			loader->join();
+		}
+	} catch (...) {
+		// The thread can't outlive the process, so leaving it 
+		//	running is harmless
+	}
+}
+
+/** Returns the number of light curves in the catalog
+ *
+ * @return The number of sources that may be returned by getSource() 
+ *	or pick().
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t Catalog::size() const {
+	return sources.size();
+}
+
+/** Returns a particular light curve in the catalog
+ *
+ * @param[in] index The position of the light curve in the catalog file, 
+ *	not counting blank lines.
+ *
+ * @return A pointer to the light curve, normalized to a median flux of 1. 
+ *	The light curve is read from disk only the first time it is requested.
+ *
+ * @perform Constant time after the first call with @p index. The first 
+ *	call takes O(N) time, where N is the length of the light curve.
+ *
+ * @pre @p index &lt; size()
+ *
+ * @exception std::out_of_range Thrown if @p index &ge; size()
+ * @exception kpfutils::except::FileIo Thrown if the light curve could not 
+ *	be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to store 
+ *	the light curve.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+boost::shared_ptr<const Observations> Catalog::getSource(size_t index) const {
+	if (sources.at(index).get() == NULL) {
+		boost::shared_ptr<const Observations> temp = claim(index);
+		if (temp.get() == NULL) {
+			temp = load(index);
+		}
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		sources[index] = temp;
+	}
+	return sources[index];
+}
+
+/** Returns a particular light curve in the catalog without keeping it 
+ *	in memory
+ *
+ * @param[in] index The position of the light curve in the catalog file, 
+ *	not counting blank lines.
+ *
+ * @return A pointer to the light curve, normalized to a median flux of 1. 
+ *	The light curve is taken from memory if it was already read by 
+ *	getSource() or prefetch(), and read from disk otherwise.
+ *
+ * @post The catalog does not keep the light curve unless it was 
+ *	already kept by getSource().
+ *
+ * @perform O(N) time, where N is the length of the light curve, unless 
+ *	the light curve is already in memory.
+ *
+ * @pre @p index &lt; size()
+ *
+ * @exception std::out_of_range Thrown if @p index &ge; size()
+ * @exception kpfutils::except::FileIo Thrown if the light curve could not 
+ *	be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to store 
+ *	the light curve.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+boost::shared_ptr<const Observations> Catalog::readSource(size_t index) const {
+	if (sources.at(index).get() != NULL) {
+		return sources[index];
+	}
+	
+	boost::shared_ptr<const Observations> temp = claim(index);
+	if (temp.get() == NULL) {
+		temp = load(index);
+	}
+	return temp;
+}
+
+/** Returns the file from which a light curve is read
+ *
+ * @param[in] index The position of the light curve in the catalog file, 
+ *	not counting blank lines.
+ *
+ * @return The name of the light curve file, as given in the catalog, 
+ *	or an empty string if the catalog is a Bundle.
+ *
+ * @pre @p index &lt; size()
+ *
+ * @exception std::out_of_range Thrown if @p index &ge; size()
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	copy the name.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+std::string Catalog::sourceName(size_t index) const {
+	if (index >= size()) {
+		throw std::out_of_range("No light curve at the requested position in the catalog.");
+	}
+	return (bundle.get() == NULL ? library[index] : std::string());
+}
+
+/** Reads a light curve from disk
+ *
+ * @param[in] index The position of the light curve in the catalog.
+ *
+ * @return A pointer to the light curve, normalized to a median flux of 1.
+ *
+ * @pre @p index &lt; size()
+ *
+ * @exception kpfutils::except::FileIo Thrown if the light curve could not 
+ *	be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to store 
+ *	the light curve.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ *
+ * @note May be called from any thread, since it uses only the members 
+ *	set by the constructor.
+ */
+boost::shared_ptr<const Observations> Catalog::load(size_t index) const {
+	boost::shared_ptr<Observations> temp(new Observations());
+	if (bundle.get() != NULL) {
+		// Bundled light curves are already clean and normalized
+		const size_t n = bundle->sourceSize(index);
+		std::vector<double> times (bundle->times (index), bundle->times (index) + n);
+		std::vector<double> fluxes(bundle->fluxes(index), bundle->fluxes(index) + n);
+		temp->setLightCurve(times, fluxes);
+	} else {
+		temp->readFile(library[index]);
+	}
+	return temp;
+}
+
+/** Takes a light curve from the prefetched light curves
+ *
+ * If the light curve is still waiting to be read by the background 
+ * thread, waits until it has been read.
+ *
+ * @param[in] index The position of the light curve in the catalog.
+ *
+ * @return A pointer to the light curve, or a null pointer if the light 
+ *	curve was not prefetched or could not be read in the background.
+ *
+ * @post The light curve is no longer stored as prefetched.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+boost::shared_ptr<const Observations> Catalog::claim(size_t index) const {
+	boost::unique_lock<boost::mutex> guard(prefetchLock);
+	while (pending.count(index) > 0) {
+		prefetchDone.wait(guard);
+	}
+	
+	boost::shared_ptr<const Observations> source;
+	std::map<size_t, boost::shared_ptr<const Observations> >::iterator it 
+		= prefetched.find(index);
+	if (it != prefetched.end()) {
+		source = it->second;
+		prefetched.erase(it);
+	}
+	return source;
+}
+
+/** Reads the light curves passed to prefetch()
+ *
+ * @post The queue is empty, and each light curve in it is stored as 
+ *	prefetched unless it could not be read.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void Catalog::loadQueued() const {
+	boost::unique_lock<boost::mutex> guard(prefetchLock);
+	while (!queue.empty()) {
+		const size_t index = queue.front();
+		queue.pop_front();
+		
+		// Don't block the main thread while reading
+		guard.unlock();
+		boost::shared_ptr<const Observations> source;
+		try {
+			source = load(index);
+		} catch (...) {
+			// getSource() will try again, and report any error
+		}
+		guard.lock();
+		
+		if (source.get() != NULL) {
+			try {
+				prefetched[index] = source;
+			} catch (const std::bad_alloc& e) {
+				// getSource() will try again
+			}
+		}
+		pending.erase(index);
+		prefetchDone.notify_all();
+	}
+	loading = false;
+	// Remove any light curves cleared by the destructor
+	pending.clear();
+	prefetchDone.notify_all();
+}
+
+/** Starts reading light curves in the background
+ *
+ * The light curves are read in order on a single background thread, 
+ * while the calling thread does other work. Light curves that are 
+ * already in memory or already waiting to be read are ignored.
+ *
+ * @param[in] indices The positions in the catalog of the light curves 
+ *	that will be needed soon. Any index &ge; size() is ignored.
+ *
+ * @post The light curves in @p indices are read by the background 
+ *	thread, unless they are requested with getSource() first.
+ *
+ * @perform Returns in O(N log N) time, where N = @p indices.size(). 
+ *	Does not wait for the light curves to be read.
+ *
+ * @exceptsafe Does not throw exceptions. Failure to prefetch a light 
+ *	curve is not an error, since it will be read when it is needed.
+ */
+void Catalog::prefetch(const std::vector<size_t>& indices) const {
+	try {
+		boost::lock_guard<boost::mutex> guard(prefetchLock);
+		
+		const size_t oldSize = queue.size();
+		std::vector<size_t> added;
+		try {
+			for(std::vector<size_t>::const_iterator it = indices.begin(); 
+					it != indices.end(); it++) {
+				if (*it < sources.size() && sources[*it].get() == NULL 
+						&& pending.count(*it) == 0 
+						&& prefetched.count(*it) == 0) {
+					added.push_back(*it);
+					pending.insert(*it);
+					queue.push_back(*it);
+				}
+			}
+			
+			if (!loading && !queue.empty()) {
+				// Any previous thread has emptied the queue and 
+				//	is about to return
+				if (loader) {
+					loader->join();
+				}
+				loader.reset(new boost::thread(CatalogLoader(*this)));
+				loading = true;
+			}
+		} catch (...) {
+			// Nothing waits for light curves that won't be read
+			queue.resize(oldSize);
+			for(std::vector<size_t>::const_iterator it = added.begin(); 
+					it != added.end(); it++) {
+				pending.erase(*it);
+			}
+		}
+	} catch (...) {
+		// Prefetching is optional
+	}
+}
+
+/** Returns a randomly selected light curve from the catalog
+ *
+ * If a utils::TrialStreams object is active on the calling thread, the 
+ *	light curve is picked using that trial's injection stream.
+ *
+ * @return A pointer to the light curve, normalized to a median flux of 1.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the light curve could not 
+ *	be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to store 
+ *	the light curve.
+ *
+ * @exceptsafe The object and the random number generator are unchanged 
+ *	in the event of an exception.
+ */
+boost::shared_ptr<const Observations> Catalog::pick() const {
+	gsl_rng * picker = utils::trialStream(utils::INJECT_STREAM);
+	if (picker == NULL) {
+		picker = defaultPicker();
+	}
+
+	// copy-and-swap the generator state, to ensure it only changes 
+	//	if a light curve is successfully returned
+	boost::shared_ptr<gsl_rng> tempRng(
+		kpfutils::checkAlloc(gsl_rng_clone(picker)), &gsl_rng_free);
+	
+	boost::shared_ptr<const Observations> source = getSource(choose(tempRng.get()));
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	gsl_rng_memcpy(picker, tempRng.get());
+	return source;
+}
+
+/** Returns the light curve that pick() would select using a 
+ *	particular generator
+ *
+ * @param[in] rng The generator to use. Its state is advanced exactly as 
+ *	pick() would advance it.
+ *
+ * @return The position in the catalog of the selected light curve.
+ *
+ * @post The return value is less than size().
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t Catalog::choose(const gsl_rng* rng) const {
+	// gsl_rng_uniform_int() generates over [0, n), not [0, n]
+	return gsl_rng_uniform_int(rng, sources.size());
+}
+
+/** Returns the light curves that the next calls to pick() would 
+ *	select if no trial streams are active
+ *
+ * @param[in] n The number of calls to predict.
+ *
+ * @return The positions in the catalog of the next @p n light curves 
+ *	that pick() would return, assuming no other catalog is picked 
+ *	from in the meantime.
+ *
+ * @perform O(@p n) time
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the positions.
+ *
+ * @exceptsafe The object and the random number generator are 
+ *	unchanged in the event of an exception.
+ */
+std::vector<size_t> Catalog::upcoming(size_t n) const {
+	// Work on a copy, so that the generator is unchanged
+	boost::shared_ptr<gsl_rng> tempRng(
+		kpfutils::checkAlloc(gsl_rng_clone(defaultPicker())), &gsl_rng_free);
+	
+	std::vector<size_t> indices;
+	indices.reserve(n);
+	for(size_t i = 0; i < n; i++) {
+		indices.push_back(choose(tempRng.get()));
+	}
+	return indices;
+}
+
+/** Returns the bundle stored in a catalog file, if any
+ *
+ * @param[in] catalogName The catalog file to examine.
+ *
+ * @return A pointer to the bundle if @p catalogName is a bundle, 
+ *	otherwise a null pointer.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p catalogName is a 
+ *	bundle but could not be mapped.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	open the bundle.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+boost::shared_ptr<const Bundle> Catalog::openBundle(const std::string& catalogName) {
+	if (isBundle(catalogName)) {
+		return boost::shared_ptr<const Bundle>(new Bundle(catalogName));
+	} else {
+		return boost::shared_ptr<const Bundle>();
+	}
+}
+
+/** Returns the list of files from which the catalog may select sources
+ *
+ * @param[in] catalogName A text file where each line is a path 
+ *	to a text file containing the light curve of a source in 
+ *	the sample.
+ *
+ * @return A vector whose every entry is a path to a text file containing 
+ *	the light curve of a source in the sample. The vector may be empty 
+ *	if catalogName does not contain any valid lines.
+ * 
+ * @exception lcmc::inject::except::NoCatalog Thrown if the catalog file 
+ *	does not exist.
+ * @exception kpfutils::except::FileIo Thrown if the catalog could not 
+ *	be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to store 
+ *	the catalog.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ *
+ * @bug Returns file paths relative to working directory, not relative to catalog.
+ */
+const std::vector<std::string> Catalog::getLcLibrary(const std::string& catalogName) {
+
+	std::vector<std::string> fileList;
+	
+	boost::shared_ptr<FILE> hCatalog;
+	try {
+		hCatalog = kpfutils::fileCheckOpen(catalogName, "r");
+	} catch (const kpfutils::except::FileIo& e) {
+		throw except::NoCatalog(e.what(), catalogName);
+	}
+
+	// Read the catalog line by line
+	/** @todo Add some format checking later!
+	 */
+	while(!feof(hCatalog.get())) {
+		char textBuffer[128];
+		fgets(textBuffer, 128, hCatalog.get());
+		if (ferror(hCatalog.get())) {
+			kpfutils::fileError(hCatalog.get(), "Error while reading " + catalogName + ": ");
+		}
+		// Remove trailing whitespace!
+		std::string strBuffer(textBuffer);
+		while(strBuffer.size() > 0 && *(strBuffer.rbegin()) == '\n') {
+			// erase() only works with forward iterators
+			// Size check guarantees that there is an iterator before end()
+			strBuffer.erase(--strBuffer.end());
+		}
+		if (strBuffer.size() > 0) {
+			fileList.push_back(strBuffer);
+		}
+	}
+	
+	return fileList;
+}
+
+/** Returns the catalog stored in a particular file, reading it only 
+ *	the first time it is requested
+ *
+ * @param[in] catalogName Either a text file where each line is a path 
+ *	to a text file containing the light curve of a source in 
+ *	the sample, or a bundle created by writeBundle().
+ *
+ * @return A catalog of the light curves listed in @p catalogName, 
+ *	valid for the rest of the program run.
+ *
+ * @exception lcmc::inject::except::NoCatalog Thrown if the catalog file does not exist.
+ * @exception kpfutils::except::FileIo Thrown if the catalog could not be 
+ *	read or does not contain any light curves.
+ * @exception std::bad_alloc Thrown if there is not enough memory to store 
+ *	the catalog.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe. Injection light curves are only drawn from the 
+ *	main thread.
+ */
+const Catalog& getCatalog(const std::string& catalogName) {
+	typedef std::map<std::string, boost::shared_ptr<const Catalog> > CatalogCache;
+	static CatalogCache catalogs;
+	static utils::CacheCounter counter("Injection catalogs");
+	
+	CatalogCache::const_iterator it = catalogs.find(catalogName);
+	if (it == catalogs.end()) {
+		const utils::CacheMiss miss(counter);
+		boost::shared_ptr<const Catalog> temp(new Catalog(catalogName));
+		it = catalogs.insert(CatalogCache::value_type(catalogName, temp)).first;
+	} else {
+		counter.hit();
+	}
+	return *(it->second);
+}
+
+}}		// end lcmc::inject
@@ -0,0 +1,172 @@
+/** Type definitions for catalogs of observed light curves
+ * @file lightcurveMC/samples/catalog.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCCATALOGH
+#define LCMCCATALOGH
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <gsl/gsl_rng.h>
+#include "bundle.h"
+#include "observations.h"
+
+namespace lcmc { namespace inject {
+
+/** Catalog represents a sample of observed light curves that can be 
+ * injected with simulated data.
+ *
+ * The list of light curves is read when the catalog is created. Each 
+ * light curve is read from disk and normalized the first time it is 
+ * chosen, and is served from memory afterward. If the catalog is a 
+ * Bundle, light curves are copied from it without any parsing. Programs 
+ * that visit every light curve once may use readSource() instead, so 
+ * that only the light curves in use are held in memory.
+ *
+ * Light curves that will be needed soon may be passed to prefetch(), 
+ * which reads them on a background thread so that file access overlaps 
+ * other work. Except for the loading done by prefetch(), a Catalog may 
+ * only be used by one thread.
+ *
+ * @invariant The catalog contains at least one light curve.
+ */
+class Catalog {
+public:
+	/** Reads the list of light curves in a catalog
+	 */
+	explicit Catalog(const std::string& catalogName);
+	
+	/** Waits for any light curves being prefetched
+	 */
+	~Catalog();
+	
+	/** Returns the number of light curves in the catalog
+	 */
+	size_t size() const;
+	
+	/** Returns a particular light curve in the catalog
+	 */
+	boost::shared_ptr<const Observations> getSource(size_t index) const;
+	
+	/** Returns a particular light curve in the catalog without 
+	 *	keeping it in memory
+	 */
+	boost::shared_ptr<const Observations> readSource(size_t index) const;
+	
+	/** Returns the file from which a light curve is read
+	 */
+	std::string sourceName(size_t index) const;
+	
+	/** Returns a randomly selected light curve from the catalog
+	 */
+	boost::shared_ptr<const Observations> pick() const;
+	
+	/** Returns the light curve that pick() would select using a 
+	 *	particular generator
+	 */
+	size_t choose(const gsl_rng* rng) const;
+	
+	/** Returns the light curves that the next calls to pick() would 
+	 *	select if no trial streams are active
+	 */
+	std::vector<size_t> upcoming(size_t n) const;
+	
+	/** Starts reading light curves in the background
+	 */
+	void prefetch(const std::vector<size_t>& indices) const;
+
+private:
+	// Catalogs are shared, not copied
+	Catalog(const Catalog&);
+	Catalog& operator=(const Catalog&);
+	
+	// Runs loadQueued() on the background thread
+	friend class CatalogLoader;
+	
+	/** Reads a light curve from disk
+	 */
+	boost::shared_ptr<const Observations> load(size_t index) const;
+	
+	/** Reads the light curves passed to prefetch()
+	 */
+	void loadQueued() const;
+	
+	/** Takes a light curve from the prefetched light curves
+	 */
+	boost::shared_ptr<const Observations> claim(size_t index) const;
+	
+	/** Returns the list of files from which the catalog may select sources
+	 */
+	static const std::vector<std::string> getLcLibrary(const std::string& catalogName);
+	
+	/** Returns the bundle stored in a catalog file, if any
+	 */
+	static boost::shared_ptr<const Bundle> openBundle(const std::string& catalogName);
+	
+	// invariant: exactly one of bundle and library describes the catalog
+	boost::shared_ptr<const Bundle> bundle;
+	std::vector<std::string> library;
+	
+	// Mutable allows light curves to be loaded on first use
+	// invariant: sources.size() = size()
+	// invariant: sources[i] is null if light curve i has not been read yet
+	mutable std::vector<boost::shared_ptr<const Observations> > sources;
+	
+	/** Protects the members used by the background thread */
+	mutable boost::mutex prefetchLock;
+	// Signaled each time the background thread finishes a light curve
+	mutable boost::condition_variable prefetchDone;
+	// Light curves waiting to be read by the background thread, in order
+	mutable std::deque<size_t> queue;
+	// invariant: pending contains the elements of queue, plus the 
+	//	light curve being read, if any
+	mutable std::set<size_t> pending;
+	// Light curves read by the background thread but not yet 
+	//	moved to sources
+	mutable std::map<size_t, boost::shared_ptr<const Observations> > prefetched;
+	// invariant: loader is non-null if the background thread may 
+	//	still be running
+	mutable bool loading;
+	mutable boost::scoped_ptr<boost::thread> loader;
+};
+
+/** Returns the catalog stored in a particular file, reading it only 
+ *	the first time it is requested
+ */
+const Catalog& getCatalog(const std::string& catalogName);
+
+}}		// end lcmc::inject
+
+#endif		// end ifndef LCMCCATALOGH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/samples/datafactory.cpp
  * @author Krzysztof Findeisen
  * @date Created May 7, 2012
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,20 +27,50 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <memory>
 #include <string>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <gsl/gsl_rng.h>
+#include "catalog.h"
 #include "observations.h"
+#include "../rngstream.h"
 
-// Declare constructors for every observations subtype supported by dataSampler()
-//#include "obssamples.h"
-
-using std::auto_ptr;
+using boost::shared_ptr;
 using std::string;
 
 namespace lcmc { namespace inject {
 
-/** dataSampler is a factory method that allocates and initializes an 
- *	Observations object of a particular type.
+/** Returns the catalog file corresponding to a sample name
+ *
+ * @param[in] whichSample The name of the light curve catalog to read.
+ *
+ * @return @p whichSample, or the file corresponding to one of the 
+ *	special keywords accepted by dataSampler().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the file name.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+string catalogFile(const string& whichSample) {
+	if (       whichSample == "NonSpitzerNonVar") {
+		return "nonspitzernonvar.cat";
+	} else if (whichSample == "NonSpitzerVar") {
+		return    "nonspitzervar.cat";
+	} else if (whichSample ==    "SpitzerNonVar") {
+		return    "spitzernonvar.cat";
+	} else if (whichSample ==    "SpitzerVar") {
+		return       "spitzervar.cat";
+	} else {
+		return whichSample;
+	}
+}
+
+/** dataSampler is a factory method that returns a randomly selected 
+ *	light curve from a particular sample.
+ *
+ * Each catalog is read the first time it is requested, and each light 
+ * curve the first time it is selected. Later calls are served from memory.
  *
  * @param[in] whichSample The name of the light curve catalog to read.
  *
@@ -51,8 +81,8 @@ namespace lcmc { namespace inject {
  *	offered for backward-compatibility with shell scripts that used 
  *	previous versions of Lightcurve MC.
  *
- * @return A smart pointer to an Observations object generated from the 
- *	given catalog.
+ * @return A smart pointer to a light curve from the given catalog. The 
+ *	light curve is shared with other callers, and must not be modified.
  * 
  * @exception lcmc::inject::except::NoCatalog Thrown if the catalog file 
  *	does not exist.
@@ -61,19 +91,56 @@ namespace lcmc { namespace inject {
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	create the object.
  *
- * @exceptsafe Object construction is atomic.
+ * @exceptsafe The random number generator is unchanged in the event of 
+ *	an exception.
  */
-std::auto_ptr<Observations> dataSampler(const string& whichSample) {
-	if (       whichSample == "NonSpitzerNonVar") {
-		return auto_ptr<Observations>(new Observations("nonspitzernonvar.cat"));
-	} else if (whichSample == "NonSpitzerVar") {
-		return auto_ptr<Observations>(new Observations(   "nonspitzervar.cat"));
-	} else if (whichSample ==    "SpitzerNonVar") {
-		return auto_ptr<Observations>(new Observations(   "spitzernonvar.cat"));
-	} else if (whichSample ==    "SpitzerVar") {
-		return auto_ptr<Observations>(new Observations(      "spitzervar.cat"));
-	} else {
-		return auto_ptr<Observations>(new Observations(whichSample));
+shared_ptr<const Observations> dataSampler(const string& whichSample) {
+	return getCatalog(catalogFile(whichSample)).pick();
+}
+
+/** Starts reading the light curves that dataSampler() will return for 
+ *	a range of trials
+ *
+ * The light curves are read on a background thread, so that the calls 
+ * to dataSampler() for these trials do not need to wait for the disk.
+ *
+ * @param[in] whichSample The name of the light curve catalog to read, 
+ *	as for dataSampler().
+ * @param[in] seed The seed of the run, or a negative number if the 
+ *	trials don't use utils::TrialStreams.
+ * @param[in] bin The bin passed to utils::TrialStreams for these trials.
+ * @param[in] first, last The range of trial indices 
+ *	[@p first, @p last) to prefetch.
+ *
+ * @post If @p seed &ge; 0, the light curves picked by each trial's 
+ *	injection stream are being read. Otherwise, the next 
+ *	@p last - @p first light curves picked without trial streams 
+ *	are being read.
+ *
+ * @exceptsafe Does not throw exceptions. Failure to prefetch a light 
+ *	curve is not an error, since it will be read when it is needed, 
+ *	and any problems will be reported then.
+ */
+void prefetchSamples(const string& whichSample, long seed, unsigned long bin, 
+		unsigned long first, unsigned long last) {
+	try {
+		const Catalog& catalog = getCatalog(catalogFile(whichSample));
+		
+		std::vector<size_t> indices;
+		if (seed >= 0) {
+			// Each trial's first injection draw picks its light curve
+			for(unsigned long i = first; i < last; i++) {
+				const shared_ptr<gsl_rng> stream(utils::allocStream(seed, 
+					bin, i, utils::INJECT_STREAM), &gsl_rng_free);
+				indices.push_back(catalog.choose(stream.get()));
+			}
+		} else if (last > first) {
+			indices = catalog.upcoming(last - first);
+		}
+		
+		catalog.prefetch(indices);
+	} catch (...) {
+		// Prefetching is optional
 	}
 }
 
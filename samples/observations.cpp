@@ -2,7 +2,7 @@
  * @file lightcurveMC/samples/observations.cpp
  * @author Krzysztof Findeisen
  * @date Created May 4, 2012
- * @date Last modified June 18, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,23 +27,19 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <functional>
 #include <string>
 #include <vector>
-#include <cstdio>
-#include <cstring>
 #include <boost/smart_ptr.hpp>
-#include <gsl/gsl_rng.h>
 #include "../fluxmag.h"
+#include "catalog.h"
 #include "observations.h"
 #include "../../common/fileio.h"
-#include "../gsl_compat.h"
-#include "../except/inject.h"
 #include "../../common/lcio.h"
 #include "../mcio.h"
 #include "../../common/nan.h"
 #include "../../common/stats.tmp.h"
-#include "../../common/cerror.h"
-#include "../../common/alloc.tmp.h"
 
 namespace lcmc { namespace inject {
 
@@ -54,40 +50,42 @@ namespace lcmc { namespace inject {
  *	to a text file containing the light curve of a source in 
  *	the sample.
  * 
+ * If a utils::TrialStreams object is active on the calling thread, the 
+ *	light curve is picked using that trial's injection stream.
+ * 
  * @exception lcmc::inject::except::NoCatalog Thrown if the catalog file does not exist.
  * @exception kpfutils::except::FileIo Thrown if the catalog or the light curve 
  *	could not be read.
  * @exception std::bad_alloc Thrown if there is not enough memory to create the object.
  *
  * @exceptsafe Object construction is atomic.
+ *
+ * @see getCatalog() and Catalog::pick(), which avoid copying the light curve.
  */
-Observations::Observations(const std::string& catalogName) : times(), fluxes() {
-	// Note: because sourcePicker is static, no memory management is needed
-	static gsl_rng * sourcePicker = NULL;
-	if (sourcePicker == NULL) {
-		sourcePicker = gsl_rng_alloc(gsl_rng_mt19937);
-		gsl_rng_set(sourcePicker, 5489);
-	}
-
-	// Grab the light curves in the sample
-	const std::vector<std::string> library = getLcLibrary(catalogName);
+Observations::Observations(const std::string& catalogName) : times(), fluxes(), 
+		offsets() {
+	boost::shared_ptr<const Observations> source = getCatalog(catalogName).pick();
 	
-	if (library.size() == 0) {
-		throw kpfutils::except::FileIo("Catalog " + catalogName + " does not contain any light curves.");
-	}
-	
-	// copy-and-swap the generator state, to ensure it only changes 
-	//	if the object is successfully constructed
-	gsl_rng * tempRng = kpfutils::checkAlloc(gsl_rng_clone(sourcePicker));
-	
-	// gsl_rng_uniform_int() generates over [0, n), not [0, n]
-	unsigned long int index = gsl_rng_uniform_int(tempRng, library.size());
-	
-	readFile(library.at(index));
+	// copy-and-swap
+	// The cadence is shared with the catalog's copy, not duplicated
+	models::Cadence tempTimes = source->times;
+	std::vector<double> tempFluxes = source->fluxes;
+	std::vector<double> tempOffsets = source->offsets;
 	
 	// IMPORTANT: no exceptions beyond this point
 	
-	gsl_rng_memcpy(sourcePicker, tempRng);
+	this->times  .swap(tempTimes  );
+	this->fluxes .swap(tempFluxes );
+	this->offsets.swap(tempOffsets);
+}
+
+/** Initializes the object to an empty light curve.
+ *
+ * @post The object contains no observations.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+Observations::Observations() : times(), fluxes(), offsets() {
 }
 
 /** Initializes an object to the value of a particular light curve.
@@ -99,6 +97,7 @@ Observations::Observations(const std::string& catalogName) : times(), fluxes() {
  *
  * @post times does not contain NaNs
  * @post fluxes does not contain NaNs
+ * @post times is in ascending order
  * 
  * @exception kpfutils::except::FileIo Thrown if the file could not 
  *	be opened or if the file does not conform to the expected format.
@@ -109,8 +108,6 @@ Observations::Observations(const std::string& catalogName) : times(), fluxes() {
  *	in the event of an exception.
  */
 void Observations::readFile(const std::string& fileName) {
-	using std::swap;
-
 	// Use the existing interface
 	// Temporary variables for exception safety
 	std::vector<double> dummyFluxes, dummyTimes, dummyErrors;
@@ -137,65 +134,99 @@ void Observations::readFile(const std::string& fileName) {
 		(*it) /= median;
 	}
 	
-	// Non-throwing swap
-	swap(this->times , cleanTimes );
-	swap(this->fluxes, cleanFluxes);
+	setLightCurve(cleanTimes, cleanFluxes);
 }
 
-/** Returns the list of files from which the class may select sources
+/** Orders the positions in a light curve by time
+ */
+class ByTime : public std::binary_function<size_t, size_t, bool> {
+public:
+	/** Sorts positions in @p times
+	 *
+	 * @param[in] times The times to compare. Must remain valid for 
+	 *	the lifetime of the object.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	explicit ByTime(const std::vector<double>& times) : times(times) {
+	}
+	
+	/** Tests whether one observation came before another
+	 *
+	 * @param[in] a, b Positions in the light curve.
+	 *
+	 * @return True if time @p a is earlier than time @p b.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool operator()(size_t a, size_t b) const {
+		return times[a] < times[b];
+	}
+private:
+	const std::vector<double>& times;
+};
+
+/** Replaces the light curve, sorting it in time order.
  *
- * @param[in] catalogName A text file where each line is a path 
- *	to a text file containing the light curve of a source in 
- *	the sample.
+ * @param[in,out] newTimes, newFluxes The light curve to store. 
+ *	Their contents are unspecified after the call.
  *
- * @return A vector whose every entry is a path to a text file containing 
- *	the light curve of a source in the sample. The vector may be empty 
- *	if catalogName does not contain any valid lines.
- * 
- * @exception lcmc::inject::except::NoCatalog Thrown if the catalog file 
- *	does not exist.
- * @exception kpfutils::except::FileIo Thrown if the catalog could not 
- *	be read.
- * @exception std::bad_alloc Thrown if there is not enough memory to store 
- *	the catalog.
+ * @pre @p newTimes.size() = @p newFluxes.size()
+ * @pre @p newTimes does not contain NaNs
  *
- * @exceptsafe The arguments are unchanged in the event of an exception.
+ * @post times contains the elements of @p newTimes, in ascending order.
+ * @post fluxes[i] is the flux originally paired with times[i]. 
+ *	Observations taken at the same time keep their original order.
+ * @post offsets[i] = fluxes[i] - 1
  *
- * @bug Returns file paths relative to working directory, not relative to catalog.
+ * @perform O(N) time if @p newTimes is already sorted, O(N log N) 
+ *	time otherwise, where N = @p newTimes.size().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to store 
+ *	the light curve.
+ *
+ * @exceptsafe This object is unchanged in the event of an exception.
  */
-const std::vector<std::string> Observations::getLcLibrary(const std::string& catalogName) {
-
-	std::vector<std::string> fileList;
-	
-	boost::shared_ptr<FILE> hCatalog;
-	try {
-		hCatalog = kpfutils::fileCheckOpen(catalogName, "r");
-	} catch (const kpfutils::except::FileIo& e) {
-		throw except::NoCatalog(e.what(), catalogName);
-	}
-
-	// Read the catalog line by line
-	/** @todo Add some format checking later!
-	 */
-	while(!feof(hCatalog.get())) {
-		char textBuffer[128];
-		fgets(textBuffer, 128, hCatalog.get());
-		if (ferror(hCatalog.get())) {
-			kpfutils::fileError(hCatalog.get(), "Error while reading " + catalogName + ": ");
-		}
-		// Remove trailing whitespace!
-		std::string strBuffer(textBuffer);
-		while(strBuffer.size() > 0 && *(strBuffer.rbegin()) == '\n') {
-			// erase() only works with forward iterators
-			// Size check guarantees that there is an iterator before end()
-			strBuffer.erase(--strBuffer.end());
+void Observations::setLightCurve(std::vector<double>& newTimes, 
+		std::vector<double>& newFluxes) {
+	// Light curve files are almost always in time order, and 
+	//	Cadence would sort the times without their fluxes
+	if (std::adjacent_find(newTimes.begin(), newTimes.end(), 
+			std::greater<double>()) != newTimes.end()) {
+		std::vector<size_t> order(newTimes.size());
+		for(size_t i = 0; i < order.size(); i++) {
+			order[i] = i;
 		}
-		if (strBuffer.size() > 0) {
-			fileList.push_back(strBuffer);
+		std::stable_sort(order.begin(), order.end(), ByTime(newTimes));
+		
+		std::vector<double> sortedTimes, sortedFluxes;
+		sortedTimes .reserve(order.size());
+		sortedFluxes.reserve(order.size());
+		for(std::vector<size_t>::const_iterator it = order.begin(); 
+				it != order.end(); it++) {
+			sortedTimes .push_back(newTimes [*it]);
+			sortedFluxes.push_back(newFluxes[*it]);
 		}
+		
+		newTimes .swap(sortedTimes );
+		newFluxes.swap(sortedFluxes);
 	}
 	
-	return fileList;
+	// copy-and-swap
+	models::Cadence tempTimes(newTimes);
+	// Observations and ILightCurve both have a reference flux of 1, 
+	//	so injections add the light curve less that flux
+	std::vector<double> tempOffsets(newFluxes);
+	for(std::vector<double>::iterator it = tempOffsets.begin(); 
+			it != tempOffsets.end(); it++) {
+		*it -= 1.0;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	this->times  .swap(tempTimes  );
+	this->fluxes .swap(newFluxes  );
+	this->offsets.swap(tempOffsets);
 }
 
 /** Returns the timestamps associated with this source.
@@ -215,7 +246,7 @@ void Observations::getTimes(std::vector<double> &timeArray) const {
 
 	// copy-and-swap to allow atomic guarantee
 	// vector::= only offers the basic guarantee
-	std::vector<double> temp = this->times;
+	std::vector<double> temp = this->times.timeView();
 	
 	swap(timeArray, temp);
 }
@@ -242,4 +273,69 @@ void Observations::getFluxes(std::vector<double> &fluxArray) const {
 	swap(fluxArray, temp);
 }
 
+/** Returns a read-only view of the timestamps associated with this source.
+ *
+ * @return A reference to the timestamps, valid for the lifetime of 
+ *	the object.
+ * 
+ * @post return value does not contain NaNs
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const std::vector<double>& Observations::timeView() const {
+	return this->times.timeView();
+}
+
+/** Returns the cadence at which this source was observed.
+ *
+ * @return The cadence of the light curve. Copies of it share the 
+ *	times stored in this object.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const models::Cadence& Observations::cadence() const {
+	return this->times;
+}
+
+/** Returns a read-only view of the flux measurements associated with 
+ *	this source.
+ *
+ * @return A reference to the measurements, valid for the lifetime of 
+ *	the object.
+ * 
+ * @post return value does not contain NaNs
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const std::vector<double>& Observations::fluxView() const {
+	return this->fluxes;
+}
+
+/** Returns a read-only view of the flux measurements, offset to a 
+ *	median of zero.
+ *
+ * Adding the offsets to a simulated light curve, whose reference 
+ * flux is also one, injects the simulated signal into this source 
+ * without counting the reference flux twice.
+ *
+ * @return A reference to the measurements minus one, valid for the 
+ *	lifetime of the object.
+ * 
+ * @post return value does not contain NaNs
+ * @post return value.%size() = fluxView().%size()
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const std::vector<double>& Observations::offsetView() const {
+	return this->offsets;
+}
+
 }}		// end lcmc::inject
@@ -2,7 +2,7 @@
  * @file lightcurveMC/samples/observations.h
  * @author Krzysztof Findeisen
  * @date Created May 4, 2012
- * @date Last modified May 9, 2012
+ * @date Last modified October 14, 2026
  * 
  * These types represent different sets of observations that can be used to 
  * inject simulated signals into real data. The actual population of the sets 
@@ -35,9 +35,10 @@
 #ifndef LCMCDATAH
 #define LCMCDATAH
 
-#include <memory>
 #include <string>
 #include <vector>
+#include <boost/smart_ptr.hpp>
+#include "../cadence.h"
 
 namespace lcmc { 
 
@@ -74,28 +75,64 @@ public:
 	 */
 	void getFluxes(std::vector<double>& fluxArray) const;
 
+	/** Returns a read-only view of the timestamps associated with 
+	 *	this source.
+	 */
+	const std::vector<double>& timeView() const;
+
+	/** Returns the cadence at which this source was observed.
+	 */
+	const models::Cadence& cadence() const;
+
+	/** Returns a read-only view of the flux measurements associated 
+	 *	with this source.
+	 */
+	const std::vector<double>& fluxView() const;
+
+	/** Returns a read-only view of the flux measurements, offset to 
+	 *	a median of zero.
+	 */
+	const std::vector<double>& offsetView() const;
+
 	// Virtual destructor following Effective C++
 	virtual ~Observations() {};
 
 private:
+	// Catalog loads each light curve through readFile()
+	friend class Catalog;
+
+	/** Initializes the object to an empty light curve.
+	 */
+	Observations();
+
 	/** Initializes an object to the value of a particular light curve.
 	 */
 	void readFile(const std::string& fileName);
 
-	/** Returns the list of files from which the class may select sources
+	/** Replaces the light curve, sorting it in time order.
 	 */
-	static const std::vector<std::string> getLcLibrary(const std::string& catalogName);
+	void setLightCurve(std::vector<double>& newTimes, 
+			std::vector<double>& newFluxes);
 
 	/** Store the light curve itself
 	 */
-	std::vector<double> times;
+	models::Cadence times;
 	std::vector<double> fluxes;
+	/** @p fluxes minus one, so that injections can add the light 
+	 *	curve without copying it */
+	std::vector<double> offsets;
 };
 
-/** dataSampler is a factory method that allocates and initializes an 
- *	Observations object of a particular type.
+/** dataSampler is a factory method that returns a randomly selected 
+ *	light curve from a particular sample.
+ */
+boost::shared_ptr<const Observations> dataSampler(const std::string& whichSample);
+
+/** Starts reading the light curves that dataSampler() will return for 
+ *	a range of trials
  */
-std::auto_ptr<Observations> dataSampler(const std::string& whichSample);
+void prefetchSamples(const std::string& whichSample, long seed, unsigned long bin, 
+		unsigned long first, unsigned long last);
 
 }}		// end lcmc::inject
 
@@ -2,7 +2,7 @@
  * @file lightcurveMC/sims.cpp
  * @author Krzysztof Findeisen
  * @date Created May 25, 2013
- * @date Last modified June 18, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -33,14 +33,20 @@
 #include <cmath>
 #include <cstdio>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_rng.h>
 #include "../common/fileio.h"
+#include "cachestats.h"
+#include "cadence.h"
 #include "gsl_compat.h"
 #include "lightcurvetypes.h"
 #include "mcio.h"
+#include "noisepool.h"
+#include "rngstream.h"
 #include "samples/observations.h"
 #include "sims.h"
+#include "waves/lightcurves_gp.h"
 #include "../common/alloc.tmp.h"
 
 namespace lcmc { 
@@ -84,7 +90,7 @@ namespace models {
  *
  * @exceptsafe Function arguments are unchanged in the event of an exception.
  */
-auto_ptr<ILightCurve> lcFactory(LightCurveType whichLc, const vector<double> &times, 
+auto_ptr<ILightCurve> lcFactory(LightCurveType whichLc, const Cadence &times, 
 		const ParamList &lcParams);
 
 }	// end lcmc::models
@@ -96,6 +102,8 @@ auto_ptr<ILightCurve> lcFactory(LightCurveType whichLc, const vector<double> &ti
  *
  * @post The data previously in @p times are erased
  * @post @p times contains a list of Julian dates, sorted in ascending order.
+ * @post @p times shares its data with every other cadence returned for 
+ *	@p dateList, so long as no other file was read in between.
  *
  * @exception kpfutils::except::FileIo Thrown if @p dateList could 
  *	not be read or had the wrong format.
@@ -104,32 +112,39 @@ auto_ptr<ILightCurve> lcFactory(LightCurveType whichLc, const vector<double> &ti
  *
  * @exceptsafe The program arguments are unchanged in the event of an exception.
  */
-void makeTimes(const string& dateList, vector<double>& times) {
+void makeTimes(const string& dateList, models::Cadence& times) {
 	using std::swap;
 
 	// Cache time stamps to avoid unneccessary file I/O
 	// invariant: oldTimeFile.empty() xor oldTimes contains the times within oldTimeFile
-	static vector<double> oldTimes;
+	// Shared by all threads, so that every trial on a cadence shares 
+	//	one copy of its times
+	static boost::mutex cacheLock;
+	static models::Cadence oldTimes;
 	static string oldTimeFile;
+	static utils::CacheCounter counter("Cadences (makeTimes)");
+	
+	boost::mutex::scoped_lock guard(cacheLock);
 
 	if (oldTimeFile.empty() || oldTimeFile != dateList) {
-		shared_ptr<FILE> hJulDates = kpfutils::fileCheckOpen(dateList, "r");
-
-		// readTimeStamps() is not atomic
+		const utils::CacheMiss miss(counter);
+		
 		// use copy-and-swap to ensure the cache doesn't get corrupted
-		vector<double> tempTimes;
-		readTimeStamps(hJulDates.get(), tempTimes);
+		vector<double> rawTimes;
+		readTimeStampFile(dateList, rawTimes);
+		// readTimeStampFile() sorts the times
+		models::Cadence tempTimes(rawTimes, models::SortedTimes());
 		
 		oldTimeFile = dateList;
 		// IMPORTANT: no exceptions to the end of the block
 		swap(oldTimes, tempTimes);
+	} else {
+		counter.hit();
 	}
 	
-	// vector::= only offers the basic guarantee
-	// copy-and-swap to allow atomic guarantee
-	vector<double> temp = oldTimes;
-	
-	swap(times, temp);
+	// Copying a Cadence shares the times rather than duplicating them, 
+	//	and does not throw
+	times = oldTimes;
 }
 
 /** Generates white noise corresponding to a given cadence.
@@ -142,6 +157,11 @@ void makeTimes(const string& dateList, vector<double>& times) {
  * @post @p noise.size() = @p times.size()
  * @post @p noise contains uncorrelated Gaussian noise with variance &sigma;<sup>2</sup>.
  *
+ * If a utils::TrialStreams object is active on the calling thread, the noise 
+ *	is drawn from that trial's noise stream. If the trial is covered by 
+ *	the pool set with setNoisePool(), the noise is copied from the pool, 
+ *	which draws it from the same stream the first time.
+ *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	generate random numbers or store the output.
  *
@@ -152,6 +172,11 @@ void makeTimes(const string& dateList, vector<double>& times) {
 void makeWhiteNoise(const vector<double>& times, double sigma, vector<double>& noise) {
 	using std::swap;
 
+	const shared_ptr<NoisePool> pool = getNoisePool();
+	if (pool && pool->draw(times.size(), sigma, noise)) {
+		return;
+	}
+
 	// Noise generator
 	static shared_ptr<gsl_rng> mcDriver;
 	// Separate instantiation to ensure gsl_rng_alloc() gets called until it succeeds
@@ -159,14 +184,23 @@ void makeWhiteNoise(const vector<double>& times, double sigma, vector<double>& n
 		mcDriver.reset(checkAlloc(gsl_rng_alloc(gsl_rng_mt19937)), &gsl_rng_free);
 		gsl_rng_set(mcDriver.get(), 27);
 	}
+	gsl_rng* noiseRng = utils::trialStream(utils::NOISE_STREAM);
+	if (noiseRng == NULL) {
+		noiseRng = mcDriver.get();
+	}
 
 	// Generate the actual noise
 	// copy-and-swap
-	vector<double> tempNoise;
-	tempNoise.reserve(times.size());
+	vector<double> tempNoise(times.size());
 	
-	for(size_t i = 0; i < times.size(); i++) {
-		tempNoise.push_back(gsl_ran_gaussian(mcDriver.get(), sigma));
+	if (noiseRng == mcDriver.get()) {
+		// Runs without a trial seed keep the sequence of earlier versions
+		for(size_t i = 0; i < tempNoise.size(); i++) {
+			tempNoise[i] = gsl_ran_gaussian(noiseRng, sigma);
+		}
+	// &tempNoise[0] is not defined for an empty vector
+	} else if (!tempNoise.empty()) {
+		utils::fillNormal(noiseRng, &tempNoise[0], tempNoise.size(), sigma);
 	}
 	
 	// IMPORTANT: no exceptions beyond this point
@@ -174,53 +208,185 @@ void makeWhiteNoise(const vector<double>& times, double sigma, vector<double>& n
 	swap(noise, tempNoise);
 }
 
-/** Generates an observed light curve for an injection analysis.
+/** Chooses an observed light curve for an injection analysis, without 
+ *	copying it.
+ *
+ * The fluxes are not copied out of the catalog, so each trial costs 
+ * no allocations beyond its own simulated fluxes.
  *
  * @param[in] catalog The name of a file containing a list of light curves 
  *	to sample from.
- * @param[out] times, baseFlux Store a light curve randomly selected from @p catalog.
+ * @param[out] times Stores the times of a light curve randomly selected 
+ *	from @p catalog.
+ * @param[out] baseFlux Points to the fluxes of the same light curve, 
+ *	offset to a median flux of zero.
  *
- * @post The data previously in @p times and @p baseFlux are erased
- * @post @p times.size() = @p baseFlux.size()
- * @post The fluxes in the original light curve are scaled to a median flux 
- *	of one, then offset to a median flux of zero. 
+ * @post @p times shares its data with the catalog's copy of the light curve.
+ * @post @p baseFlux shares ownership of the catalog's copy of the light 
+ *	curve, so it remains valid even if the catalog is unloaded.
+ * @post @p times.size() = @p baseFlux->size()
  *
  * @exception lcmc::inject::except::NoCatalog Thrown if @p catalog does not exist.
  * @exception kpfutils::except::FileIo Thrown if the catalog or the light 
  *	curve could not be read.
  * @exception std::bad_alloc Thrown if there is not enough memory to 
- *	store the output.
+ *	choose the light curve.
  *
  * @exceptsafe The program is in a valid state in the event of an exception.
  * 
  * @internal @note No atomic guarantee because the RNG associated with 
  *	Observations will always be updated.
  */
-void makeInjectNoise(const string& catalog, 
-		vector<double>& times, vector<double>& baseFlux) {
+void makeInjectBase(const string& catalog, models::Cadence& times, 
+		boost::shared_ptr<const vector<double> >& baseFlux) {
 	using namespace inject;
 	using std::swap;
 
-	auto_ptr<Observations> curData = dataSampler(catalog);
+	boost::shared_ptr<const Observations> curData = dataSampler(catalog);
+	
+	// The pointer to the offsets owns the whole light curve
+	boost::shared_ptr<const vector<double> > tempFlux(curData, 
+		&curData->offsetView());
+	models::Cadence tempTimes = curData->cadence();
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(times, tempTimes);
+	swap(baseFlux, tempFlux);
+}
+
+/** Starts reading the observed light curves for a range of injection 
+ *	trials in the background.
+ *
+ * Later calls to makeInjectBase() for these trials will use the light 
+ * curves already read, rather than waiting for the disk.
+ *
+ * @param[in] catalog The name of a file containing a list of light curves 
+ *	to sample from.
+ * @param[in] seed The seed of the run, or a negative number if the 
+ *	trials don't use utils::TrialStreams.
+ * @param[in] bin The bin passed to utils::TrialStreams for these trials.
+ * @param[in] first, last The range of trial indices 
+ *	[@p first, @p last) about to be simulated.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void prefetchInjectNoise(const string& catalog, long seed, unsigned long bin, 
+		unsigned long first, unsigned long last) {
+	inject::prefetchSamples(catalog, seed, bin, first, last);
+}
 
-	// copy-and-swap to ensure times and baseFlux are updated together
-	vector<double> tempFlux;
-	curData->getFluxes(tempFlux);
+/** Creates a random light curve, drawing all the random numbers it 
+ *	needs at once.
+ *
+ * If the light curve is a models::GaussianProcess, its random numbers are 
+ * drawn with models::GaussianProcess::drawDeviates(), so that its fluxes 
+ * may be computed later, together with those of other light curves, 
+ * without changing the random numbers used by any trial.
+ *
+ * @param[in] curve The type of light curve to generate
+ * @param[in] params The parameters for the light curve.
+ * @param[in] times The times at which the light curve will be observed.
+ *
+ * @return A newly allocated light curve.
+ *
+ * @pre @p params contains a valid entry for each parameter required 
+ *	by @p curve
+ * @pre @p times.size() > 0
+ * 
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the light curve.
+ * @exception std::invalid_argument Thrown if @p curve is invalid.
+ * @exception lcmc::models::except::MissingParam Thrown if a required 
+ *	parameter is missing from @p params.
+ * @exception lcmc::models::except::BadParam Thrown if @p params contains an 
+ *	illegal parameter value.
+ *
+ * @exceptsafe The program is in a consistent state in the event of an exception.
+ */
+auto_ptr<models::ILightCurve> makeLightCurve(const models::LightCurveType& curve, 
+		const models::ParamList& params, const models::Cadence& times) {
+	auto_ptr<models::ILightCurve> lcInstance = lcFactory(curve, times, params);
+	
+	const models::GaussianProcess* const gp = 
+			dynamic_cast<const models::GaussianProcess*>(lcInstance.get());
+	if (gp != NULL) {
+		gp->drawDeviates();
+	}
+	
+	return lcInstance;
+}
 
-	// Observations and ILightCurve both have a reference flux of 1
-	// To add an Observations and an ILightCurve, need to subtract a 
-	//	flux of 1 to avoid double-counting
-	// This is the most convenient place to do it, since it lets the 
-	//	Observations light curve be treated like correlated noise
-	for(vector<double>::iterator it = tempFlux.begin(); it != tempFlux.end(); it++) {
-		*it -= 1.0;
+/** Computes the fluxes of a light curve and adds noise to them.
+ *
+ * @param[in] lcInstance The light curve to observe.
+ * @param[in] noise The contaminating signal, in units of the median 
+ *	source flux, to add to the light curve.
+ * @param[out] lcFluxes The fluxes of @p lcInstance, including @p noise.
+ *
+ * @pre @p lcInstance.size() = @p noise.size()
+ *
+ * @post Any data previously in @p lcFluxes is erased
+ * @post @p lcFluxes.size() = @p lcInstance.size()
+ * @post @p lcFluxes[i] = @p lcInstance.getFluxes()[i] + @p noise[i]
+ * 
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	calculate the light curve.
+ * @exception std::logic_error Thrown if a bug is found in the flux calculations.
+ *
+ * @exceptsafe The program is in a consistent state in the event of an exception.
+ */
+void finishLightCurve(const models::ILightCurve& lcInstance, 
+		const vector<double>& noise, vector<double>& lcFluxes) {
+	// Reuses the storage of lcFluxes, rather than copying a 
+	//	temporary light curve into it
+	const size_t nObs = lcInstance.size();
+	lcFluxes.resize(nObs);
+	
+	// &lcFluxes[0] is not defined for an empty vector
+	if (nObs > 0) {
+		lcInstance.fillFluxes(&lcFluxes[0]);
+	}
+	
+	// No exceptions past this point
+	for(size_t j = 0; j < nObs; j++) {
+		lcFluxes[j] += noise[j];
 	}
+}
 
-	curData->getTimes(times);
+/** Computes the magnitudes of a light curve and adds noise to them.
+ *
+ * @param[in] lcInstance The light curve to observe.
+ * @param[in] noise The contaminating signal, in magnitudes, to add to 
+ *	the light curve.
+ * @param[out] lcMags The magnitudes of @p lcInstance, including @p noise.
+ *
+ * @pre @p lcInstance.size() = @p noise.size()
+ *
+ * @post Any data previously in @p lcMags is erased
+ * @post @p lcMags.size() = @p lcInstance.size()
+ * @post @p lcMags[i] = @p lcInstance.fillMags()[i] + @p noise[i]
+ * 
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	calculate the light curve.
+ * @exception std::logic_error Thrown if a bug is found in the flux calculations.
+ *
+ * @exceptsafe The program is in a consistent state in the event of an exception.
+ */
+void finishLightCurveMags(const models::ILightCurve& lcInstance, 
+		const vector<double>& noise, vector<double>& lcMags) {
+	const size_t nObs = lcInstance.size();
+	lcMags.resize(nObs);
 	
-	// IMPORTANT: no exceptions beyond this point
+	// &lcMags[0] is not defined for an empty vector
+	if (nObs > 0) {
+		lcInstance.fillMags(&lcMags[0]);
+	}
 	
-	swap(baseFlux, tempFlux);
+	// No exceptions past this point
+	for(size_t j = 0; j < nObs; j++) {
+		lcMags[j] += noise[j];
+	}
 }
 
 /** Generates a random light curve, incorporating all the simulation settings.
@@ -256,18 +422,52 @@ void makeInjectNoise(const string& catalog,
  *	getFluxes() throws an exception.
  */
 void simLightCurve(const models::LightCurveType& curve, const models::ParamList& params, 
-		const vector<double>& times, const vector<double>& noise, 
+		const models::Cadence& times, const vector<double>& noise, 
 		vector<double>& lcFluxes) {
 	// Generate the light curve...
-	auto_ptr<models::ILightCurve> lcInstance = lcFactory(curve, times, params);
-	lcInstance->getFluxes(lcFluxes);
-	
-	// No exceptions past this point
-	size_t nObs = lcFluxes.size();
-	
-	for(size_t j = 0; j < nObs; j++) {
-		lcFluxes[j] += noise[j];
-	}
+	auto_ptr<models::ILightCurve> lcInstance = makeLightCurve(curve, params, times);
+	finishLightCurve(*lcInstance, noise, lcFluxes);
+}
+
+/** Returns the way drawParams() samples the parameter ranges
+ *
+ * @return A modifiable reference to the sampling.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ParamSampling& paramSampling() {
+	static ParamSampling sampling = SAMPLE_RANDOM;
+	return sampling;
+}
+
+/** Chooses how drawParams() samples the parameter ranges
+ *
+ * @param[in] sampling The sampling to use for all later trials.
+ *
+ * @post If @p sampling is @ref SAMPLE_SOBOL "SAMPLE_SOBOL", the 
+ *	parameters drawn in each trial are the coordinates of the trial's 
+ *	point in a scrambled Sobol sequence, transformed to each 
+ *	parameter's distribution. The first N trials of a bin then cover 
+ *	the parameter ranges more evenly than N random draws, so summary 
+ *	statistics that vary smoothly with the parameters converge in 
+ *	fewer trials.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any trials are simulated.
+ */
+void setParamSampling(ParamSampling sampling) {
+	paramSampling() = sampling;
+}
+
+/** Returns the sampling chosen with setParamSampling()
+ *
+ * @return The way parameters are drawn.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ParamSampling getParamSampling() {
+	return paramSampling();
 }
 
 /** Randomly generates parameter values within the specified limits
@@ -287,10 +487,22 @@ void simLightCurve(const models::LightCurveType& curve, const models::ParamList&
  *
  * @post No element of the return value is NaN.
  *
+ * If a utils::TrialStreams object is active on the calling thread, the 
+ *	values are drawn from that trial's parameter stream. If 
+ *	setParamSampling() chose @ref SAMPLE_SOBOL "SAMPLE_SOBOL", they are 
+ *	instead taken from the trial's Sobol point, one coordinate for each 
+ *	parameter whose minimum and maximum differ.
+ *
+ * @perform O(K) time, where K is the number of parameters in @p limits. 
+ *	Parameters are looked up by identifier rather than by name, and 
+ *	no memory is allocated after the first call.
+ *
  * @exception std::bad_alloc Thrown if not enough memory to generate random 
  *	values.
  * @exception std::logic_error Thrown if drawParams() does not support all 
- *	distributions in limits
+ *	distributions in limits, if Sobol sampling is used without an active 
+ *	utils::TrialStreams object, or if Sobol sampling is asked for more 
+ *	varying parameters than utils::sobolDimensions().
  *
  * @exceptsafe Function parameters are unchanged in the event of an 
  *	exception.
@@ -311,30 +523,41 @@ ParamList drawParams(const models::RangeList& limits) {
 		gsl_rng_set(randomizer, 42);
 		seeded = true;
 	}
+	gsl_rng* paramRng = utils::trialStream(utils::PARAM_STREAM);
+	if (paramRng == NULL) {
+		paramRng = randomizer;
+	}
+	const bool sobol = (getParamSampling() == SAMPLE_SOBOL);
+	// The next coordinate of the Sobol point to use
+	size_t dim = 0;
 	
 	ParamList returnValue;
 	// Convert all parameters
 	for(RangeList::const_iterator it = limits.begin(); it != limits.end(); it++) {
-		double min                   = limits.getMin(*it);
-		double max                   = limits.getMax(*it);
-		RangeList::RangeType distrib = limits.getType(*it);
+		double min                   = it.getMin();
+		double max                   = it.getMax();
+		RangeList::RangeType distrib = it.getType();
+		
+		// Fixed parameters don't use up a random number or a dimension
+		const double u = (min == max ? 0.0 
+			: (sobol ? utils::trialSobol(dim++) : gsl_rng_uniform(paramRng)));
 		
 		double value;
 		switch(distrib) {
 			case RangeList::UNIFORM:
 				value = (min == max ? min 
-					: min + (max-min)*gsl_rng_uniform(randomizer));
+					: min + (max-min)*u);
 				break;
 			case RangeList::LOGUNIFORM:
 				value = (min == max ? log10(min) 
-					: log10(min) + (log10(max)-log10(min))*gsl_rng_uniform(randomizer));
+					: log10(min) + (log10(max)-log10(min))*u);
 				value = pow(10.0, value);
 				break;
 			default:
 				throw std::invalid_argument("Unknown distribution!");
 		};
 		
-		returnValue.add(*it, value);
+		returnValue.add(it.getId(), value);
 	}
 	// If limits is empty, then returnValue is empty as well
 	
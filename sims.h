@@ -2,7 +2,7 @@
  * @file lightcurveMC/sims.h
  * @author Krzysztof Findeisen
  * @date Created May 26, 2013
- * @date Last modified May 26, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -30,8 +30,11 @@
 #ifndef LCMCSIMH
 #define LCMCSIMH
 
+#include <memory>
 #include <string>
 #include <vector>
+#include <boost/shared_ptr.hpp>
+#include "cadence.h"
 #include "lightcurvetypes.h"
 #include "paramlist.h"
 
@@ -40,27 +43,70 @@ namespace lcmc {
 using std::string;
 using std::vector;
 
+/** Ways to choose the parameters of successive trials
+ */
+enum ParamSampling {
+	/** Draws each parameter of each trial independently
+	 */
+	SAMPLE_RANDOM, 
+	/** Takes each trial's parameters from a scrambled Sobol sequence, 
+	 *	so that the trials cover the parameter ranges evenly
+	 */
+	SAMPLE_SOBOL
+};
+
+/** Chooses how drawParams() samples the parameter ranges
+ */
+void setParamSampling(ParamSampling sampling);
+
+/** Returns the sampling chosen with setParamSampling()
+ */
+ParamSampling getParamSampling();
+
 /** Randomly generates parameter values within the specified limits
  */
 models::ParamList drawParams(const models::RangeList& limits);
 
 /** Returns the time stamps corresponding to a particular input file.
  */
-void makeTimes(const string& dateList, vector<double>& times);
+void makeTimes(const string& dateList, models::Cadence& times);
 
 /** Generates white noise corresponding to a given cadence.
  */
 void makeWhiteNoise(const vector<double>& times, double sigma, vector<double>& noise);
 
-/** Generates an observed light curve for an injection analysis.
+/** Chooses an observed light curve for an injection analysis, 
+ *	without copying it.
+ */
+void makeInjectBase(const string& catalog, models::Cadence& times, 
+		boost::shared_ptr<const vector<double> >& baseFlux);
+
+/** Starts reading the observed light curves for a range of injection 
+ *	trials in the background.
+ */
+void prefetchInjectNoise(const string& catalog, long seed, unsigned long bin, 
+		unsigned long first, unsigned long last);
+
+/** Creates a random light curve, drawing all the random numbers it 
+ *	needs at once.
+ */
+std::auto_ptr<models::ILightCurve> makeLightCurve(const models::LightCurveType& curve, 
+		const models::ParamList& params, const models::Cadence& times);
+
+/** Computes the fluxes of a light curve and adds noise to them.
+ */
+void finishLightCurve(const models::ILightCurve& lcInstance, 
+		const vector<double>& noise, vector<double>& lcFluxes);
+
+/** Computes the magnitudes of a light curve and adds noise to them.
  */
-void makeInjectNoise(const string& catalog, 
-		vector<double>& times, vector<double>& baseFlux);
+void finishLightCurveMags(const models::ILightCurve& lcInstance, 
+		const vector<double>& noise, vector<double>& lcMags);
 
 /** Generates a random light curve, incorporating all the simulation settings.
  */
 void simLightCurve(const models::LightCurveType& curve, const models::ParamList& params, 
-		const vector<double>& times, const vector<double>& noise, 
+		const models::Cadence& times, const vector<double>& noise, 
 		vector<double>& lcFluxes);
 
 }	// end lcmc
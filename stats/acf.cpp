@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/acf.cpp
  * @author Krzysztof Findeisen
  * @date Created May 7, 2013
- * @date Last modified May 26, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,13 +27,22 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/tss.hpp>
+#ifdef LCMC_USE_FFTW
+#include <boost/thread/mutex.hpp>
+#include <fftw3.h>
+#endif
 #include <gsl/gsl_fft_halfcomplex.h>
 #include <gsl/gsl_fft_real.h>
 #include <gsl/gsl_statistics_double.h>
 #include "acf.h"
+#include "../cachestats.h"
 #include "../gsl_compat.h"
 #include "../except/undefined.h"
 #include "../../common/alloc.tmp.h"
@@ -79,6 +88,290 @@ void squareAmpHalfComplex(double hcArr[], size_t n) {
 	}
 }
 
+namespace {
+
+/** Returns a transform length that the FFT library handles quickly
+ *
+ * @param[in] minLength The shortest acceptable length.
+ *
+ * @return The smallest number of the form 2<sup>a</sup>3<sup>b</sup>5<sup>c</sup> 
+ *	that is at least @p minLength.
+ *
+ * @perform O(log<sup>3</sup> @p minLength) time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t fastFftLength(size_t minLength) {
+	size_t best = 1;
+	while (best < minLength) {
+		best *= 2;
+	}
+	// Try every smaller candidate with factors of 3 and 5
+	for (size_t p5 = 1; p5 < best; p5 *= 5) {
+		for (size_t p35 = p5; p35 < best; p35 *= 3) {
+			size_t candidate = p35;
+			while (candidate < minLength) {
+				candidate *= 2;
+			}
+			best = std::min(best, candidate);
+		}
+	}
+	return best;
+}
+
+#ifdef LCMC_USE_FFTW
+
+/** Returns the lock that serializes calls to the FFTW planner
+ *
+ * Only fftw_execute() is thread-safe; creating and destroying plans is not.
+ *
+ * @return A mutex shared by all FftPlan objects.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::mutex& fftwPlannerLock() {
+	static boost::mutex lock;
+	return lock;
+}
+
+/** Stores the FFTW plans and scratch space for real FFTs of one length
+ *
+ * Light curves with a fixed cadence are autocorrelated with the same 
+ * transform length on every trial. Each plan transforms a fixed number 
+ * of series at once, stored one after another in the buffer.
+ */
+class FftPlan {
+public:
+	/** Creates the plans for a transform length
+	 *
+	 * @param[in] length The number of points in each transform.
+	 * @param[in] count The number of series transformed together.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	for the plans.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	FftPlan(size_t length, size_t count) : length(length), count(count), 
+			scratch(static_cast<double*>(fftw_malloc(length * count * sizeof(double)))), 
+			forward(NULL), inverse(NULL) {
+		if (scratch == NULL) {
+			throw std::bad_alloc();
+		}
+		
+		boost::mutex::scoped_lock guard(fftwPlannerLock());
+		// A single many-transform plan lets FFTW interleave the series
+		const int n = static_cast<int>(length);
+		const int howMany = static_cast<int>(count);
+		const fftw_r2r_kind toHc = FFTW_R2HC;
+		const fftw_r2r_kind fromHc = FFTW_HC2R;
+		forward = fftw_plan_many_r2r(1, &n, howMany, scratch, NULL, 1, n, 
+			scratch, NULL, 1, n, &toHc, FFTW_ESTIMATE);
+		inverse = fftw_plan_many_r2r(1, &n, howMany, scratch, NULL, 1, n, 
+			scratch, NULL, 1, n, &fromHc, FFTW_ESTIMATE);
+		if (forward == NULL || inverse == NULL) {
+			destroy();
+			throw std::bad_alloc();
+		}
+	}
+	
+	/** Frees the plans
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	~FftPlan() {
+		boost::mutex::scoped_lock guard(fftwPlannerLock());
+		destroy();
+	}
+	
+	/** Replaces each series in the buffer with its circular autocorrelation
+	 *
+	 * @post <tt>buffer[j*L + k]</tt> = @f$ \sum_i x_{ji} x_{j, (i-k) \bmod L} @f$, 
+	 *	where @f$ x_{ji} @f$ is the original <tt>buffer[j*L + i]</tt> and 
+	 *	L = @ref length.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void autoCorrelate() {
+		fftw_execute(forward);
+		
+		// FFTW stores the real parts first, then the imaginary parts 
+		//	in reverse order
+		for (size_t j = 0; j < count; j++) {
+			double* const series = scratch + j*length;
+			series[0] *= series[0];
+			for (size_t k = 1; k < length - k; k++) {
+				series[k] = series[k]*series[k] 
+					+ series[length-k]*series[length-k];
+				series[length-k] = 0.0;
+			}
+			if (length % 2 == 0) {
+				series[length/2] *= series[length/2];
+			}
+		}
+		
+		fftw_execute(inverse);
+		// FFTW's inverse is not normalized
+		for (size_t i = 0; i < length*count; i++) {
+			scratch[i] /= length;
+		}
+	}
+
+	/** Returns the scratch space for the data being transformed
+	 *
+	 * @return An array of @ref count series of @ref length values each.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	double* buffer() {
+		return scratch;
+	}
+
+	/** The number of points in each transform */
+	const size_t length;
+	/** The number of series transformed together */
+	const size_t count;
+
+private:
+	// Plans are tied to their buffer, and cannot be copied
+	FftPlan(const FftPlan&);
+	FftPlan& operator=(const FftPlan&);
+	
+	/** Releases whatever the constructor allocated
+	 *
+	 * @pre The caller holds fftwPlannerLock()
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void destroy() {
+		if (forward != NULL) {
+			fftw_destroy_plan(forward);
+		}
+		if (inverse != NULL) {
+			fftw_destroy_plan(inverse);
+		}
+		fftw_free(scratch);
+	}
+	
+	double* const scratch;
+	fftw_plan forward;
+	fftw_plan inverse;
+};
+
+#else
+
+/** Stores the GSL tables and scratch space for real FFTs of one length
+ *
+ * Light curves with a fixed cadence are autocorrelated with the same 
+ * transform length on every trial. Each plan transforms a fixed number 
+ * of series, stored one after another in the buffer.
+ */
+class FftPlan {
+public:
+	/** Allocates the tables for a transform length
+	 *
+	 * @param[in] length The number of points in each transform.
+	 * @param[in] count The number of series transformed together.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	for the tables.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	FftPlan(size_t length, size_t count) : length(length), count(count), 
+		work(kpfutils::checkAlloc(gsl_fft_real_workspace_alloc(length)), 
+			&gsl_fft_real_workspace_free), 
+		forwardTable(kpfutils::checkAlloc(gsl_fft_real_wavetable_alloc(length)), 
+			&gsl_fft_real_wavetable_free), 
+		inverseTable(kpfutils::checkAlloc(gsl_fft_halfcomplex_wavetable_alloc(length)), 
+			&gsl_fft_halfcomplex_wavetable_free), 
+		storage(length * count) {
+	}
+	
+	/** Replaces each series in the buffer with its circular autocorrelation
+	 *
+	 * @post <tt>buffer[j*L + k]</tt> = @f$ \sum_i x_{ji} x_{j, (i-k) \bmod L} @f$, 
+	 *	where @f$ x_{ji} @f$ is the original <tt>buffer[j*L + i]</tt> and 
+	 *	L = @ref length.
+	 *
+	 * @exception std::runtime_error Thrown if GSL reports an error.
+	 *
+	 * @exceptsafe The buffer contents are undefined in the event of 
+	 *	an exception.
+	 */
+	void autoCorrelate() {
+		// GSL has no many-transform interface, but the series still 
+		//	share the tables and workspace
+		for (size_t j = 0; j < count; j++) {
+			double* const data = buffer() + j*length;
+			gslCheck( gsl_fft_real_transform(data, 1, length, 
+				forwardTable.get(), work.get()), "While computing ACF: ");
+
+			// Take the squared amplitude of the FFT while preserving the 
+			//	half-complex format
+			squareAmpHalfComplex(data, length);
+			
+			gslCheck( gsl_fft_halfcomplex_inverse(data, 1, length, 
+				inverseTable.get(), work.get()), "While computing ACF: ");
+		}
+	}
+
+	/** Returns the scratch space for the data being transformed
+	 *
+	 * @return An array of @ref count series of @ref length values each.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	double* buffer() {
+		return &storage[0];
+	}
+
+	/** The number of points in each transform */
+	const size_t length;
+	/** The number of series transformed together */
+	const size_t count;
+
+private:
+	boost::shared_ptr<gsl_fft_real_workspace> work;
+	boost::shared_ptr<gsl_fft_real_wavetable> forwardTable;
+	boost::shared_ptr<gsl_fft_halfcomplex_wavetable> inverseTable;
+	std::vector<double> storage;
+};
+
+#endif		// LCMC_USE_FFTW
+
+/** Returns the FFT plan for a transform length on the calling thread
+ *
+ * @param[in] length The number of points in each transform.
+ * @param[in] count The number of series transformed together.
+ *
+ * @return A plan that lasts until the next call on this thread with 
+ *	a different @p length or @p count.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory for 
+ *	a new plan.
+ *
+ * @exceptsafe The previous plan is kept in the event of an exception.
+ */
+FftPlan& fftPlan(size_t length, size_t count) {
+	static boost::thread_specific_ptr<FftPlan> cache;
+	static utils::CacheCounter counter("FFT plans");
+	
+	if (cache.get() == NULL || cache->length != length 
+			|| cache->count != count) {
+		const utils::CacheMiss miss(counter);
+		
+		// Build the new plan first, in case it throws
+		std::auto_ptr<FftPlan> plan(new FftPlan(length, count));
+		cache.reset(plan.release());
+	} else {
+		counter.hit();
+	}
+	return *cache;
+}
+
+}	// end unnamed namespace
+
 /** This function computes the lag-@p n autocorrelation of the dataset @p data, 
  *	using the signal-processing convention.
  *
@@ -106,58 +399,77 @@ void squareAmpHalfComplex(double hcArr[], size_t n) {
  *	an exception.
  */
 void autoCorrelation_sp(const double data[], double acfs[], size_t n) {
-	using boost::shared_ptr;
-	using kpfutils::checkAlloc;
-	
+	autoCorrelation_sp(data, acfs, n, 1);
+}
+
+/** This function computes the lag-@p n autocorrelations of several 
+ *	datasets at once, using the signal-processing convention.
+ *
+ * The datasets are transformed together, so that the FFT tables and 
+ *	workspace are loaded once for the whole block.
+ *
+ * @param[in] data, n The datasets to autocorrelate, stored one after 
+ *	another in blocks of @p n values.
+ * @param[out] acfs An array of length @p n &times; @p nSeries that will 
+ *	contain the lag-0 through lag-(@p n-1) offsets of each dataset, 
+ *	in the same layout as @p data.
+ * @param[in] nSeries The number of datasets in @p data.
+ *
+ * @pre @p n &ge; 2
+ * @pre @p nSeries &ge; 1
+ *
+ * @post For each j < @p nSeries, @f$ a_{jk} = \sum_{i = k}^{n-1} x_{ji} x_{j,i-k} @f$, 
+ *	where @f$ a_{jk} @f$ denotes @p acf[j*n + k] and @f$ x_{ji} @f$ 
+ *	denotes @p data[j*n + i]
+ *
+ * @perform O(<tt>nSeries</tt> <tt>n</tt> log <tt>n</tt>) time
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p n < 2
+ * @exception std::invalid_argument Thrown if @p nSeries < 1
+ * @exception std::runtime_error Thrown if the internal calculations produce an error.
+ * @exception std::bad_alloc Thrown if there is not enough memory to compute 
+ *	the autocorrelation functions
+ *
+ * @exceptsafe The function parameters are unchanged in the event of 
+ *	an exception.
+ */
+void autoCorrelation_sp(const double data[], double acfs[], size_t n, 
+		size_t nSeries) {
 	if (n < 2) {
 		throw except::NotEnoughData("Cannot calculate autocorrelation function with fewer than 2 data points.");
 	}
+	if (nSeries < 1) {
+		throw std::invalid_argument("Cannot calculate autocorrelation functions of zero datasets.");
+	}
 	
-	// Possible optimization: cache the workspaces and only recalculate 
-	//	them when n changes
-	
-	shared_ptr<gsl_fft_real_workspace> work(
-		checkAlloc(gsl_fft_real_workspace_alloc(2*n)), 
-		          &gsl_fft_real_workspace_free);
+	// Any length of at least 2n-1 avoids aliasing, so use one the FFT 
+	//	is fast for. Tables and scratch space are reused while n 
+	//	and nSeries stay the same.
+	FftPlan& plan = fftPlan(fastFftLength(2*n - 1), nSeries);
+	double* const transforms = plan.buffer();
 	
 	// Zero-pad the workspace to avoid aliasing
-	boost::scoped_array<double> transforms(new double[2*n]);
-	for(size_t i = 0; i < n; i++) {
-		transforms[i] = data[i];
-	}
-	for(size_t i = n; i < 2*n; i++) {
-		transforms[i] = 0.0;
+	for(size_t j = 0; j < nSeries; j++) {
+		double* const series = transforms + j*plan.length;
+		const double* const input = data + j*n;
+		for(size_t i = 0; i < n; i++) {
+			series[i] = input[i];
+		}
+		for(size_t i = n; i < plan.length; i++) {
+			series[i] = 0.0;
+		}
 	}
 	
-	// Forward FFT
-	{
-		shared_ptr<gsl_fft_real_wavetable> forwardTable(
-			checkAlloc(gsl_fft_real_wavetable_alloc(2*n)), 
-			          &gsl_fft_real_wavetable_free);
-
-		gslCheck( gsl_fft_real_transform(transforms.get(), 1, 2*n, 
-			forwardTable.get(), work.get()), "While computing ACF: ");
-	}
-
-	// Take the squared amplitude of the FFT while preserving the 
-	//	half-complex format
-	squareAmpHalfComplex(transforms.get(), 2*n);
-	
-	// Inverse FFT
-	{
-		shared_ptr<gsl_fft_halfcomplex_wavetable> inverseTable(
-			checkAlloc(gsl_fft_halfcomplex_wavetable_alloc(2*n)), 
-			          &gsl_fft_halfcomplex_wavetable_free);
-	
-		gslCheck( gsl_fft_halfcomplex_inverse(transforms.get(), 1, 2*n, 
-			inverseTable.get(), work.get()), "While computing ACF: ");
-	}
+	plan.autoCorrelate();
 	
 	// IMPORTANT: no exceptions past this point
 	
-	// Include only the correct part of the ACF
-	for(size_t i = 0; i < n; i++) {
-		acfs[i] = transforms[i];
+	// Include only the correct part of each ACF
+	for(size_t j = 0; j < nSeries; j++) {
+		const double* const series = transforms + j*plan.length;
+		for(size_t i = 0; i < n; i++) {
+			acfs[j*n + i] = series[i];
+		}
 	}
 }
 
@@ -190,27 +502,69 @@ void autoCorrelation_sp(const double data[], double acfs[], size_t n) {
  *	an exception.
  */
 void autoCorrelation_stat(const double data[], double acfs[], size_t n) {
+	autoCorrelation_stat(data, acfs, n, 1);
+}
+
+/** This function computes the lag-@p n autocorrelations of several 
+ *	datasets at once, using the statistical analysis convention.
+ *
+ * @param[in] data, n The datasets to autocorrelate, stored one after 
+ *	another in blocks of @p n values.
+ * @param[out] acfs An array of length @p n &times; @p nSeries that will 
+ *	contain the lag-0 through lag-(@p n-1) offsets of each dataset, 
+ *	in the same layout as @p data.
+ * @param[in] nSeries The number of datasets in @p data.
+ *
+ * @pre @p n &ge; 2
+ * @pre @p nSeries &ge; 1
+ *
+ * @post Each block of @p acfs is the value autoCorrelation_stat(const double[], double[], size_t) 
+ *	would give for the corresponding block of @p data.
+ *
+ * @perform O(<tt>nSeries</tt> <tt>n</tt> log <tt>n</tt>) time
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p n < 2
+ * @exception std::invalid_argument Thrown if @p nSeries < 1
+ * @exception std::runtime_error Thrown if the internal calculations produce an error.
+ * @exception std::bad_alloc Thrown if there is not enough memory to compute 
+ *	the autocorrelation functions
+ *
+ * @exceptsafe The function parameters are unchanged in the event of 
+ *	an exception.
+ */
+void autoCorrelation_stat(const double data[], double acfs[], size_t n, 
+		size_t nSeries) {
 	if (n < 2) {
 		throw except::NotEnoughData("Cannot calculate autocorrelation function with fewer than 2 data points.");
 	}
-	
-	// Normalizations
-	double mean =         gsl_stats_mean(data, 1, n);
-	//double nVar = (n-1) * gsl_stats_variance_m(data, 1, n, mean);
-	double nVar = gsl_stats_tss_m(data, 1, n, mean);
+	if (nSeries < 1) {
+		throw std::invalid_argument("Cannot calculate autocorrelation functions of zero datasets.");
+	}
 	
 	// It's most efficient to subtract off the mean beforehand
-	boost::scoped_array<double> zeroMean(new double[n]);
-	for(size_t i = 0; i < n; i++) {
-		zeroMean[i] = data[i] - mean;
+	boost::scoped_array<double> zeroMean(new double[n * nSeries]);
+	std::vector<double> nVar(nSeries);
+	for(size_t j = 0; j < nSeries; j++) {
+		const double* const input = data + j*n;
+		
+		// Normalizations
+		double mean =         gsl_stats_mean(input, 1, n);
+		//double nVar = (n-1) * gsl_stats_variance_m(input, 1, n, mean);
+		nVar[j] = gsl_stats_tss_m(input, 1, n, mean);
+		
+		for(size_t i = 0; i < n; i++) {
+			zeroMean[j*n + i] = input[i] - mean;
+		}
 	}
 
 	// First function that changes acfs
 	// since autoCorrelation_sp is atomic, and the normalization loop 
 	//	doesn't throw exceptions, this function is also atomic
-	autoCorrelation_sp(zeroMean.get(), acfs, n);
-	for(size_t i = 0; i < n; i++) {
-		acfs[i] /= nVar;
+	autoCorrelation_sp(zeroMean.get(), acfs, n, nSeries);
+	for(size_t j = 0; j < nSeries; j++) {
+		for(size_t i = 0; i < n; i++) {
+			acfs[j*n + i] /= nVar[j];
+		}
 	}
 }
 
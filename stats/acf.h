@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/acf.h
  * @author Krzysztof Findeisen
  * @date Created May 7, 2013
- * @date Last modified May 7, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -37,11 +37,23 @@ namespace lcmc { namespace stats {
  */
 void autoCorrelation_sp(const double data[], double acfs[], size_t n);
 
+/** This function computes the lag-@p n autocorrelations of several 
+ *	datasets at once, using the signal-processing convention.
+ */
+void autoCorrelation_sp(const double data[], double acfs[], size_t n, 
+		size_t nSeries);
+
 /** This function computes the lag-@p n autocorrelation of the dataset @p data, 
  * 	using the statistical analysis convention.
  */
 void autoCorrelation_stat(const double data[], double acfs[], size_t n);
 
+/** This function computes the lag-@p n autocorrelations of several 
+ *	datasets at once, using the statistical analysis convention.
+ */
+void autoCorrelation_stat(const double data[], double acfs[], size_t n, 
+		size_t nSeries);
+
 }}		// end lcmc::stats
 
 #endif		// LCMCACFH
@@ -2,14 +2,17 @@
  * @file lightcurveMC/stats/acfdriver.cpp
  * @author Krzysztof Findeisen
  * @date Created June 8, 2013
- * @date Last modified August 5, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <algorithm>
+#include <functional>
 #include <vector>
 #include <boost/lexical_cast.hpp>
 #include <timescales/timescales.h>
+#include "acfinterp.h"
 #include "cut.tmp.h"
+#include "scratch.h"
 #include "statcollect.h"
 #include "statfamilies.h"
 #include "../except/undefined.h"
@@ -19,12 +22,70 @@ namespace lcmc { namespace stats {
 using boost::lexical_cast;
 using std::vector;
 
+/** Regular grid at which ACF offsets are generated */
+const static double offStep = 0.1;
+
+/** Lists the lags at which doAcf() calculates the ACF of a light curve
+ *
+ * @param[in] lc The light curve to analyze.
+ * @param[out] offsets The lags, starting at zero and spaced by offStep, 
+ *	up to the baseline of @p lc.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the lags.
+ *
+ * @exceptsafe @p offsets is in a valid state in the event of an exception.
+ */
+void acfOffsets(const AnalysisContext& lc, DoubleVec& offsets) {
+	offsets.clear();
+	double maxOffset = lc.getBaseline();
+	for (double t = 0.0; t < maxOffset; t += offStep) {
+		offsets.push_back(t);
+	}
+}
+
+/** Selects logarithmically spaced elements of a grid
+ *
+ * @param[in] grid The grid to sample, in ascending order.
+ * @param[in] factor The minimum ratio between two selected elements.
+ * @param[out] indices The positions in @p grid of the selected elements.
+ *
+ * @pre @p grid is not empty
+ * @pre @p factor &gt; 1
+ *
+ * @post @p indices starts with 0, and thereafter contains each 
+ *	position whose value is at least @p factor times that of the 
+ *	previous position selected.
+ *
+ * @perform O(N) time, where N = @p grid.size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the indices.
+ *
+ * @exceptsafe @p indices is unchanged in the event of an exception.
+ */
+void logSpacedIndices(const DoubleVec& grid, double factor, 
+		vector<size_t>& indices) {
+	vector<size_t> temp(1, 0);
+	double lastValue = grid.front();
+	for (size_t i = 1; i < grid.size(); i++) {
+		if (grid[i] >= factor*lastValue) {
+			temp.push_back(i);
+			lastValue = grid[i];
+		}
+		// else skip
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	indices.swap(temp);
+}
+
 /** Does all ACF-related computations for a given light curve.
  *
  * The flavor of ACF is specified using a callback function.
  *
- * @param[in] times The times at which the light curve was sampled.
- * @param[in] data The values of the light curve
+ * @param[in] lc The light curve to analyze.
  * @param[in] acfFunc Function for calculating the autocorrelation function. 
  *	@p acfFunc takes, in order, the times of the light curve, the values 
  *	of the light curve, the time step between lag values, the number of 
@@ -39,10 +100,14 @@ using std::vector;
  * @param[out] cut2 The NamedCollection in which to record the 
  *	time offset at which the ACF crosses 1/2.
  * @param[out] acfPlot The NamedCollection in which to record the ACF.
+ * @param[in] lagFunc Optional function for calculating the 
+ *	autocorrelation function at only some lags, used instead of 
+ *	@p acfFunc if not NULL. @p lagFunc takes the same arguments as 
+ *	@p acfFunc, except that the output vector is preceded by the 
+ *	positions of the lags that are stored and a level; it must also 
+ *	calculate the ACF at every lag up to the first one below that 
+ *	level, and may set the ACF at all other lags to NaN.
  *
- * @pre @p times.size() = @p data.size()
- * @pre Neither @p times nor @p data may contain NaNs
- * 
  * @post if @p getCut, then new elements are appended to @p cut9, 
  *	@p cut4, and @p cut2. If any of the cuts are 
  *	undefined, NaN is appended to the corresponding collection.
@@ -50,109 +115,179 @@ using std::vector;
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	store more statistics.
- * @exception std::invalid_argument Thrown if @p times and @p data do not 
- *	have matching lengths or if @p times or @p data contains NaNs.
- * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
- *	and @p data are too short to calculate the desired statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate the desired statistics.
  *
  * @note Additional exceptions may be thrown by @p acfFunc.
  *
- * @exceptsafe The program is in a consistent state in the event of an 
+ * @exceptsafe The collections are unchanged in the event of an 
  *	exception, provided @p acfFunc offers at least the basic exception 
  *	guarantee.
  */
-void doAcf(const vector<double>& times, const vector<double>& data, 
+void doAcf(const AnalysisContext& lc, 
 		void (*acfFunc) (const vector<double>&, const vector<double>&, 
 				double, size_t, vector<double>&), 
 		bool getCut, bool getPlot, 
 		CollectedScalars& cut9, CollectedScalars& cut4, CollectedScalars& cut2, 
-		CollectedPairs& acfPlot) {
-
-	if (times.size() != data.size()) {
-		throw std::invalid_argument("Times and data must have the same length in analyzeLightCurve() (gave " 
-			+ lexical_cast<string>(times.size()) + " for times and " 
-			+ lexical_cast<string>( data.size()) + " for data).");
-	}
+		CollectedPairs& acfPlot, 
+		void (*lagFunc) (const vector<double>&, const vector<double>&, 
+				double, size_t, const vector<size_t>&, double, 
+				vector<double>&)) {
+	const vector<double>& times = lc.getTimes();
+	const vector<double>& data = lc.getMags();
 
 	if (getCut || getPlot) {
-		// copy-and-swap
-		CollectedScalars temp9    = cut9;
-		CollectedScalars temp4    = cut4;
-		CollectedScalars temp2    = cut2;
-		CollectedPairs   tempPlot = acfPlot;
+		// Checkpoints let us undo a partial update without copying 
+		//	the statistics from all previous light curves
+		const CollectedScalars::Checkpoint mark9    = cut9   .checkpoint();
+		const CollectedScalars::Checkpoint mark4    = cut4   .checkpoint();
+		const CollectedScalars::Checkpoint mark2    = cut2   .checkpoint();
+		const size_t markPlot = acfPlot.checkpoint();
 		
 		try {
-			// Regular grid at which offsets are generated
-			const static double offStep = 0.1;
-			// Minimum difference between two offsets written to a log file
-			const static double storeFactor = 1.05;
-			
-			double maxOffset = kpftimes::deltaT(times);
-			DoubleVec offsets;
-			for (double t = 0.0; t < maxOffset; t += offStep) {
-				offsets.push_back(t);
-			}
-			
-			DoubleVec acf;
-			acfFunc(times, data, offStep, offsets.size(), acf);
-			
-			if (getPlot) {
+			try {
+				// Minimum difference between two offsets written to a log file
+				const static double storeFactor = 1.05;
+				
+				ScratchVector offsetBuffer;
+				DoubleVec& offsets = offsetBuffer.get();
+				acfOffsets(lc, offsets);
+				
 				// Record only logarithmically spaced bins, for compactness
-				/** @todo Reimplement using an iterator adapter for faster performance
-				 */
-				DoubleVec logOffs(1, offsets.front());
-				DoubleVec logAcf (1,     acf.front());
-				double lastOffset = offsets.front();
-				for (size_t i = 1; i < offsets.size(); i++) {
-					if (offsets[i] >= storeFactor*lastOffset) {
-						logOffs.push_back(offsets[i]);
-						logAcf .push_back(    acf[i]);
-						
-						lastOffset = offsets[i];
+				// The bins are copied straight from offsets and acf
+				vector<size_t> logBins;
+				if (!offsets.empty()) {
+					logSpacedIndices(offsets, storeFactor, logBins);
+				}
+				DoubleVec levels;
+				levels.push_back(1.0/9.0);
+				levels.push_back(0.25);
+				levels.push_back(0.5);
+				
+				// The cuts need only the lags up to the first one 
+				//	below the lowest level, and the plot only 
+				//	logBins, so lagFunc may skip all other lags
+				// An ACF computed in a batch is used as is
+				ScratchVector acfBuffer;
+				const DoubleVec* recorded = (lagFunc == NULL 
+					? lc.findAcf(acfFunc, offStep, offsets.size()) 
+					: NULL);
+				if (recorded == NULL) {
+					DoubleVec& computed = acfBuffer.get();
+					if (lagFunc != NULL) {
+						lagFunc(times, data, offStep, offsets.size(), logBins, 
+							(getCut ? levels.front() : -1.0), computed);
+					} else {
+						acfFunc(times, data, offStep, offsets.size(), computed);
 					}
-					// else skip
+					recorded = &computed;
 				}
-								
-				tempPlot.addStat(logOffs, logAcf);
-			}
-			
-			if (getCut) {
-				// Key cuts
-				temp9.addStat(cutFunction(offsets, acf, 
-					LessThan(1.0/9.0)));
-				temp4.addStat(cutFunction(offsets, acf, 
-					LessThan(0.25)   ));
-				temp2.addStat(cutFunction(offsets, acf, 
-					LessThan(0.5)    ));
+				const DoubleVec& acf = *recorded;
+				
+				if (getPlot) {
+					acfPlot.addStat(offsets, acf, logBins);
+				}
+				
+				if (getCut) {
+					// Key cuts, found in one pass over the ACF
+					// NaNs never pass a cut, and lagFunc leaves 
+					//	none before the last one
+					DoubleVec cuts;
+					cutFunctions(offsets, acf, levels, 
+						std::less<double>(), cuts);
+					cut9.addStat(cuts[0]);
+					cut4.addStat(cuts[1]);
+					cut2.addStat(cuts[2]);
+				}
+			} catch (const except::NotEnoughData &e) {
+				// The one kind of Undefined we don't want to ignore
+				throw;
+			} catch (const except::Undefined &e) {
+				// Don't know how many of the collections were updated... revert to input
+				cut9   .rollback(mark9   );
+				cut4   .rollback(mark4   );
+				cut2   .rollback(mark2   );
+				acfPlot.rollback(markPlot);
+				
+				// May still throw bad_alloc
+				if (getCut) {
+					cut9.addNull();
+					cut4.addNull();
+					cut2.addNull();
+				}
+//				if (getPlot) {
+//					acfPlot.addNull();
+//				}
 			}
-		} catch (const except::NotEnoughData &e) {
-			// The one kind of Undefined we don't want to ignore
+		} catch (...) {
+			// Leave the collections as they were before the call
+			cut9   .rollback(mark9   );
+			cut4   .rollback(mark4   );
+			cut2   .rollback(mark2   );
+			acfPlot.rollback(markPlot);
 			throw;
-		} catch (const except::Undefined &e) {
-			// Don't know how many of the collections were updated... revert to input
-			temp9    = cut9;
-			temp4    = cut4;
-			temp2    = cut2;
-			tempPlot = acfPlot;
-			
-			// May still throw bad_alloc
-			if (getCut) {
-				temp9.addNull();
-				temp4.addNull();
-				temp2.addNull();
-			}
-//			if (getPlot) {
-//				tempPlot.addNull();
-//			}
 		}
-		
-		// IMPORTANT: no exceptions beyond this point
+	}
+}
 
-		using std::swap;		
-		swap(cut9   , temp9);
-		swap(cut4   , temp4);
-		swap(cut2   , temp2);
-		swap(acfPlot, tempPlot);
+/** Computes the interpolated ACFs of several light curves together, 
+ *	and records them in each light curve.
+ *
+ * @param[in,out] members The light curves to analyze.
+ *
+ * @pre All elements of @p members have the same times.
+ * @pre No element of @p members is shared with another thread.
+ *
+ * @post If the light curves are long enough to have an ACF, 
+ *	AnalysisContext::findAcf() returns, for each element of @p members, 
+ *	the ACF doAcf() would calculate with interp::autoCorr(). Otherwise, 
+ *	@p members is unchanged, and doAcf() reports the problem when 
+ *	each light curve is analyzed.
+ *
+ * @perform O(K N + K F log F) time, where K = @p members.size(), 
+ *	N is the number of times, and F the number of lags.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the ACFs.
+ * @exception std::runtime_error Thrown if the internal calculations 
+ *	produce an error.
+ *
+ * @exceptsafe Each element of @p members is unchanged in the event 
+ *	of an exception.
+ */
+void batchInterpAcfs(const vector<AnalysisContext*>& members) {
+	if (members.empty()) {
+		return;
+	}
+	
+	DoubleVec offsets;
+	acfOffsets(*members.front(), offsets);
+	if (offsets.empty()) {
+		// Reported as NotEnoughData when each light curve is analyzed
+		return;
+	}
+	
+	vector<DoubleVec> data;
+	data.reserve(members.size());
+	for(size_t k = 0; k < members.size(); k++) {
+		data.push_back(members[k]->getMags());
+	}
+	
+	vector<DoubleVec> acfs;
+	try {
+		interp::autoCorr(members.front()->getTimes(), data, offStep, 
+			offsets.size(), acfs);
+	} catch (const except::Undefined& e) {
+		// Reported when each light curve is analyzed
+		return;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	// The single-series function is the one doAcf() is given
+	const AcfFunction single = static_cast<AcfFunction>(&interp::autoCorr);
+	for(size_t k = 0; k < members.size(); k++) {
+		members[k]->setAcf(single, offStep, acfs[k]);
 	}
 }
 
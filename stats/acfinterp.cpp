@@ -3,7 +3,7 @@
  * @author Ann Marie Cody
  * @author Krzysztof Findeisen
  * @date Created May 6, 2013
- * @date Last modified May 26, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -29,19 +29,19 @@
  */
 
 #include <algorithm>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <cmath>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
-#include <gsl/gsl_spline.h>
+#include <boost/thread/mutex.hpp>
+#include "../cachestats.h"
 #include "acfinterp.h"
-#include "../gsl_compat.h"
 #include "../nan.h"
 #include "../except/nan.h"
 #include "../except/undefined.h"
 #include "../../common/vecarray.tmp.h"
-#include "../../common/alloc.tmp.h"
 
 #ifndef _GSL_HAS_ACF
 #include "acf.h"
@@ -103,6 +103,196 @@ void evenGrid(double min, double max, double step, shared_array<double>& grid, s
 	}
 }
 
+namespace {
+
+/** Linear interpolation from a fixed set of times onto an even grid
+ *
+ * Interpolating data onto the grid is a sparse linear operation with 
+ * two nonzero weights per grid point. For a fixed cadence, the plan 
+ * stores the bracketing observations of each grid point, so that 
+ * interpolating a light curve costs one pass with no searches.
+ *
+ * Plans are immutable once created, and may be shared between threads.
+ */
+class InterpPlan {
+public:
+	/** Finds the observations bracketing each grid point
+	 *
+	 * @param[in] times The times of the observations.
+	 * @param[in] deltaT The spacing of the grid.
+	 *
+	 * @pre @p times contains at least two values
+	 * @pre @p deltaT > 0
+	 *
+	 * @post The grid runs from min(@p times) to just before 
+	 *	max(@p times), as given by evenGrid().
+	 *
+	 * @perform O(N + F) time, where N = @p times.size() and F is the 
+	 *	number of grid points
+	 *
+	 * @exception std::runtime_error Thrown if @p times is not 
+	 *	strictly increasing.
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	for the plan.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	InterpPlan(const DoubleVec& times, double deltaT) : times(times), 
+			deltaT(deltaT), lows(), weights() {
+		for (size_t i = 1; i < times.size(); i++) {
+			if (!(times[i] > times[i-1])) {
+				throw std::runtime_error("While computing ACF: x values must be strictly increasing");
+			}
+		}
+		
+		shared_array<double> grid;
+		size_t nGrid;
+		evenGrid(times.front(), times.back(), deltaT, grid, nGrid);
+		
+		lows   .reserve(nGrid);
+		weights.reserve(nGrid);
+		// Grid points are increasing, so the bracket only moves forward
+		size_t low = 0;
+		for (size_t i = 0; i < nGrid; i++) {
+			if (grid[i] > times.back()) {
+				throw std::runtime_error("While computing ACF: interpolation error");
+			}
+			while (low + 2 < times.size() && times[low+1] <= grid[i]) {
+				low++;
+			}
+			lows   .push_back(low);
+			// Same operation order as gsl_interp_linear, for identical 
+			//	rounding
+			weights.push_back((grid[i] - times[low]) / (times[low+1] - times[low]));
+		}
+	}
+	
+	/** Returns a plan for a cadence, reusing the last plan if possible
+	 *
+	 * @param[in] times The times of the observations.
+	 * @param[in] deltaT The spacing of the grid.
+	 *
+	 * @return A plan for @p times and @p deltaT. If the previous call 
+	 *	had the same arguments, its plan is returned again.
+	 *
+	 * @pre @p times contains at least two values
+	 * @pre @p deltaT > 0
+	 *
+	 * @exception std::runtime_error Thrown if @p times is not 
+	 *	strictly increasing.
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	for a new plan.
+	 *
+	 * @exceptsafe The cache is unchanged in the event of an exception.
+	 */
+	static shared_ptr<const InterpPlan> forCadence(const DoubleVec& times, 
+			double deltaT) {
+		static boost::mutex cacheLock;
+		static shared_ptr<const InterpPlan> cache;
+		static utils::CacheCounter counter("Interpolated ACF plans");
+		
+		{
+			boost::mutex::scoped_lock guard(cacheLock);
+			if (cache.get() != NULL && cache->deltaT == deltaT 
+					&& cache->times == times) {
+				counter.hit();
+				return cache;
+			}
+		}
+		
+		const utils::CacheMiss miss(counter);
+		
+		// Don't hold the lock while building the plan, so that threads
+		//	working on other cadences are not blocked
+		shared_ptr<const InterpPlan> plan(new InterpPlan(times, deltaT));
+		
+		{
+			boost::mutex::scoped_lock guard(cacheLock);
+			cache = plan;
+		}
+		return plan;
+	}
+	
+	/** Returns the number of grid points
+	 *
+	 * @return The length of the interpolated data.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	size_t size() const {
+		return lows.size();
+	}
+	
+	/** Interpolates data onto the grid
+	 *
+	 * @param[in] data The value measured at each time of the plan.
+	 * @param[out] gridData An array of size() values, in which to store 
+	 *	@p data interpolated to each grid point.
+	 *
+	 * @pre @p data.size() equals the number of times in the plan
+	 *
+	 * @post The values are the same as those of gsl_interp_linear.
+	 *
+	 * @perform O(F) time, where F = size()
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void apply(const DoubleVec& data, double gridData[]) const {
+		const size_t n = lows.size();
+		for (size_t i = 0; i < n; i++) {
+			const double low = data[lows[i]];
+			gridData[i] = low + weights[i] * (data[lows[i]+1] - low);
+		}
+	}
+	
+private:
+	DoubleVec times;
+	double deltaT;
+	
+	/** The observation before each grid point */
+	vector<size_t> lows;
+	/** The weight of the observation after each grid point */
+	DoubleVec weights;
+};
+
+/** Checks the arguments common to all ACF calculations
+ *
+ * @param[in] times	Times at which data were taken
+ * @param[in] nData	The number of measurements in a time series
+ * @param[in] deltaT, nAcf The spacing and number of grid points over which 
+ *			the ACF should be calculated.
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times does 
+ *	not have at least two values. 
+ * @exception std::invalid_argument Thrown if @p times and @p nData 
+ *	do not match or if @p deltaT or @p nAcf are not positive.
+ *
+ * @exceptsafe Does not throw exceptions unless the arguments are invalid.
+ */
+void checkAcfArgs(const DoubleVec &times, size_t nData, double deltaT, size_t nAcf) {
+	const size_t NOLD = times.size();
+	if (NOLD < 2) {
+		throw except::NotEnoughData("Cannot calculate autocorrelation function with fewer than 2 data points (gave " 
+			+ lexical_cast<string>(NOLD) + ").");
+	}
+	if (NOLD != nData) {
+		throw std::invalid_argument("Data and time arrays passed to autoCorr() must have the same length (gave " 
+			+ lexical_cast<string>(NOLD) + " for times and " 
+			+ lexical_cast<string>(nData) + " for data)");
+	}
+	if (deltaT <= 0) {
+		throw std::invalid_argument("Need a positive time lag to construct an autocorrelation grid (gave " 
+			+ lexical_cast<string>(deltaT) + ")");
+	}
+	if (nAcf <= 0) {
+		throw std::invalid_argument("Must calculate autocorrelation function at a positive number of points " 
+			+ lexical_cast<string>(nAcf) + ")");
+	}
+}
+
+}		// end unnamed namespace
+
+
 
 /** Calculates the autocorrelation function for a time series. 
  * 
@@ -149,51 +339,16 @@ void evenGrid(double min, double max, double step, shared_array<double>& grid, s
 void autoCorr(const DoubleVec &times, const DoubleVec &data, 
 		double deltaT, size_t nAcf, DoubleVec &acf) {
 	using std::swap;
-	using kpfutils::checkAlloc;
 
-	const size_t NOLD = times.size();
-	if (NOLD < 2) {
-		throw except::NotEnoughData("Cannot calculate autocorrelation function with fewer than 2 data points (gave " 
-			+ lexical_cast<string>(NOLD) + ").");
-	}
-	if (NOLD != data.size()) {
-		throw std::invalid_argument("Data and time arrays passed to autoCorr() must have the same length (gave " 
-			+ lexical_cast<string>(NOLD) + " for times and " 
-			+ lexical_cast<string>(data.size()) + " for data)");
-	}
-	if (deltaT <= 0) {
-		throw std::invalid_argument("Need a positive time lag to construct an autocorrelation grid (gave " 
-			+ lexical_cast<string>(deltaT) + ")");
-	}
-	if (nAcf <= 0) {
-		throw std::invalid_argument("Must calculate autocorrelation function at a positive number of points " 
-			+ lexical_cast<string>(nAcf) + ")");
-	}
+	checkAcfArgs(times, data.size(), deltaT, nAcf);
 
-	// In C++11, can directly return an array view of times and data
-	// For now, make a copy
-	shared_array<double> tempTimes = kpfutils::vecToArr(times);
-	shared_array<double> tempData  = kpfutils::vecToArr(data );
-	
-	// Generate a grid with spacing deltaT
-	shared_array<double> evenTimes;
-	size_t nNew;
-	evenGrid(times.front(), times.back(), deltaT, evenTimes, nNew);
-
-	// Interpolate to the new grid
-	// Despite its name, gsl_spline is not necessarily a spline
-	shared_ptr<gsl_spline> interp(checkAlloc(gsl_spline_alloc(gsl_interp_linear, NOLD)), 
-		          &gsl_spline_free);
-	shared_ptr<gsl_interp_accel> interpTable(checkAlloc(gsl_interp_accel_alloc()), 
-		&gsl_interp_accel_free);
-	gslCheck( gsl_spline_init(interp.get(), tempTimes.get(), tempData.get(), NOLD), 
-			"While computing ACF: ");
+	// Linearly interpolate to a grid with spacing deltaT
+	// The grid and interpolation weights depend only on the cadence
+	const shared_ptr<const InterpPlan> plan = InterpPlan::forCadence(times, deltaT);
+	const size_t nNew = plan->size();
 	
 	scoped_array<double> evenData(new double[nNew]);
-	for(size_t i = 0; i < nNew; i++) {
-		gslCheck( gsl_spline_eval_e(interp.get(), evenTimes[i], 
-			interpTable.get(), evenData.get()+i), "While computing ACF: ");
-	}
+	plan->apply(data, evenData.get());
 
 	// ACF
 	scoped_array<double> tempAcfs(new double[nNew]);
@@ -215,4 +370,90 @@ void autoCorr(const DoubleVec &times, const DoubleVec &data,
 	swap(acf, temp);
 }
 
+/** Calculates the autocorrelation functions of several time series 
+ *	sharing a cadence. 
+ * 
+ * All the series are interpolated into a single block and 
+ * autocorrelated together, which is faster than calling 
+ * autoCorr(const DoubleVec&, const DoubleVec&, double, size_t, DoubleVec&) 
+ * once per series.
+ * 
+ * @param[in] times	Times at which data were taken
+ * @param[in] data	The time series, each measured at every time 
+ *			in @p times
+ * @param[in] deltaT, nAcf The spacing and number of grid points over which 
+ *			the ACF should be calculated. The grid will run from 
+ *			lags of 0 to (<tt>nAcf</tt>-1)*<tt>deltaT</tt>.
+ * @param[out] acfs	The autocorrelation function of each element 
+ *			of @p data.
+ *
+ * @pre @p data is not empty
+ * @pre Each element of @p data satisfies the preconditions of 
+ *	autoCorr(const DoubleVec&, const DoubleVec&, double, size_t, DoubleVec&)
+ *
+ * @post the data previously in @p acfs are erased
+ * @post @p acfs.size() = @p data.size(), and @p acfs[j] is the value 
+ *	autoCorr(const DoubleVec&, const DoubleVec&, double, size_t, DoubleVec&) 
+ *	gives for @p data[j]
+ *
+ * @perform O(K F log F) time, where K = @p data.size() and 
+ *	F = ceil((max(@p times)-min(@p times))/<tt>deltaT</tt>)
+ * 
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times and 
+ *	the elements of @p data do not have at least two values. 
+ * @exception std::invalid_argument Thrown if @p data is empty, if 
+ *	@p times and any element of @p data do not have the same length, 
+ *	or if @p deltaT or @p nAcf are not positive.
+ * @exception std::runtime_error Thrown if the internal calculations produce an error.
+ * @exception std::bad_alloc Thrown if there is not enough memory to compute 
+ *	the autocorrelation functions
+ *
+ * @exceptsafe The function parameters are unchanged in the event of 
+ *	an exception.
+ */
+void autoCorr(const DoubleVec &times, const vector<DoubleVec> &data, 
+		double deltaT, size_t nAcf, vector<DoubleVec> &acfs) {
+	using std::swap;
+
+	const size_t nSeries = data.size();
+	if (nSeries < 1) {
+		throw std::invalid_argument("Need at least one time series to compute autocorrelation functions.");
+	}
+	for(size_t j = 0; j < nSeries; j++) {
+		checkAcfArgs(times, data[j].size(), deltaT, nAcf);
+	}
+
+	// Linearly interpolate all series into one block, one after another
+	const shared_ptr<const InterpPlan> plan = InterpPlan::forCadence(times, deltaT);
+	const size_t nNew = plan->size();
+	
+	scoped_array<double> evenData(new double[nNew * nSeries]);
+	for(size_t j = 0; j < nSeries; j++) {
+		plan->apply(data[j], evenData.get() + j*nNew);
+	}
+
+	// ACF
+	scoped_array<double> tempAcfs(new double[nNew * nSeries]);
+	#ifdef _GSL_HAS_ACF
+	Unknown specification. Please update this when GSL ACF available.
+	#else
+	autoCorrelation_stat(evenData.get(), tempAcfs.get(), nNew, nSeries);
+	#endif
+	
+	// Convert to vectors and trim off lags longer than (nAcf-1)*deltaT
+	vector<DoubleVec> temp(nSeries);
+	for(size_t j = 0; j < nSeries; j++) {
+		const double* const series = tempAcfs.get() + j*nNew;
+		temp[j].reserve(nAcf);
+		temp[j].assign(series, series + std::min(nAcf, nNew));
+		if (nNew < nAcf) {
+			temp[j].insert(temp[j].end(), nAcf-nNew, 0.0);
+		}
+	}
+
+	// IMPORTANT: no exceptions past this point
+	
+	swap(acfs, temp);
+}
+
 }}}		// end lcmc::stats::interp
@@ -3,7 +3,7 @@
  * @author Ann Marie Cody
  * @author Krzysztof Findeisen
  * @date Created May 6, 2013
- * @date Last modified May 7, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -47,6 +47,12 @@ namespace interp {
 void autoCorr(const DoubleVec &times, const DoubleVec &data, 
 		double deltaT, size_t nAcf, DoubleVec &acf);
 
+/** Calculates the autocorrelation functions of several time series 
+ *	sharing a cadence. 
+ */
+void autoCorr(const DoubleVec &times, const std::vector<DoubleVec> &data, 
+		double deltaT, size_t nAcf, std::vector<DoubleVec> &acfs);
+
 }		// end lcmc::stats::interp
 
 }}		// end lcmc::stats
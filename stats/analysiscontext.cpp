@@ -0,0 +1,340 @@
+/** Intermediate results shared by the statistics of one light curve
+ * @file lightcurveMC/stats/analysiscontext.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+#include <timescales/timescales.h>
+#include "../fluxmag.h"
+#include "analysiscontext.h"
+#include "lsplan.h"
+#include "magdist.h"
+#include "../nan.h"
+
+namespace lcmc { namespace stats {
+
+using std::string;
+using std::vector;
+using boost::lexical_cast;
+
+/** Prepares a light curve for analysis
+ *
+ * @param[in] times The time stamps of the observations.
+ * @param[in] fluxes The flux measured at each time, in the same order 
+ *	as <tt>times.timeView()</tt>. May contain NaNs.
+ * @param[in] units Whether @p fluxes holds fluxes or magnitudes. 
+ *	Magnitudes are used as given.
+ *
+ * @post getTimes() and getMags() contain the times and magnitudes of
+ *	the elements of @p fluxes that are not NaN, in their original order.
+ * @post If @p fluxes contains no NaNs, getCadence() shares its times 
+ *	with @p times.
+ *
+ * @perform O(N) time, where N = @p times.size()
+ *
+ * @exception std::invalid_argument Thrown if @p times and @p fluxes
+ *	do not have the same length.
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	store the light curve.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+AnalysisContext::AnalysisContext(const models::Cadence& times,
+		const vector<double>& fluxes, utils::PhotUnits units) 
+		: times(), mags(), cacheLock(),
+		hasRanked(false), rankedMags(), hasAmplitude(false), amplitude(0.0),
+		hasBaseline(false), baseline(0.0), powerPlan(), power(), 
+		hasGpFit(false), gpTime(0.0), gpError(0.0), 
+		acfFunc(NULL), acfStep(0.0), acf() {
+	if (times.size() != fluxes.size()) {
+		throw std::invalid_argument("Times and fluxes must have the same length in analyzeLightCurve() (gave "
+			+ lexical_cast<string>(times.size()) + " for times and "
+			+ lexical_cast<string>(fluxes.size()) + " for fluxes).");
+	}
+
+	vector<double> validTimes;
+	if (units == utils::MAG_UNITS) {
+		utils::removeNans(fluxes, this->mags, times.timeView(), validTimes);
+	} else {
+		utils::fluxToValidMags(times.timeView(), fluxes, validTimes, this->mags);
+	}
+	
+	// Keep sharing the trial's cadence, so that caches keyed on it 
+	//	still recognize it
+	// Removing NaNs from sorted times leaves them sorted
+	if (validTimes.size() == times.size()) {
+		this->times = times;
+	} else {
+		this->times = models::Cadence(validTimes, models::SortedTimes());
+	}
+}
+
+/** Returns the times of the valid observations
+ *
+ * @return The times at which the light curve has a magnitude, in
+ *	their original order.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const vector<double>& AnalysisContext::getTimes() const {
+	return times.timeView();
+}
+
+/** Returns the cadence of the valid observations
+ *
+ * @return The times at which the light curve has a magnitude, in 
+ *	ascending order.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const models::Cadence& AnalysisContext::getCadence() const {
+	return times;
+}
+
+/** Returns the magnitudes of the valid observations
+ *
+ * @return The magnitude at each element of getTimes().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const vector<double>& AnalysisContext::getMags() const {
+	return mags;
+}
+
+/** Returns the magnitudes of the valid observations, with 
+ *	their percentiles in place
+ *
+ * @return A copy of getMags() arranged by selectPercentiles(), which 
+ *	may be passed to tryC1Sorted() and getAmplitudeSorted().
+ *
+ * @perform O(N) expected time on the first call, where 
+ *	N = getMags().size(), and constant time afterward.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	copy the magnitudes.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const vector<double>& AnalysisContext::getRankedMags() const {
+	boost::mutex::scoped_lock guard(cacheLock);
+	if (!hasRanked) {
+		vector<double> temp(mags);
+		// Only the percentiles are read, so a full sort is not needed
+		selectPercentiles(temp);
+
+		// IMPORTANT: no exceptions beyond this point
+
+		rankedMags.swap(temp);
+		hasRanked = true;
+	}
+	return rankedMags;
+}
+
+/** Returns the light curve amplitude
+ *
+ * @return The same value as <tt>getAmplitude(getMags())</tt>.
+ *
+ * @perform O(N) expected time on the first call, where 
+ *	N = getMags().size(), and constant time afterward.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	calculate the amplitude.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if there are
+ *	fewer than two valid observations.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+double AnalysisContext::getAmplitude() const {
+	// Don't hold cacheLock while calling another method that takes it
+	const vector<double>& ranked = getRankedMags();
+
+	boost::mutex::scoped_lock guard(cacheLock);
+	if (!hasAmplitude) {
+		amplitude    = getAmplitudeSorted(ranked);
+		hasAmplitude = true;
+	}
+	return amplitude;
+}
+
+/** Returns the time between the first and last valid observations
+ *
+ * @return The same value as <tt>kpftimes::deltaT(getTimes())</tt>.
+ *
+ * @perform O(N) time on the first call, where N = getTimes().size(),
+ *	and constant time afterward.
+ *
+ * @note Any exception thrown by kpftimes::deltaT() is propagated
+ *	unchanged. The baseline is not remembered if an exception is thrown.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+double AnalysisContext::getBaseline() const {
+	boost::mutex::scoped_lock guard(cacheLock);
+	if (!hasBaseline) {
+		baseline    = kpftimes::deltaT(times.timeView());
+		hasBaseline = true;
+	}
+	return baseline;
+}
+
+/** Records a periodogram of the light curve computed elsewhere
+ *
+ * Periodograms of several light curves can be computed together (see 
+ * PeriodogramPlan::lombScargleBatch()) more cheaply than one at a 
+ * time. Recording the result lets the periodogram statistics use it 
+ * instead of computing it again.
+ *
+ * @param[in] plan The plan with which the periodogram was computed.
+ * @param[in,out] power The periodogram of getMags(). Its contents are 
+ *	moved into the object, leaving @p power in an unspecified state.
+ *
+ * @pre <tt>plan->getTimes()</tt> = getTimes()
+ *
+ * @post findPeriodogram(*plan) returns the periodogram.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. The periodogram must be recorded before the 
+ *	context is shared with other threads.
+ */
+void AnalysisContext::setPeriodogram(
+		const boost::shared_ptr<const PeriodogramPlan>& plan, 
+		vector<double>& power) {
+	powerPlan = plan;
+	this->power.swap(power);
+}
+
+/** Returns the periodogram recorded by setPeriodogram(), if it was 
+ *	computed with a particular plan
+ *
+ * @param[in] plan The plan the caller would use to compute the 
+ *	periodogram.
+ *
+ * @return A pointer to the recorded periodogram, valid for the 
+ *	lifetime of the object, or null if setPeriodogram() was not 
+ *	called with @p plan or an equivalent plan.
+ *
+ * @perform Constant time if @p plan is the recorded plan, otherwise 
+ *	O(N + F) time, where N is the number of times and F the number of 
+ *	frequencies.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const vector<double>* AnalysisContext::findPeriodogram(
+		const PeriodogramPlan& plan) const {
+	if (powerPlan.get() == NULL) {
+		return NULL;
+	}
+	// Plans with the same times and method compute the same periodogram
+	const bool same = (powerPlan.get() == &plan) 
+		|| (powerPlan->getMethod() == plan.getMethod() 
+			&& powerPlan->getTimes() == plan.getTimes() 
+			&& (powerPlan->getSharedFreq() == plan.getSharedFreq() 
+				|| powerPlan->getFreq() == plan.getFreq()));
+	return (same ? &power : NULL);
+}
+
+/** Records a Gaussian process fit of the light curve computed elsewhere
+ *
+ * Fits of several light curves sampled at the same times can be done 
+ * together (see fitGaussGpBatch()) more cheaply than one at a time. 
+ * Recording the result lets doGaussFit() use it instead of fitting 
+ * the light curve again.
+ *
+ * @param[in] timescale The best-fit timescale, or NaN if the fit failed.
+ * @param[in] timeError The uncertainty on @p timescale, or NaN if the 
+ *	fit failed.
+ *
+ * @pre The fit of getMags() started from the point fitGaussGp() 
+ *	would have chosen.
+ *
+ * @post findGpFit() returns the fit.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. The fit must be recorded before the 
+ *	context is shared with other threads.
+ */
+void AnalysisContext::setGpFit(double timescale, double timeError) {
+	hasGpFit = true;
+	gpTime   = timescale;
+	gpError  = timeError;
+}
+
+/** Returns the fit recorded by setGpFit(), if any
+ *
+ * @param[out] timescale The recorded timescale, or unchanged if none 
+ *	was recorded.
+ * @param[out] timeError The recorded uncertainty, or unchanged if none 
+ *	was recorded.
+ *
+ * @return True if setGpFit() was called.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool AnalysisContext::findGpFit(double& timescale, double& timeError) const {
+	if (hasGpFit) {
+		timescale = gpTime;
+		timeError = gpError;
+	}
+	return hasGpFit;
+}
+
+/** Records an autocorrelation function of the light curve computed 
+ *	elsewhere
+ *
+ * Autocorrelation functions of several light curves can be computed 
+ * together (see interp::autoCorr()) more cheaply than one at a time. 
+ * Recording the result lets doAcf() use it instead of computing it 
+ * again.
+ *
+ * @param[in] acfFunc The function whose result @p acf is.
+ * @param[in] deltaT The spacing of the lags at which @p acf was computed.
+ * @param[in,out] acf The value <tt>acfFunc(getTimes(), getMags(), 
+ *	deltaT, acf.size(), ...)</tt> would give. Its contents are moved 
+ *	into the object, leaving @p acf in an unspecified state.
+ *
+ * @post findAcf(@p acfFunc, @p deltaT, @p acf.size()) returns the 
+ *	autocorrelation function.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. The autocorrelation function must be recorded 
+ *	before the context is shared with other threads.
+ */
+void AnalysisContext::setAcf(AcfFunction acfFunc, double deltaT, 
+		vector<double>& acf) {
+	this->acfFunc = acfFunc;
+	acfStep       = deltaT;
+	this->acf.swap(acf);
+}
+
+/** Returns the autocorrelation function recorded by setAcf(), if it 
+ *	was computed the same way
+ *
+ * @param[in] acfFunc The function the caller would use to compute the 
+ *	autocorrelation function.
+ * @param[in] deltaT, nAcf The spacing and number of lags the caller 
+ *	would request.
+ *
+ * @return A pointer to the recorded autocorrelation function, valid 
+ *	for the lifetime of the object, or null if setAcf() was not 
+ *	called with the same arguments.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const vector<double>* AnalysisContext::findAcf(AcfFunction acfFunc, 
+		double deltaT, size_t nAcf) const {
+	const bool same = (this->acfFunc != NULL && this->acfFunc == acfFunc 
+		&& acfStep == deltaT && acf.size() == nAcf);
+	return (same ? &acf : NULL);
+}
+
+}}		// end lcmc::stats
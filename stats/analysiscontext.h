@@ -0,0 +1,132 @@
+/** Intermediate results shared by the statistics of one light curve
+ * @file lightcurveMC/stats/analysiscontext.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCANALYSISCONTEXTH
+#define LCMCANALYSISCONTEXTH
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "../cadence.h"
+#include "../fluxmag.h"
+
+namespace lcmc { namespace stats {
+
+class PeriodogramPlan;
+
+/** A function computing an autocorrelation function on a regular 
+ *	grid of lags, as used by doAcf()
+ */
+typedef void (*AcfFunction) (const std::vector<double>&, 
+		const std::vector<double>&, double, size_t, std::vector<double>&);
+
+/** AnalysisContext holds a light curve being analyzed, along with any
+ * properties of it that more than one statistic needs.
+ *
+ * Each property is calculated the first time it is requested, and
+ * remembered for later requests. The object may be shared by threads
+ * calculating different statistics of the same light curve.
+ */
+class AnalysisContext {
+public:
+	/** Prepares a light curve for analysis
+	 */
+	AnalysisContext(const models::Cadence& times,
+			const std::vector<double>& fluxes, 
+			utils::PhotUnits units = utils::FLUX_UNITS);
+
+	/** Returns the times of the valid observations
+	 */
+	const std::vector<double>& getTimes() const;
+
+	/** Returns the cadence of the valid observations
+	 */
+	const models::Cadence& getCadence() const;
+
+	/** Returns the magnitudes of the valid observations
+	 */
+	const std::vector<double>& getMags() const;
+
+	/** Returns the magnitudes of the valid observations, with 
+	 *	their percentiles in place
+	 */
+	const std::vector<double>& getRankedMags() const;
+
+	/** Returns the light curve amplitude
+	 */
+	double getAmplitude() const;
+
+	/** Returns the time between the first and last valid observations
+	 */
+	double getBaseline() const;
+
+	/** Records a periodogram of the light curve computed elsewhere
+	 */
+	void setPeriodogram(const boost::shared_ptr<const PeriodogramPlan>& plan, 
+			std::vector<double>& power);
+
+	/** Returns the periodogram recorded by setPeriodogram(), if it 
+	 *	was computed with a particular plan
+	 */
+	const std::vector<double>* findPeriodogram(const PeriodogramPlan& plan) const;
+
+	/** Records a Gaussian process fit of the light curve computed 
+	 *	elsewhere
+	 */
+	void setGpFit(double timescale, double timeError);
+
+	/** Returns the fit recorded by setGpFit(), if any
+	 */
+	bool findGpFit(double& timescale, double& timeError) const;
+
+	/** Records an autocorrelation function of the light curve 
+	 *	computed elsewhere
+	 */
+	void setAcf(AcfFunction acfFunc, double deltaT, std::vector<double>& acf);
+
+	/** Returns the autocorrelation function recorded by setAcf(), if 
+	 *	it was computed the same way
+	 */
+	const std::vector<double>* findAcf(AcfFunction acfFunc, double deltaT, 
+			size_t nAcf) const;
+
+private:
+	// Contexts are shared, not copied
+	AnalysisContext(const AnalysisContext&);
+	AnalysisContext& operator=(const AnalysisContext&);
+
+	models::Cadence times;
+	std::vector<double> mags;
+
+	/** Protects the cached properties */
+	mutable boost::mutex cacheLock;
+	mutable bool hasRanked;
+	mutable std::vector<double> rankedMags;
+	mutable bool hasAmplitude;
+	mutable double amplitude;
+	mutable bool hasBaseline;
+	mutable double baseline;
+
+	/** The plan used for @ref power, or null if there is none */
+	boost::shared_ptr<const PeriodogramPlan> powerPlan;
+	std::vector<double> power;
+
+	/** True if @ref gpTime and @ref gpError were recorded */
+	bool hasGpFit;
+	double gpTime;
+	double gpError;
+
+	/** The function and lag spacing used for @ref acf, or null if 
+	 *	there is none */
+	AcfFunction acfFunc;
+	double acfStep;
+	std::vector<double> acf;
+};
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCANALYSISCONTEXTH
@@ -0,0 +1,555 @@
+/** Binary output for distributions of statistics
+ * @file lightcurveMC/stats/columns.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#include "columns.h"
+#include "raggedarray.h"
+#include "../textwriter.h"
+#include "../ziparchive.h"
+#include "../../common/cerror.h"
+
+namespace lcmc { namespace stats {
+
+using boost::lexical_cast;
+using boost::uint64_t;
+using std::string;
+using std::vector;
+
+/** Returns the format of the distribution files
+ *
+ * @return A modifiable reference to the format.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+DistribFormat& distribFormat() {
+	static DistribFormat format = DISTRIB_TEXT;
+	return format;
+}
+
+/** Chooses the file format used for the distributions of statistics
+ *
+ * @param[in] format The format to use for all distribution files 
+ *	written from now on.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any statistics are printed.
+ */
+void setDistribFormat(DistribFormat format) {
+	distribFormat() = format;
+}
+
+/** Returns the format chosen with setDistribFormat()
+ *
+ * @return The format of the distribution files. 
+ *	@ref DISTRIB_TEXT "DISTRIB_TEXT" if setDistribFormat() was never called.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+DistribFormat getDistribFormat() {
+	return distribFormat();
+}
+
+/** Returns whether text distribution files are to be compressed
+ *
+ * @return A modifiable reference to the setting.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& distribCompression() {
+	static bool compress = false;
+	return compress;
+}
+
+/** Chooses whether distribution files written as text are compressed
+ *
+ * @param[in] compress If set, text distribution files written from now 
+ *	on are compressed in gzip format. Binary files are never compressed, 
+ *	so that they can still be memory-mapped, and files in an archive 
+ *	follow the archive's own setting.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any statistics are printed.
+ */
+void setDistribCompression(bool compress) {
+	distribCompression() = compress;
+}
+
+/** Tests whether distribution files written as text are compressed
+ *
+ * @return True if setDistribCompression() asked for compression and 
+ *	the program was built with zlib, false otherwise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool getDistribCompression() {
+	return distribCompression() && utils::canCompressZip();
+}
+
+/** Replaces the extension of a file name
+ *
+ * @param[in] fileName The name to change.
+ * @param[in] extension The new extension, including the leading period.
+ *
+ * @return @p fileName, minus anything after its last period, plus 
+ *	@p extension.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string withExtension(const string& fileName, const string& extension) {
+	const size_t dot = fileName.find_last_of("./");
+	if (dot == string::npos || fileName[dot] != '.') {
+		return fileName + extension;
+	} else {
+		return fileName.substr(0, dot) + extension;
+	}
+}
+
+/** Returns the name under which a distribution file is written
+ *
+ * @param[in] distribFile The name of the distribution file, as given 
+ *	to the collection of statistics.
+ *
+ * @return @p distribFile if the distributions are written as text, 
+ *	@p distribFile plus <tt>.gz</tt> if they are written as compressed 
+ *	text, or the name of the binary data file otherwise.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string distribFileName(const string& distribFile) {
+	if (getDistribFormat() == DISTRIB_BINARY) {
+		return withExtension(distribFile, ".bin");
+	} else if (getDistribCompression() && !hasDistribArchive()) {
+		return distribFile + ".gz";
+	} else {
+		return distribFile;
+	}
+}
+
+/** Returns the archive of the distribution files
+ *
+ * @return A modifiable reference to the archive. Empty if no archive 
+ *	is open.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note The archive is finished when the program exits, if 
+ *	closeDistribArchive() is not called first.
+ */
+boost::scoped_ptr<utils::ZipArchive>& distribArchive() {
+	static boost::scoped_ptr<utils::ZipArchive> archive;
+	return archive;
+}
+
+/** Collects all distribution files written from now on into one archive
+ *
+ * @param[in] fileName The name of the archive. Any existing file with 
+ *	this name is overwritten.
+ * @param[in] compress If set, the distribution files are compressed. 
+ *	Ignored if the program was built without compression support.
+ *
+ * @post Distribution files are stored in a zip archive named 
+ *	@p fileName, rather than as separate files. Each file keeps the 
+ *	name it would otherwise have had on disk.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be opened.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the archive.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe. Call before any statistics are printed.
+ */
+void openDistribArchive(const string& fileName, bool compress) {
+	distribArchive().reset(new utils::ZipArchive(fileName, compress));
+}
+
+/** Tests whether distribution files are being collected into an archive
+ *
+ * @return True if openDistribArchive() has been called, and 
+ *	closeDistribArchive() has not.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool hasDistribArchive() {
+	return distribArchive().get() != NULL;
+}
+
+/** Adds a distribution file to the archive opened with openDistribArchive()
+ *
+ * @param[in] name The name of the distribution file.
+ * @param[in] contents The contents of the distribution file.
+ *
+ * @pre hasDistribArchive()
+ *
+ * @exception kpfutils::except::FileIo Thrown if the file could not 
+ *	be added to the archive.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	add the file.
+ *
+ * @exceptsafe The archive is in a valid state in the event of an 
+ *	exception, but its contents are unspecified.
+ *
+ * @note Not thread-safe.
+ */
+void addToDistribArchive(const string& name, const vector<char>& contents) {
+	distribArchive()->add(name, contents);
+}
+
+/** Finishes the archive opened with openDistribArchive()
+ *
+ * @post The archive lists every distribution file added to it, and 
+ *	hasDistribArchive() is false. Does nothing if no archive is open.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the archive index 
+ *	could not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	write the index.
+ *
+ * @exceptsafe hasDistribArchive() is false even in the event of an 
+ *	exception.
+ */
+void closeDistribArchive() {
+	boost::scoped_ptr<utils::ZipArchive> closing;
+	closing.swap(distribArchive());
+	if (closing.get() != NULL) {
+		closing->close();
+	}
+}
+
+/** Tests whether the program runs on a little-endian machine
+ *
+ * @return True if the least significant byte of a number is stored first.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool isLittleEndian() {
+	const uint64_t probe = 1;
+	return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+}
+
+/** Creates an empty table
+ *
+ * @param[in] fileName The name of the file in which to store the 
+ *	columns. The schema is stored in a file with the same name, but 
+ *	the extension <tt>.json</tt>. Any existing files with these names 
+ *	are overwritten.
+ *
+ * @post If hasDistribArchive(), the files are created in the archive 
+ *	when close() is called, and nothing is written to disk.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be opened.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+ColumnFile::ColumnFile(const string& fileName) : fileName(fileName), 
+		data(hasDistribArchive() ? boost::shared_ptr<FILE>() 
+			: kpfutils::fileCheckOpen(fileName, "wb")), 
+		archived(), toArchive(hasDistribArchive()), position(0), columns() {
+}
+
+/** Appends little-endian values to the data file
+ *
+ * @param[in] bytes An array of numbers, in little-endian order.
+ * @param[in] count The number of elements in @p bytes.
+ * @param[in] width The size of each element, in bytes.
+ *
+ * @return The number of values written.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	hold the values for the archive.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+size_t ColumnFile::writeRaw(const unsigned char* bytes, size_t count, 
+		size_t width) {
+	if (toArchive) {
+		archived.insert(archived.end(), bytes, bytes + width*count);
+		return count;
+	} else {
+		return fwrite(bytes, width, count, data.get());
+	}
+}
+
+/** Appends values to the data file
+ *
+ * @param[in] values An array of numbers, in the machine's byte order.
+ * @param[in] count The number of elements in @p values.
+ * @param[in] width The size of each element, in bytes.
+ *
+ * @pre 0 &lt; @p width &le; 8
+ *
+ * @post The values are stored in little-endian order.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the values could not 
+ *	be written.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ColumnFile::writeValues(const void* values, size_t count, size_t width) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(values);
+	size_t written;
+	if (isLittleEndian()) {
+		written = writeRaw(bytes, count, width);
+	} else {
+		// Byte-swap a few values at a time
+		unsigned char swapped[8*512];
+		written = 0;
+		while (written < count) {
+			const size_t chunk = std::min(count - written, static_cast<size_t>(512));
+			for(size_t i = 0; i < chunk; i++) {
+				std::reverse_copy(bytes + width*(written+i), 
+					bytes + width*(written+i+1), swapped + width*i);
+			}
+			const size_t done = writeRaw(swapped, chunk, width);
+			written += done;
+			if (done < chunk) {
+				break;
+			}
+		}
+	}
+	if (written != count) {
+		kpfutils::fileError(data.get(), "Could not write to file '" 
+			+ fileName + "': ");
+	}
+	position += width*static_cast<uint64_t>(count);
+}
+
+/** Records a column in the schema
+ *
+ * @param[in] name The name of the column.
+ * @param[in] type The name of the column's type in the schema.
+ * @param[in] count The number of values in the column.
+ * @param[in] width The size of each value, in bytes.
+ *
+ * @pre The column's values are the last @p count values written to 
+ *	the data file.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	record the column.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void ColumnFile::addSchema(const string& name, const char* type, size_t count, 
+		size_t width) {
+	columns.push_back(ColumnInfo(name, type, 
+		position - width*static_cast<uint64_t>(count), count));
+}
+
+/** Appends a column of numbers
+ *
+ * @param[in] name The name of the column.
+ * @param[in] values The values to store, as 64-bit floating point numbers.
+ *
+ * @pre close() has not been called
+ *
+ * @exception kpfutils::except::FileIo Thrown if the column could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	record the column.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ColumnFile::addColumn(const string& name, const vector<double>& values) {
+	// &values[0] is not defined for an empty vector
+	if (!values.empty()) {
+		writeValues(&values[0], values.size(), sizeof(double));
+	}
+	addSchema(name, "float64", values.size(), sizeof(double));
+}
+
+/** Appends a column of indices
+ *
+ * @param[in] name The name of the column.
+ * @param[in] values The values to store, as 64-bit unsigned integers.
+ *
+ * @pre close() has not been called
+ *
+ * @exception kpfutils::except::FileIo Thrown if the column could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	record the column.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ColumnFile::addColumn(const string& name, const vector<size_t>& values) {
+	// size_t need not be 64 bits wide
+	const vector<uint64_t> wide(values.begin(), values.end());
+	if (!wide.empty()) {
+		writeValues(&wide[0], wide.size(), sizeof(uint64_t));
+	}
+	addSchema(name, "uint64", wide.size(), sizeof(uint64_t));
+}
+
+/** Appends a column of variable-length rows
+ *
+ * @param[in] name The name of the column. The offsets of the rows are 
+ *	stored in a column named @p name followed by <tt>_offsets</tt>.
+ * @param[in] rows The rows to store, as 64-bit floating point numbers, 
+ *	or 32-bit if @p rows is stored in @ref SINGLE_PRECISION "SINGLE_PRECISION".
+ *
+ * @pre close() has not been called
+ *
+ * @post Row i of @p rows is stored at positions 
+ *	[offsets[i], offsets[i+1]) of column @p name.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the columns could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	record the columns.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ColumnFile::addRows(const string& name, const RaggedArray& rows) {
+	vector<size_t> offsets(1, 0);
+	offsets.reserve(rows.size() + 1);
+	const bool single = (rows.getPrecision() == SINGLE_PRECISION);
+	for(size_t i = 0; i < rows.size(); i++) {
+		const size_t length = rows.rowSize(i);
+		if (length > 0 && single) {
+			writeValues(rows.floatRowBegin(i), length, sizeof(float));
+		} else if (length > 0) {
+			writeValues(rows.rowBegin(i), length, sizeof(double));
+		}
+		offsets.push_back(offsets.back() + length);
+	}
+	if (single) {
+		addSchema(name, "float32", offsets.back(), sizeof(float));
+	} else {
+		addSchema(name, "float64", offsets.back(), sizeof(double));
+	}
+	
+	addColumn(name + "_offsets", offsets);
+}
+
+/** Writes a string as a JSON literal
+ *
+ * @param[in] out The file to write to.
+ * @param[in] text The string to write.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the string could not 
+ *	be written.
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void writeJsonString(utils::TextWriter& out, const string& text) {
+	out.write('"');
+	for(string::const_iterator it = text.begin(); it != text.end(); it++) {
+		const unsigned char c = static_cast<unsigned char>(*it);
+		if (c == '"' || c == '\\') {
+			out.write('\\');
+			out.write(*it);
+		} else if (c < 0x20) {
+			char escape[8];
+			sprintf(escape, "\\u%04x", static_cast<unsigned int>(c));
+			out.write(escape);
+		} else {
+			out.write(*it);
+		}
+	}
+	out.write('"');
+}
+
+/** Writes the schema
+ *
+ * @param[in] schema The destination for the schema.
+ * @param[in] dataName The name of the data file, relative to the schema.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the schema could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	build the schema.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void ColumnFile::writeSchema(utils::TextWriter& schema, const string& dataName) const {
+	schema.write("{\n\t\"format\": \"lightcurveMC columns\",\n\t\"version\": 1,\n\t\"data\": ");
+	writeJsonString(schema, dataName);
+	schema.write(",\n\t\"byteOrder\": \"little\",\n\t\"columns\": [");
+	for(size_t i = 0; i < columns.size(); i++) {
+		schema.write(i > 0 ? ",\n\t\t{\"name\": " : "\n\t\t{\"name\": ");
+		writeJsonString(schema, columns[i].name);
+		schema.write(", \"type\": \"");
+		schema.write(columns[i].type);
+		schema.write("\", \"offset\": ");
+		schema.write(lexical_cast<string>(columns[i].offset));
+		schema.write(", \"count\": ");
+		schema.write(lexical_cast<string>(columns[i].count));
+		schema.write('}');
+	}
+	schema.write("\n\t]\n}\n");
+	schema.close();
+}
+
+/** Writes the schema and closes the table
+ *
+ * @pre close() has not been called
+ *
+ * @post The data file is closed, and the schema file lists every column 
+ *	added to the object, in order.
+ *
+ * @exception kpfutils::except::FileIo Thrown if either file could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	build the schema.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ColumnFile::close() {
+	if (toArchive) {
+		addToDistribArchive(fileName, archived);
+		vector<char>().swap(archived);
+	} else {
+		if (fflush(data.get()) != 0) {
+			kpfutils::fileError(data.get(), "Could not write to file '" 
+				+ fileName + "': ");
+		}
+		data.reset();
+	}
+	
+	// The data file is referred to by name relative to the schema
+	const size_t slash = fileName.find_last_of('/');
+	const string dataName = (slash == string::npos 
+		? fileName : fileName.substr(slash+1));
+	
+	const string schemaName = withExtension(fileName, ".json");
+	if (toArchive) {
+		vector<char> schemaText;
+		utils::TextWriter schema(schemaText);
+		writeSchema(schema, dataName);
+		addToDistribArchive(schemaName, schemaText);
+	} else {
+		utils::TextWriter schema(schemaName);
+		writeSchema(schema, dataName);
+	}
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,167 @@
+/** Binary output for distributions of statistics
+ * @file lightcurveMC/stats/columns.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCCOLUMNSH
+#define LCMCCOLUMNSH
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace lcmc { 
+
+namespace utils {
+class TextWriter;
+}
+
+namespace stats {
+
+class RaggedArray;
+
+/** Identifies the file format used for the distributions of statistics
+ */
+enum DistribFormat {
+	/** One text file per statistic, with three decimal places
+	 */
+	DISTRIB_TEXT, 
+	/** One file of little-endian binary columns per statistic, 
+	 *	described by a JSON file of the same name
+	 */
+	DISTRIB_BINARY
+};
+
+/** Chooses the file format used for the distributions of statistics
+ */
+void setDistribFormat(DistribFormat format);
+
+/** Returns the format chosen with setDistribFormat()
+ */
+DistribFormat getDistribFormat();
+
+/** Chooses whether distribution files written as text are compressed
+ */
+void setDistribCompression(bool compress);
+
+/** Tests whether distribution files written as text are compressed
+ */
+bool getDistribCompression();
+
+/** Returns the name under which a distribution file is written
+ */
+std::string distribFileName(const std::string& distribFile);
+
+/** Collects all distribution files written from now on into one archive
+ */
+void openDistribArchive(const std::string& fileName, bool compress);
+
+/** Tests whether distribution files are being collected into an archive
+ */
+bool hasDistribArchive();
+
+/** Adds a distribution file to the archive opened with openDistribArchive()
+ */
+void addToDistribArchive(const std::string& name, const std::vector<char>& contents);
+
+/** Finishes the archive opened with openDistribArchive()
+ */
+void closeDistribArchive();
+
+/** ColumnFile writes a table of fixed-width binary columns, plus a 
+ *	schema describing them.
+ *
+ * The columns are stored one after the other in a single file of 
+ * little-endian 8-byte values, or 4-byte values for rows kept in 
+ * single precision. The schema is a JSON file giving the 
+ * name, type, length, and byte offset of each column, so the columns 
+ * can be memory-mapped or read with a single call, without parsing.
+ *
+ * Variable-length rows are stored as a column holding every row, one 
+ * after the other, and a column of offsets into it. Row i occupies 
+ * positions [offsets[i], offsets[i+1]).
+ *
+ * If hasDistribArchive() is true when the table is created, the data 
+ * and schema are added to the archive instead of written to disk.
+ */
+class ColumnFile {
+public:
+	/** Creates an empty table
+	 */
+	explicit ColumnFile(const std::string& fileName);
+	
+	/** Appends a column of numbers
+	 */
+	void addColumn(const std::string& name, const std::vector<double>& values);
+	
+	/** Appends a column of indices
+	 */
+	void addColumn(const std::string& name, const std::vector<size_t>& values);
+	
+	/** Appends a column of variable-length rows
+	 */
+	void addRows(const std::string& name, const RaggedArray& rows);
+	
+	/** Writes the schema and closes the table
+	 */
+	void close();
+
+private:
+	// Files are not shared
+	ColumnFile(const ColumnFile&);
+	ColumnFile& operator=(const ColumnFile&);
+	
+	/** Appends values to the data file
+	 */
+	void writeValues(const void* values, size_t count, size_t width);
+	
+	/** Appends little-endian values to the data file
+	 */
+	size_t writeRaw(const unsigned char* bytes, size_t count, size_t width);
+	
+	/** Writes the schema
+	 */
+	void writeSchema(utils::TextWriter& schema, const std::string& dataName) const;
+	
+	/** Records a column in the schema
+	 */
+	void addSchema(const std::string& name, const char* type, size_t count, 
+			size_t width);
+	
+	/** Describes one column of the table
+	 */
+	struct ColumnInfo {
+		/** Describes a column
+		 *
+		 * @exception std::bad_alloc Thrown if there is not enough 
+		 *	memory to store the name.
+		 *
+		 * @exceptsafe Object construction is atomic.
+		 */
+		ColumnInfo(const std::string& name, const char* type, 
+				boost::uint64_t offset, boost::uint64_t count) 
+				: name(name), type(type), offset(offset), count(count) {
+		}
+		
+		std::string name;
+		std::string type;
+		boost::uint64_t offset;
+		boost::uint64_t count;
+	};
+	
+	std::string fileName;
+	boost::shared_ptr<FILE> data;
+	/** Holds the data if it is bound for an archive */
+	std::vector<char> archived;
+	bool toArchive;
+	boost::uint64_t position;
+	std::vector<ColumnInfo> columns;
+};
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCCOLUMNSH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/cut.tmp.h
  * @author Krzysztof Findeisen
  * @date Created May 9, 2013
- * @date Last modified July 24, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,6 +31,7 @@
 #define LCMCCUTH
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 #include <boost/concept_check.hpp>
 #include <boost/concept/requires.hpp>
@@ -110,6 +111,131 @@ cutFunctionReverse(const vector<double>& pos, const vector<double>& func, UnaryP
 	}
 }
 
+/** Orders the thresholds of cutFunctions() so that values pass the 
+ *	earlier thresholds at least as easily as the later ones
+ *
+ * @tparam BinaryPredicate The comparison used by cutFunctions().
+ */
+template <class BinaryPredicate> 
+class EasierCut {
+public: 
+	/** Sets the thresholds and comparison to use for ordering
+	 *
+	 * @param[in] thresholds The thresholds being ordered.
+	 * @param[in] pred The condition a value must satisfy with respect 
+	 *	to a threshold.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	EasierCut(const vector<double>& thresholds, BinaryPredicate pred) 
+			: thresholds(&thresholds), pred(pred) {
+	}
+	
+	/** Compares two thresholds
+	 *
+	 * @param[in] a, b Indices into the thresholds.
+	 *
+	 * @return True if every value passing threshold @p b also 
+	 *	passes threshold @p a, and the thresholds differ.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool operator() (size_t a, size_t b) {
+		return pred((*thresholds)[b], (*thresholds)[a]);
+	}
+
+private: 
+	const vector<double>* thresholds;
+	BinaryPredicate pred;
+};
+
+/** Finds the first locations on a grid where a function passes each 
+ *	of several thresholds.
+ *
+ * All thresholds are found in a single pass over @p func, which is 
+ * faster than calling cutFunction() once per threshold. The 
+ * thresholds are tried from the easiest to pass to the hardest, so 
+ * each element of @p func is compared only to the thresholds it 
+ * passes and to the first one it fails.
+ *
+ * @tparam BinaryPredicate The type of condition to test. Must be a 
+ *	strict ordering such as std::greater<double> or 
+ *	std::less<double>, called as pred(value, threshold).
+ *
+ * @param[in] pos The position grid on which to search.
+ * @param[in] func The function to test against the thresholds.
+ * @param[in] thresholds The thresholds to test, in any order.
+ * @param[in] pred The condition that must be satisfied by each cut.
+ * @param[out] cuts For each element of @p thresholds, the value 
+ *	@p pos[i] at which @p pred(func[i], threshold) is first true, 
+ *	or NaN if it is false for all elements of @p func.
+ * @param[in] interpolate If true, each cut is instead interpolated 
+ *	linearly between @p pos[i-1] and @p pos[i] to where @p func 
+ *	equals the threshold. Cuts at i = 0, or following a NaN, are 
+ *	not interpolated.
+ *
+ * @pre @p pos.size() = @p func.size()
+ * 
+ * @pre @p pos does not contain NaNs
+ * @pre @p func may contain NaNs
+ *
+ * @post @p cuts.size() = @p thresholds.size()
+ * @post If @p interpolate is false, @p cuts[k] equals 
+ *	cutFunction(@p pos, @p func, p), where p(x) = 
+ *	@p pred(x, @p thresholds[k]).
+ *
+ * @perform O(N + M log M) time, where N = @p func.size() and M = 
+ *	@p thresholds.size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the cuts.
+ *
+ * @exceptsafe If @p pred throws exceptions, then cutFunctions() has the 
+ *	same exception guarantee as @p pred. Otherwise, @p cuts is 
+ *	unchanged in the event of an exception.
+ */
+template <class BinaryPredicate> 
+BOOST_CONCEPT_REQUIRES(
+	((boost::BinaryPredicate<BinaryPredicate, double, double>)),	// Predicate semantics
+	(void)) 						// cutFunctions() return type
+cutFunctions(const vector<double>& pos, const vector<double>& func, 
+		const vector<double>& thresholds, BinaryPredicate pred, 
+		vector<double>& cuts, bool interpolate = false) {
+	const size_t nCuts = thresholds.size();
+	
+	vector<size_t> order;
+	order.reserve(nCuts);
+	for(size_t k = 0; k < nCuts; k++) {
+		order.push_back(k);
+	}
+	std::sort(order.begin(), order.end(), 
+		EasierCut<BinaryPredicate>(thresholds, pred));
+	
+	vector<double> temp(nCuts, std::numeric_limits<double>::quiet_NaN());
+	
+	// invariant: thresholds[order[next...]] have not been passed, so 
+	//	a value failing thresholds[order[next]] fails all of them
+	size_t next = 0;
+	for(size_t i = 0; i < func.size() && next < nCuts; i++) {
+		while (next < nCuts && pred(func[i], thresholds[order[next]])) {
+			const double threshold = thresholds[order[next]];
+			double cut = pos[i];
+			// NaN never equals itself
+			if (interpolate && i > 0 && func[i-1] == func[i-1] 
+					&& func[i] != func[i-1]) {
+				cut = pos[i-1] + (threshold - func[i-1]) 
+					* (pos[i] - pos[i-1]) / (func[i] - func[i-1]);
+			}
+			temp[order[next]] = cut;
+			next++;
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	cuts.swap(temp);
+}
+
 /** Unary predicate for whether a value is more than some threshold
  */
 class MoreThan {
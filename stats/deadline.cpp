@@ -0,0 +1,164 @@
+/** Time limits for expensive statistics
+ * @file lightcurveMC/stats/deadline.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/tss.hpp>
+#include "../except/undefined.h"
+#include "deadline.h"
+
+namespace lcmc { namespace stats {
+
+using std::string;
+using boost::lexical_cast;
+namespace pt = boost::posix_time;
+
+/** Returns the time limit on each expensive statistic
+ *
+ * @return A modifiable reference to the limit, in seconds, or 0 if
+ *	there is no limit.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& statBudget() {
+	static double budget = 0.0;
+	return budget;
+}
+
+/** Deallocator for currentDeadline()
+ *
+ * StatDeadline objects live on the stack, so the thread-specific
+ * pointer does not own them.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void ignoreDeadline(StatDeadline*) {
+}
+
+/** Returns the deadline in effect on the calling thread
+ *
+ * @return A per-thread pointer that is null if the thread has no
+ *	deadline.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::thread_specific_ptr<StatDeadline>& currentDeadline() {
+	static boost::thread_specific_ptr<StatDeadline> deadline(&ignoreDeadline);
+	return deadline;
+}
+
+/** Sets the most wall time each expensive statistic may spend on a
+ *	single light curve
+ *
+ * @param[in] seconds The time limit, or 0 for no limit.
+ *
+ * @post Statistics that support time limits give up on any light
+ *	curve that takes longer than @p seconds, and record it as
+ *	undefined.
+ *
+ * @exception std::invalid_argument Thrown if @p seconds is negative.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe. Call before any statistics are calculated.
+ */
+void setStatBudget(double seconds) {
+	if (!(seconds >= 0.0)) {
+		throw std::invalid_argument("Time limit on statistics must be nonnegative (gave "
+			+ lexical_cast<string>(seconds) + ").");
+	}
+	statBudget() = seconds;
+}
+
+/** Returns the time limit chosen with setStatBudget()
+ *
+ * @return The limit, in seconds, or 0 if there is no limit.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double getStatBudget() {
+	return statBudget();
+}
+
+/** Starts timing a statistic
+ *
+ * @param[in] seconds The time the current thread may spend before
+ *	this object goes out of scope, or 0 for no limit.
+ *
+ * @post checkDeadline() throws except::TimedOut if called more than
+ *	@p seconds after this object was created, and before it is destroyed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+StatDeadline::StatDeadline(double seconds) : limited(seconds > 0.0), end(),
+		outer(currentDeadline().get()) {
+	if (limited) {
+		end = pt::microsec_clock::universal_time()
+			+ pt::microseconds(static_cast<long>(seconds * 1e6));
+	}
+	currentDeadline().reset(this);
+}
+
+/** Stops timing a statistic
+ *
+ * @post The deadline that was in effect when this object was
+ *	created is restored.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+StatDeadline::~StatDeadline() {
+	currentDeadline().reset(outer);
+}
+
+/** Returns the number of seconds left before the deadline
+ *
+ * @return The time remaining, which may be negative, or infinity if
+ *	there is no time limit.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double StatDeadline::remaining() const {
+	if (!limited) {
+		return std::numeric_limits<double>::infinity();
+	}
+	const pt::time_duration left = end - pt::microsec_clock::universal_time();
+	return 1e-6 * static_cast<double>(left.total_microseconds());
+}
+
+/** Throws except::TimedOut if the current thread has exceeded its deadline
+ *
+ * @exception lcmc::stats::except::TimedOut Thrown if the innermost
+ *	StatDeadline on the current thread has expired.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void checkDeadline() {
+	if (deadlineRemaining() <= 0.0) {
+		throw except::TimedOut("Statistic took longer than "
+			+ lexical_cast<string>(getStatBudget()) + " seconds.");
+	}
+}
+
+/** Returns the number of seconds before the current thread's deadline
+ *
+ * @return The time remaining, which may be negative, or infinity if
+ *	the current thread has no deadline.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double deadlineRemaining() {
+	const StatDeadline* const deadline = currentDeadline().get();
+	if (deadline == NULL) {
+		return std::numeric_limits<double>::infinity();
+	}
+	return deadline->remaining();
+}
+
+}}		// end lcmc::stats
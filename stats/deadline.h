@@ -0,0 +1,69 @@
+/** Time limits for expensive statistics
+ * @file lightcurveMC/stats/deadline.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCDEADLINEH
+#define LCMCDEADLINEH
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace lcmc { namespace stats {
+
+/** Sets the most wall time each expensive statistic may spend on a
+ *	single light curve
+ */
+void setStatBudget(double seconds);
+
+/** Returns the time limit chosen with setStatBudget()
+ */
+double getStatBudget();
+
+/** StatDeadline limits the time the current thread may spend computing
+ * a statistic.
+ *
+ * Deadlines are cooperative: long-running code calls checkDeadline()
+ * at convenient points, and is abandoned with an except::TimedOut
+ * exception if the deadline has passed. Deadlines may be nested; the
+ * innermost one in scope applies.
+ */
+class StatDeadline {
+public:
+	/** Starts timing a statistic
+	 */
+	explicit StatDeadline(double seconds);
+
+	/** Stops timing a statistic
+	 */
+	~StatDeadline();
+
+	/** Returns the number of seconds left before the deadline
+	 */
+	double remaining() const;
+
+private:
+	// Deadlines are tied to a scope, and cannot be copied
+	StatDeadline(const StatDeadline&);
+	StatDeadline& operator=(const StatDeadline&);
+
+	/** True if there is a time limit */
+	bool limited;
+	/** The time at which the statistic must be abandoned */
+	boost::posix_time::ptime end;
+	/** The deadline that was in effect when this one was created */
+	StatDeadline* outer;
+};
+
+/** Throws except::TimedOut if the current thread has exceeded its deadline
+ */
+void checkDeadline();
+
+/** Returns the number of seconds before the current thread's deadline
+ */
+double deadlineRemaining();
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCDEADLINEH
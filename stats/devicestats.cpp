@@ -0,0 +1,304 @@
+/** Offloads the heaviest statistics to a CUDA device
+ * @file lightcurveMC/stats/devicestats.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * The device functions in this file are only functional if the program 
+ * is built with GPU = cuda (see makefile.inc). Otherwise, they always 
+ * report that no device is available, and the statistics use the CPU.
+ */
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include "devicestats.h"
+
+#ifdef LCMC_USE_CUDA
+
+#include "../../common/warnflags.h"
+
+// CUDA headers use long long
+#ifdef GNUC_COARSEWARN
+#pragma GCC diagnostic ignored "-Wlong-long"
+#endif
+
+// CUDA headers use long long
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wlong-long"
+#endif
+
+#include <cuda_runtime_api.h>
+#include <cublas_v2.h>
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+#endif		// end ifdef LCMC_USE_CUDA
+
+namespace lcmc { namespace stats {
+
+using std::vector;
+using boost::shared_ptr;
+
+/** The smallest table, in elements, for which the device is used. 
+ *	Smaller periodograms are faster to compute on the CPU than to 
+ *	copy to the device.
+ */
+const size_t DEVICE_MIN_TABLE = 64*1024;
+
+/** Copy of a periodogram plan's trigonometric tables kept on a device
+ *
+ * The copies are made the first time a batch is sent for the plan, 
+ * and freed along with the plan.
+ */
+struct DeviceTables {
+	/** @f$\cos \omega_j t_i@f$, with each frequency contiguous */
+	shared_ptr<double> cosTable;
+	/** @f$\sin \omega_j t_i@f$, with each frequency contiguous */
+	shared_ptr<double> sinTable;
+};
+
+/** Returns whether the user allowed statistics on a device
+ *
+ * @return A modifiable reference to the setting.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& deviceStatsValue() {
+	static bool useDevice = false;
+	return useDevice;
+}
+
+/** Sets whether statistics may be computed on a CUDA device
+ *
+ * @param[in] useDevice If true, batches of periodograms are computed 
+ *	on a device when one is available.
+ *
+ * @post If @p useDevice and deviceStatsAvailable() are both true, 
+ *	PeriodogramPlan::lombScargleBatch() computes the trigonometric 
+ *	sums of large periodograms with deviceTrigSums(). The periodograms 
+ *	differ from those computed on the CPU only by rounding.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any light curves are analyzed.
+ */
+void setDeviceStats(bool useDevice) {
+	deviceStatsValue() = useDevice;
+}
+
+/** Returns the choice made with setDeviceStats()
+ *
+ * @return True if statistics may be computed on a device. The CPU is 
+ *	used unless setDeviceStats() was called.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool getDeviceStats() {
+	return deviceStatsValue();
+}
+
+#ifdef LCMC_USE_CUDA
+
+/** Allocates an array on the device
+ *
+ * @param[in] n The number of elements in the array.
+ *
+ * @return A pointer to the array, owning a deallocator cudaFree(), or
+ *	a null pointer if the array could not be allocated.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough host memory
+ *	to manage the pointer.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+template <typename T>
+shared_ptr<T> deviceArray(size_t n) {
+	void* data = NULL;
+	if (cudaMalloc(&data, n * sizeof(T)) != cudaSuccess) {
+		return shared_ptr<T>();
+	}
+	try {
+		return shared_ptr<T>(static_cast<T*>(data), &cudaFree);
+	} catch (...) {
+		cudaFree(data);
+		throw;
+	}
+}
+
+/** Returns a handle to the cuBLAS library for the statistics
+ *
+ * The handle is separate from the one used for Gaussian process 
+ * realizations, so that the two never share a stream.
+ *
+ * @return A handle that remains valid for the rest of the program, or
+ *	a null pointer if cuBLAS could not be initialized.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+cublasHandle_t statsBlasHandle() {
+	// invariant: handle is null if and only if initialization failed
+	static bool initialized = false;
+	static cublasHandle_t handle = NULL;
+
+	if (!initialized) {
+		initialized = true;
+		if (cublasCreate(&handle) != CUBLAS_STATUS_SUCCESS) {
+			handle = NULL;
+		}
+	}
+	return handle;
+}
+
+#endif		// end ifdef LCMC_USE_CUDA
+
+/** Tests whether statistics can be offloaded to a device
+ *
+ * @return true if the program was built with GPU = cuda and a CUDA
+ *	device is present. The result of the first call is remembered.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool deviceStatsAvailable() {
+#ifdef LCMC_USE_CUDA
+	static boost::mutex initLock;
+	static int available = -1;
+
+	boost::lock_guard<boost::mutex> guard(initLock);
+	if (available < 0) {
+		int count = 0;
+		available = (cudaGetDeviceCount(&count) == cudaSuccess && count > 0
+			&& statsBlasHandle() != NULL) ? 1 : 0;
+	}
+	return available > 0;
+#else
+	return false;
+#endif
+}
+
+/** Computes the trigonometric sums of several periodograms on a device
+ *
+ * The sums for the whole batch are the product of the plan's tables, 
+ * an F &times; N matrix, with the block of centered data, an 
+ * N &times; K matrix, so they are computed with two calls to 
+ * cublasDgemm(). The tables are copied to the device only on the 
+ * first call for each plan.
+ *
+ * @param[in] cosTable, sinTable @f$\cos \omega_j t_i@f$ and 
+ *	@f$\sin \omega_j t_i@f$, with the N times of each frequency 
+ *	contiguous.
+ * @param[in] nTimes The number of times, N.
+ * @param[in,out] cache The device copy of @p cosTable and @p sinTable, 
+ *	or null if there is none yet.
+ * @param[in] resid The centered data of each light curve, with the 
+ *	K values at each time contiguous.
+ * @param[in] nCurves The number of light curves, K.
+ * @param[out] yc, ys The sums @f$\sum_i y_{ki} \cos \omega_j t_i@f$ and 
+ *	@f$\sum_i y_{ki} \sin \omega_j t_i@f$, with the K light curves 
+ *	at each frequency contiguous.
+ *
+ * @return true if the sums were computed on the device. If false, 
+ *	because no device is available, the tables are too small to 
+ *	benefit, or the device failed, @p yc and @p ys are unchanged.
+ *
+ * @pre @p cosTable.size() = @p sinTable.size() = N &times; F
+ * @pre @p resid.size() = N &times; K
+ * @pre @p cache is either null or a copy of @p cosTable and @p sinTable
+ *
+ * @post If @p cache was null and the function returns true, @p cache 
+ *	holds a copy of @p cosTable and @p sinTable for later calls.
+ *
+ * @exception std::bad_alloc Thrown if there was not enough host memory
+ *	to store the sums.
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+bool deviceTrigSums(const utils::LargeVector<double>::type& cosTable, 
+		const utils::LargeVector<double>::type& sinTable, size_t nTimes, 
+		shared_ptr<DeviceTables>& cache, 
+		const vector<double>& resid, size_t nCurves, 
+		vector<double>& yc, vector<double>& ys) {
+	using std::swap;
+
+	if (nTimes == 0 || nCurves == 0 || cosTable.size() < DEVICE_MIN_TABLE 
+			|| !deviceStatsAvailable()) {
+		return false;
+	}
+
+#ifdef LCMC_USE_CUDA
+	const size_t nFreq = cosTable.size() / nTimes;
+
+	// The handle, and the cache of any plan shared between threads, 
+	//	may only be used by one thread at a time
+	static boost::mutex deviceLock;
+	boost::lock_guard<boost::mutex> guard(deviceLock);
+
+	cublasHandle_t blas = statsBlasHandle();
+
+	if (cache.get() == NULL) {
+		shared_ptr<DeviceTables> temp(new DeviceTables());
+		temp->cosTable = deviceArray<double>(nTimes*nFreq);
+		temp->sinTable = deviceArray<double>(nTimes*nFreq);
+		if (temp->cosTable.get() == NULL || temp->sinTable.get() == NULL
+				|| cudaMemcpy(temp->cosTable.get(), &cosTable[0], 
+					nTimes*nFreq*sizeof(double), 
+					cudaMemcpyHostToDevice) != cudaSuccess
+				|| cudaMemcpy(temp->sinTable.get(), &sinTable[0], 
+					nTimes*nFreq*sizeof(double), 
+					cudaMemcpyHostToDevice) != cudaSuccess) {
+			return false;
+		}
+		cache = temp;
+	}
+
+	shared_ptr<double> devResid = deviceArray<double>(nTimes*nCurves);
+	shared_ptr<double> devCos   = deviceArray<double>(nFreq*nCurves);
+	shared_ptr<double> devSin   = deviceArray<double>(nFreq*nCurves);
+	if (devResid.get() == NULL || devCos.get() == NULL || devSin.get() == NULL) {
+		return false;
+	}
+
+	// In column-major order, resid is K by N and each table is N by F, 
+	//	so their product is the K by F matrix of sums
+	const int m = static_cast<int>(nCurves);
+	const int n = static_cast<int>(nFreq);
+	const int k = static_cast<int>(nTimes);
+	const double one = 1.0;
+	const double zero = 0.0;
+	vector<double> tempCos(nFreq*nCurves), tempSin(nFreq*nCurves);
+	if (cudaMemcpy(devResid.get(), &resid[0], nTimes*nCurves*sizeof(double),
+				cudaMemcpyHostToDevice) != cudaSuccess
+			|| cublasDgemm(blas, CUBLAS_OP_N, CUBLAS_OP_N, m, n, k, &one, 
+				devResid.get(), m, cache->cosTable.get(), k, &zero, 
+				devCos.get(), m) != CUBLAS_STATUS_SUCCESS
+			|| cublasDgemm(blas, CUBLAS_OP_N, CUBLAS_OP_N, m, n, k, &one, 
+				devResid.get(), m, cache->sinTable.get(), k, &zero, 
+				devSin.get(), m) != CUBLAS_STATUS_SUCCESS
+			|| cudaMemcpy(&tempCos[0], devCos.get(), nFreq*nCurves*sizeof(double),
+				cudaMemcpyDeviceToHost) != cudaSuccess
+			|| cudaMemcpy(&tempSin[0], devSin.get(), nFreq*nCurves*sizeof(double),
+				cudaMemcpyDeviceToHost) != cudaSuccess) {
+		return false;
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	swap(yc, tempCos);
+	swap(ys, tempSin);
+	return true;
+#else
+	(void) sinTable;
+	(void) cache;
+	(void) resid;
+	(void) yc;
+	(void) ys;
+	return false;
+#endif
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,43 @@
+/** Offloads the heaviest statistics to a CUDA device
+ * @file lightcurveMC/stats/devicestats.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCDEVICESTATSH
+#define LCMCDEVICESTATSH
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "../largealloc.tmp.h"
+
+namespace lcmc { namespace stats {
+
+/** Sets whether statistics may be computed on a CUDA device
+ */
+void setDeviceStats(bool useDevice);
+
+/** Returns the choice made with setDeviceStats()
+ */
+bool getDeviceStats();
+
+/** Tests whether statistics can be offloaded to a device
+ */
+bool deviceStatsAvailable();
+
+/** Copy of a periodogram plan's trigonometric tables kept on a device
+ */
+struct DeviceTables;
+
+/** Computes the trigonometric sums of several periodograms on a device
+ */
+bool deviceTrigSums(const utils::LargeVector<double>::type& cosTable, 
+		const utils::LargeVector<double>::type& sinTable, size_t nTimes, 
+		boost::shared_ptr<DeviceTables>& cache, 
+		const std::vector<double>& resid, size_t nCurves, 
+		std::vector<double>& yc, std::vector<double>& ys);
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCDEVICESTATSH
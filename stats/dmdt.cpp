@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/dmdt.cpp
  * @author Krzysztof Findeisen
  * @date Created April 12, 2013
- * @date Last modified October 29, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,13 +27,14 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <vector>
 #include <boost/lexical_cast.hpp>
-#include <timescales/timescales.h>
 #include "cut.tmp.h"
-#include "magdist.h"
+#include "dmdtbins.h"
+#include "scratch.h"
 #include "statfamilies.h"
 #include "../except/undefined.h"
 #include "../../common/stats.tmp.h"
@@ -46,8 +47,7 @@ using std::vector;
 
 /** Does all &Delta;m&Delta;t-related computations for a given light curve.
  *
- * @param[in] times The times at which the light curve was sampled.
- * @param[in] mags The values of the light curve
+ * @param[in] lc The light curve to analyze.
  * @param[in] getCut Flag indicating that cuts through the the 
  *	&Delta;m&Delta;t quantiles should be extracted
  * @param[in] getPlot Flag indicating that the &Delta;m&Delta;t quantiles 
@@ -67,9 +67,6 @@ using std::vector;
  * @param[out] dmdtMed The NamedCollection in which to record the 
  *	median value of &Delta;m as a function of &Delta;t.
  *
- * @pre @p times.size() = @p mags.size()
- * @pre Neither @p times nor @p mags may contain NaNs
- * 
  * @post if @p getCut, then new elements are appended to @p cut50Amp3, 
  *	@p cut50Amp2, @p cut90Amp3, and @p cut90Amp2. If any of the cuts are 
  *	undefined, NaN is appended to the corresponding collection.
@@ -77,104 +74,112 @@ using std::vector;
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	store more statistics.
- * @exception std::invalid_argument Thrown if @p times and @p mags do not 
- *	have matching lengths or if @p times or @p data contains NaNs.
- * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
- *	and @p mags are too short to calculate the desired statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate the desired statistics.
  *
- * @exceptsafe The program is in a consistent state in the event of an exception.
+ * @exceptsafe The collections are unchanged in the event of an exception.
  */
-void doDmdt(const vector<double>& times, const vector<double>& mags, 
+void doDmdt(const AnalysisContext& lc, 
 		bool getCut, bool getPlot, 
 		CollectedScalars& cut50Amp3, CollectedScalars& cut50Amp2, 
 		CollectedScalars& cut90Amp3, CollectedScalars& cut90Amp2, 
 		CollectedPairs& dmdtMed) {
-	if (times.size() != mags.size()) {
-		throw std::invalid_argument("Times and mags must have the same length in doDmdt() (gave " 
-			+ lexical_cast<string>(times.size()) + " for times and " 
-			+ lexical_cast<string>(mags.size()) + " for mags).");
-	}
+	const vector<double>& times = lc.getTimes();
+	const vector<double>& mags = lc.getMags();
 
 	if (getCut || getPlot) {
-		// copy-and-swap
-		CollectedScalars temp50Amp3 = cut50Amp3;
-		CollectedScalars temp50Amp2 = cut50Amp2;
-		CollectedScalars temp90Amp3 = cut90Amp3;
-		CollectedScalars temp90Amp2 = cut90Amp2;
-		CollectedPairs   tempMed    = dmdtMed;
+		// Checkpoints let us undo a partial update without copying 
+		//	the statistics from all previous light curves
+		const CollectedScalars::Checkpoint mark50Amp3 = cut50Amp3.checkpoint();
+		const CollectedScalars::Checkpoint mark50Amp2 = cut50Amp2.checkpoint();
+		const CollectedScalars::Checkpoint mark90Amp3 = cut90Amp3.checkpoint();
+		const CollectedScalars::Checkpoint mark90Amp2 = cut90Amp2.checkpoint();
+		const size_t markMed    = dmdtMed  .checkpoint();
 		
 		try {
-			double amplitude = getAmplitude(mags);
-			
-			if (amplitude > 0) {
-				double minBin = -1.97;
-				double maxBin = log10(kpftimes::deltaT(times));
-				
-				DoubleVec binEdges;
-				for (double bin = minBin; bin < maxBin; bin += 0.15) {
-					binEdges.push_back(pow(10.0,bin));
-				}
-				// Get the bin containing maxBin as well
-				binEdges.push_back(pow(10.0,maxBin));
+			try {
+				double amplitude = lc.getAmplitude();
 				
-				DoubleVec deltaT, deltaM;
-				kpftimes::dmdt(times, mags, deltaT, deltaM);
-				
-				// Need median for for both getCut and getPlot
-				DoubleVec change50;
-				kpftimes::deltaMBinQuantile(deltaT, deltaM, binEdges, change50, 0.50);
-				
-				if (getCut) {
-					DoubleVec change90;
-					kpftimes::deltaMBinQuantile(deltaT, deltaM, binEdges, change90, 0.90);
+				if (amplitude > 0) {
+					double minBin = -1.97;
+					double maxBin = log10(lc.getBaseline());
 					
-					// Key cuts
-					temp50Amp3.addStat(cutFunction(binEdges, 
-						change50, MoreThan(amplitude / 3.0) ));
-					temp50Amp2.addStat(cutFunction(binEdges, 
-						change50, MoreThan(amplitude / 2.0) ));
+					ScratchVector edgeBuffer;
+					DoubleVec& binEdges = edgeBuffer.get();
+					for (double bin = minBin; bin < maxBin; bin += 0.15) {
+						binEdges.push_back(pow(10.0,bin));
+					}
+					// Get the bin containing maxBin as well
+					binEdges.push_back(pow(10.0,maxBin));
 					
-					temp90Amp3.addStat(cutFunction(binEdges, 
-						change90, MoreThan(amplitude / 3.0) ));
-					temp90Amp2.addStat(cutFunction(binEdges, 
-						change90, MoreThan(amplitude / 2.0) ));
-				}
+					// Need median for for both getCut and getPlot
+					DoubleVec quantiles(1, 0.50);
+					if (getCut) {
+						quantiles.push_back(0.90);
+					}
+					
+					// Every light curve in a simulation bin shares 
+					//	its cadence, so the pairs in each dmdt bin 
+					//	are found only once
+					vector<DoubleVec> changes;
+					DmdtPairIndex::forCadence(times, binEdges)
+						->binQuantiles(mags, quantiles, changes);
+					const DoubleVec& change50 = changes[0];
+					
+					if (getCut) {
+						const DoubleVec& change90 = changes[1];
+						
+						// Key cuts, found in one pass per quantile
+						DoubleVec levels, cuts50, cuts90;
+						levels.push_back(amplitude / 3.0);
+						levels.push_back(amplitude / 2.0);
+						cutFunctions(binEdges, change50, levels, 
+							std::greater<double>(), cuts50);
+						cutFunctions(binEdges, change90, levels, 
+							std::greater<double>(), cuts90);
+						
+						cut50Amp3.addStat(cuts50[0]);
+						cut50Amp2.addStat(cuts50[1]);
+						
+						cut90Amp3.addStat(cuts90[0]);
+						cut90Amp2.addStat(cuts90[1]);
+					}
 
-				if (getPlot) {
-					tempMed.addStat(binEdges, change50);
+					if (getPlot) {
+						dmdtMed.addStat(binEdges, change50);
+					}
+				}
+			} catch (const except::NotEnoughData &e) {
+				// The one kind of Undefined we don't want to ignore
+				throw;
+			} catch (const except::Undefined &e) {
+				// Don't know how many of the collections were updated... revert to input
+				cut50Amp3.rollback(mark50Amp3);
+				cut50Amp2.rollback(mark50Amp2);
+				cut90Amp3.rollback(mark90Amp3);
+				cut90Amp2.rollback(mark90Amp2);
+				dmdtMed  .rollback(markMed   );
+				
+				// May still throw bad_alloc
+				if (getCut) {
+					cut50Amp3.addNull();
+					cut50Amp2.addNull();
+					cut90Amp3.addNull();
+					cut90Amp2.addNull();
 				}
+//				if (getPlot) {
+//					dmdtMed.addNull();
+//				}
 			}
-		} catch (const except::NotEnoughData &e) {
-			// The one kind of Undefined we don't want to ignore
+		} catch (...) {
+			// Leave the collections as they were before the call
+			cut50Amp3.rollback(mark50Amp3);
+			cut50Amp2.rollback(mark50Amp2);
+			cut90Amp3.rollback(mark90Amp3);
+			cut90Amp2.rollback(mark90Amp2);
+			dmdtMed  .rollback(markMed   );
 			throw;
-		} catch (const except::Undefined &e) {
-			// Don't know how many of the collections were updated... revert to input
-			temp50Amp3 = cut50Amp3;
-			temp50Amp2 = cut50Amp2;
-			temp90Amp3 = cut90Amp3;
-			temp90Amp2 = cut90Amp2;
-			tempMed    = dmdtMed;
-			
-			// May still throw bad_alloc
-			if (getCut) {
-				temp50Amp3.addNull();
-				temp50Amp2.addNull();
-				temp90Amp3.addNull();
-				temp90Amp2.addNull();
-			}
-//			if (getPlot) {
-//				tempMed.addNull();
-//			}
 		}
-		
-		// IMPORTANT: no exceptions beyond this point
-		
-		using std::swap;		
-		swap(cut50Amp3, temp50Amp3);
-		swap(cut50Amp2, temp50Amp2);
-		swap(cut90Amp3, temp90Amp3);
-		swap(cut90Amp2, temp90Amp2);
-		swap(dmdtMed  , tempMed   );
 	}
 }
 
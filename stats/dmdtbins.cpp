@@ -0,0 +1,739 @@
+/** Binned Delta-m Delta-t quantiles computed without storing every pair
+ * @file lightcurveMC/stats/dmdtbins.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <gsl/gsl_statistics_double.h>
+#if defined(LCMC_USE_AVX512) || defined(LCMC_USE_AVX2)
+#include <immintrin.h>
+#endif
+#include "../cachestats.h"
+#include "../numa.h"
+#include "dmdtbins.h"
+#include "scratch.h"
+
+namespace lcmc { namespace stats {
+
+using std::string;
+using std::vector;
+using boost::lexical_cast;
+using boost::shared_ptr;
+
+namespace {
+
+/** Number of &Delta;m cells in the histogram kept for each &Delta;t bin
+ *
+ * Larger values use more memory per bin, but leave fewer values to be 
+ * stored and searched in the second pass.
+ */
+const size_t N_CELLS = 1024;
+
+/** The largest number of pairs that a DmdtPairIndex stores
+ *
+ * An index of this size takes 64 MB.
+ */
+const size_t MAX_INDEXED_PAIRS = 8*1024*1024;
+
+/** Marks a histogram cell that does not contain a requested rank */
+const size_t NOT_TARGET = std::numeric_limits<size_t>::max();
+
+/** Maps pairs of observations to a &Delta;t bin and a &Delta;m cell
+ *
+ * The mapping is computed the same way on every pass, so a pair always 
+ * lands in the same place.
+ */
+class PairGrid {
+public:
+	/** Defines the grid for a light curve
+	 *
+	 * @param[in] binEdges The lower edge of each &Delta;t bin.
+	 * @param[in] maxDeltaM The largest &Delta;m of any pair.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	PairGrid(const vector<double>& binEdges, double maxDeltaM) 
+			: edges(binEdges), 
+			cellScale(maxDeltaM > 0.0 ? N_CELLS / maxDeltaM : 0.0) {
+	}
+
+	/** Finds the &Delta;t bin of a pair
+	 *
+	 * @param[in] deltaT The time between the two observations.
+	 *
+	 * @return The index of the last edge not above @p deltaT, or 
+	 *	@p binEdges.size() if @p deltaT is below the first edge.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	size_t bin(double deltaT) const {
+		const size_t above = std::upper_bound(edges.begin(), edges.end(), deltaT) 
+			- edges.begin();
+		return (above > 0 ? above - 1 : edges.size());
+	}
+
+	/** Finds the &Delta;m cell of a pair
+	 *
+	 * @param[in] deltaM The magnitude difference of the two observations.
+	 *
+	 * @return The index of the histogram cell containing @p deltaM.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	size_t cell(double deltaM) const {
+		const size_t index = static_cast<size_t>(deltaM * cellScale);
+		return std::min(index, N_CELLS - 1);
+	}
+
+private:
+	const vector<double>& edges;
+	const double cellScale;
+};
+
+/** Finds the histogram cell containing a rank
+ *
+ * @param[in] cellCounts The number of pairs in each of the N_CELLS 
+ *	cells of a bin.
+ * @param[in] rank The rank to find, counting from the smallest &Delta;m.
+ *
+ * @param[out] before The number of pairs in the cells preceding the 
+ *	returned one.
+ *
+ * @return The index of the cell that contains the pair of rank @p rank.
+ *
+ * @pre @p rank is less than the total of @p cellCounts
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t cellOfRank(const size_t cellCounts[], size_t rank, size_t& before) {
+	before = 0;
+	size_t cell = 0;
+	while (cell < N_CELLS - 1 && rank >= before + cellCounts[cell]) {
+		before += cellCounts[cell];
+		cell++;
+	}
+	return cell;
+}
+
+/** Marks the cell containing a rank so that its pairs are kept
+ *
+ * @param[in] cellCounts The number of pairs in each of the N_CELLS 
+ *	cells of a bin.
+ * @param[in,out] cellSlots The index into the kept values for each 
+ *	cell of the bin, or NOT_TARGET if the cell is not kept.
+ * @param[in] rank The rank to keep.
+ * @param[in,out] nSlots The number of cells kept so far, in all bins.
+ *
+ * @post The cell containing @p rank has a slot.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void markRank(const size_t cellCounts[], size_t cellSlots[], size_t rank, 
+		size_t& nSlots) {
+	size_t before;
+	const size_t cell = cellOfRank(cellCounts, rank, before);
+	if (cellSlots[cell] == NOT_TARGET) {
+		cellSlots[cell] = nSlots++;
+	}
+}
+
+/** Returns the &Delta;m of a given rank within a bin
+ *
+ * @param[in] cellCounts The number of pairs in each of the N_CELLS 
+ *	cells of a bin.
+ * @param[in] cellSlots The index into @p slotValues for each cell of 
+ *	the bin.
+ * @param[in,out] slotValues The pairs kept in each marked cell. The 
+ *	values may be reordered.
+ * @param[in] rank The rank to return.
+ *
+ * @return The value that would be at index @p rank if the bin's pairs 
+ *	were sorted.
+ *
+ * @pre The cell containing @p rank was marked with markRank()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double valueAtRank(const size_t cellCounts[], const size_t cellSlots[], 
+		vector<vector<double> >& slotValues, size_t rank) {
+	size_t before;
+	const size_t cell = cellOfRank(cellCounts, rank, before);
+	vector<double>& values = slotValues[cellSlots[cell]];
+	
+	std::nth_element(values.begin(), values.begin() + (rank - before), 
+		values.end());
+	return values[rank - before];
+}
+
+/** Interpolates a quantile between the two ranks that bracket it
+ *
+ * The interpolation is done by gsl_stats_quantile_from_sorted_data(), 
+ * the convention used by kpfutils::quantile() and hence by 
+ * kpftimes::deltaMBinQuantile(), so that the result matches the 
+ * library to the last bit.
+ *
+ * @param[in] low, high The values of rank <tt>floor(pos)</tt> and 
+ *	<tt>ceil(pos)</tt>.
+ * @param[in] pos The fractional rank of the quantile, <tt>q*(n-1)</tt>.
+ *
+ * @return The value at rank @p pos.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double interpolateRank(double low, double high, double pos) {
+	const double bracket[2] = {low, high};
+	return gsl_stats_quantile_from_sorted_data(bracket, 1, 2, pos - floor(pos));
+}
+
+/** Calculates the absolute magnitude differences of a block of pairs
+ *
+ * @param[in] mags The magnitude of each observation.
+ * @param[in] first, second The two observations of each pair.
+ * @param[in] count The number of pairs.
+ * @param[out] deltaM An array of length @p count in which to store 
+ *	|<tt>mags[second[k]] - mags[first[k]]</tt>| for each pair @p k.
+ *
+ * @pre Every element of @p first and @p second is a valid index into 
+ *	@p mags
+ *
+ * @perform O(@p count) time. If the program was built with SIMD=avx2 or 
+ *	SIMD=avx512, four or eight pairs at a time are processed with 
+ *	vector gathers.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void absDifferences(const double mags[], const unsigned int first[], 
+		const unsigned int second[], size_t count, double deltaM[]) {
+	size_t k = 0;
+#if defined(LCMC_USE_AVX512)
+	// Masked gathers avoid a spurious GCC uninitialized-value warning
+	const __m512d zero8 = _mm512_setzero_pd();
+	for (; k + 8 <= count; k += 8) {
+		const __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first  + k));
+		const __m256i j = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + k));
+		const __m512d diff = _mm512_sub_pd(
+			_mm512_mask_i32gather_pd(zero8, 0xFF, j, mags, sizeof(double)), 
+			_mm512_mask_i32gather_pd(zero8, 0xFF, i, mags, sizeof(double)));
+		_mm512_storeu_pd(deltaM + k, _mm512_abs_pd(diff));
+	}
+#elif defined(LCMC_USE_AVX2)
+	// Masked gathers avoid a spurious GCC uninitialized-value warning
+	const __m256d zero4 = _mm256_setzero_pd();
+	const __m256d all4  = _mm256_castsi256_pd(_mm256_set1_epi32(-1));
+	const __m256d sign4 = _mm256_set1_pd(-0.0);
+	for (; k + 4 <= count; k += 4) {
+		const __m128i i = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first  + k));
+		const __m128i j = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + k));
+		const __m256d diff = _mm256_sub_pd(
+			_mm256_mask_i32gather_pd(zero4, mags, j, all4, sizeof(double)), 
+			_mm256_mask_i32gather_pd(zero4, mags, i, all4, sizeof(double)));
+		_mm256_storeu_pd(deltaM + k, _mm256_andnot_pd(sign4, diff));
+	}
+#endif
+	// Scalar code for the remaining pairs, or all of them
+	for (; k < count; k++) {
+		deltaM[k] = fabs(mags[second[k]] - mags[first[k]]);
+	}
+}
+
+}	// end unnamed namespace
+
+/** Calculates quantiles of &Delta;m in bins of &Delta;t, streaming over 
+ *	the pairs of observations
+ *
+ * The result is the same as building the &Delta;m&Delta;t plot of the 
+ * light curve and taking quantiles of the pairs in each bin, but the 
+ * pairs are never stored. A first pass over the pairs counts them in a 
+ * fixed-resolution &Delta;m histogram for each bin. A second pass keeps 
+ * only the pairs in the histogram cells that contain the requested 
+ * ranks, and the exact quantiles are selected from those.
+ *
+ * @param[in] times The times of the observations.
+ * @param[in] mags The magnitude at each element of @p times.
+ * @param[in] binEdges The lower edge of each &Delta;t bin. Bin @p i 
+ *	contains the pairs with <tt>binEdges[i] &le; &Delta;t &lt; 
+ *	binEdges[i+1]</tt>; the last bin has no upper edge.
+ * @param[in] quantiles The quantiles of &Delta;m to calculate in each bin.
+ * @param[out] results For each element of @p quantiles, a vector 
+ *	with that quantile of &Delta;m for each bin.
+ *
+ * @pre @p times and @p mags contain no NaNs
+ * @pre @p binEdges is sorted in ascending order
+ * @pre All elements of @p quantiles are in [0, 1]
+ *
+ * @post <tt>results.size() == quantiles.size()</tt>, and each element 
+ *	of @p results has the same length as @p binEdges.
+ * @post The @p q quantile of a bin with @p n pairs is found by linear 
+ *	interpolation between the pairs of rank <tt>floor(q*(n-1))</tt> and 
+ *	<tt>ceil(q*(n-1))</tt>, with the same arithmetic as 
+ *	gsl_stats_quantile_from_sorted_data(). Here 
+ *	&Delta;t = |t<sub>j</sub> - t<sub>i</sub>| and &Delta;m = |m<sub>j</sub> - m<sub>i</sub>| for every 
+ *	<tt>i &lt; j</tt>. Bins with no pairs have a value of NaN.
+ *
+ * @perform O(N<sup>2</sup> log B) time, where N = @p times.size() and 
+ *	B = @p binEdges.size()
+ * @perform O(B) memory, plus the pairs that share a histogram cell with 
+ *	a requested rank
+ *
+ * @exception std::invalid_argument Thrown if @p times and @p mags do 
+ *	not have the same length.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	calculate the quantiles.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void dmdtBinQuantiles(const vector<double>& times, const vector<double>& mags, 
+		const vector<double>& binEdges, const vector<double>& quantiles, 
+		vector<vector<double> >& results) {
+	const size_t n = times.size();
+	if (mags.size() != n) {
+		throw std::invalid_argument("Times and magnitudes must have the same length in dmdtBinQuantiles() (gave "
+			+ lexical_cast<string>(n) + " for times and "
+			+ lexical_cast<string>(mags.size()) + " for magnitudes).");
+	}
+	const size_t nBins  = binEdges.size();
+	const size_t nQuant = quantiles.size();
+	
+	const double maxDeltaM = (n > 0 
+		? *std::max_element(mags.begin(), mags.end()) 
+			- *std::min_element(mags.begin(), mags.end()) 
+		: 0.0);
+	const PairGrid grid(binEdges, maxDeltaM);
+	
+	// First pass: histogram of deltaM in each bin
+	vector<size_t> counts(nBins * N_CELLS, 0);
+	vector<size_t> binCounts(nBins, 0);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = i+1; j < n; j++) {
+			const size_t bin = grid.bin(fabs(times[j] - times[i]));
+			if (bin < nBins) {
+				counts[bin*N_CELLS + grid.cell(fabs(mags[j] - mags[i]))]++;
+				binCounts[bin]++;
+			}
+		}
+	}
+	
+	// Mark the cells holding the ranks needed for each quantile
+	vector<size_t> slots(nBins * N_CELLS, NOT_TARGET);
+	size_t nSlots = 0;
+	for (size_t bin = 0; bin < nBins; bin++) {
+		for (size_t q = 0; q < nQuant && binCounts[bin] > 0; q++) {
+			const double pos = quantiles[q] * (binCounts[bin] - 1);
+			markRank(&counts[bin*N_CELLS], &slots[bin*N_CELLS], 
+				static_cast<size_t>(floor(pos)), nSlots);
+			markRank(&counts[bin*N_CELLS], &slots[bin*N_CELLS], 
+				static_cast<size_t>(ceil (pos)), nSlots);
+		}
+	}
+	
+	// Second pass: keep only the pairs in the marked cells
+	vector<vector<double> > slotValues(nSlots);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = i+1; j < n; j++) {
+			const size_t bin = grid.bin(fabs(times[j] - times[i]));
+			if (bin < nBins) {
+				const double deltaM = fabs(mags[j] - mags[i]);
+				const size_t slot = slots[bin*N_CELLS + grid.cell(deltaM)];
+				if (slot != NOT_TARGET) {
+					slotValues[slot].push_back(deltaM);
+				}
+			}
+		}
+	}
+	
+	// Select the exact ranks within each cell
+	vector<vector<double> > temp(nQuant, 
+		vector<double>(nBins, std::numeric_limits<double>::quiet_NaN()));
+	for (size_t bin = 0; bin < nBins; bin++) {
+		for (size_t q = 0; q < nQuant && binCounts[bin] > 0; q++) {
+			const double pos = quantiles[q] * (binCounts[bin] - 1);
+			const double low  = valueAtRank(&counts[bin*N_CELLS], 
+				&slots[bin*N_CELLS], slotValues, static_cast<size_t>(floor(pos)));
+			const double high = valueAtRank(&counts[bin*N_CELLS], 
+				&slots[bin*N_CELLS], slotValues, static_cast<size_t>(ceil (pos)));
+			temp[q][bin] = interpolateRank(low, high, pos);
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	results.swap(temp);
+}
+
+/** Finds the pairs of observations in each &Delta;t bin
+ *
+ * @param[in] times The times of the observations.
+ * @param[in] binEdges The lower edge of each &Delta;t bin, as for 
+ *	dmdtBinQuantiles().
+ *
+ * @pre @p times contains no NaNs
+ * @pre @p binEdges is sorted in ascending order
+ *
+ * @post binQuantiles() gives the same results as dmdtBinQuantiles() 
+ *	for @p times and @p binEdges.
+ * @post Within each bin, the pairs are in ascending order of their 
+ *	later observation, so that the pairs of any prefix of @p times 
+ *	come first.
+ *
+ * @perform O(N<sup>2</sup> log B) time, where N = @p times.size() and 
+ *	B = @p binEdges.size()
+ * @perform O(N<sup>2</sup>) memory, unless there are more than 
+ *	MAX_INDEXED_PAIRS pairs
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the index.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+DmdtPairIndex::DmdtPairIndex(const vector<double>& times, 
+		const vector<double>& binEdges) : times(times), binEdges(binEdges), 
+		streaming(true), binStarts(), sortedBins(binEdges.size()), 
+		first(), second() {
+	const size_t n     = times.size();
+	const size_t nBins = binEdges.size();
+	const size_t nPairs = (n > 1 ? n * (n-1) / 2 : 0);
+	// MAX_INDEXED_PAIRS also keeps n small enough for unsigned int
+	if (nPairs > MAX_INDEXED_PAIRS) {
+		return;
+	}
+	streaming = false;
+	
+	// Two passes: bin sizes, then pairs
+	// Bin numbers are not stored between passes, to keep memory at 
+	//	two indices per pair
+	// Pairs are visited in order of their later observation, as if 
+	//	the observations were appended one at a time
+	const PairGrid grid(binEdges, 0.0);
+	binStarts.assign(nBins+1, 0);
+	for (size_t j = 1; j < n; j++) {
+		for (size_t i = 0; i < j; i++) {
+			const size_t bin = grid.bin(fabs(times[j] - times[i]));
+			if (bin < nBins) {
+				binStarts[bin+1]++;
+			}
+		}
+	}
+	for (size_t bin = 0; bin < nBins; bin++) {
+		binStarts[bin+1] += binStarts[bin];
+	}
+	
+	first .resize(binStarts[nBins]);
+	second.resize(binStarts[nBins]);
+	vector<size_t> next(binStarts.begin(), binStarts.end() - 1);
+	for (size_t j = 1; j < n; j++) {
+		for (size_t i = 0; i < j; i++) {
+			const size_t bin = grid.bin(fabs(times[j] - times[i]));
+			if (bin < nBins) {
+				first [next[bin]] = static_cast<unsigned int>(i);
+				second[next[bin]] = static_cast<unsigned int>(j);
+				next[bin]++;
+			}
+		}
+	}
+}
+
+/** Finds the pairs of observations in each &Delta;t bin of a prefix 
+ *	of an indexed cadence
+ *
+ * Where the pairs of a bin of @p full are in order of their later 
+ * observation, the pairs of the prefix lead the bin, and are copied 
+ * without being binned again. Only the pairs in the last two bins 
+ * of the prefix, whose upper edge is the prefix's own, are compared 
+ * to @p binEdges; these bins are not in order of later observation.
+ *
+ * @param[in] full An index of a cadence that starts with @p times.
+ * @param[in] times The times of the observations.
+ * @param[in] binEdges The lower edge of each &Delta;t bin, as for 
+ *	dmdtBinQuantiles().
+ *
+ * @pre <tt>full.coversPrefix(times, binEdges)</tt>
+ *
+ * @post The object is the same as 
+ *	<tt>DmdtPairIndex(times, binEdges)</tt>, except for the order of 
+ *	pairs with the same later observation.
+ *
+ * @perform O(P + B log P) time, where P is the number of pairs in 
+ *	@p times and B the number of bins
+ * @perform O(P) memory
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the index.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+DmdtPairIndex::DmdtPairIndex(const DmdtPairIndex& full, 
+		const vector<double>& times, const vector<double>& binEdges) 
+		: times(times), binEdges(binEdges), streaming(false), 
+		binStarts(), sortedBins(binEdges.size() - 2), first(), second() {
+	const unsigned int n  = static_cast<unsigned int>(times.size());
+	const size_t nBins     = binEdges.size();
+	const size_t nFullBins = full.binEdges.size();
+	// Bins of full from here on may straddle the prefix's last edge
+	const size_t tail      = sortedBins;
+	const double lastEdge  = binEdges.back();
+	
+	// The pairs of the prefix are those whose later observation is in 
+	//	it, which lead each ordered bin of full
+	// Other bins must be searched pair by pair
+	const size_t leading = std::min(tail, full.sortedBins);
+	vector<size_t> ends(leading);
+	for (size_t bin = 0; bin < leading; bin++) {
+		ends[bin] = std::lower_bound(full.second.begin() + full.binStarts[bin], 
+			full.second.begin() + full.binStarts[bin+1], n) - full.second.begin();
+	}
+	
+	binStarts.assign(nBins+1, 0);
+	for (size_t bin = 0; bin < leading; bin++) {
+		binStarts[bin+1] = ends[bin] - full.binStarts[bin];
+	}
+	for (size_t bin = leading; bin < nFullBins; bin++) {
+		for (size_t p = full.binStarts[bin]; p < full.binStarts[bin+1]; p++) {
+			if (full.second[p] < n) {
+				const double deltaT = fabs(times[full.second[p]] - times[full.first[p]]);
+				const size_t newBin = (bin < tail ? bin 
+					: (deltaT >= lastEdge ? nBins-1 : tail));
+				binStarts[newBin+1]++;
+			}
+		}
+	}
+	for (size_t bin = 0; bin < nBins; bin++) {
+		binStarts[bin+1] += binStarts[bin];
+	}
+	
+	first .resize(binStarts[nBins]);
+	second.resize(binStarts[nBins]);
+	for (size_t bin = 0; bin < leading; bin++) {
+		std::copy(full.first .begin() + full.binStarts[bin], 
+			full.first .begin() + ends[bin], first .begin() + binStarts[bin]);
+		std::copy(full.second.begin() + full.binStarts[bin], 
+			full.second.begin() + ends[bin], second.begin() + binStarts[bin]);
+	}
+	vector<size_t> next(binStarts.begin(), binStarts.end() - 1);
+	for (size_t bin = leading; bin < nFullBins; bin++) {
+		for (size_t p = full.binStarts[bin]; p < full.binStarts[bin+1]; p++) {
+			if (full.second[p] < n) {
+				const double deltaT = fabs(times[full.second[p]] - times[full.first[p]]);
+				const size_t newBin = (bin < tail ? bin 
+					: (deltaT >= lastEdge ? nBins-1 : tail));
+				first [next[newBin]] = full.first [p];
+				second[next[newBin]] = full.second[p];
+				next[newBin]++;
+			}
+		}
+	}
+}
+
+/** Tests whether an index for a prefix of the cadence can be derived 
+ *	from this one
+ *
+ * @param[in] prefixTimes The times of the observations of the prefix.
+ * @param[in] prefixEdges The lower edge of each &Delta;t bin of the 
+ *	prefix, as for dmdtBinQuantiles().
+ *
+ * @return True if the object indexes its pairs, @p prefixTimes is a 
+ *	leading part of the indexed times, and @p prefixEdges has at least 
+ *	two edges, all but the last of which are indexed edges.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool DmdtPairIndex::coversPrefix(const vector<double>& prefixTimes, 
+		const vector<double>& prefixEdges) const {
+	if (streaming || prefixEdges.size() < 2 
+			|| prefixTimes.size() > times.size() 
+			|| prefixEdges.size() - 1 > binEdges.size()) {
+		return false;
+	}
+	return std::equal(prefixTimes.begin(), prefixTimes.end(), times.begin()) 
+		&& std::equal(prefixEdges.begin(), prefixEdges.end() - 1, binEdges.begin());
+}
+
+/** Returns an index for a cadence, reusing the last index if possible
+ *
+ * @param[in] times The times of the observations.
+ * @param[in] binEdges The lower edge of each &Delta;t bin, as for 
+ *	dmdtBinQuantiles().
+ *
+ * @return An index for @p times and @p binEdges. If one of the last 
+ *	two indices on the same NUMA node had the same arguments, it is 
+ *	returned again. If an index on another node had the same 
+ *	arguments, a copy of it is returned. If @p times starts an indexed 
+ *	cadence of the same node, as when a survey is studied on several 
+ *	baselines, the new index is derived from it.
+ *
+ * @pre @p times contains no NaNs
+ * @pre @p binEdges is sorted in ascending order
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create a new index.
+ *
+ * @exceptsafe The cache is unchanged in the event of an exception.
+ */
+shared_ptr<const DmdtPairIndex> DmdtPairIndex::forCadence(
+		const vector<double>& times, const vector<double>& binEdges) {
+	static boost::mutex cacheLock;
+	// Two indices per NUMA node, so that pinned threads read local memory
+	// Indices built from scratch are kept apart from those derived 
+	//	from them, so that the prefixes of a cadence do not evict it
+	static vector<shared_ptr<const DmdtPairIndex> > roots  (utils::numaNodeCount());
+	static vector<shared_ptr<const DmdtPairIndex> > derived(utils::numaNodeCount());
+	static utils::CacheCounter counter("Dmdt pair indices");
+
+	const size_t node = utils::currentNumaNode();
+	shared_ptr<const DmdtPairIndex> replica, parent;
+	bool replicaDerived = false;
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		for(size_t i = 0; i < roots.size(); i++) {
+			for(int slot = 0; slot < 2; slot++) {
+				const shared_ptr<const DmdtPairIndex>& cached = 
+					(slot == 0 ? roots[i] : derived[i]);
+				if (cached.get() != NULL && cached->times == times 
+						&& cached->binEdges == binEdges) {
+					if (i == node) {
+						counter.hit();
+						return cached;
+					}
+					replica = cached;
+					replicaDerived = (slot != 0);
+				}
+			}
+		}
+		if (replica.get() == NULL) {
+			if (roots[node].get() != NULL 
+					&& roots[node]->coversPrefix(times, binEdges)) {
+				parent = roots[node];
+			} else if (derived[node].get() != NULL 
+					&& derived[node]->coversPrefix(times, binEdges)) {
+				parent = derived[node];
+			}
+		}
+	}
+
+	const utils::CacheMiss miss(counter);
+
+	// Don't hold the lock while building the index, so that threads
+	//	working on other cadences are not blocked
+	// Copying another node's index, or deriving one from a longer 
+	//	cadence, is cheaper than building it
+	shared_ptr<const DmdtPairIndex> index;
+	if (replica.get() != NULL) {
+		index.reset(new DmdtPairIndex(*replica));
+	} else if (parent.get() != NULL) {
+		index.reset(new DmdtPairIndex(*parent, times, binEdges));
+	} else {
+		index.reset(new DmdtPairIndex(times, binEdges));
+	}
+
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		if (parent.get() != NULL || replicaDerived) {
+			derived[node] = index;
+		} else {
+			roots[node] = index;
+		}
+	}
+	return index;
+}
+
+/** Calculates quantiles of &Delta;m in each &Delta;t bin
+ *
+ * @param[in] mags The magnitude at each of the indexed times.
+ * @param[in] quantiles The quantiles of &Delta;m to calculate in each bin.
+ * @param[out] results For each element of @p quantiles, a vector 
+ *	with that quantile of &Delta;m for each bin.
+ *
+ * @pre @p mags contains no NaNs
+ * @pre All elements of @p quantiles are in [0, 1]
+ *
+ * @post @p results is the same as given by dmdtBinQuantiles().
+ *
+ * @perform O(P) time, where P is the number of indexed pairs, or the 
+ *	performance of dmdtBinQuantiles() if the cadence was not indexed
+ * @perform O(P<sub>max</sub>) temporary memory, where P<sub>max</sub> 
+ *	is the number of pairs in the largest bin
+ *
+ * @exception std::invalid_argument Thrown if @p mags does not have one 
+ *	value for each indexed time.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	calculate the quantiles.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void DmdtPairIndex::binQuantiles(const vector<double>& mags, 
+		const vector<double>& quantiles, vector<vector<double> >& results) const {
+	if (streaming) {
+		dmdtBinQuantiles(times, mags, binEdges, quantiles, results);
+		return;
+	}
+	if (mags.size() != times.size()) {
+		throw std::invalid_argument("Times and magnitudes must have the same length in binQuantiles() (gave "
+			+ lexical_cast<string>(times.size()) + " for times and "
+			+ lexical_cast<string>(mags.size()) + " for magnitudes).");
+	}
+	const size_t nBins  = binEdges.size();
+	const size_t nQuant = quantiles.size();
+	
+	size_t maxPairs = 0;
+	for (size_t bin = 0; bin < nBins; bin++) {
+		maxPairs = std::max(maxPairs, binStarts[bin+1] - binStarts[bin]);
+	}
+	// The largest temporary of the dmdt statistics, so it is kept 
+	//	between light curves
+	ScratchVector deltaBuffer(maxPairs);
+	vector<double>& deltaM = deltaBuffer.get();
+	vector<size_t> ranks;
+	ranks.reserve(2*nQuant);
+	
+	vector<vector<double> > temp(nQuant, 
+		vector<double>(nBins, std::numeric_limits<double>::quiet_NaN()));
+	for (size_t bin = 0; bin < nBins; bin++) {
+		const size_t start = binStarts[bin];
+		const size_t count = binStarts[bin+1] - start;
+		if (count == 0) {
+			continue;
+		}
+		
+		absDifferences(&mags[0], &first[start], &second[start], count, &deltaM[0]);
+		
+		// Select every rank needed, in ascending order, so that each 
+		//	selection only searches above the previous one
+		ranks.clear();
+		for (size_t q = 0; q < nQuant; q++) {
+			const double pos = quantiles[q] * (count - 1);
+			ranks.push_back(static_cast<size_t>(floor(pos)));
+			ranks.push_back(static_cast<size_t>(ceil (pos)));
+		}
+		std::sort(ranks.begin(), ranks.end());
+		size_t from = 0;
+		for (size_t r = 0; r < ranks.size(); r++) {
+			if (ranks[r] >= from) {
+				std::nth_element(deltaM.begin() + from, deltaM.begin() + ranks[r], 
+					deltaM.begin() + count);
+				from = ranks[r] + 1;
+			}
+		}
+		
+		for (size_t q = 0; q < nQuant; q++) {
+			const double pos  = quantiles[q] * (count - 1);
+			const double low  = deltaM[static_cast<size_t>(floor(pos))];
+			const double high = deltaM[static_cast<size_t>(ceil (pos))];
+			temp[q][bin] = interpolateRank(low, high, pos);
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	results.swap(temp);
+}
+
+}}		// end lcmc::stats
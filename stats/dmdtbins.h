@@ -0,0 +1,94 @@
+/** Binned Delta-m Delta-t quantiles computed without storing every pair
+ * @file lightcurveMC/stats/dmdtbins.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCDMDTBINSH
+#define LCMCDMDTBINSH
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "../largealloc.tmp.h"
+
+namespace lcmc { namespace stats {
+
+/** Calculates quantiles of &Delta;m in bins of &Delta;t, streaming over 
+ *	the pairs of observations
+ */
+void dmdtBinQuantiles(const std::vector<double>& times, 
+		const std::vector<double>& mags, const std::vector<double>& binEdges, 
+		const std::vector<double>& quantiles, 
+		std::vector<std::vector<double> >& results);
+
+/** Stores which pairs of observations fall in each &Delta;t bin, for a 
+ *	fixed cadence.
+ *
+ * In a simulation, every light curve in a bin has the same times, so 
+ * only &Delta;m changes from one light curve to the next. The index lists 
+ * the pairs in each bin in compressed sparse row form, so that computing 
+ * &Delta;m quantiles needs no &Delta;t arithmetic or bin search.
+ *
+ * If the cadence has too many pairs to index, the object stores nothing 
+ * and binQuantiles() falls back to dmdtBinQuantiles(). The pairs are 
+ * allocated by utils::largeAlloc(), since every light curve reads all 
+ * of them.
+ *
+ * The pairs of each bin are stored in order of their later observation, 
+ * so an index for a prefix of the cadence can be derived by taking the 
+ * leading pairs of each bin, without searching the bins again.
+ *
+ * Indices are immutable once created, and may be shared between threads.
+ */
+class DmdtPairIndex {
+public:
+	/** Finds the pairs of observations in each &Delta;t bin
+	 */
+	DmdtPairIndex(const std::vector<double>& times, 
+		const std::vector<double>& binEdges);
+
+	/** Finds the pairs of observations in each &Delta;t bin of a 
+	 *	prefix of an indexed cadence
+	 */
+	DmdtPairIndex(const DmdtPairIndex& full, const std::vector<double>& times, 
+		const std::vector<double>& binEdges);
+
+	/** Returns an index for a cadence, reusing the last index if possible
+	 */
+	static boost::shared_ptr<const DmdtPairIndex> forCadence(
+		const std::vector<double>& times, const std::vector<double>& binEdges);
+
+	/** Calculates quantiles of &Delta;m in each &Delta;t bin
+	 */
+	void binQuantiles(const std::vector<double>& mags, 
+		const std::vector<double>& quantiles, 
+		std::vector<std::vector<double> >& results) const;
+
+	/** Tests whether an index for a prefix of the cadence can be 
+	 *	derived from this one
+	 */
+	bool coversPrefix(const std::vector<double>& prefixTimes, 
+		const std::vector<double>& prefixEdges) const;
+
+private:
+	std::vector<double> times;
+	std::vector<double> binEdges;
+
+	/** True if the pairs were too numerous to index */
+	bool streaming;
+	/** The first pair of each bin in @ref first and @ref second, plus 
+	 *	the total number of pairs */
+	std::vector<size_t> binStarts;
+	/** The number of leading bins whose pairs are in order of their 
+	 *	later observation */
+	size_t sortedBins;
+	/** The earlier observation of each pair, grouped by bin */
+	utils::LargeVector<unsigned int>::type first;
+	/** The later observation of each pair, grouped by bin */
+	utils::LargeVector<unsigned int>::type second;
+};
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCDMDTBINSH
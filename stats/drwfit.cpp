@@ -0,0 +1,527 @@
+/** Linear-time fitting of damped random walk models to data
+ * @file lightcurveMC/stats/drwfit.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cmath>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_multimin.h>
+#include <gsl/gsl_statistics_double.h>
+#include <gsl/gsl_vector.h>
+#include "../../common/alloc.tmp.h"
+#include "../../common/nan.h"
+#include "../except/undefined.h"
+#include "../gsl_compat.h"
+#include "deadline.h"
+#include "drwfit.h"
+
+namespace lcmc { namespace stats {
+
+using std::string;
+using std::vector;
+using boost::lexical_cast;
+using boost::shared_ptr;
+using kpfutils::checkAlloc;
+
+/** The number of hyperparameters of the model: the logarithms of the
+ *	timescale and variance of the exponential kernel, and of the
+ *	white noise variance, in that order
+ */
+const size_t DRW_NPARAM = 3;
+
+/** The most simplex steps to take before giving up on a fit
+ */
+const size_t DRW_MAXITER = 1000;
+
+/** The size of the simplex, in log-hyperparameters, at which a fit
+ *	is considered converged
+ */
+const double DRW_SIZETOL = 1e-5;
+
+/** The step, in log-hyperparameters, used to estimate the Hessian
+ *	of the likelihood
+ */
+const double DRW_HESSSTEP = 1e-3;
+
+/** Computes the negative log likelihood of a sorted light curve under
+ *	a sum of exponential kernels plus white noise
+ *
+ * The covariance matrix of such a process is semiseparable, so its
+ * LDL<sup>T</sup> factorization can be found and applied one
+ * observation at a time, as in the celerite algorithm of
+ * Foreman-Mackey et al. (2017): each term of the kernel carries a
+ * J-dimensional state between consecutive observations, where J is
+ * the number of terms.
+ *
+ * @param[in] times The times at which the light curve was sampled,
+ *	in ascending order.
+ * @param[in] data The values of the light curve.
+ * @param[in] amps The variance of each exponential term.
+ * @param[in] rates The inverse timescale of each exponential term.
+ * @param[in] noise The variance of the white noise.
+ *
+ * @return The negative log likelihood.
+ *
+ * @pre @p times.size() = @p data.size() &ge; 1
+ * @pre @p amps.size() = @p rates.size()
+ * @pre @p times is sorted in ascending order
+ *
+ * @perform O(N J<sup>2</sup>) time, where N = @p times.size() and
+ *	J = @p amps.size()
+ * @perfmore O(J<sup>2</sup>) memory
+ *
+ * @exception std::runtime_error Thrown if the covariance matrix is
+ *	not positive definite.
+ * @exception std::bad_alloc Thrown if there is not enough memory for
+ *	the calculation.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of
+ *	an exception.
+ */
+double expKernelNll(const vector<double>& times, const vector<double>& data,
+		const vector<double>& amps, const vector<double>& rates,
+		double noise) {
+	const size_t n = times.size();
+	const size_t nTerms = amps.size();
+
+	double diagonal = noise;
+	for(size_t j = 0; j < nTerms; j++) {
+		diagonal += amps[j];
+	}
+
+	// s = the covariance of the state given the previous observations
+	// f = the state given the previous observations
+	// w = the contribution of the last observation to the next state
+	vector<double> s(nTerms*nTerms, 0.0), f(nTerms, 0.0), w(nTerms),
+		su(nTerms), phi(nTerms);
+
+	double d = diagonal;
+	double z = data[0];
+	if (!(d > 0.0)) {
+		throw std::runtime_error("In expKernelNll(), covariance matrix is not positive definite.");
+	}
+	for(size_t j = 0; j < nTerms; j++) {
+		w[j] = 1.0 / d;
+	}
+	double nll = 0.5 * (z*z/d + log(d));
+
+	for(size_t i = 1; i < n; i++) {
+		const double lag = times[i] - times[i-1];
+		for(size_t j = 0; j < nTerms; j++) {
+			phi[j] = exp(-rates[j] * lag);
+		}
+		for(size_t j = 0; j < nTerms; j++) {
+			for(size_t k = 0; k < nTerms; k++) {
+				s[j*nTerms+k] = phi[j] * phi[k]
+					* (s[j*nTerms+k] + d * w[j] * w[k]);
+			}
+			f[j] = phi[j] * (f[j] + w[j] * z);
+		}
+
+		d = diagonal;
+		z = data[i];
+		for(size_t j = 0; j < nTerms; j++) {
+			su[j] = 0.0;
+			for(size_t k = 0; k < nTerms; k++) {
+				su[j] += s[j*nTerms+k] * amps[k];
+			}
+			d -= amps[j] * su[j];
+			z -= amps[j] * f[j];
+		}
+		if (!(d > 0.0)) {
+			throw std::runtime_error("In expKernelNll(), covariance matrix is not positive definite.");
+		}
+		for(size_t j = 0; j < nTerms; j++) {
+			w[j] = (1.0 - su[j]) / d;
+		}
+
+		nll += 0.5 * (z*z/d + log(d));
+	}
+
+	return nll + 0.5 * static_cast<double>(n) * log(2.0 * M_PI);
+}
+
+/** Computes the log likelihood of a light curve under a Gaussian process
+ *	with a sum of exponential kernels plus white noise, in linear time
+ *
+ * The kernel is @f$ \sum_j a_j e^{-|\Delta t|/\tau_j} + \sigma_n^2 \delta_{ij} @f$.
+ * A single term is a damped random walk.
+ *
+ * @param[in] times The times at which the light curve was sampled,
+ *	in ascending order.
+ * @param[in] data The values of the light curve.
+ * @param[in] amps The variance @f$ a_j @f$ of each exponential term.
+ * @param[in] timescales The timescale @f$ \tau_j @f$ of each exponential term.
+ * @param[in] noise The variance @f$ \sigma_n^2 @f$ of the white noise.
+ *
+ * @return The log likelihood of @p data.
+ *
+ * @pre Neither @p times nor @p data may contain NaNs
+ *
+ * @perform O(N J<sup>2</sup>) time, where N = @p times.size() and
+ *	J = @p amps.size()
+ * @perfmore O(J<sup>2</sup>) memory
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times is empty.
+ * @exception std::invalid_argument Thrown if @p times and @p data, or
+ *	@p amps and @p timescales, do not have the same length, if @p times
+ *	is not sorted, or if any variance is negative or any timescale
+ *	is not positive.
+ * @exception std::runtime_error Thrown if the covariance matrix is
+ *	not positive definite.
+ * @exception std::bad_alloc Thrown if there is not enough memory for
+ *	the calculation.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of
+ *	an exception.
+ */
+double expKernelLogLike(const vector<double>& times, const vector<double>& data,
+		const vector<double>& amps, const vector<double>& timescales,
+		double noise) {
+	if (times.empty()) {
+		throw except::NotEnoughData("Cannot compute likelihood of an empty light curve.");
+	}
+	if (times.size() != data.size()) {
+		throw std::invalid_argument("Data and time arrays passed to expKernelLogLike() must have the same length (gave "
+			+ lexical_cast<string>(times.size()) + " for times and "
+			+ lexical_cast<string>( data.size()) + " for data)");
+	}
+	if (amps.size() != timescales.size()) {
+		throw std::invalid_argument("Amplitude and timescale arrays passed to expKernelLogLike() must have the same length (gave "
+			+ lexical_cast<string>(amps.size()) + " for amplitudes and "
+			+ lexical_cast<string>(timescales.size()) + " for timescales)");
+	}
+	for(size_t i = 1; i < times.size(); i++) {
+		if (times[i] < times[i-1]) {
+			throw std::invalid_argument("Times passed to expKernelLogLike() must be in ascending order.");
+		}
+	}
+	if (!(noise >= 0.0)) {
+		throw std::invalid_argument("Noise variance passed to expKernelLogLike() must be nonnegative (gave "
+			+ lexical_cast<string>(noise) + ")");
+	}
+	vector<double> rates;
+	for(size_t j = 0; j < amps.size(); j++) {
+		if (!(amps[j] >= 0.0)) {
+			throw std::invalid_argument("Variances passed to expKernelLogLike() must be nonnegative (gave "
+				+ lexical_cast<string>(amps[j]) + ")");
+		}
+		if (!(timescales[j] > 0.0)) {
+			throw std::invalid_argument("Timescales passed to expKernelLogLike() must be positive (gave "
+				+ lexical_cast<string>(timescales[j]) + ")");
+		}
+		rates.push_back(1.0 / timescales[j]);
+	}
+
+	return -expKernelNll(times, data, amps, rates, noise);
+}
+
+/** DrwLikelihood evaluates the marginal likelihood of a damped random
+ * walk plus white noise model for a fixed light curve.
+ *
+ * The hyperparameters are @f$ a = \ln \tau @f$, @f$ b = \ln \sigma^2 @f$
+ * and @f$ c = \ln \sigma_n^2 @f$, where the kernel is
+ * @f$ \sigma^2 e^{-|\Delta t|/\tau} + \sigma_n^2 \delta_{ij} @f$ and
+ * the data are shifted and scaled to zero mean and unit variance.
+ */
+class DrwLikelihood {
+public:
+	/** Prepares to fit a light curve
+	 *
+	 * @param[in] times The times at which the light curve was sampled.
+	 * @param[in] data The values of the light curve.
+	 *
+	 * @pre @p times.size() = @p data.size() &ge; 2
+	 *
+	 * @exception std::runtime_error Thrown if @p data has no variance
+	 *	or @p times has only one distinct value.
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	store the light curve.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	DrwLikelihood(const vector<double>& times, const vector<double>& data)
+			: t(), y() {
+		const size_t n = times.size();
+
+		// Same normalization as the Gaussian process fits
+		const double mean = gsl_stats_mean(&data[0], 1, n);
+		const double sd   = gsl_stats_sd  (&data[0], 1, n);
+		if (!(sd > 0.0)) {
+			throw std::runtime_error("In fitDrw(), light curve has no variability.");
+		}
+
+		// The solver needs the observations in time order
+		vector<std::pair<double, double> > sorted;
+		sorted.reserve(n);
+		for(size_t i = 0; i < n; i++) {
+			sorted.push_back(std::make_pair(times[i], (data[i] - mean) / sd));
+		}
+		std::sort(sorted.begin(), sorted.end());
+		if (!(sorted.back().first > sorted.front().first)) {
+			throw std::runtime_error("In fitDrw(), light curve has only one distinct time.");
+		}
+
+		t.reserve(n);
+		y.reserve(n);
+		for(size_t i = 0; i < n; i++) {
+			t.push_back(sorted[i].first);
+			y.push_back(sorted[i].second);
+		}
+	}
+
+	/** Returns a timescale from which to start the fit
+	 *
+	 * @return The geometric mean of the mean sampling interval
+	 *	and the length of the light curve.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	double startTime() const {
+		const double baseline = t.back() - t.front();
+		return baseline / sqrt(static_cast<double>(t.size() - 1));
+	}
+
+	/** Computes the negative log likelihood of the light curve
+	 *
+	 * @param[in] p The hyperparameters (a, b, c).
+	 *
+	 * @return The negative log likelihood.
+	 *
+	 * @perform O(N) time, where N is the length of the light curve
+	 *
+	 * @exception std::runtime_error Thrown if the covariance matrix
+	 *	is not positive definite.
+	 * @exception std::bad_alloc Thrown if there is not enough memory
+	 *	for the calculation.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception.
+	 */
+	double negLogLike(const double p[]) const {
+		const vector<double> amps (1, exp( p[1]));
+		const vector<double> rates(1, exp(-p[0]));
+		return expKernelNll(t, y, amps, rates, exp(p[2]));
+	}
+
+private:
+	/** The sorted times */
+	vector<double> t;
+	/** The normalized light curve, in time order */
+	vector<double> y;
+};
+
+/** State shared with the GSL minimizer callback
+ *
+ * GSL is a C library, so the callback must not throw. Running out of
+ * memory is recorded here and rethrown once the minimizer returns.
+ */
+struct DrwMinimizerState {
+	/** The likelihood to minimize */
+	const DrwLikelihood* model;
+	/** True if the callback ran out of memory */
+	bool outOfMemory;
+};
+
+/** Evaluates the negative log likelihood for GSL
+ *
+ * @param[in] x The hyperparameters.
+ * @param[in] params A pointer to a DrwMinimizerState.
+ *
+ * @return The negative log likelihood, or infinity if it could not
+ *	be computed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+extern "C" double drwNllF(const gsl_vector* x, void* params) {
+	DrwMinimizerState* state = static_cast<DrwMinimizerState*>(params);
+	const double p[DRW_NPARAM] = {gsl_vector_get(x, 0), gsl_vector_get(x, 1),
+		gsl_vector_get(x, 2)};
+	// Keep the simplex away from hyperparameters that over- or
+	//	underflow, where the likelihood is flat anyway
+	for(size_t i = 0; i < DRW_NPARAM; i++) {
+		if (!(fabs(p[i]) < 50.0)) {
+			return GSL_POSINF;
+		}
+	}
+	try {
+		return state->model->negLogLike(p);
+	} catch (const std::bad_alloc& e) {
+		state->outOfMemory = true;
+		return GSL_POSINF;
+	} catch (const std::runtime_error& e) {
+		return GSL_POSINF;
+	}
+}
+
+/** Finds the best fit solution to a damped random walk model
+ *
+ * A damped random walk (exponential kernel) plus white noise is fit
+ * to the light curve, normalized to unit variance. Because the
+ * covariance matrix of this model is semiseparable, each evaluation
+ * of the likelihood takes linear rather than cubic time. The
+ * likelihood is maximized by the Nelder-Mead simplex method, and
+ * the timescale error is found from the numerical Hessian of the
+ * likelihood with respect to the logarithms of the hyperparameters.
+ *
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve (typically fluxes or magnitudes)
+ * @param[out] timescale The best-fit value of the damping timescale
+ * @param[out] timeError The estimated uncertainty on the damping timescale
+ *
+ * @pre @p times contains at least two unique values
+ * @pre @p times.size() = @p data.size()
+ * @pre for all i, @p data[i] is the measurement taken at @p time[i]
+ * @pre Neither @p times nor @p data may contain NaNs
+ *
+ * @post @p timescale and @p timeError contain the best-fit estimate
+ *	of the damping timescale for a damped random walk model
+ * @post @p timescale > 0
+ * @post @p timeError > 0
+ *
+ * @perform O(N log N) time, where N = @p times.size()
+ * @perfmore O(N) memory
+ * @perfmore May be called from several threads at once.
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times and @p data do
+ *	not have at least two values.
+ * @exception std::invalid_argument Thrown if @p times and @p data
+ *	do not have the same length.
+ * @exception std::runtime_error Thrown if the fit does not converge to
+ *	a likelihood maximum.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit
+ *	the model.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of
+ *	an exception.
+ */
+void fitDrw(const vector<double>& times, const vector<double>& data,
+		double& timescale, double& timeError) {
+	if (times.size() < 2) {
+		throw except::NotEnoughData("Cannot fit damped random walk model with fewer than 2 data points (gave "
+			+ lexical_cast<string>(times.size()) + ").");
+	}
+	if (times.size() != data.size()) {
+		throw std::invalid_argument("Data and time arrays passed to fitDrw() must have the same length (gave "
+			+ lexical_cast<string>(times.size()) + " for times and "
+			+ lexical_cast<string>( data.size()) + " for data)");
+	}
+
+	const DrwLikelihood model(times, data);
+	DrwMinimizerState state = {&model, false};
+
+	gsl_multimin_function objective;
+	objective.n      = DRW_NPARAM;
+	objective.f      = &drwNllF;
+	objective.params = &state;
+
+	// Same default variances as the Gaussian process fits
+	shared_ptr<gsl_vector> x0(checkAlloc(gsl_vector_alloc(DRW_NPARAM)),
+		&gsl_vector_free);
+	gsl_vector_set(x0.get(), 0, log(model.startTime()));
+	gsl_vector_set(x0.get(), 1,  0.0);
+	gsl_vector_set(x0.get(), 2, -2.0);
+	shared_ptr<gsl_vector> steps(checkAlloc(gsl_vector_alloc(DRW_NPARAM)),
+		&gsl_vector_free);
+	gsl_vector_set_all(steps.get(), 1.0);
+
+	shared_ptr<gsl_multimin_fminimizer> minimizer(checkAlloc(
+		gsl_multimin_fminimizer_alloc(gsl_multimin_fminimizer_nmsimplex2,
+		DRW_NPARAM)), &gsl_multimin_fminimizer_free);
+	gslCheck(gsl_multimin_fminimizer_set(minimizer.get(), &objective, x0.get(),
+		steps.get()), "In fitDrw(): ");
+
+	bool converged = false;
+	for(size_t iter = 0; iter < DRW_MAXITER && !converged; iter++) {
+		checkDeadline();
+		const int status = gsl_multimin_fminimizer_iterate(minimizer.get());
+		if (state.outOfMemory) {
+			throw std::bad_alloc();
+		}
+		if (status != GSL_SUCCESS) {
+			break;
+		}
+		converged = (gsl_multimin_test_size(
+			gsl_multimin_fminimizer_size(minimizer.get()), DRW_SIZETOL)
+			== GSL_SUCCESS);
+	}
+	if (!converged) {
+		throw std::runtime_error("In fitDrw(), optimizer did not converge to a likelihood maximum.");
+	}
+
+	double p[DRW_NPARAM] = {gsl_vector_get(minimizer->x, 0),
+		gsl_vector_get(minimizer->x, 1), gsl_vector_get(minimizer->x, 2)};
+
+	// Central differences; each evaluation takes only O(N) time
+	double h[DRW_NPARAM*DRW_NPARAM];
+	const double f0 = model.negLogLike(p);
+	const double step = DRW_HESSSTEP;
+	for(size_t i = 0; i < DRW_NPARAM; i++) {
+		p[i] += step;
+		const double fPlus  = model.negLogLike(p);
+		p[i] -= 2.0*step;
+		const double fMinus = model.negLogLike(p);
+		p[i] += step;
+		h[i*DRW_NPARAM+i] = (fPlus - 2.0*f0 + fMinus) / (step*step);
+
+		for(size_t j = 0; j < i; j++) {
+			double fCross[4];
+			for(size_t k = 0; k < 4; k++) {
+				const double di = (k < 2      ? step : -step);
+				const double dj = (k % 2 == 0 ? step : -step);
+				p[i] += di;
+				p[j] += dj;
+				fCross[k] = model.negLogLike(p);
+				p[i] -= di;
+				p[j] -= dj;
+			}
+			h[i*DRW_NPARAM+j] = h[j*DRW_NPARAM+i]
+				= (fCross[0] - fCross[1] - fCross[2] + fCross[3])
+				/ (4.0*step*step);
+		}
+	}
+
+	// Only need the (a, a) element of the inverse Hessian
+	double det, covarA;
+	if (fabs(h[8]) > 1e-8 * (fabs(h[0]) + fabs(h[4]))) {
+		det = h[0]*(h[4]*h[8] - h[5]*h[7])
+			- h[1]*(h[3]*h[8] - h[5]*h[6])
+			+ h[2]*(h[3]*h[7] - h[4]*h[6]);
+		covarA = (h[4]*h[8] - h[5]*h[7]) / det;
+	} else {
+		// A well-sampled walk can absorb all the white noise, leaving 
+		//	the likelihood flat in c; treat the noise as fixed
+		det = h[0]*h[4] - h[1]*h[3];
+		covarA = h[4] / det;
+	}
+	if (!(covarA > 0.0) || !(det > 0.0)) {
+		throw std::runtime_error("In fitDrw(), Hessian matrix is not positive definite. This probably means the fit is not a local likelihood maximum.");
+	}
+
+	// a = ln tau, so dtau = tau d(ln tau)
+	const double tempTime = exp(p[0]);
+	const double tempErr  = sqrt(covarA) * tempTime;
+	if (kpfutils::isNan(tempTime) || kpfutils::isNan(tempErr)) {
+		throw std::runtime_error("In fitDrw(), time scale or its error was NaN");
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	timescale = tempTime;
+	timeError = tempErr;
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,31 @@
+/** Functions for fitting damped random walk models to data
+ * @file lightcurveMC/stats/drwfit.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCDRWFITH
+#define LCMCDRWFITH
+
+#include <vector>
+
+namespace lcmc { namespace stats {
+
+using std::vector;
+
+/** Computes the log likelihood of a light curve under a Gaussian process
+ *	with a sum of exponential kernels plus white noise, in linear time
+ */
+double expKernelLogLike(const vector<double>& times, const vector<double>& data,
+		const vector<double>& amps, const vector<double>& timescales,
+		double noise);
+
+/** Finds the best fit solution to a damped random walk model
+ */
+void fitDrw(const vector<double>& times, const vector<double>& data,
+		double& timescale, double& timeError);
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCDRWFITH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/experimental.cpp
  * @author Krzysztof Findeisen
  * @date Created August 3, 2011
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -33,6 +33,7 @@
 #include <utility>
 #include <vector>
 #include <cmath>
+#include <limits>
 #include <boost/lexical_cast.hpp>
 #include "experimental.h"
 #include "../except/data.h"
@@ -42,6 +43,121 @@ namespace lcmc { namespace stats {
 
 using boost::lexical_cast;
 
+/** Checks the lengths of the arguments common to the RMS functions
+ *
+ * @param[in] times, fluxes The light curve to check.
+ * @param[in] caller The name of the function, for error messages.
+ *
+ * @exception std::invalid_argument Thrown if @p times is insufficiently long 
+ *	or if @p fluxes has a different length from @p times
+ *
+ * @exceptsafe Does not change the program state.
+ */
+void checkRmsLengths(const DoubleVec &times, const DoubleVec &fluxes, 
+		const std::string& caller) {
+	size_t nData = times.size();
+	
+	if(nData < 2) {
+		throw std::invalid_argument("Can't take RMS over a light curve of less than 2 points (gave " 
+		+ lexical_cast<std::string>(nData) + ")");
+	}
+	if(nData != fluxes.size()) {
+		throw std::invalid_argument("Times and fluxes have different lengths in " 
+		+ caller + "() (gave " 
+		+ lexical_cast<std::string>(nData) + " for times and " 
+		+ lexical_cast<std::string>(fluxes.size()) + " for fluxes)");
+	}
+}
+
+/** Checks the arguments common to the RMS functions
+ *
+ * @param[in] times, fluxes The light curve to check.
+ * @param[in] caller The name of the function, for error messages.
+ *
+ * @exception std::invalid_argument Thrown if @p times is insufficiently long 
+ *	or if @p fluxes has a different length from @p times
+ * @exception kpfutils::except::NotSorted Thrown if @p times is unsorted.
+ *
+ * @exceptsafe Does not change the program state.
+ */
+void checkRmsInput(const DoubleVec &times, const DoubleVec &fluxes, 
+		const std::string& caller) {
+	checkRmsLengths(times, fluxes, caller);
+	if (!kpfutils::isSorted(times.begin(), times.end())) {
+		throw kpfutils::except::NotSorted("times is not sorted in " + caller + "()");
+	}
+}
+
+/** Running mean and variance of a growing sample
+ *
+ * Welford's update keeps the sum of squared deviations directly, so 
+ * the variance does not suffer the cancellation of the sum-of-squares 
+ * formula when the mean is large compared to the scatter.
+ */
+class RunningVariance {
+public:
+	RunningVariance() : n(0), mean(0.0), sumSqDev(0.0) {}
+	
+	/** Adds one value to the sample */
+	void add(double x) {
+		n++;
+		const double delta = x - mean;
+		mean += delta / static_cast<double>(n);
+		sumSqDev += delta * (x - mean);
+	}
+	
+	/** Returns the unbiased variance of the sample, which must have 
+	 *	at least two values */
+	double variance() const {
+		return sumSqDev / static_cast<double>(n - 1);
+	}
+	
+private:
+	size_t n;
+	double mean;
+	double sumSqDev;
+};
+
+/** Calculates the RMS over subintervals starting at the first data 
+ *	point, without checking the input
+ *
+ * @see rmsVsTRooted(const DoubleVec&, const DoubleVec&, DoubleVec&, DoubleVec&)
+ *
+ * @pre The input has been checked by checkRmsLengths().
+ * @pre @p times is sorted in ascending order
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to do the 
+ *	calculations.
+ *
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void rootedRms(const DoubleVec &times, const DoubleVec &fluxes, 
+		DoubleVec &timeSteps, DoubleVec & rmsValues) {
+	using std::swap;
+	
+	size_t nData = times.size();
+	
+	// copy-and-swap
+	DoubleVec tempSteps, tempRms;
+	tempSteps.reserve(nData-1);
+	tempRms  .reserve(nData-1);
+	
+	// Each subinterval extends the previous one by a single point
+	RunningVariance running;
+	running.add(fluxes[0]);
+	for(size_t last = 1; last < nData; last++) {
+		running.add(fluxes[last]);
+		tempSteps.push_back(times[last] - times[0]);
+		tempRms.push_back(sqrt(running.variance()));
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+
+	swap(timeSteps, tempSteps);
+	swap(rmsValues, tempRms);
+}
+
 /** Calculates the RMS binned over ever-larger subintervals of the data. rmsVsTRooted() 
  *	considers only subintervals from the first data point to some later point
  * 
@@ -62,7 +178,7 @@ using boost::lexical_cast;
  * @post @p timeSteps is sorted in ascending order
  * @post if N = @p times.size(), @p timeSteps.size() = @p rmsValues.size() = N-1
  *
- * @perform O(N<sup>2</sup>) time, where N = @p times.size()
+ * @perform O(N) time, where N = @p times.size()
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to do the 
  *	calculations.
@@ -75,39 +191,31 @@ using boost::lexical_cast;
  */
 void rmsVsTRooted(const DoubleVec &times, const DoubleVec &fluxes, 
 		DoubleVec &timeSteps, DoubleVec & rmsValues) {
-	using std::swap;
-	
-	size_t nData = times.size();
-	
-	if(nData < 2) {
-		throw std::invalid_argument("Can't take RMS over a light curve of less than 2 points (gave " 
-		+ lexical_cast<std::string>(nData) + ")");
-	}
-	if(nData != fluxes.size()) {
-		throw std::invalid_argument("Times and fluxes have different lengths in rmsVsTRooted() (gave " 
-		+ lexical_cast<std::string>(nData) + " for times and " 
-		+ lexical_cast<std::string>(fluxes.size()) + " for fluxes)");
-	}
-	if (!kpfutils::isSorted(times.begin(), times.end())) {
-		throw kpfutils::except::NotSorted("times is not sorted in rmsVsTRooted()");
-	}
-	
-	// copy-and-swap
-	DoubleVec tempSteps, tempRms;
-	tempSteps.reserve(nData-1);
-	tempRms  .reserve(nData-1);
-	
-	// Do the RMS calculations
-	for(size_t length = 2; length <= nData; length++) {
-		double var = kpfutils::variance(fluxes.begin(), fluxes.begin()+length);
-		tempSteps.push_back(times[length-1] - times[0]);
-		tempRms.push_back(sqrt(var));
-	}
-	
-	// IMPORTANT: no exceptions beyond this point
+	checkRmsInput(times, fluxes, "rmsVsTRooted");
+	rootedRms(times, fluxes, timeSteps, rmsValues);
+}
 
-	swap(timeSteps, tempSteps);
-	swap(rmsValues, tempRms);
+/** Calculates the RMS binned over ever-larger subintervals of a 
+ *	cadence. rmsVsTRooted() considers only subintervals from the 
+ *	first data point to some later point
+ *
+ * Since a cadence is always sorted, the order of the times is not 
+ * checked again.
+ *
+ * @see rmsVsTRooted(const DoubleVec&, const DoubleVec&, DoubleVec&, DoubleVec&)
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to do the 
+ *	calculations.
+ * @exception std::invalid_argument Thrown if @p times is insufficiently long 
+ *	or if @p fluxes has a different length from @p times
+ *
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void rmsVsTRooted(const models::Cadence &times, const DoubleVec &fluxes, 
+		DoubleVec &timeSteps, DoubleVec & rmsValues) {
+	checkRmsLengths(times.timeView(), fluxes, "rmsVsTRooted");
+	rootedRms(times.timeView(), fluxes, timeSteps, rmsValues);
 }
 
 /** Calculates the RMS binned over ever-larger subintervals of the data. rmsVsTAllPairs() 
@@ -130,7 +238,11 @@ void rmsVsTRooted(const DoubleVec &times, const DoubleVec &fluxes,
  * @post @p timeSteps is sorted in ascending order
  * @post if N = @p times.size(), @p timeSteps.size() = @p rmsValues.size() = @f$ \binom{N}{2} @f$
  *
- * @perform O(N<sup>3</sup>) time, where N = times.size()
+ * @perform O(N<sup>2</sup> log N) time, where N = times.size(). The 
+ *	RMS values take O(N<sup>2</sup>) time, and the rest is the sort. 
+ *	Use rmsVsTBinned() if only summaries of the RMS at each timescale 
+ *	are needed.
+ * @perform O(N<sup>2</sup>) memory
  * 
  * @exception std::bad_alloc Thrown if there is not enough memory to do the 
  *	calculations.
@@ -140,40 +252,27 @@ void rmsVsTRooted(const DoubleVec &times, const DoubleVec &fluxes,
  * 
  * @exceptsafe The function arguments are unchanged in the event 
  *	of an exception.
- * 
- * @todo Reduce to O(N<sup>2</sup>) time through dynamic programming
  */
 void rmsVsTAllPairs(const DoubleVec &times, const DoubleVec &fluxes, 
 		DoubleVec &timeSteps, DoubleVec & rmsValues) {
 	using std::swap;
 
+	checkRmsInput(times, fluxes, "rmsVsTAllPairs");
 	size_t nData = times.size();
 	
-	if(nData < 2) {
-		throw std::invalid_argument("Can't take RMS over a light curve of less than 2 points (gave " 
-		+ lexical_cast<std::string>(nData) + ")");
-	}
-	if(nData != fluxes.size()) {
-		throw std::invalid_argument("Times and fluxes have different lengths in rmsVsTRooted() (gave " 
-		+ lexical_cast<std::string>(nData) + " for times and " 
-		+ lexical_cast<std::string>(fluxes.size()) + " for fluxes)");
-	}
-	if (!kpfutils::isSorted(times.begin(), times.end())) {
-		throw kpfutils::except::NotSorted("times is not sorted in rmsVsTAllPairs()");
-	}
-	
 	// Temporary storage that allows the data to be sorted together
 	std::vector<std::pair<double, double> > sortableVec;
+	sortableVec.reserve(nData*(nData-1)/2);
 	
 	// Do the RMS calculations
+	// Subintervals with the same first point are extensions of each other
 	for(size_t first = 0; first < nData; first++) {
+		RunningVariance running;
+		running.add(fluxes[first]);
 		for(size_t last = first+1; last < nData; last++) {
-			double var = kpfutils::variance(fluxes.begin()+first, 
-				fluxes.begin()+last+1);
-//			sortableVec.push_back(std::pair<double, double>(
-//				times[last]-times[first], sqrt(var) ));
+			running.add(fluxes[last]);
 			sortableVec.push_back(std::make_pair(times[last]-times[first], 
-					sqrt(var) ));
+					sqrt(running.variance()) ));
 		}
 	}
 	
@@ -200,4 +299,138 @@ void rmsVsTAllPairs(const DoubleVec &times, const DoubleVec &fluxes,
 	swap(rmsValues, tempRms);
 }
 
+/** Calculates the median RMS over all subintervals of the data whose 
+ *	lengths fall in each of a set of bins, without checking the input
+ *
+ * @see rmsVsTBinned(const DoubleVec&, const DoubleVec&, const DoubleVec&, DoubleVec&)
+ *
+ * @pre The input has been checked by checkRmsLengths().
+ * @pre @p times is sorted in ascending order
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to do the 
+ *	calculations.
+ *
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void binnedRms(const DoubleVec &times, const DoubleVec &fluxes, 
+		const DoubleVec &binEdges, DoubleVec &medians) {
+	const size_t nData = times.size();
+	const size_t nBins = binEdges.size();
+	
+	std::vector<DoubleVec> binned(nBins);
+	for(size_t first = 0; first < nData; first++) {
+		RunningVariance running;
+		running.add(fluxes[first]);
+		// The subintervals get longer as last increases, so the 
+		//	bin only ever moves forward
+		// invariant: bin is the number of edges <= the current length
+		size_t bin = 0;
+		for(size_t last = first+1; last < nData; last++) {
+			running.add(fluxes[last]);
+			const double length = times[last]-times[first];
+			while (bin < nBins && binEdges[bin] <= length) {
+				bin++;
+			}
+			// Subintervals shorter than the first edge are in no bin
+			if (bin > 0) {
+				binned[bin-1].push_back(sqrt(running.variance()));
+			}
+		}
+	}
+	
+	// copy-and-swap
+	DoubleVec temp(nBins, std::numeric_limits<double>::quiet_NaN());
+	for(size_t bin = 0; bin < nBins; bin++) {
+		DoubleVec& values = binned[bin];
+		if (values.empty()) {
+			continue;
+		}
+		const size_t low = (values.size() - 1) / 2;
+		std::nth_element(values.begin(), values.begin() + low, values.end());
+		if (values.size() % 2 == 1) {
+			temp[bin] = values[low];
+		} else {
+			// The next rank is the smallest of the larger half
+			const double high = *std::min_element(values.begin() + low + 1, 
+				values.end());
+			temp[bin] = 0.5 * (values[low] + high);
+		}
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	medians.swap(temp);
+}
+
+/** Calculates the median RMS over all subintervals of the data whose 
+ *	lengths fall in each of a set of bins
+ * 
+ * The result is what sorting the output of rmsVsTAllPairs() and 
+ * taking the median of each bin would give, but each bin's median is 
+ * found by selection rather than by sorting.
+ * 
+ * @param[in] times		Times at which data were taken
+ * @param[in] fluxes		Flux measurements of a source
+ * @param[in] binEdges	The lower edge of each bin of subinterval 
+ *	length. Bin @p i contains the subintervals with 
+ *	<tt>binEdges[i] &le; length &lt; binEdges[i+1]</tt>; the last 
+ *	bin has no upper edge.
+ * @param[out] medians	The median RMS of the subintervals in each bin
+ *
+ * @pre @p times is sorted in ascending order
+ * @pre @p fluxes[i] is the flux of the source at @p times[i], for all i
+ * @pre @p binEdges is sorted in ascending order
+ *
+ * @pre @p times does not contain NaNs
+ * @pre @p fluxes does not contain NaNs
+ *
+ * @post @p medians.size() = @p binEdges.size()
+ * @post The median of a bin with @p n subintervals is found by linear 
+ *	interpolation between the subintervals of rank 
+ *	<tt>floor((n-1)/2)</tt> and <tt>ceil((n-1)/2)</tt>, as for the 
+ *	&Delta;m&Delta;t quantiles. Bins with no subintervals have a value 
+ *	of NaN.
+ *
+ * @perform O(N<sup>2</sup> + N B) time, where N = @p times.size() and 
+ *	B = @p binEdges.size()
+ * @perform O(N<sup>2</sup>) memory
+ * 
+ * @exception std::bad_alloc Thrown if there is not enough memory to do the 
+ *	calculations.
+ * @exception std::invalid_argument Thrown if @p times is insufficiently long 
+ *	or if @p fluxes has a different length from @p times
+ * @exception kpfutils::except::NotSorted Thrown if @p times is unsorted.
+ * 
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void rmsVsTBinned(const DoubleVec &times, const DoubleVec &fluxes, 
+		const DoubleVec &binEdges, DoubleVec &medians) {
+	checkRmsInput(times, fluxes, "rmsVsTBinned");
+	binnedRms(times, fluxes, binEdges, medians);
+}
+
+/** Calculates the median RMS over all subintervals of a cadence whose 
+ *	lengths fall in each of a set of bins
+ *
+ * Since a cadence is always sorted, the order of the times is not 
+ * checked again.
+ *
+ * @see rmsVsTBinned(const DoubleVec&, const DoubleVec&, const DoubleVec&, DoubleVec&)
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to do the 
+ *	calculations.
+ * @exception std::invalid_argument Thrown if @p times is insufficiently long 
+ *	or if @p fluxes has a different length from @p times
+ * 
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void rmsVsTBinned(const models::Cadence &times, const DoubleVec &fluxes, 
+		const DoubleVec &binEdges, DoubleVec &medians) {
+	checkRmsLengths(times.timeView(), fluxes, "rmsVsTBinned");
+	binnedRms(times.timeView(), fluxes, binEdges, medians);
+}
+
 }}	// end lcmc::stats
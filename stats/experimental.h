@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/experimental.h
  * @author Krzysztof Findeisen
  * @date Created August 3, 2011
- * @date Last modified April 12, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,6 +31,7 @@
 #define LCMCEXPERIMENTH
 
 #include <vector>
+#include "../cadence.h"
 
 namespace lcmc { namespace stats {
 
@@ -40,9 +41,19 @@ typedef std::vector<double> DoubleVec;
  */
 void rmsVsTRooted(const DoubleVec &times, const DoubleVec &fluxes, 
 	DoubleVec &timeSteps, DoubleVec & rmsValues);
+void rmsVsTRooted(const models::Cadence &times, const DoubleVec &fluxes, 
+	DoubleVec &timeSteps, DoubleVec & rmsValues);
 void rmsVsTAllPairs(const DoubleVec &times, const DoubleVec &fluxes, 
 	DoubleVec &timeSteps, DoubleVec & rmsValues);
 
+/** Calculates the median RMS over all subintervals of the data whose 
+ *	lengths fall in each of a set of bins
+ */
+void rmsVsTBinned(const DoubleVec &times, const DoubleVec &fluxes, 
+	const DoubleVec &binEdges, DoubleVec &medians);
+void rmsVsTBinned(const models::Cadence &times, const DoubleVec &fluxes, 
+	const DoubleVec &binEdges, DoubleVec &medians);
+
 }}		// end lcmc::stats
 
 #endif		// end LCMCEXPERIMENTH
@@ -1,8 +1,8 @@
-/** Calculates periodograms and periods
+/** Fits timescale models to light curves
  * @file lightcurveMC/stats/gpdriver.cpp
  * @author Krzysztof Findeisen
  * @date Created June 27, 2013
- * @date Last modified August 6, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <algorithm>
@@ -11,8 +11,19 @@
 #include <vector>
 #include <boost/lexical_cast.hpp>
 #include "../../common/nan.h"
+#include "../except/undefined.h"
+#include "drwfit.h"
 #include "statcollect.h"
 #include "statfamilies.h"
+#include "statstatus.h"
+
+#include "../../common/warnflags.h"
+
+// drwAdapter() does not use trueTime, but it should still be part 
+// of the interface
+#ifdef GNUC_COARSEWARN
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
 
 namespace lcmc { namespace stats {
 
@@ -20,18 +31,180 @@ using boost::lexical_cast;
 using std::string;
 using std::vector;
 
-/** Finds the best fit solution to a squared exponential Gaussian process model
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model, reporting failed fits without exceptions
  */
-void fitGaussGp(const vector<double>& times, const vector<double>& data, 
-		double& timescale, double& timeError);
+StatStatus tryFitGaussGp(const vector<double>& times, const vector<double>& data, 
+		double trueTime, double& timescale, double& timeError);
 
-/** Does all GP-related computations for a given light curve.
+// drwAdapter() does not use trueTime, but it should still be part 
+// of the interface
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+/** Adapts fitDrw() to the interface of tryFitGaussGp()
  *
  * @param[in] times The times at which the light curve was sampled.
  * @param[in] data The values of the light curve
+ * @param[in] trueTime Ignored.
+ * @param[out] timescale The best-fit value of the damping timescale
+ * @param[out] timeError The estimated uncertainty on the damping timescale
+ *
+ * @return STAT_OK if the fit succeeded, STAT_NOT_ENOUGH_DATA if 
+ *	@p times and @p data do not have at least two values, or 
+ *	STAT_NO_FIT if the fit does not converge.
+ *
+ * @exception std::invalid_argument Thrown if @p times and @p data 
+ *	do not have the same length.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past 
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit 
+ *	the model.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of 
+ *	an exception.
+ */
+StatStatus drwAdapter(const vector<double>& times, const vector<double>& data, 
+		double trueTime, double& timescale, double& timeError) {
+	try {
+		fitDrw(times, data, timescale, timeError);
+	} catch (const except::TimedOut& e) {
+		throw;
+	} catch (const except::NotEnoughData& e) {
+		return STAT_NOT_ENOUGH_DATA;
+	} catch (const std::runtime_error& e) {
+		return STAT_NO_FIT;
+	}
+	return STAT_OK;
+}
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+/** Records a fitted timescale
+ *
+ * @param[in] bestTime The best-fit timescale, or NaN if the fit failed.
+ * @param[in] timeErr The estimated uncertainty on @p bestTime.
+ * @param[in] trueTime The value of the true time scale. NaN if not available.
+ * @param[out] timescales The NamedCollection in which to record the 
+ *	best-fit timescale.
+ * @param[out] timeErrors The NamedCollection in which to record the 
+ *	uncertainty on the best-fit timescale.
+ * @param[out] normDevs The NamedCollection in which to record the normalized 
+ *	deviation of the best-fit time scale from the true time scale.
+ * 
+ * @return STAT_OK, or STAT_NO_FIT if @p bestTime is not a plausible 
+ *	timescale.
+ *
+ * @post A new element is appended to each of @p timescales, 
+ *	@p timeErrors, and @p normDev. If @p bestTime is not a plausible 
+ *	timescale, the appended value is NaN.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ *
+ * @exceptsafe The collections may be partially updated in the event 
+ *	of an exception.
+ */
+StatStatus addFit(double bestTime, double timeErr, double trueTime, 
+		CollectedScalars& timescales, CollectedScalars& timeErrors, 
+		CollectedScalars& normDevs) {
+	// Not all fitters report errors, but lack of 
+	//	convergence is usually pretty obvious...
+	if (bestTime < 1e5 && bestTime > 0.0) {
+		timescales.addStat(bestTime);
+		timeErrors.addStat(timeErr);
+		
+		if (kpfutils::isNan(trueTime)) {
+			normDevs.addNull();
+		} else {
+			normDevs.addStat((bestTime - trueTime)/timeErr);
+		}
+		return STAT_OK;
+	} else {
+		timescales.addNull();
+		timeErrors.addNull();
+		normDevs  .addNull();
+		return STAT_NO_FIT;
+	}
+}
+
+/** Fits a timescale to a light curve and records it.
+ *
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve
+ * @param[in] fitter The function that finds the best-fit timescale 
+ *	and its error.
+ * @param[in] trueTime The value of the true time scale. NaN if not available.
+ * @param[out] timescales The NamedCollection in which to record the 
+ *	best-fit timescale.
+ * @param[out] timeErrors The NamedCollection in which to record the 
+ *	uncertainty on the best-fit timescale.
+ * @param[out] normDevs The NamedCollection in which to record the normalized 
+ *	deviation of the best-fit time scale from the true time scale.
+ *
+ * @pre @p times.size() = @p data.size()
+ * @pre Neither @p times nor @p data may contain NaNs
+ * 
+ * @return The status reported by @p fitter, or STAT_NO_FIT if it 
+ *	found an implausible timescale.
+ *
+ * @post A new element is appended to each of @p timescales, 
+ *	@p timeErrors, and @p normDev. If no value is found, the appended 
+ *	value is NaN.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past 
+ *	the current thread's StatDeadline.
+ *
+ * @exceptsafe The collections are unchanged in the event of an exception.
+ */
+StatStatus recordFit(const vector<double>& times, const vector<double>& data, 
+		StatStatus (*fitter)(const vector<double>&, const vector<double>&, 
+			double, double&, double&), 
+		double trueTime, CollectedScalars& timescales, 
+		CollectedScalars& timeErrors, CollectedScalars& normDevs) {
+	// Checkpoints let us undo a partial update without copying 
+	//	the statistics from all previous light curves
+	const CollectedScalars::Checkpoint markTimes  = timescales.checkpoint();
+	const CollectedScalars::Checkpoint markErrors = timeErrors.checkpoint();
+	const CollectedScalars::Checkpoint markDevs   = normDevs  .checkpoint();
+	
+	try {
+		double bestTime, timeErr;
+		const StatStatus status = fitter(times, data, trueTime, 
+			bestTime, timeErr);
+		if (status == STAT_OK) {
+			return addFit(bestTime, timeErr, trueTime, 
+				timescales, timeErrors, normDevs);
+		}
+		
+		timescales.addNull();
+		timeErrors.addNull();
+		normDevs  .addNull();
+		return status;
+	} catch (...) {
+		// Leave the collections as they were before the call
+		timescales.rollback(markTimes );
+		timeErrors.rollback(markErrors);
+		normDevs  .rollback(markDevs  );
+		throw;
+	}
+}
+
+/** Does all GP-related computations for a given light curve.
+ *
+ * @param[in] lc The light curve to analyze.
  * @param[in] getGp Flag indicating that the best-fit timescale 
  *	should be extracted
- * @param[in] trueTime The value of the true time scale. NaN if not available.
+ * @param[in] trueTime The value of the true time scale. NaN if not available. 
+ *	Also used as the starting point of the fit if setGpStart() was 
+ *	called with @ref GPSTART_TRUE "GPSTART_TRUE".
  * @param[out] timescales The NamedCollection in which to record the 
  *	best-fit timescale, if any.
  * @param[out] timeErrors The NamedCollection in which to record the 
@@ -40,76 +213,92 @@ void fitGaussGp(const vector<double>& times, const vector<double>& data,
  *	deviation of the best-fit time scale from the true time scale, 
  *	if any.
  *
- * @pre @p times.size() = @p data.size()
- * @pre Neither @p times nor @p data may contain NaNs
- * 
+ * @return STAT_OK if a timescale was found or none was requested, 
+ *	otherwise the reason no timescale was found. A failed fit recorded 
+ *	with AnalysisContext::setGpFit() is reported as STAT_NO_FIT.
+ *
  * @post if @p getGp, then a new element is appended to each of @p timescales, 
  *	@p timeErrors, and @p normDev. If no value is found, the appended 
  *	value is NaN.
+ * @post If a fit was recorded with AnalysisContext::setGpFit(), it is 
+ *	used instead of fitting @p lc again.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	store more statistics.
- * @exception std::invalid_argument Thrown if @p times and @p data do not 
- *	have matching lengths or if @p times or @p data contains NaNs.
- * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
- *	and @p data are too short to calculate the desired statistics.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past 
+ *	the current thread's StatDeadline.
  *
- * @exceptsafe The program is in a consistent state in the event of an exception.
+ * @exceptsafe The collections are unchanged in the event of an exception.
  */
-void doGaussFit(const vector<double>& times, const vector<double>& data, 
+StatStatus doGaussFit(const AnalysisContext& lc, 
 		bool getGp, double trueTime, CollectedScalars& timescales, 
 		CollectedScalars& timeErrors, CollectedScalars& normDevs) {
-	if (times.size() != data.size()) {
-		throw std::invalid_argument("Times and data must have the same length in doGaussFit() (gave " 
-			+ lexical_cast<string>(times.size()) + " for times and " 
-			+ lexical_cast<string>(data.size()) + " for data).");
-	}
+	const vector<double>& times = lc.getTimes();
+	const vector<double>& data = lc.getMags();
 
-	if (getGp) {
-		// copy-and-swap
-		CollectedScalars tempTimes  = timescales;
-		CollectedScalars tempErrors = timeErrors;
-		CollectedScalars tempDevs   = normDevs;
-		
+	double bestTime, timeErr;
+	if (getGp && lc.findGpFit(bestTime, timeErr)) {
+		const CollectedScalars::Checkpoint markTimes  = timescales.checkpoint();
+		const CollectedScalars::Checkpoint markErrors = timeErrors.checkpoint();
+		const CollectedScalars::Checkpoint markDevs   = normDevs  .checkpoint();
 		try {
-			double bestTime, timeErr;
-			fitGaussGp(times, data, bestTime, timeErr);
-			
-			// R code doesn't report errors, but lack of 
-			//	convergence is usually pretty obvious...
-			if (bestTime < 1e5 && bestTime > 0.0) {
-				tempTimes .addStat(bestTime);
-				tempErrors.addStat(timeErr);
-				
-				if (kpfutils::isNan(trueTime)) {
-					tempDevs.addNull();
-				} else {
-					tempDevs.addStat((bestTime - trueTime)/timeErr);
-				}
-			} else {
-				tempTimes .addNull();
-				tempErrors.addNull();
-				tempDevs  .addNull();
-			}
-		} catch (const std::runtime_error &e) {
-			// Don't know how many of the collections were updated... revert to input
-			tempTimes  = timescales;
-			tempErrors = timeErrors;
-			tempDevs   = normDevs;
-			
-			// May still throw bad_alloc
-			tempTimes .addNull();
-			tempErrors.addNull();
-			tempDevs  .addNull();
+			return addFit(bestTime, timeErr, trueTime, 
+				timescales, timeErrors, normDevs);
+		} catch (...) {
+			timescales.rollback(markTimes );
+			timeErrors.rollback(markErrors);
+			normDevs  .rollback(markDevs  );
+			throw;
 		}
-		
-		// IMPORTANT: no exceptions beyond this point
-		
-		using std::swap;
-		swap(timescales, tempTimes );
-		swap(timeErrors, tempErrors);
-		swap(normDevs  , tempDevs  );
+	} else if (getGp) {
+		return recordFit(times, data, &tryFitGaussGp, trueTime, 
+			timescales, timeErrors, normDevs);
+	}
+	return STAT_OK;
+}
+
+/** Does all DRW-related computations for a given light curve.
+ *
+ * Unlike doGaussFit(), the damped random walk likelihood is computed 
+ * in linear time, so this statistic is fast enough for long light curves.
+ *
+ * @param[in] lc The light curve to analyze.
+ * @param[in] getDrw Flag indicating that the best-fit timescale 
+ *	should be extracted
+ * @param[in] trueTime The value of the true time scale. NaN if not available.
+ * @param[out] timescales The NamedCollection in which to record the 
+ *	best-fit timescale, if any.
+ * @param[out] timeErrors The NamedCollection in which to record the 
+ *	uncertainty on the best-fit timescale, if any.
+ * @param[out] normDevs The NamedCollection in which to record the normalized 
+ *	deviation of the best-fit time scale from the true time scale, 
+ *	if any.
+ *
+ * @return STAT_OK if a timescale was found or none was requested, 
+ *	otherwise the reason no timescale was found.
+ *
+ * @post if @p getDrw, then a new element is appended to each of @p timescales, 
+ *	@p timeErrors, and @p normDev. If no value is found, the appended 
+ *	value is NaN.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past 
+ *	the current thread's StatDeadline.
+ *
+ * @exceptsafe The collections are unchanged in the event of an exception.
+ */
+StatStatus doDrwFit(const AnalysisContext& lc, 
+		bool getDrw, double trueTime, CollectedScalars& timescales, 
+		CollectedScalars& timeErrors, CollectedScalars& normDevs) {
+	const vector<double>& times = lc.getTimes();
+	const vector<double>& data = lc.getMags();
+
+	if (getDrw) {
+		return recordFit(times, data, &drwAdapter, trueTime, 
+			timescales, timeErrors, normDevs);
 	}
+	return STAT_OK;
 }
 
 }}		// end lcmc::stats
@@ -2,17 +2,23 @@
  * @file lightcurveMC/stats/gpfit.cpp
  * @author Krzysztof Findeisen
  * @date Created June 24, 2013
- * @date Last modified October 30, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <limits>
+#include <stdexcept>
 #include <vector>
+#include <cmath>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
 #include "../approx.h"
 #include "../../common/nan.h"
-#include "../r_compat.h"
 #include "../except/undefined.h"
+#include "deadline.h"
+#include "gpfit.h"
+#include "plugins.h"
 
 namespace lcmc { namespace stats {
 
@@ -21,7 +27,507 @@ using std::vector;
 using boost::lexical_cast;
 using boost::shared_ptr;
 
+/** Fits a squared exponential Gaussian process model in an R worker 
+ *	process, if any were requested
+ */
+bool fitInRWorker(const vector<double>& times, const vector<double>& data, 
+		const GpParams& start, GpParams& best, double& timeError);
+
+/** Returns the number of workers requested with setRWorkers()
+ */
+long& rWorkerCount();
+
+/** The plugin used by fitGaussGpR() when there are no R workers
+ */
+const char* const R_PLUGIN = "rgp";
+
+/** Returns the method used by fitGaussGp()
+ *
+ * @return A modifiable reference to the method.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+GpFitMethod& gpFitMethod() {
+	static GpFitMethod method = GPFIT_R;
+	return method;
+}
+
+/** Selects how fitGaussGp() fits Gaussian process models
+ *
+ * @param[in] method The backend to use for all subsequent calls 
+ *	to fitGaussGp().
+ *
+ * @post fitGaussGp() calls fitGaussGpR() if @p method is GPFIT_R, 
+ *	fitGaussGpNative() if @p method is GPFIT_NATIVE, or 
+ *	fitGaussGpPlugin() with the plugin chosen by setGpPlugin() if 
+ *	@p method is GPFIT_PLUGIN.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void setGpFitMethod(GpFitMethod method) {
+	gpFitMethod() = method;
+}
+
+/** Returns the method chosen with setGpFitMethod()
+ *
+ * @return The backend used by fitGaussGp().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+GpFitMethod getGpFitMethod() {
+	return gpFitMethod();
+}
+
+/** Returns the plugin used by fitGaussGp() for GPFIT_PLUGIN
+ *
+ * @return A modifiable reference to the plugin name.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+string& gpPluginName() {
+	static string name(R_PLUGIN);
+	return name;
+}
+
+/** Selects the statistics plugin used for GPFIT_PLUGIN
+ *
+ * @param[in] name The name of the plugin, as for loadStatPlugin().
+ *
+ * @post If setGpFitMethod() was given GPFIT_PLUGIN, fitGaussGp() 
+ *	fits models with the plugin @p name.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void setGpPlugin(const string& name) {
+	string temp(name);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	gpPluginName().swap(temp);
+}
+
+/** Returns the plugin chosen with setGpPlugin()
+ *
+ * @return The name of the plugin, or rgp if setGpPlugin() was 
+ *	never called.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	copy the name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string getGpPlugin() {
+	return gpPluginName();
+}
+
+/** Loads the plugin, if any, that fitGaussGp() will use
+ *
+ * Programs can call this function before the first fit, so that a 
+ * missing plugin is reported once rather than as a failure of every fit.
+ *
+ * @post If setGpFitMethod() was given GPFIT_PLUGIN, or was given 
+ *	GPFIT_R and setRWorkers() was not given a positive count, the 
+ *	corresponding plugin is loaded.
+ *
+ * @perform Loading a plugin may take seconds.
+ *
+ * @exception std::invalid_argument Thrown if the plugin name is invalid.
+ * @exception std::runtime_error Thrown if the plugin could not be loaded.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	load the plugin.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void loadGpPlugin() {
+	if (getGpFitMethod() == GPFIT_PLUGIN) {
+		loadStatPlugin(getGpPlugin());
+	} else if (getGpFitMethod() == GPFIT_R && rWorkerCount() <= 0) {
+		loadStatPlugin(R_PLUGIN);
+	}
+}
+
+/** Returns the policy used by fitGaussGp() to choose a starting point
+ *
+ * @return A modifiable reference to the policy.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+GpStart& gpStartPolicy() {
+	static GpStart policy = GPSTART_DEFAULT;
+	return policy;
+}
+
+/** Returns the starting timescale used by @ref GPSTART_MIDPOINT "GPSTART_MIDPOINT"
+ *
+ * @return A modifiable reference to the timescale, or to NaN if no 
+ *	midpoint is known.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& gpStartMidpoint() {
+	static double midpoint = std::numeric_limits<double>::quiet_NaN();
+	return midpoint;
+}
+
+/** Returns the last solution found by fitGaussGp() on the calling thread
+ *
+ * @return A per-thread pointer that is null if the thread has not 
+ *	yet fit a model.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::thread_specific_ptr<GpParams>& previousSolution() {
+	static boost::thread_specific_ptr<GpParams> previous;
+	return previous;
+}
+
+/** Returns the lock that protects the iteration counts
+ *
+ * @return A mutex shared by all callers.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::mutex& iterationLock() {
+	static boost::mutex lock;
+	return lock;
+}
+
+/** Returns the number of fits counted by getGpIterations()
+ *
+ * @return A modifiable reference to the count. Must only be used while 
+ *	holding iterationLock().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& gpFitCount() {
+	static long count = 0;
+	return count;
+}
+
+/** Returns the number of iterations counted by getGpIterations()
+ *
+ * @return A modifiable reference to the count. Must only be used while 
+ *	holding iterationLock().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& gpIterationCount() {
+	static long count = 0;
+	return count;
+}
+
+/** Returns the bin width used by fitGaussGp()
+ *
+ * @return A modifiable reference to the width, or to 0 if light curves 
+ *	are not binned.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& gpBinWidth() {
+	static double width = 0.0;
+	return width;
+}
+
+/** Returns the number of binned fits counted by getGpBinningBias()
+ *
+ * @return A modifiable reference to the count. Must only be used while 
+ *	holding iterationLock().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& gpBinnedCount() {
+	static long count = 0;
+	return count;
+}
+
+/** Returns the total relative bias counted by getGpBinningBias()
+ *
+ * @return A modifiable reference to the total. Must only be used while 
+ *	holding iterationLock().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& gpBinnedBias() {
+	static double total = 0.0;
+	return total;
+}
+
+/** Returns the number of binned fits whose timescale was not resolved 
+ *	by the bins
+ *
+ * @return A modifiable reference to the count. Must only be used while 
+ *	holding iterationLock().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& gpUnresolvedCount() {
+	static long count = 0;
+	return count;
+}
+
+/** Selects where fitGaussGp() starts its optimization
+ *
+ * Starting near the answer lets the optimizer converge in a few 
+ * iterations rather than up to one per data point.
+ *
+ * @param[in] policy How to choose the starting point for all 
+ *	subsequent fits. @ref GPSTART_PREVIOUS "GPSTART_PREVIOUS" reuses 
+ *	all three hyperparameters, while the other policies only set the 
+ *	starting timescale.
+ * @param[in] midpoint The starting timescale for @ref GPSTART_MIDPOINT 
+ *	"GPSTART_MIDPOINT", or NaN if the range of timescales is not known. 
+ *	Ignored for other policies.
+ *
+ * @post If the chosen starting timescale is not available for a fit 
+ *	(for example, @ref GPSTART_TRUE "GPSTART_TRUE" for a light curve 
+ *	with no timescale), the fit starts from the gptk defaults.
+ * @post With @ref GPSTART_PREVIOUS "GPSTART_PREVIOUS", the result of 
+ *	each fit may depend on which light curves were previously analyzed 
+ *	by the same thread, and therefore on the number of threads.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void setGpStart(GpStart policy, double midpoint) {
+	gpStartPolicy()   = policy;
+	gpStartMidpoint() = midpoint;
+}
+
+/** Reports how many optimizer iterations fitGaussGp() has taken
+ *
+ * @param[out] nFits The number of successful fits whose backend reports 
+ *	its iteration count.
+ * @param[out] nIterations The total number of iterations taken by 
+ *	those fits.
+ *
+ * @note Only fitGaussGpNative() reports its iteration count, as gptk 
+ *	does not expose it.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void getGpIterations(long& nFits, long& nIterations) {
+	boost::mutex::scoped_lock guard(iterationLock());
+	nFits       = gpFitCount();
+	nIterations = gpIterationCount();
+}
+
+/** Selects whether fitGaussGp() bins light curves before fitting them
+ *
+ * Light curves much denser than their timescale carry little more 
+ * information about it than a binned version with far fewer points, 
+ * but cost O(N<sup>3</sup>) time to fit. Binning by binLightCurve() 
+ * reduces N to about the number of bins spanned by the light curve.
+ *
+ * Averaging over a bin smooths the light curve, so the timescale found 
+ * from binned data is biased high. For bins whose times have variance 
+ * s<sup>2</sup>, the fitted timescale is approximately 
+ * @f$ \sqrt{\tau^2 + 2 s^2} @f$; the relative bias implied by this 
+ * approximation is reported by getGpBinningBias().
+ *
+ * @param[in] binWidth The width of the bins, in the same units as the 
+ *	times of observation, or 0 to fit every observation.
+ *
+ * @post If @p binWidth > 0, fitGaussGp() and fitGaussGpBatch() fit 
+ *	the output of binLightCurve() instead of the original light curves. 
+ *	fitGaussGpNative() weights each bin by the number of observations 
+ *	in it; fitGaussGpR() cannot, and gives all bins the same noise.
+ *
+ * @exception std::invalid_argument Thrown if @p binWidth is negative 
+ *	or NaN.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void setGpBinning(double binWidth) {
+	if (!(binWidth >= 0.0)) {
+		throw std::invalid_argument("Bin width for Gaussian process fits must be nonnegative (gave " 
+			+ lexical_cast<string>(binWidth) + ").");
+	}
+	gpBinWidth() = binWidth;
+}
+
+/** Returns the bin width chosen with setGpBinning()
+ *
+ * @return The width of the bins used by fitGaussGp(), or 0 if light 
+ *	curves are not binned.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double getGpBinning() {
+	return gpBinWidth();
+}
+
+/** Reports the timescale bias introduced by setGpBinning()
+ *
+ * @param[out] nFits The number of successful fits of binned light curves.
+ * @param[out] meanBias The average fractional amount by which binning 
+ *	increased the fitted timescales, estimated as described for 
+ *	setGpBinning(), or 0 if @p nFits = 0. Fits counted by 
+ *	@p nUnresolved are excluded from the average.
+ * @param[out] nUnresolved The number of fits whose timescale was too 
+ *	short compared to the bins for the bias to be estimated.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void getGpBinningBias(long& nFits, double& meanBias, long& nUnresolved) {
+	boost::mutex::scoped_lock guard(iterationLock());
+	nFits       = gpBinnedCount();
+	nUnresolved = gpUnresolvedCount();
+	const long nResolved = nFits - nUnresolved;
+	meanBias    = (nResolved > 0 
+		? gpBinnedBias() / static_cast<double>(nResolved) : 0.0);
+}
+
+/** Averages a light curve over bins of fixed width
+ *
+ * Each bin starts at the first observation not in an earlier bin, and 
+ * contains all observations less than @p binWidth after it, so no bin 
+ * is empty.
+ *
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve.
+ * @param[in] binWidth The width of each bin.
+ * @param[out] binTimes The average time of the observations in each bin.
+ * @param[out] binData The average value of the observations in each bin.
+ * @param[out] counts The number of observations in each bin.
+ * @param[out] spread The variance of the times in each bin, averaged 
+ *	over all bins.
+ *
+ * @pre @p times is sorted in ascending order
+ *
+ * @post @p binTimes.size() = @p binData.size() = @p counts.size() 
+ *	&le; @p times.size()
+ * @post The white noise variance of @p binData[i] is that of a single 
+ *	observation divided by @p counts[i].
+ *
+ * @perform O(N) time, where N = @p times.size()
+ *
+ * @exception std::invalid_argument Thrown if @p times and @p data do 
+ *	not have the same length, if @p times is not sorted, or if 
+ *	@p binWidth is not positive.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the binned light curve.
+ *
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void binLightCurve(const vector<double>& times, const vector<double>& data, 
+		double binWidth, vector<double>& binTimes, vector<double>& binData, 
+		vector<double>& counts, double& spread) {
+	if (times.size() != data.size()) {
+		throw std::invalid_argument("Data and time arrays passed to binLightCurve() must have the same length (gave " 
+			+ lexical_cast<string>(times.size()) + " for times and " 
+			+ lexical_cast<string>( data.size()) + " for data)");
+	}
+	if (!(binWidth > 0.0)) {
+		throw std::invalid_argument("Bin width passed to binLightCurve() must be positive (gave " 
+			+ lexical_cast<string>(binWidth) + ").");
+	}
+	for(size_t i = 1; i < times.size(); i++) {
+		if (times[i] < times[i-1]) {
+			throw std::invalid_argument("Times passed to binLightCurve() must be sorted.");
+		}
+	}
+	
+	vector<double> tempTimes, tempData, tempCounts;
+	double totalSpread = 0.0;
+	size_t first = 0;
+	while (first < times.size()) {
+		size_t last = first + 1;
+		while (last < times.size() && times[last] - times[first] < binWidth) {
+			last++;
+		}
+		
+		const double n = static_cast<double>(last - first);
+		double sumTime = 0.0, sumData = 0.0;
+		for(size_t i = first; i < last; i++) {
+			sumTime += times[i];
+			sumData += data[i];
+		}
+		const double meanTime = sumTime / n;
+		double sumSq = 0.0;
+		for(size_t i = first; i < last; i++) {
+			sumSq += (times[i] - meanTime) * (times[i] - meanTime);
+		}
+		
+		tempTimes .push_back(meanTime);
+		tempData  .push_back(sumData / n);
+		tempCounts.push_back(n);
+		totalSpread += sumSq / n;
+		first = last;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	binTimes.swap(tempTimes);
+	binData .swap(tempData);
+	counts  .swap(tempCounts);
+	spread = (binTimes.empty() ? 0.0 
+		: totalSpread / static_cast<double>(binTimes.size()));
+}
+
+/** Records the bias introduced by binning one light curve
+ *
+ * @param[in] timescale The timescale fit to the binned light curve.
+ * @param[in] spread The average variance of the times in each bin, as 
+ *	found by binLightCurve().
+ *
+ * @pre Caller holds iterationLock()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void recordBinningBias(double timescale, double spread) {
+	gpBinnedCount()++;
+	// Smoothing adds 2 s^2 to the squared timescale
+	const double trueSq = timescale*timescale - 2.0*spread;
+	if (trueSq > 0.0) {
+		gpBinnedBias() += timescale / sqrt(trueSq) - 1.0;
+	} else {
+		gpUnresolvedCount()++;
+	}
+}
+
+/** Chooses the starting point of a fit according to setGpStart()
+ *
+ * @param[in] trueTime The timescale used to simulate the light curve, 
+ *	or NaN if not available.
+ *
+ * @return The hyperparameters from which to start the fit. NaN members 
+ *	start from the gptk defaults.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+GpParams chooseGpStart(double trueTime) {
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	GpParams start = {nan, nan, nan};
+	switch (gpStartPolicy()) {
+	case GPSTART_PREVIOUS:
+		// Other light curves in the bin have similar amplitudes 
+		//	and noise levels, as well as timescales
+		if (previousSolution().get() != NULL) {
+			start = *previousSolution();
+		}
+		break;
+	case GPSTART_TRUE:
+		start.timescale = trueTime;
+		break;
+	case GPSTART_MIDPOINT:
+		start.timescale = gpStartMidpoint();
+		break;
+	default:
+		break;
+	}
+	// Only timescales in the range accepted by doGaussFit() are useful
+	if (!(start.timescale > 0.0 && start.timescale < 1e5)) {
+		start.timescale = nan;
+	}
+	return start;
+}
+
 /** Finds the best fit solution to a squared exponential Gaussian process model
+ *
+ * Equivalent to fitGaussGp(times, data, NaN, timescale, timeError).
  * 
  * @param[in] times The times at which the light curve was sampled.
  * @param[in] data The values of the light curve (typically fluxes or magnitudes)
@@ -57,77 +563,478 @@ using boost::shared_ptr;
  */
 void fitGaussGp(const vector<double>& times, const vector<double>& data, 
 		double& timescale, double& timeError) {
-	shared_ptr<RInside> r = getRInstance();
-	
-	if (times.size() < 2) {
+	fitGaussGp(times, data, std::numeric_limits<double>::quiet_NaN(), 
+		timescale, timeError);
+}
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model, starting from the guess chosen by setGpStart()
+ *
+ * The fit is done by fitGaussGpR(), fitGaussGpNative(), or 
+ * fitGaussGpPlugin(), as chosen by setGpFitMethod(). If setGpBinning() was given a bin width, the 
+ * light curve is first binned by binLightCurve().
+ * 
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve (typically fluxes or magnitudes)
+ * @param[in] trueTime The timescale used to simulate the light curve, 
+ *	or NaN if not available.
+ * @param[out] timescale The best-fit value of the model timescale
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ * 
+ * @pre @p times contains at least two unique values
+ * @pre @p times.size() = @p data.size()
+ * @pre for all i, @p data[i] is the measurement taken at @p time[i]
+ * @pre Neither @p times nor @p data may contain NaNs
+ * 
+ * @post @p timescale and @p timeError contain the best-fit estimate 
+ *	of the correlation timescale for a Gaussian process model
+ * @post @p timescale > 0
+ * @post @p timeError > 0
+ * 
+ * @perform O(N<sup>3</sup>) time, where N = @p times.size(), or the number 
+ *	of bins if setGpBinning() was given a bin width
+ * @perfmore O(N<sup>2</sup>) memory
+ * 
+ * @exception lcmc::utils::except::UnexpectedNan Thrown if there are any 
+ *	NaN values present in @p times or @p data.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times and @p data do 
+ *	not have at least two values. 
+ * @exception std::invalid_argument Thrown if @p times and @p data 
+ *	do not have the same length, or if the light curve is binned and 
+ *	@p times is not sorted.
+ * @exception std::runtime_error Thrown if the internal calculations produce 
+ *	an error.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past 
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit 
+ *	the model.
+ * 
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void fitGaussGp(const vector<double>& times, const vector<double>& data, 
+		double trueTime, double& timescale, double& timeError) {
+	const StatStatus status = tryFitGaussGp(times, data, trueTime, 
+		timescale, timeError);
+	if (status == STAT_NOT_ENOUGH_DATA) {
 		throw except::NotEnoughData("Cannot fit Gaussian process model with fewer than 2 data points (gave " 
 			+ lexical_cast<string>(times.size()) + ").");
+	} else if (status == STAT_UNDEFINED) {
+		throw std::runtime_error("In fitGaussGp(), light curve has no variance.");
+	} else if (status != STAT_OK) {
+		throw std::runtime_error("In fitGaussGp(), fit did not converge to a likelihood maximum.");
 	}
+}
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model, reporting failed fits without exceptions
+ *
+ * The fit is the same as for fitGaussGp(), but light curves that cannot 
+ * be fit are reported by the return value rather than by an exception. 
+ * Native fits never throw on such light curves; fits done by R or a 
+ * plugin report all of their errors as STAT_NO_FIT.
+ * 
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve (typically fluxes or magnitudes)
+ * @param[in] trueTime The timescale used to simulate the light curve, 
+ *	or NaN if not available.
+ * @param[out] timescale The best-fit value of the model timescale
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ *
+ * @return STAT_OK if the fit succeeded, STAT_NOT_ENOUGH_DATA if 
+ *	@p times has fewer than two values, STAT_UNDEFINED if @p data has 
+ *	no variance, or STAT_NO_FIT if the fit failed. @p timescale and 
+ *	@p timeError are only changed if STAT_OK is returned.
+ * 
+ * @pre @p times.size() = @p data.size()
+ * @pre for all i, @p data[i] is the measurement taken at @p time[i]
+ * @pre Neither @p times nor @p data may contain NaNs
+ * 
+ * @perform O(N<sup>3</sup>) time, where N = @p times.size(), or the number 
+ *	of bins if setGpBinning() was given a bin width
+ * @perfmore O(N<sup>2</sup>) memory
+ * 
+ * @exception std::invalid_argument Thrown if @p times and @p data 
+ *	do not have the same length, or if the light curve is binned and 
+ *	@p times is not sorted.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past 
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit 
+ *	the model.
+ * 
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+StatStatus tryFitGaussGp(const vector<double>& times, const vector<double>& data, 
+		double trueTime, double& timescale, double& timeError) {
 	if (times.size() != data.size()) {
 		throw std::invalid_argument("Data and time arrays passed to fitGaussGp() must have the same length (gave " 
 			+ lexical_cast<string>(times.size()) + " for times and " 
 			+ lexical_cast<string>( data.size()) + " for data)");
 	}
+	if (times.size() < 2) {
+		return STAT_NOT_ENOUGH_DATA;
+	}
+	
+	const GpParams start = chooseGpStart(trueTime);
+	
+	const bool binned = getGpBinning() > 0.0;
+	vector<double> binTimes, binData, counts;
+	double spread = 0.0;
+	if (binned) {
+		binLightCurve(times, data, getGpBinning(), binTimes, binData, 
+			counts, spread);
+	}
+	const vector<double>& fitTimes = (binned ? binTimes : times);
+	const vector<double>& fitData  = (binned ? binData  : data);
 	
-	Rcpp::NumericVector rTimes(times.begin(), times.end(), static_cast<int>(times.size()));
-	Rcpp::NumericVector rData (data .begin(), data .end(), static_cast<int>(data .size()));
-	
-	(*r)["times"] = rTimes;
-	(*r)["data" ] = rData;
-	
-	// Unfortunately, there seems to be no way to source() files relative 
-	// to the directory containing the lightcurveMC program... it must 
-	// be relative to a hardcoded path or to the lightcurveMC *working* 
-	// directory
-	r->parseEvalQ("suppressMessages(library(gptk))");
-	r->parseEvalQ("suppressMessages(library(numDeriv))");
-	r->parseEvalQ("gpSettings <- gpOptions('ftc')");	// Exact solution; approximations are no faster
-	r->parseEvalQ("gpSettings$optimiser <- 'CG'");		// SCG gives low quality solutions
-	r->parseEvalQ("gpSettings$kern$type <- 'cmpnd'");	// GP + noise
-	r->parseEvalQ("gpSettings$kern$comp <- list('rbf', 'white')");
-	r->parseEvalQ("gpSettings$scaleVal <- sd(data)");	// Equivalent to $scale2var1, but doesn't produce errors
-	
-	// Solve for the best fit
-	r->parseEvalQ("model <- gpCreate(1, 1, as.matrix(times), as.matrix(data), gpSettings)");
-	// Conjugate gradient optimization is supposed to converge within N iterations, 
-	//	where N is the size of the kernel matrix
-	// 10% margin for normal truncation errors
-	r->parseEvalQ("model <- gpOptimise(model, 0, 1.1*length(times))");
-	r->parseEvalQ("tau <- 1.0/sqrt(model$kern$comp[[1]]$inverseWidth)");
-
-	// Estimate the errors
-	r->parseEvalQ("hess <- jacobian(function(p) {gpGradient(p, model)}, gpExtractParam(model))");
-	// If likelihood maximized poorly, Hessian matrix will be asymmetric
-	r->parseEvalQ("isSym <- isSymmetric(hess, tol=1e-4)");
-	if ( !Rcpp::as<bool>((*r)["isSym"]) ) {
-		throw std::runtime_error("In fitGaussGp(), Hessian matrix is asymmetric. This probably means the fit is not a local likelihood maximum.");
-	}
-
-	r->parseEvalQ("covar <- solve(hess)");
-	// Covariance matrix is for ln(1/tau^2), ln(amp^2), ln(noise^2), in that order
-	r->parseEvalQ("err <- 0.5 * sqrt(covar[1,1]) * tau");
-
-	try {
-		// copy-and-swap
-		double tempTime = Rcpp::as<double>((*r)["tau"]);
-		double tempErr  = Rcpp::as<double>((*r)["err"]);
-		// Rcpp will convert NAs to NaNs without error, but we don't 
-		// want to allow those solutions
-		if (kpfutils::isNan(tempTime)) {
-			throw std::runtime_error("In fitGaussGp(), code ran successfully, but time scale was NA");
+	GpParams best;
+	double tempErr;
+	long iterations;
+	if (getGpFitMethod() == GPFIT_NATIVE) {
+		const StatStatus status = tryFitGaussGpNative(fitTimes, fitData, 
+			counts, start, best, tempErr, iterations);
+		if (status != STAT_OK) {
+			return status;
 		}
-		if (kpfutils::isNan(tempErr)) {
-			throw std::runtime_error("In fitGaussGp(), found a time scale, but time scale error was NA");
+	} else {
+		// Neither R nor the plugins distinguish the ways a fit can fail
+		try {
+			if (getGpFitMethod() == GPFIT_PLUGIN) {
+				fitGaussGpPlugin(getGpPlugin(), fitTimes, fitData, start, 
+					best, tempErr, iterations);
+			} else {
+				fitGaussGpR(fitTimes, fitData, start, best, tempErr, 
+					iterations);
+			}
+		} catch (const except::TimedOut& e) {
+			throw;
+		} catch (const except::NotEnoughData& e) {
+			return STAT_NOT_ENOUGH_DATA;
+		} catch (const std::runtime_error& e) {
+			return STAT_NO_FIT;
 		}
+	}
+	
+	if (gpStartPolicy() == GPSTART_PREVIOUS) {
+		if (previousSolution().get() == NULL) {
+			previousSolution().reset(new GpParams(best));
+		} else {
+			*previousSolution() = best;
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	timescale = best.timescale;
+	timeError = tempErr;
+	boost::mutex::scoped_lock guard(iterationLock());
+	if (iterations >= 0) {
+		gpFitCount()++;
+		gpIterationCount() += iterations;
+	}
+	if (binned) {
+		recordBinningBias(best.timescale, spread);
+	}
+	return STAT_OK;
+}
 
-		// IMPORTANT: no exceptions beyond this point
+/** Tests whether fitGaussGpBatch() may be used
+ *
+ * @return True if the fits chosen by setGpFitMethod() and setGpStart() 
+ *	can be done in batches.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool gpBatchable() {
+	return getGpFitMethod() == GPFIT_NATIVE && gpStartPolicy() != GPSTART_PREVIOUS;
+}
 
-		timescale = tempTime;
-		timeError = tempErr;
-	} catch (const std::exception& e) {
-		// Only std::exception can catch all possible Rcpp errors
-		throw std::runtime_error(e.what());
+/** Finds the best fit solutions to squared exponential Gaussian process 
+ *	models of several light curves sampled at the same times
+ *
+ * Each fit is the same as the one fitGaussGp() would do, including 
+ * any binning chosen by setGpBinning(), but the fits are done together 
+ * by fitGaussGpNativeBatch().
+ * 
+ * @param[in] times The times at which the light curves were sampled.
+ * @param[in] data The values of each light curve.
+ * @param[in] trueTimes The timescale used to simulate each light curve, 
+ *	or NaN if not available.
+ * @param[out] timescales The best-fit value of each model timescale, 
+ *	or NaN if its fit failed.
+ * @param[out] timeErrors The estimated uncertainty on each model 
+ *	timescale, or NaN if its fit failed.
+ * 
+ * @pre gpBatchable() is true
+ * @pre @p times contains at least two unique values
+ * @pre For all i, @p data[i] is not null, @p data[i]->size() = 
+ *	@p times.size(), and @p data[i] contains no NaNs
+ * @pre @p trueTimes.size() = @p data.size()
+ * 
+ * @post @p timescales.size() = @p timeErrors.size() = @p data.size()
+ * 
+ * @perform O(N<sup>3</sup>) time per distinct set of hyperparameters 
+ *	evaluated, where N = @p times.size(), or the number of bins if 
+ *	setGpBinning() was given a bin width
+ * @perfmore O(N<sup>2</sup>) memory
+ * 
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
+ *	does not have at least two values. 
+ * @exception std::invalid_argument Thrown if the arrays do not have 
+ *	matching lengths, if @p times is binned and is not sorted, or if 
+ *	gpBatchable() is false.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fits run past 
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit 
+ *	the models.
+ * 
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void fitGaussGpBatch(const vector<double>& times, 
+		const vector<const vector<double>*>& data, 
+		const vector<double>& trueTimes, 
+		vector<double>& timescales, vector<double>& timeErrors) {
+	if (!gpBatchable()) {
+		throw std::invalid_argument("fitGaussGpBatch() requires native fits that do not start from the previous solution.");
+	}
+	if (trueTimes.size() != data.size()) {
+		throw std::invalid_argument("Timescale and data arrays passed to fitGaussGpBatch() must have the same length (gave " 
+			+ lexical_cast<string>(trueTimes.size()) + " for timescales and " 
+			+ lexical_cast<string>(     data.size()) + " for data)");
+	}
+	
+	vector<GpParams> starts;
+	starts.reserve(trueTimes.size());
+	for(vector<double>::const_iterator it = trueTimes.begin(); 
+			it != trueTimes.end(); it++) {
+		starts.push_back(chooseGpStart(*it));
+	}
+	
+	// The bins depend only on the times, so are the same for all curves
+	const bool binned = getGpBinning() > 0.0;
+	vector<double> binTimes, counts;
+	vector<vector<double> > binData(binned ? data.size() : 0);
+	vector<const vector<double>*> binPtrs;
+	double spread = 0.0;
+	if (binned) {
+		binPtrs.reserve(data.size());
+		for(size_t i = 0; i < data.size(); i++) {
+			binLightCurve(times, *data[i], getGpBinning(), binTimes, 
+				binData[i], counts, spread);
+			binPtrs.push_back(&binData[i]);
+		}
+	}
+	
+	vector<GpParams> best;
+	vector<double> tempErrors;
+	vector<long> iterations;
+	fitGaussGpNativeBatch(binned ? binTimes : times, binned ? binPtrs : data, 
+		counts, starts, best, tempErrors, iterations);
+	
+	vector<double> tempTimes;
+	tempTimes.reserve(best.size());
+	for(vector<GpParams>::const_iterator it = best.begin(); it != best.end(); it++) {
+		tempTimes.push_back(it->timescale);
 	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	timescales.swap(tempTimes);
+	timeErrors.swap(tempErrors);
+	boost::mutex::scoped_lock guard(iterationLock());
+	for(size_t i = 0; i < iterations.size(); i++) {
+		if (iterations[i] >= 0) {
+			gpFitCount()++;
+			gpIterationCount() += iterations[i];
+			if (binned) {
+				recordBinningBias(best[i].timescale, spread);
+			}
+		}
+	}
+}
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model using R
+ * 
+ * The fit is done by an R worker if setRWorkers() was called, and 
+ * otherwise by the rgp plugin, which runs gptk in an embedded R 
+ * interpreter.
+ * 
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve (typically fluxes or magnitudes)
+ * @param[in] start The hyperparameters from which to start the 
+ *	optimization. NaN members start from the gptk defaults.
+ * @param[out] best The best-fit hyperparameters
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ * @param[out] iterations Always -1, as gptk does not report how many 
+ *	iterations it took.
+ * 
+ * @pre @p times contains at least two unique values
+ * @pre @p times.size() = @p data.size()
+ * @pre for all i, @p data[i] is the measurement taken at @p time[i]
+ * @pre Neither @p times nor @p data may contain NaNs
+ * 
+ * @post @p best and @p timeError contain the best-fit estimate 
+ *	of the correlation timescale for a Gaussian process model
+ * @post @p best.timescale > 0
+ * @post @p timeError > 0
+ * 
+ * @perform O(N<sup>3</sup>) time, where N = @p times.size()
+ * @perfmore O(N<sup>2</sup>) memory
+ * @perfmore Calls from different threads are serialized, as the embedded 
+ *	R interpreter is not thread-safe, unless setRWorkers() was called. 
+ *	In that case, the fits are done by separate R processes, and 
+ *	calls from different threads run in parallel.
+ * @perfmore The first call without R workers loads the rgp plugin 
+ *	and starts R, unless loadGpPlugin() already did.
+ * @perfmore The embedded R interpreter cannot be interrupted, so a 
+ *	StatDeadline is only checked before the fit starts. Fits done by 
+ *	R workers are abandoned as soon as the deadline passes.
+ * 
+ * @exception lcmc::utils::except::UnexpectedNan Thrown if there are any 
+ *	NaN values present in @p times or @p data.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times and @p data do 
+ *	not have at least two values. 
+ * @exception std::invalid_argument Thrown if @p times and @p data 
+ *	do not have the same length.
+ * @exception std::runtime_error Thrown if the rgp plugin could not be 
+ *	loaded, or if the internal calculations produce an error.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past 
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit 
+ *	the model.
+ * 
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void fitGaussGpR(const vector<double>& times, const vector<double>& data, 
+		const GpParams& start, GpParams& best, double& timeError, 
+		long& iterations) {
+	if (times.size() < 2) {
+		throw except::NotEnoughData("Cannot fit Gaussian process model with fewer than 2 data points (gave " 
+			+ lexical_cast<string>(times.size()) + ").");
+	}
+	if (times.size() != data.size()) {
+		throw std::invalid_argument("Data and time arrays passed to fitGaussGpR() must have the same length (gave " 
+			+ lexical_cast<string>(times.size()) + " for times and " 
+			+ lexical_cast<string>( data.size()) + " for data)");
+	}
+	
+	if (fitInRWorker(times, data, start, best, timeError)) {
+		iterations = -1;
+		return;
+	}
+	
+	fitGaussGpPlugin(R_PLUGIN, times, data, start, best, timeError, iterations);
+}
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model using a statistics plugin
+ * 
+ * @param[in] plugin The name of the plugin, as for loadStatPlugin().
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve (typically fluxes or magnitudes)
+ * @param[in] start The hyperparameters from which to start the 
+ *	optimization. NaN members start from the plugin's defaults.
+ * @param[out] best The best-fit hyperparameters
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ * @param[out] iterations The number of optimizer iterations, or -1 if 
+ *	the plugin does not report them.
+ * 
+ * @pre @p times contains at least two unique values
+ * @pre @p times.size() = @p data.size()
+ * @pre for all i, @p data[i] is the measurement taken at @p time[i]
+ * @pre Neither @p times nor @p data may contain NaNs
+ * 
+ * @post @p best and @p timeError contain the best-fit estimate 
+ *	of the correlation timescale for a Gaussian process model
+ * @post @p best.timescale > 0
+ * @post @p timeError > 0
+ * 
+ * @perform Depends on the plugin; the first call loads it.
+ * @perfmore Calls from different threads are serialized unless the 
+ *	plugin declares itself thread-safe. Plugins cannot be interrupted, 
+ *	so a StatDeadline is only checked before the fit starts.
+ * 
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times and @p data do 
+ *	not have at least two values. 
+ * @exception std::invalid_argument Thrown if @p times and @p data 
+ *	do not have the same length, or if @p plugin is not a valid name.
+ * @exception std::runtime_error Thrown if the plugin could not be 
+ *	loaded, does not fit Gaussian processes, or reports an error.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit starts past 
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit 
+ *	the model.
+ * 
+ * @exceptsafe The function arguments are unchanged in the event 
+ *	of an exception.
+ */
+void fitGaussGpPlugin(const string& plugin, 
+		const vector<double>& times, const vector<double>& data, 
+		const GpParams& start, GpParams& best, double& timeError, 
+		long& iterations) {
+	if (times.size() < 2) {
+		throw except::NotEnoughData("Cannot fit Gaussian process model with fewer than 2 data points (gave " 
+			+ lexical_cast<string>(times.size()) + ").");
+	}
+	if (times.size() != data.size()) {
+		throw std::invalid_argument("Data and time arrays passed to fitGaussGpPlugin() must have the same length (gave " 
+			+ lexical_cast<string>(times.size()) + " for times and " 
+			+ lexical_cast<string>( data.size()) + " for data)");
+	}
+	
+	const LcmcStatPlugin& fitter = loadStatPlugin(plugin);
+	if (fitter.fitGp == NULL) {
+		throw std::runtime_error("Statistics plugin '" + plugin 
+			+ "' does not fit Gaussian process models.");
+	}
+	
+	const double startParams[3] = {start.timescale, start.variance, start.noise};
+	double params[3];
+	double tempErr;
+	long tempIter;
+	vector<char> message(1024, '\0');
+	int status;
+	{
+		// Plugins that are not thread-safe share one lock, as they 
+		//	may share libraries (e.g., R)
+		static boost::mutex pluginLock;
+		boost::mutex::scoped_lock guard(pluginLock, boost::defer_lock);
+		if (!fitter.threadSafe) {
+			guard.lock();
+		}
+		// Waiting for the lock may have used up the time limit
+		checkDeadline();
+		
+		status = fitter.fitGp(&times[0], &data[0], times.size(), startParams, 
+			params, &tempErr, &tempIter, &message[0], message.size());
+	}
+	
+	if (status == LCMC_PLUGIN_NO_MEMORY) {
+		throw std::bad_alloc();
+	} else if (status != LCMC_PLUGIN_OK) {
+		throw std::runtime_error("In fitGaussGpPlugin(), plugin '" + plugin 
+			+ "' failed: " + string(&message[0]));
+	}
+	// Plugins may report failed fits as NaN (e.g., from R's NA), but 
+	// we don't want to allow those solutions
+	if (kpfutils::isNan(params[0])) {
+		throw std::runtime_error("In fitGaussGpPlugin(), code ran successfully, but time scale was NA");
+	}
+	if (kpfutils::isNan(tempErr)) {
+		throw std::runtime_error("In fitGaussGpPlugin(), found a time scale, but time scale error was NA");
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	best.timescale = params[0];
+	best.variance  = params[1];
+	best.noise     = params[2];
+	timeError  = tempErr;
+	iterations = tempIter;
 }
 
 }}		// end lcmc::stats
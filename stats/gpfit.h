@@ -2,23 +2,203 @@
  * @file lightcurveMC/stats/gpfit.h
  * @author Krzysztof Findeisen
  * @date Created June 24, 2013
- * @date Last modified June 24, 2013
+ * @date Last modified October 14, 2026
  */
 
 #ifndef LCMCGPFITH
 #define LCMCGPFITH
 
+#include <string>
 #include <vector>
+#include "statstatus.h"
 
 namespace lcmc { namespace stats {
 
 using std::vector;
 
+/** Type used to tell the program how to fit Gaussian process models
+ */
+enum GpFitMethod {
+	/** Fits the model with the gptk package in an embedded R interpreter, 
+	 *	loaded from the rgp plugin
+	 */
+	GPFIT_R, 
+	/** Fits the model with native code
+	 */
+	GPFIT_NATIVE, 
+	/** Fits the model with the plugin chosen by setGpPlugin()
+	 */
+	GPFIT_PLUGIN
+};
+
+/** Selects how fitGaussGp() fits Gaussian process models
+ */
+void setGpFitMethod(GpFitMethod method);
+
+/** Returns the method chosen with setGpFitMethod()
+ */
+GpFitMethod getGpFitMethod();
+
+/** Selects the statistics plugin used for GPFIT_PLUGIN
+ */
+void setGpPlugin(const std::string& name);
+
+/** Returns the plugin chosen with setGpPlugin()
+ */
+std::string getGpPlugin();
+
+/** Loads the plugin, if any, that fitGaussGp() will use
+ */
+void loadGpPlugin();
+
+/** Type used to tell the program where to start Gaussian process fits
+ */
+enum GpStart {
+	/** Starts from the gptk defaults, a timescale of 1
+	 */
+	GPSTART_DEFAULT, 
+	/** Starts from the last solution found on the same thread
+	 */
+	GPSTART_PREVIOUS, 
+	/** Starts from the timescale used to simulate the light curve
+	 */
+	GPSTART_TRUE, 
+	/** Starts from the middle of the range of simulated timescales
+	 */
+	GPSTART_MIDPOINT
+};
+
+/** The hyperparameters of a squared exponential plus white noise 
+ *	Gaussian process model
+ *
+ * The variances are in units of the sample variance of the light curve.
+ * When used as a starting point, any member may be NaN to start that 
+ * hyperparameter from the gptk default.
+ */
+struct GpParams {
+	/** The coherence time of the squared exponential kernel */
+	double timescale;
+	/** The variance of the squared exponential kernel */
+	double variance;
+	/** The variance of the white noise */
+	double noise;
+};
+
+/** Selects where fitGaussGp() starts its optimization
+ */
+void setGpStart(GpStart policy, double midpoint);
+
+/** Reports how many optimizer iterations fitGaussGp() has taken
+ */
+void getGpIterations(long& nFits, long& nIterations);
+
+/** Selects whether fitGaussGp() bins light curves before fitting them
+ */
+void setGpBinning(double binWidth);
+
+/** Returns the bin width chosen with setGpBinning()
+ */
+double getGpBinning();
+
+/** Reports the timescale bias introduced by setGpBinning()
+ */
+void getGpBinningBias(long& nFits, double& meanBias, long& nUnresolved);
+
+/** Averages a light curve over bins of fixed width
+ */
+void binLightCurve(const vector<double>& times, const vector<double>& data, 
+		double binWidth, vector<double>& binTimes, vector<double>& binData, 
+		vector<double>& counts, double& spread);
+
+/** Fits Gaussian process models in separate R processes
+ */
+void setRWorkers(long nWorkers);
+
 /** Finds the best fit solution to a squared exponential Gaussian process model
  */
 void fitGaussGp(const vector<double>& times, const vector<double>& data, 
 		double& timescale, double& timeError);
 
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model, starting from the guess chosen by setGpStart()
+ */
+void fitGaussGp(const vector<double>& times, const vector<double>& data, 
+		double trueTime, double& timescale, double& timeError);
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model, reporting failed fits without exceptions
+ */
+StatStatus tryFitGaussGp(const vector<double>& times, const vector<double>& data, 
+		double trueTime, double& timescale, double& timeError);
+
+/** Tests whether fitGaussGpBatch() may be used
+ */
+bool gpBatchable();
+
+/** Finds the best fit solutions to squared exponential Gaussian process 
+ *	models of several light curves sampled at the same times
+ */
+void fitGaussGpBatch(const vector<double>& times, 
+		const vector<const vector<double>*>& data, 
+		const vector<double>& trueTimes, 
+		vector<double>& timescales, vector<double>& timeErrors);
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model using R
+ */
+void fitGaussGpR(const vector<double>& times, const vector<double>& data, 
+		const GpParams& start, GpParams& best, double& timeError, 
+		long& iterations);
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model using a statistics plugin
+ */
+void fitGaussGpPlugin(const std::string& plugin, 
+		const vector<double>& times, const vector<double>& data, 
+		const GpParams& start, GpParams& best, double& timeError, 
+		long& iterations);
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model without using R
+ */
+void fitGaussGpNative(const vector<double>& times, const vector<double>& data, 
+		const GpParams& start, GpParams& best, double& timeError, 
+		long& iterations);
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model of a binned light curve without using R
+ */
+void fitGaussGpNative(const vector<double>& times, const vector<double>& data, 
+		const vector<double>& counts, const GpParams& start, GpParams& best, 
+		double& timeError, long& iterations);
+
+/** Finds the best fit solution to a squared exponential Gaussian process 
+ *	model of a binned light curve without using R, reporting failed 
+ *	fits without exceptions
+ */
+StatStatus tryFitGaussGpNative(const vector<double>& times, 
+		const vector<double>& data, const vector<double>& counts, 
+		const GpParams& start, GpParams& best, double& timeError, 
+		long& iterations);
+
+/** Finds the best fit solutions to squared exponential Gaussian process 
+ *	models of several light curves sampled at the same times without 
+ *	using R
+ */
+void fitGaussGpNativeBatch(const vector<double>& times, 
+		const vector<const vector<double>*>& data, 
+		const vector<GpParams>& starts, vector<GpParams>& best, 
+		vector<double>& timeErrors, vector<long>& iterations);
+
+/** Finds the best fit solutions to squared exponential Gaussian process 
+ *	models of several binned light curves sampled at the same times 
+ *	without using R
+ */
+void fitGaussGpNativeBatch(const vector<double>& times, 
+		const vector<const vector<double>*>& data, const vector<double>& counts, 
+		const vector<GpParams>& starts, vector<GpParams>& best, 
+		vector<double>& timeErrors, vector<long>& iterations);
+
 }}		// end lcmc::stats
 
 #endif		// end LCMCGPFITH
@@ -0,0 +1,1172 @@
+/** Native fitting of Gaussian Process models to data
+ * @file lightcurveMC/stats/gpnative.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_multimin.h>
+#include <gsl/gsl_statistics_double.h>
+#include <gsl/gsl_vector.h>
+#include "../../common/alloc.tmp.h"
+#include "../../common/nan.h"
+#include "../except/undefined.h"
+#include "../gsl_compat.h"
+#include "../largealloc.tmp.h"
+#include "deadline.h"
+#include "gpfit.h"
+
+namespace lcmc { namespace utils {
+
+/** Factors a matrix in place as @f$ L L^\intercal @f$
+ */
+bool choleskyInPlace(gsl_matrix* const m, double jitter);
+
+}}	// end lcmc::utils
+
+namespace lcmc { namespace stats {
+
+using std::string;
+using std::vector;
+using boost::lexical_cast;
+using boost::shared_ptr;
+using kpfutils::checkAlloc;
+
+/** The number of hyperparameters of the model: the logarithms of the
+ *	inverse squared width and variance of the squared exponential
+ *	kernel, and of the white noise variance, in that order
+ */
+const size_t GP_NPARAM = 3;
+
+/** The most quasi-Newton steps to take before giving up on a fit
+ */
+const size_t GP_MAXITER = 200;
+
+/** The largest gradient of the negative log likelihood allowed at 
+ *	a converged fit
+ */
+const double GP_GRADTOL = 1e-4;
+
+/** The factorization of a covariance matrix at one set of 
+ *	hyperparameters
+ *
+ * The factorization depends on the times of observation, but not on 
+ * the data, so light curves sampled at the same times may share one.
+ */
+struct GpFactor {
+	/** Creates a factorization that matches no hyperparameters
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	GpFactor() : positive(false), rbf(), half(), kInv() {
+		for(size_t k = 0; k < GP_NPARAM; k++) {
+			p[k] = std::numeric_limits<double>::quiet_NaN();
+		}
+	}
+
+	/** The hyperparameters at which the matrices were computed, or 
+	 *	NaN if none were */
+	double p[GP_NPARAM];
+	/** True if the covariance matrix is numerically positive definite. 
+	 *	If false, the matrices are null. */
+	bool positive;
+	/** The squared exponential part of the covariance */
+	shared_ptr<const gsl_matrix> rbf;
+	/** The Cholesky factor of the covariance */
+	shared_ptr<const gsl_matrix> half;
+	/** The inverse of the covariance, or null if it was not needed */
+	shared_ptr<const gsl_matrix> kInv;
+};
+
+/** Computes the squared time lags between observations
+ *
+ * @param[in] times The times at which a light curve was sampled.
+ *
+ * @return A matrix whose (i, j) element is <tt>(times[i] - times[j])</tt>
+ *	squared.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	store the matrix.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+shared_ptr<const gsl_matrix> lagMatrix(const vector<double>& times) {
+	const size_t n = times.size();
+	shared_ptr<gsl_matrix> lagSq(checkAlloc(utils::largeMatrixAlloc(n, n)), &gsl_matrix_free);
+	for(size_t i = 0; i < n; i++) {
+		for(size_t j = 0; j < n; j++) {
+			const double lag = times[i] - times[j];
+			gsl_matrix_set(lagSq.get(), i, j, lag*lag);
+		}
+	}
+	return lagSq;
+}
+
+/** GpLikelihood evaluates the marginal likelihood of a squared exponential
+ * plus white noise Gaussian process model, and its derivatives, for
+ * a fixed light curve.
+ *
+ * The last factorization of the covariance matrix is remembered, and 
+ * may be shared with the likelihoods of other light curves sampled at 
+ * the same times. Evaluations at the same hyperparameters, such as 
+ * the first evaluation of several fits from the same starting point, 
+ * or the Hessian at the point where the optimizer stopped, then cost 
+ * O(N<sup>2</sup>) instead of O(N<sup>3</sup>) time.
+ *
+ * The hyperparameters are the same as those of the R backend:
+ * @f$ a = \ln w @f$, @f$ b = \ln \sigma^2 @f$ and @f$ c = \ln \sigma_n^2 @f$,
+ * where the kernel is @f$ \sigma^2 e^{-w \Delta t^2/2} + \sigma_n^2 \delta_{ij} / n_i @f$
+ * and the data are shifted and scaled to zero mean and unit variance. 
+ * @f$ n_i @f$ is the number of measurements averaged into point i, 
+ * and is 1 unless the light curve was binned by binLightCurve().
+ */
+class GpLikelihood {
+public:
+	/** Prepares to fit a light curve
+	 *
+	 * @param[in] times The times at which the light curve was sampled.
+	 * @param[in] data The values of the light curve.
+	 * @param[in] counts The number of measurements averaged into each 
+	 *	value of @p data, or empty if each value is one measurement.
+	 *
+	 * @pre @p times.size() = @p data.size() &ge; 2
+	 * @pre @p counts is empty, or @p counts.size() = @p data.size() 
+	 *	and all its elements are positive
+	 *
+	 * @exception std::runtime_error Thrown if @p data has no variance.
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	store the light curve.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	GpLikelihood(const vector<double>& times, const vector<double>& data, 
+			const vector<double>& counts)
+			: n(times.size()), lagSq(lagMatrix(times)), cache(new GpFactor()), 
+			y(normalize(data)), noiseScale(invertCounts(counts, n)) {
+	}
+
+	/** Prepares to fit one of several light curves sampled at the same 
+	 *	times
+	 *
+	 * @param[in] lagSq The squared time lags, as computed by lagMatrix().
+	 * @param[in] cache The factorization shared by the light curves 
+	 *	sampled at the same times.
+	 * @param[in] data The values of the light curve.
+	 * @param[in] counts The number of measurements averaged into each 
+	 *	value of @p data, or empty if each value is one measurement. 
+	 *	Must be the same for all light curves sharing @p cache.
+	 *
+	 * @pre @p lagSq is N &times; N and @p data.size() = N &ge; 2
+	 * @pre @p counts is empty, or @p counts.size() = N and all its 
+	 *	elements are positive
+	 * @pre @p cache is only used by one thread at a time
+	 *
+	 * @exception std::runtime_error Thrown if @p data has no variance.
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	store the light curve.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	GpLikelihood(const shared_ptr<const gsl_matrix>& lagSq, 
+			const shared_ptr<GpFactor>& cache, const vector<double>& data, 
+			const vector<double>& counts)
+			: n(lagSq->size1), lagSq(lagSq), cache(cache), y(normalize(data)), 
+			noiseScale(invertCounts(counts, n)) {
+	}
+
+	/** Computes the negative log marginal likelihood, and optionally its
+	 *	gradient, at a set of hyperparameters
+	 *
+	 * @param[in] p The hyperparameters (see GP_NPARAM).
+	 * @param[out] grad If not null, set to the gradient of the return
+	 *	value with respect to @p p.
+	 *
+	 * @return The negative log likelihood, or infinity if the
+	 *	covariance matrix at @p p is not numerically positive definite.
+	 *
+	 * @perform O(N<sup>2</sup>) time and one Cholesky factorization
+	 *	if @p grad is null; otherwise, an additional O(N<sup>3</sup>)
+	 *	matrix inversion.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory
+	 *	for the calculation.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception.
+	 */
+	double negLogLike(const double p[], double grad[]) const {
+		shared_ptr<const gsl_matrix> rbf, kInv;
+		vector<double> alpha;
+		const double nll = factor(p, rbf, kInv, alpha, grad != NULL);
+		if (grad == NULL || kpfutils::isNan(nll)
+				|| nll == std::numeric_limits<double>::infinity()) {
+			return nll;
+		}
+
+		const double w     = exp(p[0]);
+		const double noise = exp(p[2]);
+
+		// dNLL/dp_k = 0.5 tr((K^-1 - alpha alpha^T) dK/dp_k)
+		double sumA = 0.0, sumB = 0.0, sumC = 0.0;
+		for(size_t i = 0; i < n; i++) {
+			const double* rbfRow = gsl_matrix_const_ptr(rbf .get(), i, 0);
+			const double*  invRow = gsl_matrix_const_ptr(kInv.get(), i, 0);
+			const double*  lagRow = gsl_matrix_const_ptr(lagSq.get(), i, 0);
+			for(size_t j = 0; j < n; j++) {
+				const double weight = invRow[j] - alpha[i]*alpha[j];
+				sumA += weight * rbfRow[j] * (-0.5 * w * lagRow[j]);
+				sumB += weight * rbfRow[j];
+			}
+			sumC += noiseScale[i] * (invRow[i] - alpha[i]*alpha[i]);
+		}
+		grad[0] = 0.5 * sumA;
+		grad[1] = 0.5 * sumB;
+		grad[2] = 0.5 * noise * sumC;
+
+		return nll;
+	}
+
+	/** Tests whether a light curve can be normalized
+	 *
+	 * @param[in] data The values of the light curve.
+	 *
+	 * @return True if @p data has a positive variance, so that a 
+	 *	GpLikelihood may be constructed from it.
+	 *
+	 * @pre @p data.size() &ge; 2
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	static bool variable(const vector<double>& data) {
+		return gsl_stats_sd(&data[0], 1, data.size()) > 0.0;
+	}
+
+	/** Computes the Hessian of the negative log marginal likelihood
+	 *	at a set of hyperparameters
+	 *
+	 * @param[in] p The hyperparameters (see GP_NPARAM).
+	 * @param[out] hess The second derivatives of negLogLike() with
+	 *	respect to @p p, in row-major order.
+	 *
+	 * @return False if the covariance matrix at @p p is not 
+	 *	numerically positive definite, in which case @p hess is 
+	 *	unchanged.
+	 *
+	 * @perform O(N<sup>3</sup>) time
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory
+	 *	for the calculation.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception.
+	 */
+	bool hessian(const double p[], double hess[GP_NPARAM*GP_NPARAM]) const {
+		shared_ptr<const gsl_matrix> rbf, kInv;
+		vector<double> alpha;
+		const double nll = factor(p, rbf, kInv, alpha, true);
+		if (kpfutils::isNan(nll) || nll == std::numeric_limits<double>::infinity()) {
+			return false;
+		}
+
+		const double w     = exp(p[0]);
+		const double noise = exp(p[2]);
+
+		// Derivatives of K: dK/da = E u, dK/db = E, dK/dc = noise S,
+		//	where E is the squared exponential part, 
+		//	u = -w lag^2/2, and S = diag(noiseScale). Also 
+		//	d2K/da2 = E u (u+1), d2K/dadb = E u, d2K/db2 = E, 
+		//	d2K/dc2 = noise S, and all others vanish.
+		shared_ptr<gsl_matrix> dKa(checkAlloc(gsl_matrix_alloc(n, n)), &gsl_matrix_free);
+		shared_ptr<gsl_matrix> dKaa(checkAlloc(gsl_matrix_alloc(n, n)), &gsl_matrix_free);
+		for(size_t i = 0; i < n; i++) {
+			for(size_t j = 0; j < n; j++) {
+				const double e = gsl_matrix_get(rbf.get(), i, j);
+				const double u = -0.5 * w * gsl_matrix_get(lagSq.get(), i, j);
+				gsl_matrix_set(dKa .get(), i, j, e*u);
+				gsl_matrix_set(dKaa.get(), i, j, e*u*(u+1.0));
+			}
+		}
+
+		// M_k = K^-1 dK/dp_k; M_c is just noise K^-1 S
+		shared_ptr<gsl_matrix> mA(checkAlloc(gsl_matrix_alloc(n, n)), &gsl_matrix_free);
+		shared_ptr<gsl_matrix> mB(checkAlloc(gsl_matrix_alloc(n, n)), &gsl_matrix_free);
+		shared_ptr<gsl_matrix> mC(checkAlloc(gsl_matrix_alloc(n, n)), &gsl_matrix_free);
+		gslCheck(gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, kInv.get(), dKa.get(),
+			0.0, mA.get()), "In fitGaussGpNative(): ");
+		gslCheck(gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, kInv.get(), rbf.get(),
+			0.0, mB.get()), "In fitGaussGpNative(): ");
+		for(size_t i = 0; i < n; i++) {
+			for(size_t j = 0; j < n; j++) {
+				gsl_matrix_set(mC.get(), i, j, 
+					gsl_matrix_get(kInv.get(), i, j) * noiseScale[j]);
+			}
+		}
+
+		// v_k = dK/dp_k alpha, so that alpha^T dK_i K^-1 dK_j alpha = v_i^T K^-1 v_j
+		vector<double> vA(n, 0.0), vB(n, 0.0), vC(n, 0.0);
+		for(size_t i = 0; i < n; i++) {
+			for(size_t j = 0; j < n; j++) {
+				vA[i] += gsl_matrix_get(dKa.get(), i, j) * alpha[j];
+				vB[i] += gsl_matrix_get(rbf.get(), i, j) * alpha[j];
+			}
+			vC[i] = noise * noiseScale[i] * alpha[i];
+		}
+
+		const gsl_matrix* const m[GP_NPARAM] = {mA.get(), mB.get(), mC.get()};
+		const double mScale[GP_NPARAM] = {1.0, 1.0, noise};
+		const vector<double>* const v[GP_NPARAM] = {&vA, &vB, &vC};
+
+		for(size_t k = 0; k < GP_NPARAM; k++) {
+			for(size_t l = k; l < GP_NPARAM; l++) {
+				// tr(M_k M_l) and v_k^T K^-1 v_l
+				double trace = 0.0, quad = 0.0;
+				for(size_t i = 0; i < n; i++) {
+					for(size_t j = 0; j < n; j++) {
+						trace += gsl_matrix_get(m[k], i, j) * gsl_matrix_get(m[l], j, i);
+						quad  += (*v[k])[i] * gsl_matrix_get(kInv.get(), i, j) * (*v[l])[j];
+					}
+				}
+				trace *= mScale[k] * mScale[l];
+
+				// tr(K^-1 d2K) and alpha^T d2K alpha
+				double trace2 = 0.0, quad2 = 0.0;
+				if (k == 0 && l == 0) {
+					secondTerms(dKaa.get(), kInv.get(), alpha, trace2, quad2);
+				} else if (k == 0 && l == 1) {
+					secondTerms(dKa .get(), kInv.get(), alpha, trace2, quad2);
+				} else if (k == 1 && l == 1) {
+					secondTerms(rbf .get(), kInv.get(), alpha, trace2, quad2);
+				} else if (k == 2 && l == 2) {
+					for(size_t i = 0; i < n; i++) {
+						trace2 += noise * noiseScale[i] * gsl_matrix_get(kInv.get(), i, i);
+						quad2  += noise * noiseScale[i] * alpha[i] * alpha[i];
+					}
+				}
+
+				const double h = 0.5*trace2 - 0.5*trace + quad - 0.5*quad2;
+				hess[k*GP_NPARAM + l] = h;
+				hess[l*GP_NPARAM + k] = h;
+			}
+		}
+		return true;
+	}
+
+private:
+	/** Shifts and scales a light curve to zero mean and unit variance
+	 *
+	 * @param[in] data The values of the light curve.
+	 *
+	 * @return The normalized light curve.
+	 *
+	 * @exception std::runtime_error Thrown if @p data has no variance.
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	store the light curve.
+	 *
+	 * @exceptsafe The arguments are unchanged in the event of an exception.
+	 */
+	static vector<double> normalize(const vector<double>& data) {
+		const size_t n = data.size();
+		const double mean = gsl_stats_mean(&data[0], 1, n);
+		// Same normalization as the R backend's scaleVal = sd(data)
+		const double sd   = gsl_stats_sd  (&data[0], 1, n);
+		if (!(sd > 0.0)) {
+			throw std::runtime_error("In fitGaussGpNative(), light curve has no variance.");
+		}
+		vector<double> y(n);
+		for(size_t i = 0; i < n; i++) {
+			y[i] = (data[i] - mean) / sd;
+		}
+		return y;
+	}
+
+	/** Converts the number of measurements in each point to the 
+	 *	relative variance of its white noise
+	 *
+	 * @param[in] counts The number of measurements averaged into each 
+	 *	point, or empty if each point is one measurement.
+	 * @param[in] n The number of points.
+	 *
+	 * @return A vector of length @p n whose ith element is 
+	 *	1/@p counts[i], or 1 if @p counts is empty.
+	 *
+	 * @exception std::invalid_argument Thrown if @p counts is neither 
+	 *	empty nor of length @p n, or has a non-positive element.
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	store the vector.
+	 *
+	 * @exceptsafe The arguments are unchanged in the event of an exception.
+	 */
+	static vector<double> invertCounts(const vector<double>& counts, size_t n) {
+		if (counts.empty()) {
+			return vector<double>(n, 1.0);
+		}
+		if (counts.size() != n) {
+			throw std::invalid_argument("Count and data arrays passed to fitGaussGpNative() must have the same length (gave " 
+				+ lexical_cast<string>(counts.size()) + " for counts and "
+				+ lexical_cast<string>(n) + " for data)");
+		}
+		vector<double> scale(n);
+		for(size_t i = 0; i < n; i++) {
+			if (!(counts[i] > 0.0)) {
+				throw std::invalid_argument("Counts passed to fitGaussGpNative() must be positive (gave " 
+					+ lexical_cast<string>(counts[i]) + ").");
+			}
+			scale[i] = 1.0 / counts[i];
+		}
+		return scale;
+	}
+
+	/** Factors the covariance matrix at a set of hyperparameters
+	 *
+	 * If the matrix was last factored at the same hyperparameters, by 
+	 * this object or by another sharing its cache, the factorization 
+	 * is reused, and only the data terms are computed.
+	 *
+	 * @param[in] p The hyperparameters (see GP_NPARAM).
+	 * @param[out] rbf The squared exponential part of the covariance.
+	 * @param[out] kInv The inverse of the covariance, if @p invert.
+	 * @param[out] alpha The product of the inverse covariance and the data.
+	 * @param[in] invert If true, compute @p kInv.
+	 *
+	 * @return The negative log likelihood, or infinity if the
+	 *	covariance matrix is not numerically positive definite.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory
+	 *	for the calculation.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception. 
+	 *	The shared factorization may have been replaced, which does 
+	 *	not change the results of any later call.
+	 */
+	double factor(const double p[], shared_ptr<const gsl_matrix>& rbf,
+			shared_ptr<const gsl_matrix>& kInv, vector<double>& alpha,
+			bool invert) const {
+		bool cached = true;
+		for(size_t k = 0; k < GP_NPARAM; k++) {
+			cached = cached && (p[k] == cache->p[k]);
+		}
+
+		if (!cached) {
+			const double w     = exp(p[0]);
+			const double var   = exp(p[1]);
+			const double noise = exp(p[2]);
+
+			// The cached matrices are reread by every later evaluation
+			shared_ptr<gsl_matrix> tempRbf(checkAlloc(utils::largeMatrixAlloc(n, n)), &gsl_matrix_free);
+			shared_ptr<gsl_matrix> tempHalf(checkAlloc(utils::largeMatrixAlloc(n, n)), &gsl_matrix_free);
+			for(size_t i = 0; i < n; i++) {
+				for(size_t j = 0; j < n; j++) {
+					const double e = var * exp(-0.5 * w * gsl_matrix_get(lagSq.get(), i, j));
+					gsl_matrix_set(tempRbf .get(), i, j, e);
+					gsl_matrix_set(tempHalf.get(), i, j, e);
+				}
+				tempHalf->data[i * tempHalf->tda + i] += noise * noiseScale[i];
+			}
+			const bool positive = utils::choleskyInPlace(tempHalf.get(), 0.0);
+
+			// IMPORTANT: no exceptions beyond this point
+
+			std::copy(p, p + GP_NPARAM, cache->p);
+			cache->positive = positive;
+			cache->rbf  = (positive ? tempRbf  : shared_ptr<gsl_matrix>());
+			cache->half = (positive ? tempHalf : shared_ptr<gsl_matrix>());
+			cache->kInv.reset();
+		}
+		if (!cache->positive) {
+			return std::numeric_limits<double>::infinity();
+		}
+		const gsl_matrix* const half = cache->half.get();
+
+		if (invert && cache->kInv.get() == NULL) {
+			// K^-1 = L^-T L^-1
+			shared_ptr<gsl_matrix> halfInv(checkAlloc(gsl_matrix_alloc(n, n)),
+				&gsl_matrix_free);
+			gsl_matrix_set_identity(halfInv.get());
+			gslCheck(gsl_blas_dtrsm(CblasLeft, CblasLower, CblasNoTrans, CblasNonUnit,
+				1.0, half, halfInv.get()), "In fitGaussGpNative(): ");
+			shared_ptr<gsl_matrix> tempInv(checkAlloc(utils::largeMatrixAlloc(n, n)), 
+				&gsl_matrix_free);
+			gslCheck(gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, halfInv.get(),
+				halfInv.get(), 0.0, tempInv.get()), "In fitGaussGpNative(): ");
+			cache->kInv = tempInv;
+		}
+
+		// alpha = L^-T L^-1 y
+		vector<double> tempAlpha(y);
+		gsl_vector_view alphaView = gsl_vector_view_array(&tempAlpha[0], n);
+		gslCheck(gsl_blas_dtrsv(CblasLower, CblasNoTrans, CblasNonUnit,
+			half, &alphaView.vector), "In fitGaussGpNative(): ");
+		double nll = 0.0;
+		for(size_t i = 0; i < n; i++) {
+			nll += 0.5 * tempAlpha[i] * tempAlpha[i] + log(gsl_matrix_get(half, i, i));
+		}
+		nll += 0.5 * static_cast<double>(n) * log(2.0*M_PI);
+		gslCheck(gsl_blas_dtrsv(CblasLower, CblasTrans, CblasNonUnit,
+			half, &alphaView.vector), "In fitGaussGpNative(): ");
+
+		// IMPORTANT: no exceptions beyond this point
+
+		rbf = cache->rbf;
+		kInv = cache->kInv;
+		alpha.swap(tempAlpha);
+		return nll;
+	}
+
+	/** Computes the terms of the Hessian that depend on a second
+	 *	derivative of the covariance
+	 *
+	 * @param[in] d2K The second derivative of the covariance.
+	 * @param[in] kInv The inverse of the covariance.
+	 * @param[in] alpha The product of @p kInv and the data.
+	 * @param[out] trace @f$ tr(K^{-1} \partial^2 K) @f$
+	 * @param[out] quad @f$ \alpha^\intercal \partial^2 K \alpha @f$
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void secondTerms(const gsl_matrix* d2K, const gsl_matrix* kInv,
+			const vector<double>& alpha, double& trace, double& quad) const {
+		trace = 0.0;
+		quad  = 0.0;
+		for(size_t i = 0; i < n; i++) {
+			for(size_t j = 0; j < n; j++) {
+				const double d = gsl_matrix_get(d2K, i, j);
+				trace += gsl_matrix_get(kInv, j, i) * d;
+				quad  += alpha[i] * d * alpha[j];
+			}
+		}
+	}
+
+	/** The number of observations */
+	size_t n;
+	/** The squared time lags between observations. Owns a
+	 *	deallocator gsl_matrix_free() */
+	shared_ptr<const gsl_matrix> lagSq;
+	/** The last factorization of the covariance, possibly shared with 
+	 *	other light curves sampled at the same times */
+	shared_ptr<GpFactor> cache;
+	/** The normalized light curve */
+	vector<double> y;
+	/** The white noise variance of each point, relative to that of 
+	 *	a single measurement */
+	vector<double> noiseScale;
+};
+
+/** State shared with the GSL minimizer callbacks
+ *
+ * GSL is a C library, so the callbacks must not throw. Any exception
+ * is recorded here and rethrown once the minimizer returns.
+ */
+struct MinimizerState {
+	/** The likelihood to minimize */
+	const GpLikelihood* model;
+	/** True if a callback ran out of memory */
+	bool outOfMemory;
+};
+
+/** Evaluates the negative log likelihood for GSL
+ *
+ * @param[in] x The hyperparameters.
+ * @param[in] params A pointer to a MinimizerState.
+ *
+ * @return The negative log likelihood, or NaN if it could not be computed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+extern "C" double gpNllF(const gsl_vector* x, void* params) {
+	MinimizerState* state = static_cast<MinimizerState*>(params);
+	const double p[GP_NPARAM] = {gsl_vector_get(x, 0), gsl_vector_get(x, 1),
+		gsl_vector_get(x, 2)};
+	try {
+		return state->model->negLogLike(p, NULL);
+	} catch (const std::bad_alloc& e) {
+		state->outOfMemory = true;
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+}
+
+/** Evaluates the negative log likelihood and its gradient for GSL
+ *
+ * @param[in] x The hyperparameters.
+ * @param[in] params A pointer to a MinimizerState.
+ * @param[out] f The negative log likelihood, or NaN if it could not
+ *	be computed.
+ * @param[out] g The gradient of @p f.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+extern "C" void gpNllFdf(const gsl_vector* x, void* params, double* f, gsl_vector* g) {
+	MinimizerState* state = static_cast<MinimizerState*>(params);
+	const double p[GP_NPARAM] = {gsl_vector_get(x, 0), gsl_vector_get(x, 1),
+		gsl_vector_get(x, 2)};
+	double grad[GP_NPARAM] = {0.0, 0.0, 0.0};
+	try {
+		*f = state->model->negLogLike(p, grad);
+	} catch (const std::bad_alloc& e) {
+		state->outOfMemory = true;
+		*f = std::numeric_limits<double>::quiet_NaN();
+	}
+	for(size_t i = 0; i < GP_NPARAM; i++) {
+		gsl_vector_set(g, i, grad[i]);
+	}
+}
+
+/** Evaluates the gradient of the negative log likelihood for GSL
+ *
+ * @param[in] x The hyperparameters.
+ * @param[in] params A pointer to a MinimizerState.
+ * @param[out] g The gradient of the negative log likelihood.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+extern "C" void gpNllDf(const gsl_vector* x, void* params, gsl_vector* g) {
+	double f;
+	gpNllFdf(x, params, &f, g);
+}
+
+/** GpOptimizer maximizes the likelihood of one Gaussian process model 
+ * one quasi-Newton step at a time.
+ *
+ * Stepping lets several fits be interleaved, so that fits of light 
+ * curves sharing a factorization cache evaluate the same 
+ * hyperparameters close together.
+ */
+class GpOptimizer {
+public:
+	/** Prepares to fit a model
+	 *
+	 * @param[in] model The likelihood to maximize. Must outlive the 
+	 *	optimizer.
+	 * @param[in] start The hyperparameters from which to start the
+	 *	optimization. NaN members start from the defaults.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	set up the optimizer.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	GpOptimizer(const GpLikelihood& model, const GpParams& start) 
+			: model(model), state(), objective(), minimizer(), 
+			converged(false), done(false), nIter(0) {
+		state.model       = &model;
+		state.outOfMemory = false;
+
+		objective.n      = GP_NPARAM;
+		objective.f      = &gpNllF;
+		objective.df     = &gpNllDf;
+		objective.fdf    = &gpNllFdf;
+		objective.params = &state;
+
+		// Same default starting point as the R backend
+		shared_ptr<gsl_vector> x0(checkAlloc(gsl_vector_alloc(GP_NPARAM)),
+			&gsl_vector_free);
+		gsl_vector_set(x0.get(), 0, kpfutils::isNan(start.timescale)
+			?  0.0 : -2.0 * log(start.timescale));
+		gsl_vector_set(x0.get(), 1, kpfutils::isNan(start.variance)
+			?  0.0 : log(start.variance));
+		gsl_vector_set(x0.get(), 2, kpfutils::isNan(start.noise)
+			? -2.0 : log(start.noise));
+
+		minimizer.reset(checkAlloc(
+			gsl_multimin_fdfminimizer_alloc(gsl_multimin_fdfminimizer_vector_bfgs2,
+			GP_NPARAM)), &gsl_multimin_fdfminimizer_free);
+		gslCheck(gsl_multimin_fdfminimizer_set(minimizer.get(), &objective, x0.get(),
+			0.1, 0.1), "In fitGaussGpNative(): ");
+
+		if (state.outOfMemory) {
+			throw std::bad_alloc();
+		}
+		converged = (gsl_multimin_test_gradient(minimizer->gradient, GP_GRADTOL)
+			== GSL_SUCCESS);
+		done = converged;
+	}
+
+	/** Tests whether the optimizer has stopped
+	 *
+	 * @return True if step() has nothing more to do.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool finished() const {
+		return done;
+	}
+
+	/** Takes one quasi-Newton step
+	 *
+	 * @pre finished() is false
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	evaluate the likelihood.
+	 *
+	 * @exceptsafe The optimizer is left finished in the event of 
+	 *	an exception.
+	 */
+	void step() {
+		nIter++;
+		const int status = gsl_multimin_fdfminimizer_iterate(minimizer.get());
+		if (state.outOfMemory) {
+			done = true;
+			throw std::bad_alloc();
+		}
+		converged = (gsl_multimin_test_gradient(minimizer->gradient, GP_GRADTOL)
+			== GSL_SUCCESS);
+		if (status != GSL_SUCCESS) {
+			// The line search can stall within rounding error of
+			//	the minimum
+			converged = converged
+				|| gsl_multimin_test_gradient(minimizer->gradient, 100.0*GP_GRADTOL)
+				== GSL_SUCCESS;
+			done = true;
+		}
+		done = done || converged || (nIter >= static_cast<long>(GP_MAXITER));
+	}
+
+	/** Reports the result of the fit
+	 *
+	 * @param[out] best The best-fit hyperparameters
+	 * @param[out] timeError The estimated uncertainty on the model timescale
+	 * @param[out] iterations The number of quasi-Newton steps taken.
+	 *
+	 * @return STAT_OK, or STAT_NO_FIT if the fit did not converge to
+	 *	a likelihood maximum. The function arguments are only changed 
+	 *	if STAT_OK is returned.
+	 *
+	 * @pre finished() is true
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	compute the timescale error.
+	 *
+	 * @exceptsafe The function arguments are unchanged in the event of
+	 *	an exception.
+	 */
+	StatStatus result(GpParams& best, double& timeError, long& iterations) const {
+		if (!converged) {
+			return STAT_NO_FIT;
+		}
+
+		const double p[GP_NPARAM] = {gsl_vector_get(minimizer->x, 0),
+			gsl_vector_get(minimizer->x, 1), gsl_vector_get(minimizer->x, 2)};
+		double h[GP_NPARAM*GP_NPARAM];
+		if (!model.hessian(p, h)) {
+			// Covariance matrix at best fit is not positive definite
+			return STAT_NO_FIT;
+		}
+
+		// Only need the (a, a) element of the inverse Hessian
+		const double det = h[0]*(h[4]*h[8] - h[5]*h[7])
+			- h[1]*(h[3]*h[8] - h[5]*h[6])
+			+ h[2]*(h[3]*h[7] - h[4]*h[6]);
+		const double covarA = (h[4]*h[8] - h[5]*h[7]) / det;
+		if (!(covarA > 0.0) || !(det > 0.0)) {
+			// Probably not a local likelihood maximum
+			return STAT_NO_FIT;
+		}
+
+		// tau = w^-1/2, so dtau = -tau/2 d(ln w)
+		const double tempTime = exp(-0.5 * p[0]);
+		const double tempErr  = 0.5 * sqrt(covarA) * tempTime;
+		if (kpfutils::isNan(tempTime) || kpfutils::isNan(tempErr)) {
+			return STAT_NO_FIT;
+		}
+
+		// IMPORTANT: no exceptions beyond this point
+
+		best.timescale = tempTime;
+		best.variance  = exp(p[1]);
+		best.noise     = exp(p[2]);
+		timeError  = tempErr;
+		iterations = nIter;
+		return STAT_OK;
+	}
+
+private:
+	// The minimizer holds pointers into the optimizer
+	GpOptimizer(const GpOptimizer&);
+	GpOptimizer& operator=(const GpOptimizer&);
+
+	const GpLikelihood& model;
+	MinimizerState state;
+	gsl_multimin_function_fdf objective;
+	/** The GSL minimizer. Owns a deallocator 
+	 *	gsl_multimin_fdfminimizer_free() */
+	shared_ptr<gsl_multimin_fdfminimizer> minimizer;
+	bool converged;
+	bool done;
+	long nIter;
+};
+
+/** Finds the best fit solution to a squared exponential Gaussian process
+ *	model without using R
+ *
+ * Equivalent to fitGaussGpNative(times, data, counts, start, best, 
+ * timeError, iterations) with an empty @p counts.
+ *
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve (typically fluxes or magnitudes)
+ * @param[in] start The hyperparameters from which to start the
+ *	optimization. NaN members start from the defaults.
+ * @param[out] best The best-fit hyperparameters
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ * @param[out] iterations The number of quasi-Newton steps taken.
+ *
+ * @pre @p times contains at least two unique values
+ * @pre @p times.size() = @p data.size()
+ * @pre for all i, @p data[i] is the measurement taken at @p time[i]
+ * @pre Neither @p times nor @p data may contain NaNs
+ *
+ * @post @p best and @p timeError contain the best-fit estimate
+ *	of the correlation timescale for a Gaussian process model
+ * @post @p best.timescale > 0
+ * @post @p timeError > 0
+ *
+ * @perform O(N<sup>3</sup>) time per iteration, where N = @p times.size()
+ * @perfmore O(N<sup>2</sup>) memory
+ * @perfmore May be called from several threads at once.
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times and @p data do
+ *	not have at least two values.
+ * @exception std::invalid_argument Thrown if @p times and @p data
+ *	do not have the same length.
+ * @exception std::runtime_error Thrown if the fit does not converge to
+ *	a likelihood maximum.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit
+ *	the model.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of
+ *	an exception.
+ */
+void fitGaussGpNative(const vector<double>& times, const vector<double>& data,
+		const GpParams& start, GpParams& best, double& timeError,
+		long& iterations) {
+	fitGaussGpNative(times, data, vector<double>(), start, best, timeError, 
+		iterations);
+}
+
+/** Finds the best fit solution to a squared exponential Gaussian process
+ *	model without using R
+ *
+ * The model, default starting point, and error estimate are the same as
+ * for fitGaussGpR(): a squared exponential kernel plus white noise is fit
+ * to the light curve, normalized to unit variance, starting from a unit
+ * width and variance and a noise variance of e<sup>-2</sup>. The marginal
+ * likelihood is maximized by BFGS with analytic gradients, and the
+ * timescale error is found from the analytic Hessian of the likelihood
+ * with respect to the logarithms of the hyperparameters.
+ *
+ * If the light curve was binned, the white noise variance of each point 
+ * is that of a single measurement divided by the number of measurements 
+ * averaged into it, so that denser bins carry more weight.
+ *
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve (typically fluxes or magnitudes)
+ * @param[in] counts The number of measurements averaged into each 
+ *	element of @p data, or empty if each is a single measurement.
+ * @param[in] start The hyperparameters from which to start the
+ *	optimization. NaN members start from the defaults.
+ * @param[out] best The best-fit hyperparameters
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ * @param[out] iterations The number of quasi-Newton steps taken.
+ *
+ * @pre @p times contains at least two unique values
+ * @pre @p times.size() = @p data.size()
+ * @pre for all i, @p data[i] is the measurement taken at @p time[i]
+ * @pre Neither @p times nor @p data may contain NaNs
+ * @pre @p counts is empty, or its elements are all positive
+ *
+ * @post @p best and @p timeError contain the best-fit estimate
+ *	of the correlation timescale for a Gaussian process model
+ * @post @p best.timescale > 0
+ * @post @p timeError > 0
+ *
+ * @perform O(N<sup>3</sup>) time per iteration, where N = @p times.size()
+ * @perfmore O(N<sup>2</sup>) memory
+ * @perfmore May be called from several threads at once.
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times and @p data do
+ *	not have at least two values.
+ * @exception std::invalid_argument Thrown if @p times and @p data
+ *	do not have the same length, or if @p counts is not empty and 
+ *	does not have the same length as @p data.
+ * @exception std::runtime_error Thrown if the fit does not converge to
+ *	a likelihood maximum.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit
+ *	the model.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of
+ *	an exception.
+ */
+void fitGaussGpNative(const vector<double>& times, const vector<double>& data,
+		const vector<double>& counts, const GpParams& start, GpParams& best, 
+		double& timeError, long& iterations) {
+	const StatStatus status = tryFitGaussGpNative(times, data, counts, start, 
+		best, timeError, iterations);
+	if (status == STAT_NOT_ENOUGH_DATA) {
+		throw except::NotEnoughData("Cannot fit Gaussian process model with fewer than 2 data points (gave "
+			+ lexical_cast<string>(times.size()) + ").");
+	} else if (status == STAT_UNDEFINED) {
+		throw std::runtime_error("In fitGaussGpNative(), light curve has no variance.");
+	} else if (status != STAT_OK) {
+		throw std::runtime_error("In fitGaussGpNative(), optimizer did not converge to a likelihood maximum.");
+	}
+}
+
+/** Finds the best fit solution to a squared exponential Gaussian process
+ *	model without using R, reporting failed fits without exceptions
+ *
+ * The fit is the same as for fitGaussGpNative(), but light curves that 
+ * cannot be fit, which are common in bins of flat or noisy light 
+ * curves, are reported by the return value.
+ *
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve (typically fluxes or magnitudes)
+ * @param[in] counts The number of measurements averaged into each 
+ *	element of @p data, or empty if each is a single measurement.
+ * @param[in] start The hyperparameters from which to start the
+ *	optimization. NaN members start from the defaults.
+ * @param[out] best The best-fit hyperparameters
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ * @param[out] iterations The number of quasi-Newton steps taken.
+ *
+ * @return STAT_OK if the fit succeeded, STAT_NOT_ENOUGH_DATA if 
+ *	@p times has fewer than two values, STAT_UNDEFINED if @p data has 
+ *	no variance, or STAT_NO_FIT if the fit did not converge to a 
+ *	likelihood maximum. @p best, @p timeError, and @p iterations are 
+ *	only changed if STAT_OK is returned.
+ *
+ * @pre for all i, @p data[i] is the measurement taken at @p time[i]
+ * @pre Neither @p times nor @p data may contain NaNs
+ * @pre @p counts is empty, or its elements are all positive
+ *
+ * @perform O(N<sup>3</sup>) time per iteration, where N = @p times.size()
+ * @perfmore O(N<sup>2</sup>) memory
+ * @perfmore May be called from several threads at once.
+ *
+ * @exception std::invalid_argument Thrown if @p times and @p data
+ *	do not have the same length, or if @p counts is not empty and 
+ *	does not have the same length as @p data.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fit runs past
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit
+ *	the model.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of
+ *	an exception.
+ */
+StatStatus tryFitGaussGpNative(const vector<double>& times, 
+		const vector<double>& data, const vector<double>& counts, 
+		const GpParams& start, GpParams& best, double& timeError, 
+		long& iterations) {
+	if (times.size() != data.size()) {
+		throw std::invalid_argument("Data and time arrays passed to fitGaussGpNative() must have the same length (gave "
+			+ lexical_cast<string>(times.size()) + " for times and "
+			+ lexical_cast<string>( data.size()) + " for data)");
+	}
+	if (times.size() < 2) {
+		return STAT_NOT_ENOUGH_DATA;
+	}
+	if (!GpLikelihood::variable(data)) {
+		return STAT_UNDEFINED;
+	}
+
+	const GpLikelihood model(times, data, counts);
+	GpOptimizer optimizer(model, start);
+	while (!optimizer.finished()) {
+		checkDeadline();
+		optimizer.step();
+	}
+	return optimizer.result(best, timeError, iterations);
+}
+
+/** Finds the best fit solutions to squared exponential Gaussian process
+ *	models of several light curves sampled at the same times
+ *
+ * Equivalent to fitGaussGpNativeBatch(times, data, counts, starts, 
+ * best, timeErrors, iterations) with an empty @p counts.
+ *
+ * @param[in] times The times at which the light curves were sampled.
+ * @param[in] data The values of each light curve.
+ * @param[in] starts The hyperparameters from which to start each
+ *	optimization. NaN members start from the defaults.
+ * @param[out] best The best-fit hyperparameters of each light curve, 
+ *	or NaN if its fit failed.
+ * @param[out] timeErrors The estimated uncertainty on each model 
+ *	timescale, or NaN if its fit failed.
+ * @param[out] iterations The number of quasi-Newton steps taken by 
+ *	each fit, or -1 if it failed.
+ *
+ * @pre @p times contains at least two unique values
+ * @pre For all i, @p data[i] is not null, @p data[i]->size() = 
+ *	@p times.size(), and @p data[i] contains no NaNs
+ * @pre @p starts.size() = @p data.size()
+ *
+ * @post @p best.size() = @p timeErrors.size() = @p iterations.size() 
+ *	= @p data.size()
+ *
+ * @perform O(N<sup>3</sup>) time per distinct set of hyperparameters 
+ *	evaluated, and O(N<sup>2</sup>) time per light curve per iteration, 
+ *	where N = @p times.size()
+ * @perfmore O(N<sup>2</sup>) memory
+ * @perfmore May be called from several threads at once.
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
+ *	does not have at least two values.
+ * @exception std::invalid_argument Thrown if any element of @p data 
+ *	does not have the same length as @p times, or if @p starts does 
+ *	not have the same length as @p data.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fits run past
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit
+ *	the models.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of
+ *	an exception.
+ */
+void fitGaussGpNativeBatch(const vector<double>& times, 
+		const vector<const vector<double>*>& data, 
+		const vector<GpParams>& starts, vector<GpParams>& best, 
+		vector<double>& timeErrors, vector<long>& iterations) {
+	fitGaussGpNativeBatch(times, data, vector<double>(), starts, best, 
+		timeErrors, iterations);
+}
+
+/** Finds the best fit solutions to squared exponential Gaussian process
+ *	models of several light curves sampled at the same times
+ *
+ * Each fit is the same as the one fitGaussGpNative() would do. The fits 
+ * share the time lags between observations and the factorization of 
+ * the covariance matrix, and take their quasi-Newton steps in turn, so 
+ * fits that evaluate the same hyperparameters (for example, their 
+ * common starting point) only factor the covariance matrix once.
+ *
+ * @param[in] times The times at which the light curves were sampled.
+ * @param[in] data The values of each light curve.
+ * @param[in] counts The number of measurements averaged into each 
+ *	point of the light curves, or empty if each is a single measurement.
+ * @param[in] starts The hyperparameters from which to start each
+ *	optimization. NaN members start from the defaults.
+ * @param[out] best The best-fit hyperparameters of each light curve, 
+ *	or NaN if its fit failed.
+ * @param[out] timeErrors The estimated uncertainty on each model 
+ *	timescale, or NaN if its fit failed.
+ * @param[out] iterations The number of quasi-Newton steps taken by 
+ *	each fit, or -1 if it failed.
+ *
+ * @pre @p times contains at least two unique values
+ * @pre For all i, @p data[i] is not null, @p data[i]->size() = 
+ *	@p times.size(), and @p data[i] contains no NaNs
+ * @pre @p starts.size() = @p data.size()
+ * @pre @p counts is empty, or its elements are all positive
+ *
+ * @post @p best.size() = @p timeErrors.size() = @p iterations.size() 
+ *	= @p data.size()
+ *
+ * @perform O(N<sup>3</sup>) time per distinct set of hyperparameters 
+ *	evaluated, and O(N<sup>2</sup>) time per light curve per iteration, 
+ *	where N = @p times.size()
+ * @perfmore O(N<sup>2</sup>) memory
+ * @perfmore May be called from several threads at once.
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
+ *	does not have at least two values.
+ * @exception std::invalid_argument Thrown if any element of @p data 
+ *	does not have the same length as @p times, if @p starts does 
+ *	not have the same length as @p data, or if @p counts is not 
+ *	empty and does not have the same length as @p times.
+ * @exception lcmc::stats::except::TimedOut Thrown if the fits run past
+ *	the current thread's StatDeadline.
+ * @exception std::bad_alloc Thrown if there is not enough memory to fit
+ *	the models.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of
+ *	an exception.
+ */
+void fitGaussGpNativeBatch(const vector<double>& times, 
+		const vector<const vector<double>*>& data, const vector<double>& counts, 
+		const vector<GpParams>& starts, vector<GpParams>& best, 
+		vector<double>& timeErrors, vector<long>& iterations) {
+	if (times.size() < 2) {
+		throw except::NotEnoughData("Cannot fit Gaussian process model with fewer than 2 data points (gave "
+			+ lexical_cast<string>(times.size()) + ").");
+	}
+	if (starts.size() != data.size()) {
+		throw std::invalid_argument("Start and data arrays passed to fitGaussGpNativeBatch() must have the same length (gave "
+			+ lexical_cast<string>(starts.size()) + " for starts and "
+			+ lexical_cast<string>(  data.size()) + " for data)");
+	}
+	if (!counts.empty() && counts.size() != times.size()) {
+		throw std::invalid_argument("Count and time arrays passed to fitGaussGpNativeBatch() must have the same length (gave "
+			+ lexical_cast<string>(counts.size()) + " for counts and "
+			+ lexical_cast<string>( times.size()) + " for times)");
+	}
+	for(size_t i = 0; i < data.size(); i++) {
+		if (times.size() != data[i]->size()) {
+			throw std::invalid_argument("Data and time arrays passed to fitGaussGpNativeBatch() must have the same length (gave "
+				+ lexical_cast<string>(   times.size()) + " for times and "
+				+ lexical_cast<string>(data[i]->size()) + " for data)");
+		}
+	}
+
+	const size_t nCurves = data.size();
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	const GpParams failed = {nan, nan, nan};
+	vector<GpParams> tempBest(nCurves, failed);
+	vector<double> tempErrors(nCurves, nan);
+	vector<long> tempIter(nCurves, -1);
+
+	const shared_ptr<const gsl_matrix> lagSq = lagMatrix(times);
+	const shared_ptr<GpFactor> cache(new GpFactor());
+
+	// A failed fit leaves null pointers, and is skipped by later steps
+	vector<shared_ptr<GpLikelihood> > models(nCurves);
+	vector<shared_ptr<GpOptimizer> > optimizers(nCurves);
+	for(size_t i = 0; i < nCurves; i++) {
+		if (GpLikelihood::variable(*data[i])) {
+			models[i].reset(new GpLikelihood(lagSq, cache, *data[i], counts));
+			optimizers[i].reset(new GpOptimizer(*models[i], starts[i]));
+		}
+	}
+
+	// Step the fits in turn, so that fits at the same point hit the cache
+	bool running = true;
+	while (running) {
+		running = false;
+		for(size_t i = 0; i < nCurves; i++) {
+			if (optimizers[i].get() != NULL && !optimizers[i]->finished()) {
+				optimizers[i]->step();
+				running = true;
+			}
+		}
+		if (running) {
+			checkDeadline();
+		}
+	}
+
+	for(size_t i = 0; i < nCurves; i++) {
+		if (optimizers[i].get() != NULL) {
+			// A failed result() leaves the failure values alone
+			optimizers[i]->result(tempBest[i], tempErrors[i], tempIter[i]);
+		}
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	best.swap(tempBest);
+	timeErrors.swap(tempErrors);
+	iterations.swap(tempIter);
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,1007 @@
+/** Precomputed Lomb-Scargle periodograms for a fixed cadence
+ * @file lightcurveMC/stats/lsplan.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#if defined(LCMC_USE_AVX512) || defined(LCMC_USE_AVX2)
+#include <immintrin.h>
+#endif
+#include <gsl/gsl_fft_complex.h>
+#include <timescales/timescales.h>
+#include "../cachestats.h"
+#include "../gsl_compat.h"
+#include "../numa.h"
+#include "deadline.h"
+#include "devicestats.h"
+#include "lsplan.h"
+
+namespace lcmc { namespace stats {
+
+using boost::lexical_cast;
+using boost::shared_ptr;
+using std::string;
+
+/** The largest number of values (frequencies times observations) for
+ *	which a plan stores trigonometric tables
+ *
+ * Each table of this size takes 32 MB.
+ */
+const size_t MAX_TABLE_SIZE = 4*1024*1024;
+
+/** The number of grid points to which each observation is extirpolated 
+ *	by @ref LS_FAST "LS_FAST"
+ */
+const size_t EXTIRP_ORDER = 6;
+
+/** The minimum ratio of the FFT length to the highest frequency index 
+ *	used by @ref LS_FAST "LS_FAST"
+ *
+ * Larger values make the extirpolation more accurate.
+ */
+const size_t FFT_OVERSAMPLE = 8;
+
+/** The number of frequencies between checks of the caller's StatDeadline
+ */
+const size_t DEADLINE_STRIDE = 256;
+
+/** The number of light curves whose sums lombScargleBatch() 
+ *	accumulates in a single pass over the plan
+ *
+ * Larger batches are split, so that the running sums stay in 
+ * registers or the first-level cache.
+ */
+const size_t MAX_BATCH = 16;
+
+/** The largest number of products that floatTrigSums() adds in single 
+ *	precision before moving the total to a double
+ *
+ * Smaller blocks round less, but spend more time on the transfers.
+ */
+const size_t FLOAT_BLOCK = 256;
+
+/** Returns the precision chosen with setPeriodogramPrecision()
+ *
+ * @return A modifiable reference to the precision.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ValuePrecision& periodogramPrecision() {
+	static ValuePrecision precision = DOUBLE_PRECISION;
+	return precision;
+}
+
+/** Chooses the precision of the trigonometric tables of new 
+ *	periodogram plans
+ *
+ * Single-precision tables take half the memory, so tables are kept for 
+ * cadences and frequency grids twice as large, and each SIMD operation 
+ * of lombScargle() covers twice as many observations. The phases are 
+ * still computed in double precision, from times relative to the 
+ * plan's epoch, so the only error is the rounding of each table entry 
+ * and of the single-precision sums in floatTrigSums(). Each sum of 
+ * <i>B</i> = FLOAT_BLOCK products is off by at most about 
+ * <i>B</i>&nbsp;&times;&nbsp;2<sup>-24</sup> &asymp; 1.5&times;10<sup>-5</sup> 
+ * of the sum of |<i>y<sub>i</sub></i>| it covers, so powers change in 
+ * about the fifth significant figure, far below the scatter between 
+ * noise peaks.
+ *
+ * @param[in] precision The precision of plans created from now on.
+ *
+ * @post PeriodogramPlan::forCadence() builds plans whose tables are 
+ *	stored at @p precision. Existing plans are unchanged.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void setPeriodogramPrecision(ValuePrecision precision) {
+	periodogramPrecision() = precision;
+}
+
+/** Returns the precision chosen with setPeriodogramPrecision()
+ *
+ * @return The precision of the tables of new plans.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ValuePrecision getPeriodogramPrecision() {
+	return periodogramPrecision();
+}
+
+/** Subtracts the mean from a light curve
+ *
+ * @param[in] data The values of the light curve.
+ * @param[out] resid The array in which to store @p data minus its 
+ *	mean. Element i is stored at <tt>resid[i*stride]</tt>.
+ * @param[in] stride The spacing of the elements of @p resid.
+ *
+ * @return The sample variance of @p data.
+ *
+ * @pre @p data.size() &ge; 2
+ * @pre @p resid has room for @p data.size() elements at spacing 
+ *	@p stride.
+ *
+ * @perform O(N) time, where N = @p data.size()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double centerData(const vector<double>& data, double resid[], size_t stride) {
+	const size_t n = data.size();
+	
+	double mean = 0.0;
+	for(size_t i = 0; i < n; i++) {
+		mean += data[i];
+	}
+	mean /= n;
+
+	double var = 0.0;
+	for(size_t i = 0; i < n; i++) {
+		const double r = data[i] - mean;
+		resid[i*stride] = r;
+		var += r*r;
+	}
+	return var / (n - 1);
+}
+
+/** Computes the sums of a light curve times the terms of a 
+ *	single-precision table
+ *
+ * @param[in] resid The centered values of the light curve.
+ * @param[in] cosRow, sinRow The table entries for each value of @p resid.
+ * @param[in] n The number of elements in each array.
+ * @param[out] yc, ys The sums of @p resid times @p cosRow and 
+ *	@p sinRow, respectively.
+ *
+ * @perform O(@p n) time. Products are added in single precision, in 
+ *	blocks of FLOAT_BLOCK, and the block totals in double precision. 
+ *	If the program was built with SIMD=avx2 or SIMD=avx512, eight or 
+ *	sixteen products are computed at a time, twice as many as the 
+ *	same instructions handle in double precision.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void floatTrigSums(const float resid[], const float cosRow[], 
+		const float sinRow[], size_t n, double& yc, double& ys) {
+	double sumCos = 0.0, sumSin = 0.0;
+	size_t i = 0;
+#if defined(LCMC_USE_AVX512)
+	const size_t LANES = 16;
+	float partCos[LANES], partSin[LANES];
+	while (i + LANES <= n) {
+		const size_t end = i + std::min(FLOAT_BLOCK, (n - i) / LANES * LANES);
+		__m512 c = _mm512_setzero_ps();
+		__m512 s = _mm512_setzero_ps();
+		for (; i < end; i += LANES) {
+			const __m512 r = _mm512_loadu_ps(resid + i);
+			c = _mm512_add_ps(c, _mm512_mul_ps(r, _mm512_loadu_ps(cosRow + i)));
+			s = _mm512_add_ps(s, _mm512_mul_ps(r, _mm512_loadu_ps(sinRow + i)));
+		}
+		_mm512_storeu_ps(partCos, c);
+		_mm512_storeu_ps(partSin, s);
+		for (size_t k = 0; k < LANES; k++) {
+			sumCos += partCos[k];
+			sumSin += partSin[k];
+		}
+	}
+#elif defined(LCMC_USE_AVX2)
+	const size_t LANES = 8;
+	float partCos[LANES], partSin[LANES];
+	while (i + LANES <= n) {
+		const size_t end = i + std::min(FLOAT_BLOCK, (n - i) / LANES * LANES);
+		__m256 c = _mm256_setzero_ps();
+		__m256 s = _mm256_setzero_ps();
+		for (; i < end; i += LANES) {
+			const __m256 r = _mm256_loadu_ps(resid + i);
+			c = _mm256_add_ps(c, _mm256_mul_ps(r, _mm256_loadu_ps(cosRow + i)));
+			s = _mm256_add_ps(s, _mm256_mul_ps(r, _mm256_loadu_ps(sinRow + i)));
+		}
+		_mm256_storeu_ps(partCos, c);
+		_mm256_storeu_ps(partSin, s);
+		for (size_t k = 0; k < LANES; k++) {
+			sumCos += partCos[k];
+			sumSin += partSin[k];
+		}
+	}
+#endif
+	// Scalar code for the remaining values, or all of them
+	while (i < n) {
+		const size_t end = std::min(n, i + FLOAT_BLOCK);
+		float c = 0.0f, s = 0.0f;
+		for (; i < end; i++) {
+			c += resid[i] * cosRow[i];
+			s += resid[i] * sinRow[i];
+		}
+		sumCos += c;
+		sumSin += s;
+	}
+	yc = sumCos;
+	ys = sumSin;
+}
+
+/** Finds the spacing of a uniform frequency grid
+ *
+ * @param[in] freq The grid to test.
+ *
+ * @return The spacing between consecutive elements of @p freq, or 0 if 
+ *	@p freq has fewer than two elements or is not evenly spaced.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double uniformStep(const vector<double>& freq) {
+	if (freq.size() < 2) {
+		return 0.0;
+	}
+	
+	const double step = (freq.back() - freq.front()) / (freq.size() - 1);
+	if (step <= 0.0) {
+		return 0.0;
+	}
+	for(size_t j = 0; j < freq.size(); j++) {
+		if (fabs(freq[j] - (freq.front() + j*step)) > 1e-6 * step) {
+			return 0.0;
+		}
+	}
+	return step;
+}
+
+/** Adds a complex value to a periodic grid, spread over the neighbouring 
+ *	points so that its Fourier transform is preserved
+ *
+ * This is the "extirpolation" step of Press & Rybicki (1989): the value 
+ * is distributed using Lagrange interpolation weights of order 
+ * @ref EXTIRP_ORDER, so that low-frequency sums over the grid approximate 
+ * the same sums evaluated at the original position.
+ *
+ * @param[in,out] grid An array of complex numbers stored as alternating 
+ *	real and imaginary parts.
+ * @param[in] m The number of complex numbers in @p grid.
+ * @param[in] x The position of the value, in units of grid points.
+ * @param[in] re, im The value to add.
+ *
+ * @pre 0 &le; @p x &lt; @p m
+ * @pre @p m &ge; @ref EXTIRP_ORDER
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void extirpolate(double grid[], size_t m, double x, double re, double im) {
+	const long first = static_cast<long>(floor(x)) 
+		- static_cast<long>(EXTIRP_ORDER/2) + 1;
+	
+	for(size_t i = 0; i < EXTIRP_ORDER; i++) {
+		double weight = 1.0;
+		for(size_t j = 0; j < EXTIRP_ORDER; j++) {
+			if (j != i) {
+				weight *= (x - (first + static_cast<long>(j))) 
+					/ (static_cast<double>(i) - static_cast<double>(j));
+			}
+		}
+		
+		// Wrap around the grid
+		const long mLong = static_cast<long>(m);
+		const size_t index = static_cast<size_t>(
+			((first + static_cast<long>(i)) % mLong + mLong) % mLong);
+		grid[2*index  ] += weight * re;
+		grid[2*index+1] += weight * im;
+	}
+}
+
+/** Evaluates a weighted sum of complex exponentials at every frequency 
+ *	of a uniform grid
+ *
+ * @param[in] times The times of observation.
+ * @param[in] weights The weight of each observation.
+ * @param[in] f0, df The first frequency and spacing of the grid.
+ * @param[in] mult A multiplier applied to all frequencies.
+ * @param[in] nFreq The number of frequencies.
+ * @param[in] fftSize The length of the FFT to use.
+ * @param[out] re, im The real and imaginary parts of @f$\sum_i w_i 
+ *	\exp(2\pi i \cdot mult \cdot (f_0 + k\,df)(t_i - t_0))@f$ for each 
+ *	frequency index k.
+ *
+ * @pre @p times.size() = @p weights.size() &gt; 0
+ * @pre @p fftSize is a power of 2, and is greater than 
+ *	@p mult &times; (@p nFreq - 1)
+ *
+ * @perform O(N + M log M) time, where N = @p times.size() and 
+ *	M = @p fftSize
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	for the FFT.
+ * @exception std::runtime_error Thrown if the FFT fails.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void fftSums(const vector<double>& times, const vector<double>& weights, 
+		double f0, double df, size_t mult, size_t nFreq, size_t fftSize, 
+		vector<double>& re, vector<double>& im) {
+	vector<double> grid(2*fftSize, 0.0);
+	
+	const double t0 = times.front();
+	for(size_t i = 0; i < times.size(); i++) {
+		const double t = times[i] - t0;
+		
+		// The offset f0 is not a multiple of df, so apply it directly
+		const double phase = 2.0 * M_PI * mult * f0 * t;
+		// Frequency index mult*k then gives exp(2 pi i mult k df t)
+		const double x = fmod(df * t * fftSize, static_cast<double>(fftSize));
+		extirpolate(&grid[0], fftSize, x, 
+			weights[i] * cos(phase), weights[i] * sin(phase));
+	}
+	
+	// GSL's backward transform has the sign convention exp(+2 pi i jk/M)
+	gslCheck(gsl_fft_complex_radix2_backward(&grid[0], 1, fftSize), 
+		"While computing periodogram: ");
+	
+	vector<double> tempRe(nFreq), tempIm(nFreq);
+	for(size_t k = 0; k < nFreq; k++) {
+		tempRe[k] = grid[2*mult*k  ];
+		tempIm[k] = grid[2*mult*k+1];
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	re.swap(tempRe);
+	im.swap(tempIm);
+}
+
+/** Precomputes the periodogram terms for a set of observation times.
+ *
+ * The frequency grid is the one previously used by
+ * @ref lcmc::stats::doPeriodogram() "doPeriodogram()": it runs from the
+ * inverse of the time baseline (but no lower than 0.005) to the
+ * pseudo-Nyquist frequency of @p times.
+ *
+ * @param[in] times The times at which light curves will be sampled.
+ * @param[in] method The algorithm lombScargle() will use. If @p method 
+ *	is @ref LS_FAST "LS_FAST" but the frequency grid is not evenly 
+ *	spaced, the periodogram is evaluated directly instead.
+ * @param[in] precision The precision in which to store the 
+ *	trigonometric tables, if any (see setPeriodogramPrecision()).
+ *
+ * @pre @p times is sorted in ascending order, and contains no NaNs
+ *
+ * @post getFreq() and getTimes() return the grid and @p times, and
+ *	lombScargle() may be called for any data sampled at @p times.
+ *
+ * @perform O(NF) time, where N = @p times.size() and F is the number of
+ *	frequencies, for @ref LS_DIRECT "LS_DIRECT". O(N + F log F) time 
+ *	for @ref LS_FAST "LS_FAST".
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to construct the object.
+ * @exception std::invalid_argument Thrown if @p times is too short to
+ *	define a frequency grid.
+ * @exception std::runtime_error Thrown if the FFT used by 
+ *	@ref LS_FAST "LS_FAST" fails.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+PeriodogramPlan::PeriodogramPlan(const vector<double>& times, 
+		PeriodogramMethod method, ValuePrecision precision) : times(times), 
+		epoch(0.0), offsets(), 
+		freqGrid(new vector<double>(defaultFreq(times))), 
+		method(method), precision(precision), fftSize(0), 
+		cosTau(), sinTau(), sumCos2(), sumSin2(),
+		cosTable(), sinTable(), cosTableSingle(), sinTableSingle(), 
+		deviceTables() {
+	prepare();
+}
+
+/** Precomputes the periodogram terms for a set of observation times 
+ *	and a chosen frequency grid.
+ *
+ * @param[in] times The times at which light curves will be sampled.
+ * @param[in] freq The frequencies at which to evaluate periodograms.
+ * @param[in] method The algorithm lombScargle() will use. If @p method 
+ *	is @ref LS_FAST "LS_FAST" but @p freq is not evenly spaced, the 
+ *	periodogram is evaluated directly instead.
+ * @param[in] precision The precision in which to store the 
+ *	trigonometric tables, if any (see setPeriodogramPrecision()).
+ *
+ * @pre @p times is sorted in ascending order, and contains no NaNs
+ * @pre @p freq is positive and sorted in ascending order
+ *
+ * @post getFreq() and getTimes() return @p freq and @p times, and
+ *	lombScargle() may be called for any data sampled at @p times.
+ *
+ * @perform O(NF) time, where N = @p times.size() and F = @p freq.size(), 
+ *	for @ref LS_DIRECT "LS_DIRECT". O(N + F log F) time for 
+ *	@ref LS_FAST "LS_FAST".
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to construct the object.
+ * @exception std::invalid_argument Thrown if @p times has fewer than 
+ *	two elements or @p freq is empty.
+ * @exception std::runtime_error Thrown if the FFT used by 
+ *	@ref LS_FAST "LS_FAST" fails.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+PeriodogramPlan::PeriodogramPlan(const vector<double>& times, 
+		const vector<double>& freq, PeriodogramMethod method, 
+		ValuePrecision precision) 
+		: times(times), epoch(0.0), offsets(), 
+		freqGrid(new vector<double>(freq)), method(method), 
+		precision(precision), fftSize(0), 
+		cosTau(), sinTau(), sumCos2(), sumSin2(),
+		cosTable(), sinTable(), cosTableSingle(), sinTableSingle(), 
+		deviceTables() {
+	if (times.size() < 2) {
+		throw std::invalid_argument("Need at least two observations to compute a periodogram (gave " 
+			+ lexical_cast<string>(times.size()) + ").");
+	}
+	if (freq.empty()) {
+		throw std::invalid_argument("Need at least one frequency to compute a periodogram.");
+	}
+	prepare();
+}
+
+/** Returns the frequency grid used by doPeriodogram()
+ *
+ * @param[in] times The times at which light curves will be sampled.
+ *
+ * @return A grid running from the inverse of the time baseline (but 
+ *	no lower than 0.005) to the pseudo-Nyquist frequency of @p times.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the grid.
+ * @exception std::invalid_argument Thrown if @p times is too short to
+ *	define a frequency grid.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<double> PeriodogramPlan::defaultFreq(const vector<double>& times) {
+	if (times.size() < 2) {
+		throw std::invalid_argument("Need at least two observations to compute a periodogram (gave " 
+			+ lexical_cast<string>(times.size()) + ").");
+	}
+	
+	double freqMin = 1.0/kpftimes::deltaT(times);
+	double freqMax = kpftimes::pseudoNyquistFreq(times);
+	if (freqMin < 0.005) {
+		freqMin = 0.005;
+	}
+	vector<double> freq;
+	kpftimes::freqGen(times, freq, freqMin, freqMax);
+	if (freq.empty()) {
+		throw std::invalid_argument("Observations span too short a time to compute a periodogram.");
+	}
+	return freq;
+}
+
+/** Computes the terms that depend on times and frequencies
+ *
+ * @pre @ref times has at least two elements, and @ref freqGrid is not empty
+ * @pre @ref method is set, and the other members are empty
+ *
+ * @post The object is ready for lombScargle().
+ * @post @ref epoch is the middle of the observations, and @ref offsets 
+ *	the times relative to it. Since both are of the same magnitude, 
+ *	each offset is exact.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the terms.
+ * @exception std::runtime_error Thrown if the FFT used by 
+ *	@ref LS_FAST "LS_FAST" fails.
+ *
+ * @exceptsafe The object is in a valid but unspecified state in the 
+ *	event of an exception. Since only constructors call prepare(), 
+ *	such an object is never seen by the caller.
+ */
+void PeriodogramPlan::prepare() {
+	const vector<double>& freq = *freqGrid;
+	const size_t nTimes = times.size();
+	const size_t nFreq  = freq.size();
+	
+	// The periodogram is invariant under shifts in time, so measure 
+	//	phases from the middle of the cadence for the most precision
+	epoch = 0.5 * (times.front() + times.back());
+	offsets.reserve(nTimes);
+	for(size_t i = 0; i < nTimes; i++) {
+		offsets.push_back(times[i] - epoch);
+	}
+
+	const double df = uniformStep(freq);
+	if (method == LS_FAST && df > 0.0) {
+		// The 2 omega sums need frequency indices up to 2(nFreq-1)
+		// The FFT must be a power of 2, and have room for a full 
+		//	set of extirpolation points
+		fftSize = 1;
+		while (fftSize < FFT_OVERSAMPLE * 2 * nFreq || fftSize < EXTIRP_ORDER) {
+			fftSize *= 2;
+		}
+		
+		vector<double> unit(nTimes, 1.0);
+		vector<double> sum2Cos, sum2Sin;
+		fftSums(offsets, unit, freq.front(), df, 2, nFreq, fftSize, 
+			sum2Cos, sum2Sin);
+		
+		cosTau .resize(nFreq);
+		sinTau .resize(nFreq);
+		sumCos2.resize(nFreq);
+		sumSin2.resize(nFreq);
+		for(size_t j = 0; j < nFreq; j++) {
+			// Press & Rybicki (1989), eqs. 11-12, with 
+			//	cos(2 omega tau) = sum2Cos/h, sin(2 omega tau) = sum2Sin/h
+			const double h = sqrt(sum2Cos[j]*sum2Cos[j] + sum2Sin[j]*sum2Sin[j]);
+			const double cos2Tau = (h > 0.0 ? sum2Cos[j] / h : 1.0);
+			const double sin2Tau = (h > 0.0 ? sum2Sin[j] / h : 0.0);
+			
+			cosTau[j] = sqrt(0.5 * (1.0 + cos2Tau));
+			sinTau[j] = sqrt(0.5 * (1.0 - cos2Tau)) * (sin2Tau < 0.0 ? -1.0 : 1.0);
+			sumCos2[j] = 0.5 * (nTimes + h);
+			sumSin2[j] = 0.5 * (nTimes - h);
+		}
+		return;
+	}
+
+	cosTau .reserve(nFreq);
+	sinTau .reserve(nFreq);
+	sumCos2.reserve(nFreq);
+	sumSin2.reserve(nFreq);
+
+	// Single-precision tables hold twice as many values in the same memory
+	const bool single = (precision == SINGLE_PRECISION);
+	const size_t maxTable = (single ? 2*MAX_TABLE_SIZE : MAX_TABLE_SIZE);
+	const bool tables = (nFreq <= maxTable / nTimes);
+	if (tables && single) {
+		cosTableSingle.reserve(nTimes*nFreq);
+		sinTableSingle.reserve(nTimes*nFreq);
+	} else if (tables) {
+		cosTable.reserve(nTimes*nFreq);
+		sinTable.reserve(nTimes*nFreq);
+	}
+
+	for(size_t j = 0; j < nFreq; j++) {
+		const double omega = 2.0 * M_PI * freq[j];
+
+		// tan(2 omega tau) = sum(sin(2 omega t)) / sum(cos(2 omega t))
+		double sum2Sin = 0.0, sum2Cos = 0.0;
+		for(size_t i = 0; i < nTimes; i++) {
+			sum2Sin += sin(2.0 * omega * offsets[i]);
+			sum2Cos += cos(2.0 * omega * offsets[i]);
+		}
+		const double tau = 0.5 * atan2(sum2Sin, sum2Cos) / omega;
+		cosTau.push_back(cos(omega * tau));
+		sinTau.push_back(sin(omega * tau));
+
+		double cc = 0.0, ss = 0.0;
+		for(size_t i = 0; i < nTimes; i++) {
+			const double c = cos(omega * (offsets[i] - tau));
+			const double s = sin(omega * (offsets[i] - tau));
+			cc += c*c;
+			ss += s*s;
+		}
+		sumCos2.push_back(cc);
+		sumSin2.push_back(ss);
+
+		if (tables && single) {
+			for(size_t i = 0; i < nTimes; i++) {
+				cosTableSingle.push_back(static_cast<float>(cos(omega * offsets[i])));
+				sinTableSingle.push_back(static_cast<float>(sin(omega * offsets[i])));
+			}
+		} else if (tables) {
+			for(size_t i = 0; i < nTimes; i++) {
+				cosTable.push_back(cos(omega * offsets[i]));
+				sinTable.push_back(sin(omega * offsets[i]));
+			}
+		}
+	}
+}
+
+/** Returns a plan for a set of observation times, reusing the
+ *	last plan if possible.
+ *
+ * The most recently created plan is cached, so consecutive calls with
+ * the same times and method share a single plan. The cache may be used 
+ * by several analysis threads at once. If threads are pinned to NUMA 
+ * nodes (see utils::setNumaPinning()), each node keeps its own copy 
+ * of the plan.
+ *
+ * @param[in] times The times at which light curves will be sampled.
+ * @param[in] method The algorithm the plan's lombScargle() will use.
+ *
+ * @return A plan for which getTimes() equals @p times, getMethod() 
+ *	equals @p method, and getPrecision() equals getPeriodogramPrecision().
+ *
+ * @pre @p times is sorted in ascending order, and contains no NaNs
+ *
+ * @perform O(N) time if the cached plan matches @p times, where
+ *	N = @p times.size(), otherwise the same as the
+ *	@ref PeriodogramPlan() "constructor"
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to create a new plan.
+ * @exception std::invalid_argument Thrown if @p times is too short to
+ *	define a frequency grid.
+ * @exception std::runtime_error Thrown if the FFT used by 
+ *	@ref LS_FAST "LS_FAST" fails.
+ *
+ * @exceptsafe The cache is unchanged in the event of an exception.
+ */
+shared_ptr<const PeriodogramPlan> PeriodogramPlan::forCadence(
+		const vector<double>& times, PeriodogramMethod method) {
+	static boost::mutex cacheLock;
+	// One plan per NUMA node, so that pinned threads read local memory
+	static vector<shared_ptr<const PeriodogramPlan> > cache(utils::numaNodeCount());
+	static utils::CacheCounter counter("Periodogram plans");
+
+	const size_t node = utils::currentNumaNode();
+	shared_ptr<const PeriodogramPlan> replica;
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		for(size_t i = 0; i < cache.size(); i++) {
+			if (cache[i].get() != NULL && cache[i]->getMethod() == method 
+					&& cache[i]->getPrecision() == getPeriodogramPrecision() 
+					&& cache[i]->getTimes() == times) {
+				if (i == node) {
+					counter.hit();
+					return cache[i];
+				}
+				replica = cache[i];
+			}
+		}
+	}
+
+	const utils::CacheMiss miss(counter);
+
+	// Don't hold the lock while building the plan, so that threads
+	//	working on other cadences are not blocked
+	// Copying another node's trig tables is cheaper than computing them
+	shared_ptr<const PeriodogramPlan> plan(replica.get() != NULL 
+		? new PeriodogramPlan(*replica) 
+		: new PeriodogramPlan(times, method, getPeriodogramPrecision()));
+
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		cache[node] = plan;
+	}
+	return plan;
+}
+
+/** Returns the times for which the plan was computed.
+ *
+ * @return The times passed to the constructor.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const vector<double>& PeriodogramPlan::getTimes() const {
+	return times;
+}
+
+/** Returns the method requested for the plan.
+ *
+ * @return The method passed to the constructor.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+PeriodogramMethod PeriodogramPlan::getMethod() const {
+	return method;
+}
+
+/** Returns the precision of the plan's trigonometric tables.
+ *
+ * @return The precision passed to the constructor.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ValuePrecision PeriodogramPlan::getPrecision() const {
+	return precision;
+}
+
+/** Returns the reference epoch subtracted from the times.
+ *
+ * @return The time at which every frequency has zero phase. Any epoch 
+ *	gives the same periodogram, up to rounding.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double PeriodogramPlan::getEpoch() const {
+	return epoch;
+}
+
+/** Returns the frequency grid of the periodogram.
+ *
+ * @return The frequencies at which lombScargle() evaluates the
+ *	periodogram, in increasing order.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const vector<double>& PeriodogramPlan::getFreq() const {
+	return *freqGrid;
+}
+
+/** Returns the frequency grid of the periodogram, as an object that 
+ *	may be shared by all periodograms computed from the plan.
+ *
+ * @return A pointer to the frequencies at which lombScargle() evaluates 
+ *	the periodogram, in increasing order. The grid never changes, and 
+ *	copies of the plan, such as those made for other NUMA nodes, 
+ *	return the same object.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const shared_ptr<const vector<double> >& PeriodogramPlan::getSharedFreq() const {
+	return freqGrid;
+}
+
+/** Computes the periodogram of a light curve sampled at the
+ *	plan's times.
+ *
+ * The periodogram is normalized by the variance of the data, following
+ * Scargle (1982) and Horne & Baliunas (1986).
+ *
+ * @param[in] data The values of the light curve at getTimes().
+ * @param[out] power The periodogram of @p data at each frequency in
+ *	getFreq().
+ *
+ * @pre @p data contains no NaNs
+ *
+ * @post @p power.size() = getFreq().size()
+ *
+ * @perform O(NF) time, where N = @p data.size() and F is the number of
+ *	frequencies. If the plan has trigonometric tables, the only
+ *	per-value work is two multiply-adds, done by floatTrigSums() if 
+ *	the tables are in single precision. If the plan uses 
+ *	@ref LS_FAST "LS_FAST", O(N + F log F) time.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the periodogram.
+ * @exception std::invalid_argument Thrown if @p data does not have
+ *	the same length as getTimes().
+ * @exception std::runtime_error Thrown if the FFT used by 
+ *	@ref LS_FAST "LS_FAST" fails.
+ * @exception lcmc::stats::except::TimedOut Thrown if the calculation 
+ *	runs past the current thread's StatDeadline.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void PeriodogramPlan::lombScargle(const vector<double>& data,
+		vector<double>& power) const {
+	const vector<double>& freq = *freqGrid;
+	const size_t nTimes = times.size();
+	const size_t nFreq  = freq.size();
+
+	if (data.size() != nTimes) {
+		throw std::invalid_argument("Data must have the same length as the periodogram plan (gave "
+			+ lexical_cast<string>(data.size()) + " values for "
+			+ lexical_cast<string>(nTimes) + " times).");
+	}
+
+	vector<double> resid(nTimes);
+	const double var = centerData(data, &resid[0], 1);
+
+	// sum(y cos(omega (t - t0))) and sum(y sin(omega (t - t0)))
+	vector<double> fastYc, fastYs;
+	if (fftSize > 0) {
+		fftSums(offsets, resid, freq.front(), uniformStep(freq), 1, nFreq, 
+			fftSize, fastYc, fastYs);
+	}
+	
+	const bool single = !cosTableSingle.empty();
+	vector<float> singleResid;
+	if (single) {
+		singleResid.assign(resid.begin(), resid.end());
+	}
+
+	vector<double> temp(nFreq);
+	const bool tables = !cosTable.empty();
+	for(size_t j = 0; j < nFreq; j++) {
+		if (j % DEADLINE_STRIDE == 0) {
+			checkDeadline();
+		}
+
+		// sum(y cos(omega t)) and sum(y sin(omega t))
+		double yc = 0.0, ys = 0.0;
+		if (fftSize > 0) {
+			yc = fastYc[j];
+			ys = fastYs[j];
+		} else if (single) {
+			floatTrigSums(&singleResid[0], &cosTableSingle[j*nTimes], 
+				&sinTableSingle[j*nTimes], nTimes, yc, ys);
+		} else if (tables) {
+			const double* cosRow = &cosTable[j*nTimes];
+			const double* sinRow = &sinTable[j*nTimes];
+			for(size_t i = 0; i < nTimes; i++) {
+				yc += resid[i] * cosRow[i];
+				ys += resid[i] * sinRow[i];
+			}
+		} else {
+			const double omega = 2.0 * M_PI * freq[j];
+			for(size_t i = 0; i < nTimes; i++) {
+				yc += resid[i] * cos(omega * offsets[i]);
+				ys += resid[i] * sin(omega * offsets[i]);
+			}
+		}
+
+		temp[j] = normalizedPower(j, yc, ys, var);
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	power.swap(temp);
+}
+
+/** Computes the periodograms of several light curves sampled at the 
+ *	plan's times, in one pass over the plan.
+ *
+ * The result is the same as calling lombScargle() on each light 
+ * curve. However, each trigonometric term is read from the tables, or 
+ * computed if the plan has no tables, once for up to 16 light curves 
+ * rather than once per light curve. The sums for the whole batch are 
+ * then a product of the block of data with the tables, which is 
+ * limited by arithmetic rather than by memory bandwidth.
+ *
+ * @param[in] data The values of each light curve at getTimes().
+ * @param[out] powers The periodogram of each element of @p data at 
+ *	each frequency in getFreq().
+ *
+ * @pre No element of @p data is null or contains NaNs
+ *
+ * @post @p powers.size() = @p data.size()
+ * @post <tt>powers[k].size()</tt> = getFreq().size() for all k
+ *
+ * @perform O(KNF) time, where K = @p data.size(), N is the number of 
+ *	times, and F is the number of frequencies. If the plan uses 
+ *	@ref LS_FAST "LS_FAST", O(K(N + F log F)) time, since the FFT sums 
+ *	do not share any work between light curves.
+ * @perform If setDeviceStats() was given true, a device is available, 
+ *	and the plan has large enough tables, the sums for all the light 
+ *	curves are computed on the device by deviceTrigSums(). The results 
+ *	differ from the CPU's only by rounding. Single-precision tables 
+ *	are not copied to the device.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the periodograms.
+ * @exception std::invalid_argument Thrown if any element of @p data 
+ *	does not have the same length as getTimes().
+ * @exception std::runtime_error Thrown if the FFT used by 
+ *	@ref LS_FAST "LS_FAST" fails.
+ * @exception lcmc::stats::except::TimedOut Thrown if the calculation 
+ *	runs past the current thread's StatDeadline.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void PeriodogramPlan::lombScargleBatch(const vector<const vector<double>*>& data, 
+		vector<vector<double> >& powers) const {
+	const vector<double>& freq = *freqGrid;
+	const size_t nTimes  = times.size();
+	const size_t nFreq   = freq.size();
+	const size_t nCurves = data.size();
+
+	for(size_t k = 0; k < nCurves; k++) {
+		if (data[k]->size() != nTimes) {
+			throw std::invalid_argument("Data must have the same length as the periodogram plan (gave "
+				+ lexical_cast<string>(data[k]->size()) + " values for "
+				+ lexical_cast<string>(nTimes) + " times).");
+		}
+	}
+
+	vector<vector<double> > temp(nCurves);
+	if (fftSize > 0) {
+		for(size_t k = 0; k < nCurves; k++) {
+			lombScargle(*data[k], temp[k]);
+		}
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		powers.swap(temp);
+		return;
+	}
+
+	const bool single = !cosTableSingle.empty();
+	const bool tables = single || !cosTable.empty();
+	if (!cosTable.empty() && nCurves > 0 && getDeviceStats()) {
+		checkDeadline();
+		
+		// Time-major, so each time is one column of the device matrix
+		vector<double> resid(nTimes * nCurves), var(nCurves);
+		for(size_t k = 0; k < nCurves; k++) {
+			var[k] = centerData(*data[k], &resid[k], nCurves);
+		}
+		
+		vector<double> yc, ys;
+		if (deviceTrigSums(cosTable, sinTable, nTimes, deviceTables, 
+				resid, nCurves, yc, ys)) {
+			for(size_t k = 0; k < nCurves; k++) {
+				temp[k].resize(nFreq);
+				for(size_t j = 0; j < nFreq; j++) {
+					temp[k][j] = normalizedPower(j, yc[j*nCurves + k], 
+						ys[j*nCurves + k], var[k]);
+				}
+			}
+			
+			// IMPORTANT: no exceptions beyond this point
+			
+			powers.swap(temp);
+			return;
+		}
+	}
+	
+	for(size_t first = 0; first < nCurves; first += MAX_BATCH) {
+		const size_t nBatch = std::min(MAX_BATCH, nCurves - first);
+		
+		// Time-major, so the inner loop runs over the batch
+		vector<double> resid(nTimes * nBatch), var(nBatch);
+		for(size_t k = 0; k < nBatch; k++) {
+			var[k] = centerData(*data[first + k], &resid[k], nBatch);
+			temp[first + k].resize(nFreq);
+		}
+		
+		vector<double> yc(nBatch), ys(nBatch);
+		for(size_t j = 0; j < nFreq; j++) {
+			if (j % DEADLINE_STRIDE == 0) {
+				checkDeadline();
+			}
+			
+			std::fill(yc.begin(), yc.end(), 0.0);
+			std::fill(ys.begin(), ys.end(), 0.0);
+			const double omega = 2.0 * M_PI * freq[j];
+			for(size_t i = 0; i < nTimes; i++) {
+				double c, s;
+				if (single) {
+					c = cosTableSingle[j*nTimes + i];
+					s = sinTableSingle[j*nTimes + i];
+				} else if (tables) {
+					c = cosTable[j*nTimes + i];
+					s = sinTable[j*nTimes + i];
+				} else {
+					c = cos(omega * offsets[i]);
+					s = sin(omega * offsets[i]);
+				}
+				
+				const double* r = &resid[i*nBatch];
+				for(size_t k = 0; k < nBatch; k++) {
+					yc[k] += r[k] * c;
+					ys[k] += r[k] * s;
+				}
+			}
+			
+			for(size_t k = 0; k < nBatch; k++) {
+				temp[first + k][j] = normalizedPower(j, yc[k], ys[k], var[k]);
+			}
+		}
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	powers.swap(temp);
+}
+
+/** Combines the data sums at one frequency into the normalized power
+ *
+ * @param[in] j The index of the frequency.
+ * @param[in] yc, ys The sums of the centered data times 
+ *	@f$\cos \omega t_i@f$ and @f$\sin \omega t_i@f$.
+ * @param[in] var The sample variance of the data.
+ *
+ * @return The Lomb-Scargle power at <tt>getFreq()[j]</tt>.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double PeriodogramPlan::normalizedPower(size_t j, double yc, double ys, 
+		double var) const {
+	// cos(omega (t - tau)) = cos(omega t) cos(omega tau) + sin(omega t) sin(omega tau)
+	// sin(omega (t - tau)) = sin(omega t) cos(omega tau) - cos(omega t) sin(omega tau)
+	const double c = yc*cosTau[j] + ys*sinTau[j];
+	const double s = ys*cosTau[j] - yc*sinTau[j];
+
+	double p = 0.0;
+	if (sumCos2[j] > 0.0) {
+		p += c*c / sumCos2[j];
+	}
+	if (sumSin2[j] > 0.0) {
+		p += s*s / sumSin2[j];
+	}
+	return 0.5 * p / var;
+}
+
+}}		// end lcmc::stats
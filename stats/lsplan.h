@@ -0,0 +1,192 @@
+/** Precomputed Lomb-Scargle periodograms for a fixed cadence
+ * @file lightcurveMC/stats/lsplan.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCLSPLANH
+#define LCMCLSPLANH
+
+#include <vector>
+#include <cstddef>
+#include <boost/shared_ptr.hpp>
+#include "../largealloc.tmp.h"
+#include "raggedarray.h"
+
+namespace lcmc { namespace stats {
+
+struct DeviceTables;
+
+using std::vector;
+
+/** Type used to tell the program how to calculate periodograms
+ */
+enum PeriodogramMethod {
+	/** Evaluates the Lomb-Scargle periodogram directly at each frequency
+	 */
+	LS_DIRECT, 
+	/** Approximates the Lomb-Scargle periodogram using the extirpolation 
+	 *	and FFT method of Press & Rybicki (1989)
+	 */
+	LS_FAST
+};
+
+/** Stores everything needed to compute a Lomb-Scargle periodogram that
+ *	depends only on the times of observation, not on the data.
+ *
+ * Creating a plan computes the frequency grid and, for each frequency,
+ * the offset &tau; and the normalization terms of the periodogram. If the
+ * grid is not too large, the plan also stores @f$\cos \omega t_i@f$ and
+ * @f$\sin \omega t_i@f$, so that computing a periodogram from the plan
+ * requires only two dot products per frequency. The tables may be 
+ * stored in single precision, which halves their memory and doubles 
+ * the number of terms in each SIMD operation.
+ *
+ * All phases are computed from the times minus a reference epoch, 
+ * chosen once when the plan is created. The periodogram does not 
+ * depend on the origin of time, but Julian dates of order 
+ * 10<sup>6</sup> would otherwise make every phase lose six digits.
+ *
+ * A plan using @ref LS_FAST "LS_FAST" stores no tables. Instead, it
+ * computes the trigonometric sums for all frequencies at once with
+ * an FFT, in O(N + M log M) time, where M is a few times the number of
+ * frequencies.
+ *
+ * Plans are immutable once created, and may be shared between threads.
+ */
+class PeriodogramPlan {
+public:
+	/** Precomputes the periodogram terms for a set of observation times.
+	 */
+	explicit PeriodogramPlan(const vector<double>& times, 
+		PeriodogramMethod method = LS_DIRECT, 
+		ValuePrecision precision = DOUBLE_PRECISION);
+
+	/** Precomputes the periodogram terms for a set of observation times 
+	 *	and a chosen frequency grid.
+	 */
+	PeriodogramPlan(const vector<double>& times, const vector<double>& freq, 
+		PeriodogramMethod method = LS_DIRECT, 
+		ValuePrecision precision = DOUBLE_PRECISION);
+
+	/** Returns a plan for a set of observation times, reusing the
+	 *	last plan if possible.
+	 */
+	static boost::shared_ptr<const PeriodogramPlan> forCadence(
+		const vector<double>& times, PeriodogramMethod method = LS_DIRECT);
+
+	/** Returns the method requested for the plan.
+	 */
+	PeriodogramMethod getMethod() const;
+
+	/** Returns the precision of the plan's trigonometric tables.
+	 */
+	ValuePrecision getPrecision() const;
+
+	/** Returns the reference epoch subtracted from the times.
+	 */
+	double getEpoch() const;
+
+	/** Returns the times for which the plan was computed.
+	 */
+	const vector<double>& getTimes() const;
+
+	/** Returns the frequency grid of the periodogram.
+	 */
+	const vector<double>& getFreq() const;
+
+	/** Returns the frequency grid of the periodogram, as an object that 
+	 *	may be shared by all periodograms computed from the plan.
+	 */
+	const boost::shared_ptr<const vector<double> >& getSharedFreq() const;
+
+	/** Computes the periodogram of a light curve sampled at the
+	 *	plan's times.
+	 */
+	void lombScargle(const vector<double>& data, vector<double>& power) const;
+
+	/** Computes the periodograms of several light curves sampled at 
+	 *	the plan's times, in one pass over the plan.
+	 */
+	void lombScargleBatch(const vector<const vector<double>*>& data, 
+		vector<vector<double> >& powers) const;
+
+private:
+	/** Returns the frequency grid used by doPeriodogram()
+	 */
+	static vector<double> defaultFreq(const vector<double>& times);
+
+	/** Computes the terms that depend on times and frequencies
+	 */
+	void prepare();
+
+	/** Combines the data sums at one frequency into the normalized 
+	 *	power
+	 */
+	double normalizedPower(size_t j, double yc, double ys, double var) const;
+
+	vector<double> times;
+	/** The time from which all phases are measured */
+	double epoch;
+	/** @ref times minus @ref epoch */
+	vector<double> offsets;
+	/** The frequency grid, shared with any copies of the plan */
+	boost::shared_ptr<const vector<double> > freqGrid;
+
+	PeriodogramMethod method;
+	ValuePrecision precision;
+	/** The length of the FFTs used by @ref LS_FAST "LS_FAST", or 0 if 
+	 *	the sums are evaluated directly
+	 */
+	size_t fftSize;
+
+	/** @f$\cos \omega\tau@f$ for each frequency
+	 */
+	vector<double> cosTau;
+	/** @f$\sin \omega\tau@f$ for each frequency
+	 */
+	vector<double> sinTau;
+	/** @f$\sum_i \cos^2 \omega(t_i - \tau)@f$ for each frequency
+	 */
+	vector<double> sumCos2;
+	/** @f$\sum_i \sin^2 \omega(t_i - \tau)@f$ for each frequency
+	 */
+	vector<double> sumSin2;
+
+	/** @f$\cos \omega t_i@f$, one row per frequency, or empty if the
+	 *	tables are too large to store or are in single precision. 
+	 *	Allocated by utils::largeAlloc(), like the other tables.
+	 */
+	utils::LargeVector<double>::type cosTable;
+	/** @f$\sin \omega t_i@f$, one row per frequency, or empty if the
+	 *	tables are too large to store or are in single precision
+	 */
+	utils::LargeVector<double>::type sinTable;
+	/** @ref cosTable rounded to floats, if @ref precision is 
+	 *	@ref SINGLE_PRECISION "SINGLE_PRECISION"
+	 */
+	utils::LargeVector<float>::type cosTableSingle;
+	/** @ref sinTable rounded to floats, if @ref precision is 
+	 *	@ref SINGLE_PRECISION "SINGLE_PRECISION"
+	 */
+	utils::LargeVector<float>::type sinTableSingle;
+
+	/** The device copy of @ref cosTable and @ref sinTable, or null if 
+	 *	there is none. Only read or changed by deviceTrigSums().
+	 */
+	mutable boost::shared_ptr<DeviceTables> deviceTables;
+};
+
+/** Chooses the precision of the trigonometric tables of new 
+ *	periodogram plans
+ */
+void setPeriodogramPrecision(ValuePrecision precision);
+
+/** Returns the precision chosen with setPeriodogramPrecision()
+ */
+ValuePrecision getPeriodogramPrecision();
+
+}}		// end lcmc::stats
+
+#endif		// End ifndef LCMCLSPLANH
@@ -0,0 +1,482 @@
+/** Cached false alarm thresholds for Lomb-Scargle periodograms
+ * @file lightcurveMC/stats/lsthreshold.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <new>
+#include <sys/stat.h>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include "deadline.h"
+#include "lsplan.h"
+#include "lsthreshold.h"
+#include "profile.h"
+#include "../cachestats.h"
+#include "../diskcache.h"
+#include "../hash.h"
+#include "../rngstream.h"
+#include "../trialpool.h"
+
+namespace lcmc { namespace stats {
+
+using boost::lexical_cast;
+using boost::shared_ptr;
+using boost::uint64_t;
+using std::vector;
+using utils::fnvBasis;
+using utils::fnvHash;
+
+/** Returns the lock that protects the threshold caches
+ *
+ * @return A mutex shared by all callers.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::mutex& cacheLock() {
+	static boost::mutex theLock;
+	return theLock;
+}
+
+/** Returns the directory in which thresholds are saved
+ *
+ * @return A modifiable directory name, empty if thresholds are not
+ *	saved between runs.
+ *
+ * @pre The caller holds cacheLock()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+string& cacheDir() {
+	static string theDir;
+	return theDir;
+}
+
+/** Returns the number of threads used to calculate new thresholds
+ *
+ * @return A modifiable thread count.
+ *
+ * @pre The caller holds cacheLock()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& cacheThreads() {
+	static long theThreads = 1;
+	return theThreads;
+}
+
+/** Identifies a false alarm calculation
+ *
+ * @param[in] plan, fap, nSims The inputs to the calculation.
+ *
+ * @return A hash of all the inputs.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint64_t thresholdKey(const PeriodogramPlan& plan, double fap, long nSims) {
+	const vector<double>& times = plan.getTimes();
+	const vector<double>& freq  = plan.getFreq();
+	const int method = static_cast<int>(plan.getMethod());
+
+	uint64_t hash = fnvBasis();
+
+	hash = fnvHash(hash, &method, sizeof(method));
+	const size_t nTimes = times.size();
+	const size_t nFreq  = freq .size();
+	hash = fnvHash(hash, &nTimes, sizeof(nTimes));
+	if (nTimes > 0) {
+		hash = fnvHash(hash, &times[0], nTimes*sizeof(double));
+	}
+	hash = fnvHash(hash, &nFreq, sizeof(nFreq));
+	if (nFreq > 0) {
+		hash = fnvHash(hash, &freq[0], nFreq*sizeof(double));
+	}
+	hash = fnvHash(hash, &fap  , sizeof(fap));
+	hash = fnvHash(hash, &nSims, sizeof(nSims));
+	return hash;
+}
+
+/** Returns the name of the file in which a threshold is saved
+ *
+ * @param[in] dir The cache directory.
+ * @param[in] key The identifier of the calculation.
+ *
+ * @return The path to the file.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	for the file name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string cacheFile(const string& dir, uint64_t key) {
+	char name[64];
+	sprintf(name, "lsthresh_%08lx%08lx.txt",
+		static_cast<unsigned long>((key >> 32) & 0xffffffffUL),
+		static_cast<unsigned long>( key        & 0xffffffffUL));
+	return dir + "/" + name;
+}
+
+/** Opens a file, returning a null pointer instead of throwing if it
+ *	cannot be opened
+ *
+ * @param[in] fileName, mode The arguments to fopen().
+ *
+ * @return A handle that closes the file when it is destroyed, or a
+ *	null handle if the file could not be opened.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	for the handle.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+shared_ptr<FILE> tryOpen(const string& fileName, const char* mode) {
+	FILE* file = fopen(fileName.c_str(), mode);
+	if (file == NULL) {
+		return shared_ptr<FILE>();
+	}
+	return shared_ptr<FILE>(file, &fclose);
+}
+
+/** Reads a threshold saved by a previous run
+ *
+ * @param[in] fileName The file to read.
+ * @param[in] nTimes, nFreq, fap, nSims The properties of the
+ *	calculation, used to check that the file matches.
+ * @param[out] threshold The saved threshold.
+ *
+ * @return True if the file exists and matches the calculation,
+ *	false otherwise.
+ *
+ * @post @p threshold is unchanged if the return value is false.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool readThreshold(const string& fileName, size_t nTimes, size_t nFreq,
+		double fap, long nSims, double& threshold) {
+	try {
+		shared_ptr<FILE> file = tryOpen(fileName, "r");
+		if (file.get() == NULL) {
+			return false;
+		}
+
+		unsigned long savedTimes, savedFreq;
+		long savedSims;
+		double savedFap, savedThreshold;
+		if (fscanf(file.get(), "%lu %lu %lf %ld %lf", &savedTimes, &savedFreq,
+				&savedFap, &savedSims, &savedThreshold) != 5) {
+			return false;
+		}
+		if (savedTimes != nTimes || savedFreq != nFreq
+				|| savedFap != fap || savedSims != nSims) {
+			return false;
+		}
+
+		threshold = savedThreshold;
+		return true;
+	} catch (const std::bad_alloc& e) {
+		return false;
+	}
+}
+
+/** Saves a threshold for future runs
+ *
+ * The threshold is first written to a uniquely named temporary file,
+ * then moved into place, so that other processes never read a partial
+ * file. Failure to save the threshold is not an error, since it can
+ * always be recalculated.
+ *
+ * @param[in] dir The cache directory.
+ * @param[in] fileName The file to write.
+ * @param[in] nTimes, nFreq, fap, nSims The properties of the calculation.
+ * @param[in] threshold The threshold to save.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void writeThreshold(const string& dir, const string& fileName,
+		size_t nTimes, size_t nFreq, double fap, long nSims, double threshold) {
+	try {
+		string tempName;
+		bool written;
+		{
+			shared_ptr<FILE> file = utils::openCacheTemp(dir, fileName, tempName);
+			if (file.get() == NULL) {
+				fprintf(stderr, "WARNING: could not save periodogram threshold to %s\n",
+					fileName.c_str());
+				return;
+			}
+
+			// %.17g preserves every bit of a double
+			written = (fprintf(file.get(), "%lu %lu %.17g %ld %.17g\n",
+					static_cast<unsigned long>(nTimes),
+					static_cast<unsigned long>(nFreq),
+					fap, nSims, threshold) >= 0)
+				&& (fflush(file.get()) == 0);
+		}
+
+		if (written) {
+			utils::commitCacheFile(dir, tempName, fileName);
+		} else {
+			remove(tempName.c_str());
+		}
+	} catch (const std::bad_alloc& e) {
+		// Saving is optional
+	}
+}
+
+/** Function object that simulates the periodograms of pure noise
+ */
+class NoiseMaxima {
+public:
+	/** Prepares to simulate periodograms.
+	 *
+	 * @param[in] plan The cadence and frequency grid to simulate.
+	 * @param[out] maxima The array in which to store the highest 
+	 *	power of each simulated periodogram.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	NoiseMaxima(const PeriodogramPlan& plan, vector<double>& maxima) 
+			: plan(plan), maxima(maxima) {
+	}
+
+	/** Simulates a block of periodograms.
+	 *
+	 * Simulation @p i uses its own random number stream, so its result 
+	 * does not depend on which worker runs it.
+	 *
+	 * @param[in] worker The index of the worker running the block 
+	 *	(unused).
+	 * @param[in] first, last The range of simulations to run.
+	 *
+	 * @post <tt>maxima[first, last)</tt> contains the highest power 
+	 *	of each simulated periodogram.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	for the simulations.
+	 * @exception std::runtime_error Thrown if the periodogram could 
+	 *	not be calculated.
+	 *
+	 * @exceptsafe Elements of @p maxima outside [@p first, @p last) 
+	 *	are unchanged in the event of an exception.
+	 */
+	void operator()(size_t /*worker*/, size_t first, size_t last) const {
+		const size_t nTimes = plan.getTimes().size();
+		vector<double> noise(nTimes), power;
+
+		for(size_t i = first; i < last; i++) {
+			shared_ptr<gsl_rng> rng(utils::allocStream(0, 0, i, 
+				utils::THRESHOLD_STREAM), &gsl_rng_free);
+			for(size_t j = 0; j < nTimes; j++) {
+				noise[j] = gsl_ran_gaussian(rng.get(), 1.0);
+			}
+
+			plan.lombScargle(noise, power);
+			maxima[i] = *std::max_element(power.begin(), power.end());
+		}
+	}
+
+private:
+	const PeriodogramPlan& plan;
+	vector<double>& maxima;
+};
+
+/** Simulates the periodogram power corresponding to a false alarm
+ *	probability
+ *
+ * The threshold is the (1 - @p fap) quantile of the highest peak in the 
+ * periodograms of @p nSims simulated white noise light curves sampled 
+ * at the plan's times. Each simulation has its own random number 
+ * stream, and the quantile is taken over all simulations at once, so 
+ * the threshold depends only on the plan, @p fap, and @p nSims, not on 
+ * @p nThreads.
+ *
+ * @param[in] plan The cadence and frequency grid of the periodogram.
+ * @param[in] fap The false alarm probability of the threshold.
+ * @param[in] nSims The number of simulated periodograms used to
+ *	estimate the threshold.
+ * @param[in] nThreads The number of threads among which to divide 
+ *	the simulations.
+ *
+ * @return The periodogram power exceeded by noise alone with 
+ *	probability @p fap.
+ *
+ * @perform O(@p nSims) times the cost of plan.lombScargle(), divided 
+ *	by min(@p nThreads, @p nSims).
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to calculate the threshold.
+ * @exception std::invalid_argument Thrown if @p fap is not in (0, 1), 
+ *	or if @p nSims or @p nThreads is not positive.
+ * @exception std::runtime_error Thrown if the simulations could not 
+ *	be carried out.
+ * @exception std::logic_error Thrown if a bug was encountered in the 
+ *	simulations.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+double lsThreshold(const PeriodogramPlan& plan, double fap, long nSims, 
+		long nThreads) {
+	if (!(fap > 0.0 && fap < 1.0)) {
+		throw std::invalid_argument("False alarm probability must be between 0 and 1 (gave " 
+			+ lexical_cast<string>(fap) + ").");
+	}
+	if (nSims < 1) {
+		throw std::invalid_argument("Need at least one simulation to estimate a false alarm threshold (gave " 
+			+ lexical_cast<string>(nSims) + ").");
+	}
+	if (nThreads < 1) {
+		throw std::invalid_argument("Need at least one thread to estimate a false alarm threshold (gave " 
+			+ lexical_cast<string>(nThreads) + ").");
+	}
+
+	const size_t n = static_cast<size_t>(nSims);
+	vector<double> maxima(n);
+	runBlocks(n, std::min(static_cast<size_t>(nThreads), n), 
+		NoiseMaxima(plan, maxima));
+
+	// The smallest peak exceeded by at most a fraction fap of the noise
+	const double rank = ceil((1.0 - fap) * n);
+	const size_t index = (rank < 1.0 ? 0 : std::min(static_cast<size_t>(rank) - 1, n - 1));
+	std::nth_element(maxima.begin(), maxima.begin() + index, maxima.end());
+	return maxima[index];
+}
+
+/** Sets the directory in which false alarm thresholds are saved
+ *	between runs
+ *
+ * @param[in] dir The directory to use. If empty, thresholds are only
+ *	kept for the life of the process.
+ *
+ * @post Subsequent calls to cachedLsThreshold() will look for thresholds
+ *	in @p dir before calculating them, and save any new thresholds to
+ *	@p dir. The directory is created if necessary.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the directory name.
+ *
+ * @exceptsafe The cache directory is unchanged in the event of an exception.
+ */
+void setThresholdCacheDir(const string& dir) {
+	boost::mutex::scoped_lock guard(cacheLock());
+	cacheDir() = dir;
+}
+
+/** Sets the number of threads used to calculate false alarm thresholds
+ *
+ * @param[in] nThreads The number of threads among which cachedLsThreshold() 
+ *	divides the simulations for each new threshold.
+ *
+ * @post Subsequent calls to cachedLsThreshold() use @p nThreads threads.
+ *	The thresholds themselves do not depend on @p nThreads.
+ *
+ * @exception std::invalid_argument Thrown if @p nThreads is not positive.
+ *
+ * @exceptsafe The thread count is unchanged in the event of an exception.
+ */
+void setThresholdThreads(long nThreads) {
+	if (nThreads < 1) {
+		throw std::invalid_argument("Need at least one thread to estimate a false alarm threshold (gave " 
+			+ lexical_cast<string>(nThreads) + ").");
+	}
+
+	boost::mutex::scoped_lock guard(cacheLock());
+	cacheThreads() = nThreads;
+}
+
+/** Returns the periodogram power corresponding to a false alarm
+ *	probability, reusing earlier calculations when possible
+ *
+ * Thresholds are identified by a hash of the times, the frequency grid,
+ * the periodogram method, and the false alarm settings, so two cadences 
+ * never share a threshold even if they have the same frequency range. 
+ * Thresholds are remembered for the life of the process and, if 
+ * setThresholdCacheDir() has been called, saved to disk for later runs.
+ * New thresholds are calculated using the number of threads given to 
+ * setThresholdThreads().
+ *
+ * The cache may be shared by several analysis threads.
+ *
+ * @param[in] plan The cadence and frequency grid of the periodogram.
+ * @param[in] fap The false alarm probability of the threshold.
+ * @param[in] nSims The number of simulated periodograms used to
+ *	estimate the threshold.
+ *
+ * @return The same value as <tt>lsThreshold(plan, fap, nSims, ...)</tt>, 
+ *	calculated either now or by an earlier call.
+ *
+ * @perform O(N) time if the threshold is cached, where N is the
+ *	total number of times and frequencies in @p plan. Otherwise the 
+ *	same as lsThreshold().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to calculate or cache the threshold.
+ * @exception std::invalid_argument Thrown if @p fap or @p nSims are
+ *	invalid inputs to lsThreshold().
+ * @exception std::runtime_error Thrown if the threshold could not be 
+ *	calculated.
+ * @exception std::logic_error Thrown if a bug was encountered while 
+ *	calculating the threshold.
+ *
+ * @exceptsafe The cache is unchanged in the event of an exception.
+ */
+double cachedLsThreshold(const PeriodogramPlan& plan, double fap, long nSims) {
+	static std::map<uint64_t, double> memCache;
+	static utils::CacheCounter counter("Periodogram thresholds");
+	static utils::CacheCounter diskCounter("Periodogram thresholds on disk");
+
+	const uint64_t key = thresholdKey(plan, fap, nSims);
+	const size_t nTimes = plan.getTimes().size();
+	const size_t nFreq  = plan.getFreq() .size();
+
+	// Hold the lock during the calculation so that threads analyzing
+	//	the same cadence don't duplicate it
+	// The calculation itself is divided among its own threads
+	boost::mutex::scoped_lock guard(cacheLock());
+
+	std::map<uint64_t, double>::const_iterator it = memCache.find(key);
+	if (it != memCache.end()) {
+		counter.hit();
+		return it->second;
+	}
+
+	const utils::CacheMiss miss(counter);
+
+	const string dir = cacheDir();
+	const string fileName = (dir.empty() ? "" : cacheFile(dir, key));
+
+	double threshold;
+	if (!dir.empty() && readThreshold(fileName, nTimes, nFreq,
+			fap, nSims, threshold)) {
+		diskCounter.hit();
+		utils::touchCacheFile(fileName);
+	} else {
+		const double start = monotonicSeconds();
+		// The threshold is shared by every light curve with this
+		//	cadence, so don't let one light curve's time limit 
+		//	abandon it
+		const StatDeadline unlimited(0.0);
+		threshold = lsThreshold(plan, fap, nSims, cacheThreads());
+		if (!dir.empty()) {
+			writeThreshold(dir, fileName, nTimes, nFreq,
+				fap, nSims, threshold);
+			diskCounter.miss(monotonicSeconds() - start);
+		}
+	}
+
+	memCache.insert(std::make_pair(key, threshold));
+	return threshold;
+}
+
+}}		// end lcmc::stats
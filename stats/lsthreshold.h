@@ -0,0 +1,40 @@
+/** Cached false alarm thresholds for Lomb-Scargle periodograms
+ * @file lightcurveMC/stats/lsthreshold.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCLSTHRESHH
+#define LCMCLSTHRESHH
+
+#include <string>
+#include "lsplan.h"
+
+namespace lcmc { namespace stats {
+
+using std::string;
+
+/** Sets the directory in which false alarm thresholds are saved
+ *	between runs
+ */
+void setThresholdCacheDir(const string& dir);
+
+/** Sets the number of threads used to calculate false alarm thresholds
+ */
+void setThresholdThreads(long nThreads);
+
+/** Simulates the periodogram power corresponding to a false alarm
+ *	probability
+ */
+double lsThreshold(const PeriodogramPlan& plan, double fap, long nSims, 
+		long nThreads);
+
+/** Returns the periodogram power corresponding to a false alarm
+ *	probability, reusing earlier calculations when possible
+ */
+double cachedLsThreshold(const PeriodogramPlan& plan, double fap, long nSims);
+
+}}		// end lcmc::stats
+
+#endif		// End ifndef LCMCLSTHRESHH
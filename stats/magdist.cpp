@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/magdist.cpp
  * @author Krzysztof Findeisen
  * @date Created April 12, 2011
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,6 +31,7 @@
 #include <stdexcept>
 #include <vector>
 #include "magdist.h"
+#include "scratch.h"
 #include "../../common/nan.h"
 #include "../except/undefined.h"
 
@@ -42,6 +43,79 @@ namespace lcmc { namespace stats {
 
 typedef std::vector<double> DoubleVec;
 
+namespace {
+
+/** Returns the index of a percentile in a sorted array
+ *
+ * @param[in] fraction The percentile, expressed as a fraction in [0, 1).
+ * @param[in] n The number of elements in the array.
+ *
+ * @return The index of the element at the @p fraction percentile.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t percentileRank(double fraction, size_t n) {
+	return static_cast<size_t>(fraction * n);
+}
+
+/** Partially sorts a vector so that selected elements are where a 
+ *	full sort would put them
+ *
+ * @param[in,out] values The vector to rearrange.
+ * @param[in] ranks An array of indices into @p values.
+ * @param[in] nRanks The number of elements in @p ranks.
+ *
+ * @pre @p ranks is sorted in ascending order
+ * @pre Every element of @p ranks is less than @p values.size()
+ * @pre @p values contains no NaNs
+ *
+ * @post For every element r of @p ranks, @p values[r] is the value 
+ *	that would be at index r if @p values were sorted. The elements 
+ *	between consecutive ranks are in unspecified order.
+ *
+ * @perform O(N) expected time for a small, fixed number of ranks, 
+ *	where N = @p values.size()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void selectRanks(DoubleVec& values, const size_t ranks[], size_t nRanks) {
+	// Each selection leaves everything above its rank no smaller than it, 
+	//	so later (higher) ranks only need to search the remainder
+	size_t from = 0;
+	for (size_t i = 0; i < nRanks; i++) {
+		if (ranks[i] >= from) {
+			std::nth_element(values.begin() + from, values.begin() + ranks[i], 
+					values.end());
+			from = ranks[i] + 1;
+		}
+	}
+}
+
+/** Throws the exception corresponding to a failed C1 calculation
+ *
+ * @param[in] status The outcome of tryC1() or tryC1Sorted().
+ * @param[in] c1 The value calculated, if @p status is STAT_OK.
+ *
+ * @return @p c1
+ *
+ * @exception lcmc::stats::except::Undefined Thrown if @p status 
+ *	is STAT_UNDEFINED.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p status 
+ *	is STAT_NOT_ENOUGH_DATA.
+ *
+ * @exceptsafe Program state is unchanged in the event of an exception.
+ */
+double checkC1(StatStatus status, double c1) {
+	if (status == STAT_NOT_ENOUGH_DATA) {
+		throw except::NotEnoughData("Need at least 3 values to compute C1.");
+	} else if (status != STAT_OK) {
+		throw except::Undefined("No variability, so C1 is singular");
+	}
+	return c1;
+}
+
+}	// end unnamed namespace
+
 /** Calculates the modified C1 statistic. 
  * 
  * The statistic is identical to that presented in @cite RotorCtts, 
@@ -58,7 +132,7 @@ typedef std::vector<double> DoubleVec;
  *
  * @pre @p mags may contain NaNs
  *
- * @perform O(N log N) time, where N = @p mags.size()
+ * @perform O(N) expected time, where N = @p mags.size()
  *
  * @exception std::bad_alloc Thrown if not enough memory to calculate C1
  * @exception lcmc::stats::except::Undefined Thrown if C1 is undefined 
@@ -69,26 +143,97 @@ typedef std::vector<double> DoubleVec;
  * @exceptsafe Program state is unchanged in the event of an exception.
  */
 double getC1(const DoubleVec& mags) {
+	double c1 = 0.0;
+	return checkC1(tryC1(mags, c1), c1);
+}
+
+/** Calculates the modified C1 statistic without throwing if it is 
+ *	not defined
+ * 
+ * @param[in] mags A vector of magnitudes from which to calculate C1.
+ * @param[out] c1 The C1 statistic, if it is defined.
+ *
+ * @return STAT_OK if @p c1 was calculated, STAT_UNDEFINED if @p mags 
+ *	has no variability, or STAT_NOT_ENOUGH_DATA if @p mags has fewer 
+ *	than three finite values. @p c1 is unchanged unless STAT_OK is 
+ *	returned.
+ *
+ * @pre @p mags may contain NaNs
+ *
+ * @perform O(N) expected time, where N = @p mags.size()
+ *
+ * @exception std::bad_alloc Thrown if not enough memory to calculate C1
+ *
+ * @exceptsafe Program state is unchanged in the event of an exception.
+ */
+StatStatus tryC1(const DoubleVec& mags, double& c1) {
 	// Get rid of all NaN values
 	// Need to make a copy anyway since mags is constant
-	DoubleVec sMags(mags.size());
+	ScratchVector scratch(mags.size());
+	DoubleVec& sMags = scratch.get();
 	DoubleVec::iterator newEnd = std::remove_copy_if(mags.begin(), mags.end(), 
 			sMags.begin(), &kpfutils::isNan);
 	sMags.erase(newEnd, sMags.end());
 	
-	// Sort the survivors
-	std::sort(sMags.begin(), sMags.end());
+	// Put only the percentiles read by tryC1Sorted() in place
+	selectPercentiles(sMags);
+	
+	return tryC1Sorted(sMags, c1);
+}
+
+/** Calculates the modified C1 statistic from magnitudes that are 
+ *	already sorted.
+ * 
+ * @param[in] sMags A vector of magnitudes from which to calculate C1.
+ *
+ * @return The same value as getC1(@p sMags).
+ *
+ * @pre @p sMags is sorted in ascending order, or arranged by 
+ *	selectPercentiles(), and contains no NaNs
+ * @pre @p sMags contains at least three values
+ * @pre @p sMags contains at least two distinct values
+ *
+ * @perform Constant time
+ *
+ * @exception lcmc::stats::except::Undefined Thrown if C1 is undefined 
+ *	because @p sMags has no variability
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p sMags does not 
+ *	have enough values to calculate C1
+ *
+ * @exceptsafe Program state is unchanged in the event of an exception.
+ */
+double getC1Sorted(const DoubleVec& sMags) {
+	double c1 = 0.0;
+	return checkC1(tryC1Sorted(sMags, c1), c1);
+}
+
+/** Calculates the modified C1 statistic from magnitudes that are 
+ *	already sorted, without throwing if it is not defined
+ * 
+ * @param[in] sMags A vector of magnitudes from which to calculate C1.
+ * @param[out] c1 The C1 statistic, if it is defined.
+ *
+ * @return The same value as tryC1(@p sMags, @p c1).
+ *
+ * @pre @p sMags is sorted in ascending order, or arranged by 
+ *	selectPercentiles(), and contains no NaNs
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+StatStatus tryC1Sorted(const DoubleVec& sMags, double& c1) {
 	size_t n = sMags.size();
 	
 	if (n < 3) {
-		throw except::NotEnoughData("Need at least 3 values to compute C1.");
+		return STAT_NOT_ENOUGH_DATA;
 	}
 
 	double medMin = 0.0, amplitude = 0.0;
 	// Find the percentiles
-	size_t lowRank = static_cast<size_t>(0.05 * n);
-	size_t midRank = static_cast<size_t>(0.50 * n);
-	size_t  hiRank = static_cast<size_t>(0.95 * n);
+	size_t lowRank = percentileRank(0.05, n);
+	size_t midRank = percentileRank(0.50, n);
+	size_t  hiRank = percentileRank(0.95, n);
 	// assert: 0 <= lowRank < midRank < hiRank < n
 
 	if (sMags[hiRank] > sMags[lowRank]) {
@@ -98,10 +243,11 @@ double getC1(const DoubleVec& mags) {
 	// else no variability, so C1 is singular
 	
 	if (amplitude == 0.0) {
-		throw except::Undefined("No variability, so C1 is singular");
+		return STAT_UNDEFINED;
 	}
 	
-	return medMin / amplitude;
+	c1 = medMin / amplitude;
+	return STAT_OK;
 }
 
 /** Calculates the light curve amplitude. 
@@ -117,7 +263,7 @@ double getC1(const DoubleVec& mags) {
  * @pre @p mags contains at least two finite values
  * @pre @p mags may contain NaNs
  *
- * @perform O(N log N) time, where N = @p mags.size()
+ * @perform O(N) expected time, where N = @p mags.size()
  *
  * @exception std::bad_alloc Thrown if not enough memory to calculate amplitude
  * @exception lcmc::stats::except::NotEnoughData Thrown if @p mags does not 
@@ -128,13 +274,42 @@ double getC1(const DoubleVec& mags) {
 double getAmplitude(const DoubleVec& mags) {
 	// Get rid of all NaN values
 	// Need to make a copy anyway since mags is constant
-	DoubleVec sMags(mags.size());
+	ScratchVector scratch(mags.size());
+	DoubleVec& sMags = scratch.get();
 	DoubleVec::iterator newEnd = std::remove_copy_if(mags.begin(), mags.end(), 
 			sMags.begin(), &kpfutils::isNan);
 	sMags.erase(newEnd, sMags.end());
 	
-	// Sort the survivors
-	std::sort(sMags.begin(), sMags.end());
+	// Put only the percentiles read by getAmplitudeSorted() in place
+	size_t n = sMags.size();
+	if (n >= 2) {
+		const size_t ranks[] = {percentileRank(0.05, n), percentileRank(0.95, n)};
+		selectRanks(sMags, ranks, sizeof(ranks)/sizeof(ranks[0]));
+	}
+	
+	return getAmplitudeSorted(sMags);
+}
+
+/** Calculates the light curve amplitude from magnitudes that are 
+ *	already sorted.
+ * 
+ * @param[in] sMags A vector of magnitudes from which to calculate 
+ *	the amplitude.
+ *
+ * @return The same value as getAmplitude(@p sMags).
+ *
+ * @pre @p sMags is sorted in ascending order, or arranged by 
+ *	selectPercentiles(), and contains no NaNs
+ * @pre @p sMags contains at least two values
+ *
+ * @perform Constant time
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p sMags does not 
+ *	have enough values to calculate an amplitude
+ *
+ * @exceptsafe Does not throw exceptions other than NotEnoughData.
+ */
+double getAmplitudeSorted(const DoubleVec& sMags) {
 	size_t n = sMags.size();
 
 	if (n < 2) {
@@ -142,8 +317,8 @@ double getAmplitude(const DoubleVec& mags) {
 	}
 
 	// Find the percentiles
-	size_t lowRank = static_cast<size_t>(0.05 * n);
-	size_t  hiRank = static_cast<size_t>(0.95 * n);
+	size_t lowRank = percentileRank(0.05, n);
+	size_t  hiRank = percentileRank(0.95, n);
 	// assert: 0 <= lowRank < midRank < hiRank < n
 
 	double amplitude = sMags[hiRank]  - sMags[lowRank];
@@ -151,4 +326,29 @@ double getAmplitude(const DoubleVec& mags) {
 	return amplitude;
 }
 
+/** Partially sorts magnitudes so that they can be passed to 
+ *	tryC1Sorted() and getAmplitudeSorted()
+ * 
+ * @param[in,out] mags The magnitudes to rearrange.
+ *
+ * @pre @p mags contains no NaNs
+ *
+ * @post The 5th, 50th, and 95th percentiles of @p mags are at the 
+ *	positions where a full sort would put them, so tryC1Sorted() and 
+ *	getAmplitudeSorted() give the same results as for the sorted 
+ *	magnitudes. The other elements are in unspecified order.
+ *
+ * @perform O(N) expected time, where N = @p mags.size()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void selectPercentiles(DoubleVec& mags) {
+	size_t n = mags.size();
+	if (n > 0) {
+		const size_t ranks[] = {percentileRank(0.05, n), 
+			percentileRank(0.50, n), percentileRank(0.95, n)};
+		selectRanks(mags, ranks, sizeof(ranks)/sizeof(ranks[0]));
+	}
+}
+
 }}	// end lcmc::stats
@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/magdist.h
  * @author Krzysztof Findeisen
  * @date Created April 12, 2011
- * @date Last modified April 12, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,6 +31,7 @@
 #define LCMCMAGDISTH
 
 #include <vector>
+#include "statstatus.h"
 
 namespace lcmc { namespace stats {
 
@@ -38,10 +39,35 @@ namespace lcmc { namespace stats {
  */
 double getC1(const std::vector<double>& mags);
 
+/** Calculates the modified C1 statistic without throwing if it is 
+ *	not defined
+ */
+StatStatus tryC1(const std::vector<double>& mags, double& c1);
+
 /** Calculates the light curve amplitude. 
  */
 double getAmplitude(const std::vector<double>& mags);
 
+/** Calculates the modified C1 statistic from magnitudes that are 
+ *	already sorted.
+ */
+double getC1Sorted(const std::vector<double>& sortedMags);
+
+/** Calculates the modified C1 statistic from magnitudes that are 
+ *	already sorted, without throwing if it is not defined
+ */
+StatStatus tryC1Sorted(const std::vector<double>& sortedMags, double& c1);
+
+/** Calculates the light curve amplitude from magnitudes that are 
+ *	already sorted.
+ */
+double getAmplitudeSorted(const std::vector<double>& sortedMags);
+
+/** Partially sorts magnitudes so that they can be passed to 
+ *	tryC1Sorted() and getAmplitudeSorted()
+ */
+void selectPercentiles(std::vector<double>& mags);
+
 }}	// end lcmc::stats
 
 #endif 	//LCMCMAGDISTH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/output.cpp
  * @author Krzysztof Findeisen
  * @date Created June 7, 2013
- * @date Last modified June 18, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <algorithm>
@@ -11,14 +11,20 @@
 #include <vector>
 #include <cmath>
 #include <cstdio>
+#include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
 #include "../../common/cerror.h"
+#include "../../common/fileio.h"
 #include "../../common/alloc.tmp.h"
 #include "../mcio.h"
+#include "../textwriter.h"
+#include "columns.h"
 #include "output.h"
+#include "quantilesketch.h"
+#include "raggedarray.h"
+#include "runningstats.h"
 #include "../../common/nan.h"
 #include "../nan.h"
-#include "../except/undefined.h"
 
 namespace lcmc { namespace stats {
 
@@ -46,17 +52,23 @@ void getSummaryStats(const vector<double>& values, double& mean, double& stddev,
 	mean   = std::numeric_limits<double>::quiet_NaN();
 	stddev = std::numeric_limits<double>::quiet_NaN();
 	
-	try {
-		// For the exception handling to work right, order matters!
-		// Mean requires at least one measurement
-		// Standard deviation requires at least two, i.e. it has 
-		//	strictly tighter requirements than the mean and must 
-		//	go later
-		mean   =      utils::    meanNoNan(values);
-		stddev = sqrt(utils::varianceNoNan(values));
-	} catch (const except::NotEnoughData &e) {
+	// One pass gives both moments
+	size_t count;
+	double rawMean, rawVariance;
+	utils::summarizeNoNan(values, count, rawMean, rawVariance);
+	
+	// Mean requires at least one measurement
+	// Standard deviation requires at least two
+	if (count >= 1) {
+		mean   = rawMean;
+	}
+	if (count >= 2) {
+		stddev = sqrt(rawVariance);
+	} else {
 		// These should just be warnings that a statistic is undefined
-		fprintf(stderr, "WARNING: %s summary: %s\n", statName.c_str(), e.what());
+		fprintf(stderr, "WARNING: %s summary: %s\n", statName.c_str(), 
+			(count == 0 ? "no values other than NaN" 
+			: "only one value other than NaN, so no standard deviation"));
 	}
 }
 
@@ -88,6 +100,75 @@ void getSummaryStats(const vector<double>& values, double& mean, double& stddev,
 	getSummaryStats(values, mean, stddev, statName);
 }
 
+/** DistribText is the destination of a distribution file written as text.
+ *
+ * The text goes to the distribution archive if one is open, and to 
+ * its own file otherwise, compressed if getDistribCompression() is true.
+ */
+class DistribText {
+public:
+	/** Starts a distribution file
+	 *
+	 * @param[in] fileName The name of the distribution file.
+	 *
+	 * @exception kpfutils::except::FileIo Thrown if @p fileName could 
+	 *	not be opened.
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	to create the object.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	explicit DistribText(const string& fileName) : fileName(fileName), 
+			contents(), writer(hasDistribArchive() 
+				? new utils::TextWriter(contents) 
+				// Distribution files can hold millions of lines, 
+				//	so let the disk catch up in the background
+				: new utils::TextWriter(fileName, true, 
+					getDistribCompression())) {
+	}
+	
+	/** Returns the writer for the file's text
+	 *
+	 * @return A writer that stays valid until the object is destroyed.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	utils::TextWriter& text() {
+		return *writer;
+	}
+	
+	/** Finishes the distribution file
+	 *
+	 * @pre close() has not been called
+	 *
+	 * @post The file holds all the text written to text(), either 
+	 *	on disk or in the distribution archive.
+	 *
+	 * @exception kpfutils::except::FileIo Thrown if the text could 
+	 *	not be written.
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	to add the file to the archive.
+	 *
+	 * @exceptsafe The program is in a consistent state in the event 
+	 *	of an exception.
+	 */
+	void close() {
+		writer->close();
+		if (hasDistribArchive()) {
+			addToDistribArchive(fileName, contents);
+		}
+	}
+
+private:
+	// Files are not shared
+	DistribText(const DistribText&);
+	DistribText& operator=(const DistribText&);
+	
+	string fileName;
+	vector<char> contents;
+	boost::scoped_ptr<utils::TextWriter> writer;
+};
+
 /** Prints a single family of statistics to the specified file
  *
  * The function will print, in order: the mean of the statistic, the 
@@ -96,9 +177,6 @@ void getSummaryStats(const vector<double>& values, double& mean, double& stddev,
  * distribution of the statistics. The row is in tab-delimited 
  * format, except that the mean and standard deviation are separated by 
  * a  sign for improved readability.
- *
- * This function differs from printStatAlwaysDefined() only in that the 
- * latter does not print the number of times each statistic had a value.
  * 
  * @param[in] file An open file handle representing the text file to write to.
  * @param[in] archive The statistics to summarize.
@@ -106,6 +184,13 @@ void getSummaryStats(const vector<double>& values, double& mean, double& stddev,
  * @param[in] distribFile The prefix identifying the distribution file as 
  *	being for this particular statistic.
  *
+ * @post If getDistribFormat() is @ref DISTRIB_BINARY "DISTRIB_BINARY", 
+ *	the distribution is stored as binary columns in 
+ *	distribFileName(@p distribFile), and described by a file of the 
+ *	same name ending in <tt>.json</tt>.
+ * @post If hasDistribArchive(), the distribution is added to the 
+ *	archive instead of written to its own file.
+ *
  * @exception std::runtime_error Thrown if there are difficulties writing 
  *	to @p file
  * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
@@ -123,74 +208,202 @@ void printStat(FILE* const file, const vector<double>& archive,
 	getSummaryStats(archive, meanStats, stddevStats, fracStats, 
 			statName);
 	
+	const string auxName = distribFileName(distribFile);
 	int status = fprintf(file, "\t%6.3g%5.2g\t%6.3g\t%s",
-			meanStats, stddevStats, fracStats, distribFile.c_str() );
+			meanStats, stddevStats, fracStats, auxName.c_str() );
 	if (status < 0) {
 		cError("Could not print statistics in printStat(): ");
 	}
 
-	shared_ptr<FILE> auxFile = fileCheckOpen(distribFile, "w");
+	writeStat(archive, distribFile);
+}
+
+/** Writes a single family of statistics to a distribution file
+ *
+ * @param[in] archive The statistics to write.
+ * @param[in] distribFile The prefix identifying the distribution file as 
+ *	being for this particular statistic.
+ *
+ * @post The distribution is stored in distribFileName(@p distribFile), 
+ *	in the same format as written by printStat().
+ * @post If hasDistribArchive(), the distribution is added to the 
+ *	archive instead of written to its own file.
+ *
+ * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
+ *	to @p distribFile
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void writeStat(const vector<double>& archive, const string& distribFile) {
+	const string auxName = distribFileName(distribFile);
+	
+	if (getDistribFormat() == DISTRIB_BINARY) {
+		ColumnFile auxFile(auxName);
+		auxFile.addColumn("value", archive);
+		auxFile.close();
+		return;
+	}
+	
+	DistribText aux(auxName);
+	utils::TextWriter& auxFile = aux.text();
 	
 	for(size_t i = 0; i < archive.size(); i++) {
-		status = fprintf(auxFile.get(), "%0.3f\n", archive[i]);
-		if (status < 0) {
-			fileError(auxFile.get(), "Could not write to log file '" + distribFile 
-				+ "' in printStat(): ");
-		}
+		auxFile.writeFixed(archive[i], 3);
+		auxFile.write('\n');
 	}
+	aux.close();
 }
 
-/** Prints a single family of statistics to the specified file
+/** Prints a summary of a single family of statistics to the specified file
  *
  * The function will print, in order: the mean of the statistic, the 
- * standard deviation of the statistic, and the name of a file 
- * containing the distribution of the statistics. The row is in tab-delimited 
- * format, except that the mean and standard deviation are separated by 
- * a  sign for improved readability.
- * 
- * This function differs from printStat() only in that the 
- * latter also prints the number of times each statistic had a value.
+ * standard deviation of the statistic, the fraction of times each 
+ * statistic was defined, and @p distribName in place of the name 
+ * of a distribution file. The row has the same format as that printed 
+ * by printStat(), so that the two can be used interchangeably.
  * 
  * @param[in] file An open file handle representing the text file to write to.
- * @param[in] archive The statistics to summarize.
+ * @param[in] summary The statistics to summarize.
  * @param[in] statName The name of the statistic to use for error messages.
- * @param[in] distribFile The prefix identifying the distribution file as 
- *	being for this particular statistic.
+ * @param[in] distribName The text to print in the file name column, 
+ *	usually a placeholder (-) or a pattern matching the files 
+ *	already written by writeStat().
  *
  * @exception std::runtime_error Thrown if there are difficulties writing 
  *	to @p file
- * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
- *	to @p distribFile
  *
  * @exceptsafe The program is in a consistent state in the event 
  *	of an exception.
  */
-void printStatAlwaysDefined(FILE* const file, const vector<double>& archive, 
-		const string& statName, const string& distribFile) {
-	// For now, define summary variables for each statistic
-	// Eventually statistics will be objects, with mean, filename, etc. 
-	//	accessible as members
-	double meanStats, stddevStats;
-	getSummaryStats(archive, meanStats, stddevStats, statName);
+void printStat(FILE* const file, const RunningStats& summary, 
+		const string& statName, const string& distribName) {
+	double meanStats, stddevStats, fracStats;
+	summary.getSummary(meanStats, stddevStats, fracStats, statName);
 	
-	int status = fprintf(file, "\t%6.3g%5.2g\t%s",
-			meanStats, stddevStats, distribFile.c_str() );
+	int status = fprintf(file, "\t%6.3g%5.2g\t%6.3g\t%s",
+			meanStats, stddevStats, fracStats, distribName.c_str());
 	if (status < 0) {
-		cError("Could not print statistics in printStatAlwaysDefined(): ");
+		cError("Could not print statistics in printStat(): ");
 	}
+}
 
-	shared_ptr<FILE> auxFile = fileCheckOpen(distribFile, "w");
-	
-	for(size_t i = 0; i < archive.size(); i++) {
-		status = fprintf(auxFile.get(), "%0.3f\n", archive[i]);
-		if (status < 0) {
-			fileError(auxFile.get(), "Could not write to log file '" + distribFile 
-				+ "' in printStatAlwaysDefined(): ");
-		}
+/** Returns the choice made with setPrintQuantiles()
+ *
+ * @return A modifiable reference to the choice.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& quantilesOn() {
+	static bool printed = false;
+	return printed;
+}
+
+/** Chooses whether scalar statistics are printed with their median 
+ *	and percentiles
+ *
+ * The quantiles are kept whether or not they are printed, so the 
+ * choice does not affect checkpoints or the statistics themselves.
+ *
+ * @param[in] print If true, CollectedScalars::printHeader() and 
+ *	CollectedScalars::printStats() add a column with the median and 
+ *	the 5th and 95th percentiles after each statistic.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any statistics are printed.
+ */
+void setPrintQuantiles(bool print) {
+	quantilesOn() = print;
+}
+
+/** Returns the choice made with setPrintQuantiles()
+ *
+ * @return True if scalar statistics are printed with their median 
+ *	and percentiles. False until setPrintQuantiles() is called.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool getPrintQuantiles() {
+	return quantilesOn();
+}
+
+/** Prints the median and percentiles of a single family of statistics 
+ *	to the specified file
+ *
+ * The function will print the median, followed by the 5th and 95th 
+ * percentiles in brackets, as one tab-delimited column.
+ * 
+ * @param[in] file An open file handle representing the text file to write to.
+ * @param[in] sketch The quantile sketch of the statistics.
+ *
+ * @post If @p sketch is empty, all three values are printed as NaN.
+ *
+ * @exception std::runtime_error Thrown if there are difficulties writing 
+ *	to @p file
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	estimate the quantiles.
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void printQuantiles(FILE* const file, const QuantileSketch& sketch) {
+	int status = fprintf(file, "\t%6.3g [%.3g, %.3g]", sketch.quantile(0.5), 
+			sketch.quantile(0.05), sketch.quantile(0.95));
+	if (status < 0) {
+		cError("Could not print statistics in printQuantiles(): ");
 	}
 }
 
-/** Prints a set of functions to the specified file
+/** Prints one row of a distribution file
+ *
+ * @param[in] auxFile The distribution file.
+ * @param[in] begin, end The values to print.
+ *
+ * @pre [@p begin, @p end) is a valid range, or @p begin = @p end.
+ *
+ * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
+ *	to @p auxFile
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+template <typename T>
+void printRow(utils::TextWriter& auxFile, const T* begin, const T* end) {
+	// Same format as "%0.3f " for each value
+	for(const T* it = begin; it != end; it++) {
+		auxFile.writeFixed(*it, 3);
+		auxFile.write(' ');
+	}
+	auxFile.write('\n');
+}
+
+/** Prints one row of an array to a distribution file
+ *
+ * @param[in] auxFile The distribution file.
+ * @param[in] array The array containing the row.
+ * @param[in] row The index of the row to print.
+ *
+ * @pre @p row &lt; @p array.size()
+ *
+ * @post The row is printed in the same format whatever the precision 
+ *	of @p array.
+ *
+ * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
+ *	to @p auxFile
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void printRow(utils::TextWriter& auxFile, const RaggedArray& array, size_t row) {
+	if (array.getPrecision() == SINGLE_PRECISION) {
+		printRow(auxFile, array.floatRowBegin(row), array.floatRowEnd(row));
+	} else {
+		printRow(auxFile, array.rowBegin(row), array.rowEnd(row));
+	}
+}
+
+/** Prints a single family of statistics to the specified file
  *
  * The function will print only the name of a file containing the 
  * distribution of the functions. The row is in tab-delimited 
@@ -201,6 +414,15 @@ void printStatAlwaysDefined(FILE* const file, const vector<double>& archive,
  * @param[in] distribFile The prefix identifying the distribution file as 
  *	being for this particular statistic.
  *
+ * @perform O(N) time, where N is the total number of values in @p archive
+ *
+ * @post If getDistribFormat() is @ref DISTRIB_BINARY "DISTRIB_BINARY", 
+ *	the distribution is stored as binary columns in 
+ *	distribFileName(@p distribFile), and described by a file of the 
+ *	same name ending in <tt>.json</tt>.
+ * @post If hasDistribArchive(), the distribution is added to the 
+ *	archive instead of written to its own file.
+ *
  * @exception std::runtime_error Thrown if there are difficulties writing 
  *	to @p file
  * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
@@ -209,30 +431,29 @@ void printStatAlwaysDefined(FILE* const file, const vector<double>& archive,
  * @exceptsafe The program is in a consistent state in the event 
  *	of an exception.
  */
-void printStat(FILE* const file, const std::vector<vector<double> >& archive, 
+void printStat(FILE* const file, const RaggedArray& archive, 
 		const string& distribFile) {
 	
-	int status = fprintf(file, "\t%s", distribFile.c_str());
+	const string auxName = distribFileName(distribFile);
+	int status = fprintf(file, "\t%s", auxName.c_str());
 	if (status < 0) {
 		cError("Could not print log file name in printStat(): ");
 	}
 
-	shared_ptr<FILE> auxFile = fileCheckOpen(distribFile, "w");
+	if (getDistribFormat() == DISTRIB_BINARY) {
+		ColumnFile auxFile(auxName);
+		auxFile.addRows("value", archive);
+		auxFile.close();
+		return;
+	}
+	
+	DistribText aux(auxName);
+	utils::TextWriter& auxFile = aux.text();
 	
 	for(size_t i = 0; i < archive.size(); i++) {
-		for(size_t j = 0; j < archive[i].size(); j++) {
-			status = fprintf(auxFile.get(), "%0.3f ", archive[i][j]);
-			if (status < 0) {
-				fileError(auxFile.get(), "Could not write to log file '" 
-					+ distribFile + "' in printStat(): ");
-			}
-		}
-		status = fprintf(auxFile.get(), "\n");
-		if (status < 0) {
-			fileError(auxFile.get(), "Could not write to log file '" 
-				+ distribFile + "' in printStat(): ");
-		}
+		printRow(auxFile, archive, i);
 	}
+	aux.close();
 }
 
 /** Prints a set of functions to the specified file
@@ -242,11 +463,25 @@ void printStat(FILE* const file, const std::vector<vector<double> >& archive,
  * format.
  * 
  * @param[in] file An open file handle representing the text file to write to.
- * @param[in] timeArchive The times of the functions to print.
+ * @param[in] timeGrids The times at which the functions are sampled.
+ * @param[in] gridIndex For each function, the row of @p timeGrids 
+ *	giving its times.
  * @param[in] statArchive The values of the functions to print.
  * @param[in] distribFile The prefix identifying the distribution file as 
  *	being for this particular statistic.
  *
+ * @pre @p gridIndex.size() &ge; @p statArchive.size()
+ * @pre Each element of @p gridIndex is less than @p timeGrids.size()
+ *
+ * @perform O(N) time, where N is the total number of values printed
+ *
+ * @post If getDistribFormat() is @ref DISTRIB_BINARY "DISTRIB_BINARY", 
+ *	the distribution is stored as binary columns in 
+ *	distribFileName(@p distribFile), and described by a file of the 
+ *	same name ending in <tt>.json</tt>.
+ * @post If hasDistribArchive(), the distribution is added to the 
+ *	archive instead of written to its own file.
+ *
  * @exception std::runtime_error Thrown if there are difficulties writing 
  *	to @p file
  * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
@@ -255,43 +490,243 @@ void printStat(FILE* const file, const std::vector<vector<double> >& archive,
  * @exceptsafe The program is in a consistent state in the event 
  *	of an exception.
  */
-void printStat(FILE* const file, const std::vector<vector<double> >& timeArchive, 
-		const std::vector<vector<double> >& statArchive, 
+void printStat(FILE* const file, const RaggedArray& timeGrids, 
+		const vector<size_t>& gridIndex, const RaggedArray& statArchive, 
 		const string& distribFile) {
 	
-	int status = fprintf(file, "\t%s", distribFile.c_str());
+	const string auxName = distribFileName(distribFile);
+	int status = fprintf(file, "\t%s", auxName.c_str());
 	if (status < 0) {
 		cError("Could not print log file name in printStat(): ");
 	}
 
-	shared_ptr<FILE> auxFile = fileCheckOpen(distribFile, "w");
+	writeStat(timeGrids, gridIndex, statArchive, distribFile);
+}
+
+/** Writes a set of functions to a distribution file
+ *
+ * @param[in] timeGrids The times at which the functions are sampled.
+ * @param[in] gridIndex For each function, the row of @p timeGrids 
+ *	giving its times.
+ * @param[in] statArchive The values of the functions to print.
+ * @param[in] distribFile The prefix identifying the distribution file as 
+ *	being for this particular statistic.
+ *
+ * @pre @p gridIndex.size() &ge; @p statArchive.size()
+ * @pre Each element of @p gridIndex is less than @p timeGrids.size()
+ *
+ * @perform O(N) time, where N is the total number of values printed
+ *
+ * @post The functions are stored in distribFileName(@p distribFile), 
+ *	in the same format as by printStat().
+ *
+ * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
+ *	to @p distribFile
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
+void writeStat(const RaggedArray& timeGrids, const vector<size_t>& gridIndex, 
+		const RaggedArray& statArchive, const string& distribFile) {
+	const string auxName = distribFileName(distribFile);
+	
+	if (getDistribFormat() == DISTRIB_BINARY) {
+		// Grids are stored once, as in the collection itself
+		ColumnFile auxFile(auxName);
+		auxFile.addRows  ("grid", timeGrids);
+		auxFile.addColumn("grid_index", vector<size_t>(gridIndex.begin(), 
+			gridIndex.begin() + statArchive.size()));
+		auxFile.addRows  ("value", statArchive);
+		auxFile.close();
+		return;
+	}
+	
+	DistribText aux(auxName);
+	utils::TextWriter& auxFile = aux.text();
 	
 	for(size_t i = 0; i < statArchive.size(); i++) {
-		for(size_t j = 0; j < timeArchive[i].size(); j++) {
-			status = fprintf(auxFile.get(), "%0.3f ", timeArchive[i][j]);
-			if (status < 0) {
-				fileError(auxFile.get(), "Could not write to log file '" 
-					+ distribFile + "' in printStat(): ");
+		const size_t grid = gridIndex[i];
+		printRow(auxFile, timeGrids, grid);
+		printRow(auxFile, statArchive, i);
+	}
+	aux.close();
+}
+
+/** Returns the label chosen with setPartPrefix()
+ *
+ * @return A modifiable reference to the label.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+string& partPrefix() {
+	static string prefix;
+	return prefix;
+}
+
+/** Chooses a label that distinguishes the parts written by this process
+ *
+ * Processes that share the statistics of one bin, such as the shards 
+ * of a run, each label their parts so that none of them overwrites 
+ * another's.
+ *
+ * @param[in] prefix The label to put before the number of every part 
+ *	named from now on, or an empty string for no label.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the label.
+ *
+ * @exceptsafe The label is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe. Call before any statistics are printed.
+ */
+void setPartPrefix(const string& prefix) {
+	partPrefix() = prefix;
+}
+
+/** Returns the name of one part of a distribution file written in pieces
+ *
+ * @param[in] distribFile The name of the whole distribution file.
+ * @param[in] part A label for the part, usually its number.
+ *
+ * @return @p distribFile, with <tt>.part</tt>, the label chosen with 
+ *	setPartPrefix(), and @p part inserted before its extension, if it 
+ *	has one.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string partFileName(const string& distribFile, const string& part) {
+	const string label = ".part" + partPrefix() + part;
+	const size_t dot = distribFile.find_last_of("./");
+	if (dot == string::npos || distribFile[dot] != '.') {
+		return distribFile + label;
+	} else {
+		return distribFile.substr(0, dot) + label + distribFile.substr(dot);
+	}
+}
+
+/** Returns the choice made with setJoinParts()
+ *
+ * @return A modifiable reference to the choice.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& joinOn() {
+	static bool joined = false;
+	return joined;
+}
+
+/** Chooses whether distribution files written in parts are joined 
+ *	into one file when they are printed
+ *
+ * A merged run joins the parts written by its shards, so that its 
+ * distribution files have the same names and contents as those of a 
+ * run in a single process.
+ *
+ * @param[in] join If true, printing a collection written in parts 
+ *	joins its parts and names the joined file.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any statistics are printed.
+ */
+void setJoinParts(bool join) {
+	joinOn() = join;
+}
+
+/** Tests whether distribution files written in parts are joined when 
+ *	they are printed
+ *
+ * Only separate text files can be joined, so parts written in binary 
+ * or to a distribution archive are left as they are.
+ *
+ * @return True if setJoinParts() was last called with @c true, 
+ *	getDistribFormat() is @ref DISTRIB_TEXT "DISTRIB_TEXT", and 
+ *	hasDistribArchive() is false.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool getJoinParts() {
+	return joinOn() && getDistribFormat() == DISTRIB_TEXT && !hasDistribArchive();
+}
+
+/** Renames one part of a distribution file written in pieces
+ *
+ * @param[in] distribFile The name of the whole distribution file.
+ * @param[in] from, to The old and new labels of the part, as passed 
+ *	to partFileName().
+ *
+ * @pre getJoinParts()
+ *
+ * @post The part labeled @p from is now labeled @p to.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the part could not be 
+ *	renamed.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the names.
+ *
+ * @exceptsafe The part is unchanged in the event of an exception.
+ */
+void renamePart(const string& distribFile, const string& from, const string& to) {
+	const string oldName = distribFileName(partFileName(distribFile, from));
+	const string newName = distribFileName(partFileName(distribFile, to));
+	if (rename(oldName.c_str(), newName.c_str()) != 0) {
+		throw except::FileIo("Could not rename " + oldName + " to " + newName + ".");
+	}
+}
+
+/** Joins the parts of a distribution file into the whole file
+ *
+ * @param[in] distribFile The name of the whole distribution file.
+ * @param[in] nParts The number of parts, labeled from 1 to @p nParts.
+ *
+ * @pre getJoinParts()
+ *
+ * @post distribFileName(@p distribFile) holds the contents of every 
+ *	part, in order, and the parts are deleted.
+ *
+ * @exception kpfutils::except::FileIo Thrown if a part could not be 
+ *	read, or the whole file could not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	copy the parts.
+ *
+ * @exceptsafe The parts are unchanged in the event of an exception.
+ */
+void joinParts(const string& distribFile, long nParts) {
+	vector<string> partNames;
+	for(long part = 1; part <= nParts; part++) {
+		partNames.push_back(distribFileName(partFileName(distribFile, 
+			boost::lexical_cast<string>(part))));
+	}
+	
+	{
+		const string joinedName = distribFileName(distribFile);
+		shared_ptr<FILE> joined = fileCheckOpen(joinedName, "wb");
+		vector<char> buffer(1 << 16);
+		for(size_t part = 0; part < partNames.size(); part++) {
+			shared_ptr<FILE> hPart = fileCheckOpen(partNames[part], "rb");
+			size_t nRead;
+			while ((nRead = fread(&buffer[0], 1, buffer.size(), hPart.get())) > 0) {
+				if (fwrite(&buffer[0], 1, nRead, joined.get()) != nRead) {
+					fileError(joined.get(), "Could not write " + joinedName + ": ");
+				}
 			}
-		}
-		status = fprintf(auxFile.get(), "\n");
-		if (status < 0) {
-			fileError(auxFile.get(), "Could not write to log file '" 
-				+ distribFile + "' in printStat(): ");
-		}
-		for(size_t j = 0; j < statArchive[i].size(); j++) {
-			status = fprintf(auxFile.get(), "%0.3f ", statArchive[i][j]);
-			if (status < 0) {
-				fileError(auxFile.get(), "Could not write to log file '" 
-					+ distribFile + "' in printStat(): ");
+			if (ferror(hPart.get())) {
+				fileError(hPart.get(), "Could not read " + partNames[part] + ": ");
 			}
 		}
-		status = fprintf(auxFile.get(), "\n");
-		if (status < 0) {
-			fileError(auxFile.get(), "Could not write to log file '" + distribFile 
-				+ "' in printStat(): ");
+		if (fflush(joined.get()) != 0) {
+			fileError(joined.get(), "Could not write " + joinedName + ": ");
 		}
 	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	for(size_t part = 0; part < partNames.size(); part++) {
+		remove(partNames[part].c_str());
+	}
 }
 
 }}	// end lcmc::stats
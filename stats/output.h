@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/output.h
  * @author Krzysztof Findeisen
  * @date Created June 7, 2013
- * @date Last modified June 7, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <string>
@@ -11,6 +11,10 @@
 
 namespace lcmc { namespace stats {
 
+class QuantileSketch;
+class RaggedArray;
+class RunningStats;
+
 using std::string;
 using std::vector;
 
@@ -29,19 +33,69 @@ void getSummaryStats(const vector<double>& values, double& mean, double& stddev,
 void printStat(FILE* const file, const vector<double>& archive, 
 	const string& statName, const string& distribFile);
 
-/** Prints a single family of statistics to the specified file
+/** Prints a summary of a single family of statistics to the specified file
  */
-void printStatAlwaysDefined(FILE* const file, const vector<double>& archive, 
-	const string& statName, const string& distribFile);
+void printStat(FILE* const file, const RunningStats& summary, 
+	const string& statName, const string& distribName = "-");
+
+/** Writes a single family of statistics to a distribution file
+ */
+void writeStat(const vector<double>& archive, const string& distribFile);
+
+/** Prints the median and percentiles of a single family of statistics 
+ *	to the specified file
+ */
+void printQuantiles(FILE* const file, const QuantileSketch& sketch);
+
+/** Chooses whether scalar statistics are printed with their median 
+ *	and percentiles
+ */
+void setPrintQuantiles(bool print);
+
+/** Returns the choice made with setPrintQuantiles()
+ */
+bool getPrintQuantiles();
 
 /** Prints a single family of statistics to the specified file
  */
-void printStat(FILE* const file, const vector<vector<double> >& archive, 
+void printStat(FILE* const file, const RaggedArray& archive, 
 	const string& distribFile);
 
 /** Prints a set of functions to the specified file
  */
-void printStat(FILE* const file, const vector<vector<double> >& timeArchive, 
-	const vector<vector<double> >& statArchive, const string& distribFile);
+void printStat(FILE* const file, const RaggedArray& timeGrids, 
+	const vector<size_t>& gridIndex, const RaggedArray& statArchive, 
+	const string& distribFile);
+
+/** Writes a set of functions to a distribution file
+ */
+void writeStat(const RaggedArray& timeGrids, const vector<size_t>& gridIndex, 
+	const RaggedArray& statArchive, const string& distribFile);
+
+/** Chooses a label that distinguishes the parts written by this process
+ */
+void setPartPrefix(const string& prefix);
+
+/** Returns the name of one part of a distribution file written in pieces
+ */
+string partFileName(const string& distribFile, const string& part);
+
+/** Chooses whether distribution files written in parts are joined 
+ *	into one file when they are printed
+ */
+void setJoinParts(bool join);
+
+/** Tests whether distribution files written in parts are joined when 
+ *	they are printed
+ */
+bool getJoinParts();
+
+/** Renames one part of a distribution file written in pieces
+ */
+void renamePart(const string& distribFile, const string& from, const string& to);
+
+/** Joins the parts of a distribution file into the whole file
+ */
+void joinParts(const string& distribFile, long nParts);
 
 }}	// end lcmc::stats
@@ -2,37 +2,240 @@
  * @file lightcurveMC/stats/pairs.cpp
  * @author Krzysztof Findeisen
  * @date Reconstructed June 7, 2013
- * @date Last modified August 6, 2013
+ * @date Last modified October 14, 2026
  */
 
+#include <algorithm>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <boost/lexical_cast.hpp>
 #include "../mcio.h"
+#include "columns.h"
 #include "output.h"
 #include "statcollect.h"
 #include "../../common/cerror.h"
+#include "../../common/fileio.h"
 
 namespace lcmc { namespace stats {
 
 using std::string;
 using std::vector;
 
+namespace {
+
+/** The quantiles reported at each grid point by a collection that 
+ *	summarizes curves
+ */
+const double SUMMARY_QUANTILES[] = {0.05, 0.5, 0.95};
+const size_t N_SUMMARY_QUANTILES = sizeof(SUMMARY_QUANTILES)/sizeof(double);
+
+/** Returns the precision chosen with setCurvePrecision()
+ *
+ * @return A modifiable reference to the precision.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ValuePrecision& curvePrecision() {
+	static ValuePrecision precision = DOUBLE_PRECISION;
+	return precision;
+}
+
+/** Tests whether a row of an array matches a sequence of values
+ *
+ * @param[in] array The array to examine.
+ * @param[in] row The row of @p array to compare.
+ * @param[in] begin, end The values to compare to.
+ *
+ * @pre @p row &lt; @p array.size()
+ *
+ * @return True if the row has the same length as [@p begin, @p end) 
+ *	and every element compares equal, false otherwise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool rowEquals(const RaggedArray& array, size_t row, 
+		const double* begin, const double* end) {
+	return array.rowSize(row) == static_cast<size_t>(end - begin) 
+		&& std::equal(begin, end, array.rowBegin(row));
+}
+
+/** Tests whether a row of an array matches selected elements of a vector
+ *
+ * @param[in] array The array to examine.
+ * @param[in] row The row of @p array to compare.
+ * @param[in] source The vector to compare to.
+ * @param[in] indices The positions in @p source of the values to compare.
+ *
+ * @pre @p row &lt; @p array.size()
+ * @pre Every element of @p indices is less than @p source.size().
+ *
+ * @return True if the row has the same length as @p indices and 
+ *	element i compares equal to <tt>source[indices[i]]</tt>, false otherwise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool rowEquals(const RaggedArray& array, size_t row, 
+		const DoubleVec& source, const vector<size_t>& indices) {
+	if (array.rowSize(row) != indices.size()) {
+		return false;
+	}
+	const double* value = array.rowBegin(row);
+	for(vector<size_t>::const_iterator it = indices.begin(); 
+			it != indices.end(); it++, value++) {
+		if (!(*value == source[*it])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}	// end unnamed namespace
+
+/** Chooses the precision in which CollectedPairs stores the values of 
+ *	the functions it records
+ *
+ * Storing the values as floats halves their memory and the size of 
+ * binary distribution files. Their text distribution files, which 
+ * have three decimal places, are unchanged except where rounding to 
+ * a float moves a value across the last decimal place.
+ *
+ * @param[in] precision The precision of collections created from now on.
+ *
+ * @post Collections that store curves and are created from now on 
+ *	keep their function values at @p precision. Existing collections 
+ *	and summaries are unchanged.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any statistics are calculated.
+ */
+void setCurvePrecision(ValuePrecision precision) {
+	curvePrecision() = precision;
+}
+
+/** Returns the precision chosen with setCurvePrecision()
+ *
+ * @return The precision of the function values of new collections.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ValuePrecision getCurvePrecision() {
+	return curvePrecision();
+}
+
 /** Constructs a collection of statistics.
  *
  * @param[in] statName The name of the statistic to use in program output.
  * @param[in] distribFile The prefix identifying the distribution file as 
  *	being for this particular statistic.
+ * @param[in] storeCurves If true, every function recorded is stored 
+ *	and written to the distribution file. If false, only the count, 
+ *	mean, standard deviation, and 5th, 50th, and 95th percentiles at 
+ *	each grid point are kept.
  *
  * @post The object represents an empty set of statistics.
+ * @post If @p storeCurves, function values are stored at 
+ *	getCurvePrecision(). The summaries, and the one curve a 
+ *	collection that does not store curves holds, are always 
+ *	kept in double precision.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory 
  *	to construct the object.
  *
  * @exceptsafe Object construction is atomic.
  */
-CollectedPairs::CollectedPairs(const std::string& statName, const std::string& distribFile) 
-		: NamedCollection(statName, distribFile), x(), y() {
+CollectedPairs::CollectedPairs(const std::string& statName, const std::string& distribFile, 
+		bool storeCurves) 
+		: NamedCollection(statName, distribFile), storeCurves(storeCurves), 
+		grids(), gridIndex(), lastGrid(), 
+		y(storeCurves ? getCurvePrecision() : DOUBLE_PRECISION), parts(0), 
+		summaryGrids(), pointStats(), pointSketches(), nSummarized(0) {
+}
+
+/** Returns the index of the summary sampled on a grid
+ *
+ * @param[in] begin, end The grid to look up.
+ *
+ * @return The row of summaryGrids equal to [@p begin, @p end), or 
+ *	summaryGrids.size() if there is none.
+ *
+ * @perform O(G) time, where G is the number of distinct grids. Grids 
+ *	of the wrong length are skipped in constant time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t CollectedPairs::findSummary(const double* begin, const double* end) const {
+	for(size_t i = 0; i < summaryGrids.size(); i++) {
+		if (rowEquals(summaryGrids, i, begin, end)) {
+			return i;
+		}
+	}
+	return summaryGrids.size();
+}
+
+/** Adds the statistics held in memory to the per-point summaries.
+ *
+ * A collection that summarizes curves holds the most recent one 
+ * until the next is recorded, so that rollback() can still remove it.
+ *
+ * @pre The object does not store curves, so at most one statistic 
+ *	is held in memory.
+ *
+ * @post The statistic held in memory, if any, is incorporated into 
+ *	the summary for its grid, and no statistics are held in memory.
+ *
+ * @perform O(N) time, where N is the length of the statistic, plus 
+ *	the time to look up its grid.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to summarize the statistic.
+ *
+ * @exceptsafe The statistics recorded are unchanged in the event of 
+ *	an exception.
+ */
+void CollectedPairs::foldHeld() {
+	if (gridIndex.empty()) {
+		return;
+	}
+	
+	const double* xBegin = grids.rowBegin(gridIndex[0]);
+	const double* xEnd   = grids.rowEnd  (gridIndex[0]);
+	const double* yBegin = y.rowBegin(0);
+	const size_t n = std::min(grids.rowSize(gridIndex[0]), y.rowSize(0));
+	
+	const size_t nGrids = summaryGrids.size();
+	const size_t target = findSummary(xBegin, xEnd);
+	try {
+		if (target == nGrids) {
+			pointStats   .push_back(vector<RunningStats  >(grids.rowSize(gridIndex[0])));
+			pointSketches.push_back(vector<QuantileSketch>(grids.rowSize(gridIndex[0])));
+			summaryGrids .push_back(xBegin, xEnd);
+		}
+		// Reserving never changes the values summarized
+		for(size_t i = 0; i < n; i++) {
+			pointSketches[target][i].reserveAdd();
+		}
+	} catch (...) {
+		// Shrinking a vector never throws
+		summaryGrids .truncate(nGrids);
+		pointStats   .resize(nGrids);
+		pointSketches.resize(nGrids);
+		throw;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	for(size_t i = 0; i < n; i++) {
+		pointStats   [target][i].add(yBegin[i]);
+		pointSketches[target][i].add(yBegin[i]);
+	}
+	nSummarized++;
+	grids.clear();
+	lastGrid.reset();
+	gridIndex.clear();
+	y.clear();
 }
 
 /** Records the value of a function statistic.
@@ -43,36 +246,660 @@ CollectedPairs::CollectedPairs(const std::string& statName, const std::string& d
  * @pre @p x and @p y may contain NaNs
  *
  * @post The object contains all the statistics previously stored, 
- *	plus a new entry equal to @p y(x).
+ *	plus a new entry equal to @p y(x). If the object does not store 
+ *	curves, the previous entry is added to the per-point summaries.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory 
  *	to store the new statistic.
  *
- * @exceptsafe The object is unchanged in the event of an exception.
+ * @exceptsafe The statistics recorded are unchanged in the event of 
+ *	an exception.
  */
 void CollectedPairs::addStat(const DoubleVec& x, const DoubleVec& y) {
-	using std::swap;
+	if (!storeCurves) {
+		foldHeld();
+	}
+	
+	// &x[0] is not defined for an empty vector
+	const double* xBegin = (x.empty() ? NULL : &x[0]);
+	const double* xEnd   = xBegin + x.size();
+	const bool newGrid = grids.size() == 0 
+		|| !rowEquals(grids, grids.size()-1, xBegin, xEnd);
 
 	// reserve never changes the contents of the vector, whether 
 	//	or not it throws an exception, so it is a safe operation
-	// if neither call to reserve() throws, the calls to push_back() 
-	//	will not throw, either	
-	this->x.reserve(this->x.size() + 1);
-	this->y.reserve(this->y.size() + 1);
-
+	// if reserve() does not throw, gridIndex.push_back() will not throw
+	if (gridIndex.size() == gridIndex.capacity()) {
+		gridIndex.reserve(std::max<size_t>(1, 2*gridIndex.capacity()));
+	}
+	
+	// RaggedArray::push_back() is atomic, so only the first 
+	//	call ever needs to be undone
+	const size_t nGrids = grids.size();
+	if (newGrid) {
+		grids.push_back(xBegin, xEnd);
+	}
+	try {
+		this->y.push_back(y);
+	} catch (...) {
+		grids.truncate(nGrids);
+		throw;
+	}
+	
 	// IMPORTANT: no exceptions beyond this point
 
-	this->x.push_back(x);
+	if (newGrid) {
+		lastGrid.reset();
+	}
+	gridIndex.push_back(grids.size()-1);
+}
+
+/** Records the value of a function statistic sampled on a grid shared 
+ *	with other statistics.
+ *
+ * @param[in] x The values at which the function is sampled.
+ * @param[in] y The sampled function values
+ *
+ * @pre @p x is not null, and the grid it points to is not changed 
+ *	while the object holds a reference to it
+ * @pre @p x and @p y may contain NaNs
+ *
+ * @post The object contains all the statistics previously stored, 
+ *	plus a new entry equal to @p y(x). If the object does not store 
+ *	curves, the previous entry is added to the per-point summaries.
+ *
+ * @perform If @p x is the same grid as on the previous call, it is 
+ *	known to be stored already, so only @p y is copied. Otherwise, 
+ *	the same as addStat(const DoubleVec&, const DoubleVec&).
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to store the new statistic.
+ *
+ * @exceptsafe The statistics recorded are unchanged in the event of 
+ *	an exception.
+ */
+void CollectedPairs::addStat(const boost::shared_ptr<const DoubleVec>& x, 
+		const DoubleVec& y) {
+	// Without stored curves, every statistic replaces the grids held
+	if (!storeCurves || grids.size() == 0 || x.get() != lastGrid.get()) {
+		addStat(*x, y);
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		lastGrid = x;
+		return;
+	}
+	
+	// reserve never changes the contents of the vector, whether 
+	//	or not it throws an exception, so it is a safe operation
+	// if reserve() does not throw, gridIndex.push_back() will not throw
+	if (gridIndex.size() == gridIndex.capacity()) {
+		gridIndex.reserve(std::max<size_t>(1, 2*gridIndex.capacity()));
+	}
+	
 	this->y.push_back(y);
+	
+	// IMPORTANT: no exceptions beyond this point
+
+	gridIndex.push_back(grids.size()-1);
+}
+
+/** Records the value of a function statistic at selected points 
+ *	of its sampling.
+ *
+ * The selected points are copied straight from @p x and @p y, so 
+ * callers need not build a downsampled copy of either.
+ *
+ * @param[in] x The values at which the function is sampled
+ * @param[in] y The sampled function values
+ * @param[in] keep The positions in @p x and @p y of the samples to record, 
+ *	in the order they are to be recorded.
+ *
+ * @pre @p x and @p y may contain NaNs
+ * @pre Every element of @p keep is less than both @p x.size() and 
+ *	@p y.size().
+ *
+ * @post The object contains all the statistics previously stored, 
+ *	plus a new entry equal to <tt>y[keep[i]](x[keep[i]])</tt>. If the 
+ *	object does not store curves, the previous entry is added to the 
+ *	per-point summaries.
+ *
+ * @perform O(N) time, where N = @p keep.size().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to store the new statistic.
+ *
+ * @exceptsafe The statistics recorded are unchanged in the event of 
+ *	an exception.
+ */
+void CollectedPairs::addStat(const DoubleVec& x, const DoubleVec& y, 
+		const vector<size_t>& keep) {
+	if (!storeCurves) {
+		foldHeld();
+	}
+	
+	const bool newGrid = grids.size() == 0 
+		|| !rowEquals(grids, grids.size()-1, x, keep);
+
+	// reserve never changes the contents of the vector, whether 
+	//	or not it throws an exception, so it is a safe operation
+	// if reserve() does not throw, gridIndex.push_back() will not throw
+	if (gridIndex.size() == gridIndex.capacity()) {
+		gridIndex.reserve(std::max<size_t>(1, 2*gridIndex.capacity()));
+	}
+	
+	// RaggedArray::push_back() is atomic, so only the first 
+	//	call ever needs to be undone
+	const size_t nGrids = grids.size();
+	if (newGrid) {
+		grids.push_back(x, keep);
+	}
+	try {
+		this->y.push_back(y, keep);
+	} catch (...) {
+		grids.truncate(nGrids);
+		throw;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+
+	if (newGrid) {
+		lastGrid.reset();
+	}
+	gridIndex.push_back(grids.size()-1);
 }
 
+/** Records all the statistics stored in another collection.
+ *
+ * @param[in] other The collection whose statistics are to be copied.
+ *
+ * @pre @p other may be the same object as @p *this
+ * @pre @p other stores curves if and only if the object does.
+ *
+ * @post The object contains all the statistics previously stored, 
+ *	followed by all the statistics in @p other, in the same order 
+ *	as in @p other. If the object does not store curves, the 
+ *	per-point summaries of @p other are merged into its own.
+ * @post The names of the object are unchanged.
+ * @post The parts written by @p other.spill() are counted as parts of 
+ *	the object, which is correct only if the object holds no statistics 
+ *	in memory and both parts are named as described for 
+ *	setPartPrefix().
+ *
+ * @perform Amortized O(N) time, where N is the total length of the 
+ *	statistics in @p other
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to store the new statistics.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedPairs::append(const CollectedPairs& other) {
+	if (&other == this) {
+		const CollectedPairs copy = other;
+		append(copy);
+		return;
+	}
+	
+	if (!storeCurves) {
+		CollectedPairs result(*this);
+		CollectedPairs extra(other);
+		result.foldHeld();
+		extra .foldHeld();
+		for(size_t i = 0; i < extra.summaryGrids.size(); i++) {
+			const size_t target = result.findSummary(
+				extra.summaryGrids.rowBegin(i), extra.summaryGrids.rowEnd(i));
+			if (target == result.summaryGrids.size()) {
+				result.pointStats   .push_back(extra.pointStats   [i]);
+				result.pointSketches.push_back(extra.pointSketches[i]);
+				result.summaryGrids .push_back(extra.summaryGrids.rowBegin(i), 
+					extra.summaryGrids.rowEnd(i));
+			} else {
+				for(size_t j = 0; j < extra.pointStats[i].size(); j++) {
+					result.pointStats   [target][j].merge(extra.pointStats   [i][j]);
+					result.pointSketches[target][j].merge(extra.pointSketches[i][j]);
+				}
+			}
+		}
+		result.nSummarized += extra.nSummarized;
+		result.parts       += extra.parts;
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		swap(result);
+		return;
+	}
+	
+	// other usually continues the grid last recorded here, in which 
+	//	case that grid need not be stored again
+	const bool sharedGrid = grids.size() > 0 && other.grids.size() > 0 
+		&& rowEquals(grids, grids.size()-1, 
+			other.grids.rowBegin(0), other.grids.rowEnd(0));
+	const size_t nGrids = grids.size();
+	const size_t base = (sharedGrid ? nGrids-1 : nGrids);
+	
+	// reserve never changes the contents of the vector, whether 
+	//	or not it throws an exception, so it is a safe operation
+	gridIndex.reserve(gridIndex.size() + other.gridIndex.size());
+	
+	// RaggedArray::push_back() and append() are atomic, so only the 
+	//	completed calls need to be undone
+	try {
+		for(size_t i = (sharedGrid ? 1 : 0); i < other.grids.size(); i++) {
+			grids.push_back(other.grids.rowBegin(i), other.grids.rowEnd(i));
+		}
+		this->y.append(other.y);
+	} catch (...) {
+		grids.truncate(nGrids);
+		throw;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+
+	if (grids.size() > nGrids) {
+		lastGrid.reset();
+	}
+	for(vector<size_t>::const_iterator it = other.gridIndex.begin(); 
+			it != other.gridIndex.end(); it++) {
+		gridIndex.push_back(base + *it);
+	}
+	parts += other.parts;
+}
+
+/** Returns a marker for the statistics currently stored.
+ *
+ * The marker may be passed to rollback() to undo any statistics 
+ *	recorded after this call.
+ *
+ * @return The number of statistics recorded by the object.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t CollectedPairs::checkpoint() const {
+	return nSummarized + gridIndex.size();
+}
+
+/** Deletes all statistics recorded since a call to checkpoint().
+ *
+ * @param[in] mark The value returned by checkpoint().
+ *
+ * @pre No statistics have been removed from the object since 
+ *	@p mark was created.
+ * @pre If the object does not store curves, at most one statistic 
+ *	has been recorded since @p mark was created; earlier ones are 
+ *	already part of the summaries and cannot be removed.
+ *
+ * @post The object contains the same statistics it contained when 
+ *	checkpoint() returned @p mark. If the object has fewer than 
+ *	@p mark statistics, it is unchanged.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void CollectedPairs::rollback(size_t mark) {
+	const size_t held = (mark > nSummarized ? mark - nSummarized : 0);
+	if (held < gridIndex.size()) {
+		// Grids are numbered in order of first use, so every grid 
+		//	after the last one still referenced can be deleted
+		grids.truncate(held > 0 ? gridIndex[held-1] + 1 : 0);
+		lastGrid.reset();
+		// Erasing from the end of a vector of size_t never throws
+		gridIndex.erase(gridIndex.begin() + held, gridIndex.end());
+		y.truncate(held);
+	}
+}
+
+/** Writes the statistics recorded so far to a part of the 
+ *	distribution file, and frees their memory.
+ *
+ * Long runs can use spill() to keep the memory held by the collection 
+ * bounded. The parts are numbered from 1 in the order they are written, 
+ * and printStats() writes the statistics recorded after the last call 
+ * as the final part.
+ *
+ * @post If the collection held any statistics, they are stored in 
+ *	distribFileName(partFileName(distribFile, "N")), where N is the 
+ *	number of parts written so far, and the collection is empty.
+ * @post If the object does not store curves, no part is written; 
+ *	the statistics are instead added to the per-point summaries, 
+ *	which are already bounded in size.
+ * @post Checkpoints made before the call are no longer valid.
+ *
+ * @perform O(N) time, where N is the number of values stored.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the part could not be 
+ *	written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	write the part.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedPairs::spill() {
+	if (!storeCurves) {
+		foldHeld();
+		return;
+	}
+	if (gridIndex.empty()) {
+		return;
+	}
+	
+	writeStat(grids, gridIndex, y, partFileName(getFileName(), 
+		boost::lexical_cast<string>(parts + 1)));
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	// clear() would keep the memory reserved
+	RaggedArray().swap(grids);
+	lastGrid.reset();
+	vector<size_t>().swap(gridIndex);
+	RaggedArray(y.getPrecision()).swap(y);
+	parts++;
+}
+
+/** Renames the parts written under a label so that they follow the 
+ *	parts of another collection
+ *
+ * A merged run calls renumberParts() on the statistics of each shard 
+ * before appending them, so that the parts of every shard are numbered 
+ * as if a single process had written them.
+ *
+ * @param[in] label The label the parts were written with, as chosen 
+ *	with setPartPrefix().
+ * @param[in] previous The collection that the statistics will be 
+ *	appended to.
+ *
+ * @pre The label chosen with setPartPrefix() is empty
+ *
+ * @post If getJoinParts() is true, the parts of the object are named 
+ *	as parts of @p previous, numbered after the parts it already has. 
+ *	Otherwise, the parts are unchanged.
+ *
+ * @exception kpfutils::except::FileIo Thrown if a part could not be 
+ *	renamed.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	rename the parts.
+ *
+ * @exceptsafe The parts renamed before an exception keep their new 
+ *	names.
+ */
+void CollectedPairs::renumberParts(const string& label, const CollectedPairs& previous) const {
+	if (!getJoinParts()) {
+		return;
+	}
+	for(long part = 1; part <= parts; part++) {
+		renamePart(getFileName(), label + boost::lexical_cast<string>(part), 
+			boost::lexical_cast<string>(previous.parts + part));
+	}
+}
+
+/** Saves the state of a spilled collection to a text file
+ *
+ * Together with the parts already written by spill(), the state is 
+ * enough to continue the collection in a later run.
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ *
+ * @pre spill() has been called since the last addStat().
+ *
+ * @post The number of parts is written as one line of @p file. If the 
+ *	object does not store curves, the line also holds the per-point 
+ *	summaries, in a form that readState() restores exactly.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the state could not 
+ *	be written.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedPairs::writeState(FILE* const file) const {
+	if (storeCurves) {
+		if (fprintf(file, "%ld\n", parts) < 0) {
+			kpfutils::fileError(file, "Could not save statistics in writeState(): ");
+		}
+		return;
+	}
+	
+	if (fprintf(file, "%ld %lu %lu", parts, 
+			static_cast<unsigned long>(nSummarized), 
+			static_cast<unsigned long>(summaryGrids.size())) < 0) {
+		kpfutils::fileError(file, "Could not save statistics in writeState(): ");
+	}
+	for(size_t i = 0; i < summaryGrids.size(); i++) {
+		if (fprintf(file, " %lu", static_cast<unsigned long>(summaryGrids.rowSize(i))) < 0) {
+			kpfutils::fileError(file, "Could not save statistics in writeState(): ");
+		}
+		// %.17g preserves every bit of a double
+		for(const double* x = summaryGrids.rowBegin(i); x != summaryGrids.rowEnd(i); x++) {
+			if (fprintf(file, " %.17g", *x) < 0) {
+				kpfutils::fileError(file, "Could not save statistics in writeState(): ");
+			}
+		}
+		for(size_t j = 0; j < pointStats[i].size(); j++) {
+			pointStats   [i][j].writeState(file);
+			pointSketches[i][j].writeState(file);
+		}
+	}
+	if (fprintf(file, "\n") < 0) {
+		kpfutils::fileError(file, "Could not save statistics in writeState(): ");
+	}
+}
+
+/** Restores a state saved by writeState()
+ *
+ * @param[in] file An open file handle positioned at the line written 
+ *	by writeState().
+ *
+ * @pre The object stores curves if and only if the object that 
+ *	wrote the line did.
+ *
+ * @post The object has the same parts and per-point summaries as the 
+ *	object that wrote the line, and no statistics in memory.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p file does not 
+ *	contain a saved state.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	restore the summaries.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedPairs::readState(FILE* const file) {
+	long newParts;
+	if (fscanf(file, "%ld", &newParts) != 1 || newParts < 0) {
+		throw kpfutils::except::FileIo("Misformatted saved state for " 
+			+ getStatName() + ".");
+	}
+	
+	CollectedPairs result(getStatName(), getFileName(), storeCurves);
+	// The precision may have changed since this object was created
+	RaggedArray(y.getPrecision()).swap(result.y);
+	if (!storeCurves) {
+		unsigned long newSummarized, nGrids;
+		if (fscanf(file, "%lu %lu", &newSummarized, &nGrids) != 2) {
+			throw kpfutils::except::FileIo("Misformatted saved state for " 
+				+ getStatName() + ".");
+		}
+		for(unsigned long i = 0; i < nGrids; i++) {
+			unsigned long n;
+			if (fscanf(file, "%lu", &n) != 1) {
+				throw kpfutils::except::FileIo("Misformatted saved state for " 
+					+ getStatName() + ".");
+			}
+			DoubleVec grid(n);
+			for(DoubleVec::iterator it = grid.begin(); it != grid.end(); it++) {
+				if (fscanf(file, "%lf", &(*it)) != 1) {
+					throw kpfutils::except::FileIo("Misformatted saved state for " 
+						+ getStatName() + ".");
+				}
+			}
+			result.pointStats   .push_back(vector<RunningStats  >(n));
+			result.pointSketches.push_back(vector<QuantileSketch>(n));
+			result.summaryGrids .push_back(grid);
+			for(unsigned long j = 0; j < n; j++) {
+				result.pointStats   .back()[j].readState(file);
+				result.pointSketches.back()[j].readState(file);
+			}
+		}
+		result.nSummarized = newSummarized;
+	}
+	result.parts = newParts;
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(result);
+}
+
+/** Prints the name of the distribution file to the specified file, 
+ *	and writes the statistics to it.
+ *
+ * If spill() has been called, the statistics recorded since the last 
+ * call are written as the final part, and the name printed is a 
+ * pattern matching every part. If getJoinParts() is true, the parts 
+ * are instead joined into the distribution file, and its name is printed.
+ *
+ * @param[in] hOutput An open file handle representing the text file 
+ *	to write to.
+ *
+ * @exception std::runtime_error Thrown if there are difficulties writing 
+ *	to @p hOutput
+ * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
+ *	to the distribution file.
+ *
+ * If the object does not store curves, each grid summarized is written 
+ * as six functions sampled on it: the number of trials in which each 
+ * point was defined, the mean, the standard deviation, and the 5th, 
+ * 50th, and 95th percentiles.
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
 void CollectedPairs::printStats(FILE* const hOutput) const {
-	printStat(hOutput, x, y, getFileName());
+	if (!storeCurves) {
+		CollectedPairs result(*this);
+		result.foldHeld();
+		
+		vector<size_t> rowGrids;
+		RaggedArray rows;
+		for(size_t i = 0; i < result.summaryGrids.size(); i++) {
+			const size_t n = result.pointStats[i].size();
+			DoubleVec counts(n), means(n), stddevs(n);
+			vector<DoubleVec> quantiles(N_SUMMARY_QUANTILES, DoubleVec(n));
+			for(size_t j = 0; j < n; j++) {
+				const QuantileSketch& sketch = result.pointSketches[i][j];
+				counts[j] = static_cast<double>(sketch.count());
+				result.pointStats[i][j].getMoments(means[j], stddevs[j]);
+				for(size_t k = 0; k < N_SUMMARY_QUANTILES; k++) {
+					quantiles[k][j] = sketch.quantile(SUMMARY_QUANTILES[k]);
+				}
+			}
+			rows.push_back(counts);
+			rows.push_back(means);
+			rows.push_back(stddevs);
+			for(size_t k = 0; k < N_SUMMARY_QUANTILES; k++) {
+				rows.push_back(quantiles[k]);
+			}
+			rowGrids.resize(rows.size(), i);
+		}
+		printStat(hOutput, result.summaryGrids, rowGrids, rows, getFileName());
+		return;
+	}
+	if (parts == 0) {
+		printStat(hOutput, grids, gridIndex, y, getFileName());
+		return;
+	}
+	
+	if (getJoinParts()) {
+		long nParts = parts;
+		if (!gridIndex.empty()) {
+			writeStat(grids, gridIndex, y, partFileName(getFileName(), 
+				boost::lexical_cast<string>(++nParts)));
+		}
+		joinParts(getFileName(), nParts);
+		const string joinedName = distribFileName(getFileName());
+		if (fprintf(hOutput, "\t%s", joinedName.c_str()) < 0) {
+			kpfutils::fileError(hOutput, "Could not print log file name in printStats(): ");
+		}
+		return;
+	}
+	
+	const string pattern = distribFileName(partFileName(getFileName(), "*"));
+	if (fprintf(hOutput, "\t%s", pattern.c_str()) < 0) {
+		kpfutils::fileError(hOutput, "Could not print log file name in printStats(): ");
+	}
+	if (!gridIndex.empty()) {
+		writeStat(grids, gridIndex, y, partFileName(getFileName(), 
+			boost::lexical_cast<string>(parts + 1)));
+	}
 }
 
 void CollectedPairs::clear() {
-	x.clear();
+	grids.clear();
+	lastGrid.reset();
+	gridIndex.clear();
 	y.clear();
+	parts = 0;
+	summaryGrids.clear();
+	pointStats.clear();
+	pointSketches.clear();
+	nSummarized = 0;
+}
+
+size_t CollectedPairs::memoryBytes() const {
+	size_t bytes = grids.memoryBytes() + gridIndex.capacity()*sizeof(size_t) 
+		+ y.memoryBytes() + summaryGrids.memoryBytes();
+	for(size_t i = 0; i < pointStats.size(); i++) {
+		bytes += pointStats[i].capacity()*sizeof(RunningStats);
+		for(size_t j = 0; j < pointSketches[i].size(); j++) {
+			bytes += pointSketches[i][j].memoryBytes();
+		}
+	}
+	return bytes;
+}
+
+/** Returns the number of statistics held in memory
+ *
+ * @return The number of functions recorded since the collection was 
+ *	created, cleared, or last spilled. If the collection does not 
+ *	store curves, only the most recent function is held in memory.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t CollectedPairs::size() const {
+	return y.size();
+}
+
+/** Returns one statistic held in memory, without copying it
+ *
+ * @param[in] i The index of the statistic, in the order recorded.
+ * @param[out] xBegin, yBegin Pointers to the @f$\{x_i\}@f$ and 
+ *	@f$\{y_i\}@f$ of the function. Statistics sharing a grid share 
+ *	@p xBegin. The pointers are valid until the collection is next changed.
+ * @param[out] n The number of points in the function.
+ *
+ * @exception std::out_of_range Thrown if @p i &ge; size().
+ * @exception std::logic_error Thrown if the function values are 
+ *	stored in single precision, so no pointer to doubles exists.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void CollectedPairs::getStat(size_t i, const double*& xBegin, 
+		const double*& yBegin, size_t& n) const {
+	if (i >= y.size()) {
+		throw std::out_of_range("No statistic " 
+			+ boost::lexical_cast<string>(i) + " in " + getStatName() + ".");
+	}
+	if (y.getPrecision() != DOUBLE_PRECISION) {
+		throw std::logic_error("Statistics in " + getStatName() 
+			+ " are stored in single precision.");
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	xBegin = grids.rowBegin(gridIndex[i]);
+	yBegin = y.rowBegin(i);
+	n      = y.rowSize(i);
 }
 
 /** Prints a header row representing the statistics printed by 
@@ -111,8 +938,16 @@ void CollectedPairs::swap(CollectedPairs& other) {
 	
 	NamedCollection::swap(other);
 	
-	swap(this->x, other.x);
-	swap(this->y, other.y);
+	swap(this->storeCurves  , other.storeCurves  );
+	swap(this->grids        , other.grids        );
+	swap(this->gridIndex    , other.gridIndex    );
+	swap(this->lastGrid     , other.lastGrid     );
+	swap(this->y            , other.y            );
+	swap(this->parts        , other.parts        );
+	swap(this->summaryGrids , other.summaryGrids );
+	swap(this->pointStats   , other.pointStats   );
+	swap(this->pointSketches, other.pointSketches);
+	swap(this->nSummarized  , other.nSummarized  );
 }
 
 /** Non-throwing swap
@@ -2,17 +2,18 @@
  * @file lightcurveMC/stats/peakdriver.cpp
  * @author Krzysztof Findeisen
  * @date Created June 8, 2013
- * @date Last modified October 29, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 #include <boost/lexical_cast.hpp>
 #include <timescales/timescales.h>
 #include "cut.tmp.h"
-#include "magdist.h"
 #include "../../common/nan.h"
+#include "scratch.h"
 #include "statcollect.h"
 #include "statfamilies.h"
 #include "../except/undefined.h"
@@ -23,10 +24,251 @@ using boost::lexical_cast;
 using std::vector;
 using kpftimes::peakFindTimescales;
 
+namespace {
+
+/** Returns the search chosen with setPeakMethod()
+ *
+ * @return A modifiable reference to the search.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+PeakMethod& peakMethod() {
+	static PeakMethod method = PEAK_DIRECT;
+	return method;
+}
+
+}	// end unnamed namespace
+
+/** Chooses how doPeak() searches for peak-finding timescales
+ *
+ * @ref PEAK_LADDER "PEAK_LADDER" searches each light curve once instead 
+ * of up to three times, but the 80% cut is interpolated between steps 
+ * of the peak-finding curve, so it can differ from that of 
+ * @ref PEAK_DIRECT "PEAK_DIRECT" by less than one step (0.01 mag).
+ *
+ * @param[in] method The search to use from now on.
+ *
+ * @post doPeak() searches for timescales with @p method.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void setPeakMethod(PeakMethod method) {
+	peakMethod() = method;
+}
+
+/** Returns the search chosen with setPeakMethod()
+ *
+ * @return The search used by doPeak(), 
+ *	@ref PEAK_DIRECT "PEAK_DIRECT" unless changed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+PeakMethod getPeakMethod() {
+	return peakMethod();
+}
+
+/** Interpolates a function sampled at selected points
+ *
+ * @param[in] x, y The function samples.
+ * @param[in] keep The positions in @p x and @p y of the samples to use, 
+ *	in ascending order of @p x.
+ * @param[in] where The point at which to evaluate the function.
+ *
+ * @return The linear interpolation of the selected samples at @p where, 
+ *	or NaN if @p where lies outside them or either bracketing value of 
+ *	@p y is NaN.
+ *
+ * @pre Every element of @p keep is less than both @p x.size() and 
+ *	@p y.size().
+ *
+ * @perform O(N) time, where N = @p keep.size()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double interpolateSamples(const DoubleVec& x, const DoubleVec& y, 
+		const vector<size_t>& keep, double where) {
+	for (size_t i = 1; i < keep.size(); i++) {
+		const size_t lo = keep[i-1];
+		const size_t hi = keep[i];
+		if (x[lo] <= where && where <= x[hi]) {
+			const double frac = (where - x[lo]) / (x[hi] - x[lo]);
+			return y[lo] + frac * (y[hi] - y[lo]);
+		}
+	}
+	if (keep.size() == 1 && x[keep.front()] == where) {
+		return y[keep.front()];
+	}
+	return std::numeric_limits<double>::quiet_NaN();
+}
+
+/** Finds the peak-finding timescales of a light curve with one search 
+ *	per statistic
+ *
+ * @param[in] times, mags The light curve to analyze.
+ * @param[in] amplitude The amplitude of the light curve.
+ * @param[in] getCut, getPlot, cut3, cut2, cut80, peakPlot As for doPeak().
+ *
+ * @pre @p amplitude > 0
+ *
+ * @post As for doPeak(), using @ref PEAK_DIRECT "PEAK_DIRECT".
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::Undefined Thrown if a timescale 
+ *	could not be calculated.
+ *
+ * @exceptsafe The collections are in a valid state in the event of an 
+ *	exception, but may be partially updated.
+ */
+void directPeaks(const vector<double>& times, const vector<double>& mags, 
+		double amplitude, bool getCut, bool getPlot, 
+		CollectedScalars& cut3, CollectedScalars& cut2, 
+		CollectedScalars& cut80, CollectedPairs& peakPlot) {
+	// Treat cut2 and cut3 separately for improved efficiency
+	if (getCut) {
+		DoubleVec magCuts;
+		magCuts.push_back(amplitude / 3.0);
+		magCuts.push_back(amplitude / 2.0);
+	
+		DoubleVec cutTimes;
+		peakFindTimescales(times, mags, 
+			magCuts, cutTimes);
+		
+		// Key cuts
+		cut3.addStat(cutTimes[0]);
+		cut2.addStat(cutTimes[1]);
+	}
+	
+	const static double minMag = 0.01;
+	
+	ScratchVector cutBuffer;
+	DoubleVec& magCuts = cutBuffer.get();
+	for (double mag = minMag; mag < amplitude; mag += minMag) {
+		magCuts.push_back(mag);
+	}
+	
+	ScratchVector timeBuffer;
+	DoubleVec& cutTimes = timeBuffer.get();
+	peakFindTimescales(times, mags, magCuts, cutTimes);
+	
+	if (getPlot) {
+		peakPlot.addStat(cutTimes, magCuts);
+	}
+	
+	if (getCut) {
+		// 80% of the highest mag with a defined timescale
+		double mag08 = 0.8 * 
+			cutFunctionReverse(magCuts, cutTimes, 
+				kpfutils::NotNan());
+		
+		// can't use cutFunction() because cutTimes may 
+		//	have NaNs
+		DoubleVec singleTime;
+		peakFindTimescales(times, mags, 
+			vector<double>(1, mag08), singleTime);
+		// singleTime.size() == 1 guaranteed
+		cut80.addStat(singleTime.front());
+	}
+}
+
+/** Finds the peak-finding timescales of a light curve with a single 
+ *	search
+ *
+ * @param[in] times, mags The light curve to analyze.
+ * @param[in] amplitude The amplitude of the light curve.
+ * @param[in] getCut, getPlot, cut3, cut2, cut80, peakPlot As for doPeak().
+ *
+ * @pre @p amplitude > 0
+ *
+ * @post As for doPeak(), using @ref PEAK_LADDER "PEAK_LADDER".
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::Undefined Thrown if a timescale 
+ *	could not be calculated.
+ *
+ * @exceptsafe The collections are in a valid state in the event of an 
+ *	exception, but may be partially updated.
+ */
+void ladderPeaks(const vector<double>& times, const vector<double>& mags, 
+		double amplitude, bool getCut, bool getPlot, 
+		CollectedScalars& cut3, CollectedScalars& cut2, 
+		CollectedScalars& cut80, CollectedPairs& peakPlot) {
+	const static double minMag = 0.01;
+	
+	// All thresholds go into one sorted list, so that 
+	//	the light curve is only searched once: the 
+	//	ladder of fixed steps, with the 1/3 and 1/2 
+	//	amplitude cuts merged in at their places
+	const double keyMags[2] = {amplitude / 3.0, amplitude / 2.0};
+	size_t keyIndex[2] = {0, 0};
+	size_t nKeys = 0;
+	
+	ScratchVector cutBuffer;
+	DoubleVec& magCuts = cutBuffer.get();
+	vector<size_t> ladder;
+	for (double mag = minMag; ; mag += minMag) {
+		const bool inLadder = (mag < amplitude);
+		while (getCut && nKeys < 2 
+				&& (!inLadder || keyMags[nKeys] <= mag)) {
+			keyIndex[nKeys] = magCuts.size();
+			magCuts.push_back(keyMags[nKeys]);
+			nKeys++;
+		}
+		if (!inLadder) {
+			break;
+		}
+		ladder.push_back(magCuts.size());
+		magCuts.push_back(mag);
+	}
+	
+	ScratchVector timeBuffer;
+	DoubleVec& cutTimes = timeBuffer.get();
+	peakFindTimescales(times, mags, magCuts, cutTimes);
+	
+	if (getCut) {
+		// Key cuts
+		cut3.addStat(cutTimes[keyIndex[0]]);
+		cut2.addStat(cutTimes[keyIndex[1]]);
+	}
+	
+	if (getPlot) {
+		peakPlot.addStat(cutTimes, magCuts, ladder);
+	}
+	
+	if (getCut) {
+		// 80% of the highest mag with a defined timescale
+		double maxMag = std::numeric_limits<double>::quiet_NaN();
+		for (vector<size_t>::const_reverse_iterator it = ladder.rbegin(); 
+				it != ladder.rend(); it++) {
+			if (!kpfutils::isNan(cutTimes[*it])) {
+				maxMag = magCuts[*it];
+				break;
+			}
+		}
+		
+		// Read the timescale off the ladder rather 
+		//	than searching the light curve again
+		const double mag80 = 0.8 * maxMag;
+		double time80 = interpolateSamples(magCuts, 
+			cutTimes, ladder, mag80);
+		// The ladder can't bracket the cut if it lies 
+		//	below the first step or next to an 
+		//	undefined timescale, so search exactly
+		if (kpfutils::isNan(time80) && !kpfutils::isNan(mag80)) {
+			DoubleVec singleTime;
+			peakFindTimescales(times, mags, 
+				vector<double>(1, mag80), singleTime);
+			// singleTime.size() == 1 guaranteed
+			time80 = singleTime.front();
+		}
+		cut80.addStat(time80);
+	}
+}
+
 /** Does all peak-finding related computations for a given light curve.
  *
- * @param[in] times The times at which the light curve was sampled.
- * @param[in] mags The values of the light curve
+ * @param[in] lc The light curve to analyze.
  * @param[in] getCut Flag indicating that cuts through the the 
  *	peak-finding curve should be extracted
  * @param[in] getPlot Flag indicating that the peak-finding curve should 
@@ -43,118 +285,75 @@ using kpftimes::peakFindTimescales;
  * @param[out] peakPlot The NamedCollection in which to record the 
  *	peak-finding curve.
  *
- * @pre @p times.size() = @p mags.size()
- * @pre Neither @p times nor @p mags may contain NaNs
- * 
  * @post if @p getCut, then new elements are appended to @p cut3, @p cut2, 
  *	and @p cut80. If the cut is undefined, NaN is appended.
  * @post if @p getPlot, then a new element is appended to @p peakPlot.
+ * @post The timescales are found with the search chosen by 
+ *	setPeakMethod().
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	store more statistics.
- * @exception std::invalid_argument Thrown if @p times and @p mags do not 
- *	have matching lengths or if @p times or @p data contains NaNs.
- * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
- *	and @p mags are too short to calculate the desired statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate the desired statistics.
  *
- * @exceptsafe The program is in a consistent state in the event of an exception.
+ * @exceptsafe The collections are unchanged in the event of an exception.
  */
-void doPeak(const vector<double>& times, const vector<double>& mags, 
+void doPeak(const AnalysisContext& lc, 
 		bool getCut, bool getPlot, 
 		CollectedScalars& cut3, CollectedScalars& cut2, 
 		CollectedScalars& cut80, CollectedPairs& peakPlot) {
-
-	if (times.size() != mags.size()) {
-		throw std::invalid_argument("Times and mags must have the same length in analyzeLightCurve() (gave " 
-			+ lexical_cast<string>(times.size()) + " for times and " 
-			+ lexical_cast<string>( mags.size()) + " for mags).");
-	}
+	const vector<double>& times = lc.getTimes();
+	const vector<double>& mags = lc.getMags();
 
 	if (getCut || getPlot) {
-		// copy-and-swap
-		CollectedScalars temp3    = cut3;
-		CollectedScalars temp2    = cut2;
-		CollectedScalars temp80   = cut80;
-		CollectedPairs   tempPlot = peakPlot;
+		// Checkpoints let us undo a partial update without copying 
+		//	the statistics from all previous light curves
+		const CollectedScalars::Checkpoint mark3    = cut3    .checkpoint();
+		const CollectedScalars::Checkpoint mark2    = cut2    .checkpoint();
+		const CollectedScalars::Checkpoint mark80   = cut80   .checkpoint();
+		const size_t markPlot = peakPlot.checkpoint();
 		
 		try {
-			double amplitude = getAmplitude(mags);
+			try {
+				double amplitude = lc.getAmplitude();
 				
-			// Treat cut2 and cut3 separately for improved efficiency
-			if (getCut) {
 				if (amplitude > 0) {
-					DoubleVec magCuts;
-					magCuts.push_back(amplitude / 3.0);
-					magCuts.push_back(amplitude / 2.0);
-				
-					DoubleVec cutTimes;
-					peakFindTimescales(times, mags, 
-						magCuts, cutTimes);
-					
-					// Key cuts
-					temp3.addStat(cutTimes[0]);
-					temp2.addStat(cutTimes[1]);
-				}
-			}
-			
-			if (amplitude > 0) {
-				const static double minMag = 0.01;
-				
-				DoubleVec magCuts;
-				for (double mag = minMag; mag < amplitude; mag += minMag) {
-					magCuts.push_back(mag);
-				}
-				
-				DoubleVec cutTimes;
-				peakFindTimescales(times, mags, magCuts, cutTimes);
-				
-				if (getPlot) {
-					tempPlot.addStat(cutTimes, magCuts);
+					if (getPeakMethod() == PEAK_LADDER) {
+						ladderPeaks(times, mags, amplitude, getCut, getPlot, 
+							cut3, cut2, cut80, peakPlot);
+					} else {
+						directPeaks(times, mags, amplitude, getCut, getPlot, 
+							cut3, cut2, cut80, peakPlot);
+					}
 				}
+			} catch (const except::NotEnoughData &e) {
+				// The one kind of Undefined we don't want to ignore
+				throw;
+			} catch (const except::Undefined &e) {
+				// Don't know how many of the collections were updated... revert to input
+				cut3    .rollback(mark3   );
+				cut2    .rollback(mark2   );
+				cut80   .rollback(mark80  );
+				peakPlot.rollback(markPlot);
 				
+				// May still throw bad_alloc
 				if (getCut) {
-					// 80% of the highest mag with a defined timescale
-					double mag08 = 0.8 * 
-						cutFunctionReverse(magCuts, cutTimes, 
-							kpfutils::NotNan());
-					
-					// can't use cutFunction() because cutTimes may 
-					//	have NaNs
-					DoubleVec singleTime;
-					peakFindTimescales(times, mags, 
-						vector<double>(1, mag08), singleTime);
-					// singleTime.size() == 1 guaranteed
-					temp80.addStat(singleTime.front());
+					cut3 .addNull();
+					cut2 .addNull();
+					cut80.addNull();
 				}
+//				if (getPlot) {
+//					peakPlot.addNull();
+//				}
 			}
-		} catch (const except::NotEnoughData &e) {
-			// The one kind of Undefined we don't want to ignore
+		} catch (...) {
+			// Leave the collections as they were before the call
+			cut3    .rollback(mark3   );
+			cut2    .rollback(mark2   );
+			cut80   .rollback(mark80  );
+			peakPlot.rollback(markPlot);
 			throw;
-		} catch (const except::Undefined &e) {
-			// Don't know how many of the collections were updated... revert to input
-			temp3    = cut3;
-			temp2    = cut2;
-			temp80   = cut80;
-			tempPlot = peakPlot;
-			
-			// May still throw bad_alloc
-			if (getCut) {
-				temp3 .addNull();
-				temp2 .addNull();
-				temp80.addNull();
-			}
-//			if (getPlot) {
-//				tempPlot.addNull();
-//			}
 		}
-		
-		// IMPORTANT: no exceptions beyond this point
-		
-		using std::swap;		
-		swap(cut3    , temp3 );
-		swap(cut2    , temp2 );
-		swap(cut80   , temp80);
-		swap(peakPlot, tempPlot);
 	}
 }
 
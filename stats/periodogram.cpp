@@ -2,14 +2,16 @@
  * @file lightcurveMC/stats/periodogram.cpp
  * @author Krzysztof Findeisen
  * @date Created June 8, 2013
- * @date Last modified June 8, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <boost/lexical_cast.hpp>
-#include <timescales/timescales.h>
+#include <boost/shared_ptr.hpp>
+#include "lsplan.h"
+#include "lsthreshold.h"
 #include "statcollect.h"
 #include "statfamilies.h"
 #include "../except/undefined.h"
@@ -17,71 +19,66 @@
 namespace lcmc { namespace stats {
 
 using boost::lexical_cast;
+using boost::shared_ptr;
 using std::vector;
 
 /** Does all periodogram-related computations for a given light curve.
  *
- * @param[in] times The times at which the light curve was sampled.
- * @param[in] data The values of the light curve
+ * @param[in] lc The light curve to analyze.
  * @param[in] getPeriod Flag indicating that the best period (having <1% FAP 
  *	in the case of Gaussian white noise) should be extracted
  * @param[in] getPlot Flag indicating that the periodograms should be stored
+ * @param[in] method The algorithm to use for calculating the periodogram.
  * @param[out] periods The NamedCollection in which to record the period, 
  *	if any.
  * @param[out] periodograms The NamedCollection in which to record 
  *	the periodograms.
  *
- * @pre @p times.size() = @p data.size()
- * @pre Neither @p times nor @p data may contain NaNs
- * 
  * @post if @p getPeriod, then a new element is appended to @p periods. 
  *	If no significant period is found, the appended value is NaN.
  * @post if @p getPlot, then a new element is appended to @p periodograms.
  *
+ * @perform The frequency grid and the trigonometric terms of the 
+ *	periodogram are reused if @p times is the same as on the previous 
+ *	call, so repeated calls for the same cadence cost O(NF) 
+ *	multiply-adds, where N = @p times.size() and F is the number of 
+ *	frequencies. If a periodogram computed with the same plan was 
+ *	recorded in @p lc, it is used without being computed again. 
+ *	Periodograms from the same plan share one frequency grid, so 
+ *	@p periodograms stores each grid once without comparing it.
+ *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	store more statistics.
- * @exception std::invalid_argument Thrown if @p times and @p data do not 
- *	have matching lengths or if @p times or @p data contains NaNs.
- * @exception lcmc::stats::except::NotEnoughData Thrown if @p times 
- *	and @p data are too short to calculate the desired statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate the desired statistics.
+ * @exception lcmc::stats::except::TimedOut Thrown if the periodogram 
+ *	runs past the current thread's StatDeadline. @p periods and 
+ *	@p periodograms are unchanged.
  *
  * @exceptsafe The program is in a consistent state in the event of an exception.
  */
-void doPeriodogram(const vector<double>& times, const vector<double>& data, 
-		bool getPeriod, bool getPlot, 
+void doPeriodogram(const AnalysisContext& lc, 
+		bool getPeriod, bool getPlot, PeriodogramMethod method, 
 		CollectedScalars& periods, CollectedPairs& periodograms) {
-	if (times.size() != data.size()) {
-		throw std::invalid_argument("Times and data must have the same length in doPeriodogram() (gave " 
-			+ lexical_cast<string>(times.size()) + " for times and " 
-			+ lexical_cast<string>(data.size()) + " for data).");
-	}
+	const vector<double>& times = lc.getTimes();
+	const vector<double>& data = lc.getMags();
 
 	if (getPeriod || getPlot) {
 		try {
-			double freqMin = 1.0/kpftimes::deltaT(times);
-			double freqMax = kpftimes::pseudoNyquistFreq(times);
-			if (freqMin < 0.005) {
-				freqMin = 0.005;
-			}
-			
-			DoubleVec freq;
-			kpftimes::freqGen(times, freq, freqMin, freqMax);
+			shared_ptr<const PeriodogramPlan> plan = 
+					PeriodogramPlan::forCadence(times, method);
+			const DoubleVec& freq = plan->getFreq();
 			
 			// False alarm probability
-			static double cacheFreqMin = -1.0, cacheFreqMax = -1.0;
-			static double threshold;
-			if (cacheFreqMax < 0.0 
-					|| cacheFreqMin != freqMin 
-					|| cacheFreqMax != freqMax) {
-				threshold = kpftimes::lsThreshold(times, freq, 
-						0.01, 1000);
-				cacheFreqMin = freqMin;
-				cacheFreqMax = freqMax;
-			}
+			const double threshold = cachedLsThreshold(*plan, 0.01, 1000);
 			
-			// Periodogram
-			DoubleVec power;
-			kpftimes::lombScargle(times, data, freq, power);
+			// Periodogram, unless it was already computed in a batch
+			DoubleVec computed;
+			const DoubleVec* batched = lc.findPeriodogram(*plan);
+			if (batched == NULL) {
+				plan->lombScargle(data, computed);
+			}
+			const DoubleVec& power = (batched != NULL ? *batched : computed);
 			
 			if (getPeriod) {	
 				// Find the highest peak in the periodogram
@@ -106,7 +103,8 @@ void doPeriodogram(const vector<double>& times, const vector<double>& data,
 			// no exceptions (other than bad_alloc) beyond this point
 
 			if (getPlot) {
-				periodograms.addStat(freq, power);
+				// Every light curve on the cadence shares one grid
+				periodograms.addStat(plan->getSharedFreq(), power);
 			}
 			
 		} catch (const std::invalid_argument& e) {
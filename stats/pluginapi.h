@@ -0,0 +1,94 @@
+/** Interface between the program and dynamically loaded statistics plugins
+ * @file lightcurveMC/stats/pluginapi.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * A plugin is a shared library named <tt>lcmc_</tt><i>name</i><tt>.so</tt> 
+ * that defines lcmcStatPlugin(). The interface is plain C, so that 
+ * plugins need not be compiled with the same compiler or C++ library 
+ * as the program, and no exception may propagate out of a plugin.
+ */
+
+#ifndef LCMCPLUGINAPIH
+#define LCMCPLUGINAPIH
+
+#include <stddef.h>
+
+/** The version of LcmcStatPlugin described by this header. It changes 
+ * whenever an existing member changes meaning or a new member is added.
+ */
+#define LCMC_PLUGIN_API_VERSION 1
+
+/** The name of the function every plugin must define
+ */
+#define LCMC_PLUGIN_ENTRY "lcmcStatPlugin"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Status codes returned by plugin functions
+ */
+enum LcmcPluginStatus {
+	/** The calculation succeeded */
+	LCMC_PLUGIN_OK = 0, 
+	/** The calculation failed; the message explains why */
+	LCMC_PLUGIN_ERROR = 1, 
+	/** There was not enough memory for the calculation */
+	LCMC_PLUGIN_NO_MEMORY = 2
+};
+
+/** Fits a squared exponential plus white noise Gaussian process model 
+ * to a light curve
+ *
+ * @param[in] times, data Arrays of the @p n observations of the light curve.
+ * @param[in] start The timescale, kernel variance, and noise variance 
+ *	from which to start the fit, as in lcmc::stats::GpParams. NaN 
+ *	elements start from the plugin's own defaults.
+ * @param[out] best Array of 3 elements to receive the best-fit timescale, 
+ *	kernel variance, and noise variance.
+ * @param[out] timeError The uncertainty on the best-fit timescale.
+ * @param[out] iterations The number of optimizer iterations, or -1 if 
+ *	not known.
+ * @param[out] message Buffer of @p messageSize characters to receive a 
+ *	null-terminated explanation if the fit fails.
+ *
+ * @return One of the LcmcPluginStatus codes. The outputs other than 
+ *	@p message are only written if the fit succeeds.
+ */
+typedef int (*LcmcGpFitFunction)(const double* times, const double* data, 
+		size_t n, const double* start, double* best, double* timeError, 
+		long* iterations, char* message, size_t messageSize);
+
+/** Describes the statistics provided by a plugin
+ *
+ * Each function member implements one family of statistics, and is 
+ * null if the plugin does not provide that family.
+ */
+struct LcmcStatPlugin {
+	/** Must be LCMC_PLUGIN_API_VERSION */
+	int apiVersion;
+	/** A short name for the plugin, for error messages */
+	const char* name;
+	/** Nonzero if the functions may be called from several threads 
+	 *	at once; otherwise the program serializes all calls */
+	int threadSafe;
+	/** Fits Gaussian process models, for '--gp-fit' */
+	LcmcGpFitFunction fitGp;
+};
+
+/** Returns the plugin's description, which must remain valid until 
+ * the program exits
+ */
+const struct LcmcStatPlugin* lcmcStatPlugin(void);
+
+/** The type of lcmcStatPlugin()
+ */
+typedef const struct LcmcStatPlugin* (*LcmcStatPluginEntry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif		/* end LCMCPLUGINAPIH */
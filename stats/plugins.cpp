@@ -0,0 +1,179 @@
+/** Loading of statistics plugins at run time
+ * @file lightcurveMC/stats/plugins.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+#include "plugins.h"
+
+namespace lcmc { namespace stats {
+
+using std::string;
+using std::vector;
+using boost::lexical_cast;
+
+/** Returns the directory containing the running program
+ *
+ * @return The directory of <tt>/proc/self/exe</tt>, or the working 
+ *	directory if it cannot be read.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the path.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string programDir() {
+	vector<char> buffer(4096);
+	const ssize_t length = readlink("/proc/self/exe", &buffer[0], buffer.size());
+	if (length <= 0 || static_cast<size_t>(length) >= buffer.size()) {
+		return ".";
+	}
+	
+	const string path(&buffer[0], static_cast<size_t>(length));
+	const size_t slash = path.rfind('/');
+	return (slash == string::npos ? string(".") : path.substr(0, slash));
+}
+
+/** Returns the directories searched for statistics plugins
+ *
+ * @return The directories in the colon-separated environment variable 
+ *	<tt>LCMC_PLUGIN_DIR</tt>, if set, followed by <tt>plugins/</tt> 
+ *	in and next to the directory containing the program, so that 
+ *	both the program and the test driver find plugins built in 
+ *	the source tree.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the path.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<string> statPluginPath() {
+	vector<string> path;
+	
+	const char* const env = std::getenv("LCMC_PLUGIN_DIR");
+	if (env != NULL) {
+		const string dirs(env);
+		size_t begin = 0;
+		while (begin <= dirs.size()) {
+			size_t end = dirs.find(':', begin);
+			if (end == string::npos) {
+				end = dirs.size();
+			}
+			if (end > begin) {
+				path.push_back(dirs.substr(begin, end - begin));
+			}
+			begin = end + 1;
+		}
+	}
+	
+	const string home = programDir();
+	path.push_back(home + "/plugins");
+	path.push_back(home + "/../plugins");
+	
+	return path;
+}
+
+/** Returns a statistics plugin, loading it on first use
+ *
+ * @param[in] name The name of the plugin, which is found in the file 
+ *	<tt>lcmc_</tt>@p name<tt>.so</tt> in the first directory of 
+ *	statPluginPath() that has one.
+ *
+ * @return The plugin's description.
+ *
+ * @post The plugin remains loaded until the program exits, so the 
+ *	return value and its functions may be used at any time.
+ *
+ * @perform Loading a plugin also loads the libraries it depends on, 
+ *	which may take seconds. Later calls with the same @p name take 
+ *	O(log N) time, where N is the number of plugins loaded.
+ * @perfmore Calls from different threads are serialized.
+ *
+ * @exception std::invalid_argument Thrown if @p name is empty or 
+ *	contains a '/'.
+ * @exception std::runtime_error Thrown if the plugin could not be found 
+ *	or loaded, or was built for a different version of pluginapi.h.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	load the plugin.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+const LcmcStatPlugin& loadStatPlugin(const string& name) {
+	if (name.empty() || name.find('/') != string::npos) {
+		throw std::invalid_argument("Invalid statistics plugin name '" + name + "'.");
+	}
+	
+	static boost::mutex loadLock;
+	static std::map<string, const LcmcStatPlugin*> loaded;
+	boost::mutex::scoped_lock guard(loadLock);
+	
+	std::map<string, const LcmcStatPlugin*>::const_iterator it = loaded.find(name);
+	if (it != loaded.end()) {
+		return *(it->second);
+	}
+	
+	const string file = "lcmc_" + name + ".so";
+	const vector<string> path = statPluginPath();
+	string errors;
+	void* handle = NULL;
+	for(vector<string>::const_iterator dir = path.begin(); 
+			dir != path.end() && handle == NULL; dir++) {
+		const string candidate = *dir + "/" + file;
+		// RTLD_GLOBAL lets libraries loaded later by the plugin, such 
+		//	as R packages, see the symbols of the plugin's dependencies
+		handle = dlopen(candidate.c_str(), RTLD_NOW | RTLD_GLOBAL);
+		if (handle == NULL) {
+			const char* const why = dlerror();
+			errors += "\n\t" + (why != NULL ? string(why) : candidate);
+		}
+	}
+	if (handle == NULL) {
+		throw std::runtime_error("Could not load statistics plugin '" + name 
+			+ "'; set LCMC_PLUGIN_DIR to the directory containing " 
+			+ file + ". Tried:" + errors);
+	}
+	
+	try {
+		void* const symbol = dlsym(handle, LCMC_PLUGIN_ENTRY);
+		if (symbol == NULL) {
+			throw std::runtime_error("Statistics plugin '" + name 
+				+ "' does not define " LCMC_PLUGIN_ENTRY "().");
+		}
+		// ISO C++ does not allow casts between object and function 
+		//	pointers, but POSIX guarantees they have the same representation
+		LcmcStatPluginEntry entry;
+		std::memcpy(&entry, &symbol, sizeof(entry));
+		
+		const LcmcStatPlugin* const plugin = entry();
+		if (plugin == NULL || plugin->apiVersion != LCMC_PLUGIN_API_VERSION) {
+			throw std::runtime_error("Statistics plugin '" + name 
+				+ "' was built for version " 
+				+ (plugin == NULL ? string("?") : lexical_cast<string>(plugin->apiVersion)) 
+				+ " of the plugin interface, but this program uses version " 
+				+ lexical_cast<string>(LCMC_PLUGIN_API_VERSION) + ".");
+		}
+		
+		loaded[name] = plugin;
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		// The handle is never closed, so that plugin stays valid
+		return *plugin;
+	} catch (...) {
+		dlclose(handle);
+		throw;
+	}
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,27 @@
+/** Loading of statistics plugins at run time
+ * @file lightcurveMC/stats/plugins.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCPLUGINSH
+#define LCMCPLUGINSH
+
+#include <string>
+#include <vector>
+#include "pluginapi.h"
+
+namespace lcmc { namespace stats {
+
+/** Returns the directories searched for statistics plugins
+ */
+std::vector<std::string> statPluginPath();
+
+/** Returns a statistics plugin, loading it on first use
+ */
+const LcmcStatPlugin& loadStatPlugin(const std::string& name);
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCPLUGINSH
@@ -0,0 +1,418 @@
+/** Lightweight timing of the stages of a simulation
+ * @file lightcurveMC/stats/profile.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <new>
+#include <ctime>
+#ifdef LCMC_USE_PERF_EVENTS
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/tss.hpp>
+#include "profile.h"
+
+namespace lcmc { namespace stats {
+
+/** Returns whether the simulation stages are timed
+ *
+ * @return A modifiable reference to the setting.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& profiling() {
+	static bool profile = false;
+	return profile;
+}
+
+/** Turns timing of the simulation stages on or off
+ *
+ * @param[in] profile If true, ProfileScope objects record the time 
+ *	spent in their scope.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any light curves are simulated.
+ */
+void setProfiling(bool profile) {
+	profiling() = profile;
+}
+
+/** Returns the setting chosen with setProfiling()
+ *
+ * @return True if the simulation stages are timed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool getProfiling() {
+	return profiling();
+}
+
+/** Returns the time from a clock that never runs backward
+ *
+ * @return The time, in seconds since an arbitrary starting point. Only 
+ *	differences between two calls are meaningful.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Falls back on the system clock on platforms without a 
+ *	monotonic clock, in which case changes to the system time 
+ *	distort the timings.
+ */
+double monotonicSeconds() {
+#ifdef CLOCK_MONOTONIC
+	timespec now;
+	if (clock_gettime(CLOCK_MONOTONIC, &now) == 0) {
+		return static_cast<double>(now.tv_sec) + 1e-9 * now.tv_nsec;
+	}
+#endif
+	namespace pt = boost::posix_time;
+	static const pt::ptime epoch(boost::gregorian::date(1970, 1, 1));
+	return 1e-6 * (pt::microsec_clock::universal_time() - epoch).total_microseconds();
+}
+
+/** Creates a count of zero events
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+HardwareCounts::HardwareCounts() : cycles(0.0), instructions(0.0), 
+		cacheMisses(0.0) {
+}
+
+/** Adds another count to this one
+ *
+ * @param[in] other The events to add.
+ *
+ * @return This object.
+ *
+ * @post Each count is the sum of its old value and the value in @p other.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+HardwareCounts& HardwareCounts::operator+=(const HardwareCounts& other) {
+	cycles       += other.cycles;
+	instructions += other.instructions;
+	cacheMisses  += other.cacheMisses;
+	return *this;
+}
+
+/** Returns the events counted between two readings
+ *
+ * @param[in] later, earlier Two readings of threadCounts() on the 
+ *	same thread.
+ *
+ * @return The events counted after @p earlier and before @p later.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+HardwareCounts operator-(const HardwareCounts& later, 
+		const HardwareCounts& earlier) {
+	HardwareCounts result;
+	result.cycles       = later.cycles       - earlier.cycles;
+	result.instructions = later.instructions - earlier.instructions;
+	result.cacheMisses  = later.cacheMisses  - earlier.cacheMisses;
+	return result;
+}
+
+/** Returns a fraction of a count
+ *
+ * @param[in] counts The events to divide.
+ * @param[in] factor The fraction to keep.
+ *
+ * @return Each count of @p counts, multiplied by @p factor.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+HardwareCounts operator*(const HardwareCounts& counts, double factor) {
+	HardwareCounts result;
+	result.cycles       = factor * counts.cycles;
+	result.instructions = factor * counts.instructions;
+	result.cacheMisses  = factor * counts.cacheMisses;
+	return result;
+}
+
+/** Returns whether profiled scopes count hardware events
+ *
+ * @return A modifiable reference to the setting.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& counting() {
+	static bool count = false;
+	return count;
+}
+
+/** Turns hardware event counting in profiled scopes on or off
+ *
+ * @param[in] count If true, ProfileScope objects given a HardwareCounts 
+ *	add the cycles, instructions, and last-level cache misses of 
+ *	their thread to it while profiling is on.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Not thread-safe. Call before any light curves are simulated. 
+ *	Has no useful effect unless profileCountersAvailable() is true.
+ */
+void setProfileCounters(bool count) {
+	counting() = count;
+}
+
+/** Returns whether profiled scopes count hardware events
+ *
+ * @return True if both setProfiling() and setProfileCounters() have 
+ *	been turned on.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool getProfileCounters() {
+	return getProfiling() && counting();
+}
+
+#ifdef LCMC_USE_PERF_EVENTS
+
+/** The number of events counted by CounterGroup
+ */
+const size_t N_COUNTERS = 3;
+
+/** Opens one of the calling thread's hardware counters
+ *
+ * @param[in] event The generic hardware event to count.
+ * @param[in] group The counter leading the group, or -1 to start a 
+ *	new group.
+ *
+ * @return A file descriptor for the counter, or -1 if it could not 
+ *	be opened.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+int openCounter(boost::uint64_t event, int group) {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type   = PERF_TYPE_HARDWARE;
+	attr.size   = sizeof(attr);
+	attr.config = event;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED 
+		| PERF_FORMAT_TOTAL_TIME_RUNNING;
+	// Unprivileged users may only count their own code
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+	return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+/** The hardware counters of one thread
+ *
+ * The counters form one group led by the cycle counter, so that the 
+ * kernel always schedules them together and a single read returns 
+ * all three.
+ */
+class CounterGroup {
+public:
+	/** Starts counting events on the calling thread
+	 *
+	 * @post If the system allows it, the counters of the calling 
+	 *	thread are running. Otherwise, valid() is false.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	CounterGroup() : fds() {
+		fds[0] = openCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+		fds[1] = openCounter(PERF_COUNT_HW_INSTRUCTIONS, fds[0]);
+		fds[2] = openCounter(PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+		if (!valid()) {
+			closeAll();
+		}
+	}
+
+	/** Stops counting
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	~CounterGroup() {
+		closeAll();
+	}
+
+	/** Tests whether the counters are running
+	 *
+	 * @return True if every counter could be opened.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool valid() const {
+		for(size_t i = 0; i < N_COUNTERS; i++) {
+			if (fds[i] < 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Reads the counters
+	 *
+	 * @return The events counted since the object was created, scaled 
+	 *	up for any time the kernel had the group switched out, or 
+	 *	zero if the counters could not be read.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	HardwareCounts read() const {
+		// Layout for PERF_FORMAT_GROUP with both times: 
+		//	count, time enabled, time running, then each value
+		boost::uint64_t buffer[3 + N_COUNTERS];
+		HardwareCounts result;
+		if (!valid() || ::read(fds[0], buffer, sizeof(buffer)) 
+					!= static_cast<ssize_t>(sizeof(buffer)) 
+				|| buffer[0] != N_COUNTERS || buffer[2] == 0) {
+			return result;
+		}
+		const double scale = static_cast<double>(buffer[1]) 
+			/ static_cast<double>(buffer[2]);
+		result.cycles       = scale * static_cast<double>(buffer[3]);
+		result.instructions = scale * static_cast<double>(buffer[4]);
+		result.cacheMisses  = scale * static_cast<double>(buffer[5]);
+		return result;
+	}
+
+private:
+	// Each group belongs to one thread
+	CounterGroup(const CounterGroup&);
+	CounterGroup& operator=(const CounterGroup&);
+
+	/** Closes every open counter
+	 *
+	 * @post Every element of @ref fds is -1.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void closeAll() {
+		// Close members before the leader
+		for(size_t i = N_COUNTERS; i > 0; i--) {
+			if (fds[i-1] >= 0) {
+				close(fds[i-1]);
+			}
+			fds[i-1] = -1;
+		}
+	}
+
+	/** The file descriptor of each counter, or -1 if it is not open */
+	int fds[N_COUNTERS];
+};
+
+#endif
+
+/** Tests whether hardware events can be counted on this system
+ *
+ * @return True if the program was built with PERF = perf_event and the 
+ *	kernel lets the calling thread count cycles, instructions, and 
+ *	cache misses.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Counting may be unavailable in virtual machines without a 
+ *	virtual performance monitoring unit, or if 
+ *	/proc/sys/kernel/perf_event_paranoid is 3 or more.
+ */
+bool profileCountersAvailable() {
+#ifdef LCMC_USE_PERF_EVENTS
+	const CounterGroup probe;
+	return probe.valid();
+#else
+	return false;
+#endif
+}
+
+/** Returns the hardware events counted on the calling thread so far
+ *
+ * The counters are started the first time each thread calls this 
+ * function, and stopped when the thread exits.
+ *
+ * @return The events counted since the first call on this thread, or 
+ *	zero if getProfileCounters() is false or the events cannot be 
+ *	counted. Only differences between two calls on the same thread 
+ *	are meaningful.
+ *
+ * @perform One system call per call, after the first.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+HardwareCounts threadCounts() {
+#ifdef LCMC_USE_PERF_EVENTS
+	if (getProfileCounters()) {
+		static boost::thread_specific_ptr<CounterGroup> groups;
+		try {
+			if (groups.get() == NULL) {
+				groups.reset(new CounterGroup());
+			}
+		} catch (const std::bad_alloc& e) {
+			return HardwareCounts();
+		}
+		return groups->read();
+	}
+#endif
+	return HardwareCounts();
+}
+
+/** Starts timing a scope
+ *
+ * @param[in,out] total The running total, in seconds, to which the time 
+ *	spent in the scope will be added.
+ *
+ * @post If getProfiling() is true, @p total is increased by the time 
+ *	between the creation and destruction of this object. Otherwise, 
+ *	@p total is unchanged.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ProfileScope::ProfileScope(double& total) 
+		: total(getProfiling() ? &total : NULL), 
+		start(getProfiling() ? monotonicSeconds() : 0.0), 
+		counts(NULL), startCounts() {
+}
+
+/** Starts timing a scope and counting its hardware events
+ *
+ * @param[in,out] total The running total, in seconds, to which the time 
+ *	spent in the scope will be added.
+ * @param[in,out] counts The running total to which the hardware events 
+ *	counted on the calling thread during the scope will be added.
+ *
+ * @pre The object is destroyed on the thread that created it.
+ *
+ * @post If getProfiling() is true, @p total is increased by the time 
+ *	between the creation and destruction of this object. Otherwise, 
+ *	@p total is unchanged.
+ * @post If getProfileCounters() is true, @p counts is increased by the 
+ *	events counted between the creation and destruction of this 
+ *	object. Otherwise, @p counts is unchanged.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Events on other threads, such as those a scope waits for, are 
+ *	not counted.
+ */
+ProfileScope::ProfileScope(double& total, HardwareCounts& counts) 
+		: total(getProfiling() ? &total : NULL), 
+		start(getProfiling() ? monotonicSeconds() : 0.0), 
+		counts(getProfileCounters() ? &counts : NULL), 
+		startCounts(threadCounts()) {
+}
+
+/** Stops timing a scope
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ProfileScope::~ProfileScope() {
+	if (total != NULL) {
+		*total += monotonicSeconds() - start;
+	}
+	if (counts != NULL) {
+		*counts += threadCounts() - startCounts;
+	}
+}
+
+}}		// end lcmc::stats
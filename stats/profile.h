@@ -0,0 +1,111 @@
+/** Lightweight timing of the stages of a simulation
+ * @file lightcurveMC/stats/profile.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCPROFILEH
+#define LCMCPROFILEH
+
+namespace lcmc { namespace stats {
+
+/** Turns timing of the simulation stages on or off
+ */
+void setProfiling(bool profile);
+
+/** Returns the setting chosen with setProfiling()
+ */
+bool getProfiling();
+
+/** Returns the time from a clock that never runs backward
+ */
+double monotonicSeconds();
+
+/** Hardware events counted on one thread over some interval
+ *
+ * The counts are stored as doubles, so that they can be scaled for 
+ * counter multiplexing and summed over many light curves.
+ */
+struct HardwareCounts {
+	/** Creates a count of zero events
+	 */
+	HardwareCounts();
+
+	/** Adds another count to this one
+	 */
+	HardwareCounts& operator+=(const HardwareCounts& other);
+
+	/** Processor cycles */
+	double cycles;
+	/** Instructions retired */
+	double instructions;
+	/** Last-level cache misses */
+	double cacheMisses;
+};
+
+/** Returns the events counted between two readings
+ */
+HardwareCounts operator-(const HardwareCounts& later, 
+		const HardwareCounts& earlier);
+
+/** Returns a fraction of a count
+ */
+HardwareCounts operator*(const HardwareCounts& counts, double factor);
+
+/** Turns hardware event counting in profiled scopes on or off
+ */
+void setProfileCounters(bool count);
+
+/** Returns whether profiled scopes count hardware events
+ */
+bool getProfileCounters();
+
+/** Tests whether hardware events can be counted on this system
+ */
+bool profileCountersAvailable();
+
+/** Returns the hardware events counted on the calling thread so far
+ */
+HardwareCounts threadCounts();
+
+/** ProfileScope adds the time spent in a scope to a running total, 
+ * if setProfiling() has turned profiling on.
+ *
+ * A scope may also add the hardware events counted on its thread to a 
+ * second total, if setProfileCounters() has turned counting on.
+ * When profiling is off, the object does not read the clock or the 
+ * counters.
+ */
+class ProfileScope {
+public:
+	/** Starts timing a scope
+	 */
+	explicit ProfileScope(double& total);
+
+	/** Starts timing a scope and counting its hardware events
+	 */
+	ProfileScope(double& total, HardwareCounts& counts);
+
+	/** Stops timing a scope
+	 */
+	~ProfileScope();
+
+private:
+	// Scopes cannot be copied
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+
+	/** The total to update, or null if profiling is off */
+	double* total;
+	/** The time at which the scope started */
+	double start;
+	/** The counts to update, or null if counting is off */
+	HardwareCounts* counts;
+	/** The thread's counts when the scope started */
+	HardwareCounts startCounts;
+};
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCPROFILEH
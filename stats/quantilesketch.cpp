@@ -0,0 +1,481 @@
+/** Approximate quantiles that do not require storing the data
+ * @file lightcurveMC/stats/quantilesketch.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdio>
+#include <boost/lexical_cast.hpp>
+#include "quantilesketch.h"
+#include "../../common/cerror.h"
+#include "../../common/fileio.h"
+#include "../../common/nan.h"
+
+namespace lcmc { namespace stats {
+
+using std::vector;
+
+namespace {
+
+/** Returns the level size of new sketches
+ *
+ * @return A modifiable reference to the level size.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t& sketchSize() {
+	static size_t levelSize = 64;
+	return levelSize;
+}
+
+/** Orders (value, weight) pairs by value
+ */
+bool lessValue(const std::pair<double, size_t>& a, 
+		const std::pair<double, size_t>& b) {
+	return a.first < b.first;
+}
+
+}	// end unnamed namespace
+
+/** Sets the number of values each level of a new quantile sketch 
+ *	holds before it is compacted
+ *
+ * Larger levels give smaller rank errors, which are about 1% for 
+ * 10<sup>5</sup> values at the default of 64, at the cost of memory that 
+ * grows as (level size) log2(N/(level size)).
+ *
+ * @param[in] levelSize The new level size.
+ *
+ * @post Sketches created with the default constructor from now on 
+ *	compact their levels at @p levelSize values. Existing sketches 
+ *	are unchanged.
+ *
+ * @exception std::invalid_argument Thrown if @p levelSize is odd 
+ *	or less than 2.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe. Call before any statistics are calculated.
+ */
+void setSketchSize(long levelSize) {
+	if (levelSize < 2 || levelSize % 2 != 0) {
+		throw std::invalid_argument("Quantile sketch size must be a positive even number (gave "
+			+ boost::lexical_cast<std::string>(levelSize) + ").");
+	}
+	sketchSize() = static_cast<size_t>(levelSize);
+}
+
+/** Returns the level size chosen with setSketchSize()
+ *
+ * @return The number of values at which the levels of a new sketch 
+ *	are compacted.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t getSketchSize() {
+	return sketchSize();
+}
+
+/** Creates a sketch that has seen no values.
+ *
+ * @post count() = 0
+ * @post The sketch compacts its levels at getSketchSize() values.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+QuantileSketch::QuantileSketch() : levelSize(getSketchSize()), levels(), 
+		nValues(0), oddNext(false) {
+}
+
+/** Creates a sketch with a specific accuracy that has seen no values.
+ *
+ * @param[in] levelSize The number of values at which a level is 
+ *	compacted.
+ *
+ * @pre @p levelSize is even and at least 2
+ *
+ * @post count() = 0
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+QuantileSketch::QuantileSketch(size_t levelSize) : levelSize(levelSize), 
+		levels(), nValues(0), oddNext(false) {
+}
+
+/** Returns the most values a level can hold between calls to add()
+ *
+ * @return levelSize - 1 values of the level's own, plus levelSize/2 
+ *	from the level below, plus one left over from an odd compaction.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t QuantileSketch::levelCapacity() const {
+	return levelSize + levelSize/2 + 1;
+}
+
+/** Makes sure the next call to add() cannot throw.
+ *
+ * Callers that must update many sketches atomically can reserve all of 
+ * them first, then add the values once nothing else can fail.
+ *
+ * @post The next call to add() will not throw exceptions.
+ *
+ * @perform Constant time
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	prepare the sketch.
+ *
+ * @exceptsafe The values summarized are unchanged in the event of 
+ *	an exception.
+ */
+void QuantileSketch::reserveAdd() {
+	// A value can cascade only as far as the first level that is not 
+	//	about to fill, so one empty level on top is always enough
+	if (levels.empty() || !levels.back().empty()) {
+		vector<double> top;
+		top.reserve(levelCapacity());
+		levels.push_back(top);
+	}
+	for(vector<vector<double> >::iterator it = levels.begin(); 
+			it != levels.end(); it++) {
+		it->reserve(levelCapacity());
+	}
+}
+
+/** Incorporates a value into the sketch.
+ *
+ * @param[in] value The value to add.
+ *
+ * @pre @p value may be NaN or infinite
+ *
+ * @post If @p value is not NaN, the sketch describes all the values 
+ *	previously added, plus @p value. Otherwise, the sketch is unchanged.
+ *
+ * @perform Amortized constant time.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the value. Cannot happen if reserveAdd() was called since 
+ *	the last change to the sketch.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void QuantileSketch::add(double value) {
+	if (kpfutils::isNan(value)) {
+		return;
+	}
+	if (levels.empty() || !levels.back().empty()) {
+		reserveAdd();
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	levels.front().push_back(value);
+	nValues++;
+	for(size_t i = 0; i + 1 < levels.size() && levels[i].size() >= levelSize; i++) {
+		compact(i);
+	}
+}
+
+/** Sorts a full level and moves every other value to the level above it.
+ *
+ * @param[in] level The level to compact.
+ *
+ * @pre @p level + 1 &lt; levels.size()
+ * @pre levels[@p level + 1] has room for half of levels[@p level].
+ *
+ * @post Each pair of values at @p level is replaced by one of them at 
+ *	@p level + 1, which keeps the total weight unchanged. If the level 
+ *	held an odd number of values, its largest stays behind.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void QuantileSketch::compact(size_t level) {
+	vector<double>& from = levels[level];
+	vector<double>& to   = levels[level+1];
+	std::sort(from.begin(), from.end());
+	
+	const size_t nPairs = from.size() / 2;
+	for(size_t i = 0; i < nPairs; i++) {
+		to.push_back(from[2*i + (oddNext ? 1 : 0)]);
+	}
+	// Alternating which value survives keeps the estimates unbiased
+	oddNext = !oddNext;
+	
+	// Moving the leftover to the front never throws
+	if (from.size() % 2 == 1) {
+		from.front() = from.back();
+		from.resize(1);
+	} else {
+		from.clear();
+	}
+}
+
+/** Incorporates all the values summarized by another sketch.
+ *
+ * @param[in] other The sketch to combine with this one.
+ *
+ * @pre @p other may be the same object as @p *this
+ *
+ * @post The sketch describes all the values previously added, plus 
+ *	all the values described by @p other.
+ *
+ * @perform O(M) time, where M is the number of values stored by 
+ *	@p other.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the values.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void QuantileSketch::merge(const QuantileSketch& other) {
+	QuantileSketch result(*this);
+	
+	if (result.levels.size() < other.levels.size()) {
+		result.levels.resize(other.levels.size());
+	}
+	for(size_t i = 0; i < other.levels.size(); i++) {
+		result.levels[i].insert(result.levels[i].end(), 
+			other.levels[i].begin(), other.levels[i].end());
+	}
+	result.nValues += other.nValues;
+	
+	// Restore the invariants of add() from the bottom up
+	for(size_t i = 0; i < result.levels.size(); i++) {
+		if (result.levels[i].size() >= levelSize) {
+			if (i + 1 == result.levels.size()) {
+				result.levels.push_back(vector<double>());
+			}
+			result.levels[i+1].reserve(result.levels[i+1].size() 
+				+ result.levels[i].size()/2);
+			result.compact(i);
+		}
+	}
+	result.reserveAdd();
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(result);
+}
+
+/** Returns the number of values summarized.
+ *
+ * @return The number of values other than NaN passed to add(), plus 
+ *	the counts of any merged sketches.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t QuantileSketch::count() const {
+	return nValues;
+}
+
+/** Returns an estimate of a quantile of the values.
+ *
+ * @param[in] q The quantile to estimate.
+ *
+ * @pre 0 &le; @p q &le; 1
+ *
+ * @return The smallest stored value such that a fraction @p q of the 
+ *	weight of the sketch is at or below it, or NaN if the sketch 
+ *	is empty. While fewer than levelSize values have been added, 
+ *	this is the exact quantile.
+ *
+ * @perform O(M log M) time, where M is the number of values stored.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	sort the values.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+double QuantileSketch::quantile(double q) const {
+	if (nValues == 0) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	
+	vector<std::pair<double, size_t> > weighted;
+	for(size_t i = 0; i < levels.size(); i++) {
+		const size_t weight = static_cast<size_t>(1) << i;
+		for(vector<double>::const_iterator it = levels[i].begin(); 
+				it != levels[i].end(); it++) {
+			weighted.push_back(std::make_pair(*it, weight));
+		}
+	}
+	std::sort(weighted.begin(), weighted.end(), &lessValue);
+	
+	const double target = q * static_cast<double>(nValues);
+	size_t cumulative = 0;
+	for(vector<std::pair<double, size_t> >::const_iterator it = weighted.begin(); 
+			it != weighted.end(); it++) {
+		cumulative += it->second;
+		if (static_cast<double>(cumulative) >= target) {
+			return it->first;
+		}
+	}
+	return weighted.back().first;
+}
+
+/** Returns the number of bytes held by the sketch.
+ *
+ * @return The memory reserved for stored values.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t QuantileSketch::memoryBytes() const {
+	size_t bytes = levels.capacity() * sizeof(vector<double>);
+	for(vector<vector<double> >::const_iterator it = levels.begin(); 
+			it != levels.end(); it++) {
+		bytes += it->capacity() * sizeof(double);
+	}
+	return bytes;
+}
+
+/** Saves the sketch to a text file
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ *
+ * @post The sketch is written on the current line of @p file, in a 
+ *	form that readState() restores exactly. No newline is written.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the sketch could not 
+ *	be written.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void QuantileSketch::writeState(FILE* const file) const {
+	if (fprintf(file, " %lu %lu %d %lu", static_cast<unsigned long>(levelSize), 
+			static_cast<unsigned long>(nValues), oddNext ? 1 : 0, 
+			static_cast<unsigned long>(levels.size())) < 0) {
+		kpfutils::fileError(file, "Could not save sketch in writeState(): ");
+	}
+	for(vector<vector<double> >::const_iterator it = levels.begin(); 
+			it != levels.end(); it++) {
+		if (fprintf(file, " %lu", static_cast<unsigned long>(it->size())) < 0) {
+			kpfutils::fileError(file, "Could not save sketch in writeState(): ");
+		}
+		// %.17g preserves every bit of a double
+		for(vector<double>::const_iterator jt = it->begin(); 
+				jt != it->end(); jt++) {
+			if (fprintf(file, " %.17g", *jt) < 0) {
+				kpfutils::fileError(file, "Could not save sketch in writeState(): ");
+			}
+		}
+	}
+}
+
+/** Restores a sketch saved by writeState()
+ *
+ * @param[in] file An open file handle positioned at the text written 
+ *	by writeState().
+ *
+ * @post The object summarizes the same values, with the same level 
+ *	size, as the object that wrote the text, and @p file is positioned 
+ *	after the text.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p file does not 
+ *	contain a saved sketch.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	restore the sketch.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void QuantileSketch::readState(FILE* const file) {
+	unsigned long newSize, count, nLevels;
+	int odd;
+	if (fscanf(file, "%lu %lu %d %lu", &newSize, &count, &odd, &nLevels) != 4 
+			|| newSize < 2 || newSize % 2 != 0) {
+		throw kpfutils::except::FileIo("Misformatted saved state: expected a quantile sketch.");
+	}
+	
+	QuantileSketch result(newSize);
+	unsigned long weight = 0;
+	for(unsigned long i = 0; i < nLevels; i++) {
+		unsigned long size;
+		if (fscanf(file, "%lu", &size) != 1 || size >= result.levelCapacity()) {
+			throw kpfutils::except::FileIo("Misformatted saved state: expected a quantile sketch.");
+		}
+		vector<double> level(size);
+		for(vector<double>::iterator it = level.begin(); it != level.end(); it++) {
+			if (fscanf(file, "%lf", &(*it)) != 1) {
+				throw kpfutils::except::FileIo("Misformatted saved state: expected a quantile sketch.");
+			}
+		}
+		weight += size << i;
+		result.levels.push_back(level);
+	}
+	if (weight != count) {
+		throw kpfutils::except::FileIo("Misformatted saved state: quantile sketch has the wrong number of values.");
+	}
+	result.nValues = count;
+	result.oddNext = (odd != 0);
+	result.reserveAdd();
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(result);
+}
+
+/** Non-throwing swap
+ *
+ * @param[in,out] other The sketch with which to exchange contents.
+ *
+ * @post The values previously summarized by @p other are now summarized 
+ *	by @p *this, and vice versa.
+ * 
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void QuantileSketch::swap(QuantileSketch& other) {
+	using std::swap;
+	
+	swap(this->levelSize, other.levelSize);
+	swap(this->levels   , other.levels   );
+	swap(this->nValues  , other.nValues  );
+	swap(this->oddNext  , other.oddNext  );
+}
+
+/** Non-throwing swap
+ *
+ * @param[in,out] a,b The sketches to exchange contents.
+ *
+ * @post The values previously summarized by @p a are now summarized 
+ *	by @p b, and vice versa.
+ * 
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void swap(QuantileSketch& a, QuantileSketch& b) {
+	a.swap(b);
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,131 @@
+/** Approximate quantiles that do not require storing the data
+ * @file lightcurveMC/stats/quantilesketch.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCQUANTSKETCHH
+#define LCMCQUANTSKETCHH
+
+#include <vector>
+#include <cstdio>
+
+namespace lcmc { namespace stats {
+
+using std::vector;
+
+/** Sets the number of values each level of a new quantile sketch 
+ *	holds before it is compacted
+ */
+void setSketchSize(long levelSize);
+
+/** Returns the level size chosen with setSketchSize()
+ */
+size_t getSketchSize();
+
+/** Estimates the quantiles of a sequence of values while storing only 
+ *	a number of them that grows with the logarithm of their count.
+ *
+ * The sketch is a stack of compactors (Karnin, Lang, & Liberty 2016, 
+ * without the randomization): each level holds values standing for 
+ * 2<sup>level</sup> inputs, and a full level is sorted and every other 
+ * value is promoted to the next level. The compaction is deterministic, 
+ * so a run gives the same answer every time, and two sketches can be 
+ * combined, so partial results from several threads may be merged.
+ */
+class QuantileSketch {
+public:
+	/** Creates a sketch that has seen no values.
+	 */
+	QuantileSketch();
+
+	/** Creates a sketch with a specific accuracy that has seen no values.
+	 */
+	explicit QuantileSketch(size_t levelSize);
+
+	/** Makes sure the next call to add() cannot throw.
+	 */
+	void reserveAdd();
+
+	/** Incorporates a value into the sketch.
+	 */
+	void add(double value);
+
+	/** Incorporates all the values summarized by another sketch.
+	 */
+	void merge(const QuantileSketch& other);
+
+	/** Returns the number of values summarized.
+	 */
+	size_t count() const;
+
+	/** Returns an estimate of a quantile of the values.
+	 */
+	double quantile(double q) const;
+
+	/** Returns the number of bytes held by the sketch.
+	 */
+	size_t memoryBytes() const;
+
+	/** Saves the sketch to a text file
+	 */
+	void writeState(FILE* const file) const;
+
+	/** Restores a sketch saved by writeState()
+	 */
+	void readState(FILE* const file);
+
+	/** Non-throwing swap
+	 */
+	void swap(QuantileSketch& other);
+
+private:
+	/** Sorts a full level and moves every other value to the 
+	 *	level above it.
+	 */
+	void compact(size_t level);
+
+	/** Returns the most values a level can hold between calls to add()
+	 */
+	size_t levelCapacity() const;
+
+	/** The number of values at which a level is compacted */
+	size_t levelSize;
+	/** The values at each level, unsorted */
+	vector<vector<double> > levels;
+	/** The number of values summarized */
+	size_t nValues;
+	/** Whether the next compaction keeps the odd-numbered values */
+	bool oddNext;
+};
+
+/** Non-throwing swap
+ */
+void swap(QuantileSketch& a, QuantileSketch& b);
+
+}}		// end lcmc::stats
+
+#endif		// End ifndef LCMCQUANTSKETCHH
@@ -0,0 +1,462 @@
+/** Contiguous storage for sequences of variable-length vectors
+ * @file lightcurveMC/stats/raggedarray.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <boost/lexical_cast.hpp>
+#include "raggedarray.h"
+
+namespace lcmc { namespace stats {
+
+using boost::lexical_cast;
+using std::string;
+
+/** Ensures that a vector can grow without reallocating
+ *
+ * Unlike a bare call to vector::reserve(), growth is geometric, so
+ * growing a vector one element at a time takes amortized constant time.
+ *
+ * @param[in,out] vec The vector to prepare.
+ * @param[in] extra The number of elements that will be added to @p vec.
+ *
+ * @post <tt>vec.capacity() &ge; vec.size() + extra</tt>
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	enlarge @p vec.
+ *
+ * @exceptsafe The contents of @p vec are unchanged, whether or not
+ *	an exception is thrown.
+ */
+template <typename T>
+void reserveExtra(vector<T>& vec, size_t extra) {
+	const size_t needed = vec.size() + extra;
+	if (needed > vec.capacity()) {
+		vec.reserve(std::max(needed, 2*vec.capacity()));
+	}
+}
+
+/** Checks that a row index is valid
+ *
+ * @param[in] row The index to check.
+ * @param[in] nRows The number of rows in the array.
+ *
+ * @exception std::out_of_range Thrown if @p row &ge; @p nRows.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void checkRow(size_t row, size_t nRows) {
+	if (row >= nRows) {
+		throw std::out_of_range("Row " + lexical_cast<string>(row)
+			+ " requested from " + lexical_cast<string>(nRows)
+			+ "-row RaggedArray.");
+	}
+}
+
+/** Checks that an array's rows are read at the precision they are 
+ *	stored in
+ *
+ * @param[in] stored The precision of the array.
+ * @param[in] requested The precision of the pointers requested.
+ *
+ * @exception std::logic_error Thrown if @p stored &ne; @p requested.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void checkPrecision(ValuePrecision stored, ValuePrecision requested) {
+	if (stored != requested) {
+		throw std::logic_error(stored == SINGLE_PRECISION 
+			? "Double-precision row requested from single-precision RaggedArray."
+			: "Single-precision row requested from double-precision RaggedArray.");
+	}
+}
+
+/** Creates an array with no rows.
+ *
+ * @param[in] precision How the values of the array are to be stored.
+ *
+ * @post size() = 0
+ * @post getPrecision() = @p precision
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to construct the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+RaggedArray::RaggedArray(ValuePrecision precision) : precision(precision), 
+		values(), floats(), offsets(1, 0) {
+}
+
+/** Returns how the values of the array are stored.
+ *
+ * @return The precision given when the array was created.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ValuePrecision RaggedArray::getPrecision() const {
+	return precision;
+}
+
+/** Returns the number of rows in the array.
+ *
+ * @return The number of calls to push_back() since the array was
+ *	created or cleared, plus the rows added by append(), less the
+ *	rows removed by truncate().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t RaggedArray::size() const {
+	return offsets.size() - 1;
+}
+
+/** Returns the number of values in a row.
+ *
+ * @param[in] row The index of the row to examine.
+ *
+ * @return The length of the vector stored at @p row.
+ *
+ * @exception std::out_of_range Thrown if @p row &ge; size().
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+size_t RaggedArray::rowSize(size_t row) const {
+	checkRow(row, size());
+	return offsets[row+1] - offsets[row];
+}
+
+/** Returns a pointer to the first value in a row.
+ *
+ * @param[in] row The index of the row to examine.
+ *
+ * @return A pointer such that <tt>[rowBegin(row), rowEnd(row))</tt>
+ *	contains the values of the row. The pointer is invalidated by
+ *	any call to a non-const method.
+ *
+ * @exception std::out_of_range Thrown if @p row &ge; size().
+ * @exception std::logic_error Thrown if the array is stored in 
+ *	SINGLE_PRECISION.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const double* RaggedArray::rowBegin(size_t row) const {
+	checkRow(row, size());
+	checkPrecision(precision, DOUBLE_PRECISION);
+	// &values[0] is not defined for an empty vector
+	return values.empty() ? NULL : &values[0] + offsets[row];
+}
+
+/** Returns a pointer past the last value in a row.
+ *
+ * @param[in] row The index of the row to examine.
+ *
+ * @return A pointer such that <tt>[rowBegin(row), rowEnd(row))</tt>
+ *	contains the values of the row. The pointer is invalidated by
+ *	any call to a non-const method.
+ *
+ * @exception std::out_of_range Thrown if @p row &ge; size().
+ * @exception std::logic_error Thrown if the array is stored in 
+ *	SINGLE_PRECISION.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const double* RaggedArray::rowEnd(size_t row) const {
+	checkRow(row, size());
+	checkPrecision(precision, DOUBLE_PRECISION);
+	return values.empty() ? NULL : &values[0] + offsets[row+1];
+}
+
+/** Returns a pointer to the first value in a row stored in 
+ *	single precision.
+ *
+ * @param[in] row The index of the row to examine.
+ *
+ * @return A pointer such that <tt>[floatRowBegin(row), floatRowEnd(row))</tt>
+ *	contains the values of the row. The pointer is invalidated by
+ *	any call to a non-const method.
+ *
+ * @exception std::out_of_range Thrown if @p row &ge; size().
+ * @exception std::logic_error Thrown if the array is stored in 
+ *	DOUBLE_PRECISION.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const float* RaggedArray::floatRowBegin(size_t row) const {
+	checkRow(row, size());
+	checkPrecision(precision, SINGLE_PRECISION);
+	return floats.empty() ? NULL : &floats[0] + offsets[row];
+}
+
+/** Returns a pointer past the last value in a row stored in 
+ *	single precision.
+ *
+ * @param[in] row The index of the row to examine.
+ *
+ * @return A pointer such that <tt>[floatRowBegin(row), floatRowEnd(row))</tt>
+ *	contains the values of the row. The pointer is invalidated by
+ *	any call to a non-const method.
+ *
+ * @exception std::out_of_range Thrown if @p row &ge; size().
+ * @exception std::logic_error Thrown if the array is stored in 
+ *	DOUBLE_PRECISION.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+const float* RaggedArray::floatRowEnd(size_t row) const {
+	checkRow(row, size());
+	checkPrecision(precision, SINGLE_PRECISION);
+	return floats.empty() ? NULL : &floats[0] + offsets[row+1];
+}
+
+/** Adds a row to the end of the array.
+ *
+ * @param[in] row The values to store.
+ *
+ * @post size() is increased by 1, and the last row equals @p row.
+ *
+ * @perform Amortized O(N) time, where N = @p row.size().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the new row.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void RaggedArray::push_back(const vector<double>& row) {
+	// &row[0] is not defined for an empty vector
+	if (row.empty()) {
+		push_back(NULL, NULL);
+	} else {
+		push_back(&row[0], &row[0] + row.size());
+	}
+}
+
+/** Adds a row to the end of the array.
+ *
+ * @param[in] begin, end The values to store.
+ *
+ * @pre [@p begin, @p end) is a valid range that does not point into 
+ *	this array, or @p begin = @p end.
+ *
+ * @post size() is increased by 1, and the last row equals 
+ *	[@p begin, @p end), rounded to floats if the array is stored 
+ *	in SINGLE_PRECISION.
+ *
+ * @perform Amortized O(N) time, where N = @p end - @p begin.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the new row.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void RaggedArray::push_back(const double* begin, const double* end) {
+	// reserve never changes the contents of the vector, whether
+	//	or not it throws an exception, so it is a safe operation
+	// if neither call to reserveExtra() throws, insert() and
+	//	push_back() will not throw either, since copying a
+	//	double or a size_t does not throw
+	const size_t length = static_cast<size_t>(end - begin);
+	if (precision == SINGLE_PRECISION) {
+		reserveExtra(floats, length);
+	} else {
+		reserveExtra(values, length);
+	}
+	reserveExtra(offsets, 1);
+
+	// IMPORTANT: no exceptions beyond this point
+
+	if (precision == SINGLE_PRECISION) {
+		floats.insert(floats.end(), begin, end);
+	} else {
+		values.insert(values.end(), begin, end);
+	}
+	offsets.push_back(offsets.back() + length);
+}
+
+/** Adds selected elements of a vector as a row at the end of
+ *	the array.
+ *
+ * @param[in] source The vector from which to take values.
+ * @param[in] indices The positions in @p source of the values to store, 
+ *	in the order they are to be stored.
+ *
+ * @pre Every element of @p indices is less than @p source.size().
+ *
+ * @post size() is increased by 1, and element i of the last row equals 
+ *	<tt>source[indices[i]]</tt>.
+ *
+ * @perform Amortized O(N) time, where N = @p indices.size().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the new row.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void RaggedArray::push_back(const vector<double>& source, 
+		const vector<size_t>& indices) {
+	if (precision == SINGLE_PRECISION) {
+		reserveExtra(floats, indices.size());
+	} else {
+		reserveExtra(values, indices.size());
+	}
+	reserveExtra(offsets, 1);
+
+	// IMPORTANT: no exceptions beyond this point
+
+	for(vector<size_t>::const_iterator it = indices.begin(); 
+			it != indices.end(); it++) {
+		if (precision == SINGLE_PRECISION) {
+			floats.push_back(static_cast<float>(source[*it]));
+		} else {
+			values.push_back(source[*it]);
+		}
+	}
+	offsets.push_back(offsets.back() + indices.size());
+}
+
+/** Adds all the rows of another array to the end of this one.
+ *
+ * @param[in] other The rows to add.
+ *
+ * @pre @p other may be the same object as @p *this
+ *
+ * @post The array contains all the rows previously stored, followed by
+ *	all the rows of @p other, in the same order as in @p other. The 
+ *	new rows are stored at this array's precision, whatever the 
+ *	precision of @p other.
+ *
+ * @perform Amortized O(N) time, where N is the number of values in @p other.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the new rows.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void RaggedArray::append(const RaggedArray& other) {
+	if (&other == this) {
+		const RaggedArray copy = other;
+		append(copy);
+		return;
+	}
+
+	if (precision == SINGLE_PRECISION) {
+		reserveExtra(floats, other.offsets.back());
+	} else {
+		reserveExtra(values, other.offsets.back());
+	}
+	reserveExtra(offsets, other.size());
+
+	// IMPORTANT: no exceptions beyond this point
+
+	// Only one of other's buffers is nonempty
+	const size_t base = offsets.back();
+	if (precision == SINGLE_PRECISION) {
+		floats.insert(floats.end(), other.values.begin(), other.values.end());
+		floats.insert(floats.end(), other.floats.begin(), other.floats.end());
+	} else {
+		values.insert(values.end(), other.values.begin(), other.values.end());
+		values.insert(values.end(), other.floats.begin(), other.floats.end());
+	}
+	for(vector<size_t>::const_iterator it = other.offsets.begin() + 1;
+			it != other.offsets.end(); it++) {
+		offsets.push_back(base + *it);
+	}
+}
+
+/** Deletes all rows after the first few.
+ *
+ * @param[in] nRows The number of rows to keep.
+ *
+ * @post size() = min(old size(), @p nRows), and the remaining rows
+ *	are unchanged.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void RaggedArray::truncate(size_t nRows) {
+	if (nRows < size()) {
+		// Erasing numbers from the end of a vector never throws
+		if (precision == SINGLE_PRECISION) {
+			floats.erase(floats.begin() + offsets[nRows], floats.end());
+		} else {
+			values.erase(values.begin() + offsets[nRows], values.end());
+		}
+		offsets.erase(offsets.begin() + nRows + 1, offsets.end());
+	}
+}
+
+/** Deletes all rows.
+ *
+ * @post size() = 0
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void RaggedArray::clear() {
+	truncate(0);
+}
+
+/** Returns the heap memory reserved by the array.
+ *
+ * @return The number of bytes allocated for the values and row 
+ *	boundaries, including space reserved for rows not yet added.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t RaggedArray::memoryBytes() const {
+	return values.capacity()*sizeof(double) + floats.capacity()*sizeof(float) 
+		+ offsets.capacity()*sizeof(size_t);
+}
+
+/** Non-throwing swap
+ *
+ * @param[in,out] other The array with which to exchange contents.
+ *
+ * @post The rows previously contained in @p other are now stored in
+ *	@p *this, and vice versa. The precisions are exchanged as well.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void RaggedArray::swap(RaggedArray& other) {
+	using std::swap;
+
+	swap(this->precision, other.precision);
+	swap(this->values   , other.values   );
+	swap(this->floats   , other.floats   );
+	swap(this->offsets  , other.offsets  );
+}
+
+/** Non-throwing swap
+ *
+ * @param[in,out] a,b The arrays to exchange contents.
+ *
+ * @post The rows previously contained in @p a are now stored in @p b, 
+ *	and vice versa.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void swap(RaggedArray& a, RaggedArray& b) {
+	a.swap(b);
+}
+
+}}		// end lcmc::stats
+
+namespace std {
+
+template <>
+void swap<lcmc::stats::RaggedArray>(lcmc::stats::RaggedArray& a, 
+		lcmc::stats::RaggedArray& b) {
+	a.swap(b);
+}
+
+}
@@ -0,0 +1,138 @@
+/** Contiguous storage for sequences of variable-length vectors
+ * @file lightcurveMC/stats/raggedarray.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCRAGGEDH
+#define LCMCRAGGEDH
+
+#include <vector>
+#include <cstddef>
+
+namespace lcmc { namespace stats {
+
+using std::vector;
+
+/** Identifies how the values of a RaggedArray are stored
+ */
+enum ValuePrecision {
+	/** Values are stored exactly, as doubles
+	 */
+	DOUBLE_PRECISION, 
+	/** Values are rounded to floats, in half the memory
+	 */
+	SINGLE_PRECISION
+};
+
+/** Stores a sequence of vectors of doubles, each of arbitrary length,
+ *	in a single buffer.
+ *
+ * The values of all rows are stored end to end, with a separate index
+ * giving where each row starts. Adding a row therefore costs one
+ * amortized copy rather than a new allocation, and the rows can be read
+ * in order with a single linear scan.
+ *
+ * An array created with SINGLE_PRECISION rounds each value to a float 
+ * as it is added. Its rows are read with floatRowBegin() and 
+ * floatRowEnd() instead of rowBegin() and rowEnd().
+ *
+ * @invariant <tt>offsets.size() = size() + 1</tt>
+ * @invariant <tt>offsets.front() = 0</tt>, <tt>offsets.back()</tt> 
+ *	equals <tt>values.size()</tt> for DOUBLE_PRECISION and 
+ *	<tt>floats.size()</tt> for SINGLE_PRECISION
+ * @invariant Only the buffer matching the precision is nonempty.
+ */
+class RaggedArray {
+public:
+	/** Creates an array with no rows.
+	 */
+	explicit RaggedArray(ValuePrecision precision = DOUBLE_PRECISION);
+
+	/** Returns how the values of the array are stored.
+	 */
+	ValuePrecision getPrecision() const;
+
+	/** Returns the number of rows in the array.
+	 */
+	size_t size() const;
+
+	/** Returns the number of values in a row.
+	 */
+	size_t rowSize(size_t row) const;
+
+	/** Returns the heap memory reserved by the array.
+	 */
+	size_t memoryBytes() const;
+
+	/** Returns a pointer to the first value in a row.
+	 */
+	const double* rowBegin(size_t row) const;
+
+	/** Returns a pointer past the last value in a row.
+	 */
+	const double* rowEnd(size_t row) const;
+
+	/** Returns a pointer to the first value in a row stored in 
+	 *	single precision.
+	 */
+	const float* floatRowBegin(size_t row) const;
+
+	/** Returns a pointer past the last value in a row stored in 
+	 *	single precision.
+	 */
+	const float* floatRowEnd(size_t row) const;
+
+	/** Adds a row to the end of the array.
+	 */
+	void push_back(const vector<double>& row);
+
+	/** Adds a row to the end of the array.
+	 */
+	void push_back(const double* begin, const double* end);
+
+	/** Adds selected elements of a vector as a row at the end of
+	 *	the array.
+	 */
+	void push_back(const vector<double>& source, const vector<size_t>& indices);
+
+	/** Adds all the rows of another array to the end of this one.
+	 */
+	void append(const RaggedArray& other);
+
+	/** Deletes all rows after the first few.
+	 */
+	void truncate(size_t nRows);
+
+	/** Deletes all rows.
+	 */
+	void clear();
+
+	/** Non-throwing swap
+	 */
+	void swap(RaggedArray& other);
+
+private:
+	ValuePrecision precision;
+	vector<double> values;
+	vector<float> floats;
+	vector<size_t> offsets;
+};
+
+/** Non-throwing swap
+ */
+void swap(RaggedArray& a, RaggedArray& b);
+
+}}		// end lcmc::stats
+
+// Template overrides for clients that (incorrectly) call std::swap
+namespace std {
+
+template <>
+void swap<lcmc::stats::RaggedArray>(lcmc::stats::RaggedArray& a, 
+		lcmc::stats::RaggedArray& b);
+
+}		// end std
+
+#endif		// End ifndef LCMCRAGGEDH
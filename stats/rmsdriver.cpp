@@ -0,0 +1,123 @@
+/** Calculates RMS-timescale statistics
+ * @file lightcurveMC/stats/rmsdriver.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vector>
+#include <cmath>
+#include "experimental.h"
+#include "scratch.h"
+#include "statcollect.h"
+#include "statfamilies.h"
+#include "../except/undefined.h"
+
+namespace lcmc { namespace stats {
+
+using std::vector;
+
+/** Does all RMS-related computations for a given light curve.
+ *
+ * @param[in] lc The light curve to analyze.
+ * @param[in] getRooted Flag indicating that the RMS of the light curve 
+ *	from its first observation to each later one should be stored
+ * @param[in] getPairs Flag indicating that the median RMS over all 
+ *	subintervals of the light curve, binned by length, should be stored
+ * @param[out] rooted The NamedCollection in which to record the RMS 
+ *	as a function of time since the first observation.
+ * @param[out] pairs The NamedCollection in which to record the median 
+ *	RMS as a function of subinterval length.
+ *
+ * @post if @p getRooted, then a new element is appended to @p rooted.
+ * @post if @p getPairs, then a new element is appended to @p pairs, 
+ *	unless the light curve has no time baseline.
+ *
+ * @perform O(N) time for @p rooted and O(N<sup>2</sup>) time for 
+ *	@p pairs, where N is the number of observations.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store more statistics.
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p lc 
+ *	is too short to calculate the desired statistics.
+ *
+ * @exceptsafe The collections are unchanged in the event of an exception.
+ */
+void doRms(const AnalysisContext& lc, bool getRooted, bool getPairs, 
+		CollectedPairs& rooted, CollectedPairs& pairs) {
+	// The cadence is already sorted, so the RMS functions need not 
+	//	check it again
+	const models::Cadence& times = lc.getCadence();
+	const vector<double>& mags = lc.getMags();
+
+	if (getRooted || getPairs) {
+		if (times.size() < 2) {
+			throw except::NotEnoughData("Cannot calculate RMS with fewer than 2 data points.");
+		}
+		
+		// Checkpoints let us undo a partial update without copying 
+		//	the statistics from all previous light curves
+		const size_t markRooted = rooted.checkpoint();
+		const size_t markPairs  = pairs .checkpoint();
+		
+		try {
+			if (getRooted) {
+				ScratchVector stepBuffer, rmsBuffer;
+				DoubleVec& steps = stepBuffer.get();
+				DoubleVec& rms   = rmsBuffer .get();
+				rmsVsTRooted(times, mags, steps, rms);
+				rooted.addStat(steps, rms);
+			}
+			
+			const double baseline = lc.getBaseline();
+			if (getPairs && baseline > 0) {
+				// Same grid as the dmdt plots, for easy comparison
+				double minBin = -1.97;
+				double maxBin = log10(baseline);
+				
+				ScratchVector edgeBuffer;
+				DoubleVec& binEdges = edgeBuffer.get();
+				for (double bin = minBin; bin < maxBin; bin += 0.15) {
+					binEdges.push_back(pow(10.0,bin));
+				}
+				// Get the bin containing maxBin as well
+				binEdges.push_back(pow(10.0,maxBin));
+				
+				ScratchVector medianBuffer;
+				DoubleVec& medians = medianBuffer.get();
+				rmsVsTBinned(times, mags, binEdges, medians);
+				pairs.addStat(binEdges, medians);
+			}
+		} catch (...) {
+			// Leave the collections as they were before the call
+			rooted.rollback(markRooted);
+			pairs .rollback(markPairs );
+			throw;
+		}
+	}
+}
+
+}}	// end lcmc::stats
@@ -0,0 +1,275 @@
+/** Summary statistics that do not require storing the data
+ * @file lightcurveMC/stats/runningstats.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <limits>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include "runningstats.h"
+#include "../../common/cerror.h"
+#include "../../common/fileio.h"
+#include "../../common/nan.h"
+
+namespace lcmc { namespace stats {
+
+/** Creates an accumulator that has seen no values.
+ *
+ * @post count() = 0
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+RunningStats::RunningStats() : nTotal(0), nFinite(0), nPosInf(0), nNegInf(0),
+		runMean(0.0), runSumSqDev(0.0), runSumSq(0.0) {
+}
+
+/** Incorporates a value into the summary.
+ *
+ * @param[in] value The value to add.
+ *
+ * @pre @p value may be NaN or infinite
+ *
+ * @post The summary describes all the values previously added,
+ *	plus @p value.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void RunningStats::add(double value) {
+	nTotal++;
+
+	if (kpfutils::isNan(value)) {
+		return;
+	}
+
+	runSumSq += value*value;
+
+	if (kpfutils::isNanOrInf(value)) {
+		if (value > 0) {
+			nPosInf++;
+		} else {
+			nNegInf++;
+		}
+	} else {
+		nFinite++;
+		const double delta = value - runMean;
+		runMean     += delta / nFinite;
+		runSumSqDev += delta * (value - runMean);
+	}
+}
+
+/** Incorporates all the values summarized by another accumulator.
+ *
+ * @param[in] other The accumulator to combine with this one.
+ *
+ * @pre @p other may be the same object as @p *this
+ *
+ * @post The summary describes all the values previously added,
+ *	plus all the values added to @p other.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void RunningStats::merge(const RunningStats& other) {
+	// Copy in case other is *this
+	const RunningStats that = other;
+
+	if (that.nFinite > 0) {
+		const double nA    = static_cast<double>(nFinite);
+		const double nB    = static_cast<double>(that.nFinite);
+		const double delta = that.runMean - runMean;
+
+		runMean     += delta * nB / (nA + nB);
+		runSumSqDev += that.runSumSqDev + delta*delta * nA*nB / (nA + nB);
+	}
+
+	nTotal   += that.nTotal;
+	nFinite  += that.nFinite;
+	nPosInf  += that.nPosInf;
+	nNegInf  += that.nNegInf;
+	runSumSq += that.runSumSq;
+}
+
+/** Returns the number of values summarized.
+ *
+ * @return The number of calls to add(), including calls with NaN,
+ *	plus the counts of any merged accumulators.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t RunningStats::count() const {
+	return nTotal;
+}
+
+/** Returns the sum of the squares of all values that are not NaN.
+ *
+ * @return The sum of squares, or 0 if every value was NaN.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double RunningStats::sumSquares() const {
+	return runSumSq;
+}
+
+/** Returns the standard error of the mean, as a fraction of the mean
+ *
+ * @return The standard deviation of the values divided by the square 
+ *	root of their number and by the absolute value of their mean. 
+ *	Infinity if the values include infinities or the mean is zero. 
+ *	NaN if there are less than two finite values.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double RunningStats::relativeError() const {
+	if (nFinite < 2) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	if (nPosInf > 0 || nNegInf > 0 || runMean == 0.0) {
+		return std::numeric_limits<double>::infinity();
+	}
+	
+	const double stddev = sqrt(runSumSqDev / (nFinite - 1));
+	return stddev / sqrt(static_cast<double>(nFinite)) / fabs(runMean);
+}
+
+/** Calculates the mean, standard deviation, and definition rate
+ *	of the values
+ *
+ * The results are the same as those of
+ * @ref lcmc::stats::getSummaryStats() "getSummaryStats()" applied to
+ * the values, up to rounding error.
+ *
+ * @param[out] mean The mean of the values.
+ * @param[out] stddev The standard deviation of the values.
+ * @param[out] goodFrac The fraction of values that are finite.
+ * @param[in] statName The name of the statistic, for error messages.
+ *
+ * @post @p mean and @p stddev ignore any NaNs.
+ * @post If there are no non-NaN values, @p mean equals NaN
+ * @post If there are less than two non-NaN values, @p stddev equals NaN
+ * @post If there are no values, @p goodFrac equals 0
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void RunningStats::getSummary(double& mean, double& stddev, double& goodFrac,
+		const string& statName) const {
+	const size_t nClean = nFinite + nPosInf + nNegInf;
+
+	goodFrac = (nTotal > 0 ? static_cast<double>(nFinite)/nTotal : 0.0);
+	getMoments(mean, stddev);
+
+	if (nClean < 1) {
+		fprintf(stderr, "WARNING: %s summary: Not enough data to calculate a mean.\n",
+			statName.c_str());
+	} else if (nClean < 2) {
+		fprintf(stderr, "WARNING: %s summary: Not enough data to calculate a variance.\n",
+			statName.c_str());
+	}
+}
+
+/** Calculates the mean and standard deviation of the values, 
+ *	without warnings
+ *
+ * Collections that summarize many values at once, such as every point 
+ * of a periodogram, use this form so that sparsely defined points 
+ * do not flood the error stream.
+ *
+ * @param[out] mean The mean of the values.
+ * @param[out] stddev The standard deviation of the values.
+ *
+ * @post @p mean and @p stddev are the same as those calculated by 
+ *	getSummary().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void RunningStats::getMoments(double& mean, double& stddev) const {
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	const double inf = std::numeric_limits<double>::infinity();
+	const size_t nClean = nFinite + nPosInf + nNegInf;
+
+	mean   = nan;
+	stddev = nan;
+
+	if (nClean < 1) {
+		return;
+	}
+	if (nPosInf > 0 && nNegInf > 0) {
+		mean = nan;
+	} else if (nPosInf > 0) {
+		mean = inf;
+	} else if (nNegInf > 0) {
+		mean = -inf;
+	} else {
+		mean = runMean;
+	}
+
+	if (nClean < 2) {
+		return;
+	}
+	// Infinite values have undefined variance
+	if (nPosInf == 0 && nNegInf == 0) {
+		stddev = sqrt(runSumSqDev / (nFinite - 1));
+	}
+}
+
+/** Saves the summary to a text file
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ *
+ * @post The summary is written on the current line of @p file, in a 
+ *	form that readState() restores exactly. No newline is written.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the summary could not 
+ *	be written.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void RunningStats::writeState(FILE* const file) const {
+	// %.17g preserves every bit of a double
+	if (fprintf(file, " %lu %lu %lu %lu %.17g %.17g %.17g", 
+			static_cast<unsigned long>(nTotal), 
+			static_cast<unsigned long>(nFinite), 
+			static_cast<unsigned long>(nPosInf), 
+			static_cast<unsigned long>(nNegInf), 
+			runMean, runSumSqDev, runSumSq) < 0) {
+		kpfutils::fileError(file, "Could not save summary in writeState(): ");
+	}
+}
+
+/** Restores a summary saved by writeState()
+ *
+ * @param[in] file An open file handle positioned at the text written 
+ *	by writeState().
+ *
+ * @post The object summarizes the same values as the object that 
+ *	wrote the text, and @p file is positioned after the text.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p file does not 
+ *	contain a saved summary.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void RunningStats::readState(FILE* const file) {
+	unsigned long total, finite, posInf, negInf;
+	double mean, sumSqDev, sumSq;
+	if (fscanf(file, "%lu %lu %lu %lu %lf %lf %lf", &total, &finite, 
+			&posInf, &negInf, &mean, &sumSqDev, &sumSq) != 7) {
+		throw kpfutils::except::FileIo("Misformatted saved state: expected a summary of statistics.");
+	}
+	
+	nTotal      = total;
+	nFinite     = finite;
+	nPosInf     = posInf;
+	nNegInf     = negInf;
+	runMean     = mean;
+	runSumSqDev = sumSqDev;
+	runSumSq    = sumSq;
+}
+
+}}		// end lcmc::stats
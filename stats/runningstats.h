@@ -0,0 +1,81 @@
+/** Summary statistics that do not require storing the data
+ * @file lightcurveMC/stats/runningstats.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCRUNSTATSH
+#define LCMCRUNSTATSH
+
+#include <string>
+#include <cstdio>
+
+namespace lcmc { namespace stats {
+
+using std::string;
+
+/** Accumulates the mean, variance, and definition rate of a sequence of
+ *	values without storing the values themselves.
+ *
+ * The mean and variance are updated using Welford's algorithm, and two
+ * accumulators can be combined using the method of Chan, Golub, & LeVeque
+ * (1979), so partial results from several threads may be merged.
+ */
+class RunningStats {
+public:
+	/** Creates an accumulator that has seen no values.
+	 */
+	RunningStats();
+
+	/** Incorporates a value into the summary.
+	 */
+	void add(double value);
+
+	/** Incorporates all the values summarized by another accumulator.
+	 */
+	void merge(const RunningStats& other);
+
+	/** Returns the number of values summarized.
+	 */
+	size_t count() const;
+
+	/** Returns the sum of the squares of all values that are not NaN.
+	 */
+	double sumSquares() const;
+
+	/** Returns the standard error of the mean, as a fraction of the mean
+	 */
+	double relativeError() const;
+
+	/** Calculates the mean, standard deviation, and definition rate
+	 *	of the values
+	 */
+	void getSummary(double& mean, double& stddev, double& goodFrac,
+		const string& statName) const;
+	/** Calculates the mean and standard deviation of the values, 
+	 *	without warnings
+	 */
+	void getMoments(double& mean, double& stddev) const;
+
+	/** Saves the summary to a text file
+	 */
+	void writeState(FILE* const file) const;
+
+	/** Restores a summary saved by writeState()
+	 */
+	void readState(FILE* const file);
+
+private:
+	size_t nTotal;
+	size_t nFinite;
+	size_t nPosInf;
+	size_t nNegInf;
+	double runMean;
+	double runSumSqDev;
+	double runSumSq;
+};
+
+}}		// end lcmc::stats
+
+#endif		// End ifndef LCMCRUNSTATSH
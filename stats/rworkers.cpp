@@ -0,0 +1,533 @@
+/** Pool of separate R processes for fitting Gaussian Process models
+ * @file lightcurveMC/stats/rworkers.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include "../../common/nan.h"
+#include "../except/undefined.h"
+#include "deadline.h"
+#include "gpfit.h"
+
+namespace lcmc { namespace stats {
+
+using std::string;
+using std::vector;
+using boost::lexical_cast;
+using boost::shared_ptr;
+
+/** The program run by each worker
+ *
+ * The worker reads requests from standard input, each consisting of a
+ * line with the number of points and the three starting parameters in
+ * gptk's log form (NA for the gptk defaults), a line of times, and a line
+ * of data. It replies to each request with a single line, either "OK"
+ * followed by the timescale, its error, the signal variance, and the
+ * noise variance, or "ERROR" followed by a message.
+ * The fit is the same as in fitGaussGpR().
+ */
+const char R_WORKER_SCRIPT[] =
+	"suppressMessages(library(gptk)); suppressMessages(library(numDeriv)); "
+	"options(warn = 2); "
+	"input <- file('stdin', 'r'); "
+	"repeat { "
+	"  header <- readLines(input, n = 1); "
+	"  if (length(header) == 0) break; "
+	"  reply <- tryCatch({ "
+	"    fields <- strsplit(header, ' ')[[1]]; "
+	"    n <- as.integer(fields[1]); "
+	"    start0 <- suppressWarnings(as.numeric(fields[2:4])); "
+	"    times <- scan(input, nlines = 1, quiet = TRUE); "
+	"    data  <- scan(input, nlines = 1, quiet = TRUE); "
+	"    if (length(times) != n || length(data) != n) stop('malformed request'); "
+	"    gpSettings <- gpOptions('ftc'); "
+	"    gpSettings$optimiser <- 'CG'; "
+	"    gpSettings$kern$type <- 'cmpnd'; "
+	"    gpSettings$kern$comp <- list('rbf', 'white'); "
+	"    gpSettings$scaleVal <- sd(data); "
+	"    model <- gpCreate(1, 1, as.matrix(times), as.matrix(data), gpSettings); "
+	"    start <- gpExtractParam(model); "
+	"    start[!is.na(start0)] <- start0[!is.na(start0)]; "
+	"    model <- gpExpandParam(model, start); "
+	"    model <- gpOptimise(model, 0, 1.1*length(times)); "
+	"    tau <- 1.0/sqrt(model$kern$comp[[1]]$inverseWidth); "
+	"    hess <- jacobian(function(p) {gpGradient(p, model)}, gpExtractParam(model)); "
+	"    if (!isSymmetric(hess, tol=1e-4)) stop('Hessian matrix is asymmetric. This probably means the fit is not a local likelihood maximum.'); "
+	"    covar <- solve(hess); "
+	"    err <- 0.5 * sqrt(covar[1,1]) * tau; "
+	"    sprintf('OK %.17g %.17g %.17g %.17g', tau, err, "
+	"      model$kern$comp[[1]]$variance, model$kern$comp[[2]]$variance) "
+	"  }, error = function(e) paste('ERROR', gsub('\\n', ' ', conditionMessage(e)))); "
+	"  cat(reply, '\\n', sep = ''); "
+	"  flush(stdout()); "
+	"}";
+
+/** RWorker is a persistent R process connected to this one by pipes.
+ *
+ * @invariant If @p toR is not null, it and @p fromR are connected to
+ *	the standard input and output of a running worker @p pid.
+ */
+class RWorker {
+public:
+	/** Starts a worker
+	 *
+	 * @exception std::runtime_error Thrown if the process could not
+	 *	be started.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	RWorker() : pid(-1), toR(NULL), fromR(NULL) {
+		start();
+	}
+
+	/** Stops the worker, waiting for it to finish any request in
+	 *	progress
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	~RWorker() {
+		stop();
+	}
+
+	/** Fits a light curve in the worker
+	 *
+	 * @param[in] times The times at which the light curve was sampled.
+	 * @param[in] data The values of the light curve.
+	 * @param[in] startParams The hyperparameters from which to start the fit.
+	 *	NaN members start from the gptk defaults.
+	 * @param[out] best The best-fit hyperparameters
+	 * @param[out] timeError The estimated uncertainty on the model timescale
+	 *
+	 * @pre @p times.size() = @p data.size()
+	 *
+	 * @post If the worker could not be reached, it has been restarted.
+	 *
+	 * @post If the fit ran past the current thread's StatDeadline,
+	 *	the worker has been killed and will be restarted on the
+	 *	next fit.
+	 *
+	 * @exception std::runtime_error Thrown if the fit failed, or if
+	 *	the worker could not be reached.
+	 * @exception lcmc::stats::except::TimedOut Thrown if the fit ran
+	 *	past the current thread's StatDeadline.
+	 *
+	 * @exceptsafe The function arguments are unchanged in the event
+	 *	of an exception.
+	 */
+	void fit(const vector<double>& times, const vector<double>& data,
+			const GpParams& startParams, GpParams& best, double& timeError) {
+		if (toR == NULL) {
+			start();
+		}
+
+		// Parameters are ln(1/tau^2), ln(amp^2), ln(noise^2), in that order
+		double logStart[3];
+		logStart[0] = -2.0*log(startParams.timescale);
+		logStart[1] = log(startParams.variance);
+		logStart[2] = log(startParams.noise);
+		bool sent = fprintf(toR, "%lu", static_cast<unsigned long>(times.size())) >= 0;
+		for(size_t i = 0; sent && i < 3; i++) {
+			sent = (kpfutils::isNan(logStart[i])
+				? fprintf(toR, " NA")
+				: fprintf(toR, " %.17g", logStart[i])) >= 0;
+		}
+		sent = sent && (fputc('\n', toR) != EOF);
+		for(size_t i = 0; sent && i < times.size(); i++) {
+			sent = (fprintf(toR, "%.17g ", times[i]) >= 0);
+		}
+		sent = sent && (fputc('\n', toR) != EOF);
+		for(size_t i = 0; sent && i < data.size(); i++) {
+			sent = (fprintf(toR, "%.17g ", data[i]) >= 0);
+		}
+		sent = sent && (fputc('\n', toR) != EOF) && (fflush(toR) == 0);
+
+		if (sent && !replyBy(deadlineRemaining())) {
+			// R can't be interrupted mid-fit, so the only way to
+			//	get the worker back is to replace it
+			kill(pid, SIGKILL);
+			stop();
+			throw except::TimedOut("In fitGaussGpR(), R worker took longer than "
+				+ lexical_cast<string>(getStatBudget()) + " seconds.");
+		}
+
+		string reply;
+		char buffer[256];
+		while (sent && fgets(buffer, sizeof(buffer), fromR) != NULL) {
+			reply += buffer;
+			if (!reply.empty() && reply[reply.size()-1] == '\n') {
+				break;
+			}
+		}
+		if (reply.empty() || reply[reply.size()-1] != '\n') {
+			// Worker died or is wedged; don't reuse it
+			stop();
+			throw std::runtime_error("In fitGaussGpR(), lost contact with R worker process.");
+		}
+
+		if (reply.compare(0, 3, "OK ") != 0) {
+			throw std::runtime_error("In fitGaussGpR(), "
+				+ reply.substr(0, reply.size()-1));
+		}
+		char* end = NULL;
+		const double tempTime = strtod(reply.c_str() + 3, &end);
+		const double tempErr  = strtod(end, &end);
+		const double tempVar  = strtod(end, &end);
+		const double tempNoise = strtod(end, NULL);
+		// R will format NAs as "NA", which strtod() reads as 0
+		if (kpfutils::isNan(tempTime) || !(tempTime > 0.0)) {
+			throw std::runtime_error("In fitGaussGpR(), code ran successfully, but time scale was NA");
+		}
+		if (kpfutils::isNan(tempErr) || !(tempErr > 0.0)) {
+			throw std::runtime_error("In fitGaussGpR(), found a time scale, but time scale error was NA");
+		}
+
+		// IMPORTANT: no exceptions beyond this point
+
+		best.timescale = tempTime;
+		best.variance  = tempVar;
+		best.noise     = tempNoise;
+		timeError = tempErr;
+	}
+
+private:
+	// Workers own processes, and cannot be copied
+	RWorker(const RWorker&);
+	RWorker& operator=(const RWorker&);
+
+	/** Waits for the worker to start replying
+	 *
+	 * @param[in] seconds The longest time to wait, or infinity to
+	 *	wait indefinitely.
+	 *
+	 * @return False if the worker has not written anything after
+	 *	@p seconds, true otherwise.
+	 *
+	 * @pre A process is running
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool replyBy(double seconds) const {
+		if (seconds > 1e-3 * INT_MAX) {
+			return true;
+		}
+		const int timeout = (seconds > 0.0 ? static_cast<int>(ceil(1e3 * seconds)) : 0);
+
+		struct pollfd reply;
+		reply.fd      = fileno(fromR);
+		reply.events  = POLLIN;
+		reply.revents = 0;
+		int status;
+		do {
+			status = poll(&reply, 1, timeout);
+		} while (status < 0 && errno == EINTR);
+		// Let the read report any error other than a timeout
+		return status != 0;
+	}
+
+	/** Launches the R process
+	 *
+	 * @pre No process is running
+	 * @post @p pid, @p toR, and @p fromR refer to a new worker
+	 *
+	 * @exception std::runtime_error Thrown if the process could not
+	 *	be started.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception.
+	 */
+	void start() {
+		int request[2], response[2];
+		if (pipe(request) != 0) {
+			throw std::runtime_error(string("Could not start R worker: ")
+				+ strerror(errno));
+		}
+		if (pipe(response) != 0) {
+			const int err = errno;
+			close(request[0]);
+			close(request[1]);
+			throw std::runtime_error(string("Could not start R worker: ")
+				+ strerror(err));
+		}
+		// Don't let later workers inherit this worker's pipes, or it
+		//	will never see the end of its input
+		fcntl(request [1], F_SETFD, FD_CLOEXEC);
+		fcntl(response[0], F_SETFD, FD_CLOEXEC);
+
+		const pid_t child = fork();
+		if (child == 0) {
+			// Only async-signal-safe calls are allowed before exec,
+			//	since the parent may have other threads
+			dup2(request [0], STDIN_FILENO);
+			dup2(response[1], STDOUT_FILENO);
+			close(request [0]);
+			close(request [1]);
+			close(response[0]);
+			close(response[1]);
+			execlp("Rscript", "Rscript", "--vanilla", "-e", R_WORKER_SCRIPT,
+				static_cast<char*>(NULL));
+			_exit(127);
+		}
+		const int forkErr = errno;
+		close(request [0]);
+		close(response[1]);
+		if (child < 0) {
+			close(request [1]);
+			close(response[0]);
+			throw std::runtime_error(string("Could not start R worker: ")
+				+ strerror(forkErr));
+		}
+
+		FILE* const tempTo   = fdopen(request [1], "w");
+		FILE* const tempFrom = fdopen(response[0], "r");
+		if (tempTo == NULL || tempFrom == NULL) {
+			if (tempTo != NULL) {
+				fclose(tempTo);
+			} else {
+				close(request[1]);
+			}
+			if (tempFrom != NULL) {
+				fclose(tempFrom);
+			} else {
+				close(response[0]);
+			}
+			waitpid(child, NULL, 0);
+			throw std::runtime_error("Could not connect to R worker.");
+		}
+
+		// IMPORTANT: no exceptions beyond this point
+
+		pid   = child;
+		toR   = tempTo;
+		fromR = tempFrom;
+	}
+
+	/** Ends the R process
+	 *
+	 * @post No process is running
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void stop() {
+		if (toR != NULL) {
+			// Closing the worker's input ends its loop
+			fclose(toR);
+			fclose(fromR);
+			waitpid(pid, NULL, 0);
+		}
+		pid   = -1;
+		toR   = NULL;
+		fromR = NULL;
+	}
+
+	/** The process ID of the worker */
+	pid_t pid;
+	/** The worker's standard input */
+	FILE* toR;
+	/** The worker's standard output */
+	FILE* fromR;
+};
+
+/** RWorkerPool hands out idle workers to the threads that need them.
+ */
+class RWorkerPool {
+public:
+	/** Starts a pool of workers
+	 *
+	 * @param[in] nWorkers The number of workers to start.
+	 *
+	 * @pre @p nWorkers > 0
+	 *
+	 * @exception std::runtime_error Thrown if the workers could not
+	 *	be started.
+	 * @exception std::bad_alloc Thrown if there is not enough memory
+	 *	for the pool.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	explicit RWorkerPool(size_t nWorkers) : workers(), idle(), lock(),
+			freed() {
+		// A worker that dies mid-request must produce an error,
+		//	not kill the program
+		signal(SIGPIPE, SIG_IGN);
+
+		for(size_t i = 0; i < nWorkers; i++) {
+			workers.push_back(shared_ptr<RWorker>(new RWorker()));
+			idle.push_back(i);
+		}
+	}
+
+	/** Fits a light curve in the next available worker
+	 *
+	 * @param[in] times The times at which the light curve was sampled.
+	 * @param[in] data The values of the light curve.
+	 * @param[in] start The hyperparameters from which to start the fit.
+	 *	NaN members start from the gptk defaults.
+	 * @param[out] best The best-fit hyperparameters
+	 * @param[out] timeError The estimated uncertainty on the model timescale
+	 *
+	 * @perform Blocks until a worker is free.
+	 *
+	 * @exception std::runtime_error Thrown if the fit failed.
+	 *
+	 * @exceptsafe The function arguments are unchanged in the event
+	 *	of an exception.
+	 */
+	void fit(const vector<double>& times, const vector<double>& data,
+			const GpParams& start, GpParams& best, double& timeError) {
+		const Checkout worker(*this);
+		workers[worker.index]->fit(times, data, start, best, timeError);
+	}
+
+private:
+	/** Checkout reserves a worker for the lifetime of the object.
+	 */
+	class Checkout {
+	public:
+		/** Waits for an idle worker and reserves it
+		 *
+		 * @exceptsafe Does not throw exceptions.
+		 */
+		explicit Checkout(RWorkerPool& pool) : pool(pool), index(0) {
+			boost::unique_lock<boost::mutex> guard(pool.lock);
+			while (pool.idle.empty()) {
+				pool.freed.wait(guard);
+			}
+			index = pool.idle.back();
+			pool.idle.pop_back();
+		}
+
+		/** Returns the worker to the pool
+		 *
+		 * @exceptsafe Does not throw exceptions.
+		 */
+		~Checkout() {
+			{
+				boost::lock_guard<boost::mutex> guard(pool.lock);
+				// Cannot throw, since capacity is never exceeded
+				pool.idle.push_back(index);
+			}
+			pool.freed.notify_one();
+		}
+
+		/** The pool owning the worker */
+		RWorkerPool& pool;
+		/** The index of the worker in @p pool.workers */
+		size_t index;
+
+	private:
+		Checkout(const Checkout&);
+		Checkout& operator=(const Checkout&);
+	};
+
+	/** The workers, in any state */
+	vector<shared_ptr<RWorker> > workers;
+	/** The indices of the workers not currently fitting a light curve */
+	vector<size_t> idle;
+	/** Protects @p idle */
+	boost::mutex lock;
+	/** Signaled whenever a worker is returned to @p idle */
+	boost::condition_variable freed;
+};
+
+/** Returns the number of workers requested with setRWorkers()
+ *
+ * @return A modifiable reference to the number of workers.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& rWorkerCount() {
+	static long count = 0;
+	return count;
+}
+
+/** Fits Gaussian process models in separate R processes
+ *
+ * @param[in] nWorkers The number of R processes to use, or 0 to fit
+ *	models in the embedded R interpreter.
+ *
+ * @post If @p nWorkers > 0, fitGaussGpR() sends light curves to a
+ *	pool of @p nWorkers R processes, started on the first fit, so
+ *	that up to @p nWorkers fits can run at once. Each process loads
+ *	gptk and numDeriv only once.
+ *
+ * @exception std::invalid_argument Thrown if @p nWorkers < 0.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ *
+ * @note Must be called before the first call to fitGaussGpR().
+ */
+void setRWorkers(long nWorkers) {
+	if (nWorkers < 0) {
+		throw std::invalid_argument("Number of R workers must be nonnegative (gave "
+			+ lexical_cast<string>(nWorkers) + ").");
+	}
+	rWorkerCount() = nWorkers;
+}
+
+/** Fits a squared exponential Gaussian process model in an R worker
+ *	process, if any were requested
+ *
+ * @param[in] times The times at which the light curve was sampled.
+ * @param[in] data The values of the light curve.
+ * @param[in] start The hyperparameters from which to start the fit.
+ *	NaN members start from the gptk defaults.
+ * @param[out] best The best-fit hyperparameters
+ * @param[out] timeError The estimated uncertainty on the model timescale
+ *
+ * @return True if the fit was done by a worker, false if setRWorkers()
+ *	was not called with a positive count.
+ *
+ * @pre @p times.size() = @p data.size() &ge; 2
+ *
+ * @perform Blocks until a worker is free. Calls from different
+ *	threads run in parallel on different workers.
+ *
+ * @exception std::runtime_error Thrown if the workers could not be
+ *	started or the fit failed.
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	start the workers.
+ *
+ * @exceptsafe The function arguments are unchanged in the event
+ *	of an exception.
+ */
+bool fitInRWorker(const vector<double>& times, const vector<double>& data,
+		const GpParams& start, GpParams& best, double& timeError) {
+	if (rWorkerCount() <= 0) {
+		return false;
+	}
+
+	// Workers are started on first use, so that runs without
+	//	GP statistics don't pay for them
+	static boost::mutex poolLock;
+	static shared_ptr<RWorkerPool> pool;
+	{
+		boost::lock_guard<boost::mutex> guard(poolLock);
+		if (pool.get() == NULL) {
+			pool.reset(new RWorkerPool(static_cast<size_t>(rWorkerCount())));
+		}
+	}
+
+	pool->fit(times, data, start, best, timeError);
+	return true;
+}
+
+}}		// end lcmc::stats
@@ -2,38 +2,109 @@
  * @file lightcurveMC/stats/scalars.cpp
  * @author Krzysztof Findeisen
  * @date Reconstructed June 7, 2013
- * @date Last modified August 6, 2013
+ * @date Last modified October 14, 2026
  */
 
+#include <algorithm>
 #include <limits>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <boost/lexical_cast.hpp>
 #include "../mcio.h"
+#include "columns.h"
 #include "output.h"
+#include "quantilesketch.h"
+#include "runningstats.h"
 #include "statcollect.h"
 #include "../../common/cerror.h"
+#include "../../common/fileio.h"
+#include "../../common/nan.h"
 
 namespace lcmc { namespace stats {
 
 using std::string;
 using std::vector;
 
+namespace {
+
+/** The number of most recent values that rollback() can always remove. 
+ * Values wait in a buffer of twice this size before entering the sketch.
+ */
+const size_t SKETCH_DELAY = 64;
+
+}	// end unnamed namespace
+
 /** Constructs a collection of statistics.
  *
  * @param[in] statName The name of the statistic to use in program output.
  * @param[in] distribFile The prefix identifying the distribution file as 
  *	being for this particular statistic.
+ * @param[in] storeDistrib If true, every statistic is stored so that 
+ *	its distribution can be printed. If false, only a running summary 
+ *	is kept, and the memory used by the object does not grow with the 
+ *	number of statistics.
  *
  * @post The object represents an empty set of statistics.
+ * @post The quantile sketch uses the level size given by getSketchSize().
  *
  * @exception std::bad_alloc Thrown if there is not enough memory 
  *	to construct the object.
  *
  * @exceptsafe Object construction is atomic.
  */
-CollectedScalars::CollectedScalars(const std::string& statName, const std::string& distribFile) 
-		: NamedCollection(statName, distribFile), stats() {
+CollectedScalars::CollectedScalars(const std::string& statName, const std::string& distribFile, 
+		bool storeDistrib) 
+		: NamedCollection(statName, distribFile), storeDistrib(storeDistrib), 
+		stats(), summary(), sketch(), unsketched(), parts(0), 
+		spilledSquares(0.0) {
+}
+
+/** Moves the oldest values waiting for the sketch into it
+ *
+ * @post The oldest SKETCH_DELAY values in @ref unsketched, or all of 
+ *	them if there are fewer, are added to @ref sketch and removed 
+ *	from @ref unsketched.
+ *
+ * @perform O(S) time, where S is the size of the sketch.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to update the sketch.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedScalars::flushSketch() {
+	const size_t nMoved = std::min(SKETCH_DELAY, unsketched.size());
+	QuantileSketch newSketch(sketch);
+	for(size_t i = 0; i < nMoved; i++) {
+		newSketch.add(unsketched[i]);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	sketch.swap(newSketch);
+	// Erasing doubles never throws
+	unsketched.erase(unsketched.begin(), unsketched.begin() + nMoved);
+}
+
+/** Returns a sketch of every value recorded
+ *
+ * @return A copy of @ref sketch that also includes the values in 
+ *	@ref unsketched.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to copy the sketch.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+QuantileSketch CollectedScalars::fullSketch() const {
+	QuantileSketch result(sketch);
+	for(vector<double>::const_iterator it = unsketched.begin(); 
+			it != unsketched.end(); it++) {
+		result.add(*it);
+	}
+	return result;
 }
 
 /** Records the value of a scalar statistic.
@@ -51,7 +122,25 @@ CollectedScalars::CollectedScalars(const std::string& statName, const std::strin
  * @exceptsafe The object is unchanged in the event of an exception.
  */
 void CollectedScalars::addStat(double value) {
-	stats.push_back(value);
+	const bool sketched = !kpfutils::isNan(value);
+	if (sketched) {
+		// The flush only moves values between two representations, 
+		//	so it need not be undone if a later step throws
+		if (unsketched.size() >= 2*SKETCH_DELAY) {
+			flushSketch();
+		}
+		unsketched.reserve(2*SKETCH_DELAY);
+	}
+	if (storeDistrib) {
+		stats.push_back(value);
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+	
+	summary.add(value);
+	if (sketched) {
+		unsketched.push_back(value);
+	}
 }
 
 /** Records an invalid scalar statistic.
@@ -68,12 +157,328 @@ void CollectedScalars::addNull() {
 	addStat(std::numeric_limits<double>::quiet_NaN());
 }
 
+/** Records all the statistics stored in another collection.
+ *
+ * @param[in] other The collection whose statistics are to be copied.
+ *
+ * @pre @p other may be the same object as @p *this
+ *
+ * @post The object contains all the statistics previously stored, 
+ *	followed by all the statistics in @p other, in the same order 
+ *	as in @p other.
+ * @post The names of the object are unchanged.
+ * @post The parts written by @p other.spill() are counted as parts of 
+ *	the object, which is correct only if the object holds no statistics 
+ *	in memory and both parts are named as described for 
+ *	setPartPrefix().
+ *
+ * @perform O(N + S) time, where N is the number of statistics in 
+ *	@p other and S is the size of its quantile sketch. O(S) time if 
+ *	this object does not store distributions.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to store the new statistics.
+ * @exception std::invalid_argument Thrown if this object stores 
+ *	distributions but @p other does not.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedScalars::append(const CollectedScalars& other) {
+	QuantileSketch newSketch(sketch);
+	newSketch.merge(other.fullSketch());
+	
+	if (!storeDistrib) {
+		// IMPORTANT: no exceptions beyond this point
+		
+		summary.merge(other.summary);
+		sketch.swap(newSketch);
+		return;
+	}
+	if (!other.storeDistrib) {
+		throw std::invalid_argument("Cannot append a summary of " 
+			+ other.getStatName() + " to a full distribution.");
+	}
+	
+	// Copy the data first in case other is *this
+	const vector<double> newStats = other.stats;
+	const RunningStats   newSummary = other.summary;
+	const long           newParts = other.parts;
+	const double         newSquares = other.spilledSquares;
+	
+	// reserve never changes the contents of the vector, whether 
+	//	or not it throws an exception, so it is a safe operation
+	// if reserve() does not throw, insert() will not throw either, 
+	//	since copying a double does not throw
+	stats.reserve(stats.size() + newStats.size());
+
+	// IMPORTANT: no exceptions beyond this point
+
+	stats.insert(stats.end(), newStats.begin(), newStats.end());
+	summary.merge(newSummary);
+	sketch.swap(newSketch);
+	parts          += newParts;
+	spilledSquares += newSquares;
+}
+
+/** Returns a marker for the statistics currently stored.
+ *
+ * The marker may be passed to rollback() to undo any statistics 
+ *	recorded after this call.
+ *
+ * @return The state of the object.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+CollectedScalars::Checkpoint CollectedScalars::checkpoint() const {
+	return Checkpoint(stats.size(), summary, sketch.count() + unsketched.size());
+}
+
+/** Deletes all statistics recorded since a call to checkpoint().
+ *
+ * @param[in] mark The value returned by checkpoint().
+ *
+ * @pre No statistics have been removed from the object since 
+ *	@p mark was created.
+ * @pre At most 64 statistics have been recorded since @p mark was 
+ *	created. Older ones may already be part of the quantile sketch.
+ *
+ * @post The object contains the same statistics it contained when 
+ *	checkpoint() returned @p mark.
+ *
+ * @perform O(N) time, where N is the number of statistics deleted
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void CollectedScalars::rollback(const Checkpoint& mark) {
+	// Since only doubles are being erased, erase() will not throw
+	if (mark.nStats < stats.size()) {
+		stats.erase(stats.begin() + mark.nStats, stats.end());
+	}
+	summary = mark.summary;
+	
+	const size_t nSketched = sketch.count();
+	if (mark.nSketched >= nSketched 
+			&& mark.nSketched - nSketched < unsketched.size()) {
+		unsketched.erase(unsketched.begin() + (mark.nSketched - nSketched), 
+			unsketched.end());
+	}
+}
+
+/** Writes the statistics recorded so far to a part of the 
+ *	distribution file, and frees their memory.
+ *
+ * The running summary is kept, so printStats() reports the same 
+ * mean, scatter, and definition rate as if spill() had never been called. 
+ * The parts are numbered from 1 in the order they are written, and 
+ * printStats() writes the statistics recorded after the last call 
+ * as the final part.
+ *
+ * @post If the object stores distributions and held any statistics, 
+ *	they are stored in distribFileName(partFileName(distribFile, "N")), 
+ *	where N is the number of parts written so far, and only the 
+ *	summary remains in memory. Otherwise, the object is unchanged.
+ * @post Checkpoints made before the call are no longer valid.
+ *
+ * @perform O(N) time, where N is the number of statistics stored.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the part could not be 
+ *	written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	write the part.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedScalars::spill() {
+	if (!storeDistrib || stats.empty()) {
+		return;
+	}
+	
+	writeStat(stats, partFileName(getFileName(), 
+		boost::lexical_cast<string>(parts + 1)));
+	const double squares = sumSquares();
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	// clear() would keep the memory reserved
+	vector<double>().swap(stats);
+	spilledSquares = squares;
+	parts++;
+}
+
+/** Renames the parts written under a label so that they follow the 
+ *	parts of another collection
+ *
+ * A merged run calls renumberParts() on the statistics of each shard 
+ * before appending them, so that the parts of every shard are numbered 
+ * as if a single process had written them.
+ *
+ * @param[in] label The label the parts were written with, as chosen 
+ *	with setPartPrefix().
+ * @param[in] previous The collection that the statistics will be 
+ *	appended to.
+ *
+ * @pre The label chosen with setPartPrefix() is empty
+ *
+ * @post If getJoinParts() is true, the parts of the object are named 
+ *	as parts of @p previous, numbered after the parts it already has. 
+ *	Otherwise, the parts are unchanged.
+ *
+ * @exception kpfutils::except::FileIo Thrown if a part could not be 
+ *	renamed.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	rename the parts.
+ *
+ * @exceptsafe The parts renamed before an exception keep their new 
+ *	names.
+ */
+void CollectedScalars::renumberParts(const string& label, const CollectedScalars& previous) const {
+	if (!getJoinParts()) {
+		return;
+	}
+	for(long part = 1; part <= parts; part++) {
+		renamePart(getFileName(), label + boost::lexical_cast<string>(part), 
+			boost::lexical_cast<string>(previous.parts + part));
+	}
+}
+
+/** Saves the state of a spilled collection to a text file
+ *
+ * Together with the parts already written by spill(), the state is 
+ * enough to continue the collection in a later run.
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ *
+ * @pre The object holds no statistics that have not been spilled, 
+ *	that is, spill() has been called since the last addStat() or 
+ *	the object does not store distributions.
+ *
+ * @post The number of parts, the running summary, the quantile 
+ *	sketch, and the sum of squares are written as one line of @p file.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the state could not 
+ *	be written.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedScalars::writeState(FILE* const file) const {
+	// %.17g preserves every bit of a double
+	if (fprintf(file, "%ld %.17g", parts, spilledSquares) < 0) {
+		kpfutils::fileError(file, "Could not save statistics in writeState(): ");
+	}
+	summary.writeState(file);
+	fullSketch().writeState(file);
+	if (fprintf(file, "\n") < 0) {
+		kpfutils::fileError(file, "Could not save statistics in writeState(): ");
+	}
+}
+
+/** Restores a state saved by writeState()
+ *
+ * @param[in] file An open file handle positioned at the line written 
+ *	by writeState().
+ *
+ * @post The object has the same parts, summary, and quantile sketch 
+ *	as the object that wrote the line, and no statistics in memory.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p file does not 
+ *	contain a saved state.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedScalars::readState(FILE* const file) {
+	long newParts;
+	double newSquares;
+	if (fscanf(file, "%ld %lf", &newParts, &newSquares) != 2 || newParts < 0) {
+		throw kpfutils::except::FileIo("Misformatted saved state for " 
+			+ getStatName() + ".");
+	}
+	RunningStats newSummary;
+	newSummary.readState(file);
+	QuantileSketch newSketch;
+	newSketch.readState(file);
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	vector<double>().swap(stats);
+	unsketched.clear();
+	parts          = newParts;
+	spilledSquares = newSquares;
+	summary        = newSummary;
+	sketch.swap(newSketch);
+}
+
+/** Prints a single family of statistics to the specified file
+ *
+ * If getPrintQuantiles() is true, the summary is followed by the 
+ * median and the 5th and 95th percentiles estimated by a quantile 
+ * sketch, which are available whether or not distributions are stored. 
+ * If the object does not store distributions, the summary is printed 
+ * without writing a distribution file. If spill() has been called, 
+ * the statistics recorded since the last call are written as the final 
+ * part, and the name printed is a pattern matching every part. If 
+ * getJoinParts() is true, the parts are instead joined into the 
+ * distribution file, and its name is printed.
+ *
+ * @param[in] hOutput An open file handle representing the text file 
+ *	to write to.
+ *
+ * @exception std::runtime_error Thrown if there are difficulties writing 
+ *	to @p file
+ * @exception kpfutils::except::FileIo Thrown if there are difficulties writing 
+ *	to the distribution file.
+ *
+ * @exceptsafe The program is in a consistent state in the event 
+ *	of an exception.
+ */
 void CollectedScalars::printStats(FILE* const hOutput) const {
-	printStat(hOutput, stats, getStatName(), getFileName());
+	if (storeDistrib && parts > 0 && getJoinParts()) {
+		long nParts = parts;
+		if (!stats.empty()) {
+			writeStat(stats, partFileName(getFileName(), 
+				boost::lexical_cast<string>(++nParts)));
+		}
+		joinParts(getFileName(), nParts);
+		printStat(hOutput, summary, getStatName(), 
+			distribFileName(getFileName()));
+	} else if (storeDistrib && parts > 0) {
+		printStat(hOutput, summary, getStatName(), 
+			distribFileName(partFileName(getFileName(), "*")));
+		if (!stats.empty()) {
+			writeStat(stats, partFileName(getFileName(), 
+				boost::lexical_cast<string>(parts + 1)));
+		}
+	} else if (storeDistrib) {
+		printStat(hOutput, stats, getStatName(), getFileName());
+	} else {
+		printStat(hOutput, summary, getStatName());
+	}
+	if (getPrintQuantiles()) {
+		printQuantiles(hOutput, fullSketch());
+	}
 }
 
 void CollectedScalars::clear() {
 	stats.clear();
+	summary = RunningStats();
+	QuantileSketch().swap(sketch);
+	unsketched.clear();
+	parts = 0;
+	spilledSquares = 0.0;
+}
+
+/** Returns the heap memory used by the stored distribution.
+ *
+ * @return The number of bytes reserved for the statistics that 
+ *	spill() can free. The quantile sketch, whose size grows only with 
+ *	the logarithm of the number of statistics, is not counted.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t CollectedScalars::memoryBytes() const {
+	return stats.capacity()*sizeof(double);
 }
 
 /** Returns a vector containing the data in the same order as 
@@ -82,7 +487,9 @@ void CollectedScalars::clear() {
  * @param[in] outVector A vector in which the data will be stored
  * 
  * @post @p outVector contains a copy of the data output by printStats(), 
- * 	in the same order
+ * 	in the same order. If the object does not store distributions, 
+ *	@p outVector is empty. If spill() has been called, @p outVector 
+ *	holds only the statistics recorded since the last call.
  * @post Any data previously in @p outVector is deleted
  * 
  * @exception std::bad_alloc Thrown if there is not enough memory 
@@ -100,12 +507,96 @@ void CollectedScalars::toVector(vector<double>& outVector) const {
 	swap(outVector, temp);
 }
 
+/** Returns the statistics held in memory, without copying them
+ *
+ * @return A pointer to size() contiguous values, in the order 
+ *	they would be returned by toVector(). The pointer is valid until 
+ *	the collection is next changed. May be null if size() is zero.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const double* CollectedScalars::data() const {
+	return stats.empty() ? NULL : &stats[0];
+}
+
+/** Returns the number of statistics held in memory
+ *
+ * @return The number of values returned by toVector(). Zero if the 
+ *	object does not store distributions.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t CollectedScalars::size() const {
+	return stats.size();
+}
+
+/** Returns the sum of the squares of all statistics that are not NaN.
+ *
+ * @return The sum of squares, or 0 if there are no statistics.
+ *
+ * @perform O(N) time, where N is the number of statistics stored. 
+ *	Constant time if the object does not store distributions.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double CollectedScalars::sumSquares() const {
+	if (!storeDistrib) {
+		return summary.sumSquares();
+	}
+	
+	// Add in order, so that the result does not depend on how 
+	//	the statistics were accumulated
+	// Statistics written by spill() come first
+	double sum = spilledSquares;
+	for(vector<double>::const_iterator it = stats.begin(); 
+			it != stats.end(); it++) {
+		if (!kpfutils::isNan(*it)) {
+			sum += (*it) * (*it);
+		}
+	}
+	return sum;
+}
+
+/** Returns the standard error of the mean statistic, as a fraction 
+ *	of the mean
+ *
+ * @return The relative error of the mean printed by printStats(). 
+ *	Infinity if the statistics include infinities or have a mean 
+ *	of zero. NaN if less than two statistics are finite.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double CollectedScalars::relativeError() const {
+	return summary.relativeError();
+}
+
+/** Returns an estimate of a quantile of all statistics recorded
+ *
+ * @param[in] q The quantile to estimate.
+ *
+ * @pre 0 &le; @p q &le; 1
+ *
+ * @return The quantile of the statistics other than NaN, including 
+ *	any written by spill(), or NaN if there are none. The estimate is 
+ *	exact for fewer than getSketchSize() statistics.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	estimate the quantile.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+double CollectedScalars::quantile(double q) const {
+	return fullSketch().quantile(q);
+}
+
 /** Prints a header row representing the statistics printed by 
  *	printStats() to the specified file
  * 
  * The headers are the name of the statistic, the error, the fraction 
- * of runs in which the statistic is well defined, and the name of a 
- * file containing the distribution. The header is in tab-delimited 
+ * of runs in which the statistic is well defined, the name of a 
+ * file containing the distribution, and, if getPrintQuantiles() is 
+ * true, the median with its 5th and 95th percentiles. The header is 
+ * in tab-delimited 
  * format, except that the statistic and the error are separated by 
  * the  sign.
  * 
@@ -120,6 +611,9 @@ void CollectedScalars::toVector(vector<double>& outVector) const {
 void CollectedScalars::printHeader(FILE* const hOutput, const string& fieldName) {
 	int status = fprintf(hOutput, "\t%serr\tFinite\t%s Distribution", 
 			fieldName.c_str(), fieldName.c_str());
+	if (status >= 0 && getPrintQuantiles()) {
+		status = fprintf(hOutput, "\t%s Median [5%%, 95%%]", fieldName.c_str());
+	}
 	if (status < 0) {
 		kpfutils::fileError(hOutput, "String formatting error in printHeader(): ");
 	}
@@ -141,7 +635,13 @@ void CollectedScalars::swap(CollectedScalars& other) {
 	
 	NamedCollection::swap(other);
 	
-	swap(this->stats, other.stats);
+	swap(this->storeDistrib, other.storeDistrib);
+	swap(this->stats,        other.stats);
+	swap(this->summary,      other.summary);
+	swap(this->sketch,       other.sketch);
+	swap(this->unsketched,   other.unsketched);
+	swap(this->parts,        other.parts);
+	swap(this->spilledSquares, other.spilledSquares);
 }
 
 /** Non-throwing swap
@@ -0,0 +1,442 @@
+/** Scargle autocorrelation functions computed from periodograms
+ * @file lightcurveMC/stats/scargleacf.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <gsl/gsl_fft_halfcomplex.h>
+#include <timescales/timescales.h>
+#include "../cachestats.h"
+#include "../gsl_compat.h"
+#include "../except/undefined.h"
+#include "scargleacf.h"
+
+namespace lcmc { namespace stats {
+
+using std::string;
+using std::vector;
+using boost::lexical_cast;
+using boost::shared_ptr;
+
+namespace {
+
+/** The ratio of the inverse time baseline to the frequency spacing
+ */
+const double FREQ_OVERSAMPLE = 4.0;
+
+/** Returns the length of the inverse transform for a cadence and lag grid
+ *
+ * @param[in] times The times of the observations.
+ * @param[in] offStep, nOffsets The spacing and number of lags.
+ *
+ * @return The smallest power of 2 that both resolves the lowest 
+ *	frequencies of @p times and has no wrap-around before lag 
+ *	(@p nOffsets - 1)*@p offStep.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t transformLength(const vector<double>& times, double offStep, 
+		size_t nOffsets) {
+	const double resolved = FREQ_OVERSAMPLE * kpftimes::deltaT(times) / offStep;
+	size_t length = 2;
+	while (length < resolved || length < 2*nOffsets) {
+		length *= 2;
+	}
+	return length;
+}
+
+/** Returns the frequency grid of a Scargle ACF plan
+ *
+ * @param[in] times The times of the observations.
+ * @param[in] offStep The spacing of the lags.
+ * @param[in] fftSize The length of the inverse transform.
+ *
+ * @return The frequencies k/(@p fftSize * @p offStep), for k = 1 up to 
+ *	the lower of the pseudo-Nyquist frequency of @p times and the 
+ *	Nyquist frequency of the lag grid.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the grid.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<double> acfFreq(const vector<double>& times, double offStep, 
+		size_t fftSize) {
+	const double df = 1.0 / (fftSize * offStep);
+	const double maxFreq = kpftimes::pseudoNyquistFreq(times);
+	
+	vector<double> freq;
+	for (size_t k = 1; k < fftSize/2 && k * df <= maxFreq; k++) {
+		freq.push_back(k * df);
+	}
+	if (freq.empty()) {
+		freq.push_back(df);
+	}
+	return freq;
+}
+
+/** Returns the algorithm chosen with setScargleAcfMethod()
+ *
+ * @return A modifiable reference to the algorithm.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ScargleAcfMethod& scargleAcfMethod() {
+	static ScargleAcfMethod method = SACF_DIRECT;
+	return method;
+}
+
+}	// end unnamed namespace
+
+/** Chooses the algorithm for calculating Scargle ACFs
+ *
+ * @ref SACF_PERIODOGRAM "SACF_PERIODOGRAM" is much faster on long 
+ * cadences, but its frequency grid differs from that of 
+ * kpftimes::autoCorr(), so the ACFs differ slightly from those of 
+ * @ref SACF_DIRECT "SACF_DIRECT".
+ *
+ * @param[in] method The algorithm to use from now on.
+ *
+ * @post The Scargle ACF statistics are calculated with @p method.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void setScargleAcfMethod(ScargleAcfMethod method) {
+	scargleAcfMethod() = method;
+}
+
+/** Returns the algorithm chosen with setScargleAcfMethod()
+ *
+ * @return The algorithm for Scargle ACFs, 
+ *	@ref SACF_DIRECT "SACF_DIRECT" unless changed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ScargleAcfMethod getScargleAcfMethod() {
+	return scargleAcfMethod();
+}
+
+/** Precomputes the periodogram and transform for a cadence and 
+ *	lag grid
+ *
+ * @param[in] times The times of the observations.
+ * @param[in] offStep, nOffsets The spacing and number of lags at which 
+ *	autoCorr() evaluates the ACF.
+ *
+ * @pre @p times is sorted in ascending order, and contains no NaNs
+ * @pre @p offStep > 0
+ *
+ * @perform O(N + F log F) time, where N = @p times.size() and F is the 
+ *	transform length
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times has 
+ *	fewer than two values.
+ * @exception std::invalid_argument Thrown if @p offStep is not positive 
+ *	or @p nOffsets is zero.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	construct the object.
+ * @exception std::runtime_error Thrown if the periodogram's FFT fails.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+ScargleAcfPlan::ScargleAcfPlan(const vector<double>& times, double offStep, 
+		size_t nOffsets) : offStep(offStep), nOffsets(nOffsets), fftSize(0), 
+		periodogram(), cosines(), directLags(0) {
+	if (times.size() < 2) {
+		throw except::NotEnoughData("Cannot calculate autocorrelation function with fewer than 2 data points (gave " 
+			+ lexical_cast<string>(times.size()) + ").");
+	}
+	if (!(offStep > 0.0)) {
+		throw std::invalid_argument("Need a positive time lag to construct an autocorrelation grid (gave " 
+			+ lexical_cast<string>(offStep) + ")");
+	}
+	if (nOffsets == 0) {
+		throw std::invalid_argument("Must calculate autocorrelation function at a positive number of points.");
+	}
+	
+	fftSize = transformLength(times, offStep, nOffsets);
+	// The grid is uniform, so the periodogram's trigonometric sums 
+	//	are done with FFTs
+	periodogram.reset(new PeriodogramPlan(times, 
+		acfFreq(times, offStep, fftSize), LS_FAST));
+	
+	cosines.reserve(fftSize);
+	for (size_t j = 0; j < fftSize; j++) {
+		cosines.push_back(cos(2.0 * M_PI * j / fftSize));
+	}
+	
+	// A radix-2 transform takes about fftSize log2(fftSize) steps, 
+	//	and a direct sum one step per frequency
+	size_t logSize = 0;
+	for (size_t n = fftSize; n > 1; n /= 2) {
+		logSize++;
+	}
+	directLags = fftSize * logSize / periodogram->getFreq().size();
+}
+
+/** Returns a plan for a cadence and lag grid, reusing the last 
+ *	plan if possible
+ *
+ * @param[in] times The times of the observations.
+ * @param[in] offStep, nOffsets The spacing and number of lags at which 
+ *	autoCorr() evaluates the ACF.
+ *
+ * @return A plan for @p times, @p offStep, and @p nOffsets. If the 
+ *	previous call had the same arguments, its plan is returned again.
+ *
+ * @pre @p times is sorted in ascending order, and contains no NaNs
+ *
+ * @exception lcmc::stats::except::NotEnoughData Thrown if @p times has 
+ *	fewer than two values.
+ * @exception std::invalid_argument Thrown if @p offStep is not positive 
+ *	or @p nOffsets is zero.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create a new plan.
+ * @exception std::runtime_error Thrown if the periodogram's FFT fails.
+ *
+ * @exceptsafe The cache is unchanged in the event of an exception.
+ */
+shared_ptr<const ScargleAcfPlan> ScargleAcfPlan::forCadence(
+		const vector<double>& times, double offStep, size_t nOffsets) {
+	static boost::mutex cacheLock;
+	static shared_ptr<const ScargleAcfPlan> cache;
+	static utils::CacheCounter counter("Scargle ACF plans");
+
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		if (cache.get() != NULL && cache->offStep == offStep 
+				&& cache->nOffsets == nOffsets 
+				&& cache->periodogram->getTimes() == times) {
+			counter.hit();
+			return cache;
+		}
+	}
+
+	const utils::CacheMiss miss(counter);
+
+	// Don't hold the lock while building the plan, so that threads
+	//	working on other cadences are not blocked
+	shared_ptr<const ScargleAcfPlan> plan(new ScargleAcfPlan(times, offStep, nOffsets));
+
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		cache = plan;
+	}
+	return plan;
+}
+
+/** Computes the autocorrelation function of a light curve sampled 
+ *	at the plan's times
+ *
+ * @param[in] data The values of the light curve at each time.
+ * @param[out] acf The ACF at lags 0, offStep, ..., 
+ *	(nOffsets-1)*offStep.
+ *
+ * @pre @p data contains no NaNs
+ *
+ * @post @p acf.size() = nOffsets, and @p acf[0] = 1.
+ * @post @p acf[m] = @f$ \sum_k P_k \cos(2\pi f_k m \Delta) / \sum_k P_k @f$, 
+ *	where @f$ P_k @f$ is the Lomb-Scargle periodogram of @p data at 
+ *	frequency @f$ f_k @f$, and @f$ \Delta @f$ is the lag spacing.
+ *
+ * @perform O(N + F log F) time, where N = @p data.size() and F is the 
+ *	transform length. No trigonometric functions are evaluated.
+ *
+ * @exception lcmc::stats::except::Undefined Thrown if @p data is constant.
+ * @exception std::invalid_argument Thrown if @p data does not have one 
+ *	value for each time of the plan.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the ACF.
+ * @exception std::runtime_error Thrown if an FFT fails.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void ScargleAcfPlan::autoCorr(const vector<double>& data, 
+		vector<double>& acf) const {
+	vector<double> power;
+	periodogram->lombScargle(data, power);
+	transform(power, acf);
+}
+
+/** Computes the autocorrelation function of a light curve at 
+ *	selected lags, and at the shortest lags down to a level
+ *
+ * The lags are summed directly from the periodogram if that is 
+ * clearly faster than the inverse transform. Otherwise, or if the 
+ * lags show that the ACF might stay above @p level for too long, the 
+ * ACF is computed at every lag as by 
+ * autoCorr(const std::vector<double>&, std::vector<double>&) const. 
+ * Since the first lag below @p level is never later than the first 
+ * of @p lags below it, the lags in between are the only ones that 
+ * need to be summed to find it.
+ *
+ * @param[in] data The values of the light curve at each time.
+ * @param[in] lags The positions, on the grid 0, offStep, ..., 
+ *	(nOffsets-1)*offStep, at which the ACF is needed.
+ * @param[in] level The ACF is also needed at every lag up to and 
+ *	including the first at which it is less than @p level. A 
+ *	@p level of -1 or less needs no such lags, since no ACF is 
+ *	below -1.
+ * @param[out] acf The ACF on the grid 0, offStep, ..., 
+ *	(nOffsets-1)*offStep.
+ *
+ * @pre @p data contains no NaNs
+ * @pre Every element of @p lags is less than nOffsets
+ *
+ * @post @p acf.size() = nOffsets.
+ * @post For each m in @p lags, and each m up to and including the 
+ *	first one for which the ACF is less than @p level, @p acf[m] is 
+ *	the value computed by 
+ *	autoCorr(const std::vector<double>&, std::vector<double>&) const, 
+ *	to within rounding error. Any other element of @p acf is either 
+ *	that value or NaN.
+ *
+ * @perform O(N + F log F) time, where N = @p data.size() and F is the 
+ *	transform length. If the lags are summed directly, the 
+ *	inverse transform is not done. No trigonometric functions are 
+ *	evaluated.
+ *
+ * @exception lcmc::stats::except::Undefined Thrown if @p data is constant.
+ * @exception std::invalid_argument Thrown if @p data does not have one 
+ *	value for each time of the plan.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the ACF.
+ * @exception std::runtime_error Thrown if an FFT fails.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void ScargleAcfPlan::autoCorr(const vector<double>& data, 
+		const vector<size_t>& lags, double level, 
+		vector<double>& acf) const {
+	vector<double> power;
+	periodogram->lombScargle(data, power);
+	
+	// Falling back to the transform wastes the lags already summed, 
+	//	so never sum more than half a transform's worth of them
+	if (2*lags.size() > directLags) {
+		transform(power, acf);
+		return;
+	}
+	
+	const double norm = lagSum(power, 0);
+	if (!(norm > 0.0)) {
+		throw except::Undefined("Light curve has no variability, so its autocorrelation function is undefined.");
+	}
+	vector<double> temp(nOffsets, std::numeric_limits<double>::quiet_NaN());
+	size_t bracket = nOffsets;
+	for (vector<size_t>::const_iterator it = lags.begin(); 
+			it != lags.end(); it++) {
+		temp[*it] = lagSum(power, *it) / norm;
+		if (bracket == nOffsets && temp[*it] < level) {
+			bracket = *it;
+		}
+	}
+	
+	if (level > -1.0) {
+		if (bracket == nOffsets || lags.size() + bracket > directLags) {
+			transform(power, acf);
+			return;
+		}
+		for (size_t m = 0; m <= bracket; m++) {
+			// NaN never equals itself
+			if (temp[m] != temp[m]) {
+				temp[m] = lagSum(power, m) / norm;
+			}
+			if (temp[m] < level) {
+				break;
+			}
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	acf.swap(temp);
+}
+
+/** Converts a periodogram of the plan to the ACF at every lag
+ *
+ * @param[in] power The periodogram of a light curve at the plan's 
+ *	frequencies.
+ * @param[out] acf The ACF at lags 0, offStep, ..., 
+ *	(nOffsets-1)*offStep.
+ *
+ * @post @p acf is as described for 
+ *	autoCorr(const std::vector<double>&, std::vector<double>&) const.
+ *
+ * @perform O(F log F) time, where F is the transform length.
+ *
+ * @exception lcmc::stats::except::Undefined Thrown if @p power is zero.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the ACF.
+ * @exception std::runtime_error Thrown if the FFT fails.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void ScargleAcfPlan::transform(const vector<double>& power, 
+		vector<double>& acf) const {
+	// Radix-2 half-complex layout: real parts of frequencies 0 through 
+	//	fftSize/2, then imaginary parts. The power spectrum is real, 
+	//	and has no constant term because the mean is subtracted.
+	vector<double> spectrum(fftSize, 0.0);
+	std::copy(power.begin(), power.end(), spectrum.begin() + 1);
+	gslCheck( gsl_fft_halfcomplex_radix2_inverse(&spectrum[0], 1, fftSize), 
+		"While computing ACF: ");
+	
+	const double norm = spectrum[0];
+	if (!(norm > 0.0)) {
+		throw except::Undefined("Light curve has no variability, so its autocorrelation function is undefined.");
+	}
+	vector<double> temp(spectrum.begin(), spectrum.begin() + nOffsets);
+	for (size_t m = 0; m < nOffsets; m++) {
+		temp[m] /= norm;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	acf.swap(temp);
+}
+
+/** Sums a periodogram of the plan at one lag
+ *
+ * @param[in] power The periodogram of a light curve at the plan's 
+ *	frequencies.
+ * @param[in] lag The position of the lag on the grid 0, offStep, ..., 
+ *	(nOffsets-1)*offStep.
+ *
+ * @return @f$ \sum_k P_k \cos(2\pi f_k m \Delta) @f$, where 
+ *	@f$ P_k @f$ = @p power[k], @f$ m @f$ = @p lag, and @f$ \Delta @f$ 
+ *	is the lag spacing.
+ *
+ * @pre @p lag < nOffsets
+ *
+ * @perform O(F) time, where F = @p power.size().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double ScargleAcfPlan::lagSum(const vector<double>& power, size_t lag) const {
+	// power[k] is at frequency (k+1)/(fftSize*offStep), so its phase 
+	//	at the lag is 2 pi (k+1) lag/fftSize. Since 2*lag < fftSize, 
+	//	the phase index wraps at most once per step.
+	double sum = 0.0;
+	size_t phase = 0;
+	for (size_t k = 0; k < power.size(); k++) {
+		phase += lag;
+		if (phase >= fftSize) {
+			phase -= fftSize;
+		}
+		sum += power[k] * cosines[phase];
+	}
+	return sum;
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,104 @@
+/** Scargle autocorrelation functions computed from periodograms
+ * @file lightcurveMC/stats/scargleacf.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCSCARGLEACFH
+#define LCMCSCARGLEACFH
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "lsplan.h"
+
+namespace lcmc { namespace stats {
+
+/** Type used to tell the program how to calculate Scargle ACFs
+ */
+enum ScargleAcfMethod {
+	/** Calls kpftimes::autoCorr(), as in earlier versions
+	 */
+	SACF_DIRECT, 
+	/** Transforms a periodogram cached by ScargleAcfPlan
+	 */
+	SACF_PERIODOGRAM
+};
+
+/** Stores everything needed to compute a Scargle autocorrelation 
+ *	function that depends only on the times of observation.
+ *
+ * Following Scargle (1989), the ACF is the inverse Fourier transform of 
+ * the Lomb-Scargle periodogram. The plan evaluates the periodogram on a 
+ * uniform frequency grid whose spacing matches the lag grid, so that 
+ * the inverse transform is a single real FFT. If only a few lags are 
+ * needed, they may instead be summed directly from the periodogram.
+ *
+ * As with kpftimes::autoCorr(), the ACF is normalized to 1 at zero lag. 
+ * The two differ only through the frequency grid, which here is 
+ * uniform and oversampled to match the lags.
+ *
+ * Plans are immutable once created, and may be shared between threads.
+ */
+class ScargleAcfPlan {
+public:
+	/** Precomputes the periodogram and transform for a cadence and 
+	 *	lag grid
+	 */
+	ScargleAcfPlan(const std::vector<double>& times, double offStep, 
+		size_t nOffsets);
+
+	/** Returns a plan for a cadence and lag grid, reusing the last 
+	 *	plan if possible
+	 */
+	static boost::shared_ptr<const ScargleAcfPlan> forCadence(
+		const std::vector<double>& times, double offStep, size_t nOffsets);
+
+	/** Computes the autocorrelation function of a light curve sampled 
+	 *	at the plan's times
+	 */
+	void autoCorr(const std::vector<double>& data, 
+		std::vector<double>& acf) const;
+
+	/** Computes the autocorrelation function of a light curve at 
+	 *	selected lags, and at the shortest lags down to a level
+	 */
+	void autoCorr(const std::vector<double>& data, 
+		const std::vector<size_t>& lags, double level, 
+		std::vector<double>& acf) const;
+
+private:
+	/** Converts a periodogram of the plan to the ACF at every lag
+	 */
+	void transform(const std::vector<double>& power, 
+		std::vector<double>& acf) const;
+	
+	/** Sums a periodogram of the plan at one lag
+	 */
+	double lagSum(const std::vector<double>& power, size_t lag) const;
+
+	double offStep;
+	size_t nOffsets;
+	/** The length of the inverse transform */
+	size_t fftSize;
+	/** The periodogram, on frequencies k/(fftSize*offStep) for 
+	 *	k = 1, 2, ... */
+	boost::shared_ptr<const PeriodogramPlan> periodogram;
+	/** cos(2&pi; j/fftSize), for j = 0, ..., fftSize-1 */
+	std::vector<double> cosines;
+	/** The number of lags that lagSum() evaluates in about the time 
+	 *	of one inverse transform */
+	size_t directLags;
+};
+
+/** Chooses the algorithm for calculating Scargle ACFs
+ */
+void setScargleAcfMethod(ScargleAcfMethod method);
+
+/** Returns the algorithm chosen with setScargleAcfMethod()
+ */
+ScargleAcfMethod getScargleAcfMethod();
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCSCARGLEACFH
@@ -0,0 +1,192 @@
+/** Reusable buffers for the temporaries of each light curve
+ * @file lightcurveMC/stats/scratch.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <boost/thread/tss.hpp>
+#include "scratch.h"
+
+namespace lcmc { namespace stats {
+
+using std::vector;
+
+namespace {
+
+/** ScratchPool holds the vectors one thread is not currently using.
+ */
+class ScratchPool {
+public:
+	/** Creates an empty pool
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	ScratchPool() : idle(), owned(0) {
+	}
+
+	/** Frees every vector the pool created
+	 *
+	 * @pre Every vector lent by the pool has been returned
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	~ScratchPool() {
+		for(vector<vector<double>*>::iterator it = idle.begin(); 
+				it != idle.end(); it++) {
+			delete *it;
+		}
+	}
+
+	/** Lends a vector
+	 *
+	 * @return An empty vector, reused if the pool has one idle.
+	 *
+	 * @exception std::bad_alloc Thrown if a new vector is needed and 
+	 *	there is not enough memory for it.
+	 *
+	 * @exceptsafe The pool is unchanged in the event of an exception.
+	 */
+	vector<double>* lend() {
+		if (!idle.empty()) {
+			vector<double>* const reused = idle.back();
+			idle.pop_back();
+			return reused;
+		}
+		
+		// Make room to take the new vector back, so that returning 
+		//	it cannot fail
+		idle.reserve(owned + 1);
+		vector<double>* const fresh = new vector<double>();
+		owned++;
+		return fresh;
+	}
+
+	/** Takes back a vector lent by lend()
+	 *
+	 * @param[in] buffer The vector to return.
+	 *
+	 * @post @p buffer is empty, but keeps its capacity for the next 
+	 *	call to lend().
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void giveBack(vector<double>* buffer) {
+		buffer->clear();
+		// lend() reserved a place for every vector the pool owns
+		idle.push_back(buffer);
+	}
+
+	/** Returns the number of vectors the pool has created
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	size_t size() const {
+		return owned;
+	}
+
+private:
+	// Pools own their vectors
+	ScratchPool(const ScratchPool&);
+	ScratchPool& operator=(const ScratchPool&);
+
+	vector<vector<double>*> idle;
+	size_t owned;
+};
+
+/** Returns the calling thread's pool
+ *
+ * @return A pool private to the calling thread, created on first use 
+ *	and freed when the thread exits.
+ *
+ * @exception std::bad_alloc Thrown if the pool could not be created.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+ScratchPool& threadPool() {
+	static boost::thread_specific_ptr<ScratchPool> pools;
+	if (pools.get() == NULL) {
+		pools.reset(new ScratchPool());
+	}
+	return *pools;
+}
+
+}	// end unnamed namespace
+
+/** Borrows a vector from the calling thread's pool
+ *
+ * @param[in] n The number of elements the vector should have.
+ *
+ * @post get() has @p n zero-valued elements.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory for 
+ *	the vector.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+ScratchVector::ScratchVector(size_t n) : buffer(threadPool().lend()) {
+	try {
+		buffer->resize(n);
+	} catch (...) {
+		threadPool().giveBack(buffer);
+		throw;
+	}
+}
+
+/** Returns the vector to the pool
+ *
+ * @pre The object is destroyed on the thread that created it
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ScratchVector::~ScratchVector() {
+	threadPool().giveBack(buffer);
+}
+
+/** Returns the borrowed vector
+ *
+ * @return A vector that the caller may use freely until the object is 
+ *	destroyed. Swapping its contents with another vector is allowed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+vector<double>& ScratchVector::get() {
+	return *buffer;
+}
+
+/** Returns the number of vectors owned by the calling thread's pool
+ *
+ * @return The most vectors the calling thread has had on loan at once.
+ *
+ * @exception std::bad_alloc Thrown if the pool could not be created.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+size_t scratchVectorCount() {
+	return threadPool().size();
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,74 @@
+/** Reusable buffers for the temporaries of each light curve
+ * @file lightcurveMC/stats/scratch.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCSCRATCHH
+#define LCMCSCRATCHH
+
+#include <vector>
+#include <cstddef>
+
+namespace lcmc { namespace stats {
+
+/** ScratchVector lends a vector from a per-thread pool for the 
+ * lifetime of one scope.
+ *
+ * The vector is returned to the pool empty but with its capacity 
+ * intact, so once a thread has analyzed one light curve, later light 
+ * curves of similar length reuse the same memory instead of 
+ * allocating their temporaries again.
+ */
+class ScratchVector {
+public:
+	/** Borrows a vector from the calling thread's pool
+	 */
+	explicit ScratchVector(size_t n = 0);
+
+	/** Returns the vector to the pool
+	 */
+	~ScratchVector();
+
+	/** Returns the borrowed vector
+	 */
+	std::vector<double>& get();
+
+private:
+	// Each lease returns its vector exactly once
+	ScratchVector(const ScratchVector&);
+	ScratchVector& operator=(const ScratchVector&);
+
+	std::vector<double>* buffer;
+};
+
+/** Returns the number of vectors owned by the calling thread's pool
+ */
+size_t scratchVectorCount();
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCSCRATCHH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/stats/statcollect.h
  * @author Krzysztof Findeisen
  * @date Created June 6, 2013
- * @date Last modified August 5, 2013
+ * @date Last modified October 14, 2026
  */
 
 #ifndef LCMCSTATCOLH
@@ -12,6 +12,10 @@
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <boost/shared_ptr.hpp>
+#include "quantilesketch.h"
+#include "raggedarray.h"
+#include "runningstats.h"
 
 namespace lcmc { namespace stats {
 
@@ -31,8 +35,10 @@ public:
 	 *
 	 * The function will print, in order: the mean of the statistic, the 
 	 * standard deviation of the statistic, the fraction of times each 
-	 * statistic was defined, and the name of a file containing the 
-	 * distribution of the statistics. The row is in tab-delimited 
+	 * statistic was defined, the name of a file containing the 
+	 * distribution of the statistics, and, if requested with 
+	 * setPrintQuantiles(), the median and percentiles of the 
+	 * statistic. The row is in tab-delimited 
 	 * format, except that the mean and standard deviation are separated by 
 	 * a  sign for improved readability.
 	 *
@@ -57,21 +63,31 @@ public:
 	 */
 	virtual void clear() = 0;
 	
+	/** Returns the heap memory used by the object.
+	 *
+	 * @return The number of bytes reserved for the statistics, not 
+	 *	counting the object itself.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	virtual size_t memoryBytes() const = 0;
+	
 	virtual ~IStats() {}
 };
 
 /** Abstract base class defining infrastructure used by statistic collections.
  */
 class NamedCollection : public IStats {
+public:
+	/** Returns the name of the statistic.
+	 */
+	const string& getStatName() const;
+
 protected:
 	/** Names a collection of statistics.
 	 */
 	NamedCollection(const string& statName, const string& distribFile);
 
-	/** Returns the name of the statistic.
-	 */
-	const string& getStatName() const;
-
 	/** Returns the file name of the statistic.
 	 */
 	const string& getFileName() const;
@@ -89,9 +105,30 @@ private:
  */
 class CollectedScalars : public NamedCollection {
 public:
+	/** Identifies a state to which the collection can be restored.
+	 */
+	struct Checkpoint {
+		/** Records the state of a collection.
+		 *
+		 * @exceptsafe Does not throw exceptions.
+		 */
+		Checkpoint(size_t nStats, const RunningStats& summary, 
+				size_t nSketched) 
+				: nStats(nStats), summary(summary), nSketched(nSketched) {
+		}
+		
+		/** The number of statistics stored. */
+		size_t nStats;
+		/** The summary of all statistics recorded. */
+		RunningStats summary;
+		/** The number of values destined for the quantile sketch. */
+		size_t nSketched;
+	};
+
 	/** Constructs a collection of statistics.
 	 */
-	CollectedScalars(const string& statName, const string& distribFile);
+	CollectedScalars(const string& statName, const string& distribFile, 
+			bool storeDistrib);
 
 	/** Records the value of a scalar statistic.
 	 */
@@ -101,17 +138,71 @@ public:
 	 */
 	void addNull();
 
+	/** Records all the statistics stored in another collection.
+	 */
+	void append(const CollectedScalars& other);
+
+	/** Returns a marker for the statistics currently stored.
+	 */
+	Checkpoint checkpoint() const;
+
+	/** Deletes all statistics recorded since a call to checkpoint().
+	 */
+	void rollback(const Checkpoint& mark);
+
+	/** Writes the statistics recorded so far to a part of the 
+	 *	distribution file, and frees their memory.
+	 */
+	void spill();
+
+	/** Renames the parts written under a label so that they follow the 
+	 *	parts of another collection
+	 */
+	void renumberParts(const string& label, const CollectedScalars& previous) const;
+
+	/** Saves the state of a spilled collection to a text file
+	 */
+	void writeState(FILE* const file) const;
+
+	/** Restores a state saved by writeState()
+	 */
+	void readState(FILE* const file);
+
 	// Inherit documentation from IStats
 	void printStats(FILE* const hOutput) const;
 
 	// Inherit documentation from IStats
 	void clear();
+
+	// Inherit documentation from IStats
+	size_t memoryBytes() const;
 	
 	/** Returns a vector containing the data in the same order as 
 	 * printed by printStats()
 	 */
 	void toVector(vector<double>& outVector) const;
 
+	/** Returns the statistics held in memory, without copying them
+	 */
+	const double* data() const;
+
+	/** Returns the number of statistics held in memory
+	 */
+	size_t size() const;
+
+	/** Returns the sum of the squares of all statistics that are not NaN.
+	 */
+	double sumSquares() const;
+
+	/** Returns the standard error of the mean statistic, as a fraction 
+	 *	of the mean
+	 */
+	double relativeError() const;
+
+	/** Returns an estimate of a quantile of all statistics recorded
+	 */
+	double quantile(double q) const;
+
 	/** Prints a header row representing the statistics printed by 
 	 *	printStats() to the specified file
 	 */
@@ -122,7 +213,26 @@ public:
 	void swap(CollectedScalars& other);
 	
 private:
+	/** Moves the oldest values waiting for the sketch into it
+	 */
+	void flushSketch();
+
+	/** Returns a sketch of every value recorded
+	 */
+	QuantileSketch fullSketch() const;
+
+	bool storeDistrib;
 	vector<double> stats;
+	RunningStats summary;
+	/** The quantiles of all but the most recent values */
+	QuantileSketch sketch;
+	/** The most recent values other than NaN, in the order recorded, 
+	 *	kept out of the sketch so that rollback() can remove them */
+	vector<double> unsketched;
+	/** The number of parts of the distribution file written by spill() */
+	long parts;
+	/** The sum of squares of the statistics written by spill() */
+	double spilledSquares;
 };
 
 /** Non-throwing swap
@@ -141,12 +251,27 @@ public:
 	 */
 	void addStat(const DoubleVec& value);
 
+	/** Records all the statistics stored in another collection.
+	 */
+	void append(const CollectedVectors& other);
+
+	/** Returns a marker for the statistics currently stored.
+	 */
+	size_t checkpoint() const;
+
+	/** Deletes all statistics recorded since a call to checkpoint().
+	 */
+	void rollback(size_t mark);
+
 	// Inherit documentation from IStats
 	void printStats(FILE* const hOutput) const;
 
 	// Inherit documentation from IStats
 	void clear();
 
+	// Inherit documentation from IStats
+	size_t memoryBytes() const;
+
 	/** Prints a header row representing the statistics printed by 
 	 *	printStats() to the specified file
 	 */
@@ -157,31 +282,106 @@ public:
 	void swap(CollectedVectors& other);
 	
 private:
-	vector<DoubleVec> stats;
+	RaggedArray stats;
 };
 /** Non-throwing swap
  */
 void swap(CollectedVectors& a, CollectedVectors& b);
 
+/** Chooses the precision in which CollectedPairs stores the values of 
+ *	the functions it records
+ */
+void setCurvePrecision(ValuePrecision precision);
+
+/** Returns the precision chosen with setCurvePrecision()
+ */
+ValuePrecision getCurvePrecision();
+
 /** Defines a collection of statistics where each statistic represents 
  *	the sampling of a function, @f$\{(x_i, y_i)\}@f$.
+ *
+ * Statistics are usually sampled on the same @f$\{x_i\}@f$ on every 
+ * trial, so a grid identical to the one before it is stored only once.
+ *
+ * A collection that does not store curves keeps, for each distinct grid, 
+ * only the running mean, scatter, and quantiles of the function at 
+ * each grid point, so its memory does not grow with the number of trials.
+ *
+ * A collection that stores curves keeps the @f$\{y_i\}@f$ at the 
+ * precision given by getCurvePrecision() when it was created. The 
+ * grids are always stored exactly.
  */
 class CollectedPairs : public NamedCollection {
 public:
 	/** Constructs a collection of statistics.
 	 */
-	CollectedPairs(const string& statName, const string& distribFile);
+	CollectedPairs(const string& statName, const string& distribFile, 
+			bool storeCurves = true);
 
 	/** Records the value of a function statistic.
 	 */
 	void addStat(const DoubleVec& x, const DoubleVec& y);
 
+	/** Records the value of a function statistic at selected points 
+	 *	of its sampling.
+	 */
+	void addStat(const DoubleVec& x, const DoubleVec& y, 
+			const vector<size_t>& keep);
+
+	/** Records the value of a function statistic sampled on a grid 
+	 *	shared with other statistics.
+	 */
+	void addStat(const boost::shared_ptr<const DoubleVec>& x, 
+			const DoubleVec& y);
+
+	/** Records all the statistics stored in another collection.
+	 */
+	void append(const CollectedPairs& other);
+
+	/** Returns a marker for the statistics currently stored.
+	 */
+	size_t checkpoint() const;
+
+	/** Deletes all statistics recorded since a call to checkpoint().
+	 */
+	void rollback(size_t mark);
+
+	/** Writes the statistics recorded so far to a part of the 
+	 *	distribution file, and frees their memory.
+	 */
+	void spill();
+
+	/** Renames the parts written under a label so that they follow the 
+	 *	parts of another collection
+	 */
+	void renumberParts(const string& label, const CollectedPairs& previous) const;
+
+	/** Saves the state of a spilled collection to a text file
+	 */
+	void writeState(FILE* const file) const;
+
+	/** Restores a state saved by writeState()
+	 */
+	void readState(FILE* const file);
+
 	// Inherit documentation from IStats
 	void printStats(FILE* const hOutput) const;
 
 	// Inherit documentation from IStats
 	void clear();
 
+	// Inherit documentation from IStats
+	size_t memoryBytes() const;
+
+	/** Returns the number of statistics held in memory
+	 */
+	size_t size() const;
+
+	/** Returns one statistic held in memory, without copying it
+	 */
+	void getStat(size_t i, const double*& xBegin, const double*& yBegin, 
+			size_t& n) const;
+
 	/** Prints a header row representing the statistics printed by 
 	 *	printStats() to the specified file
 	 */
@@ -192,8 +392,36 @@ public:
 	void swap(CollectedPairs& other);
 	
 private:
-	vector<DoubleVec> x;
-	vector<DoubleVec> y;
+	/** Adds the statistics held in memory to the per-point summaries.
+	 */
+	void foldHeld();
+
+	/** Returns the index of the summary sampled on a grid
+	 */
+	size_t findSummary(const double* begin, const double* end) const;
+
+	bool storeCurves;
+	/** The distinct grids, in the order they were first recorded
+	 */
+	RaggedArray grids;
+	/** For each statistic, the index in grids of its @f$\{x_i\}@f$
+	 */
+	vector<size_t> gridIndex;
+	/** The shared grid stored as the last element of @ref grids, or 
+	 *	null if the last grid was not recorded from a shared grid */
+	boost::shared_ptr<const DoubleVec> lastGrid;
+	RaggedArray y;
+	/** The number of parts of the distribution file written by spill() */
+	long parts;
+	
+	/** If not storeCurves, the distinct grids summarized so far */
+	RaggedArray summaryGrids;
+	/** For each summarized grid, the mean and scatter at each point */
+	vector<vector<RunningStats> > pointStats;
+	/** For each summarized grid, the quantiles at each point */
+	vector<vector<QuantileSketch> > pointSketches;
+	/** The number of statistics added to the summaries */
+	size_t nSummarized;
 };
 /** Non-throwing swap
  */
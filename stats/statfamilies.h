@@ -2,14 +2,17 @@
  * @file lightcurveMC/stats/statfamilies.h
  * @author Krzysztof Findeisen
  * @date Created June 8, 2013
- * @date Last modified August 5, 2013
+ * @date Last modified October 14, 2026
  */
 
 #ifndef LCMCSTATFAMH
 #define LCMCSTATFAMH
 
 #include <vector>
+#include "analysiscontext.h"
+#include "lsplan.h"
 #include "statcollect.h"
+#include "statstatus.h"
 
 namespace lcmc { namespace stats {
 
@@ -17,13 +20,13 @@ using std::vector;
 
 /** Does all periodogram-related computations for a given light curve.
  */
-void doPeriodogram(const vector<double>& times, const vector<double>& data, 
-		bool getPeriod, bool getPlot, 
+void doPeriodogram(const AnalysisContext& lc, 
+		bool getPeriod, bool getPlot, PeriodogramMethod method, 
 		CollectedScalars& periods, CollectedPairs& periodograms);
 
 /** Does all &Delta;m&Delta;t-related computations for a given light curve.
  */
-void doDmdt(const vector<double>& times, const vector<double>& mags, 
+void doDmdt(const AnalysisContext& lc, 
 		bool getCut, bool getPlot, 
 		CollectedScalars& cut50Amp3, CollectedScalars& cut50Amp2, 
 		CollectedScalars& cut90Amp3, CollectedScalars& cut90Amp2, 
@@ -31,16 +34,46 @@ void doDmdt(const vector<double>& times, const vector<double>& mags,
 
 /** Does all ACF-related computations for a given light curve.
  */
-void doAcf(const vector<double>& times, const vector<double>& data, 
+void doAcf(const AnalysisContext& lc, 
 		void (*acfFunc) (const vector<double>&, const vector<double>&, 
 				double, size_t, vector<double>&), 
 		bool getCut, bool getPlot, 
 		CollectedScalars& cut9, CollectedScalars& cut4, CollectedScalars& cut2, 
-		CollectedPairs& acfPlot);
+		CollectedPairs& acfPlot, 
+		void (*lagFunc) (const vector<double>&, const vector<double>&, 
+				double, size_t, const vector<size_t>&, double, 
+				vector<double>&) = NULL);
+
+/** Computes the interpolated ACFs of several light curves together, 
+ *	and records them in each light curve.
+ */
+void batchInterpAcfs(const vector<AnalysisContext*>& members);
+
+/** Type used to tell the program how to search for peak-finding 
+ *	timescales
+ */
+enum PeakMethod {
+	/** Searches separately for the key cuts, the peak-finding curve, 
+	 *	and the 80% cut, as in earlier versions
+	 */
+	PEAK_DIRECT, 
+	/** Searches once for every threshold, and interpolates the 80% cut 
+	 *	from the peak-finding curve
+	 */
+	PEAK_LADDER
+};
+
+/** Chooses how doPeak() searches for peak-finding timescales
+ */
+void setPeakMethod(PeakMethod method);
+
+/** Returns the search chosen with setPeakMethod()
+ */
+PeakMethod getPeakMethod();
 
 /** Does all peak-finding related computations for a given light curve.
  */
-void doPeak(const vector<double>& times, const vector<double>& mags, 
+void doPeak(const AnalysisContext& lc, 
 		bool getCut, bool getPlot, 
 		CollectedScalars& cut3, CollectedScalars& cut2, 
 		CollectedScalars& cut80, CollectedPairs& peakPlot);
@@ -48,10 +81,21 @@ void doPeak(const vector<double>& times, const vector<double>& mags,
 
 /** Does all GP-related computations for a given light curve.
  */
-void doGaussFit(const vector<double>& times, const vector<double>& data, 
+StatStatus doGaussFit(const AnalysisContext& lc, 
 		bool getGp, double trueTime, CollectedScalars& timescales, 
 		CollectedScalars& timeErrors, CollectedScalars& normDevs);
 
+/** Does all DRW-related computations for a given light curve.
+ */
+StatStatus doDrwFit(const AnalysisContext& lc, 
+		bool getDrw, double trueTime, CollectedScalars& timescales, 
+		CollectedScalars& timeErrors, CollectedScalars& normDevs);
+
+/** Does all RMS-related computations for a given light curve.
+ */
+void doRms(const AnalysisContext& lc, bool getRooted, bool getPairs, 
+		CollectedPairs& rooted, CollectedPairs& pairs);
+
 }}		// end lcmc::stats
 
 #endif		// End ifndef LCMCSTATFAMH
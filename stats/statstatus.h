@@ -0,0 +1,40 @@
+/** Outcomes of statistics that may not be defined for every light curve
+ * @file lightcurveMC/stats/statstatus.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCSTATSTATUSH
+#define LCMCSTATSTATUSH
+
+#include <cstddef>
+
+namespace lcmc { namespace stats {
+
+/** Type used to report why a statistic was not calculated
+ *
+ * Functions on the per-light-curve path return a StatStatus instead of 
+ * throwing, since in bins of flat or noisy light curves most trials 
+ * may fail. Each has a wrapper that throws the corresponding 
+ * exception instead.
+ */
+enum StatStatus {
+	/** The statistic was calculated */
+	STAT_OK, 
+	/** The statistic is undefined for this light curve, for example 
+	 *	because it has no variability; corresponds to except::Undefined */
+	STAT_UNDEFINED, 
+	/** The light curve is too short; corresponds to 
+	 *	except::NotEnoughData */
+	STAT_NOT_ENOUGH_DATA, 
+	/** A model fit did not converge; corresponds to std::runtime_error */
+	STAT_NO_FIT
+};
+
+/** The number of values of StatStatus */
+const size_t N_STAT_STATUS = 4;
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCSTATSTATUSH
@@ -0,0 +1,251 @@
+/** Event tracing of the stages of a simulation
+ * @file lightcurveMC/stats/trace.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "profile.h"
+#include "trace.h"
+#include "../../common/cerror.h"
+
+namespace lcmc { namespace stats {
+
+using boost::lexical_cast;
+using boost::shared_ptr;
+using std::string;
+using std::vector;
+
+/** A completed span, as recorded by TraceSpan
+ */
+struct TraceEvent {
+	TraceEvent() : name(NULL), start(0.0), duration(0.0), thread() {}
+
+	/** The name of the span, with static storage duration */
+	const char* name;
+	/** The time at which the span started, from monotonicSeconds() */
+	double start;
+	/** The length of the span, in seconds */
+	double duration;
+	/** The thread that executed the span */
+	boost::thread::id thread;
+};
+
+/** TraceBuffer holds the most recent events of a trace.
+ *
+ * Once the buffer is full, each new event replaces the oldest one, so 
+ * a trace never uses more memory than was allotted to it by startTrace().
+ */
+struct TraceBuffer {
+	TraceBuffer() : lock(), fileName(), origin(0.0), events(), next(0), 
+			recorded(0) {}
+
+	/** Protects all other members */
+	boost::mutex lock;
+	/** The file to which writeTrace() writes the events */
+	string fileName;
+	/** The time from which event times are measured */
+	double origin;
+	/** The ring buffer; its size is the capacity of the trace */
+	vector<TraceEvent> events;
+	/** The position at which the next event is stored */
+	size_t next;
+	/** The number of events recorded since startTrace() */
+	unsigned long recorded;
+};
+
+/** Returns the state of the trace
+ *
+ * @return A modifiable reference to the trace buffer.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+TraceBuffer& traceBuffer() {
+	static TraceBuffer buffer;
+	return buffer;
+}
+
+/** Returns whether trace events are being recorded
+ *
+ * @return A modifiable reference to the setting.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool& tracing() {
+	static bool trace = false;
+	return trace;
+}
+
+/** Starts recording trace events
+ *
+ * @param[in] fileName The file to which writeTrace() will write the 
+ *	events, in the Chrome trace event format.
+ * @param[in] capacity The most events to keep. If more events are 
+ *	recorded, only the most recent @p capacity are written.
+ *
+ * @post TraceSpan objects created after this call are recorded.
+ * @post Memory for @p capacity events has been reserved, and the 
+ *	trace will not allocate any more.
+ *
+ * @exception std::invalid_argument Thrown if @p capacity &le; 0.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store @p capacity events.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe. Call before any light curves are simulated.
+ */
+void startTrace(const string& fileName, long capacity) {
+	if (capacity <= 0) {
+		throw std::invalid_argument("Trace must hold at least one event (gave " 
+			+ lexical_cast<string>(capacity) + ")");
+	}
+	
+	TraceBuffer& buffer = traceBuffer();
+	vector<TraceEvent> events(capacity);
+	string name = fileName;
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	buffer.fileName.swap(name);
+	buffer.events.swap(events);
+	buffer.origin   = monotonicSeconds();
+	buffer.next     = 0;
+	buffer.recorded = 0;
+	tracing() = true;
+}
+
+/** Returns whether trace events are being recorded
+ *
+ * @return True if startTrace() has been called, and writeTrace() 
+ *	has not been called since.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool isTracing() {
+	return tracing();
+}
+
+/** Writes the recorded events to the trace file and stops recording
+ *
+ * The file can be loaded into chrome://tracing, Perfetto, or any other 
+ * viewer of the Chrome trace event format. Each thread is shown on its 
+ * own track, numbered in order of its first recorded event.
+ *
+ * @post If isTracing() was true, the file named in startTrace() contains 
+ *	the most recent events recorded by TraceSpan, in order of 
+ *	completion, and the number of older events that were discarded.
+ * @post isTracing() is false.
+ *
+ * @exception std::runtime_error Thrown if the file could not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	write the file.
+ *
+ * @exceptsafe Tracing is off in the event of an exception. The trace 
+ *	file may be incomplete.
+ *
+ * @note Not thread-safe. Call after all light curves are analyzed.
+ */
+void writeTrace() {
+	if (!isTracing()) {
+		return;
+	}
+	tracing() = false;
+	
+	TraceBuffer& buffer = traceBuffer();
+	const size_t capacity = buffer.events.size();
+	const size_t nEvents  = (buffer.recorded < capacity 
+		? static_cast<size_t>(buffer.recorded) : capacity);
+	// The oldest event is overwritten next, once the buffer is full
+	const size_t first = (buffer.recorded < capacity ? 0 : buffer.next);
+	
+	shared_ptr<FILE> hTrace = kpfutils::fileCheckOpen(buffer.fileName, "w");
+	FILE* const file = hTrace.get();
+	
+	std::map<boost::thread::id, long> threadNumbers;
+	if (fprintf(file, "{\"traceEvents\":[\n") < 0) {
+		kpfutils::fileError(file, "Could not write trace: ");
+	}
+	for(size_t i = 0; i < nEvents; i++) {
+		const TraceEvent& event = buffer.events[(first + i) % capacity];
+		
+		std::map<boost::thread::id, long>::const_iterator thread = 
+			threadNumbers.find(event.thread);
+		if (thread == threadNumbers.end()) {
+			const long id = static_cast<long>(threadNumbers.size());
+			thread = threadNumbers.insert(std::make_pair(event.thread, id)).first;
+		}
+		
+		// Chrome traces are in microseconds
+		if (fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"lcmc\",\"ph\":\"X\","
+				"\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%ld}\n", 
+				(i > 0 ? "," : ""), event.name, 
+				1e6 * (event.start - buffer.origin), 1e6 * event.duration, 
+				thread->second) < 0) {
+			kpfutils::fileError(file, "Could not write trace: ");
+		}
+	}
+	if (fprintf(file, "],\"displayTimeUnit\":\"ms\","
+			"\"otherData\":{\"recordedEvents\":%lu,\"droppedEvents\":%lu}}\n", 
+			buffer.recorded, 
+			buffer.recorded - static_cast<unsigned long>(nEvents)) < 0) {
+		kpfutils::fileError(file, "Could not write trace: ");
+	}
+	
+	vector<TraceEvent>().swap(buffer.events);
+}
+
+/** Starts a trace event
+ *
+ * @param[in] name The name of the event, as shown in the trace.
+ *
+ * @pre @p name has static storage duration, such as a string literal, 
+ *	and contains no characters that need escaping in JSON.
+ *
+ * @post If isTracing(), the time spent between construction and 
+ *	destruction of the object will be recorded as an event.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+TraceSpan::TraceSpan(const char* name) 
+		: name(isTracing() ? name : NULL), 
+		start(isTracing() ? monotonicSeconds() : 0.0) {
+}
+
+/** Records a trace event
+ *
+ * @post If tracing was on when the object was created, the event is 
+ *	stored in the trace, replacing the oldest event if the trace is full.
+ *
+ * @perform Constant time. The trace is shared by all threads, so the 
+ *	event is stored while holding a lock.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+TraceSpan::~TraceSpan() {
+	if (name != NULL && isTracing()) {
+		const double end = monotonicSeconds();
+		const boost::thread::id thread = boost::this_thread::get_id();
+		
+		TraceBuffer& buffer = traceBuffer();
+		boost::mutex::scoped_lock guard(buffer.lock);
+		TraceEvent& event = buffer.events[buffer.next];
+		event.name     = name;
+		event.start    = start;
+		event.duration = end - start;
+		event.thread   = thread;
+		buffer.next    = (buffer.next + 1) % buffer.events.size();
+		buffer.recorded++;
+	}
+}
+
+}}		// end lcmc::stats
@@ -0,0 +1,55 @@
+/** Event tracing of the stages of a simulation
+ * @file lightcurveMC/stats/trace.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+#ifndef LCMCTRACEH
+#define LCMCTRACEH
+
+#include <string>
+
+namespace lcmc { namespace stats {
+
+/** Starts recording trace events
+ */
+void startTrace(const std::string& fileName, long capacity);
+
+/** Returns whether trace events are being recorded
+ */
+bool isTracing();
+
+/** Writes the recorded events to the trace file and stops recording
+ */
+void writeTrace();
+
+/** TraceSpan records the time spent in a scope as a trace event, 
+ * if startTrace() has been called.
+ *
+ * When tracing is off, the object does not read the clock.
+ */
+class TraceSpan {
+public:
+	/** Starts a trace event
+	 */
+	explicit TraceSpan(const char* name);
+
+	/** Records a trace event
+	 */
+	~TraceSpan();
+
+private:
+	// Spans cannot be copied
+	TraceSpan(const TraceSpan&);
+	TraceSpan& operator=(const TraceSpan&);
+
+	/** The name of the event, or null if tracing is off */
+	const char* name;
+	/** The time at which the event started */
+	double start;
+};
+
+}}		// end lcmc::stats
+
+#endif		// end LCMCTRACEH
@@ -50,10 +50,68 @@ CollectedVectors::CollectedVectors(const std::string& statName, const std::strin
  * @exceptsafe The object is unchanged in the event of an exception.
  */
 void CollectedVectors::addStat(const DoubleVec& value) {
-	// DoubleVec is copyable, therefore stats.push_back() is atomic
+	// RaggedArray::push_back() is atomic
 	stats.push_back(value);
 }
 
+/** Records all the statistics stored in another collection.
+ *
+ * @param[in] other The collection whose statistics are to be copied.
+ *
+ * @pre @p other may be the same object as @p *this
+ *
+ * @post The object contains all the statistics previously stored, 
+ *	followed by all the statistics in @p other, in the same order 
+ *	as in @p other.
+ * @post The names of the object are unchanged.
+ *
+ * @perform Amortized O(N) time, where N is the total length of the 
+ *	statistics in @p other
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	to store the new statistics.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void CollectedVectors::append(const CollectedVectors& other) {
+	// RaggedArray::append() is atomic, even if other is *this
+	stats.append(other.stats);
+}
+
+/** Returns a marker for the statistics currently stored.
+ *
+ * The marker may be passed to rollback() to undo any statistics 
+ *	recorded after this call.
+ *
+ * @return The number of statistics stored in the object.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t CollectedVectors::checkpoint() const {
+	return stats.size();
+}
+
+/** Deletes all statistics recorded since a call to checkpoint().
+ *
+ * @param[in] mark The value returned by checkpoint().
+ *
+ * @pre No statistics have been removed from the object since 
+ *	@p mark was created.
+ *
+ * @post The object contains the same statistics it contained when 
+ *	checkpoint() returned @p mark. If the object has fewer than 
+ *	@p mark statistics, it is unchanged.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void CollectedVectors::rollback(size_t mark) {
+	stats.truncate(mark);
+}
+
 void CollectedVectors::printStats(FILE* const hOutput) const {
 	printStat(hOutput, stats, getFileName());
 }
@@ -62,6 +120,10 @@ void CollectedVectors::clear() {
 	stats.clear();
 }
 
+size_t CollectedVectors::memoryBytes() const {
+	return stats.memoryBytes();
+}
+
 /** Prints a header row representing the statistics printed by 
  *	printStats() to the specified file
  * 
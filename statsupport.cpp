@@ -2,7 +2,7 @@
  * @file lightcurveMC/statsupport.cpp
  * @author Krzysztof Findeisen
  * @date Created May 9, 2013
- * @date Last modified June 27, 2013
+ * @date Last modified October 14, 2026
  * 
  * The functions defined here act as an interface between the StatType 
  * parameters and the parser.
@@ -82,6 +82,9 @@ const StatRegistry& getStatRegistry() {
 		registry.insert(StatEntry("peakcut" , PEAKCUT    ));
 		registry.insert(StatEntry("peakplot", PEAKFIND   ));
 		registry.insert(StatEntry("gptau"   , GPTAU      ));
+		registry.insert(StatEntry("drwtau"  , DRWTAU     ));
+		registry.insert(StatEntry("rmsplot" , RMSPLOT    ));
+		registry.insert(StatEntry("rmspairplot", RMSPAIRPLOT));
 		
 		// No exceptions past this point
 		// To preserve the invariant in the face of exceptions, 
@@ -0,0 +1,95 @@
+/** Counts heap allocations for the benchmarks and performance tests
+ * @file lightcurveMC/tests/alloccount.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <new>
+#include <cstdlib>
+#include <boost/detail/atomic_count.hpp>
+#include "alloccount.h"
+
+/** Returns the number of times the global allocation functions have 
+ *	been called
+ *
+ * @return A counter that may be read and incremented by any thread.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::detail::atomic_count& allocCount() {
+	static boost::detail::atomic_count count(0);
+	return count;
+}
+
+/** Allocates memory, counting the call
+ *
+ * @param[in] size The number of bytes to allocate.
+ *
+ * @return A block of at least @p size bytes.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ */
+void* operator new(std::size_t size) throw(std::bad_alloc) {
+	++allocCount();
+	void* block = std::malloc(size > 0 ? size : 1);
+	if (block == NULL) {
+		throw std::bad_alloc();
+	}
+	return block;
+}
+
+/** Allocates memory for an array, counting the call
+ *
+ * @param[in] size The number of bytes to allocate.
+ *
+ * @return A block of at least @p size bytes.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ */
+void* operator new[](std::size_t size) throw(std::bad_alloc) {
+	return operator new(size);
+}
+
+/** Frees memory allocated by operator new()
+ *
+ * @param[in] block The memory to free.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void operator delete(void* block) throw() {
+	std::free(block);
+}
+
+/** Frees memory allocated by operator new[]()
+ *
+ * @param[in] block The memory to free.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void operator delete[](void* block) throw() {
+	std::free(block);
+}
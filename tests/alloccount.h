@@ -0,0 +1,45 @@
+/** Counts heap allocations for the benchmarks and performance tests
+ * @file lightcurveMC/tests/alloccount.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * Linking alloccount.o into a program replaces the global operator new 
+ * and operator delete with versions that count each allocation. 
+ * Allocations made by GSL or BLAS through malloc() are not counted.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCALLOCCOUNTH
+#define LCMCALLOCCOUNTH
+
+#include <boost/detail/atomic_count.hpp>
+
+/** Returns the number of times the global allocation functions have 
+ *	been called
+ */
+boost::detail::atomic_count& allocCount();
+
+#endif		// end LCMCALLOCCOUNTH
@@ -0,0 +1,909 @@
+/** Microbenchmarks for Lightcurve MC
+ * @file lightcurveMC/tests/benchmark.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * Times the program's hot spots on the bundled cadences, and prints one 
+ * JSON object per line so that the results can be compared between 
+ * versions. Run with <tt>make bench</tt>, or directly from the tests 
+ * directory as <tt>./benchmark [--min-time SECONDS] [FILTER]</tt>.
+ *
+ * Each record gives the time and the number of C++ heap allocations 
+ * per call. Allocations made by GSL or BLAS through malloc() are not 
+ * counted. Every benchmark is also run on prefixes of a regular 
+ * cadence of increasing length, and the fitted power of N is reported 
+ * in a record of type "scaling".
+ *
+ * With <tt>--scaling</tt>, the program instead runs every light curve 
+ * model with every statistic, on the cadences most often used for 
+ * survey planning and on random cadences of 10<sup>2</sup> to 
+ * 10<sup>5</sup> epochs. Each combination stops growing once one call 
+ * takes longer than <tt>--max-op-time</tt> seconds. <tt>--plot FILE</tt> 
+ * also writes a gnuplot script that plots the timings.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include "../../common/cerror.h"
+#include "../cadence.h"
+#include "../lightcurveparser.h"
+#include "../lightcurvetypes.h"
+#include "../mcio.h"
+#include "../paramlist.h"
+#include "../projectinfo.h"
+#include "../sims.h"
+#include "../stats/acfinterp.h"
+#include "../stats/analysiscontext.h"
+#include "../stats/gpfit.h"
+#include "../stats/lsthreshold.h"
+#include "../stats/magdist.h"
+#include "../stats/scargleacf.h"
+#include "../stats/statcollect.h"
+#include "../stats/statfamilies.h"
+#include "../waves/generators.h"
+#include "../waves/kernels.tmp.h"
+#include "alloccount.h"
+
+namespace lcmc { namespace bench {
+
+using boost::shared_ptr;
+using std::string;
+using std::vector;
+using models::Cadence;
+
+/** The longest cadence for which Fixture builds a covariance matrix
+ */
+const size_t MAX_MATRIX_SIZE = 1600;
+
+/** Light curve and precomputed inputs shared by all benchmarks of one 
+ *	cadence and length
+ */
+struct Fixture {
+	/** Prepares inputs for the first @p n times of a cadence
+	 */
+	Fixture(const string& cadenceName, const vector<double>& allTimes, 
+		size_t n, const string& modelName = "drw");
+	
+	/** The name of the cadence file */
+	string cadenceName;
+	/** The light curve type to simulate */
+	string modelName;
+	Cadence times;
+	/** A realization of modelName with white noise, sampled at times */
+	vector<double> fluxes;
+	stats::AnalysisContext lc;
+	/** A squared exponential covariance matrix over times, or null if 
+	 *	there are more than @ref MAX_MATRIX_SIZE times */
+	shared_ptr<const gsl_matrix> covar;
+	/** Uncorrelated standard normal deviates, one per time */
+	vector<double> deviates;
+};
+
+/** A function that does one operation of a benchmark
+ *
+ * The second argument counts the operations done so far, so that a 
+ * benchmark can defeat caches by changing its input on every call.
+ */
+typedef void (*BenchFunction)(const Fixture&, long);
+
+/** Describes one benchmark
+ */
+struct Benchmark {
+	const char* name;
+	BenchFunction run;
+	/** The longest cadence on which to run the benchmark, since 
+	 *	some operations take O(N<sup>3</sup>) time */
+	size_t maxSize;
+};
+
+/** Returns the random number generator used to prepare the inputs
+ *
+ * @return A generator seeded the same way on every run.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+gsl_rng* benchRng() {
+	static shared_ptr<gsl_rng> rng(gsl_rng_alloc(gsl_rng_mt19937), &gsl_rng_free);
+	return rng.get();
+}
+
+/** Returns the parameters used for every simulated light curve
+ *
+ * @param[in] tau The period or coherence time, in days.
+ *
+ * @return Values for every parameter a built-in light curve may need.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the parameters.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+models::ParamList benchParams(double tau) {
+	models::ParamList params;
+	params.add("a", 1.0);
+	params.add("p", tau);
+	params.add("ph", 0.0);
+	params.add("width", 0.1);
+	params.add("width2", 0.1);
+	params.add("d", 0.01);
+	params.add("amp2", 0.1);
+	params.add("period2", 10.0*tau);
+	return params;
+}
+
+/** Simulates a noisy light curve
+ *
+ * @param[in] modelName The light curve type to simulate.
+ * @param[in] times The times at which to sample the light curve.
+ *
+ * @return The fluxes at each time.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	simulate the light curve.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<double> benchFluxes(const string& modelName, const Cadence& times) {
+	vector<double> noise, fluxes;
+	makeWhiteNoise(times.timeView(), 0.05, noise);
+	simLightCurve(parse::parseLightCurve(modelName), benchParams(10.0), 
+		times, noise, fluxes);
+	return fluxes;
+}
+
+/** Draws uncorrelated standard normal deviates
+ *
+ * @param[in] n The number of deviates.
+ *
+ * @return The deviates.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the deviates.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<double> benchDeviates(size_t n) {
+	vector<double> deviates(n);
+	for(size_t i = 0; i < n; i++) {
+		deviates[i] = gsl_ran_ugaussian(benchRng());
+	}
+	return deviates;
+}
+
+/** Prepares inputs for the first @p n times of a cadence
+ *
+ * @param[in] cadenceName The name of the cadence file, for the output.
+ * @param[in] allTimes The times in the cadence file, in ascending order.
+ * @param[in] n The number of times to use.
+ * @param[in] modelName The light curve type to simulate.
+ *
+ * @pre @p n &le; @p allTimes.size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	prepare the inputs.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+Fixture::Fixture(const string& cadenceName, const vector<double>& allTimes, 
+		size_t n, const string& modelName) 
+		: cadenceName(cadenceName), modelName(modelName), 
+		times(vector<double>(allTimes.begin(), allTimes.begin() + n)), 
+		fluxes(benchFluxes(modelName, times)), lc(times, fluxes), 
+		covar(n <= MAX_MATRIX_SIZE ? models::kernelMatrix(times.timeView(), 
+			models::SquaredExpKernel(1.0, 10.0)) : shared_ptr<gsl_matrix>()), 
+		deviates(benchDeviates(n)) {
+}
+
+/** Times utils::multiNormal() on a covariance it has factored before
+ */
+void benchMultiNormal(const Fixture& data, long) {
+	vector<double> result;
+	utils::multiNormal(data.deviates, data.covar, result);
+}
+
+/** Times utils::multiNormal() on a new covariance each call, 
+ *	including the cost of building the matrix
+ */
+void benchMultiNormalFactor(const Fixture& data, long op) {
+	const shared_ptr<const gsl_matrix> covar = models::kernelMatrix(
+		data.times.timeView(), 
+		models::SquaredExpKernel(1.0, 10.0*(1.0 + 1e-6*(op+1))));
+	vector<double> result;
+	utils::multiNormal(data.deviates, covar, result);
+}
+
+/** Simulates one light curve of a given type
+ *
+ * @param[in] data The cadence to simulate.
+ * @param[in] op The number of operations done so far. The period or 
+ *	coherence time changes with each operation, so that each call 
+ *	computes the covariance or the process coefficients anew.
+ * @param[in] name The name of the light curve type.
+ */
+void benchModel(const Fixture& data, long op, const char* name) {
+	const models::ParamList params = benchParams(10.0*(1.0 + 1e-6*(op+1)));
+	const std::auto_ptr<models::ILightCurve> model = makeLightCurve(
+		parse::parseLightCurve(name), params, data.times);
+	vector<double> fluxes;
+	model->getFluxes(fluxes);
+}
+
+void benchWhiteNoise(const Fixture& data, long op) {
+	benchModel(data, op, "white_noise");
+}
+
+void benchRandomWalk(const Fixture& data, long op) {
+	benchModel(data, op, "walk");
+}
+
+void benchDampedWalk(const Fixture& data, long op) {
+	benchModel(data, op, "drw");
+}
+
+void benchSimpleGp(const Fixture& data, long op) {
+	benchModel(data, op, "simple_gp");
+}
+
+void benchTwoScaleGp(const Fixture& data, long op) {
+	benchModel(data, op, "two_gp");
+}
+
+void benchSine(const Fixture& data, long op) {
+	benchModel(data, op, "sine");
+}
+
+void benchSimulate(const Fixture& data, long op) {
+	benchModel(data, op, data.modelName.c_str());
+}
+
+/** Calculates the periodogram and its peak
+ *
+ * @param[in] data The light curve to analyze.
+ * @param[in] method The periodogram algorithm to use.
+ */
+void benchPeriodogram(const Fixture& data, stats::PeriodogramMethod method) {
+	stats::CollectedScalars periods("period", "", false);
+	stats::CollectedPairs periodograms("periodogram", "");
+	stats::doPeriodogram(data.lc, true, true, method, periods, periodograms);
+}
+
+void benchPeriodogramDirect(const Fixture& data, long) {
+	benchPeriodogram(data, stats::LS_DIRECT);
+}
+
+void benchPeriodogramFast(const Fixture& data, long) {
+	benchPeriodogram(data, stats::LS_FAST);
+}
+
+void benchDmdt(const Fixture& data, long) {
+	stats::CollectedScalars cut50Amp3("", "", false), cut50Amp2("", "", false), 
+		cut90Amp3("", "", false), cut90Amp2("", "", false);
+	stats::CollectedPairs dmdtMed("", "");
+	stats::doDmdt(data.lc, true, true, cut50Amp3, cut50Amp2, 
+		cut90Amp3, cut90Amp2, dmdtMed);
+}
+
+/** Same signature as stats::interp::autoCorr(), so that doAcf() can 
+ *	use ScargleAcfPlan the way the simulations do
+ */
+void scargleAcf(const vector<double>& times, const vector<double>& data, 
+		double offStep, size_t nOffsets, vector<double>& acf) {
+	stats::ScargleAcfPlan::forCadence(times, offStep, nOffsets)->autoCorr(data, acf);
+}
+
+/** Same as scargleAcf(), but evaluates only the lags that doAcf() uses
+ */
+void scargleLagAcf(const vector<double>& times, const vector<double>& data, 
+		double offStep, size_t nOffsets, const vector<size_t>& lags, 
+		double level, vector<double>& acf) {
+	stats::ScargleAcfPlan::forCadence(times, offStep, nOffsets)->autoCorr(data, 
+		lags, level, acf);
+}
+
+/** Calculates one flavor of ACF and its cuts
+ *
+ * @param[in] data The light curve to analyze.
+ * @param[in] acfFunc The ACF algorithm to use.
+ * @param[in] lagFunc The algorithm to use for selected lags, if any.
+ */
+void benchAcf(const Fixture& data, void (*acfFunc) (const vector<double>&, 
+		const vector<double>&, double, size_t, vector<double>&), 
+		void (*lagFunc) (const vector<double>&, const vector<double>&, 
+		double, size_t, const vector<size_t>&, double, 
+		vector<double>&) = NULL) {
+	stats::CollectedScalars cut9("", "", false), cut4("", "", false), 
+		cut2("", "", false);
+	stats::CollectedPairs acfPlot("", "");
+	stats::doAcf(data.lc, acfFunc, true, true, cut9, cut4, cut2, acfPlot, 
+		lagFunc);
+}
+
+void benchAcfInterp(const Fixture& data, long) {
+	benchAcf(data, &stats::interp::autoCorr);
+}
+
+void benchAcfScargle(const Fixture& data, long) {
+	benchAcf(data, &scargleAcf, &scargleLagAcf);
+}
+
+void benchPeak(const Fixture& data, long) {
+	stats::CollectedScalars cut3("", "", false), cut2("", "", false), 
+		cut80("", "", false);
+	stats::CollectedPairs peakPlot("", "");
+	stats::doPeak(data.lc, true, true, cut3, cut2, cut80, peakPlot);
+}
+
+void benchGpFit(const Fixture& data, long) {
+	double timescale, timeError;
+	stats::fitGaussGp(data.lc.getTimes(), data.lc.getMags(), timescale, timeError);
+}
+
+void benchC1(const Fixture& data, long) {
+	stats::getC1(data.lc.getMags());
+}
+
+/** Every benchmark, in the order they are run
+ */
+const Benchmark BENCHMARKS[] = {
+	{"multiNormal",          &benchMultiNormal,       1600}, 
+	{"multiNormal/factor",   &benchMultiNormalFactor,  800}, 
+	{"model/white_noise",    &benchWhiteNoise,        1600}, 
+	{"model/walk",           &benchRandomWalk,       10000}, 
+	{"model/drw",            &benchDampedWalk,       10000}, 
+	{"model/simple_gp",      &benchSimpleGp,           800}, 
+	{"model/two_gp",         &benchTwoScaleGp,         800}, 
+	{"model/sine",           &benchSine,             10000}, 
+	{"doPeriodogram/direct", &benchPeriodogramDirect, 1600}, 
+	{"doPeriodogram/fast",   &benchPeriodogramFast,  10000}, 
+	{"doDmdt",               &benchDmdt,              3200}, 
+	{"doAcf/interp",         &benchAcfInterp,         3200}, 
+	{"doAcf/scargle",        &benchAcfScargle,       10000}, 
+	{"doPeak",               &benchPeak,             10000}, 
+	{"fitGaussGp",           &benchGpFit,              400}, 
+	{"getC1",                &benchC1,               10000}
+};
+
+/** Everything --scaling times for each light curve model
+ *
+ * The maximum sizes keep the matrices of the Gaussian process fit, and 
+ * the direct periodogram's false alarm simulations, within a day's run.
+ */
+const Benchmark STATISTICS[] = {
+	{"simulate",             &benchSimulate,         100000}, 
+	{"getC1",                &benchC1,               100000}, 
+	{"doPeriodogram/direct", &benchPeriodogramDirect, 10000}, 
+	{"doPeriodogram/fast",   &benchPeriodogramFast,  100000}, 
+	{"doDmdt",               &benchDmdt,             100000}, 
+	{"doAcf/interp",         &benchAcfInterp,        100000}, 
+	{"doAcf/scargle",        &benchAcfScargle,       100000}, 
+	{"doPeak",               &benchPeak,             100000}, 
+	{"fitGaussGp",           &benchGpFit,             10000}
+};
+
+/** The bundled irregular cadences, from sparsest to densest */
+const char* const CADENCES[] = {"ysovarjds.txt", "ptfjds.txt", "ptfjds_all.txt"};
+
+/** The bundled cadences timed by --scaling, besides the random ones */
+const char* const SURVEY_CADENCES[] = {"logsampling.txt", "ptfjds_2010-12.txt", 
+	"ptfjds.txt", "ptfjds_all.txt", "hicadence.txt"};
+
+/** The regular cadence used to find how each benchmark scales with N, 
+ *	so that only the number of points changes between runs */
+const char* const SCALING_CADENCE = "hicadence.txt";
+
+/** Returns the current time
+ *
+ * @return The time, in nanoseconds since an arbitrary starting point.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double nowNs() {
+	namespace pt = boost::posix_time;
+	static const pt::ptime start = pt::microsec_clock::universal_time();
+	return 1000.0 * (pt::microsec_clock::universal_time() - start).total_microseconds();
+}
+
+/** Times one benchmark on one input
+ *
+ * @param[in] bench The benchmark to run.
+ * @param[in] data The input to run it on.
+ * @param[in] minTime The least time, in seconds, to spend timing.
+ * @param[out] firstNs The time taken by the first call, which also 
+ *	fills any caches.
+ *
+ * @return The time per operation, in nanoseconds.
+ *
+ * @post Prints a record of type "result" to standard output.
+ *
+ * @exception std::runtime_error Thrown if the benchmark fails. 
+ *	Additional exceptions may be thrown by the benchmark.
+ */
+double runBenchmark(const Benchmark& bench, const Fixture& data, double minTime, 
+		double& firstNs) {
+	// The first call fills any caches, as in a real run
+	const double firstStart = nowNs();
+	bench.run(data, 0);
+	firstNs = nowNs() - firstStart;
+	
+	// An operation slower than minTime needs only one timed call
+	const long minOps = (firstNs > 1e9*minTime ? 1 : 3);
+	long ops = 0;
+	const long startAllocs = allocCount();
+	const double start = nowNs();
+	double elapsed = 0.0;
+	while (elapsed < 1e9*minTime || ops < minOps) {
+		bench.run(data, ops + 1);
+		ops++;
+		elapsed = nowNs() - start;
+	}
+	const long allocs = allocCount() - startAllocs;
+	
+	const double nsPerOp = elapsed / ops;
+	printf("{\"type\": \"result\", \"version\": \"%s\", \"benchmark\": \"%s\", "
+		"\"model\": \"%s\", \"cadence\": \"%s\", \"n\": %lu, \"ops\": %ld, "
+		"\"ns_per_op\": %.4g, \"first_ns\": %.4g, \"allocs_per_op\": %.4g}\n", 
+		VERSION_STRING, bench.name, data.modelName.c_str(), 
+		data.cadenceName.c_str(), 
+		static_cast<unsigned long>(data.times.size()), ops, 
+		nsPerOp, firstNs, static_cast<double>(allocs) / ops);
+	fflush(stdout);
+	return nsPerOp;
+}
+
+/** Reads a cadence file
+ *
+ * @param[in] fileName The file to read.
+ *
+ * @return The times in the file, in ascending order.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the file could not 
+ *	be read.
+ */
+vector<double> readCadence(const string& fileName) {
+	vector<double> times;
+	readTimeStampFile(fileName, times);
+	std::sort(times.begin(), times.end());
+	return times;
+}
+
+/** Finds the power of N that best describes a set of timings
+ *
+ * @param[in] sizes The lengths of the inputs.
+ * @param[in] nsPerOp The time per operation for each length.
+ *
+ * @pre @p sizes.size() = @p nsPerOp.size() &ge; 2
+ *
+ * @return The least-squares slope of log(@p nsPerOp) against log(@p sizes).
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double scalingExponent(const vector<size_t>& sizes, const vector<double>& nsPerOp) {
+	const size_t n = sizes.size();
+	double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+	for(size_t i = 0; i < n; i++) {
+		const double x = log(static_cast<double>(sizes[i]));
+		const double y = log(nsPerOp[i]);
+		sumX  += x;
+		sumY  += y;
+		sumXX += x*x;
+		sumXY += x*y;
+	}
+	return (n*sumXY - sumX*sumY) / (n*sumXX - sumX*sumX);
+}
+
+/** Prints the fitted power of N for one benchmark
+ *
+ * @param[in] benchName The name of the benchmark.
+ * @param[in] modelName The light curve type it was run on.
+ * @param[in] cadenceName The cadence whose length was varied.
+ * @param[in] sizes The lengths of the inputs.
+ * @param[in] nsPerOp The time per operation for each length.
+ *
+ * @pre @p sizes.size() = @p nsPerOp.size()
+ *
+ * @post If there are at least two timings, prints a record of type 
+ *	"scaling" to standard output.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void printScaling(const string& benchName, const string& modelName, 
+		const string& cadenceName, 
+		const vector<size_t>& sizes, const vector<double>& nsPerOp) {
+	if (sizes.size() >= 2) {
+		printf("{\"type\": \"scaling\", \"version\": \"%s\", \"benchmark\": \"%s\", "
+			"\"model\": \"%s\", \"cadence\": \"%s\", \"n_min\": %lu, \"n_max\": %lu, "
+			"\"exponent\": %.3f}\n", 
+			VERSION_STRING, benchName.c_str(), modelName.c_str(), 
+			cadenceName.c_str(), 
+			static_cast<unsigned long>(sizes.front()), 
+			static_cast<unsigned long>(sizes.back()), 
+			scalingExponent(sizes, nsPerOp));
+		fflush(stdout);
+	}
+}
+
+/** The name given to random cadences in the output */
+const char* const RANDOM_CADENCE = "random";
+
+/** Draws a random cadence
+ *
+ * @param[in] n The number of times.
+ *
+ * @return @p n times drawn uniformly over three years, in ascending 
+ *	order. The times depend only on @p n.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the times.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<double> randomCadence(size_t n) {
+	static shared_ptr<gsl_rng> rng(gsl_rng_alloc(gsl_rng_mt19937), &gsl_rng_free);
+	gsl_rng_set(rng.get(), n);
+	
+	vector<double> times(n);
+	for(size_t i = 0; i < n; i++) {
+		times[i] = gsl_rng_uniform(rng.get()) * 3.0 * 365.25;
+	}
+	std::sort(times.begin(), times.end());
+	return times;
+}
+
+/** One timing reported by --scaling
+ */
+struct ScalingPoint {
+	string benchmark;
+	string model;
+	size_t n;
+	double nsPerOp;
+};
+
+/** Times one benchmark on one input, reporting failures
+ *
+ * @param[in] bench The benchmark to run.
+ * @param[in] data The input to run it on.
+ * @param[in] minTime The least time, in seconds, to spend timing.
+ * @param[out] firstNs The time taken by the first call.
+ * @param[out] nsPerOp The time per operation, in nanoseconds.
+ *
+ * @return True if the benchmark ran, false if it threw an exception.
+ *
+ * @post Prints a record of type "result" to standard output, or one 
+ *	of type "error" if the benchmark failed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool tryBenchmark(const Benchmark& bench, const Fixture& data, double minTime, 
+		double& firstNs, double& nsPerOp) {
+	try {
+		nsPerOp = runBenchmark(bench, data, minTime, firstNs);
+		return true;
+	} catch (const std::exception& e) {
+		printf("{\"type\": \"error\", \"version\": \"%s\", \"benchmark\": \"%s\", "
+			"\"model\": \"%s\", \"cadence\": \"%s\", \"n\": %lu, "
+			"\"what\": \"%s\"}\n", 
+			VERSION_STRING, bench.name, data.modelName.c_str(), 
+			data.cadenceName.c_str(), 
+			static_cast<unsigned long>(data.times.size()), e.what());
+		fflush(stdout);
+		return false;
+	}
+}
+
+/** Tests whether a light curve type is simulated from its covariance 
+ *	matrix, which needs O(N<sup>2</sup>) memory
+ *
+ * @param[in] modelName The light curve type.
+ *
+ * @return True for the Gaussian processes, false otherwise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool isMatrixModel(const string& modelName) {
+	return modelName == "simple_gp" || modelName == "two_gp";
+}
+
+/** Times every statistic on one model and all cadences
+ *
+ * Random cadences are timed from the shortest to the longest, and each 
+ * statistic stops at the first length where one call takes longer than 
+ * @p maxOpTime. The bundled cadences are timed only up to the same 
+ * length.
+ *
+ * @param[in] modelName The light curve type to simulate.
+ * @param[in] filter A string that the name "model/benchmark" must 
+ *	contain for the combination to be timed.
+ * @param[in] minTime The least time, in seconds, to spend timing each 
+ *	combination.
+ * @param[in] maxOpTime The longest time, in seconds, a single call may 
+ *	take before longer cadences are skipped.
+ * @param[out] points The timings on random cadences, to which the new 
+ *	timings will be appended.
+ *
+ * @post Prints records of type "result" and "scaling" to standard output. 
+ *	Combinations that fail print a record of type "error" instead.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	prepare the inputs.
+ * @exception kpfutils::except::FileIo Thrown if a bundled cadence 
+ *	could not be read.
+ */
+void scaleModel(const string& modelName, const string& filter, double minTime, 
+		double maxOpTime, vector<ScalingPoint>& points) {
+	const size_t nStats = sizeof(STATISTICS) / sizeof(STATISTICS[0]);
+	const double maxOpNs = 1e9*maxOpTime;
+	
+	vector<bool> selected(nStats);
+	vector<size_t> limit(nStats);
+	vector<vector<size_t> > sizes(nStats);
+	vector<vector<double> > nsPerOp(nStats);
+	bool any = false;
+	for(size_t s = 0; s < nStats; s++) {
+		selected[s] = (modelName + "/" + STATISTICS[s].name).find(filter) 
+			!= string::npos;
+		limit[s] = STATISTICS[s].maxSize;
+		any = any || selected[s];
+	}
+	if (!any) {
+		return;
+	}
+	size_t modelLimit = (isMatrixModel(modelName) ? 10000 : 100000);
+	
+	// 10^2, 10^2.5, ..., 10^5 epochs
+	for(int k = 0; k <= 6; k++) {
+		const size_t n = static_cast<size_t>(floor(pow(10.0, 2.0 + 0.5*k) + 0.5));
+		if (n > modelLimit) {
+			break;
+		}
+		const double start = nowNs();
+		const Fixture data(RANDOM_CADENCE, randomCadence(n), n, modelName);
+		if (nowNs() - start > maxOpNs) {
+			modelLimit = n;
+		}
+		
+		for(size_t s = 0; s < nStats; s++) {
+			double firstNs = 0.0, ns = 0.0;
+			if (selected[s] && n <= limit[s]) {
+				if (!tryBenchmark(STATISTICS[s], data, minTime, firstNs, ns)) {
+					limit[s] = 0;
+					continue;
+				}
+				sizes[s].push_back(n);
+				nsPerOp[s].push_back(ns);
+				const ScalingPoint point = {STATISTICS[s].name, modelName, n, ns};
+				points.push_back(point);
+				if (firstNs > maxOpNs || ns > maxOpNs) {
+					limit[s] = n;
+				}
+			}
+		}
+	}
+	for(size_t s = 0; s < nStats; s++) {
+		printScaling(STATISTICS[s].name, modelName, RANDOM_CADENCE, 
+			sizes[s], nsPerOp[s]);
+	}
+	
+	for(size_t c = 0; c < sizeof(SURVEY_CADENCES) / sizeof(SURVEY_CADENCES[0]); c++) {
+		const vector<double> allTimes = readCadence(SURVEY_CADENCES[c]);
+		if (allTimes.size() > modelLimit) {
+			continue;
+		}
+		const Fixture data(SURVEY_CADENCES[c], allTimes, allTimes.size(), modelName);
+		for(size_t s = 0; s < nStats; s++) {
+			double firstNs = 0.0, ns = 0.0;
+			if (selected[s] && allTimes.size() <= limit[s]) {
+				tryBenchmark(STATISTICS[s], data, minTime, firstNs, ns);
+			}
+		}
+	}
+	}
+
+/** Writes a gnuplot script that plots time against N for every 
+ *	statistic timed by --scaling
+ *
+ * The script draws one page per statistic, with one line per model, 
+ * to a PostScript file named after the script.
+ *
+ * @param[in] fileName The script to write.
+ * @param[in] points The timings to plot.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the script could not 
+ *	be written.
+ */
+void writePlot(const string& fileName, const vector<ScalingPoint>& points) {
+	shared_ptr<FILE> hPlot = kpfutils::fileCheckOpen(fileName, "w");
+	FILE* const file = hPlot.get();
+	
+	if (fprintf(file, "# Timings from benchmark --scaling, version %s\n"
+			"set terminal postscript color\n"
+			"set output '%s.ps'\n"
+			"set logscale xy\n"
+			"set xlabel 'Number of epochs'\n"
+			"set ylabel 'Time per call (ns)'\n"
+			"set key outside right\n", 
+			VERSION_STRING, fileName.c_str()) < 0) {
+		kpfutils::fileError(file, "Could not write plot script: ");
+	}
+	
+	for(size_t s = 0; s < sizeof(STATISTICS) / sizeof(STATISTICS[0]); s++) {
+		const string stat = STATISTICS[s].name;
+		vector<string> models;
+		for(vector<ScalingPoint>::const_iterator it = points.begin(); 
+				it != points.end(); it++) {
+			if (it->benchmark == stat && std::find(models.begin(), 
+					models.end(), it->model) == models.end()) {
+				models.push_back(it->model);
+			}
+		}
+		if (models.empty()) {
+			continue;
+		}
+		
+		if (fprintf(file, "set title '%s'\nplot ", stat.c_str()) < 0) {
+			kpfutils::fileError(file, "Could not write plot script: ");
+		}
+		for(size_t m = 0; m < models.size(); m++) {
+			if (fprintf(file, "%s'-' using 1:2 with linespoints title '%s'", 
+					(m > 0 ? ", " : ""), models[m].c_str()) < 0) {
+				kpfutils::fileError(file, "Could not write plot script: ");
+			}
+		}
+		fputc('\n', file);
+		for(size_t m = 0; m < models.size(); m++) {
+			for(vector<ScalingPoint>::const_iterator it = points.begin(); 
+					it != points.end(); it++) {
+				if (it->benchmark == stat && it->model == models[m]) {
+					if (fprintf(file, "%lu %.4g\n", 
+							static_cast<unsigned long>(it->n), 
+							it->nsPerOp) < 0) {
+						kpfutils::fileError(file, "Could not write plot script: ");
+					}
+				}
+			}
+			if (fprintf(file, "e\n") < 0) {
+				kpfutils::fileError(file, "Could not write plot script: ");
+			}
+		}
+	}
+	
+	if (fflush(file) != 0) {
+		kpfutils::fileError(file, "Could not write plot script: ");
+	}
+}
+
+}}		// end lcmc::bench
+
+/** Runs all the benchmarks whose name contains a filter
+ *
+ * @param[in] argc The number of command-line arguments.
+ * @param[in] argv The arguments: an optional <tt>--min-time SECONDS</tt>, 
+ *	an optional <tt>--scaling</tt> with its options 
+ *	<tt>--max-op-time SECONDS</tt> and <tt>--plot FILE</tt>, 
+ *	and an optional filter.
+ *
+ * @return 0 if every benchmark ran, 1 otherwise.
+ */
+int main(int argc, char* argv[]) {
+	using namespace lcmc::bench;
+	
+	double minTime = 0.2;
+	bool scaling = false;
+	double maxOpTime = 2.0;
+	string plotFile;
+	string filter;
+	for(int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--min-time") == 0 && i+1 < argc) {
+			minTime = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--scaling") == 0) {
+			scaling = true;
+		} else if (strcmp(argv[i], "--max-op-time") == 0 && i+1 < argc) {
+			maxOpTime = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--plot") == 0 && i+1 < argc) {
+			plotFile = argv[++i];
+		} else {
+			filter = argv[i];
+		}
+	}
+	
+	try {
+		// Neither the threshold nor the fits should depend on R or 
+		//	on other threads
+		lcmc::stats::setThresholdThreads(1);
+		lcmc::stats::setGpFitMethod(lcmc::stats::GPFIT_NATIVE);
+		
+		if (scaling) {
+			const vector<string> models = lcmc::parse::lightCurveTypes();
+			vector<ScalingPoint> points;
+			for(size_t m = 0; m < models.size(); m++) {
+				scaleModel(models[m], filter, minTime, maxOpTime, points);
+			}
+			if (!plotFile.empty()) {
+				writePlot(plotFile, points);
+			}
+			return 0;
+		}
+		
+		const size_t nBench = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+		
+		for(size_t c = 0; c < sizeof(CADENCES) / sizeof(CADENCES[0]); c++) {
+			const vector<double> allTimes = readCadence(CADENCES[c]);
+			const Fixture data(CADENCES[c], allTimes, allTimes.size());
+			for(size_t b = 0; b < nBench; b++) {
+				if (strstr(BENCHMARKS[b].name, filter.c_str()) != NULL 
+						&& allTimes.size() <= BENCHMARKS[b].maxSize) {
+					double firstNs = 0.0;
+					runBenchmark(BENCHMARKS[b], data, minTime, firstNs);
+				}
+			}
+		}
+		
+		const vector<double> scalingTimes = readCadence(SCALING_CADENCE);
+		vector<size_t> sizes;
+		for(size_t n = 100; n <= scalingTimes.size(); n *= 2) {
+			sizes.push_back(n);
+		}
+		vector<boost::shared_ptr<const Fixture> > scalingData;
+		for(size_t i = 0; i < sizes.size(); i++) {
+			scalingData.push_back(boost::shared_ptr<const Fixture>(
+				new Fixture(SCALING_CADENCE, scalingTimes, sizes[i])));
+		}
+		for(size_t b = 0; b < nBench; b++) {
+			if (strstr(BENCHMARKS[b].name, filter.c_str()) == NULL) {
+				continue;
+			}
+			vector<size_t> runSizes;
+			vector<double> nsPerOp;
+			for(size_t i = 0; i < sizes.size() && sizes[i] <= BENCHMARKS[b].maxSize; i++) {
+				double firstNs = 0.0;
+				runSizes.push_back(sizes[i]);
+				nsPerOp.push_back(runBenchmark(BENCHMARKS[b], *scalingData[i], 
+					minTime, firstNs));
+			}
+			printScaling(BENCHMARKS[b].name, scalingData.front()->modelName, 
+				SCALING_CADENCE, runSizes, nsPerOp);
+		}
+	} catch (const std::exception &e) {
+		fprintf(stderr, "ERROR: %s\n", e.what());
+		return 1;
+	}
+	
+	return 0;
+}
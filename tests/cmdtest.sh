@@ -2,6 +2,8 @@
 
 # Tests the command-line interface
 rm -vf cmdtest_*.log
+rm -vf cmdtest_grid.txt
+rm -vf run_c1_magsine_a1.00_p0.25_p0.00_n0.01*.dat
 rm -vf nonspitzernonvar.cat
 #ln will print error message on failure
 ln -vs test1.cat nonspitzernonvar.cat || exit $?
@@ -129,6 +131,79 @@ nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --add NonSpit
 	-s C1 -s dmdtcut magsine \
 	&>> cmdtest_xor.log
 
+# --grid must reject malformed files with the line at fault
+echo "EXPECTED RESULT: FAIL (missing grid file)" &>> cmdtest_grid.log
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid nosuchgrid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+echo "EXPECTED RESULT: FAIL (unknown grid parameter)" &>> cmdtest_grid.log
+printf 'a 1.0 1.0 q 0.5 0.5\n' > cmdtest_grid.txt
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid cmdtest_grid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+echo "EXPECTED RESULT: FAIL (grid range with one number)" &>> cmdtest_grid.log
+printf '# amplitude only\na 1.0\n' > cmdtest_grid.txt
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid cmdtest_grid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+echo "EXPECTED RESULT: FAIL (grid range that is not a number)" &>> cmdtest_grid.log
+printf 'a 1.0 x\n' > cmdtest_grid.txt
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid cmdtest_grid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+echo "EXPECTED RESULT: FAIL (negative grid range)" &>> cmdtest_grid.log
+printf 'a -1.0 1.0\n' > cmdtest_grid.txt
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid cmdtest_grid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+echo "EXPECTED RESULT: FAIL (grid phase outside [0, 1])" &>> cmdtest_grid.log
+printf 'ph 0.5 2.0\n' > cmdtest_grid.txt
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid cmdtest_grid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+echo "EXPECTED RESULT: FAIL (grid parameter repeated)" &>> cmdtest_grid.log
+printf 'a 1.0 1.0 a 2.0 2.0\n' > cmdtest_grid.txt
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid cmdtest_grid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+echo "EXPECTED RESULT: FAIL (grid bins with different parameters)" &>> cmdtest_grid.log
+printf 'a 1.0 1.0\n\na 2.0 2.0 width 0.1 0.1\n' > cmdtest_grid.txt
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid cmdtest_grid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+echo "EXPECTED RESULT: FAIL (grid with no bins)" &>> cmdtest_grid.log
+printf '# no bins\n\n   \n' > cmdtest_grid.txt
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --grid cmdtest_grid.txt ptfjds.txt \
+	-s C1 magsine \
+	&>> cmdtest_grid.log
+
+rm -f cmdtest_grid.txt
+
+# Distribution files must say which units --noise is in
+echo "EXPECTED RESULT: noise in flux units" &>> cmdtest_units.log
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --noise 0.01 ptfjds.txt \
+	-s C1 magsine \
+	&> /dev/null
+ls run_c1_magsine_a1.00_p0.25_p0.00_n0.01*.dat &>> cmdtest_units.log
+rm -f run_c1_magsine_a1.00_p0.25_p0.00_n0.01*.dat
+
+echo "EXPECTED RESULT: noise in magnitudes" &>> cmdtest_units.log
+nice -n 15 ../lightcurveMC -a "1.0 1.0" -p "0.25 0.25" --ntrials 5 --noise 0.01 --magnitudes ptfjds.txt \
+	-s C1 magsine \
+	&> /dev/null
+ls run_c1_magsine_a1.00_p0.25_p0.00_n0.01*.dat &>> cmdtest_units.log
+rm -f run_c1_magsine_a1.00_p0.25_p0.00_n0.01*.dat
+
+diff -s cmdtarget_units.log cmdtest_units.log
+diff -s cmdtarget_grid.log cmdtest_grid.log
 diff -s cmdtarget_xor.log cmdtest_xor.log
 diff -s cmdtarget_domain.log cmdtest_domain.log
 # diff returns 0 iff files are equal
@@ -1,17 +1,20 @@
 #!/bin/bash
 
 rm -vf paradoxgrid_snr*.log
-alias lightcurveMC="nice -n 15 /cygdrive/c/krzys/softdev/CPP/astroapps/lightcurveMC-stable/lightcurveMC"
+# Aliases are not expanded in scripts, so use a function to run the in-tree build
+lightcurveMC()
+{
+	nice -n 15 ../lightcurveMC "$@"
+}
 
 oldoptions=$(set +o); oldoptions=${oldoptions//set /; set }; oldoptions=${oldoptions/#;/}
 set +o noclobber
 
-doGridPoint()
+addGridPoint()
 {
-	# $1 is output file
+	# $1 is grid file
 	# $2 is 5-95% amplitude
 	# $3 is timescale
-	# $4 is noise
 
 	# Convert 5-95% amplitudes to amplitude parameters
 	# Half-amplitude for sine
@@ -21,14 +24,10 @@ doGridPoint()
 	# Diffusion coefficient for DRW
 	diffus=$( echo "scale=10; 2 * $gaussAmp / $3" | bc )
 	
-        echo "Output File:" $1
         echo "Amplitude:"   $2
         echo "Timescale:"   $3
-        echo "Noise:"       $4
 
-	lightcurveMC -a "$gaussAmp $gaussAmp" -d "$diffus $diffus" -p "$3 $3" --noise $4 paradox_ptfjds.txt \
-	 	drw simple_gp --print 4 \
-	 	>> $1
+	echo "a $gaussAmp $gaussAmp d $diffus $diffus p $3 $3" >> $1
 }
 
 unset amps
@@ -44,13 +43,23 @@ snrs=(1e6)
 total=$((${#amps[@]}*${#times[@]}*${#noises[@]}))
 echo "Generating light curves over" $total "parameter bins."
 
-for a in ${amps[@]} ; do 
-	for t in ${times[@]} ; do 
-		for ((i=0; i<${#noises[@]}; i++)) ; do 
-			doGridPoint paradoxgrid_snr${snrs[$i]}.log $a $t ${noises[$i]}
+# Every bin with the same noise runs in one process, sharing its caches
+gridFile=paradoxgrid_bins.txt
+for ((i=0; i<${#noises[@]}; i++)) ; do 
+	rm -f $gridFile
+	for a in ${amps[@]} ; do 
+		for t in ${times[@]} ; do 
+			addGridPoint $gridFile $a $t
 		done
 	done
+	
+        echo "Output File:" paradoxgrid_snr${snrs[$i]}.log
+        echo "Noise:"       ${noises[$i]}
+	lightcurveMC --grid $gridFile --noise ${noises[$i]} paradox_ptfjds.txt \
+	 	drw simple_gp --print 4 \
+	 	>> paradoxgrid_snr${snrs[$i]}.log
 done
+rm -f $gridFile
 
 eval $oldoptions
 echo "Simulation complete."
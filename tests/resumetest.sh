@@ -0,0 +1,62 @@
+#!/bin/bash
+
+# Test case for interrupted runs
+# A run killed after its first checkpoint and continued with --resume 
+#	must give the same table and distribution files as an 
+#	uninterrupted run (see threadtest.sh)
+
+rm -vf run_*.dat
+rm -rvf resumetest_full
+rm -vf resumetest_*.log resumetest_*.txt
+status=0
+
+# Enough light curves that the run usually outlives its first checkpoint
+lightcurveMC() {
+	nice -n 15 ../lightcurveMC -a "0.25 0.25" -d "0.115 0.115" -p "0.1 0.1" --ntrials 200 --noise 0.05 ptfjds.txt \
+		white_noise drw --seed 42 --flush-every 20 \
+		--stat C1 --stat dmdtcut --stat dmdtplot \
+		--stat iacfcut --stat iacfplot --stat peakcut --stat peakplot \
+		"$@"
+}
+
+lightcurveMC --checkpoint resumetest_full.txt > resumetest_full.log
+status=$(($status || $?))
+mkdir resumetest_full
+mv run_*.dat resumetest_full/
+
+# Interrupt the run once it has saved its progress
+lightcurveMC --checkpoint resumetest_part.txt > resumetest_killed.log &
+pid=$!
+while [ ! -e resumetest_part.txt ] && kill -0 $pid 2> /dev/null ; do
+	sleep 0.1
+done
+kill -9 $pid 2> /dev/null
+wait $pid 2> /dev/null
+if [ ! -e resumetest_part.txt ] ; then
+	echo "No checkpoint was written before the run ended."
+	status=1
+fi
+
+lightcurveMC --checkpoint resumetest_part.txt --resume > resumetest_resumed.log
+status=$(($status || $?))
+
+diff -s resumetest_full.log resumetest_resumed.log
+status=$(($status || $?))
+
+# The checkpoint's parts end where it flushed, so resuming with 
+#	different flushing must be refused
+if lightcurveMC --checkpoint resumetest_full.txt --resume --memory-limit 100 \
+		> resumetest_mismatch.log 2>&1 ; then
+	echo "A checkpoint was resumed with a different --memory-limit."
+	status=1
+elif ! grep -q "memory-limit" resumetest_mismatch.log ; then
+	echo "A mismatched checkpoint was refused for the wrong reason."
+	status=1
+fi
+
+for file in resumetest_full/run_*.dat ; do
+	diff -s $file $(basename $file)
+	status=$(($status || $?))
+done
+
+exit $status
@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# Test case for runs split into shards
+# Merging the shards of a run must print the same table, and write the
+#	same distribution files, as running it in a single process (see
+#	threadtest.sh)
+
+rm -vf run_*.dat
+rm -vf shard_*_of_3.txt
+rm -vf shardtest_*.log
+rm -rvf shardtest_single
+status=0
+
+lightcurveMC() {
+	nice -n 15 ../lightcurveMC -a "0.25 0.25" -d "0.115 0.115" -p "0.1 0.1" --ntrials 20 --noise 0.05 ptfjds.txt \
+		white_noise drw --seed 42 \
+		--stat C1 --stat dmdtcut --stat iacfcut --stat sacfcut --stat peakcut \
+		"$@"
+}
+
+lightcurveMC > shardtest_single.log
+status=$(($status || $?))
+# The merge writes distribution files of the same names
+mkdir shardtest_single
+mv run_*.dat shardtest_single/
+
+for shard in 0 1 2 ; do
+	lightcurveMC --shard $shard/3 > shardtest_shard$shard.log
+	status=$(($status || $?))
+done
+lightcurveMC --merge 3 > shardtest_merged.log
+status=$(($status || $?))
+
+diff -s shardtest_single.log shardtest_merged.log
+status=$(($status || $?))
+
+# Every part must have been joined into a distribution file
+for part in run_*.part*.dat ; do
+	if [ -e "$part" ]; then
+		echo "Part $part was not joined"
+		status=1
+	fi
+done
+for single in shardtest_single/run_*.dat ; do
+	cmp "$single" "$(basename "$single")"
+	status=$(($status || $?))
+done
+ls run_*.dat > shardtest_merged_files.log
+(cd shardtest_single && ls run_*.dat) | diff - shardtest_merged_files.log
+status=$(($status || $?))
+
+exit $status
@@ -0,0 +1,60 @@
+#!/bin/bash
+
+# Test case for multithreaded analysis
+# Output must be identical to a single-threaded run (see rngtest.sh), 
+#	whether light curves or statistic families are split among threads
+
+rm -vf lightcurve_*.dat
+rm -vf run_*.dat
+rm -vf threadtest_snr*.log
+rm -vf stattest_snr*.log
+status=0
+nice -n 15 ../lightcurveMC -a "0.25 0.25" -d "0.115 0.115" -p "0.1 0.1" --ntrials 20 --noise 0.05 ptfjds.txt \
+	white_noise drw --print 1 --threads 4 \
+	--stat C1 --stat periplot --stat dmdtcut --stat dmdtplot \
+	--stat iacfcut --stat iacfplot --stat sacfcut --stat sacfplot \
+	--stat peakcut --stat peakplot \
+	>> threadtest_snr20.log
+status=$(($status || $?))
+
+diff -s   lctarget_drw_a0.25_d0.12_p0.10_p0.00_n0.05_0.dat \
+	lightcurve_drw_a0.25_d0.12_p0.10_p0.00_n0.05_0.dat
+status=$(($status || $?))
+diff -s   lctarget_white_noise_a0.25_d0.12_p0.10_p0.00_n0.05_0.dat \
+	lightcurve_white_noise_a0.25_d0.12_p0.10_p0.00_n0.05_0.dat
+status=$(($status || $?))
+
+diff -s rngtarget_snr20.log threadtest_snr20.log
+status=$(($status || $?))
+
+# Same distribution files as checked by rngtest.sh
+for stat in c1 cut50_3 cut50_2 cut90_3 cut90_2 dmdtmed acf9 acf4 acf2 acf \
+		sacf9 sacf4 sacf2 cutpeak3 cutpeak2 cutpeak45 peaks ; do
+	for lc in white_noise drw ; do
+		diff -s    run_${stat}_${lc}_a0.25_d0.12_p0.10_p0.00_n0.05.dat \
+			target_${stat}_${lc}_a0.25_d0.12_p0.10_p0.00_n0.05.dat
+		status=$(($status || $?))
+	done
+done
+
+nice -n 15 ../lightcurveMC -a "0.25 0.25" -d "0.115 0.115" -p "0.1 0.1" --ntrials 20 --noise 0.05 ptfjds.txt \
+	white_noise drw --print 1 --stat-threads 4 \
+	--stat C1 --stat periplot --stat dmdtcut --stat dmdtplot \
+	--stat iacfcut --stat iacfplot --stat sacfcut --stat sacfplot \
+	--stat peakcut --stat peakplot \
+	>> stattest_snr20.log
+status=$(($status || $?))
+
+diff -s rngtarget_snr20.log stattest_snr20.log
+status=$(($status || $?))
+
+for stat in c1 cut50_3 cut50_2 cut90_3 cut90_2 dmdtmed acf9 acf4 acf2 acf \
+		sacf9 sacf4 sacf2 cutpeak3 cutpeak2 cutpeak45 peaks ; do
+	for lc in white_noise drw ; do
+		diff -s    run_${stat}_${lc}_a0.25_d0.12_p0.10_p0.00_n0.05.dat \
+			target_${stat}_${lc}_a0.25_d0.12_p0.10_p0.00_n0.05.dat
+		status=$(($status || $?))
+	done
+done
+
+exit $status
@@ -2,7 +2,7 @@
  * @file lightcurveMC/tests/unit_dmdt.cpp
  * @author Krzysztof Findeisen
  * @date Created April 19, 2013
- * @date Last modified July 24, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -50,6 +50,8 @@
 #endif
 
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <string>
 #include <vector>
 #include <cmath>
@@ -60,6 +62,7 @@
 #include "test.h"
 #include "../binstats.h"
 #include "../stats/cut.tmp.h"
+#include "../stats/dmdtbins.h"
 #include "../gsl_compat.h"
 #include "../../common/alloc.tmp.h"
 
@@ -276,6 +279,423 @@ BOOST_AUTO_TEST_CASE(quantileCuts)
 			BINWIDTH : 2.0*error90Amp2s);
 }
 
+/** Tests whether the streaming &Delta;m&Delta;t quantiles agree with 
+ * quantiles of the stored &Delta;m&Delta;t plot.
+ * 
+ * @see @ref lcmc::stats::dmdtBinQuantiles() "dmdtBinQuantiles()"
+ * 
+ * @test For a random light curve, every quantile of every bin equals 
+ *	the interpolated quantile of the sorted pairs in that bin
+ * @test Bins with no pairs are NaN
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(streamingQuantiles)
+{
+	using lcmc::stats::dmdtBinQuantiles;
+	
+	boost::shared_ptr<gsl_rng> rng(checkAlloc(gsl_rng_alloc(gsl_rng_mt19937)), 
+		&gsl_rng_free);
+	gsl_rng_set(rng.get(), 42);
+	
+	vector<double> times, mags;
+	for (size_t i = 0; i < 200; i++) {
+		times.push_back(gsl_ran_flat(rng.get(), 0.0, 100.0));
+		mags .push_back(gsl_ran_gaussian(rng.get(), 1.0));
+	}
+	std::sort(times.begin(), times.end());
+	
+	vector<double> edges;
+	for (double bin = -1.97; bin < 2.5; bin += 0.15) {
+		edges.push_back(pow(10.0, bin));
+	}
+	vector<double> quantiles;
+	quantiles.push_back(0.0);
+	quantiles.push_back(0.5);
+	quantiles.push_back(0.9);
+	quantiles.push_back(1.0);
+	
+	vector<vector<double> > results;
+	BOOST_REQUIRE_NO_THROW(dmdtBinQuantiles(times, mags, edges, quantiles, 
+			results));
+	BOOST_REQUIRE_EQUAL(results.size(), quantiles.size());
+	
+	for (size_t bin = 0; bin < edges.size(); bin++) {
+		vector<double> pairs;
+		for (size_t i = 0; i < times.size(); i++) {
+			for (size_t j = i+1; j < times.size(); j++) {
+				const double deltaT = times[j] - times[i];
+				if (deltaT >= edges[bin] 
+						&& (bin+1 == edges.size() || deltaT < edges[bin+1])) {
+					pairs.push_back(fabs(mags[j] - mags[i]));
+				}
+			}
+		}
+		std::sort(pairs.begin(), pairs.end());
+		
+		for (size_t q = 0; q < quantiles.size(); q++) {
+			BOOST_REQUIRE_EQUAL(results[q].size(), edges.size());
+			if (pairs.empty()) {
+				BOOST_CHECK(testNan(results[q][bin]));
+			} else {
+				const double pos = quantiles[q] * (pairs.size() - 1);
+				const double low  = pairs[static_cast<size_t>(floor(pos))];
+				const double high = pairs[static_cast<size_t>(ceil (pos))];
+				BOOST_CHECK_CLOSE(results[q][bin], 
+					low + (pos - floor(pos)) * (high - low), 1e-10);
+			}
+		}
+	}
+}
+
+/** Tests whether quantiles from a cadence's pair index agree with the 
+ * streaming &Delta;m&Delta;t quantiles.
+ * 
+ * @see @ref lcmc::stats::DmdtPairIndex "DmdtPairIndex"
+ * 
+ * @test For several light curves sharing one cadence, 
+ *	DmdtPairIndex::binQuantiles() equals dmdtBinQuantiles()
+ * @test DmdtPairIndex::forCadence() reuses the index for a repeated cadence
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(pairIndex)
+{
+	using lcmc::stats::dmdtBinQuantiles;
+	using lcmc::stats::DmdtPairIndex;
+	
+	boost::shared_ptr<gsl_rng> rng(checkAlloc(gsl_rng_alloc(gsl_rng_mt19937)), 
+		&gsl_rng_free);
+	gsl_rng_set(rng.get(), 42);
+	
+	vector<double> times;
+	for (size_t i = 0; i < 200; i++) {
+		times.push_back(gsl_ran_flat(rng.get(), 0.0, 100.0));
+	}
+	std::sort(times.begin(), times.end());
+	
+	vector<double> edges;
+	for (double bin = -1.97; bin < 2.5; bin += 0.15) {
+		edges.push_back(pow(10.0, bin));
+	}
+	vector<double> quantiles;
+	quantiles.push_back(0.5);
+	quantiles.push_back(0.9);
+	
+	boost::shared_ptr<const DmdtPairIndex> index;
+	BOOST_REQUIRE_NO_THROW(index = DmdtPairIndex::forCadence(times, edges));
+	BOOST_CHECK(DmdtPairIndex::forCadence(times, edges) == index);
+	
+	for (size_t trial = 0; trial < 5; trial++) {
+		vector<double> mags;
+		for (size_t i = 0; i < times.size(); i++) {
+			mags.push_back(gsl_ran_gaussian(rng.get(), 1.0));
+		}
+		
+		vector<vector<double> > streamed, indexed;
+		BOOST_REQUIRE_NO_THROW(dmdtBinQuantiles(times, mags, edges, quantiles, 
+				streamed));
+		BOOST_REQUIRE_NO_THROW(index->binQuantiles(mags, quantiles, indexed));
+		BOOST_REQUIRE_EQUAL(indexed.size(), streamed.size());
+		for (size_t q = 0; q < quantiles.size(); q++) {
+			BOOST_REQUIRE_EQUAL(indexed[q].size(), streamed[q].size());
+			for (size_t bin = 0; bin < edges.size(); bin++) {
+				if (testNan(streamed[q][bin])) {
+					BOOST_CHECK(testNan(indexed[q][bin]));
+				} else {
+					BOOST_CHECK_EQUAL(indexed[q][bin], streamed[q][bin]);
+				}
+			}
+		}
+	}
+}
+
+/** Lists the &Delta;t bin edges doDmdt() uses for a baseline
+ *
+ * @param[in] baseline The time from the first to the last observation.
+ * @param[out] edges The bin edges.
+ *
+ * @exceptsafe @p edges is in a valid state in the event of an exception.
+ */
+void baselineEdges(double baseline, vector<double>& edges) {
+	edges.clear();
+	const double maxBin = log10(baseline);
+	for (double bin = -1.97; bin < maxBin; bin += 0.15) {
+		edges.push_back(pow(10.0, bin));
+	}
+	edges.push_back(pow(10.0, maxBin));
+}
+
+/** Tests whether pair indices derived for prefixes of a cadence agree 
+ * with the streaming &Delta;m&Delta;t quantiles.
+ * 
+ * @see @ref lcmc::stats::DmdtPairIndex "DmdtPairIndex"
+ * 
+ * @test For nested prefixes of a cadence, each binned as by doDmdt(), 
+ *	an index derived from the full index, or from the index of a 
+ *	longer prefix, gives the same quantiles as dmdtBinQuantiles()
+ * @test A longer cadence is not covered by the index of a prefix
+ * @test DmdtPairIndex::forCadence() reuses a derived index, and keeps 
+ *	the index it was derived from
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(prefixIndex)
+{
+	using lcmc::stats::dmdtBinQuantiles;
+	using lcmc::stats::DmdtPairIndex;
+	
+	boost::shared_ptr<gsl_rng> rng(checkAlloc(gsl_rng_alloc(gsl_rng_mt19937)), 
+		&gsl_rng_free);
+	gsl_rng_set(rng.get(), 43);
+	
+	vector<double> times;
+	for (size_t i = 0; i < 200; i++) {
+		times.push_back(gsl_ran_flat(rng.get(), 0.0, 100.0));
+	}
+	std::sort(times.begin(), times.end());
+	vector<double> mags;
+	for (size_t i = 0; i < times.size(); i++) {
+		mags.push_back(gsl_ran_gaussian(rng.get(), 1.0));
+	}
+	
+	vector<double> quantiles;
+	quantiles.push_back(0.5);
+	quantiles.push_back(0.9);
+	
+	vector<double> edges;
+	baselineEdges(times.back() - times.front(), edges);
+	boost::shared_ptr<const DmdtPairIndex> parent(new DmdtPairIndex(times, edges));
+	
+	// Each prefix is derived from the last, so that bins which are 
+	//	no longer in order of later observation are also tested
+	// A longer cadence cannot be derived from a shorter one
+	const size_t sizes[] = {150, 80, 81, 10};
+	size_t parentSize = times.size();
+	for (size_t k = 0; k < sizeof(sizes)/sizeof(sizes[0]); k++) {
+		const vector<double> prefixTimes(times.begin(), times.begin() + sizes[k]);
+		const vector<double> prefixMags (mags .begin(), mags .begin() + sizes[k]);
+		vector<double> prefixEdges;
+		baselineEdges(prefixTimes.back() - prefixTimes.front(), prefixEdges);
+		
+		if (sizes[k] > parentSize) {
+			BOOST_CHECK(!parent->coversPrefix(prefixTimes, prefixEdges));
+			continue;
+		}
+		BOOST_REQUIRE(parent->coversPrefix(prefixTimes, prefixEdges));
+		boost::shared_ptr<const DmdtPairIndex> prefix(
+			new DmdtPairIndex(*parent, prefixTimes, prefixEdges));
+		
+		vector<vector<double> > streamed, indexed;
+		BOOST_REQUIRE_NO_THROW(dmdtBinQuantiles(prefixTimes, prefixMags, 
+				prefixEdges, quantiles, streamed));
+		BOOST_REQUIRE_NO_THROW(prefix->binQuantiles(prefixMags, quantiles, 
+				indexed));
+		BOOST_REQUIRE_EQUAL(indexed.size(), streamed.size());
+		for (size_t q = 0; q < quantiles.size(); q++) {
+			BOOST_REQUIRE_EQUAL(indexed[q].size(), streamed[q].size());
+			for (size_t bin = 0; bin < prefixEdges.size(); bin++) {
+				if (testNan(streamed[q][bin])) {
+					BOOST_CHECK(testNan(indexed[q][bin]));
+				} else {
+					BOOST_CHECK_EQUAL(indexed[q][bin], streamed[q][bin]);
+				}
+			}
+		}
+		parent = prefix;
+		parentSize = sizes[k];
+	}
+	
+	const vector<double> prefixTimes(times.begin(), times.begin() + 120);
+	vector<double> prefixEdges;
+	baselineEdges(prefixTimes.back() - prefixTimes.front(), prefixEdges);
+	boost::shared_ptr<const DmdtPairIndex> full, prefix;
+	BOOST_REQUIRE_NO_THROW(full = DmdtPairIndex::forCadence(times, edges));
+	BOOST_REQUIRE_NO_THROW(prefix = DmdtPairIndex::forCadence(prefixTimes, 
+		prefixEdges));
+	BOOST_CHECK(DmdtPairIndex::forCadence(prefixTimes, prefixEdges) == prefix);
+	BOOST_CHECK(DmdtPairIndex::forCadence(times, edges) == full);
+}
+
+/** Tests whether several thresholds can be cut in one pass
+ *
+ * @test cutFunctions() gives the same cuts as calling cutFunction() 
+ *	once per threshold, for thresholds in any order
+ * @test cutFunctions() skips NaNs and returns NaN for thresholds that 
+ *	are never passed
+ * @test Interpolated cuts lie where the linear interpolation of the 
+ *	function equals the threshold
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(multiCuts)
+{
+	using lcmc::stats::cutFunction;
+	using lcmc::stats::cutFunctions;
+	using lcmc::stats::LessThan;
+	using lcmc::stats::MoreThan;
+	
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	const double rawFunc[] = {0.0, 0.1, nan, 0.35, 0.3, 0.6, 0.9, 0.5};
+	const size_t n = sizeof(rawFunc) / sizeof(double);
+	vector<double> pos, func(rawFunc, rawFunc + n);
+	for(size_t i = 0; i < n; i++) {
+		pos.push_back(static_cast<double>(i));
+	}
+	
+	vector<double> levels;
+	levels.push_back(0.5);
+	levels.push_back(0.05);
+	levels.push_back(1.0);
+	levels.push_back(0.3);
+	
+	vector<double> cuts;
+	cutFunctions(pos, func, levels, std::greater<double>(), cuts);
+	BOOST_REQUIRE_EQUAL(cuts.size(), levels.size());
+	for(size_t k = 0; k < levels.size(); k++) {
+		const double expected = cutFunction(pos, func, MoreThan(levels[k]));
+		if (testNan(expected)) {
+			BOOST_CHECK(testNan(cuts[k]));
+		} else {
+			BOOST_CHECK_EQUAL(cuts[k], expected);
+		}
+	}
+	BOOST_CHECK_EQUAL(cuts[1], 1.0);
+	BOOST_CHECK(testNan(cuts[2]));
+	
+	vector<double> reversed(func.rbegin(), func.rend());
+	cutFunctions(pos, reversed, levels, std::less<double>(), cuts);
+	BOOST_REQUIRE_EQUAL(cuts.size(), levels.size());
+	for(size_t k = 0; k < levels.size(); k++) {
+		const double expected = cutFunction(pos, reversed, LessThan(levels[k]));
+		if (testNan(expected)) {
+			BOOST_CHECK(testNan(cuts[k]));
+		} else {
+			BOOST_CHECK_EQUAL(cuts[k], expected);
+		}
+	}
+	
+	// Crossing 0.3 at index 3 follows a NaN, so it is not interpolated
+	cutFunctions(pos, func, levels, std::greater<double>(), cuts, true);
+	BOOST_REQUIRE_EQUAL(cuts.size(), levels.size());
+	BOOST_CHECK_CLOSE(cuts[0], 4.0 + 2.0/3.0, 1e-10);
+	BOOST_CHECK_CLOSE(cuts[1], 0.5, 1e-10);
+	BOOST_CHECK(testNan(cuts[2]));
+	BOOST_CHECK_EQUAL(cuts[3], 3.0);
+}
+
+/** Tests whether the streaming &Delta;m&Delta;t quantiles agree with 
+ * the timescales library.
+ * 
+ * @see @ref lcmc::stats::dmdtBinQuantiles() "dmdtBinQuantiles()"
+ * 
+ * @test For a randomly sampled and an evenly sampled random light 
+ *	curve, on the bins used by the simulations, the median and 90th 
+ *	percentile of every bin equal those found by kpftimes::dmdt() and 
+ *	kpftimes::deltaMBinQuantile(), and are NaN in the same bins
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(libraryQuantiles)
+{
+	using lcmc::stats::dmdtBinQuantiles;
+	
+	boost::shared_ptr<gsl_rng> rng(checkAlloc(gsl_rng_alloc(gsl_rng_mt19937)), 
+		&gsl_rng_free);
+	gsl_rng_set(rng.get(), 42);
+	
+	for (size_t sampling = 0; sampling < 2; sampling++) {
+		vector<double> times, mags;
+		for (size_t i = 0; i < 200; i++) {
+			times.push_back(sampling == 0 
+				? gsl_ran_flat(rng.get(), 0.0, 100.0) : 0.5*i);
+			mags .push_back(gsl_ran_gaussian(rng.get(), 1.0));
+		}
+		std::sort(times.begin(), times.end());
+		
+		// Same bins as doDmdt()
+		const double maxBin = log10(times.back() - times.front());
+		vector<double> edges;
+		for (double bin = -1.97; bin < maxBin; bin += 0.15) {
+			edges.push_back(pow(10.0, bin));
+		}
+		edges.push_back(pow(10.0, maxBin));
+		
+		vector<double> quantiles;
+		quantiles.push_back(0.5);
+		quantiles.push_back(0.9);
+		
+		vector<vector<double> > results;
+		BOOST_REQUIRE_NO_THROW(dmdtBinQuantiles(times, mags, edges, 
+				quantiles, results));
+		BOOST_REQUIRE_EQUAL(results.size(), quantiles.size());
+		
+		vector<double> deltaT, deltaM;
+		kpftimes::dmdt(times, mags, deltaT, deltaM);
+		for (size_t q = 0; q < quantiles.size(); q++) {
+			vector<double> expected;
+			kpftimes::deltaMBinQuantile(deltaT, deltaM, edges, expected, 
+				quantiles[q]);
+			BOOST_REQUIRE_EQUAL(results[q].size(), expected.size());
+			for (size_t bin = 0; bin < expected.size(); bin++) {
+				if (testNan(expected[bin])) {
+					BOOST_CHECK(testNan(results[q][bin]));
+				} else {
+					BOOST_CHECK_CLOSE(results[q][bin], expected[bin], 1e-10);
+				}
+			}
+		}
+	}
+}
+
+/** Tests whether the &Delta;m&Delta;t quantiles interpolate between 
+ * ranks the way the timescales library does.
+ * 
+ * @see @ref lcmc::stats::dmdtBinQuantiles() "dmdtBinQuantiles()"
+ * @see @ref lcmc::stats::DmdtPairIndex "DmdtPairIndex"
+ * 
+ * @test For a light curve whose pairs all fall in one bin, with 
+ *	&Delta;m = {1, 2, 3, 4, 6, 7}, the 0, 25, 50, 90, and 100% 
+ *	quantiles are exactly 1, 2.25, 3.5, 6.5, and 7
+ * @test DmdtPairIndex::binQuantiles() gives the same values
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(quantileConvention)
+{
+	using lcmc::stats::dmdtBinQuantiles;
+	using lcmc::stats::DmdtPairIndex;
+	
+	vector<double> times, mags;
+	times.push_back(0.0);	mags.push_back(0.0);
+	times.push_back(1.0);	mags.push_back(1.0);
+	times.push_back(2.0);	mags.push_back(3.0);
+	times.push_back(3.0);	mags.push_back(7.0);
+	
+	const vector<double> edges(1, 0.5);
+	
+	vector<double> quantiles, expected;
+	quantiles.push_back(0.0 );	expected.push_back(1.0 );
+	quantiles.push_back(0.25);	expected.push_back(2.25);
+	quantiles.push_back(0.5 );	expected.push_back(3.5 );
+	quantiles.push_back(0.9 );	expected.push_back(6.5 );
+	quantiles.push_back(1.0 );	expected.push_back(7.0 );
+	
+	vector<vector<double> > streamed, indexed;
+	BOOST_REQUIRE_NO_THROW(dmdtBinQuantiles(times, mags, edges, quantiles, 
+			streamed));
+	BOOST_REQUIRE_NO_THROW(DmdtPairIndex::forCadence(times, edges)
+			->binQuantiles(mags, quantiles, indexed));
+	BOOST_REQUIRE_EQUAL(streamed.size(), quantiles.size());
+	BOOST_REQUIRE_EQUAL(indexed .size(), quantiles.size());
+	for (size_t q = 0; q < quantiles.size(); q++) {
+		BOOST_REQUIRE_EQUAL(streamed[q].size(), 1u);
+		BOOST_REQUIRE_EQUAL(indexed [q].size(), 1u);
+		BOOST_CHECK_EQUAL(streamed[q][0], expected[q]);
+		BOOST_CHECK_EQUAL(indexed [q][0], expected[q]);
+	}
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}		// end lcmc::test
@@ -49,21 +49,28 @@
 #pragma GCC diagnostic pop
 #endif
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
 #include <cerrno>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
+#include <gsl/gsl_matrix.h>
 #include "test.h"
 #include "../except/data.h"
 #include "../fluxmag.h"
 #include "../lightcurvetypes.h"
 #include "../mcio.h"
+#include "../rngstream.h"
+#include "../waves/generators.h"
+#include "../waves/kernels.tmp.h"
 #include "../waves/lightcurves_gp.h"
+#include "../waves/statespace.h"
 #include "../../common/cerror.h"
 #include "../../common/alloc.tmp.h"
 
@@ -623,6 +630,687 @@ BOOST_AUTO_TEST_CASE(zerotime)
 	BOOST_CHECK_NO_THROW(dummyGp(10, TestTwoGpFactory(evenTimes, 1.0, 1.0, 0.3, 0.1)));
 }
 
+/** Computes the matrix B used by multiNormal() for a covariance matrix
+ *
+ * @param[in] covar The covariance matrix to factor.
+ * @param[out] half The matrix B, stored by columns.
+ *
+ * @exceptsafe Does not throw exceptions other than those of multiNormal()
+ */
+void factorColumns(const shared_ptr<gsl_matrix>& covar, 
+		std::vector<std::vector<double> >& half) {
+	const size_t N = covar->size1;
+	half.clear();
+	for(size_t k = 0; k < N; k++) {
+		std::vector<double> unit(N, 0.0), column;
+		unit[k] = 1.0;
+		lcmc::utils::multiNormal(unit, covar, column);
+		half.push_back(column);
+	}
+}
+
+/** Tests whether both factorizations used by multiNormal() reproduce 
+ *	the covariance matrix
+ *
+ * @test For the covariance of a damped random walk, B B<sup>T</sup> 
+ *	equals the covariance for both FACTOR_EIGEN and FACTOR_CHOLESKY
+ * @test Alternating between two matrices gives the same factors as 
+ *	using each matrix alone
+ * @test A singular matrix can be factored with FACTOR_CHOLESKY
+ * @test Identifying a matrix by a token gives the same results as 
+ *	comparing its elements, and a copy of the matrix with the same 
+ *	token finds the same factorization
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(covar_factor)
+{
+	using lcmc::utils::multiNormal;
+	using lcmc::utils::setCovarFactor;
+	
+	const size_t N = 30;
+	shared_ptr<gsl_matrix> drw(kpfutils::checkAlloc(gsl_matrix_alloc(N, N)), 
+		&gsl_matrix_free);
+	shared_ptr<gsl_matrix> flat(kpfutils::checkAlloc(gsl_matrix_alloc(N, N)), 
+		&gsl_matrix_free);
+	for(size_t i = 0; i < N; i++) {
+		for(size_t j = 0; j < N; j++) {
+			const double dt = 0.37 * (static_cast<double>(i) - static_cast<double>(j));
+			gsl_matrix_set(drw .get(), i, j, exp(-fabs(dt) / 3.0));
+			gsl_matrix_set(flat.get(), i, j, 1.0);
+		}
+	}
+	
+	const lcmc::utils::CovarFactor methods[] = {lcmc::utils::FACTOR_EIGEN, 
+		lcmc::utils::FACTOR_CHOLESKY};
+	for(size_t m = 0; m < 2; m++) {
+		setCovarFactor(methods[m]);
+		
+		std::vector<std::vector<double> > half, flatHalf, again;
+		factorColumns(drw , half);
+		factorColumns(flat, flatHalf);
+		factorColumns(drw , again);
+		BOOST_CHECK(half == again);
+		
+		std::vector<double> unit(N, 1.0), plain, tokened, copied;
+		multiNormal(unit, drw, plain);
+		multiNormal(unit, drw, tokened, 42);
+		BOOST_CHECK(plain == tokened);
+		shared_ptr<gsl_matrix> drwCopy(kpfutils::checkAlloc(gsl_matrix_alloc(N, N)), 
+			&gsl_matrix_free);
+		gsl_matrix_memcpy(drwCopy.get(), drw.get());
+		multiNormal(unit, drwCopy, copied, 42);
+		BOOST_CHECK(plain == copied);
+		
+		for(size_t i = 0; i < N; i++) {
+			for(size_t j = 0; j < N; j++) {
+				double sum = 0.0, flatSum = 0.0;
+				for(size_t k = 0; k < N; k++) {
+					sum     += half    [k][i] * half    [k][j];
+					flatSum += flatHalf[k][i] * flatHalf[k][j];
+				}
+				BOOST_CHECK_SMALL(sum - gsl_matrix_get(drw.get(), i, j), 1e-10);
+				BOOST_CHECK_SMALL(flatSum - 1.0, 1e-6);
+			}
+		}
+	}
+	
+	setCovarFactor(lcmc::utils::FACTOR_EIGEN);
+}
+
+/** Tests whether coherence times are rounded to the requested grid
+ *
+ * @test With no grid, snapTau() returns its argument
+ * @test With 10 points per decade, snapTau() returns powers of 10<sup>0.1</sup> 
+ *	within tauGridError() of its argument
+ * @test tauGridSize() counts the grid values in a range
+ * @test tauGridCovarError() bounds the change in a Gaussian kernel
+ * @test A negative grid density throws invalid_argument
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(tau_grid)
+{
+	using namespace lcmc::models;
+	
+	setTauGrid(0);
+	BOOST_CHECK_EQUAL(snapTau(1.234), 1.234);
+	BOOST_CHECK_EQUAL(tauGridError(), 0.0);
+	BOOST_CHECK_EQUAL(tauGridCovarError(), 0.0);
+	
+	setTauGrid(10);
+	BOOST_CHECK_CLOSE(snapTau(1.0), 1.0, 1e-10);
+	BOOST_CHECK_CLOSE(snapTau(1.2), pow(10.0, 0.1), 1e-10);
+	BOOST_CHECK_CLOSE(snapTau(0.03), pow(10.0, -1.5), 1e-10);
+	BOOST_CHECK_EQUAL(tauGridSize(1.0, 10.0), 11U);
+	
+	double worstKernel = 0.0;
+	for(double tau = 0.1; tau < 10.0; tau *= 1.01) {
+		const double snapped = snapTau(tau);
+		BOOST_CHECK_LE(fabs(snapped/tau - 1.0), tauGridError() * (1.0 + 1e-10));
+		
+		for(double dt = 0.0; dt < 5.0*tau; dt += 0.01*tau) {
+			const double diff = fabs(exp(-0.5*dt*dt/(tau*tau)) 
+				- exp(-0.5*dt*dt/(snapped*snapped)));
+			worstKernel = std::max(worstKernel, diff);
+		}
+	}
+	BOOST_CHECK_LE(worstKernel, tauGridCovarError() * (1.0 + 1e-10));
+	BOOST_CHECK_GT(worstKernel, 0.9 * tauGridCovarError());
+	
+	BOOST_CHECK_THROW(setTauGrid(-1), std::invalid_argument);
+	setTauGrid(0);
+}
+
+/** Tests whether circulant embedding reproduces a stationary covariance
+ *
+ * @test regularCadence() accepts gapped regular grids and rejects 
+ *	irregular ones
+ * @test For a Gaussian kernel on a 20-point grid, the embedding is 
+ *	positive semidefinite and reproduces the kernel
+ * @test SimpleGp light curves can be generated with FACTOR_CIRCULANT on 
+ *	both regular and irregular cadences
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(circulant)
+{
+	using namespace lcmc::utils;
+	
+	std::vector<double> gapped;
+	gapped.push_back(3.0);
+	gapped.push_back(3.5);
+	gapped.push_back(4.0);
+	gapped.push_back(4.0);
+	gapped.push_back(6.5);
+	double step = 0.0;
+	std::vector<size_t> index;
+	BOOST_REQUIRE(regularCadence(gapped, step, index));
+	BOOST_CHECK_CLOSE(step, 0.5, 1e-10);
+	BOOST_REQUIRE_EQUAL(index.size(), gapped.size());
+	BOOST_CHECK_EQUAL(index[1], 1U);
+	BOOST_CHECK_EQUAL(index[3], 2U);
+	BOOST_CHECK_EQUAL(index[4], 7U);
+	gapped.push_back(6.8);
+	BOOST_CHECK(!regularCadence(gapped, step, index));
+	
+	BOOST_CHECK_EQUAL(circulantSize(20), 64U);
+	BOOST_CHECK_EQUAL(circulantSize(33), 64U);
+	
+	const size_t M = 20;
+	const size_t n = circulantSize(M);
+	const double tau = 2.0;
+	std::vector<double> autocov;
+	for(size_t j = 0; j <= n/2; j++) {
+		const double lag = static_cast<double>(j) / tau;
+		autocov.push_back(exp(-0.5*lag*lag));
+	}
+	std::vector<double> sqrtEigen;
+	BOOST_REQUIRE(circulantSpectrum(autocov, sqrtEigen));
+	BOOST_REQUIRE_EQUAL(sqrtEigen.size(), n/2 + 1);
+	
+	// The transformation is linear, so its columns give its covariance
+	std::vector<std::vector<double> > half;
+	for(size_t k = 0; k < n; k++) {
+		std::vector<double> unit(n, 0.0), column;
+		unit[k] = 1.0;
+		circulantNormal(sqrtEigen, unit, column);
+		BOOST_REQUIRE_EQUAL(column.size(), n);
+		half.push_back(column);
+	}
+	for(size_t i = 0; i < M; i++) {
+		for(size_t j = 0; j < M; j++) {
+			double sum = 0.0;
+			for(size_t k = 0; k < n; k++) {
+				sum += half[k][i] * half[k][j];
+			}
+			const double lag = (static_cast<double>(i) - static_cast<double>(j)) / tau;
+			BOOST_CHECK_SMALL(sum - exp(-0.5*lag*lag), 1e-8);
+		}
+	}
+	BOOST_CHECK_THROW(circulantNormal(sqrtEigen, std::vector<double>(n+1, 0.0), 
+		autocov), std::invalid_argument);
+	
+	setCovarFactor(FACTOR_CIRCULANT);
+	std::vector<double> evenTimes, unevenTimes;
+	for(double t = 0.0; t <= 10.0; t += 0.1) {
+		evenTimes.push_back(t);
+		unevenTimes.push_back(t + 0.01*t*t);
+	}
+	std::vector<double> fluxes;
+	lcmc::models::SimpleGp(evenTimes, 0.3, 1.0).getFluxes(fluxes);
+	BOOST_CHECK_EQUAL(fluxes.size(), evenTimes.size());
+	for(size_t i = 0; i < fluxes.size(); i++) {
+		BOOST_CHECK(fluxes[i] > 0.0);
+	}
+	lcmc::models::SimpleGp(unevenTimes, 0.3, 1.0).getFluxes(fluxes);
+	BOOST_CHECK_EQUAL(fluxes.size(), unevenTimes.size());
+	setCovarFactor(FACTOR_EIGEN);
+}
+
+/** Tests whether Gaussian processes computed together match those 
+ *	computed one at a time
+ *
+ * @test For a sequence of SimpleGp light curves with two different 
+ *	coherence times, solveBatch() gives the same fluxes as getFluxes() 
+ *	for light curves drawn from the same random numbers
+ * @test A light curve whose deviates were not drawn in advance is 
+ *	skipped by solveBatch()
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(batch_solve)
+{
+	using namespace lcmc::models;
+	
+	std::vector<double> times;
+	for(double t = 0.0; t <= 5.0; t += 0.1) {
+		times.push_back(t);
+	}
+	const double taus[] = {0.5, 0.5, 0.5, 2.0, 2.0, 0.5};
+	const size_t nCurves = sizeof(taus) / sizeof(double);
+	
+	std::vector<std::vector<double> > serial;
+	std::vector<shared_ptr<SimpleGp> > curves;
+	std::vector<const GaussianProcess*> batch;
+	for(size_t i = 0; i < nCurves; i++) {
+		std::vector<double> fluxes;
+		{
+			lcmc::utils::TrialStreams streams(42, 0, i);
+			SimpleGp(times, 0.3, taus[i]).getFluxes(fluxes);
+		}
+		serial.push_back(fluxes);
+		
+		lcmc::utils::TrialStreams streams(42, 0, i);
+		curves.push_back(shared_ptr<SimpleGp>(new SimpleGp(times, 0.3, taus[i])));
+		curves.back()->drawDeviates();
+		batch.push_back(curves.back().get());
+	}
+	
+	GaussianProcess::solveBatch(batch);
+	
+	for(size_t i = 0; i < nCurves; i++) {
+		std::vector<double> fluxes;
+		curves[i]->getFluxes(fluxes);
+		BOOST_REQUIRE_EQUAL(fluxes.size(), serial[i].size());
+		for(size_t j = 0; j < fluxes.size(); j++) {
+			BOOST_CHECK_CLOSE(fluxes[j], serial[i][j], 1e-10);
+		}
+	}
+	
+	// Undrawn curves are left for getFluxes()
+	SimpleGp undrawn(times, 0.3, 0.5);
+	BOOST_CHECK_NO_THROW(GaussianProcess::solveBatch(
+		std::vector<const GaussianProcess*>(1, &undrawn)));
+	std::vector<double> fluxes;
+	BOOST_CHECK_NO_THROW(undrawn.getFluxes(fluxes));
+	BOOST_CHECK_EQUAL(fluxes.size(), times.size());
+}
+
+/** Tests whether random walks computed together match those computed 
+ *	one at a time
+ *
+ * @test For a sequence of DampedRandomWalk, RandomWalk, and SimpleGp 
+ *	light curves sampled with a repeated time, solveBatch() gives the 
+ *	same fluxes as getFluxes() for light curves drawn from the same 
+ *	random numbers
+ * @test Repeated times have the same flux in batched light curves
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(batch_recursive)
+{
+	using namespace lcmc::models;
+	
+	std::vector<double> times;
+	for(double t = 0.0; t <= 5.0; t += 0.1) {
+		times.push_back(t);
+	}
+	times.push_back(times.back());
+	const double taus[] = {0.5, 0.5, 2.0, -1.0, -1.0, 0.5, 0.0, 0.5};
+	const size_t nCurves = sizeof(taus) / sizeof(double);
+	
+	std::vector<std::vector<double> > serial;
+	std::vector<shared_ptr<GaussianProcess> > curves;
+	std::vector<const GaussianProcess*> batch;
+	for(size_t i = 0; i < nCurves; i++) {
+		for(size_t copy = 0; copy < 2; copy++) {
+			lcmc::utils::TrialStreams streams(42, 0, i);
+			shared_ptr<GaussianProcess> curve;
+			if (taus[i] > 0.0) {
+				curve.reset(new DampedRandomWalk(times, 0.1, taus[i]));
+			} else if (taus[i] < 0.0) {
+				curve.reset(new RandomWalk(times, 0.1));
+			} else {
+				curve.reset(new SimpleGp(times, 0.3, 0.5));
+			}
+			
+			if (copy == 0) {
+				std::vector<double> fluxes;
+				curve->getFluxes(fluxes);
+				serial.push_back(fluxes);
+			} else {
+				curve->drawDeviates();
+				curves.push_back(curve);
+				batch.push_back(curve.get());
+			}
+		}
+	}
+	
+	GaussianProcess::solveBatch(batch);
+	
+	for(size_t i = 0; i < nCurves; i++) {
+		std::vector<double> fluxes;
+		curves[i]->getFluxes(fluxes);
+		BOOST_REQUIRE_EQUAL(fluxes.size(), serial[i].size());
+		for(size_t j = 0; j < fluxes.size(); j++) {
+			BOOST_CHECK_CLOSE(fluxes[j], serial[i][j], 1e-10);
+		}
+		BOOST_CHECK_EQUAL(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2]);
+	}
+}
+
+/** Tests whether kernel matrices match their kernels
+ *
+ * @test kernelMatrix() of a sum of two squared exponential kernels and 
+ *	white noise is symmetric, and equals the sum of the kernels
+ * @test White noise is added only to the diagonal, even for repeated 
+ *	times
+ * @test LagMatrix stores the squared lags, and kernelMatrix() gives the 
+ *	same matrix from them as from the times
+ * @test cadenceLags() returns the same lags for the same cadence, and 
+ *	new lags for different times
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(kernel_matrix)
+{
+	using namespace lcmc::models;
+	
+	std::vector<double> times;
+	for(double t = 0.0; t <= 5.0; t += 0.25) {
+		times.push_back(t + 0.01*t*t);
+	}
+	times.push_back(times.back());
+	const size_t n = times.size();
+	
+	shared_ptr<gsl_matrix> covar = kernelMatrix(times, addKernels(
+		addKernels(SquaredExpKernel(4.0, 0.5), SquaredExpKernel(0.25, 3.0)), 
+		WhiteKernel(0.1)));
+	BOOST_REQUIRE_EQUAL(covar->size1, n);
+	BOOST_REQUIRE_EQUAL(covar->size2, n);
+	for(size_t i = 0; i < n; i++) {
+		for(size_t j = 0; j < n; j++) {
+			const double lag = times[i] - times[j];
+			const double expected = 4.0*exp(-0.5*lag*lag/0.25) 
+				+ 0.25*exp(-0.5*lag*lag/9.0) + (i == j ? 0.1 : 0.0);
+			BOOST_CHECK_CLOSE(gsl_matrix_get(covar.get(), i, j), expected, 1e-10);
+			BOOST_CHECK_EQUAL(gsl_matrix_get(covar.get(), i, j), 
+				gsl_matrix_get(covar.get(), j, i));
+		}
+	}
+	
+	const LagMatrix lags(times);
+	BOOST_REQUIRE_EQUAL(lags.size(), n);
+	for(size_t i = 0; i < n; i++) {
+		for(size_t j = 0; j <= i; j++) {
+			const double lag = times[i] - times[j];
+			BOOST_CHECK_EQUAL(lags.row(i)[j], lag*lag);
+		}
+	}
+	shared_ptr<gsl_matrix> fromLags = kernelMatrix(lags, addKernels(
+		addKernels(SquaredExpKernel(4.0, 0.5), SquaredExpKernel(0.25, 3.0)), 
+		WhiteKernel(0.1)));
+	BOOST_CHECK(lcmc::utils::sameMatrix(fromLags.get(), covar.get()));
+	
+	const Cadence cadence(times);
+	shared_ptr<const LagMatrix> cached = cadenceLags(cadence);
+	BOOST_REQUIRE_EQUAL(cached->size(), n);
+	BOOST_CHECK_EQUAL(cadenceLags(cadence).get(), cached.get());
+	times.push_back(times.back() + 1.0);
+	BOOST_CHECK_EQUAL(cadenceLags(Cadence(times))->size(), n+1);
+}
+
+/** Tests whether state-space models approximate the squared exponential 
+ *	kernel
+ *
+ * @test The approximate kernel has unit variance at zero lag
+ * @test The kernel error decreases with the order of the model
+ * @test Orders outside 0-8 throw invalid_argument
+ * @test SimpleGp and TwoScaleGp light curves can be generated from a 
+ *	state-space model, and repeated times get the same flux
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(state_space)
+{
+	using namespace lcmc::models;
+	
+	double oldError = 1.0;
+	for(long order = 1; order <= 8; order++) {
+		const SquaredExpSde& sde = SquaredExpSde::get(order);
+		BOOST_CHECK_CLOSE(sde.kernel(0.0), 1.0, 1e-8);
+		BOOST_CHECK_LT(sde.maxError(), oldError);
+		oldError = sde.maxError();
+	}
+	BOOST_CHECK_GT(SquaredExpSde::get(2).maxError(), 0.1);
+	BOOST_CHECK_LT(SquaredExpSde::get(6).maxError(), 0.005);
+	
+	BOOST_CHECK_THROW(setStateSpaceOrder(-1), std::invalid_argument);
+	BOOST_CHECK_THROW(setStateSpaceOrder( 9), std::invalid_argument);
+	
+	setStateSpaceOrder(0);
+	BOOST_CHECK_EQUAL(stateSpaceError(), 0.0);
+	setStateSpaceOrder(4);
+	BOOST_CHECK_EQUAL(getStateSpaceOrder(), 4);
+	BOOST_CHECK_CLOSE(stateSpaceError(), SquaredExpSde::get(4).maxError(), 1e-10);
+	
+	std::vector<double> times;
+	for(double t = 0.0; t <= 10.0; t += 0.1) {
+		times.push_back(t + 0.01*t*t);
+	}
+	times.push_back(times.back());
+	
+	std::vector<double> fluxes;
+	SimpleGp(times, 0.3, 1.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	for(size_t i = 0; i < fluxes.size(); i++) {
+		BOOST_CHECK(fluxes[i] > 0.0);
+	}
+	BOOST_CHECK_EQUAL(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2]);
+	
+	TwoScaleGp(times, 0.3, 1.0, 0.1, 10.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	BOOST_CHECK_EQUAL(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2]);
+	
+	setStateSpaceOrder(0);
+}
+
+/** Tests the Nystr&ouml;m approximation to stationary Gaussian processes
+ *
+ * @test Negative ranks throw invalid_argument
+ * @test nystromError() is zero until an approximate light curve is 
+ *	generated
+ * @test The covariance error is small when the inducing points are 
+ *	closer together than the coherence time, and large when they are 
+ *	much farther apart
+ * @test SimpleGp and TwoScaleGp light curves can be generated from a 
+ *	Nystr&ouml;m approximation, and repeated times get the same flux
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(nystrom)
+{
+	using namespace lcmc::models;
+	
+	BOOST_CHECK_THROW(setNystromRank(-1), std::invalid_argument);
+	
+	std::vector<double> times;
+	for(double t = 0.0; t <= 10.0; t += 0.1) {
+		times.push_back(t + 0.01*t*t);
+	}
+	times.push_back(times.back());
+	
+	setNystromRank(60);
+	BOOST_CHECK_EQUAL(getNystromRank(), 60);
+	BOOST_CHECK_EQUAL(nystromError(), 0.0);
+	
+	std::vector<double> fluxes;
+	SimpleGp(times, 0.3, 1.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	for(size_t i = 0; i < fluxes.size(); i++) {
+		BOOST_CHECK(fluxes[i] > 0.0);
+	}
+	BOOST_CHECK_EQUAL(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2]);
+	BOOST_CHECK_LT(nystromError(), 0.01);
+	
+	TwoScaleGp(times, 0.3, 1.0, 0.1, 10.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	BOOST_CHECK_EQUAL(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2]);
+	
+	setNystromRank(3);
+	BOOST_CHECK_EQUAL(nystromError(), 0.0);
+	SimpleGp(times, 0.3, 1.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	BOOST_CHECK_GT(nystromError(), 0.5);
+	
+	setNystromRank(0);
+}
+
+/** Tests the generation of stationary Gaussian processes one season 
+ *	at a time
+ *
+ * @test Negative tolerances, or tolerances of 1 or more, throw 
+ *	invalid_argument
+ * @test seasonError() is zero until a light curve is generated one 
+ *	season at a time
+ * @test SimpleGp and TwoScaleGp light curves with seasons much farther 
+ *	apart than their coherence times can be generated one season at 
+ *	a time, the covariance dropped is within the tolerance, and 
+ *	repeated times get the same flux
+ * @test Light curves whose gaps are shorter than the coherence time 
+ *	are not split into seasons
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(seasons)
+{
+	using namespace lcmc::models;
+	
+	BOOST_CHECK_THROW(setSeasonTolerance(-0.1), std::invalid_argument);
+	BOOST_CHECK_THROW(setSeasonTolerance( 1.0), std::invalid_argument);
+	
+	std::vector<double> times;
+	for(size_t season = 0; season < 3; season++) {
+		for(size_t i = 0; i < 30; i++) {
+			times.push_back(100.0 * static_cast<double>(season) 
+				+ 0.2 * static_cast<double>(i));
+		}
+	}
+	times.push_back(times.back());
+	
+	setSeasonTolerance(1e-6);
+	BOOST_CHECK_EQUAL(getSeasonTolerance(), 1e-6);
+	BOOST_CHECK_EQUAL(seasonError(), 0.0);
+	
+	std::vector<double> fluxes;
+	SimpleGp(times, 0.3, 1.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	for(size_t i = 0; i < fluxes.size(); i++) {
+		BOOST_CHECK(fluxes[i] > 0.0);
+	}
+	BOOST_CHECK_EQUAL(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2]);
+	BOOST_CHECK_LE(seasonError(), 1e-6);
+	
+	TwoScaleGp(times, 0.3, 1.0, 0.1, 10.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	BOOST_CHECK_EQUAL(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2]);
+	BOOST_CHECK_LE(seasonError(), 1e-6);
+	
+	// Gaps of 2 days are well within a coherence time of 10 days
+	std::vector<double> dense;
+	for(size_t i = 0; i < 50; i++) {
+		dense.push_back(2.0 * static_cast<double>(i));
+	}
+	// Resets seasonError()
+	setSeasonTolerance(1e-6);
+	SimpleGp(dense, 0.3, 10.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), dense.size());
+	BOOST_CHECK_EQUAL(seasonError(), 0.0);
+	
+	setSeasonTolerance(0.0);
+}
+
+/** Tests the generation of stationary Gaussian processes from sparse 
+ *	covariance matrices
+ *
+ * @test Negative tolerances, or tolerances of 1 or more, throw 
+ *	invalid_argument
+ * @test multiNormal() reproduces a banded covariance matrix from its 
+ *	envelope alone, and agrees with the dense Cholesky factorization
+ * @test Envelopes that do not match the input, or that are not 
+ *	positive definite, throw invalid_argument
+ * @test SimpleGp and TwoScaleGp light curves with coherence times much 
+ *	shorter than the spacing between observations can be generated, 
+ *	and repeated times get nearly the same flux
+ * @test Light curves with long coherence times are still generated
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+BOOST_AUTO_TEST_CASE(sparse_covar)
+{
+	using namespace lcmc::models;
+	using lcmc::utils::SparseCovar;
+	using lcmc::utils::multiNormal;
+	
+	BOOST_CHECK_THROW(setSparseTolerance(-0.1), std::invalid_argument);
+	BOOST_CHECK_THROW(setSparseTolerance( 1.0), std::invalid_argument);
+	
+	const size_t N = 30;
+	shared_ptr<gsl_matrix> banded(kpfutils::checkAlloc(gsl_matrix_alloc(N, N)), 
+		&gsl_matrix_free);
+	SparseCovar sparse;
+	for(size_t i = 0; i < N; i++) {
+		// Rows of different widths
+		const size_t width = 1 + (i % 4);
+		sparse.first.push_back(i >= width ? i - width : 0);
+		for(size_t j = 0; j < N; j++) {
+			const double dt = 0.37 * (static_cast<double>(i) - static_cast<double>(j));
+			const double cov = exp(-0.5 * dt * dt);
+			if (j <= i && j >= sparse.first[i]) {
+				sparse.values.push_back(cov);
+			}
+			gsl_matrix_set(banded.get(), i, j, cov);
+		}
+		sparse.offset.push_back(sparse.values.size());
+	}
+	// The dense matrix must have the same envelope
+	for(size_t i = 0; i < N; i++) {
+		for(size_t j = 0; j < sparse.first[i]; j++) {
+			gsl_matrix_set(banded.get(), i, j, 0.0);
+			gsl_matrix_set(banded.get(), j, i, 0.0);
+		}
+	}
+	
+	lcmc::utils::setCovarFactor(lcmc::utils::FACTOR_CHOLESKY);
+	std::vector<std::vector<double> > half(N), denseHalf(N);
+	for(size_t k = 0; k < N; k++) {
+		std::vector<double> unit(N, 0.0);
+		unit[k] = 1.0;
+		multiNormal(unit, sparse, half[k]);
+		multiNormal(unit, banded, denseHalf[k]);
+		BOOST_REQUIRE_EQUAL(half[k].size(), N);
+	}
+	lcmc::utils::setCovarFactor(lcmc::utils::FACTOR_EIGEN);
+	for(size_t i = 0; i < N; i++) {
+		for(size_t j = 0; j < N; j++) {
+			double sum = 0.0;
+			for(size_t k = 0; k < N; k++) {
+				sum += half[k][i] * half[k][j];
+			}
+			BOOST_CHECK_SMALL(sum - gsl_matrix_get(banded.get(), i, j), 1e-10);
+			BOOST_CHECK_SMALL(half[j][i] - denseHalf[j][i], 1e-10);
+		}
+	}
+	
+	std::vector<double> output;
+	BOOST_CHECK_THROW(multiNormal(std::vector<double>(N-1, 1.0), sparse, output), 
+		std::invalid_argument);
+	SparseCovar negative;
+	negative.first.push_back(0);
+	negative.values.push_back(-1.0);
+	negative.offset.push_back(1);
+	BOOST_CHECK_THROW(multiNormal(std::vector<double>(1, 1.0), negative, output), 
+		std::invalid_argument);
+	
+	std::vector<double> times;
+	for(size_t i = 0; i < 100; i++) {
+		times.push_back(0.2 * static_cast<double>(i) + 0.05 * static_cast<double>(i % 3));
+	}
+	times.push_back(times.back());
+	
+	setSparseTolerance(1e-6);
+	BOOST_CHECK_EQUAL(getSparseTolerance(), 1e-6);
+	
+	std::vector<double> fluxes;
+	SimpleGp(times, 0.3, 0.05).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	for(size_t i = 0; i < fluxes.size(); i++) {
+		BOOST_CHECK(fluxes[i] > 0.0);
+	}
+	BOOST_CHECK_CLOSE(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2], 1e-3);
+	
+	TwoScaleGp(times, 0.3, 0.05, 0.1, 0.02).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	BOOST_CHECK_CLOSE(fluxes[fluxes.size()-1], fluxes[fluxes.size()-2], 1e-3);
+	
+	// A coherence time of 10 days correlates every pair of observations
+	SimpleGp(times, 0.3, 10.0).getFluxes(fluxes);
+	BOOST_REQUIRE_EQUAL(fluxes.size(), times.size());
+	
+	setSparseTolerance(0.0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 // Re-enable all compiler warnings
@@ -0,0 +1,830 @@
+/** Test unit for the output file formats
+ * @file lightcurveMC/tests/unit_io.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../common/warnflags.h"
+
+// Boost.Test uses C-style casts and non-virtual destructors
+#ifdef GNUC_COARSEWARN
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Weffc++"
+#endif
+
+// Boost.Test uses C-style casts and non-virtual destructors
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Weffc++"
+#endif
+
+#include <boost/test/unit_test.hpp>
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#ifdef LCMC_USE_ZLIB
+#include <zlib.h>
+#endif
+#include "../except/inject.h"
+#include "../samples/bundle.h"
+#include "../samples/catalog.h"
+#include "../samples/observations.h"
+#include "../stats/columns.h"
+#include "../stats/raggedarray.h"
+#include "../textwriter.h"
+#include "../ziparchive.h"
+
+namespace lcmc { namespace test {
+
+using boost::uint32_t;
+using boost::uint64_t;
+using std::string;
+using std::vector;
+
+namespace {
+
+/** Reads a whole file into memory
+ *
+ * @param[in] fileName The file to read.
+ *
+ * @return The bytes of the file.
+ *
+ * @exception std::runtime_error Thrown if the file could not be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the file.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<unsigned char> readBytes(const string& fileName) {
+	boost::shared_ptr<FILE> file(fopen(fileName.c_str(), "rb"), &fclose);
+	if (file.get() == NULL) {
+		throw std::runtime_error("Could not open " + fileName);
+	}
+	
+	vector<unsigned char> bytes;
+	unsigned char buffer[4096];
+	size_t nRead;
+	while ((nRead = fread(buffer, 1, sizeof(buffer), file.get())) > 0) {
+		bytes.insert(bytes.end(), buffer, buffer + nRead);
+	}
+	return bytes;
+}
+
+/** Reads a little-endian field from a byte array
+ *
+ * @param[in] bytes The array to read.
+ * @param[in] start The position of the first byte of the field.
+ * @param[in] width The number of bytes in the field.
+ *
+ * @return The value of the field.
+ *
+ * @exception std::runtime_error Thrown if the field runs past the 
+ *	end of @p bytes.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+uint64_t getField(const vector<unsigned char>& bytes, uint64_t start, 
+		int width) {
+	if (start + width > bytes.size()) {
+		throw std::runtime_error("Field at byte " 
+			+ boost::lexical_cast<string>(start) + " runs past the end of the file");
+	}
+	uint64_t value = 0;
+	for(int i = width - 1; i >= 0; i--) {
+		value = (value << 8) | bytes[start + i];
+	}
+	return value;
+}
+
+/** Calculates a CRC-32 checksum one bit at a time
+ *
+ * This is deliberately independent of the table-driven version used 
+ * by @ref lcmc::utils::ZipArchive "ZipArchive".
+ *
+ * @param[in] first, last The range of bytes to check.
+ *
+ * @return The checksum of the range.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint32_t slowCrc(vector<unsigned char>::const_iterator first, 
+		vector<unsigned char>::const_iterator last) {
+	uint32_t crc = 0xFFFFFFFFu;
+	for(; first != last; first++) {
+		crc ^= *first;
+		for(int k = 0; k < 8; k++) {
+			crc = (crc & 1u ? 0xEDB88320u ^ (crc >> 1) : crc >> 1);
+		}
+	}
+	return crc ^ 0xFFFFFFFFu;
+}
+
+/** Calculates a CRC-32 checksum of a zip entry
+ *
+ * @param[in] contents The entry to check.
+ *
+ * @return The checksum of @p contents.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+uint32_t slowCrc(const vector<char>& contents) {
+	const vector<unsigned char> bytes(contents.begin(), contents.end());
+	return slowCrc(bytes.begin(), bytes.end());
+}
+
+/** Describes one entry of a zip archive, as listed in its index
+ */
+struct ZipEntry {
+	/** Creates an empty entry
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	ZipEntry() : name(), method(0), crc(0), storedSize(0), size(0), 
+			offset(0) {
+	}
+	
+	string name;
+	uint64_t method;
+	uint64_t crc;
+	uint64_t storedSize;
+	uint64_t size;
+	uint64_t offset;
+};
+
+/** Reads the index of a zip archive without Zip64 records
+ *
+ * The end of central directory record, every central directory 
+ * record, and the local header each record points to are checked 
+ * against each other.
+ *
+ * @param[in] archive The bytes of the archive.
+ *
+ * @return The entries of @p archive, in index order.
+ *
+ * @exception std::runtime_error Thrown if the index is inconsistent.
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<ZipEntry> readZipIndex(const vector<unsigned char>& archive) {
+	// The archives have no comment, so the end record is the last 22 bytes
+	if (archive.size() < 22) {
+		throw std::runtime_error("Archive too short to hold an index");
+	}
+	const uint64_t endStart = archive.size() - 22;
+	if (getField(archive, endStart, 4) != 0x06054b50u) {
+		throw std::runtime_error("Missing end of central directory record");
+	}
+	const uint64_t nEntries   = getField(archive, endStart + 10, 2);
+	const uint64_t indexSize  = getField(archive, endStart + 12, 4);
+	const uint64_t indexStart = getField(archive, endStart + 16, 4);
+	if (getField(archive, endStart + 8, 2) != nEntries) {
+		throw std::runtime_error("Entry counts in end record disagree");
+	}
+	if (indexStart + indexSize != endStart) {
+		throw std::runtime_error("Central directory does not end at the end record");
+	}
+	
+	vector<ZipEntry> entries;
+	uint64_t pos = indexStart;
+	for(uint64_t i = 0; i < nEntries; i++) {
+		if (getField(archive, pos, 4) != 0x02014b50u) {
+			throw std::runtime_error("Missing central directory record " 
+				+ boost::lexical_cast<string>(i));
+		}
+		ZipEntry entry;
+		entry.method     = getField(archive, pos + 10, 2);
+		entry.crc        = getField(archive, pos + 16, 4);
+		entry.storedSize = getField(archive, pos + 20, 4);
+		entry.size       = getField(archive, pos + 24, 4);
+		const uint64_t nameLength  = getField(archive, pos + 28, 2);
+		const uint64_t extraLength = getField(archive, pos + 30, 2);
+		const uint64_t noteLength  = getField(archive, pos + 32, 2);
+		entry.offset     = getField(archive, pos + 42, 4);
+		if (pos + 46 + nameLength > archive.size() 
+				|| entry.offset + 30 + nameLength > archive.size()) {
+			throw std::runtime_error("Entry name runs past the end of the file");
+		}
+		entry.name.assign(archive.begin() + pos + 46, 
+			archive.begin() + pos + 46 + nameLength);
+		pos += 46 + nameLength + extraLength + noteLength;
+		
+		// The local header must repeat the index
+		const uint64_t local = entry.offset;
+		if (getField(archive, local, 4) != 0x04034b50u) {
+			throw std::runtime_error("Entry " + entry.name 
+				+ " does not point to a local header");
+		}
+		if (getField(archive, local +  8, 2) != entry.method 
+				|| getField(archive, local + 14, 4) != entry.crc 
+				|| getField(archive, local + 18, 4) != entry.storedSize 
+				|| getField(archive, local + 22, 4) != entry.size 
+				|| getField(archive, local + 26, 2) != nameLength 
+				|| string(archive.begin() + local + 30, 
+					archive.begin() + local + 30 + nameLength) != entry.name) {
+			throw std::runtime_error("Local header of " + entry.name 
+				+ " disagrees with the index");
+		}
+		
+		entries.push_back(entry);
+	}
+	if (pos != endStart) {
+		throw std::runtime_error("Central directory has trailing bytes");
+	}
+	return entries;
+}
+
+/** Returns the stored data of a zip entry
+ *
+ * @param[in] archive The bytes of the archive.
+ * @param[in] entry An entry of @p archive.
+ *
+ * @return The bytes following the local header of @p entry.
+ *
+ * @exception std::runtime_error Thrown if the data runs past the 
+ *	end of @p archive.
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<unsigned char> entryData(const vector<unsigned char>& archive, 
+		const ZipEntry& entry) {
+	const uint64_t start = entry.offset + 30 + entry.name.size() 
+		+ getField(archive, entry.offset + 28, 2);
+	if (start + entry.storedSize > archive.size()) {
+		throw std::runtime_error("Data of " + entry.name 
+			+ " runs past the end of the file");
+	}
+	return vector<unsigned char>(archive.begin() + start, 
+		archive.begin() + start + entry.storedSize);
+}
+
+/** Creates the contents of a test entry
+ *
+ * @param[in] i The index of the entry.
+ *
+ * @return A repetitive text, so that it can be compressed.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<char> entryContents(size_t i) {
+	string text;
+	for(size_t j = 0; j <= i % 50; j++) {
+		text += "0.25\t" + boost::lexical_cast<string>(i + j) + "\n";
+	}
+	return vector<char>(text.begin(), text.end());
+}
+
+/** Decodes a little-endian 64-bit floating point value
+ *
+ * @param[in] bytes The array to read.
+ * @param[in] start The position of the first byte of the value.
+ *
+ * @return The value stored at @p start.
+ *
+ * @exception std::runtime_error Thrown if the value runs past the 
+ *	end of @p bytes.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+double getDouble(const vector<unsigned char>& bytes, uint64_t start) {
+	const uint64_t raw = getField(bytes, start, 8);
+	double value;
+	std::memcpy(&value, &raw, sizeof(value));
+	return value;
+}
+
+/** Decodes a little-endian 32-bit floating point value
+ *
+ * @param[in] bytes The array to read.
+ * @param[in] start The position of the first byte of the value.
+ *
+ * @return The value stored at @p start.
+ *
+ * @exception std::runtime_error Thrown if the value runs past the 
+ *	end of @p bytes.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+float getFloat(const vector<unsigned char>& bytes, uint64_t start) {
+	const uint32_t raw = static_cast<uint32_t>(getField(bytes, start, 4));
+	float value;
+	std::memcpy(&value, &raw, sizeof(value));
+	return value;
+}
+
+/** Writes the first bytes of a file to another file
+ *
+ * @param[in] bytes The contents of the original file.
+ * @param[in] length The number of bytes to keep.
+ * @param[in] fileName The file to create.
+ *
+ * @exception std::runtime_error Thrown if the file could not be written.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void writePrefix(const vector<unsigned char>& bytes, size_t length, 
+		const string& fileName) {
+	boost::shared_ptr<FILE> file(fopen(fileName.c_str(), "wb"), &fclose);
+	if (file.get() == NULL 
+			|| fwrite(&bytes[0], 1, length, file.get()) != length) {
+		throw std::runtime_error("Could not write " + fileName);
+	}
+}
+
+/** Writes the table used by the ColumnFile tests
+ *
+ * @param[in] fileName The name of the data file.
+ *
+ * @exception std::runtime_error Thrown if the table could not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+void writeTestTable(const string& fileName) {
+	using lcmc::stats::RaggedArray;
+	
+	vector<double> x;
+	x.push_back(1.5);
+	x.push_back(-2.25);
+	x.push_back(std::numeric_limits<double>::quiet_NaN());
+	
+	vector<size_t> ids;
+	ids.push_back(0);
+	ids.push_back(7);
+	ids.push_back(123456789);
+	
+	RaggedArray dm;
+	dm.push_back(vector<double>(2, 0.125));
+	dm.push_back(vector<double>());
+	dm.push_back(vector<double>(1, -0.5));
+	
+	RaggedArray flt(lcmc::stats::SINGLE_PRECISION);
+	flt.push_back(vector<double>(2, 0.75));
+	
+	lcmc::stats::ColumnFile table(fileName);
+	table.addColumn("x", x);
+	table.addColumn("id \"quoted\"\t\\", ids);
+	table.addRows("dm", dm);
+	table.addRows("f", flt);
+	table.addColumn("empty", vector<double>());
+	table.close();
+}
+
+/** Checks the data written by writeTestTable()
+ *
+ * @param[in] data The bytes of the data file.
+ *
+ * @exception std::runtime_error Thrown if the data are too short.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void checkTestTable(const vector<unsigned char>& data) {
+	BOOST_REQUIRE_EQUAL(data.size(), 128u);
+	BOOST_CHECK_EQUAL(getDouble(data,  0),  1.5);
+	BOOST_CHECK_EQUAL(getDouble(data,  8), -2.25);
+	BOOST_CHECK(getDouble(data, 16) != getDouble(data, 16));
+	BOOST_CHECK_EQUAL(getField(data, 24, 8), 0u);
+	BOOST_CHECK_EQUAL(getField(data, 32, 8), 7u);
+	BOOST_CHECK_EQUAL(getField(data, 40, 8), 123456789u);
+	BOOST_CHECK_EQUAL(getDouble(data, 48),  0.125);
+	BOOST_CHECK_EQUAL(getDouble(data, 56),  0.125);
+	BOOST_CHECK_EQUAL(getDouble(data, 64), -0.5);
+	BOOST_CHECK_EQUAL(getField(data,  72, 8), 0u);
+	BOOST_CHECK_EQUAL(getField(data,  80, 8), 2u);
+	BOOST_CHECK_EQUAL(getField(data,  88, 8), 2u);
+	BOOST_CHECK_EQUAL(getField(data,  96, 8), 3u);
+	BOOST_CHECK_EQUAL(getFloat(data, 104), 0.75f);
+	BOOST_CHECK_EQUAL(getFloat(data, 108), 0.75f);
+	BOOST_CHECK_EQUAL(getField(data, 112, 8), 0u);
+	BOOST_CHECK_EQUAL(getField(data, 120, 8), 2u);
+}
+
+/** The schema written by writeTestTable(), for a data file named 
+ *	test_columns.bin
+ */
+const char* const TEST_SCHEMA = 
+	"{\n"
+	"\t\"format\": \"lightcurveMC columns\",\n"
+	"\t\"version\": 1,\n"
+	"\t\"data\": \"test_columns.bin\",\n"
+	"\t\"byteOrder\": \"little\",\n"
+	"\t\"columns\": [\n"
+	"\t\t{\"name\": \"x\", \"type\": \"float64\", \"offset\": 0, \"count\": 3},\n"
+	"\t\t{\"name\": \"id \\\"quoted\\\"\\u0009\\\\\", \"type\": \"uint64\", \"offset\": 24, \"count\": 3},\n"
+	"\t\t{\"name\": \"dm\", \"type\": \"float64\", \"offset\": 48, \"count\": 3},\n"
+	"\t\t{\"name\": \"dm_offsets\", \"type\": \"uint64\", \"offset\": 72, \"count\": 4},\n"
+	"\t\t{\"name\": \"f\", \"type\": \"float32\", \"offset\": 104, \"count\": 2},\n"
+	"\t\t{\"name\": \"f_offsets\", \"type\": \"uint64\", \"offset\": 112, \"count\": 2},\n"
+	"\t\t{\"name\": \"empty\", \"type\": \"float64\", \"offset\": 128, \"count\": 0}\n"
+	"\t]\n"
+	"}\n";
+
+/** Creates a text long enough to fill several TextWriter blocks
+ *
+ * @param[in] nLines The number of lines of text.
+ *
+ * @return A table of numbers, one row per line.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string longText(size_t nLines) {
+	string text;
+	for(size_t i = 0; i < nLines; i++) {
+		text += boost::lexical_cast<string>(i) + "\t" 
+			+ boost::lexical_cast<string>(0.001 * i*i) + "\n";
+	}
+	return text;
+}
+
+#ifdef LCMC_USE_ZLIB
+/** Reads a gzip file using zlib's own reader
+ *
+ * @param[in] fileName The file to read.
+ *
+ * @return The uncompressed contents of the file.
+ *
+ * @exception std::runtime_error Thrown if the file could not be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+string readGzip(const string& fileName) {
+	boost::shared_ptr<gzFile_s> file(gzopen(fileName.c_str(), "rb"), &gzclose);
+	if (file.get() == NULL) {
+		throw std::runtime_error("Could not open " + fileName);
+	}
+	
+	string text;
+	char buffer[4096];
+	int nRead;
+	while ((nRead = gzread(file.get(), buffer, sizeof(buffer))) > 0) {
+		text.append(buffer, nRead);
+	}
+	if (nRead < 0) {
+		throw std::runtime_error("Could not decompress " + fileName);
+	}
+	return text;
+}
+#endif
+
+}	// end unnamed namespace
+
+/** Test cases for the output file formats
+ * @class BoostTest::test_io
+ */
+BOOST_AUTO_TEST_SUITE(test_io)
+
+/** Tests whether zip archives can be read back
+ *
+ * @see @ref lcmc::utils::ZipArchive "ZipArchive"
+ *
+ * @test An uncompressed archive with one entry. Expected behavior: 
+ *	the index lists the entry with the correct size and CRC, and the 
+ *	stored data equal the input.
+ * @test An uncompressed archive with an empty entry. Expected 
+ *	behavior: the entry has size 0 and CRC 0.
+ * @test An uncompressed archive with 1000 entries. Expected behavior: 
+ *	the local headers, central directory, and end record agree, and 
+ *	every entry is stored unchanged.
+ * @test A compressed archive, if the program was built with zlib. 
+ *	Expected behavior: the index is consistent and records the CRC 
+ *	of the uncompressed data.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(zip) {
+	using lcmc::utils::ZipArchive;
+	
+	try {
+		{
+			const string text = "123456789";
+			ZipArchive archive("test_one.zip", false);
+			archive.add("check.txt", vector<char>(text.begin(), text.end()));
+			archive.add("empty.txt", vector<char>());
+			archive.close();
+		}
+		const vector<unsigned char> one = readBytes("test_one.zip");
+		const vector<ZipEntry> oneIndex = readZipIndex(one);
+		BOOST_REQUIRE_EQUAL(oneIndex.size(), 2u);
+		BOOST_CHECK_EQUAL(oneIndex[0].name, "check.txt");
+		BOOST_CHECK_EQUAL(oneIndex[0].method, 0u);
+		BOOST_CHECK_EQUAL(oneIndex[0].size, 9u);
+		BOOST_CHECK_EQUAL(oneIndex[0].storedSize, 9u);
+		// Standard check value of CRC-32
+		BOOST_CHECK_EQUAL(oneIndex[0].crc, 0xCBF43926u);
+		BOOST_CHECK_EQUAL(oneIndex[0].offset, 0u);
+		const vector<unsigned char> data = entryData(one, oneIndex[0]);
+		BOOST_CHECK_EQUAL(string(data.begin(), data.end()), "123456789");
+		BOOST_CHECK_EQUAL(oneIndex[1].name, "empty.txt");
+		BOOST_CHECK_EQUAL(oneIndex[1].size, 0u);
+		BOOST_CHECK_EQUAL(oneIndex[1].crc, 0u);
+		
+		const size_t nEntries = 1000;
+		{
+			ZipArchive archive("test_many.zip", false);
+			for(size_t i = 0; i < nEntries; i++) {
+				archive.add("entry" + boost::lexical_cast<string>(i) 
+					+ ".dat", entryContents(i));
+			}
+			archive.close();
+		}
+		const vector<unsigned char> many = readBytes("test_many.zip");
+		const vector<ZipEntry> manyIndex = readZipIndex(many);
+		BOOST_REQUIRE_EQUAL(manyIndex.size(), nEntries);
+		for(size_t i = 0; i < nEntries; i++) {
+			const vector<char> contents = entryContents(i);
+			BOOST_CHECK_EQUAL(manyIndex[i].name, 
+				"entry" + boost::lexical_cast<string>(i) + ".dat");
+			BOOST_CHECK_EQUAL(manyIndex[i].size, contents.size());
+			BOOST_CHECK_EQUAL(manyIndex[i].crc, slowCrc(contents));
+			const vector<unsigned char> stored = entryData(many, manyIndex[i]);
+			BOOST_CHECK(vector<char>(stored.begin(), stored.end()) == contents);
+			// Entries are written back to back
+			if (i > 0) {
+				BOOST_CHECK_EQUAL(manyIndex[i].offset, manyIndex[i-1].offset 
+					+ 30 + manyIndex[i-1].name.size() + manyIndex[i-1].storedSize);
+			}
+		}
+		
+		if (lcmc::utils::canCompressZip()) {
+			{
+				ZipArchive archive("test_deflate.zip", true);
+				for(size_t i = 0; i < 100; i++) {
+					archive.add("entry" + boost::lexical_cast<string>(i) 
+						+ ".dat", entryContents(i));
+				}
+				archive.close();
+			}
+			const vector<ZipEntry> deflateIndex = readZipIndex(
+				readBytes("test_deflate.zip"));
+			BOOST_REQUIRE_EQUAL(deflateIndex.size(), 100u);
+			for(size_t i = 0; i < deflateIndex.size(); i++) {
+				const vector<char> contents = entryContents(i);
+				BOOST_CHECK_EQUAL(deflateIndex[i].size, contents.size());
+				BOOST_CHECK_EQUAL(deflateIndex[i].crc, slowCrc(contents));
+				// Entries are only deflated if that makes them smaller
+				BOOST_CHECK(deflateIndex[i].method == 0u 
+					|| deflateIndex[i].method == 8u);
+				BOOST_CHECK(deflateIndex[i].storedSize <= contents.size());
+			}
+			std::remove("test_deflate.zip");
+		}
+		
+		std::remove("test_one.zip");
+		std::remove("test_many.zip");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether gzip text files decompress to the text written
+ *
+ * @see @ref lcmc::utils::TextWriter "TextWriter"
+ *
+ * @test A short text written in the foreground. Expected behavior: 
+ *	zlib decompresses the file to the same text.
+ * @test A text spanning several blocks, written in the foreground and 
+ *	in the background. Expected behavior: zlib decompresses each file 
+ *	to the same text.
+ * @test An empty text. Expected behavior: the file is a valid gzip 
+ *	file holding no text.
+ * @test A text written without compression. Expected behavior: the 
+ *	file holds the text unchanged.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(gzip) {
+	using lcmc::utils::TextWriter;
+	
+	try {
+		const string shortText = longText(10);
+		// At least 3 blocks of 1 MiB
+		const string manyBlocks = longText(300000);
+		BOOST_REQUIRE(manyBlocks.size() > 3 << 20);
+		
+		{
+			TextWriter plain("test_plain.txt", false, false);
+			plain.write(manyBlocks);
+			plain.close();
+		}
+		const vector<unsigned char> plainBytes = readBytes("test_plain.txt");
+		BOOST_CHECK(string(plainBytes.begin(), plainBytes.end()) == manyBlocks);
+		std::remove("test_plain.txt");
+		
+#ifdef LCMC_USE_ZLIB
+		{
+			TextWriter small("test_short.txt.gz", false, true);
+			small.write(shortText);
+			small.close();
+		}
+		const vector<unsigned char> header = readBytes("test_short.txt.gz");
+		// gzip magic number
+		BOOST_REQUIRE(header.size() >= 2);
+		BOOST_CHECK_EQUAL(header[0], 0x1fu);
+		BOOST_CHECK_EQUAL(header[1], 0x8bu);
+		BOOST_CHECK_EQUAL(readGzip("test_short.txt.gz"), shortText);
+		
+		for(int background = 0; background <= 1; background++) {
+			{
+				TextWriter big("test_long.txt.gz", background != 0, true);
+				// Write in pieces, as the statistics code does
+				for(size_t i = 0; i < manyBlocks.size(); i += 1000) {
+					big.write(manyBlocks.substr(i, 1000));
+				}
+				big.close();
+			}
+			BOOST_CHECK(readGzip("test_long.txt.gz") == manyBlocks);
+		}
+		
+		{
+			TextWriter empty("test_empty.txt.gz", false, true);
+			empty.close();
+		}
+		BOOST_CHECK_EQUAL(readGzip("test_empty.txt.gz"), "");
+		
+		std::remove("test_short.txt.gz");
+		std::remove("test_long.txt.gz");
+		std::remove("test_empty.txt.gz");
+#endif
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether binary distribution files can be read back
+ *
+ * @see @ref lcmc::stats::ColumnFile "ColumnFile"
+ *
+ * @test A table of numbers, indices, ragged rows in both precisions, 
+ *	and an empty column, with a name that needs escaping. Expected 
+ *	behavior: the data file holds each column in little-endian order 
+ *	at the offset the schema gives, and the schema matches a golden 
+ *	copy.
+ * @test The same table written to a distribution archive. Expected 
+ *	behavior: the archive holds the same data and schema, and 
+ *	nothing is written to disk.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(columns) {
+	try {
+		writeTestTable("test_columns.bin");
+		checkTestTable(readBytes("test_columns.bin"));
+		const vector<unsigned char> schema = readBytes("test_columns.json");
+		BOOST_CHECK_EQUAL(string(schema.begin(), schema.end()), TEST_SCHEMA);
+		std::remove("test_columns.bin");
+		std::remove("test_columns.json");
+		
+		lcmc::stats::openDistribArchive("test_columns.zip", false);
+		writeTestTable("test_columns.bin");
+		lcmc::stats::closeDistribArchive();
+		FILE* const stray = fopen("test_columns.bin", "rb");
+		BOOST_CHECK(stray == NULL);
+		if (stray != NULL) {
+			fclose(stray);
+		}
+		
+		const vector<unsigned char> archive = readBytes("test_columns.zip");
+		const vector<ZipEntry> index = readZipIndex(archive);
+		BOOST_REQUIRE_EQUAL(index.size(), 2u);
+		BOOST_CHECK_EQUAL(index[0].name, "test_columns.bin");
+		checkTestTable(entryData(archive, index[0]));
+		BOOST_CHECK_EQUAL(index[1].name, "test_columns.json");
+		const vector<unsigned char> archivedSchema = entryData(archive, index[1]);
+		BOOST_CHECK_EQUAL(string(archivedSchema.begin(), archivedSchema.end()), 
+			TEST_SCHEMA);
+		std::remove("test_columns.zip");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether a catalog survives being packed into a bundle
+ *
+ * @see @ref lcmc::inject::Bundle "Bundle"
+ * @see @ref lcmc::inject::writeBundle() "writeBundle()"
+ *
+ * @test The catalog test2.cat, packed with writeBundle(). Expected 
+ *	behavior: the file is recognized as a bundle, and both the Bundle 
+ *	and a Catalog opened on it give every light curve of the text 
+ *	catalog with identical times and fluxes, in the same order.
+ * @test A text catalog. Expected behavior: not recognized as a bundle.
+ * @test The bundle cut off after its index. Expected behavior: 
+ *	opening it succeeds, but reading any nonempty light curve throws 
+ *	BadFormat.
+ * @test The bundle cut off inside its header. Expected behavior: 
+ *	opening it throws BadFormat.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(bundle) {
+	using lcmc::inject::Bundle;
+	using lcmc::inject::Catalog;
+	using lcmc::inject::Observations;
+	using lcmc::inject::except::BadFormat;
+	
+	try {
+		lcmc::inject::writeBundle("test2.cat", "test_bundle.bnd");
+		BOOST_CHECK(lcmc::inject::isBundle("test_bundle.bnd"));
+		BOOST_CHECK(!lcmc::inject::isBundle("test2.cat"));
+		
+		const Catalog text("test2.cat");
+		const Bundle packed("test_bundle.bnd");
+		const Catalog bundled("test_bundle.bnd");
+		BOOST_REQUIRE_EQUAL(packed.size(), text.size());
+		BOOST_REQUIRE_EQUAL(bundled.size(), text.size());
+		for(size_t i = 0; i < text.size(); i++) {
+			const boost::shared_ptr<const Observations> original = text.getSource(i);
+			const vector<double>& times  = original->timeView();
+			const vector<double>& fluxes = original->fluxView();
+			
+			BOOST_REQUIRE_EQUAL(packed.sourceSize(i), times.size());
+			BOOST_CHECK(vector<double>(packed.times(i), packed.times(i) 
+				+ packed.sourceSize(i)) == times);
+			BOOST_CHECK(vector<double>(packed.fluxes(i), packed.fluxes(i) 
+				+ packed.sourceSize(i)) == fluxes);
+			
+			const boost::shared_ptr<const Observations> copy = bundled.getSource(i);
+			BOOST_CHECK(copy->timeView() == times);
+			BOOST_CHECK(copy->fluxView() == fluxes);
+		}
+		BOOST_CHECK_THROW(packed.times(text.size()), std::out_of_range);
+		
+		// The header is 16 bytes, and each index entry another 16
+		const vector<unsigned char> bytes = readBytes("test_bundle.bnd");
+		const size_t indexEnd = 16 + 16*text.size();
+		BOOST_REQUIRE(bytes.size() > indexEnd);
+		
+		writePrefix(bytes, indexEnd, "test_truncated.bnd");
+		const Bundle truncated("test_truncated.bnd");
+		BOOST_CHECK_EQUAL(truncated.size(), text.size());
+		for(size_t i = 0; i < text.size(); i++) {
+			if (text.getSource(i)->timeView().size() > 0) {
+				BOOST_CHECK_THROW(truncated.times(i), BadFormat);
+			}
+		}
+		
+		writePrefix(bytes, 12, "test_truncated.bnd");
+		BOOST_CHECK_THROW(Bundle("test_truncated.bnd"), BadFormat);
+		
+		std::remove("test_bundle.bnd");
+		std::remove("test_truncated.bnd");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}		// end lcmc::test
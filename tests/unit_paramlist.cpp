@@ -272,6 +272,47 @@ BOOST_AUTO_TEST_CASE(add) {
 	BOOST_CHECK_THROW(dummyParamList.get("g"), MissingParam);
 }
 
+/** Tests @ref lcmc::models::ParamList "ParamList" access by parameter 
+ *	identifier
+ *
+ * @see @ref lcmc::models::paramId() "paramId()"
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(ids) {
+	using lcmc::models::ParamId;
+	using lcmc::models::paramId;
+	using lcmc::models::paramName;
+	
+	// Built-in parameters have fixed identifiers
+	BOOST_CHECK_EQUAL(paramId("a"), static_cast<ParamId>(lcmc::models::PARAM_AMP));
+	BOOST_CHECK_EQUAL(paramId("p"), static_cast<ParamId>(lcmc::models::PARAM_PERIOD));
+	BOOST_CHECK_EQUAL(paramName(lcmc::models::PARAM_PERIOD2), "period2");
+	
+	// New names get new identifiers, once
+	const ParamId idB = paramId("b");
+	BOOST_CHECK_EQUAL(paramId("b"), idB);
+	BOOST_CHECK_EQUAL(paramName(idB), "b");
+	BOOST_CHECK(paramId("e") != idB);
+	
+	// Names and identifiers refer to the same values
+	BOOST_CHECK_NO_THROW(BOOST_CHECK_EQUAL(dummyParamList.get(idB), -42.0));
+	BOOST_CHECK_NO_THROW(BOOST_CHECK_EQUAL(dummyParamList.get(lcmc::models::PARAM_AMP), 1e10));
+	BOOST_CHECK_THROW(dummyParamList.get(paramId("e")), MissingParam);
+	BOOST_CHECK_NO_THROW(emptyParamList.add(lcmc::models::PARAM_PHASE, 0.25));
+	BOOST_CHECK_NO_THROW(BOOST_CHECK_EQUAL(emptyParamList.get("ph"), 0.25));
+	BOOST_CHECK_THROW(emptyParamList.add("ph", 0.5), ExtraParam);
+	
+	// Iterators know their parameters' identifiers
+	for(RangeList::const_iterator it = dummyRangeList.begin(); 
+			it != dummyRangeList.end(); it++) {
+		BOOST_CHECK_EQUAL(it.getId(), paramId(*it));
+		BOOST_CHECK_EQUAL(it.getMin(), dummyRangeList.getMin(*it));
+		BOOST_CHECK_EQUAL(it.getMax(), dummyRangeList.getMax(*it));
+		BOOST_CHECK(it.getType() == dummyRangeList.getType(*it));
+	}
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
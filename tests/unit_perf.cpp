@@ -0,0 +1,339 @@
+/** Performance tests for Lightcurve MC
+ * @file lightcurveMC/tests/unit_perf.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * These tests are slow and depend on the machine, so they are labeled 
+ * "perf" and skipped by default. Run them with <tt>make perftest</tt>, 
+ * or from the tests directory as <tt>./test --run_test=\@perf</tt>.
+ *
+ * Times are measured in units of a fixed calibration loop, so that the 
+ * budgets hold on faster and slower machines alike. The budgets are 
+ * several times larger than the expected cost, so that only slowdowns 
+ * of the size caused by a lost cache or an extra pass over the data 
+ * fail the tests.
+ *
+ * The calibration loop was measured at 35 ms on an x86-64 build 
+ * machine (g++ -O3). The cost of each operation, written next to its 
+ * budget, is an estimate from its operation count on that machine: 
+ * the operations themselves have not yet been timed, or their 
+ * allocations counted, because the machine lacked GSL. Replace the 
+ * estimates with the numbers printed by <tt>make perftest</tt> when 
+ * tightening a budget.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "../../common/warnflags.h"
+
+// Boost.Test uses C-style casts and non-virtual destructors
+#ifdef GNUC_COARSEWARN
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Weffc++"
+#endif
+
+// Boost.Test uses C-style casts and non-virtual destructors
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Weffc++"
+#endif
+
+#include <boost/test/unit_test.hpp>
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <boost/version.hpp>
+#include "test.h"
+#include "alloccount.h"
+#include "../cadence.h"
+#include "../stats/acfinterp.h"
+#include "../stats/analysiscontext.h"
+#include "../stats/profile.h"
+#include "../stats/statcollect.h"
+#include "../stats/statfamilies.h"
+#include "../waves/lightcurves_gp.h"
+
+// Test labels need Boost 1.59 or later; older versions build the 
+//	performance tests only on request
+#if BOOST_VERSION >= 105900 || defined(LCMC_PERF_TESTS)
+
+namespace lcmc { namespace test {
+
+using std::vector;
+using stats::monotonicSeconds;
+
+/** Returns the time taken by a fixed amount of floating-point work
+ *
+ * @return The shortest of several timings of the calibration loop, 
+ *	in seconds.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double calibrationSeconds() {
+	static double best = 0.0;
+	if (best <= 0.0) {
+		for(int trial = 0; trial < 5; trial++) {
+			const double start = monotonicSeconds();
+			// volatile keeps the compiler from removing the loop
+			volatile double sum = 0.0;
+			for(long i = 0; i < 10000000L; i++) {
+				sum = sum + std::sqrt(static_cast<double>(i));
+			}
+			const double elapsed = monotonicSeconds() - start;
+			if (best <= 0.0 || elapsed < best) {
+				best = elapsed;
+			}
+		}
+	}
+	return best;
+}
+
+/** Checks that an operation stays within its time and allocation budgets
+ *
+ * @tparam Operation A type whose objects may be called with no arguments.
+ *
+ * @param[in] operation The operation to time. It is called once before 
+ *	timing begins, so that any caches it uses are filled.
+ * @param[in] reps The number of calls in each timed batch.
+ * @param[in] maxCalibrations The most time one call may take, in units 
+ *	of calibrationSeconds().
+ * @param[in] maxAllocs The most heap allocations one call may make.
+ *
+ * @post A Boost.Test error is recorded if the fastest of several batches 
+ *	exceeds @p maxCalibrations per call, or if a call allocates 
+ *	more than @p maxAllocs times.
+ *
+ * @exceptsafe Does not throw exceptions beyond those thrown by @p operation.
+ */
+template <class Operation>
+void checkBudget(Operation& operation, long reps, double maxCalibrations, 
+		long maxAllocs) {
+	// Fill the caches
+	operation();
+	
+	const long startAllocs = allocCount();
+	operation();
+	const long allocs = allocCount() - startAllocs;
+	
+	double best = 0.0;
+	for(int trial = 0; trial < 5; trial++) {
+		const double start = monotonicSeconds();
+		for(long i = 0; i < reps; i++) {
+			operation();
+		}
+		const double elapsed = (monotonicSeconds() - start) / reps;
+		if (trial == 0 || elapsed < best) {
+			best = elapsed;
+		}
+	}
+	
+	BOOST_CHECK_LE(best / calibrationSeconds(), maxCalibrations);
+	BOOST_CHECK_LE(allocs, maxAllocs);
+}
+
+/** Simulates a damped random walk
+ */
+class DrwOperation {
+public:
+	explicit DrwOperation(const models::Cadence& times) : times(times), fluxes() {
+	}
+	
+	void operator()() {
+		models::DampedRandomWalk(times, 0.1, 10.0).getFluxes(fluxes);
+	}
+
+private:
+	const models::Cadence& times;
+	vector<double> fluxes;
+};
+
+/** Simulates a squared exponential Gaussian process whose covariance 
+ *	has already been factored
+ */
+class SimpleGpOperation {
+public:
+	explicit SimpleGpOperation(const models::Cadence& times) : times(times), 
+			fluxes() {
+	}
+	
+	void operator()() {
+		models::SimpleGp(times, 1.0, 10.0).getFluxes(fluxes);
+	}
+
+private:
+	const models::Cadence& times;
+	vector<double> fluxes;
+};
+
+/** Calculates the &Delta;m&Delta;t statistics on a cadence whose 
+ *	pair index has already been built
+ */
+class DmdtOperation {
+public:
+	explicit DmdtOperation(const stats::AnalysisContext& lc) : lc(lc) {
+	}
+	
+	void operator()() {
+		stats::CollectedScalars cut50Amp3("", "", false), cut50Amp2("", "", false), 
+			cut90Amp3("", "", false), cut90Amp2("", "", false);
+		stats::CollectedPairs dmdtMed("", "");
+		stats::doDmdt(lc, true, true, cut50Amp3, cut50Amp2, 
+			cut90Amp3, cut90Amp2, dmdtMed);
+	}
+
+private:
+	const stats::AnalysisContext& lc;
+};
+
+/** Calculates the interpolated ACF statistics on a cadence whose 
+ *	plan has already been made
+ */
+class AcfOperation {
+public:
+	explicit AcfOperation(const stats::AnalysisContext& lc) : lc(lc) {
+	}
+	
+	void operator()() {
+		stats::CollectedScalars cut9("", "", false), cut4("", "", false), 
+			cut2("", "", false);
+		stats::CollectedPairs acfPlot("", "");
+		stats::doAcf(lc, &stats::interp::autoCorr, true, true, 
+			cut9, cut4, cut2, acfPlot);
+	}
+
+private:
+	const stats::AnalysisContext& lc;
+};
+
+/** Test cases for testing whether the simulations and statistics run 
+ * within their time and memory budgets
+ * @class BoostTest::test_perf
+ */
+#if BOOST_VERSION >= 105900
+BOOST_FIXTURE_TEST_SUITE(test_perf, ObsData, 
+	* boost::unit_test::label("perf") * boost::unit_test::disabled())
+#else
+BOOST_FIXTURE_TEST_SUITE(test_perf, ObsData)
+#endif
+
+/** Tests whether damped random walks are simulated quickly
+ *
+ * @see @ref lcmc::models::DampedRandomWalk "DampedRandomWalk"
+ *
+ * @test A damped random walk sampled at the PTF epochs takes at most 
+ *	0.1 calibration units and 100 allocations
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(perf_drw) {
+	const models::Cadence cadence(times);
+	DrwOperation operation(cadence);
+	// Estimated 537 steps at ~100 ns, or 0.002 units, and ~10 
+	//	allocations: about 50x and 10x headroom. Not measured.
+	checkBudget(operation, 100, 0.1, 100);
+}
+
+/** Tests whether Gaussian processes reuse their factored covariances
+ *
+ * @see @ref lcmc::models::SimpleGp "SimpleGp"
+ *
+ * @test A squared exponential Gaussian process sampled at the PTF epochs, 
+ *	with an unchanged timescale, takes at most 0.5 calibration 
+ *	units and 100 allocations. Factoring the covariance takes 
+ *	much longer.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(perf_simple_gp) {
+	const models::Cadence cadence(times);
+	SimpleGpOperation operation(cadence);
+	// Estimated one 537x537 triangular product, or 0.005 units, and 
+	//	~10 allocations: about 100x and 10x headroom. A new 
+	//	factorization (~5e7 flops, ~1 unit) is what the budget catches. 
+	//	Not measured.
+	checkBudget(operation, 20, 0.5, 100);
+}
+
+/** Tests whether &Delta;m&Delta;t statistics reuse their pair index
+ *
+ * @see @ref lcmc::stats::doDmdt() "doDmdt()"
+ * @see @ref lcmc::stats::DmdtPairIndex "DmdtPairIndex"
+ *
+ * @test The &Delta;m&Delta;t statistics of a damped random walk sampled 
+ *	at the PTF epochs take at most 1 calibration unit and 2000 
+ *	allocations
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(perf_dmdt) {
+	const models::Cadence cadence(times);
+	vector<double> fluxes;
+	models::DampedRandomWalk(cadence, 0.1, 10.0).getFluxes(fluxes);
+	const stats::AnalysisContext lc(cadence, fluxes);
+	
+	DmdtOperation operation(lc);
+	// Estimated two passes over 1.4e5 pairs, or 0.05 units, and ~200 
+	//	allocations for the bins and collections: about 20x and 10x 
+	//	headroom. Not measured.
+	checkBudget(operation, 10, 1.0, 2000);
+}
+
+/** Tests whether interpolated ACFs reuse their plans
+ *
+ * @see @ref lcmc::stats::doAcf() "doAcf()"
+ * @see @ref lcmc::stats::interp::autoCorr() "interp::autoCorr()"
+ *
+ * @test The interpolated ACF statistics of a damped random walk sampled 
+ *	at the PTF epochs take at most 1 calibration unit and 500 
+ *	allocations
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(perf_acf) {
+	const models::Cadence cadence(times);
+	vector<double> fluxes;
+	models::DampedRandomWalk(cadence, 0.1, 10.0).getFluxes(fluxes);
+	const stats::AnalysisContext lc(cadence, fluxes);
+	
+	AcfOperation operation(lc);
+	// Estimated one interpolation onto the lag grid and one 
+	//	autocorrelation of it, or about 0.05 units, and ~50 
+	//	allocations: about 20x and 10x headroom. Not measured.
+	checkBudget(operation, 10, 1.0, 500);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}		// end lcmc::test
+
+#endif		// end BOOST_VERSION >= 105900 || defined(LCMC_PERF_TESTS)
@@ -0,0 +1,452 @@
+/** Test unit for per-trial random number streams
+ * @file lightcurveMC/tests/unit_rng.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../common/warnflags.h"
+
+// Boost.Test uses C-style casts and non-virtual destructors
+#ifdef GNUC_COARSEWARN
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Weffc++"
+#endif
+
+// Boost.Test uses C-style casts and non-virtual destructors
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Weffc++"
+#endif
+
+#include <boost/test/unit_test.hpp>
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <cmath>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <gsl/gsl_rng.h>
+#include "../noisepool.h"
+#include "../rngstream.h"
+#include "../sims.h"
+#include "../waves/lcstochastic.h"
+
+using boost::uint32_t;
+using boost::shared_ptr;
+using std::vector;
+
+using namespace lcmc::utils;
+
+namespace lcmc { namespace test {
+
+/** Draws the first few numbers from a stream
+ *
+ * @param[in] rng The stream to sample.
+ * @param[in] n The number of values to draw.
+ *
+ * @return The first @p n values of @p rng.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the values.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<unsigned long> sample(gsl_rng* rng, size_t n) {
+	vector<unsigned long> values;
+	for(size_t i = 0; i < n; i++) {
+		values.push_back(gsl_rng_get(rng));
+	}
+	return values;
+}
+
+/** Draws the first few numbers from a newly allocated stream
+ *
+ * @param[in] seed, bin, trial, stream The stream to sample.
+ * @param[in] n The number of values to draw.
+ *
+ * @return The first @p n values of the stream.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to create the stream or store the values.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+vector<unsigned long> sample(unsigned long seed, unsigned long bin,
+		unsigned long trial, StreamType stream, size_t n) {
+	shared_ptr<gsl_rng> rng(allocStream(seed, bin, trial, stream), &gsl_rng_free);
+	return sample(rng.get(), n);
+}
+
+/** Test cases for per-trial random number streams
+ * @class BoostTest::test_rng
+ */
+BOOST_AUTO_TEST_SUITE(test_rng)
+
+/** Tests whether the Philox bijection matches the published
+ *	known-answer values
+ *
+ * @see @ref lcmc::utils::philox4x32() "philox4x32()"
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(philox_kat) {
+	uint32_t result[4];
+
+	const uint32_t zeroCtr[4] = {0, 0, 0, 0};
+	const uint32_t zeroKey[2] = {0, 0};
+	philox4x32(zeroCtr, zeroKey, result);
+	BOOST_CHECK_EQUAL(result[0], 0x6627e8d5UL);
+	BOOST_CHECK_EQUAL(result[1], 0xe169c58dUL);
+	BOOST_CHECK_EQUAL(result[2], 0xbc57ac4cUL);
+	BOOST_CHECK_EQUAL(result[3], 0x9b00dbd8UL);
+
+	const uint32_t onesCtr[4] = {0xffffffffUL, 0xffffffffUL, 0xffffffffUL, 0xffffffffUL};
+	const uint32_t onesKey[2] = {0xffffffffUL, 0xffffffffUL};
+	philox4x32(onesCtr, onesKey, result);
+	BOOST_CHECK_EQUAL(result[0], 0x408f276dUL);
+	BOOST_CHECK_EQUAL(result[1], 0x41c83b0eUL);
+	BOOST_CHECK_EQUAL(result[2], 0xa20bc7c6UL);
+	BOOST_CHECK_EQUAL(result[3], 0x6d5451fdUL);
+
+	const uint32_t piCtr[4] = {0x243f6a88UL, 0x85a308d3UL, 0x13198a2eUL, 0x03707344UL};
+	const uint32_t piKey[2] = {0xa4093822UL, 0x299f31d0UL};
+	philox4x32(piCtr, piKey, result);
+	BOOST_CHECK_EQUAL(result[0], 0xd16cfe09UL);
+	BOOST_CHECK_EQUAL(result[1], 0x94fdccebUL);
+	BOOST_CHECK_EQUAL(result[2], 0x5001e420UL);
+	BOOST_CHECK_EQUAL(result[3], 0x24126ea1UL);
+}
+
+/** Tests whether streams depend only on their keys
+ *
+ * @see @ref lcmc::utils::allocStream() "allocStream()"
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(stream_keys) {
+	const size_t N = 10;
+
+	// Reproducible regardless of what else has been generated
+	const vector<unsigned long> ref = sample(42, 3, 17, NOISE_STREAM, N);
+	sample(42, 3, 16, NOISE_STREAM, N);
+	BOOST_CHECK(sample(42, 3, 17, NOISE_STREAM, N) == ref);
+
+	// Any change to the key gives a different stream
+	BOOST_CHECK(sample(43, 3, 17, NOISE_STREAM, N) != ref);
+	BOOST_CHECK(sample(42, 4, 17, NOISE_STREAM, N) != ref);
+	BOOST_CHECK(sample(42, 3, 18, NOISE_STREAM, N) != ref);
+	BOOST_CHECK(sample(42, 3, 17, PARAM_STREAM, N) != ref);
+
+	// Copies continue the same stream
+	shared_ptr<gsl_rng> rng(allocStream(42, 3, 17, NOISE_STREAM), &gsl_rng_free);
+	vector<unsigned long> head = sample(rng.get(), 3);
+	shared_ptr<gsl_rng> copy(gsl_rng_clone(rng.get()), &gsl_rng_free);
+	BOOST_CHECK(sample(rng.get(), N-3) == sample(copy.get(), N-3));
+	BOOST_CHECK(std::equal(head.begin(), head.end(), ref.begin()));
+}
+
+/** Tests whether light curve generators follow the same streams as 
+ *	allocated generators, and can be saved and restored by value
+ *
+ * @see @ref lcmc::models::StochasticRng "StochasticRng"
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(model_rng) {
+	const size_t N = 10;
+
+	shared_ptr<gsl_rng> ref(allocStream(42, 3, 17, MODEL_STREAM), &gsl_rng_free);
+	models::StochasticRng rng(42, 3, 17, MODEL_STREAM);
+	for(size_t i = 0; i < N; i++) {
+		BOOST_CHECK_EQUAL(rng.rUnif(), gsl_rng_uniform(ref.get()));
+	}
+
+	// Copies continue the same stream without affecting the original
+	const models::StochasticRng saved = rng;
+	vector<double> head;
+	for(size_t i = 0; i < N; i++) {
+		head.push_back(rng.rNorm());
+	}
+	models::StochasticRng copy = saved;
+	for(size_t i = 0; i < N; i++) {
+		BOOST_CHECK_EQUAL(copy.rNorm(), head[i]);
+	}
+	
+	// Assignment restores an earlier state
+	rng = saved;
+	BOOST_CHECK_EQUAL(rng.rNorm(), head[0]);
+}
+
+/** Tests whether light curve generators constructed from a seed alone 
+ *	follow the Mersenne Twister, and can be saved and restored
+ *
+ * @see @ref lcmc::models::StochasticRng "StochasticRng"
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(legacy_model_rng) {
+	const size_t N = 10;
+
+	shared_ptr<gsl_rng> ref(gsl_rng_alloc(gsl_rng_mt19937), &gsl_rng_free);
+	gsl_rng_set(ref.get(), 42);
+	models::StochasticRng rng(42);
+	for(size_t i = 0; i < N; i++) {
+		BOOST_CHECK_EQUAL(rng.rUnif(), gsl_rng_uniform(ref.get()));
+	}
+
+	// Copies have their own state
+	const models::StochasticRng saved = rng;
+	vector<double> head;
+	for(size_t i = 0; i < N; i++) {
+		head.push_back(rng.rNorm());
+	}
+	models::StochasticRng copy = saved;
+	for(size_t i = 0; i < N; i++) {
+		BOOST_CHECK_EQUAL(copy.rNorm(), head[i]);
+	}
+	
+	// Assignment restores an earlier state
+	rng = saved;
+	BOOST_CHECK_EQUAL(rng.rNorm(), head[0]);
+	
+	// Bulk draws give the same sequence as single draws
+	rng = saved;
+	vector<double> bulk(N);
+	rng.fillNormal(&bulk[0], N, 2.0);
+	for(size_t i = 0; i < N; i++) {
+		BOOST_CHECK_EQUAL(bulk[i], 2.0 * head[i]);
+	}
+}
+
+/** Tests whether bulk normal variates have the right distribution and 
+ *	do not depend on how the draws are divided into calls
+ *
+ * @see @ref lcmc::utils::fillNormal() "fillNormal()"
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(fill_normal) {
+	const size_t N = 100000;
+	const double sigma = 2.0;
+
+	shared_ptr<gsl_rng> rng(allocStream(42, 3, 17, NOISE_STREAM), &gsl_rng_free);
+	vector<double> values(N);
+	fillNormal(rng.get(), &values[0], N, sigma);
+
+	double sum = 0.0, sumSq = 0.0;
+	for(size_t i = 0; i < N; i++) {
+		sum   += values[i];
+		sumSq += values[i]*values[i];
+	}
+	const double mean = sum / N;
+	const double var  = sumSq / N - mean*mean;
+	// Tolerances are about five standard errors
+	BOOST_CHECK_SMALL(mean, 5.0 * sigma / sqrt(static_cast<double>(N)));
+	BOOST_CHECK_CLOSE(var, sigma*sigma, 5.0 * 100.0 * sqrt(2.0 / N));
+
+	// Splitting an even-length request gives the same variates
+	models::StochasticRng whole(42, 3, 17, MODEL_STREAM);
+	models::StochasticRng parts(42, 3, 17, MODEL_STREAM);
+	vector<double> once(300), twice(300);
+	whole.fillNormal(&once[0], 300, 1.0);
+	parts.fillNormal(&twice[0], 130, 1.0);
+	parts.fillNormal(&twice[130], 170, 1.0);
+	BOOST_CHECK(once == twice);
+}
+
+/** Tests whether TrialStreams installs and restores the current streams
+ *
+ * @see @ref lcmc::utils::TrialStreams "TrialStreams"
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(trial_scope) {
+	const size_t N = 10;
+
+	BOOST_CHECK(trialStream(PARAM_STREAM) == NULL);
+	BOOST_CHECK(trialModelRng() == NULL);
+
+	{
+		TrialStreams outer(42, 0, 5);
+		BOOST_REQUIRE(trialStream(PARAM_STREAM) != NULL);
+		BOOST_REQUIRE(trialModelRng() != NULL);
+		BOOST_CHECK(sample(trialStream(INJECT_STREAM), N)
+			== sample(42, 0, 5, INJECT_STREAM, N));
+
+		{
+			TrialStreams inner(42, 0, 6);
+			BOOST_CHECK(trialStream(NOISE_STREAM) == inner.stream(NOISE_STREAM));
+		}
+		BOOST_CHECK(trialStream(NOISE_STREAM) == outer.stream(NOISE_STREAM));
+		BOOST_CHECK(trialModelRng() == &(outer.modelRng()));
+	}
+
+	BOOST_CHECK(trialStream(NOISE_STREAM) == NULL);
+	BOOST_CHECK(trialModelRng() == NULL);
+}
+
+/** Tests whether parameter draws are reproducible within a trial
+ *
+ * @see @ref lcmc::drawParams() "drawParams()"
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(trial_params) {
+	models::RangeList limits;
+	limits.add("a", 0.0, 1.0, models::RangeList::UNIFORM);
+	limits.add("p", 1.0, 100.0, models::RangeList::LOGUNIFORM);
+
+	models::ParamList first, second;
+	{
+		TrialStreams streams(1, 2, 3);
+		first = drawParams(limits);
+	}
+	// Legacy generator should not disturb the trial streams
+	drawParams(limits);
+	{
+		TrialStreams streams(1, 2, 3);
+		second = drawParams(limits);
+	}
+
+	BOOST_CHECK_EQUAL(first.get("a"), second.get("a"));
+	BOOST_CHECK_EQUAL(first.get("p"), second.get("p"));
+}
+
+/** Tests whether Sobol sampling covers the parameter ranges evenly
+ *
+ * @see @ref lcmc::drawParams() "drawParams()"
+ * @see @ref lcmc::utils::sobolPoint() "sobolPoint()"
+ *
+ * @test the first 256 trials put exactly one point in each cell of a 
+ *	16&times;16 grid over two parameters, respecting LOGUNIFORM ranges
+ * @test fixed parameters do not use up a dimension
+ * @test the points of a trial depend only on the seed, bin, and trial
+ * @test different seeds give different points
+ * @test Sobol sampling without a TrialStreams object throws logic_error
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(sobol_params) {
+	models::RangeList limits;
+	limits.add("a", 0.0, 1.0, models::RangeList::UNIFORM);
+	limits.add("d", 0.5, 0.5, models::RangeList::UNIFORM);
+	limits.add("p", 1.0, 100.0, models::RangeList::LOGUNIFORM);
+
+	setParamSampling(SAMPLE_SOBOL);
+	vector<int> cells(16*16, 0);
+	for(unsigned long trial = 0; trial < 256; trial++) {
+		TrialStreams streams(7, 1, trial);
+		const models::ParamList params = drawParams(limits);
+		
+		const int a = static_cast<int>(16.0 * params.get("a"));
+		const int p = static_cast<int>(8.0 * log10(params.get("p")));
+		BOOST_REQUIRE(a >= 0 && a < 16 && p >= 0 && p < 16);
+		cells[16*a + p]++;
+		BOOST_CHECK_EQUAL(params.get("d"), 0.5);
+		
+		BOOST_CHECK_EQUAL(sobolPoint(7, 1, trial, 0), streams.sobol(0));
+	}
+	BOOST_CHECK(std::count(cells.begin(), cells.end(), 1) == 16*16);
+	
+	BOOST_CHECK(sobolPoint(7, 1, 5, 2) == sobolPoint(7, 1, 5, 2));
+	BOOST_CHECK(sobolPoint(7, 1, 5, 2) != sobolPoint(8, 1, 5, 2));
+	BOOST_CHECK_THROW(sobolPoint(7, 1, 5, sobolDimensions()), 
+		std::invalid_argument);
+	
+	BOOST_CHECK_THROW(drawParams(limits), std::logic_error);
+	setParamSampling(SAMPLE_RANDOM);
+}
+
+/** Tests whether pooled noise is the same as newly drawn noise
+ *
+ * @see @ref lcmc::NoisePool "NoisePool"
+ * @see @ref lcmc::makeWhiteNoise() "makeWhiteNoise()"
+ *
+ * @test the first and later requests for a trial in the pool give the 
+ *	noise drawn without a pool
+ * @test trials outside the pool, with another seed, or with another 
+ *	amplitude are drawn as without a pool
+ * @test the pool does not cover code outside a TrialStreams object
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(noise_pool) {
+	const vector<double> times(20, 0.0);
+	const double SIGMA = 0.1;
+
+	vector<double> expected, other;
+	{
+		TrialStreams streams(42, 1, 5);
+		makeWhiteNoise(times, SIGMA, expected);
+	}
+	{
+		TrialStreams streams(42, 1, 9);
+		makeWhiteNoise(times, SIGMA, other);
+	}
+
+	const boost::shared_ptr<NoisePool> pool(new NoisePool(42, 2, 3, 8, 
+		times.size(), SIGMA));
+	BOOST_CHECK(!pool->isMapped());
+	BOOST_CHECK_EQUAL(pool->bytes(), 2*5*times.size()*sizeof(double));
+	setNoisePool(pool);
+	for(int i = 0; i < 2; i++) {
+		TrialStreams streams(42, 1, 5);
+		vector<double> noise;
+		makeWhiteNoise(times, SIGMA, noise);
+		BOOST_CHECK(noise == expected);
+	}
+	{
+		TrialStreams streams(42, 1, 9);
+		vector<double> noise;
+		BOOST_CHECK(!pool->draw(times.size(), SIGMA, noise));
+		makeWhiteNoise(times, SIGMA, noise);
+		BOOST_CHECK(noise == other);
+	}
+	{
+		TrialStreams streams(43, 1, 5);
+		vector<double> noise;
+		BOOST_CHECK(!pool->draw(times.size(), SIGMA, noise));
+	}
+	{
+		TrialStreams streams(42, 1, 5);
+		vector<double> noise;
+		BOOST_CHECK(!pool->draw(times.size(), 2.0*SIGMA, noise));
+	}
+	vector<double> noise;
+	BOOST_CHECK(!pool->draw(times.size(), SIGMA, noise));
+	setNoisePool(boost::shared_ptr<NoisePool>());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}		// end lcmc::test
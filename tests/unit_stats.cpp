@@ -2,7 +2,7 @@
  * @file lightcurveMC/tests/unit_stats.cpp
  * @author Krzysztof Findeisen
  * @date Created April 18, 2013
- * @date Last modified October 29, 2013
+ * @date Last modified October 14, 2026
  *
  * @todo Break up this file.
  */
@@ -55,23 +55,59 @@
 #include <limits>
 #include <stdexcept>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <unistd.h>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_errno.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_math.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_statistics_double.h>
+#include <timescales/timescales.h>
 #include "../stats/acfinterp.h"
+#include "../stats/analysiscontext.h"
+#include "../stats/deadline.h"
+#include "../stats/profile.h"
+#include "../stats/trace.h"
+#include "../binstats.h"
+#include "../cachestats.h"
+#include "../checkpoint.h"
+#include "../costmodel.h"
+#include "../trialarchive.h"
+#include "../resultcache.h"
+#include "../jobserver.h"
+#include "../lcdump.h"
+#include "../largealloc.tmp.h"
+#include "../numa.h"
+#include "../trialpool.h"
+#include "../stats/drwfit.h"
+#include "../stats/experimental.h"
+#include "../stats/gpfit.h"
+#include "../stats/plugins.h"
 #include "../approx.h"
+#include "../fluxmag.h"
 #include "../../common/cerror.h"
 #include "../../common/fileio.h"
+#include "../../common/stats.tmp.h"
 #include "../waves/generators.h"
 #include "../gsl_compat.h"
+#include "../gslpool.tmp.h"
 #include "../../common/lcio.h"
+#include "../stats/lsplan.h"
+#include "../stats/lsthreshold.h"
 #include "../stats/magdist.h"
+#include "../stats/quantilesketch.h"
+#include "../stats/raggedarray.h"
+#include "../stats/runningstats.h"
+#include "../stats/scargleacf.h"
+#include "../stats/scratch.h"
+#include "../stats/statfamilies.h"
+#include "../stats/statcollect.h"
 #include "../mcio.h"
 #include "../nan.h"
 #include "test.h"
@@ -88,7 +124,7 @@ using kpfutils::fileCheckOpen;
 
 namespace lcmc { namespace utils {
 
-shared_ptr<gsl_matrix> getHalfMatrix(const shared_ptr<gsl_matrix>& a);
+shared_ptr<gsl_matrix> getHalfMatrix(const shared_ptr<const gsl_matrix>& a);
 
 }}	// end lcmc::utils
 
@@ -99,8 +135,14 @@ namespace lcmc { namespace stats {
 void getSummaryStats(const DoubleVec& values, double& mean, double& stddev, 
 		const std::string& statName);
 
+void getSummaryStats(const DoubleVec& values, double& mean, double& stddev, 
+		double& goodFrac, const std::string& statName);
+
 void autoCorrelation_stat(const double data[], double acfs[], size_t n);
 
+void autoCorrelation_stat(const double data[], double acfs[], size_t n, 
+		size_t nSeries);
+
 }}	// end lcmc::stats
 /// @endcond
 
@@ -190,8 +232,10 @@ public:
 	vector<double> awfulVec;
 };
 
-/** Tests whether @ref utils::meanNoNan() "meanNoNan()" and 
- *	@ref utils::varianceNoNan() "varianceNoNan()" correctly handle NaN values
+/** Tests whether @ref utils::meanNoNan() "meanNoNan()", 
+ *	@ref utils::varianceNoNan() "varianceNoNan()", 
+ *	@ref utils::summarizeNoNan() "summarizeNoNan()", and 
+ *	@ref utils::removeNans() "removeNans()" correctly handle NaN values
  *
  * @param[in] seed A random seed for generating multiple data sets.
  * @param[in] nTests The number of values whose mean and variance will be calculated.
@@ -233,6 +277,42 @@ void testNanProof(unsigned long int seed, size_t nTests) {
 		gsl_stats_mean    (cleanArr.get(), 1, nClean), 1e-10));
 	BOOST_CHECK_NO_THROW(myTestClose(utils::varianceNoNan(dirty), 
 		gsl_stats_variance(cleanArr.get(), 1, nClean), 1e-10));
+	
+	size_t count;
+	double mean, variance;
+	utils::summarizeNoNan(dirty, count, mean, variance);
+	BOOST_CHECK_EQUAL(count, nClean);
+	BOOST_CHECK_NO_THROW(myTestClose(variance, 
+		gsl_stats_variance(cleanArr.get(), 1, nClean), 1e-10));
+	
+	// A large offset must not cost the variance its precision
+	vector<double> offset(dirty);
+	for(size_t i = 0; i < offset.size(); i++) {
+		offset[i] += 1e6;
+	}
+	utils::summarizeNoNan(offset, count, mean, variance);
+	BOOST_CHECK_NO_THROW(myTestClose(variance, 
+		gsl_stats_variance(cleanArr.get(), 1, nClean), 1e-6));
+	
+	// An infinite value must not be used as the offset
+	vector<double> infinite(dirty);
+	infinite.insert(infinite.begin(), std::numeric_limits<double>::infinity());
+	utils::summarizeNoNan(infinite, count, mean, variance);
+	BOOST_CHECK_EQUAL(count, nClean + 1);
+	BOOST_CHECK_EQUAL(mean, std::numeric_limits<double>::infinity());
+	
+	// Use the positions as the matching values, to check the order
+	vector<double> index, goodVals, matchVals;
+	for(size_t i = 0; i < dirty.size(); i++) {
+		index.push_back(static_cast<double>(i));
+	}
+	utils::removeNans(dirty, goodVals, index, matchVals);
+	BOOST_REQUIRE_EQUAL(goodVals.size(), nClean);
+	BOOST_REQUIRE_EQUAL(matchVals.size(), nClean);
+	for(size_t i = 0; i < nClean; i++) {
+		BOOST_CHECK_EQUAL(goodVals[i], clean[i]);
+		BOOST_CHECK_EQUAL(goodVals[i], dirty[static_cast<size_t>(matchVals[i])]);
+	}
 }
 
 /** Tests whether lcmc::utils::getHalfMatrix() correctly decomposes a matrix into two factors
@@ -328,6 +408,31 @@ void testProduct(const shared_ptr< gsl_matrix > & initial)
 	
 }
 
+/** Finds the number of hits reported for a cache
+ *
+ * @param[in] report A file written by 
+ *	@ref utils::printCacheReport() "printCacheReport()".
+ * @param[in] cacheName The name of the cache to look up.
+ *
+ * @return The number of hits listed for @p cacheName, or -1 if it is 
+ *	not listed.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long readCacheHits(FILE* report, const std::string& cacheName) {
+	rewind(report);
+	char line[256];
+	while (fgets(line, sizeof(line), report) != NULL) {
+		long hits;
+		if (strncmp(line, cacheName.c_str(), cacheName.size()) == 0 
+				&& line[cacheName.size()] == ' ' 
+				&& sscanf(line + cacheName.size(), "%ld", &hits) == 1) {
+			return hits;
+		}
+	}
+	return -1;
+}
+
 /** Test cases for testing functions related to handling Nan values
  * @class BoostTest::test_nan
  */
@@ -476,117 +581,3342 @@ BOOST_AUTO_TEST_CASE(zero_variance) {
 	}
 }
 
-/** Tests whether @ref lcmc::stats::autoCorrelation_stat() "autoCorrelation_stat()" 
- *	matches existing autocorrelation implementations from other languages
- * @see @ref lcmc::stats::autoCorrelation_stat() "autoCorrelation_stat()"
+/** Tests whether @ref lcmc::stats::RunningStats "RunningStats" 
+ *	reproduces the summaries of stored statistics
  *
- * @test Consistent results with a_correlate() procedure from IDL
+ * @see @ref lcmc::stats::RunningStats "RunningStats"
+ *
+ * @test given a vector with NaNs, gives the same mean, standard deviation, 
+ *	and definition rate as getSummaryStats()
+ * @test merging summaries of the two halves of a vector gives the 
+ *	same results as summarizing the whole vector
  *
  * @exceptsafe Does not throw exceptions.
  */
-BOOST_AUTO_TEST_CASE(acf) {
-	shared_ptr<FILE> hTarget;
+BOOST_AUTO_TEST_CASE(running_summary) {
 	try {
-		hTarget = fileCheckOpen("acftarget.txt", "r");
-	} catch (const kpfutils::except::FileIo& e) {
-		BOOST_FAIL(e.what());
+		vector<double> values;
+		for(size_t i = 0; i < ptfTimes.size(); i++) {
+			values.push_back(i % 7 == 0 
+				? std::numeric_limits<double>::quiet_NaN() 
+				: 3.0 + sin(ptfTimes[i]));
+		}
+		
+		double mean, stddev, goodFrac;
+		BOOST_REQUIRE_NO_THROW(lcmc::stats::getSummaryStats(values, mean, stddev, 
+			goodFrac, "Running Summary Test"));
+		
+		lcmc::stats::RunningStats whole, front, back;
+		for(size_t i = 0; i < values.size(); i++) {
+			whole.add(values[i]);
+			(i < values.size()/2 ? front : back).add(values[i]);
+		}
+		front.merge(back);
+		BOOST_CHECK_EQUAL(whole.count(), values.size());
+		BOOST_CHECK_EQUAL(front.count(), values.size());
+		
+		double runMean, runStddev, runFrac;
+		whole.getSummary(runMean, runStddev, runFrac, "Running Summary Test");
+		BOOST_CHECK_CLOSE(runMean  , mean    , 1e-8);
+		BOOST_CHECK_CLOSE(runStddev, stddev  , 1e-8);
+		BOOST_CHECK_CLOSE(runFrac  , goodFrac, 1e-8);
+		
+		front.getSummary(runMean, runStddev, runFrac, "Running Summary Test");
+		BOOST_CHECK_CLOSE(runMean  , mean    , 1e-8);
+		BOOST_CHECK_CLOSE(runStddev, stddev  , 1e-8);
+		BOOST_CHECK_CLOSE(runFrac  , goodFrac, 1e-8);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
 	}
+}
+
+/** Tests whether @ref lcmc::stats::RunningStats "RunningStats" 
+ *	estimates the error of its mean
+ *
+ * @see @ref lcmc::stats::RunningStats::relativeError() "RunningStats::relativeError()"
+ *
+ * @test fewer than two finite values give NaN
+ * @test the values 1 and 3 give a relative error of 0.5
+ * @test NaNs are ignored
+ * @test an infinite value gives infinity
+ * @test a mean of zero gives infinity
+ * @test the relative error of N copies of a pair of values falls 
+ *	as 1/sqrt(N)
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(relative_error) {
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	const double inf = std::numeric_limits<double>::infinity();
+	
+	lcmc::stats::RunningStats stats;
+	BOOST_CHECK(gsl_isnan(stats.relativeError()));
+	stats.add(1.0);
+	stats.add(nan);
+	BOOST_CHECK(gsl_isnan(stats.relativeError()));
+	stats.add(3.0);
+	BOOST_CHECK_CLOSE(stats.relativeError(), 0.5, 1e-8);
+	
+	lcmc::stats::RunningStats infinite(stats);
+	infinite.add(inf);
+	BOOST_CHECK_EQUAL(infinite.relativeError(), inf);
 	
+	lcmc::stats::RunningStats zero;
+	zero.add(-1.0);
+	zero.add( 1.0);
+	BOOST_CHECK_EQUAL(zero.relativeError(), inf);
+	
+	lcmc::stats::RunningStats many;
+	for(int i = 0; i < 50; i++) {
+		many.add(1.0);
+		many.add(3.0);
+	}
+	// stddev = sqrt(100/99), SE = stddev/10, mean = 2
+	BOOST_CHECK_CLOSE(many.relativeError(), sqrt(100.0/99.0)/20.0, 1e-8);
+}
+
+/** Tests whether RaggedArray stores and removes rows correctly
+ *
+ * @see @ref lcmc::stats::RaggedArray "RaggedArray"
+ *
+ * @test rows of different lengths, including empty rows, read back 
+ *	unchanged
+ * @test appending an array to itself duplicates its rows
+ * @test truncating the array removes only the last rows
+ * @test a row built from selected elements of a vector holds those 
+ *	elements, in order
+ * @test requesting a nonexistent row throws out_of_range
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(ragged_array) {
 	try {
-		while(!feof(hTarget.get())) {
-			double data[10];
-			for(size_t i = 0; i < 10 && !feof(hTarget.get()); i++) {
-				double curVal;
-				fscanf(hTarget.get(), "%lf", &curVal);
-				data[i] = curVal;
-			}
-			if (feof(hTarget.get())) {
-				break;
+		using lcmc::stats::RaggedArray;
+		
+		vector<vector<double> > rows;
+		for(size_t i = 0; i < 20; i++) {
+			vector<double> row;
+			for(size_t j = 0; j < (i*7) % 5; j++) {
+				row.push_back(static_cast<double>(10*i + j));
 			}
+			rows.push_back(row);
+		}
+		
+		RaggedArray array;
+		BOOST_CHECK_EQUAL(array.size(), 0U);
+		for(size_t i = 0; i < rows.size(); i++) {
+			array.push_back(rows[i]);
+		}
+		BOOST_REQUIRE_EQUAL(array.size(), rows.size());
+		for(size_t i = 0; i < rows.size(); i++) {
+			BOOST_CHECK_EQUAL(array.rowSize(i), rows[i].size());
+			BOOST_CHECK_EQUAL_COLLECTIONS(array.rowBegin(i), array.rowEnd(i), 
+				rows[i].begin(), rows[i].end());
+		}
+		
+		array.append(array);
+		BOOST_REQUIRE_EQUAL(array.size(), 2*rows.size());
+		for(size_t i = 0; i < array.size(); i++) {
+			const vector<double>& row = rows[i % rows.size()];
+			BOOST_CHECK_EQUAL_COLLECTIONS(array.rowBegin(i), array.rowEnd(i), 
+				row.begin(), row.end());
+		}
+		
+		array.truncate(3);
+		BOOST_REQUIRE_EQUAL(array.size(), 3U);
+		BOOST_CHECK_EQUAL_COLLECTIONS(array.rowBegin(2), array.rowEnd(2), 
+			rows[2].begin(), rows[2].end());
+		BOOST_CHECK_THROW(array.rowBegin(3), std::out_of_range);
+		
+		vector<size_t> picks;
+		picks.push_back(0);
+		picks.push_back(3);
+		picks.push_back(1);
+		array.push_back(rows[2], picks);
+		BOOST_REQUIRE_EQUAL(array.size(), 4U);
+		BOOST_REQUIRE_EQUAL(array.rowSize(3), picks.size());
+		for(size_t i = 0; i < picks.size(); i++) {
+			BOOST_CHECK_EQUAL(array.rowBegin(3)[i], rows[2][picks[i]]);
+		}
+		
+		array.clear();
+		BOOST_CHECK_EQUAL(array.size(), 0U);
+		BOOST_CHECK_THROW(array.rowSize(0), std::out_of_range);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
 
-			double corrs[10];
-			for(size_t i = 0; i < 10 && !feof(hTarget.get()); i++) {
-				double curVal;
-				fscanf(hTarget.get(), "%lf", &curVal);
-				corrs[i] = curVal;
-			}
-			if (feof(hTarget.get())) {
-				break;
-			}
-			
-			double acfs[10];
-			BOOST_REQUIRE_NO_THROW(
-				lcmc::stats::autoCorrelation_stat(data, acfs, 10));
-			
-			for(size_t i = 0; i < 10; i++) {
-				myTestClose(acfs[i], corrs[i], 1e-5);
-			}
+/** Counts the lines in a text file
+ *
+ * @param[in] fileName The file to read.
+ *
+ * @return The number of newline characters in the file.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the file could not be 
+ *	opened.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+long countLines(const std::string& fileName) {
+	boost::shared_ptr<FILE> file = kpfutils::fileCheckOpen(fileName, "r");
+	long lines = 0;
+	int c;
+	while ((c = fgetc(file.get())) != EOF) {
+		if (c == '\n') {
+			lines++;
 		}
-	} catch (const std::exception &e) {
-		BOOST_MESSAGE("Could not finish reading from acftarget.txt.");
+	}
+	return lines;
+}
+
+/** Tests whether CollectedPairs can write its statistics in parts
+ *
+ * @see @ref lcmc::stats::CollectedPairs "CollectedPairs"
+ *
+ * @test recording statistics increases memoryBytes()
+ * @test spill() writes the statistics recorded so far to part 1 of 
+ *	the distribution file, and frees their memory
+ * @test printStats() writes the remaining statistics to part 2, and 
+ *	prints a pattern matching both parts
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(pairs_spill) {
+	try {
+		using lcmc::stats::CollectedPairs;
+		
+		vector<double> x, y;
+		for(size_t i = 0; i < 100; i++) {
+			x.push_back(0.1 * static_cast<double>(i));
+			y.push_back(static_cast<double>(i % 7));
+		}
+		
+		CollectedPairs pairs("Test", "test_spill.dat");
+		const size_t emptyBytes = pairs.memoryBytes();
+		for(size_t i = 0; i < 3; i++) {
+			pairs.addStat(x, y);
+		}
+		BOOST_CHECK_GE(pairs.memoryBytes(), emptyBytes + 4*sizeof(double)*y.size());
+		
+		pairs.spill();
+		BOOST_CHECK_EQUAL(pairs.memoryBytes(), emptyBytes);
+		// Each function is written as a row of x and a row of y
+		BOOST_CHECK_EQUAL(countLines("test_spill.part1.dat"), 6);
+		
+		pairs.addStat(x, y);
+		boost::shared_ptr<FILE> table(tmpfile(), &fclose);
+		BOOST_REQUIRE(table.get() != NULL);
+		pairs.printStats(table.get());
+		BOOST_CHECK_EQUAL(countLines("test_spill.part2.dat"), 2);
+		
+		rewind(table.get());
+		char line[256] = "";
+		BOOST_REQUIRE(fgets(line, sizeof(line), table.get()) != NULL);
+		BOOST_CHECK_EQUAL(std::string(line), "\ttest_spill.part*.dat");
+		
+		std::remove("test_spill.part1.dat");
+		std::remove("test_spill.part2.dat");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
 		BOOST_FAIL(e.what());
 	}
 }
 
-/** Tests whether @ref lcmc::stats::interp::autoCorr() "interp::autoCorr()" 
- *	matches Ann Marie's original program
+/** Tests whether CollectedScalars can write its statistics in parts
  *
- * @see @ref lcmc::stats::interp::autoCorr() "interp::autoCorr()"
+ * @see @ref lcmc::stats::CollectedScalars "CollectedScalars"
  *
- * @test Consistent results with original IDL code
+ * @test spill() writes the statistics recorded so far to part 1 of 
+ *	the distribution file, and frees their memory
+ * @test sumSquares() is the same with and without spill()
+ * @test after spill(), printStats() writes the remaining statistics 
+ *	to part 2, and prints a pattern matching both parts
  *
  * @exceptsafe Does not throw exceptions.
  */
-BOOST_AUTO_TEST_CASE(acf_interp) {
-	for(size_t i = 0; i <= 13; i++) {
-		vector<double> times, mags;
-		vector<double> lags, acfs;
+BOOST_AUTO_TEST_CASE(scalars_spill) {
+	try {
+		using lcmc::stats::CollectedScalars;
+		
+		CollectedScalars whole  ("Test", "test_whole.dat", true);
+		CollectedScalars spilled("Test", "test_scalars.dat", true);
+		for(size_t i = 0; i < 50; i++) {
+			const double value = 0.1 * static_cast<double>(i);
+			whole  .addStat(value);
+			spilled.addStat(value);
+		}
+		
+		spilled.spill();
+		BOOST_CHECK_EQUAL(spilled.memoryBytes(), 0);
+		BOOST_CHECK_EQUAL(countLines("test_scalars.part1.dat"), 50);
+		
+		for(size_t i = 0; i < 20; i++) {
+			const double value = 0.3 * static_cast<double>(i);
+			whole  .addStat(value);
+			spilled.addStat(value);
+		}
+		BOOST_CHECK_EQUAL(spilled.sumSquares(), whole.sumSquares());
+		
+		boost::shared_ptr<FILE> table(tmpfile(), &fclose);
+		BOOST_REQUIRE(table.get() != NULL);
+		spilled.printStats(table.get());
+		BOOST_CHECK_EQUAL(countLines("test_scalars.part2.dat"), 20);
+		
+		rewind(table.get());
+		char line[256] = "";
+		BOOST_REQUIRE(fgets(line, sizeof(line), table.get()) != NULL);
+		const std::string row(line);
+		BOOST_CHECK(row.find("\ttest_scalars.part*.dat") != std::string::npos);
+		
+		std::remove("test_scalars.part1.dat");
+		std::remove("test_scalars.part2.dat");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
 
-		try {
-			{
-				char fileName[80];
-				int status = sprintf(fileName, "idl_target_in_%i.txt", i);
-				if (status < 0) {
-					cError("While testing interp::autoCorr(): ");
-				}
-				
-				kpfutils::readMcLightCurve(fileName, times, mags);
-			}
-	
-			{
-				char fileName[80];
-				int status = sprintf(fileName, "idl_target_acf_%i.txt", i);
-				if (status < 0) {
-					cError("While testing interp::autoCorr(): ");
-				}
-	
-				kpfutils::readMcLightCurve(fileName, lags, acfs);
-			}
-		} catch (const std::exception& e) {
-			BOOST_FAIL(e.what());
+/** Reads the first line of a file
+ *
+ * @param[in] file The file to read, which is rewound first.
+ *
+ * @return The first line of @p file, including the newline if any.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+std::string firstLine(FILE* const file) {
+	rewind(file);
+	char line[256] = "";
+	if (fgets(line, sizeof(line), file) == NULL) {
+		return "";
+	}
+	return line;
+}
+
+/** Tests whether CollectedScalars can continue from a saved state
+ *
+ * @see @ref lcmc::stats::CollectedScalars "CollectedScalars"
+ *
+ * @test A collection restored by readState() after spill() and 
+ *	writeState() prints the same summary as the original, after 
+ *	the same further statistics
+ * @test sumSquares() is the same for the restored collection
+ * @test readState() rejects a file that does not contain a saved state
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(scalars_state) {
+	try {
+		using lcmc::stats::CollectedScalars;
+		
+		CollectedScalars original("Test", "test_state.dat", true);
+		for(size_t i = 0; i < 30; i++) {
+			original.addStat(std::sqrt(static_cast<double>(i)));
 		}
+		original.addNull();
+		original.spill();
 		
-		size_t   nAcf = lags.size();
-		// Add a small offset to prevent roundoff errors from making 
-		//	a longer grid than AMC used
-		double deltaT = (lags.back() - lags.front())/(nAcf-1) + 1e-14;
+		boost::shared_ptr<FILE> state(tmpfile(), &fclose);
+		BOOST_REQUIRE(state.get() != NULL);
+		original.writeState(state.get());
+		rewind(state.get());
+		CollectedScalars restored("Test", "test_state.dat", true);
+		restored.readState(state.get());
 		
-		vector<double> myAcfs;
-		BOOST_REQUIRE_NO_THROW(lcmc::stats::interp::autoCorr(times, mags, 
-			deltaT, nAcf, myAcfs));
+		for(size_t i = 0; i < 10; i++) {
+			original.addStat(0.7 * static_cast<double>(i));
+			restored.addStat(0.7 * static_cast<double>(i));
+		}
+		BOOST_CHECK_EQUAL(restored.sumSquares(), original.sumSquares());
 		
-		BOOST_REQUIRE_EQUAL(nAcf, myAcfs.size());
+		boost::shared_ptr<FILE> originalRow(tmpfile(), &fclose);
+		boost::shared_ptr<FILE> restoredRow(tmpfile(), &fclose);
+		BOOST_REQUIRE(originalRow.get() != NULL && restoredRow.get() != NULL);
+		original.printStats(originalRow.get());
+		restored.printStats(restoredRow.get());
+		BOOST_CHECK_EQUAL(firstLine(restoredRow.get()), firstLine(originalRow.get()));
 		
-		// Allow for occasional deviations due to roundoff errors
-		unsigned int nBad = 0;
-		for(size_t j = 0; j < nAcf; j++) {
-			if (!isClose(acfs[j], myAcfs[j], 1e-5)) {
-				nBad++;
-			}
+		boost::shared_ptr<FILE> garbage(tmpfile(), &fclose);
+		BOOST_REQUIRE(garbage.get() != NULL);
+		fprintf(garbage.get(), "not a state\n");
+		rewind(garbage.get());
+		BOOST_CHECK_THROW(restored.readState(garbage.get()), 
+			kpfutils::except::FileIo);
+		
+		std::remove("test_state.part1.dat");
+		std::remove("test_state.part2.dat");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Reads a whole file
+ *
+ * @param[in] fileName The file to read.
+ *
+ * @return The contents of @p fileName, or an empty string if it could 
+ *	not be opened.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+std::string readAll(const std::string& fileName) {
+	std::string contents;
+	FILE* const file = fopen(fileName.c_str(), "r");
+	if (file != NULL) {
+		char buffer[256];
+		size_t n;
+		while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+			contents.append(buffer, n);
 		}
-		BOOST_WARN(nBad == 0 || nBad >= nAcf/1000);
-		BOOST_CHECK(nBad <= nAcf/1000);
-	}	// end loop over examples
+		fclose(file);
+	}
+	return contents;
+}
+
+/** Tests whether QuantileSketch estimates quantiles of its values
+ *
+ * @see @ref lcmc::stats::QuantileSketch "QuantileSketch"
+ *
+ * @test A sketch of fewer than 64 values gives exact quantiles.
+ * @test NaNs are not counted.
+ * @test Two sketches merged estimate the 5th, 50th, and 95th percentiles 
+ *	of all their values to within 2% in rank.
+ * @test A sketch restored by readState() gives the same quantiles.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(quantile_sketch) {
+	try {
+		using lcmc::stats::QuantileSketch;
+		
+		QuantileSketch small;
+		for(size_t i = 1; i <= 10; i++) {
+			small.add(static_cast<double>(i));
+		}
+		small.add(std::numeric_limits<double>::quiet_NaN());
+		BOOST_CHECK_EQUAL(small.count(), 10);
+		BOOST_CHECK_EQUAL(small.quantile(0.5), 5.0);
+		BOOST_CHECK_EQUAL(small.quantile(1.0), 10.0);
+		
+		// Values are a permutation of 0..N-1, so rank = value
+		const size_t N = 100000;
+		QuantileSketch odd, even;
+		for(size_t i = 0; i < N; i++) {
+			const double value = static_cast<double>((i * 7919) % N);
+			(i % 2 == 0 ? even : odd).add(value);
+		}
+		odd.merge(even);
+		BOOST_CHECK_EQUAL(odd.count(), N);
+		const double quantiles[] = {0.05, 0.5, 0.95};
+		for(size_t i = 0; i < 3; i++) {
+			BOOST_CHECK_SMALL(odd.quantile(quantiles[i]) / N - quantiles[i], 0.02);
+		}
+		
+		boost::shared_ptr<FILE> state(tmpfile(), &fclose);
+		BOOST_REQUIRE(state.get() != NULL);
+		odd.writeState(state.get());
+		rewind(state.get());
+		QuantileSketch restored;
+		restored.readState(state.get());
+		BOOST_CHECK_EQUAL(restored.count(), odd.count());
+		BOOST_CHECK_EQUAL(restored.quantile(0.5), odd.quantile(0.5));
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether CollectedScalars reports quantiles in every mode
+ *
+ * @see @ref lcmc::stats::CollectedScalars "CollectedScalars"
+ *
+ * @test A collection that does not store distributions gives the exact 
+ *	median of fewer than 64 statistics, ignoring NaNs.
+ * @test rollback() removes statistics from the quantiles.
+ * @test quantile() includes statistics written by spill().
+ * @test A collection restored by readState() gives the same quantiles.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(scalars_quantiles) {
+	try {
+		using lcmc::stats::CollectedScalars;
+		
+		CollectedScalars summary("Test", "test_quantiles.dat", false);
+		for(size_t i = 1; i <= 9; i++) {
+			summary.addStat(static_cast<double>(i));
+		}
+		summary.addNull();
+		BOOST_CHECK_EQUAL(summary.quantile(0.5), 5.0);
+		
+		const CollectedScalars::Checkpoint mark = summary.checkpoint();
+		summary.addStat(100.0);
+		summary.addStat(100.0);
+		summary.rollback(mark);
+		BOOST_CHECK_EQUAL(summary.quantile(1.0), 9.0);
+		
+		CollectedScalars spilled("Test", "test_quantiles.dat", true);
+		for(size_t i = 0; i < 1000; i++) {
+			spilled.addStat(static_cast<double>(i));
+		}
+		spilled.spill();
+		BOOST_CHECK_CLOSE(spilled.quantile(0.5), 500.0, 3.0);
+		
+		boost::shared_ptr<FILE> state(tmpfile(), &fclose);
+		BOOST_REQUIRE(state.get() != NULL);
+		spilled.writeState(state.get());
+		rewind(state.get());
+		CollectedScalars restored("Test", "test_quantiles.dat", true);
+		restored.readState(state.get());
+		BOOST_CHECK_EQUAL(restored.quantile(0.5), spilled.quantile(0.5));
+		BOOST_CHECK_EQUAL(restored.quantile(0.95), spilled.quantile(0.95));
+		
+		std::remove("test_quantiles.part1.dat");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether CollectedPairs can summarize curves instead of 
+ *	storing them
+ *
+ * @see @ref lcmc::stats::CollectedPairs "CollectedPairs"
+ *
+ * @test The memory held while summarizing many curves is much less than 
+ *	the memory needed to store them.
+ * @test rollback() removes the curve recorded after checkpoint().
+ * @test spill() writes no parts.
+ * @test printStats() writes six functions for each grid.
+ * @test A collection restored by readState() after spill() and 
+ *	writeState() writes the same summaries as the original, after 
+ *	the same further statistics.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(pairs_summary) {
+	try {
+		using lcmc::stats::CollectedPairs;
+		
+		vector<double> x, y;
+		for(size_t i = 0; i < 10; i++) {
+			x.push_back(0.1 * static_cast<double>(i));
+			y.push_back(0.0);
+		}
+		vector<double> shortX(x.begin(), x.begin() + 5);
+		vector<double> shortY(y.begin(), y.begin() + 5);
+		
+		CollectedPairs original("Test", "test_summary.dat", false);
+		const size_t nCurves = 5000;
+		for(size_t i = 0; i < nCurves; i++) {
+			for(size_t j = 0; j < y.size(); j++) {
+				y[j] = static_cast<double>((i + j) % 101);
+			}
+			original.addStat(x, y);
+		}
+		original.addStat(shortX, shortY);
+		BOOST_CHECK_LT(original.memoryBytes(), nCurves*x.size()*sizeof(double) / 2);
+		
+		const size_t mark = original.checkpoint();
+		original.addStat(x, x);
+		original.rollback(mark);
+		BOOST_CHECK_EQUAL(original.checkpoint(), mark);
+		
+		original.spill();
+		BOOST_CHECK_EQUAL(readAll("test_summary.part1.dat"), "");
+		
+		boost::shared_ptr<FILE> state(tmpfile(), &fclose);
+		BOOST_REQUIRE(state.get() != NULL);
+		original.writeState(state.get());
+		rewind(state.get());
+		CollectedPairs restored("Test", "test_restored.dat", false);
+		restored.readState(state.get());
+		
+		original.addStat(x, y);
+		restored.addStat(x, y);
+		
+		boost::shared_ptr<FILE> table(tmpfile(), &fclose);
+		BOOST_REQUIRE(table.get() != NULL);
+		original.printStats(table.get());
+		restored.printStats(table.get());
+		// Each function is written as a row of x and a row of y
+		BOOST_CHECK_EQUAL(countLines("test_summary.dat"), 2*6*2);
+		BOOST_CHECK_EQUAL(readAll("test_restored.dat"), readAll("test_summary.dat"));
+		
+		std::remove("test_summary.dat");
+		std::remove("test_restored.dat");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether CollectedPairs stores shared grids correctly
+ *
+ * @see @ref lcmc::stats::CollectedPairs "CollectedPairs"
+ *
+ * @test Statistics recorded on the same shared grid refer to one 
+ *	stored copy of the grid.
+ * @test A statistic recorded on a different grid between two uses of a 
+ *	shared grid gets its own grid, and the shared grid is stored again.
+ * @test After a rollback removes the last grid, the shared grid is 
+ *	stored again.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(pairs_shared_grid) {
+	try {
+		using lcmc::stats::CollectedPairs;
+		
+		vector<double> x, otherX, y;
+		for(size_t i = 0; i < 10; i++) {
+			x.push_back(0.1 * static_cast<double>(i));
+			otherX.push_back(0.2 * static_cast<double>(i));
+			y.push_back(static_cast<double>(i));
+		}
+		const boost::shared_ptr<const vector<double> > grid(new vector<double>(x));
+		
+		CollectedPairs pairs("Test", "test_shared.dat");
+		pairs.addStat(grid, y);
+		pairs.addStat(grid, y);
+		
+		const double *x0, *x1, *x2, *x3, *yBegin;
+		size_t n;
+		pairs.getStat(0, x0, yBegin, n);
+		pairs.getStat(1, x1, yBegin, n);
+		BOOST_CHECK_EQUAL(x0, x1);
+		BOOST_CHECK_EQUAL(n, x.size());
+		BOOST_CHECK_EQUAL_COLLECTIONS(x1, x1 + n, x.begin(), x.end());
+		
+		pairs.addStat(otherX, y);
+		pairs.addStat(grid, y);
+		BOOST_REQUIRE_EQUAL(pairs.size(), 4U);
+		pairs.getStat(2, x2, yBegin, n);
+		pairs.getStat(3, x3, yBegin, n);
+		BOOST_CHECK_EQUAL_COLLECTIONS(x2, x2 + n, otherX.begin(), otherX.end());
+		BOOST_CHECK_EQUAL_COLLECTIONS(x3, x3 + n, x.begin(), x.end());
+		
+		pairs.addStat(otherX, y);
+		const size_t mark = pairs.checkpoint();
+		pairs.addStat(grid, y);
+		pairs.rollback(mark);
+		pairs.addStat(grid, y);
+		BOOST_REQUIRE_EQUAL(pairs.size(), 6U);
+		pairs.getStat(5, x3, yBegin, n);
+		BOOST_CHECK_EQUAL_COLLECTIONS(x3, x3 + n, x.begin(), x.end());
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether CollectedPairs can store curves in single precision
+ *
+ * @see @ref lcmc::stats::CollectedPairs "CollectedPairs"
+ * @see @ref lcmc::stats::RaggedArray "RaggedArray"
+ *
+ * @test Rows appended to a single-precision RaggedArray are rounded 
+ *	to floats, and can only be read as floats.
+ * @test Curves stored in single precision use less memory than the 
+ *	same curves in double precision.
+ * @test getStat() throws logic_error for curves stored in single 
+ *	precision.
+ * @test Curves whose values are exact floats are written to the same 
+ *	text distribution file in either precision.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(pairs_single_precision) {
+	try {
+		using lcmc::stats::CollectedPairs;
+		using lcmc::stats::RaggedArray;
+		
+		RaggedArray wide;
+		wide.push_back(vector<double>(3, 0.1));
+		RaggedArray narrow(lcmc::stats::SINGLE_PRECISION);
+		narrow.append(wide);
+		BOOST_REQUIRE_EQUAL(narrow.rowSize(0), 3U);
+		BOOST_CHECK_EQUAL(*narrow.floatRowBegin(0), 0.1f);
+		BOOST_CHECK_THROW(narrow.rowBegin(0), std::logic_error);
+		BOOST_CHECK_THROW(wide.floatRowBegin(0), std::logic_error);
+		
+		vector<double> x, y;
+		for(size_t i = 0; i < 100; i++) {
+			x.push_back(0.1 * static_cast<double>(i));
+			y.push_back(0.25 * static_cast<double>(i % 7));
+		}
+		
+		CollectedPairs doubles("Test", "test_double.dat");
+		lcmc::stats::setCurvePrecision(lcmc::stats::SINGLE_PRECISION);
+		CollectedPairs singles("Test", "test_single.dat");
+		lcmc::stats::setCurvePrecision(lcmc::stats::DOUBLE_PRECISION);
+		for(size_t i = 0; i < 20; i++) {
+			doubles.addStat(x, y);
+			singles.addStat(x, y);
+		}
+		BOOST_CHECK_LT(singles.memoryBytes(), doubles.memoryBytes());
+		
+		const double* xBegin;
+		const double* yBegin;
+		size_t n;
+		BOOST_CHECK_NO_THROW(doubles.getStat(0, xBegin, yBegin, n));
+		BOOST_CHECK_THROW(singles.getStat(0, xBegin, yBegin, n), std::logic_error);
+		
+		boost::shared_ptr<FILE> table(tmpfile(), &fclose);
+		BOOST_REQUIRE(table.get() != NULL);
+		doubles.printStats(table.get());
+		singles.printStats(table.get());
+		BOOST_CHECK_EQUAL(readAll("test_single.dat"), readAll("test_double.dat"));
+		
+		std::remove("test_double.dat");
+		std::remove("test_single.dat");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether scratch vectors are reused between scopes
+ *
+ * @see @ref lcmc::stats::ScratchVector "ScratchVector"
+ *
+ * @test A new lease has the requested size and zero values.
+ * @test A lease taken after another is returned reuses its memory, and 
+ *	does not add a vector to the pool.
+ * @test Leases held at the same time get distinct vectors.
+ */
+BOOST_AUTO_TEST_CASE(scratch_reuse) {
+	using stats::ScratchVector;
+	
+	const double* firstData;
+	size_t firstCapacity;
+	{
+		ScratchVector lease(1000);
+		BOOST_REQUIRE_EQUAL(lease.get().size(), 1000U);
+		BOOST_CHECK_EQUAL(lease.get()[999], 0.0);
+		lease.get()[999] = 1.5;
+		firstData     = &lease.get()[0];
+		firstCapacity = lease.get().capacity();
+	}
+	const size_t owned = stats::scratchVectorCount();
+	
+	{
+		ScratchVector lease(500);
+		BOOST_CHECK_EQUAL(lease.get().size(), 500U);
+		BOOST_CHECK_EQUAL(lease.get().capacity(), firstCapacity);
+		BOOST_CHECK_EQUAL(&lease.get()[0], firstData);
+		BOOST_CHECK_EQUAL(stats::scratchVectorCount(), owned);
+		
+		ScratchVector other;
+		BOOST_CHECK(&other.get() != &lease.get());
+		BOOST_CHECK(other.get().empty());
+	}
+	
+	// Both vectors are idle again
+	{
+		ScratchVector a, b;
+		BOOST_CHECK_EQUAL(stats::scratchVectorCount(), std::max<size_t>(owned, 2));
+	}
+}
+
+/** Tests whether GSL objects are reused by size
+ *
+ * @see @ref lcmc::utils::GslLease "GslLease"
+ *
+ * @test A lease of the same size as a returned object gets that object.
+ * @test A lease of a different size gets an object of its own size.
+ * @test Leases held at the same time get distinct objects.
+ */
+BOOST_AUTO_TEST_CASE(gsl_pool) {
+	using utils::GslLease;
+	using utils::VectorTraits;
+	
+	const gsl_vector* first;
+	{
+		const GslLease<VectorTraits> lease(50);
+		BOOST_REQUIRE(lease.get() != NULL);
+		BOOST_CHECK_EQUAL(lease.get()->size, 50U);
+		first = lease.get();
+	}
+	{
+		const GslLease<VectorTraits> other(60);
+		BOOST_CHECK_EQUAL(other.get()->size, 60U);
+		BOOST_CHECK(other.get() != first);
+		
+		const GslLease<VectorTraits> same(50);
+		BOOST_CHECK_EQUAL(same.get(), first);
+		
+		const GslLease<VectorTraits> again(50);
+		BOOST_CHECK_EQUAL(again.get()->size, 50U);
+		BOOST_CHECK(again.get() != first);
+	}
+}
+
+/** Tests whether sets of statistics report their members correctly
+ *
+ * @see @ref lcmc::stats::StatSet "StatSet"
+ *
+ * @test An empty set contains nothing.
+ * @test A set built from a list contains exactly the listed statistics, 
+ *	regardless of order or duplicates.
+ */
+BOOST_AUTO_TEST_CASE(stat_set) {
+	using stats::StatSet;
+	using stats::StatType;
+	
+	const StatSet none;
+	BOOST_CHECK(none.empty());
+	BOOST_CHECK(!none.contains(stats::C1));
+	
+	const StatType someArr[] = {stats::RMSPAIRPLOT, stats::C1, stats::DMDT, stats::C1};
+	const vector<StatType> some(someArr, someArr + 4);
+	const StatSet set(some);
+	BOOST_CHECK(!set.empty());
+	BOOST_CHECK( set.contains(stats::C1));
+	BOOST_CHECK( set.contains(stats::DMDT));
+	BOOST_CHECK( set.contains(stats::RMSPAIRPLOT));
+	BOOST_CHECK(!set.contains(stats::DMDTCUT));
+	BOOST_CHECK(!set.contains(stats::PERIOD));
+	
+	const StatType reorderArr[] = {stats::DMDT, stats::RMSPAIRPLOT, stats::C1};
+	BOOST_CHECK(StatSet(vector<StatType>(reorderArr, reorderArr + 3)) == set);
+	BOOST_CHECK(StatSet(vector<StatType>(reorderArr, reorderArr + 2)) != set);
+	
+	StatSet grown;
+	grown.insert(stats::C1);
+	grown.insert(stats::DMDT);
+	grown.insert(stats::RMSPAIRPLOT);
+	BOOST_CHECK(grown == set);
+}
+
+/** Tests whether measured costs are saved and predicted correctly
+ *
+ * @see @ref lcmc::CostTable "CostTable"
+ *
+ * @test An empty table predicts nothing.
+ * @test A recorded bin predicts its own cost per light curve, and the 
+ *	cost of light curves with other lengths scales as the square of 
+ *	the length.
+ * @test A table survives being written and read back, and a file 
+ *	that is not a table is rejected.
+ */
+BOOST_AUTO_TEST_CASE(cost_table) {
+	try {
+		CostTable costs;
+		BOOST_CHECK_EQUAL(costs.estimate("drw_a1", "C1", 100), 0.0);
+		
+		costs.record("drw_a1", "C1", 100, 50, 10.0);
+		costs.record("simple gp_a1", "C1+dmdt", 100, 10, 20.0);
+		BOOST_CHECK_CLOSE(costs.estimate("drw_a1", "C1", 100), 0.2, 1e-10);
+		BOOST_CHECK_CLOSE(costs.estimate("drw_a1", "C1", 200), 0.8, 1e-10);
+		BOOST_CHECK_EQUAL(costs.estimate("drw_a1", "dmdt", 100), 0.0);
+		
+		costs.write("test_costs.txt");
+		CostTable restored;
+		BOOST_CHECK(restored.read("test_costs.txt"));
+		BOOST_CHECK_CLOSE(restored.estimate("drw_a1", "C1", 100), 0.2, 1e-4);
+		BOOST_CHECK_CLOSE(restored.estimate("simple gp_a1", "C1+dmdt", 100), 
+			2.0, 1e-4);
+		std::remove("test_costs.txt");
+		BOOST_CHECK(!restored.read("test_costs.txt"));
+		
+		{
+			FILE* const garbage = fopen("test_costs.txt", "w");
+			BOOST_REQUIRE(garbage != NULL);
+			fprintf(garbage, "not a table\n");
+			fclose(garbage);
+		}
+		BOOST_CHECK_THROW(restored.read("test_costs.txt"), 
+			kpfutils::except::FileIo);
+		BOOST_CHECK_CLOSE(restored.estimate("drw_a1", "C1", 100), 0.2, 1e-4);
+		std::remove("test_costs.txt");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether the settings chosen by --tune are listed, saved, and 
+ *	found correctly
+ *
+ * @see @ref lcmc::TuningTable "TuningTable"
+ * @see @ref lcmc::tuningCandidates() "tuningCandidates()"
+ * @see @ref lcmc::tuningKey() "tuningKey()"
+ *
+ * @test The candidates start with the settings used without --tune, 
+ *	and include each batch size with each power of two statistic 
+ *	threads up to the maximum, and the maximum itself, exactly once.
+ * @test Runs with the same cadence, statistics, and threads share a 
+ *	key, and runs that differ in any of them do not.
+ * @test An empty table finds nothing, and a recorded run finds its 
+ *	settings.
+ * @test A table survives being written and read back, and a file 
+ *	that is not a table is rejected.
+ */
+BOOST_AUTO_TEST_CASE(tuning_table) {
+	try {
+		const vector<Tuning> single = tuningCandidates(1);
+		BOOST_REQUIRE_EQUAL(single.size(), 3U);
+		BOOST_CHECK_EQUAL(single.front().batchFactor, Tuning().batchFactor);
+		BOOST_CHECK_EQUAL(single.front().statThreads, 1);
+		
+		const vector<Tuning> several = tuningCandidates(3);
+		BOOST_REQUIRE_EQUAL(several.size(), 9U);
+		BOOST_CHECK_EQUAL(several.front().batchFactor, Tuning().batchFactor);
+		BOOST_CHECK_EQUAL(several.front().statThreads, 3);
+		for(size_t i = 0; i < several.size(); i++) {
+			BOOST_CHECK(several[i].statThreads == 1 || several[i].statThreads == 2 
+				|| several[i].statThreads == 3);
+			for(size_t j = 0; j < i; j++) {
+				BOOST_CHECK(several[i].batchFactor != several[j].batchFactor 
+					|| several[i].statThreads != several[j].statThreads);
+			}
+		}
+		
+		const models::Cadence ptf(ptfTimes);
+		const models::Cadence shorter(vector<double>(ptfTimes.begin(), 
+			ptfTimes.end() - 1));
+		const std::string key = tuningKey(ptf, "C1", 4);
+		BOOST_CHECK_EQUAL(key, tuningKey(models::Cadence(ptfTimes), "C1", 4));
+		BOOST_CHECK(key != tuningKey(shorter, "C1", 4));
+		BOOST_CHECK(key != tuningKey(ptf, "C1+dmdt", 4));
+		BOOST_CHECK(key != tuningKey(ptf, "C1", 8));
+		BOOST_CHECK_EQUAL(key.find_first_of("\t\n"), std::string::npos);
+		
+		TuningTable table;
+		Tuning found(1, 1);
+		BOOST_CHECK(!table.find(key, found));
+		BOOST_CHECK_EQUAL(found.batchFactor, 1);
+		
+		table.record(key, Tuning(32, 2));
+		table.record(tuningKey(ptf, "C1", 8), Tuning(8, 1));
+		BOOST_REQUIRE(table.find(key, found));
+		BOOST_CHECK_EQUAL(found.batchFactor, 32);
+		BOOST_CHECK_EQUAL(found.statThreads, 2);
+		
+		table.write("test_tuning.txt");
+		TuningTable restored;
+		BOOST_CHECK(restored.read("test_tuning.txt"));
+		BOOST_REQUIRE(restored.find(tuningKey(ptf, "C1", 8), found));
+		BOOST_CHECK_EQUAL(found.batchFactor, 8);
+		BOOST_CHECK_EQUAL(found.statThreads, 1);
+		std::remove("test_tuning.txt");
+		BOOST_CHECK(!restored.read("test_tuning.txt"));
+		
+		{
+			FILE* const garbage = fopen("test_tuning.txt", "w");
+			BOOST_REQUIRE(garbage != NULL);
+			fprintf(garbage, "not a table\n");
+			fclose(garbage);
+		}
+		BOOST_CHECK_THROW(restored.read("test_tuning.txt"), 
+			kpfutils::except::FileIo);
+		BOOST_CHECK(restored.find(key, found));
+		std::remove("test_tuning.txt");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether simulated light curves are saved and replayed correctly
+ *
+ * @see @ref lcmc::TrialWriter "TrialWriter"
+ * @see @ref lcmc::TrialReader "TrialReader"
+ *
+ * @test Replayed trials have the fluxes, parameters, units, and times 
+ *	that were saved, and trials on the same cadence share its times.
+ * @test A replay may skip trials at the start or end of a bin.
+ * @test Replaying a bin that was not saved, or a trial past the end 
+ *	of a bin, throws FileIo.
+ */
+BOOST_AUTO_TEST_CASE(trial_archive) {
+	try {
+		models::RangeList limits;
+		limits.add("a", 0.1, 1.0, models::RangeList::UNIFORM);
+		limits.add("p", 1.0, 10.0, models::RangeList::LOGUNIFORM);
+		
+		vector<SimTrial> saved(4);
+		for(size_t i = 0; i < saved.size(); i++) {
+			saved[i].times  = (i < 3 ? models::Cadence(ptfTimes) 
+				: models::Cadence(vector<double>(ptfTimes.begin(), 
+					ptfTimes.begin() + 10)));
+			saved[i].fluxes = vector<double>(saved[i].times.size(), 
+				0.5 * static_cast<double>(i));
+			saved[i].params.add("a", 0.1 * static_cast<double>(i + 1));
+			saved[i].params.add("p", 2.0 + static_cast<double>(i));
+			saved[i].units  = (i == 1 ? utils::MAG_UNITS : utils::FLUX_UNITS);
+		}
+		
+		{
+			TrialWriter writer("test_trials.bin");
+			writer.startBin("first", limits);
+			for(size_t i = 0; i < saved.size(); i++) {
+				writer.write(static_cast<long>(i), saved[i]);
+			}
+			writer.startBin("second", limits);
+			writer.write(0, saved[3]);
+			writer.close();
+		}
+		
+		TrialReader reader("test_trials.bin");
+		reader.startBin("first", limits);
+		vector<SimTrial> replayed(3);
+		for(size_t i = 0; i < replayed.size(); i++) {
+			reader.read(static_cast<long>(i + 1), replayed[i]);
+			const SimTrial& original = saved[i + 1];
+			BOOST_CHECK(replayed[i].times == original.times);
+			BOOST_CHECK(replayed[i].fluxes == original.fluxes);
+			BOOST_CHECK_EQUAL(replayed[i].params.get("a"), original.params.get("a"));
+			BOOST_CHECK_EQUAL(replayed[i].params.get("p"), original.params.get("p"));
+			BOOST_CHECK_EQUAL(replayed[i].units, original.units);
+		}
+		BOOST_CHECK(replayed[0].times.sameAs(replayed[1].times));
+		BOOST_CHECK_THROW(reader.read(4, replayed[0]), kpfutils::except::FileIo);
+		
+		// The unread trial of the first bin is skipped
+		TrialReader partial("test_trials.bin");
+		partial.startBin("first", limits);
+		partial.read(0, replayed[0]);
+		partial.startBin("second", limits);
+		partial.read(0, replayed[0]);
+		BOOST_CHECK(replayed[0].times == saved[3].times);
+		
+		TrialReader wrong("test_trials.bin");
+		BOOST_CHECK_THROW(wrong.startBin("second", limits), 
+			kpfutils::except::FileIo);
+		std::remove("test_trials.bin");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether light curves are chosen and printed correctly
+ *
+ * @see @ref lcmc::DumpQueue "DumpQueue"
+ * @see @ref lcmc::TrialDumper "TrialDumper"
+ *
+ * @test With DUMP_FIRST, the first light curves are printed, and no others.
+ * @test With DUMP_RANDOM, the requested number of light curves is 
+ *	printed, and the choice does not depend on how the trials are 
+ *	divided into batches.
+ * @test With DUMP_OUTLIER, the light curves with the highest and lowest 
+ *	values of the statistic are printed.
+ * @test Choosing by a statistic that is not stored throws invalid_argument.
+ */
+BOOST_AUTO_TEST_CASE(trial_dumper) {
+	try {
+		models::RangeList limits;
+		limits.add("a", 0.1, 1.0, models::RangeList::UNIFORM);
+		
+		const vector<double> times(ptfTimes.begin(), ptfTimes.begin() + 40);
+		vector<SimTrial> batch(6);
+		lcmc::stats::LcBinStats bin("dump", limits, "0", 
+			vector<lcmc::stats::StatType>(1, lcmc::stats::C1), true);
+		for(size_t i = 0; i < batch.size(); i++) {
+			batch[i].times = models::Cadence(times);
+			for(size_t j = 0; j < times.size(); j++) {
+				batch[i].fluxes.push_back(1.0 + 0.1 * sin(times[j]) 
+					+ 0.03 * static_cast<double>(i) * cos(2.0 * times[j]));
+			}
+			batch[i].params.add("a", 0.5);
+			bin.analyzeLightCurve(batch[i].times, batch[i].fluxes, batch[i].params);
+		}
+		const vector<SimTrial> front(batch.begin(), batch.begin() + 3);
+		const vector<SimTrial> back (batch.begin() + 3, batch.end());
+		
+		DumpQueue queue(2);
+		
+		TrialDumper first(queue, "test_dump_first_", 2, DUMP_FIRST, "", 0);
+		first.offer(0, front, bin);
+		first.offer(3, back, bin);
+		first.finish();
+		
+		TrialDumper whole(queue, "test_dump_whole_", 2, DUMP_RANDOM, "", 42);
+		whole.offer(0, batch, bin);
+		TrialDumper parts(queue, "test_dump_parts_", 2, DUMP_RANDOM, "", 42);
+		parts.offer(0, front, bin);
+		parts.offer(3, back, bin);
+		whole.finish();
+		parts.finish();
+		
+		TrialDumper outliers(queue, "test_dump_c1_", 2, DUMP_OUTLIER, "c1", 0);
+		outliers.offer(0, batch, bin);
+		outliers.finish();
+		queue.flush();
+		
+		const lcmc::stats::CollectedScalars& c1 = bin.getScalars("c1");
+		BOOST_REQUIRE_EQUAL(c1.size(), batch.size());
+		const size_t lowest  = std::min_element(c1.data(), c1.data() + c1.size()) 
+			- c1.data();
+		const size_t highest = std::max_element(c1.data(), c1.data() + c1.size()) 
+			- c1.data();
+		
+		size_t nRandom = 0;
+		for(size_t i = 0; i < batch.size(); i++) {
+			const std::string index = boost::lexical_cast<std::string>(i) + ".dat";
+			BOOST_CHECK_EQUAL(!readAll("test_dump_first_" + index).empty(), i < 2);
+			const bool inWhole = !readAll("test_dump_whole_" + index).empty();
+			BOOST_CHECK_EQUAL(inWhole, !readAll("test_dump_parts_" + index).empty());
+			nRandom += (inWhole ? 1 : 0);
+			BOOST_CHECK_EQUAL(!readAll("test_dump_c1_" + index).empty(), 
+				i == lowest || i == highest);
+			
+			std::remove(("test_dump_first_" + index).c_str());
+			std::remove(("test_dump_whole_" + index).c_str());
+			std::remove(("test_dump_parts_" + index).c_str());
+			std::remove(("test_dump_c1_" + index).c_str());
+		}
+		BOOST_CHECK_EQUAL(nRandom, 2U);
+		
+		TrialDumper missing(queue, "test_dump_peri_", 2, DUMP_OUTLIER, "peri", 0);
+		BOOST_CHECK_THROW(missing.offer(0, batch, bin), std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether light curves sampled on several cadences at once are 
+ *	subsampled correctly
+ *
+ * @see @ref lcmc::models::mergeCadences() "mergeCadences()"
+ * @see @ref lcmc::subsampleTrials() "subsampleTrials()"
+ *
+ * @test The merged cadence holds each time of any cadence once, in 
+ *	ascending order.
+ * @test Each cadence's positions point to its own times.
+ * @test A subsampled trial has the cadence's times, the fluxes at 
+ *	those times, and the original parameters and units.
+ * @test A truncated cadence holds exactly the times within its 
+ *	baseline of the first time.
+ */
+BOOST_AUTO_TEST_CASE(cadence_subsample) {
+	try {
+		vector<models::Cadence> parts;
+		parts.push_back(models::Cadence(vector<double>(ptfTimes.begin(), 
+			ptfTimes.begin() + 20)));
+		parts.push_back(models::Cadence(vector<double>(ptfTimes.begin() + 10, 
+			ptfTimes.begin() + 30)));
+		
+		models::Cadence whole;
+		vector<vector<size_t> > positions;
+		models::mergeCadences(parts, whole, positions);
+		BOOST_CHECK(whole.timeView() == vector<double>(ptfTimes.begin(), 
+			ptfTimes.begin() + 30));
+		BOOST_REQUIRE_EQUAL(positions.size(), parts.size());
+		for(size_t i = 0; i < parts.size(); i++) {
+			BOOST_REQUIRE_EQUAL(positions[i].size(), parts[i].size());
+			for(size_t j = 0; j < positions[i].size(); j++) {
+				BOOST_CHECK_EQUAL(whole.timeView()[positions[i][j]], 
+					parts[i].timeView()[j]);
+			}
+		}
+		
+		vector<SimTrial> batch(2);
+		for(size_t i = 0; i < batch.size(); i++) {
+			batch[i].times = whole;
+			for(size_t j = 0; j < whole.size(); j++) {
+				batch[i].fluxes.push_back(static_cast<double>(100*i + j));
+			}
+			batch[i].params.add("a", 0.5 * static_cast<double>(i + 1));
+			batch[i].units = (i == 1 ? utils::MAG_UNITS : utils::FLUX_UNITS);
+		}
+		vector<SimTrial> part;
+		subsampleTrials(batch, parts[1], positions[1], part);
+		BOOST_REQUIRE_EQUAL(part.size(), batch.size());
+		for(size_t i = 0; i < part.size(); i++) {
+			BOOST_CHECK(part[i].times.sameAs(parts[1]));
+			BOOST_REQUIRE_EQUAL(part[i].fluxes.size(), parts[1].size());
+			BOOST_CHECK_EQUAL(part[i].fluxes.front(), batch[i].fluxes[10]);
+			BOOST_CHECK_EQUAL(part[i].fluxes.back(), batch[i].fluxes[29]);
+			BOOST_CHECK_EQUAL(part[i].params.get("a"), batch[i].params.get("a"));
+			BOOST_CHECK_EQUAL(part[i].units, batch[i].units);
+		}
+		
+		const double cut = 0.5 * (ptfTimes[9] + ptfTimes[10]) - ptfTimes[0];
+		models::Cadence prefix;
+		models::truncateCadence(whole, cut, prefix);
+		BOOST_CHECK(prefix.timeView() == vector<double>(ptfTimes.begin(), 
+			ptfTimes.begin() + 10));
+		models::truncateCadence(whole, ptfTimes[10] - ptfTimes[0], prefix);
+		BOOST_CHECK_EQUAL(prefix.size(), 11U);
+		models::truncateCadence(models::Cadence(), 100.0, prefix);
+		BOOST_CHECK(prefix.empty());
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether times known to be sorted are handled like other times
+ *
+ * @see @ref lcmc::models::Cadence "Cadence"
+ * @see @ref lcmc::stats::rmsVsTRooted() "rmsVsTRooted()"
+ * @see @ref lcmc::stats::rmsVsTBinned() "rmsVsTBinned()"
+ *
+ * @test A cadence built from sorted times without checking their 
+ *	order equals one built with the check, including its hash, 
+ *	baseline, and minimum step.
+ * @test The RMS functions give the same results for a cadence as for 
+ *	its times.
+ * @test The RMS functions still reject unsorted times.
+ */
+BOOST_AUTO_TEST_CASE(sorted_cadence) {
+	try {
+		const models::Cadence checked(ptfTimes);
+		const models::Cadence trusted(ptfTimes, models::SortedTimes());
+		BOOST_CHECK(checked == trusted);
+		BOOST_CHECK_EQUAL(checked.getHash(), trusted.getHash());
+		BOOST_CHECK_EQUAL(checked.getBaseline(), trusted.getBaseline());
+		BOOST_CHECK_EQUAL(checked.getMinStep(), trusted.getMinStep());
+		
+		vector<double> fluxes;
+		for(size_t i = 0; i < ptfTimes.size(); i++) {
+			fluxes.push_back(sin(0.1 * static_cast<double>(i)));
+		}
+		
+		vector<double> steps1, rms1, steps2, rms2;
+		stats::rmsVsTRooted(ptfTimes, fluxes, steps1, rms1);
+		stats::rmsVsTRooted(trusted, fluxes, steps2, rms2);
+		BOOST_CHECK(steps1 == steps2);
+		BOOST_CHECK(rms1 == rms2);
+		
+		vector<double> edges, medians1, medians2;
+		for(double edge = 0.01; edge < trusted.getBaseline(); edge *= 2.0) {
+			edges.push_back(edge);
+		}
+		stats::rmsVsTBinned(ptfTimes, fluxes, edges, medians1);
+		stats::rmsVsTBinned(trusted, fluxes, edges, medians2);
+		BOOST_REQUIRE_EQUAL(medians1.size(), medians2.size());
+		for(size_t i = 0; i < medians1.size(); i++) {
+			if (testNan(medians1[i])) {
+				BOOST_CHECK(testNan(medians2[i]));
+			} else {
+				BOOST_CHECK_EQUAL(medians1[i], medians2[i]);
+			}
+		}
+		
+		vector<double> unsorted(ptfTimes.rbegin(), ptfTimes.rend());
+		BOOST_CHECK_THROW(stats::rmsVsTRooted(unsorted, fluxes, steps1, rms1), 
+			kpfutils::except::NotSorted);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether finished bins are saved and reprinted correctly
+ *
+ * @see @ref lcmc::ResultKey "ResultKey"
+ * @see @ref lcmc::ResultCache "ResultCache"
+ *
+ * @test Keys built from the same values are equal, and keys built 
+ *	from different values, or the same values in a different order, 
+ *	are not.
+ * @test A bin that was not saved is not found.
+ * @test A saved bin reprints its row and restores its distribution 
+ *	files, but not the files of other bins.
+ */
+BOOST_AUTO_TEST_CASE(result_cache) {
+	try {
+		models::RangeList limits;
+		limits.add("a", 0.1, 1.0, models::RangeList::UNIFORM);
+		models::RangeList otherLimits;
+		otherLimits.add("a", 0.1, 2.0, models::RangeList::UNIFORM);
+		
+		ResultKey key;
+		key.add(std::string("drw"));
+		key.add(limits);
+		key.add(42L);
+		ResultKey sameKey;
+		sameKey.add(std::string("drw"));
+		sameKey.add(limits);
+		sameKey.add(42L);
+		BOOST_CHECK_EQUAL(key.value(), sameKey.value());
+		
+		ResultKey otherKey;
+		otherKey.add(std::string("drw"));
+		otherKey.add(otherLimits);
+		otherKey.add(42L);
+		BOOST_CHECK(key.value() != otherKey.value());
+		ResultKey swappedKey;
+		swappedKey.add(42L);
+		swappedKey.add(std::string("drw"));
+		swappedKey.add(limits);
+		BOOST_CHECK(key.value() != swappedKey.value());
+		ResultKey splitKey;
+		splitKey.add(std::string("dr"));
+		splitKey.add(std::string("w"));
+		splitKey.add(limits);
+		splitKey.add(42L);
+		BOOST_CHECK(key.value() != splitKey.value());
+		
+		const std::string label = "drw_a0.10_n0.05";
+		const std::string distribFile = "run_c1_" + label + ".dat";
+		const std::string otherFile   = "run_c1_" + label + "0.dat";
+		const char* const contents = "0.123\n0.456\n";
+		{
+			shared_ptr<FILE> file = fileCheckOpen(distribFile, "w");
+			fputs(contents, file.get());
+			shared_ptr<FILE> other = fileCheckOpen(otherFile, "w");
+			fputs(contents, other.get());
+		}
+		
+		const ResultCache cache("test_result_cache");
+		{
+			shared_ptr<FILE> out(tmpfile(), &fclose);
+			BOOST_CHECK(!cache.replay(key, out.get()));
+		}
+		cache.save(key, label, "drw\t0.1\t1.0\tC1", 0);
+		std::remove(distribFile.c_str());
+		std::remove(otherFile.c_str());
+		
+		shared_ptr<FILE> out(tmpfile(), &fclose);
+		BOOST_REQUIRE(cache.replay(key, out.get()));
+		rewind(out.get());
+		char row[256];
+		BOOST_REQUIRE(fgets(row, sizeof(row), out.get()) != NULL);
+		BOOST_CHECK_EQUAL(std::string(row), "drw\t0.1\t1.0\tC1\n");
+		{
+			shared_ptr<FILE> restored = fileCheckOpen(distribFile, "r");
+			char line[256];
+			BOOST_REQUIRE(fgets(line, sizeof(line), restored.get()) != NULL);
+			BOOST_CHECK_EQUAL(std::string(line), "0.123\n");
+		}
+		FILE* const stale = fopen(otherFile.c_str(), "r");
+		BOOST_CHECK(stale == NULL);
+		if (stale != NULL) {
+			fclose(stale);
+		}
+		BOOST_CHECK(!cache.replay(otherKey, out.get()));
+		
+		char entry[64];
+		sprintf(entry, "test_result_cache/bin_%08lx%08lx", 
+			static_cast<unsigned long>((key.value() >> 32) & 0xffffffffUL),
+			static_cast<unsigned long>( key.value()        & 0xffffffffUL));
+		std::remove((std::string(entry) + "/" + distribFile).c_str());
+		std::remove((std::string(entry) + "/row.txt").c_str());
+		std::remove((std::string(entry) + "/files.txt").c_str());
+		rmdir(entry);
+		rmdir("test_result_cache");
+		std::remove(distribFile.c_str());
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** The command lines received by recordJob() */
+vector<vector<std::string> > recordedJobs;
+
+/** Stands in for the simulation when testing serveJobs()
+ *
+ * @param[in] argc, argv The command line of the job.
+ *
+ * @return 0 if the job has any arguments, 2 otherwise.
+ *
+ * @post The command line is appended to @ref recordedJobs.
+ */
+int recordJob(int argc, char* argv[]) {
+	recordedJobs.push_back(vector<std::string>(argv, argv + argc));
+	return (argc > 1 ? 0 : 2);
+}
+
+/** Tests whether job specifications are read correctly by --serve
+ *
+ * @see @ref lcmc::splitJobLine() "splitJobLine()"
+ * @see @ref lcmc::serveJobs() "serveJobs()"
+ *
+ * @test Arguments are split at whitespace, except inside quotes or 
+ *	after a backslash, and the quotes and backslashes are removed.
+ * @test An unmatched quote or a trailing backslash throws 
+ *	std::invalid_argument.
+ * @test Each job line is run with the program name as its first 
+ *	argument, and its end is marked with its exit status. Blank and 
+ *	comment lines are not run, and a malformed line is reported as a 
+ *	failed job.
+ * @test serveJobs() stops at @c quit without reading further lines.
+ */
+BOOST_AUTO_TEST_CASE(job_server) {
+	try {
+		vector<std::string> words;
+		splitJobLine("  -n 100 --seed 42\t'two words' \"a \\\"b\" c\\ d '' ", words);
+		BOOST_REQUIRE_EQUAL(words.size(), 8U);
+		BOOST_CHECK_EQUAL(words[0], "-n");
+		BOOST_CHECK_EQUAL(words[1], "100");
+		BOOST_CHECK_EQUAL(words[2], "--seed");
+		BOOST_CHECK_EQUAL(words[3], "42");
+		BOOST_CHECK_EQUAL(words[4], "two words");
+		BOOST_CHECK_EQUAL(words[5], "a \"b");
+		BOOST_CHECK_EQUAL(words[6], "c d");
+		BOOST_CHECK_EQUAL(words[7], "");
+		
+		BOOST_CHECK_THROW(splitJobLine("-n 'unmatched", words), 
+			std::invalid_argument);
+		BOOST_CHECK_THROW(splitJobLine("-n 100\\", words), 
+			std::invalid_argument);
+		
+		shared_ptr<FILE> in(tmpfile(), &fclose);
+		fputs("ptfjds.txt drw -a 0.5\n\n# comment\n'\nconst\nquit\nnever run\n", 
+			in.get());
+		rewind(in.get());
+		shared_ptr<FILE> out(tmpfile(), &fclose);
+		recordedJobs.clear();
+		BOOST_CHECK(serveJobs(in.get(), out.get(), "lightcurveMC", &recordJob));
+		
+		BOOST_REQUIRE_EQUAL(recordedJobs.size(), 2U);
+		BOOST_REQUIRE_EQUAL(recordedJobs[0].size(), 5U);
+		BOOST_CHECK_EQUAL(recordedJobs[0][0], "lightcurveMC");
+		BOOST_CHECK_EQUAL(recordedJobs[0][1], "ptfjds.txt");
+		BOOST_CHECK_EQUAL(recordedJobs[0][4], "0.5");
+		BOOST_REQUIRE_EQUAL(recordedJobs[1].size(), 2U);
+		BOOST_CHECK_EQUAL(recordedJobs[1][1], "const");
+		
+		rewind(out.get());
+		char line[256];
+		const char* const expected[] = {"# done 0\n", "# done 1\n", "# done 0\n"};
+		for(size_t i = 0; i < 3; i++) {
+			BOOST_REQUIRE(fgets(line, sizeof(line), out.get()) != NULL);
+			BOOST_CHECK_EQUAL(std::string(line), expected[i]);
+		}
+		BOOST_CHECK(fgets(line, sizeof(line), out.get()) == NULL);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether the trials of a run are divided correctly among shards
+ *
+ * @see @ref lcmc::shardTrials() "shardTrials()"
+ *
+ * @test For runs with fewer, as many, or more trials than shards, the 
+ *	blocks of all shards cover every trial once, in order, and differ 
+ *	in length by at most one trial.
+ */
+BOOST_AUTO_TEST_CASE(shard_trials) {
+	const long nTrials[] = {0, 3, 7, 100, 1001};
+	const long nShards[] = {1, 3, 7, 16};
+	
+	for(size_t i = 0; i < sizeof(nTrials)/sizeof(long); i++) {
+		for(size_t j = 0; j < sizeof(nShards)/sizeof(long); j++) {
+			long expected = 0, shortest = nTrials[i], longest = 0;
+			for(long k = 0; k < nShards[j]; k++) {
+				long first, last;
+				lcmc::shardTrials(nTrials[i], k, nShards[j], first, last);
+				BOOST_CHECK_EQUAL(first, expected);
+				BOOST_CHECK(last >= first);
+				shortest = std::min(shortest, last - first);
+				longest  = std::max(longest , last - first);
+				expected = last;
+			}
+			BOOST_CHECK_EQUAL(expected, nTrials[i]);
+			BOOST_CHECK(longest - shortest <= 1);
+		}
+	}
+}
+
+/** Records which chunk processed each item of a job
+ */
+class ChunkRecorder {
+public:
+	ChunkRecorder(vector<long>& chunks, vector<long>& visits) 
+			: chunks(chunks), visits(visits) {
+	}
+	
+	void operator()(size_t chunk, size_t first, size_t last) const {
+		for(size_t i = first; i < last; i++) {
+			chunks[i] = static_cast<long>(chunk);
+			visits[i]++;
+		}
+	}
+	
+private:
+	vector<long>& chunks;
+	vector<long>& visits;
+};
+
+/** Tests whether a job divided into chunks is processed exactly once
+ *
+ * @see @ref lcmc::runChunks() "runChunks()"
+ *
+ * @test For one or several threads, and chunk sizes that do or do not 
+ *	divide the job, every item is processed once, by the chunk 
+ *	containing it.
+ */
+BOOST_AUTO_TEST_CASE(run_chunks) {
+	const size_t nItems = 1000;
+	const size_t chunkSizes[] = {1, 7, 100, 2000};
+	const size_t nWorkers[] = {1, 3, 8};
+	
+	for(size_t i = 0; i < sizeof(chunkSizes)/sizeof(size_t); i++) {
+		for(size_t j = 0; j < sizeof(nWorkers)/sizeof(size_t); j++) {
+			vector<long> chunks(nItems, -1), visits(nItems, 0);
+			lcmc::runChunks(nItems, chunkSizes[i], nWorkers[j], 
+				ChunkRecorder(chunks, visits));
+			
+			long misplaced = 0, repeated = 0;
+			for(size_t k = 0; k < nItems; k++) {
+				if (chunks[k] != static_cast<long>(k / chunkSizes[i])) {
+					misplaced++;
+				}
+				if (visits[k] != 1) {
+					repeated++;
+				}
+			}
+			BOOST_CHECK_EQUAL(misplaced, 0);
+			BOOST_CHECK_EQUAL(repeated, 0);
+		}
+	}
+}
+
+/** Tests whether bins analyzed together get the same statistics as 
+ *	bins analyzed alone
+ *
+ * @see @ref lcmc::analyzeBins() "analyzeBins()"
+ *
+ * @test With one or several threads, each of three bins of 1, 5, and 
+ *	3 light curves gets the statistics, in order, that analyzeTrials() 
+ *	gives on one thread.
+ * @test No threads throws invalid_argument.
+ */
+BOOST_AUTO_TEST_CASE(analyze_bins) {
+	try {
+		models::RangeList limits;
+		limits.add("a", 0.1, 1.0, models::RangeList::UNIFORM);
+		const vector<lcmc::stats::StatType> stats(1, lcmc::stats::C1);
+		const lcmc::stats::LcBinStats emptyBin("packed", limits, "0", stats, true);
+		
+		const vector<double> times(ptfTimes.begin(), ptfTimes.begin() + 40);
+		const size_t sizes[] = {1, 5, 3};
+		const size_t nBins = sizeof(sizes)/sizeof(size_t);
+		vector<vector<SimTrial> > trials(nBins);
+		vector<lcmc::stats::LcBinStats> expected(nBins, emptyBin);
+		for(size_t i = 0; i < nBins; i++) {
+			trials[i].resize(sizes[i]);
+			for(size_t j = 0; j < sizes[i]; j++) {
+				trials[i][j].times = models::Cadence(times);
+				for(size_t k = 0; k < times.size(); k++) {
+					trials[i][j].fluxes.push_back(1.0 + 0.1 * sin(times[k]) 
+						+ 0.02 * static_cast<double>(3*i + j) * cos(2.0 * times[k]));
+				}
+				trials[i][j].params.add("a", 0.5);
+			}
+			lcmc::analyzeTrials(trials[i], 1, emptyBin, expected[i]);
+		}
+		
+		const long nThreads[] = {1, 2, 8};
+		for(size_t n = 0; n < sizeof(nThreads)/sizeof(long); n++) {
+			vector<lcmc::stats::LcBinStats> packed(nBins, emptyBin);
+			vector<lcmc::BinJob> jobs;
+			for(size_t i = 0; i < nBins; i++) {
+				jobs.push_back(lcmc::BinJob(trials[i], emptyBin, packed[i]));
+			}
+			lcmc::analyzeBins(jobs, nThreads[n]);
+			
+			for(size_t i = 0; i < nBins; i++) {
+				const lcmc::stats::CollectedScalars& c1 = packed[i].getScalars("c1");
+				const lcmc::stats::CollectedScalars& alone = expected[i].getScalars("c1");
+				BOOST_REQUIRE_EQUAL(c1.size(), sizes[i]);
+				BOOST_CHECK(std::equal(c1.data(), c1.data() + c1.size(), alone.data()));
+			}
+		}
+		
+		vector<lcmc::stats::LcBinStats> unused(1, emptyBin);
+		BOOST_CHECK_THROW(lcmc::analyzeBins(vector<lcmc::BinJob>(1, 
+			lcmc::BinJob(trials[0], emptyBin, unused[0])), 0), 
+			std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether NUMA placement stays within the available nodes
+ *
+ * @see @ref lcmc::utils::currentNumaNode() "currentNumaNode()"
+ *
+ * @test Without pinning, every thread uses the copies of node 0.
+ * @test With pinning, any thread uses the copies of an existing node, 
+ *	and pinned workers still process every item.
+ */
+BOOST_AUTO_TEST_CASE(numa_nodes) {
+	BOOST_REQUIRE(utils::numaNodeCount() >= 1);
+	
+	utils::setNumaPinning(false);
+	BOOST_CHECK(!utils::numaPinning());
+	BOOST_CHECK_EQUAL(utils::currentNumaNode(), 0U);
+	
+	utils::setNumaPinning(true);
+	BOOST_CHECK_EQUAL(utils::numaPinning(), utils::numaNodeCount() > 1);
+	BOOST_CHECK(utils::currentNumaNode() < utils::numaNodeCount());
+	
+	vector<long> chunks(100, -1), visits(100, 0);
+	runChunks(100, 7, 4, ChunkRecorder(chunks, visits));
+	BOOST_CHECK_EQUAL(std::count(visits.begin(), visits.end(), 1L), 100);
+	
+	utils::setNumaPinning(false);
+}
+
+/** Tests whether large buffers are aligned and usable as ordinary 
+ *	GSL matrices and vectors
+ *
+ * @see @ref lcmc::utils::largeAlloc() "largeAlloc()"
+ * @see @ref lcmc::utils::largeMatrixAlloc() "largeMatrixAlloc()"
+ *
+ * @test A 600&times;600 matrix from largeMatrixCalloc() is all zeros, 
+ *	starts on a 2 MB boundary, and can be copied to and freed with 
+ *	gsl_matrix_free().
+ * @test With setHugePages(false), the same matrix starts on a 64-byte 
+ *	boundary.
+ * @test A vector using LargeAllocator holds its elements on a 64-byte 
+ *	boundary, and can be copied and swapped.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(large_alloc) {
+	const size_t HUGE_PAGE = 2*1024*1024;
+	BOOST_CHECK(utils::hugePages());
+	
+	try {
+		shared_ptr<gsl_matrix> big(checkAlloc(
+			utils::largeMatrixCalloc(600, 600)), &gsl_matrix_free);
+		BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(big->data) % HUGE_PAGE, 0U);
+		BOOST_CHECK_EQUAL(gsl_matrix_max(big.get()), 0.0);
+		BOOST_CHECK_EQUAL(gsl_matrix_min(big.get()), 0.0);
+		
+		gsl_matrix_set(big.get(), 599, 599, 3.0);
+		shared_ptr<gsl_matrix> copy(checkAlloc(
+			gsl_matrix_alloc(600, 600)), &gsl_matrix_free);
+		gsl_matrix_memcpy(copy.get(), big.get());
+		BOOST_CHECK_EQUAL(gsl_matrix_get(copy.get(), 599, 599), 3.0);
+		
+		utils::setHugePages(false);
+		shared_ptr<gsl_matrix> small(checkAlloc(
+			utils::largeMatrixAlloc(600, 600)), &gsl_matrix_free);
+		BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(small->data) % 64, 0U);
+		utils::setHugePages(true);
+		
+		utils::LargeVector<double>::type table(1000, 1.0);
+		BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(&table[0]) % 64, 0U);
+		utils::LargeVector<double>::type other(table);
+		other.push_back(2.0);
+		table.swap(other);
+		BOOST_CHECK_EQUAL(table.size(), 1001U);
+		BOOST_CHECK_EQUAL(table.back(), 2.0);
+		BOOST_CHECK_EQUAL(other.size(), 1000U);
+	} catch (const std::bad_alloc& e) {
+		utils::setHugePages(true);
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether PeriodogramPlan reproduces the periodograms calculated 
+ *	from scratch
+ *
+ * @see @ref lcmc::stats::PeriodogramPlan "PeriodogramPlan"
+ *
+ * @test for PTF cadence, a sine wave with white noise gives the same 
+ *	periodogram as kpftimes::lombScargle() on the plan's frequency grid, 
+ *	with times measured from the plan's epoch
+ * @test the plan's epoch lies within the cadence
+ * @test a second call for the same cadence returns the same plan
+ * @test data of the wrong length throws invalid_argument
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(periodogram_plan) {
+	try {
+		using lcmc::stats::PeriodogramPlan;
+		
+		vector<double> data;
+		for(size_t i = 0; i < ptfTimes.size(); i++) {
+			data.push_back(sin(2.0*M_PI * ptfTimes[i] / 3.7) 
+				+ 0.1*cos(static_cast<double>(7*i)));
+		}
+		
+		boost::shared_ptr<const PeriodogramPlan> plan = 
+			PeriodogramPlan::forCadence(ptfTimes);
+		BOOST_CHECK(PeriodogramPlan::forCadence(ptfTimes) == plan);
+		BOOST_CHECK(plan->getEpoch() >= ptfTimes.front());
+		BOOST_CHECK(plan->getEpoch() <= ptfTimes.back());
+		
+		// Phases of raw Julian dates lose too much precision for a 
+		//	tight comparison at high frequencies
+		vector<double> offsets;
+		for(size_t i = 0; i < ptfTimes.size(); i++) {
+			offsets.push_back(ptfTimes[i] - plan->getEpoch());
+		}
+		
+		vector<double> planPower, refPower;
+		plan->lombScargle(data, planPower);
+		kpftimes::lombScargle(offsets, data, plan->getFreq(), refPower);
+		
+		BOOST_REQUIRE_EQUAL(planPower.size(), refPower.size());
+		for(size_t i = 0; i < planPower.size(); i++) {
+			// Relative tolerance fails for frequencies with negligible power
+			BOOST_CHECK_SMALL(planPower[i] - refPower[i], 1e-8 * (1.0 + refPower[i]));
+		}
+		
+		data.pop_back();
+		BOOST_CHECK_THROW(plan->lombScargle(data, planPower), 
+			std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether the Press & Rybicki periodogram approximates the 
+ *	direct periodogram
+ *
+ * @see @ref lcmc::stats::PeriodogramPlan "PeriodogramPlan"
+ *
+ * @test for PTF cadence, a sine wave with white noise gives the same 
+ *	periodogram with LS_FAST as with LS_DIRECT, to within 1e-5 of 
+ *	the peak power
+ * @test both methods find the peak at the same frequency
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(fast_periodogram) {
+	try {
+		using lcmc::stats::PeriodogramPlan;
+		
+		vector<double> data;
+		for(size_t i = 0; i < ptfTimes.size(); i++) {
+			data.push_back(sin(2.0*M_PI * ptfTimes[i] / 3.7) 
+				+ 0.1*cos(static_cast<double>(7*i)));
+		}
+		
+		const PeriodogramPlan direct(ptfTimes, lcmc::stats::LS_DIRECT);
+		const PeriodogramPlan fast  (ptfTimes, lcmc::stats::LS_FAST);
+		BOOST_REQUIRE(direct.getFreq() == fast.getFreq());
+		
+		vector<double> directPower, fastPower;
+		direct.lombScargle(data, directPower);
+		fast  .lombScargle(data, fastPower);
+		BOOST_REQUIRE_EQUAL(directPower.size(), fastPower.size());
+		
+		const double peak = *std::max_element(directPower.begin(), directPower.end());
+		for(size_t i = 0; i < directPower.size(); i++) {
+			BOOST_CHECK_SMALL(fastPower[i] - directPower[i], 1e-5 * peak);
+		}
+		BOOST_CHECK(std::max_element(directPower.begin(), directPower.end()) 
+				- directPower.begin() 
+			== std::max_element(fastPower.begin(), fastPower.end()) 
+				- fastPower.begin());
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether single-precision periodogram tables approximate the 
+ *	double-precision periodogram
+ *
+ * @see @ref lcmc::stats::PeriodogramPlan "PeriodogramPlan"
+ * @see @ref lcmc::stats::setPeriodogramPrecision() "setPeriodogramPrecision()"
+ *
+ * @test for PTF cadence, a sine wave with white noise gives the same 
+ *	periodogram with SINGLE_PRECISION as with DOUBLE_PRECISION, to 
+ *	within 1e-4 of the peak power
+ * @test both precisions find the peak at the same frequency
+ * @test lombScargleBatch() matches lombScargle() for SINGLE_PRECISION
+ * @test getPrecision() reports the precision the plan was built with
+ * @test after setPeriodogramPrecision(SINGLE_PRECISION), 
+ *	PeriodogramPlan::forCadence() returns a single-precision plan
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(single_periodogram) {
+	try {
+		using lcmc::stats::PeriodogramPlan;
+		using lcmc::stats::DOUBLE_PRECISION;
+		using lcmc::stats::SINGLE_PRECISION;
+		
+		vector<double> data;
+		for(size_t i = 0; i < ptfTimes.size(); i++) {
+			data.push_back(sin(2.0*M_PI * ptfTimes[i] / 3.7) 
+				+ 0.1*cos(static_cast<double>(7*i)));
+		}
+		
+		const PeriodogramPlan full  (ptfTimes, lcmc::stats::LS_DIRECT, DOUBLE_PRECISION);
+		const PeriodogramPlan single(ptfTimes, lcmc::stats::LS_DIRECT, SINGLE_PRECISION);
+		BOOST_CHECK_EQUAL(full  .getPrecision(), DOUBLE_PRECISION);
+		BOOST_CHECK_EQUAL(single.getPrecision(), SINGLE_PRECISION);
+		BOOST_REQUIRE(full.getFreq() == single.getFreq());
+		
+		vector<double> fullPower, singlePower;
+		full  .lombScargle(data, fullPower);
+		single.lombScargle(data, singlePower);
+		BOOST_REQUIRE_EQUAL(fullPower.size(), singlePower.size());
+		
+		const double peak = *std::max_element(fullPower.begin(), fullPower.end());
+		for(size_t i = 0; i < fullPower.size(); i++) {
+			BOOST_CHECK_SMALL(singlePower[i] - fullPower[i], 1e-4 * peak);
+		}
+		BOOST_CHECK(std::max_element(fullPower.begin(), fullPower.end()) 
+				- fullPower.begin() 
+			== std::max_element(singlePower.begin(), singlePower.end()) 
+				- singlePower.begin());
+		
+		vector<const vector<double>*> batch(3, &data);
+		vector<vector<double> > batchPower;
+		single.lombScargleBatch(batch, batchPower);
+		BOOST_REQUIRE_EQUAL(batchPower.size(), batch.size());
+		for(size_t k = 0; k < batchPower.size(); k++) {
+			BOOST_REQUIRE_EQUAL(batchPower[k].size(), singlePower.size());
+			for(size_t i = 0; i < singlePower.size(); i++) {
+				BOOST_CHECK_SMALL(batchPower[k][i] - singlePower[i], 1e-5 * peak);
+			}
+		}
+		
+		lcmc::stats::setPeriodogramPrecision(SINGLE_PRECISION);
+		BOOST_CHECK_EQUAL(lcmc::stats::getPeriodogramPrecision(), SINGLE_PRECISION);
+		BOOST_CHECK_EQUAL(PeriodogramPlan::forCadence(ptfTimes)->getPrecision(), 
+			SINGLE_PRECISION);
+		lcmc::stats::setPeriodogramPrecision(DOUBLE_PRECISION);
+		BOOST_CHECK_EQUAL(PeriodogramPlan::forCadence(ptfTimes)->getPrecision(), 
+			DOUBLE_PRECISION);
+	} catch (const std::bad_alloc& e) {
+		lcmc::stats::setPeriodogramPrecision(lcmc::stats::DOUBLE_PRECISION);
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether batched periodograms match periodograms calculated 
+ *	one at a time
+ *
+ * @see @ref lcmc::stats::PeriodogramPlan::lombScargleBatch() "PeriodogramPlan::lombScargleBatch()"
+ *
+ * @test for PTF cadence, 20 sine waves with different periods and 
+ *	white noise give the same periodograms with lombScargleBatch() as 
+ *	with lombScargle(), for both LS_DIRECT and LS_FAST
+ * @test an empty batch gives no periodograms
+ * @test data of the wrong length throws invalid_argument
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(periodogram_batch) {
+	try {
+		using lcmc::stats::PeriodogramPlan;
+		
+		// More curves than fit in one batch
+		vector<vector<double> > curves(20);
+		vector<const vector<double>*> data;
+		for(size_t k = 0; k < curves.size(); k++) {
+			for(size_t i = 0; i < ptfTimes.size(); i++) {
+				curves[k].push_back(sin(2.0*M_PI * ptfTimes[i] / (1.3 + 0.4*k)) 
+					+ 0.1*cos(static_cast<double>((7+k)*i)));
+			}
+			data.push_back(&curves[k]);
+		}
+		
+		const lcmc::stats::PeriodogramMethod methods[] = 
+			{lcmc::stats::LS_DIRECT, lcmc::stats::LS_FAST};
+		for(size_t m = 0; m < 2; m++) {
+			const PeriodogramPlan plan(ptfTimes, methods[m]);
+			
+			vector<vector<double> > powers;
+			plan.lombScargleBatch(data, powers);
+			BOOST_REQUIRE_EQUAL(powers.size(), curves.size());
+			
+			for(size_t k = 0; k < curves.size(); k++) {
+				vector<double> single;
+				plan.lombScargle(curves[k], single);
+				
+				BOOST_REQUIRE_EQUAL(powers[k].size(), single.size());
+				for(size_t j = 0; j < single.size(); j++) {
+					BOOST_CHECK_SMALL(powers[k][j] - single[j], 
+						1e-10 * (1.0 + single[j]));
+				}
+			}
+			
+			plan.lombScargleBatch(vector<const vector<double>*>(), powers);
+			BOOST_CHECK(powers.empty());
+		}
+		
+		curves[5].pop_back();
+		vector<vector<double> > powers;
+		BOOST_CHECK_THROW(PeriodogramPlan(ptfTimes).lombScargleBatch(data, powers), 
+			std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether periodogram thresholds are calculated and cached 
+ *	correctly
+ *
+ * @see @ref lcmc::stats::lsThreshold() "lsThreshold()"
+ * @see @ref lcmc::stats::cachedLsThreshold() "cachedLsThreshold()"
+ *
+ * @test the threshold does not depend on the number of threads
+ * @test the threshold increases as the false alarm probability decreases
+ * @test a second call with the same inputs returns the same threshold
+ * @test two cadences with the same time span do not share a threshold
+ * @test invalid settings throw invalid_argument
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(threshold_cache) {
+	try {
+		using lcmc::stats::PeriodogramPlan;
+		using lcmc::stats::lsThreshold;
+		using lcmc::stats::cachedLsThreshold;
+		
+		const vector<double> times(ptfTimes.begin(), ptfTimes.begin() + 50);
+		vector<double> moved = times;
+		moved[25] = 0.5 * (moved[24] + moved[25]);
+		BOOST_REQUIRE_EQUAL(moved.front(), times.front());
+		BOOST_REQUIRE_EQUAL(moved.back() , times.back());
+		
+		const PeriodogramPlan plan(times), movedPlan(moved);
+		
+		const double serial = lsThreshold(plan, 0.05, 40, 1);
+		BOOST_CHECK_EQUAL(lsThreshold(plan, 0.05, 40, 3), serial);
+		BOOST_CHECK_EQUAL(lsThreshold(plan, 0.05, 40, 100), serial);
+		BOOST_CHECK_GE(lsThreshold(plan, 0.01, 40, 1), serial);
+		
+		const double cached = cachedLsThreshold(plan, 0.05, 40);
+		BOOST_CHECK_EQUAL(cached, serial);
+		BOOST_CHECK_EQUAL(cachedLsThreshold(plan, 0.05, 40), cached);
+		BOOST_CHECK_NE(cachedLsThreshold(movedPlan, 0.05, 40), cached);
+		
+		BOOST_CHECK_THROW(lsThreshold(plan, 0.0, 40, 1), std::invalid_argument);
+		BOOST_CHECK_THROW(lsThreshold(plan, 1.0, 40, 1), std::invalid_argument);
+		BOOST_CHECK_THROW(lsThreshold(plan, 0.05, 0, 1), std::invalid_argument);
+		BOOST_CHECK_THROW(lsThreshold(plan, 0.05, 40, 0), std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether the native Gaussian process fit behaves sensibly
+ *
+ * @see @ref lcmc::stats::fitGaussGpNative() "fitGaussGpNative()"
+ *
+ * @test for a smooth light curve with a coherence time of a few days, 
+ *	the fit returns a timescale between 1 and 10 days with a positive 
+ *	error smaller than the timescale
+ * @test a second fit of the same light curve gives the same answer
+ * @test a fit started from the previous solution gives the same answer 
+ *	in fewer iterations
+ * @test setGpFitMethod(GPFIT_NATIVE) makes fitGaussGp() give the 
+ *	same answer
+ * @test with setGpStart(GPSTART_PREVIOUS), repeated calls to 
+ *	fitGaussGp() give the same answer and are counted by 
+ *	getGpIterations()
+ * @test fewer than two points throws NotEnoughData
+ * @test data of the wrong length throws invalid_argument
+ * @test a constant light curve throws runtime_error
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(native_gp_fit) {
+	try {
+		using lcmc::stats::fitGaussGp;
+		using lcmc::stats::fitGaussGpNative;
+		using lcmc::stats::setGpFitMethod;
+		using lcmc::stats::setGpStart;
+		using lcmc::stats::getGpIterations;
+		using lcmc::stats::GpParams;
+		
+		vector<double> times, data;
+		for(size_t i = 0; i < 80; i++) {
+			const double t = 0.61 * static_cast<double>(i) 
+				+ 0.3 * sin(1.7 * static_cast<double>(i));
+			times.push_back(t);
+			data .push_back(sin(t / 2.0) + 0.5*cos(t / 1.3 + 1.0) 
+				+ 0.02*cos(static_cast<double>(7*i)));
+		}
+		
+		const double nan = std::numeric_limits<double>::quiet_NaN();
+		const GpParams defaultStart = {nan, nan, nan};
+		
+		GpParams best;
+		double err;
+		long iter;
+		fitGaussGpNative(times, data, defaultStart, best, err, iter);
+		const double tau = best.timescale;
+		BOOST_CHECK_GT(tau, 1.0);
+		BOOST_CHECK_LT(tau, 10.0);
+		BOOST_CHECK_GT(err, 0.0);
+		BOOST_CHECK_LT(err, tau);
+		BOOST_CHECK_GT(iter, 0);
+		
+		GpParams best2;
+		double err2;
+		long iter2;
+		fitGaussGpNative(times, data, defaultStart, best2, err2, iter2);
+		BOOST_CHECK_EQUAL(best2.timescale, tau);
+		BOOST_CHECK_EQUAL(err2, err);
+		BOOST_CHECK_EQUAL(iter2, iter);
+		
+		fitGaussGpNative(times, data, best, best2, err2, iter2);
+		BOOST_CHECK_CLOSE(best2.timescale, tau, 1e-3);
+		BOOST_CHECK_CLOSE(err2, err, 1e-3);
+		BOOST_CHECK_LT(iter2, iter);
+		
+		double tau2;
+		setGpFitMethod(lcmc::stats::GPFIT_NATIVE);
+		fitGaussGp(times, data, tau2, err2);
+		BOOST_CHECK_EQUAL(tau2, tau);
+		BOOST_CHECK_EQUAL(err2, err);
+		
+		long fitsBefore, iterBefore, fitsAfter, iterAfter;
+		getGpIterations(fitsBefore, iterBefore);
+		setGpStart(lcmc::stats::GPSTART_PREVIOUS, nan);
+		fitGaussGp(times, data, nan, tau2, err2);
+		BOOST_CHECK_CLOSE(tau2, tau, 1e-3);
+		fitGaussGp(times, data, nan, tau2, err2);
+		BOOST_CHECK_CLOSE(tau2, tau, 1e-3);
+		getGpIterations(fitsAfter, iterAfter);
+		setGpStart(lcmc::stats::GPSTART_DEFAULT, nan);
+		setGpFitMethod(lcmc::stats::GPFIT_R);
+		BOOST_CHECK_EQUAL(fitsAfter - fitsBefore, 2);
+		// The second fit starts at the solution
+		BOOST_CHECK_LT(iterAfter - iterBefore, 2*iter);
+		
+		const vector<double> one(1, 1.0);
+		BOOST_CHECK_THROW(fitGaussGpNative(one, one, defaultStart, 
+			best, err, iter), lcmc::stats::except::NotEnoughData);
+		vector<double> shortData(data.begin(), data.end() - 1);
+		BOOST_CHECK_THROW(fitGaussGpNative(times, shortData, defaultStart, 
+			best, err, iter), std::invalid_argument);
+		const vector<double> flat(times.size(), 3.0);
+		BOOST_CHECK_THROW(fitGaussGpNative(times, flat, defaultStart, 
+			best, err, iter), std::runtime_error);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether statistics plugins are found and reported correctly
+ *
+ * @see @ref lcmc::stats::loadStatPlugin() "loadStatPlugin()"
+ *
+ * @test statPluginPath() searches the directories in LCMC_PLUGIN_DIR 
+ *	first, in order
+ * @test a plugin name containing a directory throws invalid_argument
+ * @test a plugin that does not exist throws runtime_error, both from 
+ *	loadStatPlugin() and from fitGaussGp() with GPFIT_PLUGIN
+ * @test setGpPlugin() is remembered by getGpPlugin()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(stat_plugins) {
+	try {
+		using lcmc::stats::fitGaussGp;
+		using lcmc::stats::loadStatPlugin;
+		using lcmc::stats::setGpFitMethod;
+		using lcmc::stats::setGpPlugin;
+		using lcmc::stats::getGpPlugin;
+		
+		const char* const oldDir = getenv("LCMC_PLUGIN_DIR");
+		const std::string savedDir = (oldDir != NULL ? oldDir : "");
+		setenv("LCMC_PLUGIN_DIR", "/nonexistent/a::/nonexistent/b", 1);
+		const vector<std::string> path = lcmc::stats::statPluginPath();
+		if (oldDir != NULL) {
+			setenv("LCMC_PLUGIN_DIR", savedDir.c_str(), 1);
+		} else {
+			unsetenv("LCMC_PLUGIN_DIR");
+		}
+		BOOST_REQUIRE_GE(path.size(), 3U);
+		BOOST_CHECK_EQUAL(path[0], "/nonexistent/a");
+		BOOST_CHECK_EQUAL(path[1], "/nonexistent/b");
+		
+		BOOST_CHECK_THROW(loadStatPlugin("../rgp"), std::invalid_argument);
+		BOOST_CHECK_THROW(loadStatPlugin(""), std::invalid_argument);
+		BOOST_CHECK_THROW(loadStatPlugin("no_such_plugin"), std::runtime_error);
+		
+		vector<double> times, data;
+		for(size_t i = 0; i < 10; i++) {
+			times.push_back(static_cast<double>(i));
+			data .push_back(sin(static_cast<double>(i)));
+		}
+		double tau, err;
+		setGpPlugin("no_such_plugin");
+		BOOST_CHECK_EQUAL(getGpPlugin(), "no_such_plugin");
+		setGpFitMethod(lcmc::stats::GPFIT_PLUGIN);
+		BOOST_CHECK_THROW(fitGaussGp(times, data, tau, err), std::runtime_error);
+		setGpFitMethod(lcmc::stats::GPFIT_R);
+		setGpPlugin("rgp");
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether batched Gaussian process fits match individual fits
+ *
+ * @see @ref lcmc::stats::fitGaussGpNativeBatch() "fitGaussGpNativeBatch()"
+ * @see @ref lcmc::stats::fitGaussGpBatch() "fitGaussGpBatch()"
+ *
+ * @test for light curves sampled at the same times, each batched fit 
+ *	gives exactly the same timescale, error, and iteration count as 
+ *	fitGaussGpNative()
+ * @test a constant light curve in the batch gives NaN and -1 iterations 
+ *	without affecting the other fits
+ * @test fitGaussGpBatch() gives the same answers as fitGaussGp(), and 
+ *	throws invalid_argument if gpBatchable() is false
+ * @test fewer than two points throws NotEnoughData
+ * @test data of the wrong length throws invalid_argument
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(native_gp_batch) {
+	try {
+		using lcmc::stats::fitGaussGp;
+		using lcmc::stats::fitGaussGpBatch;
+		using lcmc::stats::fitGaussGpNative;
+		using lcmc::stats::fitGaussGpNativeBatch;
+		using lcmc::stats::gpBatchable;
+		using lcmc::stats::setGpFitMethod;
+		using lcmc::stats::GpParams;
+		
+		vector<double> times, smooth, scaled, rough;
+		for(size_t i = 0; i < 60; i++) {
+			const double t = 0.61 * static_cast<double>(i) 
+				+ 0.3 * sin(1.7 * static_cast<double>(i));
+			times .push_back(t);
+			smooth.push_back(sin(t / 2.0) + 0.5*cos(t / 1.3 + 1.0) 
+				+ 0.02*cos(static_cast<double>(7*i)));
+			scaled.push_back(3.0*smooth.back() + 10.0);
+			rough .push_back(sin(2.0 * t) + 0.3*cos(static_cast<double>(5*i)));
+		}
+		const vector<double> flat(times.size(), 3.0);
+		
+		vector<const vector<double>*> data;
+		data.push_back(&smooth);
+		data.push_back(&flat);
+		data.push_back(&scaled);
+		data.push_back(&rough);
+		
+		const double nan = std::numeric_limits<double>::quiet_NaN();
+		const GpParams defaultStart = {nan, nan, nan};
+		const vector<GpParams> starts(data.size(), defaultStart);
+		
+		vector<GpParams> best;
+		vector<double> errs;
+		vector<long> iters;
+		fitGaussGpNativeBatch(times, data, starts, best, errs, iters);
+		BOOST_REQUIRE_EQUAL(best .size(), data.size());
+		BOOST_REQUIRE_EQUAL(errs .size(), data.size());
+		BOOST_REQUIRE_EQUAL(iters.size(), data.size());
+		
+		for(size_t i = 0; i < data.size(); i++) {
+			if (data[i] == &flat) {
+				BOOST_CHECK(gsl_isnan(best[i].timescale));
+				BOOST_CHECK(gsl_isnan(errs[i]));
+				BOOST_CHECK_EQUAL(iters[i], -1);
+			} else {
+				GpParams single;
+				double err;
+				long iter;
+				fitGaussGpNative(times, *data[i], defaultStart, single, err, iter);
+				BOOST_CHECK_EQUAL(best[i].timescale, single.timescale);
+				BOOST_CHECK_EQUAL(best[i].variance , single.variance );
+				BOOST_CHECK_EQUAL(best[i].noise    , single.noise    );
+				BOOST_CHECK_EQUAL(errs[i], err);
+				BOOST_CHECK_EQUAL(iters[i], iter);
+			}
+		}
+		
+		const vector<double> trueTimes(data.size(), nan);
+		vector<double> taus, tauErrs;
+		setGpFitMethod(lcmc::stats::GPFIT_R);
+		BOOST_CHECK(!gpBatchable());
+		BOOST_CHECK_THROW(fitGaussGpBatch(times, data, trueTimes, taus, tauErrs), 
+			std::invalid_argument);
+		setGpFitMethod(lcmc::stats::GPFIT_NATIVE);
+		BOOST_CHECK(gpBatchable());
+		fitGaussGpBatch(times, data, trueTimes, taus, tauErrs);
+		BOOST_REQUIRE_EQUAL(taus.size(), data.size());
+		double tau, tauErr;
+		fitGaussGp(times, rough, tau, tauErr);
+		BOOST_CHECK_EQUAL(taus.back(), tau);
+		BOOST_CHECK_EQUAL(tauErrs.back(), tauErr);
+		setGpFitMethod(lcmc::stats::GPFIT_R);
+		
+		const vector<double> one(1, 1.0);
+		const vector<const vector<double>*> oneData(1, &one);
+		BOOST_CHECK_THROW(fitGaussGpNativeBatch(one, oneData, 
+			vector<GpParams>(1, defaultStart), best, errs, iters), 
+			lcmc::stats::except::NotEnoughData);
+		vector<double> shortData(smooth.begin(), smooth.end() - 1);
+		data.push_back(&shortData);
+		BOOST_CHECK_THROW(fitGaussGpNativeBatch(times, data, 
+			vector<GpParams>(data.size(), defaultStart), best, errs, iters), 
+			std::invalid_argument);
+		data.pop_back();
+		BOOST_CHECK_THROW(fitGaussGpNativeBatch(times, data, 
+			vector<GpParams>(1, defaultStart), best, errs, iters), 
+			std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether Gaussian process fits of binned light curves behave 
+ *	sensibly
+ *
+ * @see @ref lcmc::stats::binLightCurve() "binLightCurve()"
+ * @see @ref lcmc::stats::setGpBinning() "setGpBinning()"
+ *
+ * @test binLightCurve() averages the times and values of the 
+ *	observations in each bin, counts them, and reports the average 
+ *	variance of the times in each bin
+ * @test binLightCurve() throws invalid_argument for unsorted times, 
+ *	mismatched arrays, or a nonpositive bin width
+ * @test a native fit with unit counts gives exactly the same answer 
+ *	as a fit without counts
+ * @test with setGpBinning(), fitGaussGp() on a dense light curve gives 
+ *	a timescale within 20% of the unbinned fit, and getGpBinningBias() 
+ *	counts the fit with a small positive bias
+ * @test fitGaussGpBatch() gives the same binned answer as fitGaussGp()
+ * @test setGpBinning() throws invalid_argument for a negative width
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(binned_gp_fit) {
+	try {
+		using lcmc::stats::binLightCurve;
+		using lcmc::stats::fitGaussGp;
+		using lcmc::stats::fitGaussGpBatch;
+		using lcmc::stats::fitGaussGpNative;
+		using lcmc::stats::getGpBinningBias;
+		using lcmc::stats::setGpBinning;
+		using lcmc::stats::setGpFitMethod;
+		using lcmc::stats::GpParams;
+		
+		const double smallTimes[] = {0.0, 0.1, 0.2, 1.0, 1.05, 3.0};
+		const double smallData [] = {1.0, 2.0, 3.0, 4.0, 6.0,  7.0};
+		const vector<double> fewTimes(smallTimes, smallTimes + 6);
+		const vector<double> fewData (smallData,  smallData  + 6);
+		vector<double> binTimes, binData, counts;
+		double spread;
+		binLightCurve(fewTimes, fewData, 0.5, binTimes, binData, counts, spread);
+		BOOST_REQUIRE_EQUAL(binTimes.size(), 3);
+		BOOST_REQUIRE_EQUAL(binData .size(), 3);
+		BOOST_REQUIRE_EQUAL(counts  .size(), 3);
+		BOOST_CHECK_CLOSE(binTimes[0], 0.1,   1e-10);
+		BOOST_CHECK_CLOSE(binTimes[1], 1.025, 1e-10);
+		BOOST_CHECK_CLOSE(binTimes[2], 3.0,   1e-10);
+		BOOST_CHECK_CLOSE(binData[0], 2.0, 1e-10);
+		BOOST_CHECK_CLOSE(binData[1], 5.0, 1e-10);
+		BOOST_CHECK_CLOSE(binData[2], 7.0, 1e-10);
+		BOOST_CHECK_EQUAL(counts[0], 3.0);
+		BOOST_CHECK_EQUAL(counts[1], 2.0);
+		BOOST_CHECK_EQUAL(counts[2], 1.0);
+		BOOST_CHECK_CLOSE(spread, (0.02/3.0 + 0.000625) / 3.0, 1e-8);
+		
+		vector<double> unsorted(fewTimes);
+		std::swap(unsorted[1], unsorted[2]);
+		BOOST_CHECK_THROW(binLightCurve(unsorted, fewData, 0.5, 
+			binTimes, binData, counts, spread), std::invalid_argument);
+		BOOST_CHECK_THROW(binLightCurve(fewTimes, vector<double>(5, 1.0), 0.5, 
+			binTimes, binData, counts, spread), std::invalid_argument);
+		BOOST_CHECK_THROW(binLightCurve(fewTimes, fewData, 0.0, 
+			binTimes, binData, counts, spread), std::invalid_argument);
+		
+		vector<double> times, data;
+		for(size_t i = 0; i < 400; i++) {
+			const double t = 0.06 * static_cast<double>(i) 
+				+ 0.02 * sin(1.7 * static_cast<double>(i));
+			times.push_back(t);
+			data .push_back(sin(t / 2.0) + 0.5*cos(t / 1.3 + 1.0) 
+				+ 0.02*cos(static_cast<double>(7*i)));
+		}
+		
+		const double nan = std::numeric_limits<double>::quiet_NaN();
+		const GpParams defaultStart = {nan, nan, nan};
+		GpParams best, best2;
+		double err, err2;
+		long iter, iter2;
+		fitGaussGpNative(times, data, defaultStart, best, err, iter);
+		fitGaussGpNative(times, data, vector<double>(times.size(), 1.0), 
+			defaultStart, best2, err2, iter2);
+		BOOST_CHECK_EQUAL(best2.timescale, best.timescale);
+		BOOST_CHECK_EQUAL(err2, err);
+		BOOST_CHECK_EQUAL(iter2, iter);
+		
+		long fitsBefore, unresolvedBefore, fitsAfter, unresolvedAfter;
+		double biasBefore, biasAfter;
+		getGpBinningBias(fitsBefore, biasBefore, unresolvedBefore);
+		setGpFitMethod(lcmc::stats::GPFIT_NATIVE);
+		setGpBinning(0.6);
+		double tau, tauErr;
+		fitGaussGp(times, data, tau, tauErr);
+		getGpBinningBias(fitsAfter, biasAfter, unresolvedAfter);
+		BOOST_CHECK_CLOSE(tau, best.timescale, 20.0);
+		BOOST_CHECK_GT(tauErr, 0.0);
+		BOOST_CHECK_EQUAL(fitsAfter - fitsBefore, 1);
+		BOOST_CHECK_EQUAL(unresolvedAfter, unresolvedBefore);
+		BOOST_CHECK_GT(biasAfter, 0.0);
+		BOOST_CHECK_LT(biasAfter, 0.05);
+		
+		vector<const vector<double>*> batch(1, &data);
+		vector<double> taus, tauErrs;
+		fitGaussGpBatch(times, batch, vector<double>(1, nan), taus, tauErrs);
+		BOOST_REQUIRE_EQUAL(taus.size(), 1);
+		BOOST_CHECK_EQUAL(taus[0], tau);
+		BOOST_CHECK_EQUAL(tauErrs[0], tauErr);
+		
+		setGpBinning(0.0);
+		setGpFitMethod(lcmc::stats::GPFIT_R);
+		BOOST_CHECK_THROW(setGpBinning(-1.0), std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether the linear-time damped random walk fit behaves sensibly
+ *
+ * @see @ref lcmc::stats::expKernelLogLike() "expKernelLogLike()"
+ * @see @ref lcmc::stats::fitDrw() "fitDrw()"
+ *
+ * @test for a two-term kernel, expKernelLogLike() matches the likelihood 
+ *	computed from a dense Cholesky factorization
+ * @test expKernelLogLike() throws invalid_argument for unsorted times
+ * @test for a simulated damped random walk with a timescale of 10 days, 
+ *	the fit returns a timescale between 5 and 20 days with a positive 
+ *	error smaller than the timescale
+ * @test the fit does not depend on the order of the observations
+ * @test fewer than two points throws NotEnoughData
+ * @test data of the wrong length throws invalid_argument
+ * @test a constant light curve throws runtime_error
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(drw_fit) {
+	try {
+		using lcmc::stats::expKernelLogLike;
+		using lcmc::stats::fitDrw;
+		
+		shared_ptr<gsl_rng> rng(checkAlloc(gsl_rng_alloc(gsl_rng_mt19937)), 
+			&gsl_rng_free);
+		gsl_rng_set(rng.get(), 42);
+		
+		// Likelihood
+		vector<double> times, data;
+		double t = 0.0;
+		for(size_t i = 0; i < 60; i++) {
+			t += 0.1 + 2.0*gsl_rng_uniform(rng.get());
+			times.push_back(t);
+			data .push_back(gsl_ran_ugaussian(rng.get()));
+		}
+		vector<double> amps, timescales;
+		amps.push_back(1.3);
+		amps.push_back(0.4);
+		timescales.push_back(3.0);
+		timescales.push_back(0.7);
+		const double noise = 0.05;
+		
+		const size_t n = times.size();
+		shared_ptr<gsl_matrix> covar(checkAlloc(gsl_matrix_alloc(n, n)), 
+			&gsl_matrix_free);
+		for(size_t i = 0; i < n; i++) {
+			for(size_t j = 0; j < n; j++) {
+				double k = (i == j ? noise : 0.0);
+				for(size_t term = 0; term < amps.size(); term++) {
+					k += amps[term] * exp(-fabs(times[i]-times[j]) 
+						/ timescales[term]);
+				}
+				gsl_matrix_set(covar.get(), i, j, k);
+			}
+		}
+		gsl_linalg_cholesky_decomp(covar.get());
+		vector<double> z(data);
+		gsl_vector_view zView = gsl_vector_view_array(&z[0], n);
+		gsl_blas_dtrsv(CblasLower, CblasNoTrans, CblasNonUnit, covar.get(), 
+			&zView.vector);
+		double denseLike = -0.5 * static_cast<double>(n) * log(2.0 * M_PI);
+		for(size_t i = 0; i < n; i++) {
+			denseLike -= 0.5*z[i]*z[i] + log(gsl_matrix_get(covar.get(), i, i));
+		}
+		BOOST_CHECK_CLOSE(expKernelLogLike(times, data, amps, timescales, noise), 
+			denseLike, 1e-8);
+		
+		vector<double> unsorted(times);
+		std::swap(unsorted[3], unsorted[4]);
+		BOOST_CHECK_THROW(expKernelLogLike(unsorted, data, amps, timescales, 
+			noise), std::invalid_argument);
+		
+		// Fit
+		const double tau = 10.0;
+		times.clear();
+		data .clear();
+		t = 0.0;
+		double x = gsl_ran_ugaussian(rng.get());
+		for(size_t i = 0; i < 900; i++) {
+			const double dt = 0.05 + 0.6*gsl_rng_uniform(rng.get());
+			const double decay = exp(-dt/tau);
+			t += dt;
+			x  = x*decay + sqrt(1.0 - decay*decay)*gsl_ran_ugaussian(rng.get());
+			times.push_back(t);
+			data .push_back(x + 0.05*gsl_ran_ugaussian(rng.get()));
+		}
+		
+		double fitTime, fitErr;
+		fitDrw(times, data, fitTime, fitErr);
+		BOOST_CHECK_GT(fitTime, 5.0);
+		BOOST_CHECK_LT(fitTime, 20.0);
+		BOOST_CHECK_GT(fitErr, 0.0);
+		BOOST_CHECK_LT(fitErr, fitTime);
+		
+		vector<double> revTimes(times.rbegin(), times.rend());
+		vector<double> revData (data .rbegin(), data .rend());
+		double revTime, revErr;
+		fitDrw(revTimes, revData, revTime, revErr);
+		BOOST_CHECK_CLOSE(revTime, fitTime, 1e-6);
+		
+		const vector<double> one(1, 1.0);
+		BOOST_CHECK_THROW(fitDrw(one, one, fitTime, fitErr), 
+			lcmc::stats::except::NotEnoughData);
+		vector<double> shortData(data.begin(), data.end() - 1);
+		BOOST_CHECK_THROW(fitDrw(times, shortData, fitTime, fitErr), 
+			std::invalid_argument);
+		const vector<double> flat(times.size(), 3.0);
+		BOOST_CHECK_THROW(fitDrw(times, flat, fitTime, fitErr), 
+			std::runtime_error);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether @ref lcmc::stats::StatDeadline "StatDeadline" abandons 
+ *	calculations that run too long
+ *
+ * @see @ref lcmc::stats::StatDeadline "StatDeadline"
+ * @see @ref lcmc::stats::checkDeadline() "checkDeadline()"
+ *
+ * @test without a deadline, checkDeadline() does not throw
+ * @test with an expired deadline, checkDeadline() and fitDrw() throw TimedOut
+ * @test an unlimited deadline nested inside an expired one does not throw
+ * @test leaving the scope of a deadline restores the previous deadline
+ * @test a generous deadline does not stop fitDrw()
+ * @test setStatBudget() rejects negative limits
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(stat_deadline) {
+	try {
+		using lcmc::stats::StatDeadline;
+		using lcmc::stats::checkDeadline;
+		using lcmc::stats::fitDrw;
+		using lcmc::stats::except::TimedOut;
+		
+		vector<double> times, data;
+		for(size_t i = 0; i < 100; i++) {
+			times.push_back(static_cast<double>(i));
+			data .push_back(sin(0.3 * static_cast<double>(i)));
+		}
+		double fitTime, fitErr;
+		
+		BOOST_CHECK_NO_THROW(checkDeadline());
+		{
+			const StatDeadline expired(1e-9);
+			BOOST_CHECK_THROW(checkDeadline(), TimedOut);
+			BOOST_CHECK_THROW(fitDrw(times, data, fitTime, fitErr), TimedOut);
+			{
+				const StatDeadline unlimited(0.0);
+				BOOST_CHECK_NO_THROW(checkDeadline());
+			}
+			BOOST_CHECK_THROW(checkDeadline(), TimedOut);
+		}
+		BOOST_CHECK_NO_THROW(checkDeadline());
+		{
+			const StatDeadline generous(3600.0);
+			BOOST_CHECK_NO_THROW(fitDrw(times, data, fitTime, fitErr));
+		}
+		
+		BOOST_CHECK_THROW(lcmc::stats::setStatBudget(-1.0), std::invalid_argument);
+		BOOST_CHECK_EQUAL(lcmc::stats::getStatBudget(), 0.0);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether @ref lcmc::stats::ProfileScope "ProfileScope" records 
+ *	time only when profiling is on
+ *
+ * @see @ref lcmc::stats::ProfileScope "ProfileScope"
+ * @see @ref lcmc::stats::setProfiling() "setProfiling()"
+ *
+ * @test profiling is off by default
+ * @test with profiling off, a scope leaves its total unchanged
+ * @test with profiling on, a scope adds the time spent in it to its total
+ * @test monotonicSeconds() never decreases
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(profile_scope) {
+	using lcmc::stats::ProfileScope;
+	using lcmc::stats::monotonicSeconds;
+	
+	BOOST_CHECK(!lcmc::stats::getProfiling());
+	
+	double total = 1.0;
+	{
+		const ProfileScope timer(total);
+	}
+	BOOST_CHECK_EQUAL(total, 1.0);
+	
+	lcmc::stats::setProfiling(true);
+	double before = 0.0, after = 0.0;
+	{
+		const ProfileScope timer(total);
+		before = monotonicSeconds();
+		// Wait for the clock to advance
+		do {
+			after = monotonicSeconds();
+		} while (after <= before);
+	}
+	lcmc::stats::setProfiling(false);
+	
+	BOOST_CHECK_GE(total - 1.0, after - before);
+	BOOST_CHECK_LT(total - 1.0, 1.0);
+}
+
+/** Tests whether @ref lcmc::stats::ProfileScope "ProfileScope" counts 
+ *	hardware events only when asked to
+ *
+ * @see @ref lcmc::stats::HardwareCounts "HardwareCounts"
+ * @see @ref lcmc::stats::setProfileCounters() "setProfileCounters()"
+ *
+ * @test HardwareCounts starts at zero, and adds, subtracts, and scales 
+ *	each event separately
+ * @test counting is off by default, and requires profiling
+ * @test with counting off, threadCounts() is zero and a scope leaves its 
+ *	counts unchanged
+ * @test with counting on, a scope never decreases its counts, and 
+ *	increases the cycle count if events can be counted
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(profile_counters) {
+	using lcmc::stats::HardwareCounts;
+	using lcmc::stats::ProfileScope;
+	
+	HardwareCounts a;
+	BOOST_CHECK_EQUAL(a.cycles, 0.0);
+	BOOST_CHECK_EQUAL(a.instructions, 0.0);
+	BOOST_CHECK_EQUAL(a.cacheMisses, 0.0);
+	
+	a.cycles = 10.0;
+	a.instructions = 20.0;
+	a.cacheMisses = 4.0;
+	HardwareCounts b;
+	b.cycles = 3.0;
+	b.instructions = 5.0;
+	b.cacheMisses = 1.0;
+	
+	const HardwareCounts diff = (a - b) * 2.0;
+	BOOST_CHECK_EQUAL(diff.cycles, 14.0);
+	BOOST_CHECK_EQUAL(diff.instructions, 30.0);
+	BOOST_CHECK_EQUAL(diff.cacheMisses, 6.0);
+	b += a;
+	BOOST_CHECK_EQUAL(b.cycles, 13.0);
+	BOOST_CHECK_EQUAL(b.instructions, 25.0);
+	BOOST_CHECK_EQUAL(b.cacheMisses, 5.0);
+	
+	BOOST_CHECK(!lcmc::stats::getProfileCounters());
+	lcmc::stats::setProfileCounters(true);
+	BOOST_CHECK(!lcmc::stats::getProfileCounters());
+	
+	double total = 0.0;
+	HardwareCounts counts;
+	{
+		const ProfileScope timer(total, counts);
+	}
+	BOOST_CHECK_EQUAL(counts.cycles, 0.0);
+	BOOST_CHECK_EQUAL(lcmc::stats::threadCounts().cycles, 0.0);
+	
+	lcmc::stats::setProfiling(true);
+	BOOST_CHECK(lcmc::stats::getProfileCounters());
+	{
+		const ProfileScope timer(total, counts);
+		// Give the counters something to count
+		volatile double sum = 0.0;
+		for(int i = 0; i < 100000; i++) {
+			sum = sum + 1.0 / (i + 1.0);
+		}
+	}
+	lcmc::stats::setProfiling(false);
+	lcmc::stats::setProfileCounters(false);
+	
+	BOOST_CHECK_GE(counts.cycles, 0.0);
+	BOOST_CHECK_GE(counts.instructions, 0.0);
+	BOOST_CHECK_GE(counts.cacheMisses, 0.0);
+	if (lcmc::stats::profileCountersAvailable()) {
+		BOOST_CHECK_GT(counts.cycles, 0.0);
+	} else {
+		BOOST_CHECK_EQUAL(counts.cycles, 0.0);
+	}
+}
+
+/** Tests whether @ref lcmc::stats::TraceSpan "TraceSpan" records the 
+ *	most recent events
+ *
+ * @see @ref lcmc::stats::TraceSpan "TraceSpan"
+ * @see @ref lcmc::stats::writeTrace() "writeTrace()"
+ *
+ * @test spans created before startTrace() are not recorded
+ * @test once the trace is full, each span replaces the oldest one
+ * @test writeTrace() reports the number of events dropped, and 
+ *	stops tracing
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(trace_span) {
+	try {
+		using lcmc::stats::TraceSpan;
+		const std::string fileName = "test_trace.json";
+		
+		BOOST_CHECK(!lcmc::stats::isTracing());
+		{
+			const TraceSpan span("before");
+		}
+		
+		BOOST_CHECK_THROW(lcmc::stats::startTrace(fileName, 0), 
+			std::invalid_argument);
+		lcmc::stats::startTrace(fileName, 2);
+		BOOST_CHECK(lcmc::stats::isTracing());
+		{
+			const TraceSpan span1("first");
+		}
+		{
+			const TraceSpan span2("second");
+			const TraceSpan span3("third");
+		}
+		lcmc::stats::writeTrace();
+		BOOST_CHECK(!lcmc::stats::isTracing());
+		
+		std::string trace;
+		{
+			boost::shared_ptr<FILE> file = kpfutils::fileCheckOpen(fileName, "r");
+			char buffer[256];
+			while (fgets(buffer, sizeof(buffer), file.get()) != NULL) {
+				trace += buffer;
+			}
+		}
+		std::remove(fileName.c_str());
+		
+		BOOST_CHECK_EQUAL(trace.find("\"before\""), std::string::npos);
+		BOOST_CHECK_EQUAL(trace.find("\"first\""),  std::string::npos);
+		// Inner spans finish first
+		BOOST_CHECK_LT(trace.find("\"third\""), trace.find("\"second\""));
+		BOOST_CHECK_LT(trace.find("\"second\""), std::string::npos);
+		BOOST_CHECK(trace.find("\"droppedEvents\":1") != std::string::npos);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether @ref lcmc::utils::CacheCounter "CacheCounter" counts 
+ *	the uses of a cache
+ *
+ * @see @ref lcmc::utils::CacheCounter "CacheCounter"
+ * @see @ref lcmc::utils::CacheMiss "CacheMiss"
+ *
+ * @test a new counter has no hits or misses
+ * @test hit() and CacheMiss each add one to their count
+ * @test repeated calls to PeriodogramPlan::forCadence() for the same 
+ *	times all hit its cache, which printCacheReport() lists
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(cache_counter) {
+	try {
+		using lcmc::utils::CacheCounter;
+		using lcmc::utils::CacheMiss;
+		using lcmc::stats::PeriodogramPlan;
+		
+		CacheCounter counter("Test cache");
+		BOOST_CHECK_EQUAL(counter.getHits(),   0);
+		BOOST_CHECK_EQUAL(counter.getMisses(), 0);
+		counter.hit();
+		counter.hit();
+		{
+			const CacheMiss miss(counter);
+		}
+		BOOST_CHECK_EQUAL(counter.getHits(),   2);
+		BOOST_CHECK_EQUAL(counter.getMisses(), 1);
+		
+		vector<double> times;
+		for(size_t i = 0; i < 50; i++) {
+			times.push_back(1.5 * static_cast<double>(i));
+		}
+		PeriodogramPlan::forCadence(times, lcmc::stats::LS_DIRECT);
+		
+		boost::shared_ptr<FILE> report(tmpfile(), &fclose);
+		BOOST_REQUIRE(report.get() != NULL);
+		lcmc::utils::printCacheReport(report.get());
+		const long before = readCacheHits(report.get(), "Periodogram plans");
+		
+		PeriodogramPlan::forCadence(times, lcmc::stats::LS_DIRECT);
+		PeriodogramPlan::forCadence(times, lcmc::stats::LS_DIRECT);
+		
+		report.reset(tmpfile(), &fclose);
+		BOOST_REQUIRE(report.get() != NULL);
+		lcmc::utils::printCacheReport(report.get());
+		BOOST_CHECK_EQUAL(readCacheHits(report.get(), "Periodogram plans"), 
+			before + 2);
+		BOOST_CHECK_EQUAL(readCacheHits(report.get(), "Test cache"), 2);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether @ref lcmc::stats::AnalysisContext "AnalysisContext" 
+ *	gives the same intermediate results as the standalone functions
+ *
+ * @see @ref lcmc::stats::AnalysisContext "AnalysisContext"
+ * @see @ref lcmc::stats::getC1Sorted() "getC1Sorted()"
+ *
+ * @test NaN fluxes are removed along with their times
+ * @test the ranked magnitudes are a permutation of the magnitudes, 
+ *	with the 5th, 50th, and 95th percentiles where a sort puts them
+ * @test the amplitude matches getAmplitude(), and C1 from the ranked 
+ *	magnitudes matches getC1()
+ * @test the baseline is the time between the first and last valid points
+ * @test fluxes of the wrong length throw invalid_argument
+ * @test a single point throws NotEnoughData when asked for an amplitude
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(analysis_context) {
+	try {
+		using lcmc::stats::AnalysisContext;
+		
+		vector<double> times, fluxes;
+		for(size_t i = 0; i < 10; i++) {
+			times .push_back(static_cast<double>(i));
+			fluxes.push_back(1.0 + 0.1*static_cast<double>((3*i) % 10));
+		}
+		fluxes[9] = std::numeric_limits<double>::quiet_NaN();
+		
+		const AnalysisContext lc(times, fluxes);
+		BOOST_REQUIRE_EQUAL(lc.getTimes().size(), times.size() - 1);
+		BOOST_REQUIRE_EQUAL(lc.getMags ().size(), times.size() - 1);
+		BOOST_CHECK_EQUAL(lc.getTimes().back(), 8.0);
+		
+		vector<double> mags;
+		lcmc::utils::fluxToMag(vector<double>(fluxes.begin(), fluxes.end() - 1), mags);
+		BOOST_CHECK_EQUAL_COLLECTIONS(lc.getMags().begin(), lc.getMags().end(), 
+			mags.begin(), mags.end());
+		
+		vector<double> sorted(mags);
+		std::sort(sorted.begin(), sorted.end());
+		const vector<double>& ranked = lc.getRankedMags();
+		BOOST_REQUIRE_EQUAL(ranked.size(), sorted.size());
+		const size_t n = sorted.size();
+		const size_t ranks[] = {static_cast<size_t>(0.05*n), 
+			static_cast<size_t>(0.50*n), static_cast<size_t>(0.95*n)};
+		for(size_t i = 0; i < 3; i++) {
+			BOOST_CHECK_EQUAL(ranked[ranks[i]], sorted[ranks[i]]);
+		}
+		vector<double> resorted(ranked);
+		std::sort(resorted.begin(), resorted.end());
+		BOOST_CHECK_EQUAL_COLLECTIONS(resorted.begin(), resorted.end(), 
+			sorted.begin(), sorted.end());
+		
+		BOOST_CHECK_EQUAL(lc.getAmplitude(), lcmc::stats::getAmplitude(mags));
+		BOOST_CHECK_EQUAL(lcmc::stats::getC1Sorted(lc.getRankedMags()), 
+			lcmc::stats::getC1(mags));
+		BOOST_CHECK_CLOSE(lc.getBaseline(), 8.0, 1e-10);
+		
+		// Light curves without NaNs keep the caller's cadence
+		const lcmc::models::Cadence cadence(vector<double>(times.begin(), times.end() - 1));
+		const AnalysisContext clean(cadence, vector<double>(fluxes.begin(), fluxes.end() - 1));
+		BOOST_CHECK(clean.getCadence().sameAs(cadence));
+		BOOST_CHECK(lc.getCadence() == cadence);
+		BOOST_CHECK(!lc.getCadence().sameAs(cadence));
+		
+		BOOST_CHECK_THROW(AnalysisContext(times, mags), std::invalid_argument);
+		
+		const AnalysisContext single(vector<double>(1, 0.0), vector<double>(1, 1.0));
+		BOOST_CHECK_THROW(single.getAmplitude(), lcmc::stats::except::NotEnoughData);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether the status-returning statistics report the same 
+ *	failures as the functions that throw
+ *
+ * @see @ref lcmc::stats::tryC1() "tryC1()"
+ * @see @ref lcmc::stats::tryFitGaussGp() "tryFitGaussGp()"
+ *
+ * @test tryC1() and tryC1Sorted() give the same value as getC1()
+ * @test fewer than 3 points gives STAT_NOT_ENOUGH_DATA, and a flat 
+ *	light curve STAT_UNDEFINED, without changing the output; getC1() 
+ *	still throws NotEnoughData and Undefined
+ * @test tryFitGaussGpNative() and tryFitGaussGp() report a single 
+ *	point as STAT_NOT_ENOUGH_DATA and a flat light curve as 
+ *	STAT_UNDEFINED, while fitGaussGp() still throws
+ * @test mismatched times and data still throw invalid_argument
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(stat_status) {
+	try {
+		using lcmc::stats::GpParams;
+		using lcmc::stats::StatStatus;
+		using lcmc::stats::tryC1;
+		using lcmc::stats::tryC1Sorted;
+		using lcmc::stats::tryFitGaussGp;
+		using lcmc::stats::tryFitGaussGpNative;
+		const double nan = std::numeric_limits<double>::quiet_NaN();
+		
+		vector<double> times, mags;
+		for(size_t i = 0; i < 10; i++) {
+			times.push_back(static_cast<double>(i));
+			mags .push_back(0.1*static_cast<double>((3*i) % 10));
+		}
+		vector<double> sorted(mags);
+		std::sort(sorted.begin(), sorted.end());
+		
+		double c1 = -1.0;
+		BOOST_CHECK_EQUAL(tryC1(mags, c1), lcmc::stats::STAT_OK);
+		BOOST_CHECK_EQUAL(c1, lcmc::stats::getC1(mags));
+		c1 = -1.0;
+		BOOST_CHECK_EQUAL(tryC1Sorted(sorted, c1), lcmc::stats::STAT_OK);
+		BOOST_CHECK_EQUAL(c1, lcmc::stats::getC1(mags));
+		
+		const vector<double> two(2, 1.0);
+		const vector<double> flat(times.size(), 3.0);
+		c1 = -1.0;
+		BOOST_CHECK_EQUAL(tryC1(two, c1), lcmc::stats::STAT_NOT_ENOUGH_DATA);
+		BOOST_CHECK_EQUAL(tryC1(flat, c1), lcmc::stats::STAT_UNDEFINED);
+		BOOST_CHECK_EQUAL(c1, -1.0);
+		BOOST_CHECK_THROW(lcmc::stats::getC1(two), 
+			lcmc::stats::except::NotEnoughData);
+		BOOST_CHECK_THROW(lcmc::stats::getC1(flat), 
+			lcmc::stats::except::Undefined);
+		
+		const GpParams defaultStart = {nan, nan, nan};
+		GpParams best = {-1.0, -1.0, -1.0};
+		double err = -1.0;
+		long iter = -2;
+		const vector<double> one(1, 1.0);
+		BOOST_CHECK_EQUAL(tryFitGaussGpNative(one, one, vector<double>(), 
+			defaultStart, best, err, iter), lcmc::stats::STAT_NOT_ENOUGH_DATA);
+		BOOST_CHECK_EQUAL(tryFitGaussGpNative(times, flat, vector<double>(), 
+			defaultStart, best, err, iter), lcmc::stats::STAT_UNDEFINED);
+		BOOST_CHECK_EQUAL(best.timescale, -1.0);
+		BOOST_CHECK_EQUAL(err, -1.0);
+		BOOST_CHECK_THROW(tryFitGaussGpNative(times, one, vector<double>(), 
+			defaultStart, best, err, iter), std::invalid_argument);
+		
+		lcmc::stats::setGpFitMethod(lcmc::stats::GPFIT_NATIVE);
+		double tau = -1.0;
+		BOOST_CHECK_EQUAL(tryFitGaussGp(one, one, nan, tau, err), 
+			lcmc::stats::STAT_NOT_ENOUGH_DATA);
+		BOOST_CHECK_EQUAL(tryFitGaussGp(times, flat, nan, tau, err), 
+			lcmc::stats::STAT_UNDEFINED);
+		BOOST_CHECK_EQUAL(tau, -1.0);
+		BOOST_CHECK_THROW(lcmc::stats::fitGaussGp(one, one, tau, err), 
+			lcmc::stats::except::NotEnoughData);
+		BOOST_CHECK_THROW(lcmc::stats::fitGaussGp(times, flat, tau, err), 
+			std::runtime_error);
+		lcmc::stats::setGpFitMethod(lcmc::stats::GPFIT_R);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether @ref lcmc::stats::autoCorrelation_stat() "autoCorrelation_stat()" 
+ *	matches existing autocorrelation implementations from other languages
+ * @see @ref lcmc::stats::autoCorrelation_stat() "autoCorrelation_stat()"
+ *
+ * @test Consistent results with a_correlate() procedure from IDL
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(acf) {
+	shared_ptr<FILE> hTarget;
+	try {
+		hTarget = fileCheckOpen("acftarget.txt", "r");
+	} catch (const kpfutils::except::FileIo& e) {
+		BOOST_FAIL(e.what());
+	}
+	
+	try {
+		while(!feof(hTarget.get())) {
+			double data[10];
+			for(size_t i = 0; i < 10 && !feof(hTarget.get()); i++) {
+				double curVal;
+				fscanf(hTarget.get(), "%lf", &curVal);
+				data[i] = curVal;
+			}
+			if (feof(hTarget.get())) {
+				break;
+			}
+
+			double corrs[10];
+			for(size_t i = 0; i < 10 && !feof(hTarget.get()); i++) {
+				double curVal;
+				fscanf(hTarget.get(), "%lf", &curVal);
+				corrs[i] = curVal;
+			}
+			if (feof(hTarget.get())) {
+				break;
+			}
+			
+			double acfs[10];
+			BOOST_REQUIRE_NO_THROW(
+				lcmc::stats::autoCorrelation_stat(data, acfs, 10));
+			
+			for(size_t i = 0; i < 10; i++) {
+				myTestClose(acfs[i], corrs[i], 1e-5);
+			}
+		}
+	} catch (const std::exception &e) {
+		BOOST_MESSAGE("Could not finish reading from acftarget.txt.");
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether the batched @ref lcmc::stats::autoCorrelation_stat() "autoCorrelation_stat()" 
+ *	matches the single-series version
+ * @see @ref lcmc::stats::autoCorrelation_stat() "autoCorrelation_stat()"
+ *
+ * @test Each of three series autocorrelated together gives the same 
+ *	ACF as when autocorrelated alone
+ * @test A batch of zero series throws invalid_argument
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(acf_batch) {
+	try {
+		const size_t N = 50, K = 3;
+		
+		double data[N*K];
+		for(size_t j = 0; j < K; j++) {
+			for(size_t i = 0; i < N; i++) {
+				data[j*N + i] = sin(0.3 * (j+1) * i) + 0.1*cos(static_cast<double>(7*i + j));
+			}
+		}
+		
+		double batch[N*K];
+		BOOST_REQUIRE_NO_THROW(
+			lcmc::stats::autoCorrelation_stat(data, batch, N, K));
+		
+		for(size_t j = 0; j < K; j++) {
+			double single[N];
+			BOOST_REQUIRE_NO_THROW(
+				lcmc::stats::autoCorrelation_stat(data + j*N, single, N));
+			for(size_t i = 0; i < N; i++) {
+				myTestClose(batch[j*N + i], single[i], 1e-10);
+			}
+		}
+		
+		BOOST_CHECK_THROW(lcmc::stats::autoCorrelation_stat(data, batch, N, 0), 
+			std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether @ref lcmc::stats::batchInterpAcfs() "batchInterpAcfs()" 
+ *	records the ACFs doAcf() would calculate
+ * @see @ref lcmc::stats::batchInterpAcfs() "batchInterpAcfs()"
+ * @see @ref lcmc::stats::AnalysisContext::findAcf() "AnalysisContext::findAcf()"
+ *
+ * @test Each of three light curves on the same cadence has a recorded 
+ *	ACF, equal to what interp::autoCorr() gives for it alone
+ * @test The recorded ACF is not returned for a different lag spacing, 
+ *	number of lags, or ACF function
+ * @test Light curves with a single point are left unrecorded
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(acf_context_batch) {
+	using lcmc::stats::AcfFunction;
+	using lcmc::stats::AnalysisContext;
+	
+	try {
+		const AcfFunction interpAcf = 
+			static_cast<AcfFunction>(&lcmc::stats::interp::autoCorr);
+		const size_t N = 60, K = 3;
+		
+		vector<double> times;
+		for(size_t i = 0; i < N; i++) {
+			times.push_back(0.37 * i);
+		}
+		const lcmc::models::Cadence cadence(times);
+		
+		vector<shared_ptr<AnalysisContext> > contexts;
+		vector<AnalysisContext*> members;
+		for(size_t j = 0; j < K; j++) {
+			vector<double> fluxes;
+			for(size_t i = 0; i < N; i++) {
+				fluxes.push_back(1.0 + 0.1 * sin(0.3 * (j+1) * times[i]));
+			}
+			contexts.push_back(shared_ptr<AnalysisContext>(
+				new AnalysisContext(cadence, fluxes)));
+			members.push_back(contexts.back().get());
+		}
+		
+		BOOST_REQUIRE_NO_THROW(lcmc::stats::batchInterpAcfs(members));
+		
+		for(size_t j = 0; j < K; j++) {
+			BOOST_REQUIRE(!contexts[j]->getMags().empty());
+			
+			// doAcf() asks for one lag per 0.1 up to the baseline
+			size_t nAcf = 0;
+			for(double t = 0.0; t < contexts[j]->getBaseline(); t += 0.1) {
+				nAcf++;
+			}
+			const vector<double>* recorded = 
+				contexts[j]->findAcf(interpAcf, 0.1, nAcf);
+			BOOST_REQUIRE(recorded != NULL);
+			
+			vector<double> single;
+			BOOST_REQUIRE_NO_THROW(lcmc::stats::interp::autoCorr(
+				contexts[j]->getTimes(), contexts[j]->getMags(), 
+				0.1, nAcf, single));
+			BOOST_REQUIRE_EQUAL(recorded->size(), single.size());
+			for(size_t i = 0; i < single.size(); i++) {
+				myTestClose((*recorded)[i], single[i], 1e-10);
+			}
+			
+			BOOST_CHECK(contexts[j]->findAcf(interpAcf, 0.2, nAcf)   == NULL);
+			BOOST_CHECK(contexts[j]->findAcf(interpAcf, 0.1, nAcf+1) == NULL);
+			BOOST_CHECK(contexts[j]->findAcf(NULL,      0.1, nAcf)   == NULL);
+		}
+		
+		AnalysisContext shortCurve(lcmc::models::Cadence(vector<double>(1, 0.0)), 
+			vector<double>(1, 1.0));
+		vector<AnalysisContext*> shortMembers(2, &shortCurve);
+		BOOST_CHECK_NO_THROW(lcmc::stats::batchInterpAcfs(shortMembers));
+		BOOST_CHECK(shortCurve.findAcf(interpAcf, 0.1, 0) == NULL);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
+}
+
+/** Tests whether the Scargle ACF at selected lags matches the ACF at 
+ *	every lag
+ *
+ * @see @ref lcmc::stats::ScargleAcfPlan "ScargleAcfPlan"
+ *
+ * @test For logarithmically spaced lags, the ACF at those lags, and at 
+ *	every lag up to the first one below 1/9, equals the ACF at every 
+ *	lag. All other lags are either equal or NaN.
+ * @test Asking for every lag gives the ACF at every lag.
+ * @test With a level of -1, only the lags asked for are needed.
+ * @test A constant light curve has no ACF.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(acf_scargle_lags) {
+	using lcmc::stats::ScargleAcfPlan;
+	
+	try {
+		const lcmc::models::Cadence cadence(ptfTimes);
+		const vector<double>& times = cadence.timeView();
+		const double offStep = 0.1;
+		const size_t nOffsets = static_cast<size_t>(
+			(times.back() - times.front()) / offStep);
+		const ScargleAcfPlan plan(times, offStep, nOffsets);
+		
+		vector<double> data;
+		for(size_t i = 0; i < times.size(); i++) {
+			data.push_back(sin(2.0*M_PI*times[i]/5.0) + 0.3*cos(7.0*i));
+		}
+		vector<double> full;
+		plan.autoCorr(data, full);
+		BOOST_REQUIRE_EQUAL(full.size(), nOffsets);
+		
+		vector<size_t> lags(1, 0);
+		for(size_t m = 1; m < nOffsets; m = m*21/20 + 1) {
+			lags.push_back(m);
+		}
+		vector<double> partial;
+		plan.autoCorr(data, lags, 1.0/9.0, partial);
+		BOOST_REQUIRE_EQUAL(partial.size(), nOffsets);
+		for(vector<size_t>::const_iterator it = lags.begin(); 
+				it != lags.end(); it++) {
+			BOOST_CHECK_SMALL(partial[*it] - full[*it], 1e-10);
+		}
+		bool crossed = false;
+		for(size_t m = 0; m < nOffsets; m++) {
+			if (!crossed) {
+				BOOST_CHECK_SMALL(partial[m] - full[m], 1e-10);
+				crossed = (full[m] < 1.0/9.0);
+			} else {
+				// NaN never equals itself
+				BOOST_CHECK(partial[m] != partial[m] 
+					|| fabs(partial[m] - full[m]) < 1e-10);
+			}
+		}
+		
+		vector<size_t> all;
+		for(size_t m = 0; m < nOffsets; m++) {
+			all.push_back(m);
+		}
+		plan.autoCorr(data, all, 1.0/9.0, partial);
+		BOOST_REQUIRE_EQUAL(partial.size(), nOffsets);
+		for(size_t m = 0; m < nOffsets; m++) {
+			BOOST_CHECK_SMALL(partial[m] - full[m], 1e-10);
+		}
+		
+		plan.autoCorr(data, vector<size_t>(1, 0), -1.0, partial);
+		BOOST_REQUIRE_EQUAL(partial.size(), nOffsets);
+		BOOST_CHECK_SMALL(partial[0] - 1.0, 1e-10);
+		
+		BOOST_CHECK_THROW(plan.autoCorr(vector<double>(times.size(), 1.0), 
+			lags, 1.0/9.0, partial), lcmc::stats::except::Undefined);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether the Scargle ACF computed from a periodogram matches 
+ *	the ACF of the timescales library
+ *
+ * @see @ref lcmc::stats::ScargleAcfPlan "ScargleAcfPlan"
+ *
+ * @test For sinusoids with periods of 5 and 50 days plus noise, 
+ *	sampled at the PTF epochs, both ACFs are 1 at zero lag.
+ * @test For the same light curves, the two ACFs differ by less than 
+ *	0.05 at every lag up to 1/4 of the baseline.
+ * @test For the same light curves, the first lags at which the two 
+ *	ACFs fall below 1/2, 1/e, and 1/9 differ by at most 2% of 
+ *	the lag, or one lag step.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(acf_scargle_reference) {
+	using lcmc::stats::ScargleAcfPlan;
+	
+	try {
+		const lcmc::models::Cadence cadence(ptfTimes);
+		const vector<double>& times = cadence.timeView();
+		const double offStep = 0.1;
+		const size_t nOffsets = static_cast<size_t>(
+			0.25 * (times.back() - times.front()) / offStep);
+		const ScargleAcfPlan plan(times, offStep, nOffsets);
+		
+		vector<double> offsets;
+		for(size_t m = 0; m < nOffsets; m++) {
+			offsets.push_back(m*offStep);
+		}
+		
+		const double PERIODS[] = {5.0, 50.0};
+		const double LEVELS[] = {0.5, exp(-1.0), 1.0/9.0};
+		for(size_t p = 0; p < 2; p++) {
+			vector<double> data;
+			for(size_t i = 0; i < times.size(); i++) {
+				data.push_back(sin(2.0*M_PI*times[i]/PERIODS[p]) 
+					+ 0.3*cos(7.0*i));
+			}
+			
+			vector<double> fast, reference;
+			plan.autoCorr(data, fast);
+			kpftimes::autoCorr(times, data, offsets, reference);
+			BOOST_REQUIRE_EQUAL(fast.size(), nOffsets);
+			BOOST_REQUIRE_EQUAL(reference.size(), nOffsets);
+			
+			BOOST_CHECK_SMALL(fast[0] - 1.0, 1e-10);
+			BOOST_CHECK_SMALL(reference[0] - 1.0, 1e-10);
+			for(size_t m = 0; m < nOffsets; m++) {
+				BOOST_CHECK_SMALL(fast[m] - reference[m], 0.05);
+			}
+			
+			for(size_t l = 0; l < 3; l++) {
+				size_t fastCut = nOffsets, refCut = nOffsets;
+				for(size_t m = 0; m < nOffsets; m++) {
+					if (fastCut == nOffsets && fast[m] < LEVELS[l]) {
+						fastCut = m;
+					}
+					if (refCut == nOffsets && reference[m] < LEVELS[l]) {
+						refCut = m;
+					}
+				}
+				BOOST_REQUIRE(refCut < nOffsets);
+				const size_t diff = (fastCut > refCut 
+					? fastCut - refCut : refCut - fastCut);
+				BOOST_CHECK(diff <= std::max<size_t>(1, refCut/50));
+			}
+		}
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	} catch (const std::runtime_error& e) {
+		BOOST_FAIL(e.what());
+	}
+}
+
+/** Tests whether @ref lcmc::stats::interp::autoCorr() "interp::autoCorr()" 
+ *	matches Ann Marie's original program
+ *
+ * @see @ref lcmc::stats::interp::autoCorr() "interp::autoCorr()"
+ *
+ * @test Consistent results with original IDL code
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(acf_interp) {
+	for(size_t i = 0; i <= 13; i++) {
+		vector<double> times, mags;
+		vector<double> lags, acfs;
+
+		try {
+			{
+				char fileName[80];
+				int status = sprintf(fileName, "idl_target_in_%i.txt", i);
+				if (status < 0) {
+					cError("While testing interp::autoCorr(): ");
+				}
+				
+				kpfutils::readMcLightCurve(fileName, times, mags);
+			}
+	
+			{
+				char fileName[80];
+				int status = sprintf(fileName, "idl_target_acf_%i.txt", i);
+				if (status < 0) {
+					cError("While testing interp::autoCorr(): ");
+				}
+	
+				kpfutils::readMcLightCurve(fileName, lags, acfs);
+			}
+		} catch (const std::exception& e) {
+			BOOST_FAIL(e.what());
+		}
+		
+		size_t   nAcf = lags.size();
+		// Add a small offset to prevent roundoff errors from making 
+		//	a longer grid than AMC used
+		double deltaT = (lags.back() - lags.front())/(nAcf-1) + 1e-14;
+		
+		vector<double> myAcfs;
+		BOOST_REQUIRE_NO_THROW(lcmc::stats::interp::autoCorr(times, mags, 
+			deltaT, nAcf, myAcfs));
+		
+		BOOST_REQUIRE_EQUAL(nAcf, myAcfs.size());
+		
+		// Allow for occasional deviations due to roundoff errors
+		unsigned int nBad = 0;
+		for(size_t j = 0; j < nAcf; j++) {
+			if (!isClose(acfs[j], myAcfs[j], 1e-5)) {
+				nBad++;
+			}
+		}
+		BOOST_WARN(nBad == 0 || nBad >= nAcf/1000);
+		BOOST_CHECK(nBad <= nAcf/1000);
+	}	// end loop over examples
+}
+
+/** Tests whether the streaming RMS-timescale functions match the 
+ *	definitions they replace
+ *
+ * @see @ref lcmc::stats::rmsVsTRooted() "rmsVsTRooted()"
+ * @see @ref lcmc::stats::rmsVsTAllPairs() "rmsVsTAllPairs()"
+ * @see @ref lcmc::stats::rmsVsTBinned() "rmsVsTBinned()"
+ *
+ * @test Given PTF-like sampling and magnitudes with a large mean, the 
+ *	RMS from the first observation to each later one equals the 
+ *	standard deviation of those observations.
+ * @test The RMS over all subintervals, sorted by length, equals the 
+ *	standard deviation of each subinterval.
+ * @test The binned medians equal the medians of the sorted RMS values 
+ *	in each bin, and empty bins are NaN.
+ * @test Light curves of one point throw std::invalid_argument.
+ */
+BOOST_AUTO_TEST_CASE(rms_timescales) {
+	try {
+		const size_t N = 60;
+		const vector<double> times(ptfTimes.begin(), ptfTimes.begin() + N);
+		shared_ptr<gsl_rng> rng(checkAlloc(gsl_rng_alloc(gsl_rng_mt19937)), 
+			&gsl_rng_free);
+		gsl_rng_set(rng.get(), 42);
+		vector<double> mags;
+		for(size_t i = 0; i < N; i++) {
+			mags.push_back(15.0 + 0.1*gsl_ran_ugaussian(rng.get()));
+		}
+		
+		vector<double> steps, rms;
+		stats::rmsVsTRooted(times, mags, steps, rms);
+		BOOST_REQUIRE_EQUAL(steps.size(), N-1);
+		BOOST_REQUIRE_EQUAL(rms.size(), N-1);
+		for(size_t last = 1; last < N; last++) {
+			BOOST_CHECK_EQUAL(steps[last-1], times[last] - times[0]);
+			myTestClose(rms[last-1], sqrt(kpfutils::variance(mags.begin(), 
+				mags.begin() + last + 1)), 1e-10);
+		}
+		
+		vector<std::pair<double, double> > expected;
+		for(size_t first = 0; first < N; first++) {
+			for(size_t last = first+1; last < N; last++) {
+				expected.push_back(std::make_pair(times[last] - times[first], 
+					sqrt(kpfutils::variance(mags.begin() + first, 
+						mags.begin() + last + 1))));
+			}
+		}
+		std::sort(expected.begin(), expected.end());
+		stats::rmsVsTAllPairs(times, mags, steps, rms);
+		BOOST_REQUIRE_EQUAL(steps.size(), expected.size());
+		for(size_t i = 0; i < expected.size(); i++) {
+			BOOST_CHECK_EQUAL(steps[i], expected[i].first);
+			myTestClose(rms[i], expected[i].second, 1e-10);
+		}
+		
+		// The first edge is shorter than any subinterval, and the 
+		//	last is longer
+		const double edges[] = {1e-4, 0.01, 1.0, 10.0, 100.0, 1e6};
+		const vector<double> binEdges(edges, edges + sizeof(edges)/sizeof(edges[0]));
+		vector<double> medians;
+		stats::rmsVsTBinned(times, mags, binEdges, medians);
+		BOOST_REQUIRE_EQUAL(medians.size(), binEdges.size());
+		for(size_t bin = 0; bin + 1 < binEdges.size(); bin++) {
+			vector<double> inBin;
+			for(size_t i = 0; i < steps.size(); i++) {
+				if (steps[i] >= binEdges[bin] && steps[i] < binEdges[bin+1]) {
+					inBin.push_back(rms[i]);
+				}
+			}
+			std::sort(inBin.begin(), inBin.end());
+			if (inBin.empty()) {
+				BOOST_CHECK(gsl_isnan(medians[bin]));
+			} else {
+				const size_t n = inBin.size();
+				myTestClose(medians[bin], 
+					0.5*(inBin[(n-1)/2] + inBin[n/2]), 1e-10);
+			}
+		}
+		BOOST_CHECK(gsl_isnan(medians.back()));
+		
+		const vector<double> onePoint(1, 0.0);
+		BOOST_CHECK_THROW(stats::rmsVsTRooted(onePoint, onePoint, steps, rms), 
+			std::invalid_argument);
+	} catch (const std::bad_alloc& e) {
+		BOOST_FAIL("Out of memory!");
+	}
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,7 +2,7 @@
  * @file lightcurveMC/tests/unit_waves.cpp
  * @author Krzysztof Findeisen
  * @date Created April 28, 2013
- * @date Last modified May 24, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -49,16 +49,22 @@
 #pragma GCC diagnostic pop
 #endif
 
+#include <algorithm>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include <cmath>
 #include <cstdio>
 #include <boost/smart_ptr.hpp>
 #include <gsl/gsl_math.h>
 #include "test.h"
 #include "../except/data.h"
 #include "../fluxmag.h"
+#include "../lightcurvemc.h"
+#include "../lightcurvemc_c.h"
 #include "../lightcurvetypes.h"
+#include "../waves/lightcurves_fades.h"
+#include "../waves/lightcurves_outbursts.h"
 #include "../waves/lightcurves_periodic.h"
 
 namespace lcmc { namespace test {
@@ -380,6 +386,23 @@ void testPeriodic(size_t nTest, const TestFactory& factory) {
 			// If this condition is violated, all other tests are buggy
 			BOOST_REQUIRE(times.size() == fluxes.size());	
 			
+			// The views must agree with the copies
+			BOOST_CHECK(model->timeView() == times);
+			std::vector<double> filled(model->size());
+			if (!filled.empty()) {
+				model->fillFluxes(&filled[0]);
+			}
+			BOOST_CHECK(filled == fluxes);
+			std::vector<double> mags(model->size());
+			if (!mags.empty()) {
+				model->fillMags(&mags[0]);
+			}
+			for(size_t j = 0; j < mags.size(); j++) {
+				// Nonpositive fluxes have no magnitude
+				BOOST_CHECK(fluxes[j] <= 0.0 || isClose(lcmc::utils::magToFlux(mags[j]), 
+					fluxes[j], 1e-12));
+			}
+			
 			for(size_t j = 0; j < times.size(); j++) {
 				/*for(size_t k = j+1; k < times.size(); k++) {
 					//@post if getTimes()[i] == getTimes()[j] for i &ne; j, then 
@@ -456,6 +479,170 @@ BOOST_AUTO_TEST_CASE(sine)
 			models::except::BadParam);
 }
 
+/** Returns the largest change in a light curve caused by tabulating 
+ *	its waveform
+ *
+ * @param[in] lc The light curve to test.
+ * @param[in] tol The tolerance to pass to setShapeTolerance().
+ *
+ * @return The largest difference in flux at any time between the 
+ *	exact and tabulated light curves.
+ *
+ * @post getShapeTolerance() = 0
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the fluxes.
+ *
+ * @exceptsafe getShapeTolerance() = 0 in the event of an exception.
+ */
+double tableError(const models::ILightCurve& lc, double tol) {
+	std::vector<double> exact, tabulated;
+	models::setShapeTolerance(0.0);
+	lc.getFluxes(exact);
+	models::setShapeTolerance(tol);
+	try {
+		lc.getFluxes(tabulated);
+	} catch (...) {
+		models::setShapeTolerance(0.0);
+		throw;
+	}
+	models::setShapeTolerance(0.0);
+	
+	double diff = 0.0;
+	for(size_t i = 0; i < exact.size(); i++) {
+		diff = std::max(diff, fabs(exact[i] - tabulated[i]));
+	}
+	return diff;
+}
+
+/** Tests whether tabulated outburst and fade waveforms stay within 
+ *	their tolerance
+ *
+ * @see @ref lcmc::models::setShapeTolerance() "setShapeTolerance()"
+ * @see @ref lcmc::models::TabulatedKernel "TabulatedKernel"
+ *
+ * @test SlowPeak, FlarePeak, SlowDip, and FlareDip light curves 
+ *	sampled densely with a tolerance of 1e-4 differ from the exact 
+ *	light curves by no more than 1e-4 times the amplitude, but 
+ *	do differ.
+ * @test A FlarePeak with an amplitude above 1, whose flux jumps at 
+ *	the start of the rise, stays within its tolerance.
+ * @test A light curve with fewer epochs than its table would need 
+ *	is evaluated exactly.
+ * @test setShapeTolerance() throws std::invalid_argument for a 
+ *	negative tolerance or a tolerance of 1, and keeps its old value.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BOOST_AUTO_TEST_CASE(shape_tables)
+{
+	std::vector<double> dense;
+	for(int i = 0; i < 50000; i++) {
+		dense.push_back(0.0137 * i);
+	}
+	const double tol = 1e-4;
+	
+	const double slowPeakDiff = tableError(
+		models::SlowPeak (dense, 0.7, 3.1, 0.2, 0.05), tol);
+	BOOST_CHECK(slowPeakDiff > 0.0 && slowPeakDiff <= tol * 0.7);
+	const double flarePeakDiff = tableError(
+		models::FlarePeak(dense, 2.0, 3.1, 0.2, 0.1, 0.03), tol);
+	BOOST_CHECK(flarePeakDiff > 0.0 && flarePeakDiff <= tol * 2.0);
+	const double slowDipDiff = tableError(
+		models::SlowDip  (dense, 0.7, 3.1, 0.2, 0.2), tol);
+	BOOST_CHECK(slowDipDiff > 0.0 && slowDipDiff <= tol * 0.7);
+	const double flareDipDiff = tableError(
+		models::FlareDip (dense, 0.7, 3.1, 0.2, 0.1, 0.03), tol);
+	BOOST_CHECK(flareDipDiff > 0.0 && flareDipDiff <= tol * 0.7);
+	
+	// A narrow peak needs tens of thousands of nodes
+	BOOST_CHECK_EQUAL(tableError(
+		models::SlowPeak (times, 0.7, 3.1, 0.2, 0.001), tol), 0.0);
+	
+	models::setShapeTolerance(tol);
+	BOOST_CHECK_EQUAL(models::getShapeTolerance(), tol);
+	BOOST_CHECK_THROW(models::setShapeTolerance(-1e-3), std::invalid_argument);
+	BOOST_CHECK_THROW(models::setShapeTolerance( 1.0 ), std::invalid_argument);
+	BOOST_CHECK_EQUAL(models::getShapeTolerance(), tol);
+	models::setShapeTolerance(0.0);
+}
+
+/** Tests whether the embedding interface matches the models it wraps
+ *
+ * @see @ref lcmc::api::simulate() "api::simulate()"
+ * @see @ref lcmc::api::Analysis "api::Analysis"
+ * @see lcmc_simulate()
+ *
+ * @test simulate() and lcmc_simulate() write the same fluxes as a 
+ *	SineWave sampled at the PTF epochs.
+ * @test lcmc_simulate() reports an unknown model instead of throwing.
+ * @test An Analysis of C1 has one value per light curve, equal to the 
+ *	value seen through the C interface.
+ * @test An unknown statistic throws std::invalid_argument, or fails 
+ *	through the C interface.
+ * @test An Analysis of periodograms has one function per light curve, 
+ *	and an index past the last one throws std::out_of_range.
+ */
+BOOST_AUTO_TEST_CASE(embedding)
+{
+	const models::SineWave model(times, 0.5, 2.0, 0.25);
+	std::vector<double> expected;
+	model.getFluxes(expected);
+	
+	models::ParamList params;
+	params.add("a", 0.5);
+	params.add("p", 2.0);
+	params.add("ph", 0.25);
+	std::vector<double> fluxes(times.size());
+	api::simulate("sine", params, &times[0], times.size(), -1, 0, &fluxes[0]);
+	BOOST_CHECK(fluxes == expected);
+	
+	const char* const names[] = {"a", "p", "ph"};
+	const double values[] = {0.5, 2.0, 0.25};
+	std::vector<double> cFluxes(times.size());
+	BOOST_CHECK_EQUAL(lcmc_simulate("sine", names, values, 3, &times[0], 
+		times.size(), -1, 0, &cFluxes[0]), 0);
+	BOOST_CHECK(cFluxes == expected);
+	BOOST_CHECK(lcmc_simulate("no_such_model", names, values, 3, &times[0], 
+		times.size(), -1, 0, &cFluxes[0]) != 0);
+	BOOST_CHECK(std::string(lcmc_last_error()) != "");
+	
+	api::Analysis analysis(std::vector<std::string>(1, "C1"));
+	analysis.add(&times[0], &fluxes[0], times.size());
+	analysis.add(&times[0], &fluxes[0], times.size());
+	BOOST_CHECK_EQUAL(analysis.size(), 2);
+	size_t nC1;
+	const double* c1 = analysis.values("c1", nC1);
+	BOOST_REQUIRE_EQUAL(nC1, 2U);
+	BOOST_CHECK_EQUAL(c1[0], c1[1]);
+	BOOST_CHECK_THROW(analysis.values("no_such_stat", nC1), std::invalid_argument);
+	
+	const char* const stats[] = {"C1"};
+	lcmc_analysis* const cAnalysis = lcmc_analysis_create(stats, 1);
+	BOOST_REQUIRE(cAnalysis != NULL);
+	BOOST_CHECK_EQUAL(lcmc_analysis_add(cAnalysis, &times[0], &fluxes[0], 
+		times.size()), 0);
+	const double* cC1 = NULL;
+	BOOST_CHECK_EQUAL(lcmc_analysis_values(cAnalysis, "c1", &cC1, &nC1), 0);
+	BOOST_REQUIRE_EQUAL(nC1, 1U);
+	BOOST_CHECK_EQUAL(cC1[0], c1[0]);
+	BOOST_CHECK(lcmc_analysis_values(cAnalysis, "no_such_stat", &cC1, &nC1) != 0);
+	lcmc_analysis_free(cAnalysis);
+	
+	api::Analysis pgrams(std::vector<std::string>(1, "periplot"));
+	pgrams.add(&times[0], &fluxes[0], times.size());
+	BOOST_REQUIRE_EQUAL(pgrams.curves("pgram"), 1U);
+	const double* freqs = NULL;
+	const double* powers = NULL;
+	size_t nFreqs = 0;
+	pgrams.curve("pgram", 0, freqs, powers, nFreqs);
+	BOOST_CHECK(nFreqs > 0);
+	BOOST_CHECK(freqs != NULL && powers != NULL);
+	BOOST_CHECK_THROW(pgrams.curve("pgram", 1, freqs, powers, nFreqs), 
+		std::out_of_range);
+	BOOST_CHECK_THROW(pgrams.curves("no_such_stat"), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}		// end lcmc::test
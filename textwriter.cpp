@@ -0,0 +1,560 @@
+/** Buffered output for large text files
+ * @file lightcurveMC/textwriter.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <boost/cstdint.hpp>
+#ifdef LCMC_USE_ZLIB
+#include <zlib.h>
+#endif
+#include "textwriter.h"
+#include "ziparchive.h"
+#include "../common/cerror.h"
+
+namespace lcmc { namespace utils {
+
+using boost::uint64_t;
+using std::string;
+
+/** Size of the blocks handed to the file, in bytes
+ */
+const size_t BLOCK_SIZE = 1 << 20;
+
+/** Formats a number the same way as <tt>sprintf("%*.*f")</tt>
+ *
+ * Typical values are converted directly to decimal digits, avoiding 
+ * the overhead of format parsing. Values that cannot be converted 
+ * exactly this way, such as ties, very large values, and NaNs, are 
+ * passed to sprintf(), so the result is always identical to the 
+ * standard library's.
+ *
+ * @param[in] value The number to format.
+ * @param[in] precision The number of digits after the decimal point.
+ * @param[in] width The minimum number of characters to write. Shorter 
+ *	results are padded with spaces on the left.
+ * @param[out] out The buffer in which to store the text.
+ *
+ * @pre 0 &le; @p precision &le; 9
+ * @pre 0 &le; @p width &lt; 100
+ * @pre @p out has room for at least @ref FIXED_FORMAT_MAX characters.
+ *
+ * @return The number of characters stored in @p out, not counting the 
+ *	terminating null.
+ *
+ * @perform O(@p precision + @p width) for values less than 10<sup>15</sup> 
+ *	in absolute value.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t formatFixed(double value, int precision, int width, char* out) {
+	static const double scale[] = {1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+	static const uint64_t intScale[] = {1u, 10u, 100u, 1000u, 10000u, 100000u, 
+		1000000u, 10000000u, 100000000u, 1000000000u};
+	
+	// Comparisons with NaN are false, so NaNs fall through
+	// Zero is formatted by sprintf to get the sign of -0.0 right
+	const double magnitude = fabs(value);
+	if (precision >= 0 && precision <= 9 && magnitude > 0.0 && magnitude < 1e15) {
+		// Splitting off the integer part is exact, so the only 
+		//	rounding error is from scaling the fraction, which is 
+		//	far less than 1e-6 of a digit
+		const double whole = floor(magnitude);
+		const double digits = (magnitude - whole) * scale[precision];
+		const double kept = floor(digits);
+		const double dropped = digits - kept;
+		
+		if (fabs(dropped - 0.5) > 1e-6) {
+			uint64_t intPart  = static_cast<uint64_t>(whole);
+			uint64_t fracPart = static_cast<uint64_t>(kept) + (dropped > 0.5 ? 1u : 0u);
+			if (fracPart >= intScale[precision]) {
+				fracPart -= intScale[precision];
+				intPart++;
+			}
+			
+			// Build the number backwards
+			char reversed[32];
+			size_t n = 0;
+			for(int i = 0; i < precision; i++) {
+				reversed[n++] = static_cast<char>('0' + fracPart % 10);
+				fracPart /= 10;
+			}
+			if (precision > 0) {
+				reversed[n++] = '.';
+			}
+			do {
+				reversed[n++] = static_cast<char>('0' + intPart % 10);
+				intPart /= 10;
+			} while (intPart > 0);
+			if (value < 0.0) {
+				reversed[n++] = '-';
+			}
+			
+			const size_t padding = (static_cast<size_t>(width) > n 
+				? static_cast<size_t>(width) - n : 0);
+			std::fill(out, out + padding, ' ');
+			std::reverse_copy(reversed, reversed + n, out + padding);
+			out[padding + n] = '\0';
+			return padding + n;
+		}
+	}
+	
+	// assert: FIXED_FORMAT_MAX is enough for any finite double 
+	//	at the allowed precision and width
+	const int length = sprintf(out, "%*.*f", width, precision, value);
+	return (length > 0 ? static_cast<size_t>(length) : 0);
+}
+
+/** GzipStream compresses a sequence of blocks into a gzip file.
+ *
+ * Only TextWriter uses this class, and only when canCompressZip() is true.
+ */
+class GzipStream {
+public:
+	/** Starts a gzip file
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	for the compressor.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	GzipStream() : 
+#ifdef LCMC_USE_ZLIB
+			stream(), 
+#endif
+			out(BLOCK_SIZE/4) {
+#ifdef LCMC_USE_ZLIB
+		stream.zalloc = Z_NULL;
+		stream.zfree  = Z_NULL;
+		stream.opaque = Z_NULL;
+		// 16 more window bits give a gzip header and trailer
+		// Even the fastest level shrinks repetitive tables severalfold, 
+		//	and keeps the compressor from holding up the simulations
+		if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, 
+				Z_DEFAULT_STRATEGY) != Z_OK) {
+			throw std::bad_alloc();
+		}
+#endif
+	}
+	
+	/** Releases the compressor
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	~GzipStream() {
+#ifdef LCMC_USE_ZLIB
+		deflateEnd(&stream);
+#endif
+	}
+	
+	/** Compresses text into a file
+	 *
+	 * @param[in] file The file to write to.
+	 * @param[in] text The text to compress.
+	 * @param[in] length The number of characters in @p text.
+	 * @param[in] finish If set, the gzip file is completed after 
+	 *	@p text. No more text may be written afterward.
+	 *
+	 * @return True if all output was written to @p file, false otherwise.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool write(FILE* file, const char* text, size_t length, bool finish) {
+#ifdef LCMC_USE_ZLIB
+		stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(text));
+		stream.avail_in = static_cast<uInt>(length);
+		int status;
+		do {
+			stream.next_out  = &out[0];
+			stream.avail_out = static_cast<uInt>(out.size());
+			status = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+			if (status == Z_STREAM_ERROR) {
+				return false;
+			}
+			const size_t produced = out.size() - stream.avail_out;
+			if (produced > 0 && fwrite(&out[0], 1, produced, file) != produced) {
+				return false;
+			}
+		} while (stream.avail_out == 0);
+		return !finish || status == Z_STREAM_END;
+#else
+		return !finish && fwrite(text, 1, length, file) == length;
+#endif
+	}
+
+private:
+	// Compressor state cannot be shared
+	GzipStream(const GzipStream&);
+	GzipStream& operator=(const GzipStream&);
+	
+#ifdef LCMC_USE_ZLIB
+	z_stream stream;
+#endif
+	/** Holds compressed data on its way to the file */
+	std::vector<unsigned char> out;
+};
+
+/** Function object that writes a TextWriter's pending block on a 
+ *	background thread
+ */
+class BlockWriter {
+public:
+	/** Prepares to write the pending block of @p writer
+	 *
+	 * @param[in] writer The object whose pending block is to be written.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	explicit BlockWriter(TextWriter& writer) : writer(writer) {
+	}
+	
+	/** Writes the pending block
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void operator()() const {
+		writer.writePending();
+	}
+private:
+	TextWriter& writer;
+};
+
+/** Creates a new text file
+ *
+ * @param[in] fileName The file to create. Any existing file with this 
+ *	name is overwritten.
+ * @param[in] background If set, full blocks of text are written by a 
+ *	background thread while the caller continues adding text.
+ * @param[in] compress If set, the file is written in gzip format. 
+ *	Ignored unless canCompressZip() is true.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could 
+ *	not be opened.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	buffer the file.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+TextWriter::TextWriter(const std::string& fileName, bool background, bool compress) 
+		: fileName(fileName), 
+		file(kpfutils::fileCheckOpen(fileName, compress ? "wb" : "w")), 
+		target(NULL), 
+		gzip(compress && canCompressZip() ? new GzipStream() : NULL), 
+		buffer(BLOCK_SIZE), used(0), 
+		pending(background ? BLOCK_SIZE : 0), pendingSize(0), pendingFailed(false), 
+		background(background), writer() {
+}
+
+/** Prepares to append text to a block of memory
+ *
+ * @param[in,out] target The memory to which text is appended. Must 
+ *	remain valid for the lifetime of the object.
+ *
+ * @post Text passed to the object is appended to @p target, in order, 
+ *	no later than the call to close().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	buffer the text.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+TextWriter::TextWriter(std::vector<char>& target) : fileName(), file(), 
+		target(&target), gzip(), buffer(BLOCK_SIZE), used(0), 
+		pending(), pendingSize(0), pendingFailed(false), 
+		background(false), writer() {
+}
+
+/** Writes any remaining text and closes the file
+ *
+ * Errors are ignored. Call close() first to have them reported.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+TextWriter::~TextWriter() {
+	try {
+		if (writer.get() != NULL) {
+			writer->join();
+		}
+		if (target != NULL && used > 0) {
+			target->insert(target->end(), buffer.begin(), buffer.begin() + used);
+		} else if (file.get() != NULL) {
+			writeBlock(&buffer[0], used);
+			if (gzip.get() != NULL) {
+				gzip->write(file.get(), NULL, 0, true);
+			}
+		}
+	} catch (...) {
+		// Destructors must not throw
+	}
+}
+
+/** Appends raw characters to the file
+ *
+ * @param[in] text The characters to write.
+ * @param[in] length The number of characters in @p text.
+ *
+ * @pre close() has not been called
+ *
+ * @exception kpfutils::except::FileIo Thrown if earlier text could 
+ *	not be written to the file.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void TextWriter::write(const char* text, size_t length) {
+	while (length > 0) {
+		if (used == buffer.size()) {
+			flushBuffer();
+		}
+		const size_t chunk = std::min(length, buffer.size() - used);
+		std::memcpy(&buffer[used], text, chunk);
+		used   += chunk;
+		text   += chunk;
+		length -= chunk;
+	}
+}
+
+/** Appends a string to the file
+ *
+ * @param[in] text A null-terminated string to write.
+ *
+ * @pre close() has not been called
+ *
+ * @exception kpfutils::except::FileIo Thrown if earlier text could 
+ *	not be written to the file.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void TextWriter::write(const char* text) {
+	write(text, std::strlen(text));
+}
+
+/** Appends a string to the file
+ *
+ * @param[in] text The string to write.
+ *
+ * @pre close() has not been called
+ *
+ * @exception kpfutils::except::FileIo Thrown if earlier text could 
+ *	not be written to the file.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void TextWriter::write(const std::string& text) {
+	write(text.data(), text.size());
+}
+
+/** Appends a character to the file
+ *
+ * @param[in] c The character to write.
+ *
+ * @pre close() has not been called
+ *
+ * @exception kpfutils::except::FileIo Thrown if earlier text could 
+ *	not be written to the file.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void TextWriter::write(char c) {
+	if (used == buffer.size()) {
+		flushBuffer();
+	}
+	buffer[used++] = c;
+}
+
+/** Appends a number in fixed-point notation to the file
+ *
+ * @param[in] value The number to write.
+ * @param[in] precision The number of digits after the decimal point.
+ * @param[in] width The minimum number of characters to write. Shorter 
+ *	numbers are padded with spaces on the left.
+ *
+ * @pre 0 &le; @p precision &le; 9
+ * @pre 0 &le; @p width &lt; 100
+ * @pre close() has not been called
+ *
+ * @post The file contains the same text as would have been written by 
+ *	<tt>fprintf("%*.*f", width, precision, value)</tt>.
+ *
+ * @exception kpfutils::except::FileIo Thrown if earlier text could 
+ *	not be written to the file.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void TextWriter::writeFixed(double value, int precision, int width) {
+	// Most numbers are short enough to format in place
+	if (buffer.size() - used >= FIXED_FORMAT_MAX) {
+		used += formatFixed(value, precision, width, &buffer[used]);
+	} else {
+		char text[FIXED_FORMAT_MAX];
+		write(text, formatFixed(value, precision, width, text));
+	}
+}
+
+/** Writes all text to the file and checks for errors
+ *
+ * @pre close() has not been called
+ *
+ * @post The file contains all the text passed to the object, and is 
+ *	closed.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the text could not be 
+ *	written to the file.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void TextWriter::close() {
+	flushBuffer();
+	finishWrite();
+	if (target != NULL) {
+		return;
+	}
+	
+	if ((gzip.get() != NULL && !gzip->write(file.get(), NULL, 0, true)) 
+			|| fflush(file.get()) != 0) {
+		kpfutils::fileError(file.get(), "Could not write to file '" 
+			+ fileName + "': ");
+	}
+	file.reset();
+}
+
+/** Hands the buffer to the file
+ *
+ * @post The buffer is empty.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the text could not be 
+ *	written to the file.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void TextWriter::flushBuffer() {
+	// Only one block may be in flight at a time
+	finishWrite();
+	
+	if (used == 0) {
+		return;
+	}
+	if (target != NULL) {
+		// insert() is atomic for a single range, so nothing is lost 
+		//	if it runs out of memory
+		target->insert(target->end(), buffer.begin(), buffer.begin() + used);
+		used = 0;
+		return;
+	}
+	if (!background) {
+		const size_t length = used;
+		used = 0;
+		if (!writeBlock(&buffer[0], length)) {
+			kpfutils::fileError(file.get(), "Could not write to file '" 
+				+ fileName + "': ");
+		}
+		return;
+	}
+	
+	// Both blocks have the same size, so swapping them is all it 
+	//	takes to start a new block
+	pending.swap(buffer);
+	pendingSize = used;
+	used = 0;
+	try {
+		writer.reset(new boost::thread(BlockWriter(*this)));
+	} catch (const boost::thread_resource_error& e) {
+		// Write in the foreground instead
+		writePending();
+		finishWrite();
+	}
+}
+
+/** Waits for the background thread to finish writing
+ *
+ * @post No text is being written to the file.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the last block handed 
+ *	to the file could not be written.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void TextWriter::finishWrite() {
+	if (writer.get() != NULL) {
+		writer->join();
+		writer.reset();
+	}
+	if (pendingFailed) {
+		pendingFailed = false;
+		kpfutils::fileError(file.get(), "Could not write to file '" 
+			+ fileName + "': ");
+	}
+}
+
+/** Writes the pending block to the file
+ *
+ * @post pendingFailed is set if the block could not be written.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Called from the background thread, if there is one. It must 
+ *	not touch any member other than file, gzip, and the pending block.
+ */
+void TextWriter::writePending() {
+	if (pendingSize > 0 && !writeBlock(&pending[0], pendingSize)) {
+		pendingFailed = true;
+	}
+	pendingSize = 0;
+}
+
+/** Passes text to the file, compressing it if needed
+ *
+ * @param[in] text The text to write.
+ * @param[in] length The number of characters in @p text.
+ *
+ * @return True if the text was written, false otherwise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ *
+ * @note Called from the background thread, if there is one.
+ */
+bool TextWriter::writeBlock(const char* text, size_t length) {
+	if (gzip.get() != NULL) {
+		return gzip->write(file.get(), text, length, false);
+	} else {
+		return length == 0 || fwrite(text, 1, length, file.get()) == length;
+	}
+}
+
+}}		// end lcmc::utils
@@ -0,0 +1,156 @@
+/** Buffered output for large text files
+ * @file lightcurveMC/textwriter.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCTEXTWRITERH
+#define LCMCTEXTWRITERH
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <boost/smart_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace lcmc { namespace utils {
+
+class GzipStream;
+
+/** The largest number of characters written by formatFixed(), 
+ *	including the terminating null
+ */
+const size_t FIXED_FORMAT_MAX = 512;
+
+/** Formats a number the same way as <tt>sprintf("%*.*f")</tt>
+ */
+size_t formatFixed(double value, int precision, int width, char* out);
+
+/** TextWriter writes a text file through a large buffer.
+ *
+ * Text is collected in memory and handed to the file one block at a 
+ * time, so a file with many short lines costs only a few system calls 
+ * and a single error check per block. Optionally, each full block is 
+ * written by a background thread while the next one is being filled.
+ *
+ * Errors are reported by the method that hands a block to the file, 
+ * which may be a later call than the one that supplied the text.
+ *
+ * A TextWriter may also collect its text in memory, so that code that 
+ * formats a file need not know where the file is going.
+ *
+ * Files may be written in gzip format. The text is then compressed 
+ * one block at a time, on the background thread if there is one.
+ */
+class TextWriter {
+public:
+	/** Creates a new text file
+	 */
+	explicit TextWriter(const std::string& fileName, bool background = false, 
+			bool compress = false);
+	
+	/** Prepares to append text to a block of memory
+	 */
+	explicit TextWriter(std::vector<char>& target);
+	
+	/** Writes any remaining text and closes the file
+	 */
+	~TextWriter();
+	
+	/** Appends a string to the file
+	 */
+	void write(const char* text);
+	
+	/** Appends a string to the file
+	 */
+	void write(const std::string& text);
+	
+	/** Appends a character to the file
+	 */
+	void write(char c);
+	
+	/** Appends a number in fixed-point notation to the file
+	 */
+	void writeFixed(double value, int precision, int width = 0);
+	
+	/** Writes all text to the file and checks for errors
+	 */
+	void close();
+
+private:
+	// Writers own their files
+	TextWriter(const TextWriter&);
+	TextWriter& operator=(const TextWriter&);
+	
+	// The background thread writes pending on the writer's behalf
+	friend class BlockWriter;
+	
+	/** Appends raw characters to the file
+	 */
+	void write(const char* text, size_t length);
+	
+	/** Hands the buffer to the file
+	 */
+	void flushBuffer();
+	
+	/** Waits for the background thread to finish writing
+	 */
+	void finishWrite();
+	
+	/** Writes the pending block to the file
+	 */
+	void writePending();
+	
+	/** Passes text to the file, compressing it if needed
+	 */
+	bool writeBlock(const char* text, size_t length);
+	
+	std::string fileName;
+	boost::shared_ptr<FILE> file;
+	/** The memory receiving the text, or null if writing to a file */
+	std::vector<char>* target;
+	/** Compresses text before it reaches the file, or null if the 
+	 *	file is not compressed */
+	boost::scoped_ptr<GzipStream> gzip;
+	
+	/** Text not yet handed to the file */
+	std::vector<char> buffer;
+	size_t used;
+	
+	/** Text being written by the background thread */
+	std::vector<char> pending;
+	size_t pendingSize;
+	bool pendingFailed;
+	
+	bool background;
+	boost::scoped_ptr<boost::thread> writer;
+};
+
+}}		// end lcmc::utils
+
+#endif		// end LCMCTEXTWRITERH
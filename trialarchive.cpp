@@ -0,0 +1,496 @@
+/** Archives of simulated light curves, for analysis by later runs
+ * @file lightcurveMC/trialarchive.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include "cadence.h"
+#include "paramlist.h"
+#include "trialarchive.h"
+#include "../common/cerror.h"
+#include "../common/fileio.h"
+
+namespace lcmc {
+
+using boost::uint32_t;
+using boost::uint64_t;
+using boost::lexical_cast;
+using std::string;
+using std::vector;
+
+/** Identifies a trial archive, and the version of its format */
+const char TRIAL_MAGIC[8] = {'L', 'C', 'M', 'C', 'T', 'R', 'L', '1'};
+
+/** Record starting the trials of a bin */
+const char RECORD_BIN     = 'B';
+/** Record holding the times of a cadence */
+const char RECORD_CADENCE = 'C';
+/** Record holding one simulated light curve */
+const char RECORD_TRIAL   = 'T';
+/** Record ending the archive */
+const char RECORD_END     = 'E';
+
+/** Writes raw data to an archive
+ *
+ * @param[in] file The archive to write to.
+ * @param[in] data The data to write.
+ * @param[in] size The number of bytes to write.
+ * @param[in] fileName The name of @p file, for error messages.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the data could not 
+ *	be written.
+ *
+ * @exceptsafe The program is in a consistent state in the event of 
+ *	an exception.
+ */
+void writeRaw(FILE* const file, const void* data, size_t size, 
+		const string& fileName) {
+	if (size > 0 && fwrite(data, size, 1, file) != 1) {
+		kpfutils::fileError(file, "Could not write trial archive " 
+			+ fileName + ": ");
+	}
+}
+
+/** Reads raw data from an archive
+ *
+ * @param[in] file The archive to read from.
+ * @param[out] data The buffer to fill.
+ * @param[in] size The number of bytes to read.
+ * @param[in] fileName The name of @p file, for error messages.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the data could not 
+ *	be read.
+ *
+ * @exceptsafe The program is in a consistent state in the event of 
+ *	an exception.
+ */
+void readRaw(FILE* const file, void* data, size_t size, 
+		const string& fileName) {
+	if (size > 0 && fread(data, size, 1, file) != 1) {
+		throw kpfutils::except::FileIo("Trial archive " + fileName 
+			+ " is truncated or misformatted.");
+	}
+}
+
+/** Writes a length-prefixed string to an archive
+ *
+ * @param[in] file The archive to write to.
+ * @param[in] text The string to write.
+ * @param[in] fileName The name of @p file, for error messages.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the string could not 
+ *	be written.
+ *
+ * @exceptsafe The program is in a consistent state in the event of 
+ *	an exception.
+ */
+void writeString(FILE* const file, const string& text, const string& fileName) {
+	const uint32_t length = static_cast<uint32_t>(text.size());
+	writeRaw(file, &length, sizeof(length), fileName);
+	writeRaw(file, text.data(), text.size(), fileName);
+}
+
+/** Reads a string written by writeString()
+ *
+ * @param[in] file The archive to read from.
+ * @param[in] fileName The name of @p file, for error messages.
+ *
+ * @return The string.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the string could not 
+ *	be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the string.
+ *
+ * @exceptsafe The program is in a consistent state in the event of 
+ *	an exception.
+ */
+string readString(FILE* const file, const string& fileName) {
+	uint32_t length;
+	readRaw(file, &length, sizeof(length), fileName);
+	vector<char> text(length + 1, '\0');
+	readRaw(file, &text[0], length, fileName);
+	return string(&text[0], length);
+}
+
+/** Creates an empty archive
+ *
+ * @param[in] fileName The file in which to save the light curves. Any 
+ *	existing file is replaced.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be created.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+TrialWriter::TrialWriter(const string& fileName) : fileName(fileName), 
+		file(kpfutils::fileCheckOpen(fileName, "wb")), params(), cadences() {
+	writeRaw(file.get(), TRIAL_MAGIC, sizeof(TRIAL_MAGIC), fileName);
+}
+
+/** Starts the trials of a new bin
+ *
+ * @param[in] label A name that identifies the bin, such as 
+ *	stats::LcBinStats::makeFileName().
+ * @param[in] limits The parameter ranges of the bin. Every trial of 
+ *	the bin has a value for each of these parameters.
+ *
+ * @post Later calls to write() are saved as trials of this bin.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the bin could not be 
+ *	recorded.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the parameter list.
+ *
+ * @exceptsafe The archive is unusable in the event of an exception.
+ */
+void TrialWriter::startBin(const string& label, const models::RangeList& limits) {
+	vector<models::ParamId> temp;
+	for(models::RangeList::const_iterator it = limits.begin(); 
+			it != limits.end(); it++) {
+		temp.push_back(it.getId());
+	}
+	
+	writeRaw(file.get(), &RECORD_BIN, 1, fileName);
+	writeString(file.get(), label, fileName);
+	const uint32_t nParams = static_cast<uint32_t>(temp.size());
+	writeRaw(file.get(), &nParams, sizeof(nParams), fileName);
+	for(vector<models::ParamId>::const_iterator it = temp.begin(); 
+			it != temp.end(); it++) {
+		writeString(file.get(), models::paramName(*it), fileName);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	params.swap(temp);
+}
+
+/** Saves one simulated light curve
+ *
+ * @param[in] trial The index of the trial within the current bin.
+ * @param[in] lc The light curve, after its fluxes have been computed.
+ *
+ * @pre startBin() has been called.
+ * @pre @p lc has a value for every parameter of the current bin.
+ *
+ * @post The cadence of @p lc is written before its first trial, and 
+ *	referred to by later trials.
+ *
+ * @perform O(N) time, where N is the number of fluxes in @p lc, plus 
+ *	O(N) for the first trial on each cadence.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the trial could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	remember the cadence.
+ *
+ * @exceptsafe The archive is unusable in the event of an exception.
+ */
+void TrialWriter::write(long trial, const SimTrial& lc) {
+	std::map<uint64_t, uint64_t>::const_iterator cadence = 
+		cadences.find(lc.times.getHash());
+	if (cadence == cadences.end()) {
+		const vector<double>& times = lc.times.timeView();
+		const uint64_t nTimes = times.size();
+		writeRaw(file.get(), &RECORD_CADENCE, 1, fileName);
+		writeRaw(file.get(), &nTimes, sizeof(nTimes), fileName);
+		writeRaw(file.get(), times.empty() ? NULL : &times[0], 
+			times.size()*sizeof(double), fileName);
+		const uint64_t id = cadences.size();
+		cadence = cadences.insert(std::make_pair(lc.times.getHash(), id)).first;
+	}
+	
+	const uint64_t index  = static_cast<uint64_t>(trial);
+	const uint32_t units  = static_cast<uint32_t>(lc.units);
+	const uint64_t nFluxes = lc.fluxes.size();
+	writeRaw(file.get(), &RECORD_TRIAL, 1, fileName);
+	writeRaw(file.get(), &index, sizeof(index), fileName);
+	writeRaw(file.get(), &cadence->second, sizeof(cadence->second), fileName);
+	writeRaw(file.get(), &units, sizeof(units), fileName);
+	for(vector<models::ParamId>::const_iterator it = params.begin(); 
+			it != params.end(); it++) {
+		const double value = lc.params.get(*it);
+		writeRaw(file.get(), &value, sizeof(value), fileName);
+	}
+	writeRaw(file.get(), &nFluxes, sizeof(nFluxes), fileName);
+	writeRaw(file.get(), lc.fluxes.empty() ? NULL : &lc.fluxes[0], 
+		lc.fluxes.size()*sizeof(double), fileName);
+}
+
+/** Finishes the archive
+ *
+ * @post The archive is complete, and written to disk. No more trials 
+ *	may be written.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the archive could not 
+ *	be written.
+ *
+ * @exceptsafe The archive is unusable in the event of an exception.
+ */
+void TrialWriter::close() {
+	writeRaw(file.get(), &RECORD_END, 1, fileName);
+	if (fflush(file.get()) != 0) {
+		kpfutils::fileError(file.get(), "Could not write trial archive " 
+			+ fileName + ": ");
+	}
+	file.reset();
+}
+
+/** Opens an archive
+ *
+ * @param[in] fileName A file written by a TrialWriter.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be opened, or is not a trial archive.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+TrialReader::TrialReader(const string& fileName) : fileName(fileName), 
+		file(kpfutils::fileCheckOpen(fileName, "rb")), params(), cadences(), 
+		pending('\0') {
+	char magic[sizeof(TRIAL_MAGIC)];
+	if (fread(magic, sizeof(magic), 1, file.get()) != 1 
+			|| !std::equal(TRIAL_MAGIC, TRIAL_MAGIC + sizeof(TRIAL_MAGIC), magic)) {
+		throw kpfutils::except::FileIo(fileName + " is not a trial archive.");
+	}
+}
+
+/** Reads the type of the next record
+ *
+ * @return The type of the record following any record already 
+ *	examined, or @ref RECORD_END "RECORD_END" at the end of the file.
+ *
+ * @post The file is positioned at the contents of the record.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the file could not 
+ *	be read.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+char TrialReader::nextRecord() {
+	if (pending != '\0') {
+		const char type = pending;
+		pending = '\0';
+		return type;
+	}
+	
+	const int type = fgetc(file.get());
+	if (type == EOF) {
+		if (ferror(file.get())) {
+			throw kpfutils::except::FileIo("Could not read trial archive " 
+				+ fileName + ".");
+		}
+		return RECORD_END;
+	}
+	return static_cast<char>(type);
+}
+
+/** Reads a cadence record
+ *
+ * @pre The file is positioned at the contents of a cadence record.
+ *
+ * @post The cadence is available to later trials.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the cadence could 
+ *	not be read.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the cadence.
+ *
+ * @exceptsafe The archive is unusable in the event of an exception.
+ */
+void TrialReader::readCadence() {
+	uint64_t nTimes;
+	readRaw(file.get(), &nTimes, sizeof(nTimes), fileName);
+	vector<double> times(static_cast<size_t>(nTimes));
+	readRaw(file.get(), times.empty() ? NULL : &times[0], 
+		times.size()*sizeof(double), fileName);
+	cadences.push_back(models::Cadence(times));
+}
+
+/** Moves to the trials of a bin
+ *
+ * Any unread trials of the previous bin are skipped.
+ *
+ * @param[in] label The name given to TrialWriter::startBin() for the 
+ *	bin.
+ * @param[in] limits The parameter ranges of the bin.
+ *
+ * @post Later calls to read() return trials of this bin.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the next bin in the 
+ *	archive is not @p label, or has different parameters.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the archive.
+ *
+ * @exceptsafe The archive is unusable in the event of an exception.
+ */
+void TrialReader::startBin(const string& label, const models::RangeList& limits) {
+	char type;
+	while ((type = nextRecord()) != RECORD_BIN) {
+		if (type == RECORD_CADENCE) {
+			// Later bins may refer to the cadence
+			readCadence();
+		} else if (type == RECORD_TRIAL) {
+			SimTrial skipped;
+			pending = RECORD_TRIAL;
+			read(-1, skipped);
+		} else {
+			throw kpfutils::except::FileIo("Trial archive " + fileName 
+				+ " has no bin " + label + ".");
+		}
+	}
+	
+	const string archived = readString(file.get(), fileName);
+	if (archived != label) {
+		throw kpfutils::except::FileIo("Trial archive " + fileName 
+			+ " has bin " + archived + " where " + label 
+			+ " was expected; was it written with the same options?");
+	}
+	uint32_t nParams;
+	readRaw(file.get(), &nParams, sizeof(nParams), fileName);
+	vector<models::ParamId> temp;
+	for(uint32_t i = 0; i < nParams; i++) {
+		const string name = readString(file.get(), fileName);
+		models::ParamId id;
+		if (!models::findParamId(name, id)) {
+			throw kpfutils::except::FileIo("Trial archive " + fileName 
+				+ " uses unknown parameter " + name + ".");
+		}
+		temp.push_back(id);
+	}
+	for(models::RangeList::const_iterator it = limits.begin(); 
+			it != limits.end(); it++) {
+		if (std::find(temp.begin(), temp.end(), it.getId()) == temp.end()) {
+			throw kpfutils::except::FileIo("Trial archive " + fileName 
+				+ " has no values of " + models::paramName(it.getId()) 
+				+ " for bin " + label + ".");
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	params.swap(temp);
+}
+
+/** Restores one simulated light curve
+ *
+ * Trials of the current bin before @p trial are skipped, so a run 
+ * may replay only the end of a bin.
+ *
+ * @param[in] trial The index of the trial within the current bin, or 
+ *	a negative number to read whichever trial comes next.
+ * @param[out] lc The light curve, with its fluxes computed.
+ *
+ * @pre startBin() has been called.
+ *
+ * @post @p lc has the cadence, parameters, units, and fluxes saved by 
+ *	TrialWriter::write(). Trials on the same cadence share one copy 
+ *	of the times.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the current bin of 
+ *	the archive has no trial @p trial.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	read the trial.
+ *
+ * @exceptsafe The archive is unusable in the event of an exception. 
+ *	@p lc is in a valid state.
+ */
+void TrialReader::read(long trial, SimTrial& lc) {
+	for(;;) {
+		const char type = nextRecord();
+		if (type == RECORD_CADENCE) {
+			readCadence();
+			continue;
+		} else if (type != RECORD_TRIAL) {
+			pending = (type == RECORD_END ? '\0' : type);
+			throw kpfutils::except::FileIo("Trial archive " + fileName 
+				+ " has no trial " + lexical_cast<string>(trial) 
+				+ " in the current bin.");
+		}
+		
+		uint64_t index, cadence, nFluxes;
+		uint32_t units;
+		readRaw(file.get(), &index, sizeof(index), fileName);
+		readRaw(file.get(), &cadence, sizeof(cadence), fileName);
+		readRaw(file.get(), &units, sizeof(units), fileName);
+		if (cadence >= cadences.size() 
+				|| (units != utils::FLUX_UNITS && units != utils::MAG_UNITS)) {
+			throw kpfutils::except::FileIo("Trial archive " + fileName 
+				+ " is misformatted.");
+		}
+		models::ParamList values;
+		for(vector<models::ParamId>::const_iterator it = params.begin(); 
+				it != params.end(); it++) {
+			double value;
+			readRaw(file.get(), &value, sizeof(value), fileName);
+			values.add(*it, value);
+		}
+		readRaw(file.get(), &nFluxes, sizeof(nFluxes), fileName);
+		
+		if (trial >= 0 && index < static_cast<uint64_t>(trial)) {
+			// Skip over the fluxes
+			if (fseek(file.get(), static_cast<long>(nFluxes*sizeof(double)), 
+					SEEK_CUR) != 0) {
+				throw kpfutils::except::FileIo("Trial archive " + fileName 
+					+ " is truncated or misformatted.");
+			}
+			continue;
+		} else if (trial >= 0 && index > static_cast<uint64_t>(trial)) {
+			throw kpfutils::except::FileIo("Trial archive " + fileName 
+				+ " has no trial " + lexical_cast<string>(trial) 
+				+ " in the current bin.");
+		}
+		
+		vector<double> fluxes(static_cast<size_t>(nFluxes));
+		readRaw(file.get(), fluxes.empty() ? NULL : &fluxes[0], 
+			fluxes.size()*sizeof(double), fileName);
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		lc.times = cadences[static_cast<size_t>(cadence)];
+		lc.fluxes.swap(fluxes);
+		lc.params = values;
+		lc.model.reset();
+		vector<double>().swap(lc.noise);
+		lc.base.reset();
+		lc.units = static_cast<utils::PhotUnits>(units);
+		return;
+	}
+}
+
+}		// end lcmc
@@ -0,0 +1,127 @@
+/** Archives of simulated light curves, for analysis by later runs
+ * @file lightcurveMC/trialarchive.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCTRIALARCHIVEH
+#define LCMCTRIALARCHIVEH
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include "cadence.h"
+#include "paramlist.h"
+#include "trialpool.h"
+
+namespace lcmc {
+
+/** TrialWriter saves every simulated light curve of a run, so that 
+ * later runs can calculate new statistics without simulating the 
+ * light curves again.
+ *
+ * The archive holds, for each bin, the parameters, units, and fluxes 
+ * of each trial. Each distinct cadence is stored once, and referred 
+ * to by the trials that use it.
+ */
+class TrialWriter {
+public:
+	/** Creates an empty archive
+	 */
+	explicit TrialWriter(const std::string& fileName);
+	
+	/** Starts the trials of a new bin
+	 */
+	void startBin(const std::string& label, const models::RangeList& limits);
+	
+	/** Saves one simulated light curve
+	 */
+	void write(long trial, const SimTrial& lc);
+	
+	/** Finishes the archive
+	 */
+	void close();
+	
+private:
+	// Archives have a single owner
+	TrialWriter(const TrialWriter&);
+	TrialWriter& operator=(const TrialWriter&);
+	
+	std::string fileName;
+	boost::shared_ptr<FILE> file;
+	/** The parameters of the current bin, in archive order */
+	std::vector<models::ParamId> params;
+	/** The index of each cadence already written, keyed by its hash */
+	std::map<boost::uint64_t, boost::uint64_t> cadences;
+};
+
+/** TrialReader replays the light curves saved by a TrialWriter, in 
+ * the order in which they were saved.
+ */
+class TrialReader {
+public:
+	/** Opens an archive
+	 */
+	explicit TrialReader(const std::string& fileName);
+	
+	/** Moves to the trials of a bin
+	 */
+	void startBin(const std::string& label, const models::RangeList& limits);
+	
+	/** Restores one simulated light curve
+	 */
+	void read(long trial, SimTrial& lc);
+	
+private:
+	// Archives have a single owner
+	TrialReader(const TrialReader&);
+	TrialReader& operator=(const TrialReader&);
+	
+	/** Reads the type of the next record
+	 */
+	char nextRecord();
+	
+	/** Reads a cadence record
+	 */
+	void readCadence();
+	
+	std::string fileName;
+	boost::shared_ptr<FILE> file;
+	/** The parameters of the current bin, in archive order */
+	std::vector<models::ParamId> params;
+	/** Every cadence read so far, in archive order */
+	std::vector<models::Cadence> cadences;
+	/** A record type read but not yet processed, or 0 if none */
+	char pending;
+};
+
+}		// end lcmc
+
+#endif		// end LCMCTRIALARCHIVEH
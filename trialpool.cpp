@@ -0,0 +1,981 @@
+/** Functions for analyzing simulated light curves in parallel
+ * @file lightcurveMC/trialpool.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <boost/function.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "binstats.h"
+#include "numa.h"
+#include "trialpool.h"
+#include "stats/profile.h"
+#include "stats/trace.h"
+#include "../common/cerror.h"
+
+namespace lcmc {
+
+using std::string;
+using std::vector;
+using boost::shared_ptr;
+using stats::LcBinStats;
+
+/** Records whether an analysis thread terminated abnormally.
+ *
+ * Exceptions cannot propagate from one thread to another, so each
+ * thread stores a description of any error it encounters for the
+ * calling thread to report.
+ */
+class WorkerStatus {
+public:
+	/** Creates a record for a thread that has not failed.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	WorkerStatus() : failed(false), bug(false), message() {
+	}
+
+	/** Records an error.
+	 *
+	 * @param[in] what A description of the error.
+	 * @param[in] isBug If true, the error represents a bug in the program.
+	 *
+	 * @post rethrow() will throw an exception describing the error.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void fail(const char* what, bool isBug) {
+		failed = true;
+		bug    = isBug;
+		try {
+			message = what;
+		} catch (...) {
+			// Report the error without the description
+			message.clear();
+		}
+	}
+
+	/** Tests whether an error has been recorded.
+	 *
+	 * @return True if fail() has been called.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool hasFailed() const {
+		return failed;
+	}
+
+	/** Throws an exception equivalent to the one that terminated the thread.
+	 *
+	 * @post Does nothing if the thread did not fail.
+	 *
+	 * @exception std::logic_error Thrown if the thread failed because
+	 *	of a bug.
+	 * @exception std::runtime_error Thrown if the thread failed for
+	 *	any other reason.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception.
+	 */
+	void rethrow() const {
+		if (failed) {
+			if (bug) {
+				throw std::logic_error(message);
+			} else {
+				throw std::runtime_error(message);
+			}
+		}
+	}
+
+private:
+	bool failed;
+	bool bug;
+	string message;
+};
+
+/** Function object that runs one block of a job on its own thread.
+ */
+class BlockWorker {
+public:
+	/** Prepares to run a block of a job.
+	 *
+	 * @param[in] task The function that processes the block.
+	 * @param[in] worker The index of this worker.
+	 * @param[in] nWorkers The number of workers sharing the job.
+	 * @param[in] first, last The range of item indices to process.
+	 * @param[out] status The object in which to report any errors.
+	 *	No other thread may access @p status until the block
+	 *	is complete.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	BlockWorker(const BlockTask& task, size_t worker, size_t nWorkers, 
+			size_t first, size_t last, WorkerStatus& status)
+			: task(task), worker(worker), nWorkers(nWorkers), first(first), 
+			last(last), status(status) {
+	}
+
+	/** Processes the block.
+	 *
+	 * @post <tt>task(worker, first, last)</tt> has been called.
+	 * @post If an error occurred, @p status contains a description.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void operator()() {
+		utils::pinWorker(worker, nWorkers);
+		try {
+			task(worker, first, last);
+		} catch (const std::logic_error& e) {
+			status.fail(e.what(), true);
+		} catch (const std::exception& e) {
+			status.fail(e.what(), false);
+		} catch (...) {
+			status.fail("Unknown exception in analysis thread.", true);
+		}
+	}
+
+private:
+	const BlockTask& task;
+	size_t worker;
+	size_t nWorkers;
+	size_t first;
+	size_t last;
+	WorkerStatus& status;
+};
+
+/** The chunks of a job that no worker has claimed, out of one 
+ *	worker's share.
+ *
+ * The owner claims chunks from the front of its share and other 
+ * workers steal them from the back, so the two rarely contend for 
+ * the same chunk.
+ */
+class ChunkQueue {
+public:
+	/** Creates a share of a job.
+	 *
+	 * @param[in] first, last The range of chunk indices in the share.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	ChunkQueue(size_t first, size_t last) : lock(), next(first), end(last) {
+	}
+
+	/** Claims the earliest unclaimed chunk, for use by the owner.
+	 *
+	 * @param[out] chunk The index of the claimed chunk.
+	 *
+	 * @return True if a chunk was claimed, false if the share is empty.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool takeFront(size_t& chunk) {
+		boost::mutex::scoped_lock guard(lock);
+		if (next >= end) {
+			return false;
+		}
+		chunk = next++;
+		return true;
+	}
+
+	/** Claims the latest unclaimed chunk, for use by other workers.
+	 *
+	 * @param[out] chunk The index of the claimed chunk.
+	 *
+	 * @return True if a chunk was claimed, false if the share is empty.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool takeBack(size_t& chunk) {
+		boost::mutex::scoped_lock guard(lock);
+		if (next >= end) {
+			return false;
+		}
+		chunk = --end;
+		return true;
+	}
+
+private:
+	// Queues are shared by the workers, not copied
+	ChunkQueue(const ChunkQueue&);
+	ChunkQueue& operator=(const ChunkQueue&);
+
+	boost::mutex lock;
+	size_t next;
+	size_t end;
+};
+
+/** Function object that runs chunks of a job on its own thread until 
+ *	no chunks are left.
+ */
+class ChunkWorker {
+public:
+	/** Prepares to run chunks of a job.
+	 *
+	 * @param[in] task The function that processes each chunk.
+	 * @param[in] worker The index of this worker.
+	 * @param[in] nItems The number of items in the job.
+	 * @param[in] chunkSize The number of items in each chunk but the last.
+	 * @param[in,out] queues The unclaimed chunks of every worker.
+	 * @param[out] status The objects in which to report any errors, 
+	 *	one per chunk. No other thread may access an element of 
+	 *	@p status while its chunk is being processed.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	ChunkWorker(const BlockTask& task, size_t worker, size_t nItems, 
+			size_t chunkSize, const vector<shared_ptr<ChunkQueue> >& queues, 
+			vector<WorkerStatus>& status)
+			: task(task), worker(worker), nItems(nItems), 
+			chunkSize(chunkSize), queues(queues), status(status) {
+	}
+
+	/** Processes chunks until every chunk of the job has been claimed.
+	 *
+	 * @post <tt>task(chunk, first, last)</tt> has been called for 
+	 *	every chunk claimed by this worker.
+	 * @post If an error occurred, the chunk's element of @p status 
+	 *	contains a description.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void operator()() {
+		utils::pinWorker(worker, queues.size());
+		size_t chunk;
+		while (claim(chunk)) {
+			const size_t first = chunk * chunkSize;
+			const size_t last  = std::min(nItems, first + chunkSize);
+			try {
+				task(chunk, first, last);
+			} catch (const std::logic_error& e) {
+				status[chunk].fail(e.what(), true);
+			} catch (const std::exception& e) {
+				status[chunk].fail(e.what(), false);
+			} catch (...) {
+				status[chunk].fail("Unknown exception in analysis thread.", true);
+			}
+		}
+	}
+
+private:
+	/** Claims the next chunk to process, stealing from other workers 
+	 *	once this worker's share is done.
+	 *
+	 * @param[out] chunk The index of the claimed chunk.
+	 *
+	 * @return True if a chunk was claimed, false if no chunks are left.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	bool claim(size_t& chunk) const {
+		if (queues[worker]->takeFront(chunk)) {
+			return true;
+		}
+		for(size_t i = 1; i < queues.size(); i++) {
+			if (queues[(worker + i) % queues.size()]->takeBack(chunk)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const BlockTask& task;
+	size_t worker;
+	size_t nItems;
+	size_t chunkSize;
+	const vector<shared_ptr<ChunkQueue> >& queues;
+	vector<WorkerStatus>& status;
+};
+
+/** Function object that analyzes blocks of light curves, recording 
+ *	each block in its own private collection.
+ */
+class TrialAnalyzer {
+public:
+	/** Prepares to analyze light curves.
+	 *
+	 * @param[in] trials The light curves to analyze.
+	 * @param[in,out] blockBins The objects in which to record the 
+	 *	analysis, one per block.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	TrialAnalyzer(const vector<SimTrial>& trials, vector<LcBinStats>& blockBins)
+			: trials(trials), blockBins(blockBins) {
+	}
+
+	/** Analyzes each light curve in a block, in order.
+	 *
+	 * @param[in] block The index of the block.
+	 * @param[in] first, last The range of indices in @p trials to analyze.
+	 *
+	 * @post <tt>blockBins[block]</tt> contains the statistics for
+	 *	<tt>trials[first, last)</tt>, in order.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	store more statistics.
+	 * @exception std::logic_error Thrown if a bug was encountered.
+	 * @exception std::exception Thrown if a light curve could not be 
+	 *	analyzed.
+	 *
+	 * @exceptsafe <tt>blockBins[block]</tt> is in a valid state in the 
+	 *	event of an exception.
+	 */
+	void operator()(size_t block, size_t first, size_t last) const {
+		blockBins[block].analyzeLightCurves(trials, first, last);
+	}
+
+private:
+	const vector<SimTrial>& trials;
+	vector<LcBinStats>& blockBins;
+};
+
+/** Divides a job into contiguous blocks and processes each block on 
+ *	its own thread.
+ *
+ * Item indices are divided as evenly as possible among the workers, 
+ * with worker @p i processing a block that precedes the block of 
+ * worker @p i+1. Since each block is a fixed function of @p nItems and 
+ * @p nWorkers, a task that writes only to storage indexed by item or by 
+ * worker produces the same results however the threads are scheduled.
+ *
+ * @param[in] nItems The number of items in the job.
+ * @param[in] nWorkers The number of threads to use. If @p nWorkers &le; 1, 
+ *	the entire job is processed on the calling thread as a single 
+ *	block.
+ * @param[in] task The function that processes each block. It is called 
+ *	once per worker, with the worker's index and block.
+ *
+ * @pre @p task may be safely called from several threads at once, as 
+ *	long as the blocks are different
+ * @pre @p nWorkers &le; @p nItems
+ *
+ * @post @p task has been called for every block.
+ *
+ * @exception std::runtime_error Thrown if @p task failed on any 
+ *	worker thread, or if the threads could not be started.
+ * @exception std::logic_error Thrown if @p task encountered a bug on 
+ *	any worker thread.
+ * @exception std::exception Any exception thrown by @p task is 
+ *	propagated unchanged if @p nWorkers &le; 1.
+ *
+ * @exceptsafe All worker threads have finished in the event of an 
+ *	exception.
+ */
+void runBlocks(size_t nItems, size_t nWorkers, const BlockTask& task) {
+	if (nWorkers <= 1) {
+		task(0, 0, nItems);
+		return;
+	}
+
+	vector<WorkerStatus> status(nWorkers);
+
+	boost::thread_group pool;
+	try {
+		for(size_t i = 0; i < nWorkers; i++) {
+			const size_t first = ( i    * nItems) / nWorkers;
+			const size_t last  = ((i+1) * nItems) / nWorkers;
+			pool.create_thread(BlockWorker(task, i, nWorkers, first, last, 
+				status[i]));
+		}
+	} catch (...) {
+		// Don't leave threads writing to status after it's destroyed
+		pool.join_all();
+		throw;
+	}
+	pool.join_all();
+
+	// Report the error from the earliest block, as in a serial run
+	for(vector<WorkerStatus>::const_iterator it = status.begin();
+			it != status.end(); it++) {
+		it->rethrow();
+	}
+}
+
+/** Divides a job into small chunks and lets a pool of threads claim 
+ *	them as they become free.
+ *
+ * Each worker starts with a contiguous share of the chunks. A worker 
+ * that finishes its share steals the remaining chunks of the others, 
+ * latest first, so that a few expensive items do not leave the other 
+ * threads idle. Since each chunk is a fixed function of @p nItems and 
+ * @p chunkSize, a task that writes only to storage indexed by item or 
+ * by chunk produces the same results however the chunks are claimed.
+ *
+ * @param[in] nItems The number of items in the job.
+ * @param[in] chunkSize The number of items in each chunk. The last 
+ *	chunk may be shorter.
+ * @param[in] nWorkers The number of threads to use. If @p nWorkers &le; 1, 
+ *	the chunks are processed in order on the calling thread.
+ * @param[in] task The function that processes each chunk. It is called 
+ *	once per chunk, with the chunk's index and range of items.
+ *
+ * @pre @p task may be safely called from several threads at once, as 
+ *	long as the chunks are different
+ * @pre @p chunkSize &ge; 1
+ *
+ * @post @p task has been called for every chunk.
+ *
+ * @exception std::runtime_error Thrown if @p task failed on any 
+ *	chunk, or if the threads could not be started.
+ * @exception std::logic_error Thrown if @p task encountered a bug on 
+ *	any chunk.
+ * @exception std::exception Any exception thrown by @p task is 
+ *	propagated unchanged if @p nWorkers &le; 1.
+ *
+ * @exceptsafe All worker threads have finished in the event of an 
+ *	exception.
+ */
+void runChunks(size_t nItems, size_t chunkSize, size_t nWorkers, 
+		const BlockTask& task) {
+	const size_t nChunks = (nItems + chunkSize - 1) / chunkSize;
+	if (nWorkers <= 1) {
+		for(size_t i = 0; i < nChunks; i++) {
+			task(i, i * chunkSize, std::min(nItems, (i+1) * chunkSize));
+		}
+		return;
+	}
+
+	vector<shared_ptr<ChunkQueue> > queues;
+	for(size_t i = 0; i < nWorkers; i++) {
+		queues.push_back(shared_ptr<ChunkQueue>(new ChunkQueue(
+			( i    * nChunks) / nWorkers, 
+			((i+1) * nChunks) / nWorkers)));
+	}
+	vector<WorkerStatus> status(nChunks);
+
+	boost::thread_group pool;
+	try {
+		for(size_t i = 0; i < nWorkers; i++) {
+			pool.create_thread(ChunkWorker(task, i, nItems, chunkSize, 
+				queues, status));
+		}
+	} catch (...) {
+		// Don't leave threads writing to status after it's destroyed
+		pool.join_all();
+		throw;
+	}
+	pool.join_all();
+
+	// Report the error from the earliest chunk, as in a serial run
+	for(vector<WorkerStatus>::const_iterator it = status.begin();
+			it != status.end(); it++) {
+		it->rethrow();
+	}
+}
+
+/** Selects the observations of a batch of light curves that fall on 
+ *	one of the cadences they were sampled from
+ *
+ * @param[in] whole The light curves, sampled on a cadence given by 
+ *	models::mergeCadences().
+ * @param[in] times One of the cadences passed to models::mergeCadences().
+ * @param[in] positions The positions of @p times given by 
+ *	models::mergeCadences().
+ * @param[out] part The light curves of @p whole, observed only at 
+ *	@p times.
+ *
+ * @pre Every element of @p whole has been completed by finishTrials().
+ * @pre Every element of @p positions is less than the number of fluxes 
+ *	in each element of @p whole.
+ *
+ * @post @p part has one element for each element of @p whole, with 
+ *	the same parameters and units, the times @p times, and the fluxes 
+ *	at @p positions. The noise of a time shared by several cadences 
+ *	is the same on each.
+ *
+ * @perform O(NM) time, where N = @p whole.size() and M = @p positions.size().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	copy the light curves.
+ *
+ * @exceptsafe The function arguments are unchanged in the event of 
+ *	an exception.
+ */
+void subsampleTrials(const vector<SimTrial>& whole, 
+		const models::Cadence& times, const vector<size_t>& positions, 
+		vector<SimTrial>& part) {
+	vector<SimTrial> newPart(whole.size());
+	for(size_t i = 0; i < whole.size(); i++) {
+		SimTrial& trial = newPart[i];
+		trial.times  = times;
+		trial.params = whole[i].params;
+		trial.units  = whole[i].units;
+		trial.fluxes.reserve(positions.size());
+		for(vector<size_t>::const_iterator it = positions.begin(); 
+				it != positions.end(); it++) {
+			trial.fluxes.push_back(whole[i].fluxes[*it]);
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	part.swap(newPart);
+}
+
+/** Analyzes a batch of simulated light curves using a pool of threads.
+ *
+ * The light curves are divided into small contiguous chunks, several 
+ * per thread, which the threads claim with runChunks() as they become 
+ * free. Each chunk's results are recorded in a private copy of 
+ * @p emptyBin. The private copies are merged into @p results in the 
+ * order of the light curves in @p trials, so the contents of @p results 
+ * depend neither on the number of threads nor on which thread analyzed 
+ * which chunk.
+ *
+ * @param[in] trials The light curves to analyze.
+ * @param[in] nThreads The maximum number of threads to use. If
+ *	@p nThreads = 1, the analysis is carried out on the calling thread.
+ * @param[in] emptyBin A collection with no statistics, used as the
+ *	template for each thread's results.
+ * @param[in,out] results The collection to which the statistics
+ *	for @p trials are added.
+ *
+ * @pre @p nThreads &ge; 1
+ * @pre @p emptyBin calculates the same statistics as @p results
+ *
+ * @post @p results contains the statistics previously stored, followed
+ *	by the statistics of each element of @p trials, in order.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	store more statistics.
+ * @exception std::invalid_argument Thrown if @p nThreads < 1 or if
+ *	@p emptyBin does not match @p results.
+ * @exception std::runtime_error Thrown if any light curve could not be
+ *	analyzed, or if the threads could not be started.
+ * @exception std::logic_error Thrown if a bug was encountered during
+ *	the analysis.
+ *
+ * @exceptsafe @p results is in a valid state in the event of an exception.
+ */
+void analyzeTrials(const vector<SimTrial>& trials, long nThreads,
+		const LcBinStats& emptyBin, LcBinStats& results) {
+	if (nThreads < 1) {
+		throw std::invalid_argument("Need at least one thread to analyze light curves (gave "
+			+ boost::lexical_cast<string>(nThreads) + ").");
+	}
+
+	const size_t nWorkers = std::min(static_cast<size_t>(nThreads), trials.size());
+
+	if (nWorkers <= 1) {
+		results.analyzeLightCurves(trials, 0, trials.size());
+		return;
+	}
+
+	// The cost of a trial can vary a hundredfold, so each thread gets 
+	//	several chunks to even out the load, but not so many that 
+	//	copying emptyBin becomes expensive
+	const size_t chunkSize = std::max<size_t>(1, trials.size() / (4*nWorkers));
+	const size_t nChunks = (trials.size() + chunkSize - 1) / chunkSize;
+	vector<LcBinStats> chunkBins(nChunks, emptyBin);
+	runChunks(trials.size(), chunkSize, nWorkers, 
+		TrialAnalyzer(trials, chunkBins));
+
+	// Merge in trial order so the output doesn't depend on nThreads
+	for(vector<LcBinStats>::const_iterator it = chunkBins.begin();
+			it != chunkBins.end(); it++) {
+		results.merge(*it);
+	}
+}
+
+/** Describes a bin's light curves
+ *
+ * @param[in] trials The light curves to analyze.
+ * @param[in] emptyBin A collection with no statistics, used as the
+ *	template for each thread's results.
+ * @param[in,out] results The collection to which the statistics
+ *	for @p trials are to be added.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+BinJob::BinJob(const vector<SimTrial>& trials, const LcBinStats& emptyBin, 
+		LcBinStats& results) 
+		: trials(&trials), emptyBin(&emptyBin), results(&results) {
+}
+
+/** PackedAnalyzer analyzes one chunk of the light curves of several bins.
+ */
+class PackedAnalyzer {
+public:
+	/** Prepares to analyze light curves.
+	 *
+	 * @param[in] jobs The bins to analyze.
+	 * @param[in] chunkJobs, chunkFirsts, chunkLasts The bin and range 
+	 *	of light curves of each chunk.
+	 * @param[in,out] chunkBins The objects in which to record the 
+	 *	analysis, one per chunk.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	PackedAnalyzer(const vector<BinJob>& jobs, const vector<size_t>& chunkJobs, 
+			const vector<size_t>& chunkFirsts, const vector<size_t>& chunkLasts, 
+			vector<LcBinStats>& chunkBins)
+			: jobs(jobs), chunkJobs(chunkJobs), chunkFirsts(chunkFirsts), 
+			chunkLasts(chunkLasts), chunkBins(chunkBins) {
+	}
+
+	/** Analyzes each light curve in a chunk, in order.
+	 *
+	 * @param[in] chunk The index of the chunk. The other arguments 
+	 *	are ignored, since runChunks() is given one item per chunk.
+	 *
+	 * @post <tt>chunkBins[chunk]</tt> contains the statistics for 
+	 *	the chunk's light curves, in order.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to
+	 *	store more statistics.
+	 * @exception std::logic_error Thrown if a bug was encountered.
+	 * @exception std::exception Thrown if a light curve could not be 
+	 *	analyzed.
+	 *
+	 * @exceptsafe <tt>chunkBins[chunk]</tt> is in a valid state in the 
+	 *	event of an exception.
+	 */
+	void operator()(size_t chunk, size_t, size_t) const {
+		chunkBins[chunk].analyzeLightCurves(*(jobs[chunkJobs[chunk]].trials), 
+			chunkFirsts[chunk], chunkLasts[chunk]);
+	}
+
+private:
+	const vector<BinJob>& jobs;
+	const vector<size_t>& chunkJobs;
+	const vector<size_t>& chunkFirsts;
+	const vector<size_t>& chunkLasts;
+	vector<LcBinStats>& chunkBins;
+};
+
+/** Analyzes the light curves of several bins using one pool of threads
+ *
+ * The light curves of every bin are divided into small contiguous 
+ * chunks, which never span two bins, and all the chunks are claimed 
+ * by the same pool of threads with runChunks(). Bins with too few 
+ * light curves to keep every thread busy therefore share the threads 
+ * with the other bins, instead of leaving them idle. As in 
+ * analyzeTrials(), each chunk's results are merged into its bin's 
+ * results in the order of the light curves, so the contents of each 
+ * bin are the same as if it had been analyzed alone.
+ *
+ * @param[in,out] jobs The bins to analyze.
+ * @param[in] nThreads The maximum number of threads to use. If
+ *	@p nThreads = 1, the analysis is carried out on the calling thread.
+ *
+ * @pre @p nThreads &ge; 1
+ * @pre The @p emptyBin of each element of @p jobs calculates the same 
+ *	statistics as its @p results
+ * @pre No two elements of @p jobs have the same @p results
+ *
+ * @post The @p results of each element of @p jobs contains the 
+ *	statistics previously stored, followed by the statistics of each 
+ *	of its @p trials, in order.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	store more statistics.
+ * @exception std::invalid_argument Thrown if @p nThreads < 1 or if
+ *	an @p emptyBin does not match its @p results.
+ * @exception std::runtime_error Thrown if any light curve could not be
+ *	analyzed, or if the threads could not be started.
+ * @exception std::logic_error Thrown if a bug was encountered during
+ *	the analysis.
+ *
+ * @exceptsafe The results of each element of @p jobs are in a valid 
+ *	state in the event of an exception.
+ */
+void analyzeBins(const vector<BinJob>& jobs, long nThreads) {
+	if (nThreads < 1) {
+		throw std::invalid_argument("Need at least one thread to analyze light curves (gave "
+			+ boost::lexical_cast<string>(nThreads) + ").");
+	}
+
+	size_t nTrials = 0;
+	for(vector<BinJob>::const_iterator it = jobs.begin(); it != jobs.end(); it++) {
+		nTrials += it->trials->size();
+	}
+	const size_t nWorkers = std::min(static_cast<size_t>(nThreads), nTrials);
+
+	if (nWorkers <= 1) {
+		for(vector<BinJob>::const_iterator it = jobs.begin(); 
+				it != jobs.end(); it++) {
+			it->results->analyzeLightCurves(*(it->trials), 0, it->trials->size());
+		}
+		return;
+	}
+
+	// Chunks are sized by the whole job, as in analyzeTrials(), but 
+	//	end at the boundaries between bins
+	const size_t chunkSize = std::max<size_t>(1, nTrials / (4*nWorkers));
+	vector<size_t> chunkJobs, chunkFirsts, chunkLasts;
+	vector<LcBinStats> chunkBins;
+	for(size_t i = 0; i < jobs.size(); i++) {
+		const size_t binSize = jobs[i].trials->size();
+		for(size_t first = 0; first < binSize; first += chunkSize) {
+			chunkJobs  .push_back(i);
+			chunkFirsts.push_back(first);
+			chunkLasts .push_back(std::min(binSize, first + chunkSize));
+			chunkBins  .push_back(*(jobs[i].emptyBin));
+		}
+	}
+	runChunks(chunkBins.size(), 1, nWorkers, 
+		PackedAnalyzer(jobs, chunkJobs, chunkFirsts, chunkLasts, chunkBins));
+
+	// Merge in trial order so the output doesn't depend on nThreads
+	for(size_t i = 0; i < chunkBins.size(); i++) {
+		jobs[chunkJobs[i]].results->merge(chunkBins[i]);
+	}
+}
+
+/** Starts the analysis stage
+ *
+ * @param[in] depth The most batches that may wait for analysis at once.
+ * @param[in] nThreads The maximum number of threads with which to 
+ *	analyze each batch, as for analyzeTrials().
+ * @param[in] emptyBin A collection with no statistics, used as the
+ *	template for each thread's results. Must remain valid until 
+ *	the pipeline is destroyed.
+ * @param[in,out] results The collection to which the statistics of 
+ *	each batch are added. Must not be used by any other thread until 
+ *	finish() has returned or the pipeline is destroyed.
+ * @param[in] finish A function to call on the analysis thread after 
+ *	each batch has been added to @p results.
+ *
+ * @pre @p depth &ge; 1
+ * @pre @p nThreads &ge; 1
+ * @pre @p emptyBin calculates the same statistics as @p results
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	start the pipeline.
+ * @exception boost::thread_resource_error Thrown if the analysis 
+ *	thread could not be started.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+TrialPipeline::TrialPipeline(size_t depth, long nThreads, 
+		const LcBinStats& emptyBin, LcBinStats& results, 
+		const BatchCallback& finish) 
+		: depth(depth), nThreads(nThreads), emptyBin(emptyBin), 
+		results(results), finishBatch(finish), lock(), changed(), 
+		queue(), closed(false), abandoned(false), 
+		status(new WorkerStatus()), 
+		startTime(stats::monotonicSeconds()), endTime(startTime), 
+		pushWait(0.0), analysisBusy(0.0), 
+		pushes(0), depthSum(0), maxDepth(0), thread() {
+	thread.reset(new boost::thread(&TrialPipeline::run, this));
+}
+
+/** Stops the analysis stage, abandoning any batches not analyzed
+ *
+ * @post The analysis thread has finished. If finish() was not called, 
+ *	the batch being analyzed is completed, but later batches are not.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+TrialPipeline::~TrialPipeline() {
+	if (thread.get() != NULL) {
+		{
+			boost::mutex::scoped_lock guard(lock);
+			closed    = true;
+			abandoned = true;
+		}
+		changed.notify_all();
+		thread->join();
+	}
+}
+
+/** Analyzes batches until the queue is closed
+ *
+ * @post Every batch in the queue has been analyzed, or the analysis 
+ *	failed and @p status describes the error.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void TrialPipeline::run() {
+	try {
+		for(;;) {
+			PendingBatch job;
+			{
+				boost::mutex::scoped_lock guard(lock);
+				while (queue.empty() && !closed) {
+					changed.wait(guard);
+				}
+				if (queue.empty() || abandoned) {
+					return;
+				}
+				job = queue.front();
+				queue.pop_front();
+			}
+			// The simulations may continue
+			changed.notify_all();
+			
+			const double start = stats::monotonicSeconds();
+			analyzeTrials(*job.trials, nThreads, emptyBin, results);
+			finishBatch(job.first, *job.trials, job.simSeconds, 
+				stats::monotonicSeconds() - start);
+			
+			boost::mutex::scoped_lock guard(lock);
+			analysisBusy += stats::monotonicSeconds() - start;
+		}
+	} catch (const std::logic_error& e) {
+		boost::mutex::scoped_lock guard(lock);
+		status->fail(e.what(), true);
+	} catch (const std::exception& e) {
+		boost::mutex::scoped_lock guard(lock);
+		status->fail(e.what(), false);
+	} catch (...) {
+		boost::mutex::scoped_lock guard(lock);
+		status->fail("Unknown exception in analysis thread.", true);
+	}
+	// Don't leave the simulations waiting for space in the queue
+	changed.notify_all();
+}
+
+/** Hands a simulated batch to the analysis stage
+ *
+ * If the queue is full, waits until the analysis stage takes the 
+ * oldest batch.
+ *
+ * @param[in] first The index of the first trial in @p batch.
+ * @param[in,out] batch The light curves to analyze, ready for 
+ *	analyzeTrials(). Its contents are moved into the pipeline.
+ * @param[in] simSeconds The time spent simulating @p batch.
+ *
+ * @pre finish() has not been called
+ *
+ * @post @p batch is empty, and its former contents will be analyzed 
+ *	after every batch already added.
+ *
+ * @exception std::runtime_error Thrown if the analysis of an earlier 
+ *	batch failed.
+ * @exception std::logic_error Thrown if the analysis of an earlier 
+ *	batch encountered a bug.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	add the batch.
+ *
+ * @exceptsafe @p batch is unchanged in the event of an exception.
+ */
+void TrialPipeline::push(long first, vector<SimTrial>& batch, double simSeconds) {
+	PendingBatch job;
+	job.first      = first;
+	job.simSeconds = simSeconds;
+	job.trials.reset(new vector<SimTrial>());
+	
+	{
+		const stats::TraceSpan span("pipeline wait");
+		boost::mutex::scoped_lock guard(lock);
+		const double waitStart = stats::monotonicSeconds();
+		while (queue.size() >= depth && !status->hasFailed()) {
+			changed.wait(guard);
+		}
+		pushWait += stats::monotonicSeconds() - waitStart;
+		status->rethrow();
+		
+		// Last operation in this block that is allowed to throw
+		queue.push_back(job);
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		job.trials->swap(batch);
+		pushes++;
+		depthSum += static_cast<long>(queue.size());
+		maxDepth = std::max(maxDepth, queue.size());
+	}
+	changed.notify_all();
+}
+
+/** Waits for every batch to be analyzed
+ *
+ * @post Every batch passed to push() has been added to the results, 
+ *	and the analysis thread has finished.
+ *
+ * @exception std::runtime_error Thrown if the analysis of any batch 
+ *	failed.
+ * @exception std::logic_error Thrown if the analysis of any batch 
+ *	encountered a bug.
+ *
+ * @exceptsafe The results are in a valid state in the event of an 
+ *	exception.
+ */
+void TrialPipeline::finish() {
+	if (thread.get() != NULL) {
+		{
+			boost::mutex::scoped_lock guard(lock);
+			closed = true;
+		}
+		changed.notify_all();
+		
+		const double waitStart = stats::monotonicSeconds();
+		thread->join();
+		thread.reset();
+		endTime   = stats::monotonicSeconds();
+		pushWait += endTime - waitStart;
+	}
+	status->rethrow();
+}
+
+/** Prints how full the queue was and how busy each stage was
+ *
+ * A simulation stage that is rarely busy, or a queue that is usually 
+ * full, means the analysis is the bottleneck, and would benefit from 
+ * more threads. An analysis stage that is rarely busy, or a queue that 
+ * is usually empty, means the opposite.
+ *
+ * @param[in] file An open file handle representing the text file to 
+ *	write to.
+ * @param[in] binName The name of the light curve type analyzed.
+ *
+ * @pre finish() has been called
+ *
+ * @exception std::runtime_error Thrown if the report could not be written.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void TrialPipeline::printReport(FILE* const file, const string& binName) const {
+	const double wallTime = std::max(endTime - startTime, 1e-9);
+	const double meanDepth = (pushes > 0 
+		? static_cast<double>(depthSum) / static_cast<double>(pushes) 
+		: 0.0);
+	
+	if (fprintf(file, "Pipeline for %s: simulation busy %.0f%%, "
+			"analysis busy %.0f%%, queue depth %.2g mean, %lu max, of %lu\n", 
+			binName.c_str(), 
+			100.0 * std::max(0.0, (wallTime - pushWait) / wallTime), 
+			100.0 * analysisBusy / wallTime, meanDepth, 
+			static_cast<unsigned long>(maxDepth), 
+			static_cast<unsigned long>(depth)) < 0) {
+		kpfutils::cError("Could not print output in printReport(): ");
+	}
+}
+
+}	// end lcmc
@@ -0,0 +1,234 @@
+/** Functions for analyzing simulated light curves in parallel
+ * @file lightcurveMC/trialpool.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCTRIALPOOLH
+#define LCMCTRIALPOOLH
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "binstats.h"
+#include "cadence.h"
+#include "fluxmag.h"
+#include "lightcurvetypes.h"
+#include "paramlist.h"
+
+namespace lcmc {
+
+/** Stores a simulated light curve that is waiting to be analyzed.
+ */
+struct SimTrial {
+	/** Creates an empty light curve.
+	 */
+	SimTrial() : times(), fluxes(), params(), model(), noise(), base(), 
+			units(utils::FLUX_UNITS) {
+	}
+	
+	/** The times at which the light curve was sampled. Trials on the 
+	 *	same cadence share one copy of the times.
+	 */
+	models::Cadence times;
+	/** The simulated flux at each time in @p times, or the simulated 
+	 *	magnitude if @p units is @ref utils::MAG_UNITS "MAG_UNITS".
+	 */
+	std::vector<double> fluxes;
+	/** The parameters used to generate @p fluxes.
+	 */
+	models::ParamList params;
+	/** The light curve whose fluxes have not yet been copied to 
+	 *	@p fluxes, or null if @p fluxes is ready.
+	 */
+	boost::shared_ptr<const models::ILightCurve> model;
+	/** The noise to add to @p model, or empty if @p fluxes is ready 
+	 *	or @p base is used instead.
+	 */
+	std::vector<double> noise;
+	/** The observed light curve into which @p model is injected, 
+	 *	shared with the injection catalog, or null if @p fluxes is 
+	 *	ready or @p noise is used instead.
+	 */
+	boost::shared_ptr<const std::vector<double> > base;
+	/** Whether @p fluxes and @p noise are fluxes or magnitudes.
+	 */
+	utils::PhotUnits units;
+};
+
+/** Type of a function that processes one block of a job.
+ *
+ * The arguments are the index of the worker running the block (for 
+ * runBlocks()) or of the block itself (for runChunks()), and the 
+ * first and one-past-last indices of the items in the block.
+ */
+typedef boost::function<void (size_t, size_t, size_t)> BlockTask;
+
+/** Divides a job into contiguous blocks and processes each block on 
+ *	its own thread
+ */
+void runBlocks(size_t nItems, size_t nWorkers, const BlockTask& task);
+
+/** Divides a job into small chunks and lets a pool of threads claim 
+ *	them as they become free
+ */
+void runChunks(size_t nItems, size_t chunkSize, size_t nWorkers, 
+		const BlockTask& task);
+
+/** Selects the observations of a batch of light curves that fall on 
+ *	one of the cadences they were sampled from
+ */
+void subsampleTrials(const std::vector<SimTrial>& whole, 
+		const models::Cadence& times, const std::vector<size_t>& positions, 
+		std::vector<SimTrial>& part);
+
+/** Analyzes a batch of simulated light curves using a pool of threads
+ */
+void analyzeTrials(const std::vector<SimTrial>& trials, long nThreads,
+		const stats::LcBinStats& emptyBin, stats::LcBinStats& results);
+
+/** Describes the light curves of one bin to be analyzed by analyzeBins()
+ *
+ * A BinJob only refers to its light curves and collections, which must 
+ * outlive it.
+ */
+struct BinJob {
+	/** Describes a bin's light curves
+	 */
+	BinJob(const std::vector<SimTrial>& trials, 
+			const stats::LcBinStats& emptyBin, stats::LcBinStats& results);
+	
+	/** The light curves to analyze. */
+	const std::vector<SimTrial>* trials;
+	/** A collection with no statistics, used as the template for 
+	 *	each thread's results. */
+	const stats::LcBinStats* emptyBin;
+	/** The collection to which the statistics of @p trials are added. */
+	stats::LcBinStats* results;
+};
+
+/** Analyzes the light curves of several bins using one pool of threads
+ */
+void analyzeBins(const std::vector<BinJob>& jobs, long nThreads);
+
+/** Type of a function that finishes a batch of light curves once they 
+ *	have been analyzed.
+ *
+ * The arguments are the index of the first trial in the batch, the 
+ * light curves, the time spent simulating them, and the time spent 
+ * analyzing them.
+ */
+typedef boost::function<void (long, const std::vector<SimTrial>&, double, double)> 
+	BatchCallback;
+
+class WorkerStatus;
+
+/** TrialPipeline analyzes batches of light curves on a background 
+ *	thread while the caller simulates the following batches.
+ *
+ * Batches are analyzed in the order they are added, so the results do 
+ * not depend on how far the simulations run ahead of the analysis.
+ */
+class TrialPipeline {
+public:
+	/** Starts the analysis stage
+	 */
+	TrialPipeline(size_t depth, long nThreads, 
+		const stats::LcBinStats& emptyBin, stats::LcBinStats& results, 
+		const BatchCallback& finish);
+	
+	/** Stops the analysis stage, abandoning any batches not analyzed
+	 */
+	~TrialPipeline();
+	
+	/** Hands a simulated batch to the analysis stage
+	 */
+	void push(long first, std::vector<SimTrial>& batch, double simSeconds);
+	
+	/** Waits for every batch to be analyzed
+	 */
+	void finish();
+	
+	/** Prints how full the queue was and how busy each stage was
+	 */
+	void printReport(FILE* const file, const std::string& binName) const;
+
+private:
+	// The analysis thread refers to the pipeline
+	TrialPipeline(const TrialPipeline&);
+	TrialPipeline& operator=(const TrialPipeline&);
+	
+	/** Analyzes batches until the queue is closed
+	 */
+	void run();
+	
+	/** A batch waiting for analysis */
+	struct PendingBatch {
+		PendingBatch() : first(0), simSeconds(0.0), trials() {
+		}
+		
+		long first;
+		double simSeconds;
+		boost::shared_ptr<std::vector<SimTrial> > trials;
+	};
+	
+	const size_t depth;
+	const long nThreads;
+	const stats::LcBinStats& emptyBin;
+	stats::LcBinStats& results;
+	const BatchCallback finishBatch;
+	
+	/** Protects every member below it, except where noted */
+	boost::mutex lock;
+	boost::condition_variable changed;
+	std::deque<PendingBatch> queue;
+	/** True once no more batches will be added */
+	bool closed;
+	/** True if the remaining batches should be dropped */
+	bool abandoned;
+	boost::shared_ptr<WorkerStatus> status;
+	
+	/** Statistics for printReport() */
+	double startTime, endTime;
+	double pushWait, analysisBusy;
+	long pushes, depthSum;
+	size_t maxDepth;
+	
+	/** Used only by the caller's thread */
+	boost::scoped_ptr<boost::thread> thread;
+};
+
+}	// end lcmc
+
+#endif	// LCMCTRIALPOOLH
@@ -0,0 +1,351 @@
+/** Generates stationary Gaussian processes on a regular grid by circulant embedding
+ * @file lightcurveMC/waves/circulant.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/thread/tss.hpp>
+#include <gsl/gsl_fft_halfcomplex.h>
+#include <gsl/gsl_fft_real.h>
+#include "generators.h"
+#include "../gsl_compat.h"
+#include "../gslpool.tmp.h"
+#include "../../common/alloc.tmp.h"
+
+namespace lcmc { namespace utils {
+
+using std::vector;
+using boost::lexical_cast;
+using boost::shared_ptr;
+using kpfutils::checkAlloc;
+
+/** The largest number of grid points regularCadence() will accept
+ */
+const size_t MAX_GRID = 1 << 20;
+
+/** The largest fraction of the grid step by which a time may differ
+ *	from its grid point in regularCadence()
+ */
+const double GRID_TOLERANCE = 1e-6;
+
+/** The most negative eigenvalue, as a fraction of the largest, that
+ *	circulantSpectrum() treats as rounding error
+ */
+const double EIGEN_TOLERANCE = 1e-8;
+
+/** Tests whether a set of times lies on a regular grid
+ *
+ * The grid step is the smallest nonzero difference between successive
+ * times, so a cadence with gaps, or with several observations at the
+ * same time, is still regular if every time is an integer number of
+ * steps from the first.
+ *
+ * @param[in] times The times to test.
+ * @param[out] step The spacing of the grid.
+ * @param[out] gridIndex The number of steps from @p times[0] to each
+ *	element of @p times.
+ *
+ * @return True if @p times is on a regular grid with no more than
+ *	2<sup>20</sup> points. If false, @p step and @p gridIndex are
+ *	unchanged.
+ *
+ * @pre @p times is sorted in ascending order
+ *
+ * @post If the return value is true, @p gridIndex.size() = @p times.size(),
+ *	and |@p times[i] - @p times[0] - @p gridIndex[i]&times;@p step|
+ *	&le; 10<sup>-6</sup>&times;@p step for all i.
+ *
+ * @perform O(N) time, where N = @p times.size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	store the grid.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+bool regularCadence(const vector<double>& times, double& step,
+		vector<size_t>& gridIndex) {
+	using std::swap;
+
+	if (times.size() < 2) {
+		return false;
+	}
+	const double span = times.back() - times.front();
+	if (!(span > 0.0)) {
+		return false;
+	}
+
+	double minStep = span;
+	for(size_t i = 1; i < times.size(); i++) {
+		const double gap = times[i] - times[i-1];
+		if (gap > GRID_TOLERANCE * span && gap < minStep) {
+			minStep = gap;
+		}
+	}
+	if (span / minStep > static_cast<double>(MAX_GRID - 1)) {
+		return false;
+	}
+
+	vector<size_t> temp;
+	temp.reserve(times.size());
+	for(size_t i = 0; i < times.size(); i++) {
+		const double offset = (times[i] - times.front()) / minStep;
+		const double k = floor(offset + 0.5);
+		if (fabs(offset - k) > GRID_TOLERANCE) {
+			return false;
+		}
+		temp.push_back(static_cast<size_t>(k));
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	step = minStep;
+	swap(gridIndex, temp);
+	return true;
+}
+
+/** Returns the smallest circulant embedding of a grid
+ *
+ * @param[in] gridSize The number of points on the grid.
+ *
+ * @return The smallest power of 2 that is at least
+ *	2(@p gridSize - 1), and at least 2.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t circulantSize(size_t gridSize) {
+	size_t size = 2;
+	while (size < 2*(gridSize - 1)) {
+		size *= 2;
+	}
+	return size;
+}
+
+/** The spectrum last computed by circulantSpectrum() on one thread
+ */
+struct CirculantCache {
+	/** Creates an empty cache
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	CirculantCache() : autocov(), sqrtEigen() {
+	}
+	
+	/** The autocovariance whose embedding was last computed */
+	vector<double> autocov;
+	/** The square root of the spectrum of the embedding, or empty 
+	 *	if it was not positive semidefinite */
+	vector<double> sqrtEigen;
+};
+
+/** Computes the square root of the spectrum of a circulant covariance
+ *	matrix
+ *
+ * The matrix is the symmetric circulant matrix whose first row is
+ * @p autocov[0], @p autocov[1], ..., @p autocov[m], @p autocov[m-1], ...,
+ * @p autocov[1], where m = @p autocov.size() - 1. Its eigenvalues are
+ * the Fourier transform of that row.
+ *
+ * @param[in] autocov The autocovariance of the process at lags 0
+ *	through m grid steps.
+ * @param[out] sqrtEigen The square roots of the m + 1 distinct
+ *	eigenvalues of the matrix.
+ *
+ * @return False if the matrix is not positive semidefinite, in which
+ *	case @p sqrtEigen is unchanged. Eigenvalues that are negative
+ *	by less than 10<sup>-8</sup> of the largest eigenvalue are
+ *	treated as zero.
+ *
+ * @pre @p autocov.size() &ge; 2
+ *
+ * @perform O(m log m) time if m is a power of 2. The spectrum of the
+ *	last @p autocov is remembered, so repeated calls for the same
+ *	process take O(m) time.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the spectrum.
+ * @exception std::invalid_argument Thrown if @p autocov.size() < 2.
+ * @exception std::runtime_error Thrown if the Fourier transform fails.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+bool circulantSpectrum(const vector<double>& autocov, vector<double>& sqrtEigen) {
+	using std::swap;
+
+	// Each thread keeps its own spectrum, so that light curves 
+	//	simulated in parallel neither block nor overwrite each other
+	// invariant: oldSqrtEigen is empty if the last embedding was
+	//	not positive semidefinite
+	static boost::thread_specific_ptr<CirculantCache> caches;
+	if (caches.get() == NULL) {
+		caches.reset(new CirculantCache());
+	}
+	vector<double>& oldAutocov   = caches->autocov;
+	vector<double>& oldSqrtEigen = caches->sqrtEigen;
+
+	if (autocov.size() < 2) {
+		throw std::invalid_argument("Circulant embedding needs at least 2 lags (gave "
+			+ lexical_cast<std::string>(autocov.size()) + ").");
+	}
+
+	if (autocov != oldAutocov) {
+		const size_t m = autocov.size() - 1;
+		const size_t n = 2*m;
+
+		vector<double> row(n);
+		for(size_t j = 0; j <= m; j++) {
+			row[j] = autocov[j];
+		}
+		for(size_t j = m+1; j < n; j++) {
+			row[j] = autocov[n-j];
+		}
+
+		shared_ptr<gsl_fft_real_workspace> work(
+			checkAlloc(gsl_fft_real_workspace_alloc(n)),
+			          &gsl_fft_real_workspace_free);
+		shared_ptr<gsl_fft_real_wavetable> table(
+			checkAlloc(gsl_fft_real_wavetable_alloc(n)),
+			          &gsl_fft_real_wavetable_free);
+		gslCheck( gsl_fft_real_transform(&row[0], 1, n, table.get(), work.get()),
+			"While embedding covariance matrix: ");
+
+		// Since the row is symmetric, its transform is real
+		// In half-complex format, the real parts are in
+		//	row[0], row[1], row[3], ..., row[n-3], row[n-1]
+		vector<double> eigen(m+1);
+		eigen[0] = row[0];
+		for(size_t k = 1; k < m; k++) {
+			eigen[k] = row[2*k - 1];
+		}
+		eigen[m] = row[n-1];
+
+		const double maxEigen = *std::max_element(eigen.begin(), eigen.end());
+		const double minEigen = *std::min_element(eigen.begin(), eigen.end());
+		vector<double> temp;
+		if (maxEigen > 0.0 && minEigen >= -EIGEN_TOLERANCE * maxEigen) {
+			temp.reserve(m+1);
+			for(size_t k = 0; k <= m; k++) {
+				temp.push_back(sqrt(std::max(eigen[k], 0.0)));
+			}
+		}
+		vector<double> newAutocov = autocov;
+
+		// IMPORTANT: no exceptions beyond this point
+
+		swap(oldAutocov, newAutocov);
+		swap(oldSqrtEigen, temp);
+	}
+
+	if (oldSqrtEigen.empty()) {
+		return false;
+	}
+
+	vector<double> temp = oldSqrtEigen;
+	swap(sqrtEigen, temp);
+	return true;
+}
+
+/** Transforms an uncorrelated sequence of Gaussian random numbers into
+ *	a stationary correlated sequence on a regular grid
+ *
+ * @param[in] sqrtEigen The square roots of the eigenvalues of a
+ *	circulant covariance matrix, as returned by circulantSpectrum().
+ * @param[in] indVec A vector of 2(@p sqrtEigen.size() - 1) independent
+ *	unit Gaussian random numbers.
+ * @param[out] corrVec A vector of correlated Gaussian random numbers
+ *	with mean zero and the circulant covariance matrix. The first
+ *	@p sqrtEigen.size() elements have the covariance of the
+ *	autocovariance passed to circulantSpectrum().
+ *
+ * @pre @p corrVec may refer to the same vector as @p indVec
+ *
+ * @post @p corrVec.size() = @p indVec.size()
+ *
+ * @perform O(m log m) time, where m = @p sqrtEigen.size(), if m - 1 is
+ *	a power of 2.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the transformation
+ * @exception std::invalid_argument Thrown if the lengths do not match.
+ * @exception std::runtime_error Thrown if the Fourier transform fails.
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+void circulantNormal(const vector<double>& sqrtEigen, const vector<double>& indVec,
+		vector<double>& corrVec) {
+	using std::swap;
+
+	if (sqrtEigen.size() < 2 || indVec.size() != 2*(sqrtEigen.size() - 1)) {
+		throw std::invalid_argument("Vector of length "
+			+ lexical_cast<std::string>(indVec.size())
+			+ " does not match circulant embedding with "
+			+ lexical_cast<std::string>(sqrtEigen.size())
+			+ " eigenvalues.");
+	}
+	const size_t m = sqrtEigen.size() - 1;
+	const size_t n = indVec.size();
+
+	// Every trial of a bin has the same n, so the workspace and tables 
+	//	are only built once per thread
+	const GslLease<FftWorkspaceTraits> work(n);
+
+	// The symmetric square root of the circulant matrix is itself
+	//	circulant, with eigenvalues sqrtEigen
+	vector<double> temp = indVec;
+	{
+		const GslLease<FftRealTableTraits> forwardTable(n);
+		gslCheck( gsl_fft_real_transform(&temp[0], 1, n,
+			forwardTable.get(), work.get()),
+			"While generating circulant normal vector: ");
+	}
+
+	// Scale each frequency while preserving the half-complex format
+	temp[0] *= sqrtEigen[0];
+	for(size_t k = 1; k < m; k++) {
+		temp[2*k - 1] *= sqrtEigen[k];
+		temp[2*k    ] *= sqrtEigen[k];
+	}
+	temp[n-1] *= sqrtEigen[m];
+
+	{
+		const GslLease<FftHalfcomplexTableTraits> inverseTable(n);
+		gslCheck( gsl_fft_halfcomplex_inverse(&temp[0], 1, n,
+			inverseTable.get(), work.get()),
+			"While generating circulant normal vector: ");
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	swap(corrVec, temp);
+}
+
+}}		// end lcmc::utils
@@ -0,0 +1,425 @@
+/** Offloads Gaussian process linear algebra to a CUDA device
+ * @file lightcurveMC/waves/devicelinalg.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * The functions in this file are only functional if the program is built
+ * with GPU = cuda (see makefile.inc). Otherwise, they always report that
+ * no device is available, and multiNormal() and multiNormalBatch()
+ * use the CPU.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <cmath>
+#include <boost/smart_ptr.hpp>
+#include <gsl/gsl_matrix.h>
+#include "generators.h"
+#include "../largealloc.tmp.h"
+#include "../../common/alloc.tmp.h"
+
+#ifdef LCMC_USE_CUDA
+
+#include "../../common/warnflags.h"
+
+// CUDA headers use long long
+#ifdef GNUC_COARSEWARN
+#pragma GCC diagnostic ignored "-Wlong-long"
+#endif
+
+// CUDA headers use long long
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wlong-long"
+#endif
+
+#include <cuda_runtime_api.h>
+#include <cublas_v2.h>
+#include <cusolverDn.h>
+
+// Re-enable all compiler warnings
+#ifdef GNUC_FINEWARN
+#pragma GCC diagnostic pop
+#endif
+
+#endif		// end ifdef LCMC_USE_CUDA
+
+namespace lcmc { namespace utils {
+
+using std::vector;
+using boost::shared_ptr;
+using kpfutils::checkAlloc;
+
+/** The smallest matrix for which the device is used. Smaller matrices
+ *	are faster to handle on the CPU than to copy to the device.
+ */
+const size_t DEVICE_MIN_SIZE = 512;
+
+/** The largest number of sequences multiplied at once by deviceMultiply()
+ */
+const size_t DEVICE_CHUNK = 256;
+
+#ifdef LCMC_USE_CUDA
+
+/** Allocates an array on the device
+ *
+ * @param[in] n The number of elements in the array.
+ *
+ * @return A pointer to the array, owning a deallocator cudaFree(), or
+ *	a null pointer if the array could not be allocated.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough host memory
+ *	to manage the pointer.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+template <typename T>
+shared_ptr<T> deviceArray(size_t n) {
+	void* data = NULL;
+	if (cudaMalloc(&data, n * sizeof(T)) != cudaSuccess) {
+		return shared_ptr<T>();
+	}
+	try {
+		return shared_ptr<T>(static_cast<T*>(data), &cudaFree);
+	} catch (...) {
+		cudaFree(data);
+		throw;
+	}
+}
+
+/** Returns a handle to the cuBLAS library
+ *
+ * @return A handle that remains valid for the rest of the program, or
+ *	a null pointer if cuBLAS could not be initialized.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+cublasHandle_t blasHandle() {
+	// invariant: handle is null if and only if initialization failed
+	static bool initialized = false;
+	static cublasHandle_t handle = NULL;
+
+	if (!initialized) {
+		initialized = true;
+		if (cublasCreate(&handle) != CUBLAS_STATUS_SUCCESS) {
+			handle = NULL;
+		}
+	}
+	return handle;
+}
+
+/** Returns a handle to the cuSOLVER library
+ *
+ * @return A handle that remains valid for the rest of the program, or
+ *	a null pointer if cuSOLVER could not be initialized.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+cusolverDnHandle_t solverHandle() {
+	// invariant: handle is null if and only if initialization failed
+	static bool initialized = false;
+	static cusolverDnHandle_t handle = NULL;
+
+	if (!initialized) {
+		initialized = true;
+		if (cusolverDnCreate(&handle) != CUSOLVER_STATUS_SUCCESS) {
+			handle = NULL;
+		}
+	}
+	return handle;
+}
+
+#endif		// end ifdef LCMC_USE_CUDA
+
+/** Tests whether linear algebra can be offloaded to a device
+ *
+ * @return true if the program was built with GPU = cuda and a CUDA
+ *	device is present. The result of the first call is remembered.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool deviceAvailable() {
+#ifdef LCMC_USE_CUDA
+	static int available = -1;
+
+	if (available < 0) {
+		int count = 0;
+		available = (cudaGetDeviceCount(&count) == cudaSuccess && count > 0
+			&& blasHandle() != NULL && solverHandle() != NULL) ? 1 : 0;
+	}
+	return available > 0;
+#else
+	return false;
+#endif
+}
+
+/** Given a matrix A, computes a matrix B with the property
+ *	@f$ A = B B^\intercal @f$ on a device
+ *
+ * Plays the same role as getHalfMatrix(), but computes the
+ * eigendecomposition with cuSOLVER. The eigenvalues are found in
+ * ascending order, so the resulting light curves are different from,
+ * but statistically equivalent to, those computed with GSL.
+ *
+ * @param[in] a The matrix to decompose
+ * @param[out] half The matrix B.
+ *
+ * @return true if the decomposition was computed on the device. If
+ *	false, because no device is available, @p a is too small to
+ *	benefit, or the device failed, @p half is unchanged.
+ *
+ * @pre @p a is a square, symmetric, positive semi-definite matrix
+ *
+ * @exception std::bad_alloc Thrown if there was not enough host memory
+ *	to store the decomposition.
+ * @exception std::invalid_argument Thrown if the matrix is not
+ *	positive semi-definite.
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+bool deviceHalfMatrix(const shared_ptr<const gsl_matrix>& a,
+		shared_ptr<gsl_matrix>& half) {
+	using std::swap;
+
+	const size_t N = a->size1;
+	if (N < DEVICE_MIN_SIZE || !deviceAvailable()) {
+		return false;
+	}
+
+#ifdef LCMC_USE_CUDA
+	const int n = static_cast<int>(N);
+	cusolverDnHandle_t solver = solverHandle();
+
+	// Since a is symmetric, its rows are also its columns
+	vector<double> eigenVecs(N*N);
+	for(size_t i = 0; i < N; i++) {
+		const double* const rowI = a->data + i * a->tda;
+		std::copy(rowI, rowI + N, eigenVecs.begin() + i*N);
+	}
+	vector<double> eigenVals(N);
+
+	int lwork = 0;
+	shared_ptr<double> devA = deviceArray<double>(N*N);
+	shared_ptr<double> devW = deviceArray<double>(N);
+	shared_ptr<int> devInfo = deviceArray<int>(1);
+	if (devA.get() == NULL || devW.get() == NULL || devInfo.get() == NULL
+			|| cusolverDnDsyevd_bufferSize(solver, CUSOLVER_EIG_MODE_VECTOR,
+				CUBLAS_FILL_MODE_LOWER, n, devA.get(), n, devW.get(),
+				&lwork) != CUSOLVER_STATUS_SUCCESS) {
+		return false;
+	}
+	shared_ptr<double> devWork = deviceArray<double>(static_cast<size_t>(lwork));
+	if (devWork.get() == NULL) {
+		return false;
+	}
+
+	int info = 0;
+	if (cudaMemcpy(devA.get(), &eigenVecs[0], N*N*sizeof(double),
+				cudaMemcpyHostToDevice) != cudaSuccess
+			|| cusolverDnDsyevd(solver, CUSOLVER_EIG_MODE_VECTOR,
+				CUBLAS_FILL_MODE_LOWER, n, devA.get(), n, devW.get(),
+				devWork.get(), lwork, devInfo.get()) != CUSOLVER_STATUS_SUCCESS
+			|| cudaMemcpy(&info, devInfo.get(), sizeof(int),
+				cudaMemcpyDeviceToHost) != cudaSuccess
+			|| info != 0
+			|| cudaMemcpy(&eigenVecs[0], devA.get(), N*N*sizeof(double),
+				cudaMemcpyDeviceToHost) != cudaSuccess
+			|| cudaMemcpy(&eigenVals[0], devW.get(), N*sizeof(double),
+				cudaMemcpyDeviceToHost) != cudaSuccess) {
+		return false;
+	}
+
+	// Multiply eigenVecs by sqrt(diag(eigenVals)) to get a matrix
+	//	that when multiplied by its transpose produces a
+	shared_ptr<gsl_matrix> temp(checkAlloc(largeMatrixAlloc(N, N)), &gsl_matrix_free);
+	for(size_t k = 0; k < N; k++) {
+		double curVal = eigenVals[k];
+
+		if (curVal < 0.0) {
+			// Correct for rounding problems
+			if (curVal > -1e-12) {
+				curVal = 0.0;
+			} else {
+				throw std::invalid_argument("Matrix is not positive semidefinite.");
+			}
+		}
+		const double scale = sqrt(curVal);
+
+		// In column-major order, eigenvector k is contiguous
+		const double* const vecK = &eigenVecs[k*N];
+		for(size_t i = 0; i < N; i++) {
+			gsl_matrix_set(temp.get(), i, k, scale * vecK[i]);
+		}
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	swap(half, temp);
+	return true;
+#else
+	(void) half;
+	return false;
+#endif
+}
+
+/** Multiplies several sequences by a factored covariance matrix on
+ *	a device
+ *
+ * The factor is kept on the device between calls, so repeated batches
+ * for the same matrix only transfer the sequences. The sequences are
+ * sent to the device, multiplied, and sent back in chunks of up to
+ * 256 sequences, alternating between two CUDA streams so that
+ * transfers of one chunk can overlap the product of the next.
+ *
+ * @param[in] half The matrix B by which to multiply, as computed by
+ *	getHalfMatrix() or getCholeskyMatrix().
+ * @param[in] triangular True if @p half is lower triangular.
+ * @param[in] indVecs A list of vectors of length @p half->size1.
+ * @param[out] corrVecs The products of @p half with each element of
+ *	@p indVecs.
+ *
+ * @return true if the products were computed on the device. If false,
+ *	because no device is available, @p half is too small to benefit,
+ *	or the device failed, @p corrVecs is unchanged.
+ *
+ * @pre @p indVecs[i].size() = @p half->size1 = @p half->size2 for all i
+ * @pre @p corrVecs may refer to the same list as @p indVecs
+ *
+ * @exception std::bad_alloc Thrown if there was not enough host memory
+ *	to store the products.
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+bool deviceMultiply(const shared_ptr<const gsl_matrix>& half, bool triangular,
+		const vector<vector<double> >& indVecs,
+		vector<vector<double> >& corrVecs) {
+	using std::swap;
+
+	const size_t N = half->size1;
+	const size_t K = indVecs.size();
+	if (N < DEVICE_MIN_SIZE || K == 0 || !deviceAvailable()) {
+		return false;
+	}
+
+#ifdef LCMC_USE_CUDA
+	// Holding a reference to the last factor ensures that its address
+	//	is not reused by a different matrix
+	// invariant: devHalf is null if and only if hostHalf is null
+	static shared_ptr<const gsl_matrix> hostHalf;
+	static shared_ptr<double> devHalf;
+
+	cublasHandle_t blas = blasHandle();
+	const int n = static_cast<int>(N);
+
+	if (hostHalf.get() != half.get()) {
+		hostHalf.reset();
+		devHalf.reset();
+
+		// A row-major copy of half, read in column-major order,
+		//	is the transpose of half
+		shared_ptr<double> temp = deviceArray<double>(N*N);
+		if (temp.get() == NULL || cudaMemcpy2D(temp.get(), N*sizeof(double),
+				half->data, half->tda*sizeof(double), N*sizeof(double), N,
+				cudaMemcpyHostToDevice) != cudaSuccess) {
+			return false;
+		}
+		devHalf = temp;
+		hostHalf = half;
+	}
+
+	// Each sequence is one column of a column-major matrix
+	const size_t chunk = std::min(K, DEVICE_CHUNK);
+	vector<double> input(N*K), output(N*K);
+	for(size_t k = 0; k < K; k++) {
+		std::copy(indVecs[k].begin(), indVecs[k].end(), input.begin() + k*N);
+	}
+
+	shared_ptr<double> devIn [2];
+	shared_ptr<double> devOut[2];
+	cudaStream_t streams[2] = {NULL, NULL};
+	bool ok = true;
+	for(size_t s = 0; s < 2; s++) {
+		devIn [s] = deviceArray<double>(N*chunk);
+		devOut[s] = deviceArray<double>(N*chunk);
+		ok = ok && devIn[s].get() != NULL && devOut[s].get() != NULL
+			&& cudaStreamCreate(&streams[s]) == cudaSuccess;
+	}
+
+	const double one = 1.0;
+	const double zero = 0.0;
+	for(size_t first = 0, s = 0; ok && first < K; first += chunk, s = 1 - s) {
+		const size_t nSeq = std::min(chunk, K - first);
+		const int k = static_cast<int>(nSeq);
+		double* const hostIn  = &input [first*N];
+		double* const hostOut = &output[first*N];
+
+		ok = cudaMemcpyAsync(devIn[s].get(), hostIn, N*nSeq*sizeof(double),
+				cudaMemcpyHostToDevice, streams[s]) == cudaSuccess
+			&& cublasSetStream(blas, streams[s]) == CUBLAS_STATUS_SUCCESS;
+		if (ok && triangular) {
+			// devHalf is the transpose of a lower triangular matrix
+			ok = cublasDtrmm(blas, CUBLAS_SIDE_LEFT, CUBLAS_FILL_MODE_UPPER,
+				CUBLAS_OP_T, CUBLAS_DIAG_NON_UNIT, n, k, &one,
+				devHalf.get(), n, devIn[s].get(), n, devOut[s].get(), n)
+				== CUBLAS_STATUS_SUCCESS;
+		} else if (ok) {
+			ok = cublasDgemm(blas, CUBLAS_OP_T, CUBLAS_OP_N, n, k, n, &one,
+				devHalf.get(), n, devIn[s].get(), n, &zero, devOut[s].get(), n)
+				== CUBLAS_STATUS_SUCCESS;
+		}
+		ok = ok && cudaMemcpyAsync(hostOut, devOut[s].get(),
+			N*nSeq*sizeof(double), cudaMemcpyDeviceToHost, streams[s])
+			== cudaSuccess;
+	}
+	for(size_t s = 0; s < 2; s++) {
+		if (streams[s] != NULL) {
+			ok = (cudaStreamSynchronize(streams[s]) == cudaSuccess) && ok;
+			cudaStreamDestroy(streams[s]);
+		}
+	}
+	cublasSetStream(blas, NULL);
+	if (!ok) {
+		return false;
+	}
+
+	vector<vector<double> > temp(K);
+	for(size_t k = 0; k < K; k++) {
+		temp[k].assign(output.begin() + k*N, output.begin() + (k+1)*N);
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	swap(corrVecs, temp);
+	return true;
+#else
+	(void) triangular;
+	(void) corrVecs;
+	return false;
+#endif
+}
+
+}}		// end lcmc::utils
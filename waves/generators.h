@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/generators.h
  * @author Krzysztof Findeisen
  * @date Created April 18, 2013
- * @date Last modified May 6, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -30,18 +30,137 @@
 #ifndef LCMCGENERATORSH
 #define LCMCGENERATORSH
 
+#include <string>
 #include <vector>
+#include <cstddef>
+#include <boost/cstdint.hpp>
 #include <boost/smart_ptr.hpp>
 #include <gsl/gsl_matrix.h>
 
 namespace lcmc { namespace utils {
 
+/** Type used to tell multiNormal() how to factor covariance matrices
+ */
+enum CovarFactor {
+	/** Factors the matrix using its eigendecomposition
+	 */
+	FACTOR_EIGEN, 
+	/** Factors the matrix using a Cholesky decomposition, falling back 
+	 *	to the eigendecomposition if the matrix is too close to singular
+	 */
+	FACTOR_CHOLESKY, 
+	/** Lets stationary Gaussian processes on regular cadences be 
+	 *	generated by circulant embedding, and factors all other 
+	 *	matrices like @ref FACTOR_EIGEN "FACTOR_EIGEN"
+	 */
+	FACTOR_CIRCULANT
+};
+
+/** Selects how multiNormal() factors covariance matrices
+ */
+void setCovarFactor(CovarFactor method);
+
+/** Returns the method chosen with setCovarFactor()
+ */
+CovarFactor getCovarFactor();
+
+/** Ensures that multiNormal() remembers at least a given number of 
+ *	covariance factorizations
+ */
+void reserveFactorCache(size_t nFactors);
+
+/** Saves covariance factorizations to disk for use by later runs
+ */
+void setFactorCacheDir(const std::string& dir);
+
 /** Transforms an uncorrelated sequence of Gaussian random numbers into a 
  *	correlated sequence
  */
-void multiNormal(const std::vector<double>& indVec, const boost::shared_ptr<gsl_matrix>& covar, 
+void multiNormal(const std::vector<double>& indVec, const boost::shared_ptr<const gsl_matrix>& covar, 
+		std::vector<double>& corrVec, boost::uint64_t token = 0);
+
+/** Transforms several uncorrelated sequences of Gaussian random numbers 
+ *	into correlated sequences with the same covariance
+ */
+void multiNormalBatch(const std::vector<std::vector<double> >& indVecs, 
+		const boost::shared_ptr<const gsl_matrix>& covar, 
+		std::vector<std::vector<double> >& corrVecs, boost::uint64_t token = 0);
+
+/** SparseCovar stores a symmetric matrix whose nonzero elements in the 
+ *	lower triangle lie in a contiguous run of each row ending at the 
+ *	diagonal (an envelope, or skyline, matrix).
+ *
+ * Covariance matrices of stationary processes with timescales much 
+ * shorter than the spacing between observations have this form, to 
+ * within a small tolerance, when the times are sorted.
+ */
+struct SparseCovar {
+	/** Creates an empty matrix.
+	 */
+	SparseCovar() : first(), offset(1, 0), values() {
+	}
+	
+	/** The column of the first stored element of each row
+	 */
+	std::vector<size_t> first;
+	/** The index in @ref values of the first stored element of each 
+	 *	row, followed by values.size()
+	 */
+	std::vector<size_t> offset;
+	/** The stored elements of row i, from column first[i] to column i, 
+	 *	for each row in turn
+	 */
+	std::vector<double> values;
+};
+
+/** Transforms an uncorrelated sequence of Gaussian random numbers into a 
+ *	correlated sequence with a sparse covariance matrix
+ */
+void multiNormal(const std::vector<double>& indVec, const SparseCovar& covar, 
 		std::vector<double>& corrVec);
 
+/** Tests whether linear algebra can be offloaded to a device
+ */
+bool deviceAvailable();
+
+/** Given a matrix A, computes a matrix B with the property 
+ *	@f$ A = B B^\intercal @f$ on a device
+ */
+bool deviceHalfMatrix(const boost::shared_ptr<const gsl_matrix>& a, 
+		boost::shared_ptr<gsl_matrix>& half);
+
+/** Multiplies several sequences by a factored covariance matrix on 
+ *	a device
+ */
+bool deviceMultiply(const boost::shared_ptr<const gsl_matrix>& half, 
+		bool triangular, const std::vector<std::vector<double> >& indVecs, 
+		std::vector<std::vector<double> >& corrVecs);
+
+/** Tests whether two matrices have the same dimensions and elements.
+ */
+bool sameMatrix(const gsl_matrix* const a, const gsl_matrix* const b);
+
+/** Tests whether a set of times lies on a regular grid
+ */
+bool regularCadence(const std::vector<double>& times, double& step, 
+		std::vector<size_t>& gridIndex);
+
+/** Returns the smallest circulant embedding of a grid
+ */
+size_t circulantSize(size_t gridSize);
+
+/** Computes the square root of the spectrum of a circulant covariance 
+ *	matrix
+ */
+bool circulantSpectrum(const std::vector<double>& autocov, 
+		std::vector<double>& sqrtEigen);
+
+/** Transforms an uncorrelated sequence of Gaussian random numbers into 
+ *	a stationary correlated sequence on a regular grid
+ */
+void circulantNormal(const std::vector<double>& sqrtEigen, 
+		const std::vector<double>& indVec, std::vector<double>& corrVec);
+
 }}		// end lcmc::utils
 
 #endif		// LCMCGENERATORSH
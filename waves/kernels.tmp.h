@@ -0,0 +1,368 @@
+/** Covariance kernels and kernel matrices for Gaussian processes
+ * @file lightcurveMC/waves/kernels.tmp.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCKERNELSH
+#define LCMCKERNELSH
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <boost/smart_ptr.hpp>
+#include <gsl/gsl_matrix.h>
+#include "../cadence.h"
+#include "../largealloc.tmp.h"
+#include "../../common/alloc.tmp.h"
+
+namespace lcmc { namespace models {
+
+/** Squared exponential kernel, @f$ \sigma^2 e^{-\Delta t^2/2\tau^2} @f$
+ *
+ * Like all kernels used by kernelMatrix(), SquaredExpKernel evaluates
+ * the covariance for a whole row of squared time differences at once, 
+ * and reports separately any variance added only to the diagonal.
+ */
+class SquaredExpKernel {
+public:
+	/** Defines a squared exponential kernel
+	 *
+	 * @param[in] variance The variance of the process.
+	 * @param[in] tau The coherence time of the process.
+	 *
+	 * @pre @p tau > 0
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	SquaredExpKernel(double variance, double tau) : variance(variance),
+			scale(-0.5/(tau*tau)) {
+	}
+
+	/** Adds the kernel to a row of covariances
+	 *
+	 * @param[in] lagSq The squared time differences at which to 
+	 *	evaluate the kernel.
+	 * @param[in] n The number of elements in @p lagSq and @p row.
+	 * @param[in,out] row The covariances, incremented by the kernel
+	 *	at each element of @p lagSq.
+	 *
+	 * @pre @p lagSq and @p row are at least @p n elements long, and
+	 *	do not overlap
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void addRow(const double* lagSq, size_t n, double* row) const {
+		// A single pass over contiguous data, which compilers can 
+		//	vectorize
+		for(size_t j = 0; j < n; j++) {
+			row[j] += variance*exp(scale*lagSq[j]);
+		}
+	}
+
+	/** Returns the variance added only to the diagonal of the
+	 *	covariance matrix
+	 *
+	 * @return 0, since the kernel is continuous at zero lag.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	double nugget() const {
+		return 0.0;
+	}
+
+private:
+	double variance;
+	/** -1/2&tau;<sup>2</sup> */
+	double scale;
+};
+
+/** White noise kernel, @f$ \sigma^2 \delta_{ij} @f$
+ *
+ * The noise is independent for each observation, even if two
+ * observations are taken at the same time.
+ */
+class WhiteKernel {
+public:
+	/** Defines a white noise kernel
+	 *
+	 * @param[in] variance The variance of the noise.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	explicit WhiteKernel(double variance) : variance(variance) {
+	}
+
+	/** Adds the kernel to a row of covariances
+	 *
+	 * Does nothing, since white noise only contributes to
+	 * the diagonal (see nugget()).
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void addRow(const double*, size_t, double*) const {
+	}
+
+	/** Returns the variance added only to the diagonal of the
+	 *	covariance matrix
+	 *
+	 * @return The variance of the noise.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	double nugget() const {
+		return variance;
+	}
+
+private:
+	double variance;
+};
+
+/** Sum of two kernels
+ *
+ * @tparam Kernel1, Kernel2 The types of the kernels to add. Must
+ *	provide the same members as SquaredExpKernel.
+ */
+template <class Kernel1, class Kernel2>
+class SumKernel {
+public:
+	/** Defines the sum of two kernels
+	 *
+	 * @param[in] k1, k2 The kernels to add.
+	 *
+	 * @exceptsafe Does not throw exceptions if the kernels' copy
+	 *	constructors do not throw.
+	 */
+	SumKernel(const Kernel1& k1, const Kernel2& k2) : k1(k1), k2(k2) {
+	}
+
+	/** Adds the kernel to a row of covariances
+	 *
+	 * @param[in] lagSq The squared time differences at which to 
+	 *	evaluate the kernel.
+	 * @param[in] n The number of elements in @p lagSq and @p row.
+	 * @param[in,out] row The covariances, incremented by both kernels
+	 *	at each element of @p lagSq.
+	 *
+	 * @exceptsafe Has the weaker of the two kernels' guarantees.
+	 */
+	void addRow(const double* lagSq, size_t n, double* row) const {
+		k1.addRow(lagSq, n, row);
+		k2.addRow(lagSq, n, row);
+	}
+
+	/** Returns the variance added only to the diagonal of the
+	 *	covariance matrix
+	 *
+	 * @return The sum of the kernels' nuggets.
+	 *
+	 * @exceptsafe Does not throw exceptions if neither kernel does.
+	 */
+	double nugget() const {
+		return k1.nugget() + k2.nugget();
+	}
+
+private:
+	Kernel1 k1;
+	Kernel2 k2;
+};
+
+/** Adds two kernels
+ *
+ * @tparam Kernel1, Kernel2 The types of the kernels to add.
+ *
+ * @param[in] k1, k2 The kernels to add.
+ *
+ * @return A kernel equal to @p k1 + @p k2.
+ *
+ * @exceptsafe Does not throw exceptions if the kernels' copy
+ *	constructors do not throw.
+ */
+template <class Kernel1, class Kernel2>
+SumKernel<Kernel1, Kernel2> addKernels(const Kernel1& k1, const Kernel2& k2) {
+	return SumKernel<Kernel1, Kernel2>(k1, k2);
+}
+
+/** LagMatrix stores the squared differences between each pair of 
+ *	times in a cadence
+ *
+ * The differences depend only on the times, so kernel matrices for 
+ * different coherence times on the same cadence can share them. Only 
+ * the lower triangle is stored, packed row by row, so that each row 
+ * ending at the diagonal is contiguous. The lags are allocated by 
+ * utils::largeAlloc(), since every kernel matrix reads all of them.
+ */
+class LagMatrix {
+public:
+	/** Computes the squared lags of a set of times
+	 *
+	 * @param[in] times The times at which the process is sampled.
+	 *
+	 * @perform O(N<sup>2</sup>) time, where N = @p times.size()
+	 * @perfmore N(N+1)/2 doubles of memory
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	to store the lags.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	explicit LagMatrix(const std::vector<double>& times) : n(times.size()), 
+			lagSq(times.size() * (times.size() + 1) / 2) {
+		size_t k = 0;
+		for(size_t i = 0; i < n; i++) {
+			for(size_t j = 0; j <= i; j++, k++) {
+				const double deltaT = times[i] - times[j];
+				lagSq[k] = deltaT*deltaT;
+			}
+		}
+	}
+
+	/** Returns the number of times
+	 *
+	 * @return The number of rows in the matrix.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	size_t size() const {
+		return n;
+	}
+
+	/** Returns one row of the lower triangle
+	 *
+	 * @param[in] i The row to return.
+	 * 
+	 * @return A pointer to the squared lags between time @p i and 
+	 *	times 0 through @p i, in order.
+	 *
+	 * @pre @p i < size()
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	const double* row(size_t i) const {
+		return &lagSq[i*(i+1)/2];
+	}
+
+	/** Returns the memory used by the matrix
+	 *
+	 * @return The number of bytes in the lags.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	size_t bytes() const {
+		return lagSq.size() * sizeof(double);
+	}
+
+private:
+	size_t n;
+	utils::LargeVector<double>::type lagSq;
+};
+
+/** Allocates and computes the covariance matrix of a kernel from the 
+ *	squared lags of a cadence
+ *
+ * Each kernel is evaluated only in the lower triangle of the matrix.
+ * The upper triangle is a copy, so the matrix is exactly symmetric.
+ *
+ * @tparam Kernel The type of kernel to evaluate. Must provide the same
+ *	members as SquaredExpKernel.
+ *
+ * @param[in] lags The squared lags between the times at which the 
+ *	process is sampled.
+ * @param[in] kernel The covariance function of the process.
+ *
+ * @return A pointer to a newly allocated @p lags.size() &times;
+ *	@p lags.size() matrix, owning a deallocator gsl_matrix_free(). 
+ *	The elements are allocated by utils::largeAlloc().
+ *
+ * @pre @p lags is not empty
+ *
+ * @perform O(N<sup>2</sup>) time, where N = @p lags.size(), with
+ *	N(N+1)/2 kernel evaluations in one pass over the lags.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the matrix.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+template <class Kernel>
+boost::shared_ptr<gsl_matrix> kernelMatrix(const LagMatrix& lags,
+		const Kernel& kernel) {
+	const size_t nTimes = lags.size();
+
+	boost::shared_ptr<gsl_matrix> covar(
+		kpfutils::checkAlloc(utils::largeMatrixCalloc(nTimes, nTimes)),
+		&gsl_matrix_free);
+
+	for(size_t i = 0; i < nTimes; i++) {
+		// Each row of a gsl_matrix is contiguous
+		double* row = gsl_matrix_ptr(covar.get(), i, 0);
+		kernel.addRow(lags.row(i), i+1, row);
+		row[i] += kernel.nugget();
+
+		for(size_t j = 0; j < i; j++) {
+			gsl_matrix_set(covar.get(), j, i, row[j]);
+		}
+	}
+
+	return covar;
+}
+
+/** Allocates and computes the covariance matrix of a kernel at a
+ *	set of times
+ *
+ * @tparam Kernel The type of kernel to evaluate. Must provide the same
+ *	members as SquaredExpKernel.
+ *
+ * @param[in] times The times at which the process is sampled.
+ * @param[in] kernel The covariance function of the process.
+ *
+ * @return A pointer to a newly allocated @p times.size() &times;
+ *	@p times.size() matrix, owning a deallocator gsl_matrix_free().
+ *
+ * @pre @p times is not empty
+ *
+ * @perform O(N<sup>2</sup>) time, where N = @p times.size(), with
+ *	N(N+1)/2 kernel evaluations.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the matrix.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+template <class Kernel>
+boost::shared_ptr<gsl_matrix> kernelMatrix(const std::vector<double>& times,
+		const Kernel& kernel) {
+	return kernelMatrix(LagMatrix(times), kernel);
+}
+
+/** Returns the squared lags of a cadence, reusing those computed 
+ *	for the previous cadence on the same thread
+ */
+boost::shared_ptr<const LagMatrix> cadenceLags(const Cadence& times);
+
+}}		// end lcmc::models
+
+#endif		// end LCMCKERNELSH
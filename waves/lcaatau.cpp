@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcaatau.cpp
  * @author Krzysztof Findeisen
  * @date Created July 31, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <cmath>
@@ -41,9 +41,9 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-AaTauWave::AaTauWave(const std::vector<double> &times, double amp, double period, 
+AaTauWave::AaTauWave(const Cadence& times, double amp, double period, 
 		double phase, double width) : 
-		PeriodicLc(times, amp, period, phase), width(width) {
+		PeriodicKernel<AaTauWave>(times, amp, period, phase), width(width) {
 	if (width <= 0.0) {
 		throw except::BadParam("All AaTauWave light curves need positive widths (gave " 
 			+ lexical_cast<string>(width) + ").");
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcbroad.cpp
  * @author Krzysztof Findeisen
  * @date Created April 24, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -55,9 +55,9 @@ namespace lcmc { namespace models {
  *
  * @exceptsafe Object construction is atomic.
  */
-BroadPeakWave::BroadPeakWave(const std::vector<double> &times, 
+BroadPeakWave::BroadPeakWave(const Cadence& times, 
 		double amp, double period, double phase) 
-		: PeriodicLc(times, amp, period, phase) {
+		: PeriodicKernel<BroadPeakWave>(times, amp, period, phase) {
 }
 
 /** Samples the waveform at the specified phase.
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcdeterministic.cpp
  * @author Krzysztof Findeisen
  * @date Created March 18, 2013
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -29,6 +29,7 @@
 
 #include <vector>
 #include "lcdeterministic.h"
+#include "../fluxmag.h"
 
 namespace lcmc { namespace models {
 
@@ -37,14 +38,13 @@ namespace lcmc { namespace models {
  * @param[in] times The times at which the light curve will be sampled.
  *
  * @post getTimes() and getFluxes() return suitable data. getTimes() contains 
- * the same elements as @p times, possibly reordered.
+ * the same elements as @p times, in ascending order.
  *
- * @exception std::bad_alloc Thrown if there is not enough memory to 
- *	construct the object.
+ * @perform Constant time. The times are shared with @p times, not copied.
  *
- * @exceptsafe Object construction is atomic.
+ * @exceptsafe Does not throw exceptions.
  */
-Deterministic::Deterministic(const std::vector<double> &times) : ILightCurve(), times(times) {
+Deterministic::Deterministic(const Cadence &times) : ILightCurve(), times(times) {
 }
 
 Deterministic::~Deterministic() {
@@ -71,7 +71,7 @@ void Deterministic::getTimes(std::vector<double>& timeArray) const {
 
 	// copy-and-swap to allow atomic guarantee
 	// vector::= only offers the basic guarantee
-	std::vector<double> temp = times;
+	std::vector<double> temp = times.timeView();
 	
 	swap(timeArray, temp);
 }
@@ -104,24 +104,106 @@ void Deterministic::getTimes(std::vector<double>& timeArray) const {
 void Deterministic::getFluxes(std::vector<double>& fluxArray) const {
 	using std::swap;
 
-	// Must use virtual getTimes() to ensure consistency with getFluxes()
-	std::vector<double> times;
-	getTimes(times);
-	
-	size_t n = times.size();
-
 	// copy-and-swap
-	std::vector<double> temp;
-	temp.reserve(n);
+	std::vector<double> temp(size());
 	
-	for(std::vector<double>::const_iterator it = times.begin();
-			it != times.end(); it++) {
-		temp.push_back(flux(*it));
+	// &temp[0] is not defined for an empty vector
+	if (!temp.empty()) {
+		fillFluxes(&temp[0]);
 	}
 	
 	swap(fluxArray, temp);
 }
 
+/** Returns a read-only view of the times at which the simulated 
+ *	data were taken
+ *
+ * @return A reference to the times with which the light curve was 
+ *	initialized. The reference is valid for the lifetime of the object.
+ *
+ * @post return value.size() = size()
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const std::vector<double>& Deterministic::timeView() const {
+	return times.timeView();
+}
+
+/** Writes the simulated fluxes into a caller-provided buffer
+ *
+ * @param[out] fluxArray An array of at least size() elements in 
+ *	which to store the fluxes.
+ *
+ * @post @p fluxArray[i] = getFluxes()[i] for all i < size()
+ * 
+ * @perform O(N) time, where N = size()
+ *
+ * @exception std::logic_error Thrown if a bug was found in the flux calculations.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception. 
+ *	The contents of @p fluxArray are unspecified.
+ */
+void Deterministic::fillFluxes(double fluxArray[]) const {
+	// Must use virtual timeView() to ensure consistency with getTimes()
+	const std::vector<double>& times = timeView();
+	
+	// &times[0] is not defined for an empty vector
+	if (!times.empty()) {
+		fluxBatch(&times[0], fluxArray, times.size());
+	}
+}
+
+/** Writes the simulated light curve, in magnitudes, into a 
+ *	caller-provided buffer
+ *
+ * @param[out] magArray An array of at least size() elements in 
+ *	which to store the magnitudes.
+ *
+ * @post @p magArray[i] = utils::fluxToMag(getFluxes()[i]) for all i < size()
+ * 
+ * @perform O(N) time, where N = size()
+ *
+ * @exception std::logic_error Thrown if a bug was found in the flux calculations.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception. 
+ *	The contents of @p magArray are unspecified.
+ */
+void Deterministic::fillMags(double magArray[]) const {
+	// Deterministic light curves are defined in fluxes, so convert 
+	//	in place
+	fillFluxes(magArray);
+	utils::fluxToMag(magArray, magArray, size());
+}
+
+/** Samples the light curve at many times.
+ *
+ * Subclasses may override this method to evaluate the light curve 
+ * without a virtual call per time. The default calls flux() for each 
+ * time.
+ * 
+ * @param[in] times The times at which observations are taken.
+ * @param[out] fluxes An array in which to store the flux at each time.
+ * @param[in] n The number of elements in @p times and @p fluxes.
+ *
+ * @pre @p times and @p fluxes may be the same array
+ *
+ * @post @p fluxes[i] = flux(@p times[i]) for all i < @p n
+ * 
+ * @perform O(@p n) time
+ *
+ * @exception std::logic_error Thrown if a bug was found in the flux calculations.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception. 
+ *	The contents of @p fluxes are unspecified.
+ */
+void Deterministic::fluxBatch(const double times[], double fluxes[], size_t n) const {
+	for(size_t i = 0; i < n; i++) {
+		fluxes[i] = flux(times[i]);
+	}
+}
+
 /** Returns the number of times and fluxes
  *
  * @return The number of data points represented by the light curve.
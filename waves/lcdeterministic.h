@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcdeterministic.h
  * @author Krzysztof Findeisen
  * @date Created May 12, 2013
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,6 +31,7 @@
 #define LCMCCURVEDETERMH
 
 #include <gsl/gsl_rng.h>
+#include "../cadence.h"
 #include "../lightcurvetypes.h"
 
 
@@ -53,6 +54,20 @@ public:
 	 */
 	virtual void getFluxes(std::vector<double>& fluxArray) const;
 
+	/** Returns a read-only view of the times at which the simulated 
+	 *	data were taken
+	 */
+	virtual const std::vector<double>& timeView() const;
+
+	/** Writes the simulated fluxes into a caller-provided buffer
+	 */
+	virtual void fillFluxes(double fluxArray[]) const;
+
+	/** Writes the simulated light curve, in magnitudes, into a 
+	 *	caller-provided buffer
+	 */
+	virtual void fillMags(double magArray[]) const;
+
 	/** Returns the number of times and fluxes
 	 */
 	virtual size_t size() const;
@@ -61,7 +76,7 @@ protected:
 	/** Initializes the light curve to represent a particular function 
 	 * flux(time).
 	 */
-	explicit Deterministic(const std::vector<double> &times);
+	explicit Deterministic(const Cadence &times);
 
 private:
 	/** Samples the light curve at the specified time.
@@ -89,7 +104,11 @@ private:
 	 */	
 	virtual double flux(double time) const = 0;
 
-	std::vector<double> times;
+	/** Samples the light curve at many times.
+	 */
+	virtual void fluxBatch(const double times[], double fluxes[], size_t n) const;
+
+	Cadence times;
 };
 
 }}	// end lcmc::models
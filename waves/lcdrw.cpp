@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcdrw.cpp
  * @author Krzysztof Findeisen
  * @date Created March 21, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,14 +27,15 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 #include <cmath>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/tss.hpp>
 #include "../except/data.h"
-#include "../fluxmag.h"
 #include "lightcurves_gp.h"
 
 namespace lcmc { namespace models {
@@ -65,7 +66,7 @@ using boost::shared_ptr;
  *
  * @exceptsafe Object construction is atomic.
  */
-DampedRandomWalk::DampedRandomWalk(const std::vector<double>& times, double diffus, double tau) 
+DampedRandomWalk::DampedRandomWalk(const Cadence& times, double diffus, double tau) 
 		: GaussianProcess(times), sigma(sqrt(0.5*diffus*tau)), tau(tau) {
 	if (diffus <= 0.0) {
 		throw except::BadParam("All DampedRandomWalk light curves need positive diffusion coefficients (gave " 
@@ -77,96 +78,164 @@ DampedRandomWalk::DampedRandomWalk(const std::vector<double>& times, double diff
 	}
 }
 
-/** Computes a realization of the light curve. 
+/** Approximate comparison function that handles zeros cleanly.
+ */
+bool cacheCheck(double x, double y);
+
+/** The coefficients last computed by DampedRandomWalk::getArCoeffs() 
+ *	on one thread
+ */
+struct DampedWalkCache {
+	/** Creates an empty cache
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	DampedWalkCache() : coeffs(), times(), tau(0.0) {
+	}
+	
+	/** The coefficients, or null if none have been computed */
+	shared_ptr<const ArCoeffs> coeffs;
+	/** The times for which @p coeffs was computed */
+	Cadence times;
+	/** The damping time for which @p coeffs was computed */
+	double tau;
+};
+
+/** Returns the coefficients for generating the process one 
+ *	observation at a time, in units of getAmplitude().
  *
- * The light curve is computed from times and the internal random 
- * number generator, and its values are stored in fluxes.
+ * A damped random walk is Markovian, so each observation depends only 
+ * on the one before it. This simplified algorithm works only for an 
+ * exponential covariance, a white noise process, or a constant process, 
+ * since it requires rho(t1,t3) = rho(t1,t2)*rho(t2,t3). However, it's 
+ * much faster than the general-purpose, matrix-based algorithm.
  *
- * @param[out] fluxes The flux vector to update.
- * 
- * @post getFluxes() will now return the correct light curve.
- * 
- * @post @p fluxes.size() = getTimes().size()
+ * The coefficients depend only on the times and the damping time, so 
+ * light curves that differ only in diffusion constant share the same 
+ * coefficients.
+ *
+ * @return A pointer to the coefficients. The coefficients are shared 
+ *	with other light curves having the same times and damping time, 
+ *	and must not be modified.
+ *
+ * @post A realization generated from the coefficients has unit variance, 
+ *	and cov(mags[i], mags[j]) = exp(-|getTimes()[i]-getTimes()[j]|/tau)
  * @post if getTimes()[i] = getTimes()[j] for i &ne; j, then 
- *	@p fluxes[i] = @p fluxes[j]
- * 
- * @post No element of @p fluxes is NaN
- * @post All elements in @p fluxes are non-negative
- * @post The median of the flux is one, when averaged over many elements and 
- *	many light curve instances.
- *
- * @post fluxToMag(@p fluxes) has a mean of zero and a standard deviation of 
- *	sqrt(0.5*@p diffus/@p tau)
- * @post cov(fluxToMag(@p fluxes[i]), fluxToMag(@p fluxes[j])) = 
- *	0.5*<tt>diffus</tt>/<tt>tau</tt> &times; exp(|getTimes()[i]-getTimes()[j]|/tau) 
- * 
- * @exception std::bad_alloc Thrown if there is not enough memory to compute 
- *	the light curve.
- * @exception std::logic_error Thrown if a bug was found in the flux 
- *	calculations.
- *
- * @exceptsafe Neither the object nor the argument are changed in the 
- *	event of an exception.
- */	
-void DampedRandomWalk::solveFluxes(std::vector<double>& fluxes) const {
+ *	mags[i] = mags[j]
+ *
+ * @perform O(N) time, where N is the number of times.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the coefficients.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception
+ *
+ * @internal @exceptsafe The internal cache in getArCoeffs() provides 
+ *	only the basic exception guarantee. However, aside from run time 
+ *	this is not visible to the rest of the program.
+ */
+shared_ptr<const ArCoeffs> DampedRandomWalk::getArCoeffs() const {
 	using std::swap;
-
+	
+	// Define a cache so that trials sharing a cadence and damping time 
+	//	don't have to recalculate the exponentials
+	// Each thread keeps its own cache, so that light curves simulated 
+	//	in parallel neither block nor overwrite each other
+	// invariant: oldCoeffs is empty <=> no coefficients computed yet
+	static boost::thread_specific_ptr<DampedWalkCache> caches;
+	if (caches.get() == NULL) {
+		caches.reset(new DampedWalkCache());
+	}
+	shared_ptr<const ArCoeffs>& oldCoeffs = caches->coeffs;
+	Cadence& oldTimes = caches->times;
+	double& oldTau = caches->tau;
+	
 	// invariant: this->times() is sorted in ascending order
-	std::vector<double> times;
-	this->getTimes(times);
+	const std::vector<double>& times = this->timeView();
+	const size_t nTimes = times.size();
 	
-	// copy-and-swap
-	auto_ptr<StochasticRng> rng = checkout();
-	std::vector<double> temp;
-
-	if (times.size() > 0) {
-		temp.reserve(times.size());
-
-		// f(t0) ~ N(0, sigma) to ensure self-similarity
-		temp.push_back(sigma * rng->rNorm());
+	if(oldCoeffs.get() == NULL 
+			|| !cacheCheck(oldTau, tau)
+			// Trials drawn from one cadence share the same times object
+			|| (!cadence().sameAs(oldTimes) 
+				&& (oldTimes.size() != nTimes
+				|| !std::equal(oldTimes.timeView().begin(), 
+					oldTimes.timeView().end(), 
+					times.begin(), &cacheCheck))) ) {
+		// Cache is out of date
+		
+		// copy-and-swap
+		shared_ptr<ArCoeffs> temp(new ArCoeffs());
+		temp->decay.reserve(nTimes);
+		temp->step .reserve(nTimes);
 		
-		// Evaluate f(t > t0)
-		// This simplified algorithm works only for an exponential covariance, 
-		//	a white noise process, or a constant process, since it 
-		//	requires rho(t1,t3) = rho(t1,t2)*rho(t2,t3). However, it's 
-		//	much faster than the general-purpose, matrix-based algorithm.
-		for(std::vector<double>::const_iterator it = times.begin()+1; 
-				it != times.end(); it++) {
-			double oldFlux = temp.back();
-			
+		if (nTimes > 0) {
+			// f(t0) ~ N(0, 1) to ensure self-similarity
+			temp->decay.push_back(0.0);
+			temp->step .push_back(1.0);
+		}
+		for(size_t i = 1; i < nTimes; i++) {
 			// Observations taken at the same time should have the same flux
 			// Sorting invariant guarantees that all duplicate times will 
 			//	be next to each other
-			if (*it == *(it-1)) {
-				temp.push_back(oldFlux);
+			if (times[i] == times[i-1]) {
+				temp->decay.push_back(1.0);
+				temp->step .push_back(0.0);
 			// Observations taken at different times are partially 
 			//	correlated
 			} else {
 				// Implement Equation 2.47 of Gillespie (1996)
 				// His algorithm is not worth the trouble, since it 
 				//	relies heavily on deltaT being constant
-				double deltaTTau  = (*it - *(it-1))/tau;
+				const double deltaTTau = (times[i] - times[i-1])/tau;
 				
-				temp.push_back(oldFlux*exp(-deltaTTau) 
-					+ sigma*sqrt(1.0 - exp(-2.0*deltaTTau)) 
-						* rng->rNorm());
+				temp->decay.push_back(exp(-deltaTTau));
+				temp->step .push_back(sqrt(1.0 - exp(-2.0*deltaTTau)));
 			}
 		}
 		
-		utils::magToFlux(temp, temp);
-	}
+		Cadence newTimes = cadence();
 		
-	// IMPORTANT: no exceptions past this point
+		// No exceptions beyond this point
 		
-	swap(fluxes, temp);
-	commit(rng);
+		oldCoeffs = temp;
+		swap(oldTimes, newTimes);
+		oldTau = tau;
+	}
+	
+	// assert: the Cache is up-to-date
+	
+	return oldCoeffs;
+}
+
+/** Returns the factor by which a light curve with coefficients 
+ *	getArCoeffs() must be scaled.
+ *
+ * @return The root-mean-square amplitude of the damped random walk, 
+ *	sqrt(0.5*diffus*tau).
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double DampedRandomWalk::getAmplitude() const {
+	return sigma;
 }
 
 /** Allocates and initializes the covariance matrix for the 
  *	Gaussian process. 
  */
-shared_ptr<gsl_matrix> DampedRandomWalk::getCovar() const {
+shared_ptr<const gsl_matrix> DampedRandomWalk::getCovar() const {
 	throw std::logic_error("Unexpected call to DampedRandomWalk::getCovar().");
 }
 
+/** Tests whether the light curve is computed from getCovar() by 
+ *	the default implementation of solveMags()
+ *
+ * @return false, since DampedRandomWalk is computed from getArCoeffs().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool DampedRandomWalk::batchable() const {
+	return false;
+}
+
 }}		// end lcmc::models
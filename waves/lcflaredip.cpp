@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcFlareDip.cpp
  * @author Krzysztof Findeisen
  * @date Created August 21, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -65,9 +65,9 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-FlareDip::FlareDip(const std::vector<double> &times, 
+FlareDip::FlareDip(const Cadence& times, 
 			double amp, double period, double phase, double fade, double width) 
-			: PeriodicLc(times, amp, period, phase), tExp(width), tLin(fade) {
+			: TabulatedKernel<FlareDip>(times, amp, period, phase), tExp(width), tLin(fade) {
 	if (amp > 1.0) {
 		throw except::BadParam("All SlowDip light curves need amplitudes < 1 (gave " 
 			+ lexical_cast<string>(amp) + ").");
@@ -121,4 +121,28 @@ double FlareDip::fluxPhase(double phase, double amp) const {
 	}
 }
 
+/** Returns the phase at which the waveform jumps
+ *
+ * @return The start of the linear fade.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double FlareDip::shapeBreak() const {
+	return 1.0 - tLin;
+}
+
+/** Returns an upper bound on the curvature of the waveform
+ *
+ * @param[in] amp The light curve amplitude, in the same units 
+ *	as passed to the constructor.
+ *
+ * @return An upper bound on the magnitude of the second derivative 
+ *	of the flux with respect to phase, away from the start of the fade.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double FlareDip::shapeCurvature(double amp) const {
+	return amp * (1.0/(tExp*tExp) + 2.0/(tExp*tLin));
+}
+
 }}		// end lcmc::models
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcflarepeak.cpp
  * @author Krzysztof Findeisen
  * @date Created May 2, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,6 +27,7 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <boost/lexical_cast.hpp>
 #include "../except/data.h"
@@ -65,9 +66,9 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-FlarePeak::FlarePeak(const std::vector<double> &times, 
+FlarePeak::FlarePeak(const Cadence& times, 
 			double amp, double period, double phase, double rise, double fade) 
-			: PeriodicLc(times, amp, period, phase), tExp(fade), tLin(rise) {
+			: TabulatedKernel<FlarePeak>(times, amp, period, phase), tExp(fade), tLin(rise) {
 	if (rise <= 0.0) {
 		throw except::BadParam("All FlarePeak light curves need positive linear rise times (gave " 
 			+ lexical_cast<string>(rise) + ").");
@@ -117,4 +118,31 @@ double FlarePeak::fluxPhase(double phase, double amp) const {
 	}
 }
 
+/** Returns the phase at which the waveform jumps
+ *
+ * @return The start of the linear rise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double FlarePeak::shapeBreak() const {
+	return 1.0 - tLin;
+}
+
+/** Returns an upper bound on the curvature of the waveform
+ *
+ * @param[in] amp The light curve amplitude, in the same units 
+ *	as passed to the constructor.
+ *
+ * @return An upper bound on the magnitude of the second derivative 
+ *	of the flux with respect to phase, away from the start of the rise. 
+ *	The tail has a second derivative of at most amp/fade<sup>2</sup>, 
+ *	and the rise, which scales the tail by amp, of at most 
+ *	amp<sup>2</sup>(1/fade<sup>2</sup> + 2/(fade &times; rise)).
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double FlarePeak::shapeCurvature(double amp) const {
+	return std::max(amp, amp*amp) * (1.0/(tExp*tExp) + 2.0/(tExp*tLin));
+}
+
 }}		// end lcmc::models
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcflat.cpp
  * @author Krzysztof Findeisen
  * @date Created May 2, 2012
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -52,7 +52,7 @@ namespace lcmc { namespace models {
  *
  * @exceptsafe Does not throw exceptions.
  */
-FlatWave::FlatWave(const std::vector<double> &times) : Deterministic(times) {
+FlatWave::FlatWave(const Cadence& times) : Deterministic(times) {
 }
 
 // By definition, FlatWave::flux() ignores the time given to it
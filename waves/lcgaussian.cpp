@@ -2,28 +2,555 @@
  * @file lightcurveMC/waves/lcgaussian.cpp
  * @author Krzysztof Findeisen
  * @date Created August 1, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 #include <algorithm>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
-//#include <cmath>
-//#include <boost/lexical_cast.hpp>
+#include <cmath>
+#include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <gsl/gsl_eigen.h>
 #include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
 #include "../approx.h"
+#include "../cachestats.h"
 //#include "../except/data.h"
-#include "../fluxmag.h"
+#include "../gsl_compat.h"
+#include "../hash.h"
+#include "../largealloc.tmp.h"
 #include "generators.h"
+#include "kernels.tmp.h"
 #include "lightcurves_gp.h"
+#include "../../common/alloc.tmp.h"
 
 namespace lcmc { namespace models {
 
-//using boost::lexical_cast;
+using boost::lexical_cast;
 using boost::shared_ptr;
 using std::auto_ptr;
+using kpfutils::checkAlloc;
+
+/** Returns the number of grid points per decade used by snapTau()
+ *
+ * @return A modifiable grid density, 0 if coherence times are not rounded.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& tauGridDensity() {
+	static long density = 0;
+	return density;
+}
+
+/** Rounds the coherence times of Gaussian process kernels to a 
+ *	logarithmic grid
+ *
+ * Rounding lets light curves with similar coherence times share one 
+ * covariance matrix, and therefore one factorization, at the cost of 
+ * a small, bounded error in the kernel (see tauGridCovarError()).
+ *
+ * @param[in] perDecade The number of grid points per factor of 10 in 
+ *	coherence time, or 0 to use exact coherence times.
+ *
+ * @post snapTau() rounds to the nearest of @f$10^{k/perDecade}@f$ for 
+ *	integer k, or returns its argument if @p perDecade = 0.
+ *
+ * @exception std::invalid_argument Thrown if @p perDecade < 0
+ *
+ * @exceptsafe The grid is unchanged in the event of an exception.
+ */
+void setTauGrid(long perDecade) {
+	if (perDecade < 0) {
+		throw std::invalid_argument("Coherence time grid must have a non-negative number of points per decade (gave " 
+			+ lexical_cast<std::string>(perDecade) + ").");
+	}
+	tauGridDensity() = perDecade;
+}
+
+/** Returns the grid value to which a coherence time is rounded
+ *
+ * @param[in] tau The coherence time to round.
+ *
+ * @return The grid value closest to @p tau in logarithm, or @p tau 
+ *	if no grid has been set.
+ *
+ * @pre @p tau > 0
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double snapTau(double tau) {
+	const long n = tauGridDensity();
+	if (n <= 0) {
+		return tau;
+	}
+	return pow(10.0, floor(log10(tau) * n + 0.5) / n);
+}
+
+/** Returns the number of grid values needed to cover a range of 
+ *	coherence times
+ *
+ * @param[in] tauMin, tauMax The range of coherence times.
+ *
+ * @return The number of distinct values snapTau() can return for 
+ *	arguments in [@p tauMin, @p tauMax], or 0 if no grid has been set.
+ *
+ * @pre 0 < @p tauMin &le; @p tauMax
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t tauGridSize(double tauMin, double tauMax) {
+	const long n = tauGridDensity();
+	if (n <= 0) {
+		return 0;
+	}
+	const double kMin = floor(log10(tauMin) * n + 0.5);
+	const double kMax = floor(log10(tauMax) * n + 0.5);
+	return static_cast<size_t>(kMax - kMin) + 1;
+}
+
+/** Returns the largest fractional change in a coherence time caused 
+ *	by rounding to the grid
+ *
+ * @return The maximum of |snapTau(tau)/tau - 1| over all tau, or 0 
+ *	if no grid has been set.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double tauGridError() {
+	const long n = tauGridDensity();
+	if (n <= 0) {
+		return 0.0;
+	}
+	// Worst case is halfway between grid points, rounded down
+	return pow(10.0, 0.5 / n) - 1.0;
+}
+
+/** Returns the largest change in a Gaussian kernel, as a fraction of 
+ *	its variance, caused by rounding its coherence time to the grid
+ *
+ * @return The maximum over &Delta;t and tau of 
+ *	@f$|\exp(-\Delta t^2/2\tau^2) - \exp(-\Delta t^2/2\tau'^2)|@f$, 
+ *	where @f$\tau'@f$ = snapTau(tau), or 0 if no grid has been set.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double tauGridCovarError() {
+	const double ratio = 1.0 + tauGridError();
+	if (ratio <= 1.0) {
+		return 0.0;
+	}
+	// For u = (Delta t/tau')^2 and b = (tau'/tau)^2, the difference 
+	//	exp(-u/2) - exp(-b u/2) peaks at u = 2 ln(b)/(b-1)
+	const double b = ratio*ratio;
+	const double u = 2.0 * log(b) / (b - 1.0);
+	return exp(-0.5*u) - exp(-0.5*b*u);
+}
+
+/** Returns the number of inducing points used by 
+ *	GaussianProcess::nystromRealization()
+ *
+ * @return A modifiable rank, 0 if exact kernels are used.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& nystromRankValue() {
+	static long rank = 0;
+	return rank;
+}
+
+/** Returns the largest kernel error of the Nystr&ouml;m approximations 
+ *	used so far
+ *
+ * @return A modifiable error, as a fraction of the variance.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& nystromWorstError() {
+	static double error = 0.0;
+	return error;
+}
+
+/** Returns the lock protecting nystromWorstError() and seasonWorstError()
+ *
+ * @return The lock, shared by all threads.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::mutex& nystromErrorLock() {
+	static boost::mutex lock;
+	return lock;
+}
+
+/** Approximates stationary Gaussian processes by a Nystr&ouml;m 
+ *	low-rank model with a given number of inducing points
+ *
+ * The approximation lets SimpleGp and TwoScaleGp light curves with 
+ * many irregularly spaced observations be generated in 
+ * O(m<sup>2</sup>N) time and O(m<sup>2</sup> + N) memory, where m 
+ * is the rank and N is the number of observations, instead of 
+ * factoring an N&times;N covariance matrix. The covariance is 
+ * represented exactly at the inducing points, and the variance not 
+ * captured at the other times is added back as independent noise, 
+ * so that each observation keeps the correct variance. The largest 
+ * remaining error in the covariance is reported by nystromError().
+ *
+ * @param[in] rank The number of inducing points, or 0 to use exact 
+ *	kernels.
+ *
+ * @post Stationary Gaussian processes with more than @p rank 
+ *	observations are generated from a rank-@p rank approximation, or 
+ *	with their exact kernels if @p rank = 0.
+ * @post nystromError() returns 0 until a light curve is generated 
+ *	from the new approximation.
+ *
+ * @exception std::invalid_argument Thrown if @p rank < 0
+ *
+ * @exceptsafe The rank is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe.
+ */
+void setNystromRank(long rank) {
+	if (rank < 0) {
+		throw std::invalid_argument("Nystrom approximations must have a non-negative rank (gave " 
+			+ lexical_cast<std::string>(rank) + ").");
+	}
+	
+	nystromRankValue() = rank;
+	nystromWorstError() = 0.0;
+}
+
+/** Returns the rank chosen with setNystromRank()
+ *
+ * @return The number of inducing points, or 0 if exact kernels are 
+ *	used.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long getNystromRank() {
+	return nystromRankValue();
+}
+
+/** Returns the largest kernel error of any Nystr&ouml;m approximation 
+ *	used since the last call to setNystromRank()
+ *
+ * The error at a pair of times is bounded by the geometric mean of 
+ * the variance added back as independent noise at each time, so the 
+ * largest added variance bounds the error of every element of the 
+ * covariance matrix.
+ *
+ * @return The largest difference between the approximate and exact 
+ *	covariances of any light curve generated so far, as a fraction 
+ *	of the variance, or 0 if no light curve has been generated from 
+ *	the approximation.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double nystromError() {
+	boost::mutex::scoped_lock guard(nystromErrorLock());
+	return nystromWorstError();
+}
+
+/** Returns the coupling below which GaussianProcess::findSeasons() 
+ *	treats seasons as independent
+ *
+ * @return A modifiable tolerance, 0 if seasons are never separated.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& seasonToleranceValue() {
+	static double tolerance = 0.0;
+	return tolerance;
+}
+
+/** Returns the largest covariance dropped between seasons so far
+ *
+ * @return A modifiable error, as a fraction of the variance. Must only 
+ *	be used while holding nystromErrorLock().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& seasonWorstError() {
+	static double error = 0.0;
+	return error;
+}
+
+/** Generates stationary Gaussian processes one observing season at 
+ *	a time, where the seasons are nearly uncorrelated
+ *
+ * Cadences from ground-based surveys come in observing seasons 
+ * separated by gaps of several months. If the kernel has fallen 
+ * below @p tolerance of the variance across every such gap, the 
+ * covariance matrix is block diagonal to that precision, and each 
+ * season may be generated from its own block. Factoring the blocks 
+ * takes O(&sum; N<sub>s</sub><sup>3</sup>) time instead of 
+ * O(N<sup>3</sup>), where N<sub>s</sub> is the number of observations 
+ * in season s. Seasons separated by shorter gaps are generated 
+ * together, with their correlations intact. The largest covariance 
+ * dropped between seasons is reported by seasonError().
+ *
+ * @param[in] tolerance The largest covariance between seasons, as 
+ *	a fraction of the variance, that may be ignored, or 0 to always 
+ *	generate the light curve as a whole.
+ *
+ * @post Stationary Gaussian processes whose kernel falls below 
+ *	@p tolerance of its variance across one or more gaps between 
+ *	observations are generated one season at a time, unless a 
+ *	state-space or Nystr&ouml;m approximation is also requested.
+ * @post seasonError() returns 0 until a light curve is generated 
+ *	one season at a time.
+ *
+ * @exception std::invalid_argument Thrown if @p tolerance is negative, 
+ *	NaN, or not less than 1.
+ *
+ * @exceptsafe The tolerance is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe.
+ */
+void setSeasonTolerance(double tolerance) {
+	if (!(tolerance >= 0.0 && tolerance < 1.0)) {
+		throw std::invalid_argument("Tolerance for separating seasons must be in [0, 1) (gave " 
+			+ lexical_cast<std::string>(tolerance) + ").");
+	}
+	
+	seasonToleranceValue() = tolerance;
+	boost::mutex::scoped_lock guard(nystromErrorLock());
+	seasonWorstError() = 0.0;
+}
+
+/** Returns the tolerance chosen with setSeasonTolerance()
+ *
+ * @return The largest covariance between seasons that may be ignored, 
+ *	as a fraction of the variance, or 0 if seasons are never separated.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double getSeasonTolerance() {
+	return seasonToleranceValue();
+}
+
+/** Returns the largest covariance dropped between seasons since the 
+ *	last call to setSeasonTolerance()
+ *
+ * @return The largest covariance between two observations in different 
+ *	seasons of any light curve generated so far, as a fraction of the 
+ *	variance, or 0 if no light curve has been generated one season 
+ *	at a time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double seasonError() {
+	boost::mutex::scoped_lock guard(nystromErrorLock());
+	return seasonWorstError();
+}
+
+/** Returns the covariance below which GaussianProcess::sparseCovar() 
+ *	treats pairs of observations as uncorrelated
+ *
+ * @return A modifiable tolerance, 0 if covariance matrices are never 
+ *	sparse.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& sparseToleranceValue() {
+	static double tolerance = 0.0;
+	return tolerance;
+}
+
+/** Generates stationary Gaussian processes from a sparse covariance 
+ *	matrix, treating covariances below a tolerance as zero
+ *
+ * When the timescale of a process is short compared to the spacing 
+ * between observations, most elements of its covariance matrix are 
+ * negligible. If they are dropped, the covariance of the sorted 
+ * observations is nonzero only near the diagonal, and can be factored 
+ * without filling in any of the dropped elements. This takes time 
+ * and memory proportional to the number of correlated pairs of 
+ * observations, rather than O(N<sup>3</sup>) time and 
+ * O(N<sup>2</sup>) memory. Light curves whose timescales are too long 
+ * for the matrix to be sparse, or whose truncated matrix is not 
+ * positive definite, are generated from the full covariance matrix 
+ * as before.
+ *
+ * @param[in] tolerance The largest covariance, as a fraction of the 
+ *	variance, that may be treated as zero, or 0 to always use the full 
+ *	covariance matrix.
+ *
+ * @post Stationary Gaussian processes for which at most a quarter of 
+ *	the covariance matrix exceeds @p tolerance of the variance are 
+ *	generated from a sparse covariance matrix, unless another 
+ *	approximation is also requested.
+ *
+ * @exception std::invalid_argument Thrown if @p tolerance is negative, 
+ *	NaN, or not less than 1.
+ *
+ * @exceptsafe The tolerance is unchanged in the event of an exception.
+ *
+ * @note Not thread-safe.
+ */
+void setSparseTolerance(double tolerance) {
+	if (!(tolerance >= 0.0 && tolerance < 1.0)) {
+		throw std::invalid_argument("Tolerance for sparse covariances must be in [0, 1) (gave " 
+			+ lexical_cast<std::string>(tolerance) + ").");
+	}
+	
+	sparseToleranceValue() = tolerance;
+}
+
+/** Returns the tolerance chosen with setSparseTolerance()
+ *
+ * @return The largest covariance that may be treated as zero, as a 
+ *	fraction of the variance, or 0 if covariance matrices are never 
+ *	sparse.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double getSparseTolerance() {
+	return sparseToleranceValue();
+}
+
+/** Draws the random numbers for one realization of a process
+ *
+ * @param[in] coeffs The coefficients of the process.
+ * @param[in] rng The generator from which to draw the deviates.
+ * @param[out] devs A vector of <tt>coeffs.step.size()</tt> elements, 
+ *	holding an independent standard normal deviate for each nonzero 
+ *	step and zero for the others.
+ *
+ * @post The deviates are drawn in order of observation, one per 
+ *	nonzero step, so that the generator advances exactly as it did 
+ *	when each light curve model drew its own deviates.
+ *
+ * @perform O(N) time, where N = @p coeffs.step.size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the deviates.
+ *
+ * @exceptsafe @p devs is unchanged in the event of an exception.
+ */
+void arDeviates(const ArCoeffs& coeffs, const StochasticRng& rng, std::vector<double>& devs) {
+	using std::swap;
+
+	const std::vector<double>& steps = coeffs.step;
+	const size_t nTimes = steps.size();
+	
+	// copy-and-swap
+	std::vector<double> temp(nTimes);
+	const size_t nDraws = nTimes - std::count(steps.begin(), steps.end(), 0.0);
+	
+	// The deviates are drawn into the tail of temp, so that spreading 
+	//	them across the nonzero steps never overwrites an unread one
+	const size_t offset = nTimes - nDraws;
+	if (nDraws > 0) {
+		rng.fillNormal(&temp[offset], nDraws, 1.0);
+	}
+	for(size_t i = 0, next = offset; i < nTimes; i++) {
+		temp[i] = (steps[i] != 0.0 ? temp[next++] : 0.0);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(devs, temp);
+}
+
+/** Advances several realizations of a process in lockstep
+ *
+ * @param[in] coeffs The coefficients of the process.
+ * @param[in] amplitudes The amplitude of each realization, by which 
+ *	the steps in @p coeffs are multiplied.
+ * @param[in,out] series The realizations, interleaved so that element 
+ *	<tt>i*nSeries + k</tt> is observation i of realization k. On input, 
+ *	independent standard normal deviates; on output, the corresponding 
+ *	realizations of the process described by @p coeffs, in magnitudes.
+ * @param[in] nSeries The number of realizations in @p series.
+ *
+ * @pre @p series has <tt>coeffs.decay.size()*nSeries</tt> elements
+ * @pre @p amplitudes has @p nSeries elements
+ * @pre @p coeffs.decay.size() = @p coeffs.step.size()
+ *
+ * @post Each observation is computed as 
+ *	<tt>decay*previous + (amplitude*step)*deviate</tt>, so that a 
+ *	process whose step already includes its amplitude gets the same 
+ *	values it got when it was computed on its own.
+ *
+ * @perform O(NK) time, where N = @p coeffs.decay.size() and 
+ *	K = @p nSeries
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void arRecurrence(const ArCoeffs& coeffs, const double amplitudes[], 
+		double series[], size_t nSeries) {
+	const size_t nTimes = coeffs.decay.size();
+	if (nTimes == 0) {
+		return;
+	}
+	
+	const double firstStep = coeffs.step[0];
+	for(size_t k = 0; k < nSeries; k++) {
+		series[k] *= amplitudes[k]*firstStep;
+	}
+	for(size_t i = 1; i < nTimes; i++) {
+		const double  decay = coeffs.decay[i];
+		const double  step  = coeffs.step [i];
+		const double* prev  = series + (i-1)*nSeries;
+		double*       cur   = series +  i   *nSeries;
+		// The realizations are independent, so this loop vectorizes
+		for(size_t k = 0; k < nSeries; k++) {
+			cur[k] = decay*prev[k] + (amplitudes[k]*step)*cur[k];
+		}
+	}
+}
+
+/** Computes several realizations of a process that shares one set of 
+ *	coefficients
+ *
+ * @param[in] coeffs The coefficients of the process.
+ * @param[in] amplitudes The amplitude of each realization.
+ * @param[in,out] devs Each element is a vector of deviates drawn by 
+ *	arDeviates(), which is replaced by the corresponding realization 
+ *	of the process described by @p coeffs, in magnitudes.
+ *
+ * @pre Each element of @p devs has <tt>coeffs.decay.size()</tt> elements
+ * @pre @p amplitudes.size() = @p devs.size()
+ *
+ * @perform O(NK) time, where N = @p coeffs.decay.size() and 
+ *	K = @p devs.size()
+ * @perfmore O(NK) memory
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the realizations.
+ *
+ * @exceptsafe @p devs is unchanged in the event of an exception.
+ */
+void arBatch(const ArCoeffs& coeffs, const std::vector<double>& amplitudes, 
+		std::vector<std::vector<double> >& devs) {
+	const size_t nTimes  = coeffs.decay.size();
+	const size_t nSeries = devs.size();
+	
+	std::vector<double> series(nTimes * nSeries);
+	// &series[0] is not defined for an empty vector
+	if (series.empty()) {
+		return;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	for(size_t k = 0; k < nSeries; k++) {
+		for(size_t i = 0; i < nTimes; i++) {
+			series[i*nSeries + k] = devs[k][i];
+		}
+	}
+	arRecurrence(coeffs, &amplitudes[0], &series[0], nSeries);
+	for(size_t k = 0; k < nSeries; k++) {
+		for(size_t i = 0; i < nTimes; i++) {
+			devs[k][i] = series[i*nSeries + k];
+		}
+	}
+}
 
 /** Initializes the light curve to represent a Gaussian process.
  *
@@ -36,34 +563,313 @@ using std::auto_ptr;
  *
  * @exceptsafe Object construction is atomic.
  */
-GaussianProcess::GaussianProcess(const std::vector<double>& times) : Stochastic(times) {
+GaussianProcess::GaussianProcess(const Cadence& times) : Stochastic(times), 
+		deviates() {
+}
+
+/** Draws the random numbers needed to compute the light curve, 
+ *	without computing it
+ *
+ * Once the random numbers have been drawn, computing the light curve 
+ * does not use the random number generator. The light curve may 
+ * therefore be computed later, possibly as part of solveBatch(), and 
+ * still be the same as if it had been computed immediately. Light 
+ * curves that are not computed from getCovar() or getArCoeffs() are 
+ * computed immediately instead.
+ *
+ * @pre getFluxes() has not yet been called
+ *
+ * @post The random number generator is in the state it would be in 
+ *	after getFluxes() was called.
+ *
+ * @perform O(N) time, where N = size(), if the light curve is 
+ *	computed from getCovar(). Otherwise, the same as getFluxes().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the random numbers.
+ * @exception std::logic_error Thrown if a bug was found in the flux 
+ *	calculations.
+ *
+ * @exceptsafe The object and the random number generator are unchanged 
+ *	in the event of an exception.
+ */
+void GaussianProcess::drawDeviates() const {
+	using std::swap;
+
+	if (!deviates.empty()) {
+		return;
+	}
+	const shared_ptr<const ArCoeffs> coeffs = getArCoeffs();
+	if (coeffs.get() == NULL 
+			&& (!batchable() || useCirculant() || useStateSpace())) {
+		// The random numbers must come from the generator that is 
+		//	active now, so compute the light curve right away
+		prepareFluxes();
+		return;
+	}
+	
+	StochasticRng rng = checkout();
+	std::vector<double> temp(size());
+	if (coeffs.get() != NULL) {
+		arDeviates(*coeffs, rng, temp);
+	} else if (!temp.empty()) {
+		rng.fillNormal(&temp[0], temp.size(), 1.0);
+	}
+	
+	// IMPORTANT: no exceptions past this point
+	
+	swap(deviates, temp);
+	commit(rng);
+}
+
+/** Computes the realizations of several light curves at once
+ *
+ * Consecutive light curves that have the same covariance matrix are 
+ * computed with a single call to utils::multiNormalBatch(), which 
+ * is considerably faster than computing them one by one. Consecutive 
+ * light curves that share the same getArCoeffs() are advanced in 
+ * lockstep, one observation at a time. Light curves whose random 
+ * numbers were not drawn in advance with drawDeviates() are skipped, 
+ * and computed when getFluxes() is called as usual. Light curves 
+ * generated one season at a time (see setSeasonTolerance()) or from 
+ * a sparse covariance matrix (see setSparseTolerance()) are computed 
+ * individually, since their factors are cached by utils::multiNormal() 
+ * instead.
+ *
+ * @param[in] curves The light curves to compute.
+ *
+ * @pre drawDeviates() has been called for each element of @p curves 
+ *	that should be computed
+ *
+ * @post Each element of @p curves for which drawDeviates() was called 
+ *	stores the same magnitudes it would have had if getFluxes() had been 
+ *	called instead.
+ *
+ * @perform O(GN<sup>3</sup> + KN<sup>2</sup>) time, where N is the 
+ *	length of the light curves, K = @p curves.size(), and G is the 
+ *	number of runs of light curves with different covariance matrices 
+ *	that are not cached by utils::multiNormal(). O(KN) time for 
+ *	light curves computed from getArCoeffs().
+ * @perfmore O(N<sup>2</sup> + KN) memory
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the light curves.
+ * @exception std::logic_error Thrown if a bug was found in the flux 
+ *	calculations.
+ *
+ * @exceptsafe Each element of @p curves is either computed or unchanged 
+ *	in the event of an exception.
+ */
+void GaussianProcess::solveBatch(const std::vector<const GaussianProcess*>& curves) {
+	using std::swap;
+
+	size_t first = 0;
+	while (first < curves.size()) {
+		if (curves[first]->deviates.empty()) {
+			first++;
+			continue;
+		}
+		
+		// Collect all following curves compatible with curves[first]
+		// Coefficient tables are cached, so compatible curves share 
+		//	the same table
+		shared_ptr<const ArCoeffs> coeffs = curves[first]->getArCoeffs();
+		std::vector<size_t> seasons;
+		if (coeffs.get() == NULL && curves[first]->useSeasons() 
+				&& curves[first]->findSeasons(seasons)) {
+			// Never forms the full covariance matrix
+			std::vector<double> temp;
+			swap(temp, curves[first]->deviates);
+			try {
+				curves[first]->seasonNormal(seasons, temp);
+			} catch (...) {
+				swap(temp, curves[first]->deviates);
+				throw;
+			}
+			
+			// IMPORTANT: no exceptions past this point
+			
+			curves[first]->scaleToAmplitude(temp);
+			curves[first]->setMags(temp);
+			first++;
+			continue;
+		}
+		utils::SparseCovar sparse;
+		if (coeffs.get() == NULL && curves[first]->useSparse() 
+				&& curves[first]->sparseCovar(sparse)) {
+			std::vector<double> temp;
+			swap(temp, curves[first]->deviates);
+			bool solved = false;
+			try {
+				solved = curves[first]->sparseNormal(sparse, temp);
+			} catch (...) {
+				swap(temp, curves[first]->deviates);
+				throw;
+			}
+			
+			if (solved) {
+				// IMPORTANT: no exceptions past this point
+				
+				curves[first]->scaleToAmplitude(temp);
+				curves[first]->setMags(temp);
+				first++;
+				continue;
+			}
+			// Fall back to the full covariance matrix
+			swap(temp, curves[first]->deviates);
+		}
+		shared_ptr<const gsl_matrix> corrs;
+		boost::uint64_t token = 0;
+		if (coeffs.get() == NULL) {
+			corrs = curves[first]->getCovar();
+			token = curves[first]->getCovarToken();
+		}
+		size_t last = first + 1;
+		for(; last < curves.size() && !curves[last]->deviates.empty(); last++) {
+			if (curves[last]->getArCoeffs().get() != coeffs.get()) {
+				break;
+			}
+			if (coeffs.get() == NULL && curves[last]->useSeasons() 
+					&& curves[last]->findSeasons(seasons)) {
+				break;
+			}
+			if (coeffs.get() == NULL && curves[last]->useSparse() 
+					&& curves[last]->sparseCovar(sparse)) {
+				break;
+			}
+			if (coeffs.get() == NULL) {
+				// Identifiers are much faster to compare than matrices
+				const boost::uint64_t nextToken = curves[last]->getCovarToken();
+				if (token != 0 && nextToken != 0) {
+					if (nextToken != token) {
+						break;
+					}
+				} else {
+					shared_ptr<const gsl_matrix> nextCorrs = curves[last]->getCovar();
+					if (!utils::sameMatrix(nextCorrs.get(), corrs.get())) {
+						break;
+					}
+				}
+			}
+		}
+		
+		// Move rather than copy the deviates, restoring them if the 
+		//	light curves can't be computed
+		std::vector<std::vector<double> > temp(last - first);
+		for(size_t i = 0; i < temp.size(); i++) {
+			swap(temp[i], curves[first+i]->deviates);
+		}
+		try {
+			if (coeffs.get() != NULL) {
+				std::vector<double> amplitudes;
+				amplitudes.reserve(temp.size());
+				for(size_t i = 0; i < temp.size(); i++) {
+					amplitudes.push_back(curves[first+i]->getAmplitude());
+				}
+				arBatch(*coeffs, amplitudes, temp);
+			} else {
+				utils::multiNormalBatch(temp, corrs, temp, token);
+			}
+		} catch (const std::invalid_argument& e) {
+			// multiNormalBatch() leaves temp unchanged in the event 
+			//	of an exception
+			for(size_t i = 0; i < temp.size(); i++) {
+				swap(temp[i], curves[first+i]->deviates);
+			}
+			throw std::logic_error("Gaussian process uses invalid correlation matrix.\nOriginal error: " + std::string(e.what()));
+		} catch (...) {
+			for(size_t i = 0; i < temp.size(); i++) {
+				swap(temp[i], curves[first+i]->deviates);
+			}
+			throw;
+		}
+		
+		// IMPORTANT: no exceptions past this point
+		
+		for(size_t i = 0; i < temp.size(); i++) {
+			// arBatch() already applies the amplitudes
+			if (coeffs.get() == NULL) {
+				curves[first+i]->scaleToAmplitude(temp[i]);
+			}
+			curves[first+i]->setMags(temp[i]);
+		}
+		first = last;
+	}
 }
 
 /** Computes a realization of the light curve. 
  *
  * The light curve is computed from @p times and the internal random 
- * number generator, and its values are stored in @p fluxes.
+ * number generator, and its values are stored in @p mags.
  *
- * This implementation of solveFluxes() uses a generic, but slow, method of 
+ * This implementation of solveMags() uses a generic, but slow, method of 
  * generating Gaussian process instances. If a more efficient algorithm is 
  * available for a particular type of Gaussian process, you should override 
  * this function with a more specialized implementation.
  *
- * @param[out] fluxes The flux vector to update.
+ * The light curve is generated with covariance getCovar() and then 
+ * multiplied by getAmplitude(), so that light curves differing only 
+ * in amplitude can share one factorization of the covariance matrix.
+ *
+ * If utils::setCovarFactor() was called with 
+ * @ref utils::FACTOR_CIRCULANT "FACTOR_CIRCULANT", the process is 
+ * stationary, and the times lie on a regular grid, the light curve is 
+ * instead generated on the whole grid by circulant embedding, which 
+ * needs only two Fourier transforms. The grid is then subsampled at 
+ * the observed times.
+ *
+ * If setSeasonTolerance() was called with a nonzero tolerance, the 
+ * process is stationary, and its kernel falls below the tolerance 
+ * across one or more gaps in the times, each season between such gaps 
+ * is instead generated from its own block of the covariance matrix. 
+ * This takes precedence over circulant embedding.
+ *
+ * If setSparseTolerance() was called with a nonzero tolerance, the 
+ * process is stationary, and few enough pairs of observations have 
+ * covariances above the tolerance, the light curve is otherwise 
+ * generated from a sparse covariance matrix, without forming the 
+ * full one. Circulant embedding and seasons take precedence over 
+ * the sparse matrix.
+ *
+ * If setNystromRank() was called with a nonzero rank smaller than the 
+ * number of times and the process is stationary, the light curve is 
+ * instead generated from a low-rank approximation that never forms 
+ * the full covariance matrix. This takes precedence over seasons and 
+ * circulant embedding.
+ *
+ * If setStateSpaceOrder() was called with a nonzero order and the 
+ * process has a state-space approximation, the light curve is instead 
+ * generated from that approximation in linear time. This takes 
+ * precedence over the low-rank approximation and circulant embedding.
+ *
+ * If getArCoeffs() describes the process, the light curve is instead 
+ * generated exactly, one observation at a time. This takes precedence 
+ * over all other methods.
+ *
+ * @param[out] mags The magnitude vector to update.
  * 
- * @post getFluxes() will now return the correct light curve.
+ * @post getFluxes() and fillMags() will now return the correct light curve.
  * 
- * @post @p fluxes.size() = getTimes().size()
+ * @post @p mags.size() = getTimes().size()
  * @post if getTimes()[i] = getTimes()[j] for i &ne; j, then 
- *	@p fluxes[i] = @p fluxes[j]
+ *	@p mags[i] = @p mags[j]
  * 
- * @post No element of @p fluxes is NaN
- * @post All elements in @p fluxes are non-negative
- * @post The median of the flux is one, when averaged over many elements and 
+ * @post No element of @p mags is NaN
+ * @post The median of @p mags is zero, when averaged over many elements and 
  *	many light curve instances.
  *
- * @perform O(N<sup>3</sup>) time, where N = @p times.size()
- * @perfmore O(N<sup>2</sup>) memory
+ * @perform O(N<sup>3</sup>) time, where N = @p times.size(). 
+ *	O(M log M) time if the light curve is generated by circulant 
+ *	embedding, where M is the number of grid points, or 
+ *	O(&sum; N<sub>s</sub><sup>3</sup>) time if it is generated one 
+ *	season at a time, where N<sub>s</sub> is the length of season s, 
+ *	or O(&sum; w<sub>i</sub><sup>2</sup>) time if it is generated from 
+ *	a sparse covariance matrix with w<sub>i</sub> elements in row i.
+ * @perfmore O(N<sup>2</sup>) memory, or O(M) memory if the light curve 
+ *	is generated by circulant embedding, or 
+ *	O(&sum; N<sub>s</sub><sup>2</sup>) memory if it is generated one 
+ *	season at a time, or O(&sum; w<sub>i</sub>) memory if it is 
+ *	generated from a sparse covariance matrix.
  * 
  * @exception std::bad_alloc Thrown if there is not enough memory to compute 
  *	the light curve.
@@ -73,39 +879,742 @@ GaussianProcess::GaussianProcess(const std::vector<double>& times) : Stochastic(
  * @exceptsafe Neither the object nor the argument are changed in the 
  *	event of an exception.
  */
-void GaussianProcess::solveFluxes(std::vector<double>& fluxes) const {
+void GaussianProcess::solveMags(std::vector<double>& mags) const {
 	using std::swap;
 
-	// invariant: this->times() is sorted in ascending order
-	std::vector<double> times;
-	this->getTimes(times);
+	const size_t nTimes = size();
 	
 	// copy-and-swap
-	auto_ptr<StochasticRng> rng = checkout();
+	// Deviates drawn in advance are moved rather than copied, and 
+	//	restored if the light curve can't be computed
+	const bool drawn = !deviates.empty();
+	StochasticRng rng = checkout();
 	std::vector<double> temp;
+	if (drawn) {
+		swap(temp, deviates);
+	}
+
+	try {
+		std::vector<double> sqrtEigen;
+		std::vector<size_t> gridIndex, seasons;
+		const shared_ptr<const ArCoeffs> coeffs = getArCoeffs();
+		if (nTimes > 0 && coeffs.get() != NULL) {
+			if (!drawn) {
+				arDeviates(*coeffs, rng, temp);
+			}
+			
+			const double amplitude = getAmplitude();
+			arRecurrence(*coeffs, &amplitude, &temp[0], 1);
+		} else if (nTimes > 0 && !drawn && useStateSpace()) {
+			stateSpaceRealization(rng, temp);
+			
+			scaleToAmplitude(temp);
+		} else if (nTimes > 0 && !drawn && useNystrom()) {
+			nystromRealization(rng, temp);
+			
+			scaleToAmplitude(temp);
+		} else if (nTimes > 0 && useSeasons() && findSeasons(seasons)) {
+			if (!drawn) {
+				temp.resize(nTimes);
+				rng.fillNormal(&temp[0], nTimes, 1.0);
+			}
+			
+			seasonNormal(seasons, temp);
+			
+			scaleToAmplitude(temp);
+		} else if (nTimes > 0 && !drawn && useCirculant() 
+				&& circulantEmbedding(sqrtEigen, gridIndex)) {
+			std::vector<double> grid(2*(sqrtEigen.size() - 1));
+			// &grid[0] is not defined for an empty vector
+			if (!grid.empty()) {
+				rng.fillNormal(&grid[0], grid.size(), 1.0);
+			}
+			
+			try {
+				utils::circulantNormal(sqrtEigen, grid, grid);
+			} catch (const std::invalid_argument& e) {
+				throw std::logic_error("Gaussian process uses invalid circulant embedding.\nOriginal error: " + std::string(e.what()));
+			}
+			
+			temp.reserve(nTimes);
+			for(size_t i = 0; i < nTimes; i++) {
+				temp.push_back(grid[gridIndex[i]]);
+			}
+			
+			scaleToAmplitude(temp);
+		} else if (nTimes > 0) {
+			if (!drawn) {
+				temp.resize(nTimes);
+				rng.fillNormal(&temp[0], nTimes, 1.0);
+			}
+			
+			utils::SparseCovar sparse;
+			if (!(useSparse() && sparseCovar(sparse) && sparseNormal(sparse, temp))) {
+				shared_ptr<const gsl_matrix> corrs = getCovar();
+				
+				try {
+					utils::multiNormal(temp, corrs, temp, getCovarToken());
+				} catch (const std::invalid_argument& e) {
+					throw std::logic_error("Gaussian process uses invalid correlation matrix.\nOriginal error: " + std::string(e.what()));
+				}
+			}
+			
+			scaleToAmplitude(temp);
+		}
+	} catch (...) {
+		// multiNormal() leaves temp unchanged in the event of an exception
+		if (drawn) {
+			swap(temp, deviates);
+		}
+		throw;
+	}
+	
+	// IMPORTANT: no exceptions past this point
+	
+	swap(mags, temp);
+	if (!drawn) {
+		commit(rng);
+	}
+}
+
+/** Tests whether the light curve is computed from getCovar() by 
+ *	the default implementation of solveMags()
+ *
+ * @return true, unless overridden by a subclass.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool GaussianProcess::batchable() const {
+	return true;
+}
+
+/** Tests whether the covariance of the process depends only on the 
+ *	separation between two times
+ *
+ * @return false, unless overridden by a subclass.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool GaussianProcess::stationary() const {
+	return false;
+}
+
+/** Returns the covariance of the process at two times separated by 
+ *	a given interval, in units of getAmplitude()<sup>2</sup>
+ *
+ * Subclasses that override stationary() to return true must also 
+ * override this function.
+ *
+ * @param[in] deltaT The separation between the two times.
+ *
+ * @return The covariance at lag @p deltaT.
+ *
+ * @exception std::logic_error Thrown if the process is not stationary.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+double GaussianProcess::kernel(double deltaT) const {
+	throw std::logic_error("Non-stationary Gaussian process has no kernel (lag " 
+		+ lexical_cast<std::string>(deltaT) + ").");
+}
+
+/** Tests whether solveMags() should try circulant embedding
+ *
+ * @return true if @ref utils::FACTOR_CIRCULANT "FACTOR_CIRCULANT" was 
+ *	selected and the process is stationary.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool GaussianProcess::useCirculant() const {
+	return batchable() && stationary() 
+		&& utils::getCovarFactor() == utils::FACTOR_CIRCULANT;
+}
+
+/** Tests whether the process can be approximated by a state-space 
+ *	model
+ *
+ * @return false, unless overridden by a subclass.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool GaussianProcess::hasStateSpace() const {
+	return false;
+}
 
-	if (times.size() > 0) {
-		temp.reserve(times.size());
+/** Computes an approximate realization of the process with a 
+ *	state-space model, in units of getAmplitude()
+ *
+ * Subclasses that override hasStateSpace() to return true must also 
+ * override this function.
+ *
+ * @param[in] rng The random number generator to use.
+ * @param[out] mags The realization at each of getTimes().
+ *
+ * @exception std::logic_error Thrown if the process has no state-space 
+ *	approximation.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void GaussianProcess::stateSpaceRealization(const StochasticRng&, 
+		std::vector<double>&) const {
+	throw std::logic_error("Gaussian process has no state-space approximation.");
+}
+
+/** Tests whether solveMags() should use a state-space model
+ *
+ * @return true if setStateSpaceOrder() was given a nonzero order and 
+ *	the process has a state-space approximation.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool GaussianProcess::useStateSpace() const {
+	return batchable() && hasStateSpace() && getStateSpaceOrder() > 0;
+}
+
+/** Tests whether solveMags() should use a Nystr&ouml;m approximation
+ *
+ * @return true if setNystromRank() was given a nonzero rank smaller 
+ *	than the number of observations, and the process is stationary.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool GaussianProcess::useNystrom() const {
+	const long rank = getNystromRank();
+	return batchable() && stationary() && rank > 0 
+		&& static_cast<size_t>(rank) < size();
+}
+
+/** Computes an approximate realization of the process with a 
+ *	Nystr&ouml;m approximation, in units of getAmplitude()
+ *
+ * The inducing points are spaced evenly between the first and last 
+ * of getTimes(). The low-rank part of the realization is 
+ * @f$K_{nm} K_{mm}^{-1/2} z@f$, where eigenvalues of @f$K_{mm}@f$ 
+ * below 10<sup>-10</sup> of the largest are discarded, and the 
+ * variance it misses at each time is added back as independent 
+ * noise. Repeated times share their noise, so that they keep the 
+ * same value.
+ *
+ * @param[in] rng The random number generator to use.
+ * @param[out] mags The realization at each of getTimes().
+ *
+ * @pre stationary() returns true
+ * @pre getNystromRank() > 0
+ *
+ * @post nystromError() is at least the largest kernel error of this 
+ *	realization.
+ *
+ * @perform O(m + N) random numbers, O(m<sup>3</sup> + m<sup>2</sup>N) 
+ *	time, and O(m<sup>2</sup> + N) memory, where m = 
+ *	min(getNystromRank(), N) and N = size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the light curve.
+ * @exception std::runtime_error Thrown if the kernel of the inducing 
+ *	points could not be diagonalized.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void GaussianProcess::nystromRealization(const StochasticRng& rng, 
+		std::vector<double>& mags) const {
+	using std::swap;
+
+	const std::vector<double>& times = this->timeView();
+	const size_t nTimes = times.size();
+	const size_t nInduce = std::min(nTimes, 
+		static_cast<size_t>(getNystromRank()));
+	
+	std::vector<double> temp;
+	if (nTimes == 0 || nInduce == 0) {
+		swap(mags, temp);
+		return;
+	}
+	
+	// invariant: times is sorted
+	const double start = times.front();
+	const double span  = times.back() - start;
+	std::vector<double> induce;
+	induce.reserve(nInduce);
+	for(size_t j = 0; j < nInduce; j++) {
+		induce.push_back(nInduce > 1 
+			? start + span * static_cast<double>(j) / static_cast<double>(nInduce - 1) 
+			: start + 0.5*span);
+	}
+	
+	// Whiten the inducing points: kmm = vecs * diag(vals) * transpose(vecs)
+	shared_ptr<gsl_matrix> kmm(checkAlloc(gsl_matrix_alloc(nInduce, nInduce)), 
+		&gsl_matrix_free);
+	for(size_t j = 0; j < nInduce; j++) {
+		for(size_t k = 0; k <= j; k++) {
+			const double cov = kernel(fabs(induce[j] - induce[k]));
+			gsl_matrix_set(kmm.get(), j, k, cov);
+			gsl_matrix_set(kmm.get(), k, j, cov);
+		}
+	}
+	shared_ptr<gsl_vector> vals(checkAlloc(gsl_vector_alloc(nInduce)), 
+		&gsl_vector_free);
+	shared_ptr<gsl_matrix> vecs(checkAlloc(gsl_matrix_alloc(nInduce, nInduce)), 
+		&gsl_matrix_free);
+	{
+		shared_ptr<gsl_eigen_symmv_workspace> work(
+			checkAlloc(gsl_eigen_symmv_alloc(nInduce)), 
+			&gsl_eigen_symmv_free);
+		gslCheck( gsl_eigen_symmv(kmm.get(), vals.get(), vecs.get(), 
+			work.get()), "While generating Nystrom approximation: ");
+	}
+	
+	// whiten[j][k] = vecs[j][k] / sqrt(vals[k]) for each retained k
+	double maxVal = 0.0;
+	for(size_t k = 0; k < nInduce; k++) {
+		maxVal = std::max(maxVal, gsl_vector_get(vals.get(), k));
+	}
+	std::vector<size_t> kept;
+	for(size_t k = 0; k < nInduce; k++) {
+		if (gsl_vector_get(vals.get(), k) > 1e-10 * maxVal) {
+			kept.push_back(k);
+		}
+	}
+	const size_t nKept = kept.size();
+	std::vector<double> whiten(nInduce * nKept);
+	for(size_t j = 0; j < nInduce; j++) {
+		for(size_t k = 0; k < nKept; k++) {
+			whiten[j*nKept + k] = gsl_matrix_get(vecs.get(), j, kept[k]) 
+				/ sqrt(gsl_vector_get(vals.get(), kept[k]));
+		}
+	}
+	
+	// The first nKept deviates drive the low-rank part, the rest the 
+	//	independent noise
+	std::vector<double> z(nKept + nTimes);
+	rng.fillNormal(&z[0], z.size(), 1.0);
+	
+	const double variance = kernel(0.0);
+	double worst = 0.0;
+	std::vector<double> cross(nInduce), proj(nKept);
+	temp.reserve(nTimes);
+	for(size_t i = 0; i < nTimes; i++) {
+		if (i > 0 && times[i] == times[i-1]) {
+			temp.push_back(temp.back());
+			continue;
+		}
+		
+		for(size_t j = 0; j < nInduce; j++) {
+			cross[j] = kernel(fabs(times[i] - induce[j]));
+		}
+		std::fill(proj.begin(), proj.end(), 0.0);
+		for(size_t j = 0; j < nInduce; j++) {
+			const double* row = &whiten[j*nKept];
+			for(size_t k = 0; k < nKept; k++) {
+				proj[k] += cross[j] * row[k];
+			}
+		}
+		
+		double value = 0.0, captured = 0.0;
+		for(size_t k = 0; k < nKept; k++) {
+			value    += proj[k] * z[k];
+			captured += proj[k] * proj[k];
+		}
+		const double missing = std::max(0.0, variance - captured);
+		value += sqrt(missing) * z[nKept + i];
 		
-		for(size_t i = 0; i < times.size(); i++) {
-			temp.push_back(rng->rNorm());
+		temp.push_back(value);
+		worst = std::max(worst, missing);
+	}
+	
+	{
+		boost::mutex::scoped_lock guard(nystromErrorLock());
+		nystromWorstError() = std::max(nystromWorstError(), 
+			variance > 0.0 ? worst / variance : 0.0);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(mags, temp);
+}
+
+/** Tests whether solveMags() should try to generate each season 
+ *	separately
+ *
+ * @return true if setSeasonTolerance() was given a nonzero tolerance 
+ *	and the process is stationary.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool GaussianProcess::useSeasons() const {
+	return batchable() && stationary() && getSeasonTolerance() > 0.0;
+}
+
+/** Divides the light curve into nearly uncorrelated seasons
+ *
+ * A new season starts after every gap between consecutive times 
+ * across which the kernel is at most getSeasonTolerance() of the 
+ * variance. Since the kernels of the stationary processes fall off 
+ * monotonically, observations in different seasons are correlated 
+ * no more strongly than those on either side of the gap between them.
+ *
+ * @param[out] starts The index of the first observation of each season, 
+ *	in increasing order, starting with 0.
+ *
+ * @return false if the light curve has only one season. In this case, 
+ *	@p starts is unchanged.
+ *
+ * @pre stationary() returns true
+ * @pre |kernel()| does not increase with the lag
+ *
+ * @post If the return value is true, seasonError() is at least the 
+ *	largest kernel across a gap between the seasons, as a fraction 
+ *	of the variance.
+ *
+ * @perform O(N) time, where N = size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the seasons.
+ *
+ * @exceptsafe The argument is unchanged in the event of an exception.
+ */
+bool GaussianProcess::findSeasons(std::vector<size_t>& starts) const {
+	using std::swap;
+
+	const std::vector<double>& times = this->timeView();
+	const double variance = kernel(0.0);
+	if (times.size() < 2 || !(variance > 0.0)) {
+		return false;
+	}
+	const double tolerance = getSeasonTolerance();
+	
+	// invariant: times is sorted
+	std::vector<size_t> temp(1, 0);
+	double worst = 0.0;
+	for(size_t i = 1; i < times.size(); i++) {
+		const double gap = times[i] - times[i-1];
+		if (gap > 0.0) {
+			const double coupling = fabs(kernel(gap)) / variance;
+			if (coupling <= tolerance) {
+				temp.push_back(i);
+				worst = std::max(worst, coupling);
+			}
 		}
+	}
+	if (temp.size() < 2) {
+		return false;
+	}
+	
+	{
+		boost::mutex::scoped_lock guard(nystromErrorLock());
+		seasonWorstError() = std::max(seasonWorstError(), worst);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(starts, temp);
+	return true;
+}
+
+/** Transforms uncorrelated Gaussian random numbers into a realization 
+ *	of the process, one season at a time
+ *
+ * Each season is passed to utils::multiNormal() with the covariance 
+ * of its own observations, so its factorization is cached and reused 
+ * like that of any other covariance matrix. Seasons observed at the 
+ * same relative times, as in surveys with a fixed nightly schedule, 
+ * share one factorization.
+ *
+ * @param[in] starts The seasons, as found by findSeasons().
+ * @param[in,out] mags On input, independent standard normal deviates, 
+ *	one for each of getTimes(). On output, the corresponding 
+ *	realization of the process, in units of getAmplitude().
+ *
+ * @pre @p starts is sorted, starts with 0, and has no element greater 
+ *	than or equal to size()
+ * @pre @p mags.size() = size()
+ *
+ * @perform O(&sum; N<sub>s</sub><sup>3</sup>) time if none of the 
+ *	seasons' factorizations are cached, and 
+ *	O(&sum; N<sub>s</sub><sup>2</sup>) time otherwise, where 
+ *	N<sub>s</sub> is the length of season s
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the light curve.
+ * @exception std::logic_error Thrown if a bug was found in the 
+ *	covariance calculations.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void GaussianProcess::seasonNormal(const std::vector<size_t>& starts, 
+		std::vector<double>& mags) const {
+	using std::swap;
+
+	const std::vector<double>& times = this->timeView();
+	std::vector<double> temp(mags.size());
+	for(size_t s = 0; s < starts.size(); s++) {
+		const size_t first = starts[s];
+		const size_t last  = (s + 1 < starts.size() ? starts[s+1] : times.size());
+		const size_t n = last - first;
 		
-		shared_ptr<gsl_matrix> corrs = getCovar();
+		// Subtracting the start of the season keeps the lags of 
+		//	identically scheduled seasons bitwise equal
+		shared_ptr<gsl_matrix> block(checkAlloc(utils::largeMatrixAlloc(n, n)), 
+			&gsl_matrix_free);
+		for(size_t j = 0; j < n; j++) {
+			const double tj = times[first+j] - times[first];
+			for(size_t k = 0; k <= j; k++) {
+				const double cov = kernel(fabs(tj - (times[first+k] - times[first])));
+				gsl_matrix_set(block.get(), j, k, cov);
+				gsl_matrix_set(block.get(), k, j, cov);
+			}
+		}
 		
+		std::vector<double> season(mags.begin() + first, mags.begin() + last);
 		try {
-			utils::multiNormal(temp, corrs, temp);
+			utils::multiNormal(season, block, season);
 		} catch (const std::invalid_argument& e) {
-			throw std::logic_error("Gaussian process uses invalid correlation matrix.\nOriginal error: " + std::string(e.what()));
+			throw std::logic_error("Gaussian process uses invalid seasonal correlation matrix.\nOriginal error: " + std::string(e.what()));
+		}
+		std::copy(season.begin(), season.end(), temp.begin() + first);
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(mags, temp);
+}
+
+/** Tests whether solveMags() should try to use a sparse covariance 
+ *	matrix
+ *
+ * @return true if setSparseTolerance() was given a nonzero tolerance 
+ *	and the process is stationary.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool GaussianProcess::useSparse() const {
+	return batchable() && stationary() && getSparseTolerance() > 0.0;
+}
+
+/** Computes the covariance matrix of the light curve, omitting 
+ *	covariances below getSparseTolerance()
+ *
+ * Since the times are sorted and the kernels of the stationary 
+ * processes fall off monotonically, the covariances above the 
+ * tolerance in each row form a single run ending at the diagonal, 
+ * which starts no earlier than the run in the previous row.
+ *
+ * @param[out] covar The covariance matrix for the Gaussian process, 
+ *	in units of getAmplitude().
+ *
+ * @return false if more than a quarter of the elements of the 
+ *	covariance matrix exceed the tolerance, in which case factoring 
+ *	the full matrix is faster. In this case, @p covar is unchanged.
+ *
+ * @pre stationary() returns true
+ * @pre |kernel()| does not increase with the lag
+ *
+ * @perform O(N + W) time, where N = size() and W is the number of 
+ *	pairs of observations whose covariance exceeds the tolerance
+ * @perfmore O(N + W) memory
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the matrix.
+ *
+ * @exceptsafe The argument is unchanged in the event of an exception.
+ */
+bool GaussianProcess::sparseCovar(utils::SparseCovar& covar) const {
+	const std::vector<double>& times = this->timeView();
+	const size_t N = times.size();
+	const double variance = kernel(0.0);
+	if (N < 2 || !(variance > 0.0)) {
+		return false;
+	}
+	const double cutoff = getSparseTolerance() * variance;
+	const size_t maxStored = N * (N+1) / 4;
+	
+	utils::SparseCovar temp;
+	temp.first.reserve(N);
+	temp.offset.reserve(N+1);
+	// invariant: times is sorted
+	size_t first = 0;
+	for(size_t i = 0; i < N; i++) {
+		while (first < i && fabs(kernel(times[i] - times[first])) <= cutoff) {
+			first++;
+		}
+		if (temp.values.size() + (i - first + 1) > maxStored) {
+			return false;
 		}
 		
-		utils::magToFlux(temp, temp);
+		temp.first.push_back(first);
+		for(size_t k = first; k <= i; k++) {
+			temp.values.push_back(kernel(times[i] - times[k]));
+		}
+		temp.offset.push_back(temp.values.size());
 	}
 	
-	// IMPORTANT: no exceptions past this point
+	// IMPORTANT: no exceptions beyond this point
 	
-	swap(fluxes, temp);
-	commit(rng);
+	covar.first.swap(temp.first);
+	covar.offset.swap(temp.offset);
+	covar.values.swap(temp.values);
+	return true;
+}
+
+/** Transforms uncorrelated Gaussian random numbers into a realization 
+ *	of the process, using a sparse covariance matrix
+ *
+ * @param[in] covar The covariance matrix, as found by sparseCovar().
+ * @param[in,out] mags On input, independent standard normal deviates, 
+ *	one for each of getTimes(). On output, the corresponding 
+ *	realization of the process, in units of getAmplitude().
+ *
+ * @return false if @p covar is not positive definite, which may happen 
+ *	if the dropped covariances were needed to keep it so. In this case, 
+ *	@p mags is unchanged.
+ *
+ * @pre @p mags.size() = size()
+ *
+ * @perform O(&sum; w<sub>i</sub><sup>2</sup>) time if the factorization 
+ *	of @p covar is not cached, and O(W) time otherwise, where 
+ *	w<sub>i</sub> is the number of stored elements in row i and 
+ *	W = &sum; w<sub>i</sub>
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the light curve.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+bool GaussianProcess::sparseNormal(const utils::SparseCovar& covar, 
+		std::vector<double>& mags) const {
+	try {
+		utils::multiNormal(mags, covar, mags);
+	} catch (const std::invalid_argument& e) {
+		// multiNormal() leaves mags unchanged in the event of an exception
+		return false;
+	}
+	return true;
+}
+
+/** The largest circulant embedding tried by circulantEmbedding(), as 
+ *	a multiple of the smallest embedding of the grid
+ */
+const size_t MAX_EMBED_FACTOR = 16;
+
+/** Embeds the covariance of the light curve in a circulant matrix
+ *
+ * If the smallest embedding is not positive semidefinite, 
+ * successively larger embeddings are tried, up to 16 times the 
+ * smallest.
+ *
+ * @param[out] sqrtEigen The square roots of the distinct eigenvalues 
+ *	of the embedding, as given by utils::circulantSpectrum().
+ * @param[out] gridIndex The position of each of the light curve's 
+ *	times on the grid.
+ *
+ * @return false if the times do not lie on a regular grid, or if none 
+ *	of the embeddings are positive semidefinite. In this case, the 
+ *	arguments are unchanged.
+ *
+ * @pre stationary() returns true
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the embedding.
+ * @exception std::logic_error Thrown if a bug was found in the 
+ *	embedding calculations.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+bool GaussianProcess::circulantEmbedding(std::vector<double>& sqrtEigen, 
+		std::vector<size_t>& gridIndex) const {
+	using std::swap;
+
+	const std::vector<double>& times = this->timeView();
+	double step;
+	std::vector<size_t> index;
+	if (!utils::regularCadence(times, step, index)) {
+		return false;
+	}
+	
+	// invariant: times is sorted, so index.back() is the last grid point
+	const size_t minSize = utils::circulantSize(index.back() + 1);
+	for(size_t n = minSize; n <= MAX_EMBED_FACTOR * minSize; n *= 2) {
+		std::vector<double> autocov;
+		autocov.reserve(n/2 + 1);
+		for(size_t j = 0; j <= n/2; j++) {
+			autocov.push_back(kernel(static_cast<double>(j) * step));
+		}
+		
+		try {
+			if (utils::circulantSpectrum(autocov, sqrtEigen)) {
+				// IMPORTANT: no exceptions beyond this point
+				swap(gridIndex, index);
+				return true;
+			}
+		} catch (const std::invalid_argument& e) {
+			throw std::logic_error("Could not embed Gaussian process covariance.\nOriginal error: " + std::string(e.what()));
+		}
+	}
+	
+	return false;
+}
+
+/** Scales a realization with covariance getCovar() to the amplitude 
+ *	of the light curve
+ *
+ * @param[in,out] mags A realization of the Gaussian process with 
+ *	covariance getCovar(). Replaced with the corresponding magnitudes.
+ *
+ * @post @p mags is scaled by getAmplitude().
+ *
+ * @perform Scales @p mags in place, in a single pass.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void GaussianProcess::scaleToAmplitude(std::vector<double>& mags) const {
+	const double amplitude = getAmplitude();
+	for(std::vector<double>::iterator it = mags.begin(); it != mags.end(); it++) {
+		*it *= amplitude;
+	}
+}
+
+/** Returns the factor by which a light curve with covariance 
+ *	getCovar() must be scaled.
+ *
+ * The default implementation returns 1, so that getCovar() gives the 
+ * full covariance matrix. Subclasses whose kernel has the form 
+ * @f$\sigma^2 K@f$ should instead return @f$\sigma@f$ here and 
+ * @f$K@f$ from getCovar().
+ *
+ * @return The root-mean-square amplitude, relative to getCovar().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double GaussianProcess::getAmplitude() const {
+	return 1.0;
+}
+
+/** Returns an identifier of the matrix returned by getCovar(), or 0 
+ *	if it has none
+ *
+ * Subclasses whose covariance matrices are determined by a few 
+ * parameters may return a hash of the parameters and the times, so 
+ * that utils::multiNormal() and solveBatch() can recognize the matrix 
+ * without comparing its elements.
+ *
+ * @return 0, unless overridden by a subclass. Any other value must be 
+ *	the same for two light curves iff their covariance matrices are 
+ *	the same.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::uint64_t GaussianProcess::getCovarToken() const {
+	return 0;
+}
+
+/** Returns the coefficients for generating the process one 
+ *	observation at a time, in units of getAmplitude().
+ *
+ * @return A null pointer, unless overridden by a subclass.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+shared_ptr<const ArCoeffs> GaussianProcess::getArCoeffs() const {
+	return shared_ptr<const ArCoeffs>();
 }
 
 /** Approximate comparison function that handles zeros cleanly.
@@ -134,4 +1643,114 @@ bool cacheCheck(double x, double y) {
 	}
 }
 
+/** Tests whether two cadences have the same times, in constant time
+ *
+ * Intended for use only by implementations of GaussianProcess::getCovar()
+ *
+ * @param[in] a, b The cadences to compare.
+ *
+ * @return true if the cadences share their times, or have the same 
+ *	number of times and the same hash. Different times have the same 
+ *	hash with a probability of about 2<sup>-64</sup>.
+ *
+ * @perform Constant time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool sameCadence(const Cadence& a, const Cadence& b) {
+	return a.sameAs(b) || (a.size() == b.size() && a.getHash() == b.getHash());
+}
+
+/** Combines a hash with the bytes of a value
+ *
+ * Intended for use only by implementations of 
+ * GaussianProcess::getCovarToken()
+ *
+ * @param[in] hash The hash to update.
+ * @param[in] x The value to add to the hash.
+ *
+ * @return An FNV-1a hash of the bytes of @p x, starting from @p hash.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::uint64_t hashValue(boost::uint64_t hash, double x) {
+	return utils::fnvHash(hash, &x, sizeof(x));
+}
+
+/** The squared lags last computed by cadenceLags() on one thread
+ */
+struct LagCache {
+	/** Creates an empty cache
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	LagCache() : lags(), times() {
+	}
+	
+	/** The lags, or null if none have been computed */
+	shared_ptr<const LagMatrix> lags;
+	/** The times for which @p lags was computed */
+	Cadence times;
+};
+
+/** Returns the squared lags of a cadence, reusing those computed 
+ *	for the previous cadence on the same thread
+ *
+ * Intended for use only by implementations of GaussianProcess::getCovar(). 
+ * The lags do not depend on the coherence time, so a light curve 
+ * whose covariance matrix is out of date only because its coherence 
+ * time changed can rebuild the matrix from the kernel alone.
+ *
+ * @param[in] times The times at which the process is sampled.
+ *
+ * @return A pointer to the lags. The lags are shared with other light 
+ *	curves having the same times, and must not be modified.
+ *
+ * @perform O(N<sup>2</sup>) time, where N = times.size(), if the times 
+ *	are not the same as for the previous call. Otherwise, constant time.
+ * @perfmore N(N+1)/2 doubles of memory per thread
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the lags.
+ *
+ * @exceptsafe The argument is unchanged in the event of an exception.
+ *
+ * @internal @exceptsafe The internal cache provides only the basic 
+ *	exception guarantee. However, aside from run time this is not 
+ *	visible to the rest of the program.
+ */
+shared_ptr<const LagMatrix> cadenceLags(const Cadence& times) {
+	using std::swap;
+	
+	// Each thread keeps its own cache, so that light curves simulated 
+	//	in parallel neither block nor overwrite each other
+	// invariant: oldLags is empty <=> oldTimes is empty
+	static boost::thread_specific_ptr<LagCache> caches;
+	static utils::CacheCounter counter("Cadence lag matrices");
+	if (caches.get() == NULL) {
+		caches.reset(new LagCache());
+	}
+	shared_ptr<const LagMatrix>& oldLags = caches->lags;
+	Cadence& oldTimes = caches->times;
+	
+	if (oldLags.get() == NULL || !sameCadence(times, oldTimes)) {
+		// Cache is out of date
+		const utils::CacheMiss miss(counter);
+		
+		// copy-and-swap
+		shared_ptr<const LagMatrix> temp(new LagMatrix(times.timeView()));
+		Cadence newTimes = times;
+		
+		// No exceptions beyond this point
+		
+		swap(oldLags, temp);
+		swap(oldTimes, newTimes);
+		counter.setBytes(oldLags->bytes());
+	} else {
+		counter.hit();
+	}
+	
+	return oldLags;
+}
+
 }}		// end lcmc::models
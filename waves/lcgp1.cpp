@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcgp1.cpp
  * @author Krzysztof Findeisen
  * @date Created March 21, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -33,9 +33,14 @@
 #include <cmath>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/tss.hpp>
 #include <gsl/gsl_matrix.h>
+#include "../cachestats.h"
 #include "../except/data.h"
+#include "../hash.h"
+#include "kernels.tmp.h"
 #include "lightcurves_gp.h"
+#include "statespace.h"
 
 namespace lcmc { namespace models {
 
@@ -62,7 +67,7 @@ using boost::shared_ptr;
  *
  * @exceptsafe Object construction is atomic.
  */
-SimpleGp::SimpleGp(const std::vector<double>& times, double sigma, double tau) 
+SimpleGp::SimpleGp(const Cadence& times, double sigma, double tau) 
 		: GaussianProcess(times), sigma(sigma), tau(tau) {
 	if (sigma <= 0.0) {
 		throw except::BadParam("All SimpleGp light curves need positive standard deviations (gave " 
@@ -78,10 +83,47 @@ SimpleGp::SimpleGp(const std::vector<double>& times, double sigma, double tau)
  */
 bool cacheCheck(double x, double y);
 
-/** Allocates and initializes the covariance matrix for the 
- *	Gaussian process. 
+/** Tests whether two cadences have the same times, in constant time
+ */
+bool sameCadence(const Cadence& a, const Cadence& b);
+
+/** Combines a hash with the bytes of a value
+ */
+boost::uint64_t hashValue(boost::uint64_t hash, double x);
+
+/** The covariance matrix last computed by SimpleGp::getCovar() on 
+ *	one thread
+ */
+struct SimpleGpCache {
+	/** Creates an empty cache
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	SimpleGpCache() : cov(), times(), tau(0.0) {
+	}
+	
+	/** The matrix, or null if none has been computed */
+	shared_ptr<const gsl_matrix> cov;
+	/** The times for which @p cov was computed */
+	Cadence times;
+	/** The coherence time for which @p cov was computed */
+	double tau;
+};
+
+/** Returns the covariance matrix for the Gaussian process, in units 
+ *	of getAmplitude()<sup>2</sup>. 
+ *
+ * The matrix depends only on the times and the coherence time, so 
+ * light curves that differ only in amplitude share the same matrix. 
+ * The coherence time is rounded with snapTau().
+ *
+ * @return A pointer to the matrix. The matrix is shared with other 
+ *	light curves having the same times and coherence time, and must 
+ *	not be modified.
  *
- * @return A pointer containing the new matrix
+ * @perform O(N<sup>2</sup>) time, where N is the number of times, if 
+ *	the matrix is not the same as for the previous call. Otherwise, 
+ *	O(N) time.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to compute 
  *	the covariance matrix
@@ -92,57 +134,148 @@ bool cacheCheck(double x, double y);
  *	basic exception guarantee. However, aside from run time this is not 
  *	visible to the rest of the program.
  */
-shared_ptr<gsl_matrix> SimpleGp::getCovar() const {
+shared_ptr<const gsl_matrix> SimpleGp::getCovar() const {
 	using std::swap;
 	
 	// Define a cache to prevent identical simulation runs from having to 
 	//	recalculate the covariance
+	// Each thread keeps its own cache, so that light curves simulated 
+	//	in parallel neither block nor overwrite each other
 	// invariant: oldCov is empty <=> oldTimes is empty
-	static shared_ptr<gsl_matrix> oldCov;
-	static std::vector<double> oldTimes;
-	static double oldSigma = 0.0;
-	static double oldTau = 0.0;
+	static boost::thread_specific_ptr<SimpleGpCache> caches;
+	static utils::CacheCounter counter("simple_gp covariances");
+	if (caches.get() == NULL) {
+		caches.reset(new SimpleGpCache());
+	}
+	shared_ptr<const gsl_matrix>& oldCov = caches->cov;
+	Cadence& oldTimes = caches->times;
+	double& oldTau = caches->tau;
 
-	std::vector<double> times;
-	this->getTimes(times);
-	size_t nTimes = times.size();
+	const double tau = snapTau(this->tau);
 
 	if(oldCov.get() == NULL 
-			|| !cacheCheck(oldSigma, sigma)
 			|| !cacheCheck(oldTau, tau)
-			|| oldTimes.size() != nTimes
-			|| !std::equal(oldTimes.begin(), oldTimes.end(), 
-					times.begin(), &cacheCheck) ) {
+			|| !sameCadence(cadence(), oldTimes)) {
 		// Cache is out of date
+		const utils::CacheMiss miss(counter);
 		
 		// copy-and-swap
-		shared_ptr <gsl_matrix> temp(gsl_matrix_alloc(nTimes, nTimes), 
-			&gsl_matrix_free);
-		for(size_t i = 0; i < nTimes; i++) {
-			for(size_t j = 0; j < nTimes; j++) {
-				// i and j are valid indices for temp and times
-				// therefore, no out-of-range errors
-				double deltaTTau = (times[i] - times[j])/tau;
-				gsl_matrix_set(temp.get(), i, j, 
-						sigma*sigma*exp(-0.5*deltaTTau*deltaTTau));
-			}
-		}
+		// The squared lags are shared by all coherence times
+		shared_ptr<const gsl_matrix> temp = kernelMatrix(*cadenceLags(cadence()), 
+			SquaredExpKernel(1.0, tau));
+		
+		Cadence newTimes = cadence();
 		
 		// No exceptions beyond this point
 		
 		swap(oldCov, temp);
-		swap(oldTimes, times);
-		oldSigma = sigma;
+		swap(oldTimes, newTimes);
 		oldTau = tau;
+		counter.setBytes(oldCov->size1*oldCov->size2*sizeof(double));
+	} else {
+		counter.hit();
 	}
 	
 	// assert: the Cache is up-to-date
 	
-	// Return a copy of the cache as output
-	shared_ptr<gsl_matrix> cov(gsl_matrix_alloc(nTimes, nTimes), &gsl_matrix_free);
-	gsl_matrix_memcpy(cov.get(), oldCov.get());
+	return oldCov;
+}
+
+/** Returns an identifier of the matrix returned by getCovar()
+ *
+ * @return A hash of the times and the rounded coherence time, which 
+ *	is the same for any two light curves whose covariance matrices 
+ *	are the same.
+ *
+ * @perform Constant time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::uint64_t SimpleGp::getCovarToken() const {
+	static const char tag[] = "simple_gp";
+	const boost::uint64_t timeHash = cadence().getHash();
+	boost::uint64_t token = utils::fnvHash(utils::fnvBasis(), tag, sizeof(tag));
+	token = utils::fnvHash(token, &timeHash, sizeof(timeHash));
+	token = hashValue(token, snapTau(tau));
+	// 0 means the matrix has no identifier
+	return (token == 0 ? 1 : token);
+}
+
+/** Returns the factor by which a light curve with covariance 
+ *	getCovar() must be scaled.
+ *
+ * @return The root-mean-square amplitude of the Gaussian process.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double SimpleGp::getAmplitude() const {
+	return sigma;
+}
+
+/** Tests whether the covariance of the process depends only on 
+ *	the separation between two times
+ *
+ * @return true
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool SimpleGp::stationary() const {
+	return true;
+}
 
-	return cov;
+/** Returns the covariance of the process at two times separated by 
+ *	a given interval, in units of getAmplitude()<sup>2</sup>
+ *
+ * The coherence time is rounded with snapTau(), as in getCovar().
+ *
+ * @param[in] deltaT The separation between the two times.
+ *
+ * @return The Gaussian kernel evaluated at @p deltaT.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double SimpleGp::kernel(double deltaT) const {
+	const double deltaTTau = deltaT / snapTau(tau);
+	return exp(-0.5*deltaTTau*deltaTTau);
+}
+
+/** Tests whether the process can be approximated by a state-space 
+ *	model
+ *
+ * @return true
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool SimpleGp::hasStateSpace() const {
+	return true;
+}
+
+/** Computes an approximate realization of the process with a 
+ *	state-space model, in units of getAmplitude()
+ *
+ * The coherence time is rounded with snapTau(), as in getCovar().
+ *
+ * @param[in] rng The random number generator to use.
+ * @param[out] mags The realization at each of getTimes().
+ *
+ * @pre getStateSpaceOrder() > 0
+ *
+ * @perform O(nN) random numbers and O(n<sup>2</sup>N) time, where n = 
+ *	getStateSpaceOrder() and N = size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the light curve.
+ * @exception std::runtime_error Thrown if the state-space model could 
+ *	not be computed.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void SimpleGp::stateSpaceRealization(const StochasticRng& rng, 
+		std::vector<double>& mags) const {
+	const std::vector<double>& times = this->timeView();
+	
+	SquaredExpSde::get(getStateSpaceOrder()).simulate(times, snapTau(tau), 
+		rng, mags);
 }
 
 }}		// end lcmc::models
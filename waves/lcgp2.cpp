@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcgp2.cpp
  * @author Krzysztof Findeisen
  * @date Created April 29, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -33,9 +33,14 @@
 #include <cmath>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/tss.hpp>
 #include <gsl/gsl_matrix.h>
+#include "../cachestats.h"
 #include "../except/data.h"
+#include "../hash.h"
+#include "kernels.tmp.h"
 #include "lightcurves_gp.h"
+#include "statespace.h"
 
 namespace lcmc { namespace models {
 
@@ -68,7 +73,7 @@ using boost::shared_ptr;
  *
  * @todo This interface is error-prone. Redefine in terms of ADTs?
  */
-TwoScaleGp::TwoScaleGp(const std::vector<double>& times, 
+TwoScaleGp::TwoScaleGp(const Cadence& times, 
 			double sigma1, double tau1, double sigma2, double tau2) 
 		: GaussianProcess(times), sigma1(sigma1), sigma2(sigma2), 
 		tau1(tau1), tau2(tau2) {
@@ -94,10 +99,47 @@ TwoScaleGp::TwoScaleGp(const std::vector<double>& times,
  */
 bool cacheCheck(double x, double y);
 
-/** Allocates and initializes the covariance matrix for the 
- *	Gaussian process. 
+/** Tests whether two cadences have the same times, in constant time
+ */
+bool sameCadence(const Cadence& a, const Cadence& b);
+
+/** Combines a hash with the bytes of a value
+ */
+boost::uint64_t hashValue(boost::uint64_t hash, double x);
+
+/** The covariance matrix last computed by TwoScaleGp::getCovar() on 
+ *	one thread
+ */
+struct TwoScaleGpCache {
+	/** Creates an empty cache
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	TwoScaleGpCache() : cov(), times(), sigma1(0.0), sigma2(0.0), 
+			tau1(0.0), tau2(0.0) {
+	}
+	
+	/** The matrix, or null if none has been computed */
+	shared_ptr<const gsl_matrix> cov;
+	/** The times for which @p cov was computed */
+	Cadence times;
+	/** The amplitudes for which @p cov was computed */
+	double sigma1, sigma2;
+	/** The coherence times for which @p cov was computed */
+	double tau1, tau2;
+};
+
+/** Returns the covariance matrix for the Gaussian process. 
+ *
+ * Both coherence times are rounded with snapTau().
+ *
+ * @return A pointer to the matrix. The matrix is shared with other 
+ *	light curves having the same times and parameters, and must 
+ *	not be modified.
  *
- * @return A pointer containing the new matrix
+ * @perform O(N<sup>2</sup>) time, where N is the number of times, if 
+ *	the matrix is not the same as for the previous call. Otherwise, 
+ *	O(N) time.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to compute 
  *	the covariance matrix
@@ -108,64 +150,165 @@ bool cacheCheck(double x, double y);
  *	basic exception guarantee. However, aside from run time this is not 
  *	visible to the rest of the program.
  */
-shared_ptr<gsl_matrix> TwoScaleGp::getCovar() const {
+shared_ptr<const gsl_matrix> TwoScaleGp::getCovar() const {
 	using std::swap;
 	
 	// Define a cache to prevent identical simulation runs from having to 
 	//	recalculate the covariance
+	// Each thread keeps its own cache, so that light curves simulated 
+	//	in parallel neither block nor overwrite each other
 	// invariant: oldCov is empty <=> oldTimes is empty
-	static shared_ptr<gsl_matrix> oldCov;
-	static std::vector<double> oldTimes;
-	static double oldSigma1 = 0.0, oldSigma2 = 0.0;
-	static double oldTau1 = 0.0, oldTau2 = 0.0;
+	static boost::thread_specific_ptr<TwoScaleGpCache> caches;
+	static utils::CacheCounter counter("two_gp covariances");
+	if (caches.get() == NULL) {
+		caches.reset(new TwoScaleGpCache());
+	}
+	shared_ptr<const gsl_matrix>& oldCov = caches->cov;
+	Cadence& oldTimes = caches->times;
+	double& oldSigma1 = caches->sigma1;
+	double& oldSigma2 = caches->sigma2;
+	double& oldTau1   = caches->tau1;
+	double& oldTau2   = caches->tau2;
 
-	std::vector<double> times;
-	this->getTimes(times);
-	size_t nTimes = times.size();
+	const double tau1 = snapTau(this->tau1);
+	const double tau2 = snapTau(this->tau2);
 
 	if(oldCov.get() == NULL 
 			|| !cacheCheck(oldSigma1, sigma1)
 			|| !cacheCheck(oldSigma2, sigma2)
 			|| !cacheCheck(oldTau1, tau1)
 			|| !cacheCheck(oldTau2, tau2)
-			|| oldTimes.size() != nTimes
-			|| !std::equal(oldTimes.begin(), oldTimes.end(), 
-					times.begin(), &cacheCheck) ) {
-		// Cache is out of date
+			|| !sameCadence(cadence(), oldTimes)) {
 		// Cache is out of date
+		const utils::CacheMiss miss(counter);
 		
 		// copy-and-swap
-		shared_ptr <gsl_matrix> temp(gsl_matrix_alloc(nTimes, nTimes), 
-			&gsl_matrix_free);
-		for(size_t i = 0; i < nTimes; i++) {
-			for(size_t j = 0; j < nTimes; j++) {
-				// i and j are valid indices for temp and times
-				// therefore, no out-of-range errors
-				double deltaTTau1 = (times[i] - times[j])/tau1;
-				double deltaTTau2 = (times[i] - times[j])/tau2;
-				gsl_matrix_set(temp.get(), i, j, 
-					  sigma1*sigma1*exp(-0.5*deltaTTau1*deltaTTau1)
-					+ sigma2*sigma2*exp(-0.5*deltaTTau2*deltaTTau2));
-			}
-		}
+		// The squared lags are shared by all coherence times
+		shared_ptr<const gsl_matrix> temp = kernelMatrix(*cadenceLags(cadence()), addKernels(
+			SquaredExpKernel(sigma1*sigma1, tau1), 
+			SquaredExpKernel(sigma2*sigma2, tau2)));
+		
+		Cadence newTimes = cadence();
 		
 		// No exceptions beyond this point
 		
 		swap(oldCov, temp);
-		swap(oldTimes, times);
+		swap(oldTimes, newTimes);
 		oldSigma1 = sigma1;
 		oldSigma2 = sigma2;
 		oldTau1   = tau1;
 		oldTau2   = tau2;
+		counter.setBytes(oldCov->size1*oldCov->size2*sizeof(double));
+	} else {
+		counter.hit();
 	}
 	
 	// assert: the Cache is up-to-date
 	
-	// Return a copy of the cache as output
-	shared_ptr<gsl_matrix> cov(gsl_matrix_alloc(nTimes, nTimes), &gsl_matrix_free);
-	gsl_matrix_memcpy(cov.get(), oldCov.get());
+	return oldCov;
+}
+
+/** Returns an identifier of the matrix returned by getCovar()
+ *
+ * @return A hash of the times, the amplitudes, and the rounded 
+ *	coherence times, which is the same for any two light curves 
+ *	whose covariance matrices are the same.
+ *
+ * @perform Constant time.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+boost::uint64_t TwoScaleGp::getCovarToken() const {
+	static const char tag[] = "two_gp";
+	const boost::uint64_t timeHash = cadence().getHash();
+	boost::uint64_t token = utils::fnvHash(utils::fnvBasis(), tag, sizeof(tag));
+	token = utils::fnvHash(token, &timeHash, sizeof(timeHash));
+	token = hashValue(token, sigma1);
+	token = hashValue(token, sigma2);
+	token = hashValue(token, snapTau(tau1));
+	token = hashValue(token, snapTau(tau2));
+	// 0 means the matrix has no identifier
+	return (token == 0 ? 1 : token);
+}
 
-	return cov;
+/** Tests whether the covariance of the process depends only on 
+ *	the separation between two times
+ *
+ * @return true
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool TwoScaleGp::stationary() const {
+	return true;
+}
+
+/** Returns the covariance of the process at two times separated by 
+ *	a given interval
+ *
+ * Both coherence times are rounded with snapTau(), as in getCovar().
+ *
+ * @param[in] deltaT The separation between the two times.
+ *
+ * @return The sum of the two Gaussian kernels evaluated at @p deltaT.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double TwoScaleGp::kernel(double deltaT) const {
+	const double deltaTTau1 = deltaT / snapTau(tau1);
+	const double deltaTTau2 = deltaT / snapTau(tau2);
+	return sigma1*sigma1*exp(-0.5*deltaTTau1*deltaTTau1)
+		+ sigma2*sigma2*exp(-0.5*deltaTTau2*deltaTTau2);
+}
+
+/** Tests whether the process can be approximated by a state-space 
+ *	model
+ *
+ * @return true
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool TwoScaleGp::hasStateSpace() const {
+	return true;
+}
+
+/** Computes an approximate realization of the process with a 
+ *	state-space model
+ *
+ * The two components are simulated independently and added. Both 
+ * coherence times are rounded with snapTau(), as in getCovar().
+ *
+ * @param[in] rng The random number generator to use.
+ * @param[out] mags The realization at each of getTimes().
+ *
+ * @pre getStateSpaceOrder() > 0
+ *
+ * @perform O(nN) random numbers and O(n<sup>2</sup>N) time, where n = 
+ *	getStateSpaceOrder() and N = size()
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the light curve.
+ * @exception std::runtime_error Thrown if the state-space model could 
+ *	not be computed.
+ *
+ * @exceptsafe The arguments are unchanged in the event of an exception.
+ */
+void TwoScaleGp::stateSpaceRealization(const StochasticRng& rng, 
+		std::vector<double>& mags) const {
+	using std::swap;
+
+	const std::vector<double>& times = this->timeView();
+	
+	const SquaredExpSde& model = SquaredExpSde::get(getStateSpaceOrder());
+	std::vector<double> temp, second;
+	model.simulate(times, snapTau(tau1), rng, temp);
+	model.simulate(times, snapTau(tau2), rng, second);
+	for(size_t i = 0; i < temp.size(); i++) {
+		temp[i] = sigma1 * temp[i] + sigma2 * second[i];
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(mags, temp);
 }
 
 }}		// end lcmc::models
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcmagsine.cpp
  * @author Krzysztof Findeisen
  * @date Created April 11, 2013
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -55,8 +55,8 @@ namespace lcmc { namespace models {
  *
  * @exceptsafe Object construction is atomic.
  */
-MagSineWave::MagSineWave(const std::vector<double> &times, double amp, double period, 
-		double phase) : PeriodicLc(times, amp, period, phase) {
+MagSineWave::MagSineWave(const Cadence& times, double amp, double period, 
+		double phase) : PeriodicKernel<MagSineWave>(times, amp, period, phase) {
 }
 
 /** Samples the sinusoidal waveform at the specified phase.
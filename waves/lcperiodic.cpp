@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcperiodic.cpp
  * @author Krzysztof Findeisen
  * @date Created April 23, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,6 +27,9 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <stdexcept>
+#include <cfloat>
 #include <cmath>
 #include <boost/lexical_cast.hpp>
 #include "../except/data.h"
@@ -36,6 +39,154 @@ namespace lcmc { namespace models {
 
 using boost::lexical_cast;
 
+/** The most nodes in any ShapeTable, so that a table stays in cache
+ */
+const size_t MAX_SHAPE_NODES = 65536;
+
+/** Returns the tolerance of tabulated waveforms
+ *
+ * @return A modifiable tolerance, 0 if waveforms are evaluated exactly.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double& shapeTolerance() {
+	static double tolerance = 0.0;
+	return tolerance;
+}
+
+/** Lets outburst and fade waveforms be interpolated from tables 
+ *	with a bounded error
+ *
+ * Light curves derived from TabulatedKernel then sample their 
+ * waveform once per table node, rather than once or twice per 
+ * observation, which saves most of the exponentials needed for 
+ * dense cadences.
+ *
+ * @param[in] tolerance The largest change in any flux, as a fraction 
+ *	of the light curve amplitude, or 0 to evaluate waveforms exactly.
+ *
+ * @post Batches of phases evaluated by TabulatedKernel are 
+ *	interpolated to within @p tolerance times the amplitude 
+ *	whenever a table of at most 65536 nodes, and no more nodes than 
+ *	phases, meets that bound.
+ *
+ * @exception std::invalid_argument Thrown if @p tolerance < 0 
+ *	or @p tolerance &ge; 1
+ *
+ * @exceptsafe The tolerance is unchanged in the event of an exception.
+ */
+void setShapeTolerance(double tolerance) {
+	if (!(tolerance >= 0.0 && tolerance < 1.0)) {
+		throw std::invalid_argument("Waveform tolerances must be in [0, 1) (gave "
+			+ lexical_cast<std::string>(tolerance) + ").");
+	}
+	
+	shapeTolerance() = tolerance;
+}
+
+/** Returns the tolerance chosen with setShapeTolerance()
+ *
+ * @return The largest change in any flux, as a fraction of the 
+ *	light curve amplitude, or 0 if waveforms are evaluated exactly.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double getShapeTolerance() {
+	return shapeTolerance();
+}
+
+/** Returns the number of intervals a segment of a ShapeTable needs
+ *
+ * @param[in] length The width of the segment, in phase.
+ * @param[in] step The widest interval that meets the error bound.
+ *
+ * @return The number of intervals, as a real number so that it cannot 
+ *	overflow.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double segmentCells(double length, double step) {
+	if (length <= 0.0) {
+		return 0.0;
+	}
+	return std::max(1.0, ceil(length / step));
+}
+
+/** Chooses the phases at which to sample a waveform
+ *
+ * Linear interpolation over an interval of width h differs from a 
+ * function by at most h<sup>2</sup>/8 times the largest magnitude 
+ * of its second derivative, so each segment is divided into 
+ * intervals no wider than sqrt(8 @p maxError / @p curvature).
+ *
+ * @param[in] split The phase in [0, 1) at which the waveform or its 
+ *	slope jumps, or 0 if there is no such phase.
+ * @param[in] curvature An upper bound on the magnitude of the 
+ *	second derivative of the waveform, except at @p split.
+ * @param[in] maxError The largest interpolation error allowed.
+ * @param[in] maxNodes The most nodes the table may have.
+ *
+ * @post If the error bound can be met with at most @p maxNodes 
+ *	nodes (and at most 65536), size() is the number of nodes 
+ *	needed. Otherwise, size() = 0.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory 
+ *	for the table.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+ShapeTable::ShapeTable(double split, double curvature, double maxError, 
+		size_t maxNodes) : split(split > 0.0 ? split : 0.0), nBefore(0), 
+		nAfter(0), scaleBefore(0.0), scaleAfter(0.0), firstAfter(0), 
+		values() {
+	if (!(maxError > 0.0)) {
+		return;
+	}
+	const double step = (curvature > 0.0 ? sqrt(8.0 * maxError / curvature) 
+		: 1.0);
+	const double cellsBefore = segmentCells(this->split, step);
+	const double cellsAfter  = segmentCells(1.0 - this->split, step);
+	// Each segment has one more node than it has intervals
+	const double nodes = (cellsBefore > 0.0 ? cellsBefore + 1.0 : 0.0) 
+		+ cellsAfter + 1.0;
+	if (nodes > static_cast<double>(std::min(maxNodes, MAX_SHAPE_NODES))) {
+		return;
+	}
+	
+	nBefore     = static_cast<size_t>(cellsBefore);
+	nAfter      = static_cast<size_t>(cellsAfter);
+	scaleBefore = (nBefore > 0 ? static_cast<double>(nBefore) / this->split : 0.0);
+	scaleAfter  = static_cast<double>(nAfter) / (1.0 - this->split);
+	firstAfter  = (nBefore > 0 ? nBefore + 1 : 0);
+	values.resize(static_cast<size_t>(nodes));
+}
+
+/** Returns the phase at which to sample one node
+ *
+ * @param[in] i The index of the node.
+ *
+ * @return The phase of node @p i. The last node of the first segment 
+ *	lies just before the split, so that it samples the waveform on 
+ *	the same side as the rest of its segment.
+ *
+ * @pre @p i < size()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double ShapeTable::node(size_t i) const {
+	if (i < firstAfter) {
+		if (i == nBefore) {
+			return split - split*DBL_EPSILON;
+		}
+		return static_cast<double>(i) / scaleBefore;
+	}
+	const size_t j = i - firstAfter;
+	if (j == nAfter) {
+		return 1.0;
+	}
+	return split + static_cast<double>(j) / scaleAfter;
+}
+
 /** Initializes the light curve to represent a periodic function flux(time).
  *
  * @param[in] times The times at which the light curve will be sampled.
@@ -58,7 +209,7 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-PeriodicLc::PeriodicLc(const std::vector<double> &times, 
+PeriodicLc::PeriodicLc(const Cadence& times, 
 			double amp, double period, double phase) 
 			: Deterministic(times), amp(amp), period(period), phase0(phase) {
 	if (amp <= 0.0) {
@@ -111,4 +262,69 @@ double PeriodicLc::flux(double time) const {
 	return fluxPhase(phase, amp);
 }
 
+/** Samples the light curve at many times.
+ *
+ * @note This method is final. Subclasses should override 
+ *	fluxPhaseBatch() instead.
+ * 
+ * The times are folded in one pass, and all the phases are then 
+ * handed to fluxPhaseBatch() together, so that subclasses can 
+ * evaluate their waveform in a tight loop.
+ * 
+ * @param[in] times The times at which observations are taken.
+ * @param[out] fluxes An array in which to store the flux at each time.
+ * @param[in] n The number of elements in @p times and @p fluxes.
+ *
+ * @pre @p times and @p fluxes may be the same array
+ *
+ * @post @p fluxes[i] = flux(@p times[i]) for all i < @p n
+ * 
+ * @perform O(@p n) time
+ *
+ * @exception std::logic_error Thrown if a bug was found in the flux 
+ *	calculations.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception. 
+ *	The contents of @p fluxes are unspecified.
+ */
+void PeriodicLc::fluxBatch(const double times[], double fluxes[], size_t n) const {
+	for(size_t i = 0; i < n; i++) {
+		const double phase = phase0 + times[i] / period;
+		fluxes[i] = phase - floor(phase);
+	}
+	
+	fluxPhaseBatch(fluxes, n, amp);
+}
+
+/** Samples the light curve at many phases.
+ *
+ * Subclasses should override this method with a loop that does not 
+ * make a virtual call per phase. The default calls fluxPhase() for 
+ * each phase.
+ * 
+ * @param[in,out] phases The phases at which observations are taken. 
+ *	Each is replaced by the flux at that phase.
+ * @param[in] n The number of elements in @p phases.
+ * @param[in] amp The light curve amplitude, in the same units 
+ *	as passed to the constructor.
+ *
+ * @pre Every element of @p phases is in [0, 1)
+ *
+ * @post @p phases[i] is replaced by fluxPhase(@p phases[i], @p amp) 
+ *	for all i < @p n
+ * 
+ * @perform O(@p n) time
+ *
+ * @exception std::logic_error Thrown if a bug was found in the flux 
+ *	calculations.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception. 
+ *	The contents of @p phases are unspecified.
+ */
+void PeriodicLc::fluxPhaseBatch(double phases[], size_t n, double amp) const {
+	for(size_t i = 0; i < n; i++) {
+		phases[i] = fluxPhase(phases[i], amp);
+	}
+}
+
 }}		// end lcmc::models
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcrw.cpp
  * @author Krzysztof Findeisen
  * @date Created April 29, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,14 +27,15 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 #include <cmath>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/tss.hpp>
 #include "../except/data.h"
-#include "../fluxmag.h"
 #include "lightcurves_gp.h"
 
 namespace lcmc { namespace models {
@@ -61,7 +62,7 @@ using boost::shared_ptr;
  *
  * @exceptsafe Object construction is atomic.
  */
-RandomWalk::RandomWalk(const std::vector<double>& times, double diffus) 
+RandomWalk::RandomWalk(const Cadence& times, double diffus) 
 		: GaussianProcess(times), d(diffus) {
 	if (diffus <= 0.0) {
 		throw except::BadParam("All RandomWalk light curves need positive diffusion coefficients (gave " 
@@ -69,90 +70,139 @@ RandomWalk::RandomWalk(const std::vector<double>& times, double diffus)
 	}
 }
 
-/** Computes a realization of the light curve. 
+/** Approximate comparison function that handles zeros cleanly.
+ */
+bool cacheCheck(double x, double y);
+
+/** The coefficients last computed by RandomWalk::getArCoeffs() on 
+ *	one thread
+ */
+struct RandomWalkCache {
+	/** Creates an empty cache
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	RandomWalkCache() : coeffs(), times() {
+	}
+	
+	/** The coefficients, or null if none have been computed */
+	shared_ptr<const ArCoeffs> coeffs;
+	/** The times for which @p coeffs was computed */
+	Cadence times;
+};
+
+/** Returns the coefficients for generating the process one 
+ *	observation at a time, in units of getAmplitude().
  *
- * The light curve is computed from times and the internal random 
- * number generator, and its values are stored in fluxes.
+ * The coefficients depend only on the times, so light curves that 
+ * differ only in diffusion constant share the same coefficients.
  *
- * @param[out] fluxes The flux vector to update.
- * 
- * @post getFluxes() will now return the correct light curve.
- * 
- * @post @p fluxes.size() = getTimes().size()
+ * @return A pointer to the coefficients. The coefficients are shared 
+ *	with other light curves having the same times, and must not be 
+ *	modified.
+ *
+ * @post A realization generated from the coefficients starts at zero, 
+ *	and cov(mags[i], mags[j]) = min(getTimes()[i], getTimes()[j]) - getTimes()[0]
  * @post if getTimes()[i] = getTimes()[j] for i &ne; j, then 
- *	@p fluxes[i] = @p fluxes[j]
- * 
- * @post No element of @p fluxes is NaN
- * @post All elements in @p fluxes are non-negative
- * @post The median of the flux is one, when averaged over many elements and 
- *	many light curve instances.
- *
- * @post fluxToMag(@p fluxes) has a mean of zero and a standard deviation, at 
- *	each time t, of sqrt(diffus*(t-getTimes()[0]))
- * @post cov(fluxToMag(fluxes[i]), fluxToMag(fluxes[j])) = 
- *	diffus * (min{getTimes()[i], getTimes()[j]} - getTimes()[0])
- * 
- * @perform O(N) time, where N = @p times.size()
- * 
- * @exception std::bad_alloc Thrown if there is not enough memory to compute 
- *	the light curve.
- * @exception std::logic_error Thrown if a bug was found in the flux 
- *	calculations.
- *
- * @exceptsafe Neither the object nor the argument are changed in the 
- *	event of an exception.
- */	
-void RandomWalk::solveFluxes(std::vector<double>& fluxes) const {
+ *	mags[i] = mags[j]
+ *
+ * @perform O(N) time, where N is the number of times.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	compute the coefficients.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception
+ *
+ * @internal @exceptsafe The internal cache in getArCoeffs() provides 
+ *	only the basic exception guarantee. However, aside from run time 
+ *	this is not visible to the rest of the program.
+ */
+shared_ptr<const ArCoeffs> RandomWalk::getArCoeffs() const {
 	using std::swap;
-
+	
+	// Define a cache so that trials sharing a cadence don't have to 
+	//	recalculate the step sizes
+	// Each thread keeps its own cache, so that light curves simulated 
+	//	in parallel neither block nor overwrite each other
+	// invariant: oldCoeffs is empty <=> no coefficients computed yet
+	static boost::thread_specific_ptr<RandomWalkCache> caches;
+	if (caches.get() == NULL) {
+		caches.reset(new RandomWalkCache());
+	}
+	shared_ptr<const ArCoeffs>& oldCoeffs = caches->coeffs;
+	Cadence& oldTimes = caches->times;
+	
 	// invariant: this->times() is sorted in ascending order
-	std::vector<double> times;
-	this->getTimes(times);
+	const std::vector<double>& times = this->timeView();
+	const size_t nTimes = times.size();
 	
-	// copy-and-swap
-	auto_ptr<StochasticRng> rng = checkout();
-	std::vector<double> temp;
-
-	if (times.size() > 0) {
-		temp.reserve(times.size());
-
-		// A damped random walk is self-similar regardless of its starting value
-		temp.push_back(0.0);
+	if(oldCoeffs.get() == NULL 
+			// Trials drawn from one cadence share the same times object
+			|| (!cadence().sameAs(oldTimes) 
+				&& (oldTimes.size() != nTimes
+				|| !std::equal(oldTimes.timeView().begin(), 
+					oldTimes.timeView().end(), 
+					times.begin(), &cacheCheck))) ) {
+		// Cache is out of date
+		
+		// copy-and-swap
+		shared_ptr<ArCoeffs> temp(new ArCoeffs());
+		// A random walk never forgets its previous value
+		temp->decay.resize(nTimes, 1.0);
+		temp->step .reserve(nTimes);
 		
-		// Evaluate f(t > t0)
+		if (nTimes > 0) {
+			// A random walk is self-similar regardless of its starting value
+			temp->step.push_back(0.0);
+		}
 		// Derived analogously to eq. 2.47 in Gillespie (1996)
-		for(std::vector<double>::const_iterator it = times.begin()+1; 
-				it != times.end(); it++) {
-			double oldFlux = temp.back();
-			
+		for(size_t i = 1; i < nTimes; i++) {
 			// Observations taken at the same time should have the same flux
 			// Sorting invariant guarantees that all duplicate times will 
 			//	be next to each other
-			if (*it == *(it-1)) {
-				temp.push_back(oldFlux);
-			// Observations taken at different times are partially 
-			//	correlated
-			} else {
-				double deltaT = (*it - *(it-1));
-				
-				temp.push_back(oldFlux + sqrt(d * deltaT) * rng->rNorm());
-			}
+			temp->step.push_back(sqrt(times[i] - times[i-1]));
 		}
 		
-		utils::magToFlux(temp, temp);
-	}
+		Cadence newTimes = cadence();
 		
-	// IMPORTANT: no exceptions past this point
+		// No exceptions beyond this point
 		
-	swap(fluxes, temp);
-	commit(rng);
+		oldCoeffs = temp;
+		swap(oldTimes, newTimes);
+	}
+	
+	// assert: the Cache is up-to-date
+	
+	return oldCoeffs;
+}
+
+/** Returns the factor by which a light curve with coefficients 
+ *	getArCoeffs() must be scaled.
+ *
+ * @return The square root of the diffusion constant.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double RandomWalk::getAmplitude() const {
+	return sqrt(d);
 }
 
 /** Allocates and initializes the covariance matrix for the 
  *	Gaussian process. 
  */
-shared_ptr<gsl_matrix> RandomWalk::getCovar() const {
+shared_ptr<const gsl_matrix> RandomWalk::getCovar() const {
 	throw std::logic_error("Unexpected call to RandomWalk::getCovar().");
 }
 
+/** Tests whether the light curve is computed from getCovar() by 
+ *	the default implementation of solveMags()
+ *
+ * @return false, since RandomWalk is computed from getArCoeffs().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool RandomWalk::batchable() const {
+	return false;
+}
+
 }}		// end lcmc::models
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcsine.cpp
  * @author Krzysztof Findeisen
  * @date Created April 24, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -59,8 +59,8 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-SineWave::SineWave(const std::vector<double> &times, double amp, double period, double phase) 
-		: PeriodicLc(times, amp, period, phase) {
+SineWave::SineWave(const Cadence& times, double amp, double period, double phase) 
+		: PeriodicKernel<SineWave>(times, amp, period, phase) {
 	if (amp > 1.0) {
 		throw except::BadParam("SineWaves must have amplitudes less than or equal to 1 (gave " + lexical_cast<string>(amp) + ").");
 	}
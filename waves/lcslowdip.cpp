@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcSlowDip.cpp
  * @author Krzysztof Findeisen
  * @date Created August 21, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -66,9 +66,9 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-SlowDip::SlowDip(const std::vector<double> &times, 
+SlowDip::SlowDip(const Cadence& times, 
 		double amp, double period, double phase, double width) 
-		: PeriodicLc(times, amp, period, phase), width(width) {
+		: TabulatedKernel<SlowDip>(times, amp, period, phase), width(width) {
 	if (amp > 1.0) {
 		throw except::BadParam("All SlowDip light curves need amplitudes < 1 (gave " 
 			+ lexical_cast<string>(amp) + ").");
@@ -109,11 +109,69 @@ SlowDip::SlowDip(const std::vector<double> &times,
  *	event of an exception.
  */
 double SlowDip::fluxPhase(double phase, double amp) const {
-	double rawVal = 1.0 
+	return clipFlux(tableFlux(phase, amp));
+}
+
+/** Samples the waveform at the specified phase, without the floor 
+ *	at zero flux.
+ *
+ * Unlike fluxPhase(), the result is smooth, so it can be 
+ * interpolated from a table before the floor is applied.
+ * 
+ * @param[in] phase The light curve phase at which an observation is 
+ *	taken.
+ * @param[in] amp The light curve amplitude, in the same units 
+ *	as passed to the constructor.
+ * 
+ * @return The flux at the specified phase, which may be negative 
+ *	for wide dips.
+ * 
+ * @pre @p phase &isin; [0, 1]
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double SlowDip::tableFlux(double phase, double amp) const {
+	return 1.0 
 		- amp * exp(-(   phase *   phase) /(2.0*width*width)) 
 		- amp * exp(-((1-phase)*(1-phase))/(2.0*width*width));
+}
+
+/** Applies the floor at zero flux
+ *
+ * @param[in] value A flux computed by tableFlux().
+ *
+ * @return @p value, or zero if @p value is negative.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double SlowDip::clipFlux(double value) {
 	// Cheap hack to avoid problems at large widths
-	return (rawVal >= 0.0 ? rawVal : 0.0);
+	return (value >= 0.0 ? value : 0.0);
+}
+
+/** Returns the phase at which the waveform jumps
+ *
+ * @return 0, since the waveform is smooth before the floor is applied.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double SlowDip::shapeBreak() const {
+	return 0.0;
+}
+
+/** Returns an upper bound on the curvature of the waveform
+ *
+ * @param[in] amp The light curve amplitude, in the same units 
+ *	as passed to the constructor.
+ *
+ * @return An upper bound on the magnitude of the second derivative 
+ *	of the flux with respect to phase before the floor is applied. Each Gaussian has a
+ *	second derivative of at most amp/width<sup>2</sup>.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double SlowDip::shapeCurvature(double amp) const {
+	return 2.0 * amp / (width*width);
 }
 
 }}		// end lcmc::models
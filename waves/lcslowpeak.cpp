@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcslowpeak.cpp
  * @author Krzysztof Findeisen
  * @date Created May 2, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -65,9 +65,9 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-SlowPeak::SlowPeak(const std::vector<double> &times, 
+SlowPeak::SlowPeak(const Cadence& times, 
 		double amp, double period, double phase, double width) 
-		: PeriodicLc(times, amp, period, phase), width(width) {
+		: TabulatedKernel<SlowPeak>(times, amp, period, phase), width(width) {
 	if (width <= 0.0) {
 		throw except::BadParam("All SlowPeak light curves need positive widths (gave " 
 			+ lexical_cast<string>(width) + ").");
@@ -108,4 +108,29 @@ double SlowPeak::fluxPhase(double phase, double amp) const {
 		   + amp * exp(-((1-phase)*(1-phase))/(2.0*width*width));
 }
 
+/** Returns the phase at which the waveform jumps
+ *
+ * @return 0, since the waveform is smooth.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double SlowPeak::shapeBreak() const {
+	return 0.0;
+}
+
+/** Returns an upper bound on the curvature of the waveform
+ *
+ * @param[in] amp The light curve amplitude, in the same units 
+ *	as passed to the constructor.
+ *
+ * @return An upper bound on the magnitude of the second derivative 
+ *	of the flux with respect to phase. Each Gaussian has a second derivative of at most
+ *	amp/width<sup>2</sup>.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+double SlowPeak::shapeCurvature(double amp) const {
+	return 2.0 * amp / (width*width);
+}
+
 }}		// end lcmc::models
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcSquareDip.cpp
  * @author Krzysztof Findeisen
  * @date Created August 21, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -63,9 +63,9 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-SquareDip::SquareDip(const std::vector<double> &times, 
+SquareDip::SquareDip(const Cadence& times, 
 			double amp, double period, double phase, double width) 
-			: PeriodicLc(times, amp, period, phase), width(width) {
+			: PeriodicKernel<SquareDip>(times, amp, period, phase), width(width) {
 	if (amp > 1.0) {
 		throw except::BadParam("All SlowDip light curves need amplitudes < 1 (gave " 
 			+ lexical_cast<string>(amp) + ").");
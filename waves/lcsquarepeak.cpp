@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcsquarepeak.cpp
  * @author Krzysztof Findeisen
  * @date Created May 2, 2012
- * @date Last modified July 31, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -60,8 +60,8 @@ using boost::lexical_cast;
  *
  * @exceptsafe Object construction is atomic.
  */
-SquarePeak::SquarePeak(const std::vector<double> &times, 
-			double amp, double period, double phase, double width) : PeriodicLc(times, amp, period, phase), width(width) {
+SquarePeak::SquarePeak(const Cadence& times, 
+			double amp, double period, double phase, double width) : PeriodicKernel<SquarePeak>(times, amp, period, phase), width(width) {
 	if (width <= 0.0) {
 		throw except::BadParam("All SquarePeak light curves need positive widths (gave " 
 		+ lexical_cast<string>(width) + ").");
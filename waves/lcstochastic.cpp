@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcstochastic.cpp
  * @author Krzysztof Findeisen
  * @date Created March 21, 2013
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -28,36 +28,36 @@
  */
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <vector>
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
 #include "lcstochastic.h"
+#include "../fluxmag.h"
 
 #include "../../common/warnflags.h"
 
 namespace lcmc { namespace models {
 
-using std::auto_ptr;
-
 /** Initializes the light curve to represent an instance of a stochastic time series.
  *
  * @param[in] times The times at which the light curve will be sampled.
  *
  * @post getTimes() and getFluxes() return suitable data. getTimes() contains 
- * the same elements as @p times, possibly reordered.
+ * the same elements as @p times, in ascending order.
  *
  * @internal @post Calls to Stochastic::rng() will not throw exceptions. @endinternal
  *
+ * @perform Constant time. The times are shared with @p times, not copied.
+ *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	construct the object.
  *
  * @exceptsafe Object construction is atomic.
  */
-Stochastic::Stochastic(const std::vector<double> &times) 
-		: ILightCurve(), times(times), fluxes(), fluxesSolved(false) {
-	// Allow subclasses to assume times are in increasing order
-	std::sort(this->times.begin(), this->times.end());
+Stochastic::Stochastic(const Cadence &times) 
+		: ILightCurve(), times(times), mags(), magsSolved(false) {
+	// Subclasses may assume times are in increasing order, which 
+	//	Cadence guarantees
 	
 	// Since only the first call to rng() throws exceptions, deal with it 
 	//	in the constructor
@@ -89,7 +89,7 @@ void Stochastic::getTimes(std::vector<double>& timeArray) const {
 
 	// copy-and-swap to allow atomic guarantee
 	// vector::= only offers the basic guarantee
-	std::vector<double> temp = times;
+	std::vector<double> temp = times.timeView();
 	
 	swap(timeArray, temp);
 }
@@ -121,19 +121,125 @@ void Stochastic::getTimes(std::vector<double>& timeArray) const {
 void Stochastic::getFluxes(std::vector<double>& fluxArray) const {
 	using std::swap;
 
-	if (!fluxesSolved) {
-		// solveFluxes() already has the atomic guarantee
-		solveFluxes(fluxes);
-		fluxesSolved = true;
-	}
+	prepareFluxes();
 	
 	// copy-and-swap to allow atomic guarantee
-	// vector::= only offers the basic guarantee
-	std::vector<double> temp = fluxes;
+	std::vector<double> temp(mags.size());
+	// &temp[0] is not defined for an empty vector
+	if (!temp.empty()) {
+		utils::magToFlux(&mags[0], &temp[0], temp.size());
+	}
 	
 	swap(fluxArray, temp);
 }
 
+/** Returns a read-only view of the times at which the simulated 
+ *	data were taken
+ *
+ * @return A reference to the times with which the light curve was 
+ *	initialized, sorted in ascending order. The reference is valid 
+ *	for the lifetime of the object.
+ *
+ * @post return value.size() = size()
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const std::vector<double>& Stochastic::timeView() const {
+	return times.timeView();
+}
+
+/** Returns the cadence at which the simulated data were taken
+ *
+ * Subclasses that cache calculations for a cadence can use the 
+ * cadence's identity or hash to recognize it quickly.
+ *
+ * @return The cadence with which the light curve was initialized, 
+ *	valid for the lifetime of the object.
+ *
+ * @perform Constant time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const Cadence& Stochastic::cadence() const {
+	return times;
+}
+
+/** Writes the simulated fluxes into a caller-provided buffer
+ *
+ * @param[out] fluxArray An array of at least size() elements in 
+ *	which to store the fluxes.
+ *
+ * @post @p fluxArray[i] = getFluxes()[i] for all i < size()
+ *
+ * @perform O(N) time, where N = size(), if the light curve has 
+ *	already been computed.
+ * 
+ * @exception std::bad_alloc Thrown if there is not enough memory to compute 
+ *	the light curve.
+ * @exception std::logic_error Thrown if a bug was found in the flux calculations.
+ *
+ * @exceptsafe The object and @p fluxArray are unchanged in the event 
+ *	of an exception.
+ */
+void Stochastic::fillFluxes(double fluxArray[]) const {
+	prepareFluxes();
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	if (!mags.empty()) {
+		utils::magToFlux(&mags[0], fluxArray, mags.size());
+	}
+}
+
+/** Writes the simulated light curve, in magnitudes, into a 
+ *	caller-provided buffer
+ *
+ * @param[out] magArray An array of at least size() elements in 
+ *	which to store the magnitudes.
+ *
+ * @post @p magArray[i] = utils::fluxToMag(getFluxes()[i]) for all 
+ *	i < size(), up to rounding error
+ *
+ * @perform O(N) time, where N = size(), if the light curve has 
+ *	already been computed. No conversions are needed, since the 
+ *	light curve is stored in magnitudes.
+ * 
+ * @exception std::bad_alloc Thrown if there is not enough memory to compute 
+ *	the light curve.
+ * @exception std::logic_error Thrown if a bug was found in the flux calculations.
+ *
+ * @exceptsafe The object and @p magArray are unchanged in the event 
+ *	of an exception.
+ */
+void Stochastic::fillMags(double magArray[]) const {
+	prepareFluxes();
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	std::copy(mags.begin(), mags.end(), magArray);
+}
+
+/** Computes the light curve, if it has not been computed already
+ *
+ * @post Later calls to getFluxes(), fillFluxes(), or fillMags() only 
+ *	read the stored light curve.
+ * 
+ * @exception std::bad_alloc Thrown if there is not enough memory to compute 
+ *	the light curve.
+ * @exception std::logic_error Thrown if a bug was found in the flux calculations.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+void Stochastic::prepareFluxes() const {
+	if (!magsSolved) {
+		// solveMags() already has the atomic guarantee
+		solveMags(mags);
+		magsSolved = true;
+	}
+}
+
 /** Returns the number of times and fluxes
  *
  * @return The number of data points represented by the light curve.
@@ -147,6 +253,9 @@ size_t Stochastic::size() const {
 }
 	
 /** Defines the random number state of the first Stochastic object.
+ *
+ * If a utils::TrialStreams object is active on the calling thread, 
+ *	returns the stochastic light curve stream of that trial instead.
  *
  * @exception std::bad_alloc Thrown if there is not enough memory to 
  *	allocate the random number generator.
@@ -158,6 +267,11 @@ StochasticRng& Stochastic::rng() {
 	static StochasticRng* foo = NULL;
 	static bool ready = false;
 	
+	StochasticRng* trialRng = utils::trialModelRng();
+	if (trialRng != NULL) {
+		return *trialRng;
+	}
+	
 	if(!ready) {
 		foo = new StochasticRng(42);
 	
@@ -170,18 +284,21 @@ StochasticRng& Stochastic::rng() {
 
 /** Creates a temporary copy of a random number generator
  *
- * @return A newly allocated StochasticRng equal to the internal random 
- *	number generator
+ * @return A StochasticRng equal to the internal random number generator
+ *
+ * @perform Constant time. Within a trial the generator state is a few 
+ *	words, so no memory is allocated.
  *
  * @exception std::bad_alloc Thrown if there was not enough memory 
- *	to construct the generator.
+ *	to copy the generator used outside trials.
  *
- * @exceptsafe Object construction is atomic.
+ * @exceptsafe Object construction is atomic. Does not throw exceptions 
+ *	within a trial.
  */
-auto_ptr<StochasticRng> Stochastic::checkout() const {
+StochasticRng Stochastic::checkout() const {
 	// Since Stochastic has been constructed, rng() no longer 
 	//	throws exceptions
-	return auto_ptr<StochasticRng>(new StochasticRng(rng()));
+	return rng();
 }
 
 /** Updates the state of the random number generator
@@ -189,14 +306,40 @@ auto_ptr<StochasticRng> Stochastic::checkout() const {
  * @param[in] newState A temporary copy of the internal random 
  *	number generator
  *
+ * @pre @p newState was created by checkout() while the same trial, 
+ *	or no trial, was active
+ *
  * @post The internal generator is in the same state as @p newState
  *
  * @exceptsafe Does not throw exceptions.
  */
-void Stochastic::commit(auto_ptr<StochasticRng> newState) const {
+void Stochastic::commit(const StochasticRng& newState) const {
 	// Since Stochastic has been constructed, rng() no longer 
 	//	throws exceptions
-	rng() = *(newState.get());
+	rng() = newState;
+}
+
+/** Stores a realization of the light curve computed outside of 
+ *	solveMags()
+ *
+ * This function lets subclasses compute several light curves at once. 
+ *
+ * @param[in,out] newMags The light curve, in magnitudes, satisfying all 
+ *	the postconditions of solveMags(). Its contents are exchanged with 
+ *	the previous magnitudes.
+ *
+ * @pre getFluxes() has not yet been called
+ *
+ * @post fillMags() returns the former contents of @p newMags, and 
+ *	solveMags() will not be called.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void Stochastic::setMags(std::vector<double>& newMags) const {
+	using std::swap;
+	
+	swap(mags, newMags);
+	magsSolved = true;
 }
 
 }}		// end lcmc::models
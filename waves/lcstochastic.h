@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcstochastic.h
  * @author Krzysztof Findeisen
  * @date Created May 12, 2013
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,8 +31,9 @@
 #define LCMCCURVESTOCHH
 
 #include <memory>
-#include <gsl/gsl_rng.h>
+#include "../cadence.h"
 #include "../lightcurvetypes.h"
+#include "../rngstream.h"
 
 
 namespace lcmc { namespace models {
@@ -45,7 +46,11 @@ using std::auto_ptr;
  *	without being sensitive to the implementation of the random number 
  *	generator.
  *
- * @todo Rewrite in terms of pImpl.
+ * A generator for one stream of a trial is a counter-based Philox stream 
+ *	whose state is stored by value, so copying and assigning it is cheap 
+ *	and never throws. A generator constructed from a seed alone is a 
+ *	Mersenne Twister, so that runs without a trial seed reproduce the 
+ *	numbers of earlier versions.
  */
 class StochasticRng {
 public: 
@@ -53,6 +58,11 @@ public:
 	 */
 	explicit StochasticRng(unsigned long seed);
 
+	/** Initializes a random number generator for one stream of a trial
+	 */
+	StochasticRng(unsigned long seed, unsigned long bin, unsigned long trial, 
+			utils::StreamType stream);
+
 	~StochasticRng();
 	
 	/** Creates a random number generator with an identical 
@@ -62,7 +72,7 @@ public:
 
 	/** Sets the random number generator state equal to another generator
 	 */
-	const StochasticRng& operator=(const StochasticRng& other);
+	StochasticRng& operator=(const StochasticRng& other);
 	
 	/** Draws a standard uniform random variate.
 	 */
@@ -71,9 +81,22 @@ public:
 	/** Draws a standard normal random variate.
 	 */
 	double rNorm() const;
+	
+	/** Fills an array with independent normal random variates.
+	 */
+	void fillNormal(double out[], size_t n, double sigma) const;
 
 private:
-	gsl_rng * const rng;
+	/** Returns a GSL generator that draws from this object's state
+	 */
+	const gsl_rng* view(gsl_rng& buffer) const;
+
+	// Mutable because drawing numbers is not considered a change 
+	//	of state by the light curves
+	mutable utils::PhiloxState state;
+	// The Mersenne Twister of a generator constructed from a seed alone, 
+	//	or NULL if the generator is a Philox stream
+	gsl_rng* legacy;
 };
 
 /** Stochastic is the base class for all light curve models that have a 
@@ -95,6 +118,20 @@ public:
 	 */
 	virtual void getFluxes(std::vector<double>& fluxArray) const;
 
+	/** Returns a read-only view of the times at which the simulated 
+	 *	data were taken
+	 */
+	virtual const std::vector<double>& timeView() const;
+
+	/** Writes the simulated fluxes into a caller-provided buffer
+	 */
+	virtual void fillFluxes(double fluxArray[]) const;
+
+	/** Writes the simulated light curve, in magnitudes, into a 
+	 *	caller-provided buffer
+	 */
+	virtual void fillMags(double magArray[]) const;
+
 	/** Returns the number of times and fluxes
 	 */
 	virtual size_t size() const;
@@ -103,39 +140,55 @@ protected:
 	/** Initializes the light curve to represent an instance of a 
 	 * stochastic time series.
 	 */
-	explicit Stochastic(const std::vector<double> &times);
+	explicit Stochastic(const Cadence &times);
+	
+	/** Returns the cadence at which the simulated data were taken
+	 */
+	const Cadence& cadence() const;
 	
 	/** Creates a temporary copy of a random number generator
 	 */
-	auto_ptr<StochasticRng> checkout() const;
+	StochasticRng checkout() const;
 
 	/** Updates the state of the random number generator
 	 */
-	void commit(auto_ptr<StochasticRng> newState) const;
+	void commit(const StochasticRng& newState) const;
+
+	/** Stores a realization of the light curve computed outside of 
+	 *	solveMags()
+	 */
+	void setMags(std::vector<double>& newMags) const;
+
+	/** Computes the light curve, if it has not been computed already
+	 */
+	void prepareFluxes() const;
 
 private:
 	/** Computes a realization of the light curve. 
 	 *
 	 * The light curve is computed from times and the internal random 
-	 * number generator, and its values are stored in fluxes.
+	 * number generator, and its values are stored in mags. Stochastic 
+	 * light curves are defined in magnitudes, so they are stored that 
+	 * way, and only converted to fluxes if getFluxes() or fillFluxes() 
+	 * is called.
 	 *
-	 * @param[out] fluxes A write-only reference to Stochastic::fluxes.
+	 * @param[out] mags A write-only reference to Stochastic::mags.
 	 * 
-	 * @post getFluxes() will now return the correct light curve.
+	 * @post getFluxes() and fillMags() will now return the correct 
+	 *	light curve.
 	 * 
-	 * @post @p fluxes.size() = getTimes().size()
+	 * @post @p mags.size() = getTimes().size()
 	 * @post if getTimes()[i] = getTimes()[j] for i &ne; j, then 
-	 *	@p fluxes[i] = @p fluxes[j]
+	 *	@p mags[i] = @p mags[j]
 	 * 
-	 * @post No element of @p fluxes is NaN
-	 * @post All elements in @p fluxes are non-negative
-	 * @post Either the mean, median, or mode of the flux is one, when 
-	 *	averaged over many elements and many light curve instances. 
-	 *	Subclasses of Stochastic may chose the option 
+	 * @post No element of @p mags is NaN
+	 * @post Either the mean, median, or mode of the magnitude is zero, 
+	 *	when averaged over many elements and many light curve 
+	 *	instances. Subclasses of Stochastic may chose the option 
 	 *	(mean, median, or mode) most appropriate for their light 
 	 *	curve shape.
 	 *
-	 * @invariant solveFluxes() will be called at most once for any 
+	 * @invariant solveMags() will be called at most once for any 
 	 *	instance of Stochastic
 	 * 
 	 * @exception std::bad_alloc Thrown if there is not enough memory to compute 
@@ -145,18 +198,18 @@ private:
 	 * @exceptsafe Neither the object nor the argument are changed in the 
 	 *	event of an exception.
 	 */	
-	virtual void solveFluxes(std::vector<double>& fluxes) const = 0;
+	virtual void solveMags(std::vector<double>& mags) const = 0;
 	
 	/** Defines the random number generator for stochastic light curves
 	 */
 	static StochasticRng& rng();
 
-	std::vector<double> times;
-	// Mutable allows use of solveFluxes() as a cache
-	// assert: only solveFluxes(), and no other function, can change 
-	//	these values
-	mutable std::vector<double> fluxes;
-	mutable bool fluxesSolved;
+	Cadence times;
+	// Mutable allows use of solveMags() as a cache
+	// assert: only solveMags() and setMags(), and no other 
+	//	function, can change these values
+	mutable std::vector<double> mags;
+	mutable bool magsSolved;
 };
 
 }}	// end lcmc::models
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lcwhite.cpp
  * @author Krzysztof Findeisen
  * @date Created March 21, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -33,7 +33,6 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
 #include "../except/data.h"
-#include "../fluxmag.h"
 #include "lightcurves_gp.h"
 
 namespace lcmc { namespace models {
@@ -59,7 +58,7 @@ using boost::shared_ptr;
  *
  * @exceptsafe Object construction is atomic.
  */
-WhiteNoise::WhiteNoise(const std::vector<double>& times, double sigma) 
+WhiteNoise::WhiteNoise(const Cadence& times, double sigma) 
 		: GaussianProcess(times), sigma(sigma) {
 	if (sigma <= 0.0) {
 		throw except::BadParam("All WhiteNoise light curves need positive standard deviations (gave " 
@@ -70,23 +69,22 @@ WhiteNoise::WhiteNoise(const std::vector<double>& times, double sigma)
 /** Computes a realization of the light curve. 
  *
  * The light curve is computed from times and the internal random 
- * number generator, and its values are stored in fluxes.
+ * number generator, and its values are stored in mags.
  *
- * @param[out] fluxes The flux vector to update.
+ * @param[out] mags The magnitude vector to update.
  * 
- * @post getFluxes() will now return the correct light curve.
+ * @post getFluxes() and fillMags() will now return the correct light curve.
  * 
- * @post @p fluxes.size() = getTimes().size()
+ * @post @p mags.size() = getTimes().size()
  * @post if getTimes()[i] = getTimes()[j] for i &ne; j, then 
- *	@p fluxes[i] = @p fluxes[j]
+ *	@p mags[i] = @p mags[j]
  * 
- * @post No element of @p fluxes is NaN
- * @post All elements in @p fluxes are non-negative
- * @post The median of the flux is one, when averaged over many elements and 
+ * @post No element of @p mags is NaN
+ * @post The median of @p mags is zero, when averaged over many elements and 
  *	many light curve instances.
  *
- * @post fluxToMag(@p fluxes) has a mean of zero and a standard deviation of sigma
- * @post cov(fluxToMag(fluxes[i]), fluxToMag(fluxes[j])) = 0 
+ * @post @p mags has a mean of zero and a standard deviation of sigma
+ * @post cov(@p mags[i], @p mags[j]) = 0 
  *	if getTimes()[i] &ne; getTimes()[j]
  * 
  * @perform O(N) time, where N = @p times.size()
@@ -99,51 +97,67 @@ WhiteNoise::WhiteNoise(const std::vector<double>& times, double sigma)
  * @exceptsafe Neither the object nor the argument are changed in the 
  *	event of an exception.
  */	
-void WhiteNoise::solveFluxes(std::vector<double>& fluxes) const {
+void WhiteNoise::solveMags(std::vector<double>& mags) const {
 	using std::swap;
 
 	// invariant: this->times() is sorted in ascending order
-	std::vector<double> times;
-	this->getTimes(times);
+	const std::vector<double>& times = this->timeView();
 	
 	// copy-and-swap
-	auto_ptr<StochasticRng> rng = checkout();
-	std::vector<double> temp;
+	StochasticRng rng = checkout();
+	std::vector<double> temp(times.size());
 
 	if (times.size() > 0) {
-		temp.reserve(times.size());
-
-		// f(t0) ~ N(0, sigma) to avoid giving first point any special treatment
-		temp.push_back(sigma * rng->rNorm());
+		// Observations taken at the same time should have the same flux
+		// Sorting invariant guarantees that all duplicate times will 
+		//	be next to each other
+		size_t nDistinct = 1;
+		for(size_t i = 1; i < times.size(); i++) {
+			if (times[i] != times[i-1]) {
+				nDistinct++;
+			}
+		}
 		
-		// Evaluate f(t > t0)
-		for(std::vector<double>::const_iterator it = times.begin()+1; 
-				it != times.end(); it++) {
-			// Observations taken at the same time should have the same flux
-			// Sorting invariant guarantees that all duplicate times will 
-			//	be next to each other
-			if (*it == *(it-1)) {
-				temp.push_back(temp.back());
+		// Every distinct time gets an independent deviate, including 
+		//	f(t0), to avoid giving the first point any special treatment
+		// The deviates are drawn into the tail of temp, so that spreading 
+		//	them across duplicate times never overwrites an unread one
+		const size_t offset = times.size() - nDistinct;
+		rng.fillNormal(&temp[offset], nDistinct, sigma);
+		
+		temp[0] = temp[offset];
+		for(size_t i = 1, next = offset+1; i < times.size(); i++) {
+			if (times[i] == times[i-1]) {
+				temp[i] = temp[i-1];
 			// Observations taken at different times are uncorrelated
 			} else {
-				temp.push_back(sigma * rng->rNorm());
+				temp[i] = temp[next++];
 			}
 		}
-		
-		utils::magToFlux(temp, temp);
 	}
 	
 	// IMPORTANT: no exceptions past this point
 	
-	swap(fluxes, temp);
+	swap(mags, temp);
 	commit(rng);
 }
 
 /** Allocates and initializes the covariance matrix for the 
  *	Gaussian process. 
  */
-shared_ptr<gsl_matrix> WhiteNoise::getCovar() const {
+shared_ptr<const gsl_matrix> WhiteNoise::getCovar() const {
 	throw std::logic_error("Unexpected call to WhiteNoise::getCovar().");
 }
 
+/** Tests whether the light curve is computed from getCovar() by 
+ *	the default implementation of solveMags()
+ *
+ * @return false, since WhiteNoise::solveMags() does not use getCovar().
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool WhiteNoise::batchable() const {
+	return false;
+}
+
 }}		// end lcmc::models
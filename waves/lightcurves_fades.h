@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lightcurves_fades.h
  * @author Krzysztof Findeisen
  * @date Created August 21, 2012
- * @date Last modified March 20, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -42,12 +42,12 @@ namespace lcmc { namespace models {
  * @invariant Zero is the maximum flux returned by SlowDip in the limit of 
  *	short fades. Long fades may return lower maxima.
  */
-class SlowDip : public PeriodicLc {
+class SlowDip : public TabulatedKernel<SlowDip> {
 public: 
 	/** Initializes the light curve to represent a periodically 
 	 * fading function flux(time).
 	 */
-	explicit SlowDip(const std::vector<double> &times, 
+	explicit SlowDip(const Cadence& times, 
 			double amp, double period, double phase, double width);
 
 private:
@@ -55,6 +55,27 @@ private:
 	 */
 	double fluxPhase(double phase, double amp) const;
 	
+	/** Samples the waveform at the specified phase, without the 
+	 *	floor at zero flux.
+	 */
+	double tableFlux(double phase, double amp) const;
+	
+	/** Applies the floor at zero flux
+	 */
+	static double clipFlux(double value);
+
+	/** Returns the phase at which the waveform jumps
+	 */
+	double shapeBreak() const;
+	
+	/** Returns an upper bound on the curvature of the waveform
+	 */
+	double shapeCurvature(double amp) const;
+
+	// Lets the kernels call the waveform without virtual dispatch
+	friend class PeriodicKernel<SlowDip>;
+	friend class TabulatedKernel<SlowDip>;
+	
 	double width;
 };
 
@@ -66,18 +87,30 @@ private:
  * @invariant Zero is the maximum flux returned by FlareDip in the limit of 
  *	short fades. Long fades may return lower maxima.
  */
-class FlareDip : public PeriodicLc {
+class FlareDip : public TabulatedKernel<FlareDip> {
 public: 
 	/** Initializes the light curve to represent a periodically 
 	 * fading function flux(time).
 	 */
-	explicit FlareDip(const std::vector<double> &times, 
+	explicit FlareDip(const Cadence& times, 
 			double amp, double period, double phase, double fade, double width);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	/** Returns the phase at which the waveform jumps
+	 */
+	double shapeBreak() const;
+	
+	/** Returns an upper bound on the curvature of the waveform
+	 */
+	double shapeCurvature(double amp) const;
+
+	// Lets the kernels call the waveform without virtual dispatch
+	friend class PeriodicKernel<FlareDip>;
+	friend class TabulatedKernel<FlareDip>;
 	
 	double tExp, tLin;
 };
@@ -88,18 +121,21 @@ private:
  *
  * @invariant Zero is the maximum flux returned by SquareDip.
  */
-class SquareDip : public PeriodicLc {
+class SquareDip : public PeriodicKernel<SquareDip> {
 public: 
 	/** Initializes the light curve to represent a periodically 
 	 * fading function flux(time).
 	 */
-	explicit SquareDip(const std::vector<double> &times, 
+	explicit SquareDip(const Cadence& times, 
 			double amp, double period, double phase, double width);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<SquareDip>;
 	
 	double width;
 };
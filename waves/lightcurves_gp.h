@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lightcurves_gp.h
  * @author Krzysztof Findeisen
  * @date Created March 21, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -30,11 +30,121 @@
 #ifndef LCMCCURVEGPH
 #define LCMCCURVEGPH
 
+#include <vector>
+#include <cstddef>
+#include <boost/cstdint.hpp>
 #include <boost/smart_ptr.hpp>
 #include <gsl/gsl_matrix.h>
 #include "lcstochastic.h"
 
-namespace lcmc { namespace models {
+namespace lcmc { 
+
+namespace utils {
+
+struct SparseCovar;
+
+}		// end lcmc::utils
+
+namespace models {
+
+/** Rounds the coherence times of Gaussian process kernels to a 
+ *	logarithmic grid
+ */
+void setTauGrid(long perDecade);
+
+/** Returns the grid value to which a coherence time is rounded
+ */
+double snapTau(double tau);
+
+/** Returns the number of grid values needed to cover a range of 
+ *	coherence times
+ */
+size_t tauGridSize(double tauMin, double tauMax);
+
+/** Returns the largest fractional change in a coherence time caused 
+ *	by rounding to the grid
+ */
+double tauGridError();
+
+/** Returns the largest change in a Gaussian kernel, as a fraction of 
+ *	its variance, caused by rounding its coherence time to the grid
+ */
+double tauGridCovarError();
+
+/** Approximates squared exponential kernels by a state-space model of 
+ *	a given order
+ */
+void setStateSpaceOrder(long order);
+
+/** Returns the order chosen with setStateSpaceOrder()
+ */
+long getStateSpaceOrder();
+
+/** Returns the largest kernel error of the state-space approximation 
+ *	chosen with setStateSpaceOrder()
+ */
+double stateSpaceError();
+
+/** Approximates stationary Gaussian processes by a Nystr&ouml;m 
+ *	low-rank model with a given number of inducing points
+ */
+void setNystromRank(long rank);
+
+/** Returns the rank chosen with setNystromRank()
+ */
+long getNystromRank();
+
+/** Returns the largest kernel error of any Nystr&ouml;m approximation 
+ *	used since the last call to setNystromRank()
+ */
+double nystromError();
+
+/** Generates stationary Gaussian processes one observing season at 
+ *	a time, where the seasons are nearly uncorrelated
+ */
+void setSeasonTolerance(double tolerance);
+
+/** Returns the tolerance chosen with setSeasonTolerance()
+ */
+double getSeasonTolerance();
+
+/** Returns the largest covariance dropped between seasons since the 
+ *	last call to setSeasonTolerance()
+ */
+double seasonError();
+
+/** Generates stationary Gaussian processes from a sparse covariance 
+ *	matrix, treating covariances below a tolerance as zero
+ */
+void setSparseTolerance(double tolerance);
+
+/** Returns the tolerance chosen with setSparseTolerance()
+ */
+double getSparseTolerance();
+
+/** ArCoeffs describes a Gaussian process that can be generated one 
+ *	observation at a time.
+ *
+ * A realization of the process is given by 
+ * <tt>mags[0] = step[0]*z[0]</tt> and 
+ * <tt>mags[i] = decay[i]*mags[i-1] + step[i]*z[i]</tt>, where the z[i] 
+ * are independent standard normal deviates. A deviate is drawn only 
+ * for the observations whose step is nonzero, in order of observation.
+ */
+struct ArCoeffs {
+	/** Creates an empty set of coefficients.
+	 */
+	ArCoeffs() : decay(), step() {
+	}
+	
+	/** The fraction of the previous value retained at each step. 
+	 *	The first element is not used.
+	 */
+	std::vector<double> decay;
+	/** The standard deviation of the innovation at each step.
+	 */
+	std::vector<double> step;
+};
 
 /** GaussianProcess represents variables that vary as any kind of Gaussian 
  * process in magnitude space.
@@ -42,23 +152,142 @@ namespace lcmc { namespace models {
  * GaussianProcess is an abstract base class. Subclasses of GaussianProcess 
  * represent Gaussian processes with specific kernels by implementing 
  * the private function getCovar() and optionally overriding the private 
- * function solveFluxes().
+ * functions getAmplitude() and solveMags(). Subclasses that override 
+ * solveMags() must also override batchable(). Subclasses whose process 
+ * is Markovian may override getArCoeffs() instead of getCovar().
  */
 class GaussianProcess : public Stochastic {
 public: 
 	/** Initializes the light curve to represent a Gaussian process.
 	 */
-	explicit GaussianProcess(const std::vector<double>& times);
+	explicit GaussianProcess(const Cadence& times);
+
+	/** Draws the random numbers needed to compute the light curve, 
+	 *	without computing it
+	 */
+	void drawDeviates() const;
+
+	/** Computes the realizations of several light curves at once
+	 */
+	static void solveBatch(const std::vector<const GaussianProcess*>& curves);
 
 private:
 	/** Computes a realization of the light curve. 
 	 */
-	virtual void solveFluxes(std::vector<double>& fluxes) const;
+	virtual void solveMags(std::vector<double>& mags) const;
+
+	/** Tests whether the light curve is computed from getCovar() by 
+	 *	the default implementation of solveMags()
+	 */
+	virtual bool batchable() const;
+
+	/** Scales a realization with covariance getCovar() to the 
+	 *	amplitude of the light curve
+	 */
+	void scaleToAmplitude(std::vector<double>& mags) const;
+
+	/** Tests whether the covariance of the process depends only on 
+	 *	the separation between two times
+	 */
+	virtual bool stationary() const;
+
+	/** Returns the covariance of the process at two times separated 
+	 *	by a given interval, in units of getAmplitude()<sup>2</sup>
+	 */
+	virtual double kernel(double deltaT) const;
+
+	/** Tests whether solveMags() should try circulant embedding
+	 */
+	bool useCirculant() const;
+
+	/** Tests whether the process can be approximated by a 
+	 *	state-space model
+	 */
+	virtual bool hasStateSpace() const;
+
+	/** Computes an approximate realization of the process with a 
+	 *	state-space model, in units of getAmplitude()
+	 */
+	virtual void stateSpaceRealization(const StochasticRng& rng, 
+			std::vector<double>& mags) const;
+
+	/** Tests whether solveMags() should use a state-space model
+	 */
+	bool useStateSpace() const;
+
+	/** Tests whether solveMags() should use a Nystr&ouml;m 
+	 *	approximation
+	 */
+	bool useNystrom() const;
+
+	/** Computes an approximate realization of the process with a 
+	 *	Nystr&ouml;m approximation, in units of getAmplitude()
+	 */
+	void nystromRealization(const StochasticRng& rng, 
+			std::vector<double>& mags) const;
+
+	/** Tests whether solveMags() should try to generate each season 
+	 *	separately
+	 */
+	bool useSeasons() const;
+
+	/** Divides the light curve into nearly uncorrelated seasons
+	 */
+	bool findSeasons(std::vector<size_t>& starts) const;
+
+	/** Transforms uncorrelated Gaussian random numbers into a 
+	 *	realization of the process, one season at a time
+	 */
+	void seasonNormal(const std::vector<size_t>& starts, 
+			std::vector<double>& mags) const;
+
+	/** Tests whether solveMags() should try to use a sparse 
+	 *	covariance matrix
+	 */
+	bool useSparse() const;
+
+	/** Computes the covariance matrix of the light curve, omitting 
+	 *	covariances below getSparseTolerance()
+	 */
+	bool sparseCovar(utils::SparseCovar& covar) const;
+
+	/** Transforms uncorrelated Gaussian random numbers into a 
+	 *	realization of the process, using a sparse covariance matrix
+	 */
+	bool sparseNormal(const utils::SparseCovar& covar, 
+			std::vector<double>& mags) const;
+
+	/** Embeds the covariance of the light curve in a circulant matrix
+	 */
+	bool circulantEmbedding(std::vector<double>& sqrtEigen, 
+			std::vector<size_t>& gridIndex) const;
 	
-	/** Allocates and initializes the covariance matrix for the 
-	 *	Gaussian process. 
+	/** Returns the covariance matrix for the Gaussian process, in 
+	 *	units of getAmplitude()<sup>2</sup>. The matrix may be shared, 
+	 *	and must not be modified.
 	 */
-	virtual boost::shared_ptr<gsl_matrix> getCovar() const = 0;
+	virtual boost::shared_ptr<const gsl_matrix> getCovar() const = 0;
+
+	/** Returns an identifier of the matrix returned by getCovar(), 
+	 *	or 0 if it has none
+	 */
+	virtual boost::uint64_t getCovarToken() const;
+
+	/** Returns the coefficients for generating the process one 
+	 *	observation at a time, in units of getAmplitude(). The 
+	 *	coefficients may be shared, and must not be modified.
+	 */
+	virtual boost::shared_ptr<const ArCoeffs> getArCoeffs() const;
+
+	/** Returns the factor by which a light curve with covariance 
+	 *	getCovar() must be scaled.
+	 */
+	virtual double getAmplitude() const;
+
+	// Mutable allows drawDeviates() to be called on a const object
+	// assert: deviates is empty unless drawDeviates() has been called 
+	//	and the fluxes have not been computed yet
+	mutable std::vector<double> deviates;
 };
 
 /** WhiteNoise represents variables that vary stochastically on infinitesimal 
@@ -68,17 +297,22 @@ class WhiteNoise : public GaussianProcess {
 public: 
 	/** Initializes the light curve to represent a white noise process.
 	 */
-	explicit WhiteNoise(const std::vector<double>& times, double sigma);
+	explicit WhiteNoise(const Cadence& times, double sigma);
 
 private:
 	/** Computes a realization of the light curve. 
 	 */	
-	void solveFluxes(std::vector<double>& fluxes) const;
+	void solveMags(std::vector<double>& mags) const;
+
+	/** Tests whether the light curve is computed from getCovar() by 
+	 *	the default implementation of solveMags()
+	 */
+	bool batchable() const;
 	
 	/** Allocates and initializes the covariance matrix for the 
 	 *	Gaussian process. 
 	 */
-	boost::shared_ptr<gsl_matrix> getCovar() const;
+	boost::shared_ptr<const gsl_matrix> getCovar() const;
 
 	double sigma;
 };
@@ -90,17 +324,28 @@ class RandomWalk : public GaussianProcess {
 public: 
 	/** Initializes the light curve to represent a random walk.
 	 */
-	explicit RandomWalk(const std::vector<double>& times, double diffus);
+	explicit RandomWalk(const Cadence& times, double diffus);
 
 private:
-	/** Computes a realization of the light curve. 
-	 */	
-	void solveFluxes(std::vector<double>& fluxes) const;
+	/** Tests whether the light curve is computed from getCovar() by 
+	 *	the default implementation of solveMags()
+	 */
+	bool batchable() const;
 	
 	/** Allocates and initializes the covariance matrix for the 
 	 *	Gaussian process. 
 	 */
-	boost::shared_ptr<gsl_matrix> getCovar() const;
+	boost::shared_ptr<const gsl_matrix> getCovar() const;
+
+	/** Returns the coefficients for generating the process one 
+	 *	observation at a time, in units of getAmplitude().
+	 */
+	boost::shared_ptr<const ArCoeffs> getArCoeffs() const;
+
+	/** Returns the factor by which a light curve with coefficients 
+	 *	getArCoeffs() must be scaled.
+	 */
+	double getAmplitude() const;
 
 	double d;
 };
@@ -112,17 +357,28 @@ class DampedRandomWalk : public GaussianProcess {
 public: 
 	/** Initializes the light curve to represent a damped random walk.
 	 */
-	explicit DampedRandomWalk(const std::vector<double>& times, double diffus, double tau);
+	explicit DampedRandomWalk(const Cadence& times, double diffus, double tau);
 
 private:
-	/** Computes a realization of the light curve. 
-	 */	
-	void solveFluxes(std::vector<double>& fluxes) const;
+	/** Tests whether the light curve is computed from getCovar() by 
+	 *	the default implementation of solveMags()
+	 */
+	bool batchable() const;
 	
 	/** Allocates and initializes the covariance matrix for the 
 	 *	Gaussian process. 
 	 */
-	boost::shared_ptr<gsl_matrix> getCovar() const;
+	boost::shared_ptr<const gsl_matrix> getCovar() const;
+
+	/** Returns the coefficients for generating the process one 
+	 *	observation at a time, in units of getAmplitude().
+	 */
+	boost::shared_ptr<const ArCoeffs> getArCoeffs() const;
+
+	/** Returns the factor by which a light curve with coefficients 
+	 *	getArCoeffs() must be scaled.
+	 */
+	double getAmplitude() const;
 
 	double sigma, tau;
 };
@@ -134,17 +390,47 @@ class SimpleGp : public GaussianProcess {
 public: 
 	/** Initializes the light curve to represent a standard Gaussian process.
 	 */
-	explicit SimpleGp(const std::vector<double>& times, double sigma, double tau);
+	explicit SimpleGp(const Cadence& times, double sigma, double tau);
 
 private:
 	/** Computes a realization of the light curve. 
 	 */	
-//	void solveFluxes(std::vector<double>& fluxes) const;
+//	void solveMags(std::vector<double>& mags) const;
 	
-	/** Allocates and initializes the covariance matrix for the 
-	 *	Gaussian process. 
+	/** Returns the covariance matrix for the Gaussian process, in 
+	 *	units of getAmplitude()<sup>2</sup>. 
+	 */
+	boost::shared_ptr<const gsl_matrix> getCovar() const;
+
+	/** Returns an identifier of the matrix returned by getCovar()
+	 */
+	boost::uint64_t getCovarToken() const;
+
+	/** Returns the factor by which a light curve with covariance 
+	 *	getCovar() must be scaled.
+	 */
+	double getAmplitude() const;
+
+	/** Tests whether the covariance of the process depends only on 
+	 *	the separation between two times
+	 */
+	bool stationary() const;
+
+	/** Returns the covariance of the process at two times separated 
+	 *	by a given interval, in units of getAmplitude()<sup>2</sup>
 	 */
-	boost::shared_ptr<gsl_matrix> getCovar() const;
+	double kernel(double deltaT) const;
+
+	/** Tests whether the process can be approximated by a 
+	 *	state-space model
+	 */
+	bool hasStateSpace() const;
+
+	/** Computes an approximate realization of the process with a 
+	 *	state-space model, in units of getAmplitude()
+	 */
+	void stateSpaceRealization(const StochasticRng& rng, 
+			std::vector<double>& mags) const;
 	
 	double sigma, tau;
 };
@@ -157,18 +443,42 @@ public:
 	/** Initializes the light curve to represent a two-component 
 	 *	Gaussian process.
 	 */
-	explicit TwoScaleGp(const std::vector<double>& times, 
+	explicit TwoScaleGp(const Cadence& times, 
 			double sigma1, double tau1, double sigma2, double tau2);
 
 private:
 	/** Computes a realization of the light curve. 
 	 */	
-//	void solveFluxes(std::vector<double>& fluxes) const;
+//	void solveMags(std::vector<double>& mags) const;
 	
-	/** Allocates and initializes the covariance matrix for the 
-	 *	Gaussian process. 
+	/** Returns the covariance matrix for the Gaussian process. 
+	 */
+	boost::shared_ptr<const gsl_matrix> getCovar() const;
+
+	/** Returns an identifier of the matrix returned by getCovar()
+	 */
+	boost::uint64_t getCovarToken() const;
+
+	/** Tests whether the covariance of the process depends only on 
+	 *	the separation between two times
+	 */
+	bool stationary() const;
+
+	/** Returns the covariance of the process at two times separated 
+	 *	by a given interval
+	 */
+	double kernel(double deltaT) const;
+
+	/** Tests whether the process can be approximated by a 
+	 *	state-space model
+	 */
+	bool hasStateSpace() const;
+
+	/** Computes an approximate realization of the process with a 
+	 *	state-space model
 	 */
-	boost::shared_ptr<gsl_matrix> getCovar() const;
+	void stateSpaceRealization(const StochasticRng& rng, 
+			std::vector<double>& mags) const;
 
 	double sigma1, sigma2, tau1, tau2;
 };
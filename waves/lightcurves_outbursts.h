@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lightcurves_outbursts.h
  * @author Krzysztof Findeisen
  * @date Created May 2, 2012
- * @date Last modified March 20, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -42,18 +42,30 @@ namespace lcmc { namespace models {
  * @invariant Zero is the minimum flux returned by SlowPeak in the limit of 
  *	short flares.
  */
-class SlowPeak : public PeriodicLc {
+class SlowPeak : public TabulatedKernel<SlowPeak> {
 public: 
 	/** Initializes the light curve to represent a periodically 
 	 * outbursting function flux(time).
 	 */
-	explicit SlowPeak(const std::vector<double> &times, 
+	explicit SlowPeak(const Cadence& times, 
 			double amp, double period, double phase, double width);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	/** Returns the phase at which the waveform jumps
+	 */
+	double shapeBreak() const;
+	
+	/** Returns an upper bound on the curvature of the waveform
+	 */
+	double shapeCurvature(double amp) const;
+
+	// Lets the kernels call the waveform without virtual dispatch
+	friend class PeriodicKernel<SlowPeak>;
+	friend class TabulatedKernel<SlowPeak>;
 	
 	double width;
 };
@@ -66,18 +78,30 @@ private:
  * @invariant Zero is the minimum flux returned by FlarePeak in the limit of 
  *	short flares.
  */
-class FlarePeak : public PeriodicLc {
+class FlarePeak : public TabulatedKernel<FlarePeak> {
 public: 
 	/** Initializes the light curve to represent a periodically 
 	 * outbursting function flux(time).
 	 */
-	explicit FlarePeak(const std::vector<double> &times, 
+	explicit FlarePeak(const Cadence& times, 
 			double amp, double period, double phase, double rise, double width);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	/** Returns the phase at which the waveform jumps
+	 */
+	double shapeBreak() const;
+	
+	/** Returns an upper bound on the curvature of the waveform
+	 */
+	double shapeCurvature(double amp) const;
+
+	// Lets the kernels call the waveform without virtual dispatch
+	friend class PeriodicKernel<FlarePeak>;
+	friend class TabulatedKernel<FlarePeak>;
 	
 	double tExp, tLin;
 };
@@ -88,18 +112,21 @@ private:
  *
  * @invariant Zero is the minimum flux returned by SquarePeak.
  */
-class SquarePeak : public PeriodicLc {
+class SquarePeak : public PeriodicKernel<SquarePeak> {
 public: 
 	/** Initializes the light curve to represent a periodically 
 	 * outbursting function flux(time).
 	 */
-	explicit SquarePeak(const std::vector<double> &times, 
+	explicit SquarePeak(const Cadence& times, 
 			double amp, double period, double phase, double width);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<SquarePeak>;
 	
 	double width;
 };
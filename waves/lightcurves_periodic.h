@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lightcurves_periodic.h
  * @author Krzysztof Findeisen
  * @date Created February 23, 2012
- * @date Last modified May 22, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -31,10 +31,21 @@
 #define LCMCCURVEPERIH
 
 #include <string>
+#include <vector>
+#include <cstddef>
 #include "lcdeterministic.h"
 
 namespace lcmc { namespace models {
 
+/** Lets outburst and fade waveforms be interpolated from tables 
+ *	with a bounded error
+ */
+void setShapeTolerance(double tolerance);
+
+/** Returns the tolerance chosen with setShapeTolerance()
+ */
+double getShapeTolerance();
+
 /** PeriodicLc is the base class for all periodic light curve models. 
  * Each PeriodicLc subclass represents a particular waveform.
  * 
@@ -47,7 +58,7 @@ public:
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit PeriodicLc(const std::vector<double> &times, 
+	explicit PeriodicLc(const Cadence& times, 
 			double amp, double period, double phase);
 	virtual ~PeriodicLc();
 
@@ -56,6 +67,10 @@ private:
 	 */
 	double flux(double time) const;
 
+	/** Samples the light curve at many times.
+	 */
+	void fluxBatch(const double times[], double fluxes[], size_t n) const;
+
 	/** Samples the light curve at the specified phase. Subclasses of 
 	 * PeriodicLc should override this method to represent 
 	 * different waveforms.
@@ -87,26 +102,305 @@ private:
 	 */
 	virtual double fluxPhase(double phase, double amp) const = 0;
 	
+	/** Samples the light curve at many phases.
+	 */
+	virtual void fluxPhaseBatch(double phases[], size_t n, double amp) const;
+	
 	double amp, period, phase0;
 };
 
+/** PeriodicKernel is the base class for periodic light curves whose 
+ * waveform is fixed at compile time.
+ *
+ * PeriodicKernel uses the curiously recurring template pattern to 
+ * instantiate the waveform of @p Shape directly into the loop over 
+ * phases, so that the waveform can be inlined and vectorized. The 
+ * virtual interface of PeriodicLc and ILightCurve is unchanged.
+ *
+ * @tparam Shape The PeriodicLc subclass being defined. @p Shape must 
+ *	override PeriodicLc::fluxPhase(), and make PeriodicKernel<Shape> 
+ *	a friend if the override is private.
+ */
+template <class Shape>
+class PeriodicKernel : public PeriodicLc {
+protected:
+	/** Initializes the light curve to represent a periodic function 
+	 * flux(time).
+	 *
+	 * @param[in] times The times at which the light curve will be sampled.
+	 * @param[in] amp The amplitude of the light curve
+	 * @param[in] period The period of the light curve
+	 * @param[in] phase The phase of the light curve at time 0
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to 
+	 *	construct the object.
+	 * @exception lcmc::models::except::BadParam Thrown if any of the 
+	 *	parameters are outside their allowed ranges.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	explicit PeriodicKernel(const Cadence& times, 
+			double amp, double period, double phase) 
+			: PeriodicLc(times, amp, period, phase) {
+	}
+
+	/** Samples the waveform of @p Shape at many phases.
+	 *
+	 * @param[in,out] phases The phases at which observations are taken. 
+	 *	Each is replaced by the flux at that phase.
+	 * @param[in] n The number of elements in @p phases.
+	 * @param[in] amp The light curve amplitude, in the same units 
+	 *	as passed to the constructor.
+	 *
+	 * @pre Every element of @p phases is in [0, 1)
+	 *
+	 * @post @p phases[i] is replaced by 
+	 *	<tt>Shape::fluxPhase(phases[i], amp)</tt> for all i < @p n
+	 * 
+	 * @perform O(@p n) time
+	 *
+	 * @exception std::logic_error Thrown if a bug was found in the flux 
+	 *	calculations.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception. 
+	 *	The contents of @p phases are unspecified.
+	 */
+	void fluxPhaseBatch(double phases[], size_t n, double amp) const {
+		const Shape& shape = static_cast<const Shape&>(*this);
+		for(size_t i = 0; i < n; i++) {
+			// Qualified call is resolved statically
+			phases[i] = shape.Shape::fluxPhase(phases[i], amp);
+		}
+	}
+};
+
+/** ShapeTable samples one cycle of a waveform at evenly spaced phases, 
+ * and interpolates linearly between them.
+ *
+ * The cycle may be split into two segments at a phase where the 
+ * waveform or its slope jumps. Each segment has its own spacing, 
+ * chosen so that the interpolation error is bounded wherever the 
+ * waveform's second derivative is.
+ */
+class ShapeTable {
+public:
+	/** Chooses the phases at which to sample a waveform
+	 */
+	ShapeTable(double split, double curvature, double maxError, 
+		size_t maxNodes);
+	
+	/** Returns the number of phases at which the waveform is sampled
+	 *
+	 * @return The number of nodes, or 0 if the table cannot meet 
+	 *	its error bound with the number of nodes allowed.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	size_t size() const {
+		return values.size();
+	}
+	
+	/** Returns the phase at which to sample one node
+	 */
+	double node(size_t i) const;
+	
+	/** Records the waveform at one node
+	 *
+	 * @param[in] i The index of the node.
+	 * @param[in] value The waveform at node(@p i).
+	 *
+	 * @pre @p i < size()
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void set(size_t i, double value) {
+		values[i] = value;
+	}
+	
+	/** Interpolates the waveform at a phase
+	 *
+	 * @param[in] phase The phase at which to evaluate the waveform.
+	 *
+	 * @return The waveform at @p phase, to within the error given 
+	 *	to the constructor.
+	 *
+	 * @pre @p phase &isin; [0, 1)
+	 * @pre Every node has been set.
+	 *
+	 * @perform Constant time, with no transcendental functions.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	double operator()(double phase) const {
+		double x;
+		size_t first, cells;
+		if (phase < split) {
+			x     = phase * scaleBefore;
+			first = 0;
+			cells = nBefore;
+		} else {
+			x     = (phase - split) * scaleAfter;
+			first = firstAfter;
+			cells = nAfter;
+		}
+		// Rounding may put a phase at the end of its segment
+		size_t i = static_cast<size_t>(x);
+		if (i >= cells) {
+			i = cells - 1;
+		}
+		const double* const v = &values[first + i];
+		return v[0] + (x - static_cast<double>(i)) * (v[1] - v[0]);
+	}
+
+private:
+	/** The phase at which the second segment starts, or 0 if there 
+	 *	is only one segment */
+	double split;
+	/** The number of intervals in each segment */
+	size_t nBefore, nAfter;
+	/** The number of intervals per unit phase in each segment */
+	double scaleBefore, scaleAfter;
+	/** The index of the first node of the second segment */
+	size_t firstAfter;
+	/** The waveform at each node */
+	std::vector<double> values;
+};
+
+/** TabulatedKernel is the base class for periodic light curves whose 
+ * waveform is fixed at compile time and expensive to evaluate.
+ *
+ * If setShapeTolerance() has been given a positive tolerance, 
+ * TabulatedKernel samples the waveform of each light curve into a 
+ * ShapeTable before evaluating a batch of phases, then interpolates 
+ * every phase from the table. Single phases, and batches with fewer 
+ * phases than the table would need, are evaluated exactly.
+ *
+ * @tparam Shape The PeriodicLc subclass being defined. In addition to 
+ *	the requirements of PeriodicKernel, @p Shape must define 
+ *	<tt>double shapeBreak() const</tt>, which returns the phase in 
+ *	[0, 1) at which the waveform or its slope jumps (0 if there is no 
+ *	such phase), and <tt>double shapeCurvature(double amp) const</tt>, 
+ *	which returns an upper bound on the magnitude of the second 
+ *	derivative of tableFlux() away from that phase. @p Shape may hide 
+ *	tableFlux() and clipFlux() to tabulate a smooth part of its 
+ *	waveform, and make TabulatedKernel<Shape> a friend if those 
+ *	members are private.
+ */
+template <class Shape>
+class TabulatedKernel : public PeriodicKernel<Shape> {
+protected:
+	/** Initializes the light curve to represent a periodic function 
+	 * flux(time).
+	 *
+	 * @param[in] times The times at which the light curve will be sampled.
+	 * @param[in] amp The amplitude of the light curve
+	 * @param[in] period The period of the light curve
+	 * @param[in] phase The phase of the light curve at time 0
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory to 
+	 *	construct the object.
+	 * @exception lcmc::models::except::BadParam Thrown if any of the 
+	 *	parameters are outside their allowed ranges.
+	 *
+	 * @exceptsafe Object construction is atomic.
+	 */
+	explicit TabulatedKernel(const Cadence& times, 
+			double amp, double period, double phase) 
+			: PeriodicKernel<Shape>(times, amp, period, phase) {
+	}
+	
+	/** Samples the part of the waveform that is tabulated
+	 *
+	 * @param[in] phase The light curve phase, in [0, 1].
+	 * @param[in] amp The light curve amplitude.
+	 *
+	 * @return <tt>Shape::fluxPhase(phase, amp)</tt>
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	double tableFlux(double phase, double amp) const {
+		return static_cast<const Shape&>(*this).Shape::fluxPhase(phase, amp);
+	}
+	
+	/** Converts a value interpolated from tableFlux() to a flux
+	 *
+	 * @param[in] value The interpolated value.
+	 *
+	 * @return @p value
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	static double clipFlux(double value) {
+		return value;
+	}
+
+private:
+	/** Samples the waveform of @p Shape at many phases.
+	 *
+	 * @param[in,out] phases The phases at which observations are taken. 
+	 *	Each is replaced by the flux at that phase.
+	 * @param[in] n The number of elements in @p phases.
+	 * @param[in] amp The light curve amplitude, in the same units 
+	 *	as passed to the constructor.
+	 *
+	 * @pre Every element of @p phases is in [0, 1)
+	 *
+	 * @post @p phases[i] is replaced by 
+	 *	<tt>Shape::fluxPhase(phases[i], amp)</tt>, to within 
+	 *	getShapeTolerance() times @p amp, for all i < @p n
+	 * 
+	 * @perform O(@p n) time. If a table is used, the waveform is 
+	 *	evaluated exactly at no more than @p n phases.
+	 *
+	 * @exception std::bad_alloc Thrown if there is not enough memory 
+	 *	for the table.
+	 * @exception std::logic_error Thrown if a bug was found in the flux 
+	 *	calculations.
+	 *
+	 * @exceptsafe The object is unchanged in the event of an exception. 
+	 *	The contents of @p phases are unspecified.
+	 */
+	void fluxPhaseBatch(double phases[], size_t n, double amp) const {
+		const Shape& shape = static_cast<const Shape&>(*this);
+		const double tolerance = getShapeTolerance();
+		if (tolerance > 0.0) {
+			// A table with more nodes than phases saves nothing
+			ShapeTable table(shape.Shape::shapeBreak(), 
+				shape.Shape::shapeCurvature(amp), tolerance * amp, n);
+			if (table.size() > 0) {
+				for(size_t i = 0; i < table.size(); i++) {
+					table.set(i, shape.Shape::tableFlux(table.node(i), amp));
+				}
+				for(size_t i = 0; i < n; i++) {
+					phases[i] = Shape::clipFlux(table(phases[i]));
+				}
+				return;
+			}
+		}
+		PeriodicKernel<Shape>::fluxPhaseBatch(phases, n, amp);
+	}
+};
+
 /** SineWave describes sinusoidal variables in flux space. The light curve can 
  * be described entirely by its amplitude, period, and phase offset.
  *
  * @invariant One is the mean flux returned by SineWave.
  */
-class SineWave : public PeriodicLc {
+class SineWave : public PeriodicKernel<SineWave> {
 public: 
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit SineWave(const std::vector<double> &times, 
+	explicit SineWave(const Cadence& times, 
 			double amp, double period, double phase);
 
 private:
 	/** Samples the sinusoidal waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<SineWave>;
 };
 
 /** TriangleWave describes pseudo-sinusoidal variables with sharper minima and 
@@ -115,18 +409,21 @@ private:
  *
  * @invariant One is the mean flux returned by TriangleWave.
  */
-class TriangleWave : public PeriodicLc {
+class TriangleWave : public PeriodicKernel<TriangleWave> {
 public: 
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit TriangleWave(const std::vector<double> &times, 
+	explicit TriangleWave(const Cadence& times, 
 			double amp, double period, double phase);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<TriangleWave>;
 };
 
 /** EllipseWave describes pseudo-sinusoidal variables with asymmetric minima 
@@ -135,18 +432,21 @@ private:
  *
  * @invariant One is the mean flux returned by EllipseWave.
  */
-class EllipseWave : public PeriodicLc {
+class EllipseWave : public PeriodicKernel<EllipseWave> {
 public: 
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit EllipseWave(const std::vector<double> &times, 
+	explicit EllipseWave(const Cadence& times, 
 			double amp, double period, double phase);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<EllipseWave>;
 };
 
 /** EclipseWave describes variables with pairs of periodic dimmings. The 
@@ -157,18 +457,21 @@ private:
  *
  * @invariant One is the maximum flux returned by EclipseWave.
  */
-class EclipseWave : public PeriodicLc {
+class EclipseWave : public PeriodicKernel<EclipseWave> {
 public: 
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit EclipseWave(const std::vector<double> &times, 
+	explicit EclipseWave(const Cadence& times, 
 			double amp, double period, double phase);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<EclipseWave>;
 };
 
 /** BroadPeakWave describes periodic variables that smoothly rise to a maximum. 
@@ -177,18 +480,21 @@ private:
  *
  * @invariant One is the minimum flux returned by BroadPeakWave.
  */
-class BroadPeakWave : public PeriodicLc {
+class BroadPeakWave : public PeriodicKernel<BroadPeakWave> {
 public: 
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit BroadPeakWave(const std::vector<double> &times, 
+	explicit BroadPeakWave(const Cadence& times, 
 			double amp, double period, double phase);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<BroadPeakWave>;
 };
 
 /** SharpPeakWave describes periodic variables that smoothly rise to a maximum. 
@@ -197,18 +503,21 @@ private:
  *
  * @invariant One is the minimum flux returned by SharpPeakWave.
  */
-class SharpPeakWave : public PeriodicLc {
+class SharpPeakWave : public PeriodicKernel<SharpPeakWave> {
 public: 
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit SharpPeakWave(const std::vector<double> &times, 
+	explicit SharpPeakWave(const Cadence& times, 
 			double amp, double period, double phase);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<SharpPeakWave>;
 };
 
 /** MagSineWave describes sinusoidal variables in magnitude space. The light 
@@ -216,18 +525,21 @@ private:
  *
  * @invariant One is the median flux returned by MagSineWave.
  */
-class MagSineWave : public PeriodicLc {
+class MagSineWave : public PeriodicKernel<MagSineWave> {
 public: 
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit MagSineWave(const std::vector<double> &times, 
+	explicit MagSineWave(const Cadence& times, 
 			double amp, double period, double phase);
 
 private:
 	/** Samples the sinusoidal waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<MagSineWave>;
 };
 
 /** AaTauWave describes variables with periodic dips in magnitude space. The light 
@@ -236,18 +548,21 @@ private:
  *
  * @invariant One is the modal flux returned by AaTauWave.
  */
-class AaTauWave : public PeriodicLc {
+class AaTauWave : public PeriodicKernel<AaTauWave> {
 public: 
 	/** Initializes the light curve to represent a periodic function 
 	 * flux(time).
 	 */
-	explicit AaTauWave(const std::vector<double> &times, 
+	explicit AaTauWave(const Cadence& times, 
 			double amp, double period, double phase, double width);
 
 private:
 	/** Samples the waveform at the specified phase.
 	 */
 	double fluxPhase(double phase, double amp) const;
+
+	// Lets PeriodicKernel call fluxPhase() without virtual dispatch
+	friend class PeriodicKernel<AaTauWave>;
 	
 	double width;
 };
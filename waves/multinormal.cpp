@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/multinormal.cpp
  * @author Krzysztof Findeisen
  * @date Created April 18, 2013
- * @date Last modified August 1, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -28,19 +28,37 @@
  */
 
 #include <algorithm>
+#include <list>
 #include <string>
 #include <stdexcept>
 #include <vector>
 #include <cmath>
+#include <cstdio>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/cstdint.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_eigen.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_vector.h>
 #include "generators.h"
+#include "../cachestats.h"
+#include "../diskcache.h"
 #include "../gsl_compat.h"
+#include "../gslpool.tmp.h"
+#include "../hash.h"
+#include "../lapack_compat.h"
+#include "../largealloc.tmp.h"
+#include "../numa.h"
+#include "../stats/profile.h"
+#include "../stats/trace.h"
 #include "../../common/alloc.tmp.h"
 
 namespace lcmc { namespace utils {
@@ -48,16 +66,30 @@ namespace lcmc { namespace utils {
 using std::vector;
 using boost::lexical_cast;
 using boost::shared_ptr;
+using boost::uint32_t;
+using boost::uint64_t;
 using kpfutils::checkAlloc;
 
 /** Given a matrix A, returns a matrix B with the property 
  *	@f$ A = B B^\intercal @f$
  */
-shared_ptr<gsl_matrix> getHalfMatrix(const shared_ptr<gsl_matrix>& a);
+shared_ptr<gsl_matrix> getHalfMatrix(const shared_ptr<const gsl_matrix>& a);
+
+#ifdef LCMC_USE_LAPACK
+/** Given a matrix A, returns a matrix B with the property 
+ *	@f$ A = B B^\intercal @f$, using LAPACK
+ */
+shared_ptr<gsl_matrix> lapackHalfMatrix(const shared_ptr<const gsl_matrix>& a);
+#endif
+
+/** Given a matrix A, returns a lower triangular matrix L with the property 
+ *	@f$ A \approx L L^\intercal @f$
+ */
+shared_ptr<gsl_matrix> getCholeskyMatrix(const shared_ptr<const gsl_matrix>& a);
 
 /** Replaces one matrix with the value of another.
  */
-void matrixCopy(shared_ptr<gsl_matrix>& target, const shared_ptr<gsl_matrix>& newData);
+void matrixCopy(shared_ptr<gsl_matrix>& target, const shared_ptr<const gsl_matrix>& newData);
 
 // Include this function only if gsl_is_matrix_equal() is not available
 #ifndef _GSL_HAS_MATRIX_EQUAL
@@ -66,47 +98,414 @@ void matrixCopy(shared_ptr<gsl_matrix>& target, const shared_ptr<gsl_matrix>& ne
 bool matrixEqual(const gsl_matrix* const a, const gsl_matrix* const b);
 #endif
 
-/** Transforms an uncorrelated sequence of Gaussian random numbers into a 
- *	correlated sequence
+/** The default number of factorizations remembered by multiNormal()
  *
- * @param[in] indVec A vector of independent unit Gaussian random numbers.
- * @param[in] covar The desired covariance matrix.
- * @param[out] corrVec A vector of correlated Gaussian random numbers with 
- *	mean zero and covariance matrix covar.
+ * Several light curve types, or several cadences, may be simulated in 
+ * alternation, so a single cached factorization is not enough.
+ */
+const size_t FACTOR_CACHE_SIZE = 4;
+
+/** Returns the number of factorizations remembered by multiNormal()
  *
- * @pre @p indVec.size() = @p covar->size1 = @p covar->size2
- * @pre @p covar is symmetric and positive semidefinite
- * @pre @p corrVec may refer to the same vector as @p indVec
+ * @return A modifiable cache size.
  *
- * @post @p corrVec.size() = @p indVec.size()
+ * @exceptsafe Does not throw exceptions.
+ */
+size_t& factorCacheSize() {
+	static size_t nFactors = FACTOR_CACHE_SIZE;
+	return nFactors;
+}
+
+/** Stores the factorization of one covariance matrix
+ */
+struct CovarFactorization {
+	/** Creates an empty factorization
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	CovarFactorization() : method(FACTOR_EIGEN), covar(), half(), 
+			triangular(false), node(0), token(0) {
+	}
+
+	/** The method requested when the factorization was computed */
+	CovarFactor method;
+	/** The factored matrix. Owns a deallocator gsl_matrix_free() */
+	shared_ptr<gsl_matrix> covar;
+	/** A matrix B such that @f$ covar = B B^\intercal @f$. Owns a 
+	 *	deallocator gsl_matrix_free(), or UnmapMatrix if loaded 
+	 *	by readFactor() */
+	shared_ptr<gsl_matrix> half;
+	/** True if @p half is lower triangular */
+	bool triangular;
+	/** The NUMA node whose threads use this copy of the factorization */
+	size_t node;
+	/** The identifier of @p covar given by the caller, or 0 if none */
+	uint64_t token;
+};
+
+/** Tests whether a cached factorization is of a particular matrix
  *
- * @perform O(N<sup>3</sup>) time, where N = @p times.size()
- * @perfmore O(N<sup>2</sup>) memory
- * 
- * @exception std::bad_alloc Thrown if there was not enough memory to 
- *	compute the transformation
- * @exception std::invalid_argument Thrown if the lengths do not match 
- *	or if the matrix is not symmetric or positive semidefinite.
+ * @param[in] factor The cached factorization.
+ * @param[in] covar The matrix to look up.
+ * @param[in] token The identifier of @p covar, or 0 if it has none.
  *
- * @exceptsafe The parameters are unchanged in the event of an exception.
+ * @return If both @p factor and @p covar have identifiers, whether 
+ *	the identifiers are equal. Otherwise, whether the matrices have 
+ *	the same elements.
+ *
+ * @perform Constant time if both matrices have identifiers, 
+ *	O(N<sup>2</sup>) time otherwise, where N = @p covar->size1.
  *
- * @internal @exceptsafe The internal cache in multiNormal() provides only the 
- *	basic exception guarantee. However, aside from run time this is not 
- *	visible to the rest of the program.
+ * @exceptsafe Does not throw exceptions.
  */
-void multiNormal(const vector<double>& indVec, const shared_ptr<gsl_matrix>& covar, 
-		vector<double>& corrVec) {
-	// invariant: covCache is empty xor 
-	//	owns a deallocator gsl_matrix_free()
-	// invariant: prefixCache is empty xor 
-	//	owns a deallocator gsl_matrix_free()
-	// invariant: covCache is empty <=> prefixCache is empty
-	// invariant: if covCache is not empty, then 
-	//	prefixCache == getHalfMatrix(covCache)
-	static shared_ptr<gsl_matrix> covCache;
-	static shared_ptr<gsl_matrix> prefixCache;
+bool sameCovar(const CovarFactorization& factor, const gsl_matrix* const covar, 
+		uint64_t token) {
+	if (token != 0 && factor.token != 0) {
+		return factor.token == token;
+	}
+	return sameMatrix(factor.covar.get(), covar);
+}
 
-	const size_t N = indVec.size();
+/** Returns the method used by multiNormal() to factor new matrices
+ *
+ * @return A modifiable reference to the method.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+CovarFactor& covarMethod() {
+	static CovarFactor method = FACTOR_EIGEN;
+	return method;
+}
+
+/** Selects how multiNormal() factors covariance matrices
+ *
+ * @param[in] method The factorization to use for all subsequent calls 
+ *	to multiNormal().
+ *
+ * @post multiNormal() factors covariance matrices using @p method. 
+ *	Factorizations computed with the previous method are not reused.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void setCovarFactor(CovarFactor method) {
+	covarMethod() = method;
+}
+
+/** Returns the method chosen with setCovarFactor()
+ *
+ * @return The method used to factor new covariance matrices.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+CovarFactor getCovarFactor() {
+	return covarMethod();
+}
+
+/** Ensures that multiNormal() remembers at least a given number of 
+ *	covariance factorizations
+ *
+ * @param[in] nFactors The number of factorizations to keep. Each takes 
+ *	as much memory as two covariance matrices.
+ *
+ * @post multiNormal() keeps the factorizations of at least the last 
+ *	@p nFactors distinct matrices.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void reserveFactorCache(size_t nFactors) {
+	factorCacheSize() = std::max(factorCacheSize(), nFactors);
+}
+
+/** Returns the directory in which factorizations are saved
+ *
+ * @return A modifiable directory name, empty if factorizations are not 
+ *	saved between runs.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+std::string& factorCacheDir() {
+	static std::string theDir;
+	return theDir;
+}
+
+/** Saves covariance factorizations to disk for use by later runs
+ *
+ * @param[in] dir The directory in which to save factorizations, or an 
+ *	empty string to not save them.
+ *
+ * @post Subsequent calls to multiNormal() and multiNormalBatch() look 
+ *	for factorizations in @p dir before computing them, and save any 
+ *	new factorizations to @p dir. The directory is created if necessary.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	to store the directory name.
+ *
+ * @exceptsafe The cache directory is unchanged in the event of an exception.
+ */
+void setFactorCacheDir(const std::string& dir) {
+	factorCacheDir() = dir;
+}
+
+/** The layout of the start of a saved factorization
+ *
+ * The header is followed by the N&times;N elements of the factor, 
+ * in row-major order.
+ */
+struct FactorFileHeader {
+	/** Identifies the file format */
+	char magic[8];
+	/** The hash of the covariance matrix, as computed by factorKey() */
+	uint64_t key;
+	/** The dimension of the matrix */
+	uint64_t size;
+	/** The method requested when the factorization was computed */
+	uint32_t method;
+	/** Nonzero if the factor is lower triangular */
+	uint32_t triangular;
+};
+
+/** The value of FactorFileHeader::magic for the current file format
+ */
+const char FACTOR_MAGIC[8] = {'L', 'C', 'M', 'C', 'F', 'A', 'C', '1'};
+
+/** Identifies a covariance factorization
+ *
+ * The matrix is a function of the times, the kernel and its parameters, 
+ * so hashing the matrix distinguishes all three without needing to know 
+ * which kernel produced it.
+ *
+ * @param[in] covar The matrix to factor.
+ * @param[in] method The method used to factor the matrix.
+ *
+ * @return A hash of the matrix, the method, and the linear algebra 
+ *	backend the program was built with.
+ *
+ * @perform O(N<sup>2</sup>) time, where N = @p covar->size1
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint64_t factorKey(const gsl_matrix* covar, CovarFactor method) {
+	// Different backends give different, but equally valid, factors
+#if defined(LCMC_USE_CUDA)
+	const char backend[] = "cuda";
+#elif defined(LCMC_USE_LAPACK)
+	const char backend[] = "lapack";
+#else
+	const char backend[] = "gsl";
+#endif
+	const int methodId = static_cast<int>(method);
+	const uint64_t n1 = covar->size1;
+	const uint64_t n2 = covar->size2;
+	
+	uint64_t hash = fnvBasis();
+	hash = fnvHash(hash, backend, sizeof(backend));
+	hash = fnvHash(hash, &methodId, sizeof(methodId));
+	hash = fnvHash(hash, &n1, sizeof(n1));
+	hash = fnvHash(hash, &n2, sizeof(n2));
+	for(size_t i = 0; i < covar->size1; i++) {
+		hash = fnvHash(hash, gsl_matrix_const_ptr(covar, i, 0), 
+			covar->size2 * sizeof(double));
+	}
+	return hash;
+}
+
+/** Returns the name of the file in which a factorization is saved
+ *
+ * @param[in] dir The cache directory.
+ * @param[in] key The identifier of the factorization.
+ *
+ * @return The path to the file.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory
+ *	for the file name.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+std::string factorFile(const std::string& dir, uint64_t key) {
+	char name[64];
+	sprintf(name, "covfactor_%08lx%08lx.bin",
+		static_cast<unsigned long>((key >> 32) & 0xffffffffUL),
+		static_cast<unsigned long>( key        & 0xffffffffUL));
+	return dir + "/" + name;
+}
+
+/** Deallocator for a matrix whose elements are in a memory-mapped 
+ *	factorization file
+ */
+class UnmapMatrix {
+public:
+	/** Prepares to unmap a file
+	 *
+	 * @param[in] length The length of the mapping, in bytes.
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	explicit UnmapMatrix(size_t length) : length(length) {
+	}
+	
+	/** Unmaps the file and deletes the matrix
+	 *
+	 * @param[in] m A matrix created by readFactor().
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	void operator()(gsl_matrix* m) const {
+		// The file starts with a header, followed by the matrix
+		char* const start = static_cast<char*>(static_cast<void*>(m->data)) 
+			- sizeof(FactorFileHeader);
+		munmap(start, length);
+		delete m;
+	}
+
+private:
+	size_t length;
+};
+
+/** Loads a factorization saved by a previous run
+ *
+ * The file is memory-mapped rather than read, so loading takes 
+ * constant time and the factor is paged in as it is used.
+ *
+ * @param[in] fileName The file to read.
+ * @param[in] key, method, nDim The properties of the factorization, 
+ *	used to check that the file matches.
+ * @param[out] factor The factorization whose half and triangular 
+ *	members are to be loaded.
+ *
+ * @return True if the file exists and matches the factorization, 
+ *	false otherwise.
+ *
+ * @post If the return value is true, @p factor.half is a read-only 
+ *	view of the file. Otherwise, @p factor is unchanged.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool readFactor(const std::string& fileName, uint64_t key, CovarFactor method, 
+		size_t nDim, CovarFactorization& factor) {
+	const size_t length = sizeof(FactorFileHeader) + nDim*nDim*sizeof(double);
+	
+	const int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) != length) {
+		close(fd);
+		return false;
+	}
+	void* const start = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping remains valid after the file is closed
+	close(fd);
+	if (start == MAP_FAILED) {
+		return false;
+	}
+	
+	const FactorFileHeader* const header = 
+		static_cast<const FactorFileHeader*>(start);
+	if (!std::equal(FACTOR_MAGIC, FACTOR_MAGIC + sizeof(FACTOR_MAGIC), header->magic)
+			|| header->key != key || header->size != nDim
+			|| header->method != static_cast<uint32_t>(method)) {
+		munmap(start, length);
+		return false;
+	}
+	const bool triangular = (header->triangular != 0);
+	
+	gsl_matrix* view = NULL;
+	try {
+		view = new gsl_matrix;
+	} catch (const std::bad_alloc& e) {
+		munmap(start, length);
+		return false;
+	}
+	view->size1 = nDim;
+	view->size2 = nDim;
+	view->tda   = nDim;
+	// The matrix is never written to, so the mapping can be read-only
+	view->data  = static_cast<double*>(static_cast<void*>(
+		static_cast<char*>(start) + sizeof(FactorFileHeader)));
+	view->block = NULL;
+	view->owner = 0;
+	
+	shared_ptr<gsl_matrix> half;
+	try {
+		half = shared_ptr<gsl_matrix>(view, UnmapMatrix(length));
+	} catch (const std::bad_alloc& e) {
+		// shared_ptr has already called the deallocator
+		return false;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	factor.half.swap(half);
+	factor.triangular = triangular;
+	return true;
+}
+
+/** Saves a factorization for future runs
+ *
+ * The factorization is first written to a uniquely named temporary 
+ * file, then moved into place, so that other threads and processes 
+ * never read a partial file. Old files are then evicted if the cache 
+ * is over the limit set by setDiskCacheLimit(). Failure to save the 
+ * factorization is not an error, since it can always be recalculated.
+ *
+ * @param[in] dir The cache directory.
+ * @param[in] fileName The file to write.
+ * @param[in] key The identifier of the factorization.
+ * @param[in] factor The factorization to save.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void writeFactor(const std::string& dir, const std::string& fileName, 
+		uint64_t key, const CovarFactorization& factor) {
+	try {
+		const gsl_matrix* const half = factor.half.get();
+		FactorFileHeader header;
+		std::copy(FACTOR_MAGIC, FACTOR_MAGIC + sizeof(FACTOR_MAGIC), header.magic);
+		header.key        = key;
+		header.size       = half->size1;
+		header.method     = static_cast<uint32_t>(factor.method);
+		header.triangular = (factor.triangular ? 1 : 0);
+		
+		std::string tempName;
+		bool written;
+		{
+			shared_ptr<FILE> file = openCacheTemp(dir, fileName, tempName);
+			if (file.get() == NULL) {
+				fprintf(stderr, "WARNING: could not save covariance factorization to %s\n",
+					fileName.c_str());
+				return;
+			}
+			
+			written = (fwrite(&header, sizeof(header), 1, file.get()) == 1);
+			for(size_t i = 0; written && i < half->size1; i++) {
+				written = (fwrite(gsl_matrix_const_ptr(half, i, 0), sizeof(double), 
+					half->size2, file.get()) == half->size2);
+			}
+			written = written && (fflush(file.get()) == 0);
+		}
+		
+		if (written) {
+			commitCacheFile(dir, tempName, fileName);
+		} else {
+			remove(tempName.c_str());
+		}
+	} catch (const std::bad_alloc& e) {
+		// Saving is optional
+	}
+}
+
+/** Verifies that a vector can be transformed using a covariance matrix
+ *
+ * @param[in] N The length of the vector to transform.
+ * @param[in] covar The desired covariance matrix.
+ *
+ * @exception std::invalid_argument Thrown if @p covar is not square, or 
+ *	if its dimensions do not match @p N.
+ *
+ * @exceptsafe Does not change any arguments.
+ */
+void checkDimensions(size_t N, const shared_ptr<const gsl_matrix>& covar) {
 	if(covar->size1 != covar->size2) {
 		try {
 			std::string len1 = lexical_cast<std::string>(covar->size1);
@@ -130,69 +529,615 @@ void multiNormal(const vector<double>& indVec, const shared_ptr<gsl_matrix>& cov
 				"Length of input vector to multiNormal() does not match dimensions of covariance matrix.");
 		}
 	}
+}
 
-	// Is the cache valid?
+/** Returns the memory held by a range of factorizations
+ *
+ * @param[in] begin, end The factorizations to measure.
+ *
+ * @return The number of bytes in their matrices, counting matrices that 
+ *	are shared with other objects or mapped from a file.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+template <class ConstIterator>
+size_t factorBytes(ConstIterator begin, ConstIterator end) {
+	size_t bytes = 0;
+	for(ConstIterator it = begin; it != end; it++) {
+		if (it->covar.get() != NULL) {
+			bytes += it->covar->size1 * it->covar->size2 * sizeof(double);
+		}
+		if (it->half.get() != NULL) {
+			bytes += it->half->size1 * it->half->size2 * sizeof(double);
+		}
+	}
+	return bytes;
+}
+
+/** Returns the factorization of a covariance matrix, computing it if 
+ *	it is not already cached
+ *
+ * Factorizations are remembered for the life of the process and, if 
+ * setFactorCacheDir() has been called, saved to disk for later runs. 
+ * If threads are pinned to NUMA nodes (see utils::setNumaPinning()), 
+ * each node caches its own copy, copied from another node's if possible.
+ *
+ * @param[in] covar The matrix to factor.
+ * @param[in] token An identifier of the elements of @p covar, or 0 to 
+ *	identify the matrix by comparing its elements.
+ *
+ * @return A factorization of @p covar by the method chosen with 
+ *	setCovarFactor(). The factorization shares its matrices with 
+ *	the cache, so it remains valid after the cache forgets it.
+ *
+ * @pre @p covar is square, symmetric and positive semidefinite
+ *
+ * @post The factorization of @p covar is the most recently used 
+ *	element of the cache.
+ *
+ * @perform O(N<sup>3</sup>) time, where N = @p covar->size1, if 
+ *	@p covar is not one of the cached matrices or saved to disk. 
+ *	O(N<sup>2</sup>) time otherwise, or O(K) time if @p token is 
+ *	nonzero and the cached factorization has a token, where K is 
+ *	the number of cached factorizations.
+ * 
+ * @exception std::bad_alloc Thrown if there was not enough memory to 
+ *	factor the matrix
+ * @exception std::invalid_argument Thrown if the matrix is not 
+ *	positive semidefinite.
+ *
+ * @exceptsafe The cache is unchanged in the event of an exception.
+ *
+ * @note May be called from several threads at once.
+ */
+CovarFactorization findFactorization(const shared_ptr<const gsl_matrix>& covar, 
+		uint64_t token) {
+	// invariant: every element of factorCache has non-empty covar and 
+	//	half, both owning a deallocator gsl_matrix_free()
+	// invariant: elements are in order from most to least recently used
+	// invariant: factorCache.size() <= factorCacheSize()
+	// invariant: factorCache has at most one element per matrix, 
+	//	method, and NUMA node
+	typedef std::list<CovarFactorization> FactorList;
+	static boost::mutex cacheLock;
+	static FactorList factorCache;
+	static CacheCounter counter("Covariance factorizations");
+	static CacheCounter diskCounter("Covariance factorizations on disk");
+
+	// Is the matrix in the cache?
+	const CovarFactor method = covarMethod();
+	const size_t node = utils::currentNumaNode();
+	CovarFactorization replica;
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		FactorList::iterator match = factorCache.begin();
+		for(; match != factorCache.end(); match++) {
+			if (match->method == method 
+					&& sameCovar(*match, covar.get(), token)) {
+				if (match->node == node) {
+					break;
+				}
+				replica = *match;
+			}
+		}
+		if (match != factorCache.end()) {
+			counter.hit();
+			if (match != factorCache.begin()) {
+				// Splicing a list never throws
+				factorCache.splice(factorCache.begin(), factorCache, match);
+			}
+			return factorCache.front();
+		}
+	}
 	
-	// Note: isMatrixClose() is no longer used because it's 
-	// significantly slower than gsl_matrix_equal(). The extra 
-	// overhead from approximate comparison exceeded the negligible 
-	// risk of a spurious cache miss.
-	#ifdef _GSL_HAS_MATRIX_EQUAL
-	if(prefixCache.get() == NULL || gsl_matrix_equal(covCache.get(), covar.get()) != 1) {
-	#else
-	if(prefixCache.get() == NULL || !matrixEqual(covCache.get(), covar.get())) {
-	#endif
-		// copy-and-swap to ensure the cache is only updated 
-		//	if there are no exceptions
-		shared_ptr<gsl_matrix> temp;
-		matrixCopy(temp, covar);
+	const CacheMiss miss(counter);
+	
+	// Don't hold the lock while factoring, so that threads working 
+	//	on other matrices are not blocked
+	// copy-and-swap to ensure the cache is only updated 
+	//	if there are no exceptions
+	CovarFactorization temp;
+	temp.method = method;
+	temp.node   = node;
+	temp.token  = token;
+	matrixCopy(temp.covar, covar);
+	
+	// Warm runs can load the factor computed by an earlier run
+	const std::string dir = factorCacheDir();
+	const uint64_t key = (dir.empty() ? 0 : factorKey(covar.get(), method));
+	const std::string fileName = (dir.empty() ? "" : factorFile(dir, key));
+	if (replica.half.get() != NULL) {
+		// Copying another node's factor, on this node, is O(N^2)
+		matrixCopy(temp.half, replica.half);
+		temp.triangular = replica.triangular;
+	} else if (!dir.empty() && readFactor(fileName, key, method, covar->size1, temp)) {
+		diskCounter.hit();
+		touchCacheFile(fileName);
+	} else {
+		const stats::TraceSpan span("factorize");
+		const double start = stats::monotonicSeconds();
+		if (method == FACTOR_CHOLESKY) {
+			temp.half = getCholeskyMatrix(covar);
+			temp.triangular = (temp.half.get() != NULL);
+		}
+		// Large eigendecompositions are faster on a device, if 
+		//	one is available
+		if (temp.half.get() == NULL && !deviceHalfMatrix(covar, temp.half)) {
+			temp.half = getHalfMatrix(covar);
+		}
+		
+		if (!dir.empty()) {
+			writeFactor(dir, fileName, key, temp);
+			diskCounter.miss(stats::monotonicSeconds() - start);
+		}
+	}
+	
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
 		
-		// assert: prefixCache is empty xor owns gsl_matrix_free()
-		// assert: covar is non-empty and owns gsl_matrix_free()
-
 		// Last operation in this block that is allowed to throw
-		prefixCache = getHalfMatrix(covar);
+		factorCache.push_front(temp);
 		
-		// assert: prefixCache is non-empty and owns gsl_matrix_free
-		// assert: covar is non-empty and owns gsl_matrix_free()
-		// assert: temp is non-empty and owns gsl_matrix_free()
-		// assert: covCache is empty xor owns gsl_matrix_free()
-		using std::swap;
-		swap(covCache, temp);
-		// assert: covCache is non-empty and owns gsl_matrix_free()
-		// assert: temp is empty xor owns gsl_matrix_free()
-	}
-	
-	// In C++11, can directly return a vector_const_view of indVec
-	// For now, make a copy
-	shared_ptr<gsl_vector> temp(checkAlloc(gsl_vector_alloc(N)), &gsl_vector_free);
-	for(size_t i = 0; i < N; i++) {
-		// assert: i is a valid index for both temp and indVec
-		gsl_vector_set(temp.get(), i, indVec[i]);
+		// IMPORTANT: no exceptions beyond this point
+		
+		if (factorCache.size() > factorCacheSize() * utils::numaNodeCount()) {
+			factorCache.pop_back();
+		}
+		counter.setBytes(factorBytes(factorCache.begin(), factorCache.end()));
 	}
+	return temp;
+}
+
+/** Transforms an uncorrelated sequence of Gaussian random numbers into a 
+ *	correlated sequence
+ *
+ * @param[in] indVec A vector of independent unit Gaussian random numbers.
+ * @param[in] covar The desired covariance matrix.
+ * @param[in] token An identifier of the elements of @p covar, such as 
+ *	a hash of the parameters from which it was computed, or 0 to 
+ *	identify the matrix by comparing its elements.
+ * @param[out] corrVec A vector of correlated Gaussian random numbers with 
+ *	mean zero and covariance matrix covar.
+ *
+ * @pre @p indVec.size() = @p covar->size1 = @p covar->size2
+ * @pre @p covar is symmetric and positive semidefinite
+ * @pre @p corrVec may refer to the same vector as @p indVec
+ *
+ * @post @p corrVec.size() = @p indVec.size()
+ *
+ * The factorizations of the last few covariance matrices are cached, 
+ *	with the least recently used factorization discarded first, so 
+ *	alternating between a few matrices does not require refactoring 
+ *	them. The factorization method is chosen by setCovarFactor().
+ *
+ * @perform O(N<sup>3</sup>) time, where N = @p indVec.size(), if 
+ *	@p covar is not one of the cached matrices. O(N<sup>2</sup>) time 
+ *	otherwise. Finding a cached matrix takes constant time per cached 
+ *	matrix if @p token is nonzero, instead of O(N<sup>2</sup>).
+ * @perfmore O(N<sup>2</sup>) memory
+ * 
+ * @exception std::bad_alloc Thrown if there was not enough memory to 
+ *	compute the transformation
+ * @exception std::invalid_argument Thrown if the lengths do not match 
+ *	or if the matrix is not symmetric or positive semidefinite.
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+void multiNormal(const vector<double>& indVec, const shared_ptr<const gsl_matrix>& covar, 
+		vector<double>& corrVec, uint64_t token) {
+	using std::swap;
 
+	const size_t N = indVec.size();
+	checkDimensions(N, covar);
+
+	const CovarFactorization factor = findFactorization(covar, token);
+	
 	// Storage for the output
-	// calloc to prevent weirdness in the call to gsl_blas_dgemv
-	shared_ptr<gsl_vector> result(checkAlloc(gsl_vector_calloc(N)), &gsl_vector_free);
+	// Separate from corrVec, since corrVec may alias indVec
+	vector<double> result(N);
+	if (N == 0) {
+		// GSL does not allow views of empty arrays
+		swap(corrVec, result);
+		return;
+	}
 	
 	// Multiply the prefix matrix by the uncorrelated vector to 
 	//	get the correlated one
-	// The product is stored in result
-	gslCheck( gsl_blas_dgemv(CblasNoTrans, 1.0, prefixCache.get(), temp.get(), 
-		0.0, result.get()), "While generating multivariate normal vector: ");
+	// Both vectors are views of the caller's storage, so the data 
+	//	are never copied into GSL-owned buffers
+	gsl_vector_view resultView = gsl_vector_view_array(&result[0], N);
+	if (factor.triangular) {
+		// A triangular product takes half the work of a full one
+		std::copy(indVec.begin(), indVec.end(), result.begin());
+		gslCheck( gsl_blas_dtrmv(CblasLower, CblasNoTrans, CblasNonUnit, 
+			factor.half.get(), &resultView.vector), 
+			"While generating multivariate normal vector: ");
+	} else {
+		gsl_vector_const_view indView = gsl_vector_const_view_array(&indVec[0], N);
+		gslCheck( gsl_blas_dgemv(CblasNoTrans, 1.0, factor.half.get(), 
+			&indView.vector, 0.0, &resultView.vector), 
+			"While generating multivariate normal vector: ");
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
 	
-	// corrVec untouched up to this point -- atomic guarantee satisfied
+	swap(corrVec, result);
+}
 
-	// We'd want to make a copy even in a C++11 implementation
-	corrVec.reserve(N);
-	// vector::reserve() is atomic since doubles are nothrow-copyable
+/** Transforms several uncorrelated sequences of Gaussian random numbers 
+ *	into correlated sequences with the same covariance
+ *
+ * Equivalent to calling multiNormal() on each element of @p indVecs, but 
+ * all the sequences are multiplied by the factored covariance matrix 
+ * in a single matrix-matrix product, which makes much better use of 
+ * the processor cache than one matrix-vector product per sequence.
+ *
+ * @param[in] indVecs A list of vectors of independent unit Gaussian 
+ *	random numbers.
+ * @param[in] covar The desired covariance matrix.
+ * @param[in] token An identifier of the elements of @p covar, such as 
+ *	a hash of the parameters from which it was computed, or 0 to 
+ *	identify the matrix by comparing its elements.
+ * @param[out] corrVecs A list of vectors of correlated Gaussian random 
+ *	numbers with mean zero and covariance matrix covar, in the same 
+ *	order as @p indVecs.
+ *
+ * @pre @p indVecs[i].size() = @p covar->size1 = @p covar->size2 for all i
+ * @pre @p covar is symmetric and positive semidefinite
+ * @pre @p corrVecs may refer to the same list as @p indVecs
+ *
+ * @post @p corrVecs.size() = @p indVecs.size()
+ * @post @p corrVecs[i] is the value multiNormal() would give for 
+ *	@p indVecs[i]. With the reference BLAS, the result is identical 
+ *	in the last bit if the matrix was factored with 
+ *	@ref FACTOR_EIGEN "FACTOR_EIGEN" on the CPU.
+ *
+ * @note If the program is built with GPU = cuda (see makefile.inc) and 
+ *	a device is present, large products are computed on the device 
+ *	with deviceMultiply(). Otherwise, the product uses the CPU.
+ *
+ * @perform O(N<sup>3</sup> + KN<sup>2</sup>) time, where N = 
+ *	@p covar->size1 and K = @p indVecs.size(), if @p covar is not 
+ *	one of the cached matrices. O(KN<sup>2</sup>) time otherwise.
+ * @perfmore O(N<sup>2</sup> + KN) memory
+ * 
+ * @exception std::bad_alloc Thrown if there was not enough memory to 
+ *	compute the transformation
+ * @exception std::invalid_argument Thrown if the lengths do not match 
+ *	or if the matrix is not symmetric or positive semidefinite.
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+void multiNormalBatch(const vector<vector<double> >& indVecs, 
+		const shared_ptr<const gsl_matrix>& covar, 
+		vector<vector<double> >& corrVecs, uint64_t token) {
+	using std::swap;
+	
+	const size_t N = covar->size1;
+	const size_t K = indVecs.size();
+	for(size_t k = 0; k < K; k++) {
+		checkDimensions(indVecs[k].size(), covar);
+	}
+	// copy-and-swap, since corrVecs may alias indVecs
+	vector<vector<double> > output(K, vector<double>(N));
+	if (K == 0 || N == 0) {
+		// GSL does not allow views of empty arrays
+		swap(corrVecs, output);
+		return;
+	}
+
+	const CovarFactorization factor = findFactorization(covar, token);
+	
+	// Large products are faster on a device, if one is available
+	if (deviceMultiply(factor.half, factor.triangular, indVecs, corrVecs)) {
+		return;
+	}
 	
-	// No reallocations, therefore no exceptions past this point
-	corrVec.clear();
+	// One column per sequence, so that row i of the product only 
+	//	involves row i of the factor
+	// The matrices are views of local arrays rather than GSL-allocated
+	vector<double> temp(N*K), result(N*K);
+	for(size_t k = 0; k < K; k++) {
+		for(size_t i = 0; i < N; i++) {
+			temp[i*K + k] = indVecs[k][i];
+		}
+	}
+	gsl_matrix_view tempView   = gsl_matrix_view_array(&temp[0]  , N, K);
+	gsl_matrix_view resultView = gsl_matrix_view_array(&result[0], N, K);
+
+	if (factor.triangular) {
+		// Multiply in place
+		gslCheck( gsl_blas_dtrmm(CblasLeft, CblasLower, CblasNoTrans, 
+			CblasNonUnit, 1.0, factor.half.get(), &tempView.matrix), 
+			"While generating multivariate normal vectors: ");
+		swap(temp, result);
+	} else {
+		gslCheck( gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, 
+			factor.half.get(), &tempView.matrix, 0.0, &resultView.matrix), 
+			"While generating multivariate normal vectors: ");
+	}
+
+	for(size_t k = 0; k < K; k++) {
+		for(size_t i = 0; i < N; i++) {
+			output[k][i] = result[i*K + k];
+		}
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(corrVecs, output);
+}
+
+/** SparseFactorization stores the envelope Cholesky factor of a sparse 
+ *	covariance matrix
+ */
+struct SparseFactorization {
+	/** Creates an empty factorization
+	 *
+	 * @exceptsafe Does not throw exceptions.
+	 */
+	SparseFactorization() : covar(), half() {
+	}
+
+	/** The factored matrix */
+	shared_ptr<const SparseCovar> covar;
+	/** A lower triangular matrix L, with the same envelope as 
+	 *	@p covar, such that @f$ covar \approx L L^\intercal @f$ */
+	shared_ptr<const SparseCovar> half;
+};
+
+/** Verifies that a vector can be transformed using a sparse covariance 
+ *	matrix
+ *
+ * @param[in] N The length of the vector to transform.
+ * @param[in] covar The desired covariance matrix.
+ *
+ * @exception std::invalid_argument Thrown if the envelope of @p covar 
+ *	is inconsistent, or if its dimensions do not match @p N.
+ *
+ * @exceptsafe Does not change any arguments.
+ */
+void checkSparse(size_t N, const SparseCovar& covar) {
+	if (covar.first.size() != N || covar.offset.size() != N+1 
+			|| covar.offset[0] != 0 || covar.offset[N] != covar.values.size()) {
+		throw std::invalid_argument("Length of input vector to multiNormal() does not match dimensions of sparse covariance matrix.");
+	}
 	for(size_t i = 0; i < N; i++) {
-		// gsl_vector_get() doesn't invoke the error handler since 0 <= i < N
-		corrVec.push_back(gsl_vector_get(result.get(), i));
+		if (covar.first[i] > i 
+				|| covar.offset[i+1] - covar.offset[i] != i - covar.first[i] + 1) {
+			throw std::invalid_argument("Row " + lexical_cast<std::string>(i) 
+				+ " of sparse covariance matrix does not end at the diagonal.");
+		}
+	}
+}
+
+/** Performs a Cholesky decomposition of a sparse matrix, in place
+ *
+ * Element (i, j) of the factor depends only on the elements of rows i 
+ * and j at or after column max(first[i], first[j]), so the factor has 
+ * the same envelope as the matrix and no storage is needed outside it.
+ *
+ * @param[in,out] m On input, a symmetric matrix. On output, a lower 
+ *	triangular matrix L such that @f$ m + jitter I = L L^\intercal @f$, 
+ *	if the return value is true. Otherwise, undefined.
+ * @param[in] jitter A value to add to the diagonal before factoring.
+ *
+ * @return true if @p m + @p jitter I is positive definite, false otherwise.
+ *
+ * @pre checkSparse() accepts @p m
+ *
+ * @perform O(&sum; w<sub>i</sub><sup>2</sup>) time, where w<sub>i</sub> 
+ *	is the number of stored elements in row i
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool envelopeCholesky(SparseCovar& m, double jitter) {
+	vector<double>& l = m.values;
+	const size_t N = m.first.size();
+	for(size_t i = 0; i < N; i++) {
+		// Element (i, k) is at l[rowI + k], for first[i] <= k <= i
+		// Unsigned arithmetic wraps, so rowI may "underflow"
+		const size_t rowI = m.offset[i] - m.first[i];
+		for(size_t j = m.first[i]; j < i; j++) {
+			const size_t rowJ = m.offset[j] - m.first[j];
+			double sum = l[rowI + j];
+			for(size_t k = std::max(m.first[i], m.first[j]); k < j; k++) {
+				sum -= l[rowI + k] * l[rowJ + k];
+			}
+			l[rowI + j] = sum / l[rowJ + j];
+		}
+		double diag = l[rowI + i] + jitter;
+		for(size_t k = m.first[i]; k < i; k++) {
+			diag -= l[rowI + k] * l[rowI + k];
+		}
+		if (!(diag > 0.0)) {
+			return false;
+		}
+		l[rowI + i] = sqrt(diag);
 	}
+	return true;
+}
+
+/** Returns the memory held by a range of sparse factorizations
+ *
+ * @param[in] begin, end The factorizations to measure.
+ *
+ * @return The number of bytes in their envelopes.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+template <class ConstIterator>
+size_t sparseBytes(ConstIterator begin, ConstIterator end) {
+	size_t bytes = 0;
+	for(ConstIterator it = begin; it != end; it++) {
+		bytes += it->covar->values.size() * sizeof(double) 
+			+ (it->covar->first.size() + it->covar->offset.size()) * sizeof(size_t);
+		bytes += it->half->values.size() * sizeof(double) 
+			+ (it->half->first.size() + it->half->offset.size()) * sizeof(size_t);
+	}
+	return bytes;
+}
+
+/** Returns the Cholesky factor of a sparse covariance matrix, computing 
+ *	it if it is not already cached
+ *
+ * The factors share the cache size of findFactorization(), but are kept 
+ * in a cache of their own, since they are never compared with dense 
+ * matrices.
+ *
+ * @param[in] covar The matrix to factor.
+ *
+ * @return The factorization of @p covar.
+ *
+ * @pre checkSparse() accepts @p covar
+ *
+ * @perform O(&sum; w<sub>i</sub><sup>2</sup>) time, where w<sub>i</sub> 
+ *	is the number of stored elements in row i, if @p covar is not 
+ *	cached. O(KW) time otherwise, where K is the number of cached 
+ *	factorizations and W = covar.values.size().
+ * @perfmore O(W) memory
+ *
+ * @exception std::bad_alloc Thrown if there was not enough memory to 
+ *	compute the factorization
+ * @exception std::invalid_argument Thrown if @p covar is not positive 
+ *	definite, even with a jitter of 10<sup>-8</sup> of its largest 
+ *	diagonal element.
+ *
+ * @exceptsafe The cache is unchanged in the event of an exception.
+ *
+ * @note May be called from several threads at once.
+ */
+SparseFactorization findSparseFactor(const SparseCovar& covar) {
+	// invariant: every element of factorCache has non-null covar and half
+	// invariant: elements are in order from most to least recently used
+	// invariant: factorCache.size() <= factorCacheSize()
+	typedef std::list<SparseFactorization> FactorList;
+	static boost::mutex cacheLock;
+	static FactorList factorCache;
+	static CacheCounter counter("Sparse covariance factorizations");
+
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		FactorList::iterator match = factorCache.begin();
+		for(; match != factorCache.end(); match++) {
+			if (match->covar->first == covar.first 
+					&& match->covar->values == covar.values) {
+				break;
+			}
+		}
+		if (match != factorCache.end()) {
+			counter.hit();
+			if (match != factorCache.begin()) {
+				// Splicing a list never throws
+				factorCache.splice(factorCache.begin(), factorCache, match);
+			}
+			return factorCache.front();
+		}
+	}
+	
+	const CacheMiss miss(counter);
+	
+	// Don't hold the lock while factoring, so that threads working 
+	//	on other matrices are not blocked
+	double maxDiag = 0.0;
+	for(size_t i = 0; i < covar.first.size(); i++) {
+		maxDiag = std::max(maxDiag, covar.values[covar.offset[i+1] - 1]);
+	}
+	
+	shared_ptr<SparseCovar> half(new SparseCovar(covar));
+	// Try an exact factorization first, then increasing amounts of jitter
+	double jitter = 0.0;
+	int attempt = 0;
+	for(; attempt < 4; attempt++) {
+		if (envelopeCholesky(*half, jitter)) {
+			break;
+		}
+		half->values = covar.values;
+		jitter = (jitter == 0.0 ? 1e-12 * maxDiag : 100.0 * jitter);
+	}
+	if (attempt >= 4) {
+		throw std::invalid_argument("Sparse covariance matrix in multiNormal() is not positive definite.");
+	}
+	
+	SparseFactorization temp;
+	temp.covar.reset(new SparseCovar(covar));
+	temp.half = half;
+	
+	{
+		boost::mutex::scoped_lock guard(cacheLock);
+		
+		// Last operation in this block that is allowed to throw
+		factorCache.push_front(temp);
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		if (factorCache.size() > factorCacheSize()) {
+			factorCache.pop_back();
+		}
+		counter.setBytes(sparseBytes(factorCache.begin(), factorCache.end()));
+	}
+	return temp;
+}
+
+/** Transforms an uncorrelated sequence of Gaussian random numbers into a 
+ *	correlated sequence with a sparse covariance matrix
+ *
+ * The matrix is factored with a Cholesky decomposition that stays 
+ * within the envelope of @p covar, so the time and memory needed 
+ * depend only on the number of correlated pairs of elements rather 
+ * than on the square of the length. The factorizations of the last 
+ * few matrices are cached, as for the dense version of multiNormal().
+ *
+ * @param[in] indVec A vector of independent unit Gaussian random numbers.
+ * @param[in] covar The desired covariance matrix.
+ * @param[out] corrVec A vector of correlated Gaussian random numbers with 
+ *	mean zero and covariance matrix covar.
+ *
+ * @pre @p indVec.size() = @p covar.first.size()
+ * @pre @p covar is positive definite
+ * @pre @p corrVec may refer to the same vector as @p indVec
+ *
+ * @post @p corrVec.size() = @p indVec.size()
+ *
+ * @perform O(&sum; w<sub>i</sub><sup>2</sup>) time, where w<sub>i</sub> 
+ *	is the number of stored elements in row i of @p covar, if @p covar 
+ *	is not one of the cached matrices. O(&sum; w<sub>i</sub>) time 
+ *	otherwise.
+ * @perfmore O(&sum; w<sub>i</sub>) memory
+ * 
+ * @exception std::bad_alloc Thrown if there was not enough memory to 
+ *	compute the transformation
+ * @exception std::invalid_argument Thrown if the lengths do not match, 
+ *	if the envelope of @p covar is inconsistent, or if the matrix is 
+ *	not positive definite.
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+void multiNormal(const vector<double>& indVec, const SparseCovar& covar, 
+		vector<double>& corrVec) {
+	using std::swap;
+
+	const size_t N = indVec.size();
+	checkSparse(N, covar);
+
+	const SparseFactorization factor = findSparseFactor(covar);
+	const SparseCovar& half = *factor.half;
+	
+	// Separate from corrVec, since corrVec may alias indVec
+	vector<double> result(N);
+	for(size_t i = 0; i < N; i++) {
+		// Unsigned arithmetic wraps, so row may "underflow"
+		const size_t row = half.offset[i] - half.first[i];
+		double sum = 0.0;
+		for(size_t k = half.first[i]; k <= i; k++) {
+			sum += half.values[row + k] * indVec[k];
+		}
+		result[i] = sum;
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	swap(corrVec, result);
 }
 
 /** Given a matrix A, returns a matrix B with the property 
@@ -221,23 +1166,29 @@ void multiNormal(const vector<double>& indVec, const shared_ptr<gsl_matrix>& cov
  *
  * @exceptsafe The parameters are unchanged in the event of an exception.
  *
- * @todo Find a faster implementation
+ * @note If the program is built with LINALG = lapack (see makefile.inc), 
+ *	forwards to lapackHalfMatrix().
  */
-shared_ptr<gsl_matrix> getHalfMatrix(const shared_ptr<gsl_matrix>& a) {
+shared_ptr<gsl_matrix> getHalfMatrix(const shared_ptr<const gsl_matrix>& a) {
+#ifdef LCMC_USE_LAPACK
+	return lapackHalfMatrix(a);
+#else
 	// Eigendecomposition: covar = eigenVecs * diag(eigenVals) * transpose(eigenVecs)
 	//	Note: need normalization convention so that eigenVecs is orthogonal
 	//	Making the individual eigenvectors normalized meets this
 	
 	const size_t N = a->size1;
 	
-	shared_ptr<gsl_eigen_symmv_workspace> eigenWork(
-			checkAlloc(gsl_eigen_symmv_alloc(N)), &gsl_eigen_symmv_free);
-	shared_ptr<gsl_vector> eigenVals(checkAlloc(gsl_vector_alloc(N)), &gsl_vector_free);
-	shared_ptr<gsl_matrix> eigenVecs(checkAlloc(gsl_matrix_alloc(N, N)), &gsl_matrix_free);
+	// Only the eigenvectors are returned, so the other temporaries 
+	//	are kept for the next matrix of the same size
+	const GslLease<EigenSymmvTraits> eigenWork(N);
+	const GslLease<VectorTraits> eigenVals(N);
+	shared_ptr<gsl_matrix> eigenVecs(checkAlloc(largeMatrixAlloc(N, N)), &gsl_matrix_free);
 	
 	// Since gsl_eigen_symmv modifies a matrix in place, make a copy first
-	shared_ptr<gsl_matrix> aCopy;
-	matrixCopy(aCopy, a);
+	const GslLease<SquareMatrixTraits> aCopy(N);
+	gslCheck( gsl_matrix_memcpy(aCopy.get(), a.get()), 
+			"While generating multivariate normal vector: ");
 			
 	gslCheck( gsl_eigen_symmv(aCopy.get(), eigenVals.get(), eigenVecs.get(), 
 			eigenWork.get()), "While generating multivariate normal vector: ");
@@ -262,6 +1213,268 @@ shared_ptr<gsl_matrix> getHalfMatrix(const shared_ptr<gsl_matrix>& a) {
 	}
 	
 	return eigenVecs;
+#endif
+}
+
+#ifdef LCMC_USE_LAPACK
+/** Given a matrix A, returns a matrix B with the property 
+ *	@f$ A = B B^\intercal @f$, using LAPACK
+ *
+ * Plays the same role as the GSL implementation of getHalfMatrix(), 
+ * but uses the blocked dsyevr() routine. The eigenvalues are found in 
+ * ascending order, so the columns of B are ordered differently than 
+ * with GSL. The resulting light curves are different but statistically 
+ * equivalent.
+ *
+ * @param[in] a The matrix to decompose
+ *
+ * @return a pointer containing the newly allocated matrix B
+ *
+ * @pre @p a is a square, symmetric, positive semi-definite matrix
+ * @post return value is a newly allocated matrix with the property that 
+ *	multiplying it by its own transpose restores @p a
+ *
+ * @exception std::bad_alloc Thrown if there was not enough memory to 
+ *	compute the transformation
+ * @exception std::invalid_argument Thrown if the matrix is not 
+ *	positive semi-definite.
+ * @exception std::runtime_error Thrown if LAPACK could not compute the 
+ *	eigendecomposition.
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+shared_ptr<gsl_matrix> lapackHalfMatrix(const shared_ptr<const gsl_matrix>& a) {
+	const size_t N = a->size1;
+	const int n = static_cast<int>(N);
+	
+	// dsyevr() overwrites its input, and expects column-major storage
+	// Since a is symmetric, its rows are also its columns
+	vector<double> aCopy(N*N);
+	for(size_t i = 0; i < N; i++) {
+		const double* const rowI = a->data + i * a->tda;
+		std::copy(rowI, rowI + N, aCopy.begin() + i*N);
+	}
+	vector<double> eigenVals(N);
+	vector<double> eigenVecs(N*N);
+	vector<int> support(2*N);
+	
+	// Bounds are ignored when finding all eigenvalues
+	const double noBound = 0.0;
+	const int noIndex = 0;
+	const double tolerance = 0.0;
+	int nFound = 0;
+	int info = 0;
+	
+	// Workspace query
+	const int query = -1;
+	double workSize = 0.0;
+	int iworkSize = 0;
+	dsyevr_("V", "A", "L", &n, &aCopy[0], &n, &noBound, &noBound, 
+		&noIndex, &noIndex, &tolerance, &nFound, &eigenVals[0], 
+		&eigenVecs[0], &n, &support[0], &workSize, &query, 
+		&iworkSize, &query, &info);
+	lapackCheck(info, "While generating multivariate normal vector: ");
+	
+	const int lwork  = static_cast<int>(workSize);
+	const int liwork = iworkSize;
+	vector<double> work(lwork);
+	vector<int>   iwork(liwork);
+	dsyevr_("V", "A", "L", &n, &aCopy[0], &n, &noBound, &noBound, 
+		&noIndex, &noIndex, &tolerance, &nFound, &eigenVals[0], 
+		&eigenVecs[0], &n, &support[0], &work[0], &lwork, 
+		&iwork[0], &liwork, &info);
+	lapackCheck(info, "While generating multivariate normal vector: ");
+	
+	// Multiply eigenVecs by sqrt(diag(eigenVals)) to get a matrix 
+	//	that when multiplied by its transpose produces a
+	shared_ptr<gsl_matrix> half(checkAlloc(largeMatrixAlloc(N, N)), &gsl_matrix_free);
+	for(size_t k = 0; k < N; k++) {
+		double curVal = eigenVals[k];
+		
+		if (curVal < 0.0) {
+			// Correct for rounding problems
+			if (curVal > -1e-12) {
+				curVal = 0.0;
+			} else {
+				throw std::invalid_argument("Matrix is not positive semidefinite.");
+			}
+		}
+		const double scale = sqrt(curVal);
+		
+		// In column-major order, eigenvector k is contiguous
+		const double* const vecK = &eigenVecs[k*N];
+		for(size_t i = 0; i < N; i++) {
+			gsl_matrix_set(half.get(), i, k, scale * vecK[i]);
+		}
+	}
+	
+	return half;
+}
+#endif
+
+/** Factors a matrix in place as @f$ L L^\intercal @f$
+ *
+ * @param[in,out] m The matrix to factor. On success, contains L.
+ * @param[in] jitter A value to add to each diagonal element of @p m 
+ *	before factoring it.
+ *
+ * @return True if @p m + @p jitter I was positive definite, false 
+ *	otherwise.
+ *
+ * @pre @p m is square and symmetric
+ * @post If the return value is true, @p m is lower triangular, and 
+ *	@f$ m m^\intercal @f$ equals the original @p m + @p jitter I. 
+ *	Otherwise, the contents of @p m are unspecified.
+ *
+ * @perform O(N<sup>3</sup>) time, where N is the dimension of @p m
+ *
+ * @note If the program is built with LINALG = lapack (see makefile.inc), 
+ *	uses the blocked dpotrf() routine.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool choleskyInPlace(gsl_matrix* const m, double jitter) {
+	const size_t N = m->size1;
+	
+#ifdef LCMC_USE_LAPACK
+	for(size_t i = 0; i < N; i++) {
+		m->data[i * m->tda + i] += jitter;
+	}
+	
+	// In column-major order, the lower triangle of m is its upper 
+	//	triangle, and the upper Cholesky factor U is the transpose of L
+	const int n   = static_cast<int>(N);
+	const int lda = static_cast<int>(m->tda);
+	int info = 0;
+	dpotrf_("U", &n, m->data, &lda, &info);
+	if (info != 0) {
+		return false;
+	}
+#else
+	// Implemented directly rather than with gsl_linalg_cholesky_decomp(), 
+	//	so that a failed factorization doesn't invoke the GSL 
+	//	error handler
+	
+	// Each row of L only depends on the preceding rows and on 
+	//	the lower triangle of m
+	for(size_t j = 0; j < N; j++) {
+		double* const rowJ = m->data + j * m->tda;
+		
+		double pivot = rowJ[j] + jitter;
+		for(size_t k = 0; k < j; k++) {
+			pivot -= rowJ[k] * rowJ[k];
+		}
+		if (!(pivot > 0.0)) {
+			return false;
+		}
+		const double diag = sqrt(pivot);
+		rowJ[j] = diag;
+		
+		for(size_t i = j+1; i < N; i++) {
+			double* const rowI = m->data + i * m->tda;
+			
+			double sum = rowI[j];
+			for(size_t k = 0; k < j; k++) {
+				sum -= rowI[k] * rowJ[k];
+			}
+			rowI[j] = sum / diag;
+		}
+	}
+#endif
+	
+	// The upper triangle still contains the original matrix
+	for(size_t i = 0; i < N; i++) {
+		double* const rowI = m->data + i * m->tda;
+		for(size_t j = i+1; j < N; j++) {
+			rowI[j] = 0.0;
+		}
+	}
+	
+	return true;
+}
+
+/** Given a matrix A, returns a lower triangular matrix L with the property 
+ *	@f$ A \approx L L^\intercal @f$
+ *
+ * If A is not numerically positive definite, as often happens for the 
+ * covariance of closely spaced observations, a small multiple of its 
+ * largest diagonal element (at most 10<sup>-8</sup>) is added to the 
+ * diagonal. This is equivalent to adding a negligible amount of white 
+ * noise to the light curve.
+ *
+ * @param[in] a The matrix to decompose
+ *
+ * @return a pointer containing the newly allocated matrix L, or a null 
+ *	pointer if @p a is too far from positive definite to factor.
+ *
+ * @pre @p a is a square, symmetric matrix
+ * @post if the return value is not null, it is a newly allocated lower 
+ *	triangular matrix that, multiplied by its own transpose, equals 
+ *	@p a to within a relative error of 10<sup>-8</sup>
+ *
+ * @perform O(N<sup>3</sup>) time, where N = @p a->size1, but with a 
+ *	much smaller constant than getHalfMatrix()
+ *
+ * @exception std::bad_alloc Thrown if there was not enough memory to 
+ *	compute the factorization
+ *
+ * @exceptsafe The parameters are unchanged in the event of an exception.
+ */
+shared_ptr<gsl_matrix> getCholeskyMatrix(const shared_ptr<const gsl_matrix>& a) {
+	const size_t N = a->size1;
+	
+	double maxDiag = 0.0;
+	for(size_t i = 0; i < N; i++) {
+		maxDiag = std::max(maxDiag, gsl_matrix_get(a.get(), i, i));
+	}
+	
+	shared_ptr<gsl_matrix> l;
+	// Try an exact factorization first, then increasing amounts of jitter
+	double jitter = 0.0;
+	for(int attempt = 0; attempt < 4; attempt++) {
+		matrixCopy(l, a);
+		if (choleskyInPlace(l.get(), jitter)) {
+			return l;
+		}
+		jitter = (jitter == 0.0 ? 1e-12 * maxDiag : 100.0 * jitter);
+	}
+	
+	return shared_ptr<gsl_matrix>();
+}
+
+/** Tests whether two matrices have the same dimensions and elements.
+ *
+ * @param[in] a The first matrix to compare
+ * @param[in] b The second matrix to compare
+ *
+ * @return True iff @p a and @p b have the same dimensions, and each 
+ *	corresponding element is equal.
+ *
+ * @note if either @p a or @p b is a null pointer, returns false
+ *
+ * @exceptsafe Does not throw exceptions
+ */
+bool sameMatrix(const gsl_matrix* const a, const gsl_matrix* const b) {
+	if(a == NULL || b == NULL) {
+		return false;
+	// Shared matrices, such as those returned by getCovar(), need 
+	//	not be compared element by element
+	} else if (a == b) {
+		return true;
+	// gsl_matrix_equal() reports a GSL error for mismatched matrices
+	} else if (a->size1 != b->size1 || a->size2 != b->size2) {
+		return false;
+	}
+	
+	// Note: isMatrixClose() is no longer used because it's 
+	// significantly slower than gsl_matrix_equal(). The extra 
+	// overhead from approximate comparison exceeded the negligible 
+	// risk of a spurious cache miss.
+	#ifdef _GSL_HAS_MATRIX_EQUAL
+	return gsl_matrix_equal(a, b) == 1;
+	#else
+	return matrixEqual(a, b);
+	#endif
 }
 
 /** Replaces one matrix with the value of another.
@@ -273,18 +1486,18 @@ shared_ptr<gsl_matrix> getHalfMatrix(const shared_ptr<gsl_matrix>& a) {
  * @param[in] newData The data to copy to target.
  *
  * @post @p target points to a newly allocated matrix with the same dimensions 
- *	and data as @p newData
+ *	and data as @p newData, whose elements are allocated by largeAlloc()
  * @post any data previously occupying @p target is cleaned up
  *
  * @exception std::bad_alloc Thrown if the matrix could not be copied.
  *
  * @exceptsafe The parameters are unchanged in the event of an exception.
  */
-void matrixCopy(shared_ptr<gsl_matrix>& target, const shared_ptr<gsl_matrix>& newData) {
+void matrixCopy(shared_ptr<gsl_matrix>& target, const shared_ptr<const gsl_matrix>& newData) {
 	using std::swap;
 	
 	shared_ptr <gsl_matrix> temp(
-		checkAlloc(gsl_matrix_alloc(newData->size1, newData->size2)), 
+		checkAlloc(largeMatrixAlloc(newData->size1, newData->size2)), 
 		          &gsl_matrix_free);
 
 	gslCheck( gsl_matrix_memcpy(temp.get(), newData.get()), "While copying matrix: "); 
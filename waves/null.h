@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/lightcurves_periodic.h
  * @author Krzysztof Findeisen
  * @date Created May 2, 2012
- * @date Last modified March 19, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -44,7 +44,7 @@ class FlatWave : public Deterministic {
 public: 
 	/** Initializes the light curve to represent a flat waveform.
 	 */
-	explicit FlatWave(const std::vector<double> &times);
+	explicit FlatWave(const Cadence& times);
 
 private: 
 	/** Returns a flat signal
@@ -0,0 +1,573 @@
+/** State-space approximations to Gaussian process kernels
+ * @file lightcurveMC/waves/statespace.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <complex>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <boost/lexical_cast.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_permutation.h>
+#include <gsl/gsl_poly.h>
+#include <gsl/gsl_vector.h>
+#include "lightcurves_gp.h"
+#include "statespace.h"
+#include "../cachestats.h"
+#include "../gsl_compat.h"
+#include "../../common/alloc.tmp.h"
+
+namespace lcmc { namespace models {
+
+using boost::lexical_cast;
+using boost::shared_ptr;
+using kpfutils::checkAlloc;
+
+/** The highest order of state-space model supported by SquaredExpSde
+ */
+const long MAX_SDE_ORDER = 8;
+
+/** The largest lag, in coherence times, checked by
+ *	SquaredExpSde::maxError()
+ */
+const double MAX_ERROR_LAG = 10.0;
+
+/** Returns the order of state-space model used for squared exponential
+ *	kernels
+ *
+ * @return A modifiable order, 0 if exact kernels are used.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long& sdeOrder() {
+	static long order = 0;
+	return order;
+}
+
+/** Approximates squared exponential kernels by a state-space model of
+ *	a given order
+ *
+ * The approximation lets SimpleGp and TwoScaleGp light curves be
+ * generated in O(N) time, where N is the number of observations,
+ * at the cost of a small error in the kernel (see stateSpaceError()).
+ *
+ * @param[in] order The order of the model, or 0 to use exact kernels.
+ *
+ * @post SimpleGp and TwoScaleGp light curves are generated with
+ *	SquaredExpSde::get(@p order), or with their exact kernels if
+ *	@p order = 0.
+ *
+ * @exception std::invalid_argument Thrown if @p order < 0 or
+ *	@p order > 8
+ *
+ * @exceptsafe The order is unchanged in the event of an exception.
+ */
+void setStateSpaceOrder(long order) {
+	if (order < 0 || order > MAX_SDE_ORDER) {
+		throw std::invalid_argument("State-space approximations must have order between 0 and "
+			+ lexical_cast<std::string>(MAX_SDE_ORDER) + " (gave "
+			+ lexical_cast<std::string>(order) + ").");
+	}
+
+	sdeOrder() = order;
+}
+
+/** Returns the order chosen with setStateSpaceOrder()
+ *
+ * @return The order of the state-space model, or 0 if exact kernels
+ *	are used.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+long getStateSpaceOrder() {
+	return sdeOrder();
+}
+
+/** Returns the largest kernel error of the state-space approximation
+ *	chosen with setStateSpaceOrder()
+ *
+ * @return The largest difference between the approximate and exact
+ *	squared exponential kernels, as a fraction of the variance, or 0
+ *	if exact kernels are used.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the approximation.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+double stateSpaceError() {
+	if (sdeOrder() == 0) {
+		return 0.0;
+	}
+	return SquaredExpSde::get(sdeOrder()).maxError();
+}
+
+/** Allocates a zero matrix
+ *
+ * @param[in] n1, n2 The dimensions of the matrix.
+ *
+ * @return A pointer to the new matrix, owning a deallocator
+ *	gsl_matrix_free().
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	allocate the matrix.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+shared_ptr<gsl_matrix> zeroMatrix(size_t n1, size_t n2) {
+	return shared_ptr<gsl_matrix>(checkAlloc(gsl_matrix_calloc(n1, n2)),
+		&gsl_matrix_free);
+}
+
+/** Computes the exponential of a scaled matrix
+ *
+ * Uses a Taylor series with scaling and squaring, which is accurate
+ * to rounding error for the small, well-conditioned matrices used by
+ * SquaredExpSde.
+ *
+ * @param[in] a The matrix to exponentiate.
+ * @param[in] t The scale factor.
+ * @param[out] result The matrix @f$e^{ta}@f$.
+ *
+ * @pre @p a and @p result are square and have the same dimensions
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the exponential.
+ * @exception std::runtime_error Thrown if the matrix products fail.
+ *
+ * @exceptsafe @p result is in a valid state in the event of an exception.
+ */
+void matrixExp(const gsl_matrix* a, double t, gsl_matrix* result) {
+	using std::swap;
+
+	const size_t n = a->size1;
+
+	// Scale ta until its norm is at most 1/2, so that 16 terms of the
+	//	series are accurate to rounding error
+	double norm = 0.0;
+	for(size_t i = 0; i < n; i++) {
+		double rowSum = 0.0;
+		for(size_t j = 0; j < n; j++) {
+			rowSum += fabs(t * gsl_matrix_get(a, i, j));
+		}
+		norm = std::max(norm, rowSum);
+	}
+	double scale = t;
+	long squarings = 0;
+	while (norm > 0.5) {
+		norm  *= 0.5;
+		scale *= 0.5;
+		squarings++;
+	}
+
+	shared_ptr<gsl_matrix> term = zeroMatrix(n, n);
+	shared_ptr<gsl_matrix> next = zeroMatrix(n, n);
+	gsl_matrix_set_identity(result);
+	gsl_matrix_set_identity(term.get());
+	for(long k = 1; k <= 16; k++) {
+		gslCheck( gsl_blas_dgemm(CblasNoTrans, CblasNoTrans,
+			scale / static_cast<double>(k), term.get(), a, 0.0, next.get()),
+			"While computing matrix exponential: ");
+		swap(term, next);
+		gslCheck( gsl_matrix_add(result, term.get()),
+			"While computing matrix exponential: ");
+	}
+
+	for(long s = 0; s < squarings; s++) {
+		gslCheck( gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0,
+			result, result, 0.0, next.get()),
+			"While computing matrix exponential: ");
+		gslCheck( gsl_matrix_memcpy(result, next.get()),
+			"While computing matrix exponential: ");
+	}
+}
+
+/** Factors a positive semidefinite matrix in place as @f$ L L^\intercal @f$
+ *
+ * Pivots smaller than 10<sup>-12</sup> of the largest diagonal element
+ * are treated as zero, so the factorization succeeds for singular
+ * matrices, such as the transition covariance over a zero time step.
+ *
+ * @param[in,out] m The matrix to factor. Replaced by L, with the upper
+ *	triangle set to zero.
+ *
+ * @pre @p m is square, symmetric and positive semidefinite
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void semiCholesky(gsl_matrix* m) {
+	const size_t n = m->size1;
+
+	double maxDiag = 0.0;
+	for(size_t i = 0; i < n; i++) {
+		maxDiag = std::max(maxDiag, gsl_matrix_get(m, i, i));
+	}
+	const double tolerance = 1e-12 * maxDiag;
+
+	for(size_t j = 0; j < n; j++) {
+		double pivot = gsl_matrix_get(m, j, j);
+		for(size_t k = 0; k < j; k++) {
+			pivot -= gsl_matrix_get(m, j, k) * gsl_matrix_get(m, j, k);
+		}
+
+		if (pivot <= tolerance) {
+			for(size_t i = j; i < n; i++) {
+				gsl_matrix_set(m, i, j, 0.0);
+			}
+		} else {
+			const double diag = sqrt(pivot);
+			gsl_matrix_set(m, j, j, diag);
+			for(size_t i = j+1; i < n; i++) {
+				double sum = gsl_matrix_get(m, i, j);
+				for(size_t k = 0; k < j; k++) {
+					sum -= gsl_matrix_get(m, i, k) * gsl_matrix_get(m, j, k);
+				}
+				gsl_matrix_set(m, i, j, sum / diag);
+			}
+		}
+		for(size_t i = 0; i < j; i++) {
+			gsl_matrix_set(m, i, j, 0.0);
+		}
+	}
+}
+
+/** Computes the state-space model of a given order
+ *
+ * The Taylor series of @f$e^{x}@f$, @f$x = \omega^2/2@f$, truncated at
+ * order n, is a polynomial in @f$u = -\omega^2@f$. Each of its n roots
+ * gives a pole @f$s = -\sqrt{u}@f$ in the left half-plane, and the
+ * monic polynomial with these roots defines a stable SDE in companion
+ * form. The stationary covariance of the state is the solution of a
+ * Lyapunov equation, normalized so that the process has unit variance.
+ *
+ * @param[in] order The order of the SDE.
+ *
+ * @post The object represents the order-@p order approximation to a
+ *	squared exponential kernel with unit coherence time and variance.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	construct the object.
+ * @exception std::invalid_argument Thrown if @p order < 1 or
+ *	@p order > 8.
+ * @exception std::runtime_error Thrown if the model could not be computed.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+SquaredExpSde::SquaredExpSde(long order) : order(0), drift(), statCovar(),
+		statHalf() {
+	typedef std::complex<double> Complex;
+
+	if (order < 1 || order > MAX_SDE_ORDER) {
+		throw std::invalid_argument("State-space approximations must have order between 1 and "
+			+ lexical_cast<std::string>(MAX_SDE_ORDER) + " (gave "
+			+ lexical_cast<std::string>(order) + ").");
+	}
+	const size_t n = static_cast<size_t>(order);
+
+	// Truncated Taylor series of exp(-u/2), as a polynomial in u
+	std::vector<double> series(n+1);
+	series[0] = 1.0;
+	for(size_t k = 1; k <= n; k++) {
+		series[k] = -0.5 * series[k-1] / static_cast<double>(k);
+	}
+	std::vector<double> roots(2*n);
+	{
+		shared_ptr<gsl_poly_complex_workspace> work(
+			checkAlloc(gsl_poly_complex_workspace_alloc(n+1)),
+			&gsl_poly_complex_workspace_free);
+		gslCheck( gsl_poly_complex_solve(&series[0], n+1, work.get(), &roots[0]),
+			"While approximating squared exponential kernel: ");
+	}
+
+	// Expand the product of (s - pole) over the stable poles
+	std::vector<Complex> poly(1, Complex(1.0, 0.0));
+	for(size_t j = 0; j < n; j++) {
+		const Complex pole = -sqrt(Complex(roots[2*j], roots[2*j+1]));
+		poly.push_back(Complex(0.0, 0.0));
+		for(size_t k = poly.size() - 1; k > 0; k--) {
+			poly[k] = poly[k-1] - pole * poly[k];
+		}
+		poly[0] = -pole * poly[0];
+	}
+
+	shared_ptr<gsl_matrix> f = zeroMatrix(n, n);
+	for(size_t i = 0; i + 1 < n; i++) {
+		gsl_matrix_set(f.get(), i, i+1, 1.0);
+	}
+	for(size_t j = 0; j < n; j++) {
+		// The imaginary parts cancel, since the poles come in
+		//	conjugate pairs
+		gsl_matrix_set(f.get(), n-1, j, -poly[j].real());
+	}
+
+	// Stationary covariance: F P + P F^T + e e^T = 0, where e is the
+	//	last basis vector. Solve as an n^2-dimensional linear system
+	const size_t n2 = n*n;
+	shared_ptr<gsl_matrix> lyap = zeroMatrix(n2, n2);
+	shared_ptr<gsl_vector> rhs(checkAlloc(gsl_vector_calloc(n2)), &gsl_vector_free);
+	shared_ptr<gsl_vector> vecP(checkAlloc(gsl_vector_calloc(n2)), &gsl_vector_free);
+	for(size_t i = 0; i < n; i++) {
+		for(size_t j = 0; j < n; j++) {
+			const size_t row = i*n + j;
+			for(size_t k = 0; k < n; k++) {
+				*gsl_matrix_ptr(lyap.get(), row, k*n + j) += gsl_matrix_get(f.get(), i, k);
+				*gsl_matrix_ptr(lyap.get(), row, i*n + k) += gsl_matrix_get(f.get(), j, k);
+			}
+		}
+	}
+	gsl_vector_set(rhs.get(), n2 - 1, -1.0);
+	{
+		shared_ptr<gsl_permutation> perm(checkAlloc(gsl_permutation_alloc(n2)),
+			&gsl_permutation_free);
+		int sign = 0;
+		gslCheck( gsl_linalg_LU_decomp(lyap.get(), perm.get(), &sign),
+			"While approximating squared exponential kernel: ");
+		gslCheck( gsl_linalg_LU_solve(lyap.get(), perm.get(), rhs.get(), vecP.get()),
+			"While approximating squared exponential kernel: ");
+	}
+
+	// Normalize to unit variance, and symmetrize to remove rounding error
+	shared_ptr<gsl_matrix> p = zeroMatrix(n, n);
+	const double var = gsl_vector_get(vecP.get(), 0);
+	if (!(var > 0.0)) {
+		throw std::runtime_error("State-space approximation of order "
+			+ lexical_cast<std::string>(order) + " is not stable.");
+	}
+	for(size_t i = 0; i < n; i++) {
+		for(size_t j = 0; j < n; j++) {
+			gsl_matrix_set(p.get(), i, j, 0.5 / var
+				* (gsl_vector_get(vecP.get(), i*n + j)
+				+  gsl_vector_get(vecP.get(), j*n + i)));
+		}
+	}
+	shared_ptr<gsl_matrix> half = zeroMatrix(n, n);
+	gslCheck( gsl_matrix_memcpy(half.get(), p.get()),
+		"While approximating squared exponential kernel: ");
+	semiCholesky(half.get());
+
+	// IMPORTANT: no exceptions beyond this point
+
+	this->order = n;
+	drift.swap(f);
+	statCovar.swap(p);
+	statHalf.swap(half);
+}
+
+/** Returns the state-space model of a given order, computing it
+ *	only once
+ *
+ * @param[in] order The order of the SDE.
+ *
+ * @return A model equal to SquaredExpSde(@p order). The reference
+ *	remains valid for the rest of the program.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the model.
+ * @exception std::invalid_argument Thrown if @p order < 1 or
+ *	@p order > 8.
+ * @exception std::runtime_error Thrown if the model could not be computed.
+ *
+ * @exceptsafe The program state is unchanged in the event of an exception.
+ */
+const SquaredExpSde& SquaredExpSde::get(long order) {
+	typedef std::map<long, shared_ptr<const SquaredExpSde> > SdeCache;
+	static boost::mutex cacheLock;
+	static SdeCache cache;
+	static utils::CacheCounter counter("State-space models");
+
+	// Models are never removed, so references to them stay valid 
+	//	after the lock is released
+	boost::mutex::scoped_lock guard(cacheLock);
+	SdeCache::const_iterator match = cache.find(order);
+	if (match == cache.end()) {
+		const utils::CacheMiss miss(counter);
+		shared_ptr<const SquaredExpSde> model(new SquaredExpSde(order));
+		match = cache.insert(std::make_pair(order, model)).first;
+	} else {
+		counter.hit();
+	}
+	return *(match->second);
+}
+
+/** Returns the covariance of the approximate process between two
+ *	times separated by a given lag
+ *
+ * @param[in] lag The separation between the two times, in coherence
+ *	times.
+ *
+ * @return The approximate kernel at @p lag. The exact kernel is
+ *	@f$e^{-lag^2/2}@f$.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the kernel.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+double SquaredExpSde::kernel(double lag) const {
+	shared_ptr<gsl_matrix> transition = zeroMatrix(order, order);
+	matrixExp(drift.get(), fabs(lag), transition.get());
+
+	// Cov(x(t + lag), x(t)) = exp(F lag) P
+	double cov = 0.0;
+	for(size_t k = 0; k < order; k++) {
+		cov += gsl_matrix_get(transition.get(), 0, k)
+			* gsl_matrix_get(statCovar.get(), k, 0);
+	}
+	return cov;
+}
+
+/** Returns the largest difference between the approximate and
+ *	exact kernels
+ *
+ * @return The largest value of |kernel(lag) - @f$e^{-lag^2/2}@f$|
+ *	for lags up to 10 coherence times, beyond which both kernels
+ *	are negligible. The error is about 0.13 for order 2, 0.02 for
+ *	order 4, 0.004 for order 6, and 0.001 for order 8.
+ *
+ * @perform O(1) time, but several hundred matrix products.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	compute the kernel.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception.
+ */
+double SquaredExpSde::maxError() const {
+	double error = 0.0;
+	for(long i = 0; i <= 200; i++) {
+		const double lag = MAX_ERROR_LAG * static_cast<double>(i) / 200.0;
+		error = std::max(error, fabs(kernel(lag) - exp(-0.5*lag*lag)));
+	}
+	return error;
+}
+
+/** Simulates the approximate process at a set of times
+ *
+ * The state is drawn from its stationary distribution at the first
+ * time, and then propagated exactly between consecutive times. The
+ * transition matrix and noise covariance are recomputed only when the
+ * time step changes, so regular cadences are especially fast.
+ *
+ * @param[in] times The times at which to simulate the process.
+ * @param[in] tau The coherence time of the process.
+ * @param[in] rng The random number generator to draw the state and
+ *	innovations from. The generator draws order&times;N normal
+ *	deviates, where N = @p times.size().
+ * @param[out] values The value of the process at each time in @p times.
+ *
+ * @pre @p times is sorted in ascending order
+ * @pre @p tau > 0
+ *
+ * @post @p values.size() = @p times.size()
+ * @post if @p times[i] = @p times[j] for i &ne; j, then
+ *	@p values[i] = @p values[j]
+ *
+ * @perform O(N) time
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to
+ *	simulate the process.
+ * @exception std::runtime_error Thrown if the matrix products fail.
+ *
+ * @exceptsafe @p values is unchanged in the event of an exception.
+ */
+void SquaredExpSde::simulate(const std::vector<double>& times, double tau,
+		const StochasticRng& rng, std::vector<double>& values) const {
+	using std::swap;
+
+	std::vector<double> temp;
+	temp.reserve(times.size());
+
+	if (times.size() > 0) {
+		shared_ptr<gsl_vector> state(checkAlloc(gsl_vector_calloc(order)), &gsl_vector_free);
+		shared_ptr<gsl_vector> next (checkAlloc(gsl_vector_calloc(order)), &gsl_vector_free);
+		shared_ptr<gsl_vector> noise(checkAlloc(gsl_vector_calloc(order)), &gsl_vector_free);
+		shared_ptr<gsl_matrix> transition = zeroMatrix(order, order);
+		shared_ptr<gsl_matrix> innovHalf  = zeroMatrix(order, order);
+		shared_ptr<gsl_matrix> work       = zeroMatrix(order, order);
+
+		// Initial state
+		for(size_t k = 0; k < order; k++) {
+			gsl_vector_set(state.get(), k, rng.rNorm());
+		}
+		gslCheck( gsl_blas_dtrmv(CblasLower, CblasNoTrans, CblasNonUnit,
+			statHalf.get(), state.get()), "While simulating state-space model: ");
+		temp.push_back(gsl_vector_get(state.get(), 0));
+
+		double lastStep = -1.0;
+		for(size_t i = 1; i < times.size(); i++) {
+			const double step = (times[i] - times[i-1]) / tau;
+			if (step != lastStep) {
+				// Q = P - A P A^T
+				matrixExp(drift.get(), step, transition.get());
+				gslCheck( gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0,
+					transition.get(), statCovar.get(), 0.0, work.get()),
+					"While simulating state-space model: ");
+				gslCheck( gsl_matrix_memcpy(innovHalf.get(), statCovar.get()),
+					"While simulating state-space model: ");
+				gslCheck( gsl_blas_dgemm(CblasNoTrans, CblasTrans, -1.0,
+					work.get(), transition.get(), 1.0, innovHalf.get()),
+					"While simulating state-space model: ");
+				for(size_t j = 0; j < order; j++) {
+					for(size_t k = 0; k < j; k++) {
+						const double mean = 0.5 * (gsl_matrix_get(innovHalf.get(), j, k)
+							+ gsl_matrix_get(innovHalf.get(), k, j));
+						gsl_matrix_set(innovHalf.get(), j, k, mean);
+						gsl_matrix_set(innovHalf.get(), k, j, mean);
+					}
+				}
+				semiCholesky(innovHalf.get());
+				lastStep = step;
+			}
+
+			for(size_t k = 0; k < order; k++) {
+				gsl_vector_set(noise.get(), k, rng.rNorm());
+			}
+			gslCheck( gsl_blas_dtrmv(CblasLower, CblasNoTrans, CblasNonUnit,
+				innovHalf.get(), noise.get()), "While simulating state-space model: ");
+			gslCheck( gsl_blas_dgemv(CblasNoTrans, 1.0, transition.get(),
+				state.get(), 0.0, next.get()), "While simulating state-space model: ");
+			gslCheck( gsl_blas_daxpy(1.0, noise.get(), next.get()),
+				"While simulating state-space model: ");
+			swap(state, next);
+
+			temp.push_back(gsl_vector_get(state.get(), 0));
+		}
+	}
+
+	// IMPORTANT: no exceptions beyond this point
+
+	swap(values, temp);
+}
+
+}}		// end lcmc::models
@@ -0,0 +1,98 @@
+/** State-space approximations to Gaussian process kernels
+ * @file lightcurveMC/waves/statespace.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCMCSTATESPACEH
+#define LCMCSTATESPACEH
+
+#include <vector>
+#include <cstddef>
+#include <boost/smart_ptr.hpp>
+#include <gsl/gsl_matrix.h>
+#include "lcstochastic.h"
+
+namespace lcmc { namespace models {
+
+/** SquaredExpSde approximates a Gaussian process with a squared
+ * exponential kernel and unit variance by a linear stochastic
+ * differential equation.
+ *
+ * The approximation follows Hartikainen & S&auml;rkk&auml; (2010):
+ * the spectral density of the kernel, @f$\propto e^{-\omega^2\tau^2/2}@f$,
+ * is replaced by the reciprocal of the Taylor series of
+ * @f$e^{\omega^2\tau^2/2}@f$, truncated at order n. The approximate
+ * density is the spectrum of an order-n linear SDE driven by white
+ * noise, so the process can be simulated as a Markov chain of an
+ * n-dimensional state, in time linear in the number of observations.
+ *
+ * The approximation is always computed for a unit coherence time;
+ * other coherence times are handled by rescaling the times.
+ */
+class SquaredExpSde {
+public:
+	/** Computes the state-space model of a given order
+	 */
+	explicit SquaredExpSde(long order);
+
+	/** Returns the state-space model of a given order, computing it
+	 *	only once
+	 */
+	static const SquaredExpSde& get(long order);
+
+	/** Returns the covariance of the approximate process between two
+	 *	times separated by a given lag
+	 */
+	double kernel(double lag) const;
+
+	/** Returns the largest difference between the approximate and
+	 *	exact kernels
+	 */
+	double maxError() const;
+
+	/** Simulates the approximate process at a set of times
+	 */
+	void simulate(const std::vector<double>& times, double tau,
+			const StochasticRng& rng, std::vector<double>& values) const;
+
+private:
+	/** The order of the SDE */
+	size_t order;
+	/** The drift matrix of the SDE, in companion form. Owns a
+	 *	deallocator gsl_matrix_free() */
+	boost::shared_ptr<gsl_matrix> drift;
+	/** The stationary covariance of the state, normalized to unit
+	 *	variance of the process. Owns a deallocator gsl_matrix_free() */
+	boost::shared_ptr<gsl_matrix> statCovar;
+	/** The lower Cholesky factor of statCovar. Owns a deallocator
+	 *	gsl_matrix_free() */
+	boost::shared_ptr<gsl_matrix> statHalf;
+};
+
+}}		// end lcmc::models
+
+#endif		// end ifndef LCMCSTATESPACEH
@@ -2,7 +2,7 @@
  * @file lightcurveMC/waves/stochasticrng.cpp
  * @author Krzysztof Findeisen
  * @date Created May 12, 2013
- * @date Last modified May 12, 2013
+ * @date Last modified October 14, 2026
  */
 
 /* Copyright 2014, California Institute of Technology.
@@ -27,9 +27,12 @@
  * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 #include "lcstochastic.h"
+#include "../rngstream.h"
+#include "../../common/alloc.tmp.h"
 
 namespace lcmc { namespace models {
 
@@ -37,17 +40,42 @@ namespace lcmc { namespace models {
  *
  * @param[in] seed the initial seed for the generator.
  *
+ * @post The generator is a Mersenne Twister seeded with @p seed, so it 
+ *	produces the same numbers as gsl_rng_mt19937.
+ *
  * @exception std::bad_alloc Thrown if there was not enough memory 
  *	to construct the generator.
  *
  * @exceptsafe Object construction is atomic.
  */
-StochasticRng::StochasticRng(unsigned long seed) : rng(gsl_rng_alloc(gsl_rng_mt19937)) {
-	gsl_rng_set(rng, seed);
+StochasticRng::StochasticRng(unsigned long seed) : state(), 
+		legacy(kpfutils::checkAlloc(gsl_rng_alloc(gsl_rng_mt19937))) {
+	gsl_rng_set(legacy, seed);
+}
+
+/** Initializes a random number generator for one stream of a trial
+ *
+ * @param[in] seed The seed for the entire simulation run.
+ * @param[in] bin The index of the light curve or parameter bin being 
+ *	simulated.
+ * @param[in] trial The index of the trial within @p bin.
+ * @param[in] stream The purpose of the stream within the trial.
+ *
+ * @post The sequence of numbers produced by the generator depends 
+ *	only on @p seed, @p bin, @p trial, and @p stream, and is the 
+ *	same as that of utils::allocStream(@p seed, @p bin, @p trial, @p stream).
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+StochasticRng::StochasticRng(unsigned long seed, unsigned long bin, unsigned long trial, 
+		utils::StreamType stream) : state(), legacy(NULL) {
+	utils::initStream(state, seed, bin, trial, stream);
 }
 
 StochasticRng::~StochasticRng() {
-	gsl_rng_free(rng);
+	if (legacy != NULL) {
+		gsl_rng_free(legacy);
+	}
 }
 
 /** Creates a random number generator with an identical 
@@ -55,28 +83,68 @@ StochasticRng::~StochasticRng() {
  *
  * @param[in] other The generator to duplicate
  *
- * @exception std::bad_alloc Thrown if there was not enough memory 
- *	to construct the generator.
+ * @exception std::bad_alloc Thrown if @p other was constructed from a 
+ *	seed alone and there was not enough memory to duplicate it.
  *
- * @exceptsafe Object construction is atomic.
+ * @exceptsafe Object construction is atomic. Does not throw exceptions 
+ *	if @p other is a stream of a trial.
  */
-StochasticRng::StochasticRng(const StochasticRng& other) : rng(gsl_rng_clone(other.rng)) {
+StochasticRng::StochasticRng(const StochasticRng& other) : state(other.state), 
+		legacy(other.legacy == NULL ? NULL 
+			: kpfutils::checkAlloc(gsl_rng_clone(other.legacy))) {
 }
 
 /** Sets the random number generator state equal to another generator
  *
  * @param[in] other The generator to duplicate
  *
- * @return An assignable rvalue
+ * @return A reference to this generator
  *
- * @exceptsafe Does not throw exceptions.
+ * @exception std::bad_alloc Thrown if @p other was constructed from a 
+ *	seed alone, this generator was not, and there was not enough 
+ *	memory to duplicate @p other.
+ *
+ * @exceptsafe The object is unchanged in the event of an exception. 
+ *	Does not throw exceptions if both generators were constructed 
+ *	the same way.
  */
-const StochasticRng& StochasticRng::operator=(const StochasticRng& other) {
-	gsl_rng_memcpy(rng, other.rng);
+StochasticRng& StochasticRng::operator=(const StochasticRng& other) {
+	if (legacy != NULL && other.legacy != NULL) {
+		gsl_rng_memcpy(legacy, other.legacy);
+	} else if (this != &other) {
+		// copy-and-swap
+		StochasticRng temp(other);
+		
+		// IMPORTANT: no exceptions beyond this point
+		
+		std::swap(state, temp.state);
+		std::swap(legacy, temp.legacy);
+	}
 
 	return *this;
 }
 
+/** Returns a GSL generator that draws from this object's state
+ *
+ * @param[out] buffer Storage for a generator that wraps a Philox state.
+ *
+ * @return The Mersenne Twister, if this object was constructed from a 
+ *	seed alone, or else @p buffer, set to run on this object's state.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+const gsl_rng* StochasticRng::view(gsl_rng& buffer) const {
+	if (legacy != NULL) {
+		return legacy;
+	}
+	
+	// A gsl_rng is only a type and a pointer to the state, so GSL 
+	//	functions can run on the stored state without allocating one
+	buffer.type  = utils::philoxType();
+	buffer.state = &state;
+	return &buffer;
+}
+
 /** Draws a standard uniform random variate.
  *
  * @return A number distributed uniformly over [0, 1), drawn independently 
@@ -85,7 +153,8 @@ const StochasticRng& StochasticRng::operator=(const StochasticRng& other) {
  * @exceptsafe Does not throw exceptions.
  */
 double StochasticRng::rUnif() const {
-	return gsl_rng_uniform(rng);
+	gsl_rng buffer;
+	return gsl_rng_uniform(view(buffer));
 }
 
 /** Draws a standard normal random variate.
@@ -96,7 +165,39 @@ double StochasticRng::rUnif() const {
  * @exceptsafe Does not throw exceptions.
  */
 double StochasticRng::rNorm() const {
-	return gsl_ran_ugaussian(rng);
+	gsl_rng buffer;
+	return gsl_ran_ugaussian(view(buffer));
+}
+
+/** Fills an array with independent normal random variates.
+ *
+ * For a stream of a trial, this is faster than calling rNorm() once per 
+ * variate, but produces a different sequence of numbers. A generator 
+ * constructed from a seed alone produces the same numbers as @p n calls 
+ * to rNorm(), each multiplied by @p sigma.
+ *
+ * @param[out] out An array of at least @p n elements in which to 
+ *	store the variates.
+ * @param[in] n The number of variates to generate.
+ * @param[in] sigma The standard deviation of the variates.
+ *
+ * @post @p out[i] is normally distributed with mean 0 and standard 
+ *	deviation @p sigma, independently of any other calls to rUnif(), 
+ *	rNorm(), or fillNormal(), for all i < @p n.
+ *
+ * @perform O(@p n) time
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+void StochasticRng::fillNormal(double out[], size_t n, double sigma) const {
+	if (legacy != NULL) {
+		for(size_t i = 0; i < n; i++) {
+			out[i] = sigma * gsl_ran_ugaussian(legacy);
+		}
+	} else {
+		gsl_rng buffer;
+		utils::fillNormal(view(buffer), out, n, sigma);
+	}
 }
 
 }}	// end lcmc::models
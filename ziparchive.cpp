@@ -0,0 +1,462 @@
+/** Zip archives for collecting many output files into one
+ * @file lightcurveMC/ziparchive.cpp
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ *
+ * The file layout follows the PKWARE APPNOTE, version 6.3.
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/cstdint.hpp>
+#include <boost/smart_ptr.hpp>
+#ifdef LCMC_USE_ZLIB
+#include <zlib.h>
+#endif
+#include "ziparchive.h"
+#include "../common/cerror.h"
+#include "../common/checkedexception.h"
+
+namespace lcmc { namespace utils {
+
+using boost::uint16_t;
+using boost::uint32_t;
+using boost::uint64_t;
+using std::string;
+using std::vector;
+
+/** Compression method for entries stored as-is */
+const uint16_t ZIP_STORED   = 0;
+/** Compression method for deflated entries */
+const uint16_t ZIP_DEFLATED = 8;
+
+/** Largest value that fits in a 32-bit field; larger values need Zip64 */
+const uint64_t ZIP_MAX32 = 0xFFFFFFFFu;
+/** Largest entry count that fits in a 16-bit field */
+const uint64_t ZIP_MAX16 = 0xFFFFu;
+
+/** Entries are dated January 1, 1980, the earliest date a zip file 
+ *	can hold, so that the same run always gives the same archive */
+const uint16_t ZIP_DATE = (0 << 9) | (1 << 5) | 1;
+const uint16_t ZIP_TIME = 0;
+
+/** Appends a little-endian 16-bit field to a record
+ *
+ * @param[in,out] record The record to extend.
+ * @param[in] value The value to append.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	extend the record.
+ *
+ * @exceptsafe @p record is unchanged in the event of an exception.
+ */
+void put16(vector<unsigned char>& record, uint64_t value) {
+	const unsigned char bytes[2] = {static_cast<unsigned char>(value & 0xFF), 
+		static_cast<unsigned char>((value >> 8) & 0xFF)};
+	record.insert(record.end(), bytes, bytes + 2);
+}
+
+/** Appends a little-endian 32-bit field to a record
+ *
+ * @param[in,out] record The record to extend.
+ * @param[in] value The value to append.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	extend the record.
+ *
+ * @exceptsafe @p record is unchanged in the event of an exception.
+ */
+void put32(vector<unsigned char>& record, uint64_t value) {
+	unsigned char bytes[4];
+	for(int i = 0; i < 4; i++) {
+		bytes[i] = static_cast<unsigned char>((value >> (8*i)) & 0xFF);
+	}
+	record.insert(record.end(), bytes, bytes + 4);
+}
+
+/** Appends a little-endian 64-bit field to a record
+ *
+ * @param[in,out] record The record to extend.
+ * @param[in] value The value to append.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	extend the record.
+ *
+ * @exceptsafe @p record is unchanged in the event of an exception.
+ */
+void put64(vector<unsigned char>& record, uint64_t value) {
+	unsigned char bytes[8];
+	for(int i = 0; i < 8; i++) {
+		bytes[i] = static_cast<unsigned char>((value >> (8*i)) & 0xFF);
+	}
+	record.insert(record.end(), bytes, bytes + 8);
+}
+
+/** Calculates the CRC-32 checksum used by zip files
+ *
+ * @param[in] contents The data to check.
+ *
+ * @return The checksum of @p contents.
+ *
+ * @perform O(N) time, where N = @p contents.size()
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+uint32_t zipCrc(const vector<char>& contents) {
+	// Table for the reflected polynomial 0xEDB88320, built on first use
+	static uint32_t table[256];
+	static bool hasTable = false;
+	if (!hasTable) {
+		for(uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for(int k = 0; k < 8; k++) {
+				c = (c & 1u ? 0xEDB88320u ^ (c >> 1) : c >> 1);
+			}
+			table[i] = c;
+		}
+		hasTable = true;
+	}
+	
+	uint32_t crc = 0xFFFFFFFFu;
+	for(vector<char>::const_iterator it = contents.begin(); 
+			it != contents.end(); it++) {
+		crc = table[(crc ^ static_cast<unsigned char>(*it)) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFu;
+}
+
+/** Tests whether the program can compress zip archive entries
+ *
+ * @return True if the program was built with zlib, false otherwise.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+bool canCompressZip() {
+#ifdef LCMC_USE_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+/** Compresses the contents of a zip entry
+ *
+ * @param[in] contents The data to compress.
+ * @param[out] compressed The data in raw deflate format.
+ *
+ * @return True if @p compressed holds the compressed data, false if 
+ *	the data could not be compressed.
+ *
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	store the compressed data.
+ *
+ * @exceptsafe @p compressed is in a valid state in the event of an 
+ *	exception.
+ */
+bool deflateEntry(const vector<char>& contents, vector<unsigned char>& compressed) {
+#ifdef LCMC_USE_ZLIB
+	z_stream stream;
+	stream.zalloc = Z_NULL;
+	stream.zfree  = Z_NULL;
+	stream.opaque = Z_NULL;
+	// Negative window bits give raw deflate data, as zip expects
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, 
+			Z_DEFAULT_STRATEGY) != Z_OK) {
+		return false;
+	}
+	
+	// Allocates before any zlib state needs cleaning up
+	compressed.resize(deflateBound(&stream, contents.size()) + 1);
+	
+	stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(
+		contents.empty() ? NULL : &contents[0]));
+	stream.avail_in  = static_cast<uInt>(contents.size());
+	stream.next_out  = &compressed[0];
+	stream.avail_out = static_cast<uInt>(compressed.size());
+	
+	const int status = deflate(&stream, Z_FINISH);
+	const size_t length = stream.total_out;
+	deflateEnd(&stream);
+	
+	if (status != Z_STREAM_END) {
+		return false;
+	}
+	compressed.resize(length);
+	return true;
+#else
+	// Callers must check canCompressZip() before relying on the output
+	(void) contents;
+	(void) compressed;
+	return false;
+#endif
+}
+
+/** Creates an empty archive
+ *
+ * @param[in] fileName The file in which to store the archive. Any 
+ *	existing file with this name is overwritten.
+ * @param[in] compress If set, entries are deflated when that makes 
+ *	them smaller. Ignored unless canCompressZip() is true.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p fileName could not 
+ *	be opened.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	create the object.
+ *
+ * @exceptsafe Object construction is atomic.
+ */
+ZipArchive::ZipArchive(const string& fileName, bool compress) 
+		: fileName(fileName), file(kpfutils::fileCheckOpen(fileName, "wb")), 
+		compress(compress && canCompressZip()), position(0), entries() {
+}
+
+/** Writes the index if close() has not been called
+ *
+ * This keeps the archive readable if the program stops early. Errors 
+ * are ignored; call close() to have them reported.
+ *
+ * @exceptsafe Does not throw exceptions.
+ */
+ZipArchive::~ZipArchive() {
+	try {
+		if (file.get() != NULL) {
+			writeIndex();
+		}
+	} catch (...) {
+		// Destructors must not throw
+	}
+}
+
+/** Appends bytes to the archive
+ *
+ * @param[in] bytes The data to write.
+ * @param[in] length The number of bytes in @p bytes.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the data could not 
+ *	be written.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ZipArchive::write(const void* bytes, size_t length) {
+	if (length > 0 && fwrite(bytes, 1, length, file.get()) != length) {
+		kpfutils::fileError(file.get(), "Could not write to archive '" 
+			+ fileName + "': ");
+	}
+	position += length;
+}
+
+/** Appends bytes to the archive
+ *
+ * @param[in] bytes The data to write.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the data could not 
+ *	be written.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ZipArchive::write(const vector<unsigned char>& bytes) {
+	if (!bytes.empty()) {
+		write(&bytes[0], bytes.size());
+	}
+}
+
+/** Adds a file to the archive
+ *
+ * @param[in] name The name of the file within the archive.
+ * @param[in] contents The contents of the file.
+ *
+ * @pre close() has not been called
+ * @pre No other entry is named @p name
+ *
+ * @post The archive contains @p contents under the name @p name.
+ *
+ * @exception kpfutils::except::FileIo Thrown if @p contents is 4 GiB 
+ *	or larger, or could not be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	record the entry.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ZipArchive::add(const string& name, const vector<char>& contents) {
+	if (contents.size() >= ZIP_MAX32) {
+		throw kpfutils::except::FileIo("Entry " + name 
+			+ " is too large for archive '" + fileName + "'.");
+	}
+	
+	vector<unsigned char> compressed;
+	const bool deflated = compress && deflateEntry(contents, compressed) 
+		&& compressed.size() < contents.size();
+	const uint16_t method = (deflated ? ZIP_DEFLATED : ZIP_STORED);
+	const uint64_t storedSize = (deflated ? compressed.size() : contents.size());
+	const uint32_t crc = zipCrc(contents);
+	
+	// Reserve the index entry first, so that a failure cannot leave 
+	//	an entry on disk that the index does not mention
+	// Grow geometrically, so that adding N entries takes O(N) time
+	if (entries.size() == entries.capacity()) {
+		entries.reserve(std::max<size_t>(16, 2*entries.capacity()));
+	}
+	
+	vector<unsigned char> header;
+	put32(header, 0x04034b50u);		// local file header signature
+	put16(header, 20);			// version needed to extract
+	put16(header, 0);			// flags
+	put16(header, method);
+	put16(header, ZIP_TIME);
+	put16(header, ZIP_DATE);
+	put32(header, crc);
+	put32(header, storedSize);
+	put32(header, contents.size());
+	put16(header, name.size());
+	put16(header, 0);			// extra field length
+	header.insert(header.end(), name.begin(), name.end());
+	
+	const uint64_t offset = position;
+	write(header);
+	if (deflated) {
+		write(compressed);
+	} else if (!contents.empty()) {
+		write(&contents[0], contents.size());
+	}
+	
+	// IMPORTANT: no exceptions beyond this point
+	
+	entries.push_back(Entry(name, method, crc, storedSize, contents.size(), offset));
+}
+
+/** Writes the index of entries
+ *
+ * @post The file holds a central directory listing every entry, and 
+ *	is closed.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the index could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	build the index.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ZipArchive::writeIndex() {
+	const uint64_t indexStart = position;
+	for(vector<Entry>::const_iterator it = entries.begin(); 
+			it != entries.end(); it++) {
+		const bool needs64 = (it->offset >= ZIP_MAX32);
+		
+		vector<unsigned char> record;
+		put32(record, 0x02014b50u);		// central directory signature
+		put16(record, (3 << 8) | 45);		// made by: Unix, version 4.5
+		put16(record, needs64 ? 45 : 20);	// version needed to extract
+		put16(record, 0);			// flags
+		put16(record, it->method);
+		put16(record, ZIP_TIME);
+		put16(record, ZIP_DATE);
+		put32(record, it->crc);
+		put32(record, it->storedSize);
+		put32(record, it->size);
+		put16(record, it->name.size());
+		put16(record, needs64 ? 12 : 0);	// extra field length
+		put16(record, 0);			// comment length
+		put16(record, 0);			// disk number
+		put16(record, 0);			// internal attributes
+		put32(record, 0100644u << 16);		// regular file, rw-r--r--
+		put32(record, needs64 ? ZIP_MAX32 : it->offset);
+		record.insert(record.end(), it->name.begin(), it->name.end());
+		if (needs64) {
+			// Zip64 extended information, holding only the offset
+			put16(record, 0x0001);
+			put16(record, 8);
+			put64(record, it->offset);
+		}
+		write(record);
+	}
+	const uint64_t indexSize = position - indexStart;
+	const uint64_t nEntries  = entries.size();
+	
+	vector<unsigned char> end;
+	if (nEntries >= ZIP_MAX16 || indexStart >= ZIP_MAX32 || indexSize >= ZIP_MAX32) {
+		const uint64_t zip64End = position;
+		put32(end, 0x06064b50u);		// Zip64 end of central directory
+		put64(end, 44);				// size of remaining record
+		put16(end, (3 << 8) | 45);
+		put16(end, 45);
+		put32(end, 0);				// this disk
+		put32(end, 0);				// disk with the index
+		put64(end, nEntries);
+		put64(end, nEntries);
+		put64(end, indexSize);
+		put64(end, indexStart);
+		
+		put32(end, 0x07064b50u);		// Zip64 end of central directory locator
+		put32(end, 0);
+		put64(end, zip64End);
+		put32(end, 1);				// total number of disks
+	}
+	put32(end, 0x06054b50u);		// end of central directory signature
+	put16(end, 0);				// this disk
+	put16(end, 0);				// disk with the index
+	put16(end, std::min(nEntries, ZIP_MAX16));
+	put16(end, std::min(nEntries, ZIP_MAX16));
+	put32(end, std::min(indexSize, ZIP_MAX32));
+	put32(end, std::min(indexStart, ZIP_MAX32));
+	put16(end, 0);				// comment length
+	write(end);
+	
+	// Flush before closing, so that errors are not lost
+	const int status = fflush(file.get());
+	boost::shared_ptr<FILE> closing;
+	closing.swap(file);
+	if (status != 0) {
+		kpfutils::fileError(closing.get(), "Could not write to archive '" 
+			+ fileName + "': ");
+	}
+}
+
+/** Writes the index and closes the archive
+ *
+ * @pre close() has not been called
+ *
+ * @post The archive lists every entry added to it, and is closed.
+ *
+ * @exception kpfutils::except::FileIo Thrown if the index could not 
+ *	be written.
+ * @exception std::bad_alloc Thrown if there is not enough memory to 
+ *	build the index.
+ *
+ * @exceptsafe The object is in a valid state in the event of an 
+ *	exception, but the file contents are unspecified.
+ */
+void ZipArchive::close() {
+	writeIndex();
+}
+
+}}		// end lcmc::utils
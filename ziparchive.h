@@ -0,0 +1,124 @@
+/** Zip archives for collecting many output files into one
+ * @file lightcurveMC/ziparchive.h
+ * @author Krzysztof Findeisen
+ * @date Created October 14, 2026
+ * @date Last modified October 14, 2026
+ */
+
+/* Copyright 2014, California Institute of Technology.
+ *
+ * This file is part of LightcurveMC.
+ * 
+ * LightcurveMC is free software: you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as published 
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, subject to the following 
+ * exception added under Section 7 of the License:
+ *	* Neither the name of the copyright holder nor the names of its contributors 
+ *	  may be used to endorse or promote products derived from this software 
+ *	  without specific prior written permission.
+ * 
+ * LightcurveMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with LightcurveMC. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LCMCZIPARCHIVEH
+#define LCMCZIPARCHIVEH
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace lcmc { namespace utils {
+
+/** Tests whether the program can compress zip archive entries
+ */
+bool canCompressZip();
+
+/** ZipArchive writes a zip file, one entry at a time.
+ *
+ * Entries are written to the file as soon as they are added, and the 
+ * index of entries is written when the archive is closed. Archives 
+ * larger than 4 GiB use the Zip64 extensions.
+ *
+ * The archive can be read by any zip tool, including Python's 
+ * @c zipfile module.
+ */
+class ZipArchive {
+public:
+	/** Creates an empty archive
+	 */
+	ZipArchive(const std::string& fileName, bool compress);
+	
+	/** Writes the index if close() has not been called
+	 */
+	~ZipArchive();
+	
+	/** Adds a file to the archive
+	 */
+	void add(const std::string& name, const std::vector<char>& contents);
+	
+	/** Writes the index and closes the archive
+	 */
+	void close();
+
+private:
+	// Archives own their files
+	ZipArchive(const ZipArchive&);
+	ZipArchive& operator=(const ZipArchive&);
+	
+	/** Appends bytes to the archive
+	 */
+	void write(const std::vector<unsigned char>& bytes);
+	
+	/** Appends bytes to the archive
+	 */
+	void write(const void* bytes, size_t length);
+	
+	/** Writes the index of entries
+	 */
+	void writeIndex();
+	
+	/** Describes one entry of the archive
+	 */
+	struct Entry {
+		/** Describes an entry
+		 *
+		 * @exception std::bad_alloc Thrown if there is not enough 
+		 *	memory to store the name.
+		 *
+		 * @exceptsafe Object construction is atomic.
+		 */
+		Entry(const std::string& name, boost::uint16_t method, 
+				boost::uint32_t crc, boost::uint64_t storedSize, 
+				boost::uint64_t size, boost::uint64_t offset) 
+				: name(name), method(method), crc(crc), 
+				storedSize(storedSize), size(size), offset(offset) {
+		}
+		
+		std::string name;
+		boost::uint16_t method;
+		boost::uint32_t crc;
+		boost::uint64_t storedSize;
+		boost::uint64_t size;
+		boost::uint64_t offset;
+	};
+	
+	std::string fileName;
+	boost::shared_ptr<FILE> file;
+	bool compress;
+	boost::uint64_t position;
+	std::vector<Entry> entries;
+};
+
+}}		// end lcmc::utils
+
+#endif		// end LCMCZIPARCHIVEH